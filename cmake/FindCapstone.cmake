@@ -0,0 +1,42 @@
+# Attempt to locate the Capstone disassembly framework
+# Once done this will define:
+#
+#  Capstone_FOUND - system has Capstone
+#  Capstone_INCLUDE_DIRS - the include directories for Capstone
+#  Capstone_LIBRARIES - Link these to use Capstone
+#
+# and the imported target Capstone::Capstone
+#
+# SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+#
+# SPDX-License-Identifier: BSD-3-Clause
+
+find_library(Capstone_LIBRARY
+    NAMES capstone
+)
+set(Capstone_LIBRARIES "${Capstone_LIBRARY}")
+
+find_path(Capstone_INCLUDE_DIR
+    NAMES capstone/capstone.h
+)
+set(Capstone_INCLUDE_DIRS "${Capstone_INCLUDE_DIR}")
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(
+    Capstone
+    DEFAULT_MSG
+    Capstone_LIBRARIES
+    Capstone_INCLUDE_DIRS
+)
+
+mark_as_advanced(
+  Capstone_INCLUDE_DIRS
+  Capstone_LIBRARIES
+)
+
+if (Capstone_FOUND AND NOT TARGET Capstone::Capstone)
+    add_library(Capstone UNKNOWN IMPORTED GLOBAL)
+    set_target_properties(Capstone PROPERTIES IMPORTED_LOCATION ${Capstone_LIBRARY})
+    target_include_directories(Capstone INTERFACE ${Capstone_INCLUDE_DIRS})
+    add_library(Capstone::Capstone ALIAS Capstone)
+endif()
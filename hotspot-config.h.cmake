@@ -26,3 +26,7 @@
 #cmakedefine01 QCustomPlot_FOUND
 
 #cmakedefine01 KGraphViewerPart_FOUND
+
+#cmakedefine01 QtOpenGLWidgets_FOUND
+
+#cmakedefine01 Capstone_FOUND
@@ -0,0 +1,203 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "analysisserver.h"
+
+#include <QBuffer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include "jobscheduler.h"
+#include "models/resultsquery.h"
+#include "parsers/perf/perfparser.h"
+
+#include <algorithm>
+
+namespace {
+// every request is a single line, anything longer is no client of ours
+const qint64 maxRequestSize = 64 * 1024;
+// more slices than samples in any timeline, but keeps a client from asking for an unaggregated copy
+const quint32 maxTimeBuckets = 1 << 20;
+// clients may ask for any number of time buckets, so only this many KiB of answers are kept
+const int maxAnswersCost = 256 * 1024;
+
+QString peerName(QTcpSocket* socket)
+{
+    return socket->peerAddress().toString() + QLatin1Char(':') + QString::number(socket->peerPort());
+}
+}
+
+AnalysisServer::AnalysisServer(PerfParser* parser, QObject* parent)
+    : QObject(parent)
+    , m_parser(parser)
+    , m_server(new QTcpServer(this))
+    , m_answers(maxAnswersCost)
+{
+    connect(m_server, &QTcpServer::newConnection, this, [this]() {
+        while (auto* socket = m_server->nextPendingConnection()) {
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { readRequest(socket); });
+        }
+    });
+}
+
+AnalysisServer::~AnalysisServer() = default;
+
+bool AnalysisServer::listen(const QString& address)
+{
+    const auto separator = address.lastIndexOf(QLatin1Char(':'));
+    const auto host = separator == -1 ? QString() : address.left(separator);
+    bool ok = false;
+    const auto port = address.mid(separator + 1).toUShort(&ok);
+    if (!ok) {
+        m_errorString = tr("Invalid port in %1.").arg(address);
+        return false;
+    }
+
+    // anyone who can connect can read the results, so other interfaces only get used when asked for explicitly
+    if (!m_server->listen(host.isEmpty() ? QHostAddress(QHostAddress::LocalHost) : QHostAddress(host), port)) {
+        m_errorString = m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+QString AnalysisServer::errorString() const
+{
+    return m_errorString;
+}
+
+quint16 AnalysisServer::serverPort() const
+{
+    return m_server->serverPort();
+}
+
+void AnalysisServer::readRequest(QTcpSocket* socket)
+{
+    while (socket->canReadLine()) {
+        const auto line = socket->readLine(maxRequestSize + 1);
+        // any number of JSON-RPC calls can be made on the same connection
+        if (line.startsWith('{')) {
+            answerCall(socket, line);
+            continue;
+        }
+
+        // but the results close it after they got sent
+        disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+        const auto timeBuckets = PerfParser::parseServerRequest(line);
+        if (timeBuckets == 0 || timeBuckets > maxTimeBuckets) {
+            emit requestFailed(peerName(socket), tr("Invalid request."));
+            socket->abort();
+            return;
+        }
+        sendResults(socket, timeBuckets);
+        return;
+    }
+
+    if (socket->bytesAvailable() > maxRequestSize) {
+        emit requestFailed(peerName(socket), tr("Invalid request."));
+        socket->abort();
+    }
+}
+
+void AnalysisServer::sendResults(QTcpSocket* socket, quint32 timeBuckets)
+{
+    if (const auto* answer = m_answers.object(timeBuckets)) {
+        sendAnswer(socket, *answer);
+        return;
+    }
+
+    // writing the results takes a while for large captures, other clients get served meanwhile
+    JobScheduler::run(JobScheduler::Priority::Background,
+                      [bottomUp = m_parser->bottomUpResults(), events = m_parser->eventResults(), timeBuckets,
+                       socket = QPointer<QTcpSocket>(socket), this]() {
+                          QByteArray answer;
+                          QBuffer buffer(&answer);
+                          buffer.open(QIODevice::WriteOnly);
+                          PerfParser::writeServedResults(&buffer, bottomUp, events, timeBuckets);
+                          buffer.close();
+
+                          QTimer::singleShot(0, this, [this, answer, timeBuckets, socket]() {
+                              // answers larger than the whole cache don't get cached at all
+                              m_answers.insert(timeBuckets, new QByteArray(answer),
+                                               std::max(1, static_cast<int>(answer.size() / 1024)));
+                              if (socket) {
+                                  sendAnswer(socket, answer);
+                              }
+                          });
+                      });
+}
+
+void AnalysisServer::answerCall(QTcpSocket* socket, const QByteArray& call)
+{
+    // a JSON-RPC 2.0 call per line, e.g. {"jsonrpc": "2.0", "id": 1, "method": "query", "params": {"query": "..."}}
+    auto reply = [socket = QPointer<QTcpSocket>(socket)](const QJsonValue& id, const QString& key,
+                                                           const QJsonValue& value) {
+        if (socket && socket->state() == QAbstractSocket::ConnectedState) {
+            const QJsonObject answer = {{QLatin1String("jsonrpc"), QLatin1String("2.0")}, {QLatin1String("id"), id},
+                                        {key, value}};
+            socket->write(QJsonDocument(answer).toJson(QJsonDocument::Compact) + '\n');
+        }
+    };
+    auto replyError = [reply](const QJsonValue& id, int code, const QString& message) {
+        reply(id, QStringLiteral("error"),
+              QJsonObject {{QLatin1String("code"), code}, {QLatin1String("message"), message}});
+    };
+
+    QJsonParseError parseError;
+    const auto document = QJsonDocument::fromJson(call, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        replyError(QJsonValue::Null, -32700, tr("Parse error: %1").arg(parseError.errorString()));
+        return;
+    }
+
+    const auto object = document.object();
+    const auto id = object.value(QLatin1String("id"));
+    if (object.value(QLatin1String("method")).toString() != QLatin1String("query")) {
+        replyError(id, -32601, tr("Unknown method, only query is supported."));
+        return;
+    }
+
+    const auto params = object.value(QLatin1String("params"));
+    const auto spec = params.isArray() ? params.toArray().at(0).toString()
+                                       : params.toObject().value(QLatin1String("query")).toString();
+    QString errorMessage;
+    const auto query = ResultsQuery::Query::fromString(spec, &errorMessage);
+    if (!query) {
+        replyError(id, -32602, errorMessage);
+        return;
+    }
+
+    // the queries of all clients run in parallel, so the answers may arrive in a different order than the calls
+    JobScheduler::run(JobScheduler::Priority::Normal,
+                      [bottomUp = m_parser->bottomUpResults(), events = m_parser->eventResults(),
+                       stackIndex = m_parser->stackIndex(), query = *query, id, reply, replyError, this]() {
+                          const auto result = ResultsQuery::evaluate(query, bottomUp, events, stackIndex);
+                          QTimer::singleShot(0, this, [result, id, reply, replyError]() {
+                              if (result.error.isEmpty()) {
+                                  reply(id, QStringLiteral("result"), result.toJson());
+                              } else {
+                                  replyError(id, -32602, result.error);
+                              }
+                          });
+                      });
+}
+
+void AnalysisServer::sendAnswer(QTcpSocket* socket, const QByteArray& answer)
+{
+    if (socket->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+    socket->write(answer);
+    // this closes the connection once everything got written, which tells the client that the results are complete
+    socket->disconnectFromHost();
+    emit requestServed(peerName(socket), answer.size());
+}
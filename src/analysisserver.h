@@ -0,0 +1,55 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QCache>
+#include <QObject>
+#include <QString>
+
+class PerfParser;
+class QTcpServer;
+class QTcpSocket;
+
+// serves the results of a capture that got parsed on a machine with enough memory for it, e.g. next to the
+// captures, to the GUI on another machine that opens hotspot://host:port
+// a client sends a request line, see PerfParser::serverRequest, and gets the results with the samples summed up
+// per slice of the time range as a perfparser stream, see PerfParser::writeServedResults. the GUI then filters
+// and aggregates these like the results of a file, but they are only as large as the unique stacks per slice
+// clients can also send JSON-RPC calls, one per line, to evaluate a ResultsQuery on the full results
+// there is no authentication, so only local clients get served by default, e.g. through ssh -L port:localhost:port
+class AnalysisServer : public QObject
+{
+    Q_OBJECT
+public:
+    // serves the results of @p parser, which finished parsing already
+    explicit AnalysisServer(PerfParser* parser, QObject* parent = nullptr);
+    ~AnalysisServer();
+
+    // listens on @p address, which is "[host:]port", only localhost gets used when there is no host
+    bool listen(const QString& address);
+    QString errorString() const;
+    quint16 serverPort() const;
+
+signals:
+    void requestServed(const QString& client, qint64 size);
+    void requestFailed(const QString& client, const QString& errorMessage);
+
+private:
+    void readRequest(QTcpSocket* socket);
+    void sendResults(QTcpSocket* socket, quint32 timeBuckets);
+    void sendAnswer(QTcpSocket* socket, const QByteArray& answer);
+    // answers a JSON-RPC call of the query method, see ResultsQuery
+    void answerCall(QTcpSocket* socket, const QByteArray& call);
+
+    PerfParser* m_parser;
+    QTcpServer* m_server;
+    QString m_errorString;
+    // the results don't change while serving, so the answers get reused per number of time buckets, the cost of
+    // each is its size in KiB
+    QCache<quint32, QByteArray> m_answers;
+};
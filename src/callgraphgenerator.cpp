@@ -8,88 +8,146 @@
 #include "callgraphgenerator.h"
 
 #include <QFontDatabase>
+#include <QSet>
 #include <QTextStream>
-#include <QUuid>
 
-QHash<Data::Symbol, QString> writeGraph(QTextStream& stream, const Data::Symbol& symbol,
-                                        const Data::CallerCalleeResults& results, float thresholdPercent,
-                                        const QString& fontColor)
-{
-    auto settings = Settings::instance();
-    const auto parentId = QUuid::createUuid().toString(QUuid::Id128);
-    const auto font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+#include "settings.h"
 
-    stream << "digraph callgraph {\n";
-    stream << "node [shape=box, fontname=\"" << font.family() << "\", fontsize=\"" << font.pointSize()
-           << "pt\", fontcolor=\"" << fontColor << "\", style=filled, color=\"" << settings->callgraphColor().name()
-           << "\"]\n";
-
-    stream << "node" << parentId << " [label=\"";
-    if (symbol.prettySymbol.isEmpty()) {
-        stream << "??";
-    } else {
-        stream << symbol.prettySymbol;
+namespace {
+QString nodeLabel(const Data::Symbol& symbol)
+{
+    auto label = symbol.prettySymbol();
+    if (label.isEmpty()) {
+        return QStringLiteral("??");
     }
-    stream << "\", color=\"" << settings->callgraphActiveColor().name() << "\"]\n";
-
-    QHash<Data::Symbol, QString> symbolToIdLookup;
-    symbolToIdLookup.insert(symbol, parentId);
-
-    resultsToDot(settings->callgraphParentDepth(), Direction::Caller, symbol, results, parentId, stream,
-                 symbolToIdLookup, thresholdPercent);
-    resultsToDot(settings->callgraphChildDepth(), Direction::Callee, symbol, results, parentId, stream,
-                 symbolToIdLookup, thresholdPercent);
-
-    stream << "}\n";
-    return symbolToIdLookup;
+    label.replace(QLatin1Char('\\'), QLatin1String("\\\\"));
+    label.replace(QLatin1Char('"'), QLatin1String("\\\""));
+    return label;
+}
 }
 
-void resultsToDot(int height, Direction direction, const Data::Symbol& symbol, const Data::CallerCalleeResults& results,
-                  const QString& parent, QTextStream& stream, QHash<Data::Symbol, QString>& nodeIdLookup,
-                  float thresholdPercent)
+class CallGraphBuilder
 {
-    if (height == 0) {
-        return;
-    }
+public:
+    enum class Direction
+    {
+        Caller,
+        Callee
+    };
 
-    if (symbol.prettySymbol.isEmpty())
-        return;
+    CallGraphBuilder(const Data::CallerCalleeResults& results, float thresholdPercent, CallGraph* graph)
+        : m_results(results)
+        , m_thresholdPercent(thresholdPercent)
+        , m_graph(graph)
+    {
+    }
 
-    if (results.selfCosts.numTypes() == 0) {
-        return;
+    int addNode(const Data::Symbol& symbol)
+    {
+        auto it = m_graph->m_nodeIds.find(symbol);
+        if (it == m_graph->m_nodeIds.end()) {
+            it = m_graph->m_nodeIds.insert(symbol, m_graph->nodes.size());
+            m_graph->nodes.push_back(symbol);
+            m_adjacencyIds.push_back(m_results.adjacencyId(symbol));
+        }
+        return it.value();
     }
 
-    const auto entry = results.entries[symbol];
+    // @p symbolId is the id of the symbol in the adjacency lists of the results
+    int addNode(qint32 symbolId)
+    {
+        auto it = m_nodeForAdjacencyId.find(symbolId);
+        if (it == m_nodeForAdjacencyId.end()) {
+            it = m_nodeForAdjacencyId.insert(symbolId, addNode(m_results.adjacencySymbols.at(symbolId)));
+        }
+        return it.value();
+    }
 
-    auto addNode = [&stream](const QString& id, const QString& label) {
-        stream << "node" << id << " [label=\"" << label << "\"]\n";
-    };
-    auto connectNodes = [&stream, direction](const QString& parent, const QString& child) {
-        if (direction == Direction::Callee) {
-            stream << "node" << parent << " -> node" << child << "\n";
-        } else {
-            stream << "node" << child << " -> node" << parent << "\n";
+    void follow(Direction direction, int node, int depth)
+    {
+        if (depth == 0 || m_results.selfCosts.numTypes() == 0) {
+            return;
         }
-    };
 
-    const auto totalCost = results.selfCosts.totalCost(0);
-    auto map = direction == Direction::Callee ? entry.callees : entry.callers;
+        if (m_graph->nodes.at(node).prettySymbol().isEmpty()) {
+            return;
+        }
 
-    for (auto it = map.begin(); it != map.end(); it++) {
-        const auto cost = it.value()[0];
-        if (static_cast<double>(cost) / totalCost < thresholdPercent) {
-            continue;
+        // a symbol reached again doesn't need to be followed unless it now has more levels left
+        auto& followedDepth = direction == Direction::Caller ? m_callerDepths[node] : m_calleeDepths[node];
+        if (followedDepth >= depth) {
+            return;
+        }
+        followedDepth = depth;
+
+        const auto& adjacency = direction == Direction::Callee ? m_results.calleeAdjacency : m_results.callerAdjacency;
+        const auto totalCost = m_results.selfCosts.totalCost(0);
+        for (const auto& edge : adjacency.edges(m_adjacencyIds.at(node))) {
+            // the edges are sorted by cost, so all the remaining ones are below the threshold too
+            if (static_cast<double>(edge.cost) / totalCost < m_thresholdPercent) {
+                break;
+            }
+
+            const auto other = addNode(edge.symbolId);
+            const auto graphEdge = direction == Direction::Callee ? qMakePair(node, other) : qMakePair(other, node);
+            if (!m_edges.contains(graphEdge)) {
+                m_edges.insert(graphEdge);
+                m_graph->edges.push_back({graphEdge.first, graphEdge.second});
+            }
+            follow(direction, other, depth - 1);
         }
+    }
 
-        auto& key = it.key();
-        auto idIt = nodeIdLookup.find(key);
-        if (idIt == nodeIdLookup.end()) {
-            idIt = nodeIdLookup.insert(key, QUuid::createUuid().toString(QUuid::Id128));
-            addNode(idIt.value(), key.prettySymbol.isEmpty() ? QStringLiteral("??") : key.prettySymbol);
+private:
+    const Data::CallerCalleeResults& m_results;
+    const float m_thresholdPercent;
+    CallGraph* m_graph;
+    // the adjacency ids of the nodes and the other way around
+    QVector<qint32> m_adjacencyIds;
+    QHash<qint32, int> m_nodeForAdjacencyId;
+    QSet<QPair<int, int>> m_edges;
+    QHash<int, int> m_callerDepths;
+    QHash<int, int> m_calleeDepths;
+};
+
+CallGraph buildCallGraph(const Data::Symbol& symbol, const Data::CallerCalleeResults& results, int parentDepth,
+                         int childDepth, float thresholdPercent)
+{
+    if (!results.hasAdjacency()) {
+        auto copy = results;
+        copy.buildAdjacency();
+        return buildCallGraph(symbol, copy, parentDepth, childDepth, thresholdPercent);
+    }
+
+    CallGraph graph;
+    CallGraphBuilder builder(results, thresholdPercent, &graph);
+    const auto root = builder.addNode(symbol);
+    builder.follow(CallGraphBuilder::Direction::Caller, root, parentDepth);
+    builder.follow(CallGraphBuilder::Direction::Callee, root, childDepth);
+    return graph;
+}
+
+void writeGraph(QTextStream& stream, const CallGraph& graph, const QString& fontColor)
+{
+    auto settings = Settings::instance();
+    const auto font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+
+    stream << "digraph callgraph {\n";
+    stream << "node [shape=box, fontname=\"" << font.family() << "\", fontsize=\"" << font.pointSize()
+           << "pt\", fontcolor=\"" << fontColor << "\", style=filled, color=\"" << settings->callgraphColor().name()
+           << "\"]\n";
+
+    for (int i = 0, c = graph.nodes.size(); i < c; ++i) {
+        stream << "node" << i << " [label=\"" << nodeLabel(graph.nodes[i]) << '"';
+        if (i == 0) {
+            stream << ", color=\"" << settings->callgraphActiveColor().name() << '"';
         }
-        const auto nodeId = idIt.value();
+        stream << "]\n";
+    }
 
-        connectNodes(parent, nodeId);
-        resultsToDot(height - 1, direction, key, results, nodeId, stream, nodeIdLookup, thresholdPercent);
+    for (const auto& edge : graph.edges) {
+        stream << "node" << edge.caller << " -> node" << edge.callee << "\n";
     }
+
+    stream << "}\n";
 }
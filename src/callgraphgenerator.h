@@ -11,17 +11,59 @@
 #include "models/callercalleemodel.h"
 
 class QTextStream;
-class QModelIndex;
+// the call graph around a symbol, built in memory straight from the caller/callee results
+struct CallGraph
+{
+    // the first node is the symbol the graph got built for, the others are ordered by their discovery
+    QVector<Data::Symbol> nodes;
+    struct Edge
+    {
+        int caller = 0;
+        int callee = 0;
+    };
+    QVector<Edge> edges;
+
+    // the index of the node for @p symbol, or -1
+    int nodeId(const Data::Symbol& symbol) const
+    {
+        return m_nodeIds.value(symbol, -1);
+    }
 
-enum class Direction
+private:
+    friend class CallGraphBuilder;
+    QHash<Data::Symbol, int> m_nodeIds;
+};
+
+// identifies a call graph built by buildCallGraph
+struct CallGraphKey
 {
-    Caller,
-    Callee
+    Data::Symbol symbol;
+    int parentDepth = 0;
+    int childDepth = 0;
+    float thresholdPercent = 0;
 };
 
-QHash<Data::Symbol, QString> writeGraph(QTextStream& stream, const Data::Symbol& symbol,
-                                        const Data::CallerCalleeResults& results, float thresholdPercent,
-                                        const QString& fontColor);
-void resultsToDot(int height, Direction direction, const Data::Symbol& symbol, const Data::CallerCalleeResults& results,
-                  const QString& parent, QTextStream& stream, QHash<Data::Symbol, QString>& nodeIdLookup,
-                  float thresholdPercent);
+inline bool operator==(const CallGraphKey& lhs, const CallGraphKey& rhs)
+{
+    return lhs.symbol == rhs.symbol && lhs.parentDepth == rhs.parentDepth && lhs.childDepth == rhs.childDepth
+        && lhs.thresholdPercent == rhs.thresholdPercent;
+}
+
+inline uint qHash(const CallGraphKey& key, uint seed = 0)
+{
+    Util::HashCombine hash;
+    seed = hash(seed, key.symbol);
+    seed = hash(seed, key.parentDepth);
+    seed = hash(seed, key.childDepth);
+    seed = hash(seed, key.thresholdPercent);
+    return seed;
+}
+
+// follows the callers up to @p parentDepth and the callees down to @p childDepth levels away from @p symbol
+// calls below @p thresholdPercent of the total cost get pruned. this doesn't touch the GUI, so it can run in the
+// background
+CallGraph buildCallGraph(const Data::Symbol& symbol, const Data::CallerCalleeResults& results, int parentDepth,
+                         int childDepth, float thresholdPercent);
+
+// writes @p graph as graphviz dot, node i is called "node<i>"
+void writeGraph(QTextStream& stream, const CallGraph& graph, const QString& fontColor);
@@ -11,6 +11,7 @@
 
 #include <QLabel>
 #include <QMouseEvent>
+#include <QPointer>
 #include <QSpinBox>
 #include <QTemporaryFile>
 #include <QTextStream>
@@ -20,6 +21,7 @@
 #include <KParts/ReadOnlyPart>
 
 #include "callgraphgenerator.h"
+#include "jobscheduler.h"
 #include "settings.h"
 #include "ui_callgraphwidget.h"
 #include "util.h"
@@ -37,6 +39,8 @@ CallgraphWidget::CallgraphWidget(Data::CallerCalleeResults results, KParts::Read
 {
     ui->setupUi(this);
 
+    m_graphCache.setMaxCost(100000);
+
     connect(ui->costThreshold, qOverload<double>(&QDoubleSpinBox::valueChanged), this, [this](double threshold) {
         m_thresholdPercent = threshold / 100.f; // convert to percent
         generateCallgraph(m_currentSymbol);
@@ -89,7 +93,8 @@ void CallgraphWidget::selectSymbol(const Data::Symbol& symbol)
 void CallgraphWidget::setResults(const Data::CallerCalleeResults& results)
 {
     m_callerCalleeResults = results;
-    selectSymbol(m_currentSymbol);
+    m_graphCache.clear();
+    generateCallgraph(m_currentSymbol);
 }
 
 void CallgraphWidget::hoverEnter(const QString& node)
@@ -115,7 +120,9 @@ bool CallgraphWidget::eventFilter(QObject* watched, QEvent* event)
 
         if (m_graphview->widget()->geometry().contains(e->pos())) {
             if (e->button() == Qt::MouseButton::LeftButton && !m_currentNode.isEmpty()) {
-                const auto symbol = m_symbolToId.key(m_currentNode);
+                bool ok = false;
+                const auto node = m_currentNode.toInt(&ok);
+                const auto symbol = ok ? m_graph.nodes.value(node) : Data::Symbol();
                 if (symbol.isValid()) {
                     emit clickedOn(symbol);
                     m_currentNode.clear();
@@ -152,12 +159,50 @@ void CallgraphWidget::generateCallgraph(const Data::Symbol& symbol)
         return;
     }
 
+    m_currentSymbol = symbol;
+
+    // cancels the graph that is still getting built for the previous symbol or settings
+    const auto jobId = ++m_graphJobId;
+    const auto settings = Settings::instance();
+    const CallGraphKey key = {symbol, settings->callgraphParentDepth(), settings->callgraphChildDepth(),
+                              static_cast<float>(m_thresholdPercent)};
+    if (const auto* graph = m_graphCache.object(key)) {
+        showCallgraph(*graph);
+        return;
+    }
+
+    // wide graphs take a while to build, so do that in the background
+    JobScheduler::run(
+        JobScheduler::Priority::Normal,
+        [smartThis = QPointer<CallgraphWidget>(this), jobId, currentJobId = &m_graphJobId, key,
+         results = m_callerCalleeResults]() {
+            if (!smartThis || jobId != (*currentJobId)) {
+                return;
+            }
+
+            auto graph = buildCallGraph(key.symbol, results, key.parentDepth, key.childDepth, key.thresholdPercent);
+
+            QMetaObject::invokeMethod(
+                smartThis.data(),
+                [smartThis, jobId, key, graph]() {
+                    if (smartThis && jobId == smartThis->m_graphJobId) {
+                        smartThis->m_graphCache.insert(key, new CallGraph(graph), graph.nodes.size());
+                        smartThis->showCallgraph(graph);
+                    }
+                },
+                Qt::QueuedConnection);
+        });
+}
+
+void CallgraphWidget::showCallgraph(const CallGraph& graph)
+{
     m_graphview->closeUrl();
     m_graphFile->resize(0);
-    m_currentSymbol = symbol;
+    m_graph = graph;
+    m_currentNode.clear();
 
     QTextStream stream(m_graphFile);
-    m_symbolToId = writeGraph(stream, symbol, m_callerCalleeResults, m_thresholdPercent, m_fontColor);
+    writeGraph(stream, m_graph, m_fontColor);
     stream.flush();
 
     // if openUrl is called before the window is open it will freeze the application
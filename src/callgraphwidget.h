@@ -7,8 +7,12 @@
 
 #pragma once
 
+#include <QCache>
 #include <QWidget>
 
+#include <atomic>
+
+#include "callgraphgenerator.h"
 #include "data.h"
 
 namespace KParts {
@@ -59,6 +63,7 @@ private:
                     KGraphViewer::KGraphViewerInterface* interface, QWidget* parent = nullptr);
 
     void generateCallgraph(const Data::Symbol& symbol);
+    void showCallgraph(const CallGraph& graph);
     void updateColors();
 
     std::unique_ptr<Ui::CallgraphWidget> ui;
@@ -67,7 +72,11 @@ private:
     KParts::ReadOnlyPart* m_graphview = nullptr;
     KGraphViewer::KGraphViewerInterface* m_interface = nullptr;
     Data::CallerCalleeResults m_callerCalleeResults;
-    QHash<Data::Symbol, QString> m_symbolToId;
+    // the graph that is shown, the hovered node is an index into its nodes
+    CallGraph m_graph;
+    // the graphs that got built for the current results, the cost is the number of nodes
+    QCache<CallGraphKey, CallGraph> m_graphCache;
+    std::atomic<uint> m_graphJobId {0};
     Data::Symbol m_currentSymbol;
     QString m_currentNode;
     QString m_fontColor;
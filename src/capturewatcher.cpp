@@ -0,0 +1,159 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "capturewatcher.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+#include "parsers/perf/perfparser.h"
+
+namespace {
+// a capture whose size didn't change for this long is assumed to be complete
+const int settleInterval = 5000;
+}
+
+CaptureWatcher::CaptureWatcher(QObject* parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_settleTimer(new QTimer(this))
+    , m_parser(new PerfParser(this))
+{
+    m_settleTimer->setInterval(settleInterval);
+    connect(m_settleTimer, &QTimer::timeout, this, &CaptureWatcher::checkPending);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &CaptureWatcher::scan);
+
+    connect(m_parser, &PerfParser::parserOutputCached, this, [this](const QString& path) {
+        if (path == m_current) {
+            if (!m_isShuttingDown) {
+                emit captureCached(path);
+            }
+            finishCurrent();
+        }
+    });
+    connect(m_parser, &PerfParser::parsingFailed, this, [this](const QString& errorMessage) {
+        if (!m_current.isEmpty()) {
+            if (!m_isShuttingDown) {
+                emit captureFailed(m_current, errorMessage);
+            }
+            finishCurrent();
+        }
+    });
+}
+
+CaptureWatcher::~CaptureWatcher()
+{
+    // don't keep perfparser running for a capture nobody waits for anymore
+    m_parser->stop();
+}
+
+bool CaptureWatcher::watch(const QString& directory)
+{
+    if (!m_directory.isEmpty()) {
+        m_watcher->removePath(m_directory);
+    }
+    m_directory.clear();
+    m_pending.clear();
+    m_queue.clear();
+
+    if (!QFileInfo(directory).isDir() || !m_watcher->addPath(directory)) {
+        return false;
+    }
+    m_directory = directory;
+    scan();
+    return true;
+}
+
+QString CaptureWatcher::directory() const
+{
+    return m_directory;
+}
+
+void CaptureWatcher::shutdown()
+{
+    if (!m_directory.isEmpty()) {
+        m_watcher->removePath(m_directory);
+    }
+    m_settleTimer->stop();
+    m_pending.clear();
+    m_queue.clear();
+    m_isShuttingDown = true;
+    setParent(nullptr);
+
+    if (m_current.isEmpty()) {
+        deleteLater();
+    } else {
+        // finishCurrent deletes it once the job reported back
+        m_parser->stop();
+    }
+}
+
+void CaptureWatcher::scan()
+{
+    const QStringList nameFilters = {QStringLiteral("*perf*.data"), QStringLiteral("perf.data.*")};
+    // the oldest captures first
+    const auto captures =
+        QDir(m_directory).entryInfoList(nameFilters, QDir::Files | QDir::Readable, QDir::Time | QDir::Reversed);
+    for (const auto& capture : captures) {
+        const auto path = capture.absoluteFilePath();
+        if (m_processed.value(path) == capture.lastModified() || m_queue.contains(path) || path == m_current) {
+            continue;
+        }
+        // the size gets compared to this when the timer fires the next time
+        if (!m_pending.contains(path)) {
+            m_pending.insert(path, capture.size());
+        }
+    }
+
+    if (!m_pending.isEmpty() && !m_settleTimer->isActive()) {
+        m_settleTimer->start();
+    }
+}
+
+void CaptureWatcher::checkPending()
+{
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        const QFileInfo capture(it.key());
+        if (!capture.exists()) {
+            it = m_pending.erase(it);
+        } else if (capture.size() == it.value() && capture.size() > 0) {
+            m_queue.append(it.key());
+            it = m_pending.erase(it);
+        } else {
+            it.value() = capture.size();
+            ++it;
+        }
+    }
+
+    if (m_pending.isEmpty()) {
+        m_settleTimer->stop();
+    }
+    processNext();
+}
+
+void CaptureWatcher::processNext()
+{
+    if (!m_current.isEmpty() || m_queue.isEmpty()) {
+        return;
+    }
+    m_current = m_queue.takeFirst();
+    emit captureStarted(m_current);
+    m_parser->cacheParserOutput(m_current);
+}
+
+void CaptureWatcher::finishCurrent()
+{
+    // failed captures get tried again once they got modified
+    m_processed.insert(m_current, QFileInfo(m_current).lastModified());
+    m_current.clear();
+    if (m_isShuttingDown) {
+        deleteLater();
+        return;
+    }
+    processNext();
+}
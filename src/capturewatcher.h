@@ -0,0 +1,59 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+class PerfParser;
+class QFileSystemWatcher;
+class QTimer;
+
+// caches the perfparser output of the captures that show up in a directory, e.g. the ones a CI drops there all day
+// so that opening them later on only has to read the cache, see PerfParser::cacheParserOutput
+// a capture gets picked up once its size stopped changing, as it may still be written to when it shows up, and
+// the captures get processed one after the other at a low priority
+class CaptureWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CaptureWatcher(QObject* parent = nullptr);
+    ~CaptureWatcher();
+
+    // the captures that are in @p directory already get cached too, returns false when it can't be watched
+    bool watch(const QString& directory);
+    QString directory() const;
+
+    // stops watching and deletes the watcher once the capture that is getting cached right now is done, as the
+    // background job of the parser still uses it until then. the watcher detaches from its parent for that
+    void shutdown();
+
+signals:
+    void captureStarted(const QString& path);
+    void captureCached(const QString& path);
+    void captureFailed(const QString& path, const QString& errorMessage);
+
+private:
+    void scan();
+    void checkPending();
+    void processNext();
+    void finishCurrent();
+
+    QFileSystemWatcher* m_watcher;
+    QTimer* m_settleTimer;
+    PerfParser* m_parser;
+    QString m_directory;
+    // the sizes of the captures that might still get written, by their path
+    QHash<QString, qint64> m_pending;
+    QStringList m_queue;
+    // the modification times of the captures that got processed, by their path
+    QHash<QString, QDateTime> m_processed;
+    QString m_current;
+    bool m_isShuttingDown = false;
+};
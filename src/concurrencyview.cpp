@@ -0,0 +1,130 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "concurrencyview.h"
+
+#include <QEvent>
+#include <QHeaderView>
+#include <QHelpEvent>
+#include <QPainter>
+#include <QToolTip>
+#include <QTreeView>
+
+#include "models/concurrencyprofile.h"
+#include "models/eventmodel.h"
+#include "models/filterandzoomstack.h"
+#include "models/timelinedelegate.h"
+#include "util.h"
+
+#include <cmath>
+
+ConcurrencyView::ConcurrencyView(FilterAndZoomStack* filterAndZoomStack, QTreeView* timeLineView, QWidget* parent)
+    : QWidget(parent)
+    , m_filterAndZoomStack(filterAndZoomStack)
+    , m_timeLineView(timeLineView)
+{
+    setMinimumHeight(3 * fontMetrics().height());
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+
+    connect(filterAndZoomStack, &FilterAndZoomStack::zoomChanged, this, [this]() { update(); });
+    // the track follows the width of the events column
+    connect(timeLineView->header(), &QHeaderView::sectionResized, this, [this]() { update(); });
+    connect(timeLineView->header(), &QHeaderView::geometriesChanged, this, [this]() { update(); });
+}
+
+ConcurrencyView::~ConcurrencyView() = default;
+
+void ConcurrencyView::setProfile(const std::shared_ptr<const ConcurrencyProfile>& profile, Data::TimeRange time)
+{
+    m_profile = profile;
+    m_time = time;
+    update();
+}
+
+QRect ConcurrencyView::eventsRect() const
+{
+    // the track lies right above the timeline, with the same width
+    const auto* header = m_timeLineView->header();
+    const auto x = m_timeLineView->viewport()->geometry().x()
+        + header->sectionViewportPosition(EventModel::EventsColumn) + TimeLineData::padding;
+    const auto width = header->sectionSize(EventModel::EventsColumn) - 2 * TimeLineData::padding;
+    return QRect(x, TimeLineData::padding, std::max(0, width), height() - 2 * TimeLineData::padding);
+}
+
+Data::TimeRange ConcurrencyView::visibleTime() const
+{
+    const auto zoom = m_filterAndZoomStack->zoom();
+    return zoom.isValid() ? zoom.time.normalized() : m_time;
+}
+
+Data::TimeRange ConcurrencyView::columnTime(int x, int width) const
+{
+    const auto time = visibleTime();
+    const auto start = time.start + static_cast<quint64>(x) * time.delta() / width;
+    const auto end = time.start + static_cast<quint64>(x + 1) * time.delta() / width;
+    return {start, end};
+}
+
+void ConcurrencyView::paintEvent(QPaintEvent* /*event*/)
+{
+    QPainter painter(this);
+    const auto rect = eventsRect();
+    painter.fillRect(rect, palette().base());
+
+    if (!m_profile) {
+        painter.setPen(palette().color(QPalette::PlaceholderText));
+        painter.drawText(rect, Qt::AlignCenter, tr("Computing the running threads..."));
+        return;
+    }
+    if (m_profile->isEmpty()) {
+        painter.setPen(palette().color(QPalette::PlaceholderText));
+        painter.drawText(rect, Qt::AlignCenter, tr("No context switches recorded, see perf record --switch-events"));
+        return;
+    }
+    if (rect.width() <= 0 || visibleTime().isEmpty()) {
+        return;
+    }
+
+    // the average of every pixel column, so short bursts don't get lost when zoomed out
+    const auto maxThreads = std::max(1, m_profile->maxRunningThreads());
+    const auto yMultiplicator = static_cast<double>(rect.height()) / maxThreads;
+    const auto color = palette().color(QPalette::Highlight);
+    for (int x = 0; x < rect.width(); ++x) {
+        const auto average = m_profile->averageRunningThreads(columnTime(x, rect.width()));
+        const auto height = static_cast<int>(std::round(average * yMultiplicator));
+        if (height > 0) {
+            painter.fillRect(QRect(rect.x() + x, rect.bottom() - height + 1, 1, height), color);
+        }
+    }
+
+    painter.setPen(palette().color(QPalette::PlaceholderText));
+    painter.drawText(rect.adjusted(2, 0, 0, 0), Qt::AlignLeft | Qt::AlignTop,
+                     tr("%n running thread(s)", nullptr, maxThreads));
+}
+
+bool ConcurrencyView::event(QEvent* event)
+{
+    if (event->type() != QEvent::ToolTip) {
+        return QWidget::event(event);
+    }
+
+    const auto* helpEvent = static_cast<QHelpEvent*>(event);
+    const auto rect = eventsRect();
+    const auto x = helpEvent->pos().x() - rect.x();
+    if (!m_profile || m_profile->isEmpty() || x < 0 || x >= rect.width()) {
+        QToolTip::hideText();
+        event->ignore();
+        return true;
+    }
+
+    const auto time = columnTime(x, rect.width());
+    const auto text = tr("time: %1 - %2\naverage running threads: %3")
+                          .arg(Util::formatTimeString(time.start - m_time.start),
+                               Util::formatTimeString(time.end - m_time.start),
+                               QString::number(m_profile->averageRunningThreads(time), 'f', 2));
+    QToolTip::showText(helpEvent->globalPos(), text, this);
+    return true;
+}
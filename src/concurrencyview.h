@@ -0,0 +1,48 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QWidget>
+
+#include <memory>
+
+#include "models/data.h"
+
+class QTreeView;
+
+class ConcurrencyProfile;
+class FilterAndZoomStack;
+
+// a track above the timeline, showing how many threads were running over time
+// the profile gets computed once in the background, averaging it per pixel is cheap enough to follow the zoom directly
+class ConcurrencyView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit ConcurrencyView(FilterAndZoomStack* filterAndZoomStack, QTreeView* timeLineView,
+                             QWidget* parent = nullptr);
+    ~ConcurrencyView() override;
+
+    // @p time is the time of the whole timeline, the profile may be null while it gets computed
+    void setProfile(const std::shared_ptr<const ConcurrencyProfile>& profile, Data::TimeRange time);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    bool event(QEvent* event) override;
+
+private:
+    // the area of the events column of the timeline
+    QRect eventsRect() const;
+    Data::TimeRange visibleTime() const;
+    // the time shown at the pixel column @p x of the events rect
+    Data::TimeRange columnTime(int x, int width) const;
+
+    FilterAndZoomStack* m_filterAndZoomStack = nullptr;
+    QTreeView* m_timeLineView = nullptr;
+    std::shared_ptr<const ConcurrencyProfile> m_profile;
+    Data::TimeRange m_time;
+};
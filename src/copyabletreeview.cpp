@@ -7,10 +7,22 @@
 
 #include "copyabletreeview.h"
 
+#include <QAction>
 #include <QClipboard>
+#include <QFile>
+#include <QFileDialog>
 #include <QGuiApplication>
 #include <QKeyEvent>
+#include <QMessageBox>
 #include <QPainter>
+#include <QPointer>
+#include <QProgressDialog>
+#include <QTextStream>
+
+#include "jobscheduler.h"
+
+#include <atomic>
+#include <memory>
 
 CopyableTreeView::CopyableTreeView(QWidget* parent)
     : QTreeView(parent)
@@ -19,6 +31,109 @@ CopyableTreeView::CopyableTreeView(QWidget* parent)
 
 CopyableTreeView::~CopyableTreeView() = default;
 
+void CopyableTreeView::setTreeWriter(std::function<TreeWriter()> writerFactory)
+{
+    mTreeWriterFactory = std::move(writerFactory);
+    if (mCopyTreeAction) {
+        return;
+    }
+
+    // the actions of the view get added to its context menu, see ResultsUtil::setupContextMenu
+    mCopyTreeAction = new QAction(QIcon::fromTheme(QStringLiteral("edit-copy")), tr("Copy Tree"), this);
+    mCopyTreeAction->setToolTip(tr("Copy all rows of the tree as tab separated values, also the collapsed ones."));
+    mCopyTreeAction->setShortcut(tr("Ctrl+Shift+C"));
+    mCopyTreeAction->setShortcutContext(Qt::WidgetShortcut);
+    connect(mCopyTreeAction, &QAction::triggered, this, [this]() { exportTree({}); });
+    addAction(mCopyTreeAction);
+
+    mExportTreeAction =
+        new QAction(QIcon::fromTheme(QStringLiteral("document-export")), tr("Export Tree..."), this);
+    mExportTreeAction->setToolTip(tr("Write all rows of the tree to a TSV or CSV file."));
+    connect(mExportTreeAction, &QAction::triggered, this, [this]() {
+        const auto fileName = QFileDialog::getSaveFileName(this, tr("Export Tree"), {},
+                                                           tr("Tab Separated Values (*.tsv);;CSV (*.csv)"));
+        if (!fileName.isEmpty()) {
+            exportTree(fileName);
+        }
+    });
+    addAction(mExportTreeAction);
+}
+
+void CopyableTreeView::exportTree(const QString& fileName)
+{
+    if (!mTreeWriterFactory) {
+        return;
+    }
+
+    auto* dialog = new QProgressDialog(fileName.isEmpty() ? tr("Copying the tree...") : tr("Exporting the tree..."),
+                                       tr("Cancel"), 0, 100, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    // small trees are done before the dialog shows up
+    dialog->setMinimumDuration(500);
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    connect(dialog, &QProgressDialog::canceled, dialog, [cancelled]() { *cancelled = true; });
+
+    mCopyTreeAction->setEnabled(false);
+    mExportTreeAction->setEnabled(false);
+
+    JobScheduler::run(JobScheduler::Priority::Background, [smartThis = QPointer<CopyableTreeView>(this),
+                                                           dialog = QPointer<QProgressDialog>(dialog),
+                                                           writer = mTreeWriterFactory(), fileName, cancelled]() {
+        auto progress = [dialog, cancelled](qint64 writtenRows, qint64 totalRows) {
+            const auto percent = totalRows ? static_cast<int>(100 * writtenRows / totalRows) : 100;
+            QMetaObject::invokeMethod(
+                dialog.data(),
+                [dialog, percent]() {
+                    if (dialog) {
+                        dialog->setValue(percent);
+                    }
+                },
+                Qt::QueuedConnection);
+            return !*cancelled;
+        };
+
+        QString text;
+        QString errorString;
+        bool finished = false;
+        if (fileName.isEmpty()) {
+            QTextStream stream(&text);
+            finished = writer(&stream, TreeExport::Format::Tsv, progress);
+        } else {
+            QFile file(fileName);
+            if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+                QTextStream stream(&file);
+                finished = writer(&stream, TreeExport::formatForFileName(fileName), progress);
+                stream.flush();
+                if (file.error() != QFile::NoError) {
+                    errorString = file.errorString();
+                }
+            } else {
+                errorString = file.errorString();
+            }
+        }
+
+        QMetaObject::invokeMethod(
+            smartThis.data(),
+            [smartThis, dialog, fileName, text = std::move(text), errorString, finished]() {
+                if (dialog) {
+                    dialog->close();
+                }
+                if (!smartThis) {
+                    return;
+                }
+                smartThis->mCopyTreeAction->setEnabled(true);
+                smartThis->mExportTreeAction->setEnabled(true);
+                if (!errorString.isEmpty()) {
+                    QMessageBox::warning(smartThis, tr("Failed to export the tree"),
+                                         tr("Failed to write %1:\n%2").arg(fileName, errorString));
+                } else if (finished && fileName.isEmpty()) {
+                    QGuiApplication::clipboard()->setText(text);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
 void CopyableTreeView::keyPressEvent(QKeyEvent* event)
 {
     if (event->matches(QKeySequence::Copy)) {
@@ -9,6 +9,12 @@
 
 #include <QTreeView>
 
+#include <functional>
+
+#include "models/treeexport.h"
+
+class QAction;
+
 class CopyableTreeView : public QTreeView
 {
     Q_OBJECT
@@ -21,10 +27,23 @@ public:
         mDrawColumnSpanDelegate = delegate;
     }
 
+    // writes the whole tree, runs on a background thread
+    using TreeWriter = std::function<bool(QTextStream* stream, TreeExport::Format format,
+                                          const TreeExport::Progress& progress)>;
+    // enables copying and exporting the whole tree without going through the model, which is much faster for
+    // large trees. @p writerFactory gets called on the GUI thread when an export starts, to take a copy of the data
+    void setTreeWriter(std::function<TreeWriter()> writerFactory);
+
 protected:
     void keyPressEvent(QKeyEvent* event) override;
     void drawRow(QPainter* painter, const QStyleOptionViewItem& options, const QModelIndex& index) const override;
 
 private:
+    // copies to the clipboard when @p fileName is empty
+    void exportTree(const QString& fileName);
+
     QAbstractItemDelegate* mDrawColumnSpanDelegate = nullptr;
+    std::function<TreeWriter()> mTreeWriterFactory;
+    QAction* mCopyTreeAction = nullptr;
+    QAction* mExportTreeAction = nullptr;
 };
@@ -0,0 +1,392 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "flamechart.h"
+
+#include <QCache>
+#include <QComboBox>
+#include <QEvent>
+#include <QHBoxLayout>
+#include <QHelpEvent>
+#include <QLabel>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QPointer>
+#include <QScrollArea>
+#include <QSet>
+#include <QToolTip>
+#include <QVBoxLayout>
+
+#include <KColorScheme>
+
+#include "jobscheduler.h"
+#include "models/filterandzoomstack.h"
+#include "models/flamechartdata.h"
+#include "parsers/perf/perfparser.h"
+#include "resultsutil.h"
+#include "selfprofiler.h"
+#include "util.h"
+
+namespace {
+// the tiles are rendered in the background, so only the tiles that become visible are worth waiting for
+const int TileWidth = 256;
+// in KiB
+const int MaxTileCacheCost = 64 * 1024;
+
+struct TileKey
+{
+    uint generation = 0;
+    Data::TimeRange time;
+    int width = 0;
+    int tile = 0;
+    qreal devicePixelRatio = 1;
+
+    bool operator==(const TileKey& rhs) const
+    {
+        return generation == rhs.generation && time == rhs.time && width == rhs.width && tile == rhs.tile
+            && devicePixelRatio == rhs.devicePixelRatio;
+    }
+};
+
+uint qHash(const TileKey& key, uint seed = 0)
+{
+    Util::HashCombine hash;
+    seed = hash(seed, key.generation);
+    seed = hash(seed, key.time.start);
+    seed = hash(seed, key.time.end);
+    seed = hash(seed, key.width);
+    seed = hash(seed, key.tile);
+    seed = hash(seed, key.devicePixelRatio);
+    return seed;
+}
+
+QColor spanColor(const Data::Symbol& symbol)
+{
+    // equal symbols get equal colors in all parts of the chart
+    const auto hue = static_cast<int>(qHash(symbol.symbol) % 360);
+    return QColor::fromHsv(hue, symbol.binary.isEmpty() ? 40 : 120, 230);
+}
+
+QImage renderTile(const FlameChartData& data, const TileKey& key, int rowHeight, const QFont& font,
+                  const QColor& textColor)
+{
+    const auto height = std::max(1, data.depth() * rowHeight);
+    QImage image(QSize(TileWidth, height) * key.devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(key.devicePixelRatio);
+    image.fill(Qt::transparent);
+
+    const auto timePerPixel = static_cast<double>(key.time.delta()) / key.width;
+    const auto tileX = key.tile * TileWidth;
+    const Data::TimeRange tileTime(key.time.start + static_cast<quint64>(tileX * timePerPixel),
+                                   key.time.start + static_cast<quint64>((tileX + TileWidth) * timePerPixel));
+    auto mapTimeToX = [&](quint64 time) {
+        const auto x = time < key.time.start ? -1. : (time - key.time.start) / timePerPixel;
+        return static_cast<int>(std::clamp(x - tileX, -1., TileWidth + 1.));
+    };
+
+    QPainter painter(&image);
+    painter.setFont(font);
+    const auto metrics = painter.fontMetrics();
+    const auto minTextWidth = 3 * metrics.averageCharWidth();
+    const auto level = data.levelForResolution(timePerPixel);
+    for (int depth = 0, numDepths = data.depth(); depth < numDepths; ++depth) {
+        const auto y = depth * rowHeight;
+        data.forEachSpan(level, depth, tileTime, [&](const FlameChartData::Span& span) {
+            const auto left = mapTimeToX(span.start);
+            // every span is at least one pixel wide, the short ones still show that something happened
+            const auto right = std::max(left + 1, mapTimeToX(span.end));
+            const QRect rect(left, y, right - left, rowHeight - 1);
+            const auto& symbol = data.symbol(span.symbolId);
+            painter.fillRect(rect, spanColor(symbol));
+            if (rect.width() > minTextWidth) {
+                painter.setPen(textColor);
+                const auto textRect = rect.adjusted(2, 0, -2, 0);
+                painter.drawText(textRect, Qt::AlignLeft | Qt::AlignVCenter,
+                                 metrics.elidedText(Util::formatSymbol(symbol), Qt::ElideRight, textRect.width()));
+            }
+        });
+    }
+    return image;
+}
+}
+
+// paints the tiles of the chart, which get rendered off the GUI thread and cached until the zoom or data changes
+class FlameChartCanvas : public QWidget
+{
+public:
+    explicit FlameChartCanvas(FlameChart* flameChart)
+        : m_flameChart(flameChart)
+    {
+        setMouseTracking(true);
+        m_tiles.setMaxCost(MaxTileCacheCost);
+    }
+
+    void reset()
+    {
+        ++m_generation;
+        m_tiles.clear();
+        m_pending.clear();
+        const auto& data = m_flameChart->m_data;
+        setMinimumHeight(data ? data->depth() * rowHeight() : 0);
+        update();
+    }
+
+    int rowHeight() const
+    {
+        return fontMetrics().height() + 4;
+    }
+
+protected:
+    void paintEvent(QPaintEvent* event) override
+    {
+        QPainter painter(this);
+        painter.fillRect(event->rect(), palette().base());
+
+        const auto& data = m_flameChart->m_data;
+        if (!data || data->isEmpty()) {
+            painter.setPen(palette().color(QPalette::PlaceholderText));
+            painter.drawText(rect(), Qt::AlignCenter,
+                             data ? tr("No samples of this thread.") : tr("Building the flame chart..."));
+            return;
+        }
+
+        TileKey key;
+        key.generation = m_generation;
+        key.time = m_flameChart->visibleTime();
+        key.width = width();
+        key.devicePixelRatio = devicePixelRatioF();
+        if (key.time.isEmpty() || key.width <= 0) {
+            return;
+        }
+        for (int tile = event->rect().left() / TileWidth, last = event->rect().right() / TileWidth; tile <= last;
+             ++tile) {
+            key.tile = tile;
+            if (const auto* image = m_tiles.object(key)) {
+                painter.drawImage(QPoint(tile * TileWidth, 0), *image);
+            } else {
+                schedule(key, data);
+            }
+        }
+    }
+
+    bool event(QEvent* event) override
+    {
+        if (event->type() == QEvent::ToolTip) {
+            const auto* helpEvent = static_cast<QHelpEvent*>(event);
+            FlameChartData::Span span;
+            if (spanAt(helpEvent->pos(), &span)) {
+                const auto& symbol = m_flameChart->m_data->symbol(span.symbolId);
+                const auto start = m_flameChart->m_time.start;
+                QToolTip::showText(helpEvent->globalPos(),
+                                   tr("%1 in %2\n%3 samples from %4 to %5, %6")
+                                       .arg(Util::formatSymbol(symbol), Util::formatString(symbol.binary),
+                                            QString::number(span.numSamples),
+                                            Util::formatTimeString(span.start - start),
+                                            Util::formatTimeString(span.end - start),
+                                            Util::formatTimeString(span.end - span.start)),
+                                   this);
+            } else {
+                QToolTip::hideText();
+                event->ignore();
+            }
+            return true;
+        }
+        return QWidget::event(event);
+    }
+
+    void mouseDoubleClickEvent(QMouseEvent* event) override
+    {
+        // zoom the time line, and with it this chart, into the span
+        FlameChartData::Span span;
+        if (event->button() == Qt::LeftButton && spanAt(event->pos(), &span)) {
+            m_flameChart->m_filterAndZoomStack->zoomIn({span.start, span.end});
+        }
+    }
+
+private:
+    bool spanAt(QPoint pos, FlameChartData::Span* found) const
+    {
+        const auto& data = m_flameChart->m_data;
+        const auto time = m_flameChart->visibleTime();
+        if (!data || time.isEmpty() || width() <= 0) {
+            return false;
+        }
+        const auto timePerPixel = static_cast<double>(time.delta()) / width();
+        const auto posTime = time.start + static_cast<quint64>(pos.x() * timePerPixel);
+        bool isFound = false;
+        // only find the spans that got painted
+        data->forEachSpan(data->levelForResolution(timePerPixel), pos.y() / rowHeight(), {posTime, posTime},
+                          [&](const FlameChartData::Span& span) {
+                              *found = span;
+                              isFound = true;
+                          });
+        return isFound;
+    }
+
+    void schedule(const TileKey& key, const std::shared_ptr<const FlameChartData>& data)
+    {
+        if (m_pending.contains(key)) {
+            return;
+        }
+        m_pending.insert(key);
+
+        JobScheduler::run(JobScheduler::Priority::Interactive, [context = QPointer<FlameChartCanvas>(this), key, data,
+                                                                rowHeight = rowHeight(), font = font(),
+                                                                textColor = palette().color(QPalette::Text)]() {
+            ScopedPhase phase("flame chart tile");
+            auto image = renderTile(*data, key, rowHeight, font, textColor);
+            QMetaObject::invokeMethod(
+                context.data(),
+                [context, key, image = std::move(image)]() {
+                    if (!context || key.generation != context->m_generation) {
+                        return;
+                    }
+                    context->m_pending.remove(key);
+                    context->m_tiles.insert(key, new QImage(image),
+                                            std::max(1, static_cast<int>(image.sizeInBytes() / 1024)));
+                    context->update(QRect(key.tile * TileWidth, 0, TileWidth, context->height()));
+                },
+                Qt::QueuedConnection);
+        });
+    }
+
+    FlameChart* m_flameChart;
+    uint m_generation = 0;
+    QCache<TileKey, QImage> m_tiles;
+    QSet<TileKey> m_pending;
+};
+
+FlameChart::FlameChart(PerfParser* parser, FilterAndZoomStack* filterAndZoomStack, QWidget* parent)
+    : QWidget(parent)
+    , m_filterAndZoomStack(filterAndZoomStack)
+    , m_threads(new QComboBox(this))
+    , m_costSource(new QComboBox(this))
+    , m_view(new QScrollArea(this))
+    , m_canvas(new FlameChartCanvas(this))
+{
+    m_threads->setToolTip(tr("Select the thread whose samples get shown in the order of time."));
+    m_threads->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+    m_costSource->setToolTip(tr("Select the event source of the samples."));
+
+    m_view->setWidgetResizable(true);
+    m_view->setWidget(m_canvas);
+    m_view->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+
+    auto* controls = new QHBoxLayout;
+    controls->addWidget(new QLabel(tr("Thread:"), this));
+    controls->addWidget(m_threads);
+    controls->addWidget(new QLabel(tr("Event Source:"), this));
+    controls->addWidget(m_costSource);
+    controls->addStretch();
+    auto* hint = new QLabel(tr("Zoom in the time line, or double click a span to zoom into it."), this);
+    hint->setEnabled(false);
+    controls->addWidget(hint);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(controls);
+    layout->addWidget(m_view);
+
+    connect(parser, &PerfParser::bottomUpDataAvailable, this, [this](const Data::BottomUpResults& data) {
+        m_bottomUp = data;
+        const QSignalBlocker blocker(m_costSource);
+        ResultsUtil::fillEventSourceComboBox(m_costSource, data.costs, tr("Show the %1 samples."));
+    });
+    connect(parser, &PerfParser::eventsAvailable, this, [this](const Data::EventResults& data) {
+        m_events = data;
+        m_time = {};
+        for (const auto& thread : data.threads) {
+            if (thread.events.isEmpty()) {
+                continue;
+            }
+            m_time.start = m_time.isValid() ? std::min(m_time.start, thread.time.start) : thread.time.start;
+            m_time.end = std::max(m_time.end, thread.time.end);
+        }
+        fillThreads();
+        rebuild();
+    });
+    connect(m_threads, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this,
+            &FlameChart::rebuild);
+    connect(m_costSource, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this,
+            &FlameChart::rebuild);
+    connect(filterAndZoomStack, &FilterAndZoomStack::zoomChanged, m_canvas, qOverload<>(&QWidget::update));
+}
+
+FlameChart::~FlameChart() = default;
+
+void FlameChart::fillThreads()
+{
+    // keep the selected thread when the results get filtered
+    const auto oldTid = m_threads->currentData();
+
+    QVector<const Data::ThreadEvents*> threads;
+    threads.reserve(m_events.threads.size());
+    for (const auto& thread : std::as_const(m_events.threads)) {
+        if (!thread.events.isEmpty()) {
+            threads.push_back(&thread);
+        }
+    }
+    // the busiest threads first
+    std::stable_sort(threads.begin(), threads.end(), [](const Data::ThreadEvents* lhs, const Data::ThreadEvents* rhs) {
+        return lhs->events.size() > rhs->events.size();
+    });
+
+    const QSignalBlocker blocker(m_threads);
+    m_threads->clear();
+    for (const auto* thread : std::as_const(threads)) {
+        m_threads->addItem(tr("%1 (%2)").arg(thread->name, QString::number(thread->tid)), thread->tid);
+    }
+    const auto index = m_threads->findData(oldTid);
+    if (index != -1) {
+        m_threads->setCurrentIndex(index);
+    }
+}
+
+void FlameChart::rebuild()
+{
+    const auto tid = m_threads->currentData();
+    const auto costType = m_costSource->currentData();
+    const auto thread = std::find_if(m_events.threads.cbegin(), m_events.threads.cend(),
+                                     [&tid](const Data::ThreadEvents& thread) { return thread.tid == tid.toInt(); });
+    if (!tid.isValid() || !costType.isValid() || thread == m_events.threads.cend()) {
+        ++m_currentBuildJobId;
+        setData(std::make_shared<const FlameChartData>());
+        return;
+    }
+
+    m_data.reset();
+    m_canvas->reset();
+
+    const auto jobId = ++m_currentBuildJobId;
+    const auto smartThis = QPointer<FlameChart>(this);
+    JobScheduler::run(JobScheduler::Priority::Normal, [smartThis, jobId, currentJobId = &m_currentBuildJobId,
+                                                       events = thread->events, costType = costType.toInt(),
+                                                       stacks = m_events.stacks, bottomUp = m_bottomUp]() {
+        ScopedPhase phase("flame chart build");
+        auto data = std::make_shared<const FlameChartData>(FlameChartData::build(events, costType, stacks, bottomUp));
+        QMetaObject::invokeMethod(
+            smartThis.data(),
+            [smartThis, jobId, currentJobId, data = std::move(data)]() {
+                if (smartThis && jobId == *currentJobId) {
+                    smartThis->setData(data);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void FlameChart::setData(std::shared_ptr<const FlameChartData> data)
+{
+    m_data = std::move(data);
+    m_canvas->reset();
+}
+
+Data::TimeRange FlameChart::visibleTime() const
+{
+    const auto zoom = m_filterAndZoomStack->zoom();
+    return zoom.isValid() ? zoom.time.normalized() : m_time;
+}
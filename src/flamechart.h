@@ -0,0 +1,53 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QWidget>
+
+#include <atomic>
+#include <memory>
+
+#include "models/data.h"
+
+class QComboBox;
+class QScrollArea;
+
+class FilterAndZoomStack;
+class FlameChartCanvas;
+class FlameChartData;
+class PerfParser;
+
+// shows the sampled stacks of one thread in the order of time, with the outermost caller at the top
+// unlike the flame graph, this keeps the sequence of the calls, e.g. to investigate the latency of a request
+// the chart follows the zoom of the time line
+class FlameChart : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit FlameChart(PerfParser* parser, FilterAndZoomStack* filterAndZoomStack, QWidget* parent = nullptr);
+    ~FlameChart() override;
+
+private:
+    friend class FlameChartCanvas;
+
+    void fillThreads();
+    void rebuild();
+    void setData(std::shared_ptr<const FlameChartData> data);
+    // the visible time, as zoomed into in the time line
+    Data::TimeRange visibleTime() const;
+
+    FilterAndZoomStack* m_filterAndZoomStack = nullptr;
+    QComboBox* m_threads = nullptr;
+    QComboBox* m_costSource = nullptr;
+    QScrollArea* m_view = nullptr;
+    FlameChartCanvas* m_canvas = nullptr;
+    Data::EventResults m_events;
+    Data::BottomUpResults m_bottomUp;
+    Data::TimeRange m_time;
+    std::shared_ptr<const FlameChartData> m_data;
+    std::atomic<uint> m_currentBuildJobId {0};
+};
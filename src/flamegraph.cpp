@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <memory>
 #include <utility>
 
 #include <QAction>
@@ -19,17 +20,19 @@
 #include <QCursor>
 #include <QDebug>
 #include <QDoubleSpinBox>
+#include <QElapsedTimer>
 #include <QEvent>
 #include <QFontDatabase>
-#include <QGraphicsRectItem>
-#include <QGraphicsScene>
-#include <QGraphicsView>
 #include <QLabel>
 #include <QLineEdit>
 #include <QMenu>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QPointer>
 #include <QRandomGenerator>
+#include <QScrollArea>
 #include <QScrollBar>
-#include <QStyleOption>
+#include <QSignalBlocker>
 #include <QSvgGenerator>
 #include <QToolBar>
 #include <QToolTip>
@@ -40,22 +43,15 @@
 #include <KLocalizedString>
 #include <KSqueezedTextLabel>
 #include <KStandardAction>
-#include <ThreadWeaver/ThreadWeaver>
 
+#include "jobscheduler.h"
 #include "models/filterandzoomstack.h"
 #include "resultsutil.h"
+#include "selfprofiler.h"
 #include "settings.h"
 #include "util.h"
 
 namespace {
-enum SearchMatchType
-{
-    NoSearch,
-    NoMatch,
-    DirectMatch,
-    ChildMatch
-};
-
 template<class CreateInstance>
 class CustomWidgetAction : public QWidgetAction
 {
@@ -80,232 +76,6 @@ private:
 };
 }
 
-class FrameGraphicsItem : public QGraphicsRectItem
-{
-public:
-    FrameGraphicsItem(qint64 cost, Data::Symbol symbol, FrameGraphicsItem* parent);
-
-    qint64 cost() const;
-    void setCost(qint64 cost);
-    Data::Symbol symbol() const;
-
-    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = nullptr) override;
-
-    QString description() const;
-    void setSearchMatchType(SearchMatchType matchType);
-
-    bool isExternallyHovered() const;
-    void setIsExternallyHovered(bool isExternallyHovered);
-
-protected:
-    void hoverEnterEvent(QGraphicsSceneHoverEvent* event) override;
-    void hoverLeaveEvent(QGraphicsSceneHoverEvent* event) override;
-
-private:
-    qint64 m_cost;
-    Data::Symbol m_symbol;
-    bool m_isHovered = false;
-    bool m_isExternallyHovered = false;
-    SearchMatchType m_searchMatch = NoSearch;
-};
-Q_DECLARE_METATYPE(FrameGraphicsItem*)
-
-class FrameGraphicsRootItem : public FrameGraphicsItem
-{
-public:
-    FrameGraphicsRootItem(const qint64 totalCost, Data::Costs::Unit unit, QString costName, const QString& label)
-        : FrameGraphicsItem(totalCost, {label, {}}, nullptr)
-        , m_costName(std::move(costName))
-        , m_unit(unit)
-    {
-    }
-
-    Data::Costs::Unit unit() const
-    {
-        return m_unit;
-    }
-    QString costName() const
-    {
-        return m_costName;
-    }
-
-private:
-    QString m_costName;
-    Data::Costs::Unit m_unit;
-};
-
-Q_DECLARE_METATYPE(FrameGraphicsRootItem*)
-
-FrameGraphicsItem::FrameGraphicsItem(const qint64 cost, Data::Symbol symbol, FrameGraphicsItem* parent)
-    : QGraphicsRectItem(parent)
-    , m_cost(cost)
-    , m_symbol(std::move(symbol))
-{
-    setFlag(QGraphicsItem::ItemIsSelectable);
-    setAcceptHoverEvents(true);
-}
-
-qint64 FrameGraphicsItem::cost() const
-{
-    return m_cost;
-}
-
-void FrameGraphicsItem::setCost(qint64 cost)
-{
-    m_cost = cost;
-}
-
-Data::Symbol FrameGraphicsItem::symbol() const
-{
-    return m_symbol;
-}
-
-void FrameGraphicsItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* /*widget*/)
-{
-    if (isSelected() || m_isHovered || m_isExternallyHovered || m_searchMatch == DirectMatch) {
-        auto selectedColor = brush().color();
-        selectedColor.setAlpha(255);
-        painter->fillRect(rect(), selectedColor);
-    } else if (m_searchMatch == NoMatch) {
-        auto noMatchColor = brush().color();
-        noMatchColor.setAlpha(50);
-        painter->fillRect(rect(), noMatchColor);
-    } else {
-        // default, when no search is running, or a sub-item is matched
-        auto background = brush();
-
-        // give inline frames a slightly different background color
-        if (m_symbol.isInline) {
-            auto color = background.color();
-            if (qGray(pen().color().rgb()) < 128) {
-                color = color.lighter();
-            } else {
-                color = color.darker();
-            }
-            background.setColor(color);
-        }
-        painter->fillRect(rect(), background);
-
-        // give inline frames a border with the normal background color
-        if (m_symbol.isInline) {
-            const auto oldPen = painter->pen();
-            painter->setPen(QPen(brush().color(), 0.));
-            painter->drawRect(rect().adjusted(-1, -1, -1, -1));
-            painter->setPen(oldPen);
-        }
-    }
-
-    const QPen oldPen = painter->pen();
-    auto pen = oldPen;
-    if (m_searchMatch != NoMatch) {
-        pen.setColor(brush().color());
-        if (isSelected()) {
-            pen.setWidth(2);
-        }
-        painter->setPen(pen);
-        painter->drawRect(rect());
-        painter->setPen(oldPen);
-    }
-
-    const int margin = 4;
-    const int width = rect().width() - 2 * margin;
-    if (width < option->fontMetrics.averageCharWidth() * 6) {
-        // text is too wide for the current LOD, don't paint it
-        return;
-    }
-
-    if (m_searchMatch == NoMatch) {
-        auto color = oldPen.color();
-        color.setAlpha(125);
-        pen.setColor(color);
-        painter->setPen(pen);
-    }
-
-    const int height = rect().height();
-    const auto binary = Util::formatString(m_symbol.binary);
-    const auto symbol = Util::formatSymbol(m_symbol, false);
-    const auto symbolText = symbol.isEmpty() ? QObject::tr("?? [%1]").arg(binary) : symbol;
-    painter->drawText(margin + rect().x(), rect().y(), width, height,
-                      Qt::AlignVCenter | Qt::AlignLeft | Qt::TextSingleLine,
-                      Util::elideSymbol(symbolText, option->fontMetrics, width));
-
-    if (m_searchMatch == NoMatch) {
-        painter->setPen(oldPen);
-    }
-}
-
-void FrameGraphicsItem::hoverEnterEvent(QGraphicsSceneHoverEvent* event)
-{
-    QGraphicsRectItem::hoverEnterEvent(event);
-    m_isHovered = true;
-    update();
-}
-
-void FrameGraphicsItem::hoverLeaveEvent(QGraphicsSceneHoverEvent* event)
-{
-    QGraphicsRectItem::hoverLeaveEvent(event);
-    m_isHovered = false;
-    update();
-}
-
-QString FrameGraphicsItem::description() const
-{
-    // we build the tooltip text on demand, which is much faster than doing that for potentially thousands of items when
-    // we load the data
-    const FrameGraphicsRootItem* root = nullptr;
-    {
-        auto item = this;
-        while (item->parentItem()) {
-            item = static_cast<const FrameGraphicsItem*>(item->parentItem());
-        }
-        root = static_cast<const FrameGraphicsRootItem*>(item);
-    }
-
-    auto symbol = Util::formatSymbolExtended(m_symbol);
-    if (root == this) {
-        return symbol;
-    }
-
-    switch (root->unit()) {
-    case Data::Costs::Unit::Unknown:
-        return i18nc("%1: aggregated sample costs, %2: relative number, %3: function label, %4: binary, %5: cost name",
-                     "%1 (%2%) aggregated %5 costs in %3 (%4) and below.",
-                     Data::Costs::formatCost(root->unit(), m_cost), Util::formatCostRelative(m_cost, root->cost()),
-                     symbol, m_symbol.binary, root->costName());
-    case Data::Costs::Unit::Tracepoint:
-        return i18nc("%1: number of tracepoint events, %2: relative number, %3: function label, %4: binary",
-                     "%1 (%2%) aggregated %5 events in %3 (%4) and below.",
-                     Data::Costs::formatCost(root->unit(), m_cost), Util::formatCostRelative(m_cost, root->cost()),
-                     symbol, m_symbol.binary, root->costName());
-    case Data::Costs::Unit::Time:
-        return i18nc("%1: elapsed time, %2: relative number, %3: function label, %4: binary",
-                     "%1 (%2%) aggregated %5 in %3 (%4) and below.", Data::Costs::formatCost(root->unit(), m_cost),
-                     Util::formatCostRelative(m_cost, root->cost()), symbol, m_symbol.binary, root->costName());
-    }
-    Q_UNREACHABLE();
-}
-
-void FrameGraphicsItem::setSearchMatchType(SearchMatchType matchType)
-{
-    if (m_searchMatch != matchType) {
-        m_searchMatch = matchType;
-        update();
-    }
-}
-
-bool FrameGraphicsItem::isExternallyHovered() const
-{
-    return m_isExternallyHovered;
-}
-
-void FrameGraphicsItem::setIsExternallyHovered(bool externallyHovered)
-{
-    if (m_isExternallyHovered != externallyHovered) {
-        m_isExternallyHovered = externallyHovered;
-        update();
-    }
-}
-
 namespace {
 
 int randInt(int max)
@@ -432,6 +202,20 @@ QBrush costRatioBrush(quint32 cost, quint32 totalCost)
     return QColor::fromHsv(hue, 230, 200, 125);
 }
 
+// compare the share of the total cost in both captures
+// red means a frame got more expensive, blue means it got cheaper and the saturation shows the relative change
+QBrush diffBrush(qint64 cost, qint64 totalCost, qint64 baselineCost, qint64 baselineTotalCost)
+{
+    const auto ratio = totalCost ? static_cast<double>(cost) / totalCost : 0.;
+    const auto baselineRatio = baselineTotalCost ? static_cast<double>(baselineCost) / baselineTotalCost : 0.;
+    const auto maxRatio = std::max(ratio, baselineRatio);
+    if (maxRatio == 0) {
+        return QColor::fromHsv(0, 0, 200, 125);
+    }
+    const auto change = (ratio - baselineRatio) / maxRatio;
+    return QColor::fromHsv(change > 0 ? 0 : 240, static_cast<int>(std::abs(change) * 230), 220, 125);
+}
+
 QBrush brush(const Data::Symbol& entry, const BrushConfig& brushConfig, quint32 cost = 0, quint32 totalCost = 1)
 {
     switch (brushConfig.scheme) {
@@ -451,219 +235,280 @@ QBrush brush(const Data::Symbol& entry, const BrushConfig& brushConfig, quint32
     return {};
 }
 
-/**
- * Layout the flame graph and hide tiny items.
- */
-void layoutItems(FrameGraphicsItem* parent)
+// appends the brushes for all nodes that got added since the last call
+void appendBrushes(const FlameGraphData& data, const BrushConfig& brushConfig, const QBrush& rootBrush,
+                   QVector<QBrush>* brushes)
 {
-    const auto& parentRect = parent->rect();
-    const auto pos = parentRect.topLeft();
-    const qreal maxWidth = parentRect.width();
-    const qreal h = parentRect.height();
-    const qreal y_margin = 2.;
-    const qreal y = pos.y() - h - y_margin;
-    qreal x = pos.x();
-
-    auto children = parent->childItems();
-    // sort to get reproducible graphs
-    std::sort(children.begin(), children.end(), [](const QGraphicsItem* lhs, const QGraphicsItem* rhs) {
-        return static_cast<const FrameGraphicsItem*>(lhs)->symbol()
-            < static_cast<const FrameGraphicsItem*>(rhs)->symbol();
-    });
-
-    foreach (auto child, children) {
-        auto frameChild = static_cast<FrameGraphicsItem*>(child);
-        const qreal w = maxWidth * double(frameChild->cost()) / parent->cost();
-        frameChild->setVisible(w > 1);
-        if (frameChild->isVisible()) {
-            frameChild->setRect(QRectF(x, y, w, h));
-            layoutItems(frameChild);
-            x += w;
-        }
+    if (data.isEmpty()) {
+        return;
     }
-}
-
-FrameGraphicsItem* findItemBySymbol(const QList<QGraphicsItem*>& items, const Data::Symbol& symbol)
-{
-    foreach (auto item_, items) {
-        auto item = static_cast<FrameGraphicsItem*>(item_);
-        if (item->symbol() == symbol) {
-            return item;
+    if (brushes->isEmpty()) {
+        brushes->push_back(rootBrush);
+    }
+    const auto totalCost = data.node(0).cost;
+    brushes->reserve(data.size());
+    if (data.hasBaseline()) {
+        const auto baselineTotalCost = data.baselineCost(0);
+        for (qint32 id = brushes->size(), c = data.size(); id < c; ++id) {
+            brushes->push_back(diffBrush(data.node(id).cost, totalCost, data.baselineCost(id), baselineTotalCost));
         }
+        return;
+    }
+    for (qint32 id = brushes->size(), c = data.size(); id < c; ++id) {
+        brushes->push_back(brush(data.symbol(id), brushConfig, data.node(id).cost, totalCost));
     }
-    return nullptr;
 }
 
-/**
- * Convert the top-down graph into a tree of FrameGraphicsItem.
- */
-template<typename Tree>
-void toGraphicsItems(const Data::Costs& costs, int type, const QVector<Tree>& data, FrameGraphicsItem* parent,
-                     const double costThreshold, const BrushConfig& brushConfig, bool collapseRecursion)
+// the node at the end of the path along @p frames below @p node, or -1 when the graph doesn't contain that path
+qint32 findStackNode(const FlameGraphData& data, qint32 node, const QVector<const Data::Symbol*>& frames,
+                     bool collapseRecursion)
 {
-    foreach (const auto& row, data) {
-        if (collapseRecursion && !row.symbol.symbol.isEmpty() && row.symbol == parent->symbol()) {
-            if (costs.cost(type, row.id) > costThreshold) {
-                toGraphicsItems(costs, type, row.children, parent, costThreshold, brushConfig, collapseRecursion);
-            }
+    for (const auto* frame : frames) {
+        if (collapseRecursion && !frame->symbol.isEmpty() && data.symbol(node) == *frame) {
+            // the recursive calls got merged into the node, see FlameGraphBuilder
             continue;
         }
-        auto item = findItemBySymbol(parent->childItems(), row.symbol);
-        if (!item) {
-            item = new FrameGraphicsItem(costs.cost(type, row.id), row.symbol, parent);
-            item->setPen(parent->pen());
-            item->setBrush(brush(row.symbol, brushConfig, item->cost(), costs.totalCost(type)));
-        } else {
-            item->setCost(item->cost() + costs.cost(type, row.id));
+        const auto& parent = data.node(node);
+        const auto begin = parent.firstChild;
+        const auto end = parent.firstChild + parent.numChildren;
+        node = -1;
+        for (auto child = begin; child < end; ++child) {
+            if (data.symbol(child) == *frame) {
+                node = child;
+                break;
+            }
         }
-        if (item->cost() > costThreshold) {
-            toGraphicsItems(costs, type, row.children, item, costThreshold, brushConfig, collapseRecursion);
+        if (node == -1) {
+            return -1;
         }
     }
+    return node;
+}
 }
 
-template<typename Tree>
-FrameGraphicsItem* parseData(const Data::Costs& costs, int type, const QVector<Tree>& topDownData, double costThreshold,
-                             const BrushConfig& brushConfig, bool collapseRecursion)
+// paints the flame graph of its FlameGraph, which also handles all of the user interaction
+class FlameGraphCanvas : public QWidget
 {
-    const auto totalCost = costs.totalCost(type);
+public:
+    explicit FlameGraphCanvas(FlameGraph* flameGraph)
+        : m_flameGraph(flameGraph)
+    {
+        setMouseTracking(true);
+    }
 
-    const auto scheme = KColorScheme(QPalette::Active);
-    const auto pen = QPen(scheme.foreground().color());
-
-    const auto label = i18n("%1 aggregated %2 cost in total", costs.formatCost(type, totalCost), costs.typeName(type));
-    auto rootItem = new FrameGraphicsRootItem(totalCost, costs.unit(type), costs.typeName(type), label);
-    rootItem->setBrush(scheme.background());
-    rootItem->setPen(pen);
-    toGraphicsItems(costs, type, topDownData, rootItem, static_cast<double>(totalCost) * costThreshold / 100.,
-                    brushConfig, collapseRecursion);
-    return rootItem;
-}
+protected:
+    void paintEvent(QPaintEvent* event) override
+    {
+        QPainter painter(this);
+        m_flameGraph->paintFlameGraph(&painter, event->rect(), m_flameGraph->m_rootBrush, m_flameGraph->m_pen);
+    }
 
-struct SearchResults
-{
-    SearchMatchType matchType = NoMatch;
-    qint64 directCost = 0;
+private:
+    FlameGraph* m_flameGraph;
 };
 
-SearchResults applySearch(FrameGraphicsItem* item, const QString& searchValue)
+// paints the small multiples of its FlameGraph as a grid of tiles at a low level of detail, i.e. thin rows without
+// any text. hovering a frame shows its symbol in the tooltip and clicking a tile opens its full graph
+class FlameGraphMultiplesCanvas : public QWidget
 {
-    SearchResults result;
-    if (searchValue.isEmpty()) {
-        result.matchType = NoSearch;
-    } else if (item->symbol().symbol.contains(searchValue, Qt::CaseInsensitive)
-               || (searchValue == QLatin1String("??") && item->symbol().symbol.isEmpty())
-               || item->symbol().binary.contains(searchValue, Qt::CaseInsensitive)) {
-        result.directCost += item->cost();
-        result.matchType = DirectMatch;
-    }
-
-    // recurse into the child items, we always need to update all items
-    const auto children = item->childItems();
-    for (auto* child : children) {
-        auto* childFrame = static_cast<FrameGraphicsItem*>(child);
-        auto childMatch = applySearch(childFrame, searchValue);
-        if (result.matchType != DirectMatch
-            && (childMatch.matchType == DirectMatch || childMatch.matchType == ChildMatch)) {
-            result.matchType = ChildMatch;
-            result.directCost += childMatch.directCost;
+public:
+    explicit FlameGraphMultiplesCanvas(FlameGraph* flameGraph)
+        : m_flameGraph(flameGraph)
+    {
+        setMouseTracking(true);
+    }
+
+    void setBuilding()
+    {
+        m_building = true;
+        m_multiples.clear();
+        m_hoveredTile = -1;
+        update();
+    }
+
+    void setMultiples(QVector<FlameGraph::Multiple> multiples, QSize viewportSize)
+    {
+        m_building = false;
+        m_multiples = std::move(multiples);
+        m_hoveredTile = -1;
+        layoutTiles(viewportSize);
+    }
+
+    // fits as many tiles into a row as the width of the view allows
+    void layoutTiles(QSize viewportSize)
+    {
+        const auto stride = FlameGraph::MultipleWidth + FlameGraph::Padding;
+        m_columns = std::max(1, (viewportSize.width() - FlameGraph::Padding) / stride);
+        const auto numRows = (m_multiples.size() + m_columns - 1) / m_columns;
+        const auto contentHeight = FlameGraph::Padding + numRows * (FlameGraph::MultipleHeight + FlameGraph::Padding);
+        resize(std::max(viewportSize.width(), FlameGraph::Padding + stride),
+               std::max(contentHeight, viewportSize.height()));
+        update();
+    }
+
+protected:
+    void paintEvent(QPaintEvent* event) override
+    {
+        QPainter painter(this);
+        const auto& pen = m_flameGraph->m_pen;
+        painter.setPen(pen);
+
+        if (m_multiples.isEmpty()) {
+            painter.drawText(rect(), Qt::AlignCenter,
+                             m_building ? i18n("generating flame graphs...")
+                                        : i18n("no thread has a cost of the selected type"));
+            return;
+        }
+
+        const auto fontMetrics = painter.fontMetrics();
+        auto framePen = pen;
+        auto frameColor = pen.color();
+        frameColor.setAlpha(50);
+        framePen.setColor(frameColor);
+
+        for (int i = 0, c = m_multiples.size(); i < c; ++i) {
+            const auto tile = tileRect(i);
+            if (!tile.intersects(event->rect())) {
+                continue;
+            }
+            const auto& multiple = m_multiples.at(i);
+            const auto& data = multiple.data;
+
+            painter.setPen(pen);
+            painter.drawText(tile.x(), tile.y(), tile.width(), fontMetrics.height(),
+                             Qt::AlignVCenter | Qt::AlignLeft | Qt::TextSingleLine,
+                             fontMetrics.elidedText(multiple.label, Qt::ElideRight, tile.width()));
+
+            // the root is at the bottom like in the full graph, the deepest frames get cut off at the top
+            const auto graph = graphRect(i);
+            const auto numRows = std::min(data.numVisibleRows(), graph.height() / FlameGraph::MultipleRowHeight);
+            for (int depth = 1; depth < numRows; ++depth) {
+                const auto y = graph.bottom() + 1 - depth * FlameGraph::MultipleRowHeight;
+                for (auto node : data.visibleNodes(depth)) {
+                    const QRectF rect(graph.x() + data.x(node), y, data.width(node), FlameGraph::MultipleRowHeight - 1);
+                    painter.fillRect(rect, multiple.brushes.at(node));
+                }
+            }
+
+            painter.setPen(i == m_hoveredTile ? pen : framePen);
+            painter.drawRect(graph.adjusted(0, 0, -1, -1));
         }
     }
 
-    item->setSearchMatchType(result.matchType);
-    return result;
-}
+    void mouseMoveEvent(QMouseEvent* event) override
+    {
+        const auto tile = tileAt(event->pos());
+        if (tile != m_hoveredTile) {
+            m_hoveredTile = tile;
+            setCursor(tile == -1 ? Qt::ArrowCursor : Qt::PointingHandCursor);
+            update();
+        }
+    }
 
-// only apply positive matching, resetting is handled globally once before
-// this way we can correctly match multiple stacks
-bool hoverStack(FrameGraphicsItem* item, const QVector<Data::Symbol>& stack, int depth)
-{
-    if ((stack.size() - 1) == depth && item->symbol() == stack.constFirst()) {
-        item->setIsExternallyHovered(true);
-        return true;
-    } else if (stack.size() <= depth || item->symbol() != stack[stack.size() - 1 - depth]) {
-        return false;
+    void leaveEvent(QEvent* /*event*/) override
+    {
+        m_hoveredTile = -1;
+        setCursor(Qt::ArrowCursor);
+        update();
     }
 
-    const auto children = item->childItems();
-    for (auto* child : children) {
-        if (hoverStack(static_cast<FrameGraphicsItem*>(child), stack, depth + 1)) {
-            item->setIsExternallyHovered(true);
-            return true;
+    void mouseReleaseEvent(QMouseEvent* event) override
+    {
+        const auto tile = tileAt(event->pos());
+        if (event->button() == Qt::LeftButton && tile != -1) {
+            // copy the group, opening it rebuilds the multiples
+            const auto group = m_multiples.at(tile).group;
+            m_flameGraph->openMultiple(group);
         }
     }
 
-    return false;
-}
+    bool event(QEvent* event) override
+    {
+        if (event->type() != QEvent::ToolTip) {
+            return QWidget::event(event);
+        }
 
-void resetIsExternallyHovered(FrameGraphicsItem* item)
-{
-    if (!item->isExternallyHovered()) {
-        // when nothing is hovered we don't need to recurse
-        return;
+        const auto pos = static_cast<QHelpEvent*>(event)->pos();
+        const auto tile = tileAt(pos);
+        if (tile == -1) {
+            QToolTip::hideText();
+            event->ignore();
+            return true;
+        }
+
+        const auto& multiple = m_multiples.at(tile);
+        const auto& data = multiple.data;
+        auto tooltip = multiple.label;
+        const auto graph = graphRect(tile);
+        const auto fromBottom = graph.bottom() - pos.y();
+        const auto node =
+            fromBottom < 0 ? -1 : data.nodeAt(fromBottom / FlameGraph::MultipleRowHeight, pos.x() - graph.x());
+        if (node > 0) {
+            const auto cost = data.node(node).cost;
+            tooltip += QLatin1Char('\n')
+                + i18nc("%1: function label, %2: aggregated costs, %3: relative number", "%1: %2 (%3%)",
+                        Util::formatSymbol(data.symbol(node)), Data::Costs::formatCost(data.unit(), cost),
+                        Util::formatCostRelative(cost, data.node(0).cost));
+        }
+        tooltip += QLatin1Char('\n') + i18n("Click to show the full flame graph.");
+        QToolTip::showText(QCursor::pos(), tooltip, this);
+        return true;
     }
-    item->setIsExternallyHovered(false);
-    const auto children = item->childItems();
-    for (auto* child : children) {
-        resetIsExternallyHovered(static_cast<FrameGraphicsItem*>(child));
+
+private:
+    QRect tileRect(int index) const
+    {
+        const auto column = index % m_columns;
+        const auto row = index / m_columns;
+        return {FlameGraph::Padding + column * (FlameGraph::MultipleWidth + FlameGraph::Padding),
+                FlameGraph::Padding + row * (FlameGraph::MultipleHeight + FlameGraph::Padding),
+                FlameGraph::MultipleWidth, FlameGraph::MultipleHeight};
     }
-}
 
-void hoverStacks(FrameGraphicsItem* rootItem, const QVector<QVector<Data::Symbol>>& stacks)
-{
-    auto matchStacks = [&stacks](QGraphicsItem* item) {
-        return std::any_of(stacks.begin(), stacks.end(), [item](const auto& stack) {
-            return hoverStack(static_cast<FrameGraphicsItem*>(item), stack, 0);
-        });
-    };
+    // the part of the tile below its label
+    QRect graphRect(int index) const
+    {
+        return tileRect(index).adjusted(0, fontMetrics().height() + FlameGraph::RowMargin, 0, 0);
+    }
 
-    const auto children = rootItem->childItems();
-    const auto costAggregation = Settings::instance()->costAggregation();
-    const auto skipFirstLevel = costAggregation != Settings::CostAggregation::BySymbol;
-    for (auto* child : children) {
-        // reset everything first
-        resetIsExternallyHovered(static_cast<FrameGraphicsItem*>(child));
-
-        // then match all stacks
-        if (skipFirstLevel) {
-            // skip first level
-            const auto grandChildren = child->childItems();
-            bool anyMatched = false;
-            for (auto* grandChild : grandChildren) {
-                anyMatched |= matchStacks(grandChild);
+    int tileAt(QPoint pos) const
+    {
+        for (int i = 0, c = m_multiples.size(); i < c; ++i) {
+            if (tileRect(i).contains(pos)) {
+                return i;
             }
-            static_cast<FrameGraphicsItem*>(child)->setIsExternallyHovered(anyMatched);
-        } else {
-            matchStacks(child);
         }
+        return -1;
     }
-}
-}
 
-void updateFlameGraphColorScheme(FrameGraphicsItem* item, const BrushConfig& brushConfig, quint32 totalCost)
-{
-    item->setBrush(brush(item->symbol(), brushConfig, item->cost(), totalCost));
-    const auto children = item->childItems();
-    for (const auto& child : children) {
-        updateFlameGraphColorScheme(static_cast<FrameGraphicsItem*>(child), brushConfig, totalCost);
-    }
-}
+    FlameGraph* m_flameGraph;
+    QVector<FlameGraph::Multiple> m_multiples;
+    int m_columns = 1;
+    int m_hoveredTile = -1;
+    bool m_building = true;
+};
 
 FlameGraph::FlameGraph(QWidget* parent, Qt::WindowFlags flags)
     : QWidget(parent, flags)
     , m_costSource(new QComboBox(this))
-    , m_scene(new QGraphicsScene(this))
-    , m_view(new QGraphicsView(this))
+    , m_view(new QScrollArea(this))
+    , m_canvas(new FlameGraphCanvas(this))
+    , m_multiplesView(new QScrollArea(this))
+    , m_multiplesCanvas(new FlameGraphMultiplesCanvas(this))
     , m_displayLabel(new KSqueezedTextLabel(this))
     , m_searchResultsLabel(new QLabel(this))
 {
     m_displayLabel->setTextElideMode(Qt::ElideRight);
-    qRegisterMetaType<FrameGraphicsItem*>();
+
+    const auto scheme = KColorScheme(QPalette::Active);
+    m_pen = QPen(scheme.foreground().color());
+    m_rootBrush = scheme.background();
 
     m_costSource->setToolTip(i18n("Select the data source that should be visualized in the flame graph."));
 
     const auto updateHelper = [this]() {
-        m_scene->update(m_scene->sceneRect());
+        m_elidedSymbols.clear();
+        m_canvas->update();
         updateTooltip();
     };
 
@@ -673,12 +518,19 @@ FlameGraph::FlameGraph(QWidget* parent, Qt::WindowFlags flags)
 
     connect(Settings::instance(), &Settings::collapseDepthChanged, this, updateHelper);
 
-    m_scene->setItemIndexMethod(QGraphicsScene::NoIndex);
-    m_view->setScene(m_scene);
+    // the canvas gets resized manually whenever the graph gets laid out
+    m_view->setWidget(m_canvas);
+    m_view->setWidgetResizable(false);
+    m_view->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     m_view->viewport()->installEventFilter(this);
-    m_view->viewport()->setMouseTracking(true);
-    // fix for  QTBUG-105237 view->setFont does not update fontMetrics only the rendered font
-    m_scene->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    m_canvas->installEventFilter(this);
+    m_canvas->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    m_multiplesView->setWidget(m_multiplesCanvas);
+    m_multiplesView->setWidgetResizable(false);
+    m_multiplesView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    m_multiplesView->viewport()->installEventFilter(this);
+    m_multiplesView->hide();
 
     auto bottomUpAction = new CustomWidgetAction(
         [this](QWidget* widget, QHBoxLayout* layout) {
@@ -696,8 +548,10 @@ FlameGraph::FlameGraph(QWidget* parent, Qt::WindowFlags flags)
                 }
 
                 m_showBottomUpData = showBottomUpData;
-                for (auto& stack : m_hoveredStacks) {
-                    std::reverse(stack.begin(), stack.end());
+                // the zoomed in items have no counterpart in the other direction
+                if (!m_data.isEmpty()) {
+                    m_selectionHistory = {0};
+                    m_selectedItem = 0;
                 }
                 showData();
             });
@@ -706,6 +560,37 @@ FlameGraph::FlameGraph(QWidget* parent, Qt::WindowFlags flags)
 
     m_costThreshold = DEFAULT_COST_THRESHOLD;
 
+    auto multiplesAction = new CustomWidgetAction(
+        [this](QWidget* widget, QHBoxLayout* layout) {
+            auto comboBox = new QComboBox(widget);
+            comboBox->addItem(i18n("All Costs"));
+            comboBox->addItem(i18n("Per Thread"), static_cast<int>(FlameGraphMultiples::Grouping::Thread));
+            comboBox->addItem(i18n("Per Process"), static_cast<int>(FlameGraphMultiples::Grouping::Process));
+            comboBox->setToolTip(
+                i18n("<qt>Show a compact flame graph for each of the most expensive threads or processes side by "
+                     "side, which allows spotting the ones that behave differently. Click on one of them to show "
+                     "its full flame graph.</qt>"));
+            layout->addWidget(comboBox);
+
+            connect(comboBox, qOverload<int>(&QComboBox::currentIndexChanged), this, [this, comboBox] {
+                const auto data = comboBox->currentData();
+                std::optional<FlameGraphMultiples::Grouping> grouping;
+                if (data.isValid()) {
+                    grouping = static_cast<FlameGraphMultiples::Grouping>(data.toInt());
+                }
+                setMultiplesGrouping(grouping);
+            });
+            connect(this, &FlameGraph::uiResetRequested, comboBox, [comboBox]() { comboBox->setCurrentIndex(0); });
+            // opening a multiple goes back to the single graph
+            connect(this, &FlameGraph::multiplesShownChanged, comboBox, [comboBox](bool shown) {
+                if (!shown) {
+                    const QSignalBlocker blocker(comboBox);
+                    comboBox->setCurrentIndex(0);
+                }
+            });
+        },
+        this);
+
     auto costThresholdAction = new CustomWidgetAction(
         [this](QWidget* widget, QHBoxLayout* layout) {
             auto costThreshold = new QDoubleSpinBox(widget);
@@ -774,14 +659,9 @@ FlameGraph::FlameGraph(QWidget* parent, Qt::WindowFlags flags)
             auto setColorScheme = [this](Settings::ColorScheme scheme) {
                 Settings::instance()->setColorScheme(scheme);
 
-                if (m_rootItem) {
-                    const auto children = m_rootItem->childItems();
-                    // don't recolor the root item
-                    for (const auto& child : children) {
-                        updateFlameGraphColorScheme(static_cast<FrameGraphicsItem*>(child), brushConfig(scheme),
-                                                    m_rootItem->cost());
-                    }
-                }
+                m_brushes.clear();
+                appendBrushes(m_data, brushConfig(scheme), m_rootBrush, &m_brushes);
+                m_canvas->update();
             };
 
             connect(comboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [comboBox, setColorScheme] {
@@ -825,6 +705,21 @@ FlameGraph::FlameGraph(QWidget* parent, Qt::WindowFlags flags)
     m_resetAction->setShortcut(tr("Escape"));
     connect(m_resetAction, &QAction::triggered, this, [this]() { selectItem(0); });
 
+    m_compareAction = new QAction(QIcon::fromTheme(QStringLiteral("document-compare")), tr("Compare..."), this);
+    m_compareAction->setToolTip(
+        i18n("<qt>Compare the flame graph against a baseline capture. Frames that got more expensive are colored red, "
+             "frames that got cheaper are colored blue.</qt>"));
+    m_compareAction->setCheckable(true);
+    connect(m_compareAction, &QAction::toggled, this, [this](bool checked) {
+        if (checked) {
+            emit compareRequested();
+        } else {
+            emit compareCancelled();
+            clearBaseline();
+        }
+    });
+    connect(this, &FlameGraph::uiResetRequested, this, &FlameGraph::clearBaseline);
+
     // use a QToolBar to automatically hide widgets in a menu that don't fit into the window
     auto controls = new QToolBar(this);
     controls->layout()->setContentsMargins(0, 0, 0, 0);
@@ -836,12 +731,14 @@ FlameGraph::FlameGraph(QWidget* parent, Qt::WindowFlags flags)
     controls->addWidget(m_costSource);
 
     // these can be hidden as necessary
+    controls->addAction(multiplesAction);
     controls->addAction(searchInput);
     controls->addAction(costAggregation);
     controls->addAction(colorSchemeSelector);
     controls->addAction(bottomUpAction);
     controls->addAction(collapseRecursionAction);
     controls->addAction(costThresholdAction);
+    controls->addAction(m_compareAction);
 
     m_displayLabel->setWordWrap(true);
     m_displayLabel->setTextInteractionFlags(m_displayLabel->textInteractionFlags() | Qt::TextSelectableByMouse);
@@ -855,6 +752,7 @@ FlameGraph::FlameGraph(QWidget* parent, Qt::WindowFlags flags)
     layout()->setContentsMargins(0, 0, 0, 0);
     layout()->addWidget(controls);
     layout()->addWidget(m_view);
+    layout()->addWidget(m_multiplesView);
     layout()->addWidget(m_displayLabel);
     layout()->addWidget(m_searchResultsLabel);
 
@@ -866,22 +764,30 @@ FlameGraph::FlameGraph(QWidget* parent, Qt::WindowFlags flags)
 
 FlameGraph::~FlameGraph() = default;
 
-void FlameGraph::setHoveredStacks(const QVector<QVector<Data::Symbol>>& hoveredStacks)
+void FlameGraph::setHoveredStacks(const QSet<qint32>& stackIds)
 {
-    if (m_hoveredStacks == hoveredStacks) {
+    if (m_hoveredStacks == stackIds) {
         return;
     }
 
-    m_hoveredStacks = hoveredStacks;
-    if (m_showBottomUpData) {
-        for (auto& stack : m_hoveredStacks) {
-            std::reverse(stack.begin(), stack.end());
-        }
+    m_hoveredStacks = stackIds;
+    if (!m_data.isEmpty()) {
+        updateExternallyHovered();
+        m_canvas->update();
     }
+}
 
-    if (m_rootItem) {
-        hoverStacks(m_rootItem, m_hoveredStacks);
-    }
+void FlameGraph::setStacks(const QVector<QVector<qint32>>& stacks)
+{
+    m_stacks = stacks;
+    m_stackNodes.clear();
+}
+
+void FlameGraph::setEvents(const Data::EventResults& events)
+{
+    setStacks(events.stacks);
+    m_events = events;
+    rebuildMultiples();
 }
 
 void FlameGraph::setFilterStack(FilterAndZoomStack* filterStack)
@@ -893,12 +799,37 @@ bool FlameGraph::eventFilter(QObject* object, QEvent* event)
 {
     const auto ret = QObject::eventFilter(object, event);
 
+    if (object == m_multiplesView->viewport()) {
+        if (event->type() == QEvent::Resize || event->type() == QEvent::Show) {
+            if (m_multiplesNeedRebuild) {
+                showMultiples();
+            }
+            m_multiplesCanvas->layoutTiles(m_multiplesView->viewport()->size());
+        }
+        return ret;
+    }
+
+    if (object == m_view->viewport()) {
+        if (event->type() == QEvent::Resize || event->type() == QEvent::Show) {
+            if (m_needsRebuild) {
+                showData();
+            }
+            if (m_data.isEmpty()) {
+                m_canvas->resize(m_view->viewport()->size());
+            } else {
+                showItem(m_selectionHistory.at(m_selectedItem));
+            }
+            updateTooltip();
+        }
+        return ret;
+    }
+
     if (event->type() == QEvent::MouseButtonRelease) {
         auto* mouseEvent = static_cast<QMouseEvent*>(event);
         if (mouseEvent->button() == Qt::LeftButton) {
-            auto item = static_cast<FrameGraphicsItem*>(m_view->itemAt(mouseEvent->pos()));
-            if (item && item != m_selectionHistory.at(m_selectedItem)) {
-                selectItem(item);
+            const auto item = itemAt(mouseEvent->pos());
+            if (item != -1 && item != m_selectionHistory.at(m_selectedItem)) {
+                showItem(item);
                 if (m_selectedItem != m_selectionHistory.size() - 1) {
                     m_selectionHistory.remove(m_selectedItem + 1, m_selectionHistory.size() - m_selectedItem - 1);
                 }
@@ -913,43 +844,36 @@ bool FlameGraph::eventFilter(QObject* object, QEvent* event)
         }
     } else if (event->type() == QEvent::MouseMove) {
         auto* mouseEvent = static_cast<QMouseEvent*>(event);
-        auto item = static_cast<FrameGraphicsItem*>(m_view->itemAt(mouseEvent->pos()));
+        const auto item = itemAt(mouseEvent->pos());
+        setHoveredItem(item);
         setTooltipItem(item);
     } else if (event->type() == QEvent::Leave) {
-        setTooltipItem(nullptr);
-    } else if (event->type() == QEvent::Resize || event->type() == QEvent::Show) {
-        if (!m_rootItem) {
-            if (!m_buildingScene) {
-                showData();
-            }
-        } else {
-            selectItem(m_selectionHistory.at(m_selectedItem));
-        }
-        updateTooltip();
+        setHoveredItem(-1);
+        setTooltipItem(-1);
     } else if (event->type() == QEvent::ContextMenu) {
         auto* contextEvent = static_cast<QContextMenuEvent*>(event);
-        auto item = static_cast<FrameGraphicsItem*>(m_view->itemAt(m_view->mapFromGlobal(contextEvent->globalPos())));
+        const auto item = itemAt(m_canvas->mapFromGlobal(contextEvent->globalPos()));
+        const auto symbol = item != -1 ? m_data.symbol(item) : Data::Symbol();
 
         QMenu contextMenu;
-        if (item) {
+        if (item != -1) {
             auto* viewCallerCallee = contextMenu.addAction(tr("View Caller/Callee"));
-            connect(viewCallerCallee, &QAction::triggered, this,
-                    [this, item]() { emit jumpToCallerCallee(item->symbol()); });
+            connect(viewCallerCallee, &QAction::triggered, this, [this, symbol]() { emit jumpToCallerCallee(symbol); });
             auto* openEditorAction = contextMenu.addAction(tr("Open in Editor"));
-            connect(openEditorAction, &QAction::triggered, this, [this, item]() { emit openEditor(item->symbol()); });
-            openEditorAction->setEnabled(item->symbol().isValid());
+            connect(openEditorAction, &QAction::triggered, this, [this, symbol]() { emit openEditor(symbol); });
+            openEditorAction->setEnabled(symbol.isValid());
             contextMenu.addSeparator();
             auto* viewDisassembly = contextMenu.addAction(tr("Disassembly"));
-            connect(viewDisassembly, &QAction::triggered, this,
-                    [this, item]() { emit jumpToDisassembly(item->symbol()); });
-            viewDisassembly->setEnabled(item->symbol().canDisassemble());
+            connect(viewDisassembly, &QAction::triggered, this, [this, symbol]() { emit jumpToDisassembly(symbol); });
+            viewDisassembly->setEnabled(symbol.canDisassemble());
 
             auto* copy = contextMenu.addAction(QIcon::fromTheme(QStringLiteral("edit-copy")), tr("Copy"));
-            connect(copy, &QAction::triggered, this, [item]() { qApp->clipboard()->setText(item->description()); });
+            const auto text = description(item);
+            connect(copy, &QAction::triggered, this, [text]() { qApp->clipboard()->setText(text); });
 
             contextMenu.addSeparator();
         }
-        ResultsUtil::addFilterActions(&contextMenu, item ? item->symbol() : Data::Symbol(), m_filterStack);
+        ResultsUtil::addFilterActions(&contextMenu, symbol, m_filterStack);
         contextMenu.addSeparator();
         contextMenu.addActions(actions());
 
@@ -987,8 +911,41 @@ void FlameGraph::setBottomUpData(const Data::BottomUpResults& bottomUpData)
                                          tr("Show a flame graph over the aggregated %1 sample costs."));
     connect(m_costSource, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this,
             &FlameGraph::showData);
+    connect(m_costSource, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this,
+            &FlameGraph::rebuildMultiples);
 
     rebuild();
+    rebuildMultiples();
+}
+
+void FlameGraph::setBaseline(const Data::BottomUpResults& bottomUpData, const Data::TopDownResults& topDownData)
+{
+    m_baselineBottomUpData = bottomUpData;
+    m_baselineTopDownData = topDownData;
+    {
+        const QSignalBlocker blocker(m_compareAction);
+        m_compareAction->setChecked(true);
+    }
+    rebuild();
+}
+
+void FlameGraph::clearBaseline()
+{
+    {
+        const QSignalBlocker blocker(m_compareAction);
+        m_compareAction->setChecked(false);
+    }
+    if (!hasBaseline()) {
+        return;
+    }
+    m_baselineBottomUpData = {};
+    m_baselineTopDownData = {};
+    rebuild();
+}
+
+bool FlameGraph::hasBaseline() const
+{
+    return m_baselineBottomUpData.costs.numTypes() > 0;
 }
 
 void FlameGraph::rebuild()
@@ -996,10 +953,131 @@ void FlameGraph::rebuild()
     if (isVisible()) {
         showData();
     } else {
-        setData(nullptr);
+        // drop the results of a build that may still be running for the old data and build the new graph once
+        // we get shown again
+        ++m_currentBuildJobId;
+        m_buildingScene = false;
+        m_needsRebuild = true;
+    }
+}
+
+void FlameGraph::rebuildMultiples()
+{
+    if (m_multiplesGrouping && m_multiplesView->isVisible()) {
+        showMultiples();
+    } else {
+        ++m_currentMultiplesJobId;
+        m_multiplesNeedRebuild = true;
     }
 }
 
+void FlameGraph::setMultiplesGrouping(std::optional<FlameGraphMultiples::Grouping> grouping)
+{
+    if (grouping == m_multiplesGrouping) {
+        return;
+    }
+
+    m_multiplesGrouping = grouping;
+    m_view->setVisible(!grouping);
+    m_multiplesView->setVisible(grouping.has_value());
+    rebuildMultiples();
+    emit multiplesShownChanged(grouping.has_value());
+}
+
+void FlameGraph::showMultiples()
+{
+    if (!m_multiplesGrouping || !m_bottomUpData.costs.numTypes()) {
+        return;
+    }
+
+    m_multiplesNeedRebuild = false;
+    m_multiplesCanvas->setBuilding();
+
+    const auto bottomUpData = m_bottomUpData;
+    const auto events = m_events;
+    const auto grouping = *m_multiplesGrouping;
+    const auto type = m_costSource->currentData().value<int>();
+    const auto brushConfig = ::brushConfig(Settings::instance()->colorScheme());
+    const auto rootBrush = m_rootBrush;
+
+    const auto jobId = ++m_currentMultiplesJobId;
+    const auto smartThis = QPointer<FlameGraph>(this);
+    auto jobCancelled = [smartThis, jobId, currentJobId = &m_currentMultiplesJobId]() {
+        return !smartThis || jobId != (*currentJobId);
+    };
+    auto publish = [smartThis, jobCancelled](QVector<Multiple> multiples) {
+        QMetaObject::invokeMethod(
+            smartThis.data(),
+            [smartThis, jobCancelled, multiples = std::move(multiples)]() mutable {
+                if (!jobCancelled()) {
+                    smartThis->m_multiplesCanvas->setMultiples(std::move(multiples),
+                                                               smartThis->m_multiplesView->viewport()->size());
+                }
+            },
+            Qt::QueuedConnection);
+    };
+
+    JobScheduler::run(JobScheduler::Priority::Normal, [bottomUpData, events, grouping, type, brushConfig, rootBrush,
+                                                       jobCancelled, publish]() {
+        if (jobCancelled()) {
+            return;
+        }
+
+        ScopedPhase phase("flame graph multiples build");
+        const auto groups = FlameGraphMultiples::groups(events, type, grouping, MaxMultiples);
+        if (groups.isEmpty()) {
+            publish({});
+            return;
+        }
+
+        // every graph gets built by a job of its own, such that they run in parallel on the shared queue
+        // the last job to finish hands out all of them
+        struct State
+        {
+            QVector<Multiple> multiples;
+            std::atomic<int> remaining {0};
+        };
+        auto state = std::make_shared<State>();
+        state->multiples.resize(groups.size());
+        state->remaining = groups.size();
+        // the jobs only write to their own element, don't let them detach the vector
+        auto* multiples = state->multiples.data();
+
+        for (int i = 0, c = groups.size(); i < c; ++i) {
+            JobScheduler::run(JobScheduler::Priority::Normal, [bottomUpData, events, group = groups.at(i), type,
+                                                               brushConfig, rootBrush, jobCancelled, publish, state,
+                                                               multiple = multiples + i]() {
+                if (!jobCancelled()) {
+                    multiple->group = group;
+                    multiple->data = FlameGraphMultiples::build(bottomUpData, events, group, type,
+                                                                MultiplesCostThreshold);
+                    multiple->data.layout(0, MultipleWidth);
+                    appendBrushes(multiple->data, brushConfig, rootBrush, &multiple->brushes);
+                    const auto id = group.tid == Data::INVALID_TID ? group.pid : group.tid;
+                    multiple->label = i18nc("%1: thread or process name, %2: its id, %3: aggregated cost",
+                                            "%1 (%2): %3", group.name, QString::number(id),
+                                            bottomUpData.costs.formatCost(type, group.cost));
+                }
+                if (--state->remaining == 0) {
+                    publish(std::move(state->multiples));
+                }
+            });
+        }
+    });
+}
+
+void FlameGraph::openMultiple(const FlameGraphMultiples::Group& group)
+{
+    if (m_filterStack) {
+        if (group.tid == Data::INVALID_TID) {
+            m_filterStack->filterInByProcess(group.pid);
+        } else {
+            m_filterStack->filterInByThread(group.tid);
+        }
+    }
+    setMultiplesGrouping(std::nullopt);
+}
+
 void FlameGraph::clear()
 {
     emit uiResetRequested();
@@ -1007,26 +1085,27 @@ void FlameGraph::clear()
 
 QImage FlameGraph::toImage() const
 {
-    if (!m_rootItem)
+    if (m_data.isEmpty())
         return {};
 
-    const auto sceneRect = m_scene->sceneRect();
-    QImage image(sceneRect.size().toSize(), QImage::Format_ARGB32_Premultiplied);
+    const auto rect = QRect({0, 0}, m_canvas->size());
+    QImage image(rect.size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
     QPainter painter(&image);
-    m_scene->render(&painter, {{0, 0}, sceneRect.size()}, sceneRect);
+    paintFlameGraph(&painter, rect, m_rootBrush, m_pen);
     return image;
 }
 
 void FlameGraph::saveSvg(const QString& fileName) const
 {
-    if (!m_rootItem)
+    if (m_data.isEmpty())
         return;
 
-    const auto sceneRect = m_scene->sceneRect();
+    const auto rect = QRect({0, 0}, m_canvas->size());
 
     QSvgGenerator generator;
-    generator.setSize(sceneRect.size().toSize());
-    generator.setViewBox({{0, 0}, sceneRect.size()});
+    generator.setSize(rect.size());
+    generator.setViewBox(rect);
     generator.setFileName(fileName);
     if (m_showBottomUpData)
         generator.setTitle(tr("Bottom Up FlameGraph"));
@@ -1037,16 +1116,8 @@ void FlameGraph::saveSvg(const QString& fileName) const
                                  .arg(costType, QString::number(m_costThreshold), m_displayLabel->text())
                                  .toHtmlEscaped());
 
-    const auto oldPen = m_rootItem->pen();
-    const auto oldBrush = m_rootItem->brush();
-    m_rootItem->setPen(QPen(Qt::black));
-    m_rootItem->setBrush(QBrush(Qt::white));
-
     QPainter painter(&generator);
-    m_scene->render(&painter, generator.viewBoxF(), sceneRect);
-
-    m_rootItem->setPen(oldPen);
-    m_rootItem->setBrush(oldBrush);
+    paintFlameGraph(&painter, rect, QBrush(Qt::white), QPen(Qt::black));
 }
 
 void FlameGraph::showData()
@@ -1058,96 +1129,296 @@ void FlameGraph::showData()
         return;
     }
 
-    setData(nullptr);
-
+    // the current graph stays visible until the first results of the new build arrive
+    m_needsRebuild = false;
     m_buildingScene = true;
-    using namespace ThreadWeaver;
+
     auto bottomUpData = m_bottomUpData;
     auto topDownData = m_topDownData;
+    auto baselineBottomUpData = m_baselineBottomUpData;
+    auto baselineTopDownData = m_baselineTopDownData;
     const auto collapseRecursion = m_collapseRecursion;
     auto type = m_costSource->currentData().value<int>();
     auto threshold = m_costThreshold;
     auto brushConfig = ::brushConfig(Settings::instance()->colorScheme());
+    auto rootBrush = m_rootBrush;
 
-    stream() << make_job(
-        [showBottomUpData, bottomUpData, topDownData, type, threshold, brushConfig, collapseRecursion, this]() {
-            FrameGraphicsItem* parsedData = nullptr;
-            if (showBottomUpData) {
-                parsedData = parseData(bottomUpData.costs, type, bottomUpData.root.children, threshold, brushConfig,
-                                       collapseRecursion);
-            } else {
-                parsedData = parseData(topDownData.inclusiveCosts, type, topDownData.root.children, threshold,
-                                       brushConfig, collapseRecursion);
+    // starting a new build cancels any build that is still in flight
+    const auto jobId = ++m_currentBuildJobId;
+    const auto smartThis = QPointer<FlameGraph>(this);
+    auto jobCancelled = [smartThis, jobId, currentJobId = &m_currentBuildJobId]() {
+        return !smartThis || jobId != (*currentJobId);
+    };
+
+    JobScheduler::run(JobScheduler::Priority::Normal, [showBottomUpData, bottomUpData, topDownData,
+                                                       baselineBottomUpData, baselineTopDownData, type, threshold,
+                                                       brushConfig, collapseRecursion, rootBrush, smartThis, jobId,
+                                                       jobCancelled]() {
+        ScopedPhase phase("flame graph build");
+        auto publish = [&](FlameGraphData data, QVector<QBrush> nodeBrushes, bool isComplete) {
+            QMetaObject::invokeMethod(
+                smartThis.data(),
+                [smartThis, jobId, jobCancelled, data = std::move(data), nodeBrushes = std::move(nodeBrushes),
+                 isComplete]() mutable {
+                    if (!jobCancelled()) {
+                        smartThis->setData(std::move(data), std::move(nodeBrushes), jobId, isComplete);
+                    }
+                },
+                Qt::QueuedConnection);
+        };
+
+        // build the graph depth by depth and hand out intermediate results every now and then, such that the
+        // top levels show up right away while the deeper levels stream in
+        auto parseData = [&](const Data::Costs& costs, const auto& rows, const Data::Costs& baselineCosts,
+                             const auto& baselineRows) {
+            const auto totalCost = costs.totalCost(type);
+            const auto label =
+                i18n("%1 aggregated %2 cost in total", costs.formatCost(type, totalCost), costs.typeName(type));
+            const auto costThreshold = static_cast<qint64>(static_cast<double>(totalCost) * threshold / 100.);
+            using Tree = typename std::decay_t<decltype(rows)>::value_type;
+            FlameGraphBuilder<Tree> builder(costs, type, rows, costThreshold, collapseRecursion, Data::Symbol(label));
+
+            // when comparing against a baseline, match the cost types by their name
+            std::unique_ptr<FlameGraphDiff<Tree>> diff;
+            for (int baselineType = 0; baselineType < baselineCosts.numTypes(); ++baselineType) {
+                if (baselineCosts.typeName(baselineType) == costs.typeName(type)) {
+                    diff = std::make_unique<FlameGraphDiff<Tree>>(baselineCosts, baselineType, baselineRows,
+                                                                  collapseRecursion);
+                    break;
+                }
             }
-            QMetaObject::invokeMethod(this, "setData", Qt::QueuedConnection, Q_ARG(FrameGraphicsItem*, parsedData));
-        });
+
+            QVector<QBrush> nodeBrushes;
+            QElapsedTimer timer;
+            while (!jobCancelled()) {
+                const auto isComplete = !builder.buildNextDepth();
+                if (isComplete || !timer.isValid() || timer.hasExpired(ProgressiveUpdateInterval)) {
+                    auto data = builder.data();
+                    if (diff) {
+                        diff->update(&data, isComplete);
+                    }
+                    appendBrushes(data, brushConfig, rootBrush, &nodeBrushes);
+                    publish(std::move(data), nodeBrushes, isComplete);
+                    timer.start();
+                }
+                if (isComplete) {
+                    break;
+                }
+            }
+        };
+        if (showBottomUpData) {
+            parseData(bottomUpData.costs, bottomUpData.root.children, baselineBottomUpData.costs,
+                      baselineBottomUpData.root.children);
+        } else {
+            parseData(topDownData.inclusiveCosts, topDownData.root.children, baselineTopDownData.inclusiveCosts,
+                      baselineTopDownData.root.children);
+        }
+    });
     updateNavigationActions();
 }
 
-void FlameGraph::setTooltipItem(const FrameGraphicsItem* item)
+const QVector<qint32>& FlameGraph::stackNodes(qint32 stackId)
+{
+    auto it = m_stackNodes.find(stackId);
+    if (it != m_stackNodes.end()) {
+        return *it;
+    }
+
+    QVector<qint32> nodes;
+    if (stackId >= 0 && stackId < m_stacks.size() && !m_data.isEmpty()) {
+        // the frames of the stack start at the leaf, the top-down graph starts at the outermost caller
+        QVector<const Data::Symbol*> frames;
+        m_bottomUpData.foreachFrame(m_stacks.at(stackId), [&frames](const Data::Symbol& symbol, const Data::Location&) {
+            frames.push_back(&symbol);
+            return true;
+        });
+        if (!m_dataShowsBottomUp) {
+            std::reverse(frames.begin(), frames.end());
+        }
+
+        auto addNode = [&](qint32 start) {
+            const auto node = findStackNode(m_data, start, frames, m_collapseRecursion);
+            if (node > 0) {
+                nodes.push_back(node);
+            }
+        };
+        const auto& root = m_data.node(0);
+        if (Settings::instance()->costAggregation() != Settings::CostAggregation::BySymbol) {
+            // the first level groups the stacks by thread, process or CPU, which the stack may belong to any of
+            for (auto child = root.firstChild, end = root.firstChild + root.numChildren; child < end; ++child) {
+                addNode(child);
+            }
+        } else if (!frames.isEmpty()) {
+            addNode(0);
+        }
+    }
+    return *m_stackNodes.insert(stackId, nodes);
+}
+
+void FlameGraph::updateExternallyHovered()
 {
-    if (!item && m_selectedItem != -1 && m_selectionHistory.at(m_selectedItem)) {
+    m_externallyHovered.fill(false, m_data.size());
+    for (auto stackId : std::as_const(m_hoveredStacks)) {
+        for (auto node : stackNodes(stackId)) {
+            // stop at the paths already marked by another stack
+            for (; node > 0 && !m_externallyHovered.at(node); node = m_data.node(node).parent) {
+                m_externallyHovered[node] = true;
+            }
+        }
+    }
+}
+
+void FlameGraph::setTooltipItem(qint32 item)
+{
+    if (item == -1 && m_selectedItem != -1) {
         item = m_selectionHistory.at(m_selectedItem);
-        m_view->setCursor(Qt::ArrowCursor);
+        m_canvas->setCursor(Qt::ArrowCursor);
     } else {
-        m_view->setCursor(Qt::PointingHandCursor);
+        m_canvas->setCursor(Qt::PointingHandCursor);
     }
 
     m_tooltipItem = item;
     updateTooltip();
 
-    if (item) {
-        emit selectSymbol(item->symbol());
+    if (item != -1) {
+        emit selectSymbol(m_data.symbol(item));
 
         const auto costAggregation = Settings::instance()->costAggregation();
         const auto skipFirstLevel = costAggregation != Settings::CostAggregation::BySymbol;
         QVector<Data::Symbol> stack;
         stack.reserve(32);
-        while (item && (item != m_rootItem && (!skipFirstLevel || item->parentItem() != m_rootItem))) {
-            stack.append(item->symbol());
-            item = static_cast<const FrameGraphicsItem*>(item->parentItem());
+        while (item > 0 && (!skipFirstLevel || m_data.node(item).parent != 0)) {
+            stack.append(m_data.symbol(item));
+            item = m_data.node(item).parent;
         }
         emit selectStack(stack, m_showBottomUpData);
     }
 }
 
+void FlameGraph::setHoveredItem(qint32 item)
+{
+    if (m_hoveredItem != item) {
+        m_hoveredItem = item;
+        m_canvas->update();
+    }
+}
+
 void FlameGraph::updateTooltip()
 {
-    const auto text = m_tooltipItem ? m_tooltipItem->description() : QString();
+    const auto text = m_tooltipItem != -1 ? description(m_tooltipItem) : QString();
     m_displayLabel->setToolTip(text);
     m_displayLabel->setText(text);
 }
 
-void FlameGraph::setData(FrameGraphicsItem* rootItem)
+QString FlameGraph::description(qint32 item) const
 {
-    m_scene->clear();
-    m_buildingScene = false;
-    m_tooltipItem = nullptr;
-    m_rootItem = rootItem;
-    m_selectionHistory.clear();
-    m_selectionHistory.push_back(rootItem);
-    m_selectedItem = 0;
-    if (!rootItem) {
-        auto text = m_scene->addText(i18n("generating flame graph..."));
-        m_view->centerOn(text);
-        m_view->setCursor(Qt::BusyCursor);
-        return;
+    // we build the tooltip text on demand, which is much faster than doing that for potentially thousands of items when
+    // we load the data
+    const auto& symbol = m_data.symbol(item);
+    auto formattedSymbol = Util::formatSymbolExtended(symbol);
+    if (item == 0) {
+        return formattedSymbol;
+    }
+
+    const auto cost = m_data.node(item).cost;
+    const auto totalCost = m_data.node(0).cost;
+    const auto unit = m_data.unit();
+    auto text = [&]() {
+        switch (unit) {
+        case Data::Costs::Unit::Unknown:
+            return i18nc("%1: aggregated sample costs, %2: relative number, %3: function label, %4: binary, "
+                         "%5: cost name",
+                         "%1 (%2%) aggregated %5 costs in %3 (%4) and below.", Data::Costs::formatCost(unit, cost),
+                         Util::formatCostRelative(cost, totalCost), formattedSymbol, symbol.binary,
+                         m_data.costName());
+        case Data::Costs::Unit::Tracepoint:
+            return i18nc("%1: number of tracepoint events, %2: relative number, %3: function label, %4: binary",
+                         "%1 (%2%) aggregated %5 events in %3 (%4) and below.", Data::Costs::formatCost(unit, cost),
+                         Util::formatCostRelative(cost, totalCost), formattedSymbol, symbol.binary,
+                         m_data.costName());
+        case Data::Costs::Unit::Time:
+            return i18nc("%1: elapsed time, %2: relative number, %3: function label, %4: binary",
+                         "%1 (%2%) aggregated %5 in %3 (%4) and below.", Data::Costs::formatCost(unit, cost),
+                         Util::formatCostRelative(cost, totalCost), formattedSymbol, symbol.binary,
+                         m_data.costName());
+        }
+        Q_UNREACHABLE();
+    }();
+
+    if (m_data.hasBaseline()) {
+        const auto baselineCost = m_data.baselineCost(item);
+        text = i18nc("%1: description, %2: aggregated sample costs in the baseline, %3: relative number",
+                     "%1 Baseline: %2 (%3%).", text, Data::Costs::formatCost(unit, baselineCost),
+                     Util::formatCostRelative(baselineCost, m_data.baselineCost(0)));
+    }
+    return text;
+}
+
+void FlameGraph::setData(FlameGraphData data, QVector<QBrush> brushes, uint jobId, bool isComplete)
+{
+    // node ids stay stable while a graph is built up, so intermediate results only extend the current state
+    const auto isUpdate = jobId == m_dataJobId && !m_data.isEmpty();
+
+    QVector<qint32> selectionHistory = {0};
+    int selectedItem = 0;
+    if (!isUpdate && !m_data.isEmpty()) {
+        // keep showing the previous graph until the new one is deep enough to restore the zoomed in item
+        const auto zoomDepth = m_data.node(m_selectionHistory.at(m_selectedItem)).depth;
+        if (!isComplete && data.node(data.size() - 1).depth < zoomDepth) {
+            return;
+        }
+
+        // then carry the selection history over, based on the symbols along the path of every item
+        selectionHistory.clear();
+        for (int i = 0; i < m_selectionHistory.size(); ++i) {
+            const auto item = data.findNode(m_data, m_selectionHistory.at(i));
+            if (item != -1 && (selectionHistory.isEmpty() || selectionHistory.constLast() != item)) {
+                selectionHistory.push_back(item);
+            }
+            if (i <= m_selectedItem) {
+                selectedItem = selectionHistory.size() - 1;
+            }
+        }
     }
 
-    m_view->setCursor(Qt::ArrowCursor);
-    // layouting needs a root item with a given height, the rest will be overwritten later
-    rootItem->setRect(0, 0, 800, m_view->fontMetrics().height() + 4);
-    m_scene->addItem(rootItem);
+    m_buildingScene = !isComplete;
+    m_dataJobId = jobId;
+    m_data = std::move(data);
+    m_elidedSymbols.clear();
+    m_brushes = std::move(brushes);
+    m_searchMatches.fill(NoSearch, m_data.size());
+    // the results of a build always match the current direction, a new build gets started when it changes
+    m_dataShowsBottomUp = m_showBottomUpData;
+    m_stackNodes.clear();
 
     if (!m_search.isEmpty()) {
         setSearchValue(m_search);
     }
-    if (!m_hoveredStacks.isEmpty()) {
-        hoverStacks(rootItem, m_hoveredStacks);
+    updateExternallyHovered();
+
+    if (isUpdate) {
+        if (isVisible()) {
+            // the graph grows upwards, keep the part the user is looking at in place
+            auto* scrollBar = m_view->verticalScrollBar();
+            const auto distanceToBottom = scrollBar->maximum() - scrollBar->value();
+            layoutItem(m_selectionHistory.at(m_selectedItem));
+            scrollBar->setValue(scrollBar->maximum() - distanceToBottom);
+        }
+        if (isComplete) {
+            emit canConvertToImageChanged();
+        }
+        return;
     }
 
+    m_tooltipItem = -1;
+    m_hoveredItem = -1;
+    m_selectionHistory = std::move(selectionHistory);
+    m_selectedItem = selectedItem;
+    m_canvas->setCursor(Qt::ArrowCursor);
+    updateNavigationActions();
+
     if (isVisible()) {
-        selectItem(m_rootItem);
+        showItem(m_selectionHistory.at(m_selectedItem));
     }
 
     emit canConvertToImageChanged();
@@ -1157,63 +1428,250 @@ void FlameGraph::selectItem(int item)
 {
     m_selectedItem = item;
     updateNavigationActions();
-    selectItem(m_selectionHistory.at(m_selectedItem));
+    showItem(m_selectionHistory.at(m_selectedItem));
+}
+
+int FlameGraph::rowHeight() const
+{
+    return m_canvas->fontMetrics().height() + 4;
+}
+
+QRectF FlameGraph::itemRect(qint32 item) const
+{
+    // the root is at the bottom, deeper frames are stacked on top of it
+    const auto height = rowHeight();
+    const auto y = m_canvas->height() - (m_data.node(item).depth + 1) * (height + RowMargin);
+    return {Padding + m_data.x(item), static_cast<qreal>(y), m_data.width(item), static_cast<qreal>(height)};
+}
+
+qint32 FlameGraph::itemAt(QPoint pos) const
+{
+    if (m_data.isEmpty()) {
+        return -1;
+    }
+    const auto rowStride = rowHeight() + RowMargin;
+    const auto fromBottom = m_canvas->height() - pos.y();
+    if (fromBottom < 0 || fromBottom % rowStride < RowMargin) {
+        return -1;
+    }
+    return m_data.nodeAt(fromBottom / rowStride, pos.x() - Padding);
 }
 
-void FlameGraph::selectItem(FrameGraphicsItem* item)
+void FlameGraph::showItem(qint32 item)
 {
-    if (!item) {
+    if (item < 0 || item >= m_data.size()) {
         return;
     }
 
+    layoutItem(item);
+
+    // and make sure it's visible
+    const auto rect = itemRect(item).toRect();
+    m_view->ensureVisible(rect.center().x(), rect.center().y());
+
+    setTooltipItem(item);
+}
+
+void FlameGraph::layoutItem(qint32 item)
+{
     // scale item and its parents to the maximum available width
     // also hide all siblings of the parent items
-    const auto padding = 8;
-    const auto rootWidth = m_view->viewport()->width() - padding * 2
+    const auto rootWidth = m_view->viewport()->width() - Padding * 2
         - (m_view->verticalScrollBar()->isVisible() ? 0 : m_view->verticalScrollBar()->sizeHint().width());
-    auto parent = item;
-    while (parent) {
-        auto rect = parent->rect();
-        rect.setLeft(0);
-        rect.setWidth(rootWidth);
-        parent->setRect(rect);
-        if (parent->parentItem()) {
-            foreach (auto sibling, parent->parentItem()->childItems()) {
-                sibling->setVisible(sibling == parent);
+    m_data.layout(item, rootWidth);
+
+    const auto contentHeight = m_data.numVisibleRows() * (rowHeight() + RowMargin);
+    m_canvas->resize(rootWidth + 2 * Padding, std::max(contentHeight, m_view->viewport()->height()));
+    m_canvas->update();
+}
+
+QString FlameGraph::elidedSymbol(const Data::Symbol& symbol, const QFontMetrics& fontMetrics, int width) const
+{
+    auto elide = [&symbol, &fontMetrics](int width) {
+        const auto formattedSymbol = Util::formatSymbol(symbol, false);
+        const auto symbolText = formattedSymbol.isEmpty()
+            ? QObject::tr("?? [%1]").arg(Util::formatString(symbol.binary))
+            : formattedSymbol;
+        return Util::elideSymbol(symbolText, fontMetrics, width);
+    };
+
+    if (symbol.internId == -1) {
+        return elide(width);
+    }
+
+    // the canvas uses a fixed font, so rounding down to whole characters yields the same text as the exact width
+    // and all the items of a row that are about equally wide share the cache entry
+    const auto charWidth = std::max(1, fontMetrics.averageCharWidth());
+    const auto bucket = width / charWidth;
+    const auto key = (static_cast<quint64>(static_cast<quint32>(symbol.internId)) << 32) | static_cast<quint32>(bucket);
+    auto it = m_elidedSymbols.constFind(key);
+    if (it == m_elidedSymbols.constEnd()) {
+        it = m_elidedSymbols.insert(key, elide(bucket * charWidth));
+    }
+    return *it;
+}
+
+void FlameGraph::paintFlameGraph(QPainter* painter, const QRect& exposed, const QBrush& rootBrush,
+                                 const QPen& pen) const
+{
+    painter->setFont(m_canvas->font());
+
+    if (m_data.isEmpty()) {
+        painter->drawText(m_canvas->rect(), Qt::AlignCenter, i18n("generating flame graph..."));
+        return;
+    }
+
+    const auto fontMetrics = painter->fontMetrics();
+    const auto selectedItem = m_selectedItem > 0 ? m_selectionHistory.at(m_selectedItem) : -1;
+
+    auto paintItem = [&](qint32 item, const QRectF& rect) {
+        const auto& symbol = m_data.symbol(item);
+        const auto& brush = item == 0 ? rootBrush : m_brushes.at(item);
+        const auto searchMatch = m_searchMatches.at(item);
+        const bool isSelected = item == selectedItem;
+        painter->setPen(pen);
+
+        if (isSelected || item == m_hoveredItem || m_externallyHovered.at(item) || searchMatch == DirectMatch) {
+            auto selectedColor = brush.color();
+            selectedColor.setAlpha(255);
+            painter->fillRect(rect, selectedColor);
+        } else if (searchMatch == NoMatch) {
+            auto noMatchColor = brush.color();
+            noMatchColor.setAlpha(50);
+            painter->fillRect(rect, noMatchColor);
+        } else {
+            // default, when no search is running, or a sub-item is matched
+            auto background = brush;
+
+            // give inline frames a slightly different background color
+            if (symbol.isInline) {
+                auto color = background.color();
+                if (qGray(pen.color().rgb()) < 128) {
+                    color = color.lighter();
+                } else {
+                    color = color.darker();
+                }
+                background.setColor(color);
+            }
+            painter->fillRect(rect, background);
+
+            // give inline frames a border with the normal background color
+            if (symbol.isInline) {
+                painter->setPen(QPen(brush.color(), 0.));
+                painter->drawRect(rect.adjusted(-1, -1, -1, -1));
+                painter->setPen(pen);
             }
         }
-        parent = static_cast<FrameGraphicsItem*>(parent->parentItem());
-    }
 
-    // then layout all items below the selected on
-    layoutItems(item);
+        auto textPen = pen;
+        if (searchMatch != NoMatch) {
+            auto borderPen = pen;
+            borderPen.setColor(brush.color());
+            if (isSelected) {
+                borderPen.setWidth(2);
+            }
+            painter->setPen(borderPen);
+            painter->drawRect(rect);
+            painter->setPen(pen);
+        }
 
-    // Triggers a refresh of the scene's bounding rect without going via the
-    // event loop. This makes the centerOn call below work as expected in all cases.
-    m_scene->sceneRect();
+        const int margin = 4;
+        const int width = rect.width() - 2 * margin;
+        if (width < fontMetrics.averageCharWidth() * 6) {
+            // text is too wide for the current LOD, don't paint it
+            return;
+        }
 
-    // and make sure it's visible
-    m_view->centerOn(item);
+        if (searchMatch == NoMatch) {
+            auto color = pen.color();
+            color.setAlpha(125);
+            textPen.setColor(color);
+            painter->setPen(textPen);
+        }
 
-    setTooltipItem(item);
+        const int height = rect.height();
+        painter->drawText(margin + rect.x(), rect.y(), width, height,
+                          Qt::AlignVCenter | Qt::AlignLeft | Qt::TextSingleLine,
+                          elidedSymbol(symbol, fontMetrics, width));
+    };
+
+    const auto exposedLeft = exposed.left() - Padding;
+    const auto exposedRight = exposed.right() - Padding;
+    for (int depth = 0, c = m_data.numVisibleRows(); depth < c; ++depth) {
+        const auto& items = m_data.visibleNodes(depth);
+        const auto rowRect = itemRect(items.constFirst());
+        if (rowRect.bottom() < exposed.top() || rowRect.top() > exposed.bottom()) {
+            continue;
+        }
+
+        // only paint the items that intersect the exposed area, they are sorted by their position
+        auto it = std::lower_bound(items.begin(), items.end(), exposedLeft, [this](qint32 item, double x) {
+            return m_data.x(item) + m_data.width(item) < x;
+        });
+        for (auto end = items.end(); it != end && m_data.x(*it) <= exposedRight; ++it) {
+            paintItem(*it, itemRect(*it));
+        }
+    }
 }
 
 void FlameGraph::setSearchValue(const QString& value)
 {
-    if (!m_rootItem) {
+    if (m_data.isEmpty()) {
         return;
     }
 
     m_search = value;
 
-    auto match = applySearch(m_rootItem, value);
+    if (value.isEmpty()) {
+        m_searchMatches.fill(NoSearch, m_data.size());
+    } else {
+        m_searchMatches.fill(NoMatch, m_data.size());
+    }
+
+    // the index yields the direct matches sorted by id, which means parents get visited before their children
+    const auto matches = value.isEmpty() ? QVector<qint32>() : m_data.search(value);
+    for (const auto item : matches) {
+        m_searchMatches[item] = DirectMatch;
+    }
+
+    qint64 directCost = 0;
+    for (const auto item : matches) {
+        // mark the parents, unless the item is nested in another match whose cost already includes it
+        // an item that already got marked as a child match has no direct match above it
+        auto parent = m_data.node(item).parent;
+        while (parent != -1 && m_searchMatches.at(parent) == NoMatch) {
+            parent = m_data.node(parent).parent;
+        }
+        if (parent != -1 && m_searchMatches.at(parent) == DirectMatch) {
+            continue;
+        }
+        directCost += m_data.node(item).cost;
+        for (parent = m_data.node(item).parent; parent != -1 && m_searchMatches.at(parent) == NoMatch;
+             parent = m_data.node(parent).parent) {
+            m_searchMatches[parent] = ChildMatch;
+        }
+
+        // the callees of a match are part of its cost, so they get highlighted too
+        QVector<qint32> subtree = {item};
+        while (!subtree.isEmpty()) {
+            const auto& node = m_data.node(subtree.takeLast());
+            for (auto child = node.firstChild, end = node.firstChild + node.numChildren; child < end; ++child) {
+                if (m_searchMatches.at(child) == NoMatch) {
+                    m_searchMatches[child] = ParentMatch;
+                }
+                subtree.push_back(child);
+            }
+        }
+    }
+    m_canvas->update();
 
     if (value.isEmpty()) {
         m_searchResultsLabel->hide();
     } else {
-        m_searchResultsLabel->setText(
-            i18n("%1 (%2% of total of %3) aggregated costs matched by search.", Util::formatCost(match.directCost),
-                 Util::formatCostRelative(match.directCost, m_rootItem->cost()), m_rootItem->cost()));
+        const auto totalCost = m_data.node(0).cost;
+        m_searchResultsLabel->setText(i18n("%1 (%2% of total of %3) aggregated costs matched by search.",
+                                           Util::formatCost(directCost),
+                                           Util::formatCostRelative(directCost, totalCost), totalCost));
         m_searchResultsLabel->show();
     }
 }
@@ -1243,5 +1701,5 @@ void FlameGraph::updateNavigationActions()
 
 bool FlameGraph::canConvertToImage() const
 {
-    return m_rootItem != nullptr;
+    return !m_data.isEmpty() && !m_buildingScene;
 }
@@ -7,20 +7,28 @@
 
 #pragma once
 
+#include <QBrush>
+#include <QHash>
+#include <QPen>
+#include <QSet>
 #include <QVector>
 #include <QWidget>
 
+#include <atomic>
+#include <optional>
+
 #include <models/data.h>
+#include <models/flamegraphdata.h>
 
-class QGraphicsScene;
-class QGraphicsView;
+class QScrollArea;
 class QComboBox;
 class QLabel;
 class QLineEdit;
 
 class KSqueezedTextLabel;
 
-class FrameGraphicsItem;
+class FlameGraphCanvas;
+class FlameGraphMultiplesCanvas;
 class FilterAndZoomStack;
 
 class FlameGraph : public QWidget
@@ -30,12 +38,21 @@ public:
     explicit FlameGraph(QWidget* parent = nullptr, Qt::WindowFlags flags = {});
     ~FlameGraph();
 
-    void setHoveredStacks(const QVector<QVector<Data::Symbol>>& stacks);
+    // highlights the paths of the given stacks, see Data::EventResults::stacks
+    void setHoveredStacks(const QSet<qint32>& stackIds);
+    void setStacks(const QVector<QVector<qint32>>& stacks);
+    // also sets the stacks, the small multiples get built from the events of the individual threads
+    void setEvents(const Data::EventResults& events);
     void setFilterStack(FilterAndZoomStack* filterStack);
     void setTopDownData(const Data::TopDownResults& topDownData);
     void setBottomUpData(const Data::BottomUpResults& bottomUpData);
     void clear();
 
+    // turns this into a differential flame graph that compares the data against the given baseline capture
+    void setBaseline(const Data::BottomUpResults& bottomUpData, const Data::TopDownResults& topDownData);
+    void clearBaseline();
+    bool hasBaseline() const;
+
     QImage toImage() const;
     void saveSvg(const QString& fileName) const;
     bool canConvertToImage() const;
@@ -44,7 +61,6 @@ protected:
     bool eventFilter(QObject* object, QEvent* event) override;
 
 private slots:
-    void setData(FrameGraphicsItem* rootItem);
     void setSearchValue(const QString& value);
     void navigateBack();
     void navigateForward();
@@ -57,39 +73,130 @@ signals:
     void jumpToDisassembly(const Data::Symbol& symbol);
     void uiResetRequested();
     void canConvertToImageChanged();
+    // the user wants to pick a baseline capture, see setBaseline
+    void compareRequested();
+    void compareCancelled();
+    // the small multiples got shown or hidden, see setMultiplesGrouping
+    void multiplesShownChanged(bool shown);
 
 private:
-    void setTooltipItem(const FrameGraphicsItem* item);
+    friend class FlameGraphCanvas;
+    friend class FlameGraphMultiplesCanvas;
+
+    enum SearchMatchType : quint8
+    {
+        NoSearch,
+        NoMatch,
+        DirectMatch,
+        // one of the descendants matches
+        ChildMatch,
+        // one of the ancestors matches
+        ParentMatch
+    };
+
+    // @p isComplete is false for the intermediate results of the progressive build with the given @p jobId
+    void setData(FlameGraphData data, QVector<QBrush> brushes, uint jobId, bool isComplete);
+    void setTooltipItem(qint32 item);
+    void setHoveredItem(qint32 item);
+    // the nodes of m_data at the end of the path of the given stack, looked up once per build
+    const QVector<qint32>& stackNodes(qint32 stackId);
+    void updateExternallyHovered();
     void updateTooltip();
+    QString description(qint32 item) const;
     void showData();
+    // select the given entry of the selection history
     void selectItem(int item);
-    void selectItem(FrameGraphicsItem* item);
+    // scale the given node and its parents to the full width and layout everything below
+    void showItem(qint32 item);
+    void layoutItem(qint32 item);
     void updateNavigationActions();
     void rebuild();
 
+    // one compact graph of the small multiples, see FlameGraphMultiples
+    struct Multiple
+    {
+        FlameGraphMultiples::Group group;
+        // laid out for the width of a tile already
+        FlameGraphData data;
+        QVector<QBrush> brushes;
+        QString label;
+    };
+    // shows the single graph of all costs when @p grouping is unset
+    void setMultiplesGrouping(std::optional<FlameGraphMultiples::Grouping> grouping);
+    void rebuildMultiples();
+    void showMultiples();
+    // filters the results by the thread or process of the multiple and goes back to the single graph
+    void openMultiple(const FlameGraphMultiples::Group& group);
+
+    int rowHeight() const;
+    QRectF itemRect(qint32 item) const;
+    qint32 itemAt(QPoint pos) const;
+    void paintFlameGraph(QPainter* painter, const QRect& exposed, const QBrush& rootBrush, const QPen& pen) const;
+    // the formatted symbol elided to @p width, cached as formatting and eliding dominate the painting otherwise
+    QString elidedSymbol(const Data::Symbol& symbol, const QFontMetrics& fontMetrics, int width) const;
+
+    static const constexpr int Padding = 8;
+    static const constexpr int RowMargin = 2;
+    // interval in ms after which a progressive build shows its intermediate results
+    static const constexpr int ProgressiveUpdateInterval = 100;
+    // the small multiples show the most expensive threads or processes in tiles of that size, with thin rows
+    static const constexpr int MaxMultiples = 64;
+    static const constexpr int MultipleWidth = 240;
+    static const constexpr int MultipleHeight = 120;
+    static const constexpr int MultipleRowHeight = 4;
+    // cost threshold in percent of every multiple, the tiles are too small to show more details anyway
+    static const constexpr double MultiplesCostThreshold = 1.;
+
     Data::TopDownResults m_topDownData;
     Data::BottomUpResults m_bottomUpData;
+    Data::TopDownResults m_baselineTopDownData;
+    Data::BottomUpResults m_baselineBottomUpData;
 
     FilterAndZoomStack* m_filterStack = nullptr;
     QComboBox* m_costSource;
-    QGraphicsScene* m_scene;
-    QGraphicsView* m_view;
+    QScrollArea* m_view;
+    FlameGraphCanvas* m_canvas;
+    QScrollArea* m_multiplesView;
+    FlameGraphMultiplesCanvas* m_multiplesCanvas;
     KSqueezedTextLabel* m_displayLabel;
     QLabel* m_searchResultsLabel;
     QAction* m_forwardAction = nullptr;
     QAction* m_backAction = nullptr;
     QAction* m_resetAction = nullptr;
-    const FrameGraphicsItem* m_tooltipItem = nullptr;
-    FrameGraphicsItem* m_rootItem = nullptr;
-    QVector<FrameGraphicsItem*> m_selectionHistory;
+    QAction* m_compareAction = nullptr;
+    FlameGraphData m_data;
+    // per node of m_data
+    QVector<QBrush> m_brushes;
+    QVector<SearchMatchType> m_searchMatches;
+    QVector<bool> m_externallyHovered;
+    QBrush m_rootBrush;
+    QPen m_pen;
+    qint32 m_tooltipItem = -1;
+    qint32 m_hoveredItem = -1;
+    // node ids of the zoomed in items
+    QVector<qint32> m_selectionHistory;
     int m_selectedItem = -1;
     int m_minRootWidth = 0;
     bool m_showBottomUpData = false;
     bool m_collapseRecursion = false;
     bool m_buildingScene = false;
+    bool m_needsRebuild = true;
+    std::atomic<uint> m_currentBuildJobId {0};
+    // the build job that produced m_data
+    uint m_dataJobId = 0;
     QString m_search;
     // cost threshold in percent, items below that value will not be shown
     static const constexpr double DEFAULT_COST_THRESHOLD = 0.1;
     double m_costThreshold = DEFAULT_COST_THRESHOLD;
-    QVector<QVector<Data::Symbol>> m_hoveredStacks;
+    QVector<QVector<qint32>> m_stacks;
+    QSet<qint32> m_hoveredStacks;
+    QHash<qint32, QVector<qint32>> m_stackNodes;
+    bool m_dataShowsBottomUp = false;
+    Data::EventResults m_events;
+    // unset when the single graph is shown
+    std::optional<FlameGraphMultiples::Grouping> m_multiplesGrouping;
+    bool m_multiplesNeedRebuild = true;
+    std::atomic<uint> m_currentMultiplesJobId {0};
+    // the elided symbol texts by the interned symbol id and the width in characters, see elidedSymbol
+    mutable QHash<quint64, QString> m_elidedSymbols;
 };
@@ -16,6 +16,8 @@
 #include "ui_frequencypage.h"
 #include "util.h"
 
+#include <limits>
+
 namespace {
 struct PlotData
 {
@@ -92,10 +94,27 @@ FrequencyPage::FrequencyPage(PerfParser* parser, QWidget* parent)
 
         double sumCost = 0;
         double numEntries = 0;
+        // the counts of perf stat come with their own unit
+        QString unit;
 
+        // the plot shows the time range of all cores, which the points of every core share
+        auto visibleStart = std::numeric_limits<double>::max();
+        auto visibleEnd = std::numeric_limits<double>::lowest();
         for (const auto& coreData : std::as_const(m_results.cores)) {
             for (const auto& costData : coreData.costs) {
-                if (costData.costName != selectedCost) {
+                if (costData.costName == selectedCost && !costData.values.isEmpty()) {
+                    visibleStart = std::min(visibleStart, static_cast<double>(costData.values.constFirst().time));
+                    visibleEnd = std::max(visibleEnd, static_cast<double>(costData.values.constLast().time));
+                }
+            }
+        }
+        const auto visibleDuration = visibleEnd - visibleStart;
+        const auto width = std::max(1, m_plot->axisRect()->width());
+
+        for (const auto& coreData : std::as_const(m_results.cores)) {
+            for (const auto& costData : coreData.costs) {
+                const auto numValues = static_cast<int>(costData.values.size());
+                if (costData.costName != selectedCost || numValues == 0) {
                     continue;
                 }
 
@@ -107,31 +126,48 @@ FrequencyPage::FrequencyPage(PerfParser* parser, QWidget* parent)
                     QColor::fromHsv(static_cast<int>(255. * (static_cast<float>(core) / numCores)), 255, 255, 150);
                 graph->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssSquare, color, color, 4));
                 graph->setAdaptiveSampling(false);
-                graph->setName(QLatin1String("%1 (CPU #%2)").arg(costData.costName, QString::number(core)));
+                graph->setName(m_results.isAggregated
+                                   ? costData.costName
+                                   : QLatin1String("%1 (CPU #%2)").arg(costData.costName, QString::number(core)));
+                unit = costData.unit;
                 graph->addToLegend();
                 graph->setVisible(true);
 
-                const auto numValues = static_cast<int>(costData.values.size());
-                const auto valuesStart = costData.values.begin();
-                QVector<double> times((numValues + averagingWindowSize - 1) / averagingWindowSize);
-                QVector<double> costs(times.size());
-                for (int i = 0, j = 0; i < numValues; ++j, i += averagingWindowSize) {
-                    const auto averageWindowStart = std::next(valuesStart, i);
-                    const auto windowEndIndex = std::min(numValues, i + averagingWindowSize);
-                    const auto averageWindowEnd = std::next(valuesStart, windowEndIndex);
-                    const auto actualWindowSize = windowEndIndex - i;
-                    const auto value = std::accumulate(averageWindowStart, averageWindowEnd, Data::FrequencyData {},
-                                                       [](Data::FrequencyData lhs, Data::FrequencyData rhs) {
-                                                           lhs.time += rhs.time;
-                                                           lhs.cost += rhs.cost;
-                                                           return lhs;
-                                                       });
-                    const auto time =
-                        static_cast<double>(value.time) / actualWindowSize - plotData->applicationStartTime;
-                    times[j] = time;
-                    costs[j] = value.cost / actualWindowSize;
-                    numEntries += actualWindowSize;
-                    sumCost += value.cost;
+                const auto& pyramid = costData.pyramid;
+                numEntries += numValues;
+                sumCost += pyramid.average(0, numValues).cost * numValues;
+
+                // more points than pixels can't be told apart, so plot the extremes of coarser buckets then,
+                // the values of a core that only ran for a part of the time get less pixels
+                const auto duration =
+                    static_cast<double>(costData.values.constLast().time - costData.values.constFirst().time);
+                const auto pixels = visibleDuration > 0 ? width * duration / visibleDuration : width;
+                const auto maxPoints = 2 * std::max(1, static_cast<int>(pixels));
+                QVector<double> times;
+                QVector<double> costs;
+                // every bucket adds its minimum and maximum
+                const auto level = pyramid.level(visibleStart, visibleEnd, maxPoints / 2);
+                if (numValues / averagingWindowSize <= maxPoints || level < 0) {
+                    const auto numPoints = (numValues + averagingWindowSize - 1) / averagingWindowSize;
+                    times.reserve(numPoints);
+                    costs.reserve(numPoints);
+                    for (int i = 0; i < numValues; i += averagingWindowSize) {
+                        const auto value = pyramid.average(i, std::min(numValues, i + averagingWindowSize));
+                        times.push_back(static_cast<double>(value.time) - plotData->applicationStartTime);
+                        costs.push_back(value.cost);
+                    }
+                } else {
+                    const auto buckets = pyramid.buckets(level, visibleStart, visibleEnd);
+                    const auto numBuckets = static_cast<int>(std::distance(buckets.first, buckets.second));
+                    times.reserve(2 * numBuckets);
+                    costs.reserve(2 * numBuckets);
+                    for (const auto* bucket = buckets.first; bucket != buckets.second; ++bucket) {
+                        const auto time = bucket->time - plotData->applicationStartTime;
+                        times.push_back(time);
+                        costs.push_back(bucket->min);
+                        times.push_back(time);
+                        costs.push_back(bucket->max);
+                    }
                 }
                 graph->setData(times, costs, true);
             }
@@ -139,6 +175,7 @@ FrequencyPage::FrequencyPage(PerfParser* parser, QWidget* parent)
             ++core;
         }
         m_plot->xAxis->rescale();
+        m_plot->yAxis->setLabel(unit.isEmpty() ? tr("Frequency [GHz]") : unit);
 
         const auto avgCost = sumCost / numEntries;
         m_upperWithoutOutliers = avgCost * 1.1;
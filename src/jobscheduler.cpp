@@ -0,0 +1,74 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "jobscheduler.h"
+
+#include <QCoreApplication>
+#include <QThread>
+
+#include <algorithm>
+
+namespace {
+class PriorityJob : public ThreadWeaver::Job
+{
+public:
+    PriorityJob(JobScheduler::Priority priority, std::function<void()> job)
+        : m_priority(priority)
+        , m_job(std::move(job))
+    {
+    }
+
+    // ThreadWeaver takes the jobs with the highest priority first
+    int priority() const override
+    {
+        return static_cast<int>(m_priority);
+    }
+
+protected:
+    void run(ThreadWeaver::JobPointer /*self*/, ThreadWeaver::Thread* /*thread*/) override
+    {
+        m_job();
+    }
+
+private:
+    JobScheduler::Priority m_priority;
+    std::function<void()> m_job;
+};
+
+ThreadWeaver::Queue* interactiveQueue()
+{
+    // only a few threads, the interactive jobs are short but must not wait
+    static auto* queue = [] {
+        auto* queue = new ThreadWeaver::Queue;
+        queue->setMaximumNumberOfThreads(std::max(2, QThread::idealThreadCount() / 4));
+
+        // like the global queue, it is owned by the application: the running jobs get finished when it quits, so
+        // none of them is left to use the objects that get destroyed then, and deleting it stops the threads
+        if (auto* app = QCoreApplication::instance()) {
+            queue->moveToThread(app->thread());
+            queue->setParent(app);
+            QObject::connect(app, &QCoreApplication::aboutToQuit, queue, [queue]() {
+                queue->dequeue();
+                queue->finish();
+            });
+        }
+        return queue;
+    }();
+    return queue;
+}
+}
+
+namespace JobScheduler {
+ThreadWeaver::Queue* queue(Priority priority)
+{
+    return priority == Priority::Interactive ? interactiveQueue() : ThreadWeaver::Queue::instance();
+}
+
+ThreadWeaver::JobPointer makeJob(Priority priority, std::function<void()> job)
+{
+    return ThreadWeaver::JobPointer(new PriorityJob(priority, std::move(job)));
+}
+}
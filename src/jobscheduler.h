@@ -0,0 +1,37 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <ThreadWeaver/ThreadWeaver>
+
+#include <functional>
+
+// runs the background jobs of hotspot by how urgently the user waits for them
+// the bulk work shares the global queue, where normal jobs get taken before the background ones
+// interactive jobs run on threads of their own, so they never wait behind a multi-second recomputation
+namespace JobScheduler {
+enum class Priority
+{
+    // work that may take long and isn't waited for right away, like parsing, filtering or exporting
+    Background,
+    // results that get shown once they are ready, like the flame graph
+    Normal,
+    // work the user waits for, like the stacks of a time line selection or hovering and painting
+    Interactive,
+};
+
+// the queue the jobs of @p priority get run on
+ThreadWeaver::Queue* queue(Priority priority);
+
+// wraps @p job, the priority decides where it gets queued relative to the jobs that wait already
+ThreadWeaver::JobPointer makeJob(Priority priority, std::function<void()> job);
+
+inline void run(Priority priority, std::function<void()> job)
+{
+    queue(priority)->stream() << makeJob(priority, std::move(job));
+}
+}
@@ -11,6 +11,8 @@
 #include <QObject>
 #include <QPointer>
 
+#include "jobscheduler.h"
+
 class JobTracker
 {
 public:
@@ -24,10 +26,17 @@ public:
         return m_context && m_isRunning;
     }
 
+    // cancels the job that is still running, its results get dropped
+    void cancelJob()
+    {
+        ++m_currentJobId;
+        m_isRunning = false;
+    }
+
+    // a newer job cancels the previous one, the job polls the cancellation with the functor passed to it
     template<typename Job, typename SetData>
-    void startJob(Job&& job, SetData&& setData)
+    void startJob(Job&& job, SetData&& setData, JobScheduler::Priority priority = JobScheduler::Priority::Normal)
     {
-        using namespace ThreadWeaver;
         const auto jobId = ++m_currentJobId;
         auto jobCancelled = [context = m_context, jobId, currentJobId = &m_currentJobId]() {
             return !context || jobId != (*currentJobId);
@@ -41,8 +50,9 @@ public:
         };
 
         m_isRunning = true;
-        stream() << make_job([context = m_context, job = std::forward<Job>(job), maybeSetData = std::move(maybeSetData),
-                              jobCancelled = std::move(jobCancelled)]() mutable {
+        JobScheduler::run(priority, [context = m_context, job = std::forward<Job>(job),
+                                     maybeSetData = std::move(maybeSetData),
+                                     jobCancelled = std::move(jobCancelled)]() mutable {
             auto results = job(jobCancelled);
             if (jobCancelled())
                 return;
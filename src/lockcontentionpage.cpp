@@ -0,0 +1,108 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "lockcontentionpage.h"
+
+#include <QLabel>
+#include <QLineEdit>
+#include <QPointer>
+#include <QSortFilterProxyModel>
+#include <QTabWidget>
+#include <QVBoxLayout>
+
+#include "copyabletreeview.h"
+#include "jobscheduler.h"
+#include "models/filterandzoomstack.h"
+#include "models/lockcontentionmodel.h"
+#include "parsers/perf/perfparser.h"
+#include "resultsutil.h"
+#include "selfprofiler.h"
+
+LockContentionPage::LockContentionPage(FilterAndZoomStack* filterStack, PerfParser* parser,
+                                       CostContextMenu* contextMenu, QWidget* parent)
+    : QWidget(parent)
+    , m_lockModel(new LockModel(this))
+    , m_stackModel(new LockStackModel(this))
+    , m_filter(new QLineEdit(this))
+    , m_emptyLabel(new QLabel(this))
+    , m_tabs(new QTabWidget(this))
+{
+    auto addView = [this, contextMenu, filterStack](QAbstractItemModel* model, const QString& title,
+                                                    int initialSortColumn, int timeRole) {
+        auto* view = new CopyableTreeView(m_tabs);
+        view->setRootIsDecorated(false);
+        view->setUniformRowHeights(true);
+        view->setTextElideMode(Qt::ElideLeft);
+        auto* proxy = new QSortFilterProxyModel(view);
+        proxy->setSourceModel(model);
+        ResultsUtil::setupTreeView(view, contextMenu, m_filter, proxy, initialSortColumn, Qt::UserRole);
+        connect(view, &QTreeView::activated, this, [filterStack, timeRole](const QModelIndex& index) {
+            const auto time = index.data(timeRole).value<Data::TimeRange>();
+            if (!time.isEmpty()) {
+                filterStack->zoomIn(time);
+            }
+        });
+        m_tabs->addTab(view, title);
+    };
+    addView(m_lockModel, tr("Locks"), LockModel::NUM_BASE_COLUMNS + LockContentionColumns::WaitTime,
+            LockModel::TimeRole);
+    addView(m_stackModel, tr("Waiting Stacks"), LockStackModel::NUM_BASE_COLUMNS + LockContentionColumns::WaitTime,
+            LockStackModel::TimeRole);
+
+    m_emptyLabel->setWordWrap(true);
+    m_emptyLabel->setAlignment(Qt::AlignCenter);
+    m_emptyLabel->setText(tr("<qt>The data contains no lock waits. Record them with the lock contention option or "
+                             "with <tt>-e syscalls:sys_enter_futex -e syscalls:sys_exit_futex</tt> to find the "
+                             "locks the threads wait for. The kernel locks can be recorded with <tt>-e "
+                             "lock:contention_begin -e lock:contention_end</tt>.</qt>"));
+
+    auto* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(m_filter);
+    layout->addWidget(m_tabs);
+    layout->addWidget(m_emptyLabel);
+
+    setResults({}, {});
+
+    // the tracepoints and the bottom up results got published before the events, which the stacks come with
+    connect(parser, &PerfParser::eventsAvailable, this, [this, parser](const Data::EventResults& events) {
+        const auto jobId = ++m_currentJobId;
+        const auto smartThis = QPointer<LockContentionPage>(this);
+        JobScheduler::run(JobScheduler::Priority::Normal,
+                          [smartThis, jobId, currentJobId = &m_currentJobId, tracepoints = parser->tracepointResults(),
+                           bottomUp = parser->bottomUpResults(), stacks = events.stacks]() {
+                              if (!smartThis || jobId != (*currentJobId)) {
+                                  return;
+                              }
+
+                              ScopedPhase phase("lock contention");
+                              const auto contention = LockContention(tracepoints);
+                              LockStacks lockStacks;
+                              lockStacks.setResults(contention, bottomUp, stacks);
+                              QMetaObject::invokeMethod(
+                                  smartThis.data(),
+                                  [smartThis, jobId, contention, lockStacks]() {
+                                      if (smartThis && jobId == smartThis->m_currentJobId) {
+                                          smartThis->setResults(contention, lockStacks);
+                                      }
+                                  },
+                                  Qt::QueuedConnection);
+                          });
+    });
+}
+
+LockContentionPage::~LockContentionPage() = default;
+
+void LockContentionPage::setResults(const LockContention& contention, const LockStacks& stacks)
+{
+    m_lockModel->setResults(contention, stacks);
+    m_stackModel->setResults(contention, stacks);
+
+    const auto isEmpty = contention.isEmpty();
+    m_filter->setVisible(!isEmpty);
+    m_tabs->setVisible(!isEmpty);
+    m_emptyLabel->setVisible(isEmpty);
+}
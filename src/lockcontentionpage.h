@@ -0,0 +1,43 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QWidget>
+
+#include <atomic>
+
+class CostContextMenu;
+class FilterAndZoomStack;
+class LockContention;
+class LockModel;
+class LockStackModel;
+class LockStacks;
+class PerfParser;
+class QLabel;
+class QLineEdit;
+class QTabWidget;
+
+// the time the threads waited for the contended locks, by lock and by the stack of the waiting threads
+// activating a row zooms the timeline onto the time the lock or stack got waited for
+class LockContentionPage : public QWidget
+{
+    Q_OBJECT
+public:
+    LockContentionPage(FilterAndZoomStack* filterStack, PerfParser* parser, CostContextMenu* contextMenu,
+                       QWidget* parent = nullptr);
+    ~LockContentionPage();
+
+private:
+    void setResults(const LockContention& contention, const LockStacks& stacks);
+
+    LockModel* m_lockModel;
+    LockStackModel* m_stackModel;
+    QLineEdit* m_filter;
+    QLabel* m_emptyLabel;
+    QTabWidget* m_tabs;
+    std::atomic<uint> m_currentJobId {0};
+};
@@ -9,18 +9,27 @@
 #include <QCommandLineParser>
 #include <QDebug>
 #include <QDir>
+#include <QEventLoop>
 #include <QFile>
 #include <QFileInfo>
+#include <QJsonDocument>
 #include <QProcessEnvironment>
 #include <QUrl>
 
+#include "analysisserver.h"
+#include "capturewatcher.h"
 #include "dockwidgetsetup.h"
 #include "hotspot-config.h"
 #include "mainwindow.h"
+#include "models/flamegraphexport.h"
+#include "models/reportexport.h"
+#include "models/resultsquery.h"
 #include "parsers/perf/perfparser.h"
+#include "selfprofiler.h"
 #include "settings.h"
 #include "util.h"
 
+#include <KFormat>
 #include <KLocalizedString>
 #include <ThreadWeaver/ThreadWeaver>
 #include <QThread>
@@ -59,8 +68,8 @@ void Q_DECL_UNUSED initRCCIconTheme()
 
 std::unique_ptr<QCoreApplication> createApplication(int& argc, char* argv[])
 {
-    const std::initializer_list<std::string_view> nonGUIOptions = {"--version", "-v", "--exportTo",
-                                                                   "--help",    "-h", "--help-all"};
+    const std::initializer_list<std::string_view> nonGUIOptions = {
+        "--version", "-v", "--exportTo", "--report", "--serve", "--query", "--watch", "--help", "-h", "--help-all"};
 
     // create command line app if one of the command-line only options are used
     for (int i = 1; i < argc; ++i) {
@@ -76,6 +85,253 @@ std::unique_ptr<QCoreApplication> createApplication(int& argc, char* argv[])
     return std::make_unique<QApplication>(argc, argv);
 }
 
+// logs the progress of @p parser to stderr, once per phase and every ten percent while parsing
+void logParseProgress(PerfParser* parser, const QString& file)
+{
+    struct LastProgress
+    {
+        Data::ParseProgress::Phase phase = Data::ParseProgress::Phase::Parse;
+        int step = -1;
+    };
+    auto last = std::make_shared<LastProgress>();
+    QObject::connect(parser, &PerfParser::parseProgress, parser, [file, last](const Data::ParseProgress& progress) {
+        const int step = static_cast<int>(progress.percent * 10);
+        if (progress.phase == last->phase && step == last->step) {
+            return;
+        }
+        last->phase = progress.phase;
+        last->step = step;
+        QTextStream err(stderr);
+        err << file << ": " << Util::formatParseProgress(progress) << Qt::endl;
+    });
+}
+
+// parses all @p files in parallel and writes one combined report, files that fail to parse get skipped
+int writeReport(const QStringList& files, const QString& destination, const ReportExport::Options& options)
+{
+    const auto format = ReportExport::formatForFileName(destination);
+    QVector<QByteArray> reports(files.size());
+    int numPending = files.size();
+    bool failed = false;
+    QEventLoop loop;
+
+    for (int i = 0, c = files.size(); i < c; ++i) {
+        auto file = files[i];
+        if (QFileInfo(file).isDir()) {
+            file.append(QLatin1String("/perf.data"));
+        }
+
+        // every file is turned into its report right away, so only the results of the files in flight are kept
+        auto* perfParser = new PerfParser(&loop);
+        logParseProgress(perfParser, file);
+        auto results = std::make_shared<ReportExport::Results>();
+        results->file = file;
+        // a failure may follow the results, only the first one counts
+        auto done = std::make_shared<bool>(false);
+        auto finish = [perfParser, results, done, &numPending, &loop]() {
+            *done = true;
+            perfParser->deleteLater();
+            *results = {};
+            if (--numPending == 0) {
+                loop.quit();
+            }
+        };
+
+        QObject::connect(perfParser, &PerfParser::summaryDataAvailable, &loop,
+                         [results](const Data::Summary& data) { results->summary = data; });
+        QObject::connect(perfParser, &PerfParser::topDownDataAvailable, &loop,
+                         [results](const Data::TopDownResults& data) { results->topDown = data; });
+        QObject::connect(perfParser, &PerfParser::perLibraryDataAvailable, &loop,
+                         [results](const Data::PerLibraryResults& data) { results->perLibrary = data; });
+        QObject::connect(perfParser, &PerfParser::callerCalleeDataAvailable, &loop,
+                         [results](const Data::CallerCalleeResults& data) { results->callerCallee = data; });
+        QObject::connect(perfParser, &PerfParser::eventsAvailable, &loop,
+                         [results](const Data::EventResults& data) { results->events = data; });
+        QObject::connect(perfParser, &PerfParser::parsingFinished, &loop,
+                         [&reports, i, format, results, options, done, finish]() {
+                             if (*done) {
+                                 return;
+                             }
+                             reports[i] = ReportExport::report(format, *results, options);
+                             finish();
+                         });
+        QObject::connect(perfParser, &PerfParser::parsingFailed, &loop,
+                         [file, &failed, done, finish](const QString& errorMessage) {
+                             if (*done) {
+                                 return;
+                             }
+                             QTextStream err(stderr);
+                             err << QCoreApplication::translate("main", "Failed to analyze %1: %2")
+                                        .arg(file, errorMessage)
+                                 << Qt::endl;
+                             failed = true;
+                             finish();
+                         });
+        perfParser->startParseFile(file);
+    }
+
+    // files that cannot be opened fail right away
+    if (numPending > 0) {
+        loop.exec();
+    }
+
+    QFile output;
+    bool isOpen = false;
+    if (destination == QLatin1String("-")) {
+        isOpen = output.open(stdout, QIODevice::WriteOnly);
+    } else {
+        output.setFileName(destination);
+        isOpen = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    if (!isOpen || output.write(ReportExport::merge(format, reports)) == -1) {
+        QTextStream err(stderr);
+        err << QCoreApplication::translate("main", "Failed to write the report to %1: %2")
+                   .arg(destination, output.errorString())
+            << Qt::endl;
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
+
+// parses all @p files in parallel and writes the results of every query for each of them as a line of JSON
+int runQueries(const QStringList& files, const QVector<ResultsQuery::Query>& queries, const QStringList& specs)
+{
+    int numPending = files.size();
+    bool failed = false;
+    QEventLoop loop;
+    QFile output;
+    output.open(stdout, QIODevice::WriteOnly);
+
+    for (auto file : files) {
+        if (QFileInfo(file).isDir()) {
+            file.append(QLatin1String("/perf.data"));
+        }
+
+        auto* perfParser = new PerfParser(&loop);
+        logParseProgress(perfParser, file);
+        // a failure may follow the results, only the first one counts
+        auto done = std::make_shared<bool>(false);
+        auto finish = [perfParser, done, &numPending, &loop]() {
+            *done = true;
+            perfParser->deleteLater();
+            if (--numPending == 0) {
+                loop.quit();
+            }
+        };
+
+        QObject::connect(perfParser, &PerfParser::parsingFinished, &loop,
+                         [perfParser, file, &queries, &specs, &output, done, finish]() {
+                             if (*done) {
+                                 return;
+                             }
+                             // the queries only read the loaded results, no filtered results get built for them
+                             const auto bottomUp = perfParser->bottomUpResults();
+                             const auto events = perfParser->eventResults();
+                             const auto stackIndex = perfParser->stackIndex();
+                             for (int i = 0, c = queries.size(); i < c; ++i) {
+                                 auto result = ResultsQuery::evaluate(queries[i], bottomUp, events, stackIndex)
+                                                   .toJson();
+                                 result[QLatin1String("file")] = file;
+                                 result[QLatin1String("query")] = specs[i];
+                                 output.write(QJsonDocument(result).toJson(QJsonDocument::Compact) + '\n');
+                             }
+                             output.flush();
+                             finish();
+                         });
+        QObject::connect(perfParser, &PerfParser::parsingFailed, &loop,
+                         [file, &failed, done, finish](const QString& errorMessage) {
+                             if (*done) {
+                                 return;
+                             }
+                             QTextStream err(stderr);
+                             err << QCoreApplication::translate("main", "Failed to analyze %1: %2")
+                                        .arg(file, errorMessage)
+                                 << Qt::endl;
+                             failed = true;
+                             finish();
+                         });
+        perfParser->startParseFile(file);
+    }
+
+    // files that cannot be opened fail right away
+    if (numPending > 0) {
+        loop.exec();
+    }
+    return failed ? 1 : 0;
+}
+
+// parses @p file and serves its results on @p address, until hotspot gets terminated
+int serveResults(QString file, const QString& address)
+{
+    if (QFileInfo(file).isDir()) {
+        file.append(QLatin1String("/perf.data"));
+    }
+
+    PerfParser perfParser;
+    AnalysisServer server(&perfParser);
+    QObject::connect(&perfParser, &PerfParser::parsingFailed, &perfParser, [file](const QString& errorMessage) {
+        QTextStream err(stderr);
+        err << QCoreApplication::translate("main", "Failed to analyze %1: %2").arg(file, errorMessage) << Qt::endl;
+        QCoreApplication::exit(1);
+    });
+    // clients only get served once the results are complete
+    QObject::connect(&perfParser, &PerfParser::parsingFinished, &server, [file, address, &server]() {
+        if (!server.listen(address)) {
+            QTextStream err(stderr);
+            err << QCoreApplication::translate("main", "Failed to listen on %1: %2").arg(address, server.errorString())
+                << Qt::endl;
+            QCoreApplication::exit(1);
+            return;
+        }
+        QTextStream out(stdout);
+        out << QCoreApplication::translate("main",
+                                           "Serving the results of %1 on port %2, open hotspot://<host>:%2 or "
+                                           "hotspot://localhost:%2 after ssh -L %2:localhost:%2 <host>")
+                   .arg(file, QString::number(server.serverPort()))
+            << Qt::endl;
+    });
+    QObject::connect(&server, &AnalysisServer::requestServed, &server, [](const QString& client, qint64 size) {
+        QTextStream out(stdout);
+        out << QCoreApplication::translate("main", "Sent %1 to %2")
+                   .arg(KFormat().formatByteSize(size, 1, KFormat::MetricBinaryDialect), client)
+            << Qt::endl;
+    });
+    QObject::connect(&server, &AnalysisServer::requestFailed, &server,
+                     [](const QString& client, const QString& errorMessage) {
+                         QTextStream err(stderr);
+                         err << client << ": " << errorMessage << Qt::endl;
+                     });
+
+    logParseProgress(&perfParser, file);
+    perfParser.startParseFile(file);
+    return QCoreApplication::exec();
+}
+
+// caches the perfparser output of the captures that show up in @p directory, until hotspot gets terminated
+int watchCaptures(const QString& directory)
+{
+    CaptureWatcher watcher;
+    QObject::connect(&watcher, &CaptureWatcher::captureCached, &watcher, [](const QString& path) {
+        QTextStream out(stdout);
+        out << QCoreApplication::translate("main", "Cached %1").arg(path) << Qt::endl;
+    });
+    QObject::connect(&watcher, &CaptureWatcher::captureFailed, &watcher,
+                     [](const QString& path, const QString& errorMessage) {
+                         QTextStream err(stderr);
+                         err << QCoreApplication::translate("main", "Failed to cache %1: %2").arg(path, errorMessage)
+                             << Qt::endl;
+                     });
+    if (!watcher.watch(directory)) {
+        QTextStream err(stderr);
+        err << QCoreApplication::translate("main", "Failed to watch the directory %1.").arg(directory) << Qt::endl;
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    out << QCoreApplication::translate("main", "Watching %1 for new captures.").arg(directory) << Qt::endl;
+    return QCoreApplication::exec();
+}
+
 int main(int argc, char** argv)
 {
     KLocalizedString::setApplicationDomain("hotspot");
@@ -86,6 +342,10 @@ int main(int argc, char** argv)
 
     auto app = createApplication(argc, argv);
 
+    // HOTSPOT_TRACE=/tmp/hotspot.json records the phases of hotspot itself, e.g. for chrome://tracing
+    QObject::connect(app.get(), &QCoreApplication::aboutToQuit, SelfProfiler::instance(),
+                     []() { SelfProfiler::instance()->writeRequestedTrace(); });
+
     // init
     Util::appImageEnvironment();
 
@@ -152,10 +412,94 @@ int main(int argc, char** argv)
         QStringLiteral("exportTo"),
         QCoreApplication::translate("main",
                                     "Path to .perfparser output file to which the input data should be exported. A "
-                                    "single input file has to be given too."),
+                                    "single input file has to be given too. When the path ends with .zst, the data "
+                                    "gets compressed into independent zstd frames that are decompressed in parallel "
+                                    "when opening the file. When the path ends with .svg, a top-down flame graph of "
+                                    "the first cost type gets written instead, when it ends with .pftrace a "
+                                    "Perfetto trace of the timeline and when it ends with .pb.gz or .pprof a pprof "
+                                    "profile of all cost types."),
         QStringLiteral("path"));
     parser.addOption(exportTo);
 
+    const auto report = QCommandLineOption(
+        QStringLiteral("report"),
+        QCoreApplication::translate("main",
+                                    "Analyze the input files without a GUI and write a report of the first cost type "
+                                    "to the given path, or - for stdout. The files get parsed in parallel. Depending "
+                                    "on the suffix of the path the report contains the top symbols, per-library and "
+                                    "per-thread costs and the collapsed stacks as .json or .csv, or only the stacks "
+                                    "as .folded file for flamegraph.pl."),
+        QStringLiteral("path"));
+    parser.addOption(report);
+
+    const auto reportTop = QCommandLineOption(
+        QStringLiteral("reportTop"),
+        QCoreApplication::translate("main", "The number of symbols with the highest self cost listed in the report."),
+        QStringLiteral("count"), QStringLiteral("20"));
+    parser.addOption(reportTop);
+
+    const auto spillDirectory = QCommandLineOption(
+        QStringLiteral("spillDirectory"),
+        QCoreApplication::translate("main",
+                                    "Directory in which the events get stored in memory mapped files instead of in "
+                                    "RAM. This allows to load captures with more events than fit into the memory."),
+        QStringLiteral("path"));
+    parser.addOption(spillDirectory);
+
+    const auto restrict = QCommandLineOption(
+        QStringLiteral("restrict"),
+        QCoreApplication::translate(
+            "main",
+            "Only parse the samples that match all the given whitespace separated restrictions, e.g. \"time=10-20 "
+            "pid=1234,firefox cpu=0-3\". The time is given in seconds since the first event, the processes by their "
+            "pid or command. Unlike a filter, this also saves the memory and time for the other samples."),
+        QStringLiteral("restrictions"));
+    parser.addOption(restrict);
+
+    const auto merge = QCommandLineOption(
+        QStringLiteral("merge"),
+        QCoreApplication::translate("main",
+                                    "Merge the costs of all input files into a single profile, instead of opening a "
+                                    "window for every file. E.g. to look at the captures of many hosts at once. The "
+                                    "symbols get unified by their name, binary and address, the merged profile has "
+                                    "no time line."));
+    parser.addOption(merge);
+
+    const auto serve = QCommandLineOption(
+        QStringLiteral("serve"),
+        QCoreApplication::translate("main",
+                                    "Parse the single input file without a GUI and serve its results on the given "
+                                    "[host:]port. The GUI on another machine then opens hotspot://<host>:<port> and "
+                                    "only receives the costs aggregated per stack and slice of the time line, so large "
+                                    "captures can be analyzed on a machine with enough memory next to them. There is "
+                                    "no authentication, so only localhost gets served unless a host is given. Forward "
+                                    "the port instead, e.g. with ssh -L <port>:localhost:<port> <host>."),
+        QStringLiteral("address"));
+    parser.addOption(serve);
+
+    const auto watch = QCommandLineOption(
+        QStringLiteral("watch"),
+        QCoreApplication::translate("main",
+                                    "Watch the given directory without a GUI and process the perf.data files that "
+                                    "show up in it in the background, e.g. the ones a CI writes there. Opening them "
+                                    "later on then reuses the cached output of perfparser."),
+        QStringLiteral("directory"));
+    parser.addOption(watch);
+
+    const auto query = QCommandLineOption(
+        QStringLiteral("query"),
+        QCoreApplication::translate(
+            "main",
+            "Analyze the input files without a GUI and print the cost of the samples that match the query as a line "
+            "of JSON per file. Can be given several times. The query consists of whitespace separated terms: "
+            "time=<from>-<to> in seconds since the first event, last=<seconds> before the last event, "
+            "pid=<pids or commands>, tid=<tids>, cpu=<cpus>, symbol=<functions> and binary=<binaries> of the "
+            "leaf frame, under=<caller>;<callee> for a call path on the stack, type=<cost type>, "
+            "group=total|symbol|binary|thread|process|numa and top=<count>. E.g. \"binary=libfoo.so under=main;run "
+            "last=5 group=symbol\"."),
+        QStringLiteral("query"));
+    parser.addOption(query);
+
     parser.addPositionalArgument(
         QStringLiteral("files"),
         QCoreApplication::translate("main", "Optional input files to open on startup, i.e. perf.data files."),
@@ -189,7 +533,73 @@ int main(int argc, char** argv)
     settings->loadFromFile();
     applyCliArgs(settings);
 
+    if (parser.isSet(restrict)) {
+        if (!Data::ParseRestriction::fromString(parser.value(restrict))) {
+            QTextStream err(stderr);
+            err << QCoreApplication::translate("main", "Error: invalid restrictions %1.").arg(parser.value(restrict))
+                << "\n\n"
+                << parser.helpText();
+            return 1;
+        }
+        settings->setParseRestriction(parser.value(restrict));
+    }
+
+    if (parser.isSet(spillDirectory)) {
+        Data::setSpillDirectory(parser.value(spillDirectory));
+    }
+
     auto files = parser.positionalArguments();
+    if (parser.isSet(report)) {
+        if (files.isEmpty()) {
+            QTextStream err(stderr);
+            err << QCoreApplication::translate("main", "Error: expected at least one input file to analyze.")
+                << "\n\n"
+                << parser.helpText();
+            return 1;
+        }
+        ReportExport::Options options;
+        options.topCount = parser.value(reportTop).toInt();
+        return writeReport(files, parser.value(report), options);
+    }
+
+    if (parser.isSet(query)) {
+        const auto specs = parser.values(query);
+        QVector<ResultsQuery::Query> queries;
+        for (const auto& spec : specs) {
+            QString errorMessage;
+            const auto parsed = ResultsQuery::Query::fromString(spec, &errorMessage);
+            if (!parsed) {
+                QTextStream err(stderr);
+                err << QCoreApplication::translate("main", "Error: invalid query %1: %2").arg(spec, errorMessage)
+                    << Qt::endl;
+                return 1;
+            }
+            queries.append(*parsed);
+        }
+        if (files.isEmpty()) {
+            QTextStream err(stderr);
+            err << QCoreApplication::translate("main", "Error: expected at least one input file to analyze.")
+                << "\n\n"
+                << parser.helpText();
+            return 1;
+        }
+        return runQueries(files, queries, specs);
+    }
+
+    if (parser.isSet(watch)) {
+        return watchCaptures(parser.value(watch));
+    }
+
+    if (parser.isSet(serve)) {
+        if (files.size() != 1) {
+            QTextStream err(stderr);
+            err << QCoreApplication::translate("main", "Error: expected a single input file to serve.") << "\n\n"
+                << parser.helpText();
+            return 1;
+        }
+        return serveResults(files.constFirst(), parser.value(serve));
+    }
+
     if (files.size() != 1 && parser.isSet(exportTo)) {
         QTextStream err(stderr);
         err << QCoreApplication::translate("main", "Error: expected a single input file to convert, instead of %1.",
@@ -208,12 +618,23 @@ int main(int argc, char** argv)
         window = new MainWindow();
     }
 
+    if (parser.isSet(merge) && window && !files.isEmpty()) {
+        for (auto& file : files) {
+            if (QFileInfo(file).isDir()) {
+                file.append(QLatin1String("/perf.data"));
+            }
+        }
+        window->mergeFiles(files);
+        window->show();
+        return QCoreApplication::exec();
+    }
+
     const auto originalArguments = QCoreApplication::arguments();
     // remove leading executable name and trailing positional arguments
     const auto minimalArguments = originalArguments.mid(1, originalArguments.size() - 1 - files.size());
 
     while (files.size() > 1) {
-        // spawn new instances if we have more than one file argument
+        // open the other files in windows of their own, or spawn new instances when exporting them
         const auto file = files.takeLast();
         MainWindow::openInNewWindow(file, minimalArguments);
     }
@@ -243,8 +664,30 @@ int main(int argc, char** argv)
                 QCoreApplication::exit(0);
             });
             auto destination = QUrl::fromUserInput(parser.value(exportTo), QDir::currentPath(), QUrl::AssumeLocalFile);
-            QObject::connect(&perfParser, &PerfParser::parsingFinished, app.get(),
-                             [&perfParser, destination] { perfParser.exportResults(destination); });
+            if (destination.fileName().endsWith(QLatin1String(".svg"), Qt::CaseInsensitive)) {
+                // write the flame graph straight from the parse results, no GUI required
+                QObject::connect(&perfParser, &PerfParser::parsingFailed, app.get(), showErrorAndQuit);
+                QObject::connect(&perfParser, &PerfParser::topDownDataAvailable, app.get(),
+                                 [file, destination, showErrorAndQuit](const Data::TopDownResults& results) {
+                                     QFile output(destination.toLocalFile());
+                                     if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)
+                                         || !FlameGraphExport::writeSvg(&output, results, 0)) {
+                                         showErrorAndQuit(QCoreApplication::translate(
+                                                              "main", "Failed to write the flame graph to %1: %2")
+                                                              .arg(output.fileName(), output.errorString()));
+                                         return;
+                                     }
+                                     QTextStream out(stdout);
+                                     out << QCoreApplication::translate("main", "Input file %1 exported to %2")
+                                                .arg(file, output.fileName())
+                                         << Qt::endl;
+                                     QCoreApplication::exit(0);
+                                 });
+            } else {
+                QObject::connect(&perfParser, &PerfParser::parsingFinished, app.get(),
+                                 [&perfParser, destination] { perfParser.exportResults(destination); });
+            }
+            logParseProgress(&perfParser, file);
             perfParser.startParseFile(file);
             return app->exec();
         }
@@ -9,6 +9,7 @@
 #include "mainwindow.h"
 #include "recordpage.h"
 #include "resultspage.h"
+#include "selfprofilerdialog.h"
 #include "settings.h"
 #include "settingsdialog.h"
 #include "startpage.h"
@@ -21,6 +22,7 @@
 #include <QVBoxLayout>
 
 #include <QDesktopServices>
+#include <QDoubleSpinBox>
 #include <QInputDialog>
 #include <QLabel>
 #include <QLineEdit>
@@ -37,6 +39,8 @@
 #include <KStandardAction>
 
 #include <kio_version.h>
+
+#include <hotspot-config.h>
 #if KIO_VERSION >= QT_VERSION_CHECK(5, 69, 0)
 #include <KIO/CommandLauncherJob>
 #endif
@@ -44,12 +48,19 @@
 #include <kddockwidgets/LayoutSaver.h>
 
 #include "aboutdialog.h"
+#include "capturewatcher.h"
 
 #include "parsers/perf/perfparser.h"
 
 #include <functional>
 
 namespace {
+int nextWindowId()
+{
+    static int windowId = 0;
+    return windowId++;
+}
+
 struct IdeSettings
 {
     const char* const app;
@@ -71,6 +82,25 @@ const IdeSettings ideSettings[] = {
     {"codium", "-g %f:%l:%c", QT_TRANSLATE_NOOP("MainWindow", "VSCodium"), "codium"}};
 const int ideSettingsSize = sizeof(ideSettings) / sizeof(IdeSettings);
 
+// the exports are compressed when KArchive is available, see PerfParser::exportResults
+QString exportSuffix()
+{
+#if KFArchive_FOUND
+    return QStringLiteral(".perfparser.zst");
+#else
+    return QStringLiteral(".perfparser");
+#endif
+}
+
+QString dataFileFilter()
+{
+    return MainWindow::tr("Hotspot data Files (perf*.data perf.data.* *.perfparser *.perfparser.zst);;"
+                          "Linux Perf Files (perf*.data perf.data.*);;"
+                          "Perfparser Files (*.perfparser *.perfparser.zst);;"
+                          "Folded Stacks (*.folded *.collapsed *.txt);;"
+                          "All Files (*)");
+}
+
 bool isAppAvailable(const char* app)
 {
     return !QStandardPaths::findExecutable(QString::fromUtf8(app)).isEmpty();
@@ -90,13 +120,13 @@ int firstAvailableIde()
 MainWindow::MainWindow(QWidget* parent)
     : KParts::MainWindow(parent)
     , ui(std::make_unique<Ui::MainWindow>())
+    , m_windowId(nextWindowId())
     , m_parser(new PerfParser(this))
     , m_config(KSharedConfig::openConfig())
     , m_pageStack(new QStackedWidget(this))
     , m_startPage(new StartPage(this))
     , m_recordPage(new RecordPage(this))
-    , m_resultsPage(new ResultsPage(m_parser, this))
-    , m_settingsDialog(new SettingsDialog(this))
+    , m_resultsPage(new ResultsPage(m_parser, m_windowId, this))
 {
     ui->setupUi(this);
 
@@ -111,17 +141,6 @@ MainWindow::MainWindow(QWidget* parent)
 
     auto settings = Settings::instance();
 
-    connect(m_settingsDialog, &QDialog::accepted, this, [this, settings]() {
-        settings->setSysroot(m_settingsDialog->sysroot());
-        settings->setAppPath(m_settingsDialog->appPath());
-        settings->setExtraLibPaths(m_settingsDialog->extraLibPaths());
-        settings->setDebugPaths(m_settingsDialog->debugPaths());
-        settings->setKallsyms(m_settingsDialog->kallsyms());
-        settings->setArch(m_settingsDialog->arch());
-        settings->setObjdump(m_settingsDialog->objdump());
-        settings->setPerfMapPath(m_settingsDialog->perfMapPath());
-    });
-
     connect(settings, &Settings::sysrootChanged, m_resultsPage, &ResultsPage::setSysroot);
     connect(settings, &Settings::appPathChanged, m_resultsPage, &ResultsPage::setAppPath);
     connect(settings, &Settings::objdumpChanged, m_resultsPage, &ResultsPage::setObjdump);
@@ -132,17 +151,39 @@ MainWindow::MainWindow(QWidget* parent)
     connect(m_startPage, &StartPage::stopParseButtonClicked, this,
             static_cast<void (MainWindow::*)()>(&MainWindow::clear));
     connect(m_parser, &PerfParser::progress, m_startPage, &StartPage::onParseFileProgress);
+    connect(m_parser, &PerfParser::parseProgress, m_startPage, &StartPage::onParseProgress);
+    // the results fill in while a file gets parsed, so they can be looked at before parsing finished
+    m_parser->setPublishPartialResults(true);
+    connect(m_parser, &PerfParser::partialResultsAvailable, m_startPage, &StartPage::onPartialResultsAvailable);
+    connect(m_startPage, &StartPage::viewPartialResultsButtonClicked, this,
+            [this]() { m_pageStack->setCurrentWidget(m_resultsPage); });
     connect(m_parser, &PerfParser::debugInfoDownloadProgress, m_startPage, &StartPage::onDebugInfoDownloadProgress);
     connect(this, &MainWindow::openFileError, m_startPage, &StartPage::onOpenFileError);
     connect(m_recordPage, &RecordPage::homeButtonClicked, this, &MainWindow::onHomeButtonClicked);
     connect(m_recordPage, &RecordPage::openFile, this,
             static_cast<void (MainWindow::*)(const QString&)>(&MainWindow::openFile));
+    connect(m_recordPage, &RecordPage::liveRecordingStarted, this, &MainWindow::startLiveAnalysis);
+    connect(m_recordPage, &RecordPage::liveDataAvailable, m_parser, &PerfParser::addLiveInput);
+    connect(m_recordPage, &RecordPage::liveRecordingFinished, this, [this]() {
+        m_stopRecordingAction->setEnabled(false);
+        m_parser->finishLiveInput();
+    });
+    connect(m_recordPage, &RecordPage::showLiveResults, this,
+            [this]() { m_pageStack->setCurrentWidget(m_resultsPage); });
+    connect(m_recordPage, &RecordPage::openFileInNewWindow, this, [](const QString& path) { openInNewWindow(path); });
 
     connect(m_parser, &PerfParser::parsingFinished, this, [this]() {
         m_reloadAction->setEnabled(true);
-        m_exportAction->setEnabled(true);
+        // merged files have no events left to export
+        m_exportAction->setEnabled(!m_exportAction->data().toUrl().isEmpty());
+        // neither can they be compared
+        m_compareAction->setEnabled(m_exportAction->isEnabled());
         m_pageStack->setCurrentWidget(m_resultsPage);
     });
+    // filtering replaces the comparison
+    connect(m_parser, &PerfParser::parsingStarted, this, [this]() { m_stopComparingAction->setEnabled(false); });
+    connect(m_parser, &PerfParser::comparisonDataAvailable, this,
+            [this]() { m_stopComparingAction->setEnabled(true); });
     connect(m_parser, &PerfParser::exportFinished, this, [this](const QUrl& url) {
         m_exportAction->setEnabled(true);
 
@@ -167,6 +208,14 @@ MainWindow::MainWindow(QWidget* parent)
     recordDataAction->setShortcut(tr("Ctrl+R"));
     ui->fileMenu->addAction(recordDataAction);
     connect(recordDataAction, &QAction::triggered, this, &MainWindow::onRecordButtonClicked);
+
+    // allows to stop a recording with live analysis while looking at its results
+    m_stopRecordingAction = new QAction(this);
+    m_stopRecordingAction->setText(tr("&Stop Recording"));
+    m_stopRecordingAction->setIcon(QIcon::fromTheme(QStringLiteral("media-playback-stop")));
+    m_stopRecordingAction->setEnabled(false);
+    ui->fileMenu->addAction(m_stopRecordingAction);
+    connect(m_stopRecordingAction, &QAction::triggered, m_recordPage, &RecordPage::stopRecording);
     ui->fileMenu->addSeparator();
 
     connect(m_resultsPage, &ResultsPage::navigateToCode, this, &MainWindow::navigateToCode);
@@ -180,6 +229,66 @@ MainWindow::MainWindow(QWidget* parent)
             openInNewWindow(fileName);
     });
     ui->fileMenu->addAction(openNewWindow);
+
+    auto mergeFilesAction =
+        new QAction(QIcon::fromTheme(QStringLiteral("document-open")), tr("Open and Merge Files..."), this);
+    mergeFilesAction->setToolTip(tr("Merge the costs of several files into one profile, e.g. of the captures of "
+                                    "many hosts. The merged profile has no time line and can't be filtered."));
+    connect(mergeFilesAction, &QAction::triggered, this, [this] {
+        const auto fileNames =
+            QFileDialog::getOpenFileNames(this, tr("Merge Files"), QDir::currentPath(), dataFileFilter());
+        if (!fileNames.isEmpty())
+            mergeFiles(fileNames);
+    });
+    ui->fileMenu->addAction(mergeFilesAction);
+    auto connectServerAction =
+        new QAction(QIcon::fromTheme(QStringLiteral("network-connect")), tr("Connect to Analysis Server..."), this);
+    connectServerAction->setToolTip(tr("Open the results of a capture that got parsed by hotspot --serve on another "
+                                       "machine. Only the costs aggregated per stack and slice of the time line get "
+                                       "transferred."));
+    connect(connectServerAction, &QAction::triggered, this, [this] {
+        const auto address = QInputDialog::getText(this, tr("Connect to Analysis Server"), tr("Server (host:port):"));
+        if (!address.isEmpty())
+            openFile(QLatin1String("hotspot://") + address.trimmed());
+    });
+    ui->fileMenu->addAction(connectServerAction);
+    auto watchCapturesAction =
+        new QAction(QIcon::fromTheme(QStringLiteral("folder-open")), tr("Watch Directory for Captures..."), this);
+    watchCapturesAction->setToolTip(tr("Process the perf.data files that show up in a directory in the background, "
+                                       "e.g. the ones a CI writes there, so they open right away later on."));
+    watchCapturesAction->setCheckable(true);
+    connect(watchCapturesAction, &QAction::toggled, this, [this, watchCapturesAction](bool watch) {
+        if (m_captureWatcher) {
+            // the watcher may still be caching a capture in the background
+            disconnect(m_captureWatcher, nullptr, this, nullptr);
+            m_captureWatcher->shutdown();
+            m_captureWatcher = nullptr;
+        }
+        if (!watch) {
+            return;
+        }
+
+        const auto directory = QFileDialog::getExistingDirectory(this, tr("Watch Directory for Captures"));
+        auto* watcher = new CaptureWatcher(this);
+        if (directory.isEmpty() || !watcher->watch(directory)) {
+            delete watcher;
+            watchCapturesAction->setChecked(false);
+            return;
+        }
+        connect(watcher, &CaptureWatcher::captureCached, this, [this](const QString& path) {
+            auto* notification = new KNotification(QStringLiteral("captureCached"));
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+            notification->setWidget(this);
+#else
+            notification->setWindow(window()->windowHandle());
+#endif
+            notification->setUrls({QUrl::fromLocalFile(path)});
+            notification->setText(tr("%1 is ready to be opened").arg(QFileInfo(path).fileName()));
+            notification->sendEvent();
+        });
+        m_captureWatcher = watcher;
+    });
+    ui->fileMenu->addAction(watchCapturesAction);
     m_recentFilesAction = KStandardAction::openRecent(this, qOverload<const QUrl&>(&MainWindow::openFile), this);
     m_recentFilesAction->loadEntries(m_config->group(QStringLiteral("RecentFiles")));
     ui->fileMenu->addAction(m_recentFilesAction);
@@ -187,6 +296,22 @@ MainWindow::MainWindow(QWidget* parent)
     m_reloadAction = KStandardAction::redisplay(this, &MainWindow::reload, this);
     m_reloadAction->setText(tr("Reload"));
     ui->fileMenu->addAction(m_reloadAction);
+    m_compareAction = new QAction(QIcon::fromTheme(QStringLiteral("document-compare")),
+                                  tr("Compare With Baseline..."), this);
+    m_compareAction->setToolTip(tr("Show the costs of a baseline capture and their deltas next to the costs of this "
+                                   "capture in the bottom up, top down and caller/callee views."));
+    m_compareAction->setEnabled(false);
+    connect(m_compareAction, &QAction::triggered, this, [this] {
+        const auto fileName =
+            QFileDialog::getOpenFileName(this, tr("Compare With Baseline"), QDir::currentPath(), dataFileFilter());
+        if (!fileName.isEmpty())
+            m_parser->startCompare(fileName);
+    });
+    ui->fileMenu->addAction(m_compareAction);
+    m_stopComparingAction = new QAction(tr("Stop Comparing"), this);
+    m_stopComparingAction->setEnabled(false);
+    connect(m_stopComparingAction, &QAction::triggered, m_resultsPage, &ResultsPage::stopComparison);
+    ui->fileMenu->addAction(m_stopComparingAction);
     ui->fileMenu->addSeparator();
     m_exportAction = KStandardAction::saveAs(this, qOverload<>(&MainWindow::saveAs), this);
     ui->fileMenu->addAction(m_exportAction);
@@ -214,6 +339,13 @@ MainWindow::MainWindow(QWidget* parent)
                                            "instead of <tt>QHash&lt;QString, QVector&lt;QString&gt;&gt;</tt>"));
     connect(collapseTemplatesAction, &QAction::toggled, Settings::instance(), &Settings::setCollapseTemplates);
 
+    auto* foldInlinesAction = ui->viewMenu->addAction(tr("Fold Inlined Frames"));
+    foldInlinesAction->setCheckable(true);
+    foldInlinesAction->setChecked(Settings::instance()->foldInlines());
+    foldInlinesAction->setToolTip(tr("Attribute the costs of inlined functions to the function they got inlined into, "
+                                     "instead of showing them as separate frames."));
+    connect(foldInlinesAction, &QAction::toggled, Settings::instance(), &Settings::setFoldInlines);
+
     {
         auto* action = new QWidgetAction(this);
         auto* widget = new QWidget(this);
@@ -236,6 +368,36 @@ MainWindow::MainWindow(QWidget* parent)
         ui->viewMenu->addAction(action);
     }
 
+    {
+        auto* action = new QWidgetAction(this);
+        auto* widget = new QWidget(this);
+        auto* layout = new QHBoxLayout(widget);
+        auto margins = layout->contentsMargins();
+        margins.setTop(0);
+        margins.setBottom(0);
+        layout->setContentsMargins(margins);
+        auto* label = new QLabel(tr("Fold Children Below"));
+        layout->addWidget(label);
+        auto* box = new QDoubleSpinBox(widget);
+        box->setRange(0, 10);
+        box->setDecimals(2);
+        box->setSingleStep(0.01);
+        box->setSuffix(QStringLiteral("%"));
+        box->setSpecialValueText(tr("Off"));
+        box->setValue(Settings::instance()->foldThreshold());
+        box->setToolTip(tr("Show the children of a symbol that have less than this percentage of the total cost as "
+                           "one row in the bottom up and top down trees. This keeps expanding symbols with thousands "
+                           "of callers or callees fast."));
+
+        connect(box, qOverload<double>(&QDoubleSpinBox::valueChanged), Settings::instance(),
+                &Settings::setFoldThreshold);
+
+        layout->addWidget(box);
+
+        action->setDefaultWidget(widget);
+        ui->viewMenu->addAction(action);
+    }
+
     ui->viewMenu->addSeparator();
     auto* restoreDefaultLayout = new QAction(tr("Restore Default Layout"), this);
     connect(restoreDefaultLayout, &QAction::triggered, [&] {
@@ -248,6 +410,10 @@ MainWindow::MainWindow(QWidget* parent)
     ui->viewMenu->addActions(m_resultsPage->filterMenu()->actions());
     ui->viewMenu->addSeparator();
     ui->viewMenu->addMenu(m_resultsPage->exportMenu());
+    ui->viewMenu->addSeparator();
+    auto* performanceAction = ui->viewMenu->addAction(tr("Performance of Hotspot..."));
+    performanceAction->setToolTip(tr("Show how long the parsing, filtering and the views of hotspot took."));
+    connect(performanceAction, &QAction::triggered, this, &MainWindow::openPerformanceDialog);
 
     ui->windowMenu->addActions(m_resultsPage->windowActions());
 
@@ -258,6 +424,10 @@ MainWindow::MainWindow(QWidget* parent)
     auto config = m_config->group(QStringLiteral("Window"));
     restoreGeometry(config.readEntry("geometry", QByteArray()));
     restoreState(config.readEntry("state", QByteArray()));
+    if (m_windowId != 0) {
+        // restoring the layout would rearrange the docks of the first window, the others keep the initial layout
+        return;
+    }
     KDDockWidgets::LayoutSaver serializer(KDDockWidgets::RestoreOption_RelativeToMainWindow);
     const auto dockWidgetLayout = config.readEntry("layout", QByteArray());
     if (!dockWidgetLayout.isEmpty()) {
@@ -270,7 +440,13 @@ MainWindow::MainWindow(QWidget* parent)
     m_resultsPage->initDockWidgets(restored);
 }
 
-MainWindow::~MainWindow() = default;
+MainWindow::~MainWindow()
+{
+    if (m_captureWatcher) {
+        disconnect(m_captureWatcher, nullptr, this, nullptr);
+        m_captureWatcher->shutdown();
+    }
+}
 
 void MainWindow::closeEvent(QCloseEvent* event)
 {
@@ -278,20 +454,27 @@ void MainWindow::closeEvent(QCloseEvent* event)
     config.writeEntry("geometry", saveGeometry());
     config.writeEntry("state", saveState());
 
-    const auto serializer = KDDockWidgets::LayoutSaver(KDDockWidgets::RestoreOption_RelativeToMainWindow);
-    config.writeEntry("layout", serializer.serializeLayout());
+    if (m_windowId == 0) {
+        const auto serializer = KDDockWidgets::LayoutSaver(KDDockWidgets::RestoreOption_RelativeToMainWindow);
+        config.writeEntry("layout", serializer.serializeLayout());
+    }
 
     m_parser->stop();
+    if (m_windowId != 0) {
+        // the other windows go away once closed, but only after the background jobs of their parser stopped
+        if (m_parser->isParsing()) {
+            connect(m_parser, &PerfParser::parsingFailed, this, &QObject::deleteLater);
+            connect(m_parser, &PerfParser::parsingFinished, this, &QObject::deleteLater);
+        } else {
+            deleteLater();
+        }
+    }
     KMainWindow::closeEvent(event);
 }
 
 QString MainWindow::queryOpenDataFile()
 {
-    const auto filter = tr("Hotspot data Files (perf*.data perf.data.* *.perfparser);;"
-                           "Linux Perf Files (perf*.data perf.data.*);;"
-                           "Perfparser Files (*.perfparser);;"
-                           "All Files (*)");
-    return QFileDialog::getOpenFileName(this, tr("Open File"), QDir::currentPath(), filter);
+    return QFileDialog::getOpenFileName(this, tr("Open File"), QDir::currentPath(), dataFileFilter());
 }
 
 void MainWindow::onOpenFileButtonClicked()
@@ -331,6 +514,8 @@ void MainWindow::clear(bool isReload)
     m_resultsPage->clear();
     m_reloadAction->setEnabled(false);
     m_exportAction->setEnabled(false);
+    m_compareAction->setEnabled(false);
+    m_stopComparingAction->setEnabled(false);
 }
 
 void MainWindow::clear()
@@ -343,7 +528,8 @@ void MainWindow::openFile(const QString& path, bool isReload)
     clear(isReload);
 
     const auto file = QFileInfo(path);
-    setWindowTitle(tr("%1 - Hotspot").arg(file.fileName()));
+    const auto isServer = PerfParser::isServerUrl(path);
+    setWindowTitle(tr("%1 - Hotspot").arg(isServer ? QUrl(path).authority() : file.fileName()));
 
     m_startPage->showParseFileProgress();
     m_pageStack->setCurrentWidget(m_startPage);
@@ -351,13 +537,50 @@ void MainWindow::openFile(const QString& path, bool isReload)
     // TODO: support input files of different types via plugins
     m_parser->startParseFile(path);
     m_reloadAction->setData(path);
-    m_exportAction->setData(QUrl::fromLocalFile(file.absoluteFilePath() + QLatin1String(".perfparser")));
+    if (isServer) {
+        // the results of an analysis server get saved locally, named after the server
+        m_exportAction->setData(QUrl::fromLocalFile(QDir::current().filePath(QUrl(path).host() + exportSuffix())));
+        return;
+    }
+    m_exportAction->setData(QUrl::fromLocalFile(file.absoluteFilePath() + exportSuffix()));
 
     m_recentFilesAction->addUrl(QUrl::fromLocalFile(file.absoluteFilePath()));
     m_recentFilesAction->saveEntries(m_config->group(QStringLiteral("RecentFiles")));
     m_config->sync();
 }
 
+void MainWindow::mergeFiles(const QStringList& paths, bool isReload)
+{
+    clear(isReload);
+
+    setWindowTitle(tr("%n Merged Files - Hotspot", nullptr, paths.size()));
+
+    m_startPage->showParseFileProgress();
+    m_pageStack->setCurrentWidget(m_startPage);
+
+    m_parser->startMergeFiles(paths);
+    m_reloadAction->setData(paths);
+    m_exportAction->setData(QUrl());
+}
+
+void MainWindow::startLiveAnalysis(const QString& path)
+{
+    m_resultsPage->selectSummaryTab();
+    m_resultsPage->clear();
+    m_reloadAction->setEnabled(false);
+    m_exportAction->setEnabled(false);
+    m_compareAction->setEnabled(false);
+    m_stopComparingAction->setEnabled(false);
+    m_stopRecordingAction->setEnabled(true);
+
+    const auto file = QFileInfo(path);
+    setWindowTitle(tr("%1 - Hotspot").arg(file.fileName()));
+
+    m_parser->startParseLive(path);
+    m_reloadAction->setData(path);
+    m_exportAction->setData(QUrl::fromLocalFile(file.absoluteFilePath() + exportSuffix()));
+}
+
 void MainWindow::openFile(const QString& path)
 {
     openFile(path, false);
@@ -372,15 +595,31 @@ void MainWindow::openFile(const QUrl& url)
     openFile(url.toLocalFile(), false);
 }
 
+void MainWindow::mergeFiles(const QStringList& paths)
+{
+    mergeFiles(paths, false);
+}
+
 void MainWindow::reload()
 {
-    openFile(m_reloadAction->data().toString(), true);
+    const auto data = m_reloadAction->data();
+    if (data.userType() == QMetaType::QStringList) {
+        mergeFiles(data.toStringList(), true);
+    } else {
+        openFile(data.toString(), true);
+    }
 }
 
 void MainWindow::saveAs()
 {
-    const auto url = QFileDialog::getSaveFileUrl(this, tr("Save Processed Data"), m_exportAction->data().toUrl(),
-                                                 tr("PerfParser (*.perfparser)"));
+#if KFArchive_FOUND
+    const auto filter = tr("Compressed PerfParser (*.perfparser.zst);;PerfParser (*.perfparser);;"
+                           "Perfetto Trace (*.pftrace);;pprof Profile (*.pb.gz)");
+#else
+    const auto filter = tr("PerfParser (*.perfparser);;Perfetto Trace (*.pftrace);;pprof Profile (*.pprof)");
+#endif
+    const auto url =
+        QFileDialog::getSaveFileUrl(this, tr("Save Processed Data"), m_exportAction->data().toUrl(), filter);
     if (!url.isValid())
         return;
     saveAs(url);
@@ -420,6 +659,22 @@ void MainWindow::aboutKDAB()
 
 void MainWindow::openSettingsDialog()
 {
+    // the settings dialog is rarely needed, so only create it when it actually gets opened
+    if (!m_settingsDialog) {
+        m_settingsDialog = new SettingsDialog(this);
+        connect(m_settingsDialog, &QDialog::accepted, this, [this]() {
+            auto settings = Settings::instance();
+            settings->setSysroot(m_settingsDialog->sysroot());
+            settings->setAppPath(m_settingsDialog->appPath());
+            settings->setExtraLibPaths(m_settingsDialog->extraLibPaths());
+            settings->setDebugPaths(m_settingsDialog->debugPaths());
+            settings->setKallsyms(m_settingsDialog->kallsyms());
+            settings->setArch(m_settingsDialog->arch());
+            settings->setObjdump(m_settingsDialog->objdump());
+            settings->setPerfMapPath(m_settingsDialog->perfMapPath());
+        });
+    }
+
     m_settingsDialog->setWindowTitle(tr("Hotspot configuration"));
     m_settingsDialog->setWindowIcon(windowIcon());
     m_settingsDialog->adjustSize();
@@ -427,6 +682,17 @@ void MainWindow::openSettingsDialog()
     m_settingsDialog->open();
 }
 
+void MainWindow::openPerformanceDialog()
+{
+    // non-modal, such that the phases can be watched while using hotspot
+    if (!m_performanceDialog) {
+        m_performanceDialog = new SelfProfilerDialog(this);
+        m_performanceDialog->setWindowIcon(windowIcon());
+    }
+    m_performanceDialog->show();
+    m_performanceDialog->raise();
+}
+
 void MainWindow::aboutHotspot()
 {
     AboutDialog dialog(this);
@@ -588,6 +854,15 @@ void MainWindow::navigateToCode(const QString& filePath, int lineNumber, int col
 
 void MainWindow::openInNewWindow(const QString& file, const QStringList& args)
 {
+    if (qobject_cast<QApplication*>(qApp)) {
+        // the windows of one process share the symbol, disassembly and source code caches and the job scheduler
+        // the command line options got applied to the settings already, which all windows share
+        auto* window = new MainWindow;
+        window->openFile(QFileInfo(file).isDir() ? file + QLatin1String("/perf.data") : file);
+        window->show();
+        return;
+    }
+
     auto process = new QProcess(qApp);
     QObject::connect(process, &QProcess::errorOccurred, qApp, [=]() { qWarning() << file << process->errorString(); });
     // the event loop locker prevents the main app from quitting while the child processes are still running
@@ -24,10 +24,12 @@ class QStackedWidget;
 
 class KRecentFilesAction;
 
+class CaptureWatcher;
 class StartPage;
 class ResultsPage;
 class RecordPage;
 class SettingsDialog;
+class SelfProfilerDialog;
 
 class MainWindow : public KParts::MainWindow
 {
@@ -41,6 +43,8 @@ public slots:
     void clear();
     void openFile(const QString& path);
     void openFile(const QUrl& url);
+    // merges the costs of all @p paths into one profile, see PerfParser::startMergeFiles
+    void mergeFiles(const QStringList& paths);
     void reload();
     void saveAs();
     void saveAs(const QUrl& url);
@@ -52,11 +56,13 @@ public slots:
 
     void aboutKDAB();
     void openSettingsDialog();
+    void openPerformanceDialog();
     void aboutHotspot();
 
     void setCodeNavigationIDE(QAction* action);
     void navigateToCode(const QString& url, int lineNumber, int columnNumber);
 
+    // opens @p file in another window of this process, or in a new process with @p args when there's no GUI
     static void openInNewWindow(const QString& file, const QStringList& args = {});
 
 signals:
@@ -67,20 +73,30 @@ signals:
 private:
     void clear(bool isReload);
     void openFile(const QString& path, bool isReload);
+    void mergeFiles(const QStringList& paths, bool isReload);
+    void startLiveAnalysis(const QString& path);
     void closeEvent(QCloseEvent* event) override;
     void setupCodeNavigationMenu();
     QString queryOpenDataFile();
 
     std::unique_ptr<Ui::MainWindow> ui;
+    // counts the windows of this process, only the first one restores and saves the layout of the docks
+    const int m_windowId;
     PerfParser* m_parser;
     KSharedConfigPtr m_config;
     QStackedWidget* m_pageStack;
     StartPage* m_startPage;
     RecordPage* m_recordPage;
     ResultsPage* m_resultsPage;
-    SettingsDialog* m_settingsDialog;
+    SettingsDialog* m_settingsDialog = nullptr;
+    SelfProfilerDialog* m_performanceDialog = nullptr;
 
     KRecentFilesAction* m_recentFilesAction = nullptr;
     QAction* m_reloadAction = nullptr;
     QAction* m_exportAction = nullptr;
+    QAction* m_stopRecordingAction = nullptr;
+    QAction* m_compareAction = nullptr;
+    QAction* m_stopComparingAction = nullptr;
+    // caches the captures that show up in a directory while the action to watch it is checked
+    CaptureWatcher* m_captureWatcher = nullptr;
 };
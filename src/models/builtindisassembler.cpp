@@ -0,0 +1,352 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "builtindisassembler.h"
+
+#include <QCache>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QMutex>
+
+#include <capstone/capstone.h>
+#include <elfutils/libdw.h>
+#include <gelf.h>
+#include <libelf.h>
+
+#include <cxxabi.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+
+namespace {
+Q_LOGGING_CATEGORY(builtindisassembler, "hotspot.builtindisassembler")
+
+QString demangle(const QByteArray& name)
+{
+    if (name.startsWith("_Z")) {
+        int status = 0;
+        auto* demangled = abi::__cxa_demangle(name.constData(), nullptr, nullptr, &status);
+        if (status == 0 && demangled) {
+            auto ret = QString::fromUtf8(demangled);
+            free(demangled);
+            return ret;
+        }
+    }
+    return QString::fromUtf8(name);
+}
+
+struct Function
+{
+    quint64 addr = 0;
+    quint64 size = 0;
+    QByteArray name;
+};
+
+// a binary that is mapped into memory, together with the function symbols to resolve branch targets
+class ElfFile
+{
+public:
+    explicit ElfFile(const QString& path)
+        : m_fd(open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC))
+    {
+        if (m_fd < 0) {
+            qCWarning(builtindisassembler) << "failed to open" << path;
+            return;
+        }
+
+        m_elf = elf_begin(m_fd, ELF_C_READ_MMAP, nullptr);
+        if (!m_elf) {
+            qCWarning(builtindisassembler) << "failed to read" << path << elf_errmsg(-1);
+            return;
+        }
+
+        // optional, without debug infos there just won't be any source lines
+        m_dwarf = dwarf_begin_elf(m_elf, DWARF_C_READ, nullptr);
+        readFunctions();
+    }
+
+    ~ElfFile()
+    {
+        if (m_dwarf) {
+            dwarf_end(m_dwarf);
+        }
+        if (m_elf) {
+            elf_end(m_elf);
+        }
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+
+    Q_DISABLE_COPY(ElfFile)
+
+    Elf* elf() const
+    {
+        return m_elf;
+    }
+
+    Dwarf* dwarf() const
+    {
+        return m_dwarf;
+    }
+
+    // libelf and libdw read their tables lazily, so a file can only be used by one thread at a time
+    QMutex& mutex()
+    {
+        return m_mutex;
+    }
+
+    // the function containing @p addr, or nullptr
+    const Function* findFunction(quint64 addr) const
+    {
+        auto it = std::upper_bound(m_functions.begin(), m_functions.end(), addr,
+                                   [](quint64 addr, const Function& function) { return addr < function.addr; });
+        if (it == m_functions.begin()) {
+            return nullptr;
+        }
+        --it;
+        return addr < it->addr + std::max<quint64>(it->size, 1) ? &(*it) : nullptr;
+    }
+
+private:
+    void readFunctions()
+    {
+        Elf_Scn* section = nullptr;
+        while ((section = elf_nextscn(m_elf, section))) {
+            GElf_Shdr header;
+            if (!gelf_getshdr(section, &header) || (header.sh_type != SHT_SYMTAB && header.sh_type != SHT_DYNSYM)
+                || !header.sh_entsize) {
+                continue;
+            }
+
+            auto* data = elf_getdata(section, nullptr);
+            for (quint64 i = 0, c = header.sh_size / header.sh_entsize; data && i < c; ++i) {
+                GElf_Sym sym;
+                if (!gelf_getsym(data, i, &sym) || GELF_ST_TYPE(sym.st_info) != STT_FUNC || !sym.st_value) {
+                    continue;
+                }
+                if (const auto* name = elf_strptr(m_elf, header.sh_link, sym.st_name)) {
+                    m_functions.push_back({sym.st_value, sym.st_size, QByteArray(name)});
+                }
+            }
+        }
+
+        // the dynamic symbols are typically also part of the full symbol table
+        std::sort(m_functions.begin(), m_functions.end(),
+                  [](const Function& lhs, const Function& rhs) { return lhs.addr < rhs.addr; });
+        m_functions.erase(std::unique(m_functions.begin(), m_functions.end(),
+                                      [](const Function& lhs, const Function& rhs) { return lhs.addr == rhs.addr; }),
+                          m_functions.end());
+    }
+
+    QMutex m_mutex;
+    int m_fd = -1;
+    Elf* m_elf = nullptr;
+    Dwarf* m_dwarf = nullptr;
+    QVector<Function> m_functions;
+};
+
+struct ElfCache
+{
+    ElfCache()
+    {
+        elf_version(EV_CURRENT);
+    }
+
+    // only guards the cache, the files get shared so that evicting one doesn't delete it while it is in use
+    QMutex mutex;
+    QCache<QString, std::shared_ptr<ElfFile>> files {16};
+};
+
+ElfCache& elfCache()
+{
+    static ElfCache cache;
+    return cache;
+}
+
+struct Code
+{
+    const uchar* data = nullptr;
+    size_t size = 0;
+};
+
+Code findCode(Elf* elf, quint64 addr, quint64 size)
+{
+    Elf_Scn* section = nullptr;
+    while ((section = elf_nextscn(elf, section))) {
+        GElf_Shdr header;
+        if (!gelf_getshdr(section, &header) || !(header.sh_flags & SHF_EXECINSTR) || addr < header.sh_addr
+            || addr + size > header.sh_addr + header.sh_size) {
+            continue;
+        }
+
+        // separate debug files only contain the headers of the code sections
+        if (header.sh_type != SHT_PROGBITS) {
+            return {};
+        }
+
+        auto* data = elf_getdata(section, nullptr);
+        if (!data || !data->d_buf || data->d_size < addr + size - header.sh_addr) {
+            return {};
+        }
+        return {static_cast<const uchar*>(data->d_buf) + (addr - header.sh_addr), size};
+    }
+    return {};
+}
+
+bool openCapstone(const GElf_Ehdr& header, csh* handle)
+{
+    cs_arch arch;
+    int mode = 0;
+    switch (header.e_machine) {
+    case EM_X86_64:
+        arch = CS_ARCH_X86;
+        mode = CS_MODE_64;
+        break;
+    case EM_386:
+        arch = CS_ARCH_X86;
+        mode = CS_MODE_32;
+        break;
+    case EM_AARCH64:
+        arch = CS_ARCH_ARM64;
+        mode = CS_MODE_ARM;
+        break;
+    case EM_ARM:
+        arch = CS_ARCH_ARM;
+        mode = CS_MODE_ARM;
+        break;
+    default:
+        return false;
+    }
+    if (header.e_ident[EI_DATA] == ELFDATA2MSB) {
+        mode |= CS_MODE_BIG_ENDIAN;
+    }
+
+    if (cs_open(arch, static_cast<cs_mode>(mode), handle) != CS_ERR_OK) {
+        qCWarning(builtindisassembler) << "failed to initialize capstone for machine" << header.e_machine;
+        return false;
+    }
+    // use the same syntax as objdump
+    if (arch == CS_ARCH_X86) {
+        cs_option(*handle, CS_OPT_SYNTAX, CS_OPT_SYNTAX_ATT);
+    }
+    // required for the instruction groups
+    cs_option(*handle, CS_OPT_DETAIL, CS_OPT_ON);
+    return true;
+}
+
+// the target of a direct jump or call, or 0
+quint64 branchTarget(csh handle, const cs_insn& instruction)
+{
+    if (!cs_insn_group(handle, &instruction, CS_GRP_JUMP) && !cs_insn_group(handle, &instruction, CS_GRP_CALL)) {
+        return 0;
+    }
+
+    // direct branches end with the immediate target, e.g. "0x1040" or "x0, #0x1040"
+    auto target = QByteArray(instruction.op_str);
+    target = target.mid(target.lastIndexOf(' ') + 1);
+    if (target.startsWith('#')) {
+        target.remove(0, 1);
+    }
+    if (!target.startsWith("0x")) {
+        return 0;
+    }
+    bool ok = false;
+    const auto addr = target.mid(2).toULongLong(&ok, 16);
+    return ok ? addr : 0;
+}
+}
+
+bool BuiltinDisassembler::disassemble(const QString& binary, const Data::Symbol& symbol,
+                                      DisassemblyOutput::ObjectdumpOutput* output)
+{
+    auto& cache = elfCache();
+
+    // the binary could be rebuilt while we are running
+    const auto key =
+        binary + QLatin1Char('\n') + QString::number(QFileInfo(binary).lastModified().toMSecsSinceEpoch());
+    std::shared_ptr<ElfFile> file;
+    {
+        QMutexLocker lock(&cache.mutex);
+        if (auto* cached = cache.files.object(key)) {
+            file = *cached;
+        }
+    }
+    if (!file) {
+        // reading the symbols takes a while, other binaries can get disassembled meanwhile
+        file = std::make_shared<ElfFile>(binary);
+        QMutexLocker lock(&cache.mutex);
+        cache.files.insert(key, new std::shared_ptr<ElfFile>(file));
+    }
+
+    QMutexLocker fileLock(&file->mutex());
+
+    GElf_Ehdr header;
+    if (!file->elf() || !gelf_getehdr(file->elf(), &header)) {
+        return false;
+    }
+
+    const auto code = findCode(file->elf(), symbol.relAddr, symbol.size);
+    csh handle;
+    if (!code.data || !openCapstone(header, &handle)) {
+        return false;
+    }
+
+    cs_insn* instructions = nullptr;
+    const auto count = cs_disasm(handle, code.data, code.size, symbol.relAddr, 0, &instructions);
+
+    // the symbol is part of a single compilation unit, so look that up only once
+    Dwarf_Die cuDie;
+    auto* cu = file->dwarf() ? dwarf_addrdie(file->dwarf(), symbol.relAddr, &cuDie) : nullptr;
+
+    output->disassemblyLines.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const auto& instruction = instructions[i];
+
+        DisassemblyOutput::DisassemblyLine line;
+        line.addr = instruction.address;
+        line.disassembly = QString::fromLatin1(instruction.mnemonic);
+        if (instruction.op_str[0]) {
+            line.disassembly += QLatin1Char(' ') + QString::fromLatin1(instruction.op_str);
+        }
+        line.hexdump = QString::fromLatin1(
+            QByteArray::fromRawData(reinterpret_cast<const char*>(instruction.bytes), instruction.size).toHex(' '));
+
+        // annotate branches like objdump does, e.g. "call 0x1040 <foo+0x10>"
+        if (const auto target = branchTarget(handle, instruction)) {
+            if (const auto* function = file->findFunction(target)) {
+                line.linkedFunction = {demangle(function->name), static_cast<int>(target - function->addr)};
+                line.disassembly += QLatin1String(" <") + line.linkedFunction.name;
+                if (line.linkedFunction.offset) {
+                    line.disassembly += QLatin1String("+0x") + QString::number(line.linkedFunction.offset, 16);
+                }
+                line.disassembly += QLatin1Char('>');
+            }
+        }
+
+        if (cu) {
+            if (auto* sourceLine = dwarf_getsrc_die(cu, instruction.address)) {
+                int lineNumber = -1;
+                dwarf_lineno(sourceLine, &lineNumber);
+                line.fileLine = {QString::fromUtf8(dwarf_linesrc(sourceLine, nullptr, nullptr)), lineNumber};
+                if (output->mainSourceFileName.isEmpty()) {
+                    output->mainSourceFileName = line.fileLine.file;
+                }
+            }
+        }
+
+        output->disassemblyLines.push_back(line);
+    }
+
+    cs_free(instructions, count);
+    cs_close(&handle);
+    return count > 0;
+}
@@ -0,0 +1,18 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "disassemblyoutput.h"
+
+// an in-process alternative to objdump, based on capstone
+// the binaries stay mapped between calls, so disassembling another symbol of the same binary only decodes the
+// bytes of that symbol
+namespace BuiltinDisassembler {
+// returns false when the binary, its architecture or the section of the symbol isn't supported
+// objdump should be used in that case
+bool disassemble(const QString& binary, const Data::Symbol& symbol, DisassemblyOutput::ObjectdumpOutput* output);
+}
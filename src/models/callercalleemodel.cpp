@@ -7,7 +7,9 @@
 */
 
 #include "callercalleemodel.h"
+#include "../selfprofiler.h"
 #include "../util.h"
+#include "symboltimeseries.h"
 
 #include <QDebug>
 
@@ -33,12 +35,22 @@ CallerCalleeModel::~CallerCalleeModel() = default;
 
 void CallerCalleeModel::setResults(const Data::CallerCalleeResults& results)
 {
+    ScopedPhase phase("caller callee model reset");
     m_results = results;
     setRows(results.entries);
 }
 
 QVariant CallerCalleeModel::headerCell(int column, int role) const
 {
+    if (column == timeSeriesColumn()) {
+        if (role == Qt::DisplayRole) {
+            return tr("Over Time");
+        } else if (role == Qt::ToolTipRole) {
+            return tr("The inclusive cost of the symbol over the time of the recording, the markers separate the "
+                      "phases of different cost. The costs are computed when the rows get shown.");
+        }
+        return {};
+    }
     if (role == Qt::InitialSortOrderRole && column > Binary) {
         return Qt::DescendingOrder;
     } else if (role == Qt::DisplayRole) {
@@ -79,10 +91,19 @@ QVariant CallerCalleeModel::cell(int column, int role, const Data::Symbol& symbo
 {
     if (role == SymbolRole) {
         return QVariant::fromValue(symbol);
+    } else if (column == timeSeriesColumn()) {
+        if (role != TimeSeriesRole && role != Qt::ToolTipRole) {
+            return {};
+        }
+        const auto* series = m_timeSeries->series(symbol);
+        if (!series) {
+            return {};
+        }
+        return role == TimeSeriesRole ? QVariant::fromValue(*series) : QVariant(series->phasesToolTip());
     } else if (role == SortRole) {
         switch (column) {
         case Symbol:
-            return Util::formatSymbol(symbol.prettySymbol);
+            return Util::formatSymbol(symbol.prettySymbol());
         case Binary:
             return symbol.binary;
         }
@@ -95,11 +116,11 @@ QVariant CallerCalleeModel::cell(int column, int role, const Data::Symbol& symbo
     } else if (role == TotalCostRole && column >= NUM_BASE_COLUMNS) {
         column -= NUM_BASE_COLUMNS;
         if (column < m_results.selfCosts.numTypes()) {
-            return m_results.selfCosts.totalCost(column);
+            return m_results.selfCosts.referenceCost(column);
         }
 
         column -= m_results.selfCosts.numTypes();
-        return m_results.inclusiveCosts.totalCost(column);
+        return m_results.inclusiveCosts.referenceCost(column);
     } else if (role == Qt::DisplayRole) {
         switch (column) {
         case Symbol:
@@ -110,17 +131,17 @@ QVariant CallerCalleeModel::cell(int column, int role, const Data::Symbol& symbo
         column -= 2;
         if (column < m_results.selfCosts.numTypes()) {
             return Util::formatCostRelative(m_results.selfCosts.cost(column, entry.id),
-                                            m_results.selfCosts.totalCost(column), true);
+                                            m_results.selfCosts.referenceCost(column), true);
         }
         column -= m_results.selfCosts.numTypes();
         return Util::formatCostRelative(m_results.inclusiveCosts.cost(column, entry.id),
-                                        m_results.inclusiveCosts.totalCost(column), true);
+                                        m_results.inclusiveCosts.referenceCost(column), true);
     } else if (role == CalleesRole) {
         return QVariant::fromValue(entry.callees);
     } else if (role == CallersRole) {
         return QVariant::fromValue(entry.callers);
     } else if (role == SourceMapRole) {
-        return QVariant::fromValue(entry.sourceMap);
+        return QVariant::fromValue(m_results.sourceMap(symbol));
     } else if (role == SelfCostsRole) {
         return QVariant::fromValue(m_results.selfCosts);
     } else if (role == InclusiveCostsRole) {
@@ -170,5 +191,18 @@ SourceMapModel::~SourceMapModel() = default;
 
 int CallerCalleeModel::numColumns() const
 {
-    return NUM_BASE_COLUMNS + m_results.inclusiveCosts.numTypes() + m_results.selfCosts.numTypes();
+    return NUM_BASE_COLUMNS + m_results.inclusiveCosts.numTypes() + m_results.selfCosts.numTypes()
+        + (m_timeSeries ? 1 : 0);
+}
+
+void CallerCalleeModel::setTimeSeries(const SymbolTimeSeriesCache* timeSeries)
+{
+    beginResetModel();
+    m_timeSeries = timeSeries;
+    endResetModel();
+}
+
+int CallerCalleeModel::timeSeriesColumn() const
+{
+    return m_timeSeries ? numColumns() - 1 : -1;
 }
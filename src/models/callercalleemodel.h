@@ -15,6 +15,8 @@
 #include "data.h"
 #include "hashmodel.h"
 
+class SymbolTimeSeriesCache;
+
 class CallerCalleeModel : public HashModel<Data::CallerCalleeEntryMap, CallerCalleeModel>
 {
     Q_OBJECT
@@ -45,6 +47,8 @@ public:
         SelfCostsRole,
         InclusiveCostsRole,
         SymbolRole,
+        // the SymbolTimeSeries of the symbol, see setTimeSeries
+        TimeSeriesRole,
     };
 
     QVariant headerCell(int column, int role) const final override;
@@ -53,8 +57,13 @@ public:
     int numColumns() const final override;
     QModelIndex indexForSymbol(const Data::Symbol& symbol) const;
 
+    // see BottomUpModel::setTimeSeries
+    void setTimeSeries(const SymbolTimeSeriesCache* timeSeries);
+    int timeSeriesColumn() const;
+
 private:
     Data::CallerCalleeResults m_results;
+    const SymbolTimeSeriesCache* m_timeSeries = nullptr;
 };
 
 template<typename ModelImpl>
@@ -145,7 +154,7 @@ public:
             }
             return costs[column - NUM_BASE_COLUMNS];
         } else if (role == TotalCostRole && column >= NUM_BASE_COLUMNS) {
-            return m_costs.totalCost(column - NUM_BASE_COLUMNS);
+            return m_costs.referenceCost(column - NUM_BASE_COLUMNS);
         } else if (role == Qt::DisplayRole) {
             switch (column) {
             case Symbol:
@@ -154,7 +163,7 @@ public:
                 return symbol.binary;
             }
             return Util::formatCostRelative(costs[column - NUM_BASE_COLUMNS],
-                                            m_costs.totalCost(column - NUM_BASE_COLUMNS), true);
+                                            m_costs.referenceCost(column - NUM_BASE_COLUMNS), true);
         } else if (role == SymbolRole) {
             return QVariant::fromValue(symbol);
         } else if (role == Qt::ToolTipRole) {
@@ -278,7 +287,7 @@ public:
             if (column >= m_totalCosts.numTypes()) {
                 column -= m_totalCosts.numTypes();
             }
-            return m_totalCosts.totalCost(column);
+            return m_totalCosts.referenceCost(column);
         } else if (role == Qt::DisplayRole) {
             if (column == Location) {
                 if (!fileLine.isValid()) {
@@ -289,10 +298,10 @@ public:
             }
             column -= NUM_BASE_COLUMNS;
             if (column < m_totalCosts.numTypes()) {
-                return Util::formatCostRelative(costs.selfCost[column], m_totalCosts.totalCost(column), true);
+                return Util::formatCostRelative(costs.selfCost[column], m_totalCosts.referenceCost(column), true);
             }
             column -= m_totalCosts.numTypes();
-            return Util::formatCostRelative(costs.inclusiveCost[column], m_totalCosts.totalCost(column), true);
+            return Util::formatCostRelative(costs.inclusiveCost[column], m_totalCosts.referenceCost(column), true);
         } else if (role == FileLineRole) {
             return QVariant::fromValue(fileLine);
         } else if (role == Qt::ToolTipRole) {
@@ -8,31 +8,157 @@
 
 #include "callercalleeproxy.h"
 
+#include "../jobscheduler.h"
 #include "callercalleemodel.h"
 #include "data.h"
 
-#include <QRegularExpression>
+#include <QPointer>
 
-namespace {
-bool matchImpl(const QRegularExpression& pattern, const QString& haystack)
+namespace CallerCalleeProxyDetail {
+bool Matcher::match(const QSortFilterProxyModel* proxy, const Data::Symbol& symbol) const
 {
-    return pattern.match(haystack).hasMatch();
+    setPattern(proxy->filterRegularExpression());
+
+    return matches(symbol);
 }
+
+bool Matcher::matches(const Data::Symbol& symbol) const
+{
+    if (symbol.internId == -1) {
+        return matches(symbol.symbol) || matches(symbol.binary);
+    }
+
+    auto it = m_symbolMatches.constFind(symbol.internId);
+    if (it == m_symbolMatches.constEnd()) {
+        it = m_symbolMatches.insert(symbol.internId, matches(symbol.symbol) || matches(symbol.binary));
+    }
+    return it.value();
 }
 
-namespace CallerCalleeProxyDetail {
-bool match(const QSortFilterProxyModel* proxy, const Data::Symbol& symbol)
+bool Matcher::match(const QSortFilterProxyModel* proxy, const Data::FileLine& fileLine) const
+{
+    setPattern(proxy->filterRegularExpression());
+
+    return matches(fileLine.file);
+}
+
+QString Matcher::literalPattern(const QString& pattern)
+{
+    // QRegularExpression::escape prefixes every non-word character with a backslash
+    const auto isWordChar = [](QChar c) { return c.isLetterOrNumber() || c == QLatin1Char('_'); };
+
+    QString literal(pattern.size(), Qt::Uninitialized);
+    int size = 0;
+    for (int i = 0, c = pattern.size(); i < c; ++i) {
+        auto character = pattern.at(i);
+        if (character == QLatin1Char('\\')) {
+            // escaped word characters are character classes or back references like \d or \1
+            if (i + 1 == c || isWordChar(pattern.at(i + 1))) {
+                return {};
+            }
+            character = pattern.at(++i);
+        } else if (QStringView(u"^$.|?*+()[]{}").contains(character)) {
+            return {};
+        }
+        literal[size++] = character;
+    }
+    literal.resize(size);
+    // distinguish the empty pattern from the null string
+    if (literal.isNull()) {
+        literal = QLatin1String("");
+    }
+    return literal;
+}
+
+void Matcher::setPattern(const QRegularExpression& pattern) const
+{
+    if (pattern == m_pattern) {
+        return;
+    }
+
+    m_pattern = pattern;
+    m_symbolMatches.clear();
+
+    const auto literal = literalPattern(pattern.pattern());
+    m_isLiteral = !literal.isNull();
+    if (m_isLiteral) {
+        m_literal.setPattern(literal);
+        m_literal.setCaseSensitivity(pattern.patternOptions() & QRegularExpression::CaseInsensitiveOption
+                                         ? Qt::CaseInsensitive
+                                         : Qt::CaseSensitive);
+    } else {
+        m_pattern.optimize();
+    }
+}
+
+void Matcher::setSymbolMatches(const QRegularExpression& pattern, const QHash<qint32, bool>& matches)
+{
+    setPattern(pattern);
+    m_symbolMatches = matches;
+}
+
+bool Matcher::matches(const QString& haystack) const
+{
+    if (m_isLiteral) {
+        return m_literal.pattern().isEmpty() || m_literal.indexIn(haystack) != -1;
+    }
+    return m_pattern.match(haystack).hasMatch();
+}
+
+SymbolSearch::~SymbolSearch() = default;
+
+void SymbolSearch::search(QObject* context, const QRegularExpression& pattern, const std::function<void()>& apply)
 {
-    const auto pattern = proxy->filterRegularExpression();
+    // cancels the searches that are still running
+    const auto searchId = ++m_searchId;
+
+    // everything matches the empty pattern, no need to look at the symbols
+    if (pattern.pattern().isEmpty()) {
+        apply();
+        return;
+    }
 
-    return matchImpl(pattern, symbol.symbol) || matchImpl(pattern, symbol.binary);
+    const auto smartContext = QPointer<QObject>(context);
+    JobScheduler::run(JobScheduler::Priority::Interactive, [this, smartContext, searchId, currentSearchId = &m_searchId,
+                                                            pattern, apply, collectSymbols = symbolCollector()]() {
+        const auto isCancelled = [&]() { return !smartContext || searchId != (*currentSearchId); };
+        if (isCancelled()) {
+            return;
+        }
+
+        Matcher matcher;
+        matcher.setPattern(pattern);
+
+        const auto symbols = collectSymbols();
+        for (int i = 0, c = symbols.size(); i < c; ++i) {
+            if (i % 1024 == 0 && isCancelled()) {
+                return;
+            }
+            matcher.matches(symbols[i]);
+        }
+        const auto matches = matcher.symbolMatches();
+
+        QMetaObject::invokeMethod(
+            smartContext.data(),
+            [this, smartContext, searchId, pattern, apply, matches]() {
+                if (smartContext && searchId == m_searchId) {
+                    m_matcher.setSymbolMatches(pattern, matches);
+                    apply();
+                }
+            },
+            Qt::QueuedConnection);
+    });
 }
 
-bool match(const QSortFilterProxyModel* proxy, const Data::FileLine& fileLine)
+QVector<Data::Symbol> searchableSymbols(const QVector<Data::Symbol>& keys)
 {
-    const auto pattern = proxy->filterRegularExpression();
+    return keys;
+}
 
-    return matchImpl(pattern, fileLine.file);
+QVector<Data::Symbol> searchableSymbols(const QVector<Data::FileLine>& /*keys*/)
+{
+    // locations aren't interned, they get matched on demand
+    return {};
 }
 }
 
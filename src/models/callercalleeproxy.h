@@ -8,7 +8,14 @@
 
 #pragma once
 
+#include <QHash>
+#include <QRegularExpression>
 #include <QSortFilterProxyModel>
+#include <QStringMatcher>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
 
 namespace Data {
 struct Symbol;
@@ -16,14 +23,68 @@ struct FileLine;
 }
 
 namespace CallerCalleeProxyDetail {
-bool match(const QSortFilterProxyModel* proxy, const Data::Symbol& symbol);
-bool match(const QSortFilterProxyModel* proxy, const Data::FileLine& fileLine);
+// matches symbols and locations against the filter of a proxy
+// the filter gets compiled once, literal filters skip the regex engine and the result is cached per interned symbol
+class Matcher
+{
+public:
+    bool match(const QSortFilterProxyModel* proxy, const Data::Symbol& symbol) const;
+    bool match(const QSortFilterProxyModel* proxy, const Data::FileLine& fileLine) const;
+
+    // the text @p pattern matches literally, or a null string when it uses any regex syntax
+    static QString literalPattern(const QString& pattern);
+
+    // compiles @p pattern, dropping the cached results when it differs from the current one
+    void setPattern(const QRegularExpression& pattern) const;
+    bool matches(const Data::Symbol& symbol) const;
+
+    // the cached results of the interned symbols, installed by a background search for @p pattern, see SymbolSearch
+    QHash<qint32, bool> symbolMatches() const
+    {
+        return m_symbolMatches;
+    }
+    void setSymbolMatches(const QRegularExpression& pattern, const QHash<qint32, bool>& matches);
+
+private:
+    bool matches(const QString& haystack) const;
+
+    mutable QRegularExpression m_pattern;
+    mutable bool m_isLiteral = true;
+    mutable QStringMatcher m_literal;
+    // keyed by Data::Symbol::internId
+    mutable QHash<qint32, bool> m_symbolMatches;
+};
+
+// the proxies that filter by symbol can match all symbols of their source model in a background job
+// the matches are then applied at once, so typing into the search line doesn't block the GUI thread
+class SymbolSearch
+{
+public:
+    virtual ~SymbolSearch();
+
+    // matches the symbols against @p pattern in the background, then installs the matches and calls @p apply
+    // a new search cancels the ones that are still running, @p context guards the callback
+    void search(QObject* context, const QRegularExpression& pattern, const std::function<void()>& apply);
+
+protected:
+    // returns a function collecting the symbols to match, it gets called from a background thread
+    virtual std::function<QVector<Data::Symbol>()> symbolCollector() const = 0;
+
+    Matcher m_matcher;
+
+private:
+    std::atomic<uint> m_searchId {0};
+};
+
+// the keys of the caller/callee models that can be searched in the background
+QVector<Data::Symbol> searchableSymbols(const QVector<Data::Symbol>& keys);
+QVector<Data::Symbol> searchableSymbols(const QVector<Data::FileLine>& keys);
 }
 
 class SourceMapModel;
 
 template<typename Model>
-class CallerCalleeProxy : public QSortFilterProxyModel
+class CallerCalleeProxy : public QSortFilterProxyModel, public CallerCalleeProxyDetail::SymbolSearch
 {
 public:
     explicit CallerCalleeProxy(QObject* parent = nullptr)
@@ -43,7 +104,15 @@ protected:
 
         const auto key = model->key(source_row);
 
-        return CallerCalleeProxyDetail::match(this, key);
+        return m_matcher.match(this, key);
+    }
+
+    std::function<QVector<Data::Symbol>()> symbolCollector() const override
+    {
+        const auto* model = qobject_cast<Model*>(sourceModel());
+        Q_ASSERT(model);
+
+        return [keys = model->keys()]() { return CallerCalleeProxyDetail::searchableSymbols(keys); };
     }
 };
 
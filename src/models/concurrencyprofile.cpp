@@ -0,0 +1,152 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "concurrencyprofile.h"
+
+#include <algorithm>
+#include <queue>
+
+namespace {
+struct Boundary
+{
+    quint64 time = 0;
+    // +1 when the thread starts running, -1 when it stops
+    qint32 delta = 0;
+};
+
+// the times a thread started and stopped running, ordered by time
+QVector<Boundary> onCpuBoundaries(const Data::ThreadEvents& thread, qint32 offCpuTimeCostId)
+{
+    QVector<Boundary> ret;
+    if (thread.state == Data::ThreadEvents::Unknown || thread.time.end <= thread.time.start) {
+        // the thread never got switched, so it's unknown when it ran
+        return ret;
+    }
+
+    // a thread that is switched out at the end has no off-CPU time event for its last switch
+    const auto end = thread.state == Data::ThreadEvents::OffCpu ? std::min(thread.lastSwitchTime, thread.time.end)
+                                                                 : thread.time.end;
+    auto running = thread.time.start;
+    auto addRunning = [&](quint64 until) {
+        until = std::min(until, end);
+        if (until > running) {
+            ret.push_back({running, 1});
+            ret.push_back({until, -1});
+        }
+    };
+
+    const auto& times = thread.events.times();
+    thread.events.forEachRun([&](const Data::EventRun& run) {
+        if (run.type != offCpuTimeCostId) {
+            return true;
+        }
+        for (qsizetype i = run.first, last = run.first + run.count; i < last; ++i) {
+            const auto offCpuTime = times.at(i);
+            addRunning(offCpuTime);
+            running = std::max(running, offCpuTime + run.cost);
+        }
+        return true;
+    });
+    addRunning(end);
+    return ret;
+}
+}
+
+ConcurrencyProfile::ConcurrencyProfile(const Data::EventResults& events)
+{
+    // sampled off-CPU time doesn't tell when the threads ran
+    if (events.offCpuTimeCostId == -1 || events.offCpuTimeSampled) {
+        return;
+    }
+
+    QVector<QVector<Boundary>> boundaries;
+    boundaries.reserve(events.threads.size());
+    for (const auto& thread : events.threads) {
+        auto threadBoundaries = onCpuBoundaries(thread, events.offCpuTimeCostId);
+        if (!threadBoundaries.isEmpty()) {
+            boundaries.push_back(std::move(threadBoundaries));
+        }
+    }
+    if (boundaries.isEmpty()) {
+        return;
+    }
+
+    // the next boundary of every thread, the earliest one on top
+    struct Cursor
+    {
+        quint64 time = 0;
+        qint32 thread = 0;
+        qint32 boundary = 0;
+    };
+    auto isLater = [](const Cursor& lhs, const Cursor& rhs) { return lhs.time > rhs.time; };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(isLater)> heap(isLater);
+    for (qint32 thread = 0, numThreads = boundaries.size(); thread < numThreads; ++thread) {
+        heap.push({boundaries[thread].first().time, thread, 0});
+    }
+
+    qint32 running = 0;
+    double threadTime = 0;
+    while (!heap.empty()) {
+        const auto time = heap.top().time;
+        if (!m_steps.isEmpty()) {
+            const auto& last = m_steps.constLast();
+            const auto duration = time - last.time;
+            if (m_histogram.size() <= last.runningThreads) {
+                m_histogram.resize(last.runningThreads + 1);
+            }
+            m_histogram[last.runningThreads] += duration;
+            threadTime += static_cast<double>(duration) * last.runningThreads;
+        }
+
+        // apply all boundaries at this time at once, so threads that switch at the same time don't add steps
+        while (!heap.empty() && heap.top().time == time) {
+            auto cursor = heap.top();
+            heap.pop();
+            const auto& threadBoundaries = boundaries[cursor.thread];
+            running += threadBoundaries[cursor.boundary].delta;
+            if (++cursor.boundary < threadBoundaries.size()) {
+                cursor.time = threadBoundaries[cursor.boundary].time;
+                heap.push(cursor);
+            }
+        }
+
+        if (m_steps.isEmpty() || m_steps.constLast().runningThreads != running) {
+            m_steps.push_back({time, running});
+            m_threadTimes.push_back(threadTime);
+        }
+    }
+}
+
+qint32 ConcurrencyProfile::runningThreads(quint64 time) const
+{
+    auto it = std::upper_bound(m_steps.begin(), m_steps.end(), time,
+                               [](quint64 time, const Step& step) { return time < step.time; });
+    if (it == m_steps.begin()) {
+        return 0;
+    }
+    return std::prev(it)->runningThreads;
+}
+
+double ConcurrencyProfile::threadTimeBefore(quint64 time) const
+{
+    auto it = std::upper_bound(m_steps.begin(), m_steps.end(), time,
+                               [](quint64 time, const Step& step) { return time < step.time; });
+    if (it == m_steps.begin()) {
+        return 0;
+    }
+    const auto step = std::distance(m_steps.begin(), it) - 1;
+    return m_threadTimes[step]
+        + static_cast<double>(time - m_steps[step].time) * m_steps[step].runningThreads;
+}
+
+double ConcurrencyProfile::averageRunningThreads(Data::TimeRange time) const
+{
+    time = time.normalized();
+    if (time.isEmpty()) {
+        return runningThreads(time.start);
+    }
+    return (threadTimeBefore(time.end) - threadTimeBefore(time.start)) / static_cast<double>(time.delta());
+}
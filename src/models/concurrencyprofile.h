@@ -0,0 +1,82 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QVector>
+
+#include "data.h"
+
+// how many threads were running on a CPU over time, derived from the context switches of the threads
+// a thread runs from its start until it gets switched out, i.e. until its next off-CPU time event, and again once
+// that off-CPU time is over. without context switches in the capture, nothing is known about this and the profile
+// stays empty
+class ConcurrencyProfile
+{
+public:
+    struct Step
+    {
+        // from this time on, until the time of the next step
+        quint64 time = 0;
+        qint32 runningThreads = 0;
+
+        bool operator==(const Step& rhs) const
+        {
+            return time == rhs.time && runningThreads == rhs.runningThreads;
+        }
+    };
+
+    ConcurrencyProfile() = default;
+    // sweeps the on-CPU intervals of all threads in the order of their time, the next boundary of every thread comes
+    // from a heap, so this never has to sort the intervals of all threads at once
+    explicit ConcurrencyProfile(const Data::EventResults& events);
+
+    bool isEmpty() const
+    {
+        return m_steps.isEmpty();
+    }
+
+    // the number of running threads changes at every step, the last step ends the profile with no running threads
+    const QVector<Step>& steps() const
+    {
+        return m_steps;
+    }
+
+    Data::TimeRange time() const
+    {
+        return m_steps.isEmpty() ? Data::TimeRange() : Data::TimeRange(m_steps.first().time, m_steps.last().time);
+    }
+
+    // the time spent with N threads running, indexed by N
+    const QVector<quint64>& histogram() const
+    {
+        return m_histogram;
+    }
+
+    qint32 maxRunningThreads() const
+    {
+        return m_histogram.isEmpty() ? 0 : m_histogram.size() - 1;
+    }
+
+    qint32 runningThreads(quint64 time) const;
+
+    // the average number of running threads within @p time, i.e. the thread time divided by the duration
+    double averageRunningThreads(Data::TimeRange time) const;
+
+    double averageRunningThreads() const
+    {
+        return averageRunningThreads(time());
+    }
+
+private:
+    // the time all threads ran in total before @p time
+    double threadTimeBefore(quint64 time) const;
+
+    QVector<Step> m_steps;
+    // the thread time before every step, to average the running threads of any time range in logarithmic time
+    QVector<double> m_threadTimes;
+    QVector<quint64> m_histogram;
+};
@@ -0,0 +1,211 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "controlflow.h"
+
+#include <QHash>
+#include <QMap>
+
+#include "disassemblyoutput.h"
+#include "formattingutils.h"
+
+#include <algorithm>
+
+namespace {
+// splits off the first whitespace separated word of @p text
+QStringView takeWord(QStringView* text)
+{
+    *text = text->trimmed();
+    int end = 0;
+    while (end < text->size() && !text->at(end).isSpace()) {
+        ++end;
+    }
+    const auto word = text->left(end);
+    *text = text->mid(end);
+    return word;
+}
+
+bool isJump(QStringView mnemonic)
+{
+    // x86: jmp, jne, jrcxz, loopne, ...
+    if (mnemonic.startsWith(QLatin1Char('j')) || mnemonic.startsWith(QLatin1String("loop"))) {
+        return true;
+    }
+
+    // arm: b, b.ne, bne.w, cbz, tbnz, ...
+    const auto dotIndex = mnemonic.indexOf(QLatin1Char('.'));
+    if (dotIndex != -1) {
+        mnemonic = mnemonic.left(dotIndex);
+    }
+    const auto armJumps = {QLatin1String("b"),   QLatin1String("bal"), QLatin1String("beq"),  QLatin1String("bne"),
+                           QLatin1String("bcs"), QLatin1String("bhs"), QLatin1String("bcc"),  QLatin1String("blo"),
+                           QLatin1String("bmi"), QLatin1String("bpl"), QLatin1String("bvs"),  QLatin1String("bvc"),
+                           QLatin1String("bhi"), QLatin1String("bls"), QLatin1String("bge"),  QLatin1String("blt"),
+                           QLatin1String("bgt"), QLatin1String("ble"), QLatin1String("cbz"),  QLatin1String("cbnz"),
+                           QLatin1String("tbz"), QLatin1String("tbnz")};
+    return std::any_of(armJumps.begin(), armJumps.end(),
+                       [mnemonic](QLatin1String jump) { return mnemonic == jump; });
+}
+
+struct Branch
+{
+    // jumps and returns end a basic block
+    bool endsBlock = false;
+    // the target of a direct jump, or 0
+    quint64 target = 0;
+};
+
+Branch parseBranch(const QString& disassembly)
+{
+    const auto text = Util::removeAnsi(disassembly);
+    auto operands = QStringView(text);
+    auto mnemonic = takeWord(&operands);
+    // x86 prefixes that don't change the target
+    while (mnemonic == QLatin1String("bnd") || mnemonic == QLatin1String("notrack")) {
+        mnemonic = takeWord(&operands);
+    }
+
+    if (mnemonic.startsWith(QLatin1String("ret"))) {
+        return {true, 0};
+    } else if (!isJump(mnemonic)) {
+        return {};
+    }
+
+    // indirect jumps like "jmp *0x2fe2(%rip)" only have a comment with the address of the pointer
+    if (operands.contains(QLatin1Char('*'))) {
+        return {true, 0};
+    }
+
+    // the target is the last operand in front of the symbol, e.g. "cbz w0, 400600 <main+0x50>"
+    const auto bracketIndex = operands.indexOf(QLatin1Char('<'));
+    if (bracketIndex != -1) {
+        operands = operands.left(bracketIndex);
+    }
+    operands = operands.trimmed();
+    auto operandStart = operands.size();
+    while (operandStart > 0 && operands.at(operandStart - 1) != QLatin1Char(' ')
+           && operands.at(operandStart - 1) != QLatin1Char(',')) {
+        --operandStart;
+    }
+    auto target = operands.mid(operandStart);
+    if (target.startsWith(QLatin1Char('#'))) {
+        target = target.mid(1);
+    }
+    if (target.startsWith(QLatin1String("0x"))) {
+        target = target.mid(2);
+    }
+
+    bool ok = false;
+    const auto addr = target.toString().toULongLong(&ok, 16);
+    return {true, ok ? addr : 0};
+}
+}
+
+int ControlFlow::blockForRow(int row) const
+{
+    auto it = std::upper_bound(blocks.begin(), blocks.end(), row,
+                               [](int row, const BasicBlock& block) { return row < block.firstRow; });
+    if (it == blocks.begin()) {
+        return -1;
+    }
+    --it;
+    return row <= it->lastRow ? static_cast<int>(std::distance(blocks.begin(), it)) : -1;
+}
+
+int ControlFlow::loopForRow(int row) const
+{
+    auto it = std::upper_bound(loops.begin(), loops.end(), row,
+                               [](int row, const Loop& loop) { return row < loop.firstRow; });
+    // the enclosing loops all start earlier, so one of them is the innermost loop when the last loop that starts
+    // before the row doesn't contain it
+    auto loop = static_cast<int>(std::distance(loops.begin(), it)) - 1;
+    while (loop != -1 && loops.at(loop).lastRow < row) {
+        loop = loops.at(loop).parent;
+    }
+    return loop;
+}
+
+ControlFlow ControlFlow::analyze(const DisassemblyOutput& disassembly)
+{
+    ControlFlow flow;
+
+    const auto& lines = disassembly.disassemblyLines;
+    if (lines.isEmpty()) {
+        return flow;
+    }
+
+    QHash<quint64, int> rows;
+    rows.reserve(lines.size());
+    for (int row = 0, c = lines.size(); row < c; ++row) {
+        if (lines[row].addr && !rows.contains(lines[row].addr)) {
+            rows.insert(lines[row].addr, row);
+        }
+    }
+
+    QVector<bool> startsBlock(lines.size(), false);
+    startsBlock[0] = true;
+    // the first row of every loop mapped to the last row jumping back to it
+    QMap<int, int> loopEnds;
+    for (int row = 0, c = lines.size(); row < c; ++row) {
+        const auto& line = lines[row];
+        if (!line.addr) {
+            continue;
+        }
+
+        const auto branch = parseBranch(line.disassembly);
+        if (!branch.endsBlock) {
+            continue;
+        }
+        if (row + 1 < c) {
+            startsBlock[row + 1] = true;
+        }
+
+        // jumps out of the function, i.e. tail calls, don't matter here
+        const auto targetRow = branch.target ? rows.value(branch.target, -1) : -1;
+        if (targetRow == -1) {
+            continue;
+        }
+        startsBlock[targetRow] = true;
+        if (targetRow <= row) {
+            auto& loopEnd = loopEnds[targetRow];
+            loopEnd = std::max(loopEnd, row);
+        }
+    }
+
+    int firstRow = 0;
+    for (int row = 1, c = lines.size(); row < c; ++row) {
+        if (startsBlock[row]) {
+            flow.blocks.push_back({firstRow, row - 1});
+            firstRow = row;
+        }
+    }
+    flow.blocks.push_back({firstRow, static_cast<int>(lines.size()) - 1});
+
+    // the loops are visited by their first row, so the enclosing loops are on the stack
+    QVector<int> enclosingLoops;
+    for (auto it = loopEnds.cbegin(), end = loopEnds.cend(); it != end; ++it) {
+        while (!enclosingLoops.isEmpty() && flow.loops.at(enclosingLoops.last()).lastRow < it.key()) {
+            enclosingLoops.removeLast();
+        }
+
+        Loop loop;
+        loop.firstRow = it.key();
+        loop.lastRow = it.value();
+        if (!enclosingLoops.isEmpty()) {
+            loop.parent = enclosingLoops.last();
+            loop.depth = flow.loops.at(loop.parent).depth + 1;
+        }
+        enclosingLoops.push_back(static_cast<int>(flow.loops.size()));
+        flow.loops.push_back(loop);
+    }
+
+    return flow;
+}
+
+quint64 ControlFlow::jumpTarget(const QString& disassembly)
+{
+    return parseBranch(disassembly).target;
+}
@@ -0,0 +1,46 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QVector>
+
+struct DisassemblyOutput;
+
+// the control flow within a disassembled function, reconstructed from the targets of its direct jumps
+// everything is expressed in rows of DisassemblyOutput::disassemblyLines
+struct ControlFlow
+{
+    struct BasicBlock
+    {
+        int firstRow = 0;
+        int lastRow = 0;
+    };
+    // ordered by row, the blocks cover all rows
+    QVector<BasicBlock> blocks;
+
+    // a loop starts at the target of a backward jump and ends at the last jump back to it
+    struct Loop
+    {
+        int firstRow = 0;
+        int lastRow = 0;
+        // the enclosing loop or -1
+        int parent = -1;
+        int depth = 0;
+    };
+    // ordered by their first row, so enclosing loops come before the loops nested in them
+    QVector<Loop> loops;
+
+    // the index of the block containing @p row, or -1
+    int blockForRow(int row) const;
+    // the index of the innermost loop containing @p row, or -1
+    int loopForRow(int row) const;
+
+    static ControlFlow analyze(const DisassemblyOutput& disassembly);
+
+    // the target of a direct jump, e.g. "jne 11a0 <main+0x30>", or 0 for any other instruction
+    static quint64 jumpTarget(const QString& disassembly);
+};
@@ -10,6 +10,7 @@
 #include <QDebug>
 #include <QPainter>
 
+#include <algorithm>
 #include <cmath>
 
 CostDelegate::CostDelegate(quint32 sortRole, quint32 totalCostRole, QObject* parent)
@@ -23,15 +24,17 @@ CostDelegate::~CostDelegate() = default;
 
 void CostDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
 {
-    // TODO: handle negative values
-    const auto cost = index.data(m_sortRole).toULongLong();
-    if (cost == 0) {
+    // the deltas of a comparison may be negative, their bars show the magnitude
+    const auto cost = index.data(m_sortRole).toLongLong();
+    // columns without a total, like the derived metrics, don't get a bar
+    const auto totalCost = index.data(m_totalCostRole).toLongLong();
+    if (cost == 0 || totalCost == 0) {
         QStyledItemDelegate::paint(painter, option, index);
         return;
     }
 
-    const auto totalCost = index.data(m_totalCostRole).toULongLong();
-    const auto fraction = std::abs(float(cost) / totalCost);
+    // a delta can exceed the total cost of the baseline
+    const auto fraction = std::min(1.f, std::abs(float(cost) / totalCost));
 
     auto rect = option.rect;
     rect.setWidth(rect.width() * fraction);
@@ -11,9 +11,10 @@
 #include <QSortFilterProxyModel>
 
 #include "callercalleeproxy.h"
+#include "data.h"
 
 template<typename Model>
-class CostProxy : public QSortFilterProxyModel
+class CostProxy : public QSortFilterProxyModel, public CallerCalleeProxyDetail::SymbolSearch
 {
 public:
     explicit CostProxy(QObject* parent = nullptr)
@@ -23,6 +24,14 @@ public:
         setDynamicSortFilter(true);
     }
 
+    // the tree models sort themselves, see TreeModel::sort, so the proxy only filters and keeps their order
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override
+    {
+        if (auto* model = sourceModel()) {
+            model->sort(column, order);
+        }
+    }
+
 protected:
     bool filterAcceptsRow(int source_row, const QModelIndex& parent) const override
     {
@@ -36,6 +45,29 @@ protected:
             return false;
         }
 
-        return CallerCalleeProxyDetail::match(this, item->symbol);
+        return m_matcher.match(this, item->symbol);
+    }
+
+    std::function<QVector<Data::Symbol>()> symbolCollector() const override
+    {
+        const auto* model = qobject_cast<Model*>(sourceModel());
+        Q_ASSERT(model);
+
+        // the results are implicitly shared, so the snapshot is cheap and stays valid while the model changes
+        return [results = model->results()]() {
+            QVector<Data::Symbol> symbols;
+            collectSymbols(results.root, &symbols);
+            return symbols;
+        };
+    }
+
+private:
+    template<typename Tree>
+    static void collectSymbols(const Tree& tree, QVector<Data::Symbol>* symbols)
+    {
+        for (const auto& child : tree.children) {
+            symbols->push_back(child.symbol);
+            collectSymbols(child, symbols);
+        }
     }
 };
@@ -7,49 +7,138 @@
 
 #include "data.h"
 
+#include <QCoreApplication>
 #include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QReadWriteLock>
 #include <QSet>
+#include <QStringList>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <numeric>
+#include <optional>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 using namespace Data;
 
 namespace {
 
-ItemCost buildTopDownResult(const BottomUp& bottomUpData, const Costs& bottomUpCosts, TopDown* topDownData,
-                            Costs* inclusiveCosts, Costs* selfCosts, quint32* maxId, bool skipFirstLevel)
+// an estimate of the nodes and buckets of @p hash, plus what @p valueUsage reports for the nested allocations
+template<typename Key, typename Value, typename ValueUsage>
+qint64 hashMemoryUsage(const QHash<Key, Value>& hash, ValueUsage&& valueUsage)
 {
-    ItemCost totalCost;
-    totalCost.resize(bottomUpCosts.numTypes(), 0);
-    for (const auto& row : bottomUpData.children) {
-        // recurse and find the cost attributed to children
-        const auto childCost =
-            buildTopDownResult(row, bottomUpCosts, topDownData, inclusiveCosts, selfCosts, maxId, skipFirstLevel);
-        const auto rowCost = bottomUpCosts.itemCost(row.id);
-        const auto diff = rowCost - childCost;
-        if (diff.sum() != 0) {
-            // this row is (partially) a leaf
-            // bubble up the parent chain to build a top-down tree
-            auto node = &row;
-            auto stack = topDownData;
-            while (node) {
-                auto frame = stack->entryForSymbol(node->symbol, maxId);
-
-                const auto isLastNode = !node->parent || (skipFirstLevel && !node->parent->parent);
-
-                // always use the leaf node's cost and propagate that one up the chain
-                // otherwise we'd count the cost of some nodes multiple times
-                inclusiveCosts->add(frame->id, diff);
-                if (isLastNode) {
-                    selfCosts->add(frame->id, diff);
-                    break;
-                }
+    qint64 usage = hash.capacity() * sizeof(void*) + hash.size() * (sizeof(Key) + sizeof(Value) + 2 * sizeof(void*));
+    for (const auto& value : hash) {
+        usage += valueUsage(value);
+    }
+    return usage;
+}
+
+qint64 itemCostMemoryUsage(const ItemCost& cost)
+{
+    return cost.size() * sizeof(qint64);
+}
+
+qint64 locationCostMemoryUsage(const LocationCost& cost)
+{
+    return itemCostMemoryUsage(cost.selfCost) + itemCostMemoryUsage(cost.inclusiveCost);
+}
+
+// the sum doesn't do, the deltas of a comparison may cancel each other out
+bool isZero(const ItemCost& cost)
+{
+    return std::all_of(std::begin(cost), std::end(cost), [](qint64 value) { return value == 0; });
+}
 
-                stack = frame;
-                node = node->parent;
+// adds the leaf costs of the subtree of @p row to the top down tree, by bubbling up the parent chain of every leaf
+void buildTopDownResult(const BottomUp& row, const Costs& bottomUpCosts, TopDown* topDownData, Costs* inclusiveCosts,
+                        Costs* selfCosts, quint32* maxId, bool skipFirstLevel)
+{
+    // visit the rows in post order, like a recursion would, but without risking a stack overflow for deep stacks
+    struct Pending
+    {
+        const BottomUp* node;
+        int nextChild;
+    };
+    QVector<Pending> pending = {{&row, 0}};
+    ItemCost childCost;
+    while (!pending.isEmpty()) {
+        auto& top = pending.last();
+        if (top.nextChild < top.node->children.size()) {
+            const auto* child = &top.node->children.at(top.nextChild++);
+            pending.push_back({child, 0});
+            continue;
+        }
+        const auto* node = top.node;
+        pending.removeLast();
+
+        // find the cost attributed to children
+        childCost.resize(bottomUpCosts.numTypes(), 0);
+        for (const auto& child : node->children) {
+            childCost += bottomUpCosts.itemCost(child.id);
+        }
+        const auto rowCost = bottomUpCosts.itemCost(node->id);
+        // the valarray operators are lazy, evaluate the difference once instead of on every add below
+        const ItemCost diff = rowCost - childCost;
+        if (isZero(diff)) {
+            continue;
+        }
+
+        // this row is (partially) a leaf
+        // bubble up the parent chain to build a top-down tree
+        auto stack = topDownData;
+        while (node) {
+            auto frame = stack->entryForSymbol(node->symbol, maxId);
+
+            const auto isLastNode = !node->parent || (skipFirstLevel && !node->parent->parent);
+
+            // always use the leaf node's cost and propagate that one up the chain
+            // otherwise we'd count the cost of some nodes multiple times
+            inclusiveCosts->add(frame->id, diff);
+            if (isLastNode) {
+                selfCosts->add(frame->id, diff);
+                break;
             }
+
+            stack = frame;
+            node = node->parent;
+        }
+    }
+}
+
+// adds the top level bottom up rows in [begin, end) to @p results
+void buildTopDownSubtrees(const BottomUpResults& bottomUpData, bool skipFirstLevel, int begin, int end,
+                          TopDownResults* results)
+{
+    quint32 maxId = 0;
+    for (int i = begin; i < end; ++i) {
+        const auto& bottomUpRow = bottomUpData.root.children.at(i);
+        if (!skipFirstLevel) {
+            buildTopDownResult(bottomUpRow, bottomUpData.costs, &results->root, &results->inclusiveCosts,
+                               &results->selfCosts, &maxId, false);
+            continue;
+        }
+        // manually copy the first level
+        auto topDownGroup = results->root.entryForSymbol(bottomUpRow.symbol, &maxId);
+        // then traverse the children as separate trees basically
+        for (const auto& child : bottomUpRow.children) {
+            buildTopDownResult(child, bottomUpData.costs, topDownGroup, &results->inclusiveCosts,
+                               &results->selfCosts, &maxId, true);
+        }
+        // finally manually sum up the inclusive costs
+        for (const auto& child : std::as_const(topDownGroup->children)) {
+            results->inclusiveCosts.add(topDownGroup->id, results->inclusiveCosts.itemCost(child.id));
         }
-        totalCost += rowCost;
     }
-    return totalCost;
 }
 
 void add(ItemCost& lhs, const ItemCost& rhs)
@@ -62,61 +151,126 @@ void add(ItemCost& lhs, const ItemCost& rhs)
     }
 }
 
-ItemCost buildCallerCalleeResult(const BottomUp& data, const Costs& bottomUpCosts, CallerCalleeResults* results)
+ItemCost buildCallerCalleeResult(const BottomUp& data, const Costs& bottomUpCosts, CallerCalleeResults* results,
+                                 RecursionGuard* recursionGuard);
+
+// returns the inclusive cost of @p row
+ItemCost buildCallerCalleeRow(const BottomUp& row, const Costs& bottomUpCosts, CallerCalleeResults* results,
+                              RecursionGuard* recursionGuard)
+{
+    // recurse to find a leaf
+    const auto childCost = buildCallerCalleeResult(row, bottomUpCosts, results, recursionGuard);
+    const auto rowCost = bottomUpCosts.itemCost(row.id);
+    // the valarray operators are lazy, evaluate the difference once instead of on every add below
+    const ItemCost diff = rowCost - childCost;
+    if (!isZero(diff)) {
+        // this row is (partially) a leaf
+
+        // leaf node found, bubble up the parent chain to add cost for all frames
+        // to the caller/callee data. this is done top-down since we must not count
+        // symbols more than once in the caller-callee data
+        recursionGuard->reset();
+        auto node = &row;
+
+        Data::Symbol lastSymbol;
+        Data::CallerCalleeEntry* lastEntry = nullptr;
+
+        while (node) {
+            const auto& symbol = node->symbol;
+            // aggregate caller-callee data
+            auto& entry = results->entry(symbol);
+
+            if (recursionGuard->insert(symbol)) {
+                // only increment inclusive cost once for a given stack
+                results->inclusiveCosts.add(entry.id, diff);
+            }
+            if (!node->parent) {
+                // always increment the self cost
+                results->selfCosts.add(entry.id, diff);
+            }
+            // add current entry as callee to last entry
+            // and last entry as caller to current entry
+            if (lastEntry && recursionGuard->insertCall(symbol, lastSymbol)) {
+                add(lastEntry->callee(symbol, bottomUpCosts.numTypes()), diff);
+                add(entry.caller(lastSymbol, bottomUpCosts.numTypes()), diff);
+            }
+
+            node = node->parent;
+            lastSymbol = symbol;
+            lastEntry = &entry;
+        }
+    }
+    return rowCost;
+}
+
+ItemCost buildCallerCalleeResult(const BottomUp& data, const Costs& bottomUpCosts, CallerCalleeResults* results,
+                                 RecursionGuard* recursionGuard)
 {
     ItemCost totalCost;
     totalCost.resize(bottomUpCosts.numTypes(), 0);
     for (const auto& row : data.children) {
-        // recurse to find a leaf
-        const auto childCost = buildCallerCalleeResult(row, bottomUpCosts, results);
-        const auto rowCost = bottomUpCosts.itemCost(row.id);
-        const auto diff = rowCost - childCost;
-        if (diff.sum() != 0) {
-            // this row is (partially) a leaf
-
-            // leaf node found, bubble up the parent chain to add cost for all frames
-            // to the caller/callee data. this is done top-down since we must not count
-            // symbols more than once in the caller-callee data
-            QSet<Symbol> recursionGuard;
-            auto node = &row;
-
-            QSet<QPair<Symbol, Symbol>> callerCalleeRecursionGuard;
-            Data::Symbol lastSymbol;
-            Data::CallerCalleeEntry* lastEntry = nullptr;
-
-            while (node) {
-                const auto& symbol = node->symbol;
-                // aggregate caller-callee data
-                auto& entry = results->entry(symbol);
-
-                if (!recursionGuard.contains(symbol)) {
-                    // only increment inclusive cost once for a given stack
-                    results->inclusiveCosts.add(entry.id, diff);
-                    recursionGuard.insert(symbol);
-                }
-                if (!node->parent) {
-                    // always increment the self cost
-                    results->selfCosts.add(entry.id, diff);
-                }
-                // add current entry as callee to last entry
-                // and last entry as caller to current entry
-                if (lastEntry) {
-                    const auto callerCalleePair = qMakePair(symbol, lastSymbol);
-                    if (!callerCalleeRecursionGuard.contains(callerCalleePair)) {
-                        add(lastEntry->callee(symbol, bottomUpCosts.numTypes()), diff);
-                        add(entry.caller(lastSymbol, bottomUpCosts.numTypes()), diff);
-                        callerCalleeRecursionGuard.insert(callerCalleePair);
-                    }
-                }
+        totalCost += buildCallerCalleeRow(row, bottomUpCosts, results, recursionGuard);
+    }
+    return totalCost;
+}
+
+void mergeBottomUp(const BottomUp& source, const Costs& sourceCosts, BottomUp* target, Costs* targetCosts,
+                   quint32* maxId)
+{
+    for (const auto& sourceChild : source.children) {
+        auto targetChild = target->entryForSymbol(sourceChild.symbol, maxId);
+        targetCosts->add(targetChild->id, sourceCosts.itemCostView(sourceChild.id));
+        mergeBottomUp(sourceChild, sourceCosts, targetChild, targetCosts, maxId);
+    }
+}
+
+// the paths of the binaries differ between the hosts of the captures, so they don't identify a symbol
+// the relative address and size still tell apart the builds of a binary
+Symbol captureSymbol(const Symbol& symbol)
+{
+    return internSymbol({symbol.symbol, symbol.relAddr, symbol.size, symbol.binary, {}, {}, symbol.isKernel,
+                         symbol.isInline});
+}
 
-                node = node->parent;
-                lastSymbol = symbol;
-                lastEntry = &entry;
+// like mergeBottomUp, but for the tree of another capture whose cost types are at @p types in the target
+// iterative, as the stacks of a capture may be deeper than the call stack allows recursing into
+void mergeCaptureBottomUp(const BottomUp& source, const Costs& sourceCosts, const QVector<int>& types,
+                          BottomUp* target, Costs* targetCosts, quint32* maxId)
+{
+    QVector<std::pair<const BottomUp*, BottomUp*>> pending = {{&source, target}};
+    QVector<int> rows;
+    while (!pending.isEmpty()) {
+        const auto [sourceNode, targetNode] = pending.takeLast();
+        // adding a child may reallocate the children of the target, so the pointers are taken afterwards
+        rows.clear();
+        for (const auto& sourceChild : sourceNode->children) {
+            const auto* targetChild = targetNode->entryForSymbol(captureSymbol(sourceChild.symbol), maxId);
+            for (int type = 0, c = types.size(); type < c; ++type) {
+                targetCosts->add(types[type], targetChild->id, sourceCosts.cost(type, sourceChild.id));
             }
+            rows.push_back(static_cast<int>(targetChild - targetNode->children.constData()));
+        }
+        for (int i = 0, c = rows.size(); i < c; ++i) {
+            pending.push_back({&sourceNode->children[i], &targetNode->children[rows[i]]});
         }
-        totalCost += rowCost;
     }
-    return totalCost;
+}
+
+template<typename Key>
+void mergeLocationCosts(QHash<Key, LocationCost>* target, const QHash<Key, LocationCost>& source)
+{
+    for (auto it = source.begin(), end = source.end(); it != end; ++it) {
+        auto& cost = (*target)[it.key()];
+        add(cost.selfCost, it->selfCost);
+        add(cost.inclusiveCost, it->inclusiveCost);
+    }
+}
+
+void mergeSymbolCosts(SymbolCostMap* target, const SymbolCostMap& source)
+{
+    for (auto it = source.begin(), end = source.end(); it != end; ++it) {
+        add((*target)[it.key()], it.value());
+    }
 }
 
 int findSameDepth(QStringView str, int offset, QChar ch, bool returnNext = false)
@@ -258,11 +412,55 @@ QString prettifySymbol(QStringView str)
     return result;
 }
 
-void buildPerLibrary(const TopDown* node, PerLibraryResults& results, QHash<QString, int>& pathToResultIndex,
-                     const Costs& costs)
+// the ids are unique per process, so symbols from different captures can still be compared as long as they got
+// interned under the same leases, see SymbolTableLease
+struct SymbolTable
+{
+    QMutex mutex;
+    QHash<Symbol, qint32> ids;
+    // keeps counting when the table gets cleared
+    qint32 nextId = 0;
+    // the value of nextId when the table got cleared last, see Data::firstInternId
+    std::atomic<qint32> firstId {0};
+    int numLeases = 0;
+    // the binaries and paths of the interned symbols, many symbols share them
+    QSet<QString> strings;
+    // by id, only computed once somebody asks for it. the views and the aggregation ask for them all the time, so
+    // they have a lock of their own that only gets locked for writing when a name is missing
+    QReadWriteLock prettySymbolsLock;
+    QHash<qint32, QString> prettySymbols;
+
+    QString sharedString(const QString& string)
+    {
+        if (string.isEmpty()) {
+            return string;
+        }
+        auto it = strings.constFind(string);
+        if (it == strings.constEnd()) {
+            it = strings.insert(string);
+        }
+        return *it;
+    }
+};
+
+SymbolTable& symbolTable()
+{
+    static SymbolTable table;
+    return table;
+}
+
+// adds the self costs of the top down rows in [begin, end) of @p node and all their descendants to their libraries
+void buildPerLibrary(const TopDown* node, int begin, int end, PerLibraryResults& results,
+                     QHash<QString, int>& pathToResultIndex, const Costs& costs)
 {
-    for (const auto& child : node->children) {
-        const auto path = child.symbol.path;
+    // iterative, as a recursion could overflow the thread stack for deep stacks
+    QVector<const TopDown*> pending;
+    for (int i = end - 1; i >= begin; --i) {
+        pending.push_back(&node->children.at(i));
+    }
+    while (!pending.isEmpty()) {
+        const auto* child = pending.takeLast();
+        const auto path = child->symbol.path;
 
         auto resultIndexIt = pathToResultIndex.find(path);
         if (resultIndexIt == pathToResultIndex.end()) {
@@ -270,131 +468,1758 @@ void buildPerLibrary(const TopDown* node, PerLibraryResults& results, QHash<QStr
 
             PerLibrary library;
             library.id = *resultIndexIt;
-            library.symbol = Symbol({}, 0, 0, child.symbol.binary, child.symbol.path, child.symbol.actualPath,
-                                    child.symbol.isKernel);
+            library.symbol = Symbol({}, 0, 0, child->symbol.binary, child->symbol.path, child->symbol.actualPath,
+                                    child->symbol.isKernel);
             results.root.children.push_back(library);
         }
 
-        const auto cost = costs.itemCost(child.id);
-        results.costs.add(*resultIndexIt, cost);
+        results.costs.add(*resultIndexIt, costs.itemCostView(child->id));
 
-        buildPerLibrary(&child, results, pathToResultIndex, costs);
+        // in reverse, to visit the children in order, just like the recursion did
+        for (auto it = child->children.crbegin(), rend = child->children.crend(); it != rend; ++it) {
+            pending.push_back(&*it);
+        }
     }
 }
-}
 
-QString Data::prettifySymbol(const QString& name)
+// marks the @p numEntries items with the highest cost of every type in @p selected
+// a bounded min-heap keeps this at O(n log numEntries), instead of sorting all n items
+void selectTopItems(const Costs& costs, int numItems, int numEntries, QVector<bool>* selected)
 {
-    const auto result = ::prettifySymbol(QStringView(name));
-    return result == name ? name : result;
+    using Entry = std::pair<qint64, int>;
+    std::vector<Entry> heap;
+    heap.reserve(numEntries);
+    // prefers the lower index for equal costs, which keeps the selection stable
+    auto cheaper = [](const Entry& lhs, const Entry& rhs) {
+        return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+    };
+
+    for (int type = 0, numTypes = costs.numTypes(); type < numTypes; ++type) {
+        heap.clear();
+        for (int item = 0; item < numItems; ++item) {
+            const Entry entry = {costs.cost(type, item), item};
+            if (entry.first <= 0) {
+                continue;
+            } else if (heap.size() < static_cast<std::size_t>(numEntries)) {
+                heap.push_back(entry);
+                std::push_heap(heap.begin(), heap.end(), cheaper);
+            } else if (cheaper(entry, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), cheaper);
+                heap.back() = entry;
+                std::push_heap(heap.begin(), heap.end(), cheaper);
+            }
+        }
+        for (const auto& entry : heap) {
+            (*selected)[entry.second] = true;
+        }
+    }
+}
 }
 
-TopDownResults TopDownResults::fromBottomUp(const BottomUpResults& bottomUpData, bool skipFirstLevel)
+// one unlinked file in the spill directory, which all the spilled buffers map their own range of
+// this keeps the number of open files down, no matter how many threads and columns a capture has
+class Data::SpillFile
 {
-    TopDownResults results;
-    results.selfCosts.initializeCostsFrom(bottomUpData.costs);
-    results.inclusiveCosts.initializeCostsFrom(bottomUpData.costs);
-    quint32 maxId = 0;
-    if (skipFirstLevel) {
-        results.root.children.reserve(bottomUpData.root.children.size());
-        for (const auto& bottomUpGroup : bottomUpData.root.children) {
-            // manually copy the first level
-            auto topDownGroup = results.root.entryForSymbol(bottomUpGroup.symbol, &maxId);
-            // then traverse the children as separate trees basically
-            buildTopDownResult(bottomUpGroup, bottomUpData.costs, topDownGroup, &results.inclusiveCosts,
-                               &results.selfCosts, &maxId, true);
-            // finally manually sum up the inclusive costs
-            for (const auto& child : std::as_const(topDownGroup->children)) {
-                results.inclusiveCosts.add(topDownGroup->id, results.inclusiveCosts.itemCost(child.id));
+public:
+    explicit SpillFile(int fd)
+        : m_fd(fd)
+    {
+    }
+
+    ~SpillFile()
+    {
+        close(m_fd);
+    }
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    // maps @p size bytes at the end of the file, returns nullptr when that fails
+    char* map(qint64 size, qint64* offset)
+    {
+        static const qint64 pageSize = sysconf(_SC_PAGESIZE);
+        const auto alignedSize = (size + pageSize - 1) / pageSize * pageSize;
+
+        QMutexLocker lock(&m_mutex);
+        void* data = MAP_FAILED;
+        if (ftruncate(m_fd, m_size + alignedSize) == 0) {
+            data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, m_size);
+        }
+        if (data == MAP_FAILED) {
+            if (!m_failed) {
+                qWarning() << "failed to map the file in the spill directory" << strerror(errno);
+                m_failed = true;
             }
+            return nullptr;
         }
-    } else {
-        buildTopDownResult(bottomUpData.root, bottomUpData.costs, &results.root, &results.inclusiveCosts,
-                           &results.selfCosts, &maxId, false);
+        *offset = m_size;
+        m_size += alignedSize;
+        return static_cast<char*>(data);
     }
-    TopDown::initializeParents(&results.root);
-    return results;
+
+    void unmap(char* data, qint64 size, qint64 offset)
+    {
+        munmap(data, size);
+        // the ranges don't get reused, instead the disk space of the range is given back right away
+        fallocate(m_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, size);
+    }
+
+private:
+    const int m_fd;
+    QMutex m_mutex;
+    qint64 m_size = 0;
+    // to only warn once
+    bool m_failed = false;
+};
+
+QString Data::SpillDirectory::path() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_path;
 }
 
-PerLibraryResults PerLibraryResults::fromTopDown(const TopDownResults& topDownData)
+void Data::SpillDirectory::setPath(const QString& path)
 {
-    PerLibraryResults results;
-    QHash<QString, int> pathToResultIndex;
-    results.costs.initializeCostsFrom(topDownData.selfCosts);
+    QMutexLocker lock(&m_mutex);
+    m_path = path;
+    m_file.reset();
+    m_failed = false;
+}
 
-    buildPerLibrary(&topDownData.root, results, pathToResultIndex, topDownData.selfCosts);
+std::shared_ptr<Data::SpillFile> Data::SpillDirectory::file()
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_file || m_path.isEmpty() || m_failed) {
+        return m_file;
+    }
 
-    PerLibrary::initializeParents(&results.root);
+    auto pattern = QFile::encodeName(m_path + QLatin1String("/hotspot-events-XXXXXX"));
+    const auto fd = mkstemp(pattern.data());
+    if (fd == -1) {
+        qWarning() << "failed to create a file in the spill directory" << m_path << strerror(errno);
+        m_failed = true;
+        return {};
+    }
+    unlink(pattern.constData());
+    m_file = std::make_shared<Data::SpillFile>(fd);
+    return m_file;
+}
 
-    return results;
+namespace {
+Data::SpillDirectory& globalSpillDirectory()
+{
+    static Data::SpillDirectory directory;
+    return directory;
 }
 
-void Data::callerCalleesFromBottomUpData(const BottomUpResults& bottomUpData, CallerCalleeResults* results)
+// see ScopedSpillDirectory
+thread_local Data::SpillDirectory* currentSpillDirectory = nullptr;
+
+std::shared_ptr<Data::SpillFile> spillFile()
 {
-    results->inclusiveCosts.initializeCostsFrom(bottomUpData.costs);
-    results->selfCosts.initializeCostsFrom(bottomUpData.costs);
-    buildCallerCalleeResult(bottomUpData.root, bottomUpData.costs, results);
+    if (currentSpillDirectory) {
+        if (auto file = currentSpillDirectory->file()) {
+            return file;
+        }
+    }
+    return globalSpillDirectory().file();
+}
 }
 
-QDebug Data::operator<<(QDebug stream, const Symbol& symbol)
+void Data::setSpillDirectory(const QString& path)
 {
-    stream.noquote().nospace() << "Symbol{"
-                               << "symbol=" << symbol.symbol << ", "
-                               << "relAddr=" << symbol.relAddr << ", "
-                               << "size=" << symbol.size << ", "
-                               << "binary=" << symbol.binary << "}";
-    return stream.resetFormat().space();
+    globalSpillDirectory().setPath(path);
 }
 
-QDebug Data::operator<<(QDebug stream, const FileLine& fileLine)
+QString Data::spillDirectory()
 {
-    stream.noquote().nospace() << "FileLine{"
-                               << "file=" << fileLine.file << ", "
-                               << "line=" << fileLine.line << "}";
-    return stream.resetFormat().space();
+    return globalSpillDirectory().path();
 }
 
-QDebug Data::operator<<(QDebug stream, const Location& location)
+Data::ScopedSpillDirectory::ScopedSpillDirectory(SpillDirectory* directory)
+    : m_previous(std::exchange(currentSpillDirectory, directory))
 {
-    stream.noquote().nospace() << "Location{"
-                               << "address=" << location.address << ", "
-                               << "relAddr=" << location.relAddr << ", "
-                               << "fileLine=" << location.fileLine << "}";
-    return stream.resetFormat().space();
 }
 
-QDebug Data::operator<<(QDebug stream, const ItemCost& cost)
+Data::ScopedSpillDirectory::~ScopedSpillDirectory()
 {
-    stream.noquote().nospace() << "ItemCost(" << cost.size() << "){";
-    for (auto c : cost) {
-        stream << c << ",";
+    currentSpillDirectory = m_previous;
+}
+
+ColumnBuffer::ColumnBuffer(qint64 capacity)
+{
+    if (!map(capacity)) {
+        m_data = static_cast<char*>(std::malloc(capacity));
+        Q_CHECK_PTR(m_data);
+        m_capacity = capacity;
     }
-    stream << "}";
-    return stream.resetFormat().space();
 }
 
-QDebug Data::operator<<(QDebug stream, const CostSummary& cost)
+ColumnBuffer::~ColumnBuffer()
 {
-    stream.noquote().nospace() << "CostSummary{"
-                               << "label = " << cost.label << ", "
-                               << "sampleCount = " << cost.sampleCount << ", "
-                               << "totalPeriod = " << cost.totalPeriod << "}";
-    return stream.resetFormat().space();
+    release();
 }
 
-Data::ThreadEvents* Data::EventResults::findThread(qint32 pid, qint32 tid)
+void ColumnBuffer::grow(qint64 capacity)
 {
-    for (int i = threads.size() - 1; i >= 0; --i) {
-        auto& thread = threads[i];
-        if (thread.pid == pid && thread.tid == tid) {
-            return &thread;
+    if (capacity <= m_capacity) {
+        return;
+    }
+
+    // a heap buffer moves over to the spill directory once it is large enough or when the spill directory got set
+    // after it was allocated, see MemoryUsage
+    auto* oldData = m_data;
+    const auto oldCapacity = m_capacity;
+    auto oldFile = std::move(m_file);
+    const auto oldOffset = m_offset;
+    if (map(capacity)) {
+        std::memcpy(m_data, oldData, oldCapacity);
+        if (oldFile) {
+            oldFile->unmap(oldData, oldCapacity, oldOffset);
+        } else {
+            std::free(oldData);
         }
+        return;
     }
 
-    return nullptr;
+    if (oldFile) {
+        // the spill directory got unset or the file can't grow anymore
+        m_data = static_cast<char*>(std::malloc(capacity));
+        Q_CHECK_PTR(m_data);
+        std::memcpy(m_data, oldData, oldCapacity);
+        oldFile->unmap(oldData, oldCapacity, oldOffset);
+    } else {
+        m_data = static_cast<char*>(std::realloc(oldData, capacity));
+        Q_CHECK_PTR(m_data);
+    }
+    m_capacity = capacity;
 }
 
-const Data::ThreadEvents* Data::EventResults::findThread(qint32 pid, qint32 tid) const
+bool ColumnBuffer::map(qint64 capacity)
 {
-    return const_cast<Data::EventResults*>(this)->findThread(pid, tid);
+    if (capacity < MinSpilledCapacity) {
+        return false;
+    }
+    auto file = spillFile();
+    if (!file) {
+        return false;
+    }
+    auto* data = file->map(capacity, &m_offset);
+    if (!data) {
+        return false;
+    }
+    m_file = std::move(file);
+    m_data = data;
+    m_capacity = capacity;
+    return true;
+}
+
+void ColumnBuffer::release()
+{
+    if (m_file) {
+        m_file->unmap(m_data, m_capacity, m_offset);
+        m_file.reset();
+    } else {
+        std::free(m_data);
+    }
+    m_data = nullptr;
+}
+
+QString Data::prettifySymbol(const QString& name)
+{
+    const auto result = ::prettifySymbol(QStringView(name));
+    return result == name ? name : result;
+}
+
+qint32 Data::firstInternId()
+{
+    return symbolTable().firstId.load(std::memory_order_relaxed);
+}
+
+Symbol Data::internSymbol(const Symbol& symbol)
+{
+    if (symbol.internId != -1) {
+        return symbol;
+    }
+
+    auto interned = symbol;
+    interned.internHash = symbol.identityHash();
+
+    auto& table = symbolTable();
+    QMutexLocker lock(&table.mutex);
+    auto it = table.ids.constFind(symbol);
+    if (it == table.ids.constEnd()) {
+        auto key = symbol;
+        key.binary = table.sharedString(symbol.binary);
+        key.path = table.sharedString(symbol.path);
+        key.actualPath = table.sharedString(symbol.actualPath);
+        it = table.ids.insert(key, table.nextId++);
+    }
+    // share the strings of the first equal symbol, so the copies don't keep their own
+    interned.symbol = it.key().symbol;
+    interned.binary = it.key().binary;
+    interned.path = it.key().path;
+    interned.actualPath = it.key().actualPath;
+    interned.internId = it.value();
+    return interned;
+}
+
+QString Symbol::prettySymbol() const
+{
+    if (internId == -1) {
+        return Data::prettifySymbol(symbol);
+    }
+
+    auto& table = symbolTable();
+    {
+        QReadLocker lock(&table.prettySymbolsLock);
+        const auto it = table.prettySymbols.constFind(internId);
+        if (it != table.prettySymbols.constEnd()) {
+            return *it;
+        }
+    }
+
+    // prettifying runs without the lock, should two threads do it for the same symbol they get the same result
+    const auto prettySymbol = Data::prettifySymbol(symbol);
+    QWriteLocker lock(&table.prettySymbolsLock);
+    table.prettySymbols.insert(internId, prettySymbol);
+    return prettySymbol;
+}
+
+SymbolTableLease::SymbolTableLease()
+{
+    auto& table = symbolTable();
+    QMutexLocker lock(&table.mutex);
+    if (table.numLeases++ == 0) {
+        table.ids.clear();
+        table.firstId.store(table.nextId, std::memory_order_relaxed);
+        table.strings.clear();
+        QWriteLocker prettySymbolsLock(&table.prettySymbolsLock);
+        table.prettySymbols.clear();
+    }
+}
+
+SymbolTableLease::~SymbolTableLease()
+{
+    auto& table = symbolTable();
+    QMutexLocker lock(&table.mutex);
+    --table.numLeases;
+}
+
+DerivedMetrics::DerivedMetrics(const QStringList& definitions, const Costs& costs)
+{
+    auto findType = [&costs](const QString& event) {
+        for (int type = 0, c = costs.numTypes(); type < c; ++type) {
+            if (matchesEvent(costs.typeName(type), event)) {
+                return type;
+            }
+        }
+        return -1;
+    };
+
+    for (const auto& definition : definitions) {
+        const auto labelEnd = definition.indexOf(QLatin1Char('='));
+        const auto ratio = definition.mid(labelEnd + 1).split(QLatin1Char('/'));
+        if (labelEnd <= 0 || ratio.size() != 2) {
+            continue;
+        }
+        const Metric metric = {definition.left(labelEnd).trimmed(), findType(ratio[0].trimmed()),
+                               findType(ratio[1].trimmed())};
+        if (metric.numerator != -1 && metric.denominator != -1) {
+            m_metrics.push_back(metric);
+        }
+    }
+
+    // the deltas of a comparison relative to their baseline, see BottomUpResults::compareCaptures
+    for (int type = 0, c = costs.numTypes(); type < c; ++type) {
+        const auto baselineType = costs.baselineType(type);
+        if (baselineType != -1) {
+            const auto label = QCoreApplication::translate("Data", "%1 / %2")
+                                   .arg(costs.typeName(type), costs.typeName(baselineType));
+            m_metrics.push_back({label, type, baselineType});
+        }
+    }
+
+    const auto numMetrics = m_metrics.size();
+    if (!numMetrics) {
+        return;
+    }
+
+    for (const auto& metric : std::as_const(m_metrics)) {
+        m_totalValues.push_back(ratio(costs.totalCost(metric.numerator), costs.totalCost(metric.denominator)));
+    }
+
+    const auto numItems = costs.numItems();
+    m_values.resize(static_cast<qsizetype>(numItems) * numMetrics);
+    auto* values = m_values.data();
+    for (quint32 id = 0; id < numItems; ++id) {
+        const auto cost = costs.itemCostView(id);
+        for (int i = 0; i < numMetrics; ++i) {
+            const auto& metric = m_metrics[i];
+            *values++ = ratio(cost[metric.numerator], cost[metric.denominator]);
+        }
+    }
+}
+
+QString DerivedMetrics::format(double value)
+{
+    return std::isnan(value) ? QString() : QString::number(value, 'f', 3);
+}
+
+bool DerivedMetrics::matchesEvent(const QString& typeName, const QString& event)
+{
+    // strip the modifiers, i.e. "cycles:u" -> "cycles"
+    auto name = QStringView(typeName);
+    name = name.left(name.indexOf(QLatin1Char(':')));
+    // strip the PMU, i.e. "cpu_core/cycles/" -> "cycles"
+    if (name.endsWith(QLatin1Char('/'))) {
+        name.chop(1);
+        name = name.mid(name.indexOf(QLatin1Char('/')) + 1);
+    }
+    return name.compare(event) == 0;
+}
+
+TopDownResults TopDownResults::fromBottomUp(const BottomUpResults& bottomUpData, bool skipFirstLevel)
+{
+    auto results = fromBottomUpSubtrees(bottomUpData, skipFirstLevel, 0, bottomUpData.root.children.size());
+    TopDown::initializeParents(&results.root);
+    return results;
+}
+
+TopDownResults TopDownResults::fromBottomUpSubtrees(const BottomUpResults& bottomUpData, bool skipFirstLevel,
+                                                    int begin, int end)
+{
+    TopDownResults results;
+    results.selfCosts.initializeCostsFrom(bottomUpData.costs);
+    results.inclusiveCosts.initializeCostsFrom(bottomUpData.costs);
+    if (skipFirstLevel) {
+        results.root.children.reserve(end - begin);
+    }
+    buildTopDownSubtrees(bottomUpData, skipFirstLevel, begin, end, &results);
+    return results;
+}
+
+void TopDownResults::merge(const TopDownResults& other)
+{
+    // the ids are dense, so the new entries continue after the existing ones
+    quint32 maxId = 0;
+    QVector<const TopDown*> nodes = {&root};
+    while (!nodes.isEmpty()) {
+        const auto* node = nodes.takeLast();
+        maxId += node->children.size();
+        for (const auto& child : node->children) {
+            nodes.push_back(&child);
+        }
+    }
+
+    QVector<std::pair<TopDown*, const TopDown*>> pending = {{&root, &other.root}};
+    QVector<int> rows;
+    while (!pending.isEmpty()) {
+        const auto next = pending.takeLast();
+        auto* target = next.first;
+        const auto& sourceChildren = next.second->children;
+
+        // adding entries may reallocate the children, so only take their addresses once all got added
+        rows.clear();
+        for (const auto& sourceChild : sourceChildren) {
+            const auto* targetChild = target->entryForSymbol(sourceChild.symbol, &maxId);
+            inclusiveCosts.add(targetChild->id, other.inclusiveCosts.itemCostView(sourceChild.id));
+            selfCosts.add(targetChild->id, other.selfCosts.itemCostView(sourceChild.id));
+            rows.push_back(static_cast<int>(targetChild - target->children.constData()));
+        }
+        for (int i = 0, c = sourceChildren.size(); i < c; ++i) {
+            pending.push_back({target->children.data() + rows.at(i), &sourceChildren.at(i)});
+        }
+    }
+}
+
+PerLibraryResults PerLibraryResults::fromTopDown(const TopDownResults& topDownData)
+{
+    auto results = fromTopDownSubtrees(topDownData, 0, topDownData.root.children.size());
+    PerLibrary::initializeParents(&results.root);
+    return results;
+}
+
+PerLibraryResults PerLibraryResults::fromTopDownSubtrees(const TopDownResults& topDownData, int begin, int end)
+{
+    PerLibraryResults results;
+    QHash<QString, int> pathToResultIndex;
+    results.costs.initializeCostsFrom(topDownData.selfCosts);
+
+    buildPerLibrary(&topDownData.root, begin, end, results, pathToResultIndex, topDownData.selfCosts);
+
+    return results;
+}
+
+void PerLibraryResults::merge(const PerLibraryResults& other)
+{
+    // the libraries are identified by their path, and their ids are their rows
+    QHash<QString, int> pathToResultIndex;
+    pathToResultIndex.reserve(root.children.size());
+    for (const auto& library : std::as_const(root.children)) {
+        pathToResultIndex.insert(library.symbol.path, library.id);
+    }
+
+    for (const auto& library : other.root.children) {
+        auto resultIndexIt = pathToResultIndex.find(library.symbol.path);
+        if (resultIndexIt == pathToResultIndex.end()) {
+            resultIndexIt = pathToResultIndex.insert(library.symbol.path, pathToResultIndex.size());
+
+            auto merged = library;
+            merged.id = *resultIndexIt;
+            merged.parent = nullptr;
+            root.children.push_back(merged);
+        }
+        costs.add(*resultIndexIt, other.costs.itemCostView(library.id));
+    }
+}
+
+TopCosts TopCosts::fromBottomUp(const BottomUpResults& bottomUp, bool skipFirstLevel)
+{
+    TopCosts results;
+    results.symbols.costs.initializeCostsFrom(bottomUp.costs);
+    results.libraries.costs.initializeCostsFrom(bottomUp.costs);
+
+    const auto& rows = bottomUp.root.children;
+    const auto numRows = static_cast<int>(rows.size());
+
+    // the rows are indexed by their position here, not by their id
+    Costs rowCosts;
+    rowCosts.initializeCostsFrom(bottomUp.costs);
+    for (int i = 0; i < numRows; ++i) {
+        rowCosts.add(i, bottomUp.costs.itemCost(rows[i].id));
+    }
+    QVector<bool> selected(numRows, false);
+    selectTopItems(rowCosts, numRows, NumEntries, &selected);
+    for (int i = 0; i < numRows; ++i) {
+        if (selected[i]) {
+            BottomUp row;
+            row.symbol = rows[i].symbol;
+            row.id = results.symbols.root.children.size();
+            results.symbols.costs.add(row.id, rowCosts.itemCost(i));
+            results.symbols.root.children.push_back(row);
+        }
+    }
+    BottomUp::initializeParents(&results.symbols.root);
+
+    // the bottom up rows carry the self costs of their symbols
+    Costs libraryCosts;
+    libraryCosts.initializeCostsFrom(bottomUp.costs);
+    QVector<Symbol> libraries;
+    QHash<QString, int> pathToLibrary;
+    auto addLibraryCosts = [&](const BottomUp& row) {
+        auto it = pathToLibrary.constFind(row.symbol.path);
+        if (it == pathToLibrary.constEnd()) {
+            it = pathToLibrary.insert(row.symbol.path, libraries.size());
+            libraries.push_back(Symbol({}, 0, 0, row.symbol.binary, row.symbol.path, row.symbol.actualPath,
+                                       row.symbol.isKernel));
+        }
+        libraryCosts.add(*it, bottomUp.costs.itemCost(row.id));
+    };
+    for (const auto& row : rows) {
+        if (skipFirstLevel) {
+            for (const auto& child : row.children) {
+                addLibraryCosts(child);
+            }
+        } else {
+            addLibraryCosts(row);
+        }
+    }
+    const auto numLibraries = static_cast<int>(libraries.size());
+    selected.fill(false, numLibraries);
+    selectTopItems(libraryCosts, numLibraries, NumEntries, &selected);
+    for (int i = 0; i < numLibraries; ++i) {
+        if (selected[i]) {
+            PerLibrary library;
+            library.symbol = libraries[i];
+            library.id = results.libraries.root.children.size();
+            results.libraries.costs.add(library.id, libraryCosts.itemCost(i));
+            results.libraries.root.children.push_back(library);
+        }
+    }
+    PerLibrary::initializeParents(&results.libraries.root);
+
+    return results;
+}
+
+void BottomUpResults::merge(const BottomUpResults& other)
+{
+    Q_ASSERT(costs.numTypes() == other.costs.numTypes());
+    for (int i = 0, c = costs.numTypes(); i < c; ++i) {
+        costs.addTotalCost(i, other.costs.totalCost(i));
+    }
+    mergeBottomUp(other.root, other.costs, &root, &costs, &maxBottomUpId);
+    BottomUp::initializeParents(&root);
+}
+
+void BottomUpResults::mergeCapture(const BottomUpResults& other)
+{
+    QVector<int> types(other.costs.numTypes());
+    for (int i = 0, c = other.costs.numTypes(); i < c; ++i) {
+        const auto name = other.costs.typeName(i);
+        const auto unit = other.costs.unit(i);
+        int type = 0;
+        while (type < costs.numTypes() && (costs.typeName(type) != name || costs.unit(type) != unit)) {
+            ++type;
+        }
+        if (type == costs.numTypes()) {
+            costs.addType(type, name, unit);
+        }
+        costs.addTotalCost(type, other.costs.totalCost(i));
+        types[i] = type;
+    }
+    mergeCaptureBottomUp(other.root, other.costs, types, &root, &costs, &maxBottomUpId);
+    BottomUp::initializeParents(&root);
+}
+
+BottomUpResults BottomUpResults::compareCaptures(const BottomUpResults& baseline, const BottomUpResults& current)
+{
+    BottomUpResults results;
+    auto& costs = results.costs;
+    // the three types of a cost type are laid out next to each other, the first one holds the baseline costs
+    auto comparedType = [&costs](const Costs& captureCosts, int type) {
+        const auto name = captureCosts.typeName(type);
+        const auto unit = captureCosts.unit(type);
+        const auto numTypes = costs.numTypes();
+        int compared = 0;
+        while (compared < numTypes && (costs.typeName(compared + 1) != name || costs.unit(compared + 1) != unit)) {
+            compared += 3;
+        }
+        if (compared == numTypes) {
+            costs.addType(compared, QCoreApplication::translate("Data", "%1 (baseline)").arg(name), unit);
+            costs.addType(compared + 1, name, unit);
+            costs.addType(compared + 2, QCoreApplication::translate("Data", "%1 (delta)").arg(name), unit);
+            costs.setBaselineType(compared + 2, compared);
+        }
+        return compared;
+    };
+
+    // the types are laid out in the order of the current capture, followed by the ones only the baseline has
+    QVector<int> currentTypes(current.costs.numTypes());
+    for (int i = 0, c = currentTypes.size(); i < c; ++i) {
+        currentTypes[i] = comparedType(current.costs, i) + 1;
+        costs.addTotalCost(currentTypes[i], current.costs.totalCost(i));
+    }
+    QVector<int> baselineTypes(baseline.costs.numTypes());
+    for (int i = 0, c = baselineTypes.size(); i < c; ++i) {
+        baselineTypes[i] = comparedType(baseline.costs, i);
+        costs.addTotalCost(baselineTypes[i], baseline.costs.totalCost(i));
+    }
+
+    mergeCaptureBottomUp(baseline.root, baseline.costs, baselineTypes, &results.root, &costs, &results.maxBottomUpId);
+    mergeCaptureBottomUp(current.root, current.costs, currentTypes, &results.root, &costs, &results.maxBottomUpId);
+
+    for (int type = 0, c = costs.numTypes(); type < c; type += 3) {
+        costs.addTotalCost(type + 2, costs.totalCost(type + 1) - costs.totalCost(type));
+    }
+    for (quint32 id = 0; id < results.maxBottomUpId; ++id) {
+        for (int type = 0, c = costs.numTypes(); type < c; type += 3) {
+            costs.add(type + 2, id, costs.cost(type + 1, id) - costs.cost(type, id));
+        }
+    }
+
+    BottomUp::initializeParents(&results.root);
+    return results;
+}
+
+void CallerCalleeResults::mergeEntries(const CallerCalleeResults& other)
+{
+    for (auto it = other.entries.begin(), end = other.entries.end(); it != end; ++it) {
+        auto& target = entry(it.key());
+        mergeSymbolCosts(&target.callers, it->callers);
+        mergeSymbolCosts(&target.callees, it->callees);
+        mergeLocationCosts(&target.sourceMap, it->sourceMap);
+        mergeLocationCosts(&target.offsetMap, it->offsetMap);
+    }
+}
+
+void CallerCalleeResults::merge(const CallerCalleeResults& other)
+{
+    // go through the entries in the order they got created, to get stable ids
+    QVector<CallerCalleeEntryMap::const_iterator> sorted;
+    sorted.reserve(other.entries.size());
+    for (auto it = other.entries.begin(), end = other.entries.end(); it != end; ++it) {
+        sorted.push_back(it);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto& lhs, const auto& rhs) { return lhs->id < rhs->id; });
+
+    for (const auto& it : std::as_const(sorted)) {
+        auto& target = entry(it.key());
+        mergeSymbolCosts(&target.callers, it->callers);
+        mergeSymbolCosts(&target.callees, it->callees);
+        mergeLocationCosts(&target.sourceMap, it->sourceMap);
+        mergeLocationCosts(&target.offsetMap, it->offsetMap);
+        selfCosts.add(target.id, other.selfCosts.itemCostView(it->id));
+        inclusiveCosts.add(target.id, other.inclusiveCosts.itemCostView(it->id));
+    }
+}
+
+SourceLocationCostMap CallerCalleeResults::sourceMap(const Symbol& symbol) const
+{
+    const auto entry = entries.constFind(symbol);
+    if (entry != entries.constEnd() && !entry->sourceMap.isEmpty()) {
+        return entry->sourceMap;
+    }
+    return locations ? locations->locationMaps(symbol).sourceMap : SourceLocationCostMap();
+}
+
+OffsetLocationCostMap CallerCalleeResults::offsetMap(const Symbol& symbol) const
+{
+    const auto entry = entries.constFind(symbol);
+    if (entry != entries.constEnd() && !entry->offsetMap.isEmpty()) {
+        return entry->offsetMap;
+    }
+    return locations ? locations->locationMaps(symbol).offsetMap : OffsetLocationCostMap();
+}
+
+bool CallerCalleeResults::hasLocationMaps(const Symbol& symbol) const
+{
+    const auto entry = entries.constFind(symbol);
+    if (entry != entries.constEnd() && !entry->sourceMap.isEmpty() && !entry->offsetMap.isEmpty()) {
+        return true;
+    }
+    return !locations || locations->isCached(symbol);
+}
+
+QHash<Symbol, OffsetLocationCostMap> CallerCalleeResults::selfOffsetMaps() const
+{
+    if (locations) {
+        return locations->selfOffsetMaps();
+    }
+
+    QHash<Symbol, OffsetLocationCostMap> maps;
+    for (auto it = entries.cbegin(), end = entries.cend(); it != end; ++it) {
+        if (!it->offsetMap.isEmpty()) {
+            maps.insert(it.key(), it->offsetMap);
+        }
+    }
+    return maps;
+}
+
+void CallerCalleeResults::buildFileCosts()
+{
+    if (locations) {
+        fileCosts = locations->fileCosts();
+        return;
+    }
+
+    fileCosts.clear();
+    for (const auto& entry : std::as_const(entries)) {
+        for (auto it = entry.sourceMap.begin(), end = entry.sourceMap.end(); it != end; ++it) {
+            auto& cost = fileCosts[it.key().file][it.key().line];
+            add(cost.selfCost, it->selfCost);
+            add(cost.inclusiveCost, it->inclusiveCost);
+        }
+    }
+}
+
+void CallerCalleeResults::buildAdjacency()
+{
+    adjacencySymbols = QVector<Symbol>(entries.size());
+    for (auto it = entries.cbegin(), end = entries.cend(); it != end; ++it) {
+        Q_ASSERT(it->id < static_cast<quint32>(entries.size()));
+        adjacencySymbols[it->id] = it.key();
+    }
+
+    // callers and callees usually have an entry of their own, the others get appended
+    QHash<Symbol, qint32> otherIds;
+    auto symbolId = [&](const Symbol& symbol) {
+        const auto id = adjacencyId(symbol);
+        if (id != -1) {
+            return id;
+        }
+        auto it = otherIds.find(symbol);
+        if (it == otherIds.end()) {
+            it = otherIds.insert(symbol, adjacencySymbols.size());
+            adjacencySymbols.push_back(symbol);
+        }
+        return it.value();
+    };
+
+    auto build = [&](CallerCalleeAdjacency* adjacency, auto map) {
+        const auto numEntries = entries.size();
+        adjacency->offsets = QVector<qint32>(numEntries + 1, 0);
+        adjacency->allEdges.clear();
+        QVector<QVector<CallerCalleeAdjacency::Edge>> edges(numEntries);
+        for (auto it = entries.cbegin(), end = entries.cend(); it != end; ++it) {
+            const auto& symbolCosts = map(*it);
+            auto& entryEdges = edges[it->id];
+            entryEdges.reserve(symbolCosts.size());
+            for (auto costIt = symbolCosts.cbegin(), costEnd = symbolCosts.cend(); costIt != costEnd; ++costIt) {
+                entryEdges.push_back({symbolId(costIt.key()), costIt->size() ? (*costIt)[0] : 0});
+            }
+            // the ids keep the order stable for equal costs
+            std::sort(entryEdges.begin(), entryEdges.end(), [](const auto& lhs, const auto& rhs) {
+                return std::tie(rhs.cost, lhs.symbolId) < std::tie(lhs.cost, rhs.symbolId);
+            });
+        }
+        for (int i = 0; i < numEntries; ++i) {
+            adjacency->offsets[i] = adjacency->allEdges.size();
+            adjacency->allEdges.append(edges[i]);
+        }
+        adjacency->offsets[numEntries] = adjacency->allEdges.size();
+    };
+    build(&callerAdjacency, [](const CallerCalleeEntry& entry) -> const CallerMap& { return entry.callers; });
+    build(&calleeAdjacency, [](const CallerCalleeEntry& entry) -> const CalleeMap& { return entry.callees; });
+}
+
+LocationCostIndex::LocationCostIndex(const BottomUpResults& bottomUp, const EventResults& events)
+    : m_events(events)
+    , m_numTypes(bottomUp.costs.numTypes())
+{
+    m_frames.symbols = bottomUp.symbols;
+    m_frames.locations = bottomUp.locations;
+}
+
+LocationCostIndex::~LocationCostIndex() = default;
+
+template<typename Callback>
+void LocationCostIndex::forEachSample(Callback&& callback) const
+{
+    for (const auto& thread : m_events.threads) {
+        // the events of a run share their stack, so it only gets visited once per run
+        thread.events.forEachRun([&](const EventRun& run) {
+            if (run.type >= 0 && run.type < m_numTypes && run.stackId >= 0 && run.stackId < m_events.stacks.size()) {
+                callback(run.type, run.cost * run.count, m_events.stacks[run.stackId]);
+            }
+            return true;
+        });
+    }
+}
+
+namespace {
+// relAddr can be 0 for symbols in the main executable
+quint64 offsetKey(const Location& location)
+{
+    return location.relAddr ? location.relAddr : location.address;
+}
+}
+
+LocationCostIndex::LocationMaps LocationCostIndex::locationMaps(const Symbol& symbol) const
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        const auto it = m_cache.constFind(symbol);
+        if (it != m_cache.constEnd()) {
+            return it.value();
+        }
+    }
+
+    // just like the recursion guard in the parser, only the innermost frame of the symbol counts per sample
+    LocationMaps maps;
+    forEachSample([&](int type, quint64 cost, const QVector<qint32>& frames) {
+        bool isLeaf = true;
+        m_frames.foreachFrame(frames, [&](const Symbol& frameSymbol, const Location& location) {
+            if (frameSymbol == symbol) {
+                auto& sourceCost = maps.sourceMap[location.fileLine];
+                auto& addrCost = maps.offsetMap[offsetKey(location)];
+                for (auto* locationCost : {&sourceCost, &addrCost}) {
+                    if (static_cast<int>(locationCost->inclusiveCost.size()) < m_numTypes) {
+                        *locationCost = LocationCost(m_numTypes);
+                    }
+                    locationCost->inclusiveCost[type] += cost;
+                    if (isLeaf) {
+                        locationCost->selfCost[type] += cost;
+                    }
+                }
+                return false;
+            }
+            isLeaf = false;
+            return true;
+        });
+    });
+
+    QMutexLocker lock(&m_mutex);
+    if (m_cacheEnabled) {
+        m_cache.insert(symbol, maps);
+    }
+    return maps;
+}
+
+bool LocationCostIndex::isCached(const Symbol& symbol) const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_cache.contains(symbol);
+}
+
+void LocationCostIndex::setCacheEnabled(bool enabled)
+{
+    QMutexLocker lock(&m_mutex);
+    m_cacheEnabled = enabled;
+    if (!enabled) {
+        m_cache.clear();
+    }
+}
+
+qint64 LocationCostIndex::memoryUsage() const
+{
+    QMutexLocker lock(&m_mutex);
+    qint64 usage = 0;
+    for (const auto& maps : m_cache) {
+        usage += hashMemoryUsage(maps.sourceMap, locationCostMemoryUsage)
+            + hashMemoryUsage(maps.offsetMap, locationCostMemoryUsage);
+    }
+    return usage;
+}
+
+QHash<Symbol, OffsetLocationCostMap> LocationCostIndex::selfOffsetMaps() const
+{
+    QHash<Symbol, OffsetLocationCostMap> maps;
+    forEachSample([&](int type, quint64 cost, const QVector<qint32>& frames) {
+        // only the leaf has a self cost
+        m_frames.foreachFrame(frames, [&](const Symbol& symbol, const Location& location) {
+            auto& addrCost = maps[symbol][offsetKey(location)];
+            if (static_cast<int>(addrCost.selfCost.size()) < m_numTypes) {
+                addrCost = LocationCost(m_numTypes);
+            }
+            addrCost.selfCost[type] += cost;
+            return false;
+        });
+    });
+    return maps;
+}
+
+QHash<QString, FileLineCostMap> LocationCostIndex::fileCosts() const
+{
+    QHash<QString, FileLineCostMap> fileCosts;
+    RecursionGuard recursionGuard;
+    forEachSample([&](int type, quint64 cost, const QVector<qint32>& frames) {
+        recursionGuard.reset();
+        m_frames.foreachFrame(frames, [&](const Symbol& symbol, const Location& location) {
+            const auto isLeaf = recursionGuard.isEmpty();
+            if (recursionGuard.insert(symbol)) {
+                auto& lineCost = fileCosts[location.fileLine.file][location.fileLine.line];
+                if (static_cast<int>(lineCost.inclusiveCost.size()) < m_numTypes) {
+                    lineCost = LocationCost(m_numTypes);
+                }
+                lineCost.inclusiveCost[type] += cost;
+                if (isLeaf) {
+                    lineCost.selfCost[type] += cost;
+                }
+            }
+            return true;
+        });
+    });
+    return fileCosts;
+}
+
+bool Data::parseCpus(const QStringList& values, QSet<quint32>* cpus)
+{
+    // guards against typos that would otherwise insert billions of cpus
+    const quint32 MaxCpus = 65536;
+
+    for (const auto& value : values) {
+        const auto separator = value.indexOf(QLatin1Char('-'));
+        bool firstOk = false;
+        bool lastOk = false;
+        const auto first = value.left(separator).toUInt(&firstOk);
+        const auto last = separator == -1 ? first : value.mid(separator + 1).toUInt(&lastOk);
+        if (!firstOk || (separator != -1 && !lastOk) || last < first || last - first > MaxCpus) {
+            return false;
+        }
+        for (quint64 cpu = first; cpu <= last; ++cpu) {
+            cpus->insert(static_cast<quint32>(cpu));
+        }
+    }
+    return true;
+}
+
+std::optional<ParseRestriction> ParseRestriction::fromString(const QString& spec)
+{
+    // a single number or a range of numbers, either end of a range may be omitted
+    auto parseRange = [](const QString& range, auto parse, auto* begin, auto* end) {
+        const auto separator = range.indexOf(QLatin1Char('-'));
+        const auto first = separator == -1 ? range : range.left(separator);
+        const auto second = separator == -1 ? range : range.mid(separator + 1);
+        return (first.isEmpty() || parse(first, begin)) && (second.isEmpty() || parse(second, end));
+    };
+
+    ParseRestriction ret;
+    const auto items = spec.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+    for (const auto& item : items) {
+        const auto equals = item.indexOf(QLatin1Char('='));
+        if (equals == -1) {
+            return std::nullopt;
+        }
+        const auto key = item.left(equals);
+        const auto values = item.mid(equals + 1).split(QLatin1Char(','), Qt::SkipEmptyParts);
+        if (values.isEmpty()) {
+            return std::nullopt;
+        }
+
+        if (key == QLatin1String("time")) {
+            auto parseSeconds = [](const QString& value, quint64* time) {
+                bool ok = false;
+                const auto seconds = value.toDouble(&ok);
+                if (!ok || seconds < 0) {
+                    return false;
+                }
+                *time = static_cast<quint64>(std::llround(seconds * 1E9));
+                return true;
+            };
+            if (values.size() != 1 || !values.first().contains(QLatin1Char('-'))
+                || !parseRange(values.first(), parseSeconds, &ret.time.start, &ret.time.end)
+                || ret.time.end < ret.time.start) {
+                return std::nullopt;
+            }
+        } else if (key == QLatin1String("pid")) {
+            for (const auto& value : values) {
+                bool ok = false;
+                const auto pid = value.toInt(&ok);
+                if (ok) {
+                    ret.pids.insert(pid);
+                } else {
+                    ret.commands.insert(value);
+                }
+            }
+        } else if (key == QLatin1String("cpu")) {
+            if (!parseCpus(values, &ret.cpus)) {
+                return std::nullopt;
+            }
+        } else {
+            return std::nullopt;
+        }
+    }
+    return ret;
+}
+
+bool FilterAction::isRefinementOf(const FilterAction& other) const
+{
+    auto isSubset = [](const auto& subset, const auto& set) {
+        for (const auto& value : subset) {
+            if (!set.contains(value)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    return (!other.time.isValid()
+            || (time.isValid() && other.time.contains(time.start) && other.time.contains(time.end)))
+        && (other.processId == INVALID_PID || processId == other.processId)
+        && (other.threadId == INVALID_TID || threadId == other.threadId)
+        && (other.cpuId == INVALID_CPU_ID || cpuId == other.cpuId)
+        && isSubset(other.excludeProcessIds, excludeProcessIds) && isSubset(other.excludeThreadIds, excludeThreadIds)
+        && isSubset(other.excludeCpuIds, excludeCpuIds) && isSubset(other.includeSymbols, includeSymbols)
+        && isSubset(other.excludeSymbols, excludeSymbols) && isSubset(other.includeBinaries, includeBinaries)
+        && isSubset(other.excludeBinaries, excludeBinaries);
+}
+
+StackIndex::Trie::Trie()
+    : firstChild(1, -1)
+    , nextSibling(1, -1)
+{
+}
+
+qint32 StackIndex::Trie::insert(const qint32* symbolIds, qint32 size)
+{
+    qint32 node = 0;
+    for (qint32 i = 0; i < size; ++i) {
+        const auto key = (static_cast<quint64>(node) << 32) | static_cast<quint32>(symbolIds[i]);
+        auto it = children.constFind(key);
+        if (it == children.constEnd()) {
+            const auto child = firstChild.size();
+            firstChild.push_back(-1);
+            nextSibling.push_back(firstChild[node]);
+            firstChild[node] = child;
+            it = children.insert(key, child);
+        }
+        node = it.value();
+    }
+    return node;
+}
+
+void StackIndex::Trie::setStacks(const QVector<qint32>& stackNodes)
+{
+    // a counting sort, which keeps the stacks of a node sorted by their id
+    stackOffsets.fill(0, firstChild.size() + 1);
+    for (const auto node : stackNodes) {
+        ++stackOffsets[node + 1];
+    }
+    std::partial_sum(stackOffsets.begin(), stackOffsets.end(), stackOffsets.begin());
+    stackIds.resize(stackNodes.size());
+    auto next = stackOffsets;
+    for (qint32 stackId = 0, c = stackNodes.size(); stackId < c; ++stackId) {
+        stackIds[next[stackNodes[stackId]]++] = stackId;
+    }
+}
+
+StackIndex::StackIndex(const BottomUpResults& bottomUp, const QVector<QVector<qint32>>& stacks)
+    : m_numStacks(stacks.size())
+{
+    // the stacks get visited in order, so the lists stay sorted and we only need to skip duplicates
+    auto addStack = [](QVector<qint32>* stackIds, qint32 stackId) {
+        if (stackIds->isEmpty() || stackIds->last() != stackId) {
+            stackIds->push_back(stackId);
+        }
+    };
+
+    QVector<qint32> leafNodes(m_numStacks);
+    QVector<qint32> outermostCallerNodes(m_numStacks);
+    QVarLengthArray<qint32, 64> symbolIds;
+    for (qint32 stackId = 0; stackId < m_numStacks; ++stackId) {
+        symbolIds.clear();
+        bottomUp.foreachFrame(stacks.at(stackId), [&](const Symbol& symbol, const Location& /*location*/) {
+            auto it = m_symbolIds.constFind(symbol);
+            if (it == m_symbolIds.constEnd()) {
+                it = m_symbolIds.insert(symbol, m_symbolStacks.size());
+                m_symbolStacks.push_back({});
+            }
+            symbolIds.append(it.value());
+            addStack(&m_symbolStacks[it.value()], stackId);
+            addStack(&m_binaryStacks[symbol.binary], stackId);
+            return true;
+        });
+
+        // the frames are ordered from the leaf to the outermost caller
+        leafNodes[stackId] = m_fromLeaf.insert(symbolIds.constData(), symbolIds.size());
+        std::reverse(symbolIds.begin(), symbolIds.end());
+        outermostCallerNodes[stackId] = m_fromOutermostCaller.insert(symbolIds.constData(), symbolIds.size());
+    }
+    m_fromLeaf.setStacks(leafNodes);
+    m_fromOutermostCaller.setStacks(outermostCallerNodes);
+}
+
+QVector<qint32> StackIndex::stacksWithSymbol(const Symbol& symbol) const
+{
+    const auto it = m_symbolIds.constFind(symbol);
+    return it == m_symbolIds.constEnd() ? QVector<qint32>() : m_symbolStacks.at(it.value());
+}
+
+QVector<qint32> StackIndex::stacksWithPrefix(const QVector<Symbol>& frames, Direction direction) const
+{
+    const auto& trie = direction == Direction::FromLeaf ? m_fromLeaf : m_fromOutermostCaller;
+
+    qint32 node = 0;
+    for (const auto& frame : frames) {
+        const auto symbolId = m_symbolIds.value(frame, -1);
+        if (symbolId == -1) {
+            return {};
+        }
+        const auto it = trie.children.constFind((static_cast<quint64>(node) << 32) | static_cast<quint32>(symbolId));
+        if (it == trie.children.constEnd()) {
+            return {};
+        }
+        node = it.value();
+    }
+
+    // collect the stacks of the whole subtree
+    QVector<qint32> stackIds;
+    QVector<qint32> pending = {node};
+    while (!pending.isEmpty()) {
+        const auto current = pending.takeLast();
+        std::copy(trie.stackIds.begin() + trie.stackOffsets[current],
+                  trie.stackIds.begin() + trie.stackOffsets[current + 1], std::back_inserter(stackIds));
+        for (auto child = trie.firstChild[current]; child != -1; child = trie.nextSibling[child]) {
+            pending.push_back(child);
+        }
+    }
+    std::sort(stackIds.begin(), stackIds.end());
+    return stackIds;
+}
+
+QVector<bool> StackIndex::filterStacks(const FilterAction& filter) const
+{
+    // the stacks that contain all of the included symbols and binaries
+    std::optional<QVector<qint32>> includedStacks;
+    auto intersect = [&includedStacks](const QVector<qint32>& stackIds) {
+        if (!includedStacks) {
+            includedStacks = stackIds;
+            return;
+        }
+        QVector<qint32> intersection;
+        std::set_intersection(includedStacks->begin(), includedStacks->end(), stackIds.begin(), stackIds.end(),
+                              std::back_inserter(intersection));
+        includedStacks = std::move(intersection);
+    };
+    for (const auto& symbol : filter.includeSymbols) {
+        intersect(stacksWithSymbol(symbol));
+    }
+    for (const auto& binary : filter.includeBinaries) {
+        intersect(m_binaryStacks.value(binary));
+    }
+
+    QVector<bool> ret;
+    if (includedStacks) {
+        ret.fill(false, m_numStacks);
+        for (const auto stackId : std::as_const(*includedStacks)) {
+            ret[stackId] = true;
+        }
+    } else {
+        ret.fill(true, m_numStacks);
+    }
+
+    auto exclude = [&ret](const QVector<qint32>& stackIds) {
+        for (const auto stackId : stackIds) {
+            ret[stackId] = false;
+        }
+    };
+    for (const auto& symbol : filter.excludeSymbols) {
+        exclude(stacksWithSymbol(symbol));
+    }
+    for (const auto& binary : filter.excludeBinaries) {
+        exclude(m_binaryStacks.value(binary));
+    }
+    return ret;
+}
+
+void FrequencyPyramid::build(const QVector<FrequencyData>& values)
+{
+    m_levels.clear();
+    m_firstTime = values.isEmpty() ? 0 : values.constFirst().time;
+
+    m_costSums.resize(values.size() + 1);
+    m_timeSums.resize(values.size() + 1);
+    m_costSums[0] = 0;
+    m_timeSums[0] = 0;
+    for (int i = 0, c = values.size(); i < c; ++i) {
+        m_costSums[i + 1] = m_costSums[i] + values[i].cost;
+        m_timeSums[i + 1] = m_timeSums[i] + (values[i].time - m_firstTime);
+    }
+
+    // the first level summarizes the values, every further level the buckets of the previous one
+    auto summarize = [](auto begin, auto end, auto toBucket) {
+        QVector<Bucket> buckets;
+        buckets.reserve(static_cast<int>((std::distance(begin, end) + Factor - 1) / Factor));
+        for (auto it = begin; it != end;) {
+            const auto bucketEnd = std::next(it, std::min<qsizetype>(Factor, std::distance(it, end)));
+            Bucket bucket = toBucket(it);
+            double numValues = 1;
+            for (++it; it != bucketEnd; ++it) {
+                const auto value = toBucket(it);
+                bucket.min = std::min(bucket.min, value.min);
+                bucket.max = std::max(bucket.max, value.max);
+                numValues += 1;
+                // values without a duration, i.e. all at the same time, count alike
+                const auto duration = bucket.duration + value.duration;
+                const auto weight = duration > 0 ? value.duration / duration : 1. / numValues;
+                bucket.time += (value.time - bucket.time) * weight;
+                bucket.avg += (value.avg - bucket.avg) * weight;
+                bucket.duration = duration;
+            }
+            buckets.push_back(bucket);
+        }
+        return buckets;
+    };
+
+    if (values.size() <= Factor) {
+        return;
+    }
+    m_levels.push_back(summarize(values.begin(), values.end(), [&values](auto it) {
+        // a value lasts until the next one, the last one as long as the one before it
+        const auto next = std::next(it);
+        const auto duration = next != values.end() ? next->time - it->time : it->time - std::prev(it)->time;
+        const auto time = static_cast<double>(it->time);
+        return Bucket {time, it->cost, it->cost, it->cost, static_cast<double>(duration)};
+    }));
+    while (m_levels.constLast().size() > Factor) {
+        const auto& previous = m_levels.constLast();
+        auto level = summarize(previous.begin(), previous.end(), [](auto it) { return *it; });
+        m_levels.push_back(std::move(level));
+    }
+}
+
+int FrequencyPyramid::level(double start, double end, int maxBuckets) const
+{
+    for (int i = 0, c = m_levels.size(); i < c; ++i) {
+        const auto range = buckets(i, start, end);
+        if (std::distance(range.first, range.second) <= maxBuckets) {
+            return i;
+        }
+    }
+    return m_levels.size() - 1;
+}
+
+std::pair<const FrequencyPyramid::Bucket*, const FrequencyPyramid::Bucket*>
+FrequencyPyramid::buckets(int level, double start, double end) const
+{
+    const auto& buckets = m_levels.at(level);
+    const auto* first = buckets.constData();
+    const auto* last = first + buckets.size();
+    first = std::lower_bound(first, last, start, [](const Bucket& bucket, double time) { return bucket.time < time; });
+    last = std::upper_bound(first, last, end, [](double time, const Bucket& bucket) { return time < bucket.time; });
+    return {first, last};
+}
+
+FrequencyData FrequencyPyramid::average(int begin, int end) const
+{
+    Q_ASSERT(begin >= 0 && begin < end && end < m_costSums.size());
+    const auto numValues = end - begin;
+    return {m_firstTime + (m_timeSums[end] - m_timeSums[begin]) / numValues,
+            (m_costSums[end] - m_costSums[begin]) / numValues};
+}
+
+qint64 FrequencyPyramid::memoryUsage() const
+{
+    qint64 usage = m_levels.capacity() * sizeof(QVector<Bucket>) + m_costSums.capacity() * sizeof(double)
+        + m_timeSums.capacity() * sizeof(quint64);
+    for (const auto& level : m_levels) {
+        usage += level.capacity() * sizeof(Bucket);
+    }
+    return usage;
+}
+
+namespace {
+// the number of events between two checks whether building a cost cube got cancelled
+constexpr qint64 CancelPollInterval = 4096;
+
+struct CellKey
+{
+    qint32 stackId;
+    quint32 cpuId;
+    qint32 type;
+
+    bool operator==(const CellKey& rhs) const
+    {
+        return std::tie(stackId, cpuId, type) == std::tie(rhs.stackId, rhs.cpuId, rhs.type);
+    }
+};
+
+uint qHash(const CellKey& key, uint seed = 0)
+{
+    Util::HashCombine hash;
+    seed = hash(seed, key.stackId);
+    seed = hash(seed, key.cpuId);
+    return hash(seed, key.type);
+}
+}
+
+CostCube::CostCube(const EventResults& events)
+{
+    m_threadCells.reserve(events.threads.size());
+    for (const auto& thread : events.threads) {
+        m_threadCells.push_back(threadCells(thread));
+    }
+}
+
+QVector<CostCube::Cell> CostCube::threadCells(const ThreadEvents& thread, const std::atomic<bool>* cancelled)
+{
+    QVector<Cell> cells;
+    QHash<CellKey, int> cellIndices;
+    qint64 numEvents = 0;
+    // the events of a run share their cell
+    thread.events.forEachRun([&](const EventRun& run) {
+        // poll regularly, a single thread may have millions of events
+        numEvents += run.count;
+        if (cancelled && numEvents >= CancelPollInterval) {
+            numEvents = 0;
+            if (*cancelled) {
+                return false;
+            }
+        }
+        const auto key = CellKey {run.stackId, run.cpuId, run.type};
+        auto it = cellIndices.constFind(key);
+        if (it == cellIndices.constEnd()) {
+            it = cellIndices.insert(key, cells.size());
+            cells.push_back({run.stackId, run.cpuId, run.type, 0});
+        }
+        cells[it.value()].cost += run.cost * run.count;
+        return true;
+    });
+    return cells;
+}
+
+void Data::callerCalleesFromBottomUpData(const BottomUpResults& bottomUpData, CallerCalleeResults* results)
+{
+    results->inclusiveCosts.initializeCostsFrom(bottomUpData.costs);
+    results->selfCosts.initializeCostsFrom(bottomUpData.costs);
+    RecursionGuard recursionGuard;
+    buildCallerCalleeResult(bottomUpData.root, bottomUpData.costs, results, &recursionGuard);
+    results->buildFileCosts();
+    results->buildAdjacency();
+}
+
+CallerCalleeResults Data::callerCalleesFromBottomUpSubtrees(const BottomUpResults& bottomUpData, int begin, int end)
+{
+    CallerCalleeResults results;
+    results.inclusiveCosts.initializeCostsFrom(bottomUpData.costs);
+    results.selfCosts.initializeCostsFrom(bottomUpData.costs);
+    RecursionGuard recursionGuard;
+    for (int i = begin; i < end; ++i) {
+        buildCallerCalleeRow(bottomUpData.root.children.at(i), bottomUpData.costs, &results, &recursionGuard);
+    }
+    return results;
+}
+
+QDebug Data::operator<<(QDebug stream, const Symbol& symbol)
+{
+    stream.noquote().nospace() << "Symbol{"
+                               << "symbol=" << symbol.symbol << ", "
+                               << "relAddr=" << symbol.relAddr << ", "
+                               << "size=" << symbol.size << ", "
+                               << "binary=" << symbol.binary << "}";
+    return stream.resetFormat().space();
+}
+
+QDebug Data::operator<<(QDebug stream, const FileLine& fileLine)
+{
+    stream.noquote().nospace() << "FileLine{"
+                               << "file=" << fileLine.file << ", "
+                               << "line=" << fileLine.line << "}";
+    return stream.resetFormat().space();
+}
+
+QDebug Data::operator<<(QDebug stream, const Location& location)
+{
+    stream.noquote().nospace() << "Location{"
+                               << "address=" << location.address << ", "
+                               << "relAddr=" << location.relAddr << ", "
+                               << "fileLine=" << location.fileLine << "}";
+    return stream.resetFormat().space();
+}
+
+QDebug Data::operator<<(QDebug stream, const ItemCost& cost)
+{
+    stream.noquote().nospace() << "ItemCost(" << cost.size() << "){";
+    for (auto c : cost) {
+        stream << c << ",";
+    }
+    stream << "}";
+    return stream.resetFormat().space();
+}
+
+QDebug Data::operator<<(QDebug stream, const CostSummary& cost)
+{
+    stream.noquote().nospace() << "CostSummary{"
+                               << "label = " << cost.label << ", "
+                               << "sampleCount = " << cost.sampleCount << ", "
+                               << "totalPeriod = " << cost.totalPeriod << "}";
+    return stream.resetFormat().space();
+}
+
+void Data::DurationHistogram::merge(const DurationHistogram& rhs)
+{
+    for (int i = 0; i < NumBuckets; ++i) {
+        counts[i] += rhs.counts[i];
+    }
+    count += rhs.count;
+    total += rhs.total;
+    max = std::max(max, rhs.max);
+}
+
+quint64 Data::DurationHistogram::percentile(double percentile) const
+{
+    if (!count) {
+        return 0;
+    }
+
+    const auto target = std::max(quint64(1), static_cast<quint64>(std::ceil(percentile * count)));
+    quint64 seen = 0;
+    for (int i = 0; i < NumBuckets; ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            return std::min(bucketEnd(i), max);
+        }
+    }
+    return max;
+}
+
+void Data::EventResults::updateMaxCost()
+{
+    maxCost = 0;
+    for (const auto& thread : std::as_const(threads)) {
+        maxCost = std::max(thread.maxCost, maxCost);
+    }
+}
+
+void Data::EventResults::updateNumaMigrations()
+{
+    numaMigrations.clear();
+    qint32 maxNode = -1;
+    for (const auto& cpu : std::as_const(cpus)) {
+        maxNode = std::max(maxNode, cpu.numaNode);
+    }
+    if (maxNode < 0) {
+        // no NUMA topology got recorded
+        for (auto& thread : threads) {
+            thread.numaMigrations = 0;
+        }
+        return;
+    }
+
+    numaMigrations.resize(maxNode + 1);
+    for (auto& thread : threads) {
+        thread.numaMigrations = 0;
+        qint32 lastNode = -1;
+        for (const auto& event : thread.events) {
+            const auto node = numaNode(event.cpuId);
+            if (node == -1) {
+                continue;
+            }
+            if (lastNode != -1 && node != lastNode) {
+                ++thread.numaMigrations;
+                ++numaMigrations[node];
+            }
+            lastNode = node;
+        }
+    }
+}
+
+Data::ThreadEvents* Data::EventResults::findThread(qint32 pid, qint32 tid)
+{
+    for (int i = threads.size() - 1; i >= 0; --i) {
+        auto& thread = threads[i];
+        if (thread.pid == pid && thread.tid == tid) {
+            return &thread;
+        }
+    }
+
+    return nullptr;
+}
+
+const Data::ThreadEvents* Data::EventResults::findThread(qint32 pid, qint32 tid) const
+{
+    return const_cast<Data::EventResults*>(this)->findThread(pid, tid);
+}
+
+Data::Events Data::EventResults::cpuEvents(const CpuEvents& cpu) const
+{
+    Events events;
+    events.reserve(cpu.events.size());
+    for (const auto& index : cpu.events) {
+        events.push_back(threads.at(index.thread).events.at(index.event));
+    }
+    return events;
+}
+
+void Data::EventResults::addLostEvents(quint64 time, quint64 lost)
+{
+    const auto start = time - time % LostEventsWindow;
+    // the lost events arrive mostly in order, so the window is usually the last one
+    auto it = lostEvents.end();
+    if (lostEvents.isEmpty() || lostEvents.last().time.start < start) {
+        it = lostEvents.insert(it, LostEvents());
+    } else {
+        it = std::lower_bound(lostEvents.begin(), lostEvents.end(), start,
+                              [](const LostEvents& window, quint64 start) { return window.time.start < start; });
+        if (it->time.start != start) {
+            it = lostEvents.insert(it, LostEvents());
+        }
+    }
+    it->time = {start, start + LostEventsWindow - 1};
+    ++it->chunks;
+    it->lost += lost;
+}
+
+const Data::LostEvents* Data::EventResults::lostEventsAt(quint64 time) const
+{
+    auto it = std::upper_bound(lostEvents.begin(), lostEvents.end(), time,
+                               [](quint64 time, const LostEvents& window) { return time < window.time.start; });
+    if (it == lostEvents.begin()) {
+        return nullptr;
+    }
+    --it;
+    return it->time.contains(time) ? &*it : nullptr;
+}
+
+std::pair<qsizetype, qsizetype> Data::EventResults::lostEventsInRange(TimeRange range) const
+{
+    auto begin = std::lower_bound(lostEvents.begin(), lostEvents.end(), range.start,
+                                  [](const LostEvents& window, quint64 time) { return window.time.end < time; });
+    auto end = std::upper_bound(begin, lostEvents.end(), range.end,
+                                [](quint64 time, const LostEvents& window) { return time < window.time.start; });
+    return {std::distance(lostEvents.begin(), begin), std::distance(lostEvents.begin(), end)};
+}
+
+void Data::EventResults::countLostEventSamples()
+{
+    if (lostEvents.isEmpty()) {
+        return;
+    }
+
+    for (auto& window : lostEvents) {
+        window.samples = 0;
+    }
+
+    for (const auto& thread : std::as_const(threads)) {
+        const auto& types = thread.events.types();
+        const auto& times = thread.events.times();
+        // both the events and the windows are ordered by time, so walk them in lock step
+        auto window = lostEvents.begin();
+        for (qsizetype i = 0, c = thread.events.size(); i < c && window != lostEvents.end(); ++i) {
+            const auto type = types.at(i);
+            if (type == offCpuTimeCostId || type == lostEventCostId) {
+                continue;
+            }
+            const auto time = times.at(i);
+            while (window != lostEvents.end() && window->time.end < time) {
+                ++window;
+            }
+            if (window != lostEvents.end() && window->time.contains(time)) {
+                ++window->samples;
+            }
+        }
+    }
+}
+
+quint64 Data::EventResults::correctedCost(const Event& event) const
+{
+    if (event.type == offCpuTimeCostId || event.type == lostEventCostId) {
+        return event.cost;
+    }
+    const auto* window = lostEventsAt(event.time);
+    return window ? static_cast<quint64>(std::llround(event.cost * window->correction())) : event.cost;
+}
+
+namespace {
+bool isIntegral(const QVariant& value)
+{
+    switch (value.userType()) {
+    case QMetaType::Bool:
+    case QMetaType::Char:
+    case QMetaType::SChar:
+    case QMetaType::UChar:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::Long:
+    case QMetaType::ULong:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        return true;
+    default:
+        return false;
+    }
+}
+
+QString toText(const QVariant& value)
+{
+    if (value.userType() == QMetaType::QByteArray) {
+        // strings in the payload are zero-terminated char arrays
+        const auto bytes = value.toByteArray();
+        return QString::fromUtf8(bytes.constData(), static_cast<int>(qstrnlen(bytes.constData(), bytes.size())));
+    }
+    return value.toString();
+}
+}
+
+QString Data::TracepointField::text(qsizetype row) const
+{
+    return isNumeric ? QString::number(values.at(row)) : texts.at(values.at(row));
+}
+
+void Data::TracepointField::append(const QVariant& value)
+{
+    if (isNumeric && value.isValid() && !isIntegral(value)) {
+        // the field is not numeric after all, convert the rows we have so far
+        isNumeric = false;
+        Column<qint64> indices;
+        for (const auto number : values) {
+            indices.push_back(intern(QString::number(number)));
+        }
+        values = std::move(indices);
+    }
+
+    if (!isNumeric) {
+        values.push_back(intern(toText(value)));
+    } else if (value.userType() == QMetaType::ULongLong) {
+        // keep the bit pattern of large unsigned values, like pointers
+        values.push_back(static_cast<qint64>(value.toULongLong()));
+    } else {
+        values.push_back(value.toLongLong());
+    }
+}
+
+qint64 Data::TracepointField::intern(const QString& text)
+{
+    auto it = textIndices.constFind(text);
+    if (it == textIndices.constEnd()) {
+        it = textIndices.insert(text, texts.size());
+        texts.push_back(text);
+    }
+    return it.value();
+}
+
+int Data::TracepointTable::fieldIndex(const QString& name) const
+{
+    auto it = std::find_if(fields.begin(), fields.end(),
+                           [&name](const TracepointField& field) { return field.name == name; });
+    return it == fields.end() ? -1 : static_cast<int>(std::distance(fields.begin(), it));
+}
+
+std::pair<qsizetype, qsizetype> Data::TracepointTable::rowsInRange(TimeRange range) const
+{
+    const auto begin = std::lower_bound(times.begin(), times.end(), range.start);
+    const auto end = std::upper_bound(begin, times.end(), range.end);
+    return {begin - times.begin(), end - times.begin()};
+}
+
+QString Data::TracepointTable::format(qsizetype row) const
+{
+    QStringList lines;
+    lines.reserve(fields.size());
+    for (const auto& field : fields) {
+        lines.append(QLatin1String("%1: %2").arg(field.name, field.text(row)));
+    }
+    return lines.join(QLatin1Char('\n'));
+}
+
+std::pair<int, int> Data::TracepointResults::tracepointsInRange(TimeRange range) const
+{
+    const auto begin =
+        std::lower_bound(tracepoints.begin(), tracepoints.end(), range.start,
+                         [](const Tracepoint& tracepoint, quint64 time) { return tracepoint.time < time; });
+    const auto end =
+        std::upper_bound(begin, tracepoints.end(), range.end,
+                         [](quint64 time, const Tracepoint& tracepoint) { return time < tracepoint.time; });
+    return {static_cast<int>(begin - tracepoints.begin()), static_cast<int>(end - tracepoints.begin())};
+}
+
+Data::MemoryUsage Data::MemoryUsage::fromEvents(const EventResults& events)
+{
+    MemoryUsage usage;
+    usage.threadEvents = events.threads.capacity() * sizeof(ThreadEvents);
+    for (const auto& thread : events.threads) {
+        usage.threadEvents += thread.events.memoryUsage();
+    }
+    usage.cpuEvents = events.cpus.capacity() * sizeof(CpuEvents);
+    for (const auto& cpu : events.cpus) {
+        usage.cpuEvents += cpu.events.capacity() * sizeof(EventIndex);
+    }
+    usage.stacks = events.stacks.capacity() * sizeof(QVector<qint32>);
+    for (const auto& stack : events.stacks) {
+        usage.stacks += stack.capacity() * sizeof(qint32);
+    }
+    return usage;
+}
+
+Data::MemoryUsage Data::MemoryUsage::fromResults(const BottomUpResults& bottomUp,
+                                                 const CallerCalleeResults& callerCallee, const EventResults& events,
+                                                 const FrequencyResults& frequency,
+                                                 const TracepointResults& tracepoints)
+{
+    auto usage = fromEvents(events);
+
+    usage.bottomUp = bottomUp.root.memoryUsage() + bottomUp.costs.memoryUsage()
+        + bottomUp.symbols.capacity() * sizeof(Symbol) + bottomUp.locations.capacity() * sizeof(FrameLocation);
+
+    usage.callerCallee = callerCallee.selfCosts.memoryUsage() + callerCallee.inclusiveCosts.memoryUsage()
+        + (callerCallee.locations ? callerCallee.locations->memoryUsage() : 0);
+    usage.callerCallee += hashMemoryUsage(callerCallee.entries, [](const CallerCalleeEntry& entry) {
+        return hashMemoryUsage(entry.callers, itemCostMemoryUsage) + hashMemoryUsage(entry.callees, itemCostMemoryUsage)
+            + hashMemoryUsage(entry.sourceMap, locationCostMemoryUsage)
+            + hashMemoryUsage(entry.offsetMap, locationCostMemoryUsage);
+    });
+    usage.callerCallee += hashMemoryUsage(callerCallee.fileCosts, [](const FileLineCostMap& lines) {
+        return hashMemoryUsage(lines, locationCostMemoryUsage);
+    });
+
+    for (const auto& core : frequency.cores) {
+        for (const auto& costType : core.costs) {
+            usage.frequency += costType.values.capacity() * sizeof(FrequencyData) + costType.pyramid.memoryUsage();
+        }
+    }
+
+    usage.tracepoints = tracepoints.tracepoints.capacity() * sizeof(Tracepoint);
+    for (const auto& table : tracepoints.tables) {
+        usage.tracepoints +=
+            table.times.memoryUsage() + table.threadIds.memoryUsage() + table.stackIds.memoryUsage();
+        for (const auto& field : table.fields) {
+            usage.tracepoints += field.values.memoryUsage() + field.texts.capacity() * sizeof(QString)
+                + hashMemoryUsage(field.textIndices, [](qint64) { return 0; });
+        }
+    }
+
+    return usage;
 }
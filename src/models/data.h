@@ -8,16 +8,29 @@
 #pragma once
 
 #include <QHash>
+#include <QMap>
 #include <QMetaType>
+#include <QMutex>
 #include <QSet>
 #include <QString>
 #include <QTypeInfo>
+#include <QVariant>
 #include <QVector>
+#include <QtAlgorithms>
 
 #include "../util.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <optional>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 #include <valarray>
 
 namespace Data {
@@ -28,7 +41,6 @@ struct Symbol
     Symbol(const QString& symbol = {}, quint64 relAddr = 0, quint64 size = 0, const QString& binary = {},
            const QString& path = {}, const QString& actualPath = {}, bool isKernel = false, bool isInline = false)
         : symbol(symbol)
-        , prettySymbol(Data::prettifySymbol(symbol))
         , relAddr(relAddr)
         , size(size)
         , binary(binary)
@@ -41,8 +53,6 @@ struct Symbol
 
     // function name
     QString symbol;
-    // prettified function name
-    QString prettySymbol;
     // relative address
     quint64 relAddr = 0;
     // size of frame
@@ -55,6 +65,10 @@ struct Symbol
     QString actualPath;
     bool isKernel = false;
     bool isInline = false;
+    // set by internSymbol, equal interned symbols share the same id
+    // which turns comparing and hashing them into cheap integer operations
+    qint32 internId = -1;
+    uint internHash = 0;
 
     bool operator<(const Symbol& rhs) const
     {
@@ -66,16 +80,34 @@ struct Symbol
         return !symbol.isEmpty() || !binary.isEmpty() || !path.isEmpty();
     }
 
+    // prettified function name, computed lazily and cached for interned symbols
+    QString prettySymbol() const;
+
     bool canDisassemble() const
     {
         return !symbol.isEmpty() && !path.isEmpty() && relAddr > 0 && size > 0 && !isInline;
     }
+
+    // hash of the data that identifies a symbol, see operator==
+    uint identityHash() const
+    {
+        Util::HashCombine hash;
+        uint seed = 0;
+        seed = hash(seed, symbol);
+        seed = hash(seed, binary);
+        seed = hash(seed, path);
+        seed = hash(seed, relAddr);
+        return seed;
+    }
 };
 
 QDebug operator<<(QDebug stream, const Symbol& symbol);
 
 inline bool operator==(const Symbol& lhs, const Symbol& rhs)
 {
+    if (lhs.internId != -1 && rhs.internId != -1) {
+        return lhs.internId == rhs.internId;
+    }
     return std::tie(lhs.relAddr, lhs.symbol, lhs.binary, lhs.path)
         == std::tie(rhs.relAddr, rhs.symbol, rhs.binary, rhs.path);
 }
@@ -88,13 +120,128 @@ inline bool operator!=(const Symbol& lhs, const Symbol& rhs)
 inline uint qHash(const Symbol& symbol, uint seed = 0)
 {
     Util::HashCombine hash;
-    seed = hash(seed, symbol.symbol);
-    seed = hash(seed, symbol.binary);
-    seed = hash(seed, symbol.path);
-    seed = hash(seed, symbol.relAddr);
-    return seed;
+    return hash(seed, symbol.internId != -1 ? symbol.internHash : symbol.identityHash());
 }
 
+// assigns an id to @p symbol that is shared by all equal symbols interned while a SymbolTableLease exists
+Symbol internSymbol(const Symbol& symbol);
+
+// the parsers hold a lease on the table of the interned symbols while they have results
+// the first lease taken once all got released clears the table, so it doesn't keep the symbols of every file that
+// got opened. the ids never get reused, so the caches keyed by them stay valid
+class SymbolTableLease
+{
+public:
+    SymbolTableLease();
+    ~SymbolTableLease();
+
+    SymbolTableLease(const SymbolTableLease&) = delete;
+    SymbolTableLease& operator=(const SymbolTableLease&) = delete;
+};
+
+// the id of the first symbol interned since the table got cleared, the symbols of the current results have the ids
+// from there on. reading it is cheap enough to be done for every stack
+qint32 firstInternId();
+
+// remembers the symbols seen within a single stack, to count the inclusive cost of recursive symbols only once
+// interned symbols are marked in an array indexed by their id relative to firstInternId, stamped with the generation
+// of the current stack, so a lookup is an integer compare and starting a new stack doesn't allocate
+class RecursionGuard
+{
+public:
+    RecursionGuard()
+        : m_firstId(firstInternId())
+    {
+    }
+
+    // forgets all symbols, call this when starting with a new stack
+    void reset()
+    {
+        m_isEmpty = true;
+        const auto firstId = firstInternId();
+        if (firstId != m_firstId) {
+            // the symbol table got cleared, the marks of its symbols are not needed anymore
+            m_firstId = firstId;
+            m_marks.clear();
+            m_callMarks.clear();
+        }
+        if (!m_others.isEmpty()) {
+            m_others.clear();
+        }
+        if (!m_otherCalls.isEmpty()) {
+            m_otherCalls.clear();
+        }
+        if (++m_generation == 0) {
+            // the stamps wrapped around, so old ones could look current
+            m_marks.fill(0);
+            m_callMarks.clear();
+            m_generation = 1;
+        }
+    }
+
+    // marks @p symbol, returns false when it was marked already
+    bool insert(const Symbol& symbol)
+    {
+        m_isEmpty = false;
+        if (symbol.internId == -1) {
+            const auto size = m_others.size();
+            m_others.insert(symbol);
+            return m_others.size() != size;
+        }
+
+        const auto id = symbol.internId - m_firstId;
+        if (id < 0) {
+            // interned before the table got cleared
+            const auto size = m_others.size();
+            m_others.insert(symbol);
+            return m_others.size() != size;
+        }
+        if (id >= m_marks.size()) {
+            m_marks.resize(id + 1);
+        }
+        auto& mark = m_marks[id];
+        if (mark == m_generation) {
+            return false;
+        }
+        mark = m_generation;
+        return true;
+    }
+
+    // marks the call from @p caller to @p callee, returns false when it was marked already
+    // the stamps of the calls are kept across stacks, so only calls that were never seen before allocate
+    bool insertCall(const Symbol& caller, const Symbol& callee)
+    {
+        if (caller.internId == -1 || callee.internId == -1) {
+            const auto size = m_otherCalls.size();
+            m_otherCalls.insert(qMakePair(caller, callee));
+            return m_otherCalls.size() != size;
+        }
+
+        auto& mark = m_callMarks[(static_cast<quint64>(caller.internId) << 32) | static_cast<quint32>(callee.internId)];
+        if (mark == m_generation) {
+            return false;
+        }
+        mark = m_generation;
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return m_isEmpty;
+    }
+
+private:
+    // see firstInternId, the marks are indexed relative to it
+    qint32 m_firstId = 0;
+    QVector<quint32> m_marks;
+    QHash<quint64, quint32> m_callMarks;
+    quint32 m_generation = 1;
+    bool m_isEmpty = true;
+    // symbols that aren't interned, e.g. in tests
+    QSet<Symbol> m_others;
+    QSet<QPair<Symbol, Symbol>> m_otherCalls;
+};
+
 struct FileLine
 {
     FileLine() = default;
@@ -207,6 +354,44 @@ using ItemCost = std::valarray<qint64>;
 
 QDebug operator<<(QDebug stream, const ItemCost& cost);
 
+// a read-only view of the costs of a single item in Costs, valid until the costs get modified
+class ItemCostView
+{
+public:
+    ItemCostView() = default;
+    // a null @p data means all costs are zero
+    ItemCostView(const qint64* data, int size)
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    int size() const
+    {
+        return m_size;
+    }
+
+    qint64 operator[](int type) const
+    {
+        return m_data ? m_data[type] : 0;
+    }
+
+    // null when all costs are zero
+    const qint64* data() const
+    {
+        return m_data;
+    }
+
+    ItemCost toItemCost() const
+    {
+        return m_data ? ItemCost(m_data, m_size) : ItemCost(qint64(0), m_size);
+    }
+
+private:
+    const qint64* m_data = nullptr;
+    int m_size = 0;
+};
+
 class Costs
 {
 public:
@@ -224,8 +409,8 @@ public:
 
     void add(int type, quint32 id, qint64 delta)
     {
-        ensureSpaceAvailable(type, id);
-        m_costs[type][id] += delta;
+        ensureSpaceAvailable(id);
+        m_costs[index(type, id)] += delta;
     }
 
     void incrementTotal(int type)
@@ -243,6 +428,12 @@ public:
         m_totalCosts.fill(0);
     }
 
+    // the bytes allocated for the cost matrix, see MemoryUsage
+    qint64 memoryUsage() const
+    {
+        return m_costs.capacity() * sizeof(qint64) + m_totalCosts.capacity() * sizeof(qint64);
+    }
+
     int numTypes() const
     {
         return m_typeNames.size();
@@ -250,16 +441,31 @@ public:
 
     void addType(int type, const QString& name, Unit unit)
     {
-        if (m_costs.size() <= type) {
-            m_costs.resize(type + 1);
+        if (numTypes() <= type) {
+            setNumTypes(type + 1);
             m_typeNames.resize(type + 1);
             m_totalCosts.resize(type + 1);
             m_units.resize(type + 1);
+            while (m_baselineTypes.size() <= type) {
+                m_baselineTypes.push_back(-1);
+            }
         }
         m_typeNames[type] = name;
         m_units[type] = unit;
     }
 
+    // when comparing two captures, the costs of @p type are the deltas to the costs of @p baselineType
+    void setBaselineType(int type, int baselineType)
+    {
+        m_baselineTypes[type] = baselineType;
+    }
+
+    // the type @p type is the delta to, or -1 when it isn't a delta, see ComparisonResults
+    int baselineType(int type) const
+    {
+        return m_baselineTypes[type];
+    }
+
     QString typeName(int type) const
     {
         return m_typeNames[type];
@@ -267,11 +473,8 @@ public:
 
     qint64 cost(int type, quint32 id) const
     {
-        if (static_cast<quint32>(m_costs[type].size()) > id) {
-            return m_costs[type][id];
-        } else {
-            return 0;
-        }
+        const auto i = index(type, id);
+        return i < static_cast<quint64>(m_costs.size()) ? m_costs[i] : 0;
     }
 
     qint64 totalCost(int type) const
@@ -279,6 +482,14 @@ public:
         return m_totalCosts[type];
     }
 
+    // what the costs of @p type are relative to: the total cost or, for the deltas of a comparison, the total
+    // cost of the baseline
+    qint64 referenceCost(int type) const
+    {
+        const auto baseline = m_baselineTypes[type];
+        return m_totalCosts[baseline == -1 ? type : baseline];
+    }
+
     QVector<qint64> totalCosts() const
     {
         return m_totalCosts;
@@ -291,42 +502,49 @@ public:
 
     ItemCost itemCost(quint32 id) const
     {
-        ItemCost cost;
-        cost.resize(m_costs.size());
-        for (int i = 0, c = numTypes(); i < c; ++i) {
-            if (static_cast<quint32>(m_costs[i].size()) > id) {
-                cost[i] = m_costs[i][id];
-            } else {
-                cost[i] = 0;
-            }
-        }
-        return cost;
+        return itemCostView(id).toItemCost();
+    }
+
+    // like itemCost, but without copying the costs
+    ItemCostView itemCostView(quint32 id) const
+    {
+        const auto i = index(0, id);
+        return {i < static_cast<quint64>(m_costs.size()) ? m_costs.constData() + i : nullptr, m_stride};
     }
 
     void add(quint32 id, const ItemCost& cost)
     {
-        Q_ASSERT(cost.size() == static_cast<quint32>(m_costs.size()));
-        for (int i = 0, c = numTypes(); i < c; ++i) {
-            ensureSpaceAvailable(i, id);
-            m_costs[i][id] += cost[i];
-        }
+        Q_ASSERT(cost.size() == static_cast<quint32>(m_stride));
+        addCosts(id, std::begin(cost));
+    }
+
+    // @p cost must not point into these costs, adding may reallocate them
+    void add(quint32 id, const ItemCostView& cost)
+    {
+        Q_ASSERT(cost.size() == m_stride);
+        addCosts(id, cost.data());
     }
 
     void initializeCostsFrom(const Costs& rhs)
     {
+        setNumTypes(rhs.m_stride);
         m_typeNames = rhs.m_typeNames;
         m_units = rhs.m_units;
-        m_costs.resize(rhs.m_costs.size());
+        m_baselineTypes = rhs.m_baselineTypes;
         m_totalCosts = rhs.m_totalCosts;
     }
 
-    QString formatCost(int type, quint64 cost) const
+    QString formatCost(int type, qint64 cost) const
     {
         return formatCost(m_units[type], cost);
     }
 
-    static QString formatCost(Unit unit, quint64 cost)
+    static QString formatCost(Unit unit, qint64 cost)
     {
+        if (cost < 0) {
+            // the deltas of a comparison
+            return QLatin1Char('-') + formatCost(unit, -cost);
+        }
         switch (unit) {
         case Unit::Time:
             return Util::formatTimeString(cost);
@@ -342,18 +560,134 @@ public:
         return m_units[type];
     }
 
+    // the number of items that have costs stored, i.e. one more than the highest id
+    quint32 numItems() const
+    {
+        return m_stride > 0 ? static_cast<quint32>(m_costs.size() / m_stride) : 0;
+    }
+
 private:
-    void ensureSpaceAvailable(int type, quint32 id)
+    quint64 index(int type, quint32 id) const
+    {
+        return static_cast<quint64>(id) * m_stride + type;
+    }
+
+    void ensureSpaceAvailable(quint32 id)
+    {
+        const auto size = index(0, id + 1);
+        if (static_cast<quint64>(m_costs.size()) < size) {
+            // grow geometrically, resize alone would reallocate for every new id
+            const auto capacity = static_cast<quint64>(m_costs.capacity());
+            if (capacity < size) {
+                m_costs.reserve(static_cast<int>(std::max(size, 2 * capacity)));
+            }
+            m_costs.resize(static_cast<int>(size));
+        }
+    }
+
+    // a plain loop over contiguous memory that the compiler can vectorize
+    void addCosts(quint32 id, const qint64* cost)
+    {
+        ensureSpaceAvailable(id);
+        if (!cost) {
+            return;
+        }
+        auto* costs = m_costs.data() + index(0, id);
+        for (int i = 0; i < m_stride; ++i) {
+            costs[i] += cost[i];
+        }
+    }
+
+    // the costs are stored row by row, every item has one cost per type
+    void setNumTypes(int numTypes)
     {
-        while (static_cast<quint32>(m_costs[type].size()) <= id) {
-            // don't use resize, we don't want to influence the internal auto-sizing
-            m_costs[type].push_back(0);
+        if (numTypes == m_stride) {
+            return;
+        }
+        if (!m_costs.isEmpty() && m_stride > 0) {
+            const auto numItems = m_costs.size() / m_stride;
+            QVector<qint64> costs(numItems * numTypes, 0);
+            for (int item = 0; item < numItems; ++item) {
+                for (int type = 0, c = std::min(m_stride, numTypes); type < c; ++type) {
+                    costs[item * numTypes + type] = m_costs[item * m_stride + type];
+                }
+            }
+            m_costs = costs;
+        } else {
+            m_costs.clear();
         }
+        m_stride = numTypes;
     }
+
     QVector<QString> m_typeNames;
-    QVector<QVector<qint64>> m_costs;
+    // indexed by id * m_stride + type
+    QVector<qint64> m_costs;
+    int m_stride = 0;
     QVector<qint64> m_totalCosts;
     QVector<Unit> m_units;
+    QVector<int> m_baselineTypes;
+};
+
+// ratios of two cost types, like the instructions per cycle or the cache miss ratio
+// the ratios of all items get computed in one pass over the cost matrix, so they can be shown and sorted like costs
+class DerivedMetrics
+{
+public:
+    struct Metric
+    {
+        QString label;
+        int numerator = -1;
+        int denominator = -1;
+    };
+
+    DerivedMetrics() = default;
+    // @p definitions look like "IPC=instructions/cycles"
+    // definitions referring to events missing in @p costs are skipped
+    // the deltas of a comparison always get related to their baseline
+    DerivedMetrics(const QStringList& definitions, const Costs& costs);
+
+    int size() const
+    {
+        return m_metrics.size();
+    }
+
+    bool isEmpty() const
+    {
+        return m_metrics.isEmpty();
+    }
+
+    const Metric& metric(int metric) const
+    {
+        return m_metrics[metric];
+    }
+
+    // NaN when the item has no cost of the denominator type
+    double value(int metric, quint32 id) const
+    {
+        const auto i = static_cast<qsizetype>(id) * m_metrics.size() + metric;
+        return i < m_values.size() ? m_values[i] : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    double totalValue(int metric) const
+    {
+        return m_totalValues[metric];
+    }
+
+    static double ratio(qint64 numerator, qint64 denominator)
+    {
+        return denominator ? static_cast<double>(numerator) / denominator : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    static QString format(double value);
+
+    // whether the cost type @p typeName, e.g. "cycles:u" or "cpu_core/cycles/", was recorded for @p event
+    static bool matchesEvent(const QString& typeName, const QString& event);
+
+private:
+    QVector<Metric> m_metrics;
+    // indexed by id * size() + metric, like the costs
+    QVector<double> m_values;
+    QVector<double> m_totalValues;
 };
 
 template<typename T>
@@ -374,9 +708,14 @@ struct Tree
 private:
     static void setParents(QVector<T>* children, const T* parent)
     {
-        for (auto& frame : *children) {
-            frame.parent = parent;
-            setParents(&frame.children, &frame);
+        // iterative, as the trees of deep stacks could overflow the thread stack otherwise
+        QVector<std::pair<QVector<T>*, const T*>> pending = {{children, parent}};
+        while (!pending.isEmpty()) {
+            const auto next = pending.takeLast();
+            for (auto& frame : *next.first) {
+                frame.parent = next.second;
+                pending.push_back({&frame.children, &frame});
+            }
         }
     }
 };
@@ -388,42 +727,72 @@ struct SymbolTree : Tree<Impl>
 
     Impl* entryForSymbol(const Symbol& symbol, quint32* maxId)
     {
-        Impl* ret = nullptr;
-
-        auto& children = this->children;
-        for (auto row = children.data(), end = row + children.size(); row != end; ++row) {
-            if (row->symbol == symbol) {
-                ret = row;
-                break;
-            }
-        }
+        auto row = rowForSymbol(symbol);
 
-        if (!ret) {
+        if (row == -1) {
             Impl frame;
             frame.symbol = symbol;
             frame.id = *maxId;
             *maxId += 1;
+
+            auto& children = this->children;
+            row = children.size();
             children.append(frame);
-            ret = &children.last();
+
+            if (!childRows.isEmpty()) {
+                childRows.insert(symbol, row);
+            } else if (children.size() >= MinChildrenForIndex) {
+                childRows.reserve(children.size());
+                for (int i = 0, c = children.size(); i < c; ++i) {
+                    childRows.insert(children[i].symbol, i);
+                }
+            }
         }
 
-        return ret;
+        return this->children.data() + row;
     }
 
     const Impl* entryForSymbol(const Symbol& symbol) const
     {
-        const Impl* ret = nullptr;
+        const auto row = rowForSymbol(symbol);
+        return row == -1 ? nullptr : this->children.constData() + row;
+    }
 
-        auto& children = this->children;
-        for (auto row = children.data(), end = row + children.size(); row != end; ++row) {
-            if (row->symbol == symbol) {
-                ret = row;
-                break;
-            }
+    // the estimated bytes allocated for the descendants of this node, see MemoryUsage
+    qint64 memoryUsage() const
+    {
+        qint64 usage = this->children.capacity() * sizeof(Impl)
+            + childRows.size() * (sizeof(Symbol) + sizeof(int) + 2 * sizeof(void*));
+        for (const auto& child : this->children) {
+            usage += child.memoryUsage();
         }
+        return usage;
+    }
 
-        return ret;
+private:
+    // nodes with few children are scanned linearly, which is faster than hashing
+    static constexpr int MinChildrenForIndex = 16;
+
+    int rowForSymbol(const Symbol& symbol) const
+    {
+        const auto& children = this->children;
+
+        if (!childRows.isEmpty()) {
+            // the index is only valid when children are added through entryForSymbol
+            Q_ASSERT(childRows.size() == children.size());
+            return childRows.value(symbol, -1);
+        }
+
+        for (int row = 0, c = children.size(); row < c; ++row) {
+            if (children[row].symbol == symbol) {
+                return row;
+            }
+        }
+        return -1;
     }
+
+    // maps the symbol of every child to its row, only built for nodes with many children
+    QHash<Symbol, int> childRows;
 };
 
 struct BottomUp : SymbolTree<BottomUp>
@@ -437,10 +806,14 @@ struct BottomUpResults
     Costs costs;
     QVector<Data::Symbol> symbols;
     QVector<Data::FrameLocation> locations;
+    // when set, the inlined frames get skipped and their costs get attributed to the function they got inlined into
+    // this only changes how the stacks get walked, so it can be toggled without parsing again
+    bool foldInlines = false;
 
     // callback should return true to continue iteration or false otherwise
+    // the symbol and location passed to the callback are references into the tables above
     template<typename FrameCallback>
-    void foreachFrame(const QVector<qint32>& frames, FrameCallback frameCallback) const
+    void foreachFrame(const QVector<qint32>& frames, FrameCallback&& frameCallback) const
     {
         for (auto id : frames) {
             if (!handleFrame(id, frameCallback)) {
@@ -470,7 +843,21 @@ struct BottomUpResults
     const BottomUp* addEvent(const Symbol& rootSymbol, int type, quint64 cost, const QVector<qint32>& frames,
                              const FrameCallback& frameCallback)
     {
-        auto parent = root.entryForSymbol(rootSymbol, &maxBottomUpId);
+        return addEvent(rootRow(rootSymbol), type, cost, frames, frameCallback);
+    }
+
+    // the row of the first level node for @p rootSymbol, the node gets created when needed
+    // the rows stay valid, so callers can resolve them once and then pass them to addEvent
+    int rootRow(const Symbol& rootSymbol)
+    {
+        return static_cast<int>(root.entryForSymbol(rootSymbol, &maxBottomUpId) - root.children.constData());
+    }
+
+    template<typename FrameCallback>
+    const BottomUp* addEvent(int rootRow, int type, quint64 cost, const QVector<qint32>& frames,
+                             const FrameCallback& frameCallback)
+    {
+        BottomUp* parent = root.children.data() + rootRow;
 
         // propagate cost to rootSymbol
         costs.add(type, parent->id, cost);
@@ -486,31 +873,63 @@ struct BottomUpResults
         return parent;
     }
 
+    // merge the tree and costs of @p other into this result
+    // both results must share the same symbols, locations and cost types
+    void merge(const BottomUpResults& other);
+
+    // merge the tree and costs of @p other, which got parsed from another capture, into this result
+    // the symbols get unified by their name, binary and address, the cost types by their name and unit
+    // new cost types get appended, the symbols and locations are left alone as the stacks don't get merged
+    void mergeCapture(const BottomUpResults& other);
+
+    // aligns the trees of two captures by their symbol paths, like mergeCapture
+    // every cost type becomes three: the costs of @p baseline, the costs of @p current and their delta
+    static BottomUpResults compareCaptures(const BottomUpResults& baseline, const BottomUpResults& current);
+
 private:
     quint32 maxBottomUpId = 0;
     QHash<quint32, BottomUp*> tidToBottomUp;
 
+    // like QVector::value but without copying, the fallbacks are returned for out-of-range ids
+    const FrameLocation& frameLocation(qint32 locationId) const
+    {
+        static const FrameLocation invalidLocation;
+        return (locationId >= 0 && locationId < locations.size()) ? locations.at(locationId) : invalidLocation;
+    }
+
+    const Symbol& frameSymbol(qint32 locationId) const
+    {
+        static const Symbol invalidSymbol;
+        return (locationId >= 0 && locationId < symbols.size()) ? symbols.at(locationId) : invalidSymbol;
+    }
+
     template<typename FrameCallback>
-    bool handleFrame(qint32 locationId, FrameCallback frameCallback) const
+    bool handleFrame(qint32 locationId, FrameCallback& frameCallback) const
     {
         bool skipNextFrame = false;
         while (locationId != -1) {
-            const auto& location = locations.value(locationId);
+            const auto& location = frameLocation(locationId);
             if (skipNextFrame) {
                 locationId = location.parentLocationId;
                 skipNextFrame = false;
                 continue;
             }
 
-            auto symbol = symbols.value(locationId);
-            if (!symbol.isValid()) {
+            // the outermost frame of a chain of inlined frames always gets kept
+            if (foldInlines && location.parentLocationId != -1 && frameSymbol(locationId).isInline) {
+                locationId = location.parentLocationId;
+                continue;
+            }
+
+            const auto* symbol = &frameSymbol(locationId);
+            if (!symbol->isValid()) {
                 // we get function entry points from the perfparser but
                 // those are imo not interesting - skip them
-                symbol = symbols.value(location.parentLocationId);
+                symbol = &frameSymbol(location.parentLocationId);
                 skipNextFrame = true;
             }
 
-            if (!frameCallback(symbol, location.location)) {
+            if (!frameCallback(*symbol, location.location)) {
                 return false;
             }
 
@@ -531,6 +950,14 @@ struct TopDownResults
     Costs selfCosts;
     Costs inclusiveCosts;
     static TopDownResults fromBottomUp(const Data::BottomUpResults& bottomUpData, bool skipFirstLevel);
+
+    // like fromBottomUp, but only for the top level bottom up rows in [begin, end) and without the parents
+    // the partial results of disjunct ranges can be merged afterwards, see merge
+    static TopDownResults fromBottomUpSubtrees(const Data::BottomUpResults& bottomUpData, bool skipFirstLevel,
+                                               int begin, int end);
+
+    // adds the entries and costs of @p other, its entries get new ids and the parents have to be initialized again
+    void merge(const TopDownResults& other);
 };
 
 struct PerLibrary : SymbolTree<PerLibrary>
@@ -544,6 +971,28 @@ struct PerLibraryResults
     Costs costs;
 
     static PerLibraryResults fromTopDown(const TopDownResults& topDownData);
+
+    // like fromTopDown, but only for the top level top down rows in [begin, end) and without the parents
+    // the partial results of disjunct ranges can be merged afterwards, see merge
+    static PerLibraryResults fromTopDownSubtrees(const TopDownResults& topDownData, int begin, int end);
+
+    // adds the libraries and costs of @p other, the parents have to be initialized again
+    void merge(const PerLibraryResults& other);
+};
+
+// the most expensive rows of the bottom up tree and libraries, as shown by the summary page
+// only the union of the top entries of every cost type is kept, with their full costs
+struct TopCosts
+{
+    static const constexpr int NumEntries = 5;
+
+    // flat trees, i.e. the root children are the top entries
+    BottomUpResults symbols;
+    PerLibraryResults libraries;
+
+    // the libraries get the summed up self costs of their symbols, like in PerLibraryResults::fromTopDown
+    // @p skipFirstLevel must be set when the first level of @p bottomUp groups the costs, e.g. by thread
+    static TopCosts fromBottomUp(const BottomUpResults& bottomUp, bool skipFirstLevel);
 };
 
 struct FrequencyData
@@ -552,10 +1001,59 @@ struct FrequencyData
     double cost = 0;
 };
 
+// summarizes the frequency values at decreasing resolutions, so plots don't need to visit every value
+class FrequencyPyramid
+{
+public:
+    static constexpr int Factor = 8;
+
+    struct Bucket
+    {
+        // the time and the average are weighted by the duration of the values, i.e. the time until the next one
+        double time = 0;
+        double min = 0;
+        double max = 0;
+        double avg = 0;
+        double duration = 0;
+    };
+
+    void build(const QVector<FrequencyData>& values);
+
+    // level i summarizes Factor^(i+1) consecutive values per bucket, the last bucket may summarize less
+    const QVector<QVector<Bucket>>& levels() const
+    {
+        return m_levels;
+    }
+
+    // the index of the finest level with at most @p maxBuckets buckets in the time range [start, end],
+    // the coarsest level if none is coarse enough, -1 without levels
+    int level(double start, double end, int maxBuckets) const;
+
+    // the buckets of @p level in the time range [start, end]
+    std::pair<const Bucket*, const Bucket*> buckets(int level, double start, double end) const;
+
+    // the average of the values in [begin, end), without visiting them
+    FrequencyData average(int begin, int end) const;
+
+    // the bytes allocated for the levels and prefix sums, see MemoryUsage
+    qint64 memoryUsage() const;
+
+private:
+    QVector<QVector<Bucket>> m_levels;
+    // the prefix sums of the costs and of the times relative to the first one
+    QVector<double> m_costSums;
+    QVector<quint64> m_timeSums;
+    quint64 m_firstTime = 0;
+};
+
 struct PerCostFrequencyData
 {
     QString costName;
     QVector<FrequencyData> values;
+    // built once all values are known, see FrequencyPyramid::build
+    FrequencyPyramid pyramid;
+    // the unit of the values, empty for the frequency in GHz
+    QString unit;
 };
 
 struct PerCoreFrequencyData
@@ -566,6 +1064,8 @@ struct PerCoreFrequencyData
 struct FrequencyResults
 {
     QVector<PerCoreFrequencyData> cores;
+    // the only core holds the values of all cores together, e.g. the counts of perf stat, see PerfStat
+    bool isAggregated = false;
 };
 
 using SymbolCostMap = QHash<Symbol, ItemCost>;
@@ -586,6 +1086,8 @@ struct LocationCost
 
 using SourceLocationCostMap = QHash<FileLine, LocationCost>;
 using OffsetLocationCostMap = QHash<quint64, LocationCost>;
+// the costs of the lines of a single source file, keyed by line number
+using FileLineCostMap = QHash<int, LocationCost>;
 
 struct CallerCalleeEntry
 {
@@ -644,11 +1146,57 @@ struct CallerCalleeEntry
 };
 
 using CallerCalleeEntryMap = QHash<Symbol, CallerCalleeEntry>;
+
+class LocationCostIndex;
+
+// the callers or the callees of all symbols in compressed sparse row form, see CallerCalleeResults::buildAdjacency
+struct CallerCalleeAdjacency
+{
+    struct Edge
+    {
+        // index into CallerCalleeResults::adjacencySymbols
+        qint32 symbolId = 0;
+        // the cost of the first cost type
+        qint64 cost = 0;
+    };
+
+    struct EdgeRange
+    {
+        const Edge* first = nullptr;
+        const Edge* last = nullptr;
+
+        const Edge* begin() const
+        {
+            return first;
+        }
+        const Edge* end() const
+        {
+            return last;
+        }
+    };
+
+    // the edges of symbol i, sorted by descending cost
+    EdgeRange edges(qint32 symbolId) const
+    {
+        if (symbolId < 0 || symbolId + 1 >= offsets.size()) {
+            return {};
+        }
+        return {allEdges.constData() + offsets[symbolId], allEdges.constData() + offsets[symbolId + 1]};
+    }
+
+    // the edges of symbol i are at [offsets[i], offsets[i + 1])
+    QVector<qint32> offsets;
+    QVector<Edge> allEdges;
+};
+
 struct CallerCalleeResults
 {
     CallerCalleeEntryMap entries;
     Costs selfCosts;
     Costs inclusiveCosts;
+    // the line costs of all entries, including inlined ones, aggregated per source file
+    // this allows annotating a whole file without going through all entries, see buildFileCosts
+    QHash<QString, FileLineCostMap> fileCosts;
 
     CallerCalleeEntry& entry(const Symbol& symbol)
     {
@@ -659,84 +1207,1301 @@ struct CallerCalleeResults
         }
         return *it;
     }
+
+    // merge the callers, callees and location costs of all entries in @p other into this result
+    // the self and inclusive costs are not merged, compute them from the merged bottom up data instead
+    void mergeEntries(const CallerCalleeResults& other);
+
+    // like mergeEntries, but also merges the self and inclusive costs
+    void merge(const CallerCalleeResults& other);
+
+    // the samples the source and offset maps get computed from on demand, see sourceMap and offsetMap
+    // when this is null, the maps are aggregated into the entries right away
+    std::shared_ptr<const LocationCostIndex> locations;
+
+    // the source and offset maps of @p symbol, either aggregated into its entry or computed from the samples
+    // use these instead of CallerCalleeEntry::sourceMap and CallerCalleeEntry::offsetMap
+    SourceLocationCostMap sourceMap(const Symbol& symbol) const;
+    OffsetLocationCostMap offsetMap(const Symbol& symbol) const;
+    // false when sourceMap and offsetMap of @p symbol have to go through all samples, i.e. are too slow for the GUI
+    bool hasLocationMaps(const Symbol& symbol) const;
+
+    // the self costs per address of all symbols, the inclusive costs are left empty
+    QHash<Symbol, OffsetLocationCostMap> selfOffsetMaps() const;
+
+    // fills fileCosts from the source maps of all entries, call this once they are complete
+    void buildFileCosts();
+
+    // the symbols of the adjacency lists, the first ones are the entries indexed by their id
+    // followed by the callers and callees that have no entry of their own
+    QVector<Symbol> adjacencySymbols;
+    CallerCalleeAdjacency callerAdjacency;
+    CallerCalleeAdjacency calleeAdjacency;
+
+    // fills the adjacency lists from the callers and callees of all entries, call this once they are complete
+    // this allows walking the call graph without hashing symbols for every step
+    void buildAdjacency();
+
+    bool hasAdjacency() const
+    {
+        return !adjacencySymbols.isEmpty() || entries.isEmpty();
+    }
+
+    // the id of @p symbol in the adjacency lists, or -1
+    qint32 adjacencyId(const Symbol& symbol) const
+    {
+        const auto it = entries.constFind(symbol);
+        return it == entries.constEnd() ? -1 : static_cast<qint32>(it->id);
+    }
 };
 
 void callerCalleesFromBottomUpData(const BottomUpResults& data, CallerCalleeResults* results);
 
+// computes the caller/callee data of the top level bottom up rows in [begin, end)
+// the subtrees are independent, so the partial results of disjunct ranges can be merged afterwards
+CallerCalleeResults callerCalleesFromBottomUpSubtrees(const BottomUpResults& data, int begin, int end);
+
+// the views of the comparison of two captures, see BottomUpResults::compareCaptures
+// the costs are linear, so the deltas of the top down and caller/callee results follow from the bottom up deltas
+struct ComparisonResults
+{
+    BottomUpResults bottomUp;
+    TopDownResults topDown;
+    CallerCalleeResults callerCallee;
+};
+
 const constexpr auto INVALID_CPU_ID = std::numeric_limits<quint32>::max();
 const constexpr int INVALID_TID = -1;
 const constexpr int INVALID_PID = -1;
 
-struct Event
+struct TimeRange
 {
-    quint64 time = 0;
-    quint64 cost = 0;
-    qint32 type = -1;
+    constexpr TimeRange() = default;
+    constexpr TimeRange(quint64 start, quint64 end)
+        : start(start)
+        , end(end)
+    {
+    }
+
+    quint64 start = 0;
+    quint64 end = 0;
+
+    bool isValid() const
+    {
+        return start > 0 || end > 0;
+    }
+
+    bool isEmpty() const
+    {
+        return start == end;
+    }
+
+    quint64 delta() const
+    {
+        return end - start;
+    }
+
+    bool contains(quint64 time) const
+    {
+        return time >= start && time <= end;
+    }
+
+    TimeRange normalized() const
+    {
+        if (end < start)
+            return {end, start};
+        return *this;
+    }
+
+    bool operator==(TimeRange rhs) const
+    {
+        return std::tie(start, end) == std::tie(rhs.start, rhs.end);
+    }
+
+    bool operator!=(TimeRange rhs) const
+    {
+        return !operator==(rhs);
+    }
+};
+
+struct Event
+{
+    quint64 time = 0;
+    quint64 cost = 0;
+    qint32 type = -1;
     qint32 stackId = -1;
     quint32 cpuId = INVALID_CPU_ID;
 
-    bool operator==(const Event& rhs) const
+    bool operator==(const Event& rhs) const
+    {
+        return std::tie(time, cost, type, stackId, cpuId)
+            == std::tie(rhs.time, rhs.cost, rhs.type, rhs.stackId, rhs.cpuId);
+    }
+};
+
+// consecutive events that only differ in their time, like the samples of a busy loop with a fixed sample period
+// see Events, which stores the events of a thread as such runs as long as that saves memory
+struct EventRun
+{
+    // the index of the first event of the run
+    qsizetype first = 0;
+    quint64 cost = 0;
+    qint32 count = 0;
+    qint32 type = -1;
+    qint32 stackId = -1;
+    quint32 cpuId = INVALID_CPU_ID;
+
+    // whether @p event can get appended to the run
+    bool continues(const Event& event) const
+    {
+        return count < std::numeric_limits<qint32>::max()
+            && std::tie(cost, type, stackId, cpuId) == std::tie(event.cost, event.type, event.stackId, event.cpuId);
+    }
+
+    bool operator==(const EventRun& rhs) const
+    {
+        return std::tie(first, cost, count, type, stackId, cpuId)
+            == std::tie(rhs.first, rhs.cost, rhs.count, rhs.type, rhs.stackId, rhs.cpuId);
+    }
+};
+
+// when set, the large columns of the events get stored in a memory mapped file in @p path instead of on the heap
+// the kernel then writes them back and evicts them as needed, so captures larger than the RAM can be loaded
+// an empty path stores them on the heap again, this only affects columns that get allocated afterwards
+void setSpillDirectory(const QString& path);
+QString spillDirectory();
+
+class SpillFile;
+
+// a directory the large columns of the events can get stored in, see setSpillDirectory
+class SpillDirectory
+{
+public:
+    SpillDirectory() = default;
+
+    SpillDirectory(const SpillDirectory&) = delete;
+    SpillDirectory& operator=(const SpillDirectory&) = delete;
+
+    QString path() const;
+    // an empty path stores the columns on the heap again, this only affects columns that get allocated afterwards
+    void setPath(const QString& path);
+
+    // the file in the directory, created on first use and unlinked right away so that it disappears with the last
+    // buffer that got mapped from it. nullptr when the path is empty or the file can't be created
+    std::shared_ptr<SpillFile> file();
+
+private:
+    mutable QMutex m_mutex;
+    QString m_path;
+    // the buffers that are still mapped from it keep it alive when the path changes
+    std::shared_ptr<SpillFile> m_file;
+    // to only warn once when the file can't be created
+    bool m_failed = false;
+};
+
+// while this exists, the columns allocated on the current thread get stored in @p directory instead of the one of
+// setSpillDirectory. the parsers use this to apply the memory budget of one parse without affecting the others
+// a directory with an empty path falls back to the one of setSpillDirectory
+class ScopedSpillDirectory
+{
+public:
+    explicit ScopedSpillDirectory(SpillDirectory* directory);
+    ~ScopedSpillDirectory();
+
+    ScopedSpillDirectory(const ScopedSpillDirectory&) = delete;
+    ScopedSpillDirectory& operator=(const ScopedSpillDirectory&) = delete;
+
+private:
+    SpillDirectory* m_previous;
+};
+
+// the memory of a Column, either allocated on the heap or mapped from a range of the unlinked file that all the
+// spilled buffers share, see SpillFile
+class ColumnBuffer
+{
+public:
+    explicit ColumnBuffer(qint64 capacity);
+    ~ColumnBuffer();
+
+    ColumnBuffer(const ColumnBuffer&) = delete;
+    ColumnBuffer& operator=(const ColumnBuffer&) = delete;
+
+    char* data() const
+    {
+        return m_data;
+    }
+
+    qint64 capacity() const
+    {
+        return m_capacity;
+    }
+
+    bool isSpilled() const
+    {
+        return m_file != nullptr;
+    }
+
+    // smaller buffers stay on the heap, so the many small columns don't use up the memory mappings of the process
+    static constexpr qint64 MinSpilledCapacity = 1024 * 1024;
+
+    // grows the buffer to hold at least @p capacity bytes, keeping its contents
+    void grow(qint64 capacity);
+
+    // claims the @p size bytes behind @p end for the column whose values end there, false when another copy of the
+    // column appended behind them already. copies of a column share the values both hold, see Column
+    bool append(qint64 end, qint64 size)
+    {
+        return m_end.compare_exchange_strong(end, end + size);
+    }
+
+    // marks the first @p size bytes as seen by a copy of the column, which must not modify them in place anymore
+    void share(qint64 size)
+    {
+        auto shared = m_shared.load();
+        while (shared < size && !m_shared.compare_exchange_weak(shared, size)) { }
+    }
+
+    qint64 sharedSize() const
+    {
+        return m_shared.load();
+    }
+
+    // only call this while a single column uses the buffer, its values end at @p end
+    void setExclusive(qint64 end)
+    {
+        m_end = end;
+        m_shared = 0;
+    }
+
+private:
+    // maps @p capacity bytes of the spill file, returns false when the buffer has to stay on the heap
+    bool map(qint64 capacity);
+    void release();
+
+    char* m_data = nullptr;
+    qint64 m_capacity = 0;
+    // the file the buffer is mapped from and the offset of its range, nullptr for buffers on the heap
+    std::shared_ptr<SpillFile> m_file;
+    qint64 m_offset = 0;
+    // the bytes written by the columns using the buffer and the ones their copies saw, see Column
+    std::atomic<qint64> m_end {0};
+    std::atomic<qint64> m_shared {0};
+};
+
+// an append-only array of plain values, used for the columns of Events
+// copies share their buffer until one of them modifies a value they both hold, like QVector. appending behind the
+// values of the copies doesn't disturb them though, so taking a snapshot of a growing column doesn't copy it
+template<typename T>
+class Column
+{
+    static_assert(std::is_trivially_copyable_v<T>, "the values get copied bytewise");
+
+public:
+    using value_type = T;
+    using const_iterator = const T*;
+    using const_reverse_iterator = std::reverse_iterator<const T*>;
+
+    Column() = default;
+    Column(const Column& other)
+        : m_buffer(other.m_buffer)
+        , m_size(other.m_size)
+    {
+        share();
+    }
+    Column(Column&& other) = default;
+
+    Column& operator=(const Column& other)
+    {
+        m_buffer = other.m_buffer;
+        m_size = other.m_size;
+        share();
+        return *this;
+    }
+    Column& operator=(Column&& other) = default;
+
+    qsizetype size() const
+    {
+        return m_size;
+    }
+
+    bool isEmpty() const
+    {
+        return m_size == 0;
+    }
+
+    const T* constData() const
+    {
+        return m_buffer ? reinterpret_cast<const T*>(m_buffer->data()) : nullptr;
+    }
+
+    const T& at(qsizetype i) const
+    {
+        Q_ASSERT(i >= 0 && i < m_size);
+        return constData()[i];
+    }
+
+    const T& operator[](qsizetype i) const
+    {
+        return at(i);
+    }
+
+    T& operator[](qsizetype i)
+    {
+        Q_ASSERT(i >= 0 && i < m_size);
+        if (isShared(i)) {
+            detach(m_size);
+        }
+        return data()[i];
+    }
+
+    const T& last() const
+    {
+        return at(m_size - 1);
+    }
+
+    const_iterator begin() const
+    {
+        return constData();
+    }
+    const_iterator end() const
+    {
+        return constData() + m_size;
+    }
+    const_reverse_iterator rbegin() const
+    {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator rend() const
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    void reserve(qsizetype size)
+    {
+        if (size > capacity()) {
+            detach(size);
+        }
+    }
+
+    void clear()
+    {
+        m_buffer.reset();
+        m_size = 0;
+    }
+
+    void push_back(const T& value)
+    {
+        // only one of the copies can append in place, the others have to detach
+        if (m_size == capacity()) {
+            detach(std::max<qsizetype>(m_size * 2, MinCapacity));
+        } else if (!m_buffer->append(m_size * sizeof(T), sizeof(T))) {
+            detach(m_size + 1);
+        } else {
+            data()[m_size++] = value;
+            return;
+        }
+        m_buffer->setExclusive((m_size + 1) * sizeof(T));
+        data()[m_size++] = value;
+    }
+
+    void resize(qsizetype size)
+    {
+        if (size > m_size) {
+            detach(size);
+            std::fill(data() + m_size, data() + size, T());
+            m_buffer->setExclusive(size * sizeof(T));
+        }
+        m_size = size;
+    }
+
+    // whether another copy of the column holds the value at @p i as well
+    bool isShared(qsizetype i) const
+    {
+        return m_buffer.use_count() > 1 && static_cast<qint64>(i * sizeof(T)) < m_buffer->sharedSize();
+    }
+
+    // the bytes allocated on the heap, spilled columns don't count as the kernel can evict them
+    // shared buffers get counted for every copy
+    qint64 memoryUsage() const
+    {
+        return m_buffer && !m_buffer->isSpilled() ? m_buffer->capacity() : 0;
+    }
+
+    bool operator==(const Column& rhs) const
+    {
+        return m_size == rhs.m_size && std::equal(begin(), end(), rhs.begin());
+    }
+
+    bool operator!=(const Column& rhs) const
+    {
+        return !operator==(rhs);
+    }
+
+private:
+    static constexpr qsizetype MinCapacity = 64;
+
+    qsizetype capacity() const
+    {
+        return m_buffer ? static_cast<qsizetype>(m_buffer->capacity() / sizeof(T)) : 0;
+    }
+
+    T* data()
+    {
+        return reinterpret_cast<T*>(m_buffer->data());
+    }
+
+    void share()
+    {
+        if (m_buffer) {
+            m_buffer->share(m_size * sizeof(T));
+        }
+    }
+
+    // makes sure that the buffer isn't shared and can hold at least @p capacity values
+    void detach(qsizetype capacity)
+    {
+        capacity = std::max(capacity, m_size);
+        if (m_buffer && m_buffer.use_count() == 1) {
+            if (capacity > this->capacity()) {
+                m_buffer->grow(capacity * sizeof(T));
+            }
+            m_buffer->setExclusive(m_size * sizeof(T));
+            return;
+        }
+
+        auto buffer = std::make_shared<ColumnBuffer>(std::max<qsizetype>(capacity, 1) * sizeof(T));
+        if (m_size) {
+            std::memcpy(buffer->data(), constData(), m_size * sizeof(T));
+        }
+        buffer->setExclusive(m_size * sizeof(T));
+        m_buffer = std::move(buffer);
+    }
+
+    std::shared_ptr<ColumnBuffer> m_buffer;
+    qsizetype m_size = 0;
+};
+
+// the index of the run in @p runs that contains the event @p index
+// the runs next to @p hint get checked first, which makes sequential lookups take constant time
+inline qsizetype findRun(const Column<EventRun>& runs, qsizetype index, qsizetype hint)
+{
+    auto contains = [&runs, index](qsizetype run) {
+        const auto& eventRun = runs.at(run);
+        return index >= eventRun.first && index < eventRun.first + eventRun.count;
+    };
+    if (hint >= 0 && hint < runs.size()) {
+        if (contains(hint)) {
+            return hint;
+        } else if (hint + 1 < runs.size() && contains(hint + 1)) {
+            return hint + 1;
+        } else if (hint > 0 && contains(hint - 1)) {
+            return hint - 1;
+        }
+    }
+    const auto it = std::upper_bound(runs.begin(), runs.end(), index,
+                                     [](qsizetype index, const EventRun& run) { return index < run.first; });
+    return std::distance(runs.begin(), it) - 1;
+}
+
+// read access to one member of the events like to a Column, no matter whether Events stores them as runs
+// the view remembers the run of the last lookup, so scans over coalesced events don't search every value
+template<typename T>
+class EventColumn
+{
+public:
+    using value_type = T;
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = qsizetype;
+        using pointer = const T*;
+        using reference = T;
+
+        const_iterator() = default;
+        const_iterator(const EventColumn* column, qsizetype index)
+            : m_column(column)
+            , m_index(index)
+        {
+        }
+
+        T operator*() const
+        {
+            return m_column->at(m_index);
+        }
+        T operator[](difference_type offset) const
+        {
+            return m_column->at(m_index + offset);
+        }
+
+        const_iterator& operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            auto ret = *this;
+            ++m_index;
+            return ret;
+        }
+        const_iterator& operator--()
+        {
+            --m_index;
+            return *this;
+        }
+        const_iterator operator--(int)
+        {
+            auto ret = *this;
+            --m_index;
+            return ret;
+        }
+        const_iterator& operator+=(difference_type offset)
+        {
+            m_index += offset;
+            return *this;
+        }
+        const_iterator& operator-=(difference_type offset)
+        {
+            m_index -= offset;
+            return *this;
+        }
+        const_iterator operator+(difference_type offset) const
+        {
+            return {m_column, m_index + offset};
+        }
+        const_iterator operator-(difference_type offset) const
+        {
+            return {m_column, m_index - offset};
+        }
+        difference_type operator-(const const_iterator& rhs) const
+        {
+            return m_index - rhs.m_index;
+        }
+
+        bool operator==(const const_iterator& rhs) const
+        {
+            return m_index == rhs.m_index;
+        }
+        bool operator!=(const const_iterator& rhs) const
+        {
+            return m_index != rhs.m_index;
+        }
+        bool operator<(const const_iterator& rhs) const
+        {
+            return m_index < rhs.m_index;
+        }
+        bool operator>(const const_iterator& rhs) const
+        {
+            return m_index > rhs.m_index;
+        }
+        bool operator<=(const const_iterator& rhs) const
+        {
+            return m_index <= rhs.m_index;
+        }
+        bool operator>=(const const_iterator& rhs) const
+        {
+            return m_index >= rhs.m_index;
+        }
+
+    private:
+        const EventColumn* m_column = nullptr;
+        qsizetype m_index = 0;
+    };
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    // reads @p column, or the @p member of the @p runs when they are set
+    EventColumn(const Column<T>* column, const Column<EventRun>* runs, T EventRun::*member, qsizetype size)
+        : m_column(column)
+        , m_runs(runs)
+        , m_member(member)
+        , m_size(size)
+    {
+    }
+
+    qsizetype size() const
+    {
+        return m_size;
+    }
+
+    bool isEmpty() const
+    {
+        return m_size == 0;
+    }
+
+    T at(qsizetype i) const
+    {
+        if (!m_runs) {
+            return m_column->at(i);
+        }
+        Q_ASSERT(i >= 0 && i < m_size);
+        m_run = findRun(*m_runs, i, m_run);
+        return m_runs->at(m_run).*m_member;
+    }
+
+    T operator[](qsizetype i) const
+    {
+        return at(i);
+    }
+
+    // the stored values, only available when the events aren't coalesced
+    const T* constData() const
+    {
+        return m_runs ? nullptr : m_column->constData();
+    }
+
+    const_iterator begin() const
+    {
+        return {this, 0};
+    }
+    const_iterator end() const
+    {
+        return {this, m_size};
+    }
+    const_reverse_iterator rbegin() const
+    {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator rend() const
+    {
+        return const_reverse_iterator(begin());
+    }
+
+private:
+    const Column<T>* m_column;
+    const Column<EventRun>* m_runs;
+    T EventRun::*m_member;
+    qsizetype m_size;
+    mutable qsizetype m_run = 0;
+};
+
+// compressed storage for event timestamps
+// the values are grouped into blocks of fixed size, each block stores the first time as an absolute anchor
+// and every value as a 32bit delta to that anchor. values that don't fit are stored separately
+// additionally the minimum and maximum time of every block is kept, which allows to skip whole blocks
+class TimeColumn
+{
+public:
+    static constexpr qsizetype BlockSize = 256;
+
+    qsizetype size() const
+    {
+        return m_deltas.size();
+    }
+
+    bool isEmpty() const
+    {
+        return m_deltas.isEmpty();
+    }
+
+    void reserve(qsizetype size)
+    {
+        m_deltas.reserve(size);
+        m_anchors.reserve(size / BlockSize + 1);
+    }
+
+    void clear()
+    {
+        m_deltas.clear();
+        m_anchors.clear();
+        m_blockRanges.clear();
+        m_outliers.clear();
+    }
+
+    void push_back(quint64 time)
+    {
+        const auto index = m_deltas.size();
+        if (index % BlockSize == 0) {
+            m_anchors.push_back(time);
+            m_blockRanges.push_back({time, time});
+        } else {
+            auto& range = m_blockRanges.last();
+            range.start = std::min(range.start, time);
+            range.end = std::max(range.end, time);
+        }
+        const auto anchor = m_anchors.last();
+        if (time >= anchor && time - anchor < OutlierDelta) {
+            m_deltas.push_back(static_cast<quint32>(time - anchor));
+        } else {
+            m_deltas.push_back(OutlierDelta);
+            m_outliers.insert(index, time);
+        }
+    }
+
+    quint64 at(qsizetype i) const
+    {
+        const auto delta = m_deltas.at(i);
+        if (delta == OutlierDelta) {
+            return m_outliers.value(i);
+        }
+        return m_anchors.at(i / BlockSize) + delta;
+    }
+
+    // the blocks can be scanned individually, e.g. to skip blocks that start after a given time
+    // see Column::memoryUsage
+    qint64 memoryUsage() const
+    {
+        return m_deltas.memoryUsage() + m_anchors.capacity() * sizeof(quint64)
+            + m_blockRanges.capacity() * sizeof(TimeRange)
+            + m_outliers.size() * (sizeof(qsizetype) + sizeof(quint64) + 2 * sizeof(void*));
+    }
+
+    qsizetype blockCount() const
+    {
+        return m_anchors.size();
+    }
+
+    quint64 blockAnchor(qsizetype block) const
+    {
+        return m_anchors.at(block);
+    }
+
+    // the minimum and maximum time within the block
+    TimeRange blockRange(qsizetype block) const
+    {
+        return m_blockRanges.at(block);
+    }
+
+    // returns the index of the first value in [from, size()) that is not smaller than @p time
+    // like std::lower_bound this requires the values to be sorted
+    qsizetype lowerBound(quint64 time, qsizetype from = 0) const
+    {
+        // find the first block that can contain the time, then search within that block only
+        auto blockIt = std::partition_point(m_blockRanges.begin() + from / BlockSize, m_blockRanges.end(),
+                                            [time](const TimeRange& range) { return range.end < time; });
+        if (blockIt == m_blockRanges.end()) {
+            return size();
+        }
+        const qsizetype block = std::distance(m_blockRanges.begin(), blockIt);
+        auto first = std::max(from, block * BlockSize);
+        auto last = std::min(size(), (block + 1) * BlockSize);
+        while (first < last) {
+            const auto mid = first + (last - first) / 2;
+            if (at(mid) < time) {
+                first = mid + 1;
+            } else {
+                last = mid;
+            }
+        }
+        return first;
+    }
+
+    bool operator==(const TimeColumn& rhs) const
+    {
+        return std::tie(m_anchors, m_deltas, m_outliers) == std::tie(rhs.m_anchors, rhs.m_deltas, rhs.m_outliers);
+    }
+
+private:
+    static constexpr quint32 OutlierDelta = std::numeric_limits<quint32>::max();
+
+    QVector<quint64> m_anchors;
+    QVector<TimeRange> m_blockRanges;
+    Column<quint32> m_deltas;
+    QHash<qsizetype, quint64> m_outliers;
+};
+
+// stores the events column-wise, i.e. every member of Event lives in its own array
+// this keeps the events compact and allows scans to only touch the columns they need
+// the events start out coalesced: everything but the time gets stored once per EventRun, which shrinks the loops
+// and spin waits of fixed period samples a lot. once the runs get too short to save memory, the events get expanded
+// into the columns for good. scans can handle the runs at once with forEachRun in either case
+class Events
+{
+public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = Event;
+        using difference_type = qsizetype;
+        using reference = Event;
+
+        struct pointer
+        {
+            Event event;
+            const Event* operator->() const
+            {
+                return &event;
+            }
+        };
+
+        const_iterator() = default;
+        const_iterator(const Events* events, qsizetype index)
+            : m_events(events)
+            , m_index(index)
+        {
+        }
+
+        Event operator*() const
+        {
+            return m_events->at(m_index, &m_run);
+        }
+        pointer operator->() const
+        {
+            return {m_events->at(m_index, &m_run)};
+        }
+        Event operator[](difference_type offset) const
+        {
+            return m_events->at(m_index + offset, &m_run);
+        }
+
+        qsizetype index() const
+        {
+            return m_index;
+        }
+
+        const_iterator& operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            auto ret = *this;
+            ++m_index;
+            return ret;
+        }
+        const_iterator& operator--()
+        {
+            --m_index;
+            return *this;
+        }
+        const_iterator operator--(int)
+        {
+            auto ret = *this;
+            --m_index;
+            return ret;
+        }
+        const_iterator& operator+=(difference_type offset)
+        {
+            m_index += offset;
+            return *this;
+        }
+        const_iterator& operator-=(difference_type offset)
+        {
+            m_index -= offset;
+            return *this;
+        }
+        const_iterator operator+(difference_type offset) const
+        {
+            return {m_events, m_index + offset};
+        }
+        friend const_iterator operator+(difference_type offset, const const_iterator& it)
+        {
+            return it + offset;
+        }
+        const_iterator operator-(difference_type offset) const
+        {
+            return {m_events, m_index - offset};
+        }
+        difference_type operator-(const const_iterator& rhs) const
+        {
+            return m_index - rhs.m_index;
+        }
+
+        bool operator==(const const_iterator& rhs) const
+        {
+            return m_index == rhs.m_index;
+        }
+        bool operator!=(const const_iterator& rhs) const
+        {
+            return m_index != rhs.m_index;
+        }
+        bool operator<(const const_iterator& rhs) const
+        {
+            return m_index < rhs.m_index;
+        }
+        bool operator>(const const_iterator& rhs) const
+        {
+            return m_index > rhs.m_index;
+        }
+        bool operator<=(const const_iterator& rhs) const
+        {
+            return m_index <= rhs.m_index;
+        }
+        bool operator>=(const const_iterator& rhs) const
+        {
+            return m_index >= rhs.m_index;
+        }
+
+    private:
+        const Events* m_events = nullptr;
+        qsizetype m_index = 0;
+        // the run of the last access, see findRun
+        mutable qsizetype m_run = 0;
+    };
+    using iterator = const_iterator;
+
+    qsizetype size() const
+    {
+        return m_times.size();
+    }
+
+    bool isEmpty() const
+    {
+        return m_times.isEmpty();
+    }
+
+    void reserve(qsizetype size)
+    {
+        m_times.reserve(size);
+        if (!m_coalesced) {
+            m_costs.reserve(size);
+            m_types.reserve(size);
+            m_stackIds.reserve(size);
+            m_cpuIds.reserve(size);
+        }
+    }
+
+    void clear()
+    {
+        m_times.clear();
+        m_runs.clear();
+        m_coalesced = true;
+        m_costs.clear();
+        m_types.clear();
+        m_stackIds.clear();
+        m_cpuIds.clear();
+    }
+
+    void push_back(const Event& event)
+    {
+        m_times.push_back(event.time);
+        if (!m_coalesced) {
+            m_costs.push_back(event.cost);
+            m_types.push_back(event.type);
+            m_stackIds.push_back(event.stackId);
+            m_cpuIds.push_back(event.cpuId);
+            return;
+        }
+
+        if (!m_runs.isEmpty() && m_runs.last().continues(event)) {
+            ++m_runs[m_runs.size() - 1].count;
+            return;
+        }
+        m_runs.push_back({size() - 1, event.cost, 1, event.type, event.stackId, event.cpuId});
+        if (size() >= MinCoalescedEvents && size() < m_runs.size() * MinAverageRunLength) {
+            expand();
+        }
+    }
+
+    // whether the events are stored as runs, see EventRun
+    bool isCoalesced() const
+    {
+        return m_coalesced;
+    }
+
+    Events& operator<<(const Event& event)
+    {
+        push_back(event);
+        return *this;
+    }
+
+    Event at(qsizetype i) const
+    {
+        qsizetype run = 0;
+        return at(i, &run);
+    }
+
+    // like at, starting the lookup of the run at @p run, which gets updated, see findRun
+    Event at(qsizetype i, qsizetype* run) const
+    {
+        if (!m_coalesced) {
+            return {m_times.at(i), m_costs.at(i), m_types.at(i), m_stackIds.at(i), m_cpuIds.at(i)};
+        }
+        *run = findRun(m_runs, i, *run);
+        const auto& eventRun = m_runs.at(*run);
+        return {m_times.at(i), eventRun.cost, eventRun.type, eventRun.stackId, eventRun.cpuId};
+    }
+
+    Event operator[](qsizetype i) const
     {
-        return std::tie(time, cost, type, stackId, cpuId)
-            == std::tie(rhs.time, rhs.cost, rhs.type, rhs.stackId, rhs.cpuId);
+        return at(i);
     }
-};
 
-using Events = QVector<Event>;
+    Event first() const
+    {
+        return at(0);
+    }
 
-struct TimeRange
-{
-    constexpr TimeRange() = default;
-    constexpr TimeRange(quint64 start, quint64 end)
-        : start(start)
-        , end(end)
+    Event last() const
     {
+        return at(size() - 1);
     }
 
-    quint64 start = 0;
-    quint64 end = 0;
+    const_iterator begin() const
+    {
+        return {this, 0};
+    }
+    const_iterator end() const
+    {
+        return {this, size()};
+    }
+    const_iterator constBegin() const
+    {
+        return begin();
+    }
+    const_iterator constEnd() const
+    {
+        return end();
+    }
 
-    bool isValid() const
+    // direct access to the individual columns
+    const TimeColumn& times() const
     {
-        return start > 0 || end > 0;
+        return m_times;
+    }
+    EventColumn<quint64> costs() const
+    {
+        return column(&m_costs, &EventRun::cost);
+    }
+    EventColumn<qint32> types() const
+    {
+        return column(&m_types, &EventRun::type);
+    }
+    EventColumn<qint32> stackIds() const
+    {
+        return column(&m_stackIds, &EventRun::stackId);
+    }
+    EventColumn<quint32> cpuIds() const
+    {
+        return column(&m_cpuIds, &EventRun::cpuId);
     }
 
-    bool isEmpty() const
+    // calls @p callback with the runs of the events, starting at the event @p from, until it returns false
+    // events that aren't coalesced get merged into runs on the fly, so scans that only need the sum of the costs
+    // handle every run at once either way
+    template<typename Callback>
+    void forEachRun(Callback&& callback, qsizetype from = 0) const
     {
-        return start == end;
+        if (from >= size()) {
+            return;
+        }
+
+        if (m_coalesced) {
+            for (qsizetype i = findRun(m_runs, from, 0), c = m_runs.size(); i < c; ++i) {
+                auto run = m_runs.at(i);
+                if (run.first < from) {
+                    run.count -= from - run.first;
+                    run.first = from;
+                }
+                if (!callback(std::as_const(run))) {
+                    return;
+                }
+            }
+            return;
+        }
+
+        EventRun run;
+        for (qsizetype i = from, c = size(); i < c; ++i) {
+            const Event event = {0, m_costs.at(i), m_types.at(i), m_stackIds.at(i), m_cpuIds.at(i)};
+            if (run.count && run.continues(event)) {
+                ++run.count;
+                continue;
+            }
+            if (run.count && !callback(std::as_const(run))) {
+                return;
+            }
+            run = {i, event.cost, 1, event.type, event.stackId, event.cpuId};
+        }
+        callback(std::as_const(run));
     }
 
-    quint64 delta() const
+    // the highest cost of a single event of @p type
+    quint64 maxCost(qint32 type) const
     {
-        return end - start;
+        quint64 ret = 0;
+        forEachRun([&ret, type](const EventRun& run) {
+            if (run.type == type) {
+                ret = std::max(run.cost, ret);
+            }
+            return true;
+        });
+        return ret;
     }
 
-    bool contains(quint64 time) const
+    // returns the index of the first event in [from, size()) whose time is not smaller than @p time
+    // like std::lower_bound this requires the events to be sorted by time
+    qsizetype lowerBound(quint64 time, qsizetype from = 0) const
     {
-        return time >= start && time <= end;
+        return m_times.lowerBound(time, from);
     }
 
-    TimeRange normalized() const
+    // removes all events whose time lies outside of @p range
+    // blocks that lie completely in- or outside of the range don't need to check the individual times
+    void retainTimeRange(TimeRange range)
     {
-        if (end < start)
-            return {end, start};
-        return *this;
+        Events ret;
+        for (qsizetype block = 0, numBlocks = m_times.blockCount(); block < numBlocks; ++block) {
+            const auto blockRange = m_times.blockRange(block);
+            if (blockRange.end < range.start || blockRange.start > range.end) {
+                continue;
+            }
+            const bool containsBlock = range.contains(blockRange.start) && range.contains(blockRange.end);
+            qsizetype run = 0;
+            for (qsizetype i = block * TimeColumn::BlockSize,
+                           end = std::min(size(), (block + 1) * TimeColumn::BlockSize);
+                 i < end; ++i) {
+                if (containsBlock || range.contains(m_times.at(i))) {
+                    ret.push_back(at(i, &run));
+                }
+            }
+        }
+        *this = std::move(ret);
     }
 
-    bool operator==(TimeRange rhs) const
+    // removes all events for which @p predicate returns true, preserving the order of the remaining ones
+    template<typename Predicate>
+    void removeIf(Predicate predicate)
     {
-        return std::tie(start, end) == std::tie(rhs.start, rhs.end);
+        if (m_coalesced) {
+            // rebuild the runs, the ones that become adjacent may get merged
+            Events ret;
+            qsizetype run = 0;
+            for (qsizetype i = 0, c = size(); i < c; ++i) {
+                const auto event = at(i, &run);
+                if (!predicate(event)) {
+                    ret.push_back(event);
+                }
+            }
+            *this = std::move(ret);
+            return;
+        }
+
+        // the time deltas depend on the block layout, so that column gets rebuilt
+        TimeColumn times;
+        qsizetype out = 0;
+        for (qsizetype i = 0, c = size(); i < c; ++i) {
+            if (predicate(at(i))) {
+                continue;
+            }
+            times.push_back(m_times.at(i));
+            if (out != i) {
+                m_costs[out] = m_costs.at(i);
+                m_types[out] = m_types.at(i);
+                m_stackIds[out] = m_stackIds.at(i);
+                m_cpuIds[out] = m_cpuIds.at(i);
+            }
+            ++out;
+        }
+        m_times = std::move(times);
+        m_costs.resize(out);
+        m_types.resize(out);
+        m_stackIds.resize(out);
+        m_cpuIds.resize(out);
     }
 
-    bool operator!=(TimeRange rhs) const
+    // see Column::memoryUsage
+    qint64 memoryUsage() const
+    {
+        return m_times.memoryUsage() + m_runs.memoryUsage() + m_costs.memoryUsage() + m_types.memoryUsage()
+            + m_stackIds.memoryUsage() + m_cpuIds.memoryUsage();
+    }
+
+    bool operator==(const Events& rhs) const
+    {
+        if (m_coalesced != rhs.m_coalesced) {
+            return size() == rhs.size() && std::equal(begin(), end(), rhs.begin());
+        }
+        return std::tie(m_times, m_runs, m_costs, m_types, m_stackIds, m_cpuIds)
+            == std::tie(rhs.m_times, rhs.m_runs, rhs.m_costs, rhs.m_types, rhs.m_stackIds, rhs.m_cpuIds);
+    }
+
+    bool operator!=(const Events& rhs) const
     {
         return !operator==(rhs);
     }
+
+private:
+    // the runs only save memory when they are longer than this on average, a run takes 32 bytes instead of 20
+    static constexpr qsizetype MinAverageRunLength = 4;
+    // the number of events after which the average length of the runs gets checked
+    static constexpr qsizetype MinCoalescedEvents = 1024;
+
+    template<typename T>
+    EventColumn<T> column(const Column<T>* column, T EventRun::*member) const
+    {
+        return {column, m_coalesced ? &m_runs : nullptr, member, size()};
+    }
+
+    // stores the runs in the columns
+    void expand()
+    {
+        const auto runs = m_runs;
+        m_runs.clear();
+        m_coalesced = false;
+        reserve(size());
+        for (const auto& run : runs) {
+            for (qint32 i = 0; i < run.count; ++i) {
+                m_costs.push_back(run.cost);
+                m_types.push_back(run.type);
+                m_stackIds.push_back(run.stackId);
+                m_cpuIds.push_back(run.cpuId);
+            }
+        }
+    }
+
+    TimeColumn m_times;
+    // either the runs or the columns below store everything but the times
+    Column<EventRun> m_runs;
+    bool m_coalesced = true;
+    Column<quint64> m_costs;
+    Column<qint32> m_types;
+    Column<qint32> m_stackIds;
+    Column<quint32> m_cpuIds;
 };
 
 const constexpr auto MAX_TIME = std::numeric_limits<quint64>::max();
 const constexpr auto MAX_TIME_RANGE = TimeRange {0, MAX_TIME};
 
+// counts durations in power of two buckets, cheap enough to be updated for every context switch while parsing
+struct DurationHistogram
+{
+    // bucket 0 counts empty durations, bucket i the durations in [2^(i-1), 2^i)
+    static const constexpr int NumBuckets = 65;
+
+    std::array<quint32, NumBuckets> counts = {};
+    quint64 count = 0;
+    quint64 total = 0;
+    quint64 max = 0;
+
+    static int bucket(quint64 duration)
+    {
+        return duration ? 64 - qCountLeadingZeroBits(duration) : 0;
+    }
+
+    // the largest duration that can end up in the given bucket
+    static quint64 bucketEnd(int bucket)
+    {
+        return bucket >= 64 ? std::numeric_limits<quint64>::max() : (quint64(1) << bucket) - 1;
+    }
+
+    bool isEmpty() const
+    {
+        return count == 0;
+    }
+
+    void add(quint64 duration)
+    {
+        ++counts[bucket(duration)];
+        ++count;
+        total += duration;
+        max = std::max(max, duration);
+    }
+
+    void merge(const DurationHistogram& rhs);
+
+    // an upper bound for the given percentile in [0, 1], precise up to the bucket resolution
+    quint64 percentile(double percentile) const;
+
+    bool operator==(const DurationHistogram& rhs) const
+    {
+        return std::tie(counts, count, total, max) == std::tie(rhs.counts, rhs.count, rhs.total, rhs.max);
+    }
+};
+
 struct ThreadEvents
 {
     qint32 pid = INVALID_PID;
@@ -746,6 +2511,9 @@ struct ThreadEvents
     QString name;
     quint64 lastSwitchTime = MAX_TIME;
     quint64 offCpuTime = 0;
+    // the lengths of the slices the thread ran without a context switch and of the times it was switched out
+    DurationHistogram onCpuSlices;
+    DurationHistogram offCpuDurations;
     enum State
     {
         Unknown,
@@ -753,23 +2521,48 @@ struct ThreadEvents
         OffCpu
     };
     State state = Unknown;
+    // the highest cost of a single event of the first cost type, derived from the events, see updateMaxCost
+    quint64 maxCost = 0;
+    // how often the events moved to a CPU of another NUMA node, see EventResults::updateNumaMigrations
+    quint64 numaMigrations = 0;
+
+    void updateMaxCost()
+    {
+        // TODO: support multiple cost types somehow
+        maxCost = events.maxCost(0);
+    }
 
     bool operator==(const ThreadEvents& rhs) const
     {
-        return std::tie(pid, tid, time, events, name, lastSwitchTime, offCpuTime, state)
+        return std::tie(pid, tid, time, events, name, lastSwitchTime, offCpuTime, onCpuSlices, offCpuDurations, state)
             == std::tie(rhs.pid, rhs.tid, rhs.time, rhs.events, rhs.name, rhs.lastSwitchTime, rhs.offCpuTime,
-                        rhs.state);
+                        rhs.onCpuSlices, rhs.offCpuDurations, rhs.state);
+    }
+};
+
+// refers to an event stored in one of the threads of the EventResults
+struct EventIndex
+{
+    qint32 thread = -1;
+    qint32 event = -1;
+
+    bool operator==(const EventIndex& rhs) const
+    {
+        return std::tie(thread, event) == std::tie(rhs.thread, rhs.event);
     }
 };
 
 struct CpuEvents
 {
     quint32 cpuId = INVALID_CPU_ID;
-    QVector<Event> events;
+    // from the NUMA topology of the capture, -1 when it is unknown
+    qint32 numaNode = -1;
+    // the events are shared with the threads, use EventResults::cpuEvents to resolve them
+    QVector<EventIndex> events;
 
     bool operator==(const CpuEvents& rhs) const
     {
-        return std::tie(cpuId, events) == std::tie(rhs.cpuId, rhs.events);
+        return std::tie(cpuId, numaNode, events) == std::tie(rhs.cpuId, rhs.numaNode, rhs.events);
     }
 };
 
@@ -797,6 +2590,15 @@ struct CostSummary
 
 QDebug operator<<(QDebug stream, const CostSummary& symbol);
 
+struct CounterSummary
+{
+    QString name;
+    double value = 0;
+    QString unit;
+    // the metrics are derived from the counts of the events, e.g. the instructions per cycle
+    bool isMetric = false;
+};
+
 struct Summary
 {
     TimeRange applicationTime;
@@ -819,10 +2621,27 @@ struct Summary
     // only non-zero when perf record --switch-events was used
     quint64 onCpuTime = 0;
     quint64 offCpuTime = 0;
+    // merged from the per-thread histograms, see ThreadEvents
+    DurationHistogram onCpuSlices;
+    DurationHistogram offCpuDurations;
+    // the latencies of the syscalls by their number, paired from the raw_syscalls tracepoints
+    QMap<qint64, DurationHistogram> syscallLatencies;
+
+    // the user stacks whose outermost frame isn't an entry point like _start got truncated, only counted when
+    // recorded with --call-graph dwarf, where stackDumpSize is the size of the copies of the user stacks
+    quint64 userStackCount = 0;
+    quint64 truncatedStackCount = 0;
+    quint32 stackDumpSize = 0;
+    // the size to record with next time, 0 when only a few stacks got truncated
+    quint32 suggestedStackDumpSize = 0;
+
+    // the totals of perf stat, which counts the events instead of sampling them, see PerfStat
+    QVector<CounterSummary> counters;
 
     // total number of samples
     quint64 sampleCount = 0;
     QVector<CostSummary> costs;
+    TopCosts topCosts;
 
     QStringList errors;
 };
@@ -832,34 +2651,253 @@ struct ThreadNames
     QHash<qint32, QHash<qint32, QString>> names;
 };
 
+// the lost events of all threads and CPUs within one window of time, see EventResults::lostEvents
+struct LostEvents
+{
+    TimeRange time;
+    quint32 chunks = 0;
+    // the number of events perf reported as lost
+    quint64 lost = 0;
+    // the number of samples that got recorded nonetheless, see EventResults::countLostEventSamples
+    quint64 samples = 0;
+
+    // the factor that estimates the cost of the lost samples when applied to the cost of the recorded ones
+    double correction() const
+    {
+        return samples ? static_cast<double>(samples + lost) / samples : 1.;
+    }
+
+    bool operator==(const LostEvents& rhs) const
+    {
+        return std::tie(time, chunks, lost, samples) == std::tie(rhs.time, rhs.chunks, rhs.lost, rhs.samples);
+    }
+};
+
+// like all the results, these get published once and then shared by the parser and all the views
+// the containers are implicitly shared, so copying is cheap as long as nobody modifies the copy
+// modifying would duplicate the modified containers, so views derive what they need instead, see EventModel
 struct EventResults
 {
     QVector<ThreadEvents> threads;
     QVector<CpuEvents> cpus;
     QVector<QVector<qint32>> stacks;
     QVector<CostSummary> totalCosts;
+    // ordered by time, the lost events never have a valid CPU set, so they are stored once instead of for every CPU
+    QVector<LostEvents> lostEvents;
     qint32 offCpuTimeCostId = -1;
+    // the off-CPU time got sampled with perf record --off-cpu rather than computed from the context switches
+    bool offCpuTimeSampled = false;
+    // the time between the raw_syscalls:sys_enter and sys_exit tracepoints, only added to the threads
+    qint32 syscallTimeCostId = -1;
     qint32 lostEventCostId = -1;
+    // the highest ThreadEvents::maxCost, this is computed while parsing or filtering to keep it off the GUI thread
+    quint64 maxCost = 0;
+    // how often the events of a thread moved onto a NUMA node from another one, indexed by the node
+    // like maxCost, this is computed while parsing or filtering
+    QVector<quint64> numaMigrations;
+
+    // call this once ThreadEvents::maxCost is up to date for all threads
+    void updateMaxCost();
+    // computes the migrations of the threads and NUMA nodes from the CPUs of their events
+    void updateNumaMigrations();
+
+    // the NUMA node of the CPU, -1 when it is unknown
+    qint32 numaNode(quint32 cpuId) const
+    {
+        return cpuId < static_cast<quint32>(cpus.size()) ? cpus[cpuId].numaNode : -1;
+    }
 
     ThreadEvents* findThread(qint32 pid, qint32 tid);
     const ThreadEvents* findThread(qint32 pid, qint32 tid) const;
 
+    // resolve the events of @p cpu, which are stored in the threads
+    Events cpuEvents(const CpuEvents& cpu) const;
+
+    // the lost events get merged into windows of this size
+    static const constexpr quint64 LostEventsWindow = 10000000;
+
+    void addLostEvents(quint64 time, quint64 lost);
+    // the window of lost events that contains @p time, or nullptr when no events got lost then
+    const LostEvents* lostEventsAt(quint64 time) const;
+    // the windows of lost events that overlap @p range
+    std::pair<qsizetype, qsizetype> lostEventsInRange(TimeRange range) const;
+    // fill LostEvents::samples, call this once all samples got added to the threads
+    void countLostEventSamples();
+    // the cost of @p event, samples get scaled up by the correction of the window of lost events they fall into
+    quint64 correctedCost(const Event& event) const;
+
     bool operator==(const EventResults& rhs) const
     {
-        return std::tie(threads, cpus, stacks, totalCosts, offCpuTimeCostId)
-            == std::tie(rhs.threads, rhs.cpus, rhs.stacks, rhs.totalCosts, rhs.offCpuTimeCostId);
+        return std::tie(threads, cpus, stacks, totalCosts, lostEvents, offCpuTimeCostId, offCpuTimeSampled)
+            == std::tie(rhs.threads, rhs.cpus, rhs.stacks, rhs.totalCosts, rhs.lostEvents, rhs.offCpuTimeCostId,
+                        rhs.offCpuTimeSampled);
     }
 };
 
+// computes the source and offset maps of the caller/callee entries on demand from the samples
+// only few symbols ever get opened in the source or disassembly views, so this is cheaper than building the maps
+// for all of them while parsing. the maps get cached per symbol and the index can be used from any thread
+class LocationCostIndex
+{
+public:
+    LocationCostIndex(const BottomUpResults& bottomUp, const EventResults& events);
+    ~LocationCostIndex();
+
+    struct LocationMaps
+    {
+        SourceLocationCostMap sourceMap;
+        OffsetLocationCostMap offsetMap;
+    };
+    LocationMaps locationMaps(const Symbol& symbol) const;
+    // whether locationMaps returns the cached maps of @p symbol
+    bool isCached(const Symbol& symbol) const;
+
+    // when disabled, the maps get computed again every time they are asked for, which keeps the memory bounded
+    void setCacheEnabled(bool enabled);
+
+    // the estimated bytes of the cached maps
+    qint64 memoryUsage() const;
+
+    // see CallerCalleeResults::selfOffsetMaps
+    QHash<Symbol, OffsetLocationCostMap> selfOffsetMaps() const;
+
+    // the line costs of all symbols, see CallerCalleeResults::fileCosts
+    QHash<QString, FileLineCostMap> fileCosts() const;
+
+private:
+    // calls @p callback for every sample with a stack, the frames can be walked with m_frames.foreachFrame
+    template<typename Callback>
+    void forEachSample(Callback&& callback) const;
+
+    // only the symbol and location tables are needed to resolve the frames
+    BottomUpResults m_frames;
+    EventResults m_events;
+    int m_numTypes = 0;
+
+    mutable QMutex m_mutex;
+    mutable QHash<Symbol, LocationMaps> m_cache;
+    bool m_cacheEnabled = true;
+};
+
 struct Tracepoint
 {
     quint64 time = 0;
     QString name;
+    // the decoded payload in TracepointResults::tables, if any
+    qint32 table = -1;
+    qint32 row = -1;
+};
+
+// one field of the tracepoint payloads, integral values are stored as numbers, everything else as text
+// the texts repeat a lot, e.g. the command names of sched_switch, so they get interned per field
+struct TracepointField
+{
+    QString name;
+    bool isNumeric = true;
+    // the numbers, or the indices into texts when the field isn't numeric
+    Column<qint64> values;
+    QVector<QString> texts;
+    // the index of every text, only needed while appending
+    QHash<QString, qint64> textIndices;
+
+    qsizetype size() const
+    {
+        return values.size();
+    }
+
+    QString text(qsizetype row) const;
+    void append(const QVariant& value);
+
+private:
+    qint64 intern(const QString& text);
+};
+
+// the decoded payloads of one tracepoint type, with one column per field
+struct TracepointTable
+{
+    QString name;
+    // ordered by time, like the samples they stem from
+    Column<quint64> times;
+    // the thread that hit the tracepoint and its stack, see EventResults::stacks
+    Column<qint32> threadIds;
+    Column<qint32> stackIds;
+    QVector<TracepointField> fields;
+
+    // the index of the field called @p name, or -1
+    int fieldIndex(const QString& name) const;
+
+    qsizetype size() const
+    {
+        return times.size();
+    }
+
+    // the half-open range of rows within the time range
+    std::pair<qsizetype, qsizetype> rowsInRange(TimeRange range) const;
+
+    // all fields of the row, one "name: value" pair per line
+    QString format(qsizetype row) const;
 };
 
 struct TracepointResults
 {
     QVector<Tracepoint> tracepoints;
+    QVector<TracepointTable> tables;
+
+    // the half-open range of tracepoints within the time range
+    std::pair<int, int> tracepointsInRange(TimeRange range) const;
+};
+
+// the state of a running parse, see PerfParser::parseProgress
+struct ParseProgress
+{
+    enum class Phase
+    {
+        // perfparser unwinds and symbolizes the samples, which hotspot decodes as they arrive
+        Parse,
+        // the pending aggregations get drained and the results finalized
+        Aggregate,
+        // the top down, per library and caller/callee results get built
+        DeriveViews
+    };
+    Phase phase = Phase::Parse;
+    // as reported by perfparser, between 0 and 1
+    float percent = 0;
+    // the records decoded so far and their size
+    quint64 records = 0;
+    quint64 bytes = 0;
+    double recordsPerSecond = 0;
+    double bytesPerSecond = 0;
+    quint64 uniqueStacks = 0;
+    quint64 uniqueSymbols = 0;
+    // the resident set size of hotspot in bytes
+    qint64 residentMemory = 0;
+    // in milliseconds, remaining is -1 when unknown
+    qint64 elapsed = 0;
+    qint64 remaining = -1;
+};
+
+// the estimated heap memory of the results in bytes, the events stored in the spill directory are not included
+struct MemoryUsage
+{
+    qint64 threadEvents = 0;
+    qint64 cpuEvents = 0;
+    qint64 stacks = 0;
+    qint64 bottomUp = 0;
+    // including the cached source and offset maps, see LocationCostIndex
+    qint64 callerCallee = 0;
+    qint64 frequency = 0;
+    qint64 tracepoints = 0;
+
+    qint64 total() const
+    {
+        return threadEvents + cpuEvents + stacks + bottomUp + callerCallee + frequency + tracepoints;
+    }
+
+    // only the events, which are known while parsing already
+    static MemoryUsage fromEvents(const EventResults& events);
+    static MemoryUsage fromResults(const BottomUpResults& bottomUp, const CallerCalleeResults& callerCallee,
+                                   const EventResults& events, const FrequencyResults& frequency,
+                                   const TracepointResults& tracepoints);
 };
 
 struct FilterAction
@@ -883,6 +2921,184 @@ struct FilterAction
             || !includeSymbols.isEmpty() || !excludeSymbols.isEmpty() || !includeBinaries.isEmpty()
             || !excludeBinaries.isEmpty();
     }
+
+    // returns true when everything that passes this filter also passes @p other,
+    // i.e. when this filter can be applied to the results of @p other instead of the unfiltered data
+    bool isRefinementOf(const FilterAction& other) const;
+
+    bool operator==(const FilterAction& rhs) const
+    {
+        return std::tie(time, processId, threadId, cpuId, excludeProcessIds, excludeThreadIds, excludeCpuIds,
+                        includeSymbols, excludeSymbols, includeBinaries, excludeBinaries)
+            == std::tie(rhs.time, rhs.processId, rhs.threadId, rhs.cpuId, rhs.excludeProcessIds,
+                        rhs.excludeThreadIds, rhs.excludeCpuIds, rhs.includeSymbols, rhs.excludeSymbols,
+                        rhs.includeBinaries, rhs.excludeBinaries);
+    }
+
+    bool operator!=(const FilterAction& rhs) const
+    {
+        return !operator==(rhs);
+    }
+};
+
+inline uint qHash(const FilterAction& filter, uint seed = 0)
+{
+    // the order of the elements in a set is unspecified, so combine their hashes commutatively
+    auto hashSet = [](const auto& set) {
+        uint ret = 0;
+        for (const auto& value : set) {
+            ret += qHash(value);
+        }
+        return ret;
+    };
+
+    Util::HashCombine hash;
+    seed = hash(seed, filter.time.start);
+    seed = hash(seed, filter.time.end);
+    seed = hash(seed, filter.processId);
+    seed = hash(seed, filter.threadId);
+    seed = hash(seed, filter.cpuId);
+    seed = hash(seed, filter.excludeProcessIds);
+    seed = hash(seed, filter.excludeThreadIds);
+    seed = hash(seed, filter.excludeCpuIds);
+    seed = hash(seed, hashSet(filter.includeSymbols));
+    seed = hash(seed, hashSet(filter.excludeSymbols));
+    seed = hash(seed, hashSet(filter.includeBinaries));
+    seed = hash(seed, hashSet(filter.excludeBinaries));
+    return seed;
+}
+
+// inserts the cpus given like "0-3" or "8" into @p cpus, returns false for an invalid value
+bool parseCpus(const QStringList& values, QSet<quint32>* cpus);
+
+// restricts the samples that get parsed at all. unlike a FilterAction, this also saves the memory and the time to
+// aggregate the skipped samples, which matters for long system wide recordings of which only a part is of interest
+struct ParseRestriction
+{
+    // relative to the first event of the recording
+    TimeRange time = {0, std::numeric_limits<quint64>::max()};
+    // the processes are given by their pid or by the command of one of their threads
+    QSet<qint32> pids;
+    QSet<QString> commands;
+    QSet<quint32> cpus;
+
+    bool isEmpty() const
+    {
+        return time == ParseRestriction().time && pids.isEmpty() && commands.isEmpty() && cpus.isEmpty();
+    }
+
+    bool restrictsProcesses() const
+    {
+        return !pids.isEmpty() || !commands.isEmpty();
+    }
+
+    bool acceptsCpu(quint32 cpu) const
+    {
+        return cpus.isEmpty() || cpus.contains(cpu);
+    }
+
+    // parses whitespace separated restrictions like "time=10-20.5 pid=1234,firefox cpu=0-3,8"
+    // the time is given in seconds and either end may be omitted, an empty @p spec restricts nothing
+    static std::optional<ParseRestriction> fromString(const QString& spec);
+};
+
+// maps every symbol and binary to the sorted ids of the stacks that contain it
+// this turns the symbol and binary filters into set operations on the stack ids
+// the frames of the stacks are also kept in two tries, from the leaf and from the outermost caller,
+// so the stacks below a node of the bottom up or top down views can be looked up without visiting all of them
+// it gets built once per file and is implicitly shared, see PerfParser::stackIndexAvailable
+class StackIndex
+{
+public:
+    StackIndex() = default;
+    StackIndex(const BottomUpResults& bottomUp, const QVector<QVector<qint32>>& stacks);
+
+    bool isEmpty() const
+    {
+        return m_numStacks == 0;
+    }
+
+    // returns for every stack id whether it passes the symbol and binary filters of @p filter,
+    // i.e. whether the stack contains all included and none of the excluded symbols and binaries
+    QVector<bool> filterStacks(const FilterAction& filter) const;
+
+    // the sorted ids of the stacks that contain @p symbol
+    QVector<qint32> stacksWithSymbol(const Symbol& symbol) const;
+
+    enum class Direction
+    {
+        FromLeaf,
+        FromOutermostCaller,
+    };
+    // the ids of the stacks whose frames start with @p frames, in the given direction
+    QVector<qint32> stacksWithPrefix(const QVector<Symbol>& frames, Direction direction) const;
+
+private:
+    // the node of a sequence of frames has the stacks starting with these frames in its subtree
+    struct Trie
+    {
+        // the root is node 0
+        Trie();
+        // returns the node for @p symbolIds, creating the missing ones
+        qint32 insert(const qint32* symbolIds, qint32 size);
+        // sorts the stacks by the node they end in, @p stackNodes maps every stack id to its node
+        void setStacks(const QVector<qint32>& stackNodes);
+
+        // keyed by the parent node and the symbol id
+        QHash<quint64, qint32> children;
+        QVector<qint32> firstChild;
+        QVector<qint32> nextSibling;
+        // the stacks ending in node i are stackIds[stackOffsets[i], stackOffsets[i + 1])
+        QVector<qint32> stackOffsets;
+        QVector<qint32> stackIds;
+    };
+
+    qint32 m_numStacks = 0;
+    // the ids of the symbols are only valid within this index
+    QHash<Symbol, qint32> m_symbolIds;
+    QVector<QVector<qint32>> m_symbolStacks;
+    QHash<QString, QVector<qint32>> m_binaryStacks;
+    Trie m_fromLeaf;
+    Trie m_fromOutermostCaller;
+};
+
+// the costs of all events, summed up per stack, CPU and cost type for each thread
+// aggregating the costs then only needs to visit the cells instead of every single event
+class CostCube
+{
+public:
+    struct Cell
+    {
+        qint32 stackId = -1;
+        quint32 cpuId = INVALID_CPU_ID;
+        qint32 type = -1;
+        quint64 cost = 0;
+    };
+
+    CostCube() = default;
+    explicit CostCube(const EventResults& events);
+    // the cells of a thread don't depend on the other threads, so they can be built in parallel, see threadCells
+    explicit CostCube(QVector<QVector<Cell>> threadCells)
+        : m_threadCells(std::move(threadCells))
+    {
+    }
+
+    // the cells of @p thread, incomplete once @p cancelled got set
+    static QVector<Cell> threadCells(const ThreadEvents& thread, const std::atomic<bool>* cancelled = nullptr);
+
+    bool isEmpty() const
+    {
+        return m_threadCells.isEmpty();
+    }
+
+    // @p thread is an index into EventResults::threads
+    const QVector<Cell>& cells(qint32 thread) const
+    {
+        return m_threadCells.at(thread);
+    }
+
+private:
+    QVector<QVector<Cell>> m_threadCells;
 };
 
 struct ZoomAction
@@ -932,12 +3148,22 @@ Q_DECLARE_TYPEINFO(Data::TopDownResults, Q_MOVABLE_TYPE);
 Q_DECLARE_METATYPE(Data::PerLibraryResults)
 Q_DECLARE_TYPEINFO(Data::PerLibraryResults, Q_MOVABLE_TYPE);
 
+Q_DECLARE_METATYPE(Data::TopCosts)
+Q_DECLARE_TYPEINFO(Data::TopCosts, Q_MOVABLE_TYPE);
+
 Q_DECLARE_METATYPE(Data::CallerCalleeResults)
 Q_DECLARE_TYPEINFO(Data::CallerCalleeResults, Q_MOVABLE_TYPE);
 
+Q_DECLARE_METATYPE(Data::ComparisonResults)
+
 Q_DECLARE_METATYPE(Data::Event)
 Q_DECLARE_TYPEINFO(Data::Event, Q_MOVABLE_TYPE);
 
+Q_DECLARE_METATYPE(Data::Events)
+Q_DECLARE_TYPEINFO(Data::Events, Q_MOVABLE_TYPE);
+
+Q_DECLARE_TYPEINFO(Data::EventIndex, Q_PRIMITIVE_TYPE);
+
 Q_DECLARE_METATYPE(Data::FrequencyData)
 Q_DECLARE_TYPEINFO(Data::FrequencyData, Q_MOVABLE_TYPE);
 
@@ -956,12 +3182,16 @@ Q_DECLARE_TYPEINFO(Data::ThreadEvents, Q_MOVABLE_TYPE);
 Q_DECLARE_METATYPE(Data::CpuEvents)
 Q_DECLARE_TYPEINFO(Data::CpuEvents, Q_MOVABLE_TYPE);
 
+Q_DECLARE_TYPEINFO(Data::LostEvents, Q_PRIMITIVE_TYPE);
+
 Q_DECLARE_METATYPE(Data::Summary)
 Q_DECLARE_TYPEINFO(Data::Summary, Q_MOVABLE_TYPE);
 
 Q_DECLARE_METATYPE(Data::CostSummary)
 Q_DECLARE_TYPEINFO(Data::CostSummary, Q_MOVABLE_TYPE);
 
+Q_DECLARE_TYPEINFO(Data::CounterSummary, Q_MOVABLE_TYPE);
+
 Q_DECLARE_METATYPE(Data::ThreadNames)
 Q_DECLARE_TYPEINFO(Data::ThreadNames, Q_MOVABLE_TYPE);
 
@@ -971,7 +3201,13 @@ Q_DECLARE_TYPEINFO(Data::EventResults, Q_MOVABLE_TYPE);
 Q_DECLARE_METATYPE(Data::Tracepoint)
 Q_DECLARE_TYPEINFO(Data::Tracepoint, Q_MOVABLE_TYPE);
 
+Q_DECLARE_TYPEINFO(Data::TracepointField, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(Data::TracepointTable, Q_MOVABLE_TYPE);
+
 Q_DECLARE_METATYPE(Data::TracepointResults)
+Q_DECLARE_METATYPE(Data::MemoryUsage)
+Q_DECLARE_METATYPE(Data::ParseProgress)
+Q_DECLARE_METATYPE(Data::StackIndex)
 Q_DECLARE_TYPEINFO(Data::TracepointResults, Q_MOVABLE_TYPE);
 
 Q_DECLARE_METATYPE(Data::TimeRange)
@@ -8,6 +8,12 @@
 
 #include "disassemblymodel.h"
 
+#include <QPointer>
+
+#include <utility>
+
+#include "../jobscheduler.h"
+#include "../settings.h"
 #include "search.h"
 #include "sourcecodemodel.h"
 
@@ -15,6 +21,8 @@ DisassemblyModel::DisassemblyModel(KSyntaxHighlighting::Repository* repository,
     : QAbstractTableModel(parent)
     , m_highlightedText(repository)
 {
+    m_metricDefinitions = Settings::instance()->derivedMetrics();
+    connect(Settings::instance(), &Settings::derivedMetricsChanged, this, &DisassemblyModel::setDerivedMetrics);
 }
 
 DisassemblyModel::~DisassemblyModel() = default;
@@ -23,13 +31,24 @@ void DisassemblyModel::clear()
 {
     beginResetModel();
     m_data = {};
+    m_hasCost.clear();
+    m_metrics = {};
+    m_controlFlow = {};
+    m_blockCosts = {};
+    m_loopCosts = {};
+    m_hottestRows.clear();
+    m_highlightRows.clear();
+    resetSearch();
     endResetModel();
 }
 
 QModelIndex DisassemblyModel::findIndexWithOffset(int offset)
 {
-    const auto address = m_data.disassemblyLines[0].addr + offset;
+    return indexForAddress(m_data.disassemblyLines[0].addr + offset);
+}
 
+QModelIndex DisassemblyModel::indexForAddress(quint64 address) const
+{
     const auto& found =
         std::find_if(m_data.disassemblyLines.begin(), m_data.disassemblyLines.end(),
                      [address](const DisassemblyOutput::DisassemblyLine& line) { return line.addr == address; });
@@ -42,12 +61,22 @@ QModelIndex DisassemblyModel::findIndexWithOffset(int offset)
 
 void DisassemblyModel::setDisassembly(const DisassemblyOutput& disassemblyOutput,
                                       const Data::CallerCalleeResults& results)
+{
+    setDisassembly(disassemblyOutput, results, results.offsetMap(disassemblyOutput.symbol));
+}
+
+void DisassemblyModel::setDisassembly(const DisassemblyOutput& disassemblyOutput,
+                                      const Data::CallerCalleeResults& results,
+                                      const Data::OffsetLocationCostMap& offsetMap)
 {
     beginResetModel();
 
     m_data = disassemblyOutput;
-    m_results = results;
+    resetSearch();
     m_numTypes = results.selfCosts.numTypes();
+    m_controlFlow = ControlFlow::analyze(disassemblyOutput);
+
+    applyOffsetMap(results.selfCosts, offsetMap);
 
     QStringList assemblyLines;
     assemblyLines.reserve(disassemblyOutput.disassemblyLines.size());
@@ -60,9 +89,109 @@ void DisassemblyModel::setDisassembly(const DisassemblyOutput& disassemblyOutput
     endResetModel();
 }
 
+void DisassemblyModel::setOffsetMap(const Data::OffsetLocationCostMap& offsetMap)
+{
+    // only the costs change, the rows stay the same
+    const auto costTypes = m_selfCosts;
+    applyOffsetMap(costTypes, offsetMap);
+
+    const auto lastRow = rowCount() - 1;
+    if (lastRow >= 0) {
+        emit dataChanged(index(0, 0), index(lastRow, columnCount() - 1));
+    }
+}
+
+void DisassemblyModel::applyOffsetMap(const Data::Costs& costTypes, const Data::OffsetLocationCostMap& offsetMap)
+{
+    const auto& disassemblyLines = m_data.disassemblyLines;
+
+    // the costs are indexed by row, which makes data() and scans for the hottest line simple array reads
+    m_selfCosts = {};
+    m_inclusiveCosts = {};
+    m_selfCosts.initializeCostsFrom(costTypes);
+    m_inclusiveCosts.initializeCostsFrom(costTypes);
+    m_hasCost.fill(false, disassemblyLines.size());
+
+    if (!offsetMap.isEmpty()) {
+        for (int row = 0, c = disassemblyLines.size(); row < c; ++row) {
+            const auto addr = disassemblyLines[row].addr;
+            if (!addr) {
+                continue;
+            }
+            const auto it = offsetMap.constFind(addr);
+            if (it != offsetMap.constEnd()) {
+                m_selfCosts.add(row, it->selfCost);
+                m_inclusiveCosts.add(row, it->inclusiveCost);
+                m_hasCost[row] = true;
+            }
+        }
+    }
+    m_metrics = Data::DerivedMetrics(m_metricDefinitions, m_selfCosts);
+
+    // map the source lines to their instructions once instead of scanning all of them on every cursor move
+    m_hottestRows.clear();
+    m_highlightRows.clear();
+    for (int row = 0, c = disassemblyLines.size(); row < c; ++row) {
+        const auto& fileLine = disassemblyLines[row].fileLine;
+        auto hottest = m_hottestRows.find(fileLine);
+        if (hottest == m_hottestRows.end()) {
+            m_hottestRows.insert(fileLine, row);
+        } else if (m_hasCost[row]
+                   && (!m_hasCost[*hottest] || m_selfCosts.cost(0, *hottest) < m_selfCosts.cost(0, row))) {
+            *hottest = row;
+        }
+
+        auto rows = m_highlightRows.find(fileLine.line);
+        if (rows == m_highlightRows.end()) {
+            m_highlightRows.insert(fileLine.line, {row, row});
+        } else {
+            rows->second = row;
+        }
+    }
+
+    // aggregate the costs of the blocks and loops, enclosing loops include the costs of their nested loops
+    m_blockCosts = {};
+    m_loopCosts = {};
+    m_blockCosts.initializeCostsFrom(costTypes);
+    m_loopCosts.initializeCostsFrom(costTypes);
+    for (int row = 0, c = disassemblyLines.size(); row < c; ++row) {
+        if (!m_hasCost[row]) {
+            continue;
+        }
+        const auto cost = m_selfCosts.itemCost(row);
+        m_blockCosts.add(m_controlFlow.blockForRow(row), cost);
+        for (auto loop = m_controlFlow.loopForRow(row); loop != -1; loop = m_controlFlow.loops.at(loop).parent) {
+            m_loopCosts.add(loop, cost);
+        }
+    }
+}
+
+void DisassemblyModel::setDerivedMetrics(const QStringList& definitions)
+{
+    beginResetModel();
+    m_metricDefinitions = definitions;
+    m_metrics = Data::DerivedMetrics(m_metricDefinitions, m_selfCosts);
+    endResetModel();
+}
+
+int DisassemblyModel::hottestLoop(int type) const
+{
+    int hottest = -1;
+    qint64 hottestCost = 0;
+    for (int loop = 0, c = m_controlFlow.loops.size(); loop < c; ++loop) {
+        // nested loops come after their enclosing loop
+        const auto cost = m_loopCosts.cost(type, loop);
+        if (cost > 0 && cost >= hottestCost) {
+            hottest = loop;
+            hottestCost = cost;
+        }
+    }
+    return hottest;
+}
+
 QVariant DisassemblyModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
-    if (section < 0 || section >= m_numTypes + COLUMN_COUNT)
+    if (section < 0 || section >= columnCount())
         return {};
     if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
         return {};
@@ -76,10 +205,10 @@ QVariant DisassemblyModel::headerData(int section, Qt::Orientation orientation,
     else if (section == DisassemblyColumn)
         return tr("Assembly / Disassembly");
 
-    if (section - COLUMN_COUNT <= m_numTypes)
-        return m_results.selfCosts.typeName(section - COLUMN_COUNT);
+    if (section - COLUMN_COUNT < m_numTypes)
+        return m_selfCosts.typeName(section - COLUMN_COUNT);
 
-    return {};
+    return m_metrics.metric(section - COLUMN_COUNT - m_numTypes).label;
 }
 
 QVariant DisassemblyModel::data(const QModelIndex& index, int role) const
@@ -128,23 +257,48 @@ QVariant DisassemblyModel::data(const QModelIndex& index, int role) const
             return {};
         }
 
-        const auto entry = m_results.entries.value(m_data.symbol);
-        auto it = entry.offsetMap.find(data.addr);
-        if (it != entry.offsetMap.end()) {
-            const auto event = index.column() - COLUMN_COUNT;
+        if (m_hasCost.at(index.row())) {
+            // the tooltip is the same for all columns
+            if (role == Qt::ToolTipRole) {
+                auto tooltip = tr("addr: <tt>%1</tt><br/>assembly: <tt>%2</tt><br/>disassembly: <tt>%3</tt>")
+                                   .arg(QString::number(data.addr, 16), line);
+                const auto loop = m_controlFlow.loopForRow(index.row());
+                if (loop != -1) {
+                    const auto& range = m_controlFlow.loops.at(loop);
+                    tooltip += tr("<br/>loop: <tt>%1</tt> - <tt>%2</tt>")
+                                   .arg(QString::number(m_data.disassemblyLines.at(range.firstRow).addr, 16),
+                                        QString::number(m_data.disassemblyLines.at(range.lastRow).addr, 16));
+                    for (int type = 0; type < m_numTypes; ++type) {
+                        if (const auto total = m_selfCosts.totalCost(type)) {
+                            tooltip += tr("<br/>%1 in loop: %2%")
+                                           .arg(m_selfCosts.typeName(type),
+                                                Util::formatCostRelative(m_loopCosts.cost(type, loop), total));
+                        }
+                    }
+                }
+                Data::LocationCost locationCost;
+                locationCost.selfCost = m_selfCosts.itemCost(index.row());
+                locationCost.inclusiveCost = m_inclusiveCosts.itemCost(index.row());
+                return Util::formatTooltip(tooltip, locationCost, m_selfCosts);
+            }
 
-            const auto& locationCost = it.value();
-            const auto& costLine = locationCost.selfCost[event];
-            const auto totalCost = m_results.selfCosts.totalCost(event);
+            const auto event = index.column() - COLUMN_COUNT;
+            if (event >= m_numTypes) {
+                const auto value = m_metrics.value(event - m_numTypes, index.row());
+                if (role == CostRole) {
+                    return value;
+                } else if (role == TotalCostRole) {
+                    return {};
+                }
+                return Data::DerivedMetrics::format(value);
+            }
+            const auto costLine = m_selfCosts.cost(event, index.row());
+            const auto totalCost = m_selfCosts.totalCost(event);
 
             if (role == CostRole) {
                 return costLine;
             } else if (role == TotalCostRole) {
                 return totalCost;
-            } else if (role == Qt::ToolTipRole) {
-                auto tooltip = tr("addr: <tt>%1</tt><br/>assembly: <tt>%2</tt><br/>disassembly: <tt>%3</tt>")
-                                   .arg(QString::number(data.addr, 16), line);
-                return Util::formatTooltip(tooltip, locationCost, m_results.selfCosts);
             }
 
             if (!costLine)
@@ -185,7 +339,7 @@ QSize DisassemblyModel::span(const QModelIndex& index) const
 
 int DisassemblyModel::columnCount(const QModelIndex& parent) const
 {
-    return parent.isValid() ? 0 : COLUMN_COUNT + m_numTypes;
+    return parent.isValid() ? 0 : COLUMN_COUNT + m_numTypes + m_metrics.size();
 }
 
 int DisassemblyModel::rowCount(const QModelIndex& parent) const
@@ -195,8 +349,20 @@ int DisassemblyModel::rowCount(const QModelIndex& parent) const
 
 void DisassemblyModel::updateHighlighting(int line)
 {
-    m_highlightLine = line;
-    emit dataChanged(createIndex(0, Columns::DisassemblyColumn), createIndex(rowCount(), Columns::DisassemblyColumn));
+    if (line == m_highlightLine) {
+        return;
+    }
+
+    // only the rows of the previous and the new line change
+    auto emitHighlightChanged = [this](int line) {
+        const auto it = m_highlightRows.constFind(line);
+        if (it != m_highlightRows.constEnd()) {
+            emit dataChanged(createIndex(it->first, Columns::DisassemblyColumn),
+                             createIndex(it->second, Columns::DisassemblyColumn));
+        }
+    };
+    emitHighlightChanged(std::exchange(m_highlightLine, line));
+    emitHighlightChanged(line);
 }
 
 Data::FileLine DisassemblyModel::fileLineForIndex(const QModelIndex& index) const
@@ -206,45 +372,59 @@ Data::FileLine DisassemblyModel::fileLineForIndex(const QModelIndex& index) cons
 
 QModelIndex DisassemblyModel::indexForFileLine(const Data::FileLine& fileLine) const
 {
-    int i = -1;
-    int bestMatch = -1;
-    qint64 bestCost = 0;
-    const auto entry = m_results.entries.value(m_data.symbol);
-    for (const auto& line : m_data.disassemblyLines) {
-        ++i;
-        if (line.fileLine != fileLine) {
-            continue;
-        }
-
-        if (bestMatch == -1) {
-            bestMatch = i;
-        }
-
-        auto it = entry.offsetMap.find(line.addr);
-        if (it != entry.offsetMap.end()) {
-            const auto& locationCost = it.value();
+    const auto it = m_hottestRows.constFind(fileLine);
+    if (it == m_hottestRows.constEnd())
+        return {};
+    return index(*it, 0);
+}
 
-            if (!bestCost || bestCost < locationCost.selfCost[0]) {
-                bestMatch = i;
-                bestCost = locationCost.selfCost[0];
-            }
-        }
+void DisassemblyModel::find(const QString& search, Direction direction, int current)
+{
+    if (m_searchIndex && search == m_search) {
+        emitSearchResult(direction, current);
+        return;
     }
 
-    if (bestMatch == -1)
-        return {};
-    return index(bestMatch, 0);
+    const auto jobId = ++m_searchJobId;
+    JobScheduler::run(JobScheduler::Priority::Interactive,
+                      [smartThis = QPointer<DisassemblyModel>(this), jobId, searchIndex = m_searchIndex,
+                       lines = m_data.disassemblyLines, search, direction, current]() mutable {
+                          if (!searchIndex) {
+                              QStringList text;
+                              text.reserve(lines.size());
+                              for (const auto& line : lines) {
+                                  text.append(line.disassembly);
+                              }
+                              searchIndex = std::make_shared<const TextSearchIndex>(text);
+                          }
+                          const auto matches = searchIndex->matchingLines(search);
+                          QMetaObject::invokeMethod(
+                              smartThis.data(),
+                              [smartThis, jobId, searchIndex, search, matches, direction, current]() {
+                                  if (smartThis && jobId == smartThis->m_searchJobId) {
+                                      smartThis->m_searchIndex = searchIndex;
+                                      smartThis->m_search = search;
+                                      smartThis->m_searchMatches = matches;
+                                      smartThis->emitSearchResult(direction, current);
+                                  }
+                              },
+                              Qt::QueuedConnection);
+                      });
 }
 
-void DisassemblyModel::find(const QString& search, Direction direction, int current)
+void DisassemblyModel::resetSearch()
 {
-    auto searchFunc = [&search](const DisassemblyOutput::DisassemblyLine& line) {
-        return line.disassembly.indexOf(search, 0, Qt::CaseInsensitive) != -1;
-    };
+    m_searchIndex.reset();
+    m_searchMatches.clear();
+    // drop the results of a search that is still running
+    ++m_searchJobId;
+}
 
+void DisassemblyModel::emitSearchResult(Direction direction, int current)
+{
     auto endReached = [this] { emit searchEndReached(); };
 
-    const int resultIndex = ::search(m_data.disassemblyLines, current, direction, searchFunc, endReached);
+    const int resultIndex = ::searchMatches(m_searchMatches, current, direction, endReached);
 
     if (resultIndex >= 0) {
         emit resultFound(createIndex(resultIndex, DisassemblyColumn));
@@ -12,9 +12,11 @@
 #include <QAbstractTableModel>
 #include <QTextLine>
 
+#include "controlflow.h"
 #include "data.h"
 #include "disassemblyoutput.h"
 #include "highlightedtext.h"
+#include "textsearchindex.h"
 
 namespace KSyntaxHighlighting {
 class Definition;
@@ -31,9 +33,15 @@ public:
     ~DisassemblyModel() override;
 
     void setDisassembly(const DisassemblyOutput& disassemblyOutput, const Data::CallerCalleeResults& results);
+    // like above, but with the offset map of the symbol computed already, see Data::CallerCalleeResults::offsetMap
+    void setDisassembly(const DisassemblyOutput& disassemblyOutput, const Data::CallerCalleeResults& results,
+                        const Data::OffsetLocationCostMap& offsetMap);
+    // replaces the costs of the current disassembly without resetting the model
+    void setOffsetMap(const Data::OffsetLocationCostMap& offsetMap);
 
     void clear();
     QModelIndex findIndexWithOffset(int offset);
+    QModelIndex indexForAddress(quint64 address) const;
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override;
@@ -50,6 +58,29 @@ public:
         return &m_highlightedText;
     }
 
+    const ControlFlow& controlFlow() const
+    {
+        return m_controlFlow;
+    }
+
+    // the self cost of all rows of a basic block or loop of controlFlow()
+    qint64 blockCost(int type, int block) const
+    {
+        return m_blockCosts.cost(type, block);
+    }
+
+    qint64 loopCost(int type, int loop) const
+    {
+        return m_loopCosts.cost(type, loop);
+    }
+
+    // the loop with the highest cost, nested loops are preferred over enclosing loops with the same cost
+    // returns -1 when no loop has any cost
+    int hottestLoop(int type) const;
+
+    // see Settings::derivedMetrics, the metrics get shown after the cost columns
+    void setDerivedMetrics(const QStringList& definitions);
+
     enum Columns
     {
         AddrColumn,
@@ -81,9 +112,33 @@ public slots:
     void scrollToLine(const QString& lineNumber);
 
 private:
+    void resetSearch();
+    void emitSearchResult(Direction direction, int current);
+    // the costs of the rows of m_data and everything derived from them
+    void applyOffsetMap(const Data::Costs& costTypes, const Data::OffsetLocationCostMap& offsetMap);
+
     HighlightedText m_highlightedText;
     DisassemblyOutput m_data;
-    Data::CallerCalleeResults m_results;
+    // the costs of the lines, indexed by row
+    Data::Costs m_selfCosts;
+    Data::Costs m_inclusiveCosts;
+    QVector<bool> m_hasCost;
+    ControlFlow m_controlFlow;
+    // the costs of the blocks and loops, indexed like in m_controlFlow
+    Data::Costs m_blockCosts;
+    Data::Costs m_loopCosts;
     int m_numTypes = 0;
+    QStringList m_metricDefinitions;
+    // computed from the self costs of the lines
+    Data::DerivedMetrics m_metrics;
     int m_highlightLine = 0;
+    // the row with the highest self cost for every source line, the first one when none of them has costs
+    QHash<Data::FileLine, int> m_hottestRows;
+    // the first and last row of every line number, the highlighting only compares the line numbers
+    QHash<int, std::pair<int, int>> m_highlightRows;
+    // built along with the first search in the background, the matches get reused by find next and previous
+    std::shared_ptr<const TextSearchIndex> m_searchIndex;
+    QString m_search;
+    QVector<int> m_searchMatches;
+    uint m_searchJobId = 0;
 };
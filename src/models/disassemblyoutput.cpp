@@ -10,19 +10,93 @@
 #include "data.h"
 
 #include <QApplication>
+#include <QCache>
+#include <QDateTime>
 #include <QDir>
 #include <QDirIterator>
+#include <QFileSystemWatcher>
 #include <QFileInfo>
 #include <QLoggingCategory>
+#include <QMutex>
+#include <QPointer>
 #include <QProcess>
+#include <QSet>
 #include <QStandardPaths>
 
+#include <charconv>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <string_view>
+
 #include "formattingutils.h"
 
+#include "hotspot-config.h"
+
+#if Capstone_FOUND
+#include "builtindisassembler.h"
+#endif
+
 namespace {
 Q_LOGGING_CATEGORY(disassemblyoutput, "hotspot.disassemblyoutput")
 
-QByteArray objdumpHelp(const QString& objdump)
+struct CachedDisassembly
+{
+    DisassemblyOutput::ObjectdumpOutput output;
+    QString errorOutput;
+};
+
+// the objdump output for a whole binary, where only the functions get indexed. symbols are parsed from their part of
+// the output whenever they get disassembled, which is cheap compared to running objdump
+struct DisassembledBinary
+{
+    struct Function
+    {
+        quint64 addr = 0;
+        // covers all instructions that objdump printed for the function
+        quint64 size = 0;
+        // the part of the output that starts with the "0000000000001265 <main>:" line
+        qsizetype offset = 0;
+        qsizetype length = 0;
+    };
+
+    QByteArray output;
+    QString errorOutput;
+    // sorted by address
+    QVector<Function> functions;
+    // the names as used for linked functions, mapped to indices into functions
+    QHash<QByteArray, int> functionsByName;
+};
+
+// disassembling the same symbols again is common when jumping between the hot functions, and objdump gets probed
+// for its capabilities before every disassembly too, so remember both
+struct DisassemblyCache
+{
+    QMutex mutex;
+    // keyed by the objdump invocation and the identity of the binary, the cost is the number of lines
+    QCache<QString, CachedDisassembly> disassemblies {100000};
+    // keyed like the disassemblies but without an address range, the cost is the size of the output in MiB
+    QCache<QString, DisassembledBinary> binaries {1024};
+    // the binaries that are getting disassembled right now
+    QSet<QString> pendingBinaries;
+    QHash<QString, QByteArray> objdumpHelp;
+};
+
+DisassemblyCache& disassemblyCache()
+{
+    static DisassemblyCache cache;
+    return cache;
+}
+
+QString disassemblyCacheKey(const QString& processPath, const QStringList& arguments, const QString& binary)
+{
+    // the binary could be rebuilt while we are running
+    const auto info = QFileInfo(binary);
+    return processPath + QLatin1Char('\n') + arguments.join(QLatin1Char('\n')) + QLatin1Char('\n')
+        + QString::number(info.size()) + QLatin1Char('\n') + QString::number(info.lastModified().toMSecsSinceEpoch());
+}
+
+QByteArray queryObjdumpHelp(const QString& objdump)
 {
     QProcess process;
     process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
@@ -34,6 +108,25 @@ QByteArray objdumpHelp(const QString& objdump)
     return process.readAllStandardOutput();
 }
 
+QByteArray objdumpHelp(const QString& objdump)
+{
+    auto& cache = disassemblyCache();
+    {
+        QMutexLocker lock(&cache.mutex);
+        const auto it = cache.objdumpHelp.constFind(objdump);
+        if (it != cache.objdumpHelp.constEnd()) {
+            return it.value();
+        }
+    }
+
+    // objdump runs without the lock, so it doesn't hold up the other disassemblies. should two threads query it at
+    // the same time, both get the same answer
+    const auto help = queryObjdumpHelp(objdump);
+    QMutexLocker lock(&cache.mutex);
+    cache.objdumpHelp.insert(objdump, help);
+    return help;
+}
+
 bool canVisualizeJumps(const QString& objdump)
 {
     return objdumpHelp(objdump).contains("--visualize-jumps");
@@ -44,40 +137,291 @@ bool canUseSyntaxHighlighting(const QString& objdump)
     return objdumpHelp(objdump).contains("--disassembler-color");
 }
 
-DisassemblyOutput::LinkedFunction extractLinkedFunction(const QString& disassemblyWithAnsi)
+// the objdump output gets parsed in place, only the final fields are converted to QString
+using ByteView = std::string_view;
+
+bool startsWith(ByteView text, ByteView prefix)
+{
+    return text.substr(0, prefix.size()) == prefix;
+}
+
+ByteView trimmed(ByteView text)
+{
+    const auto isSpace = [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); };
+    while (!text.empty() && isSpace(text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && isSpace(text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+QString toString(ByteView text)
+{
+    return QString::fromUtf8(text.data(), static_cast<int>(text.size()));
+}
+
+template<typename T>
+bool parseNumber(ByteView text, int base, T* number)
+{
+    const auto* end = text.data() + text.size();
+    const auto result = std::from_chars(text.data(), end, *number, base);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+// returns @p text without ANSI escape sequences, @p buffer is reused to not allocate for every line
+ByteView removeAnsi(ByteView text, std::string* buffer)
+{
+    const auto escapeChar = Util::escapeChar.toLatin1();
+    auto escapeStart = text.find(escapeChar);
+    if (escapeStart == ByteView::npos) {
+        return text;
+    }
+
+    buffer->clear();
+    while (escapeStart != ByteView::npos) {
+        buffer->append(text.substr(0, escapeStart));
+        const auto escapeEnd = text.find('m', escapeStart);
+        if (escapeEnd == ByteView::npos) {
+            text = {};
+            break;
+        }
+        text.remove_prefix(escapeEnd + 1);
+        escapeStart = text.find(escapeChar);
+    }
+    buffer->append(text);
+    return *buffer;
+}
+
+DisassemblyOutput::LinkedFunction extractLinkedFunction(ByteView disassembly)
 {
     DisassemblyOutput::LinkedFunction function = {};
 
-    const auto disassembly =
-        disassemblyWithAnsi.contains(Util::escapeChar) ? Util::removeAnsi(disassemblyWithAnsi) : disassemblyWithAnsi;
+    const auto leftBracketIndex = disassembly.find('<');
+    const auto rightBracketIndex = disassembly.find('>');
 
-    const auto leftBracketIndex = disassembly.indexOf(QLatin1Char('<'));
-    const auto rightBracketIndex = disassembly.indexOf(QLatin1Char('>'));
+    if (leftBracketIndex != ByteView::npos && rightBracketIndex != ByteView::npos
+        && leftBracketIndex < rightBracketIndex) {
+        auto name = disassembly.substr(leftBracketIndex + 1, rightBracketIndex - leftBracketIndex - 1);
 
-    if (leftBracketIndex != -1 && rightBracketIndex != -1) {
-        if (leftBracketIndex < rightBracketIndex) {
-            function.name = disassembly.mid(leftBracketIndex + 1, rightBracketIndex - leftBracketIndex - 1);
+        const auto atindex = name.find('@');
+        if (atindex != ByteView::npos && atindex > 0) {
+            name = name.substr(0, atindex);
+        }
 
-            const auto atindex = function.name.indexOf(QLatin1Char('@'));
-            if (atindex > 0) {
-                function.name = function.name.left(atindex);
+        const auto plusIndex = name.find('+');
+        if (plusIndex != ByteView::npos && plusIndex > 0) {
+            // ignore 0x in offset
+            int offset = 0;
+            if (parseNumber(name.substr(std::min(plusIndex + 3, name.size())), 16, &offset)) {
+                function.offset = offset;
             }
+            name = name.substr(0, plusIndex);
+        }
+
+        function.name = toString(name);
+    }
+    return function;
+}
+
+// finding the binaries and source files probes the file system for every disassembly, and searching the sub
+// directories walks whole trees. so the results get remembered and the search paths get indexed. a file system
+// watcher on the indexed directories drops the indices and the results whenever something changes in them
+class PathResolver
+{
+public:
+    static PathResolver& instance()
+    {
+        static PathResolver resolver;
+        return resolver;
+    }
 
-            const auto plusIndex = function.name.indexOf(QLatin1Char('+'));
-            if (plusIndex > 0) {
-                bool ok;
-                // ignore 0x in offset
-                const auto& offsetStr = function.name.mid(plusIndex + 3);
-                function.name = function.name.left(plusIndex);
-                auto offset = offsetStr.toInt(&ok, 16);
-                if (ok) {
-                    function.offset = offset;
+    // the first entry named @p filename in @p path or its sub directories, in the order of QDirIterator
+    QString findInSubdirs(const QString& path, const QString& filename)
+    {
+        {
+            QMutexLocker lock(&m_mutex);
+            auto it = m_indices.constFind(path);
+            if (it != m_indices.constEnd()) {
+                auto ret = it->files.value(filename);
+                if (!ret.isEmpty() || it->complete || filename.isEmpty()) {
+                    return ret;
                 }
+                lock.unlock();
+                // the rest of the tree is not indexed
+                return findInTree(path, filename);
             }
         }
+
+        // walk the tree without holding the lock, this can take a while
+        auto index = buildIndex(path);
+        auto ret = index.files.value(filename);
+        if (ret.isEmpty() && !index.complete && !filename.isEmpty()) {
+            ret = findInTree(path, filename);
+        }
+        if (m_watcher) {
+            QMutexLocker lock(&m_mutex);
+            QMetaObject::invokeMethod(
+                m_watcher.data(), [watcher = m_watcher, directories = index.directories]() {
+                    if (watcher) {
+                        watcher->addPaths(directories);
+                    }
+                },
+                Qt::QueuedConnection);
+            m_indices.insert(path, std::move(index));
+        }
+        return ret;
     }
-    return function;
-}
+
+    // a previous result for @p key, the files get checked for existence since they could be gone by now
+    QString cachedResult(const QString& key)
+    {
+        QMutexLocker lock(&m_mutex);
+        const auto it = m_results.constFind(key);
+        if (it == m_results.constEnd()) {
+            return {};
+        } else if (!QFileInfo::exists(it.value())) {
+            m_results.erase(it);
+            return {};
+        }
+        return it.value();
+    }
+
+    void cacheResult(const QString& key, const QString& result)
+    {
+        // without the watcher, the results couldn't get updated for new files
+        if (!m_watcher || result.isEmpty()) {
+            return;
+        }
+        QMutexLocker lock(&m_mutex);
+        m_results.insert(key, result);
+    }
+
+    // indexes the given search paths ahead of time, the indices of the paths not in @p paths get dropped
+    void index(const QStringList& paths)
+    {
+        {
+            QMutexLocker lock(&m_mutex);
+            m_results.clear();
+            for (auto it = m_indices.begin(); it != m_indices.end();) {
+                if (!paths.contains(it.key())) {
+                    unwatch(it->directories);
+                    it = m_indices.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        for (const auto& path : paths) {
+            if (!path.isEmpty()) {
+                findInSubdirs(path, {});
+            }
+        }
+    }
+
+private:
+    struct Index
+    {
+        // the file names mapped to their first match
+        QHash<QString, QString> files;
+        QStringList directories;
+        // false when the tree has more than MaxWatchedDirectories directories, only the first ones get indexed then
+        bool complete = true;
+    };
+
+    PathResolver()
+    {
+        auto* app = QCoreApplication::instance();
+        if (!app) {
+            return;
+        }
+
+        m_watcher = new QFileSystemWatcher;
+        m_watcher->moveToThread(app->thread());
+        QObject::connect(app, &QCoreApplication::aboutToQuit, m_watcher.data(), &QObject::deleteLater);
+        QObject::connect(m_watcher.data(), &QFileSystemWatcher::directoryChanged, m_watcher.data(),
+                         [this](const QString& directory) { invalidate(directory); });
+    }
+
+    static Index buildIndex(const QString& path)
+    {
+        Index index;
+        index.directories.append(path);
+        QDirIterator it(path, QDir::AllEntries | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            const auto filePath = it.next();
+            const auto fileName = it.fileName();
+            if (it.fileInfo().isDir()) {
+                if (index.directories.size() == MaxWatchedDirectories) {
+                    // the entries up to here are still the first matches, as the walk keeps the same order
+                    index.complete = false;
+                    break;
+                }
+                index.directories.append(filePath);
+            }
+            if (!index.files.contains(fileName)) {
+                index.files.insert(fileName, filePath);
+            }
+        }
+        return index;
+    }
+
+    // the uncached lookup for the part of a tree that is not indexed
+    static QString findInTree(const QString& path, const QString& filename)
+    {
+        QDirIterator it(path, QDir::AllEntries | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            const auto filePath = it.next();
+            if (it.fileName() == filename) {
+                return filePath;
+            }
+        }
+        return {};
+    }
+
+    // must be called with m_mutex locked
+    void unwatch(const QStringList& directories)
+    {
+        if (!m_watcher) {
+            return;
+        }
+        QMetaObject::invokeMethod(
+            m_watcher.data(), [watcher = m_watcher, directories]() {
+                if (watcher) {
+                    watcher->removePaths(directories);
+                }
+            },
+            Qt::QueuedConnection);
+    }
+
+    void invalidate(const QString& directory)
+    {
+        qCDebug(disassemblyoutput) << "search path changed:" << directory;
+
+        QMutexLocker lock(&m_mutex);
+        m_results.clear();
+        for (auto it = m_indices.begin(); it != m_indices.end();) {
+            if (it->directories.contains(directory)) {
+                m_watcher->removePaths(it->directories);
+                it = m_indices.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // only the first directories of bigger trees get indexed, as every directory needs to be watched
+    static constexpr int MaxWatchedDirectories = 4096;
+
+    QMutex m_mutex;
+    // keyed by the search path
+    QHash<QString, Index> m_indices;
+    QHash<QString, QString> m_results;
+    // lives in the main thread
+    QPointer<QFileSystemWatcher> m_watcher;
+};
 
 QString findInSubdirRecursive(const QString& path, const QString& filename)
 {
@@ -88,12 +432,7 @@ QString findInSubdirRecursive(const QString& path, const QString& filename)
         return filepath;
     }
 
-    QDirIterator it(path, {filename}, QDir::NoFilter, QDirIterator::Subdirectories);
-    if (it.hasNext()) {
-        return it.next();
-    }
-
-    return {};
+    return PathResolver::instance().findInSubdirs(path, filename);
 }
 
 QString findBinaryForSymbol(const QStringList& debugPaths, const QStringList& extraLibPaths, const Data::Symbol& symbol)
@@ -103,6 +442,15 @@ QString findBinaryForSymbol(const QStringList& debugPaths, const QStringList& ex
         return symbol.actualPath;
     }
 
+    auto& resolver = PathResolver::instance();
+    const auto newLine = QLatin1Char('\n');
+    const auto cacheKey = QLatin1String("binary") + newLine + symbol.binary + newLine + symbol.path + newLine
+        + debugPaths.join(newLine) + newLine + extraLibPaths.join(newLine);
+    auto result = resolver.cachedResult(cacheKey);
+    if (!result.isEmpty()) {
+        return result;
+    }
+
     auto findBinary = [](const QStringList& paths, const QString& binary) -> QString {
         for (const auto& path : paths) {
             auto result = findInSubdirRecursive(path, binary);
@@ -113,25 +461,175 @@ QString findBinaryForSymbol(const QStringList& debugPaths, const QStringList& ex
         return {};
     };
 
-    auto result = findBinary(debugPaths, symbol.binary);
-    if (!result.isEmpty())
-        return result;
-
-    result = findBinary(extraLibPaths, symbol.binary);
-    if (!result.isEmpty())
-        return result;
+    result = findBinary(debugPaths, symbol.binary);
+    if (result.isEmpty())
+        result = findBinary(extraLibPaths, symbol.binary);
 
     // disassemble the binary if no debug file was found
-    if (QFileInfo::exists(symbol.path)) {
-        return symbol.path;
+    if (result.isEmpty() && QFileInfo::exists(symbol.path))
+        result = symbol.path;
+
+    resolver.cacheResult(cacheKey, result);
+    return result;
+}
+
+bool isHexCharacter(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+}
+
+// the arguments for objdump, without the address range and the binary
+QStringList objdumpArguments(const QString& processPath)
+{
+    auto arguments = QStringList {QStringLiteral("-d"), // disassemble
+                                  QStringLiteral("-l"), // include source code lines
+                                  QStringLiteral("-C")}; // demangle names
+
+    // only available for objdump 2.34+
+    if (canVisualizeJumps(processPath))
+        arguments.append(QStringLiteral("--visualize-jumps"));
+    else
+        qCInfo(disassemblyoutput) << "objdump binary does not support `--visualize-jumps`:" << processPath;
+
+    if (canUseSyntaxHighlighting(processPath)) {
+        arguments.append(QStringLiteral("--disassembler-color=color"));
+    } else {
+        qCInfo(disassemblyoutput) << "objdump binary does not support `--disassembler-color`:" << processPath;
+    }
+    return arguments;
+}
+
+// runs objdump and collects its output, problems get appended to @p errorMessage
+bool runObjdump(const QString& processPath, const QStringList& arguments, int timeout, QByteArray* output,
+                QString* errorMessage)
+{
+    // NOTE: make sure that `output` outlives `asmProcess`, as when the latter gets destroyed it might
+    //       emit `readyRead` which then needs to access `output`, see also:
+    //       https://github.com/KDAB/hotspot/issues/542
+    QProcess asmProcess;
+    QObject::connect(&asmProcess, &QProcess::readyRead, [&asmProcess, output, errorMessage]() {
+        *output += asmProcess.readAllStandardOutput();
+        *errorMessage += QString::fromStdString(asmProcess.readAllStandardError().toStdString());
+    });
+
+    asmProcess.start(processPath, arguments);
+
+    if (!asmProcess.waitForStarted()) {
+        *errorMessage += QApplication::translate("DisassemblyOutput",
+                                                 "<qt>Process failed to start: <tt>%1 %2</tt> returned <tt>%3</tt>.")
+                             .arg(processPath, arguments.join(QLatin1Char(' ')), asmProcess.errorString());
+        return false;
+    }
+
+    if (!asmProcess.waitForFinished(timeout)) {
+        *errorMessage += QApplication::translate("DisassemblyOutput",
+                                                 "<qt>Process not finished: <tt>%1 %2</tt>, stopped by timeout.")
+                             .arg(processPath, arguments.join(QLatin1Char(' ')));
+        return false;
     }
 
-    return {};
+    if (output->isEmpty()) {
+        *errorMessage += QApplication::translate("DisassemblyOutput", "<qt>Empty output of command <tt>%1 %2</tt>.")
+                             .arg(processPath, arguments.join(QLatin1Char(' ')));
+    }
+    return true;
 }
 
-bool isHexCharacter(QChar c)
+void indexFunctions(DisassembledBinary* binary)
 {
-    return (c >= QLatin1Char('0') && c <= QLatin1Char('9')) || (c >= QLatin1Char('a') && c <= QLatin1Char('f'));
+    const ByteView output(binary->output.constData(), binary->output.size());
+    std::string ansiBuffer;
+
+    quint64 lastAddr = 0;
+    auto finishFunction = [binary, &lastAddr](qsizetype end) {
+        if (!binary->functions.isEmpty()) {
+            auto& function = binary->functions.last();
+            function.length = end - function.offset;
+            function.size = lastAddr >= function.addr ? lastAddr - function.addr + 1 : 0;
+        }
+        lastAddr = 0;
+    };
+
+    size_t lineStart = 0;
+    while (lineStart < output.size()) {
+        const auto lineEnd = std::min(output.find('\n', lineStart), output.size());
+        const auto rawLine = output.substr(lineStart, lineEnd - lineStart);
+
+        quint64 addr = 0;
+        if (startsWith(rawLine, " ")) {
+            // an instruction like "    1265:\t55\tpush %rbp"
+            const auto instruction = trimmed(rawLine);
+            const auto colonIndex = instruction.find(':');
+            if (colonIndex != ByteView::npos && parseNumber(instruction.substr(0, colonIndex), 16, &addr)) {
+                lastAddr = std::max(lastAddr, addr);
+            }
+        } else if (!rawLine.empty() && isHexCharacter(rawLine.front())) {
+            // the start of a function like "0000000000001265 <main>:"
+            const auto line = removeAnsi(rawLine, &ansiBuffer);
+            const auto nameStart = line.find(" <");
+            if (nameStart != ByteView::npos && line.size() > nameStart + 4 && line.substr(line.size() - 2) == ">:"
+                && parseNumber(line.substr(0, nameStart), 16, &addr)) {
+                finishFunction(lineStart);
+
+                // strip suffixes like @plt, like extractLinkedFunction does
+                auto name = line.substr(nameStart + 2, line.size() - nameStart - 4);
+                const auto atIndex = name.find('@');
+                if (atIndex != ByteView::npos && atIndex > 0) {
+                    name = name.substr(0, atIndex);
+                }
+                const auto key = QByteArray(name.data(), static_cast<int>(name.size()));
+                if (!binary->functionsByName.contains(key)) {
+                    binary->functionsByName.insert(key, binary->functions.size());
+                }
+                binary->functions.push_back({addr, 0, static_cast<qsizetype>(lineStart), 0});
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+    finishFunction(binary->output.size());
+
+    // the functions are in the order of the output, which doesn't need to be sorted by address across sections
+    QVector<int> order(binary->functions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [binary](int lhs, int rhs) {
+        return binary->functions.at(lhs).addr < binary->functions.at(rhs).addr;
+    });
+    QVector<int> sortedIndices(order.size());
+    QVector<DisassembledBinary::Function> functions;
+    functions.reserve(order.size());
+    for (int i = 0, c = order.size(); i < c; ++i) {
+        sortedIndices[order[i]] = i;
+        functions.push_back(binary->functions.at(order[i]));
+    }
+    binary->functions = std::move(functions);
+    for (auto& index : binary->functionsByName) {
+        index = sortedIndices.at(index);
+    }
+}
+
+// parses the part of @p binary that belongs to @p symbol, returns false when no function starts at the symbol
+bool disassembleFromBinary(const DisassembledBinary& binary, const Data::Symbol& symbol,
+                           DisassemblyOutput::ObjectdumpOutput* output)
+{
+    const auto it = std::lower_bound(
+        binary.functions.cbegin(), binary.functions.cend(), symbol.relAddr,
+        [](const DisassembledBinary::Function& function, quint64 addr) { return function.addr < addr; });
+    if (it == binary.functions.cend() || it->addr != symbol.relAddr) {
+        return false;
+    }
+
+    *output = DisassemblyOutput::objdumpParse(
+        QByteArray::fromRawData(binary.output.constData() + it->offset, static_cast<int>(it->length)));
+
+    // like --stop-address, drop everything after the end of the symbol
+    auto& lines = output->disassemblyLines;
+    const auto stopAddress = symbol.relAddr + symbol.size;
+    const auto last = std::find_if(lines.rbegin(), lines.rend(),
+                                   [stopAddress](const DisassemblyOutput::DisassemblyLine& line) {
+                                       return line.addr && line.addr < stopAddress;
+                                   });
+    lines.erase(last.base(), lines.end());
+    return !lines.isEmpty();
 }
 }
 
@@ -147,6 +645,15 @@ QString findSourceCodeFile(const QString& originalPath, const QStringList& sourc
         return sysrootPath;
     }
 
+    auto& resolver = PathResolver::instance();
+    const auto newLine = QLatin1Char('\n');
+    const auto cacheKey = QLatin1String("source") + newLine + originalPath + newLine + sysroot + newLine
+        + sourceCodePaths.join(newLine);
+    const auto cached = resolver.cachedResult(cacheKey);
+    if (!cached.isEmpty()) {
+        return cached;
+    }
+
     for (const auto& sourcePath : sourceCodePaths) {
         for (auto it = originalPath.begin(); it != originalPath.end();
              it = std::find(++it, originalPath.end(), QDir::separator())) {
@@ -154,7 +661,9 @@ QString findSourceCodeFile(const QString& originalPath, const QStringList& sourc
                 QString(sourcePath + QDir::separator() + QString(it, std::distance(it, originalPath.end())));
             const auto info = QFileInfo(path);
             if (info.exists()) {
-                return info.canonicalFilePath();
+                const auto canonicalPath = info.canonicalFilePath();
+                resolver.cacheResult(cacheKey, canonicalPath);
+                return canonicalPath;
             }
         }
     }
@@ -165,18 +674,32 @@ QString findSourceCodeFile(const QString& originalPath, const QStringList& sourc
 DisassemblyOutput::ObjectdumpOutput DisassemblyOutput::objdumpParse(const QByteArray& output)
 {
     QVector<DisassemblyOutput::DisassemblyLine> disassemblyLines;
+    disassemblyLines.reserve(output.count('\n'));
+
+    ByteView remaining(output.constData(), output.size());
+    auto nextLine = [&remaining]() {
+        const auto lineEnd = remaining.find('\n');
+        auto line = remaining.substr(0, lineEnd);
+        remaining.remove_prefix(lineEnd == ByteView::npos ? remaining.size() : lineEnd + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        return line;
+    };
 
-    QTextStream stream(output);
-    QString asmLine;
     QString sourceFileName;
     QString currentSourceFileName;
+    // the file names repeat a lot, only convert them when they change
+    ByteView currentSourceFile;
+    std::string ansiBuffer;
 
     int sourceCodeLine = -1;
-    while (stream.readLineInto(&asmLine)) {
-        if (asmLine.isEmpty())
+    while (!remaining.empty()) {
+        const auto asmLine = nextLine();
+        if (asmLine.empty())
             continue;
 
-        if (asmLine.startsWith(QLatin1String("Disassembly"))) {
+        if (startsWith(asmLine, "Disassembly")) {
             // when the binary is given with an absolute path, we don't want to interpret
             // that as a source file, so clear it once we get to the Disassembly part
             sourceFileName.clear();
@@ -184,39 +707,39 @@ DisassemblyOutput::ObjectdumpOutput DisassemblyOutput::objdumpParse(const QByteA
         }
 
         // skip lines like these: 0000000000001265 <main>:
-        const int colonIndex = asmLine.indexOf(QLatin1Char(':'));
-        const int angleBracketIndex = asmLine.indexOf(QLatin1Char('<'));
-        if (angleBracketIndex > 0 && colonIndex > angleBracketIndex) {
+        const auto colonIndex = asmLine.find(':');
+        const auto angleBracketIndex = asmLine.find('<');
+        if (angleBracketIndex > 0 && colonIndex != ByteView::npos && colonIndex > angleBracketIndex) {
             // -l add a line like:
             // main():
             // after 0000000000001090 <main>:
-            stream.readLine();
+            nextLine();
             continue;
         }
 
         // we don't care about the file name
-        if (asmLine.startsWith(QLatin1Char('/')) && asmLine.contains(QStringLiteral("file format"))) {
+        if (startsWith(asmLine, "/") && asmLine.find("file format") != ByteView::npos) {
             continue;
-        } else if (asmLine.startsWith(QLatin1Char('/')) || asmLine.startsWith(QLatin1Char('.'))) {
+        } else if (startsWith(asmLine, "/") || startsWith(asmLine, ".")) {
             // extract source code line info
             // these look like this:
             // - /usr/include/c++/11.2.0/bits/stl_tree.h:2083 (discriminator 1)
             // - /usr/include/c++/11.2.0/bits/stl_tree.h:3452
             // - ././test.cpp
 
-            currentSourceFileName = asmLine.left(colonIndex);
+            const auto sourceFile = asmLine.substr(0, colonIndex);
+            if (sourceFile != currentSourceFile) {
+                currentSourceFile = sourceFile;
+                currentSourceFileName = toString(sourceFile);
+            }
             if (sourceFileName.isEmpty()) {
                 sourceFileName = currentSourceFileName;
             }
 
-            auto lineNumber = QStringView(asmLine).right(asmLine.length() - colonIndex - 1);
-            const auto spaceIndex = lineNumber.indexOf(QLatin1Char(' '));
-            if (spaceIndex != -1) {
-                lineNumber = lineNumber.left(spaceIndex);
-            }
-            bool ok = false;
-            const auto number = lineNumber.toInt(&ok);
-            if (ok) {
+            auto lineNumber = colonIndex == ByteView::npos ? asmLine : asmLine.substr(colonIndex + 1);
+            lineNumber = lineNumber.substr(0, lineNumber.find(' '));
+            int number = 0;
+            if (parseNumber(lineNumber, 10, &number)) {
                 sourceCodeLine = number;
             }
             continue;
@@ -225,60 +748,44 @@ DisassemblyOutput::ObjectdumpOutput DisassemblyOutput::objdumpParse(const QByteA
         // a line looks like this:
         // [spaces]addr:\t [branch visualization] [hexdump]\tdiassembly
         // we can simplify parsing by splitting it into three parts
+        const auto firstTab = asmLine.find('\t');
 
-        const auto parts = asmLine.split(QLatin1Char('\t'));
-
-        if (parts.size() == 1 && asmLine.endsWith(QLatin1Char(':'))) {
+        if (firstTab == ByteView::npos && asmLine.back() == ':') {
             // we got a line like:
             // std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >::_M_local_data():
             // pass them to the disassembler since this can be used for inlining
-            disassemblyLines.push_back({0, asmLine, {}, {}, {}, {currentSourceFileName, sourceCodeLine}});
+            disassemblyLines.push_back({0, toString(asmLine), {}, {}, {}, {currentSourceFileName, sourceCodeLine}});
             continue;
         }
 
-        const auto addr = [addrString = parts.value(0).trimmed(), &asmLine]() -> uint64_t {
-            const auto suffix = QLatin1Char(':');
-            if (!addrString.endsWith(suffix))
-                return 0;
-
-            bool ok = false;
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-            auto ret = addrString.leftRef(addrString.length() - 1).toULongLong(&ok, 16);
-#else
-            auto ret = addrString.left(addrString.length() - 1).toULongLong(&ok, 16);
-#endif
-
-            if (!ok) {
-                qCWarning(disassemblyoutput) << "unhandled asm line format:" << asmLine;
-                return 0;
+        const auto addrString = trimmed(asmLine.substr(0, firstTab));
+        auto rest = firstTab == ByteView::npos ? ByteView() : asmLine.substr(firstTab + 1);
+        const auto secondTab = rest.find('\t');
+        const auto branchesAndHex = rest.substr(0, secondTab);
+        rest = secondTab == ByteView::npos ? ByteView() : rest.substr(secondTab + 1);
+        const auto disassembly = trimmed(rest.substr(0, rest.find('\t')));
+
+        uint64_t addr = 0;
+        if (!addrString.empty() && addrString.back() == ':') {
+            if (!parseNumber(addrString.substr(0, addrString.size() - 1), 16, &addr)) {
+                qCWarning(disassemblyoutput) << "unhandled asm line format:" << toString(asmLine);
+                addr = 0;
             }
-
-            return ret;
-        }();
+        }
 
         // format is the following:
         //    /-  a5 54 12 ...
         //    |   64 a3 ....
         //    \-> 65 23 ....
         // so we can simply skip all characters until we meet a letter or a number
-        struct BranchesAndHexdump
-        {
-            QString branchVisualisation;
-            QString hexdump;
-        };
-        const auto [branchVisualisation, hexdump] = [branchesAndHex = parts.value(1)]() -> BranchesAndHexdump {
-            auto firstHexIt = std::find_if(branchesAndHex.cbegin(), branchesAndHex.cend(), isHexCharacter);
-            auto size = std::distance(branchesAndHex.cbegin(), firstHexIt);
-            auto branchVisualisation = branchesAndHex.mid(0, size);
-            auto hexdump = branchesAndHex.mid(size);
-            return {branchVisualisation, hexdump.trimmed()};
-        }();
+        const auto firstHexIt = std::find_if(branchesAndHex.cbegin(), branchesAndHex.cend(), isHexCharacter);
+        const auto branchesSize = static_cast<size_t>(std::distance(branchesAndHex.cbegin(), firstHexIt));
 
         disassemblyLines.push_back({addr,
-                                    parts.value(2).trimmed(),
-                                    branchVisualisation,
-                                    hexdump,
-                                    extractLinkedFunction(asmLine),
+                                    toString(disassembly),
+                                    toString(branchesAndHex.substr(0, branchesSize)),
+                                    toString(trimmed(branchesAndHex.substr(branchesSize))),
+                                    extractLinkedFunction(removeAnsi(asmLine, &ansiBuffer)),
                                     {currentSourceFileName, sourceCodeLine}});
     }
     return {disassemblyLines, sourceFileName};
@@ -287,7 +794,7 @@ DisassemblyOutput::ObjectdumpOutput DisassemblyOutput::objdumpParse(const QByteA
 DisassemblyOutput DisassemblyOutput::disassemble(const QString& objdump, const QString& arch,
                                                  const QStringList& debugPaths, const QStringList& extraLibPaths,
                                                  const QStringList& sourceCodePaths, const QString& sysroot,
-                                                 const Data::Symbol& symbol)
+                                                 const Data::Symbol& symbol, bool useBuiltinDisassembler)
 {
     DisassemblyOutput disassemblyOutput;
     disassemblyOutput.symbol = symbol;
@@ -306,6 +813,23 @@ DisassemblyOutput DisassemblyOutput::disassemble(const QString& objdump, const Q
         return disassemblyOutput;
     }
 
+#if Capstone_FOUND
+    if (useBuiltinDisassembler) {
+        DisassemblyOutput::ObjectdumpOutput output;
+        const auto binary = findBinaryForSymbol(debugPaths, extraLibPaths, symbol);
+        if (!binary.isEmpty() && BuiltinDisassembler::disassemble(binary, symbol, &output)) {
+            disassemblyOutput.disassemblyLines = output.disassemblyLines;
+            disassemblyOutput.mainSourceFileName = output.mainSourceFileName;
+            disassemblyOutput.realSourceFileName =
+                findSourceCodeFile(output.mainSourceFileName, sourceCodePaths, sysroot);
+            return disassemblyOutput;
+        }
+        qCDebug(disassemblyoutput) << "falling back to objdump for" << symbol.symbol << binary;
+    }
+#else
+    Q_UNUSED(useBuiltinDisassembler);
+#endif
+
     const auto processPath = QStandardPaths::findExecutable(objdump);
     if (processPath.isEmpty()) {
         disassemblyOutput.errorMessage =
@@ -316,74 +840,137 @@ DisassemblyOutput DisassemblyOutput::disassemble(const QString& objdump, const Q
         return disassemblyOutput;
     }
 
-    // NOTE: make sure to declare `output` before `asmProcess`, as when the latter gets destroyed it might
-    //       emit `readyRead` which then needs to access `output`, see also:
-    //       https://github.com/KDAB/hotspot/issues/542
-    QByteArray output;
-    QProcess asmProcess;
-    QObject::connect(&asmProcess, &QProcess::readyRead, [&asmProcess, &disassemblyOutput, &output]() {
-        output += asmProcess.readAllStandardOutput();
-        disassemblyOutput.errorMessage += QString::fromStdString(asmProcess.readAllStandardError().toStdString());
-    });
+    auto binary = findBinaryForSymbol(debugPaths, extraLibPaths, symbol);
+    if (binary.isEmpty()) {
+        disassemblyOutput.errorMessage +=
+            QApplication::translate("DisassemblyOutput", "<qt>Could not find binary <tt>%1</tt>.").arg(symbol.binary);
+        return disassemblyOutput;
+    }
+
+    auto finish = [&](const DisassemblyOutput::ObjectdumpOutput& objdumpOutput) {
+        disassemblyOutput.disassemblyLines = objdumpOutput.disassemblyLines;
+        disassemblyOutput.mainSourceFileName = objdumpOutput.mainSourceFileName;
+        disassemblyOutput.realSourceFileName =
+            findSourceCodeFile(objdumpOutput.mainSourceFileName, sourceCodePaths, sysroot);
+        return disassemblyOutput;
+    };
+
+    const auto commonArguments = objdumpArguments(processPath);
+    auto& cache = disassemblyCache();
+    {
+        // prefer the disassembly of the whole binary, see disassembleBinary
+        QMutexLocker lock(&cache.mutex);
+        const auto* disassembled = cache.binaries.object(disassemblyCacheKey(processPath, commonArguments, binary));
+        if (disassembled) {
+            DisassemblyOutput::ObjectdumpOutput objdumpOutput;
+            if (disassembleFromBinary(*disassembled, symbol, &objdumpOutput)) {
+                disassemblyOutput.errorMessage += disassembled->errorOutput;
+                return finish(objdumpOutput);
+            }
+        }
+    }
 
     // Call objdump with arguments: addresses range and binary file
     auto toHex = [](quint64 addr) -> QString { return QLatin1String("0x") + QString::number(addr, 16); };
-    auto arguments = QStringList {QStringLiteral("-d"), // disassemble
-                                  QStringLiteral("-l"), // include source code lines
-                                  QStringLiteral("-C"), // demangle names
-                                  QStringLiteral("--start-address"),
-                                  toHex(symbol.relAddr),
-                                  QStringLiteral("--stop-address"),
-                                  toHex(symbol.relAddr + symbol.size)};
+    const auto arguments = QStringList(commonArguments)
+        << QStringLiteral("--start-address") << toHex(symbol.relAddr) << QStringLiteral("--stop-address")
+        << toHex(symbol.relAddr + symbol.size) << binary;
+
+    const auto cacheKey = disassemblyCacheKey(processPath, arguments, binary);
+    {
+        QMutexLocker lock(&cache.mutex);
+        if (const auto* cached = cache.disassemblies.object(cacheKey)) {
+            disassemblyOutput.errorMessage += cached->errorOutput;
+            return finish(cached->output);
+        }
+    }
 
-    // only available for objdump 2.34+
-    if (canVisualizeJumps(processPath))
-        arguments.append(QStringLiteral("--visualize-jumps"));
-    else
-        qCInfo(disassemblyoutput) << "objdump binary does not support `--visualize-jumps`:" << processPath;
+    QByteArray output;
+    if (!runObjdump(processPath, arguments, 30000, &output, &disassemblyOutput.errorMessage)) {
+        return disassemblyOutput;
+    }
 
-    if (canUseSyntaxHighlighting(processPath)) {
-        arguments.append(QStringLiteral("--disassembler-color=color"));
-    } else {
-        qCInfo(disassemblyoutput) << "objdump binary does not support `--disassembler-color`:" << processPath;
+    const auto objdumpOutput = objdumpParse(output);
+    if (!output.isEmpty()) {
+        QMutexLocker lock(&cache.mutex);
+        cache.disassemblies.insert(cacheKey, new CachedDisassembly {objdumpOutput, disassemblyOutput.errorMessage},
+                                   std::max(1, static_cast<int>(objdumpOutput.disassemblyLines.size())));
     }
+    return finish(objdumpOutput);
+}
 
-    auto binary = findBinaryForSymbol(debugPaths, extraLibPaths, symbol);
-    if (binary.isEmpty()) {
-        disassemblyOutput.errorMessage +=
-            QApplication::translate("DisassemblyOutput", "<qt>Could not find binary <tt>%1</tt>.").arg(symbol.binary);
-        return disassemblyOutput;
+bool DisassemblyOutput::disassembleBinary(const QString& objdump, const QStringList& debugPaths,
+                                          const QStringList& extraLibPaths, const Data::Symbol& symbol)
+{
+    const auto processPath = QStandardPaths::findExecutable(objdump);
+    const auto binary = findBinaryForSymbol(debugPaths, extraLibPaths, symbol);
+    if (processPath.isEmpty() || binary.isEmpty()) {
+        return false;
+    }
+
+    auto arguments = objdumpArguments(processPath);
+    const auto cacheKey = disassemblyCacheKey(processPath, arguments, binary);
+    auto& cache = disassemblyCache();
+    {
+        QMutexLocker lock(&cache.mutex);
+        if (cache.binaries.contains(cacheKey)) {
+            return true;
+        } else if (cache.pendingBinaries.contains(cacheKey)) {
+            return false;
+        }
+        cache.pendingBinaries.insert(cacheKey);
     }
+
+    // this runs in the background, so don't time out for big binaries
+    auto disassembled = std::make_unique<DisassembledBinary>();
     arguments.append(binary);
+    const auto ok = runObjdump(processPath, arguments, -1, &disassembled->output, &disassembled->errorOutput)
+        && !disassembled->output.isEmpty();
+    if (ok) {
+        indexFunctions(disassembled.get());
+        qCDebug(disassemblyoutput) << "disassembled" << binary << "with" << disassembled->functions.size()
+                                   << "functions";
+    } else {
+        qCWarning(disassemblyoutput) << "failed to disassemble" << binary << disassembled->errorOutput;
+    }
 
-    asmProcess.start(processPath, arguments);
+    QMutexLocker lock(&cache.mutex);
+    cache.pendingBinaries.remove(cacheKey);
+    if (ok) {
+        const auto cost = std::max(1, static_cast<int>(disassembled->output.size() >> 20));
+        cache.binaries.insert(cacheKey, disassembled.release(), cost);
+    }
+    return ok;
+}
 
-    if (!asmProcess.waitForStarted()) {
-        disassemblyOutput.errorMessage +=
-            QApplication::translate("DisassemblyOutput",
-                                    "<qt>Process failed to start: <tt>%1 %2</tt> returned <tt>%3</tt>.")
-                .arg(processPath, arguments.join(QLatin1Char(' ')), asmProcess.errorString());
-        return disassemblyOutput;
+Data::Symbol DisassemblyOutput::findFunction(const QString& objdump, const QStringList& debugPaths,
+                                             const QStringList& extraLibPaths, const Data::Symbol& symbol,
+                                             const QString& name)
+{
+    const auto processPath = QStandardPaths::findExecutable(objdump);
+    const auto binary = findBinaryForSymbol(debugPaths, extraLibPaths, symbol);
+    if (processPath.isEmpty() || binary.isEmpty()) {
+        return {};
     }
 
-    if (!asmProcess.waitForFinished()) {
-        disassemblyOutput.errorMessage +=
-            QApplication::translate("DisassemblyOutput",
-                                    "<qt>Process not finished: <tt>%1 %2</tt>, stopped by timeout.")
-                .arg(processPath, arguments.join(QLatin1Char(' ')));
-        return disassemblyOutput;
+    // objdumpArguments locks the cache too
+    const auto cacheKey = disassemblyCacheKey(processPath, objdumpArguments(processPath), binary);
+    auto& cache = disassemblyCache();
+    QMutexLocker lock(&cache.mutex);
+    const auto* disassembled = cache.binaries.object(cacheKey);
+    if (!disassembled) {
+        return {};
     }
 
-    if (output.isEmpty()) {
-        disassemblyOutput.errorMessage +=
-            QApplication::translate("DisassemblyOutput", "<qt>Empty output of command <tt>%1 %2</tt>.")
-                .arg(processPath, arguments.join(QLatin1Char(' ')));
+    const auto it = disassembled->functionsByName.constFind(name.toUtf8());
+    if (it == disassembled->functionsByName.constEnd()) {
+        return {};
     }
+    const auto& function = disassembled->functions.at(it.value());
+    return {name, function.addr, function.size, symbol.binary, symbol.path, symbol.actualPath, symbol.isKernel};
+}
 
-    const auto objdumpOutput = objdumpParse(output);
-    disassemblyOutput.disassemblyLines = objdumpOutput.disassemblyLines;
-    disassemblyOutput.mainSourceFileName = objdumpOutput.mainSourceFileName;
-    disassemblyOutput.realSourceFileName =
-        findSourceCodeFile(objdumpOutput.mainSourceFileName, sourceCodePaths, sysroot);
-    return disassemblyOutput;
+void DisassemblyOutput::indexSearchPaths(const QStringList& paths)
+{
+    PathResolver::instance().index(paths);
 }
@@ -52,9 +52,28 @@ struct DisassemblyOutput
     };
     static ObjectdumpOutput objdumpParse(const QByteArray& objdumpOutput);
 
+    // with @p useBuiltinDisassembler the symbol gets decoded in-process when possible, objdump is only used as a
+    // fallback then. this requires hotspot to be built with capstone
     static DisassemblyOutput disassemble(const QString& objdump, const QString& arch, const QStringList& debugPaths,
                                          const QStringList& extraLibPaths, const QStringList& sourceCodePaths,
-                                         const QString& sysroot, const Data::Symbol& symbol);
+                                         const QString& sysroot, const Data::Symbol& symbol,
+                                         bool useBuiltinDisassembler = false);
+
+    // runs objdump once for the whole binary of @p symbol and keeps an index of the functions in it, disassemble()
+    // then serves all symbols of that binary from memory. this is slow for big binaries, so don't call it on the
+    // GUI thread. returns false when the binary couldn't be disassembled or is being disassembled already
+    static bool disassembleBinary(const QString& objdump, const QStringList& debugPaths,
+                                  const QStringList& extraLibPaths, const Data::Symbol& symbol);
+
+    // looks up a function by its name in the binary of @p symbol, which allows navigating to functions without
+    // samples. this only works after disassembleBinary(), otherwise an invalid symbol is returned
+    static Data::Symbol findFunction(const QString& objdump, const QStringList& debugPaths,
+                                     const QStringList& extraLibPaths, const Data::Symbol& symbol,
+                                     const QString& name);
+
+    // walks the given search paths for binaries ahead of time, otherwise that happens on the first disassembly
+    // pass all search paths, the indices of the other paths get dropped
+    static void indexSearchPaths(const QStringList& paths);
 };
 
 QString findSourceCodeFile(const QString& originalPath, const QStringList& sourceCodePaths, const QString& sysroot);
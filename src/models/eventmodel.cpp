@@ -7,14 +7,18 @@
 
 #include "eventmodel.h"
 
+#include "../jobscheduler.h"
+#include "../selfprofiler.h"
 #include "../util.h"
 
 #include <QDebug>
+#include <QPointer>
 #include <QSet>
 
-namespace {
-constexpr auto orderProcessByPid = [](const EventModel::Process& process, qint32 pid) { return process.pid < pid; };
+#include <algorithm>
+#include <numeric>
 
+namespace {
 enum class Tag : quint8
 {
     Invalid = 0,
@@ -80,7 +84,7 @@ int EventModel::rowCount(const QModelIndex& parent) const
     case Tag::Processes:
         return m_processes.value(parent.row()).threads.size();
     case Tag::Overview:
-        return (parent.row() == 0) ? m_data.cpus.size() : m_processes.size();
+        return (parent.row() == 0) ? m_cpuRows.size() : m_processes.size();
     case Tag::Root:
         return 2;
     };
@@ -125,11 +129,17 @@ QVariant EventModel::data(const QModelIndex& index, int role) const
     } else if (role == NumThreadsRole) {
         return m_data.threads.size();
     } else if (role == NumCpusRole) {
-        return static_cast<uint>(m_data.cpus.size());
+        return static_cast<uint>(m_cpuRows.size());
     } else if (role == TotalCostsRole) {
         return QVariant::fromValue(m_data.totalCosts);
     } else if (role == EventResultsRole) {
         return QVariant::fromValue(m_data);
+    } else if (role == OffCpuCostIdRole) {
+        return m_data.offCpuTimeCostId;
+    } else if (role == LostEventCostIdRole) {
+        return m_data.lostEventCostId;
+    } else if (role == HeatmapMaxCountsRole) {
+        return m_mipmapsReady ? QVariant::fromValue(m_mipmaps.heatmapMaxCounts) : QVariant();
     }
 
     auto tag = dataTag(index);
@@ -148,6 +158,21 @@ QVariant EventModel::data(const QModelIndex& index, int role) const
             }
         } else if (role == SortRole) {
             return index.row();
+        } else if (role == CpuIdRole) {
+            return Data::INVALID_CPU_ID;
+        } else if (index.row() == 1) {
+            // the processes row shows the activity of all threads
+            if (role == ThreadStartRole) {
+                return m_time.start;
+            } else if (role == ThreadEndRole) {
+                return m_time.end;
+            } else if (role == IsAggregateRole) {
+                return true;
+            } else if (role == MipmapsRole) {
+                return m_mipmapsReady ? QVariant::fromValue(m_mipmaps.allThreads) : QVariant();
+            } else if (role == RowKeyRole) {
+                return QVariant::fromValue((quint64(m_generation) << 32) | (3u << 30));
+            }
         }
         return {};
     } else if (tag == Tag::Processes) {
@@ -158,6 +183,16 @@ QVariant EventModel::data(const QModelIndex& index, int role) const
             return process.pid;
         else if (role == CpuIdRole)
             return Data::INVALID_CPU_ID;
+        else if (role == ThreadStartRole)
+            return process.time.start;
+        else if (role == ThreadEndRole)
+            return process.time.end;
+        else if (role == IsAggregateRole)
+            return true;
+        else if (role == MipmapsRole)
+            return m_mipmapsReady ? QVariant::fromValue(m_mipmaps.processes.at(index.row())) : QVariant();
+        else if (role == RowKeyRole)
+            return QVariant::fromValue((quint64(m_generation) << 32) | (1u << 30) | quint32(index.row()));
 
         if (role == Qt::ToolTipRole) {
             QString tooltip =
@@ -167,6 +202,7 @@ QVariant EventModel::data(const QModelIndex& index, int role) const
             quint64 runtime = 0;
             quint64 maxRuntime = 0;
             quint64 offCpuTime = 0;
+            Data::DurationHistogram offCpuDurations;
             quint64 numEvents = 0;
             for (const auto tid : process.threads) {
                 const auto thread = m_data.findThread(process.pid, tid);
@@ -174,6 +210,7 @@ QVariant EventModel::data(const QModelIndex& index, int role) const
                 runtime += thread->time.delta();
                 maxRuntime = std::max(thread->time.delta(), maxRuntime);
                 offCpuTime += thread->offCpuTime;
+                offCpuDurations.merge(thread->offCpuDurations);
                 numEvents += thread->events.size();
             }
 
@@ -188,6 +225,9 @@ QVariant EventModel::data(const QModelIndex& index, int role) const
                 tooltip += tr("Off-CPU time: %1 (%2% of combined thread runtime, %3% of total Off-CPU time)\n")
                                .arg(Util::formatTimeString(offCpuTime), Util::formatCostRelative(offCpuTime, runtime),
                                     Util::formatCostRelative(offCpuTime, m_totalOffCpuTime));
+                if (!offCpuDurations.isEmpty()) {
+                    tooltip += tr("Off-CPU durations: %1\n").arg(Util::formatDurationHistogram(offCpuDurations));
+                }
                 tooltip += tr("CPUs utilized: %1\n").arg(Util::formatCostRelative(onCpuTime, maxRuntime * 100));
             }
 
@@ -203,7 +243,7 @@ QVariant EventModel::data(const QModelIndex& index, int role) const
     const Data::CpuEvents* cpu = nullptr;
 
     if (tag == Tag::Cpus) {
-        cpu = &m_data.cpus[index.row()];
+        cpu = &m_data.cpus.at(m_cpuRows.at(index.row()));
     } else {
         Q_ASSERT(tag == Tag::Threads);
         const auto process = m_processes.value(tagData(index.internalId()));
@@ -225,10 +265,39 @@ QVariant EventModel::data(const QModelIndex& index, int role) const
     } else if (role == CpuIdRole) {
         return cpu ? cpu->cpuId : Data::INVALID_CPU_ID;
     } else if (role == EventsRole) {
-        return QVariant::fromValue(thread ? thread->events : (cpu ? cpu->events : Data::Events()));
+        if (thread) {
+            return QVariant::fromValue(thread->events);
+        }
+        return QVariant::fromValue(cpuEvents(index.row()));
+    } else if (role == MipmapsRole) {
+        if (!m_mipmapsReady) {
+            return {};
+        }
+        return QVariant::fromValue(thread ? m_mipmaps.threads.at(std::distance(m_data.threads.constData(), thread))
+                                          : m_mipmaps.cpus.at(index.row()));
+    } else if (role == IsAggregateRole) {
+        return false;
+    } else if (role == NumaNodeRole) {
+        return cpu ? cpu->numaNode : -1;
+    } else if (role == SearchIndexRole) {
+        auto& searchIndex = thread ? m_threadSearchIndices[std::distance(m_data.threads.constData(), thread)]
+                                   : m_cpuSearchIndices[index.row()];
+        if (searchIndex.isEmpty()) {
+            const auto events = thread ? thread->events : cpuEvents(index.row());
+            searchIndex = TimeLineSearchIndex::build(events, m_data.totalCosts.size(), m_data.offCpuTimeCostId);
+        }
+        return QVariant::fromValue(searchIndex);
+    } else if (role == RowKeyRole) {
+        // uniquely identifies the contents of this row, until new data is set
+        const quint32 row = thread ? quint32(std::distance(m_data.threads.constData(), thread))
+                                   : (quint32(index.row()) | (1u << 31));
+        return QVariant::fromValue((quint64(m_generation) << 32) | row);
     } else if (role == SortRole) {
-        if (index.column() == ThreadColumn)
-            return thread ? thread->tid : cpu->cpuId;
+        if (index.column() == ThreadColumn && cpu)
+            // groups the CPUs by their NUMA node
+            return QVariant::fromValue((quint64(quint32(cpu->numaNode + 1)) << 32) | cpu->cpuId);
+        else if (index.column() == ThreadColumn)
+            return thread->tid;
         else
             return thread ? thread->events.size() : cpu->events.size();
     }
@@ -241,6 +310,14 @@ QVariant EventModel::data(const QModelIndex& index, int role) const
             QString tooltip = cpu ? tr("CPU #%1\n").arg(cpu->cpuId)
                                   : tr("Thread %1, tid = %2, pid = %3\n")
                                         .arg(thread->name, QString::number(thread->tid), QString::number(thread->pid));
+            if (cpu && cpu->numaNode != -1) {
+                tooltip += tr("NUMA node: %1\n").arg(cpu->numaNode);
+                tooltip += tr("Migrations onto the NUMA node: %1\n")
+                               .arg(m_data.numaMigrations.value(cpu->numaNode));
+            }
+            if (thread && thread->numaMigrations > 0) {
+                tooltip += tr("NUMA node migrations: %1\n").arg(thread->numaMigrations);
+            }
             if (thread) {
                 const auto runtime = thread->time.delta();
                 const auto totalRuntime = m_time.delta();
@@ -255,6 +332,13 @@ QVariant EventModel::data(const QModelIndex& index, int role) const
                                    .arg(Util::formatTimeString(thread->offCpuTime),
                                         Util::formatCostRelative(thread->offCpuTime, runtime),
                                         Util::formatCostRelative(thread->offCpuTime, m_totalOffCpuTime));
+                    if (!thread->onCpuSlices.isEmpty()) {
+                        tooltip += tr("On-CPU slices: %1\n").arg(Util::formatDurationHistogram(thread->onCpuSlices));
+                    }
+                    if (!thread->offCpuDurations.isEmpty()) {
+                        tooltip += tr("Off-CPU durations: %1\n")
+                                       .arg(Util::formatDurationHistogram(thread->offCpuDurations));
+                    }
                 }
             }
             const auto numEvents = thread ? thread->events.size() : cpu->events.size();
@@ -277,10 +361,13 @@ QVariant EventModel::data(const QModelIndex& index, int role) const
 
 void EventModel::setData(const Data::EventResults& data)
 {
+    ScopedPhase phase("event model reset");
     beginResetModel();
     m_data = data;
+    ++m_generation;
     m_totalEvents = 0;
-    m_maxCost = 0;
+    // the parser computes this for us, scanning all events here would stall the GUI for large captures
+    m_maxCost = data.maxCost;
     m_processes.clear();
     m_totalOnCpuTime = 0;
     m_totalOffCpuTime = 0;
@@ -294,31 +381,51 @@ void EventModel::setData(const Data::EventResults& data)
             m_totalOffCpuTime += thread.offCpuTime;
             m_totalOnCpuTime += thread.time.delta() - thread.offCpuTime;
             m_totalEvents += thread.events.size();
-            auto it = std::lower_bound(m_processes.begin(), m_processes.end(), thread.pid, orderProcessByPid);
-            if (it == m_processes.end() || it->pid != thread.pid) {
-                m_processes.insert(it, {thread.pid, {thread.tid}, thread.name});
+        }
+
+        // group the threads by process with a single sort, keeping the order of the threads within a process
+        QVector<int> threadIndices(data.threads.size());
+        std::iota(threadIndices.begin(), threadIndices.end(), 0);
+        std::stable_sort(threadIndices.begin(), threadIndices.end(), [&data](int lhs, int rhs) {
+            return data.threads[lhs].pid < data.threads[rhs].pid;
+        });
+        for (auto threadIndex : std::as_const(threadIndices)) {
+            const auto& thread = data.threads[threadIndex];
+            if (m_processes.isEmpty() || m_processes.last().pid != thread.pid) {
+                m_processes.push_back({thread.pid, {thread.tid}, thread.name});
+                m_processes.last().time = thread.time;
             } else {
-                it->threads.append(thread.tid);
+                auto& process = m_processes.last();
+                process.threads.append(thread.tid);
+                process.time.start = std::min(process.time.start, thread.time.start);
+                process.time.end = std::max(process.time.end, thread.time.end);
                 // prefer process name, if we encountered a thread first
                 if (thread.pid == thread.tid)
-                    it->name = thread.name;
-            }
-
-            for (const auto& event : thread.events) {
-                if (event.type != 0) {
-                    // TODO: support multiple cost types somehow
-                    continue;
-                }
-                m_maxCost = std::max(event.cost, m_maxCost);
+                    process.name = thread.name;
             }
         }
 
-        // don't show timeline for CPU cores that did not receive any events
-        auto it = std::remove_if(m_data.cpus.begin(), m_data.cpus.end(),
-                                 [](const Data::CpuEvents& cpuEvents) { return cpuEvents.events.isEmpty(); });
-        m_data.cpus.erase(it, m_data.cpus.end());
     }
+    // don't show timeline for CPU cores that did not receive any events
+    // erasing them from m_data would detach it from the data shared with the other views
+    m_cpuRows.clear();
+    for (qint32 i = 0, c = m_data.cpus.size(); i < c; ++i) {
+        if (!m_data.cpus.at(i).events.isEmpty()) {
+            m_cpuRows.push_back(i);
+        }
+    }
+    m_cpuEvents.clear();
+    m_cpuEvents.resize(m_cpuRows.size());
+    m_cpuEventsResolved.fill(false, m_cpuRows.size());
+    m_mipmaps = {};
+    m_mipmapsReady = false;
+    m_threadSearchIndices.clear();
+    m_threadSearchIndices.resize(m_data.threads.size());
+    m_cpuSearchIndices.clear();
+    m_cpuSearchIndices.resize(m_cpuRows.size());
     endResetModel();
+
+    buildMipmaps();
 }
 
 Data::TimeRange EventModel::timeRange() const
@@ -326,6 +433,120 @@ Data::TimeRange EventModel::timeRange() const
     return m_time;
 }
 
+namespace {
+EventModel::Mipmaps buildAllMipmaps(const Data::EventResults& data, const QVector<qint32>& cpuRows,
+                                    const QVector<EventModel::Process>& processes, Data::TimeRange time)
+{
+    const auto numCostTypes = data.totalCosts.size();
+    EventModel::Mipmaps mipmaps;
+
+    mipmaps.threads.reserve(data.threads.size());
+    for (const auto& thread : data.threads) {
+        mipmaps.threads.append(TimeLineMipmap::build(thread.events, numCostTypes, time));
+    }
+
+    mipmaps.cpuEvents.reserve(cpuRows.size());
+    mipmaps.cpus.reserve(cpuRows.size());
+    for (const auto cpu : cpuRows) {
+        mipmaps.cpuEvents.append(data.cpuEvents(data.cpus.at(cpu)));
+        // unlike the threads, the CPUs get bins no matter how few events they have, the heatmap shades them all
+        TimeLineMipmap::Merger merger(numCostTypes, time);
+        merger.add(mipmaps.cpuEvents.last());
+        mipmaps.cpus.append(merger.result());
+    }
+
+    // the mipmaps of all CPUs share their time range and thus their bin widths
+    mipmaps.heatmapMaxCounts.resize(numCostTypes);
+    for (const auto& cpuMipmaps : std::as_const(mipmaps.cpus)) {
+        for (int type = 0, numTypes = cpuMipmaps.size(); type < numTypes; ++type) {
+            const auto& mipmap = cpuMipmaps.at(type);
+            auto& maxCounts = mipmaps.heatmapMaxCounts[type];
+            maxCounts.resize(std::max(maxCounts.size(), mipmap.numLevels()));
+            for (int level = 0, numLevels = mipmap.numLevels(); level < numLevels; ++level) {
+                for (const auto& bin : mipmap.bins(level)) {
+                    maxCounts[level] = std::max(maxCounts[level], bin.count);
+                }
+            }
+        }
+    }
+
+    TimeLineMipmap::Merger allThreads(numCostTypes, time);
+    mipmaps.processes.reserve(processes.size());
+    for (const auto& process : processes) {
+        // the threads with many events have their mipmaps already, only the others have to be binned here
+        TimeLineMipmap::Merger merger(numCostTypes, time);
+        for (const auto tid : process.threads) {
+            const auto* thread = data.findThread(process.pid, tid);
+            Q_ASSERT(thread);
+            if (thread->events.size() < TimeLineMipmap::MinEvents) {
+                merger.add(thread->events);
+            } else {
+                merger.add(mipmaps.threads.at(std::distance(data.threads.constData(), thread)));
+            }
+        }
+        mipmaps.processes.append(merger.result());
+        allThreads.add(mipmaps.processes.last());
+    }
+    mipmaps.allThreads = allThreads.result();
+
+    return mipmaps;
+}
+}
+
+void EventModel::buildMipmaps()
+{
+    // merging the rows of a large capture takes long, which would stall the first paint of the time line
+    JobScheduler::run(JobScheduler::Priority::Normal,
+                      [smartThis = QPointer<EventModel>(this), generation = m_generation, data = m_data,
+                       cpuRows = m_cpuRows, processes = m_processes, time = m_time]() {
+                          auto mipmaps = buildAllMipmaps(data, cpuRows, processes, time);
+                          QMetaObject::invokeMethod(
+                              smartThis.data(),
+                              [smartThis, generation, mipmaps = std::move(mipmaps)]() mutable {
+                                  if (smartThis && generation == smartThis->m_generation) {
+                                      smartThis->setMipmaps(std::move(mipmaps));
+                                  }
+                              },
+                              Qt::QueuedConnection);
+                      });
+}
+
+void EventModel::setMipmaps(Mipmaps mipmaps)
+{
+    m_mipmaps = std::move(mipmaps);
+    m_mipmapsReady = true;
+    // the CPU rows share the events resolved for their mipmaps
+    m_cpuEvents = m_mipmaps.cpuEvents;
+    m_cpuEventsResolved.fill(true, m_cpuRows.size());
+
+    const QVector<int> roles = {MipmapsRole, HeatmapMaxCountsRole};
+    auto emitDataChanged = [this, &roles](const QModelIndex& parent) {
+        const auto numRows = rowCount(parent);
+        if (numRows > 0) {
+            emit dataChanged(index(0, 0, parent), index(numRows - 1, NUM_COLUMNS - 1, parent), roles);
+        }
+    };
+    emitDataChanged({});
+    for (int overview = 0; overview < 2; ++overview) {
+        const auto overviewIndex = index(overview, 0);
+        emitDataChanged(overviewIndex);
+        if (overview == 1) {
+            for (int process = 0, c = rowCount(overviewIndex); process < c; ++process) {
+                emitDataChanged(index(process, 0, overviewIndex));
+            }
+        }
+    }
+}
+
+const Data::Events& EventModel::cpuEvents(int row) const
+{
+    if (!m_cpuEventsResolved.at(row)) {
+        m_cpuEvents[row] = m_data.cpuEvents(m_data.cpus.at(m_cpuRows.at(row)));
+        m_cpuEventsResolved[row] = true;
+    }
+    return m_cpuEvents.at(row);
+}
+
 QModelIndex EventModel::index(int row, int column, const QModelIndex& parent) const
 {
     if (row < 0 || row >= rowCount(parent) || column < 0 || column >= NUM_COLUMNS) {
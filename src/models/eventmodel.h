@@ -10,6 +10,8 @@
 #include <QAbstractItemModel>
 
 #include "data.h"
+#include "timelinemipmap.h"
+#include "timelinesearchindex.h"
 
 class EventModel : public QAbstractItemModel
 {
@@ -42,6 +44,19 @@ public:
         SortRole,
         TotalCostsRole,
         EventResultsRole,
+        // invalid until the mipmaps got built in the background, dataChanged gets emitted once they are ready
+        MipmapsRole,
+        OffCpuCostIdRole,
+        LostEventCostIdRole,
+        RowKeyRole,
+        SearchIndexRole,
+        // true for the rows of the processes and the one of all threads, whose MipmapsRole sums up their threads
+        // they have no events of their own
+        IsAggregateRole,
+        // the NUMA node of a CPU row, -1 when it is unknown
+        NumaNodeRole,
+        // the highest count of the mipmap bins of all CPU rows, per cost type and level, to shade the CPU heatmap
+        HeatmapMaxCountsRole,
     };
 
     int rowCount(const QModelIndex& parent = {}) const override;
@@ -69,11 +84,45 @@ public:
         qint32 pid;
         QVector<qint32> threads;
         QString name;
+        // from the start of the first thread to the end of the last one
+        Data::TimeRange time;
+    };
+
+    // all mipmaps of one set of event results, built off the GUI thread, see buildMipmaps
+    struct Mipmaps
+    {
+        QVector<QVector<TimeLineMipmap>> threads;
+        QVector<QVector<TimeLineMipmap>> cpus;
+        // merged from the mipmaps of the threads, such that collapsed processes show their activity
+        QVector<QVector<TimeLineMipmap>> processes;
+        QVector<TimeLineMipmap> allThreads;
+        // per cost type and level, to shade the CPU heatmap
+        QVector<QVector<quint32>> heatmapMaxCounts;
+        // the resolved events of the CPU rows, needed for their mipmaps anyway
+        QVector<Data::Events> cpuEvents;
     };
 
 private:
+    void buildMipmaps();
+    void setMipmaps(Mipmaps mipmaps);
+    const Data::Events& cpuEvents(int row) const;
+
+    // shared with the parser and the other views, so this must never be modified, see Data::EventResults
     Data::EventResults m_data;
+    // the indices into m_data.cpus of the CPU rows, CPUs that did not receive any events are not shown
+    QVector<qint32> m_cpuRows;
+    // the resolved events of the CPU rows, filled by the mipmap job or lazily when asked for before
+    mutable QVector<Data::Events> m_cpuEvents;
+    mutable QVector<bool> m_cpuEventsResolved;
+    // the timeline mipmaps of all rows, MipmapsRole returns nothing until the background job finished them
+    Mipmaps m_mipmaps;
+    bool m_mipmapsReady = false;
+    // the indices to find the events below the mouse, built once a row gets hovered
+    mutable QVector<TimeLineSearchIndex> m_threadSearchIndices;
+    mutable QVector<TimeLineSearchIndex> m_cpuSearchIndices;
     QVector<Process> m_processes;
+    // bumped whenever new data is set, part of the RowKeyRole
+    quint32 m_generation = 0;
     Data::TimeRange m_time;
     quint64 m_totalOnCpuTime = 0;
     quint64 m_totalOffCpuTime = 0;
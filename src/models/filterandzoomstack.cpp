@@ -43,14 +43,30 @@ FilterAndZoomStack::FilterAndZoomStack(QObject* parent)
         Q_ASSERT(data.canConvert<Data::Symbol>());
         filterInBySymbol(data.value<Data::Symbol>());
     });
+    connect(m_actions.filterInBySymbol, &QAction::hovered, this, [this]() {
+        const auto data = m_actions.filterInBySymbol->data();
+        if (data.canConvert<Data::Symbol>()) {
+            Data::FilterAction filter;
+            filter.includeSymbols.insert(data.value<Data::Symbol>());
+            hintFilter(filter);
+        }
+    });
 
     m_actions.filterOutBySymbol =
         new QAction(QIcon::fromTheme(QStringLiteral("view-filter")), tr("Filter Out By Symbol"), this);
     connect(m_actions.filterOutBySymbol, &QAction::triggered, this, [this]() {
-        const auto data = m_actions.filterInBySymbol->data();
+        const auto data = m_actions.filterOutBySymbol->data();
         Q_ASSERT(data.canConvert<Data::Symbol>());
         filterOutBySymbol(data.value<Data::Symbol>());
     });
+    connect(m_actions.filterOutBySymbol, &QAction::hovered, this, [this]() {
+        const auto data = m_actions.filterOutBySymbol->data();
+        if (data.canConvert<Data::Symbol>()) {
+            Data::FilterAction filter;
+            filter.excludeSymbols.insert(data.value<Data::Symbol>());
+            hintFilter(filter);
+        }
+    });
 
     m_actions.filterInByBinary =
         new QAction(QIcon::fromTheme(QStringLiteral("view-filter")), tr("Filter In By Binary"), this);
@@ -59,14 +75,30 @@ FilterAndZoomStack::FilterAndZoomStack(QObject* parent)
         Q_ASSERT(data.canConvert<QString>());
         filterInByBinary(data.value<QString>());
     });
+    connect(m_actions.filterInByBinary, &QAction::hovered, this, [this]() {
+        const auto data = m_actions.filterInByBinary->data();
+        if (data.canConvert<QString>()) {
+            Data::FilterAction filter;
+            filter.includeBinaries.insert(data.value<QString>());
+            hintFilter(filter);
+        }
+    });
 
     m_actions.filterOutByBinary =
         new QAction(QIcon::fromTheme(QStringLiteral("view-filter")), tr("Filter Out By Binary"), this);
     connect(m_actions.filterOutByBinary, &QAction::triggered, this, [this]() {
-        const auto data = m_actions.filterInByBinary->data();
+        const auto data = m_actions.filterOutByBinary->data();
         Q_ASSERT(data.canConvert<QString>());
         filterOutByBinary(data.value<QString>());
     });
+    connect(m_actions.filterOutByBinary, &QAction::hovered, this, [this]() {
+        const auto data = m_actions.filterOutByBinary->data();
+        if (data.canConvert<QString>()) {
+            Data::FilterAction filter;
+            filter.excludeBinaries.insert(data.value<QString>());
+            hintFilter(filter);
+        }
+    });
 
     connect(this, &FilterAndZoomStack::filterChanged, this, &FilterAndZoomStack::updateActions);
     connect(this, &FilterAndZoomStack::zoomChanged, this, &FilterAndZoomStack::updateActions);
@@ -154,6 +186,16 @@ void FilterAndZoomStack::filterInBySymbol(const Data::Symbol& symbol)
     applyFilter(filter);
 }
 
+void FilterAndZoomStack::filterInBySymbols(const QVector<Data::Symbol>& symbols)
+{
+    // only the samples whose stacks contain all of the symbols pass
+    Data::FilterAction filter;
+    for (const auto& symbol : symbols) {
+        filter.includeSymbols.insert(symbol);
+    }
+    applyFilter(filter);
+}
+
 void FilterAndZoomStack::filterOutBySymbol(const Data::Symbol& symbol)
 {
     Data::FilterAction filter;
@@ -176,6 +218,19 @@ void FilterAndZoomStack::filterOutByBinary(const QString& binary)
 }
 
 void FilterAndZoomStack::applyFilter(Data::FilterAction filter)
+{
+    filter = combinedFilter(std::move(filter));
+    m_filterStack.push_back(filter);
+
+    emit filterChanged(filter);
+}
+
+void FilterAndZoomStack::hintFilter(Data::FilterAction filter)
+{
+    emit filterHinted(combinedFilter(std::move(filter)));
+}
+
+Data::FilterAction FilterAndZoomStack::combinedFilter(Data::FilterAction filter) const
 {
     if (!m_filterStack.isEmpty()) {
         // apply previous filter state
@@ -200,10 +255,7 @@ void FilterAndZoomStack::applyFilter(Data::FilterAction filter)
         filter.includeBinaries += lastFilter.includeBinaries;
         filter.includeBinaries.subtract(filter.excludeBinaries);
     }
-
-    m_filterStack.push_back(filter);
-
-    emit filterChanged(filter);
+    return filter;
 }
 
 void FilterAndZoomStack::resetFilter()
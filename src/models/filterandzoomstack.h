@@ -49,10 +49,13 @@ public slots:
     void filterInByCpu(quint32 cpuId);
     void filterOutByCpu(quint32 cpuId);
     void filterInBySymbol(const Data::Symbol& symbol);
+    void filterInBySymbols(const QVector<Data::Symbol>& symbols);
     void filterOutBySymbol(const Data::Symbol& symbol);
     void filterInByBinary(const QString& binary);
     void filterOutByBinary(const QString& binary);
     void applyFilter(Data::FilterAction filter);
+    // announces that @p filter is likely to get applied next, e.g. while its menu entry is hovered
+    void hintFilter(Data::FilterAction filter);
     void resetFilter();
     void filterOut();
     void zoomIn(Data::TimeRange time);
@@ -62,10 +65,14 @@ public slots:
 
 signals:
     void filterChanged(const Data::FilterAction& filter);
+    // the filter that results when applying the hinted one on top of the current filter
+    void filterHinted(const Data::FilterAction& filter);
     void zoomChanged(Data::ZoomAction zoom);
 
 private:
     void updateActions() const;
+    // merges @p filter with the current filter
+    Data::FilterAction combinedFilter(Data::FilterAction filter) const;
 
     Actions m_actions;
     QVector<Data::FilterAction> m_filterStack;
@@ -0,0 +1,146 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "flamechartdata.h"
+
+#include <QHash>
+
+namespace {
+// levels beyond this would only be used when zooming out far beyond the capture
+const int MaxLevels = 16;
+}
+
+FlameChartData FlameChartData::build(const Data::Events& events, int costType, const QVector<QVector<qint32>>& stacks,
+                                     const Data::BottomUpResults& bottomUp)
+{
+    FlameChartData ret;
+
+    QVector<qint32> samples;
+    const auto& types = events.types();
+    const auto& stackIds = events.stackIds();
+    const auto& times = events.times();
+    for (qint32 i = 0, c = events.size(); i < c; ++i) {
+        if (types.at(i) == costType && stackIds.at(i) >= 0 && stackIds.at(i) < stacks.size()) {
+            samples.push_back(i);
+        }
+    }
+    if (samples.isEmpty()) {
+        return ret;
+    }
+
+    // the median time between two samples
+    QVector<quint64> deltas;
+    deltas.reserve(samples.size() - 1);
+    for (qint32 i = 1, c = samples.size(); i < c; ++i) {
+        deltas.push_back(times.at(samples.at(i)) - times.at(samples.at(i - 1)));
+    }
+    if (!deltas.isEmpty()) {
+        std::nth_element(deltas.begin(), deltas.begin() + deltas.size() / 2, deltas.end());
+        ret.m_period = deltas.at(deltas.size() / 2);
+    }
+    ret.m_period = std::max<quint64>(ret.m_period, 1);
+    const auto maxGap = 2 * ret.m_period;
+
+    QHash<Data::Symbol, qint32> symbolIds;
+    auto internSymbol = [&](const Data::Symbol& symbol) {
+        auto it = symbolIds.find(symbol);
+        if (it == symbolIds.end()) {
+            it = symbolIds.insert(symbol, ret.m_symbols.size());
+            ret.m_symbols.push_back(symbol);
+        }
+        return it.value();
+    };
+
+    struct OpenSpan
+    {
+        qint32 symbolId;
+        quint64 start;
+        quint32 numSamples;
+    };
+    QVector<OpenSpan> open;
+    QVector<QVector<Span>> spans;
+    auto closeFrom = [&](int depth, quint64 end) {
+        for (auto i = open.size() - 1; i >= depth; --i) {
+            const auto& span = open.at(i);
+            spans[i].push_back({span.start, end, span.symbolId, span.numSamples});
+        }
+        open.resize(depth);
+    };
+
+    QVector<qint32> frames;
+    quint64 lastEnd = 0;
+    for (qint32 i = 0, c = samples.size(); i < c; ++i) {
+        const auto time = times.at(samples.at(i));
+        if (time > lastEnd) {
+            // the thread didn't get sampled for a while, e.g. because it was sleeping
+            closeFrom(0, lastEnd);
+        }
+
+        // the frames start at the leaf, the chart starts at the outermost caller
+        frames.clear();
+        bottomUp.foreachFrame(stacks.at(stackIds.at(samples.at(i))),
+                              [&](const Data::Symbol& symbol, const Data::Location&) {
+                                  frames.push_back(internSymbol(symbol));
+                                  return true;
+                              });
+        std::reverse(frames.begin(), frames.end());
+
+        int common = 0;
+        while (common < open.size() && common < frames.size() && open.at(common).symbolId == frames.at(common)) {
+            ++open[common].numSamples;
+            ++common;
+        }
+        closeFrom(common, time);
+        if (spans.size() < frames.size()) {
+            spans.resize(frames.size());
+        }
+        for (int depth = common; depth < frames.size(); ++depth) {
+            open.push_back({frames.at(depth), time, 1});
+        }
+
+        const auto next = i + 1 < c ? times.at(samples.at(i + 1)) : time + ret.m_period;
+        lastEnd = time + std::min(next - time, maxGap);
+    }
+    closeFrom(0, lastEnd);
+
+    ret.m_time = {times.at(samples.constFirst()), lastEnd};
+    ret.m_levels.push_back(std::move(spans));
+
+    // every level keeps the spans of the previous one that are long enough, until no more spans get dropped
+    auto minDuration = ret.m_period;
+    while (ret.m_levels.size() < MaxLevels) {
+        minDuration *= LevelFactor;
+        const auto& previous = ret.m_levels.constLast();
+        QVector<QVector<Span>> level(previous.size());
+        bool droppedAny = false;
+        for (int depth = 0, numDepths = previous.size(); depth < numDepths; ++depth) {
+            for (const auto& span : previous.at(depth)) {
+                if (span.end - span.start >= minDuration) {
+                    level[depth].push_back(span);
+                } else {
+                    droppedAny = true;
+                }
+            }
+        }
+        if (!droppedAny) {
+            break;
+        }
+        ret.m_levels.push_back(std::move(level));
+    }
+
+    return ret;
+}
+
+int FlameChartData::levelForResolution(double timePerPixel) const
+{
+    int level = 0;
+    auto minDuration = static_cast<double>(m_period);
+    while (level + 1 < m_levels.size() && minDuration * LevelFactor <= timePerPixel) {
+        minDuration *= LevelFactor;
+        ++level;
+    }
+    return level;
+}
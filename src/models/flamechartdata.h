@@ -0,0 +1,104 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QVector>
+
+#include "data.h"
+
+#include <algorithm>
+
+// the sampled stacks of one thread in the order of time, as shown by a flame chart
+// consecutive samples that share a frame at some depth, and all the frames above it, get merged into one span
+// the spans are kept in levels of detail: every level drops the spans that are shorter than its minimum duration,
+// which bounds the number of spans that have to be painted for any zoom
+class FlameChartData
+{
+public:
+    struct Span
+    {
+        quint64 start = 0;
+        quint64 end = 0;
+        qint32 symbolId = -1;
+        quint32 numSamples = 0;
+    };
+
+    // every level requires four times the duration of the previous one
+    static const constexpr int LevelFactor = 4;
+
+    FlameChartData() = default;
+
+    // the spans of the events of @p costType, a sample lasts until the next one unless the gap is larger than
+    // twice the typical sampling period
+    static FlameChartData build(const Data::Events& events, int costType, const QVector<QVector<qint32>>& stacks,
+                                const Data::BottomUpResults& bottomUp);
+
+    bool isEmpty() const
+    {
+        return m_levels.isEmpty();
+    }
+
+    // the deepest stack, level 0 has one entry per depth
+    int depth() const
+    {
+        return m_levels.isEmpty() ? 0 : m_levels.constFirst().size();
+    }
+
+    int numLevels() const
+    {
+        return m_levels.size();
+    }
+
+    Data::TimeRange time() const
+    {
+        return m_time;
+    }
+
+    // the typical time between two samples, which is the minimum duration of the spans on level 0
+    quint64 period() const
+    {
+        return m_period;
+    }
+
+    // the coarsest level whose spans are not shorter than the given time per pixel
+    int levelForResolution(double timePerPixel) const;
+
+    const QVector<Span>& spans(int level, int depth) const
+    {
+        return m_levels.at(level).at(depth);
+    }
+
+    // calls @p callback with the spans at @p depth of @p level that overlap @p time, ordered by their start
+    template<typename Callback>
+    void forEachSpan(int level, int depth, Data::TimeRange time, const Callback& callback) const
+    {
+        if (level < 0 || level >= m_levels.size() || depth < 0 || depth >= m_levels.at(level).size()) {
+            return;
+        }
+        // the spans of one depth never overlap, so they are sorted by their end too
+        const auto& spans = m_levels.at(level).at(depth);
+        auto it = std::partition_point(spans.begin(), spans.end(),
+                                       [&time](const Span& span) { return span.end <= time.start; });
+        for (auto end = spans.end(); it != end && it->start <= time.end; ++it) {
+            callback(*it);
+        }
+    }
+
+    const Data::Symbol& symbol(qint32 id) const
+    {
+        return m_symbols.at(id);
+    }
+
+private:
+    Data::TimeRange m_time;
+    quint64 m_period = 0;
+    QVector<Data::Symbol> m_symbols;
+    // indexed by level and depth, the spans are ordered by their start
+    QVector<QVector<QVector<Span>>> m_levels;
+};
+
+Q_DECLARE_TYPEINFO(FlameChartData::Span, Q_PRIMITIVE_TYPE);
@@ -0,0 +1,273 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "flamegraphdata.h"
+
+#include <QSet>
+
+#include <algorithm>
+
+namespace {
+quint64 trigram(const QChar* text)
+{
+    return (quint64(text[0].unicode()) << 32) | (quint64(text[1].unicode()) << 16) | quint64(text[2].unicode());
+}
+
+void collectTrigrams(const QString& text, QSet<quint64>* trigrams)
+{
+    const auto folded = text.toCaseFolded();
+    for (int i = 0, c = folded.size() - 2; i < c; ++i) {
+        trigrams->insert(trigram(folded.constData() + i));
+    }
+}
+}
+
+qint32 FlameGraphData::internSymbol(const Data::Symbol& symbol)
+{
+    auto it = m_symbolIds.find(symbol);
+    if (it == m_symbolIds.end()) {
+        const auto id = m_symbols.size();
+        it = m_symbolIds.insert(symbol, id);
+        m_symbols.push_back(symbol);
+        m_symbolNodes.push_back({});
+
+        // symbols get added with increasing ids, which keeps the posting lists sorted
+        QSet<quint64> trigrams;
+        collectTrigrams(symbol.symbol, &trigrams);
+        collectTrigrams(symbol.binary, &trigrams);
+        for (const auto trigram : trigrams) {
+            m_trigramSymbols[trigram].push_back(id);
+        }
+    }
+    return it.value();
+}
+
+void FlameGraphData::addNode(const Node& node)
+{
+    m_symbolNodes[node.symbolId].push_back(m_nodes.size());
+    m_nodes.push_back(node);
+}
+
+bool FlameGraphData::matches(qint32 symbolId, const QString& text) const
+{
+    const auto& symbol = m_symbols.at(symbolId);
+    return symbol.symbol.contains(text, Qt::CaseInsensitive) || symbol.binary.contains(text, Qt::CaseInsensitive)
+        || (text == QLatin1String("??") && symbol.symbol.isEmpty());
+}
+
+QVector<qint32> FlameGraphData::search(const QString& text) const
+{
+    QVector<qint32> symbolIds;
+    const auto folded = text.toCaseFolded();
+    if (folded.size() < 3) {
+        // too short for the index, but there are typically far fewer symbols than nodes
+        for (qint32 id = 0, c = m_symbols.size(); id < c; ++id) {
+            if (matches(id, text)) {
+                symbolIds.push_back(id);
+            }
+        }
+    } else {
+        // intersect the posting lists of all trigrams of the text, starting with the shortest one
+        QVector<const QVector<qint32>*> postings;
+        for (int i = 0, c = folded.size() - 2; i < c; ++i) {
+            auto it = m_trigramSymbols.constFind(trigram(folded.constData() + i));
+            if (it == m_trigramSymbols.constEnd()) {
+                return {};
+            }
+            postings.push_back(&it.value());
+        }
+        std::sort(postings.begin(), postings.end(),
+                  [](const QVector<qint32>* lhs, const QVector<qint32>* rhs) { return lhs->size() < rhs->size(); });
+
+        symbolIds = *postings.constFirst();
+        QVector<qint32> intersection;
+        for (int i = 1; i < postings.size() && !symbolIds.isEmpty(); ++i) {
+            intersection.clear();
+            std::set_intersection(symbolIds.begin(), symbolIds.end(), postings[i]->begin(), postings[i]->end(),
+                                  std::back_inserter(intersection));
+            std::swap(symbolIds, intersection);
+        }
+
+        // the trigrams may come from both the symbol and the binary, or appear in a different order
+        symbolIds.erase(std::remove_if(symbolIds.begin(), symbolIds.end(),
+                                       [this, &text](qint32 id) { return !matches(id, text); }),
+                        symbolIds.end());
+    }
+
+    QVector<qint32> ret;
+    for (const auto id : symbolIds) {
+        ret.append(m_symbolNodes.at(id));
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
+qint32 FlameGraphData::findChild(qint32 id, const Data::Symbol& symbol) const
+{
+    // the children are sorted by their symbol
+    const auto& node = m_nodes.at(id);
+    auto first = node.firstChild;
+    auto count = node.numChildren;
+    while (count > 0) {
+        const auto step = count / 2;
+        if (this->symbol(first + step) < symbol) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first < node.firstChild + node.numChildren && this->symbol(first) == symbol ? first : -1;
+}
+
+qint32 FlameGraphData::findNode(const FlameGraphData& other, qint32 id) const
+{
+    if (m_nodes.isEmpty()) {
+        return -1;
+    }
+
+    // the root symbol is just a label that depends on the data, so skip it
+    QVector<qint32> path;
+    for (; id > 0; id = other.node(id).parent) {
+        path.push_back(id);
+    }
+
+    qint32 ret = 0;
+    for (auto it = path.crbegin(); it != path.crend() && ret != -1; ++it) {
+        ret = findChild(ret, other.symbol(*it));
+    }
+    return ret;
+}
+
+void FlameGraphData::layout(qint32 selected, double width)
+{
+    m_x.fill(0., m_nodes.size());
+    m_width.fill(0., m_nodes.size());
+    m_rows.clear();
+
+    if (m_nodes.isEmpty()) {
+        return;
+    }
+
+    // the selected node and all of its parents span the full width, their siblings are hidden
+    const auto selectedDepth = m_nodes.at(selected).depth;
+    m_rows.resize(selectedDepth + 1);
+    for (auto id = selected; id != -1; id = m_nodes.at(id).parent) {
+        m_width[id] = width;
+        m_rows[m_nodes.at(id).depth] = {id};
+    }
+
+    // then layout everything below the selected node, one depth after the other
+    for (int depth = selectedDepth;; ++depth) {
+        QVector<qint32> next;
+        for (const auto id : m_rows.at(depth)) {
+            const auto& node = m_nodes.at(id);
+            const auto parentWidth = m_width.at(id);
+            auto x = m_x.at(id);
+            for (auto child = node.firstChild, end = node.firstChild + node.numChildren; child < end; ++child) {
+                const auto w = parentWidth * double(m_nodes.at(child).cost) / node.cost;
+                if (w > 1) {
+                    m_x[child] = x;
+                    m_width[child] = w;
+                    next.push_back(child);
+                    x += w;
+                }
+            }
+        }
+        if (next.isEmpty()) {
+            break;
+        }
+        m_rows.push_back(std::move(next));
+    }
+}
+
+qint32 FlameGraphData::nodeAt(int depth, double x) const
+{
+    if (depth < 0 || depth >= m_rows.size()) {
+        return -1;
+    }
+
+    const auto& row = m_rows.at(depth);
+    // find the last node that starts at or before x
+    auto it = std::upper_bound(row.begin(), row.end(), x, [this](double x, qint32 id) { return x < m_x.at(id); });
+    if (it == row.begin()) {
+        return -1;
+    }
+    --it;
+    return x < m_x.at(*it) + m_width.at(*it) ? *it : -1;
+}
+
+namespace FlameGraphMultiples {
+QVector<Group> groups(const Data::EventResults& events, int type, Grouping grouping, int maxGroups)
+{
+    QVector<Group> groups;
+    QHash<qint32, int> processGroups;
+    for (qint32 i = 0, c = events.threads.size(); i < c; ++i) {
+        const auto& thread = events.threads.at(i);
+        qint64 cost = 0;
+        for (const auto& event : thread.events) {
+            if (event.type == type && event.stackId != -1) {
+                cost += event.cost;
+            }
+        }
+        if (cost == 0) {
+            continue;
+        }
+
+        Group* group = nullptr;
+        if (grouping == Grouping::Thread) {
+            groups.append({thread.name, thread.pid, thread.tid, {}, 0});
+            group = &groups.last();
+        } else {
+            auto it = processGroups.find(thread.pid);
+            if (it == processGroups.end()) {
+                it = processGroups.insert(thread.pid, groups.size());
+                groups.append({thread.name, thread.pid, Data::INVALID_TID, {}, 0});
+            }
+            group = &groups[it.value()];
+            // the main thread has the name of the process
+            if (thread.tid == thread.pid) {
+                group->name = thread.name;
+            }
+        }
+        group->threads.append(i);
+        group->cost += cost;
+    }
+
+    std::stable_sort(groups.begin(), groups.end(),
+                     [](const Group& lhs, const Group& rhs) { return lhs.cost > rhs.cost; });
+    if (groups.size() > maxGroups) {
+        groups.resize(maxGroups);
+    }
+    return groups;
+}
+
+FlameGraphData build(const Data::BottomUpResults& bottomUp, const Data::EventResults& events, const Group& group,
+                     int type, double costThreshold)
+{
+    // the symbols and locations are shared with the results of all threads
+    Data::BottomUpResults groupBottomUp;
+    groupBottomUp.symbols = bottomUp.symbols;
+    groupBottomUp.locations = bottomUp.locations;
+    groupBottomUp.foldInlines = bottomUp.foldInlines;
+    groupBottomUp.costs.initializeCostsFrom(bottomUp.costs);
+    groupBottomUp.costs.clearTotalCost();
+
+    auto frameCallback = [](const Data::Symbol& /*symbol*/, const Data::Location& /*location*/) {};
+    for (auto threadIndex : group.threads) {
+        for (const auto& event : events.threads.at(threadIndex).events) {
+            if (event.type == type && event.stackId >= 0 && event.stackId < events.stacks.size()) {
+                groupBottomUp.addEvent(type, event.cost, events.stacks.at(event.stackId), frameCallback);
+            }
+        }
+    }
+
+    const auto topDown = Data::TopDownResults::fromBottomUp(groupBottomUp, false);
+    const auto threshold = static_cast<qint64>(static_cast<double>(group.cost) * costThreshold / 100.);
+    return FlameGraphData::build(topDown.inclusiveCosts, type, topDown.root.children, threshold, false,
+                                 Data::Symbol(group.name));
+}
+}
@@ -0,0 +1,385 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QVector>
+
+#include <algorithm>
+
+#include "data.h"
+
+// a flat, array-backed flame graph
+// the nodes are stored breadth-first: every depth forms a contiguous range of the array and the children
+// of a node are stored consecutively, sorted by their symbol. the root node always has the id 0
+template<typename Tree>
+class FlameGraphBuilder;
+template<typename Tree>
+class FlameGraphDiff;
+
+class FlameGraphData
+{
+public:
+    struct Node
+    {
+        qint64 cost = 0;
+        qint32 symbolId = -1;
+        qint32 parent = -1;
+        qint32 firstChild = 0;
+        qint32 numChildren = 0;
+        qint32 depth = 0;
+    };
+
+    // converts the given top-down or bottom-up tree, children of nodes with a cost below @p costThreshold are skipped
+    template<typename Tree>
+    static FlameGraphData build(const Data::Costs& costs, int type, const QVector<Tree>& rows, qint64 costThreshold,
+                                bool collapseRecursion, const Data::Symbol& rootSymbol);
+
+    bool isEmpty() const
+    {
+        return m_nodes.isEmpty();
+    }
+
+    qint32 size() const
+    {
+        return m_nodes.size();
+    }
+
+    const Node& node(qint32 id) const
+    {
+        return m_nodes.at(id);
+    }
+
+    const Data::Symbol& symbol(qint32 id) const
+    {
+        return m_symbols.at(m_nodes.at(id).symbolId);
+    }
+
+    Data::Costs::Unit unit() const
+    {
+        return m_unit;
+    }
+
+    QString costName() const
+    {
+        return m_costName;
+    }
+
+    // differential flame graphs know the cost of every frame in a baseline capture, see FlameGraphDiff
+    bool hasBaseline() const
+    {
+        return !m_baselineCosts.isEmpty();
+    }
+
+    qint64 baselineCost(qint32 id) const
+    {
+        return m_baselineCosts.at(id);
+    }
+
+    // the direct child of @p id with the given symbol, or -1
+    qint32 findChild(qint32 id, const Data::Symbol& symbol) const;
+
+    // the node with the same symbol path as the node @p id of @p other, or -1
+    // this maps items across graphs that got built for different data of the same direction
+    qint32 findNode(const FlameGraphData& other, qint32 id) const;
+
+    // positions the nodes for a graph that is @p width pixels wide, where @p selected and its parents span the
+    // full width. nodes that would be narrower than a pixel are culled, together with all of their children
+    void layout(qint32 selected, double width);
+
+    double x(qint32 id) const
+    {
+        return m_x.at(id);
+    }
+
+    double width(qint32 id) const
+    {
+        return m_width.at(id);
+    }
+
+    bool isVisible(qint32 id) const
+    {
+        return m_width.at(id) > 0;
+    }
+
+    // the number of depths with visible nodes after the last layout
+    int numVisibleRows() const
+    {
+        return m_rows.size();
+    }
+
+    // the visible nodes of the given depth, sorted by their x position
+    const QVector<qint32>& visibleNodes(int depth) const
+    {
+        return m_rows.at(depth);
+    }
+
+    // the visible node at the given position, or -1
+    qint32 nodeAt(int depth, double x) const;
+
+    // the ids of all nodes whose symbol or binary contains @p text, case insensitively, sorted by id
+    // "??" additionally matches unresolved symbols
+    QVector<qint32> search(const QString& text) const;
+
+private:
+    template<typename Tree>
+    friend class FlameGraphBuilder;
+    template<typename Tree>
+    friend class FlameGraphDiff;
+
+    qint32 internSymbol(const Data::Symbol& symbol);
+    void addNode(const Node& node);
+    bool matches(qint32 symbolId, const QString& text) const;
+
+    QVector<Node> m_nodes;
+    QVector<Data::Symbol> m_symbols;
+    QHash<Data::Symbol, qint32> m_symbolIds;
+    // the search index: the nodes of every symbol and the symbols containing a given trigram, both sorted by id
+    QVector<QVector<qint32>> m_symbolNodes;
+    QHash<quint64, QVector<qint32>> m_trigramSymbols;
+    QVector<qint64> m_baselineCosts;
+    Data::Costs::Unit m_unit = Data::Costs::Unit::Unknown;
+    QString m_costName;
+    // the layout, indexed by node id
+    QVector<double> m_x;
+    QVector<double> m_width;
+    QVector<QVector<qint32>> m_rows;
+};
+
+// builds a FlameGraphData one depth after the other, which allows showing the upper part of the graph while the
+// deeper levels are still being generated. node ids stay stable while the graph grows
+template<typename Tree>
+class FlameGraphBuilder
+{
+public:
+    // the rows must outlive the builder
+    FlameGraphBuilder(const Data::Costs& costs, int type, const QVector<Tree>& rows, qint64 costThreshold,
+                      bool collapseRecursion, const Data::Symbol& rootSymbol)
+        : m_costs(costs)
+        , m_type(type)
+        , m_costThreshold(costThreshold)
+        , m_collapseRecursion(collapseRecursion)
+        , m_current({{&rows}})
+    {
+        m_data.m_unit = costs.unit(type);
+        m_data.m_costName = costs.typeName(type);
+
+        FlameGraphData::Node root;
+        root.cost = costs.totalCost(type);
+        root.symbolId = m_data.internSymbol(rootSymbol);
+        m_data.addNode(root);
+    }
+
+    const FlameGraphData& data() const
+    {
+        return m_data;
+    }
+
+    bool isFinished() const
+    {
+        return m_current.isEmpty();
+    }
+
+    // appends the children of the deepest nodes, returns false once the graph is complete
+    bool buildNextDepth();
+
+private:
+    // the rows whose children make up the children of a node on the current depth
+    using Sources = QVector<const QVector<Tree>*>;
+
+    struct Child
+    {
+        Data::Symbol symbol;
+        qint64 cost = 0;
+        Sources sources;
+    };
+
+    const Data::Costs& m_costs;
+    const int m_type;
+    const qint64 m_costThreshold;
+    const bool m_collapseRecursion;
+    FlameGraphData m_data;
+    QVector<Sources> m_current;
+    qint32 m_depthBegin = 0;
+};
+
+template<typename Tree>
+bool FlameGraphBuilder<Tree>::buildNextDepth()
+{
+    if (m_current.isEmpty()) {
+        return false;
+    }
+
+    QVector<Sources> next;
+    for (qint32 i = 0, c = m_current.size(); i < c; ++i) {
+        const auto id = m_depthBegin + i;
+        const auto nodeSymbol = m_data.symbol(id);
+        auto& sources = m_current[i];
+
+        // merge the rows with the same symbol, which can happen when recursion gets collapsed
+        QVector<Child> children;
+        QHash<Data::Symbol, int> childIndices;
+        for (int s = 0; s < sources.size(); ++s) {
+            const auto* source = sources.at(s);
+            for (const auto& row : *source) {
+                const auto cost = m_costs.cost(m_type, row.id);
+                if (m_collapseRecursion && !row.symbol.symbol.isEmpty() && row.symbol == nodeSymbol) {
+                    if (cost > m_costThreshold) {
+                        sources.append(&row.children);
+                    }
+                    continue;
+                }
+
+                auto it = childIndices.find(row.symbol);
+                if (it == childIndices.end()) {
+                    it = childIndices.insert(row.symbol, children.size());
+                    children.push_back({row.symbol, 0, {}});
+                }
+                auto& child = children[it.value()];
+                child.cost += cost;
+                child.sources.append(&row.children);
+            }
+        }
+
+        // sort to get reproducible graphs
+        std::sort(children.begin(), children.end(),
+                  [](const Child& lhs, const Child& rhs) { return lhs.symbol < rhs.symbol; });
+
+        auto& node = m_data.m_nodes[id];
+        node.firstChild = m_data.m_nodes.size();
+        node.numChildren = children.size();
+        const auto depth = node.depth + 1;
+
+        for (auto& child : children) {
+            FlameGraphData::Node childNode;
+            childNode.cost = child.cost;
+            childNode.symbolId = m_data.internSymbol(child.symbol);
+            childNode.parent = id;
+            childNode.depth = depth;
+            m_data.addNode(childNode);
+            next.push_back(child.cost > m_costThreshold ? std::move(child.sources) : Sources());
+        }
+    }
+    m_depthBegin += m_current.size();
+    m_current = std::move(next);
+    return !m_current.isEmpty();
+}
+
+// aligns the frames of a baseline capture with a flame graph by their symbol path
+// only the parts of the baseline that are also part of the flame graph get visited, which keeps this proportional
+// to the size of the graph instead of the size of the baseline. frames that don't exist in the baseline get a cost
+// of zero
+template<typename Tree>
+class FlameGraphDiff
+{
+public:
+    // the rows must outlive the diff
+    FlameGraphDiff(const Data::Costs& costs, int type, const QVector<Tree>& rows, bool collapseRecursion)
+        : m_costs(costs)
+        , m_type(type)
+        , m_collapseRecursion(collapseRecursion)
+        , m_baselineCosts({costs.totalCost(type)})
+        , m_sources({{&rows}})
+    {
+    }
+
+    // computes the baseline costs for the nodes of @p data that were added since the last call
+    // this can be used for intermediate results of a FlameGraphBuilder, pass @p isComplete for the final graph
+    void update(FlameGraphData* data, bool isComplete);
+
+private:
+    using Sources = QVector<const QVector<Tree>*>;
+
+    const Data::Costs& m_costs;
+    const int m_type;
+    const bool m_collapseRecursion;
+    QVector<qint64> m_baselineCosts;
+    // the rows that correspond to a node, indexed by node id
+    QVector<Sources> m_sources;
+    qint32 m_next = 0;
+};
+
+template<typename Tree>
+void FlameGraphDiff<Tree>::update(FlameGraphData* data, bool isComplete)
+{
+    if (data->isEmpty()) {
+        return;
+    }
+
+    m_baselineCosts.resize(data->size());
+    m_sources.resize(data->size());
+
+    // the children of the deepest nodes aren't known yet before the graph is complete
+    const auto maxDepth = data->node(data->size() - 1).depth;
+    for (; m_next < data->size(); ++m_next) {
+        const auto& node = data->node(m_next);
+        if (!isComplete && node.depth == maxDepth) {
+            break;
+        }
+
+        auto sources = std::move(m_sources[m_next]);
+        if (!node.numChildren) {
+            continue;
+        }
+
+        const auto& nodeSymbol = data->symbol(m_next);
+        for (int s = 0; s < sources.size(); ++s) {
+            for (const auto& row : *sources.at(s)) {
+                if (m_collapseRecursion && !row.symbol.symbol.isEmpty() && row.symbol == nodeSymbol) {
+                    sources.append(&row.children);
+                    continue;
+                }
+
+                const auto child = data->findChild(m_next, row.symbol);
+                if (child != -1) {
+                    m_baselineCosts[child] += m_costs.cost(m_type, row.id);
+                    m_sources[child].append(&row.children);
+                }
+            }
+        }
+    }
+
+    data->m_baselineCosts = m_baselineCosts;
+}
+
+template<typename Tree>
+FlameGraphData FlameGraphData::build(const Data::Costs& costs, int type, const QVector<Tree>& rows,
+                                     qint64 costThreshold, bool collapseRecursion, const Data::Symbol& rootSymbol)
+{
+    FlameGraphBuilder<Tree> builder(costs, type, rows, costThreshold, collapseRecursion, rootSymbol);
+    while (builder.buildNextDepth()) {
+    }
+    return builder.data();
+}
+
+// the small multiples of the flame graph: one compact top-down graph per thread or process, which allows comparing
+// e.g. the workers of a thread pool side by side. every group gets built on its own, so they can run in parallel
+namespace FlameGraphMultiples {
+enum class Grouping
+{
+    Thread,
+    Process,
+};
+
+struct Group
+{
+    QString name;
+    qint32 pid = Data::INVALID_PID;
+    // INVALID_TID when grouping by process
+    qint32 tid = Data::INVALID_TID;
+    // indices into Data::EventResults::threads
+    QVector<qint32> threads;
+    qint64 cost = 0;
+};
+
+// the groups with a cost of @p type, the most expensive ones first and at most @p maxGroups of them
+QVector<Group> groups(const Data::EventResults& events, int type, Grouping grouping, int maxGroups);
+
+// the top-down graph of the events of @p group, the nodes below @p costThreshold percent of its cost get skipped
+FlameGraphData build(const Data::BottomUpResults& bottomUp, const Data::EventResults& events, const Group& group,
+                     int type, double costThreshold);
+}
@@ -0,0 +1,171 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "flamegraphexport.h"
+
+#include <QCoreApplication>
+#include <QXmlStreamWriter>
+
+#include <algorithm>
+
+#include "../util.h"
+
+namespace {
+// the "hot" color space of upstream flamegraph.pl, but derived from the symbol to get reproducible files
+QString hotColor(const Data::Symbol& symbol)
+{
+    const auto hash = qHash(symbol.symbol) ^ qHash(symbol.binary);
+    return QStringLiteral("rgb(%1,%2,%3)").arg(205 + hash % 50).arg((hash >> 8) % 230).arg((hash >> 16) % 55);
+}
+
+template<typename Tree>
+class SvgExporter
+{
+public:
+    SvgExporter(const Data::Costs& costs, int type, const FlameGraphExport::Options& options)
+        : m_costs(costs)
+        , m_type(type)
+        , m_options(options)
+        , m_totalCost(costs.totalCost(type))
+        , m_scale(m_totalCost ? static_cast<double>(options.width - 2 * Padding) / m_totalCost : 0.)
+        // flamegraph.pl uses the same estimate, we cannot measure without a GUI
+        , m_charWidth(options.fontSize * 0.59)
+    {
+    }
+
+    bool write(QIODevice* device, const QVector<Tree>& rows)
+    {
+        m_numRows = numRows(rows, 1);
+        const auto height = TitleHeight + m_numRows * m_options.rowHeight + Padding;
+
+        QXmlStreamWriter xml(device);
+        xml.setAutoFormatting(true);
+        xml.writeStartDocument();
+        xml.writeStartElement(QStringLiteral("svg"));
+        xml.writeDefaultNamespace(QStringLiteral("http://www.w3.org/2000/svg"));
+        xml.writeAttribute(QStringLiteral("version"), QStringLiteral("1.1"));
+        xml.writeAttribute(QStringLiteral("width"), QString::number(m_options.width));
+        xml.writeAttribute(QStringLiteral("height"), QString::number(height));
+        xml.writeAttribute(QStringLiteral("viewBox"), QStringLiteral("0 0 %1 %2").arg(m_options.width).arg(height));
+        xml.writeAttribute(QStringLiteral("font-family"), QStringLiteral("monospace"));
+        xml.writeAttribute(QStringLiteral("font-size"), QString::number(m_options.fontSize));
+
+        const auto title = QCoreApplication::translate("FlameGraphExport", "%1 aggregated %2 cost in total")
+                               .arg(m_costs.formatCost(m_type, m_totalCost), m_costs.typeName(m_type));
+        xml.writeStartElement(QStringLiteral("text"));
+        xml.writeAttribute(QStringLiteral("x"), QString::number(m_options.width / 2));
+        xml.writeAttribute(QStringLiteral("y"), QString::number(TitleHeight - Padding));
+        xml.writeAttribute(QStringLiteral("text-anchor"), QStringLiteral("middle"));
+        xml.writeCharacters(title);
+        xml.writeEndElement();
+
+        writeFrame(&xml, Data::Symbol(title), m_totalCost, Padding, 0, m_totalCost * m_scale);
+        writeFrames(&xml, rows, Padding, 1);
+
+        xml.writeEndElement();
+        xml.writeEndDocument();
+        return !xml.hasError();
+    }
+
+private:
+    static const constexpr int Padding = 10;
+    static const constexpr int TitleHeight = 3 * Padding;
+
+    bool isVisible(const Tree& row) const
+    {
+        return m_costs.cost(m_type, row.id) * m_scale > m_options.minWidth;
+    }
+
+    // the number of rows required to show visible frames at @p depth and below
+    int numRows(const QVector<Tree>& rows, int depth) const
+    {
+        auto ret = depth;
+        for (const auto& row : rows) {
+            if (isVisible(row)) {
+                ret = std::max(ret, numRows(row.children, depth + 1));
+            }
+        }
+        return ret;
+    }
+
+    void writeFrames(QXmlStreamWriter* xml, const QVector<Tree>& rows, double x, int depth) const
+    {
+        // sort to get reproducible graphs, like in the interactive flame graph
+        QVector<const Tree*> sorted;
+        sorted.reserve(rows.size());
+        for (const auto& row : rows) {
+            sorted.push_back(&row);
+        }
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const Tree* lhs, const Tree* rhs) { return lhs->symbol < rhs->symbol; });
+
+        for (const auto* row : sorted) {
+            const auto cost = m_costs.cost(m_type, row->id);
+            const auto width = cost * m_scale;
+            if (width > m_options.minWidth) {
+                writeFrame(xml, row->symbol, cost, x, depth, width);
+                writeFrames(xml, row->children, x, depth + 1);
+            }
+            x += width;
+        }
+    }
+
+    void writeFrame(QXmlStreamWriter* xml, const Data::Symbol& symbol, qint64 cost, double x, int depth,
+                    double width) const
+    {
+        // the root is at the bottom, deeper frames are stacked on top of it
+        const auto y = TitleHeight + (m_numRows - 1 - depth) * m_options.rowHeight;
+        const auto text = depth ? Util::formatSymbol(symbol) : symbol.symbol;
+
+        xml->writeStartElement(QStringLiteral("g"));
+        xml->writeTextElement(QStringLiteral("title"),
+                              QStringLiteral("%1 (%2, %3%)")
+                                  .arg(text, m_costs.formatCost(m_type, cost),
+                                       Util::formatCostRelative(cost, m_totalCost)));
+
+        xml->writeStartElement(QStringLiteral("rect"));
+        xml->writeAttribute(QStringLiteral("x"), QString::number(x, 'f', 1));
+        xml->writeAttribute(QStringLiteral("y"), QString::number(y));
+        xml->writeAttribute(QStringLiteral("width"), QString::number(width, 'f', 1));
+        xml->writeAttribute(QStringLiteral("height"), QString::number(m_options.rowHeight - 1));
+        xml->writeAttribute(QStringLiteral("fill"), depth ? hotColor(symbol) : QStringLiteral("rgb(240,240,240)"));
+        xml->writeAttribute(QStringLiteral("rx"), QStringLiteral("2"));
+        xml->writeEndElement();
+
+        // elide the label to the frame, skip it when not even a few characters fit
+        const auto maxChars = static_cast<int>((width - 6) / m_charWidth);
+        if (maxChars >= 3) {
+            xml->writeStartElement(QStringLiteral("text"));
+            xml->writeAttribute(QStringLiteral("x"), QString::number(x + 3, 'f', 1));
+            xml->writeAttribute(QStringLiteral("y"), QString::number(y + m_options.rowHeight - 4));
+            xml->writeCharacters(text.size() > maxChars ? text.left(maxChars - 2) + QLatin1String("..") : text);
+            xml->writeEndElement();
+        }
+
+        xml->writeEndElement();
+    }
+
+    const Data::Costs& m_costs;
+    const int m_type;
+    const FlameGraphExport::Options m_options;
+    const qint64 m_totalCost;
+    const double m_scale;
+    const double m_charWidth;
+    int m_numRows = 1;
+};
+}
+
+namespace FlameGraphExport {
+bool writeSvg(QIODevice* device, const Data::TopDownResults& results, int costType, const Options& options)
+{
+    return SvgExporter<Data::TopDown>(results.inclusiveCosts, costType, options).write(device, results.root.children);
+}
+
+bool writeSvg(QIODevice* device, const Data::BottomUpResults& results, int costType, const Options& options)
+{
+    return SvgExporter<Data::BottomUp>(results.costs, costType, options).write(device, results.root.children);
+}
+}
@@ -0,0 +1,29 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "data.h"
+
+class QIODevice;
+
+// writes flame graphs as SVG straight from the parse results, without any widgets involved
+// the frames are streamed out while walking the tree, so only the current stack is kept in memory,
+// which allows exporting from the command line
+namespace FlameGraphExport {
+struct Options
+{
+    int width = 1200;
+    int rowHeight = 16;
+    int fontSize = 12;
+    // frames narrower than this many pixels are skipped, together with all of their children
+    double minWidth = 0.1;
+};
+
+// returns false when writing to @p device failed
+bool writeSvg(QIODevice* device, const Data::TopDownResults& results, int costType, const Options& options = {});
+bool writeSvg(QIODevice* device, const Data::BottomUpResults& results, int costType, const Options& options = {});
+}
@@ -28,7 +28,7 @@ public:
 
     int rowCount(const QModelIndex& parent = {}) const final override
     {
-        return parent.isValid() ? 0 : m_keys.size();
+        return parent.isValid() ? 0 : m_rowIterators.size();
     }
 
     QVariant headerData(int section, Qt::Orientation orientation = Qt::Horizontal,
@@ -47,39 +47,53 @@ public:
             return {};
         }
 
-        const auto& key = m_keys.value(index.row());
-        const auto& value = m_values.value(index.row());
-
-        return cell(index.column(), role, key, value);
+        const auto it = m_rowIterators.at(index.row());
+        return cell(index.column(), role, it.key(), it.value());
     }
 
     QModelIndex indexForKey(const typename Rows::key_type& key, int column = 0) const
     {
-        auto it = std::find(m_keys.begin(), m_keys.end(), key);
-        if (it == m_keys.end()) {
+        if (m_rowForKey.isEmpty() && !m_rowIterators.isEmpty()) {
+            // only built once another view selects something, most models never need it
+            m_rowForKey.reserve(m_rowIterators.size());
+            for (int row = 0, c = m_rowIterators.size(); row < c; ++row) {
+                m_rowForKey.insert(m_rowIterators.at(row).key(), row);
+            }
+        }
+        const auto it = m_rowForKey.constFind(key);
+        if (it == m_rowForKey.constEnd()) {
             return {};
         }
-        const int row = std::distance(m_keys.begin(), it);
-        return index(row, column);
+        return index(it.value(), column);
     }
 
     typename Rows::key_type key(int row) const
     {
-        return m_keys.value(row);
+        return row >= 0 && row < m_rowIterators.size() ? m_rowIterators.at(row).key() : typename Rows::key_type {};
+    }
+
+    QVector<typename Rows::key_type> keys() const
+    {
+        QVector<typename Rows::key_type> keys;
+        keys.reserve(m_rowIterators.size());
+        for (const auto& it : m_rowIterators) {
+            keys.push_back(it.key());
+        }
+        return keys;
     }
 
 protected:
+    // the rows are implicitly shared with @p rows, the model only keeps an iterator per row
     void setRows(const Rows& rows)
     {
         beginResetModel();
-        m_keys.reserve(rows.size());
-        m_values.reserve(rows.size());
-        m_keys.clear();
-        m_values.clear();
-        for (auto it = rows.constBegin(), end = rows.constEnd(); it != end; ++it) {
-            m_keys.push_back(it.key());
-            m_values.push_back(it.value());
+        m_rows = rows;
+        m_rowIterators.clear();
+        m_rowIterators.reserve(m_rows.size());
+        for (auto it = m_rows.constBegin(), end = m_rows.constEnd(); it != end; ++it) {
+            m_rowIterators.push_back(it);
         }
+        m_rowForKey.clear();
         endResetModel();
     }
 
@@ -88,6 +102,9 @@ protected:
                           const typename Rows::mapped_type& entry) const = 0;
     virtual int numColumns() const = 0;
 
-    QVector<typename Rows::key_type> m_keys;
-    QVector<typename Rows::mapped_type> m_values;
+private:
+    // never modified, which would detach it and invalidate the iterators
+    Rows m_rows;
+    QVector<typename Rows::const_iterator> m_rowIterators;
+    mutable QHash<typename Rows::key_type, int> m_rowForKey;
 };
@@ -28,6 +28,12 @@
 #include "formattingutils.h"
 
 #if KFSyntaxHighlighting_FOUND
+// the state of the highlighter at the start of a line, required for constructs that span lines like comments
+struct HighlightingState
+{
+    KSyntaxHighlighting::State state;
+};
+
 // highlighter using KSyntaxHighlighting
 class HighlightingImplementation : public KSyntaxHighlighting::AbstractHighlighter
 {
@@ -38,15 +44,22 @@ public:
     }
     ~HighlightingImplementation() override = default;
 
-    virtual QVector<QTextLayout::FormatRange> format(const QString& text)
+    // highlights @p text, starting in @p state which then gets updated to the state at the start of the next line
+    virtual QVector<QTextLayout::FormatRange> format(const QString& text, HighlightingState* state)
     {
         m_formats.clear();
 
-        highlightLine(text, {});
+        state->state = highlightLine(text, state->state);
 
         return m_formats;
     }
 
+    // whether a line can only be highlighted after all lines before it
+    virtual bool isStateful() const
+    {
+        return true;
+    }
+
     virtual void themeChanged()
     {
         if (!m_repository) {
@@ -87,6 +100,10 @@ private:
     QVector<QTextLayout::FormatRange> m_formats;
 };
 #else
+struct HighlightingState
+{
+};
+
 // stub incase KSyntaxHighlighting is not available
 class HighlightingImplementation
 {
@@ -94,11 +111,16 @@ public:
     HighlightingImplementation(KSyntaxHighlighting::Repository* /*repository*/) { }
     virtual ~HighlightingImplementation() = default;
 
-    virtual QVector<QTextLayout::FormatRange> format(const QString& text)
+    virtual QVector<QTextLayout::FormatRange> format(const QString& text, HighlightingState* /*state*/)
     {
         return {{QTextLayout::FormatRange {0, text.length(), {}}}};
     }
 
+    virtual bool isStateful() const
+    {
+        return false;
+    }
+
     virtual void themeChanged() { }
 
     virtual void setHighlightingDefinition(const KSyntaxHighlighting::Definition& /*definition*/) { }
@@ -118,7 +140,7 @@ public:
     }
     ~AnsiHighlightingImplementation() override = default;
 
-    QVector<QTextLayout::FormatRange> format(const QString& text) final
+    QVector<QTextLayout::FormatRange> format(const QString& text, HighlightingState* /*state*/) final
     {
         QVector<QTextLayout::FormatRange> formats;
 
@@ -167,6 +189,11 @@ public:
         return formats;
     }
 
+    bool isStateful() const final
+    {
+        return false;
+    }
+
     void themeChanged() override
     {
         m_colorScheme = KColorScheme(QPalette::Normal, KColorScheme::Complementary);
@@ -187,50 +214,38 @@ class HighlightedLine
 {
 public:
     HighlightedLine() = default;
-    HighlightedLine(HighlightingImplementation* highlighter, QString text)
-        : m_highlighter(highlighter)
-        , m_text(std::move(text))
-    {
-    }
 
     QTextLayout* layout() const
     {
-        if (!m_layout) {
-            m_layout = buildLayout();
-        }
         return m_layout.get();
     }
 
-    void updateHighlighting()
+    void setFormats(const QString& text, const QVector<QTextLayout::FormatRange>& formats)
     {
-        m_layout = nullptr;
-    }
+        m_layout = std::make_unique<QTextLayout>();
 
-private:
-    std::unique_ptr<QTextLayout> buildLayout() const
-    {
-        auto layout = std::make_unique<QTextLayout>();
-
-        layout->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
-        layout->setText(Util::removeAnsi(m_text));
-        layout->setFormats(m_highlighter->format(m_text));
+        m_layout->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+        m_layout->setText(Util::removeAnsi(text));
+        m_layout->setFormats(formats);
 
-        layout->beginLayout();
+        m_layout->beginLayout();
 
         // there is at most one line, so we don't need to check this multiple times
-        auto line = layout->createLine();
+        auto line = m_layout->createLine();
         if (line.isValid()) {
             line.setPosition(QPointF(0, 0));
         }
 
-        layout->endLayout();
+        m_layout->endLayout();
+    }
 
-        return layout;
+    void updateHighlighting()
+    {
+        m_layout = nullptr;
     }
 
-    HighlightingImplementation* m_highlighter = nullptr;
-    QString m_text;
-    mutable std::unique_ptr<QTextLayout> m_layout;
+private:
+    std::unique_ptr<QTextLayout> m_layout;
 };
 static_assert(std::is_nothrow_move_constructible_v<HighlightedLine>);
 static_assert(std::is_nothrow_destructible_v<HighlightedLine>);
@@ -243,6 +258,19 @@ HighlightedText::HighlightedText(KSyntaxHighlighting::Repository* repository, QO
 
 HighlightedText::~HighlightedText() = default;
 
+void HighlightedText::setRepository(KSyntaxHighlighting::Repository* repository)
+{
+    if (m_repository == repository)
+        return;
+
+    m_repository = repository;
+    if (m_highlighter && !m_isUsingAnsi) {
+        m_highlighter = std::make_unique<HighlightingImplementation>(m_repository);
+        resetHighlightingState();
+        updateHighlighting();
+    }
+}
+
 void HighlightedText::setText(const QStringList& text)
 {
     const bool usesAnsi =
@@ -259,10 +287,11 @@ void HighlightedText::setText(const QStringList& text)
         emit usesAnsiChanged(usesAnsi);
     }
 
+    // nothing gets highlighted here, see layoutForLine
+    m_highlightedLines.clear();
     m_highlightedLines.resize(text.size());
-    std::transform(text.cbegin(), text.cend(), m_highlightedLines.begin(), [this](const QString& text) {
-        return HighlightedLine {m_highlighter.get(), text};
-    });
+    m_lines = text;
+    resetHighlightingState();
 
     m_cleanedLines = text;
     std::for_each(m_cleanedLines.begin(), m_cleanedLines.end(), Util::removeAnsi);
@@ -274,6 +303,7 @@ void HighlightedText::setDefinition(const KSyntaxHighlighting::Definition& defin
     m_highlighter->setHighlightingDefinition(definition);
 #if KFSyntaxHighlighting_FOUND
     emit definitionChanged(definition.name());
+    resetHighlightingState();
     updateHighlighting();
 #endif
 }
@@ -286,8 +316,7 @@ QString HighlightedText::textAt(int index) const
 
 QTextLine HighlightedText::lineAt(int index) const
 {
-    auto& line = m_highlightedLines[index];
-    return line.layout()->lineAt(0);
+    return layout(index)->lineAt(0);
 }
 
 QString HighlightedText::definition() const
@@ -299,11 +328,62 @@ QString HighlightedText::definition() const
 
 QTextLayout* HighlightedText::layoutForLine(int index)
 {
-    return m_highlightedLines[index].layout();
+    return layout(index);
+}
+
+QTextLayout* HighlightedText::layout(int index) const
+{
+    auto& line = m_highlightedLines[index];
+    if (!line.layout()) {
+        line.setFormats(m_lines.at(index), formats(index));
+    }
+    return line.layout();
+}
+
+QVector<QTextLayout::FormatRange> HighlightedText::formats(int index) const
+{
+    HighlightingState state;
+    if (!m_highlighter->isStateful()) {
+        return m_highlighter->format(m_lines.at(index), &state);
+    }
+
+    // resume from the line after the last highlighted one when scrolling down, otherwise from the closest checkpoint
+    int line = 0;
+    const auto checkpoint = std::min(index / CheckpointInterval, static_cast<int>(m_checkpoints.size()) - 1);
+    if (m_resumeLine <= index && m_resumeLine >= checkpoint * CheckpointInterval) {
+        line = m_resumeLine;
+        state = *m_resumeState;
+    } else {
+        line = checkpoint * CheckpointInterval;
+        state = m_checkpoints[checkpoint];
+    }
+
+    QVector<QTextLayout::FormatRange> ret;
+    for (; line <= index; ++line) {
+        if (line == static_cast<int>(m_checkpoints.size()) * CheckpointInterval) {
+            m_checkpoints.push_back(state);
+        }
+        ret = m_highlighter->format(m_lines.at(line), &state);
+    }
+
+    m_resumeLine = line;
+    *m_resumeState = state;
+    return ret;
+}
+
+void HighlightedText::resetHighlightingState()
+{
+    m_checkpoints.assign(1, HighlightingState {});
+    m_resumeLine = 0;
+    if (!m_resumeState) {
+        m_resumeState = std::make_unique<HighlightingState>();
+    }
+    *m_resumeState = {};
 }
 
 void HighlightedText::updateHighlighting()
 {
+    // the highlighting state doesn't depend on the theme, so just drop the layouts that got built already
     m_highlighter->themeChanged();
     std::for_each(m_highlightedLines.begin(), m_highlightedLines.end(),
                   [](HighlightedLine& line) { line.updateHighlighting(); });
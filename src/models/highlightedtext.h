@@ -8,10 +8,12 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <QObject>
+#include <QStringList>
+#include <QTextLayout>
 
-class QTextLayout;
 class QTextLine;
 
 #include "hotspot-config.h"
@@ -24,6 +26,7 @@ class Repository;
 
 class HighlightingImplementation;
 class HighlightedLine;
+struct HighlightingState;
 
 class HighlightedText : public QObject
 {
@@ -32,6 +35,8 @@ public:
     HighlightedText(KSyntaxHighlighting::Repository* repository, QObject* parent = nullptr);
     ~HighlightedText() override;
 
+    // the repository can be set after construction since loading it is slow, see ResultsDisassemblyPage
+    void setRepository(KSyntaxHighlighting::Repository* repository);
     void setText(const QStringList& text);
     void setDefinition(const KSyntaxHighlighting::Definition& definition);
 
@@ -44,7 +49,8 @@ public:
         return m_isUsingAnsi;
     }
 
-    // for testing
+    // the lines get highlighted and laid out on demand, this is usually only done for the visible ones
+    // exposed for testing
     QTextLayout* layoutForLine(int index);
 
 signals:
@@ -55,9 +61,21 @@ public slots:
     void updateHighlighting();
 
 private:
+    QTextLayout* layout(int index) const;
+    QVector<QTextLayout::FormatRange> formats(int index) const;
+    void resetHighlightingState();
+
+    // the highlighting state gets remembered every CheckpointInterval lines
+    static constexpr int CheckpointInterval = 256;
+
     KSyntaxHighlighting::Repository* m_repository;
     std::unique_ptr<HighlightingImplementation> m_highlighter;
-    std::vector<HighlightedLine> m_highlightedLines;
+    mutable std::vector<HighlightedLine> m_highlightedLines;
+    // m_checkpoints[i] is the state at the start of line i * CheckpointInterval
+    mutable std::vector<HighlightingState> m_checkpoints;
+    // the state at the start of m_resumeLine, which follows the last highlighted line
+    mutable std::unique_ptr<HighlightingState> m_resumeState;
+    mutable int m_resumeLine = 0;
     QStringList m_lines;
     QStringList m_cleanedLines;
     bool m_isUsingAnsi = false;
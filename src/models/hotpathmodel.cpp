@@ -0,0 +1,244 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "hotpathmodel.h"
+
+#include "../util.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace {
+struct Candidate
+{
+    // the inclusive cost of a node that still needs to get expanded, or the self cost of a finished path
+    qint64 cost = 0;
+    // index into the visited nodes
+    int node = 0;
+    bool isPath = false;
+};
+
+// a strict order that doesn't depend on the order of the nodes in the heap, so the results are stable
+// finished paths come before the nodes of the same cost, which can't contain any hotter path
+bool isColder(const Candidate& lhs, const Candidate& rhs)
+{
+    if (lhs.cost != rhs.cost) {
+        return lhs.cost < rhs.cost;
+    } else if (lhs.isPath != rhs.isPath) {
+        return rhs.isPath;
+    }
+    return lhs.node > rhs.node;
+}
+
+QString formatFrames(const HotPath& path)
+{
+    QStringList frames;
+    frames.reserve(path.frames.size() + 1);
+    if (!path.group.symbol.isEmpty()) {
+        frames.append(Util::formatSymbol(path.group));
+    }
+    for (const auto& frame : path.frames) {
+        frames.append(Util::formatSymbol(frame));
+    }
+    return frames.join(QLatin1String(" > "));
+}
+}
+
+QVector<HotPath> hotPaths(const Data::TopDownResults& topDown, int type, int count, bool skipFirstLevel)
+{
+    const auto& inclusiveCosts = topDown.inclusiveCosts;
+    const auto& selfCosts = topDown.selfCosts;
+    if (count <= 0 || type < 0 || type >= inclusiveCosts.numTypes()) {
+        return {};
+    }
+
+    // the visited nodes link to their caller, which yields the frames of the paths in the end
+    struct Visited
+    {
+        const Data::TopDown* node = nullptr;
+        int parent = -1;
+    };
+    QVector<Visited> visited;
+    std::vector<Candidate> heap;
+
+    // the costs of the hottest paths seen so far, the coldest of them is a lower bound for the results
+    std::vector<qint64> bound;
+    auto isBelowBound = [&bound, count](qint64 cost) {
+        return static_cast<int>(bound.size()) == count && cost < bound.front();
+    };
+    auto addToBound = [&bound, count](qint64 cost) {
+        if (static_cast<int>(bound.size()) < count) {
+            bound.push_back(cost);
+            std::push_heap(bound.begin(), bound.end(), std::greater<>());
+        } else if (cost > bound.front()) {
+            std::pop_heap(bound.begin(), bound.end(), std::greater<>());
+            bound.back() = cost;
+            std::push_heap(bound.begin(), bound.end(), std::greater<>());
+        }
+    };
+
+    auto push = [&](const Candidate& candidate) {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(), heap.end(), isColder);
+    };
+    auto visit = [&](const Data::TopDown& node, int parent) {
+        const auto cost = inclusiveCosts.cost(type, node.id);
+        if (cost <= 0 || isBelowBound(cost)) {
+            return;
+        }
+        visited.push_back({&node, parent});
+        push({cost, static_cast<int>(visited.size() - 1), false});
+    };
+
+    for (const auto& child : topDown.root.children) {
+        visit(child, -1);
+    }
+
+    QVector<HotPath> paths;
+    while (!heap.empty() && paths.size() < count) {
+        std::pop_heap(heap.begin(), heap.end(), isColder);
+        const auto candidate = heap.back();
+        heap.pop_back();
+
+        if (candidate.isPath) {
+            // nothing that is left can be hotter than this
+            HotPath path;
+            for (auto i = candidate.node; i != -1; i = visited.at(i).parent) {
+                path.frames.prepend(visited.at(i).node->symbol);
+            }
+            if (skipFirstLevel) {
+                path.group = path.frames.takeFirst();
+            }
+            path.cost = selfCosts.itemCost(visited.at(candidate.node).node->id);
+            paths.push_back(std::move(path));
+            continue;
+        }
+
+        const auto* node = visited.at(candidate.node).node;
+        // the grouping first level never is the last frame of a stack
+        const auto selfCost = skipFirstLevel && visited.at(candidate.node).parent == -1
+            ? 0
+            : selfCosts.cost(type, node->id);
+        if (selfCost > 0) {
+            addToBound(selfCost);
+            push({selfCost, candidate.node, true});
+        }
+        for (const auto& child : node->children) {
+            visit(child, candidate.node);
+        }
+    }
+    return paths;
+}
+
+HotPathModel::HotPathModel(QObject* parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+HotPathModel::~HotPathModel() = default;
+
+void HotPathModel::setResults(const QVector<HotPath>& paths, const Data::Costs& selfCosts)
+{
+    beginResetModel();
+    m_paths = paths;
+    m_costs = {};
+    m_costs.initializeCostsFrom(selfCosts);
+    for (int row = 0, c = m_paths.size(); row < c; ++row) {
+        m_costs.add(row, m_paths[row].cost);
+    }
+    endResetModel();
+}
+
+int HotPathModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_paths.size();
+}
+
+int HotPathModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : NUM_BASE_COLUMNS + m_costs.numTypes();
+}
+
+QVariant HotPathModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (section < 0 || section >= columnCount() || orientation != Qt::Horizontal) {
+        return {};
+    }
+
+    if (role == Qt::InitialSortOrderRole && section > Path) {
+        return Qt::DescendingOrder;
+    } else if (role == Qt::DisplayRole) {
+        switch (section) {
+        case Path:
+            return tr("Path");
+        case Depth:
+            return tr("Depth");
+        }
+        return tr("%1 (self)").arg(m_costs.typeName(section - NUM_BASE_COLUMNS));
+    } else if (role == Qt::ToolTipRole) {
+        switch (section) {
+        case Path:
+            return tr("The call path from the outermost caller to the function the samples hit.");
+        case Depth:
+            return tr("The number of frames of the call path.");
+        }
+        return tr("The aggregated sample costs of exactly this call path, i.e. the self cost of its last frame.");
+    }
+
+    return {};
+}
+
+QVariant HotPathModel::data(const QModelIndex& index, int role) const
+{
+    if (!hasIndex(index.row(), index.column(), index.parent())) {
+        return {};
+    }
+
+    const auto row = index.row();
+    const auto& path = m_paths[row];
+    const auto column = index.column();
+
+    if (role == FramesRole) {
+        return QVariant::fromValue(path.frames);
+    } else if (role == SortRole) {
+        switch (column) {
+        case Path:
+            return formatFrames(path);
+        case Depth:
+            return path.frames.size();
+        }
+        return m_costs.cost(column - NUM_BASE_COLUMNS, row);
+    } else if (role == TotalCostRole && column >= NUM_BASE_COLUMNS) {
+        return m_costs.totalCost(column - NUM_BASE_COLUMNS);
+    } else if (role == Qt::DisplayRole) {
+        switch (column) {
+        case Path:
+            return formatFrames(path);
+        case Depth:
+            return path.frames.size();
+        }
+        return Util::formatCostRelative(m_costs.cost(column - NUM_BASE_COLUMNS, row),
+                                        m_costs.totalCost(column - NUM_BASE_COLUMNS), true);
+    } else if (role == Qt::ToolTipRole) {
+        QStringList frames;
+        frames.reserve(path.frames.size());
+        for (const auto& frame : path.frames) {
+            frames.append(Util::formatSymbolExtended(frame).toHtmlEscaped());
+        }
+        auto toolTip = frames.join(QLatin1String("<br/>"));
+        if (!path.group.symbol.isEmpty()) {
+            // see FramesRole, the group is not part of the frames
+            toolTip += QLatin1String("<hr/>")
+                + tr("Activating the path filters by its frames only, so the samples with the same path outside of "
+                     "%1 are kept as well.")
+                      .arg(Util::formatSymbol(path.group).toHtmlEscaped());
+        }
+        return QLatin1String("<qt>") + toolTip + QLatin1String("</qt>");
+    }
+
+    return {};
+}
@@ -0,0 +1,67 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QVector>
+
+#include "data.h"
+
+struct HotPath
+{
+    // from the outermost caller to the last frame of the stack
+    QVector<Data::Symbol> frames;
+    // the first level of the top down tree when it groups the costs, e.g. by thread
+    Data::Symbol group;
+    // the costs of the samples with exactly this stack, i.e. the self costs of its last frame
+    Data::ItemCost cost;
+};
+
+// the @p count call paths of @p topDown with the highest cost of @p type, the hottest first
+// a best-first search from the roots, where the inclusive cost of a node bounds the cost of all paths below it
+// subtrees that can't beat the paths found so far don't get expanded at all
+QVector<HotPath> hotPaths(const Data::TopDownResults& topDown, int type, int count, bool skipFirstLevel);
+
+class HotPathModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    explicit HotPathModel(QObject* parent = nullptr);
+    ~HotPathModel() override;
+
+    void setResults(const QVector<HotPath>& paths, const Data::Costs& selfCosts);
+
+    int rowCount(const QModelIndex& parent = {}) const override;
+    int columnCount(const QModelIndex& parent = {}) const override;
+
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    enum Columns
+    {
+        Path = 0,
+        Depth,
+    };
+    enum
+    {
+        NUM_BASE_COLUMNS = Depth + 1,
+        InitialSortColumn = Depth + 1 // the first cost column
+    };
+
+    enum Roles
+    {
+        SortRole = Qt::UserRole,
+        TotalCostRole,
+        // the frames of the path, see FilterAndZoomStack::filterInBySymbols
+        FramesRole,
+    };
+
+private:
+    QVector<HotPath> m_paths;
+    // the costs of the paths, indexed by row
+    Data::Costs m_costs;
+};
@@ -0,0 +1,156 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "lockcontention.h"
+
+#include <QSet>
+
+#include <algorithm>
+
+namespace {
+struct Tracepoints
+{
+    QLatin1String enter;
+    QLatin1String exit;
+    QLatin1String addressField;
+    // only set when the enter tracepoint doesn't always wait
+    QLatin1String opField;
+};
+
+const Tracepoints lockTracepoints[] = {
+    {QLatin1String("syscalls:sys_enter_futex"), QLatin1String("syscalls:sys_exit_futex"), QLatin1String("uaddr"),
+     QLatin1String("op")},
+    {QLatin1String("lock:contention_begin"), QLatin1String("lock:contention_end"), QLatin1String("lock_addr"),
+     QLatin1String()},
+};
+
+quint64 fieldValue(const Data::TracepointField& field, qsizetype row)
+{
+    // the pointers are numeric when decoded by libtraceevent, but may be formatted as hex numbers
+    return field.isNumeric ? static_cast<quint64>(field.values.at(row)) : field.text(row).toULongLong(nullptr, 0);
+}
+
+const Data::TracepointTable* findTable(const Data::TracepointResults& tracepoints, QLatin1String name)
+{
+    auto it = std::find_if(tracepoints.tables.begin(), tracepoints.tables.end(),
+                           [name](const Data::TracepointTable& table) { return table.name == name; });
+    return it == tracepoints.tables.end() ? nullptr : &*it;
+}
+
+// adds the waits of one kind of lock tracepoints to @p waits
+void pairWaits(const Data::TracepointTable& enter, const Data::TracepointTable& exit, const Tracepoints& names,
+               QVector<LockContention::Wait>* waits)
+{
+    const auto addressField = enter.fieldIndex(names.addressField);
+    if (addressField == -1) {
+        return;
+    }
+    const auto opField = names.opField.size() ? enter.fieldIndex(names.opField) : -1;
+    if (names.opField.size() && (opField == -1 || !enter.fields[opField].isNumeric)) {
+        return;
+    }
+
+    // both tables are ordered by time, an exit at the same time as an enter comes after it
+    QHash<qint32, LockContention::Wait> pending;
+    qsizetype enterRow = 0;
+    qsizetype exitRow = 0;
+    const auto numEnters = enter.size();
+    const auto numExits = exit.size();
+    while (enterRow < numEnters || exitRow < numExits) {
+        if (exitRow == numExits || (enterRow < numEnters && enter.times[enterRow] <= exit.times[exitRow])) {
+            const auto tid = enter.threadIds[enterRow];
+            if (opField == -1 || LockContention::isFutexWait(enter.fields[opField].values.at(enterRow))) {
+                LockContention::Wait wait;
+                wait.time.start = enter.times[enterRow];
+                wait.tid = tid;
+                wait.address = fieldValue(enter.fields[addressField], enterRow);
+                wait.stackId = enter.stackIds[enterRow];
+                pending.insert(tid, wait);
+            } else {
+                pending.remove(tid);
+            }
+            ++enterRow;
+        } else {
+            auto it = pending.find(exit.threadIds[exitRow]);
+            if (it != pending.end()) {
+                it->time.end = exit.times[exitRow];
+                waits->push_back(*it);
+                pending.erase(it);
+            }
+            ++exitRow;
+        }
+    }
+}
+}
+
+bool LockContention::isFutexWait(qint64 op)
+{
+    // see linux/futex.h, the private and realtime clock flags don't change the operation
+    enum
+    {
+        FUTEX_WAIT = 0,
+        FUTEX_LOCK_PI = 6,
+        FUTEX_WAIT_BITSET = 9,
+        FUTEX_WAIT_REQUEUE_PI = 11,
+        FUTEX_LOCK_PI2 = 13,
+        FUTEX_CMD_MASK = 127,
+    };
+    switch (op & FUTEX_CMD_MASK) {
+    case FUTEX_WAIT:
+    case FUTEX_LOCK_PI:
+    case FUTEX_WAIT_BITSET:
+    case FUTEX_WAIT_REQUEUE_PI:
+    case FUTEX_LOCK_PI2:
+        return true;
+    }
+    return false;
+}
+
+LockContention::LockContention(const Data::TracepointResults& tracepoints)
+{
+    for (const auto& names : lockTracepoints) {
+        const auto* enter = findTable(tracepoints, names.enter);
+        const auto* exit = findTable(tracepoints, names.exit);
+        if (enter && exit) {
+            pairWaits(*enter, *exit, names, &m_waits);
+        }
+    }
+    std::stable_sort(m_waits.begin(), m_waits.end(),
+                     [](const Wait& lhs, const Wait& rhs) { return lhs.time.start < rhs.time.start; });
+
+    // the distinct waiting threads of every lock and the wait time of every stack per lock
+    QSet<std::pair<quint64, qint32>> lockThreads;
+    QHash<std::pair<quint64, qint32>, quint64> lockStackTimes;
+    for (const auto& wait : std::as_const(m_waits)) {
+        auto& lock = m_locks[wait.address];
+        lock.cost.add(wait.time);
+        if (!lockThreads.contains({wait.address, wait.tid})) {
+            lockThreads.insert({wait.address, wait.tid});
+            ++lock.threads;
+        }
+
+        auto& stack = m_stacks[wait.stackId];
+        stack.cost.add(wait.time);
+        const auto key = std::make_pair(wait.address, wait.stackId);
+        if (!lockStackTimes.contains(key)) {
+            ++stack.locks;
+        }
+        lockStackTimes[key] += wait.time.delta();
+    }
+
+    QHash<quint64, quint64> topStackTimes;
+    for (auto it = lockStackTimes.cbegin(), end = lockStackTimes.cend(); it != end; ++it) {
+        const auto [address, stackId] = it.key();
+        auto& lock = m_locks[address];
+        auto topTime = topStackTimes.find(address);
+        // prefer the smaller stack id on ties, the order of the hash isn't stable
+        if (topTime == topStackTimes.end() || it.value() > *topTime
+            || (it.value() == *topTime && stackId < lock.topStackId)) {
+            topStackTimes.insert(address, it.value());
+            lock.topStackId = stackId;
+        }
+    }
+}
@@ -0,0 +1,102 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QVector>
+
+#include <algorithm>
+
+#include "data.h"
+
+// pairs the enter and exit tracepoints of the lock waits per thread, i.e. syscalls:sys_enter_futex with
+// syscalls:sys_exit_futex and lock:contention_begin with lock:contention_end of the kernel locks
+// the time every thread waited gets summed up per lock address and per stack of the waiting thread
+class LockContention
+{
+public:
+    struct Wait
+    {
+        Data::TimeRange time;
+        qint32 tid = Data::INVALID_TID;
+        quint64 address = 0;
+        // the stack of the thread that started waiting, see Data::EventResults::stacks
+        qint32 stackId = -1;
+    };
+
+    struct Cost
+    {
+        quint64 waits = 0;
+        quint64 waitTime = 0;
+        quint64 maxWaitTime = 0;
+        // from the start of the first wait to the end of the last one
+        Data::TimeRange time;
+
+        void add(Data::TimeRange wait)
+        {
+            time = waits ? Data::TimeRange(std::min(time.start, wait.start), std::max(time.end, wait.end)) : wait;
+            ++waits;
+            waitTime += wait.delta();
+            maxWaitTime = std::max(maxWaitTime, wait.delta());
+        }
+
+        quint64 averageWaitTime() const
+        {
+            return waits ? waitTime / waits : 0;
+        }
+    };
+
+    struct Lock
+    {
+        Cost cost;
+        // the number of threads that waited for the lock
+        qint32 threads = 0;
+        // the stack that waited the longest for the lock in total
+        qint32 topStackId = -1;
+    };
+
+    struct Stack
+    {
+        Cost cost;
+        // the number of locks the stack waited for
+        qint32 locks = 0;
+    };
+
+    LockContention() = default;
+    explicit LockContention(const Data::TracepointResults& tracepoints);
+
+    bool isEmpty() const
+    {
+        return m_waits.isEmpty();
+    }
+
+    // ordered by the start of the waits
+    const QVector<Wait>& waits() const
+    {
+        return m_waits;
+    }
+
+    const QHash<quint64, Lock>& locks() const
+    {
+        return m_locks;
+    }
+
+    const QHash<qint32, Stack>& stacks() const
+    {
+        return m_stacks;
+    }
+
+    // whether the futex operation @p op blocks the thread, as opposed to e.g. waking up the waiters
+    static bool isFutexWait(qint64 op);
+
+private:
+    QVector<Wait> m_waits;
+    QHash<quint64, Lock> m_locks;
+    QHash<qint32, Stack> m_stacks;
+};
+
+Q_DECLARE_TYPEINFO(LockContention::Wait, Q_MOVABLE_TYPE);
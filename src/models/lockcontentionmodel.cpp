@@ -0,0 +1,276 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "lockcontentionmodel.h"
+
+#include <QCoreApplication>
+
+#include <algorithm>
+
+#include "../util.h"
+
+namespace {
+QString tr(const char* text)
+{
+    return QCoreApplication::translate("LockContentionModel", text);
+}
+
+QString formatAddress(quint64 address)
+{
+    return QLatin1String("0x") + QString::number(address, 16);
+}
+}
+
+namespace LockContentionColumns {
+QVariant headerCell(int column, int role)
+{
+    if (role == Qt::InitialSortOrderRole) {
+        return Qt::DescendingOrder;
+    } else if (role == Qt::DisplayRole) {
+        switch (column) {
+        case Waits:
+            return tr("Waits");
+        case WaitTime:
+            return tr("Wait Time");
+        case MaxWaitTime:
+            return tr("Max Wait");
+        case AverageWaitTime:
+            return tr("Average Wait");
+        }
+    } else if (role == Qt::ToolTipRole) {
+        switch (column) {
+        case Waits:
+            return tr("How often the threads waited.");
+        case WaitTime:
+            return tr("The time the threads waited in total.");
+        case MaxWaitTime:
+            return tr("The longest time a thread waited at once.");
+        case AverageWaitTime:
+            return tr("The average time the threads waited at once.");
+        }
+    }
+    return {};
+}
+
+QVariant cell(int column, int role, const LockContention::Cost& cost)
+{
+    quint64 value = 0;
+    switch (column) {
+    case Waits:
+        value = cost.waits;
+        break;
+    case WaitTime:
+        value = cost.waitTime;
+        break;
+    case MaxWaitTime:
+        value = cost.maxWaitTime;
+        break;
+    case AverageWaitTime:
+        value = cost.averageWaitTime();
+        break;
+    default:
+        return {};
+    }
+    if (role == Qt::DisplayRole) {
+        return column == Waits ? Util::formatCost(value) : Util::formatTimeString(value);
+    } else if (role == Qt::UserRole) {
+        // the sort role of all the models
+        return value;
+    }
+    return {};
+}
+}
+
+void LockStacks::setResults(const LockContention& contention, const Data::BottomUpResults& bottomUp,
+                            const QVector<QVector<qint32>>& stacks)
+{
+    m_frames.clear();
+    const auto& lockStacks = contention.stacks();
+    for (auto it = lockStacks.cbegin(), end = lockStacks.cend(); it != end; ++it) {
+        if (it.key() < 0 || it.key() >= stacks.size()) {
+            continue;
+        }
+        QVector<Data::Symbol> frames;
+        bottomUp.foreachFrame(stacks[it.key()], [&frames](const Data::Symbol& symbol, const Data::Location&) {
+            frames.append(symbol);
+            return true;
+        });
+        // the stacks start at the leaf
+        std::reverse(frames.begin(), frames.end());
+        m_frames.insert(it.key(), frames);
+    }
+}
+
+QString LockStacks::format(qint32 stackId) const
+{
+    const auto frames = m_frames.value(stackId);
+    if (frames.isEmpty()) {
+        return tr("unknown stack");
+    }
+    QStringList names;
+    names.reserve(frames.size());
+    for (const auto& frame : frames) {
+        names.append(Util::formatSymbol(frame));
+    }
+    return names.join(QLatin1String(" > "));
+}
+
+QString LockStacks::toolTip(qint32 stackId) const
+{
+    QStringList names;
+    for (const auto& frame : m_frames.value(stackId)) {
+        names.append(Util::formatSymbolExtended(frame).toHtmlEscaped());
+    }
+    return QLatin1String("<qt>") + names.join(QLatin1String("<br/>")) + QLatin1String("</qt>");
+}
+
+LockModel::LockModel(QObject* parent)
+    : HashModel(parent)
+{
+}
+
+LockModel::~LockModel() = default;
+
+void LockModel::setResults(const LockContention& contention, const LockStacks& stacks)
+{
+    m_stacks = stacks;
+    setRows(contention.locks());
+}
+
+QVariant LockModel::headerCell(int column, int role) const
+{
+    if (column >= NUM_BASE_COLUMNS) {
+        return LockContentionColumns::headerCell(column - NUM_BASE_COLUMNS, role);
+    }
+    if (role == Qt::InitialSortOrderRole && column == Threads) {
+        return Qt::DescendingOrder;
+    } else if (role == Qt::DisplayRole) {
+        switch (column) {
+        case Address:
+            return tr("Lock");
+        case Threads:
+            return tr("Threads");
+        case TopWaiter:
+            return tr("Top Waiter");
+        }
+    } else if (role == Qt::ToolTipRole) {
+        switch (column) {
+        case Address:
+            return tr("The address of the futex or of the kernel lock the threads waited for.");
+        case Threads:
+            return tr("The number of threads that waited for the lock.");
+        case TopWaiter:
+            return tr("The stack that waited the longest for the lock in total, starting at the outermost caller.");
+        }
+    }
+    return {};
+}
+
+QVariant LockModel::cell(int column, int role, const quint64& address, const LockContention::Lock& lock) const
+{
+    if (column >= NUM_BASE_COLUMNS) {
+        return LockContentionColumns::cell(column - NUM_BASE_COLUMNS, role, lock.cost);
+    }
+    if (role == SortRole) {
+        switch (column) {
+        case Address:
+            return address;
+        case Threads:
+            return lock.threads;
+        case TopWaiter:
+            return m_stacks.format(lock.topStackId);
+        }
+    } else if (role == Qt::DisplayRole) {
+        switch (column) {
+        case Address:
+            return formatAddress(address);
+        case Threads:
+            return lock.threads;
+        case TopWaiter:
+            return m_stacks.format(lock.topStackId);
+        }
+    } else if (role == Qt::ToolTipRole && column == TopWaiter) {
+        return m_stacks.toolTip(lock.topStackId);
+    } else if (role == TimeRole) {
+        return QVariant::fromValue(lock.cost.time);
+    }
+    return {};
+}
+
+int LockModel::numColumns() const
+{
+    return NUM_BASE_COLUMNS + LockContentionColumns::NUM_COLUMNS;
+}
+
+LockStackModel::LockStackModel(QObject* parent)
+    : HashModel(parent)
+{
+}
+
+LockStackModel::~LockStackModel() = default;
+
+void LockStackModel::setResults(const LockContention& contention, const LockStacks& stacks)
+{
+    m_stacks = stacks;
+    setRows(contention.stacks());
+}
+
+QVariant LockStackModel::headerCell(int column, int role) const
+{
+    if (column >= NUM_BASE_COLUMNS) {
+        return LockContentionColumns::headerCell(column - NUM_BASE_COLUMNS, role);
+    }
+    if (role == Qt::InitialSortOrderRole && column == Locks) {
+        return Qt::DescendingOrder;
+    } else if (role == Qt::DisplayRole) {
+        switch (column) {
+        case Stack:
+            return tr("Stack");
+        case Locks:
+            return tr("Locks");
+        }
+    } else if (role == Qt::ToolTipRole) {
+        switch (column) {
+        case Stack:
+            return tr("The stack of the waiting threads, starting at the outermost caller.");
+        case Locks:
+            return tr("The number of locks the stack waited for.");
+        }
+    }
+    return {};
+}
+
+QVariant LockStackModel::cell(int column, int role, const qint32& stackId, const LockContention::Stack& stack) const
+{
+    if (column >= NUM_BASE_COLUMNS) {
+        return LockContentionColumns::cell(column - NUM_BASE_COLUMNS, role, stack.cost);
+    }
+    if (role == SortRole) {
+        switch (column) {
+        case Stack:
+            return m_stacks.format(stackId);
+        case Locks:
+            return stack.locks;
+        }
+    } else if (role == Qt::DisplayRole) {
+        switch (column) {
+        case Stack:
+            return m_stacks.format(stackId);
+        case Locks:
+            return stack.locks;
+        }
+    } else if (role == Qt::ToolTipRole && column == Stack) {
+        return m_stacks.toolTip(stackId);
+    } else if (role == TimeRole) {
+        return QVariant::fromValue(stack.cost.time);
+    }
+    return {};
+}
+
+int LockStackModel::numColumns() const
+{
+    return NUM_BASE_COLUMNS + LockContentionColumns::NUM_COLUMNS;
+}
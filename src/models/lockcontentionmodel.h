@@ -0,0 +1,110 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "data.h"
+#include "hashmodel.h"
+#include "lockcontention.h"
+
+// the columns the models of the lock contention share, they come after the base columns of every model
+namespace LockContentionColumns {
+enum Columns
+{
+    Waits = 0,
+    WaitTime,
+    MaxWaitTime,
+    AverageWaitTime,
+    NUM_COLUMNS
+};
+
+QVariant headerCell(int column, int role);
+QVariant cell(int column, int role, const LockContention::Cost& cost);
+}
+
+// resolves the stacks of the waiting threads, with the outermost caller first
+class LockStacks
+{
+public:
+    void setResults(const LockContention& contention, const Data::BottomUpResults& bottomUp,
+                    const QVector<QVector<qint32>>& stacks);
+
+    QVector<Data::Symbol> frames(qint32 stackId) const
+    {
+        return m_frames.value(stackId);
+    }
+
+    QString format(qint32 stackId) const;
+    QString toolTip(qint32 stackId) const;
+
+private:
+    QHash<qint32, QVector<Data::Symbol>> m_frames;
+};
+
+// the addresses of the contended locks, i.e. of the futexes or of the kernel locks
+class LockModel : public HashModel<QHash<quint64, LockContention::Lock>, LockModel>
+{
+    Q_OBJECT
+public:
+    explicit LockModel(QObject* parent = nullptr);
+    ~LockModel();
+
+    void setResults(const LockContention& contention, const LockStacks& stacks);
+
+    enum Columns
+    {
+        Address = 0,
+        Threads,
+        TopWaiter,
+        NUM_BASE_COLUMNS
+    };
+
+    enum Roles
+    {
+        SortRole = Qt::UserRole,
+        // the time from the first to the last wait, to zoom the timeline onto it
+        TimeRole,
+    };
+
+    QVariant headerCell(int column, int role) const final override;
+    QVariant cell(int column, int role, const quint64& address, const LockContention::Lock& lock) const final override;
+    int numColumns() const final override;
+
+private:
+    LockStacks m_stacks;
+};
+
+// the stacks of the threads that waited for the locks
+class LockStackModel : public HashModel<QHash<qint32, LockContention::Stack>, LockStackModel>
+{
+    Q_OBJECT
+public:
+    explicit LockStackModel(QObject* parent = nullptr);
+    ~LockStackModel();
+
+    void setResults(const LockContention& contention, const LockStacks& stacks);
+
+    enum Columns
+    {
+        Stack = 0,
+        Locks,
+        NUM_BASE_COLUMNS
+    };
+
+    enum Roles
+    {
+        SortRole = Qt::UserRole,
+        TimeRole,
+    };
+
+    QVariant headerCell(int column, int role) const final override;
+    QVariant cell(int column, int role, const qint32& stackId,
+                  const LockContention::Stack& stack) const final override;
+    int numColumns() const final override;
+
+private:
+    LockStacks m_stacks;
+};
@@ -0,0 +1,469 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "perfettoexport.h"
+
+#include <QHash>
+
+#include <vector>
+
+#include "protobuf.h"
+
+namespace {
+// the field numbers of the messages in perfetto/protos/perfetto/trace, only the ones that get written
+namespace Proto {
+namespace Trace {
+enum Field : quint32
+{
+    Packet = 1,
+};
+}
+namespace TracePacket {
+enum Field : quint32
+{
+    Timestamp = 8,
+    TrustedPacketSequenceId = 10,
+    TrackEvent = 11,
+    InternedData = 12,
+    SequenceFlags = 13,
+    TracePacketDefaults = 59,
+    TrackDescriptor = 60,
+    PerfSample = 66,
+};
+enum SequenceFlags : quint32
+{
+    IncrementalStateCleared = 1,
+    NeedsIncrementalState = 2,
+};
+}
+namespace TracePacketDefaults {
+enum Field : quint32
+{
+    PerfSampleDefaults = 12,
+};
+}
+namespace PerfSampleDefaults {
+enum Field : quint32
+{
+    Timebase = 1,
+};
+}
+namespace Timebase {
+enum Field : quint32
+{
+    Name = 10,
+};
+}
+namespace TrackDescriptor {
+enum Field : quint32
+{
+    Uuid = 1,
+    Name = 2,
+    Process = 3,
+    Thread = 4,
+};
+}
+namespace ProcessDescriptor {
+enum Field : quint32
+{
+    Pid = 1,
+    ProcessName = 6,
+};
+}
+namespace ThreadDescriptor {
+enum Field : quint32
+{
+    Pid = 1,
+    Tid = 2,
+    ThreadName = 5,
+};
+}
+namespace TrackEvent {
+enum Field : quint32
+{
+    Type = 9,
+    TrackUuid = 11,
+    Name = 23,
+};
+enum Type : quint32
+{
+    SliceBegin = 1,
+    SliceEnd = 2,
+};
+}
+namespace InternedData {
+enum Field : quint32
+{
+    FunctionNames = 5,
+    Frames = 6,
+    Callstacks = 7,
+    MappingPaths = 17,
+    Mappings = 19,
+};
+}
+namespace InternedString {
+enum Field : quint32
+{
+    Iid = 1,
+    Str = 2,
+};
+}
+namespace Frame {
+enum Field : quint32
+{
+    Iid = 1,
+    FunctionNameId = 2,
+    MappingId = 3,
+    RelPc = 4,
+};
+}
+namespace Callstack {
+enum Field : quint32
+{
+    Iid = 1,
+    FrameIds = 2,
+};
+}
+namespace Mapping {
+enum Field : quint32
+{
+    Iid = 1,
+    PathStringIds = 7,
+};
+}
+namespace PerfSample {
+enum Field : quint32
+{
+    Cpu = 1,
+    Pid = 2,
+    Tid = 3,
+    CallstackIid = 4,
+};
+}
+}
+
+// the sequence of the track descriptors and slices, the samples of every cost type get a sequence of their own
+const quint32 trackSequenceId = 1;
+
+using Protobuf::Message;
+
+class Exporter
+{
+public:
+    Exporter(QIODevice* output, const Data::BottomUpResults& bottomUp, const Data::EventResults& events)
+        : m_writer(output)
+        , m_bottomUp(bottomUp)
+        , m_events(events)
+    {
+    }
+
+    bool write()
+    {
+        writeTracks();
+
+        const auto switchedOffCpuTimeCostId = m_events.offCpuTimeSampled ? -1 : m_events.offCpuTimeCostId;
+        for (qint32 threadIndex = 0, c = m_events.threads.size(); threadIndex < c; ++threadIndex) {
+            const auto& thread = m_events.threads[threadIndex];
+            for (qint32 i = 0, numEvents = thread.events.size(); i < numEvents; ++i) {
+                const auto event = thread.events.at(i);
+                if (event.type < 0 || event.type == m_events.lostEventCostId) {
+                    // the lost events are written from their merged windows instead
+                    continue;
+                } else if (event.type == switchedOffCpuTimeCostId) {
+                    writeSlice(m_threadUuids[threadIndex], event.time, event.time + event.cost,
+                               QStringLiteral("off-CPU"));
+                } else {
+                    writeSample(sampleSequence(event.type), thread, event);
+                }
+            }
+        }
+
+        for (const auto& lostEvents : m_events.lostEvents) {
+            writeSlice(m_lostEventsUuid, lostEvents.time.start, lostEvents.time.end,
+                       QStringLiteral("%1 lost events").arg(lostEvents.lost));
+        }
+
+        return m_writer.flush();
+    }
+
+private:
+    // the interned data a sequence got already, indexed by the iid - 1
+    struct SampleSequence
+    {
+        quint32 id = 0;
+        std::vector<bool> callstacks;
+        std::vector<bool> frames;
+        std::vector<bool> functionNames;
+        std::vector<bool> mappings;
+    };
+
+    struct Frame
+    {
+        quint64 functionNameId = 0;
+        quint64 mappingId = 0;
+        quint64 relPc = 0;
+    };
+
+    void writeTracks()
+    {
+        // the process names are the ones of their main threads
+        QHash<qint32, QString> processNames;
+        QVector<qint32> pids;
+        for (const auto& thread : m_events.threads) {
+            auto it = processNames.find(thread.pid);
+            if (it == processNames.end()) {
+                processNames.insert(thread.pid, thread.name);
+                pids.append(thread.pid);
+            } else if (thread.tid == thread.pid) {
+                *it = thread.name;
+            }
+        }
+
+        quint64 uuid = 0;
+        for (auto pid : pids) {
+            Message process;
+            process.addInt(Proto::ProcessDescriptor::Pid, pid);
+            process.addString(Proto::ProcessDescriptor::ProcessName, processNames.value(pid));
+            Message track;
+            track.addVarint(Proto::TrackDescriptor::Uuid, ++uuid);
+            track.addMessage(Proto::TrackDescriptor::Process, process);
+            writeTrack(track);
+        }
+
+        m_threadUuids.reserve(m_events.threads.size());
+        for (const auto& thread : m_events.threads) {
+            Message descriptor;
+            descriptor.addInt(Proto::ThreadDescriptor::Pid, thread.pid);
+            descriptor.addInt(Proto::ThreadDescriptor::Tid, thread.tid);
+            descriptor.addString(Proto::ThreadDescriptor::ThreadName, thread.name);
+            Message track;
+            m_threadUuids.push_back(++uuid);
+            track.addVarint(Proto::TrackDescriptor::Uuid, uuid);
+            track.addMessage(Proto::TrackDescriptor::Thread, descriptor);
+            writeTrack(track);
+        }
+
+        if (!m_events.lostEvents.isEmpty()) {
+            Message track;
+            m_lostEventsUuid = ++uuid;
+            track.addVarint(Proto::TrackDescriptor::Uuid, m_lostEventsUuid);
+            track.addString(Proto::TrackDescriptor::Name, QStringLiteral("Lost Events"));
+            writeTrack(track);
+        }
+    }
+
+    void writeTrack(const Message& track)
+    {
+        Message packet;
+        packet.addVarint(Proto::TracePacket::TrustedPacketSequenceId, trackSequenceId);
+        packet.addMessage(Proto::TracePacket::TrackDescriptor, track);
+        writePacket(packet);
+    }
+
+    void writeSlice(quint64 trackUuid, quint64 start, quint64 end, const QString& name)
+    {
+        for (auto type : {Proto::TrackEvent::SliceBegin, Proto::TrackEvent::SliceEnd}) {
+            Message event;
+            event.addVarint(Proto::TrackEvent::Type, type);
+            event.addVarint(Proto::TrackEvent::TrackUuid, trackUuid);
+            if (type == Proto::TrackEvent::SliceBegin) {
+                event.addString(Proto::TrackEvent::Name, name);
+            }
+            Message packet;
+            packet.addVarint(Proto::TracePacket::Timestamp, type == Proto::TrackEvent::SliceBegin ? start : end);
+            packet.addVarint(Proto::TracePacket::TrustedPacketSequenceId, trackSequenceId);
+            packet.addMessage(Proto::TracePacket::TrackEvent, event);
+            writePacket(packet);
+        }
+    }
+
+    // the sequence of the samples of cost @p type, it gets started with the name of the cost type when needed
+    SampleSequence* sampleSequence(qint32 type)
+    {
+        if (m_sampleSequences.size() <= static_cast<std::size_t>(type)) {
+            m_sampleSequences.resize(type + 1);
+        }
+        auto* sequence = &m_sampleSequences[type];
+        if (sequence->id != 0) {
+            return sequence;
+        }
+
+        sequence->id = trackSequenceId + 1 + type;
+        sequence->callstacks.resize(m_events.stacks.size());
+
+        Message timebase;
+        timebase.addString(Proto::Timebase::Name, type < m_events.totalCosts.size()
+                                                      ? m_events.totalCosts[type].label
+                                                      : QString::number(type));
+        Message sampleDefaults;
+        sampleDefaults.addMessage(Proto::PerfSampleDefaults::Timebase, timebase);
+        Message defaults;
+        defaults.addMessage(Proto::TracePacketDefaults::PerfSampleDefaults, sampleDefaults);
+        Message packet;
+        packet.addVarint(Proto::TracePacket::TrustedPacketSequenceId, sequence->id);
+        packet.addVarint(Proto::TracePacket::SequenceFlags, Proto::TracePacket::IncrementalStateCleared);
+        packet.addMessage(Proto::TracePacket::TracePacketDefaults, defaults);
+        writePacket(packet);
+        return sequence;
+    }
+
+    void writeSample(SampleSequence* sequence, const Data::ThreadEvents& thread, const Data::Event& event)
+    {
+        Message sample;
+        if (event.cpuId != Data::INVALID_CPU_ID) {
+            sample.addVarint(Proto::PerfSample::Cpu, event.cpuId);
+        }
+        sample.addVarint(Proto::PerfSample::Pid, static_cast<quint32>(thread.pid));
+        sample.addVarint(Proto::PerfSample::Tid, static_cast<quint32>(thread.tid));
+
+        // the interned data of the stack is sent along with the first sample of the sequence that uses it
+        Message internedData;
+        if (event.stackId >= 0 && event.stackId < m_events.stacks.size()) {
+            internStack(sequence, event.stackId, &internedData);
+            sample.addVarint(Proto::PerfSample::CallstackIid, static_cast<quint64>(event.stackId) + 1);
+        }
+
+        Message packet;
+        packet.addVarint(Proto::TracePacket::Timestamp, event.time);
+        packet.addVarint(Proto::TracePacket::TrustedPacketSequenceId, sequence->id);
+        packet.addVarint(Proto::TracePacket::SequenceFlags, Proto::TracePacket::NeedsIncrementalState);
+        if (!internedData.isEmpty()) {
+            packet.addMessage(Proto::TracePacket::InternedData, internedData);
+        }
+        packet.addMessage(Proto::TracePacket::PerfSample, sample);
+        writePacket(packet);
+    }
+
+    // adds the stack and those of its frames, function names and mappings the sequence didn't get yet
+    void internStack(SampleSequence* sequence, qint32 stackId, Message* internedData)
+    {
+        if (sequence->callstacks[stackId]) {
+            return;
+        }
+        sequence->callstacks[stackId] = true;
+
+        m_stackFrames.clear();
+        m_bottomUp.foreachFrame(m_events.stacks[stackId],
+                                [this](const Data::Symbol& symbol, const Data::Location& location) {
+                                    m_stackFrames.push_back(internFrame(symbol, location));
+                                    return true;
+                                });
+
+        sequence->frames.resize(m_frames.size());
+        sequence->functionNames.resize(m_functionNames.size());
+        sequence->mappings.resize(m_mappingPaths.size());
+
+        Message callstack;
+        callstack.addVarint(Proto::Callstack::Iid, static_cast<quint64>(stackId) + 1);
+        // the stacks start at the leaf, perfetto expects the outermost frame first
+        for (auto it = m_stackFrames.crbegin(), end = m_stackFrames.crend(); it != end; ++it) {
+            const auto frameId = *it;
+            callstack.addVarint(Proto::Callstack::FrameIds, frameId);
+            if (sequence->frames[frameId - 1]) {
+                continue;
+            }
+            sequence->frames[frameId - 1] = true;
+
+            const auto& frame = m_frames[frameId - 1];
+            if (!sequence->functionNames[frame.functionNameId - 1]) {
+                sequence->functionNames[frame.functionNameId - 1] = true;
+                Message functionName;
+                functionName.addVarint(Proto::InternedString::Iid, frame.functionNameId);
+                functionName.addBytes(Proto::InternedString::Str, m_functionNames[frame.functionNameId - 1]);
+                internedData->addMessage(Proto::InternedData::FunctionNames, functionName);
+            }
+            if (!sequence->mappings[frame.mappingId - 1]) {
+                sequence->mappings[frame.mappingId - 1] = true;
+                // the mappings only consist of their path, which is interned with the same id
+                Message path;
+                path.addVarint(Proto::InternedString::Iid, frame.mappingId);
+                path.addBytes(Proto::InternedString::Str, m_mappingPaths[frame.mappingId - 1]);
+                internedData->addMessage(Proto::InternedData::MappingPaths, path);
+                Message mapping;
+                mapping.addVarint(Proto::Mapping::Iid, frame.mappingId);
+                mapping.addVarint(Proto::Mapping::PathStringIds, frame.mappingId);
+                internedData->addMessage(Proto::InternedData::Mappings, mapping);
+            }
+
+            Message frameMessage;
+            frameMessage.addVarint(Proto::Frame::Iid, frameId);
+            frameMessage.addVarint(Proto::Frame::FunctionNameId, frame.functionNameId);
+            frameMessage.addVarint(Proto::Frame::MappingId, frame.mappingId);
+            frameMessage.addVarint(Proto::Frame::RelPc, frame.relPc);
+            internedData->addMessage(Proto::InternedData::Frames, frameMessage);
+        }
+        internedData->addMessage(Proto::InternedData::Callstacks, callstack);
+    }
+
+    // the ids are shared by all sequences, the symbol and location are references into the bottom-up results
+    quint64 internFrame(const Data::Symbol& symbol, const Data::Location& location)
+    {
+        auto& frameId = m_frameIds[&location];
+        if (frameId != 0) {
+            return frameId;
+        }
+
+        Frame frame;
+        auto& functionNameId = m_functionNameIds[&symbol];
+        if (functionNameId == 0) {
+            m_functionNames.push_back(symbol.symbol.toUtf8());
+            functionNameId = m_functionNames.size();
+        }
+        frame.functionNameId = functionNameId;
+
+        const auto& path = symbol.path.isEmpty() ? symbol.binary : symbol.path;
+        auto& mappingId = m_mappingIds[path];
+        if (mappingId == 0) {
+            m_mappingPaths.push_back(path.toUtf8());
+            mappingId = m_mappingPaths.size();
+        }
+        frame.mappingId = mappingId;
+        frame.relPc = location.relAddr ? location.relAddr : location.address;
+
+        m_frames.push_back(frame);
+        frameId = m_frames.size();
+        return frameId;
+    }
+
+    void writePacket(const Message& packet)
+    {
+        m_writer.fields().addMessage(Proto::Trace::Packet, packet);
+        m_writer.flushIfNeeded();
+    }
+
+    Protobuf::StreamWriter m_writer;
+    const Data::BottomUpResults& m_bottomUp;
+    const Data::EventResults& m_events;
+
+    std::vector<quint64> m_threadUuids;
+    quint64 m_lostEventsUuid = 0;
+    std::vector<SampleSequence> m_sampleSequences;
+
+    // the interned data by its iid - 1
+    std::vector<Frame> m_frames;
+    std::vector<QByteArray> m_functionNames;
+    std::vector<QByteArray> m_mappingPaths;
+    QHash<const Data::Location*, quint64> m_frameIds;
+    QHash<const Data::Symbol*, quint64> m_functionNameIds;
+    QHash<QString, quint64> m_mappingIds;
+    // the frame ids of the stack that gets interned, from the leaf on
+    std::vector<quint64> m_stackFrames;
+};
+}
+
+namespace PerfettoExport {
+bool isTraceFile(const QString& fileName)
+{
+    return fileName.endsWith(QLatin1String(".pftrace"), Qt::CaseInsensitive)
+        || fileName.endsWith(QLatin1String(".perfetto-trace"), Qt::CaseInsensitive);
+}
+
+bool write(QIODevice* output, const Data::BottomUpResults& bottomUp, const Data::EventResults& events)
+{
+    Exporter exporter(output, bottomUp, events);
+    return exporter.write();
+}
+}
@@ -0,0 +1,25 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "data.h"
+
+class QIODevice;
+
+// writes the timeline as a trace in the protobuf format of Perfetto, which opens in ui.perfetto.dev and its trace
+// processor next to the traces of the application itself. every cost type becomes a perf profile of its own with
+// the stacks and frames interned per sequence, the context switches become off-CPU slices on the thread tracks and
+// the lost events slices on a track of their own
+// the events get streamed one thread after the other, only the ids of the interned frames and stacks are kept
+namespace PerfettoExport {
+// whether @p fileName has one of the suffixes of Perfetto traces, i.e. .pftrace or .perfetto-trace
+bool isTraceFile(const QString& fileName);
+
+// the timestamps are the ones perf recorded, which Perfetto takes as CLOCK_BOOTTIME
+// returns false when writing to @p output failed
+bool write(QIODevice* output, const Data::BottomUpResults& bottomUp, const Data::EventResults& events);
+}
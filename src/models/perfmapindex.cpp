@@ -0,0 +1,213 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "perfmapindex.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+
+#include <algorithm>
+
+namespace {
+const quint32 cacheMagic = 0x48534d50;
+const quint32 cacheVersion = 1;
+// enough to tell a rewritten map apart, e.g. of a new process with the same pid
+const qint64 prefixSize = 4096;
+
+QByteArray hashPrefix(QIODevice* device, qint64 size)
+{
+    device->seek(0);
+    return QCryptographicHash::hash(device->read(size), QCryptographicHash::Sha1);
+}
+
+quint64 parseHex(QByteArray value, bool* ok)
+{
+    if (value.startsWith("0x")) {
+        value.remove(0, 2);
+    }
+    return value.toULongLong(ok, 16);
+}
+
+struct LoadedIndex
+{
+    qint64 modified = 0;
+    qint64 size = 0;
+    std::shared_ptr<const PerfMapIndex> index;
+};
+}
+
+std::shared_ptr<const PerfMapIndex> PerfMapIndex::load(const QString& mapPath, const QString& cacheDir)
+{
+    // the maps of different pids may be the same file, and every parse asks for them again
+    static QMutex mutex;
+    static QHash<QString, LoadedIndex> loaded;
+
+    const QFileInfo info(mapPath);
+    const auto canonicalPath = info.canonicalFilePath();
+    if (canonicalPath.isEmpty()) {
+        return {};
+    }
+    const auto modified = info.lastModified().toMSecsSinceEpoch();
+    const auto size = info.size();
+
+    QMutexLocker locker(&mutex);
+    auto& cached = loaded[canonicalPath];
+    if (cached.index && cached.modified == modified && cached.size == size) {
+        return cached.index;
+    }
+
+    QFile file(canonicalPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        loaded.remove(canonicalPath);
+        return {};
+    }
+
+    const auto cachePath = cacheDir.isEmpty()
+        ? QString()
+        : cacheDir + QLatin1Char('/')
+            + QString::fromLatin1(QCryptographicHash::hash(canonicalPath.toUtf8(), QCryptographicHash::Sha1).toHex())
+            + QLatin1String(".index");
+
+    auto index = std::make_shared<PerfMapIndex>();
+    if (cached.index) {
+        *index = *cached.index;
+    } else if (!cachePath.isEmpty() && index->readCache(cachePath, modified, size)) {
+        cached = {modified, size, index};
+        return index;
+    }
+
+    // continue where the previous index stopped, unless the map got rewritten instead of appended to
+    const auto grew = index->m_parsedSize < size;
+    if (!grew || hashPrefix(&file, std::min(prefixSize, index->m_parsedSize)) != index->m_prefixHash) {
+        *index = PerfMapIndex();
+    }
+
+    if (index->m_parsedSize < size) {
+        file.seek(index->m_parsedSize);
+        index->parse(&file);
+        index->sort();
+        index->m_prefixHash = hashPrefix(&file, std::min(prefixSize, index->m_parsedSize));
+        if (!cachePath.isEmpty()) {
+            index->writeCache(cachePath, modified);
+        }
+    }
+
+    cached = {modified, size, index};
+    return index;
+}
+
+const PerfMapIndex::Entry* PerfMapIndex::find(quint64 address) const
+{
+    auto it = std::upper_bound(m_entries.cbegin(), m_entries.cend(), address,
+                               [](quint64 address, const Entry& entry) { return address < entry.start; });
+    if (it == m_entries.cbegin()) {
+        return nullptr;
+    }
+    --it;
+    return address - it->start < std::max<quint64>(it->size, 1) ? &*it : nullptr;
+}
+
+void PerfMapIndex::parse(QIODevice* device)
+{
+    // each line is "START SIZE symbolname" with hexadecimal numbers, the name may contain spaces
+    while (!device->atEnd()) {
+        const auto line = device->readLine();
+        if (!line.endsWith('\n')) {
+            // the JIT is still writing this line, it gets parsed once it is complete
+            break;
+        }
+        m_parsedSize += line.size();
+
+        const auto startEnd = line.indexOf(' ');
+        const auto sizeEnd = line.indexOf(' ', startEnd + 1);
+        if (startEnd == -1 || sizeEnd == -1) {
+            continue;
+        }
+        bool startOk = false;
+        bool sizeOk = false;
+        const auto start = parseHex(line.left(startEnd), &startOk);
+        const auto size = parseHex(line.mid(startEnd + 1, sizeEnd - startEnd - 1), &sizeOk);
+        if (!startOk || !sizeOk) {
+            continue;
+        }
+        m_entries.push_back({start, size, static_cast<qint32>(m_names.size())});
+        m_names.push_back(QString::fromUtf8(line.mid(sizeEnd + 1).trimmed()));
+    }
+}
+
+void PerfMapIndex::sort()
+{
+    // the appended entries come last, so the stable sort keeps them behind the older ones at the same address
+    std::stable_sort(m_entries.begin(), m_entries.end(),
+                     [](const Entry& lhs, const Entry& rhs) { return lhs.start < rhs.start; });
+    auto out = m_entries.begin();
+    for (auto it = m_entries.begin(), end = m_entries.end(); it != end; ++it) {
+        if (it + 1 != end && (it + 1)->start == it->start) {
+            continue;
+        }
+        *out++ = *it;
+    }
+    m_entries.erase(out, m_entries.end());
+}
+
+bool PerfMapIndex::readCache(const QString& cachePath, qint64 modified, qint64 size)
+{
+    QFile file(cachePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_15);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 cachedModified = 0;
+    stream >> magic >> version >> cachedModified;
+    if (magic != cacheMagic || version != cacheVersion) {
+        return false;
+    }
+
+    quint32 numEntries = 0;
+    stream >> m_parsedSize >> m_prefixHash >> numEntries;
+    m_entries.resize(numEntries);
+    for (auto& entry : m_entries) {
+        stream >> entry.start >> entry.size >> entry.name;
+    }
+    stream >> m_names;
+    if (stream.status() != QDataStream::Ok) {
+        *this = PerfMapIndex();
+        return false;
+    }
+
+    // otherwise the caller checks whether the map only grew since then
+    return cachedModified == modified && m_parsedSize == size;
+}
+
+void PerfMapIndex::writeCache(const QString& cachePath, qint64 modified) const
+{
+    QDir().mkpath(QFileInfo(cachePath).path());
+    QSaveFile file(cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << cacheMagic << cacheVersion << modified << m_parsedSize << m_prefixHash
+           << static_cast<quint32>(m_entries.size());
+    for (const auto& entry : m_entries) {
+        stream << entry.start << entry.size << entry.name;
+    }
+    stream << m_names;
+    file.commit();
+}
@@ -0,0 +1,70 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+
+class QIODevice;
+
+// the symbols of a perf-<pid>.map file, which JIT compilers like the JVM or V8 write for their generated code
+// these files easily have millions of lines, so they get parsed once into a sorted index, which is cached on disk
+// keyed by the path and modification time of the map. the JIT only ever appends to the map, so when it grew
+// since then only the new lines get parsed
+class PerfMapIndex
+{
+public:
+    struct Entry
+    {
+        quint64 start = 0;
+        quint64 size = 0;
+        // into names()
+        qint32 name = -1;
+    };
+
+    // the index of the map at @p mapPath, shared with all other users of the same file
+    // @p cacheDir is where the binary index gets stored, no index gets stored when it is empty
+    // returns nullptr when the map can't be read
+    static std::shared_ptr<const PerfMapIndex> load(const QString& mapPath, const QString& cacheDir);
+
+    // the entry containing @p address, or nullptr. when the JIT reused the memory, the latest entry wins
+    const Entry* find(quint64 address) const;
+
+    QString name(const Entry& entry) const
+    {
+        return m_names.value(entry.name);
+    }
+
+    const QVector<Entry>& entries() const
+    {
+        return m_entries;
+    }
+
+    // the number of bytes of the map that got parsed into this index
+    qint64 parsedSize() const
+    {
+        return m_parsedSize;
+    }
+
+private:
+    // parses the lines of @p device, which is at the end of the parsed part already
+    void parse(QIODevice* device);
+    // sorts the entries by their start address, keeping the latest one of each
+    void sort();
+    bool readCache(const QString& cachePath, qint64 modified, qint64 size);
+    void writeCache(const QString& cachePath, qint64 modified) const;
+
+    QVector<Entry> m_entries;
+    QStringList m_names;
+    qint64 m_parsedSize = 0;
+    // of the first bytes of the map, tells appended data apart from a map that got rewritten
+    QByteArray m_prefixHash;
+};
@@ -0,0 +1,227 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "perfstat.h"
+
+#include <QCoreApplication>
+#include <QHash>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+QString tr(const char* text)
+{
+    return QCoreApplication::translate("PerfStat", text);
+}
+
+// the metrics that perf stat prints for its default events, each is derived from the counts of two events
+struct Ratio
+{
+    const char* name;
+    const char* numerator;
+    const char* denominator;
+    double scale;
+    const char* unit;
+};
+
+const Ratio ratios[] = {
+    {QT_TRANSLATE_NOOP("PerfStat", "IPC"), "instructions", "cycles", 1,
+     QT_TRANSLATE_NOOP("PerfStat", "Instructions per Cycle")},
+    {QT_TRANSLATE_NOOP("PerfStat", "Cache Miss Rate"), "cache-misses", "cache-references", 100, "%"},
+    {QT_TRANSLATE_NOOP("PerfStat", "Branch Miss Rate"), "branch-misses", "branches", 100, "%"},
+};
+
+// the event without modifiers like :u and without the PMU of hybrid CPUs like cpu_core/cycles/
+QString eventName(const QString& event)
+{
+    const auto name = event.count(QLatin1Char('/')) >= 2 ? event.section(QLatin1Char('/'), 1, 1) : event;
+    return name.section(QLatin1Char(':'), 0, 0);
+}
+
+// the denominator of @p ratio counted like @p event, i.e. with the same modifiers and PMU, or an empty string when
+// @p event isn't the numerator of it
+QString denominatorEvent(const QString& event, const Ratio& ratio)
+{
+    const auto numerator = QLatin1String(ratio.numerator);
+    if (eventName(event) != numerator) {
+        return {};
+    }
+    return QString(event).replace(numerator, QLatin1String(ratio.denominator));
+}
+
+QString ratioName(const QString& event, const Ratio& ratio)
+{
+    const auto name = tr(ratio.name);
+    return event == QLatin1String(ratio.numerator) ? name : QLatin1String("%1 (%2)").arg(name, event);
+}
+}
+
+double PerfStat::Counter::total() const
+{
+    double ret = 0;
+    for (auto value : values) {
+        if (!std::isnan(value)) {
+            ret += value;
+        }
+    }
+    return ret;
+}
+
+PerfStat::PerfStat(const QByteArray& output)
+{
+    QHash<std::pair<qint32, QString>, int> counterIndices;
+    for (int pos = 0, size = output.size(); pos < size;) {
+        auto end = output.indexOf('\n', pos);
+        if (end == -1) {
+            end = size;
+        }
+        const auto line = output.mid(pos, end - pos).trimmed();
+        pos = end + 1;
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+
+        const auto fields = line.split(',');
+        bool ok = false;
+        const auto seconds = fields.value(0).toDouble(&ok);
+        qint32 cpu = -1;
+        int field = 1;
+        if (ok && fields.value(1).startsWith("CPU")) {
+            cpu = fields[1].mid(3).toInt(&ok);
+            ++field;
+        }
+        const auto time = static_cast<quint64>(std::llround(seconds * 1E9));
+        if (!ok || seconds < 0 || fields.size() < field + 3 || (!m_times.isEmpty() && time < m_times.last())) {
+            ++m_numInvalidLines;
+            continue;
+        }
+        if (m_times.isEmpty() || m_times.last() != time) {
+            m_times.push_back(time);
+        }
+
+        const auto event = QString::fromUtf8(fields[field + 2]);
+        auto it = counterIndices.find({cpu, event});
+        if (it == counterIndices.end()) {
+            it = counterIndices.insert({cpu, event}, m_counters.size());
+            m_counters.push_back({event, QString::fromUtf8(fields[field + 1]), cpu, {}});
+        }
+        auto& values = m_counters[it.value()].values;
+        if (values.size() >= m_times.size()) {
+            // the event got counted twice in the same interval
+            ++m_numInvalidLines;
+            continue;
+        }
+        while (values.size() < m_times.size() - 1) {
+            values.push_back(qQNaN());
+        }
+        // e.g. <not counted> or <not supported>
+        const auto value = fields[field].toDouble(&ok);
+        values.push_back(ok ? value : qQNaN());
+    }
+
+    for (auto& counter : m_counters) {
+        while (counter.values.size() < m_times.size()) {
+            counter.values.push_back(qQNaN());
+        }
+    }
+}
+
+bool PerfStat::isPerfStatOutput(const QByteArray& head)
+{
+    for (const auto& line : head.split('\n')) {
+        const auto trimmed = line.trimmed();
+        if (trimmed.isEmpty() || trimmed.startsWith('#')) {
+            continue;
+        }
+        // the first line with counts starts with the time of the interval
+        const auto fields = trimmed.split(',');
+        bool ok = false;
+        fields[0].toDouble(&ok);
+        return ok && fields[0].contains('.') && fields.size() >= 4;
+    }
+    return false;
+}
+
+QVector<Data::CounterSummary> PerfStat::summary() const
+{
+    QVector<Data::CounterSummary> ret;
+    QHash<QString, int> indices;
+    for (const auto& counter : m_counters) {
+        auto it = indices.find(counter.event);
+        if (it == indices.end()) {
+            it = indices.insert(counter.event, ret.size());
+            ret.push_back({counter.event, 0, counter.unit});
+        }
+        // the counts of all CPUs add up
+        ret[it.value()].value += counter.total();
+    }
+
+    for (int i = 0, numEvents = ret.size(); i < numEvents; ++i) {
+        const auto event = ret[i].name;
+        for (const auto& ratio : ratios) {
+            const auto denominator = indices.value(denominatorEvent(event, ratio), -1);
+            if (denominator != -1 && ret[denominator].value > 0) {
+                ret.push_back({ratioName(event, ratio), ret[i].value / ret[denominator].value * ratio.scale,
+                               tr(ratio.unit), true});
+            }
+        }
+    }
+    return ret;
+}
+
+Data::FrequencyResults PerfStat::frequencyResults() const
+{
+    Data::FrequencyResults ret;
+    ret.isAggregated = std::all_of(m_counters.begin(), m_counters.end(),
+                                   [](const Counter& counter) { return counter.cpu == -1; });
+    auto costsOfCpu = [&ret](qint32 cpu) -> QVector<Data::PerCostFrequencyData>& {
+        const auto core = std::max(0, cpu);
+        if (ret.cores.size() <= core) {
+            ret.cores.resize(core + 1);
+        }
+        return ret.cores[core].costs;
+    };
+
+    for (const auto& counter : m_counters) {
+        Data::PerCostFrequencyData costs;
+        costs.costName = counter.event;
+        costs.unit = counter.unit.isEmpty() ? tr("Events per Second") : tr("%1 per Second").arg(counter.unit);
+        for (int i = 0, c = m_times.size(); i < c; ++i) {
+            const auto duration = m_times[i] - (i == 0 ? 0 : m_times[i - 1]);
+            if (!std::isnan(counter.values[i]) && duration > 0) {
+                costs.values.push_back({m_times[i], counter.values[i] * 1E9 / duration});
+            }
+        }
+        costsOfCpu(counter.cpu).push_back(costs);
+    }
+
+    for (const auto& numerator : m_counters) {
+        for (const auto& ratio : ratios) {
+            const auto event = denominatorEvent(numerator.event, ratio);
+            const auto denominator =
+                std::find_if(m_counters.begin(), m_counters.end(), [&numerator, &event](const Counter& counter) {
+                    return counter.cpu == numerator.cpu && counter.event == event;
+                });
+            if (event.isEmpty() || denominator == m_counters.end()) {
+                continue;
+            }
+
+            Data::PerCostFrequencyData costs;
+            costs.costName = ratioName(numerator.event, ratio);
+            costs.unit = tr(ratio.unit);
+            for (int i = 0, c = m_times.size(); i < c; ++i) {
+                // NaN unless both got counted
+                const auto value = numerator.values[i] / denominator->values[i];
+                if (!std::isnan(value) && denominator->values[i] > 0) {
+                    costs.values.push_back({m_times[i], value * ratio.scale});
+                }
+            }
+            costsOfCpu(numerator.cpu).push_back(costs);
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,73 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+
+#include "data.h"
+
+// the counts of perf stat --interval-print --field-separator ",", i.e. one CSV line per interval and event with the
+// end of the interval in seconds, the CPU when counted with --no-aggr, the count, its unit, the event, the time the
+// event got counted and the percentage of that time, followed by the metric perf derived from it
+// the intervals are shared by all counters, so every counter only stores its counts
+class PerfStat
+{
+public:
+    struct Counter
+    {
+        QString event;
+        // e.g. msec for the task-clock, empty for the plain event counts
+        QString unit;
+        // -1 when the counts of all CPUs got aggregated
+        qint32 cpu = -1;
+        // the count of every interval, NaN when the event wasn't counted or isn't supported
+        QVector<double> values;
+
+        double total() const;
+    };
+
+    PerfStat() = default;
+    // the lines that are no counts get skipped, see numInvalidLines
+    explicit PerfStat(const QByteArray& output);
+
+    // whether @p head, the start of a file, looks like the output of perf stat in interval mode
+    static bool isPerfStatOutput(const QByteArray& head);
+
+    bool isEmpty() const
+    {
+        return m_times.isEmpty();
+    }
+
+    // the end of every interval in nanoseconds since perf stat started
+    const QVector<quint64>& times() const
+    {
+        return m_times;
+    }
+
+    const QVector<Counter>& counters() const
+    {
+        return m_counters;
+    }
+
+    int numInvalidLines() const
+    {
+        return m_numInvalidLines;
+    }
+
+    // the totals of the events of all intervals and CPUs along with the metrics derived from them, like the
+    // instructions per cycle or the cache misses per cache reference
+    QVector<Data::CounterSummary> summary() const;
+
+    // the counts per second and the metrics of every interval, with one core per CPU when counted with --no-aggr
+    Data::FrequencyResults frequencyResults() const;
+
+private:
+    QVector<quint64> m_times;
+    QVector<Counter> m_counters;
+    int m_numInvalidLines = 0;
+};
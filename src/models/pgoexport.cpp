@@ -0,0 +1,74 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "pgoexport.h"
+
+#include <QTextStream>
+
+namespace PgoExport {
+QHash<QString, Samples> samplesPerBinary(const Data::CallerCalleeResults& results, int type)
+{
+    QHash<QString, Samples> samples;
+    if (type < 0 || type >= results.selfCosts.numTypes()) {
+        return samples;
+    }
+
+    const auto offsetMaps = results.selfOffsetMaps();
+    for (auto it = offsetMaps.cbegin(), end = offsetMaps.cend(); it != end; ++it) {
+        const auto& symbol = it.key();
+        if (symbol.isKernel || symbol.binary.isEmpty()) {
+            continue;
+        }
+        auto& binarySamples = samples[symbol.binary];
+        const auto& offsetMap = it.value();
+        for (auto offset = offsetMap.cbegin(), offsetEnd = offsetMap.cend(); offset != offsetEnd; ++offset) {
+            const auto cost = static_cast<int>(offset->selfCost.size()) > type ? offset->selfCost[type] : 0;
+            if (cost > 0) {
+                binarySamples[offset.key()] += cost;
+            }
+        }
+        if (binarySamples.isEmpty()) {
+            samples.remove(symbol.binary);
+        }
+    }
+    return samples;
+}
+
+QString fileName(Format format, const QString& binary)
+{
+    auto name = binary;
+    name.replace(QLatin1Char('/'), QLatin1Char('_'));
+    switch (format) {
+    case Format::AutoFdo:
+        return name + QLatin1String(".unsymbolized.txt");
+    case Format::Bolt:
+        return name + QLatin1String(".preagg.txt");
+    }
+    return name;
+}
+
+void write(QTextStream* stream, Format format, const Samples& samples, const QString& event)
+{
+    switch (format) {
+    case Format::AutoFdo:
+        // every sampled instruction is a range of its own, like llvm-profgen does for samples without branch records
+        *stream << samples.size() << '\n';
+        for (auto it = samples.cbegin(), end = samples.cend(); it != end; ++it) {
+            const auto address = QString::number(it.key(), 16);
+            *stream << address << '-' << address << ':' << it.value() << '\n';
+        }
+        // no branches
+        *stream << 0 << '\n';
+        break;
+    case Format::Bolt:
+        *stream << "E " << event << '\n';
+        for (auto it = samples.cbegin(), end = samples.cend(); it != end; ++it) {
+            *stream << "S " << QString::number(it.key(), 16) << ' ' << it.value() << '\n';
+        }
+        break;
+    }
+}
+}
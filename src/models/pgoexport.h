@@ -0,0 +1,41 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QMap>
+
+#include "data.h"
+
+class QTextStream;
+
+// sample profiles for profile guided optimization, built from the self costs per address of the caller/callee
+// results. these follow the filter, e.g. to optimize for a single process or phase of the capture
+// the symbols are demangled and there are no branch records, so the profiles only consist of the sampled
+// addresses, which the tools map back to the functions and lines with the debug information of the binary
+namespace PgoExport {
+enum class Format
+{
+    // the unsymbolized profile of llvm-profgen, which turns it into an AutoFDO sample profile:
+    // llvm-profgen --binary=<binary> --unsymbolized-profile=<file> --output=<binary>.afdo
+    AutoFdo,
+    // the pre-aggregated basic samples of perf2bolt: perf2bolt <binary> -pa -p <file> -o <binary>.fdata
+    Bolt,
+};
+
+// the self cost per address of the binary
+using Samples = QMap<quint64, qint64>;
+
+// the self costs of @p type per binary, the kernel is left out as it doesn't get rebuilt with these profiles
+QHash<QString, Samples> samplesPerBinary(const Data::CallerCalleeResults& results, int type);
+
+// e.g. "libfoo.so.unsymbolized.txt"
+QString fileName(Format format, const QString& binary);
+
+// @p event is the name of the cost type the samples got recorded for
+void write(QTextStream* stream, Format format, const Samples& samples, const QString& event);
+}
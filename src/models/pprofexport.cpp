@@ -0,0 +1,341 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "pprofexport.h"
+
+#include <QHash>
+
+#include <algorithm>
+#include <vector>
+
+#include "../util.h"
+#include "protobuf.h"
+
+namespace {
+// the field numbers of the messages in profile.proto of pprof, only the ones that get written
+namespace Proto {
+namespace Profile {
+enum Field : quint32
+{
+    SampleType = 1,
+    Sample = 2,
+    Mapping = 3,
+    Location = 4,
+    Function = 5,
+    StringTable = 6,
+    DurationNanos = 10,
+    DefaultSampleType = 14,
+};
+}
+namespace ValueType {
+enum Field : quint32
+{
+    Type = 1,
+    Unit = 2,
+};
+}
+namespace Sample {
+enum Field : quint32
+{
+    LocationId = 1,
+    Value = 2,
+    Label = 3,
+};
+}
+namespace Label {
+enum Field : quint32
+{
+    Key = 1,
+    Str = 2,
+    Num = 3,
+};
+}
+namespace Mapping {
+enum Field : quint32
+{
+    Id = 1,
+    Filename = 5,
+};
+}
+namespace Location {
+enum Field : quint32
+{
+    Id = 1,
+    MappingId = 2,
+    Address = 3,
+    Line = 4,
+};
+}
+namespace Line {
+enum Field : quint32
+{
+    FunctionId = 1,
+    Line = 2,
+};
+}
+namespace Function {
+enum Field : quint32
+{
+    Id = 1,
+    Name = 2,
+    SystemName = 3,
+};
+}
+}
+
+using Protobuf::Message;
+
+class Exporter
+{
+public:
+    Exporter(QIODevice* output, const Data::BottomUpResults& bottomUp, const Data::EventResults& events,
+             PprofExport::Labels labels)
+        : m_writer(output)
+        , m_bottomUp(bottomUp)
+        , m_events(events)
+        , m_labels(labels)
+    {
+    }
+
+    bool write()
+    {
+        // the first string is always the empty one
+        m_writer.fields().addString(Proto::Profile::StringTable, {});
+        m_strings.insert(QString(), 0);
+
+        const auto numTypes = m_bottomUp.costs.numTypes();
+        for (int type = 0; type < numTypes; ++type) {
+            const auto unit = m_bottomUp.costs.unit(type) == Data::Costs::Unit::Time ? QStringLiteral("nanoseconds")
+                                                                                       : QStringLiteral("count");
+            Message valueType;
+            valueType.addInt(Proto::ValueType::Type, stringId(m_bottomUp.costs.typeName(type)));
+            valueType.addInt(Proto::ValueType::Unit, stringId(unit));
+            m_writer.fields().addMessage(Proto::Profile::SampleType, valueType);
+        }
+        if (numTypes > 0) {
+            m_writer.fields().addInt(Proto::Profile::DefaultSampleType, stringId(m_bottomUp.costs.typeName(0)));
+        }
+
+        // the process names are the ones of their main threads
+        for (const auto& thread : m_events.threads) {
+            if (!m_processNames.contains(thread.pid) || thread.tid == thread.pid) {
+                m_processNames.insert(thread.pid, thread.name);
+            }
+        }
+
+        quint64 firstTime = Data::MAX_TIME;
+        quint64 lastTime = 0;
+        for (const auto& thread : m_events.threads) {
+            QHash<quint64, int> sampleIndices;
+            m_samples.clear();
+            for (qint32 i = 0, c = thread.events.size(); i < c; ++i) {
+                const auto event = thread.events.at(i);
+                if (event.type < 0 || event.type >= numTypes) {
+                    continue;
+                }
+                firstTime = std::min(firstTime, event.time);
+                lastTime = std::max(lastTime, event.time);
+
+                const auto labelId = this->labelId(event.cpuId);
+                const auto key = (static_cast<quint64>(static_cast<quint32>(event.stackId)) << 32) | labelId;
+                auto it = sampleIndices.find(key);
+                if (it == sampleIndices.end()) {
+                    it = sampleIndices.insert(key, static_cast<int>(m_samples.size()));
+                    m_samples.push_back({event.stackId, labelId, std::vector<qint64>(numTypes, 0)});
+                }
+                m_samples[it.value()].values[event.type] += event.cost;
+            }
+
+            for (const auto& sample : m_samples) {
+                writeSample(thread, sample);
+            }
+        }
+
+        if (firstTime <= lastTime) {
+            m_writer.fields().addInt(Proto::Profile::DurationNanos, lastTime - firstTime);
+        }
+        return m_writer.flush();
+    }
+
+private:
+    struct Sample
+    {
+        qint32 stackId;
+        // the CPU or the NUMA node, depending on the labels
+        quint32 labelId;
+        std::vector<qint64> values;
+    };
+
+    quint32 labelId(quint32 cpuId) const
+    {
+        switch (m_labels) {
+        case PprofExport::Labels::Cpu:
+            return cpuId;
+        case PprofExport::Labels::NumaNode: {
+            const auto node = m_events.numaNode(cpuId);
+            return node == -1 ? Data::INVALID_CPU_ID : static_cast<quint32>(node);
+        }
+        case PprofExport::Labels::None:
+        case PprofExport::Labels::Thread:
+        case PprofExport::Labels::Process:
+            break;
+        }
+        return Data::INVALID_CPU_ID;
+    }
+
+    void writeSample(const Data::ThreadEvents& thread, const Sample& sample)
+    {
+        Message message;
+        // the locations, functions and mappings the stack uses for the first time get written before the sample
+        if (sample.stackId >= 0 && sample.stackId < m_events.stacks.size()) {
+            // like the stacks, pprof starts at the leaf
+            m_bottomUp.foreachFrame(m_events.stacks[sample.stackId],
+                                    [this, &message](const Data::Symbol& symbol, const Data::Location& location) {
+                                        message.addVarint(Proto::Sample::LocationId, locationId(symbol, location));
+                                        return true;
+                                    });
+        }
+        for (auto value : sample.values) {
+            message.addInt(Proto::Sample::Value, value);
+        }
+
+        auto addLabel = [this, &message](const QString& key, const QString& value) {
+            Message label;
+            label.addInt(Proto::Label::Key, stringId(key));
+            label.addInt(Proto::Label::Str, stringId(value));
+            message.addMessage(Proto::Sample::Label, label);
+        };
+        auto addNumLabel = [this, &message](const QString& key, qint64 value) {
+            Message label;
+            label.addInt(Proto::Label::Key, stringId(key));
+            label.addInt(Proto::Label::Num, value);
+            message.addMessage(Proto::Sample::Label, label);
+        };
+        switch (m_labels) {
+        case PprofExport::Labels::None:
+            break;
+        case PprofExport::Labels::Thread:
+            addLabel(QStringLiteral("thread"), thread.name);
+            addNumLabel(QStringLiteral("tid"), thread.tid);
+            addNumLabel(QStringLiteral("pid"), thread.pid);
+            break;
+        case PprofExport::Labels::Process:
+            addLabel(QStringLiteral("process"), m_processNames.value(thread.pid));
+            addNumLabel(QStringLiteral("pid"), thread.pid);
+            break;
+        case PprofExport::Labels::Cpu:
+            if (sample.labelId != Data::INVALID_CPU_ID) {
+                addNumLabel(QStringLiteral("cpu"), sample.labelId);
+            }
+            break;
+        case PprofExport::Labels::NumaNode:
+            if (sample.labelId != Data::INVALID_CPU_ID) {
+                addNumLabel(QStringLiteral("numa_node"), sample.labelId);
+            }
+            break;
+        }
+
+        m_writer.fields().addMessage(Proto::Profile::Sample, message);
+        m_writer.flushIfNeeded();
+    }
+
+    // the symbol and location are references into the bottom-up results, they get added with the first use
+    quint64 locationId(const Data::Symbol& symbol, const Data::Location& location)
+    {
+        auto& id = m_locationIds[&location];
+        if (id != 0) {
+            return id;
+        }
+        id = m_locationIds.size();
+
+        Message line;
+        line.addVarint(Proto::Line::FunctionId, functionId(symbol));
+        if (location.fileLine.line > 0) {
+            line.addInt(Proto::Line::Line, location.fileLine.line);
+        }
+        Message message;
+        message.addVarint(Proto::Location::Id, id);
+        message.addVarint(Proto::Location::MappingId, mappingId(symbol));
+        message.addVarint(Proto::Location::Address, location.address);
+        message.addMessage(Proto::Location::Line, line);
+        m_writer.fields().addMessage(Proto::Profile::Location, message);
+        return id;
+    }
+
+    quint64 functionId(const Data::Symbol& symbol)
+    {
+        auto& id = m_functionIds[&symbol];
+        if (id != 0) {
+            return id;
+        }
+        id = m_functionIds.size();
+
+        Message message;
+        message.addVarint(Proto::Function::Id, id);
+        message.addInt(Proto::Function::Name, stringId(Util::formatSymbol(symbol)));
+        message.addInt(Proto::Function::SystemName, stringId(symbol.symbol));
+        m_writer.fields().addMessage(Proto::Profile::Function, message);
+        return id;
+    }
+
+    quint64 mappingId(const Data::Symbol& symbol)
+    {
+        const auto& path = symbol.path.isEmpty() ? symbol.binary : symbol.path;
+        auto& id = m_mappingIds[path];
+        if (id != 0) {
+            return id;
+        }
+        id = m_mappingIds.size();
+
+        Message message;
+        message.addVarint(Proto::Mapping::Id, id);
+        message.addInt(Proto::Mapping::Filename, stringId(path));
+        m_writer.fields().addMessage(Proto::Profile::Mapping, message);
+        return id;
+    }
+
+    // the index into the string table, which gets the strings in the order they get used for the first time
+    qint64 stringId(const QString& string)
+    {
+        const auto it = m_strings.constFind(string);
+        if (it != m_strings.constEnd()) {
+            return it.value();
+        }
+        const auto id = static_cast<qint64>(m_strings.size());
+        m_strings.insert(string, id);
+        m_writer.fields().addString(Proto::Profile::StringTable, string);
+        return id;
+    }
+
+    Protobuf::StreamWriter m_writer;
+    const Data::BottomUpResults& m_bottomUp;
+    const Data::EventResults& m_events;
+    const PprofExport::Labels m_labels;
+
+    QHash<qint32, QString> m_processNames;
+    // the summed up events of the current thread
+    std::vector<Sample> m_samples;
+    QHash<QString, qint64> m_strings;
+    QHash<const Data::Location*, quint64> m_locationIds;
+    QHash<const Data::Symbol*, quint64> m_functionIds;
+    QHash<QString, quint64> m_mappingIds;
+};
+}
+
+namespace PprofExport {
+bool isProfileFile(const QString& fileName)
+{
+    return fileName.endsWith(QLatin1String(".pb.gz"), Qt::CaseInsensitive)
+        || fileName.endsWith(QLatin1String(".pprof"), Qt::CaseInsensitive);
+}
+
+bool write(QIODevice* output, const Data::BottomUpResults& bottomUp, const Data::EventResults& events,
+           Labels labels)
+{
+    Exporter exporter(output, bottomUp, events, labels);
+    return exporter.write();
+}
+}
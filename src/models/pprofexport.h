@@ -0,0 +1,37 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "data.h"
+
+class QIODevice;
+
+// writes the results as a profile in the protobuf format of pprof, which continuous profiling stores and
+// go tool pprof read. every cost type becomes a sample type, the symbols become functions and every frame of the
+// stacks a location with a single line, so inlined frames are locations of their own
+// the events are summed up per stack and thread one thread after another and then written right away, along with
+// the strings, functions, locations and mappings they use for the first time, so memory stays bounded by the
+// unique stacks of a single thread. the pprof tools merge the samples that end up with the same stack and labels
+namespace PprofExport {
+// like the cost aggregation of the GUI, the samples get labels for the thread, process, CPU or NUMA node they ran on
+enum class Labels
+{
+    None,
+    Thread,
+    Process,
+    Cpu,
+    NumaNode,
+};
+
+// whether @p fileName has one of the suffixes of pprof profiles, i.e. .pb.gz or .pprof
+bool isProfileFile(const QString& fileName);
+
+// writes the uncompressed profile, the pprof tools read it as it is but usually it gets compressed with gzip
+// returns false when writing to @p output failed
+bool write(QIODevice* output, const Data::BottomUpResults& bottomUp, const Data::EventResults& events,
+           Labels labels = Labels::None);
+}
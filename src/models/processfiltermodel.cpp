@@ -45,7 +45,7 @@ bool ProcessFilterModel::filterAcceptsRow(int source_row, const QModelIndex& sou
 
     const ProcData& data = source->dataForRow(source_row);
 
-    if (!m_currentUser.isEmpty() && data.user != m_currentUser)
+    if (filtersUser() && data.user != m_currentUser)
         return false;
 
     return QSortFilterProxyModel::filterAcceptsRow(source_row, source_parent);
@@ -54,5 +54,20 @@ bool ProcessFilterModel::filterAcceptsRow(int source_row, const QModelIndex& sou
 bool ProcessFilterModel::filterAcceptsColumn(int source_column, const QModelIndex& /*source_parent*/) const
 {
     // hide user row if current user was found
-    return m_currentUser.isEmpty() || source_column != ProcessModel::UserColumn;
+    if (source_column == ProcessModel::CgroupColumn)
+        return m_showContainers;
+    return !filtersUser() || source_column != ProcessModel::UserColumn;
+}
+
+void ProcessFilterModel::setShowContainers(bool showContainers)
+{
+    if (m_showContainers == showContainers)
+        return;
+    m_showContainers = showContainers;
+    invalidate();
+}
+
+bool ProcessFilterModel::filtersUser() const
+{
+    return !m_showContainers && !m_currentUser.isEmpty();
 }
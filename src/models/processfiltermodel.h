@@ -20,8 +20,14 @@ public:
     bool filterAcceptsRow(int source_row, const QModelIndex& source_parent) const override;
     bool filterAcceptsColumn(int source_column, const QModelIndex& source_parent) const override;
 
+    // by default only the processes of the current user are shown, but the services in containers run as others
+    // so this shows the processes of all users, along with the cgroup column to pick the container
+    void setShowContainers(bool showContainers);
+
 private:
     bool lessThan(const QModelIndex& left, const QModelIndex& right) const override;
+    bool filtersUser() const;
     QString m_currentProcId;
     QString m_currentUser;
+    bool m_showContainers = false;
 };
@@ -32,7 +32,9 @@
 
 #pragma once
 
+#include <QHash>
 #include <QList>
+#include <QMutex>
 #include <QString>
 
 struct ProcData
@@ -41,10 +43,13 @@ struct ProcData
     QString name;
     QString state;
     QString user;
+    // as perf record --cgroup expects it, i.e. relative to the cgroup mount, empty for the root cgroup
+    QString cgroup;
 
     inline bool equals(const ProcData& other) const
     {
-        return ppid == other.ppid && name == other.name && state == other.state && user == other.user;
+        return ppid == other.ppid && name == other.name && state == other.state && user == other.user
+            && cgroup == other.cgroup;
     }
 };
 Q_DECLARE_TYPEINFO(ProcData, Q_MOVABLE_TYPE);
@@ -62,4 +67,30 @@ inline bool operator==(const ProcData& l, const ProcData& r)
 QDebug operator<<(QDebug d, const ProcData& data);
 
 using ProcDataList = QVector<ProcData>;
-ProcDataList processList();
+
+// remembers the processes of the previous enumeration, so that only the state of known processes gets read again
+struct ProcessListCache
+{
+    struct Process
+    {
+        // tells a reused pid apart from the process that had it before
+        QByteArray startTime;
+        // changes when the process executes another program
+        QByteArray command;
+        ProcData data;
+    };
+    QHash<QString, Process> processes;
+    QHash<uint, QString> userNames;
+    // the enumeration may run in multiple threads at once
+    QMutex mutex;
+};
+
+ProcDataList processList(ProcessListCache* cache = nullptr);
+
+// the cgroup of a process in the hierarchy that perf uses, @p procCgroup is the content of /proc/<pid>/cgroup
+// this is the unified hierarchy of cgroup v2, or the perf_event controller of cgroup v1
+QString perfEventCgroup(const QByteArray& procCgroup);
+
+// the innermost cgroup that contains all of @p cgroups, perf monitors the nested cgroups along with it
+// e.g. the pod of the selected containers, empty when they only share the root cgroup
+QString commonCgroup(const QStringList& cgroups);
@@ -42,8 +42,7 @@
 QDebug operator<<(QDebug d, const ProcData& data)
 {
     d << "ProcData{.ppid=" << data.ppid << ", .name=" << data.name << ", .state=" << data.state
-      << ", .user=" << data.user << ", .type="
-      << "}";
+      << ", .user=" << data.user << ", .cgroup=" << data.cgroup << "}";
     return d;
 }
 
@@ -97,45 +96,118 @@ ProcDataList unixProcessListPS()
 
 // Determine UNIX processes by reading "/proc". Default to ps if
 // it does not exist
-ProcDataList processList()
+ProcDataList processList(ProcessListCache* cache)
 {
     const QDir procDir(QStringLiteral("/proc/"));
     if (!procDir.exists())
         return unixProcessListPS();
 
+    ProcessListCache localCache;
+    if (!cache)
+        cache = &localCache;
+    QMutexLocker locker(&cache->mutex);
+
     ProcDataList rc;
-    foreach (const QString& procId, procDir.entryList()) {
+    QHash<QString, ProcessListCache::Process> processes;
+    const auto procIds = procDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::NoSort);
+    processes.reserve(procIds.size());
+    for (const QString& procId : procIds) {
         if (!isUnixProcessId(procId))
             continue;
 
-        QFile file(QLatin1String("/proc/") + procId + QLatin1String("/stat"));
+        const auto statPath = QLatin1String("/proc/") + procId + QLatin1String("/stat");
+        QFile file(statPath);
         if (!file.open(QIODevice::ReadOnly))
             continue; // process may have exited
 
-        const QStringList data = QString::fromLocal8Bit(file.readAll()).split(QLatin1Char(' '));
-        ProcData proc;
-        proc.ppid = procId;
-        proc.name = data.at(1);
-        if (proc.name.startsWith(QLatin1Char('(')) && proc.name.endsWith(QLatin1Char(')'))) {
-            proc.name.truncate(proc.name.size() - 1);
-            proc.name.remove(0, 1);
-        }
-        proc.state = data.at(2);
-        // PPID is element 3
-
-        proc.user = QFileInfo(file).owner();
+        // the name is in parentheses and may contain spaces, the other fields follow it
+        const auto stat = file.readAll();
         file.close();
+        const auto nameEnd = stat.lastIndexOf(')');
+        if (nameEnd == -1)
+            continue;
+        // the state is field 3, the start time field 22
+        const auto fields = stat.mid(nameEnd + 2).split(' ');
+        const auto state = QString::fromLatin1(fields.value(0));
+        const auto startTime = fields.value(19);
+
+        const auto nameStart = stat.indexOf('(');
+        const auto command = stat.mid(nameStart + 1, nameEnd - nameStart - 1);
+
+        auto process = cache->processes.value(procId);
+        if (process.startTime != startTime || process.command != command) {
+            process.startTime = startTime;
+            process.command = command;
+            process.data.ppid = procId;
+            process.data.name = QString::fromLocal8Bit(command);
 
-        QFile cmdFile(QLatin1String("/proc/") + procId + QLatin1String("/cmdline"));
-        if (cmdFile.open(QFile::ReadOnly)) {
-            QByteArray cmd = cmdFile.readAll();
-            cmd.replace('\0', ' ');
-            if (!cmd.isEmpty())
-                proc.name = QString::fromLocal8Bit(cmd).trimmed();
+            // looking up the user name is expensive, but there are only a few users
+            const auto ownerId = QFileInfo(statPath).ownerId();
+            auto user = cache->userNames.constFind(ownerId);
+            if (user == cache->userNames.constEnd())
+                user = cache->userNames.insert(ownerId, QFileInfo(statPath).owner());
+            process.data.user = *user;
+
+            QFile cmdFile(QLatin1String("/proc/") + procId + QLatin1String("/cmdline"));
+            if (cmdFile.open(QFile::ReadOnly)) {
+                QByteArray cmd = cmdFile.readAll();
+                cmd.replace('\0', ' ');
+                if (!cmd.isEmpty())
+                    process.data.name = QString::fromLocal8Bit(cmd).trimmed();
+            }
+
+            // the container runtimes move the processes into their cgroup before executing them
+            QFile cgroupFile(QLatin1String("/proc/") + procId + QLatin1String("/cgroup"));
+            if (cgroupFile.open(QFile::ReadOnly))
+                process.data.cgroup = perfEventCgroup(cgroupFile.readAll());
         }
-        cmdFile.close();
+        process.data.state = state;
 
-        rc.push_back(proc);
+        rc.push_back(process.data);
+        processes.insert(procId, process);
     }
+
+    // forget the processes that exited
+    cache->processes = std::move(processes);
     return rc;
 }
+
+QString perfEventCgroup(const QByteArray& procCgroup)
+{
+    // each line is "hierarchy-ID:controller-list:cgroup-path", the unified hierarchy has ID 0 and no controllers
+    QByteArray path;
+    for (const auto& line : procCgroup.split('\n')) {
+        const auto firstColon = line.indexOf(':');
+        const auto secondColon = line.indexOf(':', firstColon + 1);
+        if (firstColon == -1 || secondColon == -1)
+            continue;
+        const auto controllers = line.mid(firstColon + 1, secondColon - firstColon - 1).split(',');
+        if (controllers.contains("perf_event")) {
+            // a v1 perf_event hierarchy takes precedence, perf uses it when it is mounted
+            path = line.mid(secondColon + 1);
+            break;
+        } else if (line.startsWith("0::")) {
+            path = line.mid(secondColon + 1);
+        }
+    }
+
+    while (path.startsWith('/'))
+        path.remove(0, 1);
+    return QString::fromLocal8Bit(path.trimmed());
+}
+
+QString commonCgroup(const QStringList& cgroups)
+{
+    if (cgroups.isEmpty())
+        return {};
+
+    auto common = cgroups.first().split(QLatin1Char('/'));
+    for (const auto& cgroup : cgroups) {
+        const auto components = cgroup.split(QLatin1Char('/'));
+        int i = 0;
+        while (i < common.size() && i < components.size() && common.at(i) == components.at(i))
+            ++i;
+        common.erase(common.begin() + i, common.end());
+    }
+    return common.join(QLatin1Char('/'));
+}
@@ -34,43 +34,67 @@ void ProcessModel::mergeProcesses(const ProcDataList& processes)
     ProcDataList sortedProcesses = processes;
     std::stable_sort(sortedProcesses.begin(), sortedProcesses.end());
 
-    // iterator over m_data
+    // consecutive changes are reported at once, which matters with tens of thousands of processes
+    int firstChanged = -1;
+    int lastChanged = -1;
+    auto flushChanged = [&]() {
+        if (firstChanged != -1) {
+            emit dataChanged(index(firstChanged, 0), index(lastChanged, columnCount() - 1));
+            firstChanged = -1;
+        }
+    };
+
+    // iterators over m_data and sortedProcesses
     int i = 0;
+    int j = 0;
+    const int numProcesses = sortedProcesses.size();
+    while (i < m_data.size() || j < numProcesses) {
+        // remove old procs, they seem to be outdated
+        int numRemoved = 0;
+        while (i + numRemoved < m_data.size()
+               && (j == numProcesses || m_data.at(i + numRemoved) < sortedProcesses.at(j))) {
+            ++numRemoved;
+        }
+        if (numRemoved) {
+            flushChanged();
+            beginRemoveRows(QModelIndex(), i, i + numRemoved - 1);
+            m_data.erase(m_data.begin() + i, m_data.begin() + i + numRemoved);
+            endRemoveRows();
+            continue;
+        }
 
-    foreach (const ProcData& newProc, sortedProcesses) {
-        bool shouldInsert = true;
-        while (i < m_data.count()) {
-            const ProcData& oldProc = m_data.at(i);
-            if (oldProc < newProc) {
-                // remove old proc, seems to be outdated
-                beginRemoveRows(QModelIndex(), i, i);
-                m_data.removeAt(i);
-                endRemoveRows();
-                continue;
-            } else if (newProc == oldProc) {
-                // already contained, hence increment and break.
-                // Update entry before if something changed (like state),
-                // this make sure m_data match exactly sortedProcesses for later Q_ASSERT check.
-                if (!newProc.equals(oldProc)) {
-                    m_data[i] = newProc;
-                    emit dataChanged(index(i, 0), index(i, columnCount() - 1));
-                }
-                ++i;
-                shouldInsert = false;
-                break;
-            } else { // newProc < oldProc
-                // new entry, break and insert it
-                break;
-            }
+        // insert the new procs in front of the next old one
+        int numInserted = 0;
+        while (j + numInserted < numProcesses
+               && (i == m_data.size() || sortedProcesses.at(j + numInserted) < m_data.at(i))) {
+            ++numInserted;
         }
-        if (shouldInsert) {
-            beginInsertRows(QModelIndex(), i, i);
-            m_data.insert(i, newProc);
+        if (numInserted) {
+            flushChanged();
+            beginInsertRows(QModelIndex(), i, i + numInserted - 1);
+            m_data.insert(m_data.begin() + i, numInserted, {});
+            std::copy(sortedProcesses.cbegin() + j, sortedProcesses.cbegin() + j + numInserted, m_data.begin() + i);
             endInsertRows();
-            // let i point to old element again
-            ++i;
+            i += numInserted;
+            j += numInserted;
+            continue;
+        }
+
+        // already contained, update the entry if something changed (like state),
+        // this makes sure m_data matches exactly sortedProcesses for the Q_ASSERT check below
+        const ProcData& newProc = sortedProcesses.at(j);
+        if (!newProc.equals(m_data.at(i))) {
+            m_data[i] = newProc;
+            if (firstChanged == -1 || lastChanged != i - 1) {
+                flushChanged();
+                firstChanged = i;
+            }
+            lastChanged = i;
         }
+        ++i;
+        ++j;
     }
+    flushChanged();
 
     // make sure the new data is properly inserted
     Q_ASSERT(m_data == sortedProcesses);
@@ -116,6 +140,8 @@ QVariant ProcessModel::headerData(int section, Qt::Orientation orientation, int
         return tr("State");
     else if (section == UserColumn)
         return tr("User");
+    else if (section == CgroupColumn)
+        return tr("Cgroup");
 
     return {};
 }
@@ -136,8 +162,10 @@ QVariant ProcessModel::data(const QModelIndex& index, int role) const
             return data.state;
         else if (index.column() == UserColumn)
             return data.user;
+        else if (index.column() == CgroupColumn)
+            return data.cgroup;
     } else if (role == Qt::ToolTipRole) {
-        return tr("Name: %1\nPID: %2\nOwner: %3").arg(data.name, data.ppid, data.user);
+        return tr("Name: %1\nPID: %2\nOwner: %3\nCgroup: %4").arg(data.name, data.ppid, data.user, data.cgroup);
     } else if (role == PIDRole) {
         return data.ppid.toInt(); // why is this a QString in the first place!?
     } else if (role == NameRole) {
@@ -146,6 +174,8 @@ QVariant ProcessModel::data(const QModelIndex& index, int role) const
         return data.state;
     } else if (role == UserRole) {
         return data.user;
+    } else if (role == CgroupRole) {
+        return data.cgroup;
     }
 
     return {};
@@ -36,6 +36,7 @@ public:
         NameColumn,
         StateColumn,
         UserColumn,
+        CgroupColumn,
         COLUMN_COUNT
     };
 
@@ -47,7 +48,8 @@ public:
         PIDRole = Qt::UserRole,
         NameRole,
         StateRole,
-        UserRole
+        UserRole,
+        CgroupRole
     };
 
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
@@ -0,0 +1,131 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+// just enough of the protobuf wire format to write the profiles and traces of other tools without depending on
+// protobuf, see PerfettoExport and PprofExport
+namespace Protobuf {
+// a message, nested messages get serialized first and are then added like bytes
+class Message
+{
+public:
+    void addVarint(quint32 field, quint64 value)
+    {
+        addKey(field, 0);
+        addRawVarint(value);
+    }
+
+    // negative values are encoded as 64 bit two's complement, like protobuf does for int32 and int64
+    void addInt(quint32 field, qint64 value)
+    {
+        addVarint(field, static_cast<quint64>(value));
+    }
+
+    void addBytes(quint32 field, const QByteArray& bytes)
+    {
+        addKey(field, 2);
+        addRawVarint(static_cast<quint64>(bytes.size()));
+        m_data.append(bytes);
+    }
+
+    void addString(quint32 field, const QString& string)
+    {
+        addBytes(field, string.toUtf8());
+    }
+
+    void addMessage(quint32 field, const Message& message)
+    {
+        addBytes(field, message.m_data);
+    }
+
+    bool isEmpty() const
+    {
+        return m_data.isEmpty();
+    }
+
+    int size() const
+    {
+        return m_data.size();
+    }
+
+    const QByteArray& data() const
+    {
+        return m_data;
+    }
+
+    void clear()
+    {
+        // keeps the capacity, the messages get reused for every chunk
+        m_data.resize(0);
+    }
+
+private:
+    void addKey(quint32 field, quint32 wireType)
+    {
+        addRawVarint((static_cast<quint64>(field) << 3) | wireType);
+    }
+
+    void addRawVarint(quint64 value)
+    {
+        char buffer[10];
+        int size = 0;
+        do {
+            const auto byte = static_cast<char>(value & 0x7f);
+            value >>= 7;
+            buffer[size++] = value ? static_cast<char>(byte | 0x80) : byte;
+        } while (value);
+        m_data.append(buffer, size);
+    }
+
+    QByteArray m_data;
+};
+
+// streams the fields of a top-level message to @p output in chunks of about 1 MiB
+// protobuf allows the fields in any order, so large messages can be written without keeping them in memory
+class StreamWriter
+{
+public:
+    explicit StreamWriter(QIODevice* output)
+        : m_output(output)
+    {
+    }
+
+    // add the fields here and call flushIfNeeded every now and then
+    Message& fields()
+    {
+        return m_fields;
+    }
+
+    void flushIfNeeded()
+    {
+        if (m_fields.size() >= ChunkSize) {
+            flush();
+        }
+    }
+
+    // returns false when any of the writes failed
+    bool flush()
+    {
+        if (!m_writeFailed && !m_fields.isEmpty()) {
+            m_writeFailed = m_output->write(m_fields.data()) != m_fields.size();
+        }
+        m_fields.clear();
+        return !m_writeFailed;
+    }
+
+private:
+    static const constexpr int ChunkSize = 1024 * 1024;
+
+    QIODevice* m_output;
+    Message m_fields;
+    bool m_writeFailed = false;
+};
+}
@@ -0,0 +1,309 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "reportexport.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include <algorithm>
+#include <tuple>
+
+#include "../util.h"
+
+namespace {
+struct SymbolCost
+{
+    Data::Symbol symbol;
+    qint64 selfCost = 0;
+    qint64 inclusiveCost = 0;
+};
+
+struct ThreadCost
+{
+    qint32 pid = Data::INVALID_PID;
+    qint32 tid = Data::INVALID_TID;
+    QString name;
+    qint64 cost = 0;
+    qint64 numSamples = 0;
+    quint64 offCpuTime = 0;
+};
+
+bool isValidType(const Data::Costs& costs, int type)
+{
+    return type >= 0 && type < costs.numTypes();
+}
+
+// sorted by cost, then by symbol to get reproducible reports
+QVector<SymbolCost> topSymbols(const Data::CallerCalleeResults& results, int type, int count)
+{
+    QVector<SymbolCost> symbols;
+    if (!isValidType(results.selfCosts, type)) {
+        return symbols;
+    }
+    for (auto it = results.entries.cbegin(), end = results.entries.cend(); it != end; ++it) {
+        const auto selfCost = results.selfCosts.cost(type, it->id);
+        if (selfCost > 0) {
+            symbols.push_back({it.key(), selfCost, results.inclusiveCosts.cost(type, it->id)});
+        }
+    }
+
+    auto isHotter = [](const SymbolCost& lhs, const SymbolCost& rhs) {
+        if (lhs.selfCost != rhs.selfCost) {
+            return lhs.selfCost > rhs.selfCost;
+        }
+        return lhs.symbol < rhs.symbol;
+    };
+    const auto numResults = std::min<int>(symbols.size(), std::max(count, 0));
+    std::partial_sort(symbols.begin(), symbols.begin() + numResults, symbols.end(), isHotter);
+    symbols.resize(numResults);
+    return symbols;
+}
+
+QVector<SymbolCost> libraries(const Data::PerLibraryResults& results, int type)
+{
+    QVector<SymbolCost> libraries;
+    if (!isValidType(results.costs, type)) {
+        return libraries;
+    }
+    for (const auto& library : results.root.children) {
+        const auto cost = results.costs.cost(type, library.id);
+        if (cost > 0) {
+            libraries.push_back({library.symbol, cost, cost});
+        }
+    }
+    std::sort(libraries.begin(), libraries.end(), [](const SymbolCost& lhs, const SymbolCost& rhs) {
+        if (lhs.selfCost != rhs.selfCost) {
+            return lhs.selfCost > rhs.selfCost;
+        }
+        return lhs.symbol.binary < rhs.symbol.binary;
+    });
+    return libraries;
+}
+
+QVector<ThreadCost> threads(const Data::EventResults& results, int type)
+{
+    QVector<ThreadCost> threads;
+    threads.reserve(results.threads.size());
+    for (const auto& thread : results.threads) {
+        ThreadCost cost {thread.pid, thread.tid, thread.name, 0, 0, thread.offCpuTime};
+        for (const auto& event : thread.events) {
+            if (event.type == type) {
+                cost.cost += event.cost;
+                ++cost.numSamples;
+            }
+        }
+        threads.push_back(cost);
+    }
+    std::sort(threads.begin(), threads.end(), [](const ThreadCost& lhs, const ThreadCost& rhs) {
+        return std::tie(rhs.cost, lhs.pid, lhs.tid) < std::tie(lhs.cost, rhs.pid, rhs.tid);
+    });
+    return threads;
+}
+
+void writeStacks(QTextStream* stream, const QVector<Data::TopDown>& rows, const Data::Costs& selfCosts, int type,
+                 const QString& stack)
+{
+    // sort to get reproducible stacks, like in the flame graph export
+    QVector<const Data::TopDown*> sorted;
+    sorted.reserve(rows.size());
+    for (const auto& row : rows) {
+        sorted.push_back(&row);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Data::TopDown* lhs, const Data::TopDown* rhs) { return lhs->symbol < rhs->symbol; });
+
+    for (const auto* row : sorted) {
+        // the folded format separates frames by semicolons and the count by the last space
+        auto frame = Util::formatSymbol(row->symbol);
+        frame.replace(QLatin1Char(';'), QLatin1Char(':'));
+        const auto rowStack = stack.isEmpty() ? frame : (stack + QLatin1Char(';') + frame);
+        const auto selfCost = selfCosts.cost(type, row->id);
+        if (selfCost > 0) {
+            *stream << rowStack << ' ' << selfCost << '\n';
+        }
+        writeStacks(stream, row->children, selfCosts, type, rowStack);
+    }
+}
+
+QString collapsedStacks(const Data::TopDownResults& results, int type)
+{
+    QString stacks;
+    QTextStream stream(&stacks);
+    ReportExport::writeCollapsedStacks(&stream, results, type);
+    stream.flush();
+    return stacks;
+}
+
+QByteArray jsonReport(const ReportExport::Results& results, const ReportExport::Options& options)
+{
+    const auto type = options.costType;
+
+    QJsonObject report;
+    report[QLatin1String("file")] = results.file;
+    report[QLatin1String("command")] = results.summary.command;
+    if (isValidType(results.callerCallee.selfCosts, type)) {
+        report[QLatin1String("costType")] = results.callerCallee.selfCosts.typeName(type);
+        report[QLatin1String("totalCost")] = results.callerCallee.selfCosts.totalCost(type);
+    }
+
+    QJsonArray costs;
+    for (const auto& cost : results.summary.costs) {
+        costs.append(QJsonObject {{QLatin1String("label"), cost.label},
+                                  {QLatin1String("sampleCount"), static_cast<qint64>(cost.sampleCount)},
+                                  {QLatin1String("totalPeriod"), static_cast<qint64>(cost.totalPeriod)}});
+    }
+    report[QLatin1String("costs")] = costs;
+
+    QJsonArray symbols;
+    for (const auto& symbol : topSymbols(results.callerCallee, type, options.topCount)) {
+        symbols.append(QJsonObject {{QLatin1String("symbol"), Util::formatSymbol(symbol.symbol)},
+                                    {QLatin1String("binary"), symbol.symbol.binary},
+                                    {QLatin1String("selfCost"), symbol.selfCost},
+                                    {QLatin1String("inclusiveCost"), symbol.inclusiveCost}});
+    }
+    report[QLatin1String("topSymbols")] = symbols;
+
+    QJsonArray binaries;
+    for (const auto& library : libraries(results.perLibrary, type)) {
+        binaries.append(QJsonObject {{QLatin1String("binary"), library.symbol.binary},
+                                     {QLatin1String("path"), library.symbol.path},
+                                     {QLatin1String("cost"), library.selfCost}});
+    }
+    report[QLatin1String("libraries")] = binaries;
+
+    QJsonArray threadCosts;
+    for (const auto& thread : threads(results.events, type)) {
+        threadCosts.append(QJsonObject {{QLatin1String("pid"), thread.pid},
+                                        {QLatin1String("tid"), thread.tid},
+                                        {QLatin1String("name"), thread.name},
+                                        {QLatin1String("cost"), thread.cost},
+                                        {QLatin1String("samples"), thread.numSamples},
+                                        {QLatin1String("offCpuTime"), static_cast<qint64>(thread.offCpuTime)}});
+    }
+    report[QLatin1String("threads")] = threadCosts;
+
+    const auto stacks = collapsedStacks(results.topDown, type).split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+    report[QLatin1String("collapsedStacks")] = QJsonArray::fromStringList(stacks);
+
+    return QJsonDocument(report).toJson(QJsonDocument::Indented);
+}
+
+QString csvField(const QString& field)
+{
+    if (!field.contains(QLatin1Char(',')) && !field.contains(QLatin1Char('"')) && !field.contains(QLatin1Char('\n'))) {
+        return field;
+    }
+    auto quoted = field;
+    quoted.replace(QLatin1Char('"'), QLatin1String("\"\""));
+    return QLatin1Char('"') + quoted + QLatin1Char('"');
+}
+
+QByteArray csvReport(const ReportExport::Results& results, const ReportExport::Options& options)
+{
+    const auto type = options.costType;
+
+    QString report;
+    QTextStream stream(&report);
+    const auto file = csvField(results.file);
+    auto writeRow = [&](const QString& section, const QString& name, const QString& binary, const QString& pid,
+                        const QString& tid, qint64 selfCost, qint64 inclusiveCost) {
+        stream << file << ',' << section << ',' << csvField(name) << ',' << csvField(binary) << ',' << pid << ','
+               << tid << ',' << selfCost << ',' << inclusiveCost << '\n';
+    };
+
+    for (const auto& symbol : topSymbols(results.callerCallee, type, options.topCount)) {
+        writeRow(QStringLiteral("symbol"), Util::formatSymbol(symbol.symbol), symbol.symbol.binary, {}, {},
+                 symbol.selfCost, symbol.inclusiveCost);
+    }
+    for (const auto& library : libraries(results.perLibrary, type)) {
+        writeRow(QStringLiteral("library"), {}, library.symbol.binary, {}, {}, library.selfCost, library.selfCost);
+    }
+    for (const auto& thread : threads(results.events, type)) {
+        writeRow(QStringLiteral("thread"), thread.name, {}, QString::number(thread.pid), QString::number(thread.tid),
+                 thread.cost, thread.cost);
+    }
+    for (const auto& line : collapsedStacks(results.topDown, type).split(QLatin1Char('\n'), Qt::SkipEmptyParts)) {
+        const auto separator = line.lastIndexOf(QLatin1Char(' '));
+        const auto cost = line.mid(separator + 1).toLongLong();
+        writeRow(QStringLiteral("stack"), line.left(separator), {}, {}, {}, cost, cost);
+    }
+
+    stream.flush();
+    return report.toUtf8();
+}
+}
+
+namespace ReportExport {
+Format formatForFileName(const QString& fileName)
+{
+    if (fileName.endsWith(QLatin1String(".csv"), Qt::CaseInsensitive)) {
+        return Format::Csv;
+    }
+    const auto collapsedSuffixes = {QLatin1String(".folded"), QLatin1String(".collapsed"), QLatin1String(".txt")};
+    if (std::any_of(collapsedSuffixes.begin(), collapsedSuffixes.end(),
+                    [&fileName](QLatin1String suffix) { return fileName.endsWith(suffix, Qt::CaseInsensitive); })) {
+        return Format::Collapsed;
+    }
+    return Format::Json;
+}
+
+QByteArray report(Format format, const Results& results, const Options& options)
+{
+    switch (format) {
+    case Format::Json:
+        return jsonReport(results, options);
+    case Format::Csv:
+        return csvReport(results, options);
+    case Format::Collapsed: {
+        // the file is the outermost frame, that keeps the stacks of several files apart
+        QString stacks;
+        QTextStream stream(&stacks);
+        writeCollapsedStacks(&stream, results.topDown, options.costType, results.file);
+        stream.flush();
+        return stacks.toUtf8();
+    }
+    }
+    return {};
+}
+
+QByteArray merge(Format format, const QVector<QByteArray>& reports)
+{
+    auto join = [&reports]() {
+        QByteArray joined;
+        for (const auto& report : reports) {
+            joined += report;
+        }
+        return joined;
+    };
+
+    switch (format) {
+    case Format::Json: {
+        QByteArray merged = "[\n";
+        for (int i = 0, c = reports.size(); i < c; ++i) {
+            merged += reports[i].trimmed();
+            merged += (i + 1 < c) ? ",\n" : "\n";
+        }
+        return merged + "]\n";
+    }
+    case Format::Csv:
+        return "file,section,name,binary,pid,tid,selfCost,inclusiveCost\n" + join();
+    case Format::Collapsed:
+        return join();
+    }
+    return {};
+}
+
+void writeCollapsedStacks(QTextStream* stream, const Data::TopDownResults& results, int costType,
+                          const QString& prefix)
+{
+    if (isValidType(results.selfCosts, costType)) {
+        writeStacks(stream, results.root.children, results.selfCosts, costType, prefix);
+    }
+}
+}
@@ -0,0 +1,51 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "data.h"
+
+class QTextStream;
+
+// machine-readable reports of the parse results, for batch analysis from the command line
+// every file is turned into its report on its own, so the results don't need to be kept around until all got parsed
+namespace ReportExport {
+struct Results
+{
+    QString file;
+    Data::Summary summary;
+    Data::TopDownResults topDown;
+    Data::PerLibraryResults perLibrary;
+    Data::CallerCalleeResults callerCallee;
+    Data::EventResults events;
+};
+
+struct Options
+{
+    int costType = 0;
+    // the number of symbols with the highest self cost that get listed
+    int topCount = 20;
+};
+
+enum class Format
+{
+    Json,
+    Csv,
+    // the folded stacks of Brendan Gregg's flamegraph.pl, i.e. "main;foo;bar 42"
+    Collapsed,
+};
+
+// .csv, .folded, .collapsed and .txt are picked by their suffix, anything else becomes JSON
+Format formatForFileName(const QString& fileName);
+
+// the report of a single file, combine the reports of all files with merge
+QByteArray report(Format format, const Results& results, const Options& options = {});
+QByteArray merge(Format format, const QVector<QByteArray>& reports);
+
+// writes one line per stack with a self cost, @p prefix gets prepended as the outermost frame when not empty
+void writeCollapsedStacks(QTextStream* stream, const Data::TopDownResults& results, int costType,
+                          const QString& prefix = {});
+}
@@ -0,0 +1,461 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "resultsquery.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QJsonArray>
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include <utility>
+
+namespace {
+struct Term
+{
+    QString key;
+    QStringList values;
+};
+
+// splits "key=a,b key2="c d";e" into its terms, the values are separated by commas or semicolons outside of quotes
+std::optional<QVector<Term>> splitTerms(const QString& spec)
+{
+    QVector<Term> terms;
+    const auto size = spec.size();
+    qsizetype i = 0;
+    while (i < size) {
+        if (spec[i].isSpace()) {
+            ++i;
+            continue;
+        }
+        const auto equals = spec.indexOf(QLatin1Char('='), i);
+        if (equals == -1) {
+            return std::nullopt;
+        }
+        Term term {spec.mid(i, equals - i), {}};
+        if (term.key.contains(QLatin1Char(' '))) {
+            return std::nullopt;
+        }
+        i = equals + 1;
+
+        QString value;
+        bool quoted = false;
+        for (; i < size && (quoted || !spec[i].isSpace()); ++i) {
+            const auto c = spec[i];
+            if (c == QLatin1Char('"')) {
+                quoted = !quoted;
+            } else if (!quoted && (c == QLatin1Char(',') || c == QLatin1Char(';'))) {
+                term.values.append(value);
+                value.clear();
+            } else {
+                value.append(c);
+            }
+        }
+        if (quoted) {
+            return std::nullopt;
+        }
+        term.values.append(value);
+        term.values.removeAll(QString());
+        if (term.values.isEmpty()) {
+            return std::nullopt;
+        }
+        terms.append(term);
+    }
+    return terms;
+}
+
+bool parseSeconds(const QString& value, quint64* time)
+{
+    bool ok = false;
+    const auto seconds = value.toDouble(&ok);
+    if (!ok || seconds < 0) {
+        return false;
+    }
+    *time = static_cast<quint64>(std::llround(seconds * 1E9));
+    return true;
+}
+
+// a name without an argument list also matches the functions with one, e.g. "foo" matches "foo(int)"
+bool matchesName(const QString& name, const Data::Symbol& symbol)
+{
+    return symbol.symbol.startsWith(name)
+        && (symbol.symbol.size() == name.size() || symbol.symbol.at(name.size()) == QLatin1Char('('));
+}
+
+bool matchesAnyName(const QSet<QString>& names, const Data::Symbol& symbol)
+{
+    return std::any_of(names.cbegin(), names.cend(), [&symbol](const QString& name) {
+        return matchesName(name, symbol);
+    });
+}
+
+// whether @p frames, from the leaf to the outermost caller, contain @p callPath as consecutive frames
+bool containsCallPath(const QVector<const Data::Symbol*>& frames, const QStringList& callPath)
+{
+    const auto numFrames = frames.size();
+    const auto pathSize = callPath.size();
+    for (qsizetype start = 0; start + pathSize <= numFrames; ++start) {
+        bool matches = true;
+        for (qsizetype i = 0; i < pathSize && matches; ++i) {
+            // the call path starts with the caller, which is further away from the leaf
+            matches = matchesName(callPath[i], *frames[numFrames - 1 - start - i]);
+        }
+        if (matches) {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct StackInfo
+{
+    // empty when there are no stack predicates
+    QVector<bool> accepted;
+    // empty when the groups don't need the leaf symbols
+    QVector<const Data::Symbol*> leaves;
+};
+
+StackInfo stackInfo(const ResultsQuery::Query& query, const Data::BottomUpResults& bottomUp,
+                    const Data::EventResults& events, const Data::StackIndex& stackIndex)
+{
+    using ResultsQuery::GroupBy;
+    const bool hasPredicates = !query.symbols.isEmpty() || !query.binaries.isEmpty() || !query.callPath.isEmpty();
+    const bool needsLeaves = query.groupBy == GroupBy::Symbol || query.groupBy == GroupBy::Binary;
+    StackInfo info;
+    if (!hasPredicates && !needsLeaves) {
+        return info;
+    }
+
+    const auto numStacks = events.stacks.size();
+    QVector<bool> candidates(numStacks, true);
+    if (!query.callPath.isEmpty() && !stackIndex.isEmpty()) {
+        // only the stacks that contain every function of the call path need to be walked
+        QSet<Data::Symbol> symbols;
+        for (const auto& symbol : bottomUp.symbols) {
+            symbols.insert(symbol);
+        }
+        for (const auto& name : query.callPath) {
+            QVector<bool> containsName(numStacks, false);
+            for (const auto& symbol : symbols) {
+                if (!matchesName(name, symbol)) {
+                    continue;
+                }
+                for (auto stackId : stackIndex.stacksWithSymbol(symbol)) {
+                    containsName[stackId] = true;
+                }
+            }
+            for (qsizetype stackId = 0; stackId < numStacks; ++stackId) {
+                candidates[stackId] = candidates[stackId] && containsName[stackId];
+            }
+        }
+    }
+
+    if (hasPredicates) {
+        info.accepted.resize(numStacks);
+    }
+    if (needsLeaves) {
+        info.leaves.resize(numStacks);
+    }
+    QVector<const Data::Symbol*> frames;
+    for (qsizetype stackId = 0; stackId < numStacks; ++stackId) {
+        if (!candidates[stackId] && !needsLeaves) {
+            continue;
+        }
+        frames.clear();
+        bottomUp.foreachFrame(events.stacks[stackId], [&frames](const Data::Symbol& symbol, const Data::Location&) {
+            frames.append(&symbol);
+            return true;
+        });
+        const auto* leaf = frames.isEmpty() ? nullptr : frames.first();
+        if (needsLeaves) {
+            info.leaves[stackId] = leaf;
+        }
+        if (hasPredicates) {
+            info.accepted[stackId] = candidates[stackId] && leaf
+                && (query.symbols.isEmpty() || matchesAnyName(query.symbols, *leaf))
+                && (query.binaries.isEmpty() || query.binaries.contains(leaf->binary))
+                && (query.callPath.isEmpty() || containsCallPath(frames, query.callPath));
+        }
+    }
+    return info;
+}
+}
+
+namespace ResultsQuery {
+std::optional<Query> Query::fromString(const QString& spec, QString* errorMessage)
+{
+    auto fail = [errorMessage](const QString& message) -> std::optional<Query> {
+        if (errorMessage) {
+            *errorMessage = message;
+        }
+        return std::nullopt;
+    };
+
+    const auto terms = splitTerms(spec);
+    if (!terms) {
+        return fail(
+            QCoreApplication::translate("ResultsQuery", "Expected terms like key=value in \"%1\".").arg(spec));
+    }
+
+    Query query;
+    for (const auto& term : *terms) {
+        const auto& key = term.key;
+        const auto& values = term.values;
+        auto invalid = [&fail, &term]() {
+            return fail(QCoreApplication::translate("ResultsQuery", "Invalid value for %1: %2.")
+                            .arg(term.key, term.values.join(QLatin1Char(','))));
+        };
+
+        if (key == QLatin1String("time")) {
+            const auto range = values.first();
+            const auto separator = range.indexOf(QLatin1Char('-'));
+            if (values.size() != 1 || separator == -1) {
+                return invalid();
+            }
+            const auto start = range.left(separator);
+            const auto end = range.mid(separator + 1);
+            if ((!start.isEmpty() && !parseSeconds(start, &query.time.start))
+                || (!end.isEmpty() && !parseSeconds(end, &query.time.end)) || query.time.end < query.time.start) {
+                return invalid();
+            }
+        } else if (key == QLatin1String("last")) {
+            if (values.size() != 1 || !parseSeconds(values.first(), &query.last) || query.last == 0) {
+                return invalid();
+            }
+        } else if (key == QLatin1String("pid") || key == QLatin1String("tid")) {
+            for (const auto& value : values) {
+                bool ok = false;
+                const auto id = value.toInt(&ok);
+                if (ok) {
+                    (key == QLatin1String("pid") ? query.pids : query.tids).insert(id);
+                } else if (key == QLatin1String("pid")) {
+                    query.commands.insert(value);
+                } else {
+                    return invalid();
+                }
+            }
+        } else if (key == QLatin1String("cpu")) {
+            // like the cpu restriction of the parser, e.g. cpu=0-3,8
+            if (!Data::parseCpus(values, &query.cpus)) {
+                return invalid();
+            }
+        } else if (key == QLatin1String("symbol")) {
+            for (const auto& value : values) {
+                query.symbols.insert(value);
+            }
+        } else if (key == QLatin1String("binary")) {
+            for (const auto& value : values) {
+                query.binaries.insert(value);
+            }
+        } else if (key == QLatin1String("under")) {
+            query.callPath = values;
+        } else if (key == QLatin1String("type")) {
+            if (values.size() != 1) {
+                return invalid();
+            }
+            query.type = values.first();
+        } else if (key == QLatin1String("group")) {
+            static const QHash<QString, GroupBy> groups = {
+                {QStringLiteral("total"), GroupBy::Total},     {QStringLiteral("symbol"), GroupBy::Symbol},
+                {QStringLiteral("binary"), GroupBy::Binary},   {QStringLiteral("thread"), GroupBy::Thread},
+                {QStringLiteral("process"), GroupBy::Process}, {QStringLiteral("numa"), GroupBy::NumaNode},
+            };
+            const auto it = groups.constFind(values.first());
+            if (values.size() != 1 || it == groups.constEnd()) {
+                return invalid();
+            }
+            query.groupBy = it.value();
+        } else if (key == QLatin1String("top")) {
+            bool ok = false;
+            query.top = values.first().toInt(&ok);
+            if (values.size() != 1 || !ok || query.top < 0) {
+                return invalid();
+            }
+        } else {
+            return fail(QCoreApplication::translate("ResultsQuery", "Unknown term %1.").arg(key));
+        }
+    }
+    return query;
+}
+
+QJsonObject Result::toJson() const
+{
+    if (!error.isEmpty()) {
+        return {{QLatin1String("error"), error}};
+    }
+
+    QJsonArray jsonRows;
+    for (const auto& row : rows) {
+        QJsonObject jsonRow {{QLatin1String("cost"), row.cost}, {QLatin1String("samples"), row.numSamples}};
+        if (!row.name.isEmpty()) {
+            jsonRow[QLatin1String("name")] = row.name;
+        }
+        if (!row.binary.isEmpty()) {
+            jsonRow[QLatin1String("binary")] = row.binary;
+        }
+        if (row.pid != Data::INVALID_PID) {
+            jsonRow[QLatin1String("pid")] = row.pid;
+        }
+        if (row.tid != Data::INVALID_TID) {
+            jsonRow[QLatin1String("tid")] = row.tid;
+        }
+        if (row.numaNode) {
+            jsonRow[QLatin1String("numaNode")] = *row.numaNode;
+            jsonRow[QLatin1String("numaMigrations")] = row.numaMigrations;
+        }
+        jsonRows.append(jsonRow);
+    }
+    return {{QLatin1String("costType"), costType},
+            {QLatin1String("cost"), cost},
+            {QLatin1String("samples"), numSamples},
+            {QLatin1String("rows"), jsonRows}};
+}
+
+Result evaluate(const Query& query, const Data::BottomUpResults& bottomUp, const Data::EventResults& events,
+                const Data::StackIndex& stackIndex)
+{
+    Result result;
+
+    int type = query.type.isEmpty() ? 0 : -1;
+    bool isIndex = false;
+    const auto index = query.type.toInt(&isIndex);
+    for (int i = 0, c = bottomUp.costs.numTypes(); i < c && type == -1; ++i) {
+        if ((isIndex && i == index) || bottomUp.costs.typeName(i) == query.type) {
+            type = i;
+        }
+    }
+    if (type < 0 || type >= bottomUp.costs.numTypes()) {
+        result.error = QCoreApplication::translate("ResultsQuery", "Unknown cost type %1.").arg(query.type);
+        return result;
+    }
+    result.costType = bottomUp.costs.typeName(type);
+
+    // the time range of the query is relative to the first event of the capture
+    Data::TimeRange capture = {Data::MAX_TIME, 0};
+    for (const auto& thread : events.threads) {
+        if (!thread.events.isEmpty()) {
+            capture.start = std::min(capture.start, thread.events.first().time);
+            capture.end = std::max(capture.end, thread.events.last().time);
+        }
+    }
+    if (capture.start > capture.end) {
+        return result;
+    }
+    auto offset = [&capture](quint64 time) {
+        return time > Data::MAX_TIME - capture.start ? Data::MAX_TIME : capture.start + time;
+    };
+    const auto time = query.last > 0
+        ? Data::TimeRange(capture.end - std::min(query.last, capture.end - capture.start), capture.end)
+        : Data::TimeRange(offset(query.time.start), offset(query.time.end));
+
+    QSet<qint32> pids = query.pids;
+    if (!query.commands.isEmpty()) {
+        for (const auto& thread : events.threads) {
+            if (query.commands.contains(thread.name)) {
+                pids.insert(thread.pid);
+            }
+        }
+    }
+    const bool restrictsProcesses = !query.pids.isEmpty() || !query.commands.isEmpty();
+
+    const auto stacks = stackInfo(query, bottomUp, events, stackIndex);
+    QHash<QString, Row> groups;
+    for (const auto& thread : events.threads) {
+        if ((restrictsProcesses && !pids.contains(thread.pid))
+            || (!query.tids.isEmpty() && !query.tids.contains(thread.tid))) {
+            continue;
+        }
+
+        // the events of a thread are sorted by time, so the time blocks skip everything before the range
+        const auto& threadEvents = thread.events;
+        qint32 lastNumaNode = -1;
+        for (qsizetype i = threadEvents.lowerBound(time.start), c = threadEvents.size(); i < c; ++i) {
+            const auto event = threadEvents.at(i);
+            if (event.time > time.end) {
+                break;
+            }
+            if (event.type != type || (!query.cpus.isEmpty() && !query.cpus.contains(event.cpuId))) {
+                continue;
+            }
+            const bool hasStack = event.stackId >= 0 && event.stackId < events.stacks.size();
+            if (!stacks.accepted.isEmpty() && (!hasStack || !stacks.accepted[event.stackId])) {
+                continue;
+            }
+
+            const auto cost = static_cast<qint64>(event.cost);
+            result.cost += cost;
+            ++result.numSamples;
+            if (query.groupBy == GroupBy::Total) {
+                continue;
+            }
+
+            Row* row = nullptr;
+            switch (query.groupBy) {
+            case GroupBy::Total:
+                break;
+            case GroupBy::Symbol:
+            case GroupBy::Binary: {
+                const auto* leaf = hasStack ? stacks.leaves[event.stackId] : nullptr;
+                const auto name = leaf && query.groupBy == GroupBy::Symbol ? leaf->symbol : QString();
+                const auto binary = leaf ? leaf->binary : QString();
+                row = &groups[name + QLatin1Char('\0') + binary];
+                row->name = name;
+                row->binary = binary;
+                break;
+            }
+            case GroupBy::Thread:
+                row = &groups[QString::number(thread.pid) + QLatin1Char('/') + QString::number(thread.tid)];
+                row->name = thread.name;
+                row->pid = thread.pid;
+                row->tid = thread.tid;
+                break;
+            case GroupBy::Process:
+                row = &groups[QString::number(thread.pid)];
+                row->pid = thread.pid;
+                // the main thread has the name of the process
+                if (row->name.isEmpty() || thread.tid == thread.pid) {
+                    row->name = thread.name;
+                }
+                break;
+            case GroupBy::NumaNode: {
+                const auto node = events.numaNode(event.cpuId);
+                row = &groups[QString::number(node)];
+                if (!row->numaNode) {
+                    row->numaNode = node;
+                    row->name = node == -1 ? QStringLiteral("unknown NUMA node")
+                                           : QLatin1String("NUMA node %1").arg(QString::number(node));
+                }
+                if (node != -1) {
+                    if (lastNumaNode != -1 && node != lastNumaNode) {
+                        ++row->numaMigrations;
+                    }
+                    lastNumaNode = node;
+                }
+                break;
+            }
+            }
+            row->cost += cost;
+            ++row->numSamples;
+        }
+    }
+
+    result.rows.reserve(groups.size());
+    for (const auto& row : std::as_const(groups)) {
+        result.rows.append(row);
+    }
+    // sorted by cost, then by name to get reproducible results
+    auto isHotter = [](const Row& lhs, const Row& rhs) {
+        return std::tie(rhs.cost, lhs.name, lhs.binary, lhs.pid, lhs.tid)
+            < std::tie(lhs.cost, rhs.name, rhs.binary, rhs.pid, rhs.tid);
+    };
+    const auto numRows = std::min<qsizetype>(result.rows.size(), query.top);
+    std::partial_sort(result.rows.begin(), result.rows.begin() + numRows, result.rows.end(), isHotter);
+    result.rows.resize(numRows);
+    return result;
+}
+}
@@ -0,0 +1,94 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QJsonObject>
+#include <QSet>
+#include <QStringList>
+
+#include <optional>
+
+#include "data.h"
+
+// answers questions like "the cost of libfoo.so below main;run in the last 5 seconds" right from the loaded
+// results, without building the filtered results and models of the GUI. this is meant for automated checks that
+// ask many of these questions of every capture, see hotspot --query and the JSON-RPC method of AnalysisServer
+// the stack predicates get resolved once per stack with the symbol postings of the StackIndex, the time range
+// gets looked up per thread in the time blocks of the events
+namespace ResultsQuery {
+enum class GroupBy
+{
+    Total,
+    Symbol,
+    Binary,
+    Thread,
+    Process,
+    // by the NUMA node of the CPU of the events, along with how often the threads moved onto the node
+    NumaNode,
+};
+
+struct Query
+{
+    // relative to the first event of the capture, like Data::ParseRestriction
+    Data::TimeRange time = {0, std::numeric_limits<quint64>::max()};
+    // when set, only this many ns before the last event of the capture
+    quint64 last = 0;
+    // the processes are given by their pid or by the name of one of their threads
+    QSet<qint32> pids;
+    QSet<QString> commands;
+    QSet<qint32> tids;
+    QSet<quint32> cpus;
+    // the function names or binaries of the leaf frames, i.e. of the self costs
+    // a name without an argument list matches all overloads of the function
+    QSet<QString> symbols;
+    QSet<QString> binaries;
+    // the functions that have to be on the stack as consecutive frames, from the caller to the callee
+    QStringList callPath;
+    // the name or index of the cost type, the first one when empty
+    QString type;
+    GroupBy groupBy = GroupBy::Total;
+    // the number of groups with the highest cost that get returned
+    int top = 20;
+
+    // parses whitespace separated terms like "binary=libfoo.so under=main;run last=5 group=symbol top=10"
+    // the other terms are time=10-20 in seconds, pid=1234,firefox, tid=, cpu=0-3, symbol= and type=
+    // values with spaces get quoted, e.g. symbol="foo(int, int)"
+    static std::optional<Query> fromString(const QString& spec, QString* errorMessage = nullptr);
+};
+
+struct Row
+{
+    // the symbol, binary or thread name of the group
+    QString name;
+    QString binary;
+    qint32 pid = Data::INVALID_PID;
+    qint32 tid = Data::INVALID_TID;
+    // only set for GroupBy::NumaNode, -1 for the events of CPUs with an unknown node
+    std::optional<qint32> numaNode;
+    // how often a thread continued on this NUMA node after its previous event in the query ran on another one
+    qint64 numaMigrations = 0;
+    qint64 cost = 0;
+    qint64 numSamples = 0;
+};
+
+struct Result
+{
+    QString costType;
+    qint64 cost = 0;
+    qint64 numSamples = 0;
+    // sorted by cost, empty for GroupBy::Total
+    QVector<Row> rows;
+    // set when the query can't be answered, e.g. for an unknown cost type
+    QString error;
+
+    QJsonObject toJson() const;
+};
+
+// @p stackIndex may be empty, then the stacks get checked one by one
+Result evaluate(const Query& query, const Data::BottomUpResults& bottomUp, const Data::EventResults& events,
+                const Data::StackIndex& stackIndex);
+}
@@ -65,3 +65,33 @@ int search(const Array& array, int current, Direction direction, SearchFunc sear
     }
     return resultIndex;
 }
+
+// the next of the ascending @p matches after @p current in @p direction, wrapping around at the end like search_impl
+// without a current match, i.e. @p current being -1, the search starts at the first or last match
+// returns -1 when there are no matches
+template<typename EndReached>
+int searchMatches(const QVector<int>& matches, int current, Direction direction, EndReached endReached)
+{
+    if (matches.isEmpty())
+        return -1;
+
+    if (current < 0) {
+        return direction == Direction::Forward ? matches.first() : matches.last();
+    }
+
+    if (direction == Direction::Forward) {
+        const auto found = std::upper_bound(matches.begin(), matches.end(), current);
+        if (found != matches.end()) {
+            return *found;
+        }
+        endReached();
+        return matches.first();
+    }
+
+    const auto found = std::lower_bound(matches.begin(), matches.end(), current);
+    if (found != matches.begin()) {
+        return *(found - 1);
+    }
+    endReached();
+    return matches.last();
+}
@@ -7,9 +7,14 @@
 
 #include "sourcecodemodel.h"
 
+#include <QCache>
+#include <QDateTime>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QLoggingCategory>
+#include <QMutex>
+#include <QPointer>
 #include <QScopeGuard>
 #include <QTextBlock>
 #include <QTextDocument>
@@ -18,11 +23,55 @@
 #include <iterator>
 #include <limits>
 
+#include "../jobscheduler.h"
 #include "search.h"
 #include <climits>
 
 Q_LOGGING_CATEGORY(sourcecodemodel, "hotspot.sourcecodemodel", QtWarningMsg)
 
+namespace {
+// switching between the symbols of one file is common, and source trees on network mounts are slow to read
+struct SourceFileCache
+{
+    QMutex mutex;
+    QCache<QString, QStringList> files {16};
+};
+
+SourceFileCache& sourceFileCache()
+{
+    static SourceFileCache cache;
+    return cache;
+}
+
+// this may block, so don't call it from the GUI thread
+QStringList loadSourceFile(const QString& path)
+{
+    // the file could be edited while we are running
+    const auto info = QFileInfo(path);
+    const auto key = path + QLatin1Char('\n') + QString::number(info.lastModified().toMSecsSinceEpoch());
+
+    auto& cache = sourceFileCache();
+    {
+        QMutexLocker lock(&cache.mutex);
+        if (const auto* lines = cache.files.object(key)) {
+            return *lines;
+        }
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qCDebug(sourcecodemodel) << "failed to open source file" << path << file.errorString();
+        return {};
+    }
+
+    const auto lines = QString::fromUtf8(file.readAll()).split(QLatin1Char('\n'));
+
+    QMutexLocker lock(&cache.mutex);
+    cache.files.insert(key, new QStringList(lines));
+    return lines;
+}
+}
+
 SourceCodeModel::SourceCodeModel(KSyntaxHighlighting::Repository* repository, QObject* parent)
     : QAbstractTableModel(parent)
     , m_highlightedText(repository)
@@ -41,6 +90,15 @@ void SourceCodeModel::clear()
 
 void SourceCodeModel::setDisassembly(const DisassemblyOutput& disassemblyOutput,
                                      const Data::CallerCalleeResults& results)
+{
+    // only the costs of the symbol itself are needed when not showing the whole file
+    setDisassembly(disassemblyOutput, results,
+                   m_showWholeFile ? Data::SourceLocationCostMap() : results.sourceMap(disassemblyOutput.symbol));
+}
+
+void SourceCodeModel::setDisassembly(const DisassemblyOutput& disassemblyOutput,
+                                     const Data::CallerCalleeResults& results,
+                                     const Data::SourceLocationCostMap& sourceMap)
 {
     beginResetModel();
     auto guard = qScopeGuard([this]() { endResetModel(); });
@@ -48,6 +106,11 @@ void SourceCodeModel::setDisassembly(const DisassemblyOutput& disassemblyOutput,
     m_selfCosts = {};
     m_inclusiveCosts = {};
     m_numLines = 0;
+    m_lines.clear();
+    m_highlightedText.setText({});
+    resetSearch();
+    // cancel the loading of the previous source file
+    ++m_loadJobId;
 
     if (disassemblyOutput.mainSourceFileName.isEmpty()) {
         return;
@@ -63,8 +126,6 @@ void SourceCodeModel::setDisassembly(const DisassemblyOutput& disassemblyOutput,
 
     m_mainSourceFileName = disassemblyOutput.mainSourceFileName;
 
-    const auto entry = results.entries.find(disassemblyOutput.symbol);
-
     for (const auto& line : disassemblyOutput.disassemblyLines) {
         if (line.fileLine.line == 0 || line.fileLine.file != disassemblyOutput.mainSourceFileName) {
             continue;
@@ -80,9 +141,9 @@ void SourceCodeModel::setDisassembly(const DisassemblyOutput& disassemblyOutput,
         if (m_validLineNumbers.contains(line.fileLine.line))
             continue;
 
-        if (entry != results.entries.end()) {
-            const auto it = entry->sourceMap.find(line.fileLine);
-            if (it != entry->sourceMap.end()) {
+        if (!m_showWholeFile) {
+            const auto it = sourceMap.constFind(line.fileLine);
+            if (it != sourceMap.constEnd()) {
                 const auto& locationCost = it.value();
 
                 m_selfCosts.add(line.fileLine.line, locationCost.selfCost);
@@ -103,20 +164,86 @@ void SourceCodeModel::setDisassembly(const DisassemblyOutput& disassemblyOutput,
     Q_ASSERT(minLineNumber > 0);
     Q_ASSERT(minLineNumber < maxLineNumber);
 
-    m_prettySymbol = disassemblyOutput.symbol.prettySymbol;
-    m_startLine = minLineNumber - 1; // convert to index
-    m_numLines = maxLineNumber - minLineNumber + 1; // include minLineNumber
+    m_prettySymbol = disassemblyOutput.symbol.prettySymbol();
+    if (m_showWholeFile) {
+        // the costs of all symbols, the number of lines gets updated once the file got loaded
+        const auto fileCosts = results.fileCosts.constFind(m_mainSourceFileName);
+        if (fileCosts != results.fileCosts.constEnd()) {
+            for (auto it = fileCosts->begin(), end = fileCosts->end(); it != end; ++it) {
+                m_selfCosts.add(it.key(), it->selfCost);
+                m_inclusiveCosts.add(it.key(), it->inclusiveCost);
+            }
+        }
+        m_startLine = 0;
+        m_numLines = maxLineNumber;
+    } else {
+        m_startLine = minLineNumber - 1; // convert to index
+        m_numLines = maxLineNumber - minLineNumber + 1; // include minLineNumber
+    }
 
-    QFile file(disassemblyOutput.realSourceFileName);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    // the rows only depend on the disassembly, the source code gets filled in once it got loaded
+    const auto jobId = m_loadJobId.load();
+    const auto smartThis = QPointer<SourceCodeModel>(this);
+    JobScheduler::run(JobScheduler::Priority::Interactive, [smartThis, jobId,
+                                                            path = disassemblyOutput.realSourceFileName]() {
+        const auto lines = loadSourceFile(path);
+        QMetaObject::invokeMethod(
+            smartThis.data(),
+            [smartThis, jobId, lines]() {
+                if (smartThis && jobId == smartThis->m_loadJobId) {
+                    smartThis->setSourceLines(lines);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void SourceCodeModel::setSourceMap(const Data::SourceLocationCostMap& sourceMap)
+{
+    if (m_showWholeFile || m_validLineNumbers.isEmpty()) {
         return;
     }
 
-    const auto sourceCode = QString::fromUtf8(file.readAll());
+    // only the costs change, the rows stay the same
+    const auto selfCostTypes = m_selfCosts;
+    const auto inclusiveCostTypes = m_inclusiveCosts;
+    m_selfCosts = {};
+    m_inclusiveCosts = {};
+    m_selfCosts.initializeCostsFrom(selfCostTypes);
+    m_inclusiveCosts.initializeCostsFrom(inclusiveCostTypes);
 
-    m_lines = sourceCode.split(QLatin1Char('\n'));
+    for (auto it = sourceMap.cbegin(), end = sourceMap.cend(); it != end; ++it) {
+        if (it.key().file == m_mainSourceFileName && m_validLineNumbers.contains(it.key().line)) {
+            m_selfCosts.add(it.key().line, it->selfCost);
+            m_inclusiveCosts.add(it.key().line, it->inclusiveCost);
+        }
+    }
 
-    m_highlightedText.setText(m_lines);
+    const auto lastRow = rowCount() - 1;
+    if (lastRow >= 0) {
+        emit dataChanged(index(0, 0), index(lastRow, columnCount() - 1));
+    }
+}
+
+void SourceCodeModel::setSourceLines(const QStringList& lines)
+{
+    if (m_showWholeFile && lines.size() > m_numLines) {
+        beginInsertRows({}, m_numLines + 1, lines.size());
+        m_lines = lines;
+        m_highlightedText.setText(m_lines);
+        m_numLines = lines.size();
+        endInsertRows();
+    } else {
+        m_lines = lines;
+        m_highlightedText.setText(m_lines);
+    }
+    resetSearch();
+
+    const auto lastRow = rowCount() - 1;
+    if (lastRow > 0) {
+        emit dataChanged(index(1, SourceCodeColumn), index(lastRow, SourceCodeColumn));
+    }
+    emit sourceCodeLoaded();
 }
 
 QVariant SourceCodeModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -169,6 +296,10 @@ QVariant SourceCodeModel::data(const QModelIndex& index, int role) const
             }
 
             const int lineNumber = m_startLine + index.row() - 1;
+            // the source is still being loaded, or shorter than expected by the debug infos
+            if (lineNumber >= m_lines.size()) {
+                return {};
+            }
             if (role == SyntaxHighlightRole) {
                 return QVariant::fromValue(m_highlightedText.lineAt(lineNumber));
             }
@@ -244,6 +375,19 @@ QModelIndex SourceCodeModel::indexForFileLine(const Data::FileLine& fileLine) co
     return index(fileLine.line - m_startLine, 0);
 }
 
+QModelIndex SourceCodeModel::firstSymbolLineIndex() const
+{
+    if (m_validLineNumbers.isEmpty())
+        return {};
+    const auto line = *std::min_element(m_validLineNumbers.begin(), m_validLineNumbers.end());
+    return index(line - m_startLine, 0);
+}
+
+void SourceCodeModel::setShowWholeFile(bool showWholeFile)
+{
+    m_showWholeFile = showWholeFile;
+}
+
 void SourceCodeModel::setSysroot(const QString& sysroot)
 {
     m_sysroot = sysroot;
@@ -251,11 +395,46 @@ void SourceCodeModel::setSysroot(const QString& sysroot)
 
 void SourceCodeModel::find(const QString& search, Direction direction, int current)
 {
-    auto searchFunc = [&search](const QString& line) { return line.indexOf(search, 0, Qt::CaseInsensitive) != -1; };
+    if (m_searchIndex && search == m_search) {
+        emitSearchResult(direction, current);
+        return;
+    }
+
+    const auto jobId = ++m_searchJobId;
+    JobScheduler::run(JobScheduler::Priority::Interactive,
+                      [smartThis = QPointer<SourceCodeModel>(this), jobId, searchIndex = m_searchIndex,
+                       lines = m_lines, search, direction, current]() mutable {
+                          if (!searchIndex) {
+                              searchIndex = std::make_shared<const TextSearchIndex>(lines);
+                          }
+                          const auto matches = searchIndex->matchingLines(search);
+                          QMetaObject::invokeMethod(
+                              smartThis.data(),
+                              [smartThis, jobId, searchIndex, search, matches, direction, current]() {
+                                  if (smartThis && jobId == smartThis->m_searchJobId) {
+                                      smartThis->m_searchIndex = searchIndex;
+                                      smartThis->m_search = search;
+                                      smartThis->m_searchMatches = matches;
+                                      smartThis->emitSearchResult(direction, current);
+                                  }
+                              },
+                              Qt::QueuedConnection);
+                      });
+}
 
+void SourceCodeModel::resetSearch()
+{
+    m_searchIndex.reset();
+    m_searchMatches.clear();
+    // drop the results of a search that is still running
+    ++m_searchJobId;
+}
+
+void SourceCodeModel::emitSearchResult(Direction direction, int current)
+{
     auto endReached = [this] { emit searchEndReached(); };
 
-    const int resultIndex = ::search(m_lines, current, direction, searchFunc, endReached);
+    const int resultIndex = ::searchMatches(m_searchMatches, current, direction, endReached);
 
     if (resultIndex >= 0) {
         emit resultFound(createIndex(resultIndex + 1, SourceCodeColumn));
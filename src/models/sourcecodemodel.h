@@ -10,7 +10,9 @@
 #include "data.h"
 #include "disassemblyoutput.h"
 #include "highlightedtext.h"
+#include "textsearchindex.h"
 
+#include <atomic>
 #include <memory>
 #include <QAbstractTableModel>
 #include <QTextLine>
@@ -33,6 +35,11 @@ public:
 
     void clear();
     void setDisassembly(const DisassemblyOutput& disassemblyOutput, const Data::CallerCalleeResults& results);
+    // like above, but with the source map of the symbol computed already, see Data::CallerCalleeResults::sourceMap
+    void setDisassembly(const DisassemblyOutput& disassemblyOutput, const Data::CallerCalleeResults& results,
+                        const Data::SourceLocationCostMap& sourceMap);
+    // replaces the costs of the current symbol without resetting the model, a no-op when showing the whole file
+    void setSourceMap(const Data::SourceLocationCostMap& sourceMap);
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override;
@@ -42,12 +49,22 @@ public:
 
     Data::FileLine fileLineForIndex(const QModelIndex& index) const;
     QModelIndex indexForFileLine(const Data::FileLine& line) const;
+    // the first line that belongs to the current symbol
+    QModelIndex firstSymbolLineIndex() const;
 
     HighlightedText* highlightedText()
     {
         return &m_highlightedText;
     }
 
+    // show all lines of the source file with the costs of all symbols instead of just the lines of the current symbol
+    // this gets applied by the next call to setDisassembly
+    void setShowWholeFile(bool showWholeFile);
+    bool showWholeFile() const
+    {
+        return m_showWholeFile;
+    }
+
     enum Columns
     {
         SourceCodeLineNumber,
@@ -68,6 +85,8 @@ public:
 signals:
     void resultFound(QModelIndex index);
     void searchEndReached();
+    // the source file gets loaded in the background after setDisassembly
+    void sourceCodeLoaded();
 
 public slots:
     void updateHighlighting(int line);
@@ -77,6 +96,10 @@ public slots:
     void scrollToLine(const QString& lineNumber);
 
 private:
+    void setSourceLines(const QStringList& lines);
+    void resetSearch();
+    void emitSearchResult(Direction direction, int current);
+
     QString m_sysroot;
     QSet<int> m_validLineNumbers;
     HighlightedText m_highlightedText;
@@ -88,4 +111,11 @@ private:
     int m_numLines = 0;
     QStringList m_lines;
     int m_highlightLine = 0;
+    bool m_showWholeFile = false;
+    std::atomic<uint> m_loadJobId {0};
+    // built along with the first search in the background, the matches get reused by find next and previous
+    std::shared_ptr<const TextSearchIndex> m_searchIndex;
+    QString m_search;
+    QVector<int> m_searchMatches;
+    uint m_searchJobId = 0;
 };
@@ -0,0 +1,81 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "sparklinedelegate.h"
+
+#include <QPainter>
+#include <QPainterPath>
+
+#include "symboltimeseries.h"
+
+#include <algorithm>
+
+namespace {
+QPainterPath areaPath(const QVector<quint64>& costs, quint64 maxCost, const QRectF& rect)
+{
+    const auto bucketWidth = rect.width() / costs.size();
+    QPainterPath path(rect.bottomLeft());
+    for (int bucket = 0, numBuckets = costs.size(); bucket < numBuckets; ++bucket) {
+        const auto y = rect.bottom() - rect.height() * costs[bucket] / maxCost;
+        path.lineTo(rect.left() + bucket * bucketWidth, y);
+        path.lineTo(rect.left() + (bucket + 1) * bucketWidth, y);
+    }
+    path.lineTo(rect.bottomRight());
+    path.closeSubpath();
+    return path;
+}
+}
+
+SparklineDelegate::SparklineDelegate(int timeSeriesRole, QObject* parent)
+    : QStyledItemDelegate(parent)
+    , m_timeSeriesRole(timeSeriesRole)
+{
+}
+
+SparklineDelegate::~SparklineDelegate() = default;
+
+void SparklineDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    // the background and the selection
+    QStyledItemDelegate::paint(painter, option, index);
+
+    // asking for the series computes it in the background for the painted rows, the view gets repainted once it is done
+    const auto data = index.data(m_timeSeriesRole);
+    if (!data.canConvert<SymbolTimeSeries>()) {
+        return;
+    }
+    const auto series = data.value<SymbolTimeSeries>();
+    if (series.isEmpty()) {
+        return;
+    }
+    const auto maxCost = *std::max_element(series.inclusiveCosts.begin(), series.inclusiveCosts.end());
+    if (!maxCost) {
+        return;
+    }
+
+    const auto rect = QRectF(option.rect).adjusted(2, 2, -2, -2);
+    const bool isSelected = option.state & QStyle::State_Selected;
+    const auto color = option.palette.color(isSelected ? QPalette::HighlightedText : QPalette::Highlight);
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(Qt::NoPen);
+    auto inclusiveColor = color;
+    inclusiveColor.setAlpha(90);
+    painter->setBrush(inclusiveColor);
+    painter->drawPath(areaPath(series.inclusiveCosts, maxCost, rect));
+    painter->setBrush(color);
+    painter->drawPath(areaPath(series.selfCosts, maxCost, rect));
+
+    painter->setPen(QPen(option.palette.color(isSelected ? QPalette::HighlightedText : QPalette::Text), 1,
+                         Qt::DashLine));
+    const auto bucketWidth = rect.width() / series.numBuckets();
+    for (auto changePoint : series.changePoints) {
+        const auto x = rect.left() + changePoint * bucketWidth;
+        painter->drawLine(QPointF(x, rect.top()), QPointF(x, rect.bottom()));
+    }
+    painter->restore();
+}
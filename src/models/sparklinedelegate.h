@@ -0,0 +1,24 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QStyledItemDelegate>
+
+// paints the SymbolTimeSeries of a cell as a small area chart, the inclusive costs in the back and the self costs in
+// front of them, with a marker at every change point
+class SparklineDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    explicit SparklineDelegate(int timeSeriesRole, QObject* parent = nullptr);
+    ~SparklineDelegate();
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+
+private:
+    int m_timeSeriesRole;
+};
@@ -0,0 +1,129 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "stackhistogram.h"
+
+#include <QCoreApplication>
+#include <QHash>
+
+#include "../util.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+// the bucket of @p time within @p range, which must contain it
+int bucketOf(quint64 time, Data::TimeRange range, int numBuckets)
+{
+    return static_cast<int>((time - range.start) * static_cast<quint64>(numBuckets) / (range.delta() + 1));
+}
+}
+
+Data::TimeRange StackHistogram::Buckets::bucketTime(int bucket) const
+{
+    const auto width = time.delta() + 1;
+    const auto start = time.start + bucket * width / static_cast<quint64>(numBuckets);
+    const auto end = time.start + (bucket + 1) * width / static_cast<quint64>(numBuckets);
+    return {start, std::max(start, end - 1)};
+}
+
+StackHistogram::StackHistogram(const Data::EventResults& events, const Data::BottomUpResults& bottomUp,
+                               Grouping grouping)
+{
+    m_events.reserve(events.threads.size());
+    for (const auto& thread : events.threads) {
+        m_events.push_back(thread.events);
+    }
+
+    QHash<QString, qint32> labelIds;
+    m_stackLabels.reserve(events.stacks.size());
+    for (const auto& stack : events.stacks) {
+        QString label;
+        bottomUp.foreachFrame(stack, [&](const Data::Symbol& symbol, const Data::Location&) {
+            // the first frame is the leaf
+            label = grouping == Grouping::Symbols ? Util::formatSymbol(symbol) : Util::formatString(symbol.binary);
+            return false;
+        });
+        if (label.isEmpty()) {
+            m_stackLabels.push_back(-1);
+            continue;
+        }
+        auto it = labelIds.find(label);
+        if (it == labelIds.end()) {
+            it = labelIds.insert(label, m_labels.size());
+            m_labels.push_back(label);
+        }
+        m_stackLabels.push_back(it.value());
+    }
+}
+
+StackHistogram::Buckets StackHistogram::buckets(int costType, Data::TimeRange time, int numBuckets, int topK) const
+{
+    Buckets ret;
+    ret.time = time;
+    ret.numBuckets = numBuckets;
+    if (numBuckets <= 0 || m_labels.isEmpty()) {
+        return ret;
+    }
+
+    // calls @p callback with the label and the bucket of every event of the cost type within the time range
+    auto forEachEvent = [&](auto callback) {
+        for (const auto& events : m_events) {
+            const auto& times = events.times();
+            const auto& costs = events.costs();
+            const auto& types = events.types();
+            const auto& stackIds = events.stackIds();
+            for (qsizetype i = events.lowerBound(time.start), c = events.size(); i < c; ++i) {
+                const auto eventTime = times.at(i);
+                if (eventTime > time.end) {
+                    break;
+                }
+                const auto stackId = stackIds.at(i);
+                if (types.at(i) != costType || stackId < 0 || stackId >= m_stackLabels.size()) {
+                    continue;
+                }
+                const auto label = m_stackLabels.at(stackId);
+                if (label != -1) {
+                    callback(label, bucketOf(eventTime, time, numBuckets), costs.at(i));
+                }
+            }
+        }
+    };
+
+    // first find the top entries within the time range, then aggregate the buckets for them
+    QVector<quint64> totals(m_labels.size(), 0);
+    forEachEvent([&totals](qint32 label, int, quint64 cost) { totals[label] += cost; });
+
+    QVector<qint32> order(m_labels.size());
+    std::iota(order.begin(), order.end(), 0);
+    const auto numTop = std::min(topK, static_cast<int>(std::count_if(totals.begin(), totals.end(),
+                                                                      [](quint64 total) { return total > 0; })));
+    if (numTop == 0) {
+        return ret;
+    }
+    std::partial_sort(order.begin(), order.begin() + numTop, order.end(),
+                      [&totals](qint32 lhs, qint32 rhs) { return totals.at(lhs) > totals.at(rhs); });
+
+    const auto others = numTop;
+    QVector<qint32> entries(m_labels.size(), others);
+    for (int i = 0; i < numTop; ++i) {
+        entries[order.at(i)] = i;
+        ret.labels.push_back(m_labels.at(order.at(i)));
+    }
+    ret.labels.push_back(QCoreApplication::translate("StackHistogram", "others"));
+
+    const auto numEntries = ret.labels.size();
+    ret.costs.fill(0, numBuckets * numEntries);
+    forEachEvent([&](qint32 label, int bucket, quint64 cost) {
+        ret.costs[bucket * numEntries + entries.at(label)] += cost;
+    });
+
+    for (int bucket = 0; bucket < numBuckets; ++bucket) {
+        const auto begin = ret.costs.constBegin() + bucket * numEntries;
+        ret.maxBucketCost = std::max(ret.maxBucketCost, std::accumulate(begin, begin + numEntries, quint64(0)));
+    }
+    return ret;
+}
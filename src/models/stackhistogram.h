@@ -0,0 +1,66 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QStringList>
+#include <QVector>
+
+#include "data.h"
+
+// aggregates the costs of the events of all threads by their leaf symbol or binary in buckets of time
+// this shows how the mix of the hot functions changes over the course of a capture
+class StackHistogram
+{
+public:
+    enum class Grouping
+    {
+        Symbols,
+        Binaries
+    };
+
+    // the costs of the top entries and of all others within every bucket of a time range
+    struct Buckets
+    {
+        Data::TimeRange time;
+        int numBuckets = 0;
+        // the top entries ordered by their cost, followed by one entry for all others
+        QStringList labels;
+        // indexed by bucket * labels.size() + entry
+        QVector<quint64> costs;
+        quint64 maxBucketCost = 0;
+
+        bool isEmpty() const
+        {
+            return labels.isEmpty();
+        }
+
+        quint64 cost(int bucket, int entry) const
+        {
+            return costs.at(bucket * labels.size() + entry);
+        }
+
+        Data::TimeRange bucketTime(int bucket) const;
+    };
+
+    StackHistogram() = default;
+
+    // resolves the leaf symbol or binary of all stacks once, the buckets of every time range reuse them
+    StackHistogram(const Data::EventResults& events, const Data::BottomUpResults& bottomUp, Grouping grouping);
+
+    // the events of @p costType within @p time in @p numBuckets buckets, split into the @p topK entries with the
+    // highest cost within @p time and the rest
+    Buckets buckets(int costType, Data::TimeRange time, int numBuckets, int topK) const;
+
+private:
+    // the events of all threads
+    QVector<Data::Events> m_events;
+    QStringList m_labels;
+    // the index into m_labels per stack, -1 for empty stacks
+    QVector<qint32> m_stackLabels;
+};
+
+Q_DECLARE_METATYPE(StackHistogram::Grouping)
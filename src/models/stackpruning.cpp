@@ -0,0 +1,77 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "stackpruning.h"
+
+#include <algorithm>
+
+StackPruning::StackPruning(const QStringList& patterns, int maxDepth, bool collapseRecursion)
+    : m_maxDepth(std::max(0, maxDepth))
+    , m_collapseRecursion(collapseRecursion)
+{
+    for (const auto& pattern : patterns) {
+        QRegularExpression regex(QRegularExpression::wildcardToRegularExpression(pattern));
+        if (regex.isValid()) {
+            m_patterns.push_back(regex);
+        }
+    }
+}
+
+void StackPruning::addSymbol(qint32 locationId, const QString& symbol, const QString& binary)
+{
+    if (locationId < 0 || (m_patterns.isEmpty() && !m_collapseRecursion)) {
+        return;
+    }
+    if (m_frameSymbols.size() <= locationId) {
+        const auto oldSize = m_frameSymbols.size();
+        m_frameSymbols.resize(locationId + 1);
+        // the locations in between have not been defined yet
+        std::fill(m_frameSymbols.begin() + oldSize, m_frameSymbols.end(), UnknownSymbol);
+    }
+
+    auto& frameSymbol = m_frameSymbols[locationId];
+    const auto isPruned = std::any_of(m_patterns.cbegin(), m_patterns.cend(), [&](const QRegularExpression& regex) {
+        return (!symbol.isEmpty() && regex.match(symbol).hasMatch())
+            || (!binary.isEmpty() && regex.match(binary).hasMatch());
+    });
+    if (isPruned) {
+        frameSymbol = PrunedSymbol;
+    } else if (m_collapseRecursion && !symbol.isEmpty()) {
+        auto it = m_symbolIds.constFind({symbol, binary});
+        if (it == m_symbolIds.constEnd()) {
+            it = m_symbolIds.insert({symbol, binary}, m_symbolIds.size());
+        }
+        frameSymbol = it.value();
+    } else {
+        frameSymbol = UnknownSymbol;
+    }
+}
+
+const QVector<qint32>& StackPruning::prune(const QVector<qint32>& frames)
+{
+    auto frameSymbol = [this](qint32 frame) {
+        return frame >= 0 && frame < m_frameSymbols.size() ? m_frameSymbols.at(frame) : UnknownSymbol;
+    };
+
+    m_pruned.clear();
+    qint32 previousSymbol = UnknownSymbol;
+    for (auto frame : frames) {
+        const auto symbol = frameSymbol(frame);
+        if (symbol == PrunedSymbol) {
+            continue;
+        }
+        // the innermost frame of a recursion is kept, for a recursive leaf it has the sampled instruction
+        if (m_collapseRecursion && symbol >= 0 && symbol == previousSymbol) {
+            continue;
+        }
+        previousSymbol = symbol;
+        m_pruned.push_back(frame);
+        if (m_pruned.size() == m_maxDepth) {
+            break;
+        }
+    }
+    return m_pruned;
+}
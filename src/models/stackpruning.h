@@ -0,0 +1,52 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QVector>
+
+#include <utility>
+
+// drops and collapses the uninteresting frames of the sampled stacks before they get interned
+// kernel entry trampolines, interpreter dispatch loops and start-up frames inflate every stack otherwise,
+// which costs memory and makes the trees larger and slower to aggregate
+class StackPruning
+{
+public:
+    StackPruning() = default;
+    // @p patterns are wildcards that get matched against the symbol and the binary of every frame,
+    // a @p maxDepth of 0 keeps all frames
+    StackPruning(const QStringList& patterns, int maxDepth, bool collapseRecursion);
+
+    bool isEnabled() const
+    {
+        return !m_patterns.isEmpty() || m_maxDepth > 0 || m_collapseRecursion;
+    }
+
+    // to be called for the symbol of every location, the frames of the stacks are the ids of their locations
+    void addSymbol(qint32 locationId, const QString& symbol, const QString& binary);
+
+    // @p frames without the pruned ones, starting at the leaf like @p frames
+    // a direct recursion gets collapsed into one frame, and beyond the maximum depth only the innermost frames
+    // are kept, just like perf does with --max-stack. the result stays valid until the next call
+    const QVector<qint32>& prune(const QVector<qint32>& frames);
+
+private:
+    // the frames of locations without a symbol are never pruned nor collapsed
+    static const constexpr qint32 UnknownSymbol = -2;
+    static const constexpr qint32 PrunedSymbol = -1;
+
+    QVector<QRegularExpression> m_patterns;
+    int m_maxDepth = 0;
+    bool m_collapseRecursion = false;
+    // indexed by the location id, the id of the symbol or one of the values above
+    QVector<qint32> m_frameSymbols;
+    QHash<std::pair<QString, QString>, qint32> m_symbolIds;
+    QVector<qint32> m_pruned;
+};
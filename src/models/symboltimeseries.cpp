@@ -0,0 +1,329 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "symboltimeseries.h"
+
+#include <QCoreApplication>
+#include <QPointer>
+
+#include "../jobscheduler.h"
+#include "../selfprofiler.h"
+#include "../util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+QString tr(const char* text, int n = -1)
+{
+    return QCoreApplication::translate("SymbolTimeSeries", text, nullptr, n);
+}
+
+// the bucket of @p time within @p range, which must contain it
+int bucketOf(quint64 time, Data::TimeRange range, int numBuckets)
+{
+    return static_cast<int>((time - range.start) * static_cast<quint64>(numBuckets) / (range.delta() + 1));
+}
+}
+
+Data::TimeRange SymbolTimeSeries::bucketTime(int bucket) const
+{
+    const auto width = time.delta() + 1;
+    const auto numBuckets = static_cast<quint64>(inclusiveCosts.size());
+    const auto start = time.start + bucket * width / numBuckets;
+    const auto end = time.start + (bucket + 1) * width / numBuckets;
+    return {start, std::max(start, end - 1)};
+}
+
+QString SymbolTimeSeries::phasesToolTip() const
+{
+    if (isEmpty()) {
+        return {};
+    }
+
+    QString ret = QLatin1String("<qt>") + tr("%n phase(s) over time:", changePoints.size() + 1);
+    for (int phase = 0, numPhases = changePoints.size() + 1; phase < numPhases; ++phase) {
+        const auto begin = phase == 0 ? 0 : changePoints[phase - 1];
+        const auto end = phase == changePoints.size() ? numBuckets() : changePoints[phase];
+        const auto cost = std::accumulate(inclusiveCosts.begin() + begin, inclusiveCosts.begin() + end, quint64(0));
+        ret += QLatin1String("<br/>")
+            + tr("from %1: %2 per bucket")
+                  .arg(Util::formatTimeString(bucketTime(begin).start - time.start),
+                       Util::formatCost(cost / (end - begin)));
+    }
+    return ret + QLatin1String("</qt>");
+}
+
+QVector<int> SymbolTimeSeries::changePoints(const QVector<quint64>& values, int maxChangePoints)
+{
+    const int numValues = values.size();
+    if (numValues < 2 * MinPhaseLength || maxChangePoints <= 0) {
+        return {};
+    }
+
+    // the prefix sums yield the squared error of every segment in constant time
+    QVector<double> sums(numValues + 1, 0);
+    QVector<double> squares(numValues + 1, 0);
+    for (int i = 0; i < numValues; ++i) {
+        const auto value = static_cast<double>(values[i]);
+        sums[i + 1] = sums[i] + value;
+        squares[i + 1] = squares[i] + value * value;
+    }
+    auto error = [&](int begin, int end) {
+        const auto sum = sums[end] - sums[begin];
+        return squares[end] - squares[begin] - sum * sum / (end - begin);
+    };
+
+    // the median of the differences ignores the few large ones at the change points
+    QVector<double> differences(numValues - 1);
+    for (int i = 1; i < numValues; ++i) {
+        differences[i - 1] = std::abs(static_cast<double>(values[i]) - static_cast<double>(values[i - 1]));
+    }
+    auto median = differences.begin() + differences.size() / 2;
+    std::nth_element(differences.begin(), median, differences.end());
+    // the standard deviation of normally distributed noise, the difference of two values has twice its variance
+    auto variance = std::pow(*median / (0.6745 * std::sqrt(2.)), 2);
+    if (variance == 0) {
+        // the series is mostly flat, e.g. a single step
+        variance = std::accumulate(differences.begin(), differences.end(), 0.,
+                                   [](double sum, double difference) { return sum + difference * difference; })
+            / (2 * differences.size());
+    }
+    if (variance == 0) {
+        return {};
+    }
+    // like the BIC, a split has to explain more than the noise would by chance
+    const auto penalty = 2 * variance * std::log(numValues);
+
+    struct Split
+    {
+        int begin = 0;
+        int end = 0;
+        int at = -1;
+        double gain = 0;
+    };
+    auto bestSplit = [&](int begin, int end) {
+        Split split {begin, end};
+        const auto total = error(begin, end);
+        for (int at = begin + MinPhaseLength; at <= end - MinPhaseLength; ++at) {
+            const auto gain = total - error(begin, at) - error(at, end);
+            if (gain > split.gain) {
+                split.at = at;
+                split.gain = gain;
+            }
+        }
+        return split;
+    };
+
+    // always split the segment where it helps the most, so the strongest phases remain when hitting the limit
+    QVector<Split> candidates = {bestSplit(0, numValues)};
+    QVector<int> ret;
+    while (ret.size() < maxChangePoints) {
+        const auto it = std::max_element(candidates.begin(), candidates.end(),
+                                         [](const Split& lhs, const Split& rhs) { return lhs.gain < rhs.gain; });
+        if (it == candidates.end() || it->at == -1 || it->gain <= penalty) {
+            break;
+        }
+        const auto split = *it;
+        candidates.erase(it);
+        ret.push_back(split.at);
+        candidates.push_back(bestSplit(split.begin, split.at));
+        candidates.push_back(bestSplit(split.at, split.end));
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
+SymbolTimeSeriesIndex::SymbolTimeSeriesIndex(const Data::EventResults& events, const Data::StackIndex& stackIndex)
+    : m_stackIndex(stackIndex)
+    , m_numStacks(events.stacks.size())
+{
+    m_events.reserve(events.threads.size());
+    for (const auto& thread : events.threads) {
+        const auto& threadEvents = thread.events;
+        if (threadEvents.isEmpty()) {
+            continue;
+        }
+        const auto& times = threadEvents.times();
+        // the events are sorted by time
+        const auto first = times.at(0);
+        const auto last = times.at(times.size() - 1);
+        m_time = m_events.isEmpty() ? Data::TimeRange(first, last)
+                                    : Data::TimeRange(std::min(first, m_time.start), std::max(last, m_time.end));
+        m_events.push_back(threadEvents);
+    }
+}
+
+SymbolTimeSeries SymbolTimeSeriesIndex::series(const Data::Symbol& symbol, int costType, int numBuckets,
+                                               Data::TimeRange time) const
+{
+    SymbolTimeSeries ret;
+    ret.time = time;
+    if (numBuckets <= 0 || m_events.isEmpty()) {
+        return ret;
+    }
+    ret.selfCosts.fill(0, numBuckets);
+    ret.inclusiveCosts.fill(0, numBuckets);
+
+    enum StackKind : quint8
+    {
+        Unrelated,
+        Inclusive,
+        Self,
+    };
+    QVector<quint8> stackKinds(m_numStacks, Unrelated);
+    bool hasStacks = false;
+    for (auto stackId : m_stackIndex.stacksWithSymbol(symbol)) {
+        if (stackId < m_numStacks) {
+            stackKinds[stackId] = Inclusive;
+            hasStacks = true;
+        }
+    }
+    if (!hasStacks) {
+        return ret;
+    }
+    // the stacks whose leaf frame is the symbol
+    for (auto stackId : m_stackIndex.stacksWithPrefix({symbol}, Data::StackIndex::Direction::FromLeaf)) {
+        if (stackId < m_numStacks) {
+            stackKinds[stackId] = Self;
+        }
+    }
+
+    for (const auto& events : m_events) {
+        const auto& times = events.times();
+        events.forEachRun(
+            [&](const Data::EventRun& run) {
+                if (times.at(run.first) > time.end) {
+                    return false;
+                }
+                if (run.type != costType || run.stackId < 0 || run.stackId >= m_numStacks
+                    || stackKinds[run.stackId] == Unrelated) {
+                    return true;
+                }
+                const bool isSelf = stackKinds[run.stackId] == Self;
+                for (qsizetype i = run.first, end = run.first + run.count; i < end; ++i) {
+                    const auto eventTime = times.at(i);
+                    if (eventTime > time.end) {
+                        return false;
+                    }
+                    const auto bucket = bucketOf(eventTime, time, numBuckets);
+                    ret.inclusiveCosts[bucket] += run.cost;
+                    if (isSelf) {
+                        ret.selfCosts[bucket] += run.cost;
+                    }
+                }
+                return true;
+            },
+            events.lowerBound(time.start));
+    }
+
+    ret.changePoints = SymbolTimeSeries::changePoints(ret.inclusiveCosts);
+    return ret;
+}
+
+SymbolTimeSeriesCache::SymbolTimeSeriesCache(QObject* parent)
+    : QObject(parent)
+{
+}
+
+SymbolTimeSeriesCache::~SymbolTimeSeriesCache() = default;
+
+void SymbolTimeSeriesCache::setEvents(const Data::EventResults& events)
+{
+    m_events = events;
+    reset();
+}
+
+void SymbolTimeSeriesCache::setStackIndex(const Data::StackIndex& stackIndex)
+{
+    m_stackIndex = stackIndex;
+    reset();
+}
+
+void SymbolTimeSeriesCache::clear()
+{
+    m_events = {};
+    m_stackIndex = {};
+    reset();
+}
+
+void SymbolTimeSeriesCache::reset()
+{
+    ++m_generation;
+    m_index.reset();
+    m_series.clear();
+    m_pending.clear();
+    m_requested.clear();
+    emit cleared();
+}
+
+const SymbolTimeSeries* SymbolTimeSeriesCache::series(const Data::Symbol& symbol) const
+{
+    const auto it = m_series.constFind(symbol);
+    if (it != m_series.constEnd()) {
+        return &it.value();
+    }
+    if (m_events.threads.isEmpty() || m_stackIndex.isEmpty() || m_requested.contains(symbol)) {
+        return nullptr;
+    }
+
+    m_requested.insert(symbol);
+    m_pending.push_back(symbol);
+    if (!m_batchScheduled) {
+        // the rows get painted one after the other, wait for all of them to compute their series in one job
+        m_batchScheduled = true;
+        auto* self = const_cast<SymbolTimeSeriesCache*>(this);
+        QMetaObject::invokeMethod(
+            self, [self]() { self->computePending(); }, Qt::QueuedConnection);
+    }
+    return nullptr;
+}
+
+void SymbolTimeSeriesCache::computePending()
+{
+    m_batchScheduled = false;
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    using Results = QVector<std::pair<Data::Symbol, SymbolTimeSeries>>;
+    const auto generation = m_generation.load();
+    const auto smartThis = QPointer<SymbolTimeSeriesCache>(this);
+    auto jobCancelled = [smartThis, generation, currentGeneration = &m_generation]() {
+        return !smartThis || generation != (*currentGeneration);
+    };
+    JobScheduler::run(JobScheduler::Priority::Normal,
+                      [index = m_index, events = m_events, stackIndex = m_stackIndex,
+                       symbols = std::exchange(m_pending, {}), smartThis, jobCancelled]() mutable {
+                          ScopedPhase phase("symbol time series");
+                          if (!index) {
+                              index = std::make_shared<const SymbolTimeSeriesIndex>(events, stackIndex);
+                          }
+                          Results results;
+                          results.reserve(symbols.size());
+                          for (const auto& symbol : std::as_const(symbols)) {
+                              if (jobCancelled()) {
+                                  return;
+                              }
+                              results.push_back({symbol, index->series(symbol, CostType, NumBuckets)});
+                          }
+                          QMetaObject::invokeMethod(
+                              smartThis.data(),
+                              [smartThis, jobCancelled, index, results = std::move(results)]() {
+                                  if (jobCancelled()) {
+                                      return;
+                                  }
+                                  smartThis->m_index = index;
+                                  for (const auto& [symbol, series] : results) {
+                                      smartThis->m_series.insert(symbol, series);
+                                      smartThis->m_requested.remove(symbol);
+                                  }
+                                  emit smartThis->seriesAvailable();
+                              },
+                              Qt::QueuedConnection);
+                      });
+}
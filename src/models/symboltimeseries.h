@@ -0,0 +1,132 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+#include "data.h"
+
+// the costs of a single symbol over the time of a capture, in buckets of equal length
+struct SymbolTimeSeries
+{
+    Data::TimeRange time;
+    // the costs of the samples that hit the symbol itself
+    QVector<quint64> selfCosts;
+    // the costs of the samples with the symbol anywhere on the stack
+    QVector<quint64> inclusiveCosts;
+    // the first buckets of the phases after the first one, see changePoints
+    QVector<int> changePoints;
+
+    bool isEmpty() const
+    {
+        return inclusiveCosts.isEmpty();
+    }
+
+    int numBuckets() const
+    {
+        return inclusiveCosts.size();
+    }
+
+    Data::TimeRange bucketTime(int bucket) const;
+
+    // lists the phases with their time relative to the start of the series and their average cost per bucket
+    QString phasesToolTip() const;
+
+    // splits @p values into phases of different mean levels by binary segmentation and returns the first index of
+    // every phase but the first one. a split has to reduce the squared error by more than the noise, which gets
+    // estimated from the differences of adjacent values, so steady series with some jitter don't get split at all
+    static QVector<int> changePoints(const QVector<quint64>& values, int maxChangePoints = MaxChangePoints);
+
+    // the phases shorter than this many buckets are considered noise
+    static constexpr int MinPhaseLength = 2;
+    static constexpr int MaxChangePoints = 8;
+};
+
+Q_DECLARE_METATYPE(SymbolTimeSeries)
+
+// looks up the stacks of a symbol in the postings of the StackIndex, then sums up the costs of the events with
+// these stacks per bucket. the runs of the events get checked by their stack first, so only the matching runs have
+// their times looked at and the time blocks of the threads skip everything before the time range
+class SymbolTimeSeriesIndex
+{
+public:
+    SymbolTimeSeriesIndex() = default;
+    SymbolTimeSeriesIndex(const Data::EventResults& events, const Data::StackIndex& stackIndex);
+
+    // the time from the first to the last event of all threads
+    Data::TimeRange time() const
+    {
+        return m_time;
+    }
+
+    SymbolTimeSeries series(const Data::Symbol& symbol, int costType, int numBuckets) const
+    {
+        return series(symbol, costType, numBuckets, m_time);
+    }
+
+    SymbolTimeSeries series(const Data::Symbol& symbol, int costType, int numBuckets, Data::TimeRange time) const;
+
+private:
+    // the events of all threads
+    QVector<Data::Events> m_events;
+    Data::StackIndex m_stackIndex;
+    qint32 m_numStacks = 0;
+    Data::TimeRange m_time;
+};
+
+// computes the series of the symbols only once they get asked for, in the background, and keeps them until the data
+// changes. the models ask from their data(), i.e. for the rows that get painted, so the series of the rows that are
+// scrolled into view get added incrementally while the others never get computed at all
+class SymbolTimeSeriesCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SymbolTimeSeriesCache(QObject* parent = nullptr);
+    ~SymbolTimeSeriesCache() override;
+
+    // the events may be filtered, the stack index has to be the one of the unfiltered events
+    void setEvents(const Data::EventResults& events);
+    void setStackIndex(const Data::StackIndex& stackIndex);
+    void clear();
+
+    // returns nullptr while the series of @p symbol gets computed, seriesAvailable gets emitted once it is done
+    // the returned series is only valid until the next batch of series gets added
+    const SymbolTimeSeries* series(const Data::Symbol& symbol) const;
+
+    static constexpr int NumBuckets = 64;
+    // the series of the first cost type get shown
+    static constexpr int CostType = 0;
+
+signals:
+    // emitted after a batch of series got computed
+    void seriesAvailable();
+    // all series got dropped, e.g. because the events got filtered
+    void cleared();
+
+private:
+    void reset();
+    // computes the series of the pending symbols in one job
+    void computePending();
+
+    Data::EventResults m_events;
+    Data::StackIndex m_stackIndex;
+    // built by the first job, then reused until the data changes
+    std::shared_ptr<const SymbolTimeSeriesIndex> m_index;
+    QHash<Data::Symbol, SymbolTimeSeries> m_series;
+    // the symbols that got asked for but haven't been handed to a job yet
+    mutable QVector<Data::Symbol> m_pending;
+    // the symbols that got asked for and aren't computed yet
+    mutable QSet<Data::Symbol> m_requested;
+    mutable bool m_batchScheduled = false;
+    std::atomic<uint> m_generation {0};
+};
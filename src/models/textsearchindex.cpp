@@ -0,0 +1,50 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "textsearchindex.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+TextSearchIndex::TextSearchIndex(const QStringList& lines)
+{
+    const auto size = std::accumulate(lines.begin(), lines.end(), 0,
+                                      [](int size, const QString& line) { return size + line.size() + 1; });
+    m_text.reserve(size);
+    m_lineStarts.reserve(lines.size() + 1);
+    for (const auto& line : lines) {
+        // the lines are separated by newlines, which the search can't contain, so matches never span lines
+        m_text += line;
+        m_text += QLatin1Char('\n');
+        m_lineStarts.append(m_text.size());
+    }
+    // simple case folding keeps the length, so the offsets stay valid
+    m_text = std::move(m_text).toCaseFolded();
+}
+
+QVector<int> TextSearchIndex::matchingLines(const QString& search) const
+{
+    QVector<int> matches;
+    if (search.isEmpty()) {
+        matches.resize(numLines());
+        std::iota(matches.begin(), matches.end(), 0);
+        return matches;
+    } else if (search.contains(QLatin1Char('\n'))) {
+        return matches;
+    }
+
+    const auto needle = search.toCaseFolded();
+    int pos = 0;
+    while ((pos = m_text.indexOf(needle, pos, Qt::CaseSensitive)) != -1) {
+        const auto next = std::upper_bound(m_lineStarts.begin(), m_lineStarts.end(), pos);
+        const auto line = static_cast<int>(std::distance(m_lineStarts.begin(), next)) - 1;
+        matches.append(line);
+        // continue with the next line, every line is reported once
+        pos = m_lineStarts.at(line + 1);
+    }
+    return matches;
+}
@@ -0,0 +1,35 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// the lines of a source file or disassembly case folded into a single buffer, so that a search scans the whole text
+// with one vectorized substring search instead of comparing every line case insensitively
+// it gets built in the background along with the first search and is reused for every following one
+class TextSearchIndex
+{
+public:
+    TextSearchIndex() = default;
+    explicit TextSearchIndex(const QStringList& lines);
+
+    int numLines() const
+    {
+        return m_lineStarts.size() - 1;
+    }
+
+    // the indices of all lines that contain @p search ignoring the case, in ascending order
+    // an empty search matches every line
+    QVector<int> matchingLines(const QString& search) const;
+
+private:
+    QString m_text;
+    // the offset of every line in m_text, followed by the size of m_text
+    QVector<int> m_lineStarts = {0};
+};
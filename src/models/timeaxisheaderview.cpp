@@ -74,12 +74,16 @@ bool TimeAxisHeaderView::event(QEvent* event)
                                               sectionPosition(EventModel::EventsColumn));
 
         const auto oneNanoSecond = 1e-9;
-        for (const auto& tracepoint : std::as_const(m_tracepoints.tracepoints)) {
-            if (zoomTime.contains(tracepoint.time)) {
-                if (helpEvent->pos().x() == xForTime((tracepoint.time - m_timeRange.start) * oneNanoSecond)) {
-                    QToolTip::showText(helpEvent->globalPos(), tracepoint.name);
-                    return true;
+        const auto range = m_tracepoints.tracepointsInRange(zoomTime);
+        for (int i = range.first; i < range.second; ++i) {
+            const auto& tracepoint = m_tracepoints.tracepoints.at(i);
+            if (helpEvent->pos().x() == xForTime((tracepoint.time - m_timeRange.start) * oneNanoSecond)) {
+                auto toolTip = tracepoint.name;
+                if (tracepoint.table != -1) {
+                    toolTip += QLatin1Char('\n') + m_tracepoints.tables.at(tracepoint.table).format(tracepoint.row);
                 }
+                QToolTip::showText(helpEvent->globalPos(), toolTip);
+                return true;
             }
         }
 
@@ -139,9 +143,9 @@ void TimeAxisHeaderView::paintSection(QPainter* painter, const QRect& rect, int
         const auto tracepointPen = QPen(scheme.foreground(KColorScheme::LinkText), 1);
         painter->setPen(tracepointPen);
 
-        for (const auto& tracepoint : m_tracepoints.tracepoints) {
-            if (!zoomTime.contains(tracepoint.time))
-                continue;
+        const auto range = m_tracepoints.tracepointsInRange(zoomTime);
+        for (int i = range.first; i < range.second; ++i) {
+            const auto& tracepoint = m_tracepoints.tracepoints.at(i);
             const auto x = xForTime((tracepoint.time - m_timeRange.start) * oneNanoSecond);
             painter->drawLine(x, rect.height() / 2, x, rect.height());
         }
@@ -8,16 +8,23 @@
 #include "timelinedelegate.h"
 
 #include <QAbstractItemView>
+#include <QAction>
+#include <QCache>
 #include <QDebug>
 #include <QEvent>
 #include <QHelpEvent>
+#include <QImage>
 #include <QMenu>
 #include <QPainter>
+#include <QPointer>
 #include <QToolTip>
 
+#include "../jobscheduler.h"
 #include "../util.h"
 #include "eventmodel.h"
 #include "filterandzoomstack.h"
+#include "timelinesearchindex.h"
+#include "wakeupgraph.h"
 
 #include <KColorScheme>
 
@@ -25,6 +32,9 @@
 #include <utility>
 
 namespace {
+// the tooltip of an off-CPU span only lists the wakeups that happened last
+const constexpr int MaxCriticalPathSteps = 5;
+
 QPoint globalPos(const QMouseEvent* event)
 {
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -71,39 +81,18 @@ void TimeLineData::zoom(Data::TimeRange t)
 
 template<typename Callback>
 void TimeLineData::findSamples(int mappedX, int costType, int lostEventCostId, bool contains,
-                               const Data::Events::const_iterator& start, const Callback& callback) const
+                               const TimeLineSearchIndex& searchIndex, const Callback& callback) const
 {
-    if (events.isEmpty()) {
-        return;
-    }
-
-    auto it = start;
+    const auto mapTime = [this](quint64 time) { return mapTimeToX(time); };
+    const auto sample = [&callback](const Data::Event& event) { callback(event, false); };
     if (contains) {
-        // for a contains check, we must only include events for the correct type
-        // otherwise we might skip the sched switch e.g.
-        while (it->type != costType && it != events.constBegin()) {
-            --it;
-        }
+        searchIndex.forEachSpanAt(events, costType, mappedX, mapTime, sample);
+    } else {
+        searchIndex.forEachEventAt(events, costType, mappedX, mapTime, sample);
     }
-
-    while (it != events.constEnd()) {
-        const auto isLost = it->type == lostEventCostId;
-        if (it->type != costType && !isLost) {
-            ++it;
-            continue;
-        }
-        const auto timeX = mapTimeToX(it->time);
-        if (timeX > mappedX) {
-            // event lies to the right of the selected time
-            break;
-        } else if ((contains && mappedX > mapTimeToX(it->time + it->cost)) || (!contains && timeX < mappedX)) {
-            // event lies to the left of the selected time
-            ++it;
-            continue;
-        }
-        Q_ASSERT(contains || mappedX == timeX);
-        callback(*it, isLost);
-        ++it;
+    if (lostEventCostId != costType) {
+        searchIndex.forEachEventAt(events, lostEventCostId, mappedX, mapTime,
+                                   [&callback](const Data::Event& event) { callback(event, true); });
     }
 }
 
@@ -128,22 +117,418 @@ TimeLineData dataFromIndex(const QModelIndex& index, QRect rect, Data::ZoomActio
     return data;
 }
 
-Data::Events::const_iterator findEvent(const Data::Events::const_iterator& begin,
-                                       const Data::Events::const_iterator& end, quint64 time)
+Data::Events::const_iterator findEvent(const Data::Events& events, const Data::Events::const_iterator& begin,
+                                       quint64 time)
 {
-    auto byTime = [](const Data::Event& event, quint64 time) { return event.time < time; };
-    auto it = std::lower_bound(begin, end, time, byTime);
+    // the block index of the events allows us to skip directly to the right block
+    const auto end = events.constEnd();
+    auto it = events.constBegin() + events.lowerBound(time, begin.index());
     // it points to the first item for which our predicate returns false, we want to find the item before that
     // so decrement it if possible or return begin otherwise
     // if only one event is recorded, it will point to end it->time which will cause asan to complain
     return (it == begin || (it != end && it->time == time)) ? it : (it - 1);
 }
+
+// the colors used to paint a timeline row, resolved on the GUI thread
+struct TimeLineColors
+{
+    TimeLineColors(const QPalette& palette, bool isAlternate)
+    {
+        const auto scheme = KColorScheme(palette.currentColorGroup());
+
+        background = isAlternate ? palette.base() : palette.alternateBase();
+        running = scheme.background(KColorScheme::PositiveBackground).color();
+        running.setAlpha(128);
+        runningOutline = scheme.foreground(KColorScheme::PositiveText).color();
+        runningOutline.setAlpha(128);
+        offCpu = scheme.background(KColorScheme::NegativeBackground).color();
+        offCpuSelected = scheme.foreground(KColorScheme::NegativeText).color();
+        offCpuHovered = toHoverColor(offCpuSelected);
+        selectedPen = QPen(scheme.foreground(KColorScheme::ActiveText), 1);
+        hoveredPen = QPen(toHoverColor(selectedPen.color()), 1);
+        eventPen = QPen(scheme.foreground(KColorScheme::NeutralText), 1);
+        lostEventPen = QPen(scheme.foreground(KColorScheme::NegativeText), 1);
+        heat = scheme.foreground(KColorScheme::NeutralText).color();
+        numaSeparatorPen = QPen(palette.text(), 1);
+    }
+
+    QBrush background;
+    QColor running;
+    QColor runningOutline;
+    QColor offCpu;
+    QColor offCpuSelected;
+    QColor offCpuHovered;
+    QPen selectedPen;
+    QPen hoveredPen;
+    QPen eventPen;
+    QPen lostEventPen;
+    QColor heat;
+    QPen numaSeparatorPen;
+};
+
+// everything that is needed to paint the events of a row into a tile
+struct TimeLineTile
+{
+    TimeLineData data;
+    QVector<TimeLineMipmap> mipmaps;
+    int eventType = 0;
+    int offCpuCostId = -1;
+    int lostEventCostId = -1;
+    // the row sums up other rows and has only the mipmaps, see EventModel::IsAggregateRole
+    bool isAggregate = false;
+    // a CPU row in the heatmap mode, with the highest bin counts of all CPUs per level of the event type
+    bool isHeatmap = false;
+    QVector<quint32> heatmapMaxCounts;
+};
+
+// identifies a rendered tile, the selection is not part of it as it gets painted live on top
+struct TimeLineTileKey
+{
+    quint64 row = 0;
+    Data::TimeRange time;
+    QSize size;
+    int eventType = 0;
+    bool isAlternate = false;
+    bool isHeatmap = false;
+    qreal devicePixelRatio = 1;
+
+    bool operator==(const TimeLineTileKey& other) const
+    {
+        return row == other.row && time == other.time && size == other.size && eventType == other.eventType
+            && isAlternate == other.isAlternate && isHeatmap == other.isHeatmap
+            && devicePixelRatio == other.devicePixelRatio;
+    }
+};
+
+uint qHash(const TimeLineTileKey& key, uint seed = 0)
+{
+    Util::HashCombine hash;
+    seed = hash(seed, key.row);
+    seed = hash(seed, key.time.start);
+    seed = hash(seed, key.time.end);
+    seed = hash(seed, key.size.width());
+    seed = hash(seed, key.size.height());
+    seed = hash(seed, key.eventType);
+    seed = hash(seed, key.isAlternate);
+    seed = hash(seed, key.isHeatmap);
+    seed = hash(seed, key.devicePixelRatio);
+    return seed;
+}
+
+// visualize the time where the thread was active, or an empty rect when it lies outside the visible region
+QRect threadTimeRect(const TimeLineData& data, int width)
+{
+    auto rect =
+        QRect(QPoint(data.mapTimeToX(data.threadTime.start), 0), QPoint(data.mapTimeToX(data.threadTime.end), data.h));
+    if (rect.left() >= width || rect.right() <= 0) {
+        return {};
+    }
+    if (rect.left() < 0)
+        rect.setLeft(0);
+    if (rect.right() > width)
+        rect.setRight(width);
+    return rect;
+}
+
+// shades the bins of a CPU row by their count, the painter has to be translated like in paintEvents
+void paintHeatmap(QPainter* painter, const TimeLineTile& tile, const TimeLineColors& colors)
+{
+    const auto& data = tile.data;
+    const auto mipmap = tile.mipmaps.value(tile.eventType);
+    if (mipmap.isEmpty()) {
+        return;
+    }
+
+    // like for the aggregated rows, the finest bins span several pixels when zoomed in closely
+    const auto level = std::max(0, mipmap.levelForBinWidth(1. / data.xMultiplicator));
+    // the same count gets the same shade on all CPUs
+    const auto maxCount = tile.heatmapMaxCounts.value(level);
+    if (maxCount == 0) {
+        return;
+    }
+
+    const auto& bins = mipmap.bins(level);
+    const auto binWidth = mipmap.binWidth(level);
+    const auto firstBin = data.time.start > mipmap.start() ? (data.time.start - mipmap.start()) / binWidth : 0;
+    for (auto bin = static_cast<qsizetype>(firstBin), c = bins.size(); bin < c; ++bin) {
+        const auto time = mipmap.start() + bin * binWidth;
+        if (time > data.time.end) {
+            break;
+        }
+        const auto count = bins.at(bin).count;
+        if (count == 0) {
+            continue;
+        }
+        const auto x = std::max(data.mapTimeToX(time), 0);
+        const auto x2 = std::min(data.mapTimeToX(time + binWidth), data.w);
+        auto color = colors.heat;
+        // idle bins stay empty, the ones with few events still have to be visible
+        color.setAlphaF(0.1 + 0.9 * count / maxCount);
+        painter->fillRect(x, 0, std::max(1, x2 - x), data.h, color);
+    }
+}
+
+// paints the background and all events of a row, the painter has to be translated to the row's top left corner
+void paintEvents(QPainter* painter, const TimeLineTile& tile, const TimeLineColors& colors, QSize size)
+{
+    const auto& data = tile.data;
+
+    painter->fillRect(QRect(QPoint(0, 0), size), colors.background);
+
+    // account for padding
+    painter->translate(TimeLineData::padding, TimeLineData::padding);
+
+    if (tile.isHeatmap) {
+        paintHeatmap(painter, tile, colors);
+        return;
+    }
+
+    // skip threads that are outside the visible (zoomed) region
+    const auto runningRect = threadTimeRect(data, size.width());
+    if (runningRect.isNull()) {
+        return;
+    }
+
+    painter->setBrush(QBrush(colors.running));
+    painter->setPen(QPen(colors.runningOutline, 1));
+    painter->drawRect(runningRect.adjusted(-1, -1, 0, 0));
+
+    // visualize all events
+    painter->setBrush({});
+
+    if (tile.offCpuCostId != -1) {
+        for (const auto& event : data.events) {
+            if (event.type != tile.offCpuCostId) {
+                continue;
+            }
+
+            const auto x = data.mapTimeToX(event.time);
+            const auto x2 = data.mapTimeToX(event.time + event.cost);
+            painter->fillRect(x, 0, x2 - x, data.h, colors.offCpu);
+        }
+    }
+
+    // TODO: accumulate cost for events that fall to the same pixel somehow
+    // but how to then sync the y scale across different delegates?
+    // somehow deduce threshold via min time delta and max cost?
+    // TODO: how to deal with broken cycle counts in frequency mode? For now,
+    // we simply always fill the complete height which is also what we'd get
+    // from a graph in count mode (perf record -F vs. perf record -c)
+    // see also: https://www.spinics.net/lists/linux-perf-users/msg03486.html
+    auto drawLines = [&](int type, const QPen& pen, bool force) {
+        const auto mipmap = tile.mipmaps.value(type);
+        // the time spanned by a single pixel
+        const auto pixelTime = 1. / data.xMultiplicator;
+        auto level = mipmap.levelForBinWidth(pixelTime);
+        if (level == -1 && tile.isAggregate && !mipmap.isEmpty()) {
+            // aggregated rows have no events to fall back to, so the finest bins span several pixels then
+            level = 0;
+        }
+
+        int last_x = -1;
+        auto drawLine = [&](quint64 time, int top) {
+            const auto x = data.mapTimeToX(time);
+            if (x < TimeLineData::padding || x >= data.w) {
+                return;
+            }
+            // only draw a line when it changes anything visually
+            if (x != last_x || force) {
+                painter->drawLine(x, top, x, data.h);
+            }
+            last_x = x;
+        };
+
+        painter->setPen(pen);
+        if (level != -1) {
+            // zoomed out far enough to paint the pre-aggregated bins, only look at the visible ones
+            const auto& bins = mipmap.bins(level);
+            const auto binWidth = mipmap.binWidth(level);
+            const auto firstBin = data.time.start > mipmap.start() ? (data.time.start - mipmap.start()) / binWidth : 0;
+            // aggregated rows show how many events each bin has relative to the busiest one, i.e. how many of
+            // their threads were active, instead of only whether there was any event
+            quint32 maxCount = 0;
+            if (tile.isAggregate) {
+                for (const auto& bin : bins) {
+                    maxCount = std::max(maxCount, bin.count);
+                }
+                // lines of different heights can share a pixel
+                force = true;
+            }
+            for (auto bin = static_cast<qsizetype>(firstBin), c = bins.size(); bin < c; ++bin) {
+                const auto time = mipmap.start() + bin * binWidth;
+                if (time > data.time.end) {
+                    break;
+                }
+                const auto count = bins.at(bin).count;
+                if (count > 0) {
+                    drawLine(time, maxCount ? data.h - std::max(1, int(qint64(data.h) * count / maxCount)) : 0);
+                }
+            }
+            return;
+        }
+
+        // zoomed in closely or only few events, iterate the visible events directly
+        const auto& types = data.events.types();
+        const auto& times = data.events.times();
+        const auto begin = mipmap.isEmpty() ? 0 : data.events.lowerBound(data.time.start);
+        for (qsizetype i = begin, c = data.events.size(); i < c; ++i) {
+            if (types.at(i) != type) {
+                continue;
+            }
+            const auto time = times.at(i);
+            if (!mipmap.isEmpty() && time > data.time.end) {
+                break;
+            }
+            drawLine(time, 0);
+        }
+    };
+
+    drawLines(tile.eventType, colors.eventPen, false);
+
+    // always force drawing of lost events
+    if (tile.lostEventCostId != -1) {
+        drawLines(tile.lostEventCostId, colors.lostEventPen, true);
+    }
+}
+
+QImage renderTile(const TimeLineTile& tile, const TimeLineColors& colors, const TimeLineTileKey& key)
+{
+    QImage image(key.size * key.devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(key.devicePixelRatio);
+    QPainter painter(&image);
+    paintEvents(&painter, tile, colors, key.size);
+    return image;
+}
+
+// highlights the events of the selected and hovered stacks, the painter has to be translated like in paintEvents
+void paintSelection(QPainter* painter, const TimeLineData& data, const TimeLineColors& colors, int eventType,
+                    int offCpuCostId, const QSet<qint32>& selectedStacks, const QSet<qint32>& hoveredStacks)
+{
+    if (selectedStacks.isEmpty() && hoveredStacks.isEmpty()) {
+        return;
+    }
+
+    const auto& types = data.events.types();
+    const auto& stackIds = data.events.stackIds();
+    const auto& times = data.events.times();
+
+    if (offCpuCostId != -1) {
+        const auto& costs = data.events.costs();
+        for (qsizetype i = 0, c = data.events.size(); i < c; ++i) {
+            if (types.at(i) != offCpuCostId) {
+                continue;
+            }
+            const auto stackId = stackIds.at(i);
+            const auto isSelected = selectedStacks.contains(stackId);
+            if (!isSelected && !hoveredStacks.contains(stackId)) {
+                continue;
+            }
+            const auto x = data.mapTimeToX(times.at(i));
+            const auto x2 = data.mapTimeToX(times.at(i) + costs.at(i));
+            painter->fillRect(x, 0, x2 - x, data.h, isSelected ? colors.offCpuSelected : colors.offCpuHovered);
+        }
+    }
+
+    // the events of a run share their type and stack, so whole runs get skipped at once
+    data.events.forEachRun(
+        [&](const Data::EventRun& run) {
+            if (times.at(run.first) > data.time.end) {
+                return false;
+            }
+            if (run.type != eventType) {
+                return true;
+            }
+            if (selectedStacks.contains(run.stackId)) {
+                painter->setPen(colors.selectedPen);
+            } else if (hoveredStacks.contains(run.stackId)) {
+                painter->setPen(colors.hoveredPen);
+            } else {
+                return true;
+            }
+            for (qsizetype i = run.first, end = run.first + run.count; i < end; ++i) {
+                const auto time = times.at(i);
+                if (time > data.time.end) {
+                    return false;
+                }
+                const auto x = data.mapTimeToX(time);
+                if (x >= TimeLineData::padding && x < data.w) {
+                    painter->drawLine(x, 0, x, data.h);
+                }
+            }
+            return true;
+        },
+        data.events.lowerBound(data.time.start));
+}
 }
 
+// caches the rendered rows of the timeline, which get painted on the global ThreadWeaver queue
+class TimeLineTileCache : public QObject
+{
+public:
+    explicit TimeLineTileCache(QWidget* viewport)
+        : m_viewport(viewport)
+    {
+        m_tiles.setMaxCost(MaxCost);
+    }
+
+    void setViewport(QWidget* viewport)
+    {
+        m_viewport = viewport;
+    }
+
+    const QImage* find(const TimeLineTileKey& key) const
+    {
+        return m_tiles.object(key);
+    }
+
+    void insert(const TimeLineTileKey& key, const QImage& tile)
+    {
+        m_pending.remove(key);
+        m_tiles.insert(key, new QImage(tile), std::max(1, static_cast<int>(tile.sizeInBytes() / 1024)));
+    }
+
+    void schedule(const TimeLineTileKey& key, TimeLineTile tile, const TimeLineColors& colors)
+    {
+        if (m_pending.contains(key)) {
+            return;
+        }
+        m_pending.insert(key);
+
+        // the time line stays blank until its tiles got painted
+        JobScheduler::run(JobScheduler::Priority::Interactive, [context = QPointer<TimeLineTileCache>(this), key,
+                                                                tile = std::move(tile), colors]() {
+            auto image = renderTile(tile, colors, key);
+            if (!context) {
+                return;
+            }
+            QMetaObject::invokeMethod(
+                context.data(),
+                [context, key, image = std::move(image)]() {
+                    if (context) {
+                        context->insert(key, image);
+                        if (context->m_viewport) {
+                            context->m_viewport->update();
+                        }
+                    }
+                },
+                Qt::QueuedConnection);
+        });
+    }
+
+private:
+    // in KiB
+    static const constexpr int MaxCost = 256 * 1024;
+
+    QPointer<QWidget> m_viewport;
+    QCache<TimeLineTileKey, QImage> m_tiles;
+    QSet<TimeLineTileKey> m_pending;
+};
+
 TimeLineDelegate::TimeLineDelegate(FilterAndZoomStack* filterAndZoomStack, QAbstractItemView* view, QObject* parent)
     : QStyledItemDelegate(parent)
     , m_filterAndZoomStack(filterAndZoomStack)
     , m_view(view)
+    , m_tileCache(std::make_unique<TimeLineTileCache>(view->viewport()))
 {
     m_view->viewport()->installEventFilter(this);
     m_view->viewport()->setAttribute(Qt::WA_Hover);
@@ -157,15 +542,57 @@ TimeLineDelegate::~TimeLineDelegate() = default;
 void TimeLineDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
 {
     const auto data = dataFromIndex(index, option.rect, m_filterAndZoomStack->zoom());
-    const auto results = index.data(EventModel::EventResultsRole).value<Data::EventResults>();
-    const auto offCpuCostId = results.offCpuTimeCostId;
-    const auto lostEventCostId = results.lostEventCostId;
+    const auto offCpuCostId = index.data(EventModel::OffCpuCostIdRole).toInt();
+    const auto lostEventCostId = index.data(EventModel::LostEventCostIdRole).toInt();
+    const auto isAggregate = index.data(EventModel::IsAggregateRole).toBool();
+    const auto isCpu = index.data(EventModel::CpuIdRole).value<quint32>() != Data::INVALID_CPU_ID;
+    const auto isHeatmap = m_cpuHeatmap && isCpu;
     const bool is_alternate = option.features & QStyleOptionViewItem::Alternate;
-    const auto& palette = option.palette;
-
-    painter->fillRect(option.rect, is_alternate ? palette.base() : palette.alternateBase());
+    const auto colors = TimeLineColors(option.palette, is_alternate);
+
+    TimeLineTileKey key;
+    key.row = index.data(EventModel::RowKeyRole).value<quint64>();
+    key.time = data.time;
+    key.size = option.rect.size();
+    key.eventType = m_eventType;
+    key.isAlternate = is_alternate;
+    key.isHeatmap = isHeatmap;
+    key.devicePixelRatio = painter->device()->devicePixelRatioF();
+
+    auto makeTile = [&]() {
+        TimeLineTile tile;
+        tile.data = data;
+        tile.eventType = m_eventType;
+        tile.offCpuCostId = offCpuCostId;
+        tile.lostEventCostId = lostEventCostId;
+        tile.isAggregate = isAggregate;
+        tile.isHeatmap = isHeatmap;
+        return tile;
+    };
+
+    if (const auto* cached = m_tileCache->find(key)) {
+        painter->drawImage(option.rect.topLeft(), *cached);
+    } else if (data.events.size() < TimeLineMipmap::MinEvents && !isAggregate && !isHeatmap) {
+        // small rows are cheap enough to render right away
+        const auto image = renderTile(makeTile(), colors, key);
+        painter->drawImage(option.rect.topLeft(), image);
+        m_tileCache->insert(key, image);
+    } else {
+        // paint the plain background until the events got rendered off the GUI thread
+        painter->fillRect(option.rect, colors.background);
+        // the model builds the mipmaps in the background and tells us once they are ready
+        const auto mipmaps = index.data(EventModel::MipmapsRole);
+        if (mipmaps.isValid()) {
+            auto tile = makeTile();
+            tile.mipmaps = mipmaps.value<QVector<TimeLineMipmap>>();
+            if (isHeatmap) {
+                tile.heatmapMaxCounts =
+                    index.data(EventModel::HeatmapMaxCountsRole).value<QVector<QVector<quint32>>>().value(m_eventType);
+            }
+            m_tileCache->schedule(key, std::move(tile), colors);
+        }
+    }
 
-    // skip threads that are outside the visible (zoomed) region
     painter->save();
 
     // transform into target coordinate system
@@ -173,87 +600,29 @@ void TimeLineDelegate::paint(QPainter* painter, const QStyleOptionViewItem& opti
     // account for padding
     painter->translate(TimeLineData::padding, TimeLineData::padding);
 
-    // visualize the time where the thread was active
-    // i.e. paint events for threads that have any in the selected time range
-    auto threadTimeRect =
-        QRect(QPoint(data.mapTimeToX(data.threadTime.start), 0), QPoint(data.mapTimeToX(data.threadTime.end), data.h));
-    if (threadTimeRect.left() < option.rect.width() && threadTimeRect.right() > 0) {
-        if (threadTimeRect.left() < 0)
-            threadTimeRect.setLeft(0);
-        if (threadTimeRect.right() > option.rect.width())
-            threadTimeRect.setRight(option.rect.width());
-
-        const auto scheme = KColorScheme(palette.currentColorGroup());
+    // the selection changes often, so it is painted live on top of the cached tile
+    paintSelection(painter, data, colors, m_eventType, offCpuCostId, m_selectedStacks, m_hoveredStacks);
 
-        auto runningColor = scheme.background(KColorScheme::PositiveBackground).color();
-        runningColor.setAlpha(128);
-        auto runningOutlineColor = scheme.foreground(KColorScheme::PositiveText).color();
-        runningOutlineColor.setAlpha(128);
-        painter->setBrush(QBrush(runningColor));
-        painter->setPen(QPen(runningOutlineColor, 1));
-        painter->drawRect(threadTimeRect.adjusted(-1, -1, 0, 0));
-
-        // visualize all events
-        painter->setBrush({});
-
-        if (offCpuCostId != -1) {
-            const auto offCpuColor = scheme.background(KColorScheme::NegativeBackground).color();
-            const auto offCpuColorSelected = scheme.foreground(KColorScheme::NegativeText).color();
-            const auto offCpuColorHovered = toHoverColor(offCpuColorSelected);
-            for (const auto& event : data.events) {
-                if (event.type != offCpuCostId) {
-                    continue;
-                }
-
-                const auto x = data.mapTimeToX(event.time);
-                const auto x2 = data.mapTimeToX(event.time + event.cost);
-                const auto& color = m_selectedStacks.contains(event.stackId)
-                    ? offCpuColorSelected
-                    : (m_hoveredStacks.contains(event.stackId) ? offCpuColorHovered : offCpuColor);
-                painter->fillRect(x, 0, x2 - x, data.h, color);
-            }
+    if (isHeatmap && index.row() > 0) {
+        // the rows are sorted by NUMA node, separate the nodes
+        const auto numaNode = index.data(EventModel::NumaNodeRole).toInt();
+        if (numaNode != index.sibling(index.row() - 1, index.column()).data(EventModel::NumaNodeRole).toInt()) {
+            painter->setPen(colors.numaSeparatorPen);
+            painter->drawLine(-TimeLineData::padding, -TimeLineData::padding, data.w, -TimeLineData::padding);
         }
+    }
 
-        const auto selectedPen = QPen(scheme.foreground(KColorScheme::ActiveText), 1);
-        const auto hoveredPen = QPen(toHoverColor(selectedPen.color()), 1);
-        const auto eventPen = QPen(scheme.foreground(KColorScheme::NeutralText), 1);
-        const auto lostEventPen = QPen(scheme.foreground(KColorScheme::NegativeText), 1);
-
-        int last_x = -1;
-        // TODO: accumulate cost for events that fall to the same pixel somehow
-        // but how to then sync the y scale across different delegates?
-        // somehow deduce threshold via min time delta and max cost?
-        // TODO: how to deal with broken cycle counts in frequency mode? For now,
-        // we simply always fill the complete height which is also what we'd get
-        // from a graph in count mode (perf record -F vs. perf record -c)
-        // see also: https://www.spinics.net/lists/linux-perf-users/msg03486.html
-        for (const auto& event : data.events) {
-            const auto isLostEvent = event.type == lostEventCostId;
-            if (event.type != m_eventType && !isLostEvent) {
-                continue;
-            }
-
-            const auto x = data.mapTimeToX(event.time);
-            if (x < TimeLineData::padding || x >= data.w) {
-                continue;
-            }
-
-            // only draw a line when it changes anything visually
-            // but always force drawing of lost events
-            if (x != last_x || isLostEvent) {
-                if (isLostEvent)
-                    painter->setPen(lostEventPen);
-                else if (m_selectedStacks.contains(event.stackId))
-                    painter->setPen(selectedPen);
-                else if (m_hoveredStacks.contains(event.stackId))
-                    painter->setPen(hoveredPen);
-                else
-                    painter->setPen(eventPen);
-
-                painter->drawLine(x, 0, x, data.h);
-            }
-
-            last_x = x;
+    if (lostEventCostId != -1 && isCpu) {
+        // the lost events are stored once for all CPUs, overlay them on every CPU row
+        const auto results = index.data(EventModel::EventResultsRole).value<Data::EventResults>();
+        const auto range = results.lostEventsInRange(data.time);
+        auto color = colors.lostEventPen.color();
+        color.setAlpha(128);
+        for (auto i = range.first; i < range.second; ++i) {
+            const auto& window = results.lostEvents[i];
+            const auto x = std::max(data.mapTimeToX(window.time.start), 0);
+            const auto x2 = std::min(data.mapTimeToX(window.time.end), data.w);
+            painter->fillRect(x, 0, std::max(1, x2 - x), data.h, color);
         }
     }
 
@@ -265,7 +634,7 @@ void TimeLineDelegate::paint(QPainter* painter, const QStyleOptionViewItem& opti
         // undo vertical padding manually to fill complete height
         const auto timeSlice = QRect(startX, -TimeLineData::padding, endX - startX, option.rect.height());
 
-        auto brush = palette.highlight();
+        auto brush = option.palette.highlight();
         auto color = brush.color();
         color.setAlpha(128);
         brush.setColor(color);
@@ -283,7 +652,7 @@ bool TimeLineDelegate::helpEvent(QHelpEvent* event, QAbstractItemView* view, con
         const auto localX = event->pos().x();
         const auto mappedX = localX - option.rect.x() - TimeLineData::padding;
         const auto time = data.mapXToTime(mappedX);
-        const auto start = findEvent(data.events.constBegin(), data.events.constEnd(), time);
+        const auto searchIndex = index.data(EventModel::SearchIndexRole).value<TimeLineSearchIndex>();
         const auto results = index.data(EventModel::EventResultsRole).value<Data::EventResults>();
         // find the maximum sample cost in the range spanned by one pixel
         struct FoundSamples
@@ -298,7 +667,7 @@ bool TimeLineDelegate::helpEvent(QHelpEvent* event, QAbstractItemView* view, con
         auto findSamples = [&](int costType, bool contains) -> FoundSamples {
             FoundSamples ret;
             ret.type = costType;
-            data.findSamples(mappedX, costType, results.lostEventCostId, contains, start,
+            data.findSamples(mappedX, costType, results.lostEventCostId, contains, searchIndex,
                              [&ret](const Data::Event& event, bool isLost) {
                                  if (isLost) {
                                      ++ret.numLost;
@@ -316,6 +685,13 @@ bool TimeLineDelegate::helpEvent(QHelpEvent* event, QAbstractItemView* view, con
             // check whether we are hovering an off-CPU area
             found = findSamples(results.offCpuTimeCostId, true);
         }
+        if (!found.numLost && index.data(EventModel::CpuIdRole).value<quint32>() != Data::INVALID_CPU_ID) {
+            // the CPU rows don't contain the lost events, see EventResults::lostEvents
+            if (const auto* lost = results.lostEventsAt(time)) {
+                found.numLost = lost->chunks;
+                found.totalLost = lost->lost;
+            }
+        }
 
         const auto formattedTime = Util::formatTimeString(time - data.time.start);
         const auto totalCosts = index.data(EventModel::TotalCostsRole).value<QVector<Data::CostSummary>>();
@@ -325,11 +701,34 @@ bool TimeLineDelegate::helpEvent(QHelpEvent* event, QAbstractItemView* view, con
                 tr("time: %1\nlost chunks: %2\nlost events: %3")
                     .arg(formattedTime, QString::number(found.numLost), QString::number(found.totalLost)));
         } else if (found.numSamples > 0 && found.type == results.offCpuTimeCostId) {
-            QToolTip::showText(event->globalPos(),
-                               tr("time: %1\nsched switches: %2\ntotal off-CPU time: %3\nlongest sched switch: %4")
-                                   .arg(formattedTime, QString::number(found.numSamples),
-                                        Util::formatTimeString(found.totalCost),
-                                        Util::formatTimeString(found.maxCost)));
+            auto text = tr("time: %1\nsched switches: %2\ntotal off-CPU time: %3\nlongest sched switch: %4")
+                            .arg(formattedTime, QString::number(found.numSamples),
+                                 Util::formatTimeString(found.totalCost), Util::formatTimeString(found.maxCost));
+            const auto threadId = index.data(EventModel::ThreadIdRole).value<qint32>();
+            const auto* span = m_wakeupGraph ? m_wakeupGraph->blockedAt(threadId, time) : nullptr;
+            if (span && span->wakeup != -1) {
+                auto threadName = [&results](qint32 tid) {
+                    auto isThread = [tid](const Data::ThreadEvents& thread) { return thread.tid == tid; };
+                    auto thread = std::find_if(results.threads.begin(), results.threads.end(), isThread);
+                    return thread != results.threads.end() ? thread->name : tr("unknown");
+                };
+                const auto& wakeup = m_wakeupGraph->wakeups()[span->wakeup];
+                text += tr("\nwoken up by: %1 (%2)\nwakeup latency: %3")
+                            .arg(threadName(wakeup.wakerTid), QString::number(wakeup.wakerTid),
+                                 Util::formatTimeString(span->time.end - wakeup.time));
+
+                // what the thread waited for, the most recent steps are the most relevant ones
+                const auto path = m_wakeupGraph->criticalPath(threadId, span->time.end);
+                const auto numSteps = std::min<int>(path.size(), MaxCriticalPathSteps);
+                QStringList steps;
+                for (auto it = path.end() - numSteps; it != path.end(); ++it) {
+                    steps.append(tr("%1 (%2): %3")
+                                     .arg(threadName(it->tid), QString::number(it->tid),
+                                          Util::formatTimeString(it->time.delta())));
+                }
+                text += tr("\ncritical path:\n%1").arg(steps.join(QLatin1Char('\n')));
+            }
+            QToolTip::showText(event->globalPos(), text);
         } else if (found.numSamples > 0) {
             QToolTip::showText(event->globalPos(),
                                tr("time: %1\n%5 samples: %2\ntotal sample cost: %3\nmax sample cost: %4")
@@ -382,14 +781,14 @@ bool TimeLineDelegate::eventFilter(QObject* watched, QEvent* event)
         stacks.reserve(m_hoveredStacks.size());
         if (inEventsColumn && event->type() != QEvent::HoverLeave) {
             const auto results = alwaysValidIndex.data(EventModel::EventResultsRole).value<Data::EventResults>();
-            const auto data = dataFromIndex(m_view->indexAt(pos.toPoint()), visualRect, zoom);
+            const auto hoveredIndex = m_view->indexAt(pos.toPoint());
+            const auto data = dataFromIndex(hoveredIndex, visualRect, zoom);
+            const auto searchIndex = hoveredIndex.data(EventModel::SearchIndexRole).value<TimeLineSearchIndex>();
             const auto hoverX = pos.x() - visualRect.left() - TimeLineData::padding;
 
-            const auto time = data.mapXToTime(pos.x() - visualRect.left() - TimeLineData::padding);
-            const auto start = findEvent(data.events.constBegin(), data.events.constEnd(), time);
             auto findSamples = [&](int costType, bool contains) {
                 bool foundAny = false;
-                data.findSamples(hoverX, costType, results.lostEventCostId, contains, start,
+                data.findSamples(hoverX, costType, results.lostEventCostId, contains, searchIndex,
                                  [&](const Data::Event& event, bool isLost) {
                                      foundAny = true;
                                      if (isLost || event.stackId == -1)
@@ -457,6 +856,17 @@ bool TimeLineDelegate::eventFilter(QObject* watched, QEvent* event)
         const auto isMainThread = threadStartTime == minTime && threadEndTime == maxTime;
         const auto cpuId = index.data(EventModel::CpuIdRole).value<quint32>();
         const auto numCpus = index.data(EventModel::NumCpusRole).value<uint>();
+
+        // start computing the filter in the background while its entry is hovered, it's likely to get applied next
+        auto hintOnHover = [this](QAction* action, const Data::FilterAction& filter) {
+            connect(action, &QAction::hovered, this, [this, filter]() { m_filterAndZoomStack->hintFilter(filter); });
+        };
+        auto timeFilter = [](Data::TimeRange time) {
+            Data::FilterAction filter;
+            filter.time = time.normalized();
+            return filter;
+        };
+
         if (isTimeSpanSelected && (minTime != timeSlice.start || maxTime != timeSlice.end)) {
             contextMenu->addAction(QIcon::fromTheme(QStringLiteral("zoom-in")), tr("Zoom In On Selection"), this,
                                    [this, timeSlice]() { m_filterAndZoomStack->zoomIn(timeSlice); });
@@ -482,45 +892,72 @@ bool TimeLineDelegate::eventFilter(QObject* watched, QEvent* event)
 
         if (isTimeSpanSelected
             && (!isFiltered || filter.time.end != timeSlice.start || filter.time.end != timeSlice.end)) {
-            contextMenu->addAction(QIcon::fromTheme(QStringLiteral("kt-add-filters")), tr("Filter In On Selection"),
-                                   this, [this, timeSlice]() { m_filterAndZoomStack->filterInByTime(timeSlice); });
+            auto action = contextMenu->addAction(
+                QIcon::fromTheme(QStringLiteral("kt-add-filters")), tr("Filter In On Selection"), this,
+                [this, timeSlice]() { m_filterAndZoomStack->filterInByTime(timeSlice); });
+            hintOnHover(action, timeFilter(timeSlice));
         }
 
         if (isRightButtonEvent && index.isValid() && numThreads > 1 && threadId != Data::INVALID_TID) {
             if ((!isFiltered && !isMainThread)
                 || (isFiltered && filter.time.end != threadStartTime && filter.time.end != threadEndTime)) {
-                contextMenu->addAction(QIcon::fromTheme(QStringLiteral("kt-add-filters")),
-                                       tr("Filter In On Thread #%1 By Time").arg(threadId), this,
-                                       [this, threadStartTime, threadEndTime]() {
-                                           m_filterAndZoomStack->filterInByTime({threadStartTime, threadEndTime});
-                                       });
+                auto action = contextMenu->addAction(QIcon::fromTheme(QStringLiteral("kt-add-filters")),
+                                                     tr("Filter In On Thread #%1 By Time").arg(threadId), this,
+                                                     [this, threadStartTime, threadEndTime]() {
+                                                         m_filterAndZoomStack->filterInByTime(
+                                                             {threadStartTime, threadEndTime});
+                                                     });
+                hintOnHover(action, timeFilter({threadStartTime, threadEndTime}));
             }
             if ((!isFiltered || filter.threadId == Data::INVALID_TID)) {
-                contextMenu->addAction(QIcon::fromTheme(QStringLiteral("kt-add-filters")),
-                                       tr("Filter In On Thread #%1").arg(threadId), this,
-                                       [this, threadId]() { m_filterAndZoomStack->filterInByThread(threadId); });
-                contextMenu->addAction(QIcon::fromTheme(QStringLiteral("kt-add-filters")),
-                                       tr("Exclude Thread #%1").arg(threadId), this,
-                                       [this, threadId]() { m_filterAndZoomStack->filterOutByThread(threadId); });
+                Data::FilterAction threadFilter;
+                threadFilter.threadId = threadId;
+                hintOnHover(contextMenu->addAction(
+                                QIcon::fromTheme(QStringLiteral("kt-add-filters")),
+                                tr("Filter In On Thread #%1").arg(threadId), this,
+                                [this, threadId]() { m_filterAndZoomStack->filterInByThread(threadId); }),
+                            threadFilter);
+                Data::FilterAction excludeThreadFilter;
+                excludeThreadFilter.excludeThreadIds.push_back(threadId);
+                hintOnHover(contextMenu->addAction(
+                                QIcon::fromTheme(QStringLiteral("kt-add-filters")),
+                                tr("Exclude Thread #%1").arg(threadId), this,
+                                [this, threadId]() { m_filterAndZoomStack->filterOutByThread(threadId); }),
+                            excludeThreadFilter);
             }
             if (numProcesses > 1
                 && (!isFiltered || (filter.processId == Data::INVALID_PID && filter.threadId == Data::INVALID_TID))) {
-                contextMenu->addAction(QIcon::fromTheme(QStringLiteral("kt-add-filters")),
-                                       tr("Filter In On Process #%1").arg(processId), this,
-                                       [this, processId]() { m_filterAndZoomStack->filterInByProcess(processId); });
-                contextMenu->addAction(QIcon::fromTheme(QStringLiteral("kt-add-filters")),
-                                       tr("Exclude Process #%1").arg(processId), this,
-                                       [this, processId]() { m_filterAndZoomStack->filterOutByProcess(processId); });
+                Data::FilterAction processFilter;
+                processFilter.processId = processId;
+                hintOnHover(contextMenu->addAction(
+                                QIcon::fromTheme(QStringLiteral("kt-add-filters")),
+                                tr("Filter In On Process #%1").arg(processId), this,
+                                [this, processId]() { m_filterAndZoomStack->filterInByProcess(processId); }),
+                            processFilter);
+                Data::FilterAction excludeProcessFilter;
+                excludeProcessFilter.excludeProcessIds.push_back(processId);
+                hintOnHover(contextMenu->addAction(
+                                QIcon::fromTheme(QStringLiteral("kt-add-filters")),
+                                tr("Exclude Process #%1").arg(processId), this,
+                                [this, processId]() { m_filterAndZoomStack->filterOutByProcess(processId); }),
+                            excludeProcessFilter);
             }
         }
 
         if (isRightButtonEvent && index.isValid() && cpuId != Data::INVALID_CPU_ID && numCpus > 1
             && (!isFiltered || filter.cpuId != cpuId)) {
-            contextMenu->addAction(QIcon::fromTheme(QStringLiteral("kt-add-filters")),
-                                   tr("Filter In On CPU #%1").arg(cpuId), this,
-                                   [this, cpuId]() { m_filterAndZoomStack->filterInByCpu(cpuId); });
-            contextMenu->addAction(QIcon::fromTheme(QStringLiteral("kt-add-filters")), tr("Exclude CPU #%1").arg(cpuId),
-                                   this, [this, cpuId]() { m_filterAndZoomStack->filterOutByCpu(cpuId); });
+            Data::FilterAction cpuFilter;
+            cpuFilter.cpuId = cpuId;
+            hintOnHover(contextMenu->addAction(QIcon::fromTheme(QStringLiteral("kt-add-filters")),
+                                               tr("Filter In On CPU #%1").arg(cpuId), this,
+                                               [this, cpuId]() { m_filterAndZoomStack->filterInByCpu(cpuId); }),
+                        cpuFilter);
+            Data::FilterAction excludeCpuFilter;
+            excludeCpuFilter.excludeCpuIds.push_back(cpuId);
+            hintOnHover(contextMenu->addAction(QIcon::fromTheme(QStringLiteral("kt-add-filters")),
+                                               tr("Exclude CPU #%1").arg(cpuId), this,
+                                               [this, cpuId]() { m_filterAndZoomStack->filterOutByCpu(cpuId); }),
+                        excludeCpuFilter);
         }
 
         if (isRightButtonEvent && isFiltered) {
@@ -542,8 +979,8 @@ bool TimeLineDelegate::eventFilter(QObject* watched, QEvent* event)
         QSet<qint32> threads;
         QSet<qint32> processes;
         for (const auto& thread : data.threads) {
-            const auto start = findEvent(thread.events.begin(), thread.events.end(), timeSlice.start);
-            const auto end = findEvent(start, thread.events.end(), timeSlice.end);
+            const auto start = findEvent(thread.events, thread.events.begin(), timeSlice.start);
+            const auto end = findEvent(thread.events, start, timeSlice.end);
             if (start != end) {
                 threads.insert(thread.tid);
                 processes.insert(thread.pid);
@@ -577,12 +1014,31 @@ void TimeLineDelegate::setEventType(int type)
     updateView();
 }
 
+void TimeLineDelegate::setCpuHeatmap(bool cpuHeatmap)
+{
+    m_cpuHeatmap = cpuHeatmap;
+    updateView();
+}
+
 void TimeLineDelegate::setSelectedStacks(const QSet<qint32>& selectedStacks)
 {
     m_selectedStacks = selectedStacks;
     updateView();
 }
 
+void TimeLineDelegate::setWakeupGraph(std::shared_ptr<const WakeupGraph> wakeupGraph)
+{
+    m_wakeupGraph = std::move(wakeupGraph);
+}
+
+void TimeLineDelegate::viewportChanged()
+{
+    m_view->viewport()->installEventFilter(this);
+    m_view->viewport()->setAttribute(Qt::WA_Hover);
+    m_tileCache->setViewport(m_view->viewport());
+    updateView();
+}
+
 void TimeLineDelegate::updateView()
 {
     m_view->viewport()->update();
@@ -12,10 +12,15 @@
 
 #include "data.h"
 
+#include <memory>
+
 class QAbstractItemView;
 class QAction;
 
 class FilterAndZoomStack;
+class TimeLineSearchIndex;
+class TimeLineTileCache;
+class WakeupGraph;
 
 struct TimeLineData
 {
@@ -31,9 +36,11 @@ struct TimeLineData
 
     void zoom(Data::TimeRange time);
 
+    // calls @p callback for the samples of @p costType and the lost events at the given x coordinate
+    // with @p contains, the samples span from their time to their time plus cost, e.g. for the off-CPU time
     template<typename Callback>
     void findSamples(int mappedX, int costType, int lostEventCostId, bool contains,
-                     const Data::Events::const_iterator& start, const Callback& callback) const;
+                     const TimeLineSearchIndex& searchIndex, const Callback& callback) const;
 
     static const constexpr int padding = 2;
     Data::Events events;
@@ -60,7 +67,13 @@ public:
                    const QModelIndex& index) override;
 
     void setEventType(int type);
+    // shade the CPU rows by how many events their time spans have, relative to the busiest CPU, instead of
+    // drawing every event. the CPUs of a NUMA node get separated from the ones of the next node
+    void setCpuHeatmap(bool cpuHeatmap);
     void setSelectedStacks(const QSet<qint32>& selectedStacks);
+    void setWakeupGraph(std::shared_ptr<const WakeupGraph> wakeupGraph);
+    // must be called after the view got a new viewport, e.g. to switch to hardware acceleration
+    void viewportChanged();
 
 signals:
     void stacksHovered(const QSet<qint32>& stacks);
@@ -78,4 +91,7 @@ private:
     QSet<qint32> m_selectedStacks;
     QSet<qint32> m_hoveredStacks;
     int m_eventType = 0;
+    bool m_cpuHeatmap = false;
+    std::unique_ptr<TimeLineTileCache> m_tileCache;
+    std::shared_ptr<const WakeupGraph> m_wakeupGraph;
 };
@@ -0,0 +1,126 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "timelinemipmap.h"
+
+#include <algorithm>
+
+QVector<TimeLineMipmap> TimeLineMipmap::build(const Data::Events& events, int numCostTypes, Data::TimeRange time)
+{
+    if (events.size() < MinEvents || time.isEmpty()) {
+        return QVector<TimeLineMipmap>(numCostTypes);
+    }
+
+    Merger merger(numCostTypes, time);
+    merger.add(events);
+    return merger.result();
+}
+
+TimeLineMipmap::Merger::Merger(int numCostTypes, Data::TimeRange time)
+    : m_time(time)
+    , m_firstLevels(numCostTypes)
+{
+    if (time.isEmpty()) {
+        return;
+    }
+
+    // use power-of-two bin widths, such that the levels line up with each other
+    while (time.delta() / m_binWidth >= static_cast<quint64>(MaxBins)) {
+        m_binWidth *= 2;
+    }
+    m_numBins = static_cast<qsizetype>(time.delta() / m_binWidth + 1);
+}
+
+void TimeLineMipmap::Merger::add(const QVector<TimeLineMipmap>& mipmaps)
+{
+    for (int type = 0, c = std::min(mipmaps.size(), m_firstLevels.size()); type < c; ++type) {
+        const auto& mipmap = mipmaps.at(type);
+        if (mipmap.isEmpty()) {
+            continue;
+        }
+        Q_ASSERT(mipmap.m_start == m_time.start && mipmap.m_binWidth == m_binWidth);
+
+        auto& level = m_firstLevels[type];
+        if (level.isEmpty()) {
+            level = mipmap.m_levels.first();
+            continue;
+        }
+        const auto& bins = mipmap.m_levels.first();
+        for (qsizetype i = 0, numBins = bins.size(); i < numBins; ++i) {
+            level[i].cost += bins.at(i).cost;
+            level[i].count += bins.at(i).count;
+        }
+    }
+}
+
+void TimeLineMipmap::Merger::add(const Data::Events& events)
+{
+    if (m_numBins == 0) {
+        return;
+    }
+
+    const auto numCostTypes = m_firstLevels.size();
+    const auto& times = events.times();
+    // the events of a run share their type and cost, only the times get looked at individually
+    events.forEachRun([&](const Data::EventRun& run) {
+        if (run.type < 0 || run.type >= numCostTypes) {
+            return true;
+        }
+        auto& level = m_firstLevels[run.type];
+        for (qsizetype i = run.first, end = run.first + run.count; i < end; ++i) {
+            const auto eventTime = times.at(i);
+            if (!m_time.contains(eventTime)) {
+                continue;
+            }
+            if (level.isEmpty()) {
+                level.resize(m_numBins);
+            }
+            auto& bin = level[(eventTime - m_time.start) / m_binWidth];
+            bin.cost += run.cost;
+            ++bin.count;
+        }
+        return true;
+    });
+}
+
+QVector<TimeLineMipmap> TimeLineMipmap::Merger::result() const
+{
+    QVector<TimeLineMipmap> ret(m_firstLevels.size());
+    for (int type = 0, c = m_firstLevels.size(); type < c; ++type) {
+        if (m_firstLevels.at(type).isEmpty()) {
+            continue;
+        }
+
+        auto& mipmap = ret[type];
+        mipmap.m_start = m_time.start;
+        mipmap.m_binWidth = m_binWidth;
+        mipmap.m_levels.push_back(m_firstLevels.at(type));
+        while (mipmap.m_levels.last().size() > 1) {
+            const auto& previous = mipmap.m_levels.last();
+            QVector<Bin> level((previous.size() + 1) / 2);
+            for (qsizetype i = 0, c = previous.size(); i < c; ++i) {
+                auto& bin = level[i / 2];
+                bin.cost += previous.at(i).cost;
+                bin.count += previous.at(i).count;
+            }
+            mipmap.m_levels.push_back(std::move(level));
+        }
+    }
+
+    return ret;
+}
+
+int TimeLineMipmap::levelForBinWidth(double binWidth) const
+{
+    if (m_levels.isEmpty() || binWidth < m_binWidth) {
+        return -1;
+    }
+    int level = 0;
+    while (level + 1 < m_levels.size() && static_cast<double>(m_binWidth << (level + 1)) <= binWidth) {
+        ++level;
+    }
+    return level;
+}
@@ -0,0 +1,91 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QVector>
+
+#include "data.h"
+
+// pre-aggregated cost histograms of the events of one timeline row and one cost type
+// level 0 has the finest resolution, every following level merges two bins of the previous one.
+// this allows painting a row in time proportional to its width instead of its number of events
+class TimeLineMipmap
+{
+public:
+    struct Bin
+    {
+        quint64 cost = 0;
+        quint32 count = 0;
+    };
+
+    // the maximum number of bins on level 0
+    static const constexpr qint64 MaxBins = 2048;
+    // rows with fewer events are cheap enough to paint directly
+    static const constexpr qsizetype MinEvents = 4 * MaxBins;
+
+    TimeLineMipmap() = default;
+
+    // returns one mipmap per cost type, empty for types without events or rows with few events
+    static QVector<TimeLineMipmap> build(const Data::Events& events, int numCostTypes, Data::TimeRange time);
+
+    // sums up several rows into the mipmaps of one aggregated row, e.g. of all threads of a process
+    // the mipmaps of the rows have to be built for the same time range, the rows without them get binned instead
+    class Merger
+    {
+    public:
+        Merger(int numCostTypes, Data::TimeRange time);
+
+        void add(const QVector<TimeLineMipmap>& mipmaps);
+        void add(const Data::Events& events);
+
+        // unlike build, this returns mipmaps for all types with events, no matter how few there are
+        QVector<TimeLineMipmap> result() const;
+
+    private:
+        Data::TimeRange m_time;
+        quint64 m_binWidth = 1;
+        qsizetype m_numBins = 0;
+        // the first level per cost type, empty for types without events
+        QVector<QVector<Bin>> m_firstLevels;
+    };
+
+    bool isEmpty() const
+    {
+        return m_levels.isEmpty();
+    }
+
+    // the coarsest level whose bins are not wider than @p binWidth, or -1 when already level 0 is wider
+    int levelForBinWidth(double binWidth) const;
+
+    int numLevels() const
+    {
+        return m_levels.size();
+    }
+
+    quint64 start() const
+    {
+        return m_start;
+    }
+
+    quint64 binWidth(int level) const
+    {
+        return m_binWidth << level;
+    }
+
+    const QVector<Bin>& bins(int level) const
+    {
+        return m_levels.at(level);
+    }
+
+private:
+    quint64 m_start = 0;
+    quint64 m_binWidth = 1;
+    QVector<QVector<Bin>> m_levels;
+};
+
+Q_DECLARE_TYPEINFO(TimeLineMipmap::Bin, Q_PRIMITIVE_TYPE);
+Q_DECLARE_METATYPE(QVector<TimeLineMipmap>)
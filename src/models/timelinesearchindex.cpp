@@ -0,0 +1,45 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "timelinesearchindex.h"
+
+TimeLineSearchIndex TimeLineSearchIndex::build(const Data::Events& events, int numCostTypes, int spanCostId)
+{
+    TimeLineSearchIndex ret;
+    ret.m_events.resize(numCostTypes);
+    ret.m_spanCostId = spanCostId;
+
+    const auto& types = events.types();
+    QVector<qint32> counts(numCostTypes, 0);
+    for (auto type : types) {
+        if (type >= 0 && type < numCostTypes) {
+            ++counts[type];
+        }
+    }
+    for (int type = 0; type < numCostTypes; ++type) {
+        ret.m_events[type].reserve(counts.at(type));
+    }
+    for (qint32 i = 0, c = events.size(); i < c; ++i) {
+        const auto type = types.at(i);
+        if (type >= 0 && type < numCostTypes) {
+            ret.m_events[type].push_back(i);
+        }
+    }
+
+    if (spanCostId >= 0 && spanCostId < numCostTypes) {
+        const auto& times = events.times();
+        const auto& costs = events.costs();
+        const auto& spans = ret.m_events.at(spanCostId);
+        ret.m_spanEnds.reserve(spans.size());
+        quint64 spanEnd = 0;
+        for (auto i : spans) {
+            spanEnd = std::max(spanEnd, times.at(i) + costs.at(i));
+            ret.m_spanEnds.push_back(spanEnd);
+        }
+    }
+
+    return ret;
+}
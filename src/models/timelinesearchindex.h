@@ -0,0 +1,86 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QVector>
+
+#include "data.h"
+
+#include <algorithm>
+
+// the events of one timeline row grouped by cost type, to find the events below the mouse
+// the lookups take logarithmic time, no matter how many events of other types lie in between
+class TimeLineSearchIndex
+{
+public:
+    TimeLineSearchIndex() = default;
+
+    // @p spanCostId is the cost type whose events span from their time to their time plus cost, e.g. off-CPU time
+    static TimeLineSearchIndex build(const Data::Events& events, int numCostTypes, int spanCostId);
+
+    bool isEmpty() const
+    {
+        return m_events.isEmpty();
+    }
+
+    // the indices of the events of @p type in @p events, ordered by time like the events themselves
+    QVector<qint32> events(int type) const
+    {
+        return m_events.value(type);
+    }
+
+    // calls @p callback with every event of @p type for which @p map returns @p x
+    // @p map has to be monotonic, e.g. mapping the time to a pixel
+    template<typename Map, typename Callback>
+    void forEachEventAt(const Data::Events& events, int type, int x, const Map& map, const Callback& callback) const
+    {
+        if (type < 0 || type >= m_events.size()) {
+            return;
+        }
+        const auto& times = events.times();
+        const auto& indices = m_events.at(type);
+        auto it = std::partition_point(indices.begin(), indices.end(),
+                                       [&](qint32 i) { return map(times.at(i)) < x; });
+        for (auto end = indices.end(); it != end && map(times.at(*it)) == x; ++it) {
+            callback(events.at(*it));
+        }
+    }
+
+    // calls @p callback with every event of @p type whose span contains @p x after mapping it with @p map
+    // this is only fast for the span cost type, other types get scanned from the start
+    template<typename Map, typename Callback>
+    void forEachSpanAt(const Data::Events& events, int type, int x, const Map& map, const Callback& callback) const
+    {
+        if (type < 0 || type >= m_events.size()) {
+            return;
+        }
+        const auto& times = events.times();
+        const auto& costs = events.costs();
+        const auto& indices = m_events.at(type);
+        auto it = indices.begin();
+        if (type == m_spanCostId) {
+            // skip the spans that end before x, the spans may overlap on the CPU rows
+            const auto first = std::partition_point(m_spanEnds.begin(), m_spanEnds.end(),
+                                                    [&](quint64 end) { return map(end) < x; });
+            it += std::distance(m_spanEnds.begin(), first);
+        }
+        for (auto end = indices.end(); it != end && map(times.at(*it)) <= x; ++it) {
+            if (map(times.at(*it) + costs.at(*it)) >= x) {
+                callback(events.at(*it));
+            }
+        }
+    }
+
+private:
+    // per cost type
+    QVector<QVector<qint32>> m_events;
+    int m_spanCostId = -1;
+    // the latest end of all spans up to each event of the span cost type, hence sorted
+    QVector<quint64> m_spanEnds;
+};
+
+Q_DECLARE_METATYPE(TimeLineSearchIndex)
@@ -0,0 +1,292 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "topinstructionsmodel.h"
+
+#include <QPointer>
+#include <QThread>
+
+#include <ThreadWeaver/ThreadWeaver>
+
+#include "../jobscheduler.h"
+#include "../util.h"
+#include "disassemblyoutput.h"
+#include "formattingutils.h"
+
+#include <algorithm>
+
+namespace {
+struct Candidate
+{
+    qint64 cost = 0;
+    quint64 addr = 0;
+    const Data::Symbol* symbol = nullptr;
+    const Data::LocationCost* locationCost = nullptr;
+};
+
+// a strict order that doesn't depend on the sharding, so the results are stable
+bool isHotter(const Candidate& lhs, const Candidate& rhs)
+{
+    if (lhs.cost != rhs.cost) {
+        return lhs.cost > rhs.cost;
+    } else if (lhs.addr != rhs.addr) {
+        return lhs.addr < rhs.addr;
+    }
+    return *lhs.symbol < *rhs.symbol;
+}
+
+// the heap is ordered by isHotter, so its front is the coldest of the hottest candidates
+void addCandidate(std::vector<Candidate>* heap, const Candidate& candidate, int count)
+{
+    if (static_cast<int>(heap->size()) < count) {
+        heap->push_back(candidate);
+        std::push_heap(heap->begin(), heap->end(), isHotter);
+    } else if (isHotter(candidate, heap->front())) {
+        std::pop_heap(heap->begin(), heap->end(), isHotter);
+        heap->back() = candidate;
+        std::push_heap(heap->begin(), heap->end(), isHotter);
+    }
+}
+}
+
+QVector<TopInstruction> topInstructions(const Data::CallerCalleeResults& results, int type, int count)
+{
+    using namespace ThreadWeaver;
+
+    if (count <= 0 || type < 0 || type >= results.selfCosts.numTypes()) {
+        return {};
+    }
+
+    // only symbols with a self cost have instructions with a self cost
+    const auto offsetMaps = results.selfOffsetMaps();
+    QVector<QHash<Data::Symbol, Data::OffsetLocationCostMap>::const_iterator> entries;
+    entries.reserve(offsetMaps.size());
+    for (auto it = offsetMaps.cbegin(), end = offsetMaps.cend(); it != end; ++it) {
+        const auto entry = results.entries.constFind(it.key());
+        if (entry != results.entries.constEnd() && results.selfCosts.cost(type, entry->id) > 0) {
+            entries.push_back(it);
+        }
+    }
+
+    Queue queue;
+    queue.setMaximumNumberOfThreads(QThread::idealThreadCount());
+    const int numEntries = entries.size();
+    const auto numShards = std::max(1, std::min<int>(numEntries, queue.maximumNumberOfThreads()));
+
+    std::vector<std::vector<Candidate>> heaps(numShards);
+    for (int shard = 0; shard < numShards; ++shard) {
+        queue.stream() << make_job([&, shard]() {
+            auto& heap = heaps[shard];
+            heap.reserve(count);
+            for (int i = numEntries * shard / numShards, end = numEntries * (shard + 1) / numShards; i < end; ++i) {
+                const auto& entry = entries[i];
+                const auto& offsetMap = entry.value();
+                for (auto it = offsetMap.cbegin(), mapEnd = offsetMap.cend(); it != mapEnd; ++it) {
+                    const auto cost = static_cast<int>(it->selfCost.size()) > type ? it->selfCost[type] : 0;
+                    if (cost > 0) {
+                        addCandidate(&heap, {cost, it.key(), &entry.key(), &it.value()}, count);
+                    }
+                }
+            }
+        });
+    }
+    queue.finish();
+
+    std::vector<Candidate> candidates;
+    for (const auto& heap : heaps) {
+        candidates.insert(candidates.end(), heap.begin(), heap.end());
+    }
+    const auto numResults = std::min<int>(candidates.size(), count);
+    std::partial_sort(candidates.begin(), candidates.begin() + numResults, candidates.end(), isHotter);
+
+    const auto numTypes = results.selfCosts.numTypes();
+    QVector<TopInstruction> instructions;
+    instructions.reserve(numResults);
+    for (int i = 0; i < numResults; ++i) {
+        const auto& candidate = candidates[i];
+        auto selfCost = candidate.locationCost->selfCost;
+        if (static_cast<int>(selfCost.size()) < numTypes) {
+            selfCost.resize(numTypes);
+        }
+        instructions.push_back({*candidate.symbol, candidate.addr, selfCost});
+    }
+    return instructions;
+}
+
+TopInstructionsModel::TopInstructionsModel(QObject* parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+TopInstructionsModel::~TopInstructionsModel() = default;
+
+void TopInstructionsModel::setResults(const QVector<TopInstruction>& instructions, const Data::Costs& selfCosts)
+{
+    beginResetModel();
+    // drop the instructions that are still getting resolved for the previous results
+    ++m_resultsId;
+    m_instructions = instructions;
+    m_selfCosts = {};
+    m_selfCosts.initializeCostsFrom(selfCosts);
+    for (int row = 0, c = m_instructions.size(); row < c; ++row) {
+        m_selfCosts.add(row, m_instructions[row].selfCost);
+    }
+    m_instructionText = QVector<QString>(m_instructions.size());
+    m_resolvedSymbols.clear();
+    endResetModel();
+}
+
+void TopInstructionsModel::setDisassembler(const std::function<Disassembler()>& disassembler)
+{
+    m_disassembler = disassembler;
+}
+
+int TopInstructionsModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_instructions.size();
+}
+
+int TopInstructionsModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : NUM_BASE_COLUMNS + m_selfCosts.numTypes();
+}
+
+QVariant TopInstructionsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (section < 0 || section >= columnCount() || orientation != Qt::Horizontal) {
+        return {};
+    }
+
+    if (role == Qt::InitialSortOrderRole && section > Instruction) {
+        return Qt::DescendingOrder;
+    } else if (role == Qt::DisplayRole) {
+        switch (section) {
+        case Symbol:
+            return tr("Symbol");
+        case Binary:
+            return tr("Binary");
+        case Address:
+            return tr("Address");
+        case Instruction:
+            return tr("Instruction");
+        }
+        return tr("%1 (self)").arg(m_selfCosts.typeName(section - NUM_BASE_COLUMNS));
+    } else if (role == Qt::ToolTipRole) {
+        switch (section) {
+        case Symbol:
+            return tr("The function the instruction belongs to. May be empty when debug information is missing.");
+        case Binary:
+            return tr("The name of the executable the instruction resides in.");
+        case Address:
+            return tr("The address of the instruction, relative to the start of its binary.");
+        case Instruction:
+            return tr("The disassembled instruction, filled in once the symbol got disassembled.");
+        }
+        return tr("The aggregated sample costs directly attributed to this instruction.");
+    }
+
+    return {};
+}
+
+QVariant TopInstructionsModel::data(const QModelIndex& index, int role) const
+{
+    if (!hasIndex(index.row(), index.column(), index.parent())) {
+        return {};
+    }
+
+    const auto row = index.row();
+    const auto& instruction = m_instructions[row];
+    const auto column = index.column();
+
+    if (role == SymbolRole) {
+        return QVariant::fromValue(instruction.symbol);
+    } else if (role == AddressRole) {
+        return instruction.addr;
+    } else if (role == SortRole) {
+        switch (column) {
+        case Symbol:
+            return Util::formatSymbol(instruction.symbol);
+        case Binary:
+            return instruction.symbol.binary;
+        case Address:
+            return instruction.addr;
+        case Instruction:
+            return m_instructionText[row];
+        }
+        return m_selfCosts.cost(column - NUM_BASE_COLUMNS, row);
+    } else if (role == TotalCostRole && column >= NUM_BASE_COLUMNS) {
+        return m_selfCosts.totalCost(column - NUM_BASE_COLUMNS);
+    } else if (role == Qt::DisplayRole) {
+        switch (column) {
+        case Symbol:
+            return Util::formatSymbol(instruction.symbol);
+        case Binary:
+            return instruction.symbol.binary;
+        case Address:
+            return QString::number(instruction.addr, 16);
+        case Instruction:
+            if (!m_resolvedSymbols.contains(instruction.symbol)) {
+                resolveInstructions(instruction.symbol);
+            }
+            return m_instructionText[row];
+        }
+        return Util::formatCostRelative(m_selfCosts.cost(column - NUM_BASE_COLUMNS, row),
+                                        m_selfCosts.totalCost(column - NUM_BASE_COLUMNS), true);
+    } else if (role == Qt::ToolTipRole) {
+        return Util::formatTooltip(instruction.symbol, m_selfCosts.itemCost(row), m_selfCosts);
+    }
+
+    return {};
+}
+
+void TopInstructionsModel::resolveInstructions(const Data::Symbol& symbol) const
+{
+    // only try once, the instruction text stays empty when the symbol cannot be disassembled
+    m_resolvedSymbols.insert(symbol);
+    if (!m_disassembler || !symbol.canDisassemble()) {
+        return;
+    }
+
+    // the disassembly cache makes this cheap for the symbols that got looked at or prefetched already
+    const auto resultsId = m_resultsId.load();
+    const auto smartThis = QPointer<TopInstructionsModel>(const_cast<TopInstructionsModel*>(this));
+    JobScheduler::run(
+        JobScheduler::Priority::Normal,
+        [smartThis, resultsId, currentResultsId = &m_resultsId, symbol, disassemble = m_disassembler()]() {
+            if (!smartThis || resultsId != (*currentResultsId)) {
+                return;
+            }
+
+            QHash<quint64, QString> instructions;
+            const auto disassembly = disassemble(symbol);
+            for (const auto& line : disassembly.disassemblyLines) {
+                if (line.addr) {
+                    instructions.insert(line.addr, Util::removeAnsi(line.disassembly));
+                }
+            }
+
+            QMetaObject::invokeMethod(
+                smartThis.data(),
+                [smartThis, resultsId, symbol, instructions]() {
+                    if (smartThis && resultsId == smartThis->m_resultsId) {
+                        smartThis->setInstructions(symbol, instructions);
+                    }
+                },
+                Qt::QueuedConnection);
+        });
+}
+
+void TopInstructionsModel::setInstructions(const Data::Symbol& symbol, const QHash<quint64, QString>& instructions)
+{
+    for (int row = 0, c = m_instructions.size(); row < c; ++row) {
+        const auto& instruction = m_instructions[row];
+        if (instruction.symbol == symbol) {
+            m_instructionText[row] = instructions.value(instruction.addr);
+            const auto cell = index(row, Instruction);
+            emit dataChanged(cell, cell);
+        }
+    }
+}
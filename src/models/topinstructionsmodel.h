@@ -0,0 +1,89 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+
+#include "data.h"
+
+struct DisassemblyOutput;
+
+struct TopInstruction
+{
+    Data::Symbol symbol;
+    // the address of the instruction, i.e. the key of CallerCalleeResults::offsetMap
+    quint64 addr = 0;
+    Data::ItemCost selfCost;
+};
+
+// the @p count instructions with the highest self cost of @p type across the offset maps of all symbols
+// the symbols are scanned in parallel, every job keeps a heap of its @p count hottest instructions
+QVector<TopInstruction> topInstructions(const Data::CallerCalleeResults& results, int type, int count);
+
+class TopInstructionsModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    using Disassembler = std::function<DisassemblyOutput(const Data::Symbol&)>;
+
+    explicit TopInstructionsModel(QObject* parent = nullptr);
+    ~TopInstructionsModel() override;
+
+    void setResults(const QVector<TopInstruction>& instructions, const Data::Costs& selfCosts);
+
+    // the disassembler is requested on demand, so that the instructions get resolved with the current settings
+    // the returned function gets called from a background thread
+    void setDisassembler(const std::function<Disassembler()>& disassembler);
+
+    int rowCount(const QModelIndex& parent = {}) const override;
+    int columnCount(const QModelIndex& parent = {}) const override;
+
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    enum Columns
+    {
+        Symbol = 0,
+        Binary,
+        Address,
+        Instruction,
+    };
+    enum
+    {
+        NUM_BASE_COLUMNS = Instruction + 1,
+        InitialSortColumn = Instruction + 1 // the first cost column
+    };
+
+    enum Roles
+    {
+        SortRole = Qt::UserRole,
+        TotalCostRole,
+        SymbolRole,
+        AddressRole,
+    };
+
+private:
+    // disassembles @p symbol in the background to fill in the text of all of its instructions
+    void resolveInstructions(const Data::Symbol& symbol) const;
+    void setInstructions(const Data::Symbol& symbol, const QHash<quint64, QString>& instructions);
+
+    QVector<TopInstruction> m_instructions;
+    // the self costs of the instructions, indexed by row
+    Data::Costs m_selfCosts;
+    std::function<Disassembler()> m_disassembler;
+
+    // the disassembly of the instructions indexed by row, filled in once a row got shown
+    QVector<QString> m_instructionText;
+    mutable QSet<Data::Symbol> m_resolvedSymbols;
+    std::atomic<uint> m_resultsId {0};
+};
@@ -7,6 +7,7 @@
 
 #include "topproxy.h"
 
+#include "data.h"
 #include "treemodel.h"
 
 TopProxy::TopProxy(QObject* parent)
@@ -38,7 +39,7 @@ int TopProxy::rowCount(const QModelIndex& parent) const
     if (parent.isValid() || !sourceModel()) {
         return 0; // this is not a tree
     }
-    return std::min(5, QSortFilterProxyModel::rowCount(parent));
+    return std::min(Data::TopCosts::NumEntries, QSortFilterProxyModel::rowCount(parent));
 }
 
 bool TopProxy::filterAcceptsRow(int source_row, const QModelIndex& source_parent) const
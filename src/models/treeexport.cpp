@@ -0,0 +1,128 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "treeexport.h"
+
+#include <QTextStream>
+
+#include "../util.h"
+
+namespace {
+// the rows get formatted into a buffer that is written and reported in one go
+const int ChunkRows = 4096;
+
+struct CostColumns
+{
+    const Data::Costs* costs;
+    QString suffix;
+};
+
+QString field(TreeExport::Format format, QString text)
+{
+    if (format == TreeExport::Format::Tsv) {
+        // there is no quoting for tab separated values
+        text.replace(QLatin1Char('\t'), QLatin1Char(' '));
+        text.replace(QLatin1Char('\n'), QLatin1Char(' '));
+        return text;
+    }
+    if (!text.contains(QLatin1Char(',')) && !text.contains(QLatin1Char('"')) && !text.contains(QLatin1Char('\n'))) {
+        return text;
+    }
+    text.replace(QLatin1Char('"'), QLatin1String("\"\""));
+    return QLatin1Char('"') + text + QLatin1Char('"');
+}
+
+template<typename Tree>
+qint64 numNodes(const Tree& root)
+{
+    qint64 ret = 0;
+    QVector<const Tree*> pending = {&root};
+    while (!pending.isEmpty()) {
+        const auto* node = pending.takeLast();
+        ret += node->children.size();
+        for (const auto& child : node->children) {
+            pending.push_back(&child);
+        }
+    }
+    return ret;
+}
+
+template<typename Tree>
+bool writeTree(QTextStream* stream, TreeExport::Format format, const Tree& root, const QVector<CostColumns>& columns,
+               const TreeExport::Progress& progress)
+{
+    const auto separator = format == TreeExport::Format::Tsv ? QLatin1Char('\t') : QLatin1Char(',');
+
+    QString buffer;
+    buffer += QLatin1String("depth") + separator + QLatin1String("symbol") + separator + QLatin1String("binary");
+    for (const auto& column : columns) {
+        for (int type = 0, c = column.costs->numTypes(); type < c; ++type) {
+            buffer += separator + field(format, column.costs->typeName(type) + column.suffix);
+        }
+    }
+    buffer += QLatin1Char('\n');
+
+    const auto totalRows = numNodes(root);
+    qint64 writtenRows = 0;
+    auto flush = [&]() {
+        *stream << buffer;
+        buffer.clear();
+        return !progress || progress(writtenRows, totalRows);
+    };
+
+    // depth first, so that every node follows its parent like in the expanded tree
+    struct Entry
+    {
+        const Tree* node;
+        int depth;
+    };
+    QVector<Entry> pending;
+    for (auto it = root.children.crbegin(), end = root.children.crend(); it != end; ++it) {
+        pending.push_back({&*it, 0});
+    }
+    while (!pending.isEmpty()) {
+        const auto entry = pending.takeLast();
+        const auto& symbol = entry.node->symbol;
+        buffer += QString::number(entry.depth) + separator + field(format, Util::formatSymbol(symbol)) + separator
+            + field(format, symbol.binary);
+        for (const auto& column : columns) {
+            for (int type = 0, c = column.costs->numTypes(); type < c; ++type) {
+                buffer += separator + QString::number(column.costs->cost(type, entry.node->id));
+            }
+        }
+        buffer += QLatin1Char('\n');
+
+        const auto& children = entry.node->children;
+        for (auto it = children.crbegin(), end = children.crend(); it != end; ++it) {
+            pending.push_back({&*it, entry.depth + 1});
+        }
+
+        if (++writtenRows % ChunkRows == 0 && !flush()) {
+            return false;
+        }
+    }
+    return flush();
+}
+}
+
+namespace TreeExport {
+Format formatForFileName(const QString& fileName)
+{
+    return fileName.endsWith(QLatin1String(".csv"), Qt::CaseInsensitive) ? Format::Csv : Format::Tsv;
+}
+
+bool write(QTextStream* stream, Format format, const Data::TopDownResults& results, const Progress& progress)
+{
+    const QVector<CostColumns> columns = {{&results.inclusiveCosts, QStringLiteral(" (incl.)")},
+                                          {&results.selfCosts, QStringLiteral(" (self)")}};
+    return writeTree(stream, format, results.root, columns, progress);
+}
+
+bool write(QTextStream* stream, Format format, const Data::BottomUpResults& results, const Progress& progress)
+{
+    return writeTree(stream, format, results.root, {{&results.costs, QStringLiteral(" (incl.)")}}, progress);
+}
+}
@@ -0,0 +1,35 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "data.h"
+
+#include <functional>
+
+class QTextStream;
+
+// the bottom up and top down trees as tables, for copying them into tickets or spreadsheets
+// the trees get walked directly instead of going through the models, so this can run on a background thread
+namespace TreeExport {
+enum class Format
+{
+    // tab separated values, as pasted into spreadsheets
+    Tsv,
+    Csv,
+};
+
+// .csv picks CSV, anything else becomes TSV
+Format formatForFileName(const QString& fileName);
+
+// gets called after every chunk of rows, return false to cancel the export
+using Progress = std::function<bool(qint64 writtenRows, qint64 totalRows)>;
+
+// writes a header and one row per node, parents before their children, starting with the depth of the node
+// returns false when the export got cancelled
+bool write(QTextStream* stream, Format format, const Data::TopDownResults& results, const Progress& progress = {});
+bool write(QTextStream* stream, Format format, const Data::BottomUpResults& results, const Progress& progress = {});
+}
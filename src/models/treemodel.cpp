@@ -8,6 +8,11 @@
 #include "treemodel.h"
 #include "../settings.h"
 #include "../util.h"
+#include "symboltimeseries.h"
+
+#include <QThread>
+
+#include <ThreadWeaver/ThreadWeaver>
 
 AbstractTreeModel::AbstractTreeModel(QObject* parent)
     : QAbstractItemModel(parent)
@@ -16,6 +21,32 @@ AbstractTreeModel::AbstractTreeModel(QObject* parent)
 
 AbstractTreeModel::~AbstractTreeModel() = default;
 
+void AbstractTreeModel::forEachInParallel(int count, const std::function<void(int)>& callback)
+{
+    using namespace ThreadWeaver;
+
+    // spinning up the threads isn't worth it for small trees
+    const int MinCountPerShard = 1024;
+    const auto numShards = std::min(count / MinCountPerShard, QThread::idealThreadCount());
+    if (numShards < 2) {
+        for (int i = 0; i < count; ++i) {
+            callback(i);
+        }
+        return;
+    }
+
+    Queue queue;
+    queue.setMaximumNumberOfThreads(numShards);
+    for (int shard = 0; shard < numShards; ++shard) {
+        queue.stream() << make_job([&callback, count, numShards, shard]() {
+            for (int i = count * shard / numShards, end = count * (shard + 1) / numShards; i < end; ++i) {
+                callback(i);
+            }
+        });
+    }
+    queue.finish();
+}
+
 BottomUpModel::BottomUpModel(QObject* parent)
     : CostTreeModel(parent)
 {
@@ -31,12 +62,27 @@ BottomUpModel::BottomUpModel(QObject* parent)
     connect(Settings::instance(), &Settings::collapseTemplatesChanged, this, prettifySymbolsHelper);
 
     connect(Settings::instance(), &Settings::collapseDepthChanged, this, prettifySymbolsHelper);
+
+    setDerivedMetrics(Settings::instance()->derivedMetrics());
+    connect(Settings::instance(), &Settings::derivedMetricsChanged, this, &BottomUpModel::setDerivedMetrics);
+
+    setFoldThreshold(Settings::instance()->foldThreshold());
+    connect(Settings::instance(), &Settings::foldThresholdChanged, this, &BottomUpModel::setFoldThreshold);
 }
 
 BottomUpModel::~BottomUpModel() = default;
 
 QVariant BottomUpModel::headerColumnData(int column, int role) const
 {
+    if (column == timeSeriesColumn()) {
+        if (role == Qt::DisplayRole) {
+            return tr("Over Time");
+        } else if (role == Qt::ToolTipRole) {
+            return tr("The inclusive cost of the symbol over the time of the recording, the markers separate the "
+                      "phases of different cost. The costs are computed when the rows get shown.");
+        }
+        return {};
+    }
     if (role == Qt::DisplayRole) {
         switch (column) {
         case Symbol:
@@ -44,7 +90,11 @@ QVariant BottomUpModel::headerColumnData(int column, int role) const
         case Binary:
             return tr("Binary");
         }
-        return tr("%1 (incl.)").arg(m_results.costs.typeName(column - NUM_BASE_COLUMNS));
+        column -= NUM_BASE_COLUMNS;
+        if (column >= m_results.costs.numTypes()) {
+            return m_metrics.metric(column - m_results.costs.numTypes()).label;
+        }
+        return tr("%1 (incl.)").arg(m_results.costs.typeName(column));
     } else if (role == Qt::ToolTipRole) {
         switch (column) {
         case Symbol:
@@ -54,6 +104,11 @@ QVariant BottomUpModel::headerColumnData(int column, int role) const
                 "The name of the executable the symbol resides in. May be empty when debug information is missing.");
         }
 
+        if (column - NUM_BASE_COLUMNS >= m_results.costs.numTypes()) {
+            const auto& metric = m_metrics.metric(column - NUM_BASE_COLUMNS - m_results.costs.numTypes());
+            return tr("The ratio of the inclusive costs of type \"%1\" and \"%2\" of the symbol.")
+                .arg(m_results.costs.typeName(metric.numerator), m_results.costs.typeName(metric.denominator));
+        }
         return tr("The symbol's inclusive cost of type \"%1\", i.e. the aggregated sample costs attributed to this "
                   "symbol, both directly and indirectly.")
             .arg(m_results.costs.typeName(column - NUM_BASE_COLUMNS));
@@ -64,20 +119,35 @@ QVariant BottomUpModel::headerColumnData(int column, int role) const
 
 QVariant BottomUpModel::rowData(const Data::BottomUp* row, int column, int role) const
 {
-    if (role == Qt::DisplayRole || role == SortRole) {
+    if (column == timeSeriesColumn()) {
+        if (role != TimeSeriesRole && role != Qt::ToolTipRole) {
+            return {};
+        }
+        const auto* series = m_timeSeries->series(row->symbol);
+        if (!series) {
+            return {};
+        }
+        return role == TimeSeriesRole ? QVariant::fromValue(*series) : QVariant(series->phasesToolTip());
+    } else if (role == Qt::DisplayRole || role == SortRole) {
         switch (column) {
         case Symbol:
             return Util::formatSymbol(row->symbol);
         case Binary:
             return row->symbol.binary;
         }
+        column -= NUM_BASE_COLUMNS;
+        if (column >= m_results.costs.numTypes()) {
+            const auto value = m_metrics.value(column - m_results.costs.numTypes(), row->id);
+            return role == SortRole ? QVariant(value) : QVariant(Data::DerivedMetrics::format(value));
+        }
         if (role == SortRole) {
-            return m_results.costs.cost(column - NUM_BASE_COLUMNS, row->id);
+            return m_results.costs.cost(column, row->id);
         }
-        return Util::formatCostRelative(m_results.costs.cost(column - NUM_BASE_COLUMNS, row->id),
-                                        m_results.costs.totalCost(column - NUM_BASE_COLUMNS), true);
-    } else if (role == TotalCostRole && column >= NUM_BASE_COLUMNS) {
-        return m_results.costs.totalCost(column - NUM_BASE_COLUMNS);
+        return Util::formatCostRelative(m_results.costs.cost(column, row->id), m_results.costs.referenceCost(column),
+                                        true);
+    } else if (role == TotalCostRole && column >= NUM_BASE_COLUMNS
+               && column < NUM_BASE_COLUMNS + m_results.costs.numTypes()) {
+        return m_results.costs.referenceCost(column - NUM_BASE_COLUMNS);
     } else if (role == Qt::ToolTipRole) {
         return Util::formatTooltip(row->id, row->symbol, m_results.costs);
     } else {
@@ -87,7 +157,51 @@ QVariant BottomUpModel::rowData(const Data::BottomUp* row, int column, int role)
 
 int BottomUpModel::numColumns() const
 {
-    return NUM_BASE_COLUMNS + m_results.costs.numTypes();
+    return NUM_BASE_COLUMNS + m_results.costs.numTypes() + m_metrics.size() + (m_timeSeries ? 1 : 0);
+}
+
+void BottomUpModel::setTimeSeries(const SymbolTimeSeriesCache* timeSeries)
+{
+    beginResetModel();
+    m_timeSeries = timeSeries;
+    endResetModel();
+}
+
+int BottomUpModel::timeSeriesColumn() const
+{
+    return m_timeSeries ? numColumns() - 1 : -1;
+}
+
+const Data::Costs* BottomUpModel::sortCosts(int column, int* type) const
+{
+    if (column < NUM_BASE_COLUMNS || column >= NUM_BASE_COLUMNS + m_results.costs.numTypes()) {
+        return nullptr;
+    }
+    *type = column - NUM_BASE_COLUMNS;
+    return &m_results.costs;
+}
+
+const Data::DerivedMetrics* BottomUpModel::sortMetrics(int column, int* metric) const
+{
+    *metric = column - NUM_BASE_COLUMNS - m_results.costs.numTypes();
+    return *metric >= 0 && *metric < m_metrics.size() ? &m_metrics : nullptr;
+}
+
+const Data::Costs* BottomUpModel::metricCosts() const
+{
+    return &m_results.costs;
+}
+
+const Data::Costs* BottomUpModel::foldCosts() const
+{
+    return &m_results.costs;
+}
+
+void BottomUpModel::addFoldedCosts(quint32 id, const Data::BottomUp* node)
+{
+    for (int type = 0, c = m_results.costs.numTypes(); type < c; ++type) {
+        m_results.costs.add(type, id, m_results.costs.cost(type, node->id));
+    }
 }
 
 TopDownModel::TopDownModel(QObject* parent)
@@ -106,6 +220,12 @@ TopDownModel::TopDownModel(QObject* parent)
     connect(Settings::instance(), &Settings::collapseTemplatesChanged, this, prettifySymbolsHelper);
 
     connect(Settings::instance(), &Settings::collapseDepthChanged, this, prettifySymbolsHelper);
+
+    setDerivedMetrics(Settings::instance()->derivedMetrics());
+    connect(Settings::instance(), &Settings::derivedMetricsChanged, this, &TopDownModel::setDerivedMetrics);
+
+    setFoldThreshold(Settings::instance()->foldThreshold());
+    connect(Settings::instance(), &Settings::foldThresholdChanged, this, &TopDownModel::setFoldThreshold);
 }
 
 TopDownModel::~TopDownModel() = default;
@@ -125,6 +245,9 @@ QVariant TopDownModel::headerColumnData(int column, int role) const
         }
 
         column -= m_results.inclusiveCosts.numTypes();
+        if (column >= m_results.selfCosts.numTypes()) {
+            return m_metrics.metric(column - m_results.selfCosts.numTypes()).label;
+        }
         return tr("%1 (self)").arg(m_results.selfCosts.typeName(column));
     } else if (role == Qt::ToolTipRole) {
         switch (column) {
@@ -145,6 +268,12 @@ QVariant TopDownModel::headerColumnData(int column, int role) const
         }
 
         column -= m_results.inclusiveCosts.numTypes();
+        if (column >= m_results.selfCosts.numTypes()) {
+            const auto& metric = m_metrics.metric(column - m_results.selfCosts.numTypes());
+            return tr("The ratio of the inclusive costs of type \"%1\" and \"%2\" of the symbol.")
+                .arg(m_results.inclusiveCosts.typeName(metric.numerator),
+                     m_results.inclusiveCosts.typeName(metric.denominator));
+        }
         return tr("The symbol's self cost of type \"%1\", i.e. the aggregated sample costs directly attributed to this "
                   "symbol. "
                   "This excludes the costs of all functions called by this symbol.")
@@ -170,23 +299,30 @@ QVariant TopDownModel::rowData(const Data::TopDown* row, int column, int role) c
                 return m_results.inclusiveCosts.cost(column, row->id);
             }
             return Util::formatCostRelative(m_results.inclusiveCosts.cost(column, row->id),
-                                            m_results.inclusiveCosts.totalCost(column), true);
+                                            m_results.inclusiveCosts.referenceCost(column), true);
         }
 
         column -= m_results.inclusiveCosts.numTypes();
+        if (column >= m_results.selfCosts.numTypes()) {
+            const auto value = m_metrics.value(column - m_results.selfCosts.numTypes(), row->id);
+            return role == SortRole ? QVariant(value) : QVariant(Data::DerivedMetrics::format(value));
+        }
         if (role == SortRole) {
             return m_results.selfCosts.cost(column, row->id);
         }
         return Util::formatCostRelative(m_results.selfCosts.cost(column, row->id),
-                                        m_results.selfCosts.totalCost(column), true);
+                                        m_results.selfCosts.referenceCost(column), true);
     } else if (role == TotalCostRole && column >= NUM_BASE_COLUMNS) {
         column -= NUM_BASE_COLUMNS;
         if (column < m_results.inclusiveCosts.numTypes()) {
-            return m_results.inclusiveCosts.totalCost(column);
+            return m_results.inclusiveCosts.referenceCost(column);
         }
 
         column -= m_results.inclusiveCosts.numTypes();
-        return m_results.selfCosts.totalCost(column);
+        if (column >= m_results.selfCosts.numTypes()) {
+            return {};
+        }
+        return m_results.selfCosts.referenceCost(column);
     } else if (role == Qt::ToolTipRole) {
         return Util::formatTooltip(row->id, row->symbol, m_results.selfCosts, m_results.inclusiveCosts);
     } else {
@@ -196,7 +332,47 @@ QVariant TopDownModel::rowData(const Data::TopDown* row, int column, int role) c
 
 int TopDownModel::numColumns() const
 {
-    return NUM_BASE_COLUMNS + m_results.selfCosts.numTypes() + m_results.inclusiveCosts.numTypes();
+    return NUM_BASE_COLUMNS + m_results.selfCosts.numTypes() + m_results.inclusiveCosts.numTypes() + m_metrics.size();
+}
+
+const Data::Costs* TopDownModel::sortCosts(int column, int* type) const
+{
+    if (column < NUM_BASE_COLUMNS) {
+        return nullptr;
+    }
+    column -= NUM_BASE_COLUMNS;
+    if (column < m_results.inclusiveCosts.numTypes()) {
+        *type = column;
+        return &m_results.inclusiveCosts;
+    }
+    *type = column - m_results.inclusiveCosts.numTypes();
+    return *type < m_results.selfCosts.numTypes() ? &m_results.selfCosts : nullptr;
+}
+
+const Data::DerivedMetrics* TopDownModel::sortMetrics(int column, int* metric) const
+{
+    *metric = column - NUM_BASE_COLUMNS - m_results.inclusiveCosts.numTypes() - m_results.selfCosts.numTypes();
+    return *metric >= 0 ? &m_metrics : nullptr;
+}
+
+const Data::Costs* TopDownModel::metricCosts() const
+{
+    return &m_results.inclusiveCosts;
+}
+
+const Data::Costs* TopDownModel::foldCosts() const
+{
+    return &m_results.inclusiveCosts;
+}
+
+void TopDownModel::addFoldedCosts(quint32 id, const Data::TopDown* node)
+{
+    for (int type = 0, c = m_results.inclusiveCosts.numTypes(); type < c; ++type) {
+        m_results.inclusiveCosts.add(type, id, m_results.inclusiveCosts.cost(type, node->id));
+    }
+    for (int type = 0, c = m_results.selfCosts.numTypes(); type < c; ++type) {
+        m_results.selfCosts.add(type, id, m_results.selfCosts.cost(type, node->id));
+    }
 }
 
 int TopDownModel::selfCostColumn(int cost) const
@@ -265,3 +441,12 @@ int PerLibraryModel::numColumns() const
 {
     return NUM_BASE_COLUMNS + m_results.costs.numTypes();
 }
+
+const Data::Costs* PerLibraryModel::sortCosts(int column, int* type) const
+{
+    if (column < NUM_BASE_COLUMNS) {
+        return nullptr;
+    }
+    *type = column - NUM_BASE_COLUMNS;
+    return &m_results.costs;
+}
@@ -8,9 +8,19 @@
 #pragma once
 
 #include <QAbstractItemModel>
+#include <QHash>
+#include <QVector>
 
+#include "../selfprofiler.h"
 #include "data.h"
 
+class SymbolTimeSeriesCache;
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
 class AbstractTreeModel : public QAbstractItemModel
 {
     Q_OBJECT
@@ -22,8 +32,14 @@ public:
     {
         SortRole = Qt::UserRole,
         TotalCostRole,
-        SymbolRole
+        SymbolRole,
+        // the SymbolTimeSeries of the symbol, see BottomUpModel::setTimeSeries
+        TimeSeriesRole,
     };
+
+protected:
+    // calls @p callback for every index in [0, count), spread across multiple threads for large counts
+    static void forEachInParallel(int count, const std::function<void(int)>& callback);
 };
 
 template<typename TreeNode_t, class ModelImpl>
@@ -55,6 +71,11 @@ public:
             return 0;
         } else if (auto item = itemFromIndex(parent)) {
             if (!m_simplify || item == rootItem() || item->children.size() != 1) {
+                const auto fold = m_folds.constFind(item);
+                if (fold != m_folds.constEnd()) {
+                    // the folded children are shown as one row at the end
+                    return fold->numVisible + 1;
+                }
                 return item->children.size();
             } else if (item->parent && item->parent->children.size() == 1) {
                 // simplified
@@ -62,6 +83,10 @@ public:
             }
 
             // aggregate all simplified nodes
+            const auto chain = m_chains.constFind(item);
+            if (chain != m_chains.constEnd()) {
+                return chain->size();
+            }
             int numChildren = 1;
             item = item->children.constData();
             while (item->children.size() == 1) {
@@ -106,8 +131,13 @@ public:
         }
         auto* parent = childItem->parent;
         if (m_simplify && parent && parent->children.size() == 1) {
-            while (parent->parent && parent->parent->children.size() == 1) {
-                parent = parent->parent;
+            const auto link = m_chainLinks.constFind(childItem);
+            if (link != m_chainLinks.constEnd()) {
+                parent = link->head;
+            } else {
+                while (parent->parent && parent->parent->children.size() == 1) {
+                    parent = parent->parent;
+                }
             }
         }
 
@@ -131,7 +161,8 @@ public:
         }
 
         if (role == SymbolRole) {
-            return QVariant::fromValue(item->symbol);
+            // the folded rows don't stand for a symbol that could be filtered or looked up
+            return isFoldedNode(item) ? QVariant() : QVariant::fromValue(item->symbol);
         } else {
             auto ret = rowData(item, index.column(), role);
             if (role == Qt::DisplayRole && m_simplify && index.column() == 0 && index.row() > 0 && item->parent
@@ -151,6 +182,38 @@ public:
         return m_simplify;
     }
 
+    /**
+     * Sorts the children of every node by the given column
+     *
+     * This is much faster than sorting in a QSortFilterProxyModel, since the cost columns get compared
+     * by their raw costs and the nodes get sorted in parallel. The tree itself stays untouched, every
+     * node with multiple children just gets a permutation of its rows.
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) final override
+    {
+        emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+        const auto oldIndices = persistentIndexList();
+        QVector<const TreeNode*> items;
+        items.reserve(oldIndices.size());
+        for (const auto& index : oldIndices) {
+            items.push_back(itemFromIndex(index));
+        }
+
+        m_sortColumn = column;
+        m_sortOrder = order;
+        sortChildren();
+
+        QModelIndexList newIndices;
+        newIndices.reserve(oldIndices.size());
+        for (int i = 0, c = oldIndices.size(); i < c; ++i) {
+            newIndices.push_back(indexFromItem(items[i], oldIndices[i].column()));
+        }
+        changePersistentIndexList(oldIndices, newIndices);
+
+        emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+    }
+
     /**
      * When simplification is enabled, long call chains get flattened until they branch the first time
      */
@@ -158,6 +221,7 @@ public:
     {
         beginResetModel();
         m_simplify = simplify;
+        buildChains();
         endResetModel();
     }
 
@@ -168,6 +232,10 @@ public:
         } else {
             auto parent = reinterpret_cast<const TreeNode*>(index.internalPointer());
             if (m_simplify && parent->children.size() == 1) {
+                const auto chain = m_chains.constFind(parent);
+                if (chain != m_chains.constEnd()) {
+                    return chain->value(index.row(), nullptr);
+                }
                 int row = index.row();
                 auto item = parent->children.constData();
                 while (row) {
@@ -181,6 +249,14 @@ public:
             if (index.row() >= parent->children.size()) {
                 return nullptr;
             }
+            const auto fold = m_folds.constFind(parent);
+            if (fold != m_folds.constEnd() && index.row() == fold->numVisible) {
+                return fold->other;
+            }
+            const auto permutation = m_permutations.constFind(parent);
+            if (permutation != m_permutations.constEnd()) {
+                return parent->children.constData() + permutation->children.at(index.row());
+            }
             return parent->children.constData() + index.row();
         }
     }
@@ -196,11 +272,18 @@ private:
         if (!parentItem) {
             parentItem = rootItem();
         }
+        if (isFoldedNode(item)) {
+            return createIndex(m_folds.value(parentItem).numVisible, column, const_cast<TreeNode*>(parentItem));
+        }
         Q_ASSERT(parentItem->children.constData() <= item);
         Q_ASSERT(parentItem->children.constData() + parentItem->children.size() > item);
 
         int row = 0;
         if (m_simplify && parentItem->children.size() == 1) {
+            const auto link = m_chainLinks.constFind(item);
+            if (link != m_chainLinks.constEnd()) {
+                return createIndex(link->row, column, const_cast<TreeNode*>(link->head));
+            }
             while (parentItem->parent && parentItem->parent->children.size() == 1) {
                 ++row;
                 parentItem = parentItem->parent;
@@ -208,6 +291,14 @@ private:
             Q_ASSERT(parentItem->children.size() == 1);
         } else {
             row = std::distance(parentItem->children.constData(), item);
+            const auto permutation = m_permutations.constFind(parentItem);
+            if (permutation != m_permutations.constEnd()) {
+                row = permutation->rows.at(row);
+            }
+            if (row < 0) {
+                // folded into the "other" row
+                return {};
+            }
         }
 
         return createIndex(row, column, const_cast<TreeNode*>(parentItem));
@@ -218,6 +309,276 @@ private:
     virtual QVariant headerColumnData(int column, int role) const = 0;
     virtual QVariant rowData(const TreeNode* item, int column, int role) const = 0;
 
+protected:
+    // the raw costs shown in @p column and their @p type, allows sorting without going through rowData
+    // returns nullptr for columns that don't show costs
+    virtual const Data::Costs* sortCosts(int column, int* type) const
+    {
+        Q_UNUSED(column);
+        Q_UNUSED(type);
+        return nullptr;
+    }
+
+    // like sortCosts, but for the columns showing a derived metric
+    virtual const Data::DerivedMetrics* sortMetrics(int column, int* metric) const
+    {
+        Q_UNUSED(column);
+        Q_UNUSED(metric);
+        return nullptr;
+    }
+
+    // the costs the fold threshold applies to, nullptr when the model doesn't fold its children
+    virtual const Data::Costs* foldCosts() const
+    {
+        return nullptr;
+    }
+
+    // adds the costs of the folded @p node to the costs of the "other" node with @p id
+    virtual void addFoldedCosts(quint32 id, const TreeNode* node)
+    {
+        Q_UNUSED(id);
+        Q_UNUSED(node);
+    }
+
+    /**
+     * Folds the children whose cost is below @p thresholdPercent of the total cost into one "other" row per parent
+     *
+     * Expanding a node with a huge fan-out would otherwise create a row for every child. Call this whenever the
+     * tree changes, before sortChildren.
+     */
+    void buildFolds(double thresholdPercent)
+    {
+        m_folds.clear();
+        m_otherNodes.clear();
+        const auto* costs = foldCosts();
+        if (thresholdPercent <= 0 || !costs || !costs->numTypes() || costs->totalCost(0) <= 0) {
+            return;
+        }
+        const auto minCost = costs->totalCost(0) * thresholdPercent / 100;
+
+        // the ids of the "other" nodes follow the ids of the tree
+        quint32 maxId = 0;
+        QVector<std::pair<const TreeNode*, Fold>> folds;
+        QVector<const TreeNode*> pending = {rootItem()};
+        while (!pending.isEmpty()) {
+            const auto* item = pending.takeLast();
+            const auto& children = item->children;
+            Fold fold;
+            if (children.size() >= MinFoldedChildren) {
+                fold.isFolded.resize(children.size());
+                for (int i = 0, c = children.size(); i < c; ++i) {
+                    fold.isFolded[i] = costs->cost(0, children[i].id) < minCost;
+                }
+                fold.numVisible = static_cast<int>(std::count(fold.isFolded.cbegin(), fold.isFolded.cend(), false));
+            }
+            if (children.size() - fold.numVisible >= MinFoldedChildren) {
+                folds.push_back({item, std::move(fold)});
+            }
+            for (const auto& child : children) {
+                maxId = std::max(maxId, child.id);
+                pending.push_back(&child);
+            }
+        }
+
+        m_otherNodes.resize(folds.size());
+        m_folds.reserve(folds.size());
+        for (int i = 0, c = folds.size(); i < c; ++i) {
+            auto& [node, fold] = folds[i];
+            const auto& children = node->children;
+            auto& other = m_otherNodes[i];
+            other.id = maxId + 1 + i;
+            other.parent = node == rootItem() ? nullptr : node;
+            const auto numFolded = children.size() - fold.numVisible;
+            other.symbol = Data::Symbol(AbstractTreeModel::tr("other (%n symbol(s))", nullptr, numFolded));
+            for (int child = 0, numChildren = children.size(); child < numChildren; ++child) {
+                if (fold.isFolded[child]) {
+                    addFoldedCosts(other.id, &children[child]);
+                }
+            }
+            fold.other = &other;
+            m_folds.insert(node, std::move(fold));
+        }
+    }
+
+    // applies the current sort column to the tree, call this whenever the tree changes
+    void sortChildren()
+    {
+        m_permutations.clear();
+        const bool isSorted = m_sortColumn >= 0 && m_sortColumn < numColumns();
+
+        // only nodes with multiple children need to be sorted, the folded nodes need a permutation even when unsorted
+        QVector<const TreeNode*> nodes;
+        if (isSorted) {
+            QVector<const TreeNode*> pending = {rootItem()};
+            while (!pending.isEmpty()) {
+                const auto* item = pending.takeLast();
+                if (item->children.size() > 1) {
+                    nodes.push_back(item);
+                }
+                for (const auto& child : item->children) {
+                    pending.push_back(&child);
+                }
+            }
+        } else {
+            for (auto it = m_folds.cbegin(), end = m_folds.cend(); it != end; ++it) {
+                nodes.push_back(it.key());
+            }
+        }
+
+        QVector<Permutation> permutations(nodes.size());
+        const bool descending = m_sortOrder == Qt::DescendingOrder;
+        int type = 0;
+        if (!isSorted) {
+            for (int i = 0, c = nodes.size(); i < c; ++i) {
+                auto& permutation = permutations[i];
+                permutation.children.resize(nodes[i]->children.size());
+                std::iota(permutation.children.begin(), permutation.children.end(), 0);
+            }
+        } else if (const auto* costs = sortCosts(m_sortColumn, &type)) {
+            forEachInParallel(nodes.size(), [&](int i) {
+                const auto& children = nodes[i]->children;
+                auto& permutation = permutations[i];
+                permutation.children.resize(children.size());
+                std::iota(permutation.children.begin(), permutation.children.end(), 0);
+                std::stable_sort(permutation.children.begin(), permutation.children.end(), [&](int lhs, int rhs) {
+                    const auto lhsCost = costs->cost(type, children[lhs].id);
+                    const auto rhsCost = costs->cost(type, children[rhs].id);
+                    return descending ? lhsCost > rhsCost : lhsCost < rhsCost;
+                });
+            });
+        } else if (const auto* metrics = sortMetrics(m_sortColumn, &type)) {
+            forEachInParallel(nodes.size(), [&](int i) {
+                const auto& children = nodes[i]->children;
+                auto& permutation = permutations[i];
+                permutation.children.resize(children.size());
+                std::iota(permutation.children.begin(), permutation.children.end(), 0);
+                // items without a value sort like the lowest ratio
+                auto value = [&](int child) {
+                    const auto ratio = metrics->value(type, children[child].id);
+                    return std::isnan(ratio) ? -1. : ratio;
+                };
+                std::stable_sort(permutation.children.begin(), permutation.children.end(), [&](int lhs, int rhs) {
+                    return descending ? value(lhs) > value(rhs) : value(lhs) < value(rhs);
+                });
+            });
+        } else {
+            // the other columns get formatted depending on the settings, so stay on this thread for them
+            for (int i = 0, c = nodes.size(); i < c; ++i) {
+                const auto& children = nodes[i]->children;
+                QVector<QString> keys;
+                keys.reserve(children.size());
+                for (const auto& child : children) {
+                    keys.push_back(rowData(&child, m_sortColumn, SortRole).toString());
+                }
+                auto& permutation = permutations[i];
+                permutation.children.resize(children.size());
+                std::iota(permutation.children.begin(), permutation.children.end(), 0);
+                std::stable_sort(permutation.children.begin(), permutation.children.end(), [&](int lhs, int rhs) {
+                    return descending ? keys[rhs] < keys[lhs] : keys[lhs] < keys[rhs];
+                });
+            }
+        }
+
+        m_permutations.reserve(nodes.size());
+        for (int i = 0, c = nodes.size(); i < c; ++i) {
+            auto& permutation = permutations[i];
+            const auto fold = m_folds.constFind(nodes[i]);
+            if (fold != m_folds.constEnd()) {
+                const auto& isFolded = fold->isFolded;
+                permutation.children.erase(std::remove_if(permutation.children.begin(), permutation.children.end(),
+                                                          [&isFolded](int child) { return isFolded[child]; }),
+                                           permutation.children.end());
+            }
+            // the folded children don't have a row
+            permutation.rows.fill(-1, nodes[i]->children.size());
+            for (int row = 0, numRows = permutation.children.size(); row < numRows; ++row) {
+                permutation.rows[permutation.children[row]] = row;
+            }
+            m_permutations.insert(nodes[i], std::move(permutation));
+        }
+    }
+
+    // precomputes the flattened chains of the simplified tree, call this whenever the tree changes
+    // otherwise every lookup would have to walk the chains, which is quadratic for deep call stacks
+    void buildChains()
+    {
+        m_chains.clear();
+        m_chainLinks.clear();
+        if (!m_simplify) {
+            return;
+        }
+
+        // the root is never simplified, see rowCount
+        QVector<const TreeNode*> pending;
+        for (const auto& child : rootItem()->children) {
+            pending.push_back(&child);
+        }
+        while (!pending.isEmpty()) {
+            const auto* item = pending.takeLast();
+            // a chain starts below every node with a single child, unless that node is part of a chain itself
+            if (item->children.size() == 1 && !(item->parent && item->parent->children.size() == 1)) {
+                const auto* head = item;
+                auto& chain = m_chains[head];
+                item = item->children.constData();
+                while (true) {
+                    m_chainLinks.insert(item, {head, static_cast<int>(chain.size())});
+                    chain.push_back(item);
+                    if (item->children.size() != 1) {
+                        break;
+                    }
+                    item = item->children.constData();
+                }
+            }
+            for (const auto& child : item->children) {
+                pending.push_back(&child);
+            }
+        }
+    }
+
+private:
+    bool isFoldedNode(const TreeNode* item) const
+    {
+        return !m_otherNodes.isEmpty() && item >= m_otherNodes.constData()
+            && item < m_otherNodes.constData() + m_otherNodes.size();
+    }
+
+    // folding a single child wouldn't save any rows
+    static const constexpr int MinFoldedChildren = 2;
+
+    struct Fold
+    {
+        // indexed by the child
+        QVector<bool> isFolded;
+        int numVisible = 0;
+        const TreeNode* other = nullptr;
+    };
+    // the nodes whose children got folded, see buildFolds
+    QHash<const TreeNode*, Fold> m_folds;
+    // the "other" rows of the folded nodes, never resized after building them since m_folds points into this
+    QVector<TreeNode> m_otherNodes;
+
+    struct ChainLink
+    {
+        const TreeNode* head = nullptr;
+        int row = 0;
+    };
+    // the nodes of a flattened chain, keyed by the node above the chain
+    QHash<const TreeNode*, QVector<const TreeNode*>> m_chains;
+    // every node of a flattened chain mapped to the node above the chain and its row within the chain
+    QHash<const TreeNode*, ChainLink> m_chainLinks;
+
+    struct Permutation
+    {
+        // the index of the child shown in each row
+        QVector<int> children;
+        // the row of each child
+        QVector<int> rows;
+    };
+    // the sorted rows of every node with multiple children, empty while unsorted
+    QHash<const TreeNode*, Permutation> m_permutations;
+    int m_sortColumn = -1;
+    Qt::SortOrder m_sortOrder = Qt::AscendingOrder;
+
     quint64 m_sampleCount = 0;
     bool m_simplify = true;
 
@@ -238,14 +599,39 @@ public:
     using Base::setData;
     void setData(const Results& data)
     {
+        ScopedPhase phase("tree model reset");
         QAbstractItemModel::beginResetModel();
+        m_unfoldedResults = data;
         m_results = data;
+        // appends the costs of the "other" nodes to m_results, which detaches them from the unfolded results
+        Base::buildFolds(m_foldThreshold);
+        const auto* costs = metricCosts();
+        m_metrics = costs ? Data::DerivedMetrics(m_metricDefinitions, *costs) : Data::DerivedMetrics();
+        Base::buildChains();
+        Base::sortChildren();
         QAbstractItemModel::endResetModel();
     }
 
+    // see Settings::derivedMetrics
+    void setDerivedMetrics(const QStringList& definitions)
+    {
+        m_metricDefinitions = definitions;
+        setData(m_unfoldedResults);
+    }
+
+    // see Settings::foldThreshold
+    void setFoldThreshold(double thresholdPercent)
+    {
+        if (m_foldThreshold != thresholdPercent) {
+            m_foldThreshold = thresholdPercent;
+            setData(m_unfoldedResults);
+        }
+    }
+
+    // without the costs of the folded nodes
     Results results() const
     {
-        return m_results;
+        return m_unfoldedResults;
     }
 
 protected:
@@ -254,7 +640,17 @@ protected:
         return &m_results.root;
     }
 
+    // the costs the derived metrics get computed from, nullptr when the model doesn't show any
+    virtual const Data::Costs* metricCosts() const
+    {
+        return nullptr;
+    }
+
     Results m_results;
+    Results m_unfoldedResults;
+    double m_foldThreshold = 0;
+    QStringList m_metricDefinitions;
+    Data::DerivedMetrics m_metrics;
 };
 
 class BottomUpModel : public CostTreeModel<Data::BottomUpResults, BottomUpModel>
@@ -277,6 +673,21 @@ public:
     QVariant headerColumnData(int column, int role) const final override;
     QVariant rowData(const Data::BottomUp* row, int column, int role) const final override;
     int numColumns() const final override;
+
+    // appends a column with the costs of the symbols over time, the series only get computed for the painted rows
+    void setTimeSeries(const SymbolTimeSeriesCache* timeSeries);
+    // the last column when the time series are set, -1 otherwise
+    int timeSeriesColumn() const;
+
+protected:
+    const Data::Costs* sortCosts(int column, int* type) const final override;
+    const Data::DerivedMetrics* sortMetrics(int column, int* metric) const final override;
+    const Data::Costs* metricCosts() const final override;
+    const Data::Costs* foldCosts() const final override;
+    void addFoldedCosts(quint32 id, const Data::BottomUp* node) final override;
+
+private:
+    const SymbolTimeSeriesCache* m_timeSeries = nullptr;
 };
 
 class TopDownModel : public CostTreeModel<Data::TopDownResults, TopDownModel>
@@ -301,6 +712,13 @@ public:
     QVariant rowData(const Data::TopDown* row, int column, int role) const final override;
     int numColumns() const final override;
     int selfCostColumn(int cost) const;
+
+protected:
+    const Data::Costs* sortCosts(int column, int* type) const final override;
+    const Data::DerivedMetrics* sortMetrics(int column, int* metric) const final override;
+    const Data::Costs* metricCosts() const final override;
+    const Data::Costs* foldCosts() const final override;
+    void addFoldedCosts(quint32 id, const Data::TopDown* node) final override;
 };
 
 class PerLibraryModel : public CostTreeModel<Data::PerLibraryResults, PerLibraryModel>
@@ -326,4 +744,7 @@ public:
     QVariant headerColumnData(int column, int role) const final override;
     QVariant rowData(const Data::PerLibrary* row, int column, int role) const final override;
     int numColumns() const final override;
+
+protected:
+    const Data::Costs* sortCosts(int column, int* type) const final override;
 };
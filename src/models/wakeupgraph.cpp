@@ -0,0 +1,140 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "wakeupgraph.h"
+
+#include <algorithm>
+
+namespace {
+bool isWakeupTracepoint(const QString& name)
+{
+    return name == QLatin1String("sched:sched_wakeup") || name == QLatin1String("sched:sched_wakeup_new");
+}
+}
+
+WakeupGraph::WakeupGraph(const Data::EventResults& events, const Data::TracepointResults& tracepoints)
+{
+    for (const auto& table : tracepoints.tables) {
+        if (!isWakeupTracepoint(table.name)) {
+            continue;
+        }
+        // the pid field of the tracepoint is the id of the woken thread
+        const auto wakeeField = table.fieldIndex(QStringLiteral("pid"));
+        if (wakeeField == -1 || !table.fields[wakeeField].isNumeric) {
+            continue;
+        }
+        const auto& wakees = table.fields[wakeeField].values;
+        for (qsizetype row = 0, numRows = table.size(); row < numRows; ++row) {
+            m_wakeups.push_back({table.times[row], table.threadIds[row], static_cast<qint32>(wakees[row]),
+                                 table.stackIds[row]});
+        }
+    }
+    std::stable_sort(m_wakeups.begin(), m_wakeups.end(),
+                     [](const Wakeup& lhs, const Wakeup& rhs) { return lhs.time < rhs.time; });
+
+    if (events.offCpuTimeCostId == -1) {
+        return;
+    }
+
+    // the wakeups every thread received, ordered by time
+    QHash<qint32, QVector<qint32>> receivedWakeups;
+    for (qint32 i = 0, c = m_wakeups.size(); i < c; ++i) {
+        receivedWakeups[m_wakeups[i].wakeeTid].push_back(i);
+    }
+    auto wakeupTime = [this](qint32 wakeup) { return m_wakeups[wakeup].time; };
+
+    for (const auto& thread : events.threads) {
+        auto& threadStart = m_threadStart[thread.tid];
+        threadStart = threadStart ? std::min(threadStart, thread.time.start) : thread.time.start;
+
+        const auto& types = thread.events.types();
+        if (std::find(types.begin(), types.end(), events.offCpuTimeCostId) == types.end()) {
+            continue;
+        }
+
+        const auto received = receivedWakeups.value(thread.tid);
+        auto& spans = m_offCpuSpans[thread.tid];
+        for (qsizetype i = 0, c = thread.events.size(); i < c; ++i) {
+            if (types[i] != events.offCpuTimeCostId) {
+                continue;
+            }
+
+            const auto event = thread.events.at(i);
+            OffCpuSpan span;
+            span.time = {event.time, event.time + event.cost};
+            span.stackId = event.stackId;
+
+            // the last wakeup within the span ended it
+            auto it = std::upper_bound(received.begin(), received.end(), span.time.end,
+                                       [&](quint64 time, qint32 wakeup) { return time < wakeupTime(wakeup); });
+            if (it != received.begin() && wakeupTime(*std::prev(it)) >= span.time.start) {
+                span.wakeup = *std::prev(it);
+            }
+            spans.push_back(span);
+        }
+    }
+
+    for (auto& spans : m_offCpuSpans) {
+        std::sort(spans.begin(), spans.end(),
+                  [](const OffCpuSpan& lhs, const OffCpuSpan& rhs) { return lhs.time.start < rhs.time.start; });
+    }
+}
+
+const WakeupGraph::OffCpuSpan* WakeupGraph::blockedAt(qint32 tid, quint64 time) const
+{
+    const auto it = m_offCpuSpans.constFind(tid);
+    if (it == m_offCpuSpans.constEnd()) {
+        return nullptr;
+    }
+
+    const auto& spans = *it;
+    auto span = std::upper_bound(spans.begin(), spans.end(), time,
+                                 [](quint64 time, const OffCpuSpan& span) { return time < span.time.start; });
+    if (span == spans.begin()) {
+        return nullptr;
+    }
+    --span;
+    return span->time.contains(time) ? &*span : nullptr;
+}
+
+QVector<WakeupGraph::PathStep> WakeupGraph::criticalPath(qint32 tid, quint64 time) const
+{
+    QVector<PathStep> steps;
+    while (steps.size() < MaxPathSteps) {
+        // the last span before time that got ended by a known wakeup, skipping the one the thread is blocked in
+        const OffCpuSpan* blocked = nullptr;
+        const auto it = m_offCpuSpans.constFind(tid);
+        if (it != m_offCpuSpans.constEnd()) {
+            const auto& spans = *it;
+            auto span = std::upper_bound(spans.begin(), spans.end(), time,
+                                         [](quint64 time, const OffCpuSpan& span) { return time < span.time.start; });
+            while (span != spans.begin()) {
+                --span;
+                if (span->wakeup != -1 && m_wakeups[span->wakeup].time < time) {
+                    blocked = &*span;
+                    break;
+                } else if (span->time.end < time) {
+                    // the thread ran after this span, but we don't know what woke it up
+                    break;
+                }
+            }
+        }
+
+        if (!blocked) {
+            steps.push_back({tid, {std::min(m_threadStart.value(tid, time), time), time}});
+            break;
+        }
+
+        // the waker is on the critical path up to the wakeup, the latency until the switch in is attributed to tid
+        const auto& wakeup = m_wakeups[blocked->wakeup];
+        steps.push_back({tid, {wakeup.time, time}});
+        tid = wakeup.wakerTid;
+        time = wakeup.time;
+    }
+
+    std::reverse(steps.begin(), steps.end());
+    return steps;
+}
@@ -0,0 +1,76 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QVector>
+
+#include "data.h"
+
+// connects the off-CPU time of the threads with the sched_wakeup events that ended it
+// this allows to follow the chain of wakeups backwards, i.e. the critical path that led to a point in time
+class WakeupGraph
+{
+public:
+    struct Wakeup
+    {
+        quint64 time = 0;
+        qint32 wakerTid = Data::INVALID_TID;
+        qint32 wakeeTid = Data::INVALID_TID;
+        // the stack of the waker, see Data::EventResults::stacks
+        qint32 stackId = -1;
+    };
+
+    struct OffCpuSpan
+    {
+        Data::TimeRange time;
+        // the stack that blocked, see Data::EventResults::stacks
+        qint32 stackId = -1;
+        // index into wakeups(), -1 when we don't know what ended the span
+        qint32 wakeup = -1;
+    };
+
+    // the part of the critical path during which @p tid ran or waited to be scheduled
+    struct PathStep
+    {
+        qint32 tid = Data::INVALID_TID;
+        Data::TimeRange time;
+    };
+
+    // the maximum number of wakeups that get followed by criticalPath
+    static const constexpr int MaxPathSteps = 1024;
+
+    WakeupGraph() = default;
+    WakeupGraph(const Data::EventResults& events, const Data::TracepointResults& tracepoints);
+
+    bool isEmpty() const
+    {
+        return m_wakeups.isEmpty();
+    }
+
+    const QVector<Wakeup>& wakeups() const
+    {
+        return m_wakeups;
+    }
+
+    // the off-CPU spans of the thread, ordered by time
+    QVector<OffCpuSpan> offCpuSpans(qint32 tid) const
+    {
+        return m_offCpuSpans.value(tid);
+    }
+
+    // the off-CPU span of the thread that contains @p time, or nullptr when it was running then
+    const OffCpuSpan* blockedAt(qint32 tid, quint64 time) const;
+
+    // follows the wakeups backwards from the thread at @p time, the steps are ordered by time
+    QVector<PathStep> criticalPath(qint32 tid, quint64 time) const;
+
+private:
+    QVector<Wakeup> m_wakeups;
+    QHash<qint32, QVector<OffCpuSpan>> m_offCpuSpans;
+    QHash<qint32, quint64> m_threadStart;
+};
@@ -8,18 +8,29 @@
 #include "perfparser.h"
 
 #include <QBuffer>
+#include <QCryptographicHash>
 #include <QDataStream>
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QEventLoop>
+#include <QFile>
 #include <QFileInfo>
 #include <QLoggingCategory>
+#include <QMutex>
 #include <QProcess>
+#include <QQueue>
+#include <QSaveFile>
+#include <QSet>
 #include <QScopeGuard>
+#include <QStandardPaths>
+#include <QTcpSocket>
 #include <QTemporaryFile>
 #include <QThread>
 #include <QTimer>
 #include <QUrl>
+#include <QWaitCondition>
 #include <QtEndian>
 
 #include <KIO/FileCopyJob>
@@ -27,10 +38,36 @@
 #include <ThreadWeaver/ThreadWeaver>
 
 #include <hotspot-config.h>
+#include <models/perfettoexport.h>
+#include <models/perfmapindex.h>
+#include <models/perfstat.h>
+#include <models/pprofexport.h>
+#include <models/stackpruning.h>
 #include <util.h>
 
+#include <atomic>
+#include <cctype>
+#include <deque>
 #include <functional>
+#include <future>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
+#include "jobscheduler.h"
+#include "selfprofiler.h"
 #include "settings.h"
 
 #if KFArchive_FOUND
@@ -363,6 +400,32 @@ QDebug operator<<(QDebug stream, const LostDefinition& lostDefinition)
     return stream;
 }
 
+// the layout of the payloads of one tracepoint type, see perftracingdata.h
+struct TracePointFormat
+{
+    qint32 id = 0;
+    StringId system;
+    StringId name;
+    quint32 flags = 0;
+};
+
+QDataStream& operator>>(QDataStream& stream, TracePointFormat& format)
+{
+    quint32 pid = 0;
+    quint32 tid = 0;
+    return stream >> pid >> tid >> format.id >> format.system >> format.name >> format.flags;
+}
+
+QDebug operator<<(QDebug stream, const TracePointFormat& format)
+{
+    stream.noquote().nospace() << "TracePointFormat{"
+                               << "id=" << format.id << ", "
+                               << "system=" << format.system << ", "
+                               << "name=" << format.name << ", "
+                               << "flags=" << format.flags << "}";
+    return stream;
+}
+
 struct BuildId
 {
     quint32 pid = 0;
@@ -407,6 +470,26 @@ QDebug operator<<(QDebug stream, const NumaNode& numaNode)
     return stream;
 }
 
+// the CPUs of a list like "0-3,8,10-11", as used for the topology of the NUMA nodes
+QVector<quint32> parseCpuList(const QByteArray& list)
+{
+    QVector<quint32> cpus;
+    for (const auto& range : list.trimmed().split(',')) {
+        const auto dash = range.indexOf('-');
+        bool firstOk = false;
+        bool lastOk = false;
+        const auto first = range.left(dash).trimmed().toUInt(&firstOk);
+        const auto last = dash == -1 ? first : range.mid(dash + 1).trimmed().toUInt(&lastOk);
+        if (!firstOk || (dash != -1 && !lastOk)) {
+            continue;
+        }
+        for (auto cpu = first; cpu <= last; ++cpu) {
+            cpus.append(cpu);
+        }
+    }
+    return cpus;
+}
+
 struct Pmu
 {
     quint32 type = 0;
@@ -534,891 +617,3910 @@ QDebug operator<<(QDebug stream, const Error& error)
     return stream;
 }
 
-void addCallerCalleeEvent(const Data::Symbol& symbol, const Data::Location& location, int type, quint64 cost,
-                          QSet<Data::Symbol>* recursionGuard, Data::CallerCalleeResults* callerCalleeResult,
-                          int numCosts)
+// decodes QDataStream-serialized data directly from a byte span
+// this is used for the hot event types to bypass the QBuffer/QDataStream overhead
+class ByteReader
 {
-    auto recursionIt = recursionGuard->find(symbol);
-    if (recursionIt == recursionGuard->end()) {
-        auto& entry = callerCalleeResult->entry(symbol);
-        auto& sourceCost = entry.source(location.fileLine, numCosts);
-        // relAddr can be 0 for symbols in the main executable
-        auto& addrCost = entry.offset(location.relAddr ? location.relAddr : location.address, numCosts);
+public:
+    ByteReader(const char* data, qint64 size)
+        : m_pos(data)
+        , m_end(data + size)
+    {
+    }
+
+    template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    ByteReader& operator>>(T& value)
+    {
+        if (!require(sizeof(T))) {
+            value = 0;
+            return *this;
+        }
+        if constexpr (sizeof(T) == 1) {
+            value = static_cast<T>(*m_pos);
+        } else {
+            value = qFromBigEndian<T>(m_pos);
+        }
+        m_pos += sizeof(T);
+        return *this;
+    }
+
+    ByteReader& operator>>(bool& value)
+    {
+        qint8 byte = 0;
+        *this >> byte;
+        value = byte != 0;
+        return *this;
+    }
+
+    template<typename T>
+    ByteReader& operator>>(QVector<T>& vector)
+    {
+        vector.clear();
+        quint64 size = 0;
+        {
+            quint32 size32 = 0;
+            *this >> size32;
+            size = size32;
+        }
+        if (size == 0xfffffffe) {
+            // extended size, used by Qt 6.7+ for large containers
+            *this >> size;
+        }
+        // every element takes at least one byte, guard against bogus sizes
+        if (!require(size)) {
+            return *this;
+        }
+        vector.resize(static_cast<int>(size));
+        for (auto& element : vector) {
+            *this >> element;
+        }
+        return *this;
+    }
+
+    bool isValid() const
+    {
+        return m_valid;
+    }
+
+    bool atEnd() const
+    {
+        return m_pos == m_end;
+    }
+
+    const char* position() const
+    {
+        return m_pos;
+    }
 
-        sourceCost.inclusiveCost[type] += cost;
-        addrCost.inclusiveCost[type] += cost;
-        if (recursionGuard->isEmpty()) {
-            // increment self cost for leaf
-            sourceCost.selfCost[type] += cost;
-            addrCost.selfCost[type] += cost;
+private:
+    bool require(quint64 size)
+    {
+        if (m_valid && static_cast<quint64>(m_end - m_pos) >= size) {
+            return true;
         }
-        recursionGuard->insert(symbol);
+        m_valid = false;
+        m_pos = m_end;
+        return false;
     }
+
+    const char* m_pos = nullptr;
+    const char* m_end = nullptr;
+    bool m_valid = true;
+};
+
+ByteReader& operator>>(ByteReader& reader, Record& record)
+{
+    return reader >> record.pid >> record.tid >> record.time >> record.cpu;
 }
 
-template<typename FrameCallback>
-void addBottomUpResult(Data::BottomUpResults* bottomUpResult, Settings::CostAggregation costAggregation,
-                       const Data::ThreadNames& commands, int type, quint64 cost, qint32 pid, qint32 tid, quint32 cpu,
-                       const QVector<qint32>& frames, const FrameCallback& frameCallback)
+ByteReader& operator>>(ByteReader& reader, StringId& stringId)
+{
+    return reader >> stringId.id;
+}
+
+ByteReader& operator>>(ByteReader& reader, Location& location)
+{
+    return reader >> location.address >> location.file >> location.pid >> location.line >> location.column
+        >> location.parentLocationId >> location.relAddr;
+}
+
+ByteReader& operator>>(ByteReader& reader, LocationDefinition& locationDefinition)
+{
+    return reader >> locationDefinition.id >> locationDefinition.location;
+}
+
+ByteReader& operator>>(ByteReader& reader, Symbol& symbol)
+{
+    return reader >> symbol.name >> symbol.binary >> symbol.path >> symbol.isKernel >> symbol.relAddr >> symbol.size
+        >> symbol.actualPath >> symbol.isInline;
+}
+
+ByteReader& operator>>(ByteReader& reader, SymbolDefinition& symbolDefinition)
+{
+    return reader >> symbolDefinition.id >> symbolDefinition.symbol;
+}
+
+ByteReader& operator>>(ByteReader& reader, SampleCost& sampleCost)
+{
+    return reader >> sampleCost.attributeId >> sampleCost.cost;
+}
+
+ByteReader& operator>>(ByteReader& reader, Sample& sample)
+{
+    return reader >> static_cast<Record&>(sample) >> sample.frames >> sample.guessedFrames >> sample.costs;
+}
+
+// the artificial first level symbol for the given cost aggregation, invalid when aggregating by symbol
+Data::Symbol aggregationRootSymbol(Settings::CostAggregation costAggregation, const Data::ThreadNames& commands,
+                                   qint32 pid, qint32 tid, quint32 cpu, qint32 numaNode)
 {
     switch (costAggregation) {
     case Settings::CostAggregation::BySymbol:
-        bottomUpResult->addEvent(type, cost, frames, frameCallback);
         break;
     case Settings::CostAggregation::ByThread: {
         auto thread = commands.names.value(pid).value(tid);
-        bottomUpResult->addEvent(thread.isEmpty() ? QString::number(tid) : thread, type, cost, frames, frameCallback);
-        break;
+        return thread.isEmpty() ? QString::number(tid) : thread;
     }
     case Settings::CostAggregation::ByProcess: {
         auto process = commands.names.value(pid).value(pid);
-        bottomUpResult->addEvent(process.isEmpty() ? QString::number(pid) : process, type, cost, frames, frameCallback);
-        break;
+        return process.isEmpty() ? QString::number(pid) : process;
     }
     case Settings::CostAggregation::ByCPU:
-        bottomUpResult->addEvent({QLatin1String("CPU %1").arg(QString::number(cpu))}, type, cost, frames,
-                                 frameCallback);
-        break;
+        return {QLatin1String("CPU %1").arg(QString::number(cpu))};
+    case Settings::CostAggregation::ByNumaNode:
+        if (numaNode == -1) {
+            return {QStringLiteral("unknown NUMA node")};
+        }
+        return {QLatin1String("NUMA node %1").arg(QString::number(numaNode))};
     }
+    return {};
 }
 
-struct SymbolCount
+template<typename FrameCallback>
+void addBottomUpResult(Data::BottomUpResults* bottomUpResult, const Data::Symbol& rootSymbol, int type, quint64 cost,
+                       const QVector<qint32>& frames, const FrameCallback& frameCallback)
 {
-    qint32 total = 0;
-    qint32 missing = 0;
-};
+    if (rootSymbol.isValid()) {
+        bottomUpResult->addEvent(rootSymbol, type, cost, frames, frameCallback);
+    } else {
+        bottomUpResult->addEvent(type, cost, frames, frameCallback);
+    }
+}
 
-QProcessEnvironment perfparserEnvironment(const QStringList& debuginfodUrls)
+// resolves the first level of the cost aggregation once per thread, process, CPU or NUMA node
+// instead of building and looking up its symbol for every event
+class AggregationRoots
 {
-    auto env = Util::appImageEnvironment();
-
-    if (!debuginfodUrls.isEmpty()) {
-        const auto envVar = QStringLiteral("DEBUGINFOD_URLS");
-        const auto defaultUrls = env.value(envVar);
-        const auto separator = QLatin1Char(' ');
-        env.insert(envVar, debuginfodUrls.join(separator) + separator + defaultUrls);
+public:
+    // the NUMA nodes of the CPUs get looked up in @p cpus
+    AggregationRoots(Settings::CostAggregation costAggregation, const Data::ThreadNames* commands,
+                     const QVector<Data::CpuEvents>* cpus)
+        : m_costAggregation(costAggregation)
+        , m_commands(commands)
+        , m_cpus(cpus)
+    {
     }
 
-    return env;
-}
-}
+    Data::Symbol symbol(qint32 pid, qint32 tid, quint32 cpu)
+    {
+        if (m_costAggregation == Settings::CostAggregation::BySymbol) {
+            return {};
+        }
 
-Q_DECLARE_TYPEINFO(AttributesDefinition, Q_MOVABLE_TYPE);
-Q_DECLARE_TYPEINFO(SampleCost, Q_MOVABLE_TYPE);
+        const auto key = this->key(pid, tid, cpu);
+        auto it = m_symbols.constFind(key);
+        if (it == m_symbols.constEnd()) {
+            it = m_symbols.insert(key,
+                                  aggregationRootSymbol(m_costAggregation, *m_commands, pid, tid, cpu, numaNode(cpu)));
+        }
+        return it.value();
+    }
 
-class PerfParserPrivate : public QObject
-{
-    Q_OBJECT
-public:
-    explicit PerfParserPrivate(Settings::CostAggregation costAggregation = Settings::CostAggregation::BySymbol,
-                               QObject* parent = nullptr)
-        : QObject(parent)
-        , stopRequested(false)
-        , costAggregation(costAggregation)
+    // the row of the first level node in @p bottomUp, or -1 when aggregating by symbol
+    // the rows are only valid for one result, see Data::BottomUpResults::rootRow
+    int row(Data::BottomUpResults* bottomUp, qint32 pid, qint32 tid, quint32 cpu)
     {
-        buffer.buffer().reserve(1024);
-        buffer.open(QIODevice::ReadOnly);
-        stream.setDevice(&buffer);
+        if (m_costAggregation == Settings::CostAggregation::BySymbol) {
+            return -1;
+        }
 
-        if (qEnvironmentVariableIntValue("HOTSPOT_GENERATE_SCRIPT_OUTPUT")) {
-            perfScriptOutput = std::make_unique<QTextStream>(stdout);
+        const auto key = this->key(pid, tid, cpu);
+        auto it = m_rows.constFind(key);
+        if (it == m_rows.constEnd()) {
+            it = m_rows.insert(key, bottomUp->rootRow(symbol(pid, tid, cpu)));
         }
+        return it.value();
     }
 
-    void setInput(QIODevice* input)
+    // the thread names changed, so must the symbols
+    void clear()
     {
-        this->input = input;
-        connect(input, &QProcess::readyRead, this, [this] {
-            while (tryParse()) {
-                // just call tryParse until it fails
-            }
-        });
+        m_symbols.clear();
+        m_rows.clear();
     }
 
-    bool tryParse()
+private:
+    quint64 key(qint32 pid, qint32 tid, quint32 cpu) const
     {
-        if (stopRequested) {
-            return false;
-        }
-        const auto bytesAvailable = input->bytesAvailable();
-        switch (state) {
-        case HEADER: {
-            const auto magic = QByteArrayLiteral("QPERFSTREAM");
-            // + 1 to include the trailing \0
-            if (bytesAvailable >= magic.size() + 1) {
-                input->read(buffer.buffer().data(), magic.size() + 1);
-                if (buffer.buffer().data() != magic) {
-                    state = PARSE_ERROR;
-                    qCWarning(LOG_PERFPARSER) << "Failed to read header magic";
-                    return false;
-                } else {
-                    state = DATA_STREAM_VERSION;
-                    return true;
-                }
-            }
-            break;
-        }
-        case DATA_STREAM_VERSION: {
-            qint32 dataStreamVersion = 0;
-            if (bytesAvailable >= static_cast<qint64>(sizeof(dataStreamVersion))) {
-                input->read(buffer.buffer().data(), sizeof(dataStreamVersion));
-                dataStreamVersion = qFromLittleEndian(*reinterpret_cast<qint32*>(buffer.buffer().data()));
-                stream.setVersion(dataStreamVersion);
-                qCDebug(LOG_PERFPARSER) << "data stream version is:" << dataStreamVersion;
-                state = EVENT_HEADER;
-                return true;
-            }
-            break;
-        }
-        case EVENT_HEADER:
-            if (bytesAvailable >= static_cast<qint64>(sizeof(eventSize))) {
-                input->read(buffer.buffer().data(), sizeof(eventSize));
-                eventSize = qFromLittleEndian(*reinterpret_cast<quint32*>(buffer.buffer().data()));
-                qCDebug(LOG_PERFPARSER) << "next event size is:" << eventSize;
-                state = EVENT;
-                return true;
-            }
-            break;
-        case EVENT:
-            if (bytesAvailable >= static_cast<qint64>(eventSize)) {
-                buffer.buffer().resize(eventSize);
-                input->read(buffer.buffer().data(), eventSize);
-                if (!parseEvent()) {
-                    state = PARSE_ERROR;
-                    return false;
-                }
-                // await next event
-                state = EVENT_HEADER;
-                eventSize = 0;
-                return true;
-            }
-            break;
-        case PARSE_ERROR:
-            // do nothing
+        switch (m_costAggregation) {
+        case Settings::CostAggregation::ByThread:
+            return (static_cast<quint64>(static_cast<quint32>(pid)) << 32) | static_cast<quint32>(tid);
+        case Settings::CostAggregation::ByProcess:
+            return static_cast<quint32>(pid);
+        case Settings::CostAggregation::ByCPU:
+            return cpu;
+        case Settings::CostAggregation::ByNumaNode:
+            return static_cast<quint32>(numaNode(cpu) + 1);
+        case Settings::CostAggregation::BySymbol:
             break;
         }
-        return false;
+        return 0;
     }
 
-    bool parseEvent()
+    qint32 numaNode(quint32 cpu) const
     {
-        Q_ASSERT(buffer.isOpen());
-        Q_ASSERT(buffer.isReadable());
+        return cpu < static_cast<quint32>(m_cpus->size()) ? m_cpus->at(cpu).numaNode : -1;
+    }
 
-        buffer.seek(0);
-        Q_ASSERT(buffer.pos() == 0);
+    Settings::CostAggregation m_costAggregation;
+    const Data::ThreadNames* m_commands;
+    const QVector<Data::CpuEvents>* m_cpus;
+    QHash<quint64, Data::Symbol> m_symbols;
+    QHash<quint64, int> m_rows;
+};
 
-        stream.resetStatus();
+// the number of events aggregated between two checks whether the aggregation got stopped
+const constexpr qint32 StopPollInterval = 4096;
 
-        qint8 eventType = 0;
-        stream >> eventType;
-        qCDebug(LOG_PERFPARSER) << "next event is:" << eventType;
+struct PartialResults
+{
+    Data::BottomUpResults bottomUp;
+    Data::CallerCalleeResults callerCallee;
+};
 
-        if (eventType < 0 || eventType >= static_cast<qint8>(EventType::InvalidType)) {
-            qCWarning(LOG_PERFPARSER) << "invalid event type" << eventType;
-            state = PARSE_ERROR;
-            return false;
-        }
+// aggregate the events of all threads into the bottom up and caller/callee results
+// the threads get sharded across jobs and the partial results are merged in parallel afterwards
+// with @p correctLostEvents, the costs of the samples close to lost events get scaled up, see Data::LostEvents
+// with a @p cube built from @p events, its cells get aggregated instead of every single event
+void aggregateEvents(ThreadWeaver::Queue* queue, const Data::EventResults& events,
+                     Settings::CostAggregation costAggregation, bool correctLostEvents,
+                     const Data::ThreadNames& threadNames, const std::atomic<bool>& stopRequested,
+                     Data::BottomUpResults* bottomUp, Data::CallerCalleeResults* callerCallee,
+                     const Data::CostCube* cube = nullptr)
+{
+    using namespace ThreadWeaver;
 
-        switch (static_cast<EventType>(eventType)) {
-        case EventType::TracePointSample:
-        case EventType::Sample: {
-            Sample sample;
-            stream >> sample;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << sample;
-            for (auto& sampleCost : sample.costs) {
-                if (!sampleCost.cost) {
-                    const auto& attribute = attributes.value(sampleCost.attributeId);
-                    if (!attribute.usesFrequency) {
-                        sampleCost.cost = attribute.frequencyOrPeriod;
+    const auto numShards = std::max(1, std::min<int>(events.threads.size(), queue->maximumNumberOfThreads()));
+
+    // balance the shards by the number of events, assigning the biggest threads first
+    QVector<int> threadIndices(events.threads.size());
+    std::iota(threadIndices.begin(), threadIndices.end(), 0);
+    std::sort(threadIndices.begin(), threadIndices.end(), [&events](int lhs, int rhs) {
+        return events.threads[lhs].events.size() > events.threads[rhs].events.size();
+    });
+    std::vector<QVector<int>> shardThreads(numShards);
+    std::vector<qint64> shardEvents(numShards, 0);
+    for (auto threadIndex : std::as_const(threadIndices)) {
+        const auto shard = std::distance(shardEvents.begin(), std::min_element(shardEvents.begin(), shardEvents.end()));
+        shardThreads[shard].push_back(threadIndex);
+        shardEvents[shard] += events.threads[threadIndex].events.size();
+    }
+
+    std::vector<PartialResults> shards(numShards, PartialResults {*bottomUp, *callerCallee});
+    for (int i = 0; i < numShards; ++i) {
+        queue->stream() << make_job([&, i]() {
+            auto& shard = shards[i];
+            AggregationRoots roots(costAggregation, &threadNames, &events.cpus);
+            for (auto threadIndex : std::as_const(shardThreads[i])) {
+                if (stopRequested) {
+                    return;
+                }
+
+                const auto& thread = events.threads[threadIndex];
+                // the source and offset maps get computed on demand, see Data::LocationCostIndex
+                auto frameCallback = [](const Data::Symbol& /*symbol*/, const Data::Location& /*location*/) {};
+                auto addEvent = [&](qint32 type, quint64 cost, qint32 stackId, quint32 cpuId) {
+                    const auto& frames = events.stacks.at(stackId);
+                    const auto rootRow = roots.row(&shard.bottomUp, thread.pid, thread.tid, cpuId);
+                    if (rootRow == -1) {
+                        shard.bottomUp.addEvent(type, cost, frames, frameCallback);
+                    } else {
+                        shard.bottomUp.addEvent(rootRow, type, cost, frames, frameCallback);
                     }
+                };
+
+                if (cube) {
+                    for (const auto& cell : cube->cells(threadIndex)) {
+                        if (cell.stackId != -1) {
+                            addEvent(cell.type, cell.cost, cell.stackId, cell.cpuId);
+                        }
+                    }
+                    continue;
                 }
-            }
 
-            addRecord(sample);
-            addSample(sample);
+                if (!correctLostEvents) {
+                    // the events of a run share their stack, so the stack only gets walked once per run
+                    qint64 numEvents = 0;
+                    thread.events.forEachRun([&](const Data::EventRun& run) {
+                        // poll regularly, a single thread may have millions of events
+                        numEvents += run.count;
+                        if (numEvents >= StopPollInterval) {
+                            numEvents = 0;
+                            if (stopRequested) {
+                                return false;
+                            }
+                        }
+                        if (run.stackId != -1) {
+                            addEvent(run.type, run.cost * run.count, run.stackId, run.cpuId);
+                        }
+                        return true;
+                    });
+                    continue;
+                }
 
-            if (static_cast<EventType>(eventType) == EventType::TracePointSample)
-                return true; // TODO: read full data
-            break;
-        }
-        case EventType::ThreadStart: {
-            ThreadStart threadStart;
-            stream >> threadStart;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << threadStart;
-            addRecord(threadStart);
-            // override start time explicitly
-            auto thread = addThread(threadStart);
-            thread->time.start = threadStart.time;
-            if (threadStart.ppid != threadStart.pid) {
-                const auto parentComm = commands.names.value(threadStart.ppid).value(threadStart.ppid);
-                commands.names[threadStart.pid][threadStart.pid] = parentComm;
-                thread->name = parentComm;
+                // the corrected cost depends on the time of every event
+                qint32 numEvents = 0;
+                for (const auto& event : thread.events) {
+                    if (++numEvents % StopPollInterval == 0 && stopRequested) {
+                        return;
+                    }
+                    if (event.stackId != -1) {
+                        addEvent(event.type, events.correctedCost(event), event.stackId, event.cpuId);
+                    }
+                }
             }
-            // check if perf-$pid.map file exists
-            perfMapFileExists |= QFile::exists(QDir::tempPath() + QDir::separator()
-                                               + QLatin1String("perf-%1.map").arg(QString::number(thread->pid)));
-            break;
+        });
+    }
+    queue->finish();
+    if (stopRequested) {
+        // the caller discards the incomplete results anyway
+        return;
+    }
+
+    // merge pairwise, halving the number of partial results in every round
+    for (int step = 1; step < numShards; step *= 2) {
+        for (int i = 0; i + step < numShards; i += 2 * step) {
+            queue->stream() << make_job([&shards, i, step]() {
+                auto& target = shards[i];
+                const auto& source = shards[i + step];
+                target.bottomUp.merge(source.bottomUp);
+                target.callerCallee.mergeEntries(source.callerCallee);
+            });
         }
-        case EventType::ThreadEnd: {
-            ThreadEnd threadEnd;
-            stream >> threadEnd;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << threadEnd;
-            addRecord(threadEnd);
-            addThreadEnd(threadEnd);
+        queue->finish();
+    }
+
+    *bottomUp = std::move(shards.front().bottomUp);
+    *callerCallee = std::move(shards.front().callerCallee);
+    callerCallee->locations = std::make_shared<const Data::LocationCostIndex>(*bottomUp, events);
+}
+
+// builds the cells of every thread of @p events in parallel, the cube is incomplete once @p stopRequested got set
+Data::CostCube buildCostCube(ThreadWeaver::Queue* queue, const Data::EventResults& events,
+                             const std::atomic<bool>& stopRequested)
+{
+    QVector<QVector<Data::CostCube::Cell>> threadCells(events.threads.size());
+    for (int i = 0, c = events.threads.size(); i < c; ++i) {
+        queue->stream() << ThreadWeaver::make_job([&events, &stopRequested, &threadCells, i]() {
+            if (!stopRequested) {
+                threadCells[i] = Data::CostCube::threadCells(events.threads[i], &stopRequested);
+            }
+        });
+    }
+    queue->finish();
+    return Data::CostCube(std::move(threadCells));
+}
+
+// the number of jobs the @p numSubtrees top level subtrees of a tree get split across, less than two means no split
+int numSubtreeShards(const ThreadWeaver::Queue* queue, int numSubtrees)
+{
+    return std::min<int>(numSubtrees, queue->maximumNumberOfThreads());
+}
+
+// builds the partial results of @p numShards disjunct ranges of the @p numSubtrees top level subtrees in parallel
+// and merges them, @p build gets called with the begin and end of a range
+// once @p cancelled gets set the remaining jobs are skipped, the results are incomplete then and must be dropped
+template<typename Results, typename Build>
+Results mergedSubtreeShards(ThreadWeaver::Queue* queue, int numSubtrees, int numShards, const Build& build,
+                            const std::atomic<bool>* cancelled)
+{
+    auto isCancelled = [cancelled]() { return cancelled && *cancelled; };
+
+    QVector<Results> shards(numShards);
+    for (int shard = 0; shard < numShards; ++shard) {
+        const auto begin = numSubtrees * shard / numShards;
+        const auto end = numSubtrees * (shard + 1) / numShards;
+        queue->stream() << ThreadWeaver::make_job([&shards, &build, &isCancelled, shard, begin, end]() {
+            if (!isCancelled()) {
+                shards[shard] = build(begin, end);
+            }
+        });
+    }
+    queue->finish();
+
+    // merge pairwise, just like in aggregateEvents
+    for (int step = 1; step < numShards && !isCancelled(); step *= 2) {
+        for (int i = 0; i + step < numShards; i += 2 * step) {
+            queue->stream() << ThreadWeaver::make_job([&shards, i, step]() { shards[i].merge(shards[i + step]); });
+        }
+        queue->finish();
+    }
+
+    return std::move(shards.first());
+}
+
+// like Data::callerCalleesFromBottomUpData, but the top level subtrees get split across jobs
+void callerCalleesFromBottomUpData(ThreadWeaver::Queue* queue, const Data::BottomUpResults& bottomUp,
+                                   Data::CallerCalleeResults* results, const std::atomic<bool>* cancelled = nullptr)
+{
+    const int numChildren = bottomUp.root.children.size();
+    const auto numShards = numSubtreeShards(queue, numChildren);
+    if (numShards < 2) {
+        Data::callerCalleesFromBottomUpData(bottomUp, results);
+        return;
+    }
+
+    const auto merged = mergedSubtreeShards<Data::CallerCalleeResults>(
+        queue, numChildren, numShards,
+        [&bottomUp](int begin, int end) { return Data::callerCalleesFromBottomUpSubtrees(bottomUp, begin, end); },
+        cancelled);
+    if (cancelled && *cancelled) {
+        return;
+    }
+
+    results->inclusiveCosts.initializeCostsFrom(bottomUp.costs);
+    results->selfCosts.initializeCostsFrom(bottomUp.costs);
+    results->merge(merged);
+    results->buildFileCosts();
+    results->buildAdjacency();
+}
+
+// like Data::TopDownResults::fromBottomUp, but the top level subtrees get split across jobs
+Data::TopDownResults topDownFromBottomUpData(ThreadWeaver::Queue* queue, const Data::BottomUpResults& bottomUp,
+                                             bool skipFirstLevel, const std::atomic<bool>* cancelled = nullptr)
+{
+    const int numChildren = bottomUp.root.children.size();
+    const auto numShards = numSubtreeShards(queue, numChildren);
+    if (numShards < 2) {
+        return Data::TopDownResults::fromBottomUp(bottomUp, skipFirstLevel);
+    }
+
+    auto results = mergedSubtreeShards<Data::TopDownResults>(
+        queue, numChildren, numShards, [&bottomUp, skipFirstLevel](int begin, int end) {
+            return Data::TopDownResults::fromBottomUpSubtrees(bottomUp, skipFirstLevel, begin, end);
+        },
+        cancelled);
+    Data::TopDown::initializeParents(&results.root);
+    return results;
+}
+
+// like Data::PerLibraryResults::fromTopDown, but the top level subtrees get split across jobs
+Data::PerLibraryResults perLibraryFromTopDownData(ThreadWeaver::Queue* queue, const Data::TopDownResults& topDown,
+                                                  const std::atomic<bool>* cancelled = nullptr)
+{
+    const int numChildren = topDown.root.children.size();
+    const auto numShards = numSubtreeShards(queue, numChildren);
+    if (numShards < 2) {
+        return Data::PerLibraryResults::fromTopDown(topDown);
+    }
+
+    auto results = mergedSubtreeShards<Data::PerLibraryResults>(
+        queue, numChildren, numShards,
+        [&topDown](int begin, int end) { return Data::PerLibraryResults::fromTopDownSubtrees(topDown, begin, end); },
+        cancelled);
+    Data::PerLibrary::initializeParents(&results.root);
+    return results;
+}
+
+struct SymbolCount
+{
+    qint32 total = 0;
+    qint32 missing = 0;
+};
+
+QProcessEnvironment perfparserEnvironment(const QStringList& debuginfodUrls)
+{
+    auto env = Util::appImageEnvironment();
+
+    if (!debuginfodUrls.isEmpty()) {
+        const auto envVar = QStringLiteral("DEBUGINFOD_URLS");
+        const auto defaultUrls = env.value(envVar);
+        const auto separator = QLatin1Char(' ');
+        env.insert(envVar, debuginfodUrls.join(separator) + separator + defaultUrls);
+    }
+
+    return env;
+}
+
+// how often the results parsed so far get published while parsing the data of a running recording, in ms
+constexpr int LiveSnapshotInterval = 2000;
+// the same while parsing a file, less often since the snapshots of large files take a while to build
+constexpr int FileSnapshotInterval = 5000;
+
+// the slices of the time range the analysis server sums up the samples in, plenty for the timeline of a screen
+constexpr quint32 ServerTimeBuckets = 4096;
+// used when the url of an analysis server has no port
+constexpr int DefaultServerPort = 7878;
+const auto serverUrlScheme = QLatin1String("hotspot");
+const auto serverRequestPrefix = QByteArrayLiteral("HOTSPOT/1 ");
+
+// the arguments for hotspot-perfparser, without an @p input file it reads the perf data from stdin
+QStringList perfparserArgs(const QString& input)
+{
+    const auto settings = Settings::instance();
+    QStringList parserArgs = {QStringLiteral("--max-frames"), QStringLiteral("1024")};
+    if (!input.isEmpty()) {
+        parserArgs += {QStringLiteral("--input"), input};
+    }
+    const auto sysroot = settings->sysroot();
+    if (!sysroot.isEmpty()) {
+        parserArgs += {QStringLiteral("--sysroot"), sysroot};
+    }
+    const auto kallsyms = settings->kallsyms();
+    if (!kallsyms.isEmpty()) {
+        parserArgs += {QStringLiteral("--kallsyms"), kallsyms};
+    }
+    const auto debugPaths = settings->debugPaths();
+    if (!debugPaths.isEmpty()) {
+        parserArgs += {QStringLiteral("--debug"), debugPaths};
+    }
+    const auto extraLibPaths = settings->extraLibPaths();
+    if (!extraLibPaths.isEmpty()) {
+        parserArgs += {QStringLiteral("--extra"), extraLibPaths};
+    }
+    const auto appPath = settings->appPath();
+    if (!appPath.isEmpty()) {
+        parserArgs += {QStringLiteral("--app"), appPath};
+    }
+    const auto arch = settings->arch();
+    if (!arch.isEmpty()) {
+        parserArgs += {QStringLiteral("--arch"), arch};
+    }
+    const auto perfMapPath = settings->perfMapPath();
+    if (!perfMapPath.isEmpty()) {
+        parserArgs += {QStringLiteral("--perf-map-path"), perfMapPath};
+    }
+    return parserArgs;
+}
+
+// the stack pruning rules of the settings
+StackPruning stackPruningFromSettings()
+{
+    const auto settings = Settings::instance();
+    return {settings->pruneFrames(), settings->maxStackDepth(), settings->collapseRecursion()};
+}
+
+// where the perf-<pid>.map files of the JIT compilers are, see Settings::perfMapPath
+QString perfMapDirFromSettings()
+{
+    const auto perfMapPath = Settings::instance()->perfMapPath();
+    return perfMapPath.isEmpty() ? QDir::tempPath() : perfMapPath;
+}
+
+// where the indices of the perf-<pid>.map files get cached, see PerfMapIndex
+QString perfMapCacheDir()
+{
+    const auto cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    return cacheDir.isEmpty() ? cacheDir : cacheDir + QLatin1String("/perfmaps");
+}
+
+// the local binaries the symbols of a cached perfparser output got resolved from, see perfparserCacheUpToDate
+QString perfparserCacheBinariesFile(const QString& cacheFile)
+{
+    return cacheFile + QLatin1String(".binaries");
+}
+
+// one line per binary with its path, size and modification time, -1 for binaries that don't exist locally
+QByteArray binaryStamp(const QString& path)
+{
+    const auto info = QFileInfo(path);
+    const auto size = info.exists() ? info.size() : -1;
+    const auto modified = info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+    return path.toUtf8() + '\t' + QByteArray::number(size) + '\t' + QByteArray::number(modified) + '\n';
+}
+
+// the cache of the perfparser output for @p path, empty when there is no cache location
+// the key covers the input, the parser and everything that changes its output, but not the cost aggregation
+// which happens afterwards. hashing all of a multi gigabyte input would take too long, so only its size and
+// samples of its content are part of the key. the sysroot, the debug and library paths and the debuginfod urls
+// are part of the arguments, the binaries found there get checked by perfparserCacheUpToDate
+QString perfparserCacheFile(const QString& path, const QString& parserBinary, QStringList parserArgs,
+                            const QStringList& debuginfodUrls)
+{
+    const auto cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QFile file(path);
+    if (cacheDir.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    constexpr qint64 SampleSize = 1024 * 1024;
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    // bump this when the format of the cache changes
+    hash.addData(QByteArrayLiteral("hotspot-perfparser-cache-1"));
+    const auto size = file.size();
+    hash.addData(QByteArray::number(size));
+    hash.addData(file.read(SampleSize));
+    if (size > 2 * SampleSize) {
+        file.seek(size / 2);
+        hash.addData(file.read(SampleSize));
+    }
+    if (size > SampleSize) {
+        file.seek(std::max(SampleSize, size - SampleSize));
+        hash.addData(file.read(SampleSize));
+    }
+
+    const auto parserInfo = QFileInfo(parserBinary);
+    hash.addData(QByteArray::number(parserInfo.size()));
+    hash.addData(parserInfo.lastModified().toString(Qt::ISODateWithMs).toUtf8());
+
+    // the input may be a temporary file with a random name, e.g. for compressed data
+    const auto inputIndex = parserArgs.indexOf(QStringLiteral("--input"));
+    if (inputIndex != -1 && inputIndex + 1 < parserArgs.size()) {
+        parserArgs.removeAt(inputIndex + 1);
+        parserArgs.removeAt(inputIndex);
+    }
+    hash.addData((parserArgs + debuginfodUrls).join(QLatin1Char('\n')).toUtf8());
+    // the kernel symbols are no binary of the recording
+    const auto kallsymsIndex = parserArgs.indexOf(QStringLiteral("--kallsyms"));
+    if (kallsymsIndex != -1 && kallsymsIndex + 1 < parserArgs.size()) {
+        hash.addData(binaryStamp(parserArgs[kallsymsIndex + 1]));
+    }
+
+    return cacheDir + QLatin1String("/perfparser/") + QString::fromLatin1(hash.result().toHex())
+        + QLatin1String(".perfparser");
+}
+
+// remembers the binaries of @p symbols for the cache, rebuilding them invalidates it
+void writePerfparserCacheBinaries(const QString& cacheFile, const QVector<Data::Symbol>& symbols)
+{
+    QSet<QString> paths;
+    for (const auto& symbol : symbols) {
+        const auto& path = symbol.actualPath.isEmpty() ? symbol.path : symbol.actualPath;
+        if (!symbol.isKernel && !path.isEmpty()) {
+            paths.insert(path);
+        }
+    }
+
+    QSaveFile file(perfparserCacheBinariesFile(cacheFile));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    for (const auto& path : std::as_const(paths)) {
+        file.write(binaryStamp(path));
+    }
+    file.commit();
+}
+
+// whether the binaries the cache resolved its symbols from are unchanged, the key of the cache only covers the input
+// and the settings. without a list of binaries yet, e.g. when it got cached in the background, the cache gets used
+bool perfparserCacheUpToDate(const QString& cacheFile)
+{
+    QFile file(perfparserCacheBinariesFile(cacheFile));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return true;
+    }
+    while (!file.atEnd()) {
+        const auto line = file.readLine();
+        const auto path = QString::fromUtf8(line.left(line.indexOf('\t')));
+        if (binaryStamp(path) != line) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// drops the least recently used caches once they exceed @p maxSize bytes, the newest one is always kept
+void prunePerfparserCache(const QString& cacheDir, qint64 maxSize)
+{
+    const auto files = QDir(cacheDir).entryInfoList({QStringLiteral("*.perfparser")}, QDir::Files, QDir::Time);
+    qint64 size = 0;
+    for (int i = 0, c = files.size(); i < c; ++i) {
+        size += files[i].size();
+        if (i > 0 && size > maxSize) {
+            QFile::remove(files[i].absoluteFilePath());
+            QFile::remove(perfparserCacheBinariesFile(files[i].absoluteFilePath()));
+        }
+    }
+}
+
+// the resident set size of hotspot in bytes, 0 when unknown
+qint64 residentMemory()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    const auto fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields[1].toLongLong() * sysconf(_SC_PAGESIZE) : 0;
+}
+
+// perfparser writes its output into a pipe of its own instead of stdout, which hotspot reads with blocking reads
+// of large chunks, see PerfParserPrivate::setInputFd. the pipe of stdout is only 64 KiB large and every chunk
+// of it costs a wakeup of the event loop and a copy into the buffer of QProcess first
+class PerfparserProcess : public QProcess
+{
+public:
+    ~PerfparserProcess()
+    {
+        closeFd(&m_readFd);
+        closeFd(&m_writeFd);
+    }
+
+    // returns the end of the pipe hotspot reads from, or -1 when perfparser writes to stdout as usual
+    int openOutputPipe()
+    {
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) != 0) {
+            return -1;
+        }
+        m_readFd = fds[0];
+        m_writeFd = fds[1];
+        // the size is capped by /proc/sys/fs/pipe-max-size for unprivileged users, 1 MiB by default
+        for (int size = 4 * 1024 * 1024; size > 64 * 1024 && fcntl(m_writeFd, F_SETPIPE_SZ, size) == -1; size /= 2) {
+        }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        setChildProcessModifier([fd = m_writeFd]() { redirectOutput(fd); });
+#endif
+        setStandardOutputFile(QProcess::nullDevice());
+        return m_readFd;
+    }
+
+    // the arguments that make perfparser write into the pipe
+    QStringList outputArgs() const
+    {
+        return m_writeFd == -1 ? QStringList()
+                               : QStringList {QStringLiteral("--output"), QStringLiteral("/dev/fd/%1").arg(OutputFd)};
+    }
+
+    // call this once perfparser got started, then the pipe gets closed when perfparser exits
+    void closeWriteEnd()
+    {
+        closeFd(&m_writeFd);
+    }
+
+protected:
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    void setupChildProcess() override
+    {
+        redirectOutput(m_writeFd);
+    }
+#endif
+
+private:
+    static constexpr int OutputFd = 3;
+
+    // runs in the child between fork and exec
+    static void redirectOutput(int fd)
+    {
+        if (fd == OutputFd) {
+            fcntl(fd, F_SETFD, 0);
+        } else {
+            dup2(fd, OutputFd);
+        }
+    }
+
+    static void closeFd(int* fd)
+    {
+        if (*fd != -1) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+
+    int m_readFd = -1;
+    int m_writeFd = -1;
+};
+
+// runs at the lowest priority right from the start, the threads the process starts inherit it
+class LowPriorityProcess : public QProcess
+{
+public:
+    LowPriorityProcess()
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        setChildProcessModifier([]() { lowerPriority(); });
+#endif
+    }
+
+protected:
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    void setupChildProcess() override
+    {
+        lowerPriority();
+    }
+#endif
+
+private:
+    // runs in the child between fork and exec
+    static void lowerPriority()
+    {
+        setpriority(PRIO_PROCESS, 0, 19);
+    }
+};
+
+// the error message for the exit code of hotspot-perfparser, empty when it succeeded
+QString perfparserExitError(int exitCode)
+{
+    enum ErrorCodes
+    {
+        NoError,
+        TcpSocketError,
+        CannotOpen,
+        BadMagic,
+        HeaderError,
+        DataError,
+        MissingData,
+        InvalidOption
+    };
+    switch (exitCode) {
+    case NoError:
+        return {};
+    case TcpSocketError:
+        return PerfParser::tr("The hotspot-perfparser binary exited with code %1 (TCP socket error).").arg(exitCode);
+    case CannotOpen:
+        return PerfParser::tr("The hotspot-perfparser binary exited with code %1 (file could not be opened).")
+            .arg(exitCode);
+    case BadMagic:
+    case HeaderError:
+    case DataError:
+    case MissingData:
+        return PerfParser::tr("The hotspot-perfparser binary exited with code %1 (invalid perf data file).")
+            .arg(exitCode);
+    case InvalidOption:
+        return PerfParser::tr("The hotspot-perfparser binary exited with code %1 (invalid option).").arg(exitCode);
+    }
+    return PerfParser::tr("The hotspot-perfparser binary exited with code %1.").arg(exitCode);
+}
+
+// a simple blocking queue with a maximum capacity, used to connect the stages of the parse pipeline
+template<typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(int capacity)
+        : m_capacity(capacity)
+    {
+    }
+
+    // blocks while the queue is full, returns false when the queue got aborted
+    bool push(T&& value)
+    {
+        QMutexLocker lock(&m_mutex);
+        while (m_queue.size() >= m_capacity && !m_closed) {
+            m_notFull.wait(&m_mutex);
+        }
+        if (m_closed) {
+            return false;
+        }
+        m_queue.enqueue(std::move(value));
+        m_notEmpty.wakeOne();
+        return true;
+    }
+
+    // blocks while the queue is empty, returns false once the queue got closed and drained
+    bool pop(T* value)
+    {
+        QMutexLocker lock(&m_mutex);
+        while (m_queue.isEmpty() && !m_closed) {
+            m_notEmpty.wait(&m_mutex);
+        }
+        if (m_queue.isEmpty()) {
+            return false;
+        }
+        *value = m_queue.dequeue();
+        m_notFull.wakeOne();
+        return true;
+    }
+
+    // no more values will be pushed, the consumer still gets all queued values
+    void close()
+    {
+        QMutexLocker lock(&m_mutex);
+        m_closed = true;
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+    // drop all queued values and unblock producer and consumer
+    void abort()
+    {
+        QMutexLocker lock(&m_mutex);
+        m_queue.clear();
+        m_closed = true;
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    QQueue<T> m_queue;
+    int m_capacity = 0;
+    bool m_closed = false;
+};
+
+// a batch of raw events, handed from the reading stage to the decoding stage of the parse pipeline
+struct EventBatch
+{
+    struct Event
+    {
+        qint64 offset = 0;
+        quint32 size = 0;
+    };
+
+    // a copy of the event data, unless we parse memory mapped data
+    QByteArray storage;
+    QVector<Event> events;
+};
+
+// a batch of work for the aggregation stage of the parse pipeline
+using AggregationBatch = QVector<std::function<void()>>;
+
+// folded stacks as written by the stackcollapse scripts of flamegraph.pl, bcc's profile -f or async-profiler:
+// one stack per line with the frames separated by semicolons, outermost first, followed by a space and the count
+bool isCollapsedStacks(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    // the binary header of perf.data or of the perfparser output may look like a folded stack by chance
+    const auto magic = file.peek(11);
+    if (magic.startsWith("PERFILE2") || magic.startsWith("PERFFILE") || magic.startsWith("QPERFSTREAM")) {
+        return false;
+    }
+    const auto line = file.readLine(4096).trimmed();
+    const auto separator = line.lastIndexOf(' ');
+    bool ok = false;
+    line.mid(separator + 1).toULongLong(&ok);
+    return ok && separator > 0;
+}
+
+Data::Symbol collapsedStackSymbol(QByteArray frame)
+{
+    // kernel frames are suffixed with _[k], async-profiler also marks jitted and inlined java frames
+    const bool isKernel = frame.endsWith("_[k]");
+    if (isKernel || frame.endsWith("_[j]") || frame.endsWith("_[i]")) {
+        frame.chop(4);
+    }
+
+    // the frames of dtrace and stackcollapse-perf.pl --addrs are prefixed with their module, e.g. libc.so.6`malloc
+    QString binary;
+    const auto separator = frame.indexOf('`');
+    if (separator > 0) {
+        binary = QString::fromUtf8(frame.constData(), separator);
+        frame.remove(0, separator + 1);
+    }
+
+    return Data::internSymbol({QString::fromUtf8(frame), 0, 0, binary, {}, {}, isKernel});
+}
+
+// the counts of perf stat --interval-print, see PerfStat
+bool isPerfStatOutput(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    return PerfStat::isPerfStatOutput(file.read(4096));
+}
+
+struct CollapsedStacks
+{
+    Data::BottomUpResults bottomUp;
+    quint64 numStacks = 0;
+    quint64 totalCost = 0;
+    int numStacksWithMoreThanOneFrame = 0;
+    int numInvalidLines = 0;
+};
+
+// adds the stacks of all complete lines in @p data to @p stacks
+void parseCollapsedStacks(const char* data, qint64 size, CollapsedStacks* stacks)
+{
+    // most frames repeat a lot, so intern them once per shard instead of locking the global symbol table every time
+    // the keys point into the mapped file, which outlives the parsing
+    QHash<QByteArray, Data::Symbol> symbols;
+    QVector<Data::Symbol> frames;
+
+    const auto* end = data + size;
+    for (const auto* line = data; line < end;) {
+        const auto* lineEnd = std::find(line, end, '\n');
+        // trim without copying, the frames have to point into the mapped file
+        const auto* textStart = line;
+        const auto* textEnd = lineEnd;
+        line = lineEnd + 1;
+        while (textStart < textEnd && std::isspace(static_cast<unsigned char>(*textStart))) {
+            ++textStart;
+        }
+        while (textEnd > textStart && std::isspace(static_cast<unsigned char>(*(textEnd - 1)))) {
+            --textEnd;
+        }
+        if (textStart == textEnd) {
+            continue;
+        }
+        const auto text = QByteArray::fromRawData(textStart, static_cast<int>(textEnd - textStart));
+
+        const auto separator = text.lastIndexOf(' ');
+        bool ok = false;
+        const auto cost = text.mid(separator + 1).toULongLong(&ok);
+        if (!ok || separator <= 0) {
+            ++stacks->numInvalidLines;
+            continue;
+        }
+
+        frames.clear();
+        const auto stack = QByteArray::fromRawData(text.constData(), separator);
+        for (int start = 0; start <= stack.size();) {
+            auto frameEnd = stack.indexOf(';', start);
+            if (frameEnd == -1) {
+                frameEnd = stack.size();
+            }
+            const auto frame = QByteArray::fromRawData(stack.constData() + start, frameEnd - start);
+            start = frameEnd + 1;
+            if (frame.isEmpty()) {
+                continue;
+            }
+            auto it = symbols.constFind(frame);
+            if (it == symbols.constEnd()) {
+                it = symbols.insert(frame, collapsedStackSymbol(frame));
+            }
+            frames.push_back(it.value());
+        }
+
+        // the bottom up tree starts at the innermost frame
+        auto* parent = &stacks->bottomUp.root;
+        for (auto it = frames.crbegin(), framesEnd = frames.crend(); it != framesEnd; ++it) {
+            parent = parent->entryForSymbol(*it, &stacks->bottomUp.maxBottomUpId);
+            stacks->bottomUp.costs.add(0, parent->id, cost);
+        }
+        stacks->bottomUp.costs.addTotalCost(0, cost);
+        ++stacks->numStacks;
+        stacks->totalCost += cost;
+        if (frames.size() > 1) {
+            ++stacks->numStacksWithMoreThanOneFrame;
+        }
+    }
+}
+
+// the outermost functions of the user stacks of processes and threads
+// the unwinding of a stack that ends in any other function stopped early, usually at the end of the stack dump
+bool isStackEntryPoint(const QString& symbol)
+{
+    static const auto entryPoints = QSet<QString> {
+        QStringLiteral("_start"), QStringLiteral("_dl_start_user"), QStringLiteral("__libc_start_main"),
+        QStringLiteral("__libc_start_call_main"), QStringLiteral("start_thread"), QStringLiteral("thread_start"),
+        QStringLiteral("clone"), QStringLiteral("clone3"), QStringLiteral("__clone"), QStringLiteral("__clone3"),
+        QStringLiteral("__GI___clone"), QStringLiteral("__GI___clone3"),
+    };
+    return entryPoints.contains(symbol);
+}
+
+// the bytes of the user stack that get copied per sample with the --call-graph dwarf option of @p command,
+// 0 when the stacks weren't recorded with dwarf
+// only the value of the option counts, the workload and its arguments follow the options of perf
+quint32 stackDumpSize(const QString& command)
+{
+    const auto args = command.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+    QString callGraph;
+    for (int i = 0, c = args.size(); i < c && callGraph.isEmpty(); ++i) {
+        const auto& arg = args[i];
+        if (arg == QLatin1String("--")) {
+            break;
+        } else if (arg.startsWith(QLatin1String("--call-graph="))) {
+            callGraph = arg.mid(arg.indexOf(QLatin1Char('=')) + 1);
+        } else if (arg == QLatin1String("--call-graph")) {
+            callGraph = args.value(i + 1);
+        } else if (arg == QLatin1String("-g") && args.value(i + 1).startsWith(QLatin1String("dwarf"))) {
+            // only older perf versions take a value for -g
+            callGraph = args.value(i + 1);
+        }
+    }
+
+    const auto mode = callGraph.section(QLatin1Char(','), 0, 0);
+    if (mode != QLatin1String("dwarf")) {
+        return 0;
+    }
+    const auto size = callGraph.section(QLatin1Char(','), 1, 1);
+    // perf's default
+    return size.isEmpty() ? 8192 : size.toUInt();
+}
+
+// what the scans of the snapshots found out about the events so far, the events only ever get appended while
+// parsing, so every snapshot only has to visit the ones added since the previous one, see EventResults::updateMaxCost,
+// EventResults::updateNumaMigrations and EventResults::countLostEventSamples
+struct SnapshotScan
+{
+    struct Thread
+    {
+        qsizetype scannedEvents = 0;
+        quint64 maxCost = 0;
+        quint64 numaMigrations = 0;
+        qint32 lastNode = -1;
+    };
+    QVector<Thread> threads;
+    QVector<quint64> numaMigrations;
+    // the samples per window of lost events, keyed by the start of the window
+    QHash<quint64, quint32> lostEventSamples;
+
+    void update(const Data::EventResults& events)
+    {
+        threads.resize(events.threads.size());
+
+        qint32 maxNode = -1;
+        for (const auto& cpu : events.cpus) {
+            maxNode = std::max(maxNode, cpu.numaNode);
+        }
+        numaMigrations.resize(maxNode + 1);
+
+        auto isSample = [&events](const Data::Event& event) {
+            return event.type != events.offCpuTimeCostId && event.type != events.lostEventCostId;
+        };
+
+        // windows that appeared since the last scan still need the samples that got scanned before
+        for (const auto& window : events.lostEvents) {
+            if (lostEventSamples.contains(window.time.start)) {
+                continue;
+            }
+            quint32 samples = 0;
+            for (int i = 0, c = events.threads.size(); i < c; ++i) {
+                const auto& threadEvents = events.threads.at(i).events;
+                const auto end = std::min(threadEvents.lowerBound(window.time.end + 1), threads.at(i).scannedEvents);
+                qsizetype run = 0;
+                for (auto j = threadEvents.lowerBound(window.time.start); j < end; ++j) {
+                    samples += isSample(threadEvents.at(j, &run)) ? 1 : 0;
+                }
+            }
+            lostEventSamples.insert(window.time.start, samples);
+        }
+
+        for (int i = 0, c = events.threads.size(); i < c; ++i) {
+            const auto& threadEvents = events.threads.at(i).events;
+            auto& thread = threads[i];
+            qsizetype run = 0;
+            for (auto j = thread.scannedEvents, size = threadEvents.size(); j < size; ++j) {
+                const auto event = threadEvents.at(j, &run);
+                if (event.type == 0) {
+                    thread.maxCost = std::max(thread.maxCost, event.cost);
+                }
+
+                const auto node = maxNode < 0 ? -1 : events.numaNode(event.cpuId);
+                if (node != -1) {
+                    if (thread.lastNode != -1 && node != thread.lastNode) {
+                        ++thread.numaMigrations;
+                        ++numaMigrations[node];
+                    }
+                    thread.lastNode = node;
+                }
+
+                if (!events.lostEvents.isEmpty() && isSample(event)) {
+                    if (const auto* window = events.lostEventsAt(event.time)) {
+                        ++lostEventSamples[window->time.start];
+                    }
+                }
+            }
+            thread.scannedEvents = threadEvents.size();
+        }
+    }
+};
+}
+
+Q_DECLARE_TYPEINFO(AttributesDefinition, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(SampleCost, Q_MOVABLE_TYPE);
+
+class PerfParserPrivate : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PerfParserPrivate(Settings::CostAggregation costAggregation = Settings::CostAggregation::BySymbol,
+                               QObject* parent = nullptr)
+        : QObject(parent)
+        , stopRequested(false)
+        , costAggregation(costAggregation)
+    {
+        buffer.open(QIODevice::ReadOnly);
+        stream.setDevice(&buffer);
+        parseTimer.start();
+
+        if (qEnvironmentVariableIntValue("HOTSPOT_GENERATE_SCRIPT_OUTPUT")) {
+            perfScriptOutput = std::make_unique<QTextStream>(stdout);
+        }
+    }
+
+    ~PerfParserPrivate()
+    {
+        if (pipelineJobs) {
+            decodeQueue->abort();
+            aggregationQueue->abort();
+            pipelineJobs->finish();
+        }
+    }
+
+    // parse on three threads: the calling thread reads the input and splits it into events,
+    // the decode stage decodes the events and interns the stacks, the aggregation
+    // stage finally builds the bottom up and caller/callee data
+    void startPipeline()
+    {
+        // the script output relies on everything to happen in order on one thread
+        if (perfScriptOutput || QThread::idealThreadCount() < 3) {
+            return;
+        }
+
+        decodeQueue = std::make_unique<BoundedQueue<EventBatch>>(PipelineQueueCapacity);
+        aggregationQueue = std::make_unique<BoundedQueue<AggregationBatch>>(PipelineQueueCapacity);
+        pipelineJobs = std::make_unique<ThreadWeaver::Queue>();
+        pipelineJobs->setMaximumNumberOfThreads(2);
+
+        using namespace ThreadWeaver;
+        pipelineJobs->stream() << make_job([this] { runDecodeStage(); });
+        pipelineJobs->stream() << make_job([this] { runAggregationStage(); });
+    }
+
+    // wait for the pipeline to handle all outstanding events, false when that failed
+    bool finishPipeline()
+    {
+        if (!pipelineJobs) {
+            return true;
+        }
+
+        if (!pendingEvents.events.isEmpty()) {
+            decodeQueue->push(std::exchange(pendingEvents, {}));
+        }
+        decodeQueue->close();
+        pipelineJobs->finish();
+        return !pipelineFailed;
+    }
+
+    void runDecodeStage()
+    {
+        ScopedPhase phase("decode");
+        EventBatch batch;
+        while (decodeQueue->pop(&batch)) {
+            const auto* data = mappedData ? mappedData : batch.storage.constData();
+            for (const auto& event : std::as_const(batch.events)) {
+                if (stopRequested || !parseEvent(data + event.offset, event.size)) {
+                    pipelineFailed = true;
+                    decodeQueue->abort();
+                    aggregationQueue->abort();
+                    return;
+                }
+            }
+            maybeSnapshot();
+        }
+
+        if (!pendingAggregation.isEmpty()) {
+            aggregationQueue->push(std::exchange(pendingAggregation, {}));
+        }
+        aggregationQueue->close();
+    }
+
+    void runAggregationStage()
+    {
+        ScopedPhase phase("aggregation");
+        AggregationBatch batch;
+        while (aggregationQueue->pop(&batch)) {
+            for (const auto& aggregation : std::as_const(batch)) {
+                aggregation();
+            }
+        }
+    }
+
+    // hand the event over to the decode stage of the pipeline
+    bool enqueueEvent(const char* data, quint32 size)
+    {
+        if (mappedData) {
+            pendingEvents.events.push_back({data - mappedData, size});
+        } else {
+            pendingEvents.events.push_back({pendingEvents.storage.size(), size});
+            pendingEvents.storage.append(data, static_cast<int>(size));
+        }
+
+        if (pendingEvents.events.size() < PipelineBatchSize && pendingEvents.storage.size() < ReadChunkSize) {
+            return true;
+        }
+        return decodeQueue->push(std::exchange(pendingEvents, {}));
+    }
+
+    // run the aggregation on the aggregation stage of the pipeline, or directly without a pipeline
+    void postAggregation(std::function<void()>&& aggregation)
+    {
+        if (!aggregationQueue) {
+            aggregation();
+            return;
+        }
+
+        pendingAggregation.push_back(std::move(aggregation));
+        if (pendingAggregation.size() >= PipelineBatchSize) {
+            aggregationQueue->push(std::exchange(pendingAggregation, {}));
+        }
+    }
+
+    void setInput(QIODevice* input)
+    {
+        this->input = input;
+        connect(input, &QProcess::readyRead, this, [this] {
+            while (tryParse()) {
+                // just call tryParse until it fails
+            }
+        });
+    }
+
+    bool tryParse()
+    {
+        if (stopRequested) {
+            return false;
+        }
+        switch (state) {
+        case HEADER: {
+            const auto magic = QByteArrayLiteral("QPERFSTREAM");
+            // + 1 to include the trailing \0
+            if (ensureBuffered(magic.size() + 1)) {
+                const auto* data = bufferedData();
+                consumeBuffered(magic.size() + 1);
+                if (QByteArray::fromRawData(data, magic.size()) != magic || data[magic.size()] != '\0') {
+                    state = PARSE_ERROR;
+                    qCWarning(LOG_PERFPARSER) << "Failed to read header magic";
+                    return false;
+                } else {
+                    state = DATA_STREAM_VERSION;
+                    return true;
+                }
+            }
+            break;
+        }
+        case DATA_STREAM_VERSION: {
+            qint32 dataStreamVersion = 0;
+            if (ensureBuffered(sizeof(dataStreamVersion))) {
+                dataStreamVersion = qFromLittleEndian<qint32>(bufferedData());
+                consumeBuffered(sizeof(dataStreamVersion));
+                stream.setVersion(dataStreamVersion);
+                qCDebug(LOG_PERFPARSER) << "data stream version is:" << dataStreamVersion;
+                state = EVENT_HEADER;
+                return true;
+            }
+            break;
+        }
+        case EVENT_HEADER:
+            if (ensureBuffered(sizeof(eventSize))) {
+                eventSize = qFromLittleEndian<quint32>(bufferedData());
+                consumeBuffered(sizeof(eventSize));
+                qCDebug(LOG_PERFPARSER) << "next event size is:" << eventSize;
+                state = EVENT;
+                return true;
+            }
+            break;
+        case EVENT:
+            if (ensureBuffered(eventSize)) {
+                const auto* data = bufferedData();
+                const auto size = eventSize;
+                const bool parsed = decodeQueue ? enqueueEvent(data, size) : parseEvent(data, size);
+                consumeBuffered(size);
+                if (!parsed) {
+                    state = PARSE_ERROR;
+                    return false;
+                }
+                // the decode stage of the pipeline takes the snapshots otherwise
+                if (!decodeQueue && ++numEventsSinceSnapshotCheck == PipelineBatchSize) {
+                    numEventsSinceSnapshotCheck = 0;
+                    maybeSnapshot();
+                }
+                // await next event
+                state = EVENT_HEADER;
+                eventSize = 0;
+                return true;
+            }
+            break;
+        case PARSE_ERROR:
+            // do nothing
+            break;
+        }
+        return false;
+    }
+
+    // imports folded stacks, the file gets split into one shard per core at line boundaries
+    // the shards are parsed in parallel and their trees merged afterwards
+    void parseCollapsedStacks(const char* data, qint64 size)
+    {
+        // there is no information about threads or processes in the stacks
+        costAggregation = Settings::CostAggregation::BySymbol;
+
+        const auto label = PerfParser::tr("samples");
+        const auto numShards = std::max<qint64>(1, std::min<qint64>(QThread::idealThreadCount(), size / (1024 * 1024)));
+        QVector<CollapsedStacks> shards(static_cast<int>(numShards));
+        ThreadWeaver::Queue queue;
+        queue.setMaximumNumberOfThreads(QThread::idealThreadCount());
+        const char* end = data + size;
+        const char* shardStart = data;
+        for (int i = 0; i < numShards; ++i) {
+            const char* shardEnd = i + 1 == numShards ? end : std::find(data + size * (i + 1) / numShards, end, '\n');
+            shardEnd = std::max(shardStart, shardEnd);
+            queue.stream() << ThreadWeaver::make_job([shard = &shards[i], shardStart, shardEnd, label]() {
+                shard->bottomUp.costs.addType(0, label, Data::Costs::Unit::Unknown);
+                ::parseCollapsedStacks(shardStart, shardEnd - shardStart, shard);
+            });
+            shardStart = std::min(end, shardEnd + 1);
+        }
+        queue.finish();
+
+        bottomUpResult = std::move(shards[0].bottomUp);
+        Data::CostSummary costSummary(label, 0, 0, Data::Costs::Unit::Unknown);
+        int numInvalidLines = 0;
+        for (int i = 0; i < numShards; ++i) {
+            if (i > 0) {
+                bottomUpResult.merge(shards[i].bottomUp);
+            }
+            costSummary.sampleCount += shards[i].numStacks;
+            costSummary.totalPeriod += shards[i].totalCost;
+            m_numSamplesWithMoreThanOneFrame += shards[i].numStacksWithMoreThanOneFrame;
+            numInvalidLines += shards[i].numInvalidLines;
+        }
+
+        summaryResult.sampleCount = costSummary.sampleCount;
+        summaryResult.costs = {costSummary};
+        if (numInvalidLines) {
+            summaryResult.errors << PerfParser::tr("Skipped %n lines that are no folded stacks.", nullptr,
+                                                   numInvalidLines);
+        }
+    }
+
+    // imports the counts of perf stat, which has no samples or stacks but counts the events per interval
+    void parsePerfStat(const QByteArray& data)
+    {
+        const PerfStat stat(data);
+        if (!stat.isEmpty()) {
+            // perf stat prints the intervals relative to its start
+            applicationTime = {0, stat.times().last()};
+        }
+        summaryResult.counters = stat.summary();
+        frequencyResult = stat.frequencyResults();
+        if (stat.numInvalidLines()) {
+            summaryResult.errors << PerfParser::tr("Skipped %n lines that are no counts of perf stat.", nullptr,
+                                                   stat.numInvalidLines());
+        }
+    }
+
+    // parse directly from memory mapped file contents, without any intermediate copies
+    void setMappedInput(const uchar* data, qint64 size)
+    {
+        mappedData = reinterpret_cast<const char*>(data);
+        mappedSize = size;
+        readPos = 0;
+        // we read front to back, let the kernel read ahead aggressively
+        posix_madvise(const_cast<uchar*>(data), size, POSIX_MADV_SEQUENTIAL);
+    }
+
+    // read from the pipe @p fd with blocking reads instead of waiting for readyRead, see PerfparserProcess
+    // the parser then has to be driven by calling tryParse until it fails, which means the pipe got closed
+    void setInputFd(int fd)
+    {
+        inputFd = fd;
+        inputFdAtEnd = false;
+    }
+
+    // true when all input was read and every buffered byte got parsed
+    bool isAtEnd() const
+    {
+        return bufferedBytes() == 0 && (mappedData || (inputFd != -1 ? inputFdAtEnd : input->atEnd()));
+    }
+
+    // true once all of the input got parsed and it ended after a complete event
+    bool isCompleteStream() const
+    {
+        return state == EVENT_HEADER && isAtEnd();
+    }
+
+    // everything read from the input gets written to @p copy too
+    void setInputCopy(QIODevice* copy)
+    {
+        inputCopy = copy;
+    }
+
+    qint64 bufferedBytes() const
+    {
+        return (mappedData ? mappedSize : readBuffer.size()) - readPos;
+    }
+
+    const char* bufferedData() const
+    {
+        return (mappedData ? mappedData : readBuffer.constData()) + readPos;
+    }
+
+    void consumeBuffered(qint64 size)
+    {
+        Q_ASSERT(bufferedBytes() >= size);
+        readPos += size;
+    }
+
+    // ensure at least @p size bytes are buffered, reading large chunks from the input at once
+    // this way we don't pay for two QIODevice::read calls per event
+    bool ensureBuffered(qint64 size)
+    {
+        if (bufferedBytes() >= size) {
+            return true;
+        } else if (mappedData) {
+            // the mapped input is complete, there's nothing more to read
+            return false;
+        }
+
+        if (readPos > 0) {
+            readBuffer.remove(0, static_cast<int>(readPos));
+            readPos = 0;
+        }
+
+        if (inputFd != -1) {
+            // this blocks until perfparser wrote enough or closed the pipe
+            while (bufferedBytes() < size && !inputFdAtEnd) {
+                const auto oldSize = readBuffer.size();
+                const auto toRead = std::max(size - bufferedBytes(), ReadChunkSize);
+                readBuffer.resize(static_cast<int>(oldSize + toRead));
+                const auto bytesRead = ::read(inputFd, readBuffer.data() + oldSize, static_cast<size_t>(toRead));
+                readBuffer.resize(static_cast<int>(oldSize + std::max<qint64>(bytesRead, 0)));
+                if (bytesRead > 0) {
+                    if (inputCopy) {
+                        inputCopy->write(readBuffer.constData() + oldSize, bytesRead);
+                    }
+                } else if (bytesRead == 0 || errno != EINTR) {
+                    inputFdAtEnd = true;
+                }
+            }
+            return bufferedBytes() >= size;
+        }
+
+        const auto toRead = std::min(input->bytesAvailable(), std::max(size - bufferedBytes(), ReadChunkSize));
+        if (toRead > 0) {
+            const auto oldSize = readBuffer.size();
+            readBuffer.resize(static_cast<int>(oldSize + toRead));
+            const auto bytesRead = input->read(readBuffer.data() + oldSize, toRead);
+            readBuffer.resize(static_cast<int>(oldSize + std::max(bytesRead, qint64(0))));
+            if (inputCopy && bytesRead > 0) {
+                inputCopy->write(readBuffer.constData() + oldSize, bytesRead);
+            }
+        }
+
+        return bufferedBytes() >= size;
+    }
+
+    bool parseEvent(const char* data, qint64 size)
+    {
+        const Data::ScopedSpillDirectory spill(spillDirectory.get());
+        ByteReader reader(data, size);
+        ++numRecords;
+        // including the size that precedes every event
+        numBytes += size + sizeof(quint32);
+
+        qint8 eventType = 0;
+        reader >> eventType;
+        qCDebug(LOG_PERFPARSER) << "next event is:" << eventType;
+
+        if (!reader.isValid() || eventType < 0 || eventType >= static_cast<qint8>(EventType::InvalidType)) {
+            qCWarning(LOG_PERFPARSER) << "invalid event type" << eventType;
+            return false;
+        }
+
+        // the most common events get decoded straight from the byte span
+        switch (static_cast<EventType>(eventType)) {
+        case EventType::TracePointSample:
+        case EventType::Sample: {
+            // decoding into the same sample again reuses the capacity of its vectors
+            auto& sample = decodedSample;
+            reader >> sample;
+            if (!reader.isValid()) {
+                qCWarning(LOG_PERFPARSER) << "failed to decode sample" << size;
+                return false;
+            }
+            qCDebug(LOG_PERFPARSER) << "parsed:" << sample;
+            for (auto& sampleCost : sample.costs) {
+                if (!sampleCost.cost) {
+                    const auto& attribute = attributes.value(sampleCost.attributeId);
+                    if (!attribute.usesFrequency) {
+                        sampleCost.cost = attribute.frequencyOrPeriod;
+                    }
+                }
+            }
+
+            addRecord(sample);
+
+            if (!isAllowedByRestriction(sample)) {
+                break;
+            }
+
+            if (static_cast<EventType>(eventType) == EventType::TracePointSample) {
+                // the payload of the tracepoint follows the sample
+                const TracepointPayload payload {reader.position(), data + size - reader.position()};
+                addSample(sample, &payload);
+                return true;
+            }
+
+            addSample(sample);
+            break;
+        }
+        case EventType::LocationDefinition: {
+            LocationDefinition locationDefinition;
+            reader >> locationDefinition;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << locationDefinition;
+            addLocation(locationDefinition);
+            break;
+        }
+        case EventType::SymbolDefinition: {
+            SymbolDefinition symbolDefinition;
+            reader >> symbolDefinition;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << symbolDefinition;
+            addSymbol(symbolDefinition);
+            break;
+        }
+        default:
+            return parseStreamedEvent(data, size, eventType);
+        }
+
+        if (!reader.atEnd()) {
+            qCWarning(LOG_PERFPARSER) << "did not consume all bytes for event of type" << eventType << size;
+            return false;
+        }
+
+        return true;
+    }
+
+    // slow path for the rarely occurring events, decoded through QDataStream
+    bool parseStreamedEvent(const char* data, qint64 size, qint8 eventType)
+    {
+        Q_ASSERT(buffer.isOpen());
+        Q_ASSERT(buffer.isReadable());
+
+        // no need to copy, the data stays alive while we are parsing this event
+        buffer.buffer() = QByteArray::fromRawData(data, static_cast<int>(size));
+        // skip the event type
+        buffer.seek(1);
+
+        stream.resetStatus();
+
+        switch (static_cast<EventType>(eventType)) {
+        case EventType::ThreadStart: {
+            ThreadStart threadStart;
+            stream >> threadStart;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << threadStart;
+            addRecord(threadStart);
+            // override start time explicitly
+            auto thread = addThread(threadStart);
+            thread->time.start = threadStart.time;
+            if (threadStart.ppid != threadStart.pid) {
+                const auto parentComm = commands.names.value(threadStart.ppid).value(threadStart.ppid);
+                commands.names[threadStart.pid][threadStart.pid] = parentComm;
+                aggregationRoots.clear();
+                thread->name = parentComm;
+            }
+            // check if perf-$pid.map file exists
+            perfMapFileExists |= QFile::exists(QDir::tempPath() + QDir::separator()
+                                               + QLatin1String("perf-%1.map").arg(QString::number(thread->pid)));
+            break;
+        }
+        case EventType::ThreadEnd: {
+            ThreadEnd threadEnd;
+            stream >> threadEnd;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << threadEnd;
+            addRecord(threadEnd);
+            addThreadEnd(threadEnd);
+            break;
+        }
+        case EventType::Command: {
+            Command command;
+            stream >> command;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << command;
+            addRecord(command);
+            addCommand(command);
+            break;
+        }
+        case EventType::AttributesDefinition: {
+            AttributesDefinition attributesDefinition;
+            stream >> attributesDefinition;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << attributesDefinition;
+            addAttributes(attributesDefinition);
+            break;
+        }
+        case EventType::StringDefinition: {
+            StringDefinition stringDefinition;
+            stream >> stringDefinition;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << stringDefinition;
+            addString(stringDefinition);
+            break;
+        }
+        case EventType::LostDefinition: {
+            LostDefinition lostDefinition;
+            stream >> lostDefinition;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << lostDefinition;
+            addRecord(lostDefinition);
+            addLost(lostDefinition);
+            break;
+        }
+        case EventType::FeaturesDefinition: {
+            FeaturesDefinition featuresDefinition;
+            stream >> featuresDefinition;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << featuresDefinition;
+            setFeatures(featuresDefinition);
+            break;
+        }
+        case EventType::Error: {
+            Error error;
+            stream >> error;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << error;
+            addError(error);
+            break;
+        }
+        case EventType::ContextSwitchDefinition: {
+            ContextSwitchDefinition contextSwitch;
+            stream >> contextSwitch;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << contextSwitch;
+            addRecord(contextSwitch);
+            addContextSwitch(contextSwitch);
+            break;
+        }
+        case EventType::Progress: {
+            float percent = 0;
+            stream >> percent;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << percent;
+            lastPercent = percent;
+            emit progress(percent);
+            reportProgress(Data::ParseProgress::Phase::Parse);
+            break;
+        }
+        case EventType::DebugInfoDownloadProgress: {
+            StringId module;
+            StringId url;
+            qint64 numerator = 0;
+            qint64 denominator = 0;
+            stream >> module >> url >> numerator >> denominator;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << url << numerator << denominator;
+            emit debugInfoDownloadProgress(strings.value(module.id), strings.value(url.id), numerator, denominator);
+            break;
+        }
+        case EventType::TracePointFormat: {
+            TracePointFormat format;
+            stream >> format;
+            qCDebug(LOG_PERFPARSER) << "parsed:" << format;
+            addTracepointFormat(format);
+            break;
+        }
+        case EventType::Sample:
+        case EventType::TracePointSample:
+        case EventType::LocationDefinition:
+        case EventType::SymbolDefinition:
+            // handled in parseEvent already
+            Q_UNREACHABLE();
             break;
+        case EventType::InvalidType:
+            break;
+        }
+
+        if (!stream.atEnd()) {
+            qCWarning(LOG_PERFPARSER) << "did not consume all bytes for event of type" << eventType << buffer.pos()
+                                      << buffer.size();
+            return false;
+        }
+
+        return true;
+    }
+
+    // the aggregated results parsed so far, built on copies so that parsing can continue afterwards
+    struct Snapshot
+    {
+        Data::Summary summary;
+        Data::BottomUpResults bottomUp;
+        Data::TopDownResults topDown;
+        Data::PerLibraryResults perLibrary;
+        Data::CallerCalleeResults callerCallee;
+        Data::EventResults events;
+        // the timeline of a running recording is left out, it grows with the duration of the recording
+        bool hasTimeline = false;
+    };
+
+    Snapshot snapshot()
+    {
+        Q_ASSERT(!pipelineJobs);
+
+        auto snapshot = beginSnapshot(false);
+        completeSnapshot(&snapshot);
+        return snapshot;
+    }
+
+    // copies the results of the decoding, with a pipeline this has to run on its decode stage
+    Snapshot beginSnapshot(bool withTimeline)
+    {
+        Snapshot snapshot;
+        snapshot.summary = summaryResult;
+        snapshot.summary.applicationTime = applicationTime;
+        snapshot.summary.threadCount = uniqueThreads.size();
+        snapshot.summary.processCount = uniqueProcess.size();
+
+        // the copy shares the event columns, the parser only appends behind the values the snapshot holds
+        snapshot.events = eventResult;
+        snapshot.hasTimeline = withTimeline;
+        if (withTimeline) {
+            finalizeSnapshotEvents(&snapshot.events, &snapshot.summary);
+        }
+        return snapshot;
+    }
+
+    // adds the aggregated results, with a pipeline this has to run on its aggregation stage
+    void completeSnapshot(Snapshot* snapshot) const
+    {
+        if (previewStride > 1) {
+            // the preview has fewer nodes than the full results, which makes deriving the other results cheaper
+            snapshot->bottomUp = previewBottomUp;
+            snapshot->bottomUp.symbols = bottomUpResult.symbols;
+            snapshot->bottomUp.locations = bottomUpResult.locations;
+        } else {
+            snapshot->bottomUp = bottomUpResult;
+        }
+        Data::BottomUp::initializeParents(&snapshot->bottomUp.root);
+        snapshot->summary.topCosts = Data::TopCosts::fromBottomUp(snapshot->bottomUp, skipFirstLevel());
+
+        // the snapshots never overlap, so they can share one queue
+        if (!snapshotQueue) {
+            snapshotQueue = std::make_unique<ThreadWeaver::Queue>();
+            snapshotQueue->setMaximumNumberOfThreads(QThread::idealThreadCount());
+        }
+        snapshot->topDown = ::topDownFromBottomUpData(snapshotQueue.get(), snapshot->bottomUp, skipFirstLevel());
+        snapshot->perLibrary = ::perLibraryFromTopDownData(snapshotQueue.get(), snapshot->topDown);
+
+        snapshot->callerCallee.locations =
+            std::make_shared<const Data::LocationCostIndex>(snapshot->bottomUp, snapshot->events);
+        ::callerCalleesFromBottomUpData(snapshotQueue.get(), snapshot->bottomUp, &snapshot->callerCallee);
+    }
+
+    // passes a snapshot to @p publish every @p interval ms while parsing, unless @p accepts returns false
+    // the first one gets taken after @p firstInterval ms already
+    void enableSnapshots(int firstInterval, int interval, std::function<bool()> accepts,
+                         std::function<void(const Snapshot&)> publish)
+    {
+        snapshotInterval = firstInterval;
+        nextSnapshotInterval = interval;
+        acceptsSnapshot = std::move(accepts);
+        snapshotAvailable = std::move(publish);
+        snapshotTimer.start();
+    }
+
+    // called on the thread that decodes the events, the snapshot gets completed once the events decoded
+    // so far got aggregated
+    void maybeSnapshot()
+    {
+        if (!snapshotAvailable || snapshotInFlight || snapshotTimer.elapsed() < snapshotInterval
+            || !acceptsSnapshot()) {
+            return;
+        }
+
+        snapshotInFlight = true;
+        postAggregation([this, snapshot = beginSnapshot(true)]() mutable {
+            completeSnapshot(&snapshot);
+            snapshotAvailable(snapshot);
+            snapshotInterval = nextSnapshotInterval;
+            snapshotTimer.restart();
+            snapshotInFlight = false;
+        });
+        if (aggregationQueue) {
+            aggregationQueue->push(std::exchange(pendingAggregation, {}));
+        }
+    }
+
+    static void finalizeEvents(Data::EventResults* events, Data::Summary* summary,
+                               const Data::TimeRange& applicationTime)
+    {
+        finalizeThreads(events, summary, applicationTime);
+        for (auto& thread : events->threads) {
+            thread.updateMaxCost();
+        }
+        events->updateMaxCost();
+        events->updateNumaMigrations();
+        events->countLostEventSamples();
+        finalizeCpus(events, summary);
+    }
+
+    // like finalizeEvents, but the scans over the events only visit the ones added since the last snapshot
+    // this has to run on the decode stage, like beginSnapshot
+    void finalizeSnapshotEvents(Data::EventResults* events, Data::Summary* summary)
+    {
+        finalizeThreads(events, summary, applicationTime);
+        snapshotScan.update(*events);
+
+        events->maxCost = 0;
+        for (int i = 0, c = events->threads.size(); i < c; ++i) {
+            auto& thread = events->threads[i];
+            const auto& scan = snapshotScan.threads.at(i);
+            thread.maxCost = scan.maxCost;
+            thread.numaMigrations = scan.numaMigrations;
+            events->maxCost = std::max(events->maxCost, thread.maxCost);
+        }
+        events->numaMigrations = snapshotScan.numaMigrations;
+        for (auto& window : events->lostEvents) {
+            window.samples = snapshotScan.lostEventSamples.value(window.time.start);
+        }
+        finalizeCpus(events, summary);
+    }
+
+    static void finalizeThreads(Data::EventResults* events, Data::Summary* summary,
+                                const Data::TimeRange& applicationTime)
+    {
+        for (auto& thread : events->threads) {
+            thread.time.start = std::max(thread.time.start, applicationTime.start);
+            thread.time.end = std::min(thread.time.end, applicationTime.end);
+            if (thread.name.isEmpty()) {
+                thread.name = PerfParser::tr("#%1").arg(thread.tid);
+            }
+
+            // we may have been switched out before detaching perf, so increment
+            // the off-CPU time in this case
+            if (thread.state == Data::ThreadEvents::OffCpu) {
+                const auto switchTime = thread.time.end - thread.lastSwitchTime;
+                thread.offCpuTime += switchTime;
+                thread.offCpuDurations.add(switchTime);
+            }
+
+            if (thread.offCpuTime > 0) {
+                summary->offCpuTime += thread.offCpuTime;
+                summary->onCpuTime += thread.time.delta() - thread.offCpuTime;
+                summary->onCpuSlices.merge(thread.onCpuSlices);
+                summary->offCpuDurations.merge(thread.offCpuDurations);
+            }
+        }
+    }
+
+    static void finalizeCpus(Data::EventResults* events, Data::Summary* summary)
+    {
+        {
+            uint cpuId = 0;
+            for (auto& cpu : events->cpus) {
+                cpu.cpuId = cpuId++;
+            }
+        }
+
+        events->totalCosts = summary->costs;
+    }
+
+    // once the results exceed the budget the remaining events get spilled, they make up most of the memory
+    // the columns move over to the spill directory of this parse the next time they grow, see Data::ColumnBuffer
+    // the caller/callee results only get built once all events got parsed, so they can't count here
+    void checkMemoryBudget()
+    {
+        numSamplesSinceBudgetCheck = 0;
+        if (memoryBudgetExceeded) {
+            return;
+        }
+        const auto usage =
+            Data::MemoryUsage::fromResults(bottomUpResult, {}, eventResult, frequencyResult, tracepointResult);
+        if (usage.total() < memoryBudget) {
+            return;
+        }
+
+        memoryBudgetExceeded = true;
+        if (Data::spillDirectory().isEmpty()) {
+            const auto path =
+                QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/spilled-events");
+            if (QDir().mkpath(path)) {
+                spillDirectory->setPath(path);
+            }
+        }
+    }
+
+    // the directory the events got spilled to, see checkMemoryBudget
+    QString spillPath() const
+    {
+        const auto path = spillDirectory->path();
+        return path.isEmpty() ? Data::spillDirectory() : path;
+    }
+
+    // only call this on the decode stage, or once it finished
+    void reportProgress(Data::ParseProgress::Phase phase)
+    {
+        Data::ParseProgress progress;
+        progress.phase = phase;
+        progress.percent = lastPercent;
+        progress.records = numRecords;
+        progress.bytes = numBytes;
+        progress.elapsed = parseTimer.elapsed();
+        if (progress.elapsed > 0) {
+            progress.recordsPerSecond = numRecords * 1000. / progress.elapsed;
+            progress.bytesPerSecond = numBytes * 1000. / progress.elapsed;
+        }
+        if (phase == Data::ParseProgress::Phase::Parse && lastPercent > 0 && lastPercent < 1) {
+            progress.remaining = static_cast<qint64>(progress.elapsed * (1 - lastPercent) / lastPercent);
+        }
+        progress.uniqueStacks = eventResult.stacks.size();
+        progress.uniqueSymbols = numSymbolDefinitions;
+        progress.residentMemory = residentMemory();
+        emit parseProgress(progress);
+    }
+
+    void finalize()
+    {
+        ScopedPhase phase("finalize");
+        const Data::ScopedSpillDirectory spill(spillDirectory.get());
+        if (memoryBudget > 0) {
+            checkMemoryBudget();
+        }
+        Data::BottomUp::initializeParents(&bottomUpResult.root);
+
+        summaryResult.applicationTime = applicationTime;
+        summaryResult.topCosts = Data::TopCosts::fromBottomUp(bottomUpResult, skipFirstLevel());
+        summaryResult.threadCount = uniqueThreads.size();
+        summaryResult.processCount = uniqueProcess.size();
+
+        finalizeEvents(&eventResult, &summaryResult, applicationTime);
+
+        // summarize the frequencies here, so the plot doesn't have to visit every value on the GUI thread
+        for (auto& core : frequencyResult.cores) {
+            for (auto& costType : core.costs) {
+                costType.pyramid.build(costType.values);
+            }
+        }
+
+        finalizeTruncatedStacks();
+
+        // Add error messages for all modules with missing debug symbols
+        for (auto i = numSymbolsByModule.begin(); i != numSymbolsByModule.end(); ++i) {
+            const auto& numSymbols = i.value();
+            if (!numSymbols.missing)
+                continue;
+
+            const auto& moduleName = strings.value(i.key());
+            summaryResult.errors << PerfParser::tr("Module \"%1\" is missing %2 of %3 debug symbols.")
+                                        .arg(moduleName)
+                                        .arg(numSymbols.missing)
+                                        .arg(numSymbols.total);
+        }
+    }
+
+    // reports the threads and binaries with truncated stacks and suggests a larger stack dump when too many of them
+    // got truncated. as perf doesn't tell where the unwinding stopped, this can't tell how much larger it has to be
+    void finalizeTruncatedStacks()
+    {
+        summaryResult.stackDumpSize = stackDumpSize(summaryResult.command);
+        if (!summaryResult.stackDumpSize) {
+            return;
+        }
+        summaryResult.userStackCount = numUserStacks;
+
+        using TruncatedStacks = std::pair<std::pair<qint32, qint32>, quint64>;
+        QVector<TruncatedStacks> sorted;
+        sorted.reserve(truncatedStacks.size());
+        for (auto it = truncatedStacks.cbegin(), end = truncatedStacks.cend(); it != end; ++it) {
+            summaryResult.truncatedStackCount += it.value();
+            sorted.push_back({it.key(), it.value()});
+        }
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const TruncatedStacks& lhs, const TruncatedStacks& rhs) { return lhs.second > rhs.second; });
+
+        constexpr int MaxReportedThreads = 10;
+        for (int i = 0, c = std::min<int>(sorted.size(), MaxReportedThreads); i < c; ++i) {
+            const auto [threadIndex, binaryId] = sorted[i].first;
+            const auto& thread = eventResult.threads.at(threadIndex);
+            const auto binary = binaryId == -1 ? QStringLiteral("??") : strings.value(binaryId);
+            summaryResult.errors << PerfParser::tr("%n stack(s) of thread %1 (%2) end in %3 instead of an entry point.",
+                                                   nullptr, static_cast<int>(sorted[i].second))
+                                        .arg(thread.name, QString::number(thread.tid), binary);
+        }
+
+        // perf rounds the size to multiples of 8 and limits it to 16 bits
+        constexpr quint32 MaxStackDumpSize = 65528;
+        // a few stacks always get truncated, e.g. the ones of the JIT code that has no unwind info
+        constexpr quint64 TruncatedStacksPercentThreshold = 1;
+        if (summaryResult.stackDumpSize < MaxStackDumpSize
+            && summaryResult.truncatedStackCount * 100
+                > summaryResult.userStackCount * TruncatedStacksPercentThreshold) {
+            summaryResult.suggestedStackDumpSize = std::min(MaxStackDumpSize, summaryResult.stackDumpSize * 2);
+        }
+    }
+
+    qint32 addCostType(const QString& label, Data::Costs::Unit unit)
+    {
+        auto costId = m_nextCostId;
+        m_nextCostId++;
+
+        if (label == QLatin1String("sched:sched_switch")) {
+            m_schedSwitchCostId = costId;
+        }
+
+        Q_ASSERT(summaryResult.costs.size() == costId);
+        summaryResult.costs.push_back({label, 0, 0, unit});
+        postAggregation([this, costId, label, unit]() {
+            Q_ASSERT(bottomUpResult.costs.numTypes() == costId);
+            bottomUpResult.costs.addType(costId, label, unit);
+            previewBottomUp.costs.addType(costId, label, unit);
+        });
+
+        return costId;
+    }
+
+    void addAttributes(const AttributesDefinition& attributesDefinition)
+    {
+        qint32 costId = attributeNameToCostIds.value(attributesDefinition.name.id, -1);
+
+        if (costId == -1 && strings.value(attributesDefinition.name.id) == QLatin1String("offcpu-time")) {
+            // perf record --off-cpu aggregates the off-CPU time per stack with BPF and writes it out as samples
+            // with the blocked time as period at the end of the recording, so there are no context switches
+            if (eventResult.offCpuTimeCostId == -1) {
+                const auto label = PerfParser::tr("off-CPU Time");
+                eventResult.offCpuTimeCostId = addCostType(label, Data::Costs::Unit::Time);
+            }
+            eventResult.offCpuTimeSampled = true;
+            costId = eventResult.offCpuTimeCostId;
+            attributeNameToCostIds.insert(attributesDefinition.name.id, costId);
+        }
+
+        if (costId == -1) {
+            const auto label = strings.value(attributesDefinition.name.id);
+            auto unit = [&] {
+                if (attributesDefinition.type == static_cast<quint32>(AttributesDefinition::Type::Tracepoint))
+                    return Data::Costs::Unit::Tracepoint;
+                return Data::Costs::Unit::Unknown;
+            }();
+            costId = addCostType(label, unit);
+            attributeNameToCostIds.insert(attributesDefinition.name.id, costId);
+        }
+
+        attributeIdsToCostIds[attributesDefinition.id] = costId;
+        Q_ASSERT(attributes.size() == attributesDefinition.id);
+        attributes.push_back(attributesDefinition);
+    }
+
+    Data::ThreadEvents* addThread(const Record& record)
+    {
+        Data::ThreadEvents thread;
+        thread.pid = record.pid;
+        thread.tid = record.tid;
+        // when we encounter a thread the first time it was probably alive when
+        // we started the application, otherwise we override the start time when
+        // we encounter a ThreadStart event
+        thread.time.start = applicationTime.start;
+        thread.name = commands.names.value(thread.pid).value(thread.tid);
+        if (thread.name.isEmpty() && thread.pid != thread.tid)
+            thread.name = commands.names.value(thread.pid).value(thread.pid);
+        eventResult.threads.push_back(thread);
+        return &eventResult.threads.last();
+    }
+
+    void addThreadEnd(const ThreadEnd& threadEnd)
+    {
+        auto* thread = eventResult.findThread(threadEnd.pid, threadEnd.tid);
+        if (thread) {
+            thread->time.end = threadEnd.time;
+        }
+    }
+
+    void addCommand(const Command& command)
+    {
+        const auto& comm = strings.value(command.comm.id);
+        // check if this changes the name of a current thread
+        auto* thread = eventResult.findThread(command.pid, command.tid);
+        if (thread) {
+            thread->name = comm;
+        }
+        // and remember the command, maybe a future ThreadStart event references it
+        commands.names[command.pid][command.tid] = comm;
+        aggregationRoots.clear();
+        if (restriction.commands.contains(comm)) {
+            restrictedCommandPids.insert(command.pid);
+        }
+    }
+
+    // perf reports the commands of the processes before their samples, see addCommand
+    bool isAllowedByRestriction(const Sample& sample) const
+    {
+        if (!restriction.acceptsCpu(sample.cpu)) {
+            return false;
+        }
+        // the restricted time is relative to the first event, just like the time shown in the time line
+        if (!restriction.time.contains(sample.time - applicationTime.start)) {
+            return false;
+        }
+        const auto pid = static_cast<qint32>(sample.pid);
+        return !restriction.restrictsProcesses() || restriction.pids.contains(pid)
+            || restrictedCommandPids.contains(pid);
+    }
+
+    void addLocation(const LocationDefinition& location)
+    {
+        QString file;
+        if (location.location.file.id != -1) {
+            file = strings.value(location.location.file.id);
         }
-        case EventType::Command: {
-            Command command;
-            stream >> command;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << command;
-            addRecord(command);
-            addCommand(command);
-            break;
+        Data::FrameLocation frameLocation = {
+            location.location.parentLocationId,
+            {location.location.address, location.location.relAddr, {file, location.location.line}}};
+
+        // the JIT code is resolved with the index of the map right away, perfparser reads the whole map instead
+        // and misses the code that got compiled after it did so
+        Data::Symbol symbol;
+        if (const auto* perfMap = perfMapIndex(location.location.pid)) {
+            if (const auto* entry = perfMap->find(location.location.address)) {
+                const auto& mapPath = perfMapPaths.value(location.location.pid);
+                symbol = Data::internSymbol({perfMap->name(*entry), entry->start, entry->size,
+                                             QFileInfo(mapPath).fileName(), mapPath, mapPath});
+                perfMapLocations.insert(location.id);
+                stackPruning.addSymbol(location.id, symbol.symbol, symbol.binary);
+            }
         }
-        case EventType::LocationDefinition: {
-            LocationDefinition locationDefinition;
-            stream >> locationDefinition;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << locationDefinition;
-            addLocation(locationDefinition);
-            break;
+
+        postAggregation([this, id = location.id, frameLocation, symbol]() {
+            Q_ASSERT(bottomUpResult.locations.size() == id);
+            Q_ASSERT(bottomUpResult.symbols.size() == id);
+            Q_UNUSED(id);
+            bottomUpResult.locations.push_back(frameLocation);
+            bottomUpResult.symbols.push_back(symbol);
+        });
+    }
+
+    // the index of the perf map of @p pid, nullptr when it has none
+    const PerfMapIndex* perfMapIndex(quint32 pid)
+    {
+        if (perfMapDir.isEmpty()) {
+            return nullptr;
         }
-        case EventType::SymbolDefinition: {
-            SymbolDefinition symbolDefinition;
-            stream >> symbolDefinition;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << symbolDefinition;
-            addSymbol(symbolDefinition);
-            break;
+        auto it = perfMaps.find(pid);
+        if (it == perfMaps.end()) {
+            const auto path = perfMapDir + QLatin1String("/perf-%1.map").arg(pid);
+            auto index = QFile::exists(path) ? PerfMapIndex::load(path, perfMapCacheDirectory) : nullptr;
+            if (index) {
+                perfMapPaths.insert(pid, path);
+            }
+            it = perfMaps.insert(pid, std::move(index));
         }
-        case EventType::AttributesDefinition: {
-            AttributesDefinition attributesDefinition;
-            stream >> attributesDefinition;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << attributesDefinition;
-            addAttributes(attributesDefinition);
-            break;
+        return it->get();
+    }
+
+    void addSymbol(const SymbolDefinition& symbol)
+    {
+        const auto symbolString = strings.value(symbol.symbol.name.id);
+        if (symbolString.isEmpty() && perfMapLocations.contains(symbol.id)) {
+            // keep the symbol from the perf map
+            return;
         }
-        case EventType::StringDefinition: {
-            StringDefinition stringDefinition;
-            stream >> stringDefinition;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << stringDefinition;
-            addString(stringDefinition);
-            break;
+        const auto relAddr = symbol.symbol.relAddr;
+        const auto size = symbol.symbol.size;
+        // copies of the string table entries, which share their data, internSymbol shares them across parsers
+        const auto binaryString = strings.value(symbol.symbol.binary.id);
+        const auto pathString = strings.value(symbol.symbol.path.id);
+        const auto actualPathString = strings.value(symbol.symbol.actualPath.id);
+        const auto isKernel = symbol.symbol.isKernel;
+        const auto isInline = symbol.symbol.isInline;
+        postAggregation([this, id = symbol.id,
+                         resolved = Data::internSymbol({symbolString, relAddr, size, binaryString, pathString,
+                                                        actualPathString, isKernel, isInline})]() {
+            // empty symbol was added in addLocation already
+            Q_ASSERT(bottomUpResult.symbols.size() > id);
+            bottomUpResult.symbols[id] = resolved;
+        });
+
+        stackPruning.addSymbol(symbol.id, symbolString, binaryString);
+        if (stackEnds.size() <= symbol.id) {
+            stackEnds.resize(symbol.id + 1);
         }
-        case EventType::LostDefinition: {
-            LostDefinition lostDefinition;
-            stream >> lostDefinition;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << lostDefinition;
-            addRecord(lostDefinition);
-            addLost(lostDefinition);
-            break;
+        stackEnds[symbol.id] = {symbol.symbol.binary.id, isKernel, isStackEntryPoint(symbolString)};
+
+        ++numSymbolDefinitions;
+        // Count total and missing symbols per module for error report
+        auto& numSymbols = numSymbolsByModule[symbol.symbol.binary.id];
+        ++numSymbols.total;
+        if (symbolString.isEmpty() && !binaryString.isEmpty()) {
+            ++numSymbols.missing;
+        }
+    }
+
+    // the stacks get interned in a trie that starts at the outermost frame, so stacks share the nodes of their
+    // common callers and interning a stack is a lookup of one integer key per frame
+    qint32 internStack(const QVector<qint32>& frames)
+    {
+        qint32 node = 0;
+        for (auto it = frames.crbegin(), end = frames.crend(); it != end; ++it) {
+            const auto key = (static_cast<quint64>(node) << 32) | static_cast<quint32>(*it);
+            auto child = stackNodes.constFind(key);
+            if (child == stackNodes.constEnd()) {
+                child = stackNodes.insert(key, stackNodeIds.size());
+                stackNodeIds.push_back(-1);
+            }
+            node = child.value();
+        }
+
+        auto& id = stackNodeIds[node];
+        if (id == -1) {
+            id = eventResult.stacks.size();
+            eventResult.stacks.push_back(frames);
+        }
+        return id;
+    }
+
+    void addSampleToFrequencyData(const Sample& sample)
+    {
+        auto& lastTime = m_lastSampleTimePerCore[sample.cpu];
+        auto updateTime = qScopeGuard([&]() { lastTime = sample.time; });
+        if (!lastTime) {
+            return;
+        }
+
+        if (static_cast<quint32>(frequencyResult.cores.size()) <= sample.cpu) {
+            frequencyResult.cores.resize(sample.cpu + 1);
+        }
+
+        auto& core = frequencyResult.cores[sample.cpu];
+        for (const auto& cost : sample.costs) {
+            if (core.costs.size() <= cost.attributeId) {
+                const auto oldSize = core.costs.size();
+                const auto newSize = cost.attributeId + 1;
+                core.costs.resize(newSize);
+
+                for (int i = oldSize; i < newSize; i++) {
+                    core.costs[i].costName = strings.at(attributes[i].name.id);
+                }
+            }
+
+            auto& costs = core.costs[cost.attributeId];
+
+            auto frequency = static_cast<double>(cost.cost) / (sample.time - lastTime);
+            costs.values.push_back({sample.time, frequency});
+        }
+    }
+
+    // the undecoded payload that follows a tracepoint sample
+    struct TracepointPayload
+    {
+        const char* data = nullptr;
+        qint64 size = 0;
+    };
+
+    // decodes the fields of @p payload into payloadFields, which keeps its memory for the next tracepoint
+    // perfparser writes the fields as a QHash<qint32, QVariant>, reading them one by one skips building the hash
+    void decodeTracepointPayload(const TracepointPayload& payload)
+    {
+        payloadFields.clear();
+        if (payload.size <= 0) {
+            return;
+        }
+
+        // the field values are arbitrary variants, decoding them through QDataStream is fine for these rare events
+        QDataStream payloadStream(QByteArray::fromRawData(payload.data, static_cast<int>(payload.size)));
+        payloadStream.setVersion(stream.version());
+        quint32 numFields = 0;
+        payloadStream >> numFields;
+        for (quint32 i = 0; i < numFields && payloadStream.status() == QDataStream::Ok; ++i) {
+            qint32 name = 0;
+            QVariant value;
+            payloadStream >> name >> value;
+            payloadFields.push_back({name, value});
+        }
+        if (payloadStream.status() != QDataStream::Ok) {
+            qCWarning(LOG_PERFPARSER) << "failed to decode tracepoint payload" << payload.size;
+            payloadFields.clear();
+        }
+    }
+
+    void addTracepointFormat(const TracePointFormat& format)
+    {
+        const auto name = strings.value(format.system.id) + QLatin1Char(':') + strings.value(format.name.id);
+        tracepointFormatNames.insert(format.id, name);
+    }
+
+    // store the decoded payloadFields in the table of its tracepoint type, returns the table index
+    qint32 addTracepointPayload(const AttributesDefinition& attribute, const Sample& sample, qint32 stackId)
+    {
+        // the config of tracepoint attributes is the id of their format
+        const auto formatId = static_cast<qint32>(attribute.config);
+        auto tableIt = tracepointTables.find(formatId);
+        if (tableIt == tracepointTables.end()) {
+            Data::TracepointTable table;
+            table.name = tracepointFormatNames.value(formatId, strings.value(attribute.name.id));
+            tracepointResult.tables.push_back(table);
+            tableIt = tracepointTables.insert(formatId, {static_cast<qint32>(tracepointResult.tables.size() - 1), {}});
+        }
+
+        auto& table = tracepointResult.tables[tableIt->table];
+        const auto row = table.size();
+        table.times.push_back(sample.time);
+        table.threadIds.push_back(static_cast<qint32>(sample.tid));
+        table.stackIds.push_back(stackId);
+        for (const auto& nameAndValue : std::as_const(payloadFields)) {
+            auto fieldIt = tableIt->fields.constFind(nameAndValue.first);
+            if (fieldIt == tableIt->fields.constEnd()) {
+                // a new field, the previous rows don't have a value for it
+                Data::TracepointField field;
+                field.name = strings.value(nameAndValue.first);
+                field.values.resize(row);
+                fieldIt = tableIt->fields.insert(nameAndValue.first, table.fields.size());
+                table.fields.push_back(field);
+            }
+            auto& field = table.fields[fieldIt.value()];
+            if (field.size() == row) {
+                field.append(nameAndValue.second);
+            }
+        }
+        for (auto& field : table.fields) {
+            if (field.size() == row) {
+                // not part of this payload
+                field.append({});
+            }
+        }
+        return tableIt->table;
+    }
+
+    // pairs raw_syscalls:sys_enter with the next raw_syscalls:sys_exit of the same thread, the time in between becomes
+    // the syscall time cost of the stack that entered the syscall. the event gets added at the exit, as the events of
+    // a thread have to stay ordered by time. like the off-CPU time, it only gets added to the thread
+    // the syscall id is taken from the decoded payloadFields
+    void addSyscallTracepoint(const QString& name, const Sample& sample, qint32 stackId, Data::ThreadEvents* thread)
+    {
+        const bool isEnter = name == QLatin1String("raw_syscalls:sys_enter");
+        if (!isEnter && name != QLatin1String("raw_syscalls:sys_exit")) {
+            return;
+        }
+
+        const auto tid = static_cast<qint32>(sample.tid);
+        if (isEnter) {
+            PendingSyscall syscall;
+            syscall.time = sample.time;
+            syscall.stackId = stackId;
+            for (const auto& nameAndValue : std::as_const(payloadFields)) {
+                if (strings.value(nameAndValue.first) == QLatin1String("id")) {
+                    syscall.id = nameAndValue.second.toLongLong();
+                    break;
+                }
+            }
+            m_pendingSyscalls.insert(tid, syscall);
+            return;
+        }
+
+        const auto syscall = m_pendingSyscalls.take(tid);
+        if (syscall.id < 0 || syscall.stackId < 0 || sample.time < syscall.time) {
+            // we missed the enter, e.g. because the recording started while the thread was in the syscall
+            return;
+        }
+        const auto duration = sample.time - syscall.time;
+
+        if (eventResult.syscallTimeCostId == -1) {
+            eventResult.syscallTimeCostId = addCostType(PerfParser::tr("Syscall Time"), Data::Costs::Unit::Time);
+        }
+        auto& totalCost = summaryResult.costs[eventResult.syscallTimeCostId];
+        totalCost.sampleCount++;
+        totalCost.totalPeriod += duration;
+        summaryResult.syscallLatencies[syscall.id].add(duration);
+
+        addBottomUpResult(eventResult.syscallTimeCostId, duration, sample.pid, sample.tid, sample.cpu,
+                          eventResult.stacks[syscall.stackId], false);
+
+        Data::Event event;
+        event.time = sample.time;
+        event.cost = duration;
+        event.type = eventResult.syscallTimeCostId;
+        event.stackId = syscall.stackId;
+        event.cpuId = sample.cpu;
+        thread->events.push_back(event);
+    }
+
+    void addSample(const Sample& sample, const TracepointPayload* tracepointPayload = nullptr)
+    {
+        addSampleToFrequencyData(sample);
+
+        auto* thread = eventResult.findThread(sample.pid, sample.tid);
+        if (!thread) {
+            thread = addThread(sample);
+        }
+        if (static_cast<uint>(eventResult.cpus.size()) <= sample.cpu) {
+            eventResult.cpus.resize(sample.cpu + 1);
+        }
+        auto& cpu = eventResult.cpus[sample.cpu];
+        const auto threadIndex = static_cast<qint32>(thread - eventResult.threads.constData());
+
+        if (memoryBudget > 0 && ++numSamplesSinceBudgetCheck == MemoryBudgetCheckInterval) {
+            checkMemoryBudget();
+        }
+
+        // all costs of a sample share its stack
+        const auto& sampleFrames = stackPruning.isEnabled() ? stackPruning.prune(sample.frames) : sample.frames;
+        const auto stackId = internStack(sampleFrames);
+        // the aggregation shares the interned frames, which keeps the frames of decodedSample unshared
+        const auto frames = eventResult.stacks.at(stackId);
+        for (const auto& sampleCost : sample.costs) {
+            Data::Event event;
+            event.time = sample.time;
+            event.cost = sampleCost.cost;
+            event.type = attributeIdsToCostIds.value(sampleCost.attributeId, -1);
+            event.stackId = stackId;
+            event.cpuId = sample.cpu;
+            if (event.type != eventResult.offCpuTimeCostId) {
+                // like the off-CPU time of the context switches, the sampled one shouldn't show up on the cpu line
+                cpu.events.push_back({threadIndex, static_cast<qint32>(thread->events.size())});
+            }
+            thread->events.push_back(event);
+
+            const auto attribute = attributes.value(event.type);
+            if (attribute.type == static_cast<quint32>(AttributesDefinition::Type::Tracepoint)) {
+                Data::Tracepoint tracepoint;
+                tracepoint.time = event.time;
+                tracepoint.name = strings.value(attribute.name.id);
+                if (tracepointPayload) {
+                    decodeTracepointPayload(*tracepointPayload);
+                    addSyscallTracepoint(tracepoint.name, sample, stackId, thread);
+                    tracepoint.table = addTracepointPayload(attribute, sample, stackId);
+                    tracepoint.row = static_cast<qint32>(tracepointResult.tables.at(tracepoint.table).size() - 1);
+                    // a sample with multiple costs carries the payload only once
+                    tracepointPayload = nullptr;
+                }
+                if (tracepoint.name != QLatin1String("sched:sched_switch")) {
+                    // sched_switch events are handled separately already
+                    tracepointResult.tracepoints.push_back(tracepoint);
+                }
+            }
+        }
+
+        // the samples of a thread the preview keeps stand in for the ones it skips
+        const auto previewScale =
+            previewStride > 1 && numPreviewSamples[sample.tid]++ % previewStride != 0 ? 0 : previewStride;
+        addSampleToBottomUp(sample, frames, previewScale);
+        addSampleToSummary(sample);
+
+        if (sampleFrames.length() > 1) {
+            m_numSamplesWithMoreThanOneFrame++;
+        }
+        // the pruning may drop the outermost frames
+        addStackEnd(sample.frames, threadIndex);
+    }
+
+    // counts the user stacks whose outermost frame isn't an entry point, see isStackEntryPoint
+    void addStackEnd(const QVector<qint32>& frames, qint32 threadIndex)
+    {
+        if (frames.size() < 2) {
+            // recorded without a call graph
+            return;
+        }
+        const auto end = stackEnds.value(frames.last());
+        if (end.isKernel) {
+            // kernel threads have no user stack
+            return;
+        }
+        ++numUserStacks;
+        if (!end.isEntryPoint) {
+            ++truncatedStacks[{threadIndex, end.binaryId}];
+        }
+    }
+
+    void addString(const StringDefinition& string)
+    {
+        Q_ASSERT(string.id == strings.size());
+        strings.push_back(QString::fromUtf8(string.string));
+    }
+
+    void addSampleToBottomUp(const Sample& sample, const QVector<qint32>& frames, quint32 previewScale)
+    {
+        // TODO: optimize for groups, don't repeat the same lookup multiple times
+        for (const auto& sampleCost : sample.costs) {
+            addSampleToBottomUp(sample, frames, sampleCost, previewScale);
+        }
+    }
+
+    void addSampleToBottomUp(const Sample& sample, const QVector<qint32>& frames, SampleCost sampleCost,
+                             quint32 previewScale)
+    {
+        if (perfScriptOutput) {
+            *perfScriptOutput << commands.names.value(sample.pid).value(sample.pid) << '\t' << sample.pid << '\t'
+                              << sample.time / 1000000000 << '.' << qSetFieldWidth(9) << qSetPadChar(QLatin1Char('0'))
+                              << sample.time % 1000000000 << qSetFieldWidth(0) << ":\t" << sampleCost.cost << ' '
+                              << strings.value(attributes.value(sampleCost.attributeId).name.id) << '\n';
+        }
+
+        const auto type = attributeIdsToCostIds.value(sampleCost.attributeId, -1);
+
+        if (type < 0) {
+            qCWarning(LOG_PERFPARSER) << "Unexpected attribute id:" << sampleCost.attributeId << "Only know about"
+                                      << attributeIdsToCostIds.size() << "attributes so far";
+            return;
+        }
+
+        addBottomUpResult(type, sampleCost.cost, sample.pid, sample.tid, sample.cpu, frames, true, previewScale);
+    }
+
+    // whether the first level of the bottom up tree groups the costs instead of being a symbol
+    bool skipFirstLevel() const
+    {
+        return costAggregation != Settings::CostAggregation::BySymbol;
+    }
+
+    // the top down and the caller/callee results only read the bottom up tree, so derive them concurrently
+    // each callback gets invoked as soon as its result is ready, possibly from a different thread
+    void buildDerivedResults(const std::function<void()>& topDownReady, const std::function<void()>& perLibraryReady,
+                             const std::function<void()>& callerCalleeReady,
+                             const std::function<void()>& stackIndexReady)
+    {
+        ThreadWeaver::Queue topDownQueue;
+        topDownQueue.stream() << ThreadWeaver::make_job([this, &stackIndexReady]() {
+            {
+                ScopedPhase phase("stack index");
+                // the index keeps the inlined frames, so the filters find them however the results got aggregated
+                auto unfolded = bottomUpResult;
+                unfolded.foldInlines = false;
+                stackIndex = Data::StackIndex(unfolded, eventResult.stacks);
+            }
+            stackIndexReady();
+        });
+        topDownQueue.stream() << ThreadWeaver::make_job([this, &topDownReady, &perLibraryReady]() {
+            ThreadWeaver::Queue queue;
+            queue.setMaximumNumberOfThreads(QThread::idealThreadCount());
+            {
+                ScopedPhase phase("top down");
+                topDownResult = ::topDownFromBottomUpData(&queue, bottomUpResult, skipFirstLevel());
+            }
+            topDownReady();
+            {
+                ScopedPhase phase("per library");
+                perLibraryResult = ::perLibraryFromTopDownData(&queue, topDownResult);
+            }
+            perLibraryReady();
+        });
+
+        {
+            ScopedPhase phase("caller callee");
+            auto locations = std::make_shared<Data::LocationCostIndex>(bottomUpResult, eventResult);
+            // computing the maps again is slow, but cheaper than running out of memory
+            locations->setCacheEnabled(!memoryBudgetExceeded);
+            callerCalleeResult.locations = std::move(locations);
+            ThreadWeaver::Queue queue;
+            queue.setMaximumNumberOfThreads(QThread::idealThreadCount());
+            ::callerCalleesFromBottomUpData(&queue, bottomUpResult, &callerCalleeResult);
+        }
+        callerCalleeReady();
+
+        topDownQueue.finish();
+    }
+
+    void addRecord(const Record& record)
+    {
+        uniqueProcess.insert(record.pid);
+        uniqueThreads.insert(record.tid);
+
+        if (record.time < applicationTime.start || applicationTime.start == 0) {
+            applicationTime.start = record.time;
         }
-        case EventType::FeaturesDefinition: {
-            FeaturesDefinition featuresDefinition;
-            stream >> featuresDefinition;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << featuresDefinition;
-            setFeatures(featuresDefinition);
-            break;
+        if (record.time > applicationTime.end || applicationTime.end == 0) {
+            applicationTime.end = record.time;
         }
-        case EventType::Error: {
-            Error error;
-            stream >> error;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << error;
-            addError(error);
-            break;
+    }
+
+    void addSampleToSummary(const Sample& sample)
+    {
+        ++summaryResult.sampleCount;
+
+        for (const auto& sampleCost : sample.costs) {
+            const auto type = attributeIdsToCostIds.value(sampleCost.attributeId, -1);
+            if (type < 0) {
+                qCWarning(LOG_PERFPARSER) << "Unexpected attribute id:" << sampleCost.attributeId << "Only know about"
+                                          << attributeIdsToCostIds.size() << "attributes so far";
+            } else {
+                auto& costSummary = summaryResult.costs[type];
+                ++costSummary.sampleCount;
+                costSummary.totalPeriod += sampleCost.cost;
+            }
         }
-        case EventType::ContextSwitchDefinition: {
-            ContextSwitchDefinition contextSwitch;
-            stream >> contextSwitch;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << contextSwitch;
-            addRecord(contextSwitch);
-            addContextSwitch(contextSwitch);
-            break;
+    }
+
+    void addContextSwitch(const ContextSwitchDefinition& contextSwitch)
+    {
+        auto* thread = eventResult.findThread(contextSwitch.pid, contextSwitch.tid);
+        if (!thread) {
+            return;
         }
-        case EventType::Progress: {
-            float percent = 0;
-            stream >> percent;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << percent;
-            emit progress(percent);
-            break;
+
+        if (contextSwitch.switchOut && thread->state == Data::ThreadEvents::OnCpu) {
+            thread->onCpuSlices.add(contextSwitch.time - thread->lastSwitchTime);
+        } else if (!contextSwitch.switchOut && thread->state == Data::ThreadEvents::OffCpu) {
+            const auto switchTime = contextSwitch.time - thread->lastSwitchTime;
+            thread->offCpuTime += switchTime;
+            thread->offCpuDurations.add(switchTime);
+
+            if (eventResult.offCpuTimeCostId == -1) {
+                const auto label = PerfParser::tr("off-CPU Time");
+                eventResult.offCpuTimeCostId = addCostType(label, Data::Costs::Unit::Time);
+            }
+
+            auto& totalCost = summaryResult.costs[eventResult.offCpuTimeCostId];
+            totalCost.sampleCount++;
+            totalCost.totalPeriod += switchTime;
+
+            qint32 stackId = -1;
+            if (!thread->events.isEmpty() && m_schedSwitchCostId != -1) {
+                const auto& types = thread->events.types();
+                auto it = std::find(types.rbegin(), types.rend(), m_schedSwitchCostId);
+                if (it != types.rend()) {
+                    stackId = thread->events.stackIds().at(std::distance(it, types.rend()) - 1);
+                }
+            }
+            if (stackId != -1) {
+                addBottomUpResult(eventResult.offCpuTimeCostId, switchTime, contextSwitch.pid, contextSwitch.tid,
+                                  contextSwitch.cpu, eventResult.stacks[stackId], false);
+            }
+
+            Data::Event event;
+            event.time = thread->lastSwitchTime;
+            event.cost = switchTime;
+            event.type = eventResult.offCpuTimeCostId;
+            event.stackId = stackId;
+            event.cpuId = contextSwitch.cpu;
+            thread->events.push_back(event);
         }
-        case EventType::DebugInfoDownloadProgress: {
-            StringId module;
-            StringId url;
-            qint64 numerator = 0;
-            qint64 denominator = 0;
-            stream >> module >> url >> numerator >> denominator;
-            qCDebug(LOG_PERFPARSER) << "parsed:" << url << numerator << denominator;
-            emit debugInfoDownloadProgress(strings.value(module.id), strings.value(url.id), numerator, denominator);
-            break;
+
+        thread->lastSwitchTime = contextSwitch.time;
+        thread->state = contextSwitch.switchOut ? Data::ThreadEvents::OffCpu : Data::ThreadEvents::OnCpu;
+    }
+
+    // add the cost to the bottom up and caller/callee data, potentially on the aggregation stage of the pipeline
+    // with a preview, the cost gets added to it too, scaled up by @p previewScale. 0 leaves it out of the preview
+    void addBottomUpResult(int type, quint64 cost, qint32 pid, qint32 tid, quint32 cpu, const QVector<qint32>& frames,
+                           bool writeScriptOutput, quint32 previewScale = 1)
+    {
+        // resolve the thread names now, they can change until the aggregation runs
+        auto rootSymbol = aggregationRoots.symbol(pid, tid, cpu);
+        postAggregation([this, rootSymbol, type, cost, frames, writeScriptOutput, previewScale]() {
+            // the source and offset maps get computed on demand, see Data::LocationCostIndex
+            auto frameCallback = [this, writeScriptOutput](const Data::Symbol& symbol,
+                                                           const Data::Location& location) {
+                if (writeScriptOutput && perfScriptOutput) {
+                    *perfScriptOutput << '\t' << Qt::hex << qSetFieldWidth(16) << location.address
+                                      << qSetFieldWidth(0) << Qt::dec << ' '
+                                      << (symbol.symbol.isEmpty() ? QStringLiteral("[unknown]") : symbol.symbol)
+                                      << " (" << symbol.binary << ")\n";
+                }
+            };
+
+            ::addBottomUpResult(&bottomUpResult, rootSymbol, type, cost, frames, frameCallback);
+
+            if (previewStride > 1 && previewScale > 0) {
+                // lend the symbols and locations to the preview while it resolves the frames
+                std::swap(previewBottomUp.symbols, bottomUpResult.symbols);
+                std::swap(previewBottomUp.locations, bottomUpResult.locations);
+                ::addBottomUpResult(&previewBottomUp, rootSymbol, type, cost * previewScale, frames,
+                                    [](const Data::Symbol& /*symbol*/, const Data::Location& /*location*/) {});
+                std::swap(previewBottomUp.symbols, bottomUpResult.symbols);
+                std::swap(previewBottomUp.locations, bottomUpResult.locations);
+            }
+
+            if (writeScriptOutput && perfScriptOutput) {
+                *perfScriptOutput << "\n";
+            }
+        });
+    }
+
+    void addLost(const LostDefinition& lost)
+    {
+        ++summaryResult.lostChunks;
+        summaryResult.lostEvents += lost.lost;
+        eventResult.addLostEvents(lost.time, lost.lost);
+
+        auto* thread = eventResult.findThread(lost.pid, lost.tid);
+        if (!thread) {
+            return;
         }
-        case EventType::TracePointFormat:
-            // TODO: implement me
-            return true;
-        case EventType::InvalidType:
-            break;
+
+        if (eventResult.lostEventCostId == -1) {
+            eventResult.lostEventCostId = addCostType(PerfParser::tr("Lost Event"), Data::Costs::Unit::Unknown);
         }
 
-        if (!stream.atEnd()) {
-            qCWarning(LOG_PERFPARSER) << "did not consume all bytes for event of type" << eventType << buffer.pos()
-                                      << buffer.size();
-            return false;
+        Data::Event event;
+        event.time = lost.time;
+        event.cost = lost.lost;
+        event.type = eventResult.lostEventCostId;
+        event.cpuId = lost.cpu;
+        // the lost event never has a valid cpu set, the timeline overlays EventResults::lostEvents on all CPUs
+        thread->events.push_back(event);
+    }
+
+    void setFeatures(const FeaturesDefinition& features)
+    {
+        if (features.cmdline.isEmpty()) {
+            summaryResult.command = QStringLiteral("??");
+        } else {
+            // first entry in cmdline is "perf" which could contain a path
+            // we only want to show the name without the path
+            auto args = features.cmdline;
+            args.removeFirst();
+            summaryResult.command = QLatin1String("perf ") + QString::fromUtf8(args.join(' '));
         }
+        summaryResult.hostName = QString::fromUtf8(features.hostName);
+        summaryResult.linuxKernelVersion = QString::fromUtf8(features.osRelease);
+        summaryResult.perfVersion = QString::fromUtf8(features.version);
+        summaryResult.cpuDescription = QString::fromUtf8(features.cpuDesc);
+        summaryResult.cpuId = QString::fromUtf8(features.cpuId);
+        summaryResult.cpuArchitecture = QString::fromUtf8(features.arch);
+        summaryResult.cpusOnline = features.nrCpusOnline;
+        summaryResult.cpusAvailable = features.nrCpusAvailable;
+        auto formatCpuList = [](const QByteArrayList& list) -> QString {
+            return QString::fromUtf8('[' + list.join("], [") + ']');
+        };
+        summaryResult.cpuSiblingCores = formatCpuList(features.siblingCores);
+        summaryResult.cpuSiblingThreads = formatCpuList(features.siblingThreads);
+        summaryResult.totalMemoryInKiB = features.totalMem;
 
-        return true;
+        eventResult.cpus.resize(features.nrCpusAvailable);
+        for (const auto& node : features.numaTopology) {
+            for (const auto cpu : parseCpuList(node.topology)) {
+                if (cpu < static_cast<uint>(eventResult.cpus.size())) {
+                    eventResult.cpus[cpu].numaNode = static_cast<qint32>(node.nodeId);
+                }
+            }
+        }
     }
 
-    void finalize()
+    void addError(const Error& error)
     {
-        Data::BottomUp::initializeParents(&bottomUpResult.root);
+        if (!encounteredErrors.contains(error.message)) {
+            summaryResult.errors << error.message;
+            encounteredErrors.insert(error.message);
+        }
+    }
 
-        summaryResult.applicationTime = applicationTime;
-        summaryResult.threadCount = uniqueThreads.size();
-        summaryResult.processCount = uniqueProcess.size();
+    enum State
+    {
+        HEADER,
+        DATA_STREAM_VERSION,
+        EVENT_HEADER,
+        EVENT,
+        PARSE_ERROR
+    };
+
+    enum class EventType
+    {
+        ThreadStart,
+        ThreadEnd,
+        Command,
+        LocationDefinition,
+        SymbolDefinition,
+        StringDefinition,
+        LostDefinition,
+        FeaturesDefinition,
+        Error,
+        Progress,
+        TracePointFormat,
+        AttributesDefinition,
+        ContextSwitchDefinition,
+        Sample,
+        TracePointSample,
+        DebugInfoDownloadProgress,
+        InvalidType
+    };
 
-        buildTopDownResult();
-        buildPerLibraryResult();
-        buildCallerCalleeResult();
+    static constexpr qint64 ReadChunkSize = 4 * 1024 * 1024;
+    static constexpr int PipelineBatchSize = 4096;
+    static constexpr int PipelineQueueCapacity = 16;
+    // the memory usage visits all threads and stacks, so it is only checked now and then
+    static constexpr int MemoryBudgetCheckInterval = 1 << 20;
 
-        for (auto& thread : eventResult.threads) {
-            thread.time.start = std::max(thread.time.start, applicationTime.start);
-            thread.time.end = std::min(thread.time.end, applicationTime.end);
-            if (thread.name.isEmpty()) {
-                thread.name = PerfParser::tr("#%1").arg(thread.tid);
-            }
+    State state = HEADER;
+    quint32 eventSize = 0;
+    QByteArray readBuffer;
+    const char* mappedData = nullptr;
+    qint64 mappedSize = 0;
+    qint64 readPos = 0;
+    QBuffer buffer;
+    QDataStream stream;
+    QVector<AttributesDefinition> attributes;
+    QVector<QString> strings;
+    QIODevice* input = nullptr;
+    QIODevice* inputCopy = nullptr;
+    int inputFd = -1;
+    bool inputFdAtEnd = false;
+    Data::Summary summaryResult;
+    Data::TimeRange applicationTime;
+    QSet<quint32> uniqueThreads;
+    QSet<quint32> uniqueProcess;
+    Data::BottomUpResults bottomUpResult;
+    Data::TopDownResults topDownResult;
+    Data::PerLibraryResults perLibraryResult;
+    Data::CallerCalleeResults callerCalleeResult;
+    Data::StackIndex stackIndex;
+    Data::EventResults eventResult;
+    Data::TracepointResults tracepointResult;
+    struct TracepointTableIndex
+    {
+        qint32 table = -1;
+        // maps the string id of the field names to the field index
+        QHash<qint32, int> fields;
+    };
+    QHash<qint32, TracepointTableIndex> tracepointTables;
+    // the fields of the current tracepoint, see decodeTracepointPayload
+    QVector<std::pair<qint32, QVariant>> payloadFields;
+    QHash<qint32, QString> tracepointFormatNames;
+    Data::FrequencyResults frequencyResult;
+    Data::ThreadNames commands;
+    std::unique_ptr<QTextStream> perfScriptOutput;
+    QHash<qint32, SymbolCount> numSymbolsByModule;
+    QSet<QString> encounteredErrors;
+    // the children of the stack trie, keyed by the parent node in the upper and the frame in the lower 32 bits
+    QHash<quint64, qint32> stackNodes;
+    // the stack id of every node of the stack trie, -1 while no stack ended at the node so far
+    // the first node is the root, i.e. the empty stack
+    QVector<qint32> stackNodeIds = {-1};
+    std::atomic<bool> stopRequested;
+    std::unique_ptr<BoundedQueue<EventBatch>> decodeQueue;
+    std::unique_ptr<BoundedQueue<AggregationBatch>> aggregationQueue;
+    std::unique_ptr<ThreadWeaver::Queue> pipelineJobs;
+    EventBatch pendingEvents;
+    AggregationBatch pendingAggregation;
+    std::atomic<bool> pipelineFailed {false};
+    std::atomic<int> snapshotInterval {0};
+    int nextSnapshotInterval = 0;
+    std::function<bool()> acceptsSnapshot;
+    std::function<void(const Snapshot&)> snapshotAvailable;
+    QElapsedTimer snapshotTimer;
+    std::atomic<bool> snapshotInFlight {false};
+    int numEventsSinceSnapshotCheck = 0;
+    mutable std::unique_ptr<ThreadWeaver::Queue> snapshotQueue;
+    SnapshotScan snapshotScan;
+    QHash<qint32, qint32> attributeIdsToCostIds;
+    QHash<int, qint32> attributeNameToCostIds;
+    qint32 m_nextCostId = 0;
+    qint32 m_schedSwitchCostId = -1;
+    // the syscalls the threads entered but didn't exit yet, by thread id, see addSyscallTracepoint
+    struct PendingSyscall
+    {
+        quint64 time = 0;
+        qint64 id = -1;
+        qint32 stackId = -1;
+    };
+    QHash<qint32, PendingSyscall> m_pendingSyscalls;
+    QHash<quint32, quint64> m_lastSampleTimePerCore;
+    Settings::CostAggregation costAggregation;
+    // the first level symbols of the cost aggregation, resolved on the decode stage
+    AggregationRoots aggregationRoots {costAggregation, &commands, &eventResult.cpus};
+    bool perfMapFileExists = false;
+    // where the perf-<pid>.map files get looked up, empty to leave the JIT code to perfparser alone
+    QString perfMapDir;
+    QString perfMapCacheDirectory;
+    // by pid, nullptr when the process has no perf map
+    QHash<quint32, std::shared_ptr<const PerfMapIndex>> perfMaps;
+    QHash<quint32, QString> perfMapPaths;
+    // the locations that got their symbol from a perf map
+    QSet<qint32> perfMapLocations;
+    // in bytes, 0 means unlimited, see Settings::memoryBudget
+    qint64 memoryBudget = 0;
+    bool memoryBudgetExceeded = false;
+    // only set once the budget got exceeded, shared with the filters of the parsed results, see PerfParser
+    std::shared_ptr<Data::SpillDirectory> spillDirectory = std::make_shared<Data::SpillDirectory>();
+    int numSamplesSinceBudgetCheck = 0;
+    // see parseEvent
+    Sample decodedSample;
+    // every previewStride-th sample per thread also gets added to previewBottomUp, with its costs scaled up by
+    // the stride, see Settings::previewStride. The snapshots show the preview instead of bottomUpResult
+    quint32 previewStride = 1;
+    QHash<qint32, quint32> numPreviewSamples;
+    // only the tree and the costs are used, the frames get resolved with the symbols of bottomUpResult
+    Data::BottomUpResults previewBottomUp;
+    // applied to the frames of every sample before they get interned, see Settings::pruneFrames
+    StackPruning stackPruning;
+    // the samples it rejects get skipped right after decoding, see Settings::parseRestriction
+    Data::ParseRestriction restriction;
+    // the processes with a thread whose command is part of the restriction
+    QSet<qint32> restrictedCommandPids;
+    // see reportProgress, counted on the decode stage
+    QElapsedTimer parseTimer;
+    quint64 numRecords = 0;
+    quint64 numBytes = 0;
+    quint64 numSymbolDefinitions = 0;
+    float lastPercent = 0;
+
+    // samples recorded without --call-graph have only one frame
+    int m_numSamplesWithMoreThanOneFrame = 0;
+
+    struct StackEnd
+    {
+        qint32 binaryId = -1;
+        bool isKernel = false;
+        bool isEntryPoint = false;
+    };
+    // the symbols by location id, as far as they matter for the outermost frame of a stack, see addStackEnd
+    QVector<StackEnd> stackEnds;
+    quint64 numUserStacks = 0;
+    // the number of truncated user stacks by thread index and the string id of the binary they end in
+    QHash<std::pair<qint32, qint32>, quint64> truncatedStacks;
+
+public slots:
+    void stop()
+    {
+        stopRequested = true;
+    }
+
+signals:
+    void progress(float percent);
+    void parseProgress(const Data::ParseProgress& progress);
+    void debugInfoDownloadProgress(const QString& module, const QString& url, qint64 numerator, qint64 denominator);
+};
 
-            // we may have been switched out before detaching perf, so increment
-            // the off-CPU time in this case
-            if (thread.state == Data::ThreadEvents::OffCpu) {
-                thread.offCpuTime += thread.time.end - thread.lastSwitchTime;
-            }
+// remembers the results of recent filterResults calls, least recently used results get evicted first
+// this allows to go back and forth between filters without recomputing anything, and to
+// apply a filter that only narrows down a previous one to the results of that filter
+class FilterResultsCache
+{
+public:
+    struct Entry
+    {
+        Data::FilterAction filter;
+        Settings::CostAggregation costAggregation;
+        bool correctLostEvents;
+        bool foldInlines;
+        Data::BottomUpResults bottomUp;
+        Data::TopDownResults topDown;
+        Data::PerLibraryResults perLibrary;
+        Data::CallerCalleeResults callerCallee;
+        Data::EventResults events;
+        Data::TracepointResults tracepoints;
+        Data::FrequencyResults frequency;
+    };
 
-            if (thread.offCpuTime > 0) {
-                summaryResult.offCpuTime += thread.offCpuTime;
-                summaryResult.onCpuTime += thread.time.delta() - thread.offCpuTime;
-            }
+    // returns the results for exactly this filter
+    // when they are getting precomputed in the background, this waits for them
+    std::optional<Entry> find(const Data::FilterAction& filter, Settings::CostAggregation costAggregation,
+                              bool correctLostEvents, bool foldInlines)
+    {
+        const auto key = Key {filter, costAggregation, correctLostEvents, foldInlines};
+        QMutexLocker lock(&m_mutex);
+        while (m_pending.contains(key)) {
+            m_pendingFinished.wait(&m_mutex);
+        }
+        auto it = m_entries.constFind(key);
+        if (it == m_entries.constEnd()) {
+            return std::nullopt;
         }
+        // mark as most recently used
+        m_lru.removeOne(key);
+        m_lru.push_back(key);
+        return it->entry;
+    }
 
-        {
-            uint cpuId = 0;
-            for (auto& cpu : eventResult.cpus) {
-                cpu.cpuId = cpuId++;
+    // returns the most recent results of a filter that @p filter refines
+    // only the events, tracepoints and frequency data can be reused, they don't depend on how the costs get aggregated
+    std::optional<Entry> findBase(const Data::FilterAction& filter) const
+    {
+        QMutexLocker lock(&m_mutex);
+        for (auto it = m_lru.crbegin(), end = m_lru.crend(); it != end; ++it) {
+            if (filter.isRefinementOf(it->filter)) {
+                return m_entries.value(*it).entry;
             }
         }
+        return std::nullopt;
+    }
 
-        eventResult.totalCosts = summaryResult.costs;
+    void insert(Entry entry)
+    {
+        const auto key = Key {entry.filter, entry.costAggregation, entry.correctLostEvents, entry.foldInlines};
+        QMutexLocker lock(&m_mutex);
+        if (m_entries.contains(key)) {
+            m_lru.removeOne(key);
+            m_size -= m_entries.value(key).size;
+        }
 
-        // Add error messages for all modules with missing debug symbols
-        for (auto i = numSymbolsByModule.begin(); i != numSymbolsByModule.end(); ++i) {
-            const auto& numSymbols = i.value();
-            if (!numSymbols.missing)
-                continue;
+        const auto size = estimatedSize(entry);
+        m_entries.insert(key, {std::move(entry), size});
+        m_lru.push_back(key);
+        m_size += size;
 
-            const auto& moduleName = strings.value(i.key());
-            summaryResult.errors << PerfParser::tr("Module \"%1\" is missing %2 of %3 debug symbols.")
-                                        .arg(moduleName)
-                                        .arg(numSymbols.missing)
-                                        .arg(numSymbols.total);
+        // always keep the most recent results, even when they exceed the budget on their own
+        while (m_size > MemoryBudget && m_lru.size() > 1) {
+            m_size -= m_entries.take(m_lru.takeFirst()).size;
         }
     }
 
-    qint32 addCostType(const QString& label, Data::Costs::Unit unit)
+    // marks the results of this filter as getting precomputed
+    // returns false when they are cached or getting computed already, then there is nothing to do
+    bool beginPending(const Data::FilterAction& filter, Settings::CostAggregation costAggregation,
+                      bool correctLostEvents, bool foldInlines)
     {
-        auto costId = m_nextCostId;
-        m_nextCostId++;
-
-        if (label == QLatin1String("sched:sched_switch")) {
-            m_schedSwitchCostId = costId;
+        const auto key = Key {filter, costAggregation, correctLostEvents, foldInlines};
+        QMutexLocker lock(&m_mutex);
+        if (m_entries.contains(key) || m_pending.contains(key)) {
+            return false;
         }
+        m_pending.insert(key);
+        return true;
+    }
 
-        Q_ASSERT(summaryResult.costs.size() == costId);
-        summaryResult.costs.push_back({label, 0, 0, unit});
-        Q_ASSERT(bottomUpResult.costs.numTypes() == costId);
-        bottomUpResult.costs.addType(costId, label, unit);
+    // call this once the precomputed results got inserted, or when the precomputation got cancelled
+    void endPending(const Data::FilterAction& filter, Settings::CostAggregation costAggregation,
+                    bool correctLostEvents, bool foldInlines)
+    {
+        QMutexLocker lock(&m_mutex);
+        m_pending.remove(Key {filter, costAggregation, correctLostEvents, foldInlines});
+        m_pendingFinished.wakeAll();
+    }
 
-        return costId;
+    void clear()
+    {
+        QMutexLocker lock(&m_mutex);
+        m_entries.clear();
+        m_lru.clear();
+        m_size = 0;
     }
 
-    void addAttributes(const AttributesDefinition& attributesDefinition)
+private:
+    struct Key
     {
-        qint32 costId = attributeNameToCostIds.value(attributesDefinition.name.id, -1);
+        Data::FilterAction filter;
+        Settings::CostAggregation costAggregation;
+        bool correctLostEvents;
+        bool foldInlines;
 
-        if (costId == -1) {
-            const auto label = strings.value(attributesDefinition.name.id);
-            auto unit = [&] {
-                if (attributesDefinition.type == static_cast<quint32>(AttributesDefinition::Type::Tracepoint))
-                    return Data::Costs::Unit::Tracepoint;
-                return Data::Costs::Unit::Unknown;
-            }();
-            costId = addCostType(label, unit);
-            attributeNameToCostIds.insert(attributesDefinition.name.id, costId);
+        bool operator==(const Key& rhs) const
+        {
+            return costAggregation == rhs.costAggregation && correctLostEvents == rhs.correctLostEvents
+                && foldInlines == rhs.foldInlines && filter == rhs.filter;
         }
 
-        attributeIdsToCostIds[attributesDefinition.id] = costId;
-        Q_ASSERT(attributes.size() == attributesDefinition.id);
-        attributes.push_back(attributesDefinition);
-    }
+        friend uint qHash(const Key& key, uint seed = 0)
+        {
+            Util::HashCombine hash;
+            seed = hash(seed, key.filter);
+            seed = hash(seed, static_cast<int>(key.costAggregation));
+            seed = hash(seed, key.correctLostEvents);
+            seed = hash(seed, key.foldInlines);
+            return seed;
+        }
+    };
 
-    Data::ThreadEvents* addThread(const Record& record)
+    struct SizedEntry
     {
-        Data::ThreadEvents thread;
-        thread.pid = record.pid;
-        thread.tid = record.tid;
-        // when we encounter a thread the first time it was probably alive when
-        // we started the application, otherwise we override the start time when
-        // we encounter a ThreadStart event
-        thread.time.start = applicationTime.start;
-        thread.name = commands.names.value(thread.pid).value(thread.tid);
-        if (thread.name.isEmpty() && thread.pid != thread.tid)
-            thread.name = commands.names.value(thread.pid).value(thread.pid);
-        eventResult.threads.push_back(thread);
-        return &eventResult.threads.last();
-    }
+        Entry entry;
+        qint64 size = 0;
+    };
 
-    void addThreadEnd(const ThreadEnd& threadEnd)
+    template<typename Tree>
+    static qint64 numNodes(const Tree& tree)
     {
-        auto* thread = eventResult.findThread(threadEnd.pid, threadEnd.tid);
-        if (thread) {
-            thread->time.end = threadEnd.time;
+        qint64 ret = 1;
+        for (const auto& child : tree.children) {
+            ret += numNodes(child);
         }
+        return ret;
     }
 
-    void addCommand(const Command& command)
+    // a rough estimate of the memory used by @p entry, good enough to keep the cache bounded
+    static qint64 estimatedSize(const Entry& entry)
     {
-        const auto& comm = strings.value(command.comm.id);
-        // check if this changes the name of a current thread
-        auto* thread = eventResult.findThread(command.pid, command.tid);
-        if (thread) {
-            thread->name = comm;
+        const qint64 numCostTypes = std::max(1, entry.bottomUp.costs.numTypes());
+        const qint64 costSize = numCostTypes * sizeof(qint64);
+
+        qint64 size = 0;
+        for (const auto& thread : entry.events.threads) {
+            size += thread.events.size() * (sizeof(quint32) + sizeof(quint64) + 3 * sizeof(qint32));
         }
-        // and remember the command, maybe a future ThreadStart event references it
-        commands.names[command.pid][command.tid] = comm;
+        for (const auto& cpu : entry.events.cpus) {
+            size += cpu.events.size() * sizeof(Data::EventIndex);
+        }
+        size += numNodes(entry.bottomUp.root) * (sizeof(Data::BottomUp) + costSize);
+        size += numNodes(entry.topDown.root) * (sizeof(Data::TopDown) + 2 * costSize);
+        size += numNodes(entry.perLibrary.root) * (sizeof(Data::PerLibrary) + costSize);
+        for (const auto& callerCallee : entry.callerCallee.entries) {
+            size += sizeof(Data::CallerCalleeEntry) + 2 * costSize
+                + (callerCallee.callers.size() + callerCallee.callees.size()) * (sizeof(Data::Symbol) + costSize)
+                + (callerCallee.sourceMap.size() + callerCallee.offsetMap.size()) * 2 * costSize;
+        }
+        // the tracepoint tables are never filtered and thus shared with the unfiltered results
+        size += entry.tracepoints.tracepoints.size() * sizeof(Data::Tracepoint);
+        return size;
     }
 
-    void addLocation(const LocationDefinition& location)
-    {
-        Q_ASSERT(bottomUpResult.locations.size() == location.id);
-        Q_ASSERT(bottomUpResult.symbols.size() == location.id);
-        QString file;
-        if (location.location.file.id != -1) {
-            file = strings.value(location.location.file.id);
-        }
-        bottomUpResult.locations.push_back(
-            {location.location.parentLocationId,
-             {location.location.address, location.location.relAddr, {file, location.location.line}}});
-        bottomUpResult.symbols.push_back({});
+    static constexpr qint64 MemoryBudget = 1024LL * 1024 * 1024;
+
+    // the results get precomputed in the background while the parser uses them
+    mutable QMutex m_mutex;
+    QWaitCondition m_pendingFinished;
+    QSet<Key> m_pending;
+    QHash<Key, SizedEntry> m_entries;
+    // the most recently used key comes last
+    QList<Key> m_lru;
+    qint64 m_size = 0;
+};
+
+namespace {
+// finalizes @p d and emits all of its results
+void publishResults(PerfParser* parser, PerfParserPrivate* d)
+{
+    d->reportProgress(Data::ParseProgress::Phase::Aggregate);
+    d->finalize();
+    // these don't need any further derivation, so they don't have to wait for the slower results below
+    emit parser->bottomUpDataAvailable(d->bottomUpResult);
+    emit parser->summaryDataAvailable(d->summaryResult);
+    emit parser->tracepointDataAvailable(d->tracepointResult);
+    emit parser->eventsAvailable(d->eventResult);
+    emit parser->frequencyDataAvailable(d->frequencyResult);
+    emit parser->threadNamesAvailable(d->commands);
+    emit parser->perfMapFileExists(d->perfMapFileExists);
+
+    d->reportProgress(Data::ParseProgress::Phase::DeriveViews);
+    d->buildDerivedResults([parser, d]() { emit parser->topDownDataAvailable(d->topDownResult); },
+                           [parser, d]() { emit parser->perLibraryDataAvailable(d->perLibraryResult); },
+                           [parser, d]() { emit parser->callerCalleeDataAvailable(d->callerCalleeResult); },
+                           [parser, d]() { emit parser->stackIndexAvailable(d->stackIndex); });
+
+    emit parser->memoryUsageAvailable(Data::MemoryUsage::fromResults(
+        d->bottomUpResult, d->callerCalleeResult, d->eventResult, d->frequencyResult, d->tracepointResult));
+    if (d->memoryBudgetExceeded) {
+        emit parser->parserWarning(
+            PerfParser::tr("The loaded data exceeded the memory budget of %1 MiB. The events got stored in %2 "
+                           "and the source and offset maps are not cached, which makes them slower to show.")
+                .arg(QString::number(d->memoryBudget / 1024 / 1024), d->spillPath()));
     }
 
-    void addSymbol(const SymbolDefinition& symbol)
-    {
-        // empty symbol was added in addLocation already
-        Q_ASSERT(bottomUpResult.symbols.size() > symbol.id);
-        const auto symbolString = strings.value(symbol.symbol.name.id);
-        const auto relAddr = symbol.symbol.relAddr;
-        const auto size = symbol.symbol.size;
-        const auto binaryString = strings.value(symbol.symbol.binary.id);
-        const auto pathString = strings.value(symbol.symbol.path.id);
-        const auto actualPathString = strings.value(symbol.symbol.actualPath.id);
-        const auto isKernel = symbol.symbol.isKernel;
-        const auto isInline = symbol.symbol.isInline;
-        bottomUpResult.symbols[symbol.id] = {symbolString, relAddr,          size,     binaryString,
-                                             pathString,   actualPathString, isKernel, isInline};
+    // perf stat records no samples at all
+    if (d->m_numSamplesWithMoreThanOneFrame == 0 && d->summaryResult.counters.isEmpty()) {
+        emit parser->parserWarning(
+            PerfParser::tr("Samples contained no call stack frames. Consider passing <code>--call-graph "
+                           "dwarf</code> to <code>perf record</code>."));
+    }
 
-        // Count total and missing symbols per module for error report
-        auto& numSymbols = numSymbolsByModule[symbol.symbol.binary.id];
-        ++numSymbols.total;
-        if (symbolString.isEmpty() && !binaryString.isEmpty()) {
-            ++numSymbols.missing;
-        }
+    if (const auto stackDumpSize = d->summaryResult.suggestedStackDumpSize) {
+        emit parser->parserWarning(
+            PerfParser::tr("%1% of the call stacks got truncated by the stack dump size of %2 bytes. Consider "
+                           "passing <code>--call-graph dwarf,%3</code> to <code>perf record</code>, the summary "
+                           "offers to use it for new recordings.")
+                .arg(Util::formatCostRelative(d->summaryResult.truncatedStackCount, d->summaryResult.userStackCount),
+                     QString::number(d->summaryResult.stackDumpSize), QString::number(stackDumpSize)));
     }
 
-    qint32 internStack(const QVector<qint32>& frames)
-    {
-        auto& id = stacks[frames];
-        if (!id) {
-            Q_ASSERT(stacks.size() == eventResult.stacks.size() + 1);
-            id = stacks.size();
-            eventResult.stacks.push_back(frames);
-        }
-        return id - 1;
+    // perf record only stores the lost chunks in the data, it doesn't report them when it finishes
+    if (d->summaryResult.lostChunks > 0) {
+        emit parser->parserWarning(
+            PerfParser::tr("perf lost %1 events in %2 chunks, the results are incomplete. Consider passing a bigger "
+                           "buffer with <code>--mmap-pages</code> or a lower sampling frequency with <code>-F</code> "
+                           "to <code>perf record</code>.")
+                .arg(QString::number(d->summaryResult.lostEvents), QString::number(d->summaryResult.lostChunks)));
     }
 
-    void addSampleToFrequencyData(const Sample& sample)
-    {
-        auto& lastTime = m_lastSampleTimePerCore[sample.cpu];
-        auto updateTime = qScopeGuard([&]() { lastTime = sample.time; });
-        if (!lastTime) {
-            return;
+    emit parser->parsingFinished();
+}
+
+// emits the aggregated results parsed so far, parsing continues afterwards
+void publishSnapshot(PerfParser* parser, const PerfParserPrivate::Snapshot& snapshot)
+{
+    emit parser->bottomUpDataAvailable(snapshot.bottomUp);
+    emit parser->topDownDataAvailable(snapshot.topDown);
+    emit parser->perLibraryDataAvailable(snapshot.perLibrary);
+    emit parser->summaryDataAvailable(snapshot.summary);
+    emit parser->callerCalleeDataAvailable(snapshot.callerCallee);
+    if (snapshot.hasTimeline) {
+        emit parser->eventsAvailable(snapshot.events);
+    }
+    emit parser->partialResultsAvailable();
+}
+
+// adds the summary of another capture to @p merged
+// the captures come from different machines and times, so the times get added up instead of spanning them
+void mergeCaptureSummary(Data::Summary* merged, const Data::Summary& capture, bool isFirst)
+{
+    auto addDistinct = [](QString* merged, const QString& value) {
+        if (merged->isEmpty()) {
+            *merged = value;
+        } else if (!value.isEmpty() && !merged->split(QLatin1String(", ")).contains(value)) {
+            *merged += QLatin1String(", ") + value;
         }
+    };
 
-        if (static_cast<quint32>(frequencyResult.cores.size()) <= sample.cpu) {
-            frequencyResult.cores.resize(sample.cpu + 1);
+    if (isFirst) {
+        // the hardware and software of the first capture are shown for all of them
+        *merged = capture;
+        merged->applicationTime = {0, capture.applicationTime.delta()};
+        merged->costs.clear();
+        merged->topCosts = {};
+    } else {
+        merged->applicationTime.end += capture.applicationTime.delta();
+        merged->threadCount += capture.threadCount;
+        merged->processCount += capture.processCount;
+        merged->lostChunks += capture.lostChunks;
+        merged->lostEvents += capture.lostEvents;
+        merged->onCpuTime += capture.onCpuTime;
+        merged->offCpuTime += capture.offCpuTime;
+        merged->onCpuSlices.merge(capture.onCpuSlices);
+        merged->offCpuDurations.merge(capture.offCpuDurations);
+        for (auto it = capture.syscallLatencies.cbegin(), end = capture.syscallLatencies.cend(); it != end; ++it) {
+            merged->syscallLatencies[it.key()].merge(it.value());
         }
+        merged->userStackCount += capture.userStackCount;
+        merged->truncatedStackCount += capture.truncatedStackCount;
+        merged->stackDumpSize = std::max(merged->stackDumpSize, capture.stackDumpSize);
+        merged->suggestedStackDumpSize = std::max(merged->suggestedStackDumpSize, capture.suggestedStackDumpSize);
+        merged->sampleCount += capture.sampleCount;
+        merged->errors += capture.errors;
+        addDistinct(&merged->command, capture.command);
+        addDistinct(&merged->hostName, capture.hostName);
+    }
 
-        auto& core = frequencyResult.cores[sample.cpu];
-        for (const auto& cost : sample.costs) {
-            if (core.costs.size() <= cost.attributeId) {
-                const auto oldSize = core.costs.size();
-                const auto newSize = cost.attributeId + 1;
-                core.costs.resize(newSize);
+    // like the cost types of the bottom up results, see Data::BottomUpResults::mergeCapture
+    for (const auto& cost : capture.costs) {
+        auto it = std::find_if(merged->costs.begin(), merged->costs.end(), [&cost](const Data::CostSummary& merged) {
+            return merged.label == cost.label && merged.unit == cost.unit;
+        });
+        if (it == merged->costs.end()) {
+            merged->costs.push_back({cost.label, 0, 0, cost.unit});
+            it = merged->costs.end() - 1;
+        }
+        it->sampleCount += cost.sampleCount;
+        it->totalPeriod += cost.totalPeriod;
+    }
+}
+}
 
-                for (int i = oldSize; i < newSize; i++) {
-                    core.costs[i].costName = strings.at(attributes[i].name.id);
-                }
-            }
+#if KFArchive_FOUND
+namespace {
+// the exported .perfparser.zst files follow the zstd seekable format: independent frames of a fixed decompressed
+// size, followed by a skippable frame with the size of every frame. zstd itself just skips the table, so the
+// files can still be decompressed with any tool, but we can decompress the frames in parallel
+// see https://github.com/facebook/zstd/blob/dev/contrib/seekable_format/zstd_seekable_compression_format.md
+const quint32 skippableFrameMagic = 0x184D2A5E;
+const quint32 seekableMagic = 0x8F92EAB1;
+const int seekTableFooterSize = 9;
+const qint64 exportFrameSize = 16 * 1024 * 1024;
+
+struct SeekTableEntry
+{
+    quint32 compressedSize = 0;
+    quint32 decompressedSize = 0;
+};
 
-            auto& costs = core.costs[cost.attributeId];
+bool isSeekableZstdExport(const QUrl& url)
+{
+    return url.fileName().endsWith(QLatin1String(".zst"));
+}
 
-            auto frequency = static_cast<double>(cost.cost) / (sample.time - lastTime);
-            costs.values.push_back({sample.time, frequency});
-        }
+QByteArray compressFrame(const char* data, qint64 size)
+{
+    QByteArray frame;
+    QBuffer buffer(&frame);
+    KCompressionDevice device(&buffer, false, KCompressionDevice::Zstd);
+    if (!device.open(QIODevice::WriteOnly) || device.write(data, size) != size) {
+        return {};
     }
+    device.close();
+    return frame;
+}
 
-    void addSample(const Sample& sample)
-    {
-        addSampleToFrequencyData(sample);
+// compresses the perfparser output in @p input into @p outputPath, returns an error string on failure
+QString writeSeekableZstd(QFile* input, const QString& outputPath)
+{
+    using namespace ThreadWeaver;
 
-        auto* thread = eventResult.findThread(sample.pid, sample.tid);
-        if (!thread) {
-            thread = addThread(sample);
-        }
-        if (static_cast<uint>(eventResult.cpus.size()) <= sample.cpu) {
-            eventResult.cpus.resize(sample.cpu + 1);
-        }
-        auto& cpu = eventResult.cpus[sample.cpu];
+    const auto size = input->size();
+    const auto* data = size ? reinterpret_cast<const char*>(input->map(0, size)) : nullptr;
+    if (size && !data) {
+        return input->errorString();
+    }
 
-        for (const auto& sampleCost : sample.costs) {
-            Data::Event event;
-            event.time = sample.time;
-            event.cost = sampleCost.cost;
-            event.type = attributeIdsToCostIds.value(sampleCost.attributeId, -1);
-            event.stackId = internStack(sample.frames);
-            event.cpuId = sample.cpu;
-            thread->events.push_back(event);
-            cpu.events.push_back(event);
+    const auto numFrames = static_cast<int>((size + exportFrameSize - 1) / exportFrameSize);
+    QVector<QByteArray> frames(numFrames);
+    Queue queue;
+    queue.setMaximumNumberOfThreads(QThread::idealThreadCount());
+    for (int i = 0; i < numFrames; ++i) {
+        queue.stream() << make_job([&frames, data, size, i]() {
+            const auto offset = i * exportFrameSize;
+            frames[i] = compressFrame(data + offset, std::min(exportFrameSize, size - offset));
+        });
+    }
+    queue.finish();
 
-            const auto attribute = attributes.value(event.type);
-            if (attribute.type == static_cast<quint32>(AttributesDefinition::Type::Tracepoint)) {
-                Data::Tracepoint tracepoint;
-                tracepoint.time = event.time;
-                tracepoint.name = strings.value(attribute.name.id);
-                if (tracepoint.name != QLatin1String("sched:sched_switch")) {
-                    // sched_switch events are handled separately already
-                    tracepointResult.tracepoints.push_back(tracepoint);
-                }
-            }
+    QSaveFile output(outputPath);
+    if (!output.open(QIODevice::WriteOnly)) {
+        return output.errorString();
+    }
+
+    QByteArray seekTable;
+    auto appendLittleEndian = [&seekTable](quint32 value) {
+        value = qToLittleEndian(value);
+        seekTable.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    appendLittleEndian(skippableFrameMagic);
+    appendLittleEndian(static_cast<quint32>(numFrames * sizeof(SeekTableEntry) + seekTableFooterSize));
+    for (int i = 0; i < numFrames; ++i) {
+        if (frames[i].isEmpty()) {
+            return PerfParser::tr("Failed to compress the exported data.");
         }
+        output.write(frames[i]);
+        appendLittleEndian(frames[i].size());
+        appendLittleEndian(std::min(exportFrameSize, size - i * exportFrameSize));
+    }
+    appendLittleEndian(numFrames);
+    // no checksums
+    seekTable.append('\0');
+    appendLittleEndian(seekableMagic);
+    output.write(seekTable);
+
+    if (!output.commit()) {
+        return output.errorString();
+    }
+    return {};
+}
 
-        addSampleToBottomUp(sample);
-        addSampleToSummary(sample);
+// the frames of a file written by writeSeekableZstd, empty for any other file
+QVector<SeekTableEntry> readSeekTable(QFile* file)
+{
+    auto readLittleEndian = [](const QByteArray& bytes, int offset) {
+        return qFromLittleEndian<quint32>(bytes.constData() + offset);
+    };
 
-        if (sample.frames.length() > 1) {
-            m_numSamplesWithMoreThanOneFrame++;
-        }
+    const auto size = file->size();
+    if (size < seekTableFooterSize || !file->seek(size - seekTableFooterSize)) {
+        return {};
+    }
+    const auto footer = file->read(seekTableFooterSize);
+    if (footer.size() != seekTableFooterSize || readLittleEndian(footer, 5) != seekableMagic || footer.at(4) != 0) {
+        return {};
     }
 
-    void addString(const StringDefinition& string)
-    {
-        Q_ASSERT(string.id == strings.size());
-        strings.push_back(QString::fromUtf8(string.string));
+    const auto numFrames = static_cast<qint64>(readLittleEndian(footer, 0));
+    const auto tableSize = numFrames * static_cast<qint64>(sizeof(SeekTableEntry));
+    const auto tableStart = size - seekTableFooterSize - tableSize;
+    // the skippable frame header precedes the table
+    if (tableStart < 8 || !file->seek(tableStart - 8)) {
+        return {};
+    }
+    const auto table = file->read(8 + tableSize);
+    if (table.size() != 8 + tableSize || readLittleEndian(table, 0) != skippableFrameMagic
+        || readLittleEndian(table, 4) != tableSize + seekTableFooterSize) {
+        return {};
     }
 
-    void addSampleToBottomUp(const Sample& sample)
-    {
-        // TODO: optimize for groups, don't repeat the same lookup multiple times
-        for (const auto& sampleCost : sample.costs) {
-            addSampleToBottomUp(sample, sampleCost);
-        }
+    QVector<SeekTableEntry> entries(static_cast<int>(numFrames));
+    qint64 compressedSize = 0;
+    for (int i = 0; i < numFrames; ++i) {
+        entries[i] = {readLittleEndian(table, 8 + i * 8), readLittleEndian(table, 12 + i * 8)};
+        compressedSize += entries[i].compressedSize;
+    }
+    if (compressedSize != tableStart - 8) {
+        return {};
     }
+    return entries;
+}
 
-    void addSampleToBottomUp(const Sample& sample, SampleCost sampleCost)
-    {
-        if (perfScriptOutput) {
-            *perfScriptOutput << commands.names.value(sample.pid).value(sample.pid) << '\t' << sample.pid << '\t'
-                              << sample.time / 1000000000 << '.' << qSetFieldWidth(9) << qSetPadChar(QLatin1Char('0'))
-                              << sample.time % 1000000000 << qSetFieldWidth(0) << ":\t" << sampleCost.cost << ' '
-                              << strings.value(attributes.value(sampleCost.attributeId).name.id) << '\n';
-        }
+// decompresses a single frame of a seekable zstd file into @p target
+bool decompressFrame(const char* frame, const SeekTableEntry& entry, char* target)
+{
+    QBuffer buffer;
+    buffer.setData(QByteArray::fromRawData(frame, entry.compressedSize));
+    KCompressionDevice device(&buffer, false, KCompressionDevice::Zstd);
+    return device.open(QIODevice::ReadOnly) && device.read(target, entry.decompressedSize) == entry.decompressedSize;
+}
 
-        QSet<Data::Symbol> recursionGuard;
-        const auto type = attributeIdsToCostIds.value(sampleCost.attributeId, -1);
+// decompresses the frames of @p file in parallel into @p output
+bool decompressSeekableZstd(QFile* file, const QVector<SeekTableEntry>& entries, QFile* output)
+{
+    using namespace ThreadWeaver;
 
-        if (type < 0) {
-            qCWarning(LOG_PERFPARSER) << "Unexpected attribute id:" << sampleCost.attributeId << "Only know about"
-                                      << attributeIdsToCostIds.size() << "attributes so far";
-            return;
-        }
+    const auto decompressedSize = std::accumulate(
+        entries.begin(), entries.end(), qint64(0),
+        [](qint64 size, const SeekTableEntry& entry) { return size + entry.decompressedSize; });
+    if (!decompressedSize) {
+        return true;
+    }
 
-        auto frameCallback = [this, &recursionGuard, &sampleCost, type](const Data::Symbol& symbol,
-                                                                        const Data::Location& location) {
-            addCallerCalleeEvent(symbol, location, type, sampleCost.cost, &recursionGuard, &callerCalleeResult,
-                                 bottomUpResult.costs.numTypes());
+    const auto* input = reinterpret_cast<const char*>(file->map(0, file->size()));
+    if (!output->resize(decompressedSize)) {
+        return false;
+    }
+    auto* data = reinterpret_cast<char*>(output->map(0, decompressedSize));
+    if (!input || !data) {
+        return false;
+    }
 
-            if (perfScriptOutput) {
-                *perfScriptOutput << '\t' << Qt::hex << qSetFieldWidth(16) << location.address << qSetFieldWidth(0)
-                                  << Qt::dec << ' '
-                                  << (symbol.symbol.isEmpty() ? QStringLiteral("[unknown]") : symbol.symbol) << " ("
-                                  << symbol.binary << ")\n";
+    std::atomic<bool> ok {true};
+    Queue queue;
+    queue.setMaximumNumberOfThreads(QThread::idealThreadCount());
+    qint64 inputOffset = 0;
+    qint64 outputOffset = 0;
+    for (const auto& entry : entries) {
+        queue.stream() << make_job([&ok, entry, frame = input + inputOffset, target = data + outputOffset]() {
+            if (!decompressFrame(frame, entry, target)) {
+                ok = false;
             }
-        };
+        });
+        inputOffset += entry.compressedSize;
+        outputOffset += entry.decompressedSize;
+    }
+    queue.finish();
 
-        addBottomUpResult(type, sampleCost.cost, sample.pid, sample.tid, sample.cpu, sample.frames, frameCallback);
+    output->unmap(reinterpret_cast<uchar*>(data));
+    return ok;
+}
 
-        if (perfScriptOutput) {
-            *perfScriptOutput << "\n";
+// streams the decompressed contents of a file into PerfParserPrivate, without an intermediate temporary file
+// the next chunks get decompressed in the background while the current one gets parsed
+class DecompressingDevice : public QIODevice
+{
+public:
+    // the frames of a seekable zstd file get decompressed in parallel, one per core
+    DecompressingDevice(const char* data, const QVector<SeekTableEntry>& entries)
+        : m_maxPending(std::max(1, QThread::idealThreadCount()))
+    {
+        qint64 offset = 0;
+        for (const auto& entry : entries) {
+            m_frames.push_back({data + offset, entry});
+            m_remainingBytes += entry.decompressedSize;
+            offset += entry.compressedSize;
         }
+        m_numChunks = m_frames.size();
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
     }
 
-    void buildTopDownResult()
+    // other compressed files only decompress front to back, so that happens on a single thread
+    explicit DecompressingDevice(std::unique_ptr<KCompressionDevice> device)
+        : m_device(std::move(device))
+        , m_maxPending(1)
     {
-        topDownResult =
-            Data::TopDownResults::fromBottomUp(bottomUpResult, costAggregation != Settings::CostAggregation::BySymbol);
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
     }
 
-    void buildPerLibraryResult()
+    ~DecompressingDevice() override
     {
-        perLibraryResult = Data::PerLibraryResults::fromTopDown(topDownResult);
+        for (auto& chunk : m_pending) {
+            chunk.wait();
+        }
     }
 
-    void buildCallerCalleeResult()
+    bool isSequential() const override
     {
-        Data::callerCalleesFromBottomUpData(bottomUpResult, &callerCalleeResult);
+        return true;
     }
 
-    void addRecord(const Record& record)
+    qint64 bytesAvailable() const override
     {
-        uniqueProcess.insert(record.pid);
-        uniqueThreads.insert(record.tid);
-
-        if (record.time < applicationTime.start || applicationTime.start == 0) {
-            applicationTime.start = record.time;
+        // only know for sure whether we reached the end once the next chunk got decompressed
+        if (m_pos == m_current.size()) {
+            const_cast<DecompressingDevice*>(this)->nextChunk();
         }
-        if (record.time > applicationTime.end || applicationTime.end == 0) {
-            applicationTime.end = record.time;
+        const auto buffered = m_current.size() - m_pos;
+        if (m_atEnd) {
+            return buffered;
         }
+        return buffered + (m_device ? streamChunkSize : m_remainingBytes);
     }
 
-    void addSampleToSummary(const Sample& sample)
+protected:
+    qint64 readData(char* data, qint64 maxSize) override
     {
-        ++summaryResult.sampleCount;
+        qint64 bytesRead = 0;
+        while (bytesRead < maxSize && (m_pos < m_current.size() || nextChunk())) {
+            const auto size = std::min<qint64>(maxSize - bytesRead, m_current.size() - m_pos);
+            memcpy(data + bytesRead, m_current.constData() + m_pos, size);
+            m_pos += size;
+            bytesRead += size;
+        }
+        return bytesRead;
+    }
 
-        for (const auto& sampleCost : sample.costs) {
-            const auto type = attributeIdsToCostIds.value(sampleCost.attributeId, -1);
-            if (type < 0) {
-                qCWarning(LOG_PERFPARSER) << "Unexpected attribute id:" << sampleCost.attributeId << "Only know about"
-                                          << attributeIdsToCostIds.size() << "attributes so far";
-            } else {
-                auto& costSummary = summaryResult.costs[type];
-                ++costSummary.sampleCount;
-                costSummary.totalPeriod += sampleCost.cost;
-            }
+    qint64 writeData(const char* /*data*/, qint64 /*size*/) override
+    {
+        return -1;
+    }
+
+private:
+    static constexpr qint64 streamChunkSize = 4 * 1024 * 1024;
+
+    QByteArray decompressChunk(int chunk)
+    {
+        if (m_device) {
+            return m_device->read(streamChunkSize);
+        }
+
+        const auto& frame = m_frames[chunk];
+        QByteArray data(static_cast<int>(frame.second.decompressedSize), Qt::Uninitialized);
+        if (!decompressFrame(frame.first, frame.second, data.data())) {
+            qCWarning(LOG_PERFPARSER) << "failed to decompress frame" << chunk;
+            return {};
         }
+        return data;
     }
 
-    void addContextSwitch(const ContextSwitchDefinition& contextSwitch)
+    void enqueueChunks()
     {
-        auto* thread = eventResult.findThread(contextSwitch.pid, contextSwitch.tid);
-        if (!thread) {
-            return;
+        while (static_cast<int>(m_pending.size()) < m_maxPending && (m_numChunks == -1 || m_nextChunk < m_numChunks)) {
+            m_pending.push_back(std::async(std::launch::async, &DecompressingDevice::decompressChunk, this,
+                                           m_nextChunk++));
         }
+    }
 
-        if (!contextSwitch.switchOut && thread->state == Data::ThreadEvents::OffCpu) {
-            const auto switchTime = contextSwitch.time - thread->lastSwitchTime;
-            thread->offCpuTime += switchTime;
+    bool nextChunk()
+    {
+        m_current.clear();
+        m_pos = 0;
+        if (m_atEnd) {
+            return false;
+        }
 
-            if (eventResult.offCpuTimeCostId == -1) {
-                const auto label = PerfParser::tr("off-CPU Time");
-                eventResult.offCpuTimeCostId = addCostType(label, Data::Costs::Unit::Time);
-            }
+        enqueueChunks();
+        if (!m_pending.empty()) {
+            m_current = m_pending.front().get();
+            m_pending.pop_front();
+        }
+        if (m_current.isEmpty()) {
+            // either the end of the stream or a corrupt frame, both end the input
+            m_atEnd = true;
+            return false;
+        }
+        m_remainingBytes -= m_current.size();
+        // decompress the next chunk while this one gets parsed
+        enqueueChunks();
+        return true;
+    }
 
-            auto& totalCost = summaryResult.costs[eventResult.offCpuTimeCostId];
-            totalCost.sampleCount++;
-            totalCost.totalPeriod += switchTime;
+    std::unique_ptr<KCompressionDevice> m_device;
+    QVector<std::pair<const char*, SeekTableEntry>> m_frames;
+    const int m_maxPending;
+    // unknown for compressed streams, which end with the first empty chunk
+    int m_numChunks = -1;
+    int m_nextChunk = 0;
+    qint64 m_remainingBytes = 0;
+    std::deque<std::future<QByteArray>> m_pending;
+    QByteArray m_current;
+    qint64 m_pos = 0;
+    bool m_atEnd = false;
+};
 
-            qint32 stackId = -1;
-            if (!thread->events.isEmpty() && m_schedSwitchCostId != -1) {
-                auto it = std::find_if(thread->events.rbegin(), thread->events.rend(),
-                                       [this](const Data::Event& event) { return event.type == m_schedSwitchCostId; });
-                if (it != thread->events.rend()) {
-                    stackId = it->stackId;
-                }
-            }
-            if (stackId != -1) {
-                const auto& frames = eventResult.stacks[stackId];
-                QSet<Data::Symbol> recursionGuard;
-                auto frameCallback = [this, &recursionGuard, switchTime](const Data::Symbol& symbol,
-                                                                         const Data::Location& location) {
-                    addCallerCalleeEvent(symbol, location, eventResult.offCpuTimeCostId, switchTime, &recursionGuard,
-                                         &callerCalleeResult, bottomUpResult.costs.numTypes());
-                };
-                addBottomUpResult(eventResult.offCpuTimeCostId, switchTime, contextSwitch.pid, contextSwitch.tid,
-                                  contextSwitch.cpu, frames, frameCallback);
-            }
+// decompresses @p file on the fly, returns null when it isn't compressed
+std::unique_ptr<QIODevice> openDecompressed(QFile* file, const QString& path)
+{
+    auto device = std::make_unique<KCompressionDevice>(path);
+    if (device->compressionType() == KCompressionDevice::None) {
+        return {};
+    }
 
-            Data::Event event;
-            event.time = thread->lastSwitchTime;
-            event.cost = switchTime;
-            event.type = eventResult.offCpuTimeCostId;
-            event.stackId = stackId;
-            event.cpuId = contextSwitch.cpu;
-            thread->events.push_back(event);
+    if (device->compressionType() == KCompressionDevice::Zstd) {
+        const auto seekTable = readSeekTable(file);
+        const auto* data = seekTable.isEmpty() ? nullptr : file->map(0, file->size());
+        if (data) {
+            return std::make_unique<DecompressingDevice>(reinterpret_cast<const char*>(data), seekTable);
         }
+    }
 
-        thread->lastSwitchTime = contextSwitch.time;
-        thread->state = contextSwitch.switchOut ? Data::ThreadEvents::OffCpu : Data::ThreadEvents::OnCpu;
+    if (!device->open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return std::make_unique<DecompressingDevice>(std::move(device));
+}
+}
+#endif
+
+namespace {
+// the first bytes of @p path, after decompressing it if needed
+QByteArray peekFileHeader(const QString& path)
+{
+#if KFArchive_FOUND
+    KCompressionDevice device(path);
+    if (device.compressionType() != KCompressionDevice::None) {
+        return device.open(QIODevice::ReadOnly) ? device.read(11) : QByteArray();
     }
+#endif
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.peek(11) : QByteArray();
+}
 
-    template<typename FrameCallback>
-    void addBottomUpResult(int type, quint64 cost, qint32 pid, qint32 tid, quint32 cpu, const QVector<qint32>& frames,
-                           const FrameCallback& frameCallback)
+// writes events in the format of hotspot-perfparser, see PerfParserPrivate::tryParse
+class PerfStreamWriter
+{
+public:
+    using EventType = PerfParserPrivate::EventType;
+
+    explicit PerfStreamWriter(QIODevice* output)
+        : m_output(output)
+        , m_buffer(&m_event)
     {
-        ::addBottomUpResult(&bottomUpResult, costAggregation, commands, type, cost, pid, tid, cpu, frames,
-                            frameCallback);
+        // reserving keeps the buffer allocated when it gets cleared for the next event
+        m_event.reserve(4096);
+        m_buffer.open(QIODevice::WriteOnly);
+        m_stream.setDevice(&m_buffer);
+
+        // + 1 to include the trailing \0
+        m_output->write("QPERFSTREAM", 12);
+        const auto version = qToLittleEndian<qint32>(m_stream.version());
+        m_output->write(reinterpret_cast<const char*>(&version), sizeof(version));
     }
 
-    void addLost(const LostDefinition& lost)
+    template<typename Write>
+    void writeEvent(EventType type, Write&& write)
     {
-        ++summaryResult.lostChunks;
-        summaryResult.lostEvents += lost.lost;
+        m_event.resize(0);
+        m_buffer.seek(0);
+        m_stream << static_cast<qint8>(type);
+        write(m_stream);
+
+        const auto size = qToLittleEndian<quint32>(m_event.size());
+        m_output->write(reinterpret_cast<const char*>(&size), sizeof(size));
+        m_output->write(m_event);
+    }
 
-        auto* thread = eventResult.findThread(lost.pid, lost.tid);
-        if (!thread) {
-            return;
+    // every string gets defined right before the first event that references it
+    qint32 stringId(const QString& string)
+    {
+        if (string.isEmpty()) {
+            return -1;
         }
-
-        if (eventResult.lostEventCostId == -1) {
-            eventResult.lostEventCostId = addCostType(PerfParser::tr("Lost Event"), Data::Costs::Unit::Unknown);
+        auto& id = m_stringIds[string];
+        if (!id) {
+            id = m_stringIds.size();
+            writeEvent(EventType::StringDefinition,
+                       [&](QDataStream& stream) { stream << static_cast<qint32>(id - 1) << string.toUtf8(); });
         }
-
-        Data::Event event;
-        event.time = lost.time;
-        event.cost = lost.lost;
-        event.type = eventResult.lostEventCostId;
-        event.cpuId = lost.cpu;
-        thread->events.push_back(event);
-        // the lost event never has a valid cpu set, add to all CPUs
-        for (auto& cpu : eventResult.cpus)
-            cpu.events.push_back(event);
+        return id - 1;
     }
 
-    void setFeatures(const FeaturesDefinition& features)
-    {
-        if (features.cmdline.isEmpty()) {
-            summaryResult.command = QStringLiteral("??");
-        } else {
-            // first entry in cmdline is "perf" which could contain a path
-            // we only want to show the name without the path
-            auto args = features.cmdline;
-            args.removeFirst();
-            summaryResult.command = QLatin1String("perf ") + QString::fromUtf8(args.join(' '));
-        }
-        summaryResult.hostName = QString::fromUtf8(features.hostName);
-        summaryResult.linuxKernelVersion = QString::fromUtf8(features.osRelease);
-        summaryResult.perfVersion = QString::fromUtf8(features.version);
-        summaryResult.cpuDescription = QString::fromUtf8(features.cpuDesc);
-        summaryResult.cpuId = QString::fromUtf8(features.cpuId);
-        summaryResult.cpuArchitecture = QString::fromUtf8(features.arch);
-        summaryResult.cpusOnline = features.nrCpusOnline;
-        summaryResult.cpusAvailable = features.nrCpusAvailable;
-        auto formatCpuList = [](const QByteArrayList& list) -> QString {
-            return QString::fromUtf8('[' + list.join("], [") + ']');
-        };
-        summaryResult.cpuSiblingCores = formatCpuList(features.siblingCores);
-        summaryResult.cpuSiblingThreads = formatCpuList(features.siblingThreads);
-        summaryResult.totalMemoryInKiB = features.totalMem;
+private:
+    QIODevice* m_output;
+    QByteArray m_event;
+    QBuffer m_buffer;
+    QDataStream m_stream;
+    QHash<QString, qint32> m_stringIds;
+};
 
-        eventResult.cpus.resize(features.nrCpusAvailable);
+QDataStream& writeRecord(QDataStream& stream, const Data::ThreadEvents& thread, quint64 time, quint32 cpu)
+{
+    return stream << static_cast<quint32>(thread.pid) << static_cast<quint32>(thread.tid) << time << cpu;
+}
+
+// serializes the loaded results, so they can be opened again without unwinding the samples again
+// @p events may be filtered already, the threads get clipped to @p time when it is valid
+// with @p timeBuckets, the samples of a thread with the same stack, type and CPU get summed up per slice of the
+// time range into one sample at the start of the slice, which keeps the output small for the analysis server
+void writePerfStream(QIODevice* output, const Data::BottomUpResults& bottomUp, const Data::EventResults& events,
+                     const Data::TimeRange& time, quint32 timeBuckets = 0)
+{
+    using EventType = PerfParserPrivate::EventType;
+    PerfStreamWriter writer(output);
+
+    // the off-CPU time and the lost events get recreated from the context switches and lost events
+    // unless the off-CPU time got sampled, then it is written as the samples of perf record --off-cpu again
+    const auto switchedOffCpuTimeCostId = events.offCpuTimeSampled ? -1 : events.offCpuTimeCostId;
+    const auto numTypes = bottomUp.costs.numTypes();
+    QVector<qint32> attributeIds(numTypes, -1);
+    qint32 numAttributes = 0;
+    for (int type = 0; type < numTypes; ++type) {
+        if (type == switchedOffCpuTimeCostId || type == events.lostEventCostId) {
+            continue;
+        }
+        const auto name = writer.stringId(type == events.offCpuTimeCostId ? QStringLiteral("offcpu-time")
+                                                                           : bottomUp.costs.typeName(type));
+        const auto attributeType = bottomUp.costs.unit(type) == Data::Costs::Unit::Tracepoint
+            ? AttributesDefinition::Type::Tracepoint
+            : AttributesDefinition::Type::Hardware;
+        const auto id = numAttributes++;
+        attributeIds[type] = id;
+        writer.writeEvent(EventType::AttributesDefinition, [&](QDataStream& stream) {
+            // the events store their actual cost, so pretend the attribute uses a frequency to keep it as it is
+            stream << id << static_cast<quint32>(attributeType) << quint64(0) << name << true << quint64(0);
+        });
     }
 
-    void addError(const Error& error)
-    {
-        if (!encounteredErrors.contains(error.message)) {
-            summaryResult.errors << error.message;
-            encounteredErrors.insert(error.message);
+    // the symbols got resolved already, every location id is also its symbol id
+    for (qint32 id = 0, c = bottomUp.locations.size(); id < c; ++id) {
+        const auto& frame = bottomUp.locations[id];
+        const auto& location = frame.location;
+        const auto file = writer.stringId(location.fileLine.file);
+        writer.writeEvent(EventType::LocationDefinition, [&](QDataStream& stream) {
+            stream << id << location.address << file << quint32(0) << static_cast<qint32>(location.fileLine.line)
+                   << qint32(0) << frame.parentLocationId << location.relAddr;
+        });
+
+        const auto symbol = bottomUp.symbols.value(id);
+        if (!symbol.isValid()) {
+            continue;
         }
+        const auto name = writer.stringId(symbol.symbol);
+        const auto binary = writer.stringId(symbol.binary);
+        const auto path = writer.stringId(symbol.path);
+        const auto actualPath = writer.stringId(symbol.actualPath);
+        writer.writeEvent(EventType::SymbolDefinition, [&](QDataStream& stream) {
+            stream << id << name << binary << path << symbol.isKernel << symbol.relAddr << symbol.size << actualPath
+                   << symbol.isInline;
+        });
     }
 
-    enum State
-    {
-        HEADER,
-        DATA_STREAM_VERSION,
-        EVENT_HEADER,
-        EVENT,
-        PARSE_ERROR
+    auto clip = [&time](quint64 threadTime) {
+        return time.isValid() ? std::max(time.start, std::min(time.end, threadTime)) : threadTime;
     };
 
-    enum class EventType
+    for (const auto& thread : events.threads) {
+        const auto start = clip(thread.time.start);
+        writer.writeEvent(EventType::ThreadStart, [&](QDataStream& stream) {
+            // the thread is its own parent, otherwise the parser would name it after the parent
+            writeRecord(stream, thread, start, Data::INVALID_CPU_ID) << static_cast<quint32>(thread.pid);
+        });
+        if (!thread.name.isEmpty()) {
+            const auto comm = writer.stringId(thread.name);
+            writer.writeEvent(EventType::Command, [&](QDataStream& stream) {
+                writeRecord(stream, thread, start, Data::INVALID_CPU_ID) << comm;
+            });
+        }
+    }
+
+    // perfparser writes the events ordered by time, the off-CPU events are split up into both of their switches
+    struct TimedEvent
     {
-        ThreadStart,
-        ThreadEnd,
-        Command,
-        LocationDefinition,
-        SymbolDefinition,
-        StringDefinition,
-        LostDefinition,
-        FeaturesDefinition,
-        Error,
-        Progress,
-        TracePointFormat,
-        AttributesDefinition,
-        ContextSwitchDefinition,
-        Sample,
-        TracePointSample,
-        DebugInfoDownloadProgress,
-        InvalidType
+        quint64 time;
+        qint32 thread;
+        qint32 event;
+        bool switchIn;
+        // the summed up cost of an aggregated sample
+        quint64 cost;
     };
 
-    State state = HEADER;
-    quint32 eventSize = 0;
-    QBuffer buffer;
-    QDataStream stream;
-    QVector<AttributesDefinition> attributes;
-    QVector<QString> strings;
-    QIODevice* input = nullptr;
-    Data::Summary summaryResult;
-    Data::TimeRange applicationTime;
-    QSet<quint32> uniqueThreads;
-    QSet<quint32> uniqueProcess;
-    Data::BottomUpResults bottomUpResult;
-    Data::TopDownResults topDownResult;
-    Data::PerLibraryResults perLibraryResult;
-    Data::CallerCalleeResults callerCalleeResult;
-    Data::EventResults eventResult;
-    Data::TracepointResults tracepointResult;
-    Data::FrequencyResults frequencyResult;
-    Data::ThreadNames commands;
-    std::unique_ptr<QTextStream> perfScriptOutput;
-    QHash<qint32, SymbolCount> numSymbolsByModule;
-    QSet<QString> encounteredErrors;
-    QHash<QVector<qint32>, qint32> stacks;
-    std::atomic<bool> stopRequested;
-    QHash<qint32, qint32> attributeIdsToCostIds;
-    QHash<int, qint32> attributeNameToCostIds;
-    qint32 m_nextCostId = 0;
-    qint32 m_schedSwitchCostId = -1;
-    QHash<quint32, quint64> m_lastSampleTimePerCore;
-    Settings::CostAggregation costAggregation;
-    bool perfMapFileExists = false;
-
-    // samples recorded without --call-graph have only one frame
-    int m_numSamplesWithMoreThanOneFrame = 0;
-
-public slots:
-    void stop()
-    {
-        stopRequested = true;
+    quint64 firstTime = Data::MAX_TIME;
+    quint64 lastTime = 0;
+    if (timeBuckets > 0) {
+        for (const auto& thread : events.threads) {
+            for (qint32 i = 0, numEvents = thread.events.size(); i < numEvents; ++i) {
+                const auto eventTime = thread.events.at(i).time;
+                firstTime = std::min(firstTime, eventTime);
+                lastTime = std::max(lastTime, eventTime);
+            }
+        }
+    }
+    const auto bucketSize = firstTime <= lastTime ? (lastTime - firstTime) / timeBuckets + 1 : 1;
+
+    std::vector<TimedEvent> timeline;
+    for (qint32 threadIndex = 0, c = events.threads.size(); threadIndex < c; ++threadIndex) {
+        const auto& threadEvents = events.threads[threadIndex].events;
+        // the aggregated sample of each bucket, type, stack and CPU of this thread, by its index in the timeline
+        std::map<std::tuple<quint64, qint32, qint32, quint32>, std::size_t> aggregated;
+        for (qint32 i = 0, numEvents = threadEvents.size(); i < numEvents; ++i) {
+            const auto event = threadEvents.at(i);
+            if (timeBuckets > 0 && event.type != switchedOffCpuTimeCostId && event.type != events.lostEventCostId) {
+                const auto bucket = (event.time - firstTime) / bucketSize;
+                const auto key = std::make_tuple(bucket, event.type, event.stackId, event.cpuId);
+                const auto it = aggregated.find(key);
+                if (it != aggregated.end()) {
+                    timeline[it->second].cost += event.cost;
+                    continue;
+                }
+                aggregated.emplace(key, timeline.size());
+                timeline.push_back({firstTime + bucket * bucketSize, threadIndex, i, false, event.cost});
+                continue;
+            }
+            timeline.push_back({event.time, threadIndex, i, false, event.cost});
+            if (event.type == switchedOffCpuTimeCostId) {
+                timeline.push_back({event.time + event.cost, threadIndex, i, true, event.cost});
+            }
+        }
+    }
+    std::stable_sort(timeline.begin(), timeline.end(),
+                     [](const TimedEvent& lhs, const TimedEvent& rhs) { return lhs.time < rhs.time; });
+
+    static const QVector<qint32> noFrames;
+    for (const auto& timedEvent : timeline) {
+        const auto& thread = events.threads[timedEvent.thread];
+        const auto event = thread.events.at(timedEvent.event);
+        if (event.type == switchedOffCpuTimeCostId) {
+            writer.writeEvent(EventType::ContextSwitchDefinition, [&](QDataStream& stream) {
+                writeRecord(stream, thread, timedEvent.time, event.cpuId) << !timedEvent.switchIn;
+            });
+        } else if (event.type == events.lostEventCostId) {
+            writer.writeEvent(EventType::LostDefinition, [&](QDataStream& stream) {
+                writeRecord(stream, thread, event.time, event.cpuId) << event.cost;
+            });
+        } else if (const auto attributeId = attributeIds.value(event.type, -1); attributeId != -1) {
+            const auto& frames = event.stackId != -1 ? events.stacks[event.stackId] : noFrames;
+            writer.writeEvent(EventType::Sample, [&](QDataStream& stream) {
+                // no guessed frames, and a single cost
+                writeRecord(stream, thread, timedEvent.time, event.cpuId)
+                    << frames << quint8(0) << quint32(1) << attributeId << timedEvent.cost;
+            });
+        }
     }
 
-signals:
-    void progress(float percent);
-    void debugInfoDownloadProgress(const QString& module, const QString& url, qint64 numerator, qint64 denominator);
-};
+    for (const auto& thread : events.threads) {
+        if (thread.time.end != Data::MAX_TIME) {
+            writer.writeEvent(EventType::ThreadEnd, [&](QDataStream& stream) {
+                writeRecord(stream, thread, clip(thread.time.end), Data::INVALID_CPU_ID);
+            });
+        }
+    }
+}
+}
 
 PerfParser::PerfParser(QObject* parent)
     : QObject(parent)
     , m_isParsing(false)
     , m_stopRequested(false)
-    , m_costAggregationChanged(false)
+    , m_hasPartialResults(false)
+    , m_pendingSnapshots(0)
+    , m_filterResultsCache(std::make_unique<FilterResultsCache>())
+    , m_speculationQueue(std::make_unique<ThreadWeaver::Queue>())
 {
+    m_speculationQueue->setMaximumNumberOfThreads(1);
+
     qRegisterMetaType<Data::Summary>();
     qRegisterMetaType<Data::BottomUp>();
     qRegisterMetaType<Data::TopDown>();
@@ -1426,20 +4528,26 @@ PerfParser::PerfParser(QObject* parent)
     qRegisterMetaType<Data::BottomUpResults>();
     qRegisterMetaType<Data::TopDownResults>();
     qRegisterMetaType<Data::CallerCalleeResults>();
+    qRegisterMetaType<Data::ComparisonResults>();
     qRegisterMetaType<Data::EventResults>();
     qRegisterMetaType<Data::PerLibraryResults>();
+    qRegisterMetaType<Data::TopCosts>();
     qRegisterMetaType<Data::TracepointResults>();
     qRegisterMetaType<Data::FrequencyResults>();
     qRegisterMetaType<Data::ThreadNames>();
+    qRegisterMetaType<Data::MemoryUsage>();
+    qRegisterMetaType<Data::ParseProgress>();
+    qRegisterMetaType<Data::StackIndex>();
 
     // set data via signal/slot connection to ensure we don't introduce a data race
     connect(this, &PerfParser::bottomUpDataAvailable, this, [this](const Data::BottomUpResults& data) {
-        if (m_bottomUpResults.root.children.isEmpty()) {
+        // the snapshots of partial results get replaced by the full results
+        if (m_hasPartialResults || m_bottomUpResults.root.children.isEmpty()) {
             m_bottomUpResults = data;
         }
     });
     connect(this, &PerfParser::callerCalleeDataAvailable, this, [this](const Data::CallerCalleeResults& data) {
-        if (m_callerCalleeResults.entries.isEmpty()) {
+        if (m_hasPartialResults || m_callerCalleeResults.entries.isEmpty()) {
             m_callerCalleeResults = data;
         }
     });
@@ -1449,10 +4557,13 @@ PerfParser::PerfParser(QObject* parent)
         }
     });
     connect(this, &PerfParser::eventsAvailable, this, [this](const Data::EventResults& data) {
-        if (m_events.threads.isEmpty()) {
+        if (m_hasPartialResults || m_events.threads.isEmpty()) {
             m_events = data;
         }
+        m_filteredEvents = data;
     });
+    connect(this, &PerfParser::stackIndexAvailable, this,
+            [this](const Data::StackIndex& index) { m_stackIndex = index; });
     connect(this, &PerfParser::tracepointDataAvailable, this, [this](const Data::TracepointResults& data) {
         if (m_tracepointResults.tracepoints.isEmpty()) {
             m_tracepointResults = data;
@@ -1465,8 +4576,11 @@ PerfParser::PerfParser(QObject* parent)
         m_stopRequested = false;
     });
 
+    connect(this, &PerfParser::partialResultsAvailable, this, [this]() { --m_pendingSnapshots; });
+
     auto parsingStopped = [this] {
         m_isParsing = false;
+        m_hasPartialResults = false;
         m_decompressed.reset();
     };
 
@@ -1474,9 +4588,22 @@ PerfParser::PerfParser(QObject* parent)
 
     connect(this, &PerfParser::parsingFailed, this, parsingStopped);
     connect(this, &PerfParser::parsingFinished, this, parsingStopped);
+
+    // the parsers aggregate the costs as they come in, but the correction needs all lost events, so a filter
+    // applies it once the results got parsed
+    connect(this, &PerfParser::parsingFailed, this, [this]() { m_lostEventsUncorrected = false; });
+    connect(this, &PerfParser::parsingFinished, this, [this]() {
+        if (std::exchange(m_lostEventsUncorrected, false) && Settings::instance()->correctLostEvents()
+            && !m_events.lostEvents.isEmpty()) {
+            filterResults({});
+        }
+    });
 }
 
-PerfParser::~PerfParser() = default;
+PerfParser::~PerfParser()
+{
+    finishSpeculation();
+}
 
 bool PerfParser::initParserArgs(const QString& path)
 {
@@ -1486,7 +4613,7 @@ bool PerfParser::initParserArgs(const QString& path)
         emit parsingFailed(tr("File '%1' does not exist.").arg(path));
         return false;
     }
-    if (!info.isFile()) {
+    if (!info.isFile() && !info.isDir()) {
         emit parsingFailed(tr("'%1' is not a file.").arg(path));
         return false;
     }
@@ -1495,20 +4622,26 @@ bool PerfParser::initParserArgs(const QString& path)
         return false;
     }
 
+    // perf record --threads writes a directory, but perfparser reads a single file
+    const auto input = info.isDir() ? mergeDirectory(path) : path;
+    if (input.isEmpty()) {
+        return false;
+    }
+
     // peek into file header
-    const auto filename = decompressIfNeeded(path);
-    QFile file(filename);
-    file.open(QIODevice::ReadOnly);
-    if (file.peek(8) != "PERFILE2" && file.peek(11) != "QPERFSTREAM") {
-        if (file.peek(8) == "PERFFILE") {
+    const auto header = peekFileHeader(input);
+    if (!header.startsWith("PERFILE2") && !header.startsWith("QPERFSTREAM") && !isCollapsedStacks(input)
+        && !isPerfStatOutput(input)) {
+        if (header.startsWith("PERFFILE")) {
             emit parsingFailed(tr("Failed to parse file %1: %2").arg(path, tr("Unsupported V1 perf data")));
         } else {
             emit parsingFailed(tr("Failed to parse file %1: %2").arg(path, tr("File format unknown")));
         }
-        file.close();
         return false;
     }
-    file.close();
+
+    // perfparser seeks around in perf.data files, but we decompress the perfparser output while parsing it
+    const auto filename = header.startsWith("QPERFSTREAM") ? input : decompressIfNeeded(input);
 
     // check perfparser and set initial values
     auto parserBinary = Util::perfParserBinaryPath();
@@ -1517,42 +4650,7 @@ bool PerfParser::initParserArgs(const QString& path)
         return false;
     }
 
-    auto parserArgs = [](const QString& filename) {
-        const auto settings = Settings::instance();
-        QStringList parserArgs = {QStringLiteral("--input"), filename, QStringLiteral("--max-frames"),
-                                  QStringLiteral("1024")};
-        const auto sysroot = settings->sysroot();
-        if (!sysroot.isEmpty()) {
-            parserArgs += {QStringLiteral("--sysroot"), sysroot};
-        }
-        const auto kallsyms = settings->kallsyms();
-        if (!kallsyms.isEmpty()) {
-            parserArgs += {QStringLiteral("--kallsyms"), kallsyms};
-        }
-        const auto debugPaths = settings->debugPaths();
-        if (!debugPaths.isEmpty()) {
-            parserArgs += {QStringLiteral("--debug"), debugPaths};
-        }
-        const auto extraLibPaths = settings->extraLibPaths();
-        if (!extraLibPaths.isEmpty()) {
-            parserArgs += {QStringLiteral("--extra"), extraLibPaths};
-        }
-        const auto appPath = settings->appPath();
-        if (!appPath.isEmpty()) {
-            parserArgs += {QStringLiteral("--app"), appPath};
-        }
-        const auto arch = settings->arch();
-        if (!arch.isEmpty()) {
-            parserArgs += {QStringLiteral("--arch"), arch};
-        }
-        const auto perfMapPath = settings->perfMapPath();
-        if (!perfMapPath.isEmpty()) {
-            parserArgs += {QStringLiteral("--perf-map-path"), perfMapPath};
-        }
-        return parserArgs;
-    };
-
-    m_parserArgs = parserArgs(filename);
+    m_parserArgs = perfparserArgs(filename);
     m_parserBinary = parserBinary;
     return true;
 }
@@ -1561,60 +4659,196 @@ void PerfParser::startParseFile(const QString& path)
 {
     Q_ASSERT(!m_isParsing);
 
+    if (isServerUrl(path)) {
+        startParseServer(QUrl(path));
+        return;
+    }
+
     // reset the data to ensure filtering will pick up the new data
     if (!initParserArgs(path)) {
         return;
     }
 
+    const auto restriction = Data::ParseRestriction::fromString(Settings::instance()->parseRestriction());
+    if (!restriction) {
+        emit parsingFailed(tr("Invalid parse restriction: %1").arg(Settings::instance()->parseRestriction()));
+        return;
+    }
+
+    finishSpeculation();
+    cancelFilter();
+    m_filterCancelled.reset();
+    // the filters of the previous results may still use theirs
+    m_spillDirectory = std::make_shared<Data::SpillDirectory>();
+    m_lostEventsUncorrected = true;
     m_bottomUpResults = {};
     m_callerCalleeResults = {};
     m_tracepointResults = {};
     m_events = {};
+    m_filteredEvents = {};
+    m_filterTime = {};
+    m_stackIndex = {};
+    renewSymbolTableLease();
+    clearCostCube();
+    m_filterResultsCache->clear();
     m_frequencyResults = {};
+    m_hasPartialResults = m_publishPartialResults;
+    m_hasMergedResults = false;
+    ++m_comparisonGeneration;
+    m_pendingSnapshots = 0;
 
     auto debuginfodUrls = Settings::instance()->debuginfodUrls();
     const auto costAggregation = Settings::instance()->costAggregation();
+    const auto memoryBudget = static_cast<qint64>(Settings::instance()->memoryBudget()) * 1024 * 1024;
+    const auto parserCacheSize = static_cast<qint64>(Settings::instance()->parserCacheSize()) * 1024 * 1024;
+    const auto stackPruning = stackPruningFromSettings();
+    const auto foldInlines = Settings::instance()->foldInlines();
+    const auto perfMapDir = perfMapDirFromSettings();
+    const auto perfMapCache = perfMapCacheDir();
+    // there is nobody to look at a preview without partial results
+    const auto previewStride =
+        m_hasPartialResults ? static_cast<quint32>(std::max(1, Settings::instance()->previewStride())) : 1u;
+
+    // compressed files got decompressed into a temporary file by initParserArgs
+    const auto inputIndex = m_parserArgs.indexOf(QStringLiteral("--input"));
+    const auto input = inputIndex != -1 ? m_parserArgs.value(inputIndex + 1, path) : path;
 
     emit parsingStarted();
     using namespace ThreadWeaver;
-    stream() << make_job([path, parserBinary = m_parserBinary, parserArgs = m_parserArgs, debuginfodUrls,
-                          costAggregation, this]() {
+    JobScheduler::run(JobScheduler::Priority::Background, [path, input, parserBinary = m_parserBinary,
+                                                           parserArgs = m_parserArgs, debuginfodUrls, costAggregation,
+                                                           memoryBudget, parserCacheSize,
+                                                           spillDirectory = m_spillDirectory, previewStride,
+                                                           restriction = *restriction, stackPruning, foldInlines,
+                                                           perfMapDir, perfMapCache, this]() {
+#ifdef __GLIBC__
+        {
+            // the views dropped the results of the previous file by now, hand all the memory they used back at
+            // once instead of keeping the fragmented heap around for the next file. trimming walks the whole heap,
+            // so it must not block the GUI thread
+            ScopedPhase phase("release memory");
+            malloc_trim(0);
+        }
+#endif
+
         PerfParserPrivate d(costAggregation);
+        d.memoryBudget = memoryBudget;
+        d.spillDirectory = spillDirectory;
+        d.previewStride = previewStride;
+        d.restriction = restriction;
+        d.stackPruning = stackPruning;
+        d.bottomUpResult.foldInlines = foldInlines;
+        d.previewBottomUp.foldInlines = foldInlines;
+        d.perfMapDir = perfMapDir;
+        d.perfMapCacheDirectory = perfMapCache;
         connect(&d, &PerfParserPrivate::progress, this, &PerfParser::progress);
+        connect(&d, &PerfParserPrivate::parseProgress, this, &PerfParser::parseProgress);
         connect(&d, &PerfParserPrivate::debugInfoDownloadProgress, this, &PerfParser::debugInfoDownloadProgress);
         connect(this, &PerfParser::stopRequested, &d, &PerfParserPrivate::stop);
+        if (m_hasPartialResults) {
+            // the preview gets shown as soon as the first events got parsed
+            // don't pile up snapshots when the views are slower than the parsing
+            d.enableSnapshots(
+                previewStride > 1 ? 0 : FileSnapshotInterval, FileSnapshotInterval,
+                [this]() { return m_pendingSnapshots == 0; },
+                [this](const PerfParserPrivate::Snapshot& snapshot) {
+                    ++m_pendingSnapshots;
+                    publishSnapshot(this, snapshot);
+                });
+        }
+        d.startPipeline();
+
+        // set once the cache got written or used without knowing its binaries yet
+        QString cacheBinariesFor;
+        // publishResults reports the aggregation once the pipeline drained the decoded events
+        auto finalize = [&d, &cacheBinariesFor, path, this]() {
+            if (!d.finishPipeline()) {
+                if (d.stopRequested) {
+                    emit parsingFailed(tr("Parsing stopped."));
+                } else {
+                    emit parsingFailed(tr("Failed to parse file %1: %2").arg(path, tr("Unknown reason")));
+                }
+                return;
+            }
 
-        auto finalize = [&d, this]() {
-            d.finalize();
-            emit bottomUpDataAvailable(d.bottomUpResult);
-            emit topDownDataAvailable(d.topDownResult);
-            emit perLibraryDataAvailable(d.perLibraryResult);
-            emit summaryDataAvailable(d.summaryResult);
-            emit callerCalleeDataAvailable(d.callerCalleeResult);
-            emit tracepointDataAvailable(d.tracepointResult);
-            emit eventsAvailable(d.eventResult);
-            emit frequencyDataAvailable(d.frequencyResult);
-            emit threadNamesAvailable(d.commands);
-            emit perfMapFileExists(d.perfMapFileExists);
-
-            if (d.m_numSamplesWithMoreThanOneFrame == 0) {
-                emit parserWarning(tr("Samples contained no call stack frames. Consider passing <code>--call-graph "
-                                      "dwarf</code> to <code>perf record</code>."));
-            }
-
-            emit parsingFinished();
+            if (!cacheBinariesFor.isEmpty()) {
+                writePerfparserCacheBinaries(cacheBinariesFor, d.bottomUpResult.symbols);
+            }
+            publishResults(this, &d);
         };
 
         // note: file is always readable and in supported format here,
         //        already validated in initParserArgs()
-        QFile file(path);
-        file.open(QIODevice::ReadOnly);
-        if (file.peek(11) == "QPERFSTREAM") {
-            d.setInput(&file);
-            while (!file.atEnd() && !d.stopRequested) {
+        QFile file(input);
+        // we buffer large chunks ourselves, see PerfParserPrivate::ensureBuffered
+        file.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+        // folded stacks of other profilers get imported without perfparser
+        if (isCollapsedStacks(input)) {
+            const auto* mapped = file.map(0, file.size());
+            const auto data = mapped ? QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), file.size())
+                                     : file.readAll();
+            d.parseCollapsedStacks(data.constData(), data.size());
+            emit parserWarning(tr("Folded stacks have no times, threads or processes. The time line stays empty and "
+                                  "the results can't be filtered."));
+            finalize();
+            return;
+        }
+
+        if (isPerfStatOutput(input)) {
+            d.parsePerfStat(file.readAll());
+            finalize();
+            return;
+        }
+
+        std::unique_ptr<QIODevice> decompressed;
+#if KFArchive_FOUND
+        // compressed perfparser output, compressed perf.data files got decompressed by initParserArgs already
+        if (file.peek(11) != "QPERFSTREAM") {
+            decompressed = openDecompressed(&file, input);
+        }
+#endif
+
+        // reopening a recording reuses the output of perfparser, unwinding and resolving the symbols take longest
+        QString cacheFile;
+        if (parserCacheSize > 0 && !decompressed && file.peek(11) != "QPERFSTREAM") {
+            cacheFile = perfparserCacheFile(path, parserBinary, parserArgs, debuginfodUrls);
+            if (!cacheFile.isEmpty() && QFile::exists(cacheFile) && !perfparserCacheUpToDate(cacheFile)) {
+                // a binary got rebuilt, so the symbols may resolve differently now
+                QFile::remove(cacheFile);
+                QFile::remove(perfparserCacheBinariesFile(cacheFile));
+            }
+            if (!cacheFile.isEmpty() && QFile::exists(cacheFile)) {
+                if (!QFile::exists(perfparserCacheBinariesFile(cacheFile))) {
+                    cacheBinariesFor = cacheFile;
+                }
+                file.close();
+                file.setFileName(cacheFile);
+                file.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+                // marks the cache as recently used
+                file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+            }
+        }
+
+        if (decompressed || file.peek(11) == "QPERFSTREAM") {
+            // prefer mapping the file, which leaves the readahead to the kernel and
+            // makes reopening a file that's in the page cache very fast
+            if (decompressed) {
+                d.setInput(decompressed.get());
+            } else if (auto* mapped = file.map(0, file.size())) {
+                d.setMappedInput(mapped, file.size());
+            } else {
+                d.setInput(&file);
+            }
+            while (!d.isAtEnd() && !d.stopRequested) {
                 if (!d.tryParse()) {
+                    if (file.fileName() == cacheFile) {
+                        // don't fail again the next time
+                        QFile::remove(cacheFile);
+                        QFile::remove(perfparserCacheBinariesFile(cacheFile));
+                    }
                     // TODO: provide reason
-                    emit parsingFailed(tr("Failed to parse file %1: %2").arg(path, QStringLiteral("Unknown reason")));
+                    emit parsingFailed(tr("Failed to parse file %1: %2").arg(path, tr("Unknown reason")));
                     return;
                 }
             }
@@ -1623,6 +4857,166 @@ void PerfParser::startParseFile(const QString& path)
         }
         file.close();
 
+        std::unique_ptr<QSaveFile> cache;
+        if (!cacheFile.isEmpty() && QDir().mkpath(QFileInfo(cacheFile).path())) {
+            cache = std::make_unique<QSaveFile>(cacheFile);
+            if (cache->open(QIODevice::WriteOnly)) {
+                d.setInputCopy(cache.get());
+            } else {
+                cache.reset();
+            }
+        }
+
+        PerfparserProcess process;
+        process.setProcessEnvironment(perfparserEnvironment(debuginfodUrls));
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        connect(this, &PerfParser::stopRequested, &process, &QProcess::kill);
+
+        const auto outputFd = process.openOutputPipe();
+        if (outputFd != -1) {
+            d.setInputFd(outputFd);
+        } else {
+            d.setInput(&process);
+        }
+
+        // the time perfparser takes to unwind and resolve the recording, which hotspot mostly waits for
+        qint64 processStart = 0;
+        connect(&process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), &process,
+                [finalize, &d, &cache, &cacheBinariesFor, &processStart, parserCacheSize,
+                 this](int exitCode, QProcess::ExitStatus exitStatus) {
+                    auto* profiler = SelfProfiler::instance();
+                    profiler->addPhase("perfparser process", processStart, profiler->now());
+                    if (m_stopRequested) {
+                        emit parsingFailed(tr("Parsing stopped."));
+                        return;
+                    }
+                    qCDebug(LOG_PERFPARSER) << exitCode << exitStatus;
+
+                    const auto error = perfparserExitError(exitCode);
+                    if (error.isEmpty()) {
+                        // an incomplete cache gets discarded by QSaveFile
+                        if (cache && exitStatus == QProcess::NormalExit && d.isCompleteStream()
+                            && cache->commit()) {
+                            prunePerfparserCache(QFileInfo(cache->fileName()).path(), parserCacheSize);
+                            cacheBinariesFor = cache->fileName();
+                        }
+                        finalize();
+                    } else {
+                        emit parsingFailed(error);
+                    }
+                });
+
+        connect(&process, &QProcess::errorOccurred, &process, [&process, this](QProcess::ProcessError error) {
+            if (m_stopRequested) {
+                emit parsingFailed(tr("Parsing stopped."));
+                return;
+            }
+
+            qCWarning(LOG_PERFPARSER) << error << process.errorString();
+
+            emit parsingFailed(process.errorString());
+        });
+
+        processStart = SelfProfiler::instance()->now();
+        process.start(parserBinary, parserArgs + process.outputArgs());
+        if (!process.waitForStarted()) {
+            emit parsingFailed(tr("Failed to start the hotspot-perfparser process"));
+            return;
+        }
+
+        if (outputFd != -1) {
+            process.closeWriteEnd();
+            // the reads below block, so stopping has to kill perfparser right away to close the pipe
+            const auto pid = process.processId();
+            connect(this, &PerfParser::stopRequested, &d, [pid]() { ::kill(static_cast<pid_t>(pid), SIGKILL); },
+                    Qt::DirectConnection);
+            while (d.tryParse()) {
+                // parse until the pipe got closed
+            }
+            if (!d.isAtEnd()) {
+                // perfparser would block on the full pipe otherwise
+                process.kill();
+            }
+            // emits finished, which publishes the results
+            process.waitForFinished(-1);
+            return;
+        }
+
+        QEventLoop loop;
+        connect(&process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), &loop,
+                &QEventLoop::quit);
+        loop.exec();
+    });
+}
+
+void PerfParser::startParseLive(const QString& outputPath)
+{
+    Q_ASSERT(!m_isParsing);
+
+    auto parserBinary = Util::perfParserBinaryPath();
+    if (parserBinary.isEmpty()) {
+        emit parsingFailed(tr("Failed to find hotspot-perfparser binary."));
+        return;
+    }
+    // exporting reparses the recorded file once the recording finished
+    m_parserBinary = parserBinary;
+    m_parserArgs = perfparserArgs(outputPath);
+
+    finishSpeculation();
+    cancelFilter();
+    m_filterCancelled.reset();
+    // the filters of the previous results may still use theirs
+    m_spillDirectory = std::make_shared<Data::SpillDirectory>();
+    m_lostEventsUncorrected = true;
+    m_bottomUpResults = {};
+    m_callerCalleeResults = {};
+    m_tracepointResults = {};
+    m_events = {};
+    m_filteredEvents = {};
+    m_filterTime = {};
+    m_stackIndex = {};
+    renewSymbolTableLease();
+    clearCostCube();
+    m_filterResultsCache->clear();
+    m_frequencyResults = {};
+
+    {
+        QMutexLocker lock(&m_liveInputMutex);
+        m_liveInput.clear();
+        m_liveInputFinished = false;
+    }
+    m_hasPartialResults = true;
+    m_hasMergedResults = false;
+    ++m_comparisonGeneration;
+    m_pendingSnapshots = 0;
+
+    auto debuginfodUrls = Settings::instance()->debuginfodUrls();
+    const auto costAggregation = Settings::instance()->costAggregation();
+    const auto memoryBudget = static_cast<qint64>(Settings::instance()->memoryBudget()) * 1024 * 1024;
+    const auto stackPruning = stackPruningFromSettings();
+    const auto foldInlines = Settings::instance()->foldInlines();
+    const auto perfMapDir = perfMapDirFromSettings();
+    const auto perfMapCache = perfMapCacheDir();
+
+    emit parsingStarted();
+    using namespace ThreadWeaver;
+    JobScheduler::run(JobScheduler::Priority::Background, [parserBinary, parserArgs = perfparserArgs({}),
+                                                           debuginfodUrls, costAggregation, memoryBudget,
+                                                           spillDirectory = m_spillDirectory, stackPruning,
+                                                           foldInlines, perfMapDir, perfMapCache, this]() {
+        // the snapshots are built on this thread, so no pipeline is started that would aggregate concurrently
+        // the input arrives at the pace of the recording anyway
+        PerfParserPrivate d(costAggregation);
+        d.memoryBudget = memoryBudget;
+        d.spillDirectory = spillDirectory;
+        d.stackPruning = stackPruning;
+        d.bottomUpResult.foldInlines = foldInlines;
+        d.perfMapDir = perfMapDir;
+        d.perfMapCacheDirectory = perfMapCache;
+        connect(&d, &PerfParserPrivate::parseProgress, this, &PerfParser::parseProgress);
+        connect(&d, &PerfParserPrivate::debugInfoDownloadProgress, this, &PerfParser::debugInfoDownloadProgress);
+        connect(this, &PerfParser::stopRequested, &d, &PerfParserPrivate::stop);
+
         QProcess process;
         process.setProcessEnvironment(perfparserEnvironment(debuginfodUrls));
         process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
@@ -1630,53 +5024,47 @@ void PerfParser::startParseFile(const QString& path)
 
         d.setInput(&process);
 
+        // the input gets buffered in m_liveInput, so nothing is lost before the process is up
+        auto writeInput = [&process, this]() {
+            QMutexLocker lock(&m_liveInputMutex);
+            if (!m_liveInput.isEmpty()) {
+                process.write(m_liveInput);
+                m_liveInput.clear();
+            }
+            if (m_liveInputFinished) {
+                process.closeWriteChannel();
+            }
+        };
+        connect(this, &PerfParser::liveInputChanged, &process, writeInput);
+        connect(&process, &QProcess::started, &process, writeInput);
+
+        QTimer snapshotTimer;
+        snapshotTimer.setInterval(LiveSnapshotInterval);
+        quint64 lastSnapshotSampleCount = 0;
+        connect(&snapshotTimer, &QTimer::timeout, &process, [&d, &lastSnapshotSampleCount, this]() {
+            // don't pile up snapshots when the views are slower than the recording
+            if (m_pendingSnapshots > 0 || d.summaryResult.sampleCount == lastSnapshotSampleCount) {
+                return;
+            }
+            lastSnapshotSampleCount = d.summaryResult.sampleCount;
+            ++m_pendingSnapshots;
+            publishSnapshot(this, d.snapshot());
+        });
+
         connect(&process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), &process,
-                [finalize, this](int exitCode, QProcess::ExitStatus exitStatus) {
+                [&d, &snapshotTimer, this](int exitCode, QProcess::ExitStatus exitStatus) {
+                    snapshotTimer.stop();
                     if (m_stopRequested) {
                         emit parsingFailed(tr("Parsing stopped."));
                         return;
                     }
                     qCDebug(LOG_PERFPARSER) << exitCode << exitStatus;
 
-                    enum ErrorCodes
-                    {
-                        NoError,
-                        TcpSocketError,
-                        CannotOpen,
-                        BadMagic,
-                        HeaderError,
-                        DataError,
-                        MissingData,
-                        InvalidOption
-                    };
-                    switch (exitCode) {
-                    case NoError:
-                        finalize();
-                        break;
-                    case TcpSocketError:
-                        emit parsingFailed(
-                            tr("The hotspot-perfparser binary exited with code %1 (TCP socket error).").arg(exitCode));
-                        break;
-                    case CannotOpen:
-                        emit parsingFailed(
-                            tr("The hotspot-perfparser binary exited with code %1 (file could not be opened).")
-                                .arg(exitCode));
-                        break;
-                    case BadMagic:
-                    case HeaderError:
-                    case DataError:
-                    case MissingData:
-                        emit parsingFailed(
-                            tr("The hotspot-perfparser binary exited with code %1 (invalid perf data file).")
-                                .arg(exitCode));
-                        break;
-                    case InvalidOption:
-                        emit parsingFailed(
-                            tr("The hotspot-perfparser binary exited with code %1 (invalid option).").arg(exitCode));
-                        break;
-                    default:
-                        emit parsingFailed(tr("The hotspot-perfparser binary exited with code %1.").arg(exitCode));
-                        break;
+                    const auto error = perfparserExitError(exitCode);
+                    if (error.isEmpty()) {
+                        publishResults(this, &d);
+                    } else {
+                        emit parsingFailed(error);
                     }
                 });
 
@@ -1691,233 +5079,805 @@ void PerfParser::startParseFile(const QString& path)
             emit parsingFailed(process.errorString());
         });
 
-        process.start(parserBinary, parserArgs);
-        if (!process.waitForStarted()) {
-            emit parsingFailed(tr("Failed to start the hotspot-perfparser process"));
+        process.start(parserBinary, parserArgs);
+        if (!process.waitForStarted()) {
+            emit parsingFailed(tr("Failed to start the hotspot-perfparser process"));
+            return;
+        }
+        snapshotTimer.start();
+
+        QEventLoop loop;
+        connect(&process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), &loop,
+                &QEventLoop::quit);
+        loop.exec();
+    });
+}
+
+void PerfParser::startParseServer(const QUrl& url)
+{
+    const auto restriction = Data::ParseRestriction::fromString(Settings::instance()->parseRestriction());
+    if (!restriction) {
+        emit parsingFailed(tr("Invalid parse restriction: %1").arg(Settings::instance()->parseRestriction()));
+        return;
+    }
+
+    finishSpeculation();
+    cancelFilter();
+    m_filterCancelled.reset();
+    // the filters of the previous results may still use theirs
+    m_spillDirectory = std::make_shared<Data::SpillDirectory>();
+    m_lostEventsUncorrected = true;
+    m_bottomUpResults = {};
+    m_callerCalleeResults = {};
+    m_tracepointResults = {};
+    m_events = {};
+    m_filteredEvents = {};
+    m_filterTime = {};
+    m_stackIndex = {};
+    renewSymbolTableLease();
+    clearCostCube();
+    m_filterResultsCache->clear();
+    m_frequencyResults = {};
+    m_hasPartialResults = false;
+    m_hasMergedResults = false;
+    ++m_comparisonGeneration;
+    m_pendingSnapshots = 0;
+
+    const auto costAggregation = Settings::instance()->costAggregation();
+    const auto memoryBudget = static_cast<qint64>(Settings::instance()->memoryBudget()) * 1024 * 1024;
+    const auto stackPruning = stackPruningFromSettings();
+    const auto foldInlines = Settings::instance()->foldInlines();
+
+    emit parsingStarted();
+    JobScheduler::run(JobScheduler::Priority::Background, [url, costAggregation, memoryBudget,
+                                                           spillDirectory = m_spillDirectory,
+                                                           restriction = *restriction, stackPruning, foldInlines,
+                                                           this]() {
+        // the server resolved the symbols already, the perf maps of this machine have nothing to do with them
+        PerfParserPrivate d(costAggregation);
+        d.memoryBudget = memoryBudget;
+        d.spillDirectory = spillDirectory;
+        d.restriction = restriction;
+        d.stackPruning = stackPruning;
+        d.bottomUpResult.foldInlines = foldInlines;
+        connect(&d, &PerfParserPrivate::parseProgress, this, &PerfParser::parseProgress);
+        connect(this, &PerfParser::stopRequested, &d, &PerfParserPrivate::stop);
+        d.startPipeline();
+
+        QTcpSocket socket;
+        connect(this, &PerfParser::stopRequested, &socket, &QTcpSocket::abort);
+        d.setInput(&socket);
+
+        socket.connectToHost(url.host(), static_cast<quint16>(url.port(DefaultServerPort)));
+        if (!socket.waitForConnected()) {
+            emit parsingFailed(
+                tr("Failed to connect to the analysis server %1: %2").arg(url.toString(), socket.errorString()));
+            return;
+        }
+        socket.write(serverRequest(ServerTimeBuckets));
+
+        // the server closes the connection once it sent all of the results
+        QEventLoop loop;
+        connect(&socket, &QTcpSocket::disconnected, &loop, &QEventLoop::quit);
+        connect(&socket, &QTcpSocket::errorOccurred, &loop, &QEventLoop::quit);
+        if (socket.state() == QAbstractSocket::ConnectedState) {
+            loop.exec();
+        }
+        while (d.tryParse()) {
+            // the data that arrived along with the disconnect
+        }
+
+        if (m_stopRequested) {
+            emit parsingFailed(tr("Parsing stopped."));
+            return;
+        }
+        if (!d.isCompleteStream()) {
+            emit parsingFailed(tr("The analysis server %1 sent incomplete results: %2")
+                                   .arg(url.toString(), socket.errorString()));
+            return;
+        }
+
+        if (!d.finishPipeline()) {
+            emit parsingFailed(tr("Failed to parse the results of %1: %2").arg(url.toString(), tr("Unknown reason")));
+            return;
+        }
+        publishResults(this, &d);
+    });
+}
+
+bool PerfParser::isServerUrl(const QString& path)
+{
+    return path.startsWith(serverUrlScheme + QLatin1String("://"));
+}
+
+QByteArray PerfParser::serverRequest(quint32 timeBuckets)
+{
+    return serverRequestPrefix + QByteArray::number(timeBuckets) + '\n';
+}
+
+quint32 PerfParser::parseServerRequest(const QByteArray& request)
+{
+    if (!request.startsWith(serverRequestPrefix)) {
+        return 0;
+    }
+    bool ok = false;
+    const auto timeBuckets = request.mid(serverRequestPrefix.size()).trimmed().toUInt(&ok);
+    return ok ? timeBuckets : 0;
+}
+
+void PerfParser::writeServedResults(QIODevice* output, const Data::BottomUpResults& bottomUp,
+                                    const Data::EventResults& events, quint32 timeBuckets)
+{
+    writePerfStream(output, bottomUp, events, {}, timeBuckets);
+}
+
+void PerfParser::addLiveInput(const QByteArray& data)
+{
+    {
+        QMutexLocker lock(&m_liveInputMutex);
+        m_liveInput.append(data);
+    }
+    emit liveInputChanged();
+}
+
+void PerfParser::finishLiveInput()
+{
+    {
+        QMutexLocker lock(&m_liveInputMutex);
+        m_liveInputFinished = true;
+    }
+    emit liveInputChanged();
+}
+
+struct PerfParser::MergeState
+{
+    QStringList pending;
+    int numFiles = 0;
+    int numRunning = 0;
+    int numDone = 0;
+    // the costs get merged by the parsers as they publish them
+    QMutex mutex;
+    int numMerged = 0;
+    Data::BottomUpResults bottomUp;
+    Data::Summary summary;
+    QStringList errors;
+};
+
+void PerfParser::startMergeFiles(const QStringList& paths)
+{
+    Q_ASSERT(!m_isParsing);
+
+    finishSpeculation();
+    cancelFilter();
+    m_filterCancelled.reset();
+    // the filters of the previous results may still use theirs
+    m_spillDirectory = std::make_shared<Data::SpillDirectory>();
+    m_bottomUpResults = {};
+    m_callerCalleeResults = {};
+    m_tracepointResults = {};
+    m_events = {};
+    m_filteredEvents = {};
+    m_filterTime = {};
+    m_stackIndex = {};
+    renewSymbolTableLease();
+    clearCostCube();
+    m_filterResultsCache->clear();
+    m_frequencyResults = {};
+    m_hasPartialResults = false;
+    m_hasMergedResults = true;
+    ++m_comparisonGeneration;
+    m_pendingSnapshots = 0;
+
+    auto state = std::make_shared<MergeState>();
+    state->pending = paths;
+    state->numFiles = paths.size();
+
+    emit parsingStarted();
+    emit progress(0);
+    continueMerge(state);
+}
+
+void PerfParser::continueMerge(const std::shared_ptr<MergeState>& state)
+{
+    // every parser is parallel on its own, so a few of them at once keep the cores busy while perfparser unwinds
+    // this also bounds the memory taken by the events of the files that got parsed but not merged yet
+    const auto maxRunning = std::max(1, QThread::idealThreadCount() / 4);
+    if (state->pending.isEmpty() || m_stopRequested) {
+        if (state->numRunning == 0) {
+            finishMerge(state);
+        }
+        return;
+    }
+
+    while (!state->pending.isEmpty() && state->numRunning < maxRunning) {
+        const auto path = state->pending.takeFirst();
+        ++state->numRunning;
+
+        auto* parser = new PerfParser(this);
+        // merged right away on the thread of the parser, which then drops its events
+        connect(
+            parser, &PerfParser::bottomUpDataAvailable, parser,
+            [state](const Data::BottomUpResults& data) {
+                QMutexLocker lock(&state->mutex);
+                state->bottomUp.mergeCapture(data);
+            },
+            Qt::DirectConnection);
+        connect(
+            parser, &PerfParser::summaryDataAvailable, parser,
+            [state](const Data::Summary& data) {
+                QMutexLocker lock(&state->mutex);
+                mergeCaptureSummary(&state->summary, data, state->numMerged == 0);
+                ++state->numMerged;
+            },
+            Qt::DirectConnection);
+
+        // a failure may follow the results, only the first one counts
+        auto isDone = std::make_shared<bool>(false);
+        auto done = [this, state, parser, path, isDone](const QString& errorMessage) {
+            if (*isDone) {
+                return;
+            }
+            *isDone = true;
+            if (!errorMessage.isEmpty()) {
+                state->errors << tr("Failed to merge %1: %2").arg(path, errorMessage);
+            }
+            parser->deleteLater();
+            --state->numRunning;
+            ++state->numDone;
+            emit progress(static_cast<float>(state->numDone) / state->numFiles);
+            continueMerge(state);
+        };
+        connect(parser, &PerfParser::parsingFinished, this, [done]() { done({}); });
+        connect(parser, &PerfParser::parsingFailed, this, done);
+        connect(this, &PerfParser::stopRequested, parser, &PerfParser::stop);
+
+        // files that can't be opened fail right away, which continues with the next ones already
+        parser->startParseFile(path);
+    }
+}
+
+void PerfParser::finishMerge(const std::shared_ptr<MergeState>& state)
+{
+    if (m_stopRequested) {
+        emit parsingFailed(tr("Parsing stopped."));
+        return;
+    }
+    if (state->numMerged == 0) {
+        emit parsingFailed(state->errors.join(QLatin1Char('\n')));
+        return;
+    }
+
+    const auto skipFirstLevel = Settings::instance()->costAggregation() != Settings::CostAggregation::BySymbol;
+    JobScheduler::run(JobScheduler::Priority::Background, [state, skipFirstLevel, this]() {
+        ThreadWeaver::Queue queue;
+        queue.setMaximumNumberOfThreads(QThread::idealThreadCount());
+
+        const auto& bottomUp = state->bottomUp;
+        auto summary = state->summary;
+        summary.errors += state->errors;
+        summary.topCosts = Data::TopCosts::fromBottomUp(bottomUp, skipFirstLevel);
+        // the parsers published their results in any order, the views expect the cost summaries in the order of
+        // the cost types
+        auto costType = [&bottomUp](const Data::CostSummary& cost) {
+            int type = 0;
+            while (type < bottomUp.costs.numTypes()
+                   && (bottomUp.costs.typeName(type) != cost.label || bottomUp.costs.unit(type) != cost.unit)) {
+                ++type;
+            }
+            return type;
+        };
+        std::stable_sort(summary.costs.begin(), summary.costs.end(),
+                         [&costType](const Data::CostSummary& lhs, const Data::CostSummary& rhs) {
+                             return costType(lhs) < costType(rhs);
+                         });
+        // there is no time line, but the views show the cost types of the events
+        Data::EventResults events;
+        events.totalCosts = summary.costs;
+
+        emit bottomUpDataAvailable(bottomUp);
+        emit summaryDataAvailable(summary);
+        emit eventsAvailable(events);
+
+        Data::CallerCalleeResults callerCallee;
+        callerCalleesFromBottomUpData(&queue, bottomUp, &callerCallee);
+        const auto topDown = topDownFromBottomUpData(&queue, bottomUp, skipFirstLevel);
+        emit topDownDataAvailable(topDown);
+        emit perLibraryDataAvailable(perLibraryFromTopDownData(&queue, topDown));
+        emit callerCalleeDataAvailable(callerCallee);
+        emit memoryUsageAvailable(
+            Data::MemoryUsage::fromResults(bottomUp, callerCallee, events, Data::FrequencyResults {},
+                                           Data::TracepointResults {}));
+        emit parsingFinished();
+    });
+}
+
+void PerfParser::startCompare(const QString& baselinePath)
+{
+    if (m_isParsing || m_hasPartialResults || m_hasMergedResults) {
+        emit parserWarning(tr("Only the complete results of a single capture can be compared with a baseline."));
+        return;
+    }
+
+    const auto generation = ++m_comparisonGeneration;
+    // the baseline gets parsed by a parser of its own, which leaves the events of this one alone
+    auto* parser = new PerfParser(this);
+    auto baseline = std::make_shared<Data::BottomUpResults>();
+    connect(
+        parser, &PerfParser::bottomUpDataAvailable, parser,
+        [baseline](const Data::BottomUpResults& data) { *baseline = data; }, Qt::DirectConnection);
+
+    // a failure may follow the results, only the first one counts
+    auto isDone = std::make_shared<bool>(false);
+    connect(parser, &PerfParser::parsingFailed, this, [this, parser, isDone](const QString& errorMessage) {
+        if (*isDone) {
+            return;
+        }
+        *isDone = true;
+        parser->deleteLater();
+        emit parserWarning(tr("Failed to compare with the baseline: %1").arg(errorMessage));
+    });
+    connect(parser, &PerfParser::parsingFinished, this, [this, parser, baseline, isDone, generation]() {
+        if (*isDone) {
+            return;
+        }
+        *isDone = true;
+        parser->deleteLater();
+        if (generation != m_comparisonGeneration) {
             return;
         }
 
-        QEventLoop loop;
-        connect(&process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), &loop,
-                &QEventLoop::quit);
-        loop.exec();
+        const auto skipFirstLevel = Settings::instance()->costAggregation() != Settings::CostAggregation::BySymbol;
+        JobScheduler::run(JobScheduler::Priority::Background,
+                          [this, current = m_bottomUpResults, baseline, skipFirstLevel, generation]() {
+                              ThreadWeaver::Queue queue;
+                              queue.setMaximumNumberOfThreads(QThread::idealThreadCount());
+
+                              Data::ComparisonResults results;
+                              results.bottomUp = Data::BottomUpResults::compareCaptures(*baseline, current);
+                              callerCalleesFromBottomUpData(&queue, results.bottomUp, &results.callerCallee);
+                              results.topDown = topDownFromBottomUpData(&queue, results.bottomUp, skipFirstLevel);
+                              if (generation == m_comparisonGeneration) {
+                                  emit comparisonDataAvailable(results);
+                              }
+                          });
     });
+    connect(this, &PerfParser::stopRequested, parser, &PerfParser::stop);
+
+    parser->startParseFile(baselinePath);
+}
+
+void PerfParser::setPublishPartialResults(bool publish)
+{
+    m_publishPartialResults = publish;
 }
 
 void PerfParser::filterResults(const Data::FilterAction& filter)
 {
-    Q_ASSERT(!m_isParsing);
+    // partial results can't be filtered, the filters apply once parsing finished
+    // merged results have no events left that could be filtered, like folded stacks and the counts of perf stat
+    if (m_hasPartialResults || m_hasMergedResults || (m_events.threads.isEmpty() && m_events.cpus.isEmpty())) {
+        return;
+    }
+    // only a previous filter may still be running, which the new one supersedes
+    Q_ASSERT(!m_isParsing || m_filterCancelled);
+
+    // a speculation of this filter keeps running, filterResults waits for it instead of starting over
+    if (filter != m_speculatedFilter) {
+        cancelSpeculation();
+    }
+    cancelFilter();
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    m_filterCancelled = cancelled;
+    auto generation = ++m_filterGeneration;
+    if (generation == 0) {
+        // 0 is reserved for the speculations
+        generation = ++m_filterGeneration;
+    }
 
+    m_filterTime = filter.time;
+    // the filtered results replace a comparison that is still getting computed
+    ++m_comparisonGeneration;
     emit parsingStarted();
+    const auto costAggregation = Settings::instance()->costAggregation();
+    const auto correctLostEventsSetting = Settings::instance()->correctLostEvents();
+    const auto foldInlines = Settings::instance()->foldInlines();
+    JobScheduler::run(JobScheduler::Priority::Normal,
+                      [this, filter, costAggregation, costAggregationChanged = m_costAggregationChanged,
+                       correctLostEventsSetting, foldInlines, stackIndex = m_stackIndex,
+                       spillDirectory = m_spillDirectory, cancelled, generation]() {
+                          runFilter(filter, costAggregation, costAggregationChanged, correctLostEventsSetting,
+                                    foldInlines, stackIndex, spillDirectory.get(), *cancelled, generation);
+                      });
+}
+
+void PerfParser::precomputeFilter(const Data::FilterAction& filter)
+{
+    if (m_hasPartialResults || m_hasMergedResults || m_isParsing || !filter.isValid()
+        || filter == m_speculatedFilter) {
+        return;
+    }
+
+    cancelSpeculation();
+    m_speculatedFilter = filter;
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    m_speculationCancelled = cancelled;
+
     using namespace ThreadWeaver;
     const auto costAggregation = Settings::instance()->costAggregation();
-    stream() << make_job([this, filter, costAggregation]() {
-        Queue queue;
-        queue.setMaximumNumberOfThreads(QThread::idealThreadCount());
+    const auto correctLostEventsSetting = Settings::instance()->correctLostEvents();
+    const auto foldInlines = Settings::instance()->foldInlines();
+    m_speculationQueue->stream() << make_job([this, filter, costAggregation,
+                                              costAggregationChanged = m_costAggregationChanged,
+                                              correctLostEventsSetting, foldInlines, stackIndex = m_stackIndex,
+                                              spillDirectory = m_spillDirectory, cancelled]() {
+        if (*cancelled) {
+            return;
+        }
+        // the speculation must not slow down what the user is doing right now
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+        runFilter(filter, costAggregation, costAggregationChanged, correctLostEventsSetting, foldInlines, stackIndex,
+                  spillDirectory.get(), *cancelled, 0);
+    });
+}
 
-        Data::BottomUpResults bottomUp;
-        Data::EventResults events = m_events;
-        Data::CallerCalleeResults callerCallee;
-        Data::TracepointResults tracepointResults = m_tracepointResults;
-        auto frequencyResults = m_frequencyResults;
-        const bool filterByTime = filter.time.isValid();
-        const bool filterByCpu = filter.cpuId != std::numeric_limits<quint32>::max();
-        const bool excludeByCpu = !filter.excludeCpuIds.isEmpty();
-        const bool includeBySymbol = !filter.includeSymbols.isEmpty();
-        const bool excludeBySymbol = !filter.excludeSymbols.isEmpty();
-        const bool includeByBinary = !filter.includeBinaries.isEmpty();
-        const bool excludeByBinary = !filter.excludeBinaries.isEmpty();
-        const bool filterByStack = includeBySymbol || excludeBySymbol || includeByBinary || excludeByBinary;
-
-        if (!filter.isValid() && !m_costAggregationChanged) {
-            bottomUp = m_bottomUpResults;
-            callerCallee = m_callerCalleeResults;
-        } else {
-            bottomUp.symbols = m_bottomUpResults.symbols;
-            bottomUp.locations = m_bottomUpResults.locations;
-            bottomUp.costs.initializeCostsFrom(m_bottomUpResults.costs);
-            bottomUp.costs.clearTotalCost();
-            const int numCosts = m_bottomUpResults.costs.numTypes();
-
-            // rebuild per-CPU data, i.e. wipe all the events and then re-add them
-            for (auto& cpu : events.cpus) {
-                cpu.events.clear();
-            }
-
-            // we filter all available stacks and then remember the stack ids that should be
-            // included, which is hopefully less work than filtering the stack for every event
-            QVector<bool> filterStacks;
-            if (filterByStack) {
-                filterStacks.resize(m_events.stacks.size());
-
-                const auto threadCount = queue.maximumNumberOfThreads();
-                const auto jobsPerThread = m_events.stacks.size() / threadCount;
-
-                auto filterStack = [&filter, &filterStacks, this](int start, int stop) {
-                    for (qint32 stackId = start, c = stop; stackId < c; ++stackId) {
-                        //  if empty, then all include filters are matched
-                        auto includedSymbols = filter.includeSymbols;
-                        auto includedBinaries = filter.includeBinaries;
-                        // if false, then none of the exclude filters matched
-                        bool excluded = false;
-                        m_bottomUpResults.foreachFrame(
-                            m_events.stacks.at(stackId),
-                            [&includedSymbols, &includedBinaries, &excluded,
-                             &filter](const Data::Symbol& symbol, const Data::Location& /*location*/) {
-                                excluded = filter.excludeSymbols.contains(symbol);
-                                if (excluded) {
-                                    return false;
-                                }
-                                includedSymbols.remove(symbol);
-
-                                excluded = filter.excludeBinaries.contains(symbol.binary);
-                                if (excluded) {
-                                    return false;
-                                }
-                                includedBinaries.remove(symbol.binary);
-
-                                // only stop when we included everything and no exclude filter is
-                                // set
-                                return !includedSymbols.isEmpty() || !filter.excludeSymbols.isEmpty()
-                                    || includedBinaries.isEmpty() || !filter.excludeBinaries.isEmpty();
-                            });
-                        filterStacks[stackId] = !excluded && includedSymbols.isEmpty() && includedBinaries.isEmpty();
-                    }
-                };
+void PerfParser::cancelSpeculation()
+{
+    if (m_speculationCancelled) {
+        *m_speculationCancelled = true;
+        m_speculationCancelled.reset();
+    }
+    m_speculatedFilter = {};
+}
+
+void PerfParser::cancelFilter()
+{
+    if (m_filterCancelled) {
+        *m_filterCancelled = true;
+    }
+}
+
+void PerfParser::finishSpeculation()
+{
+    cancelSpeculation();
+    m_speculationQueue->dequeue();
+    m_speculationQueue->finish();
+}
+
+void PerfParser::renewSymbolTableLease()
+{
+    // the previous results are gone, so the table may drop their symbols unless another parser still uses them
+    m_symbolTableLease.reset();
+    m_symbolTableLease = std::make_unique<Data::SymbolTableLease>();
+}
+
+void PerfParser::clearCostCube()
+{
+    QMutexLocker locker(&m_costCubeMutex);
+    m_costCube = {};
+}
 
-                for (int i = 0; i < threadCount - 1; i++) {
-                    queue.stream() << make_job(
-                        [filterStack, i, jobsPerThread] { filterStack(i * jobsPerThread, (i + 1) * jobsPerThread); });
+void PerfParser::runFilter(const Data::FilterAction& filter, Settings::CostAggregation costAggregation,
+                           bool costAggregationChanged, bool correctLostEventsSetting, bool foldInlines,
+                           const Data::StackIndex& stackIndex, Data::SpillDirectory* spillDirectory,
+                           const std::atomic<bool>& cancelled, uint generation)
+{
+    using namespace ThreadWeaver;
+    // the filtered events of a parse that exceeded the memory budget get spilled as well
+    const Data::ScopedSpillDirectory spill(spillDirectory);
+    const bool isSpeculative = generation == 0;
+    // the results get handed to the GUI thread, which is the only one to change the generation, and dropped there
+    // once a newer filter got applied. so a superseded job can't publish anything after the newer one did
+    auto publish = [this, generation](std::function<void()> emitResults) {
+        if (generation == 0) {
+            return;
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, generation, emitResults = std::move(emitResults)]() {
+                if (generation == m_filterGeneration) {
+                    emitResults();
                 }
+            },
+            Qt::QueuedConnection);
+    };
+    // the job gets cancelled when stopped, superseded by a newer filter or, for a speculation, by a newer hint
+    const auto& stopRequested = cancelled;
+    auto stopped = [this, &publish]() { publish([this]() { emit parsingFailed(tr("Parsing stopped.")); }); };
+
+    ScopedPhase filterPhase(isSpeculative ? "precompute filter" : "filter results");
+    auto emitResults = [this](const FilterResultsCache::Entry& results) {
+        emit topCostsAvailable(Data::TopCosts::fromBottomUp(
+            results.bottomUp, results.costAggregation != Settings::CostAggregation::BySymbol));
+        emit bottomUpDataAvailable(results.bottomUp);
+        emit topDownDataAvailable(results.topDown);
+        emit perLibraryDataAvailable(results.perLibrary);
+        emit callerCalleeDataAvailable(results.callerCallee);
+        emit frequencyDataAvailable(results.frequency);
+        emit tracepointDataAvailable(results.tracepoints);
+        emit eventsAvailable(results.events);
+        emit memoryUsageAvailable(Data::MemoryUsage::fromResults(
+            results.bottomUp, results.callerCallee, results.events, results.frequency, results.tracepoints));
+        emit parsingFinished();
+    };
 
-                queue.stream() << make_job([filterStack, threadCount, jobsPerThread, this] {
-                    filterStack((threadCount - 1) * jobsPerThread, m_events.stacks.size());
-                });
-            }
+    // the unfiltered results never get corrected, as the lost events are only known once all samples got parsed
+    const bool correctLostEvents = correctLostEventsSetting && !m_events.lostEvents.isEmpty();
+    const bool useUnfilteredResults = !filter.isValid() && !costAggregationChanged && !correctLostEvents
+        && foldInlines == m_bottomUpResults.foldInlines;
+    if (isSpeculative) {
+        // the unfiltered results don't need to be computed, and there is nothing to do when the results are
+        // cached or getting computed already
+        if (useUnfilteredResults
+            || !m_filterResultsCache->beginPending(filter, costAggregation, correctLostEvents, foldInlines)) {
+            return;
+        }
+    } else if (!useUnfilteredResults) {
+        // waits for a speculation of this filter that is still running
+        if (const auto cached = m_filterResultsCache->find(filter, costAggregation, correctLostEvents, foldInlines)) {
+            publish([emitResults, results = *cached]() { emitResults(results); });
+            return;
+        }
+    }
+    const auto endPending = qScopeGuard([&]() {
+        if (isSpeculative) {
+            m_filterResultsCache->endPending(filter, costAggregation, correctLostEvents, foldInlines);
+        }
+    });
 
-            if (filterByTime) {
-                auto it = std::remove_if(
-                    tracepointResults.tracepoints.begin(), tracepointResults.tracepoints.end(),
-                    [filter](const Data::Tracepoint& tracepoint) { return !filter.time.contains(tracepoint.time); });
-                tracepointResults.tracepoints.erase(it, tracepointResults.tracepoints.end());
+    Queue queue;
+    // leave some cores to the results that are actually wanted
+    queue.setMaximumNumberOfThreads(isSpeculative ? std::max(1, QThread::idealThreadCount() / 2)
+                                                  : QThread::idealThreadCount());
+
+    Data::BottomUpResults bottomUp;
+    Data::EventResults events = m_events;
+    Data::CallerCalleeResults callerCallee;
+    Data::TracepointResults tracepointResults = m_tracepointResults;
+    auto frequencyResults = m_frequencyResults;
+    if (!useUnfilteredResults) {
+        // when the filter only narrows down a previous one, start from the results of that one
+        if (const auto base = m_filterResultsCache->findBase(filter)) {
+            events = base->events;
+            tracepointResults = base->tracepoints;
+            frequencyResults = base->frequency;
+        }
+    }
+    const bool filterByTime = filter.time.isValid();
+    const bool filterByCpu = filter.cpuId != std::numeric_limits<quint32>::max();
+    const bool excludeByCpu = !filter.excludeCpuIds.isEmpty();
+    const bool includeBySymbol = !filter.includeSymbols.isEmpty();
+    const bool excludeBySymbol = !filter.excludeSymbols.isEmpty();
+    const bool includeByBinary = !filter.includeBinaries.isEmpty();
+    const bool excludeByBinary = !filter.excludeBinaries.isEmpty();
+    const bool filterByStack = includeBySymbol || excludeBySymbol || includeByBinary || excludeByBinary;
+
+    if (useUnfilteredResults) {
+        bottomUp = m_bottomUpResults;
+        callerCallee = m_callerCalleeResults;
+        publish([this, topCosts = Data::TopCosts::fromBottomUp(
+                           bottomUp, costAggregation != Settings::CostAggregation::BySymbol)]() {
+            emit topCostsAvailable(topCosts);
+        });
+    } else {
+        bottomUp.symbols = m_bottomUpResults.symbols;
+        bottomUp.locations = m_bottomUpResults.locations;
+        bottomUp.foldInlines = foldInlines;
+        bottomUp.costs.initializeCostsFrom(m_bottomUpResults.costs);
+        bottomUp.costs.clearTotalCost();
+
+        // rebuild per-CPU data, i.e. wipe all the events and then re-add them
+        for (auto& cpu : events.cpus) {
+            cpu.events.clear();
+        }
 
-                for (auto& core : frequencyResults.cores) {
-                    for (auto& costType : core.costs) {
+        // we filter all available stacks and then remember the stack ids that should be
+        // included, which is hopefully less work than filtering the stack for every event
+        QVector<bool> filterStacks;
+        if (filterByStack) {
+            filterStacks = stackIndex.filterStacks(filter);
+        }
 
-                        auto frequencyIt = std::remove_if(
-                            costType.values.begin(), costType.values.end(),
-                            [filter](Data::FrequencyData point) { return !filter.time.contains(point.time); });
-                        costType.values.erase(frequencyIt, costType.values.end());
-                    }
+        if (filterByTime) {
+            // the payload tables stay untouched, so the rows of the remaining tracepoints stay valid
+            auto it = std::remove_if(
+                tracepointResults.tracepoints.begin(), tracepointResults.tracepoints.end(),
+                [filter](const Data::Tracepoint& tracepoint) { return !filter.time.contains(tracepoint.time); });
+            tracepointResults.tracepoints.erase(it, tracepointResults.tracepoints.end());
+
+            for (auto& core : frequencyResults.cores) {
+                for (auto& costType : core.costs) {
+
+                    auto frequencyIt = std::remove_if(
+                        costType.values.begin(), costType.values.end(),
+                        [filter](Data::FrequencyData point) { return !filter.time.contains(point.time); });
+                    costType.values.erase(frequencyIt, costType.values.end());
+                    costType.pyramid.build(costType.values);
                 }
             }
+        }
 
-            queue.finish();
-
-            // remove events that lie outside the selected time span
-            // TODO: parallelize
-            for (auto& thread : events.threads) {
-                if (m_stopRequested) {
-                    emit parsingFailed(tr("Parsing stopped."));
+        // remove events that lie outside the selected time span, each thread is filtered in its own job
+        ScopedPhase eventsPhase("filter events");
+        auto* threads = events.threads.data();
+        for (qsizetype threadIndex = 0, c = events.threads.size(); threadIndex < c; ++threadIndex) {
+            queue.stream() << make_job([&filter, filterByTime, filterByCpu, excludeByCpu, filterByStack,
+                                        &filterStacks, thread = threads + threadIndex, spillDirectory,
+                                        &stopRequested]() {
+                if (stopRequested) {
                     return;
                 }
-
-                if ((filter.processId != Data::INVALID_PID && thread.pid != filter.processId)
-                    || (filter.threadId != Data::INVALID_TID && thread.tid != filter.threadId)
-                    || (filterByTime && (thread.time.start > filter.time.end || thread.time.end < filter.time.start))
-                    || filter.excludeProcessIds.contains(thread.pid) || filter.excludeThreadIds.contains(thread.tid)) {
-                    thread.events.clear();
-                    continue;
+                const Data::ScopedSpillDirectory spill(spillDirectory);
+
+                if ((filter.processId != Data::INVALID_PID && thread->pid != filter.processId)
+                    || (filter.threadId != Data::INVALID_TID && thread->tid != filter.threadId)
+                    || (filterByTime
+                        && (thread->time.start > filter.time.end || thread->time.end < filter.time.start))
+                    || filter.excludeProcessIds.contains(thread->pid)
+                    || filter.excludeThreadIds.contains(thread->tid)) {
+                    thread->events.clear();
+                    return;
                 }
 
-                if (filterByTime || filterByCpu || excludeByCpu || filterByStack) {
-                    auto it = std::remove_if(thread.events.begin(), thread.events.end(),
-                                             [filter, filterByTime, filterByCpu, excludeByCpu, filterByStack,
-                                              filterStacks](const Data::Event& event) {
-                                                 return (filterByTime && !filter.time.contains(event.time))
-                                                     || (filterByCpu && event.cpuId != filter.cpuId)
-                                                     || (excludeByCpu && filter.excludeCpuIds.contains(event.cpuId))
-                                                     || (filterByStack && event.stackId != -1
-                                                         && !filterStacks[event.stackId]);
-                                             });
-                    thread.events.erase(it, thread.events.end());
+                if (filterByTime) {
+                    thread->events.retainTimeRange(filter.time);
                 }
-
-                if (m_stopRequested) {
-                    emit parsingFailed(tr("Parsing stopped."));
+                if (stopRequested) {
                     return;
                 }
 
-                // add event data to cpus, bottom up and caller callee sets
-                for (const auto& event : std::as_const(thread.events)) {
-                    // only add non-time events to the cpu line, context switches shouldn't show up there
-                    if (event.type == events.lostEventCostId) {
-                        // the lost event never has a valid cpu set, add to all CPUs
-                        for (auto& cpu : events.cpus)
-                            cpu.events.push_back(event);
-                    } else if (event.type != events.offCpuTimeCostId) {
-                        events.cpus[event.cpuId].events.push_back(event);
-                    }
+                if (filterByCpu || excludeByCpu || filterByStack) {
+                    thread->events.removeIf([&filter, filterByCpu, excludeByCpu, filterByStack,
+                                             &filterStacks](const Data::Event& event) {
+                        return (filterByCpu && event.cpuId != filter.cpuId)
+                            || (excludeByCpu && filter.excludeCpuIds.contains(event.cpuId))
+                            || (filterByStack && event.stackId != -1 && !filterStacks[event.stackId]);
+                    });
+                }
 
-                    QSet<Data::Symbol> recursionGuard;
-                    auto frameCallback = [&callerCallee, &recursionGuard, &event,
-                                          numCosts](const Data::Symbol& symbol, const Data::Location& location) {
-                        addCallerCalleeEvent(symbol, location, event.type, event.cost, &recursionGuard, &callerCallee,
-                                             numCosts);
-                    };
+                thread->updateMaxCost();
+            });
+        }
+        queue.finish();
+        eventsPhase.finish();
 
-                    if (event.stackId != -1) {
-                        addBottomUpResult(&bottomUp, costAggregation, m_threadNames, event.type, event.cost, thread.pid,
-                                          thread.tid, event.cpuId, events.stacks.at(event.stackId), frameCallback);
-                    }
-                }
-            }
+        if (stopRequested) {
+            stopped();
+            return;
+        }
 
-            // remove threads that have no events within the selected time span
-            auto it = std::remove_if(events.threads.begin(), events.threads.end(),
-                                     [](const Data::ThreadEvents& thread) { return thread.events.isEmpty(); });
-            events.threads.erase(it, events.threads.end());
+        // remove threads that have no events within the selected time span
+        auto it = std::remove_if(events.threads.begin(), events.threads.end(),
+                                 [](const Data::ThreadEvents& thread) { return thread.events.isEmpty(); });
+        events.threads.erase(it, events.threads.end());
+        events.updateMaxCost();
+        events.updateNumaMigrations();
 
-            Data::BottomUp::initializeParents(&bottomUp.root);
+        if (stopRequested) {
+            stopped();
+            return;
+        }
 
-            if (m_stopRequested) {
-                emit parsingFailed(tr("Parsing stopped."));
+        // add event data to cpus, now that the thread indices are final
+        for (qint32 threadIndex = 0, c = events.threads.size(); threadIndex < c; ++threadIndex) {
+            if (stopRequested) {
+                stopped();
                 return;
             }
-
-            // TODO: parallelize
-            Data::callerCalleesFromBottomUpData(bottomUp, &callerCallee);
+            const auto& threadEvents = events.threads.at(threadIndex).events;
+            const auto& types = threadEvents.types();
+            const auto& cpuIds = threadEvents.cpuIds();
+            for (qint32 i = 0, numEvents = threadEvents.size(); i < numEvents; ++i) {
+                const auto type = types.at(i);
+                // only add non-time events to the cpu line, context switches and syscalls shouldn't show up there
+                // and the lost events never have a valid cpu set, see EventResults::lostEvents
+                if (type != events.offCpuTimeCostId && type != events.syscallTimeCostId
+                    && type != events.lostEventCostId) {
+                    events.cpus[cpuIds.at(i)].events.push_back({threadIndex, i});
+                }
+            }
         }
 
-        if (m_stopRequested) {
-            emit parsingFailed(tr("Parsing stopped."));
-            return;
+        // build the bottom up and caller callee sets
+        ScopedPhase aggregationPhase("aggregate costs");
+        if (!filter.isValid() && !correctLostEvents) {
+            // only the cost aggregation changed, the cube answers that without visiting every event
+            // it gets built by the first job that needs it, a superseded one may still run at the same time
+            Data::CostCube costCube;
+            {
+                QMutexLocker locker(&m_costCubeMutex);
+                costCube = m_costCube;
+            }
+            if (costCube.isEmpty()) {
+                costCube = buildCostCube(&queue, m_events, stopRequested);
+                QMutexLocker locker(&m_costCubeMutex);
+                // an incomplete cube must not be kept, a new parse may also have cleared the cube already
+                if (!stopRequested) {
+                    m_costCube = costCube;
+                }
+            }
+            // the cube got built from the unfiltered events, whose threads are all still there
+            aggregateEvents(&queue, m_events, costAggregation, false, m_threadNames, stopRequested, &bottomUp,
+                            &callerCallee, &costCube);
+        } else {
+            aggregateEvents(&queue, events, costAggregation, correctLostEvents, m_threadNames, stopRequested,
+                            &bottomUp, &callerCallee);
         }
 
-        const auto topDown =
-            Data::TopDownResults::fromBottomUp(bottomUp, costAggregation != Settings::CostAggregation::BySymbol);
-        const auto perLibrary = Data::PerLibraryResults::fromTopDown(topDown);
+        Data::BottomUp::initializeParents(&bottomUp.root);
+        aggregationPhase.finish();
 
-        if (m_stopRequested) {
-            emit parsingFailed(tr("Parsing stopped."));
+        if (stopRequested) {
+            stopped();
             return;
         }
 
-        m_costAggregationChanged = false;
+        // cheap to get, so the summary doesn't have to wait for the other results
+        publish([this, topCosts = Data::TopCosts::fromBottomUp(
+                           bottomUp, costAggregation != Settings::CostAggregation::BySymbol)]() {
+            emit topCostsAvailable(topCosts);
+        });
+
+        ScopedPhase callerCalleePhase("caller callee");
+        callerCalleesFromBottomUpData(&queue, bottomUp, &callerCallee, &stopRequested);
+    }
+
+    if (stopRequested) {
+        stopped();
+        return;
+    }
 
+    // publish what is ready already, the top down and per library results get derived afterwards
+    publish([this, bottomUp, callerCallee, frequencyResults, tracepointResults, events]() {
         emit bottomUpDataAvailable(bottomUp);
-        emit topDownDataAvailable(topDown);
-        emit perLibraryDataAvailable(perLibrary);
         emit callerCalleeDataAvailable(callerCallee);
         emit frequencyDataAvailable(frequencyResults);
         emit tracepointDataAvailable(tracepointResults);
         emit eventsAvailable(events);
+    });
+
+    ScopedPhase topDownPhase("top down");
+    const auto topDown = topDownFromBottomUpData(
+        &queue, bottomUp, costAggregation != Settings::CostAggregation::BySymbol, &stopRequested);
+    topDownPhase.finish();
+    if (stopRequested) {
+        stopped();
+        return;
+    }
+    publish([this, topDown]() { emit topDownDataAvailable(topDown); });
+    ScopedPhase perLibraryPhase("per library");
+    const auto perLibrary = perLibraryFromTopDownData(&queue, topDown, &stopRequested);
+    perLibraryPhase.finish();
+
+    if (isSpeculative) {
+        if (!stopRequested) {
+            m_filterResultsCache->insert({filter, costAggregation, correctLostEvents, foldInlines, bottomUp, topDown,
+                                          perLibrary, callerCallee, events, tracepointResults, frequencyResults});
+        }
+        return;
+    }
+    if (stopRequested) {
+        stopped();
+        return;
+    }
+
+    if (!useUnfilteredResults) {
+        m_filterResultsCache->insert({filter, costAggregation, correctLostEvents, foldInlines, bottomUp, topDown,
+                                      perLibrary, callerCallee, events, tracepointResults, frequencyResults});
+    }
+    publish([this, perLibrary,
+             memoryUsage = Data::MemoryUsage::fromResults(bottomUp, callerCallee, events, frequencyResults,
+                                                          tracepointResults)]() {
+        emit perLibraryDataAvailable(perLibrary);
+        m_costAggregationChanged = false;
+        emit memoryUsageAvailable(memoryUsage);
         emit parsingFinished();
     });
 }
 
 void PerfParser::stop()
 {
+    cancelSpeculation();
+    cancelFilter();
     m_stopRequested = true;
     emit stopRequested();
 }
@@ -1926,25 +5886,196 @@ void PerfParser::exportResults(const QString& path, const QUrl& url)
 {
     if (!initParserArgs(path))
         return;
-    exportResults(url);
+    exportParserOutput(url);
+}
+
+namespace {
+// the samples of the pprof profiles get labeled like the costs are aggregated in the GUI
+PprofExport::Labels pprofLabels(Settings::CostAggregation aggregation)
+{
+    switch (aggregation) {
+    case Settings::CostAggregation::BySymbol:
+        break;
+    case Settings::CostAggregation::ByThread:
+        return PprofExport::Labels::Thread;
+    case Settings::CostAggregation::ByProcess:
+        return PprofExport::Labels::Process;
+    case Settings::CostAggregation::ByCPU:
+        return PprofExport::Labels::Cpu;
+    case Settings::CostAggregation::ByNumaNode:
+        return PprofExport::Labels::NumaNode;
+    }
+    return PprofExport::Labels::None;
+}
 }
 
 void PerfParser::exportResults(const QUrl& url)
+{
+    // the loaded results are written as they are, which is much faster than unwinding everything again
+    // this also keeps the current filter, but the results can only contain what got loaded in the first place
+    const auto isPerfettoTrace = PerfettoExport::isTraceFile(url.fileName());
+    const auto isPprofProfile = PprofExport::isProfileFile(url.fileName());
+    if (m_isParsing || m_filteredEvents.threads.isEmpty()) {
+        if (isPerfettoTrace || isPprofProfile) {
+            emit exportFailed(
+                tr("File export failed: Perfetto traces and pprof profiles are written from the loaded results."));
+            return;
+        }
+        exportParserOutput(url);
+        return;
+    }
+
+    if (isPerfettoTrace) {
+        exportOutput(url, [bottomUp = m_bottomUpResults, events = m_filteredEvents](const QString& outputPath) {
+            QFile output(outputPath);
+            if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)
+                || !PerfettoExport::write(&output, bottomUp, events)) {
+                return output.errorString();
+            }
+            return QString();
+        });
+        return;
+    }
+
+    if (isPprofProfile) {
+        const auto labels = pprofLabels(Settings::instance()->costAggregation());
+        exportOutput(url, [bottomUp = m_bottomUpResults, events = m_filteredEvents,
+                           labels](const QString& outputPath) {
+            QFile file(outputPath);
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                return file.errorString();
+            }
+#if KFArchive_FOUND
+            // pprof profiles are usually compressed with gzip, but the tools read them either way
+            KCompressionDevice output(&file, false, KCompressionDevice::GZip);
+            if (!output.open(QIODevice::WriteOnly)) {
+                return output.errorString();
+            }
+#else
+            auto& output = file;
+#endif
+            if (!PprofExport::write(&output, bottomUp, events, labels)) {
+                return output.errorString();
+            }
+            output.close();
+            return file.error() == QFile::NoError ? QString() : file.errorString();
+        });
+        return;
+    }
+
+    exportOutput(url, [bottomUp = m_bottomUpResults, events = m_filteredEvents,
+                       time = m_filterTime](const QString& outputPath) {
+        // not a QSaveFile, the compression reads the uncompressed output through a file that is open already
+        QFile output(outputPath);
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return output.errorString();
+        }
+        writePerfStream(&output, bottomUp, events, time);
+        output.close();
+        return output.error() == QFile::NoError ? QString() : output.errorString();
+    });
+}
+
+void PerfParser::cacheParserOutput(const QString& path)
+{
+    if (!initParserArgs(path)) {
+        return;
+    }
+
+    const auto inputIndex = m_parserArgs.indexOf(QStringLiteral("--input"));
+    const auto input = inputIndex != -1 ? m_parserArgs.value(inputIndex + 1, path) : path;
+    auto debuginfodUrls = Settings::instance()->debuginfodUrls();
+    const auto parserCacheSize = static_cast<qint64>(Settings::instance()->parserCacheSize()) * 1024 * 1024;
+    JobScheduler::run(JobScheduler::Priority::Background, [path, input, parserBinary = m_parserBinary,
+                                                           parserArgs = m_parserArgs, debuginfodUrls, parserCacheSize,
+                                                           this]() {
+        // the perfparser output, the stacks of other profilers and the counts of perf stat get read as they are
+        if (peekFileHeader(input).startsWith("QPERFSTREAM") || isCollapsedStacks(input) || isPerfStatOutput(input)) {
+            emit parserOutputCached(path);
+            return;
+        }
+
+        if (parserCacheSize == 0) {
+            emit parsingFailed(tr("Failed to cache %1: %2").arg(path, tr("The parser cache is disabled.")));
+            return;
+        }
+
+        const auto cacheFile = perfparserCacheFile(path, parserBinary, parserArgs, debuginfodUrls);
+        if (cacheFile.isEmpty() || !QDir().mkpath(QFileInfo(cacheFile).path())) {
+            emit parsingFailed(tr("Failed to cache %1: %2").arg(path, tr("No writable cache location.")));
+            return;
+        }
+        if (QFile::exists(cacheFile) && perfparserCacheUpToDate(cacheFile)) {
+            emit parserOutputCached(path);
+            return;
+        }
+
+        // opening the file looks for the complete cache only, so it gets renamed once perfparser succeeded
+        const auto partialFile = cacheFile + QLatin1String(".part");
+        LowPriorityProcess process;
+        process.setProcessEnvironment(perfparserEnvironment(debuginfodUrls));
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        process.setStandardOutputFile(partialFile);
+
+        QEventLoop loop;
+        connect(&process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), &loop,
+                &QEventLoop::quit);
+        connect(this, &PerfParser::stopRequested, &process, &QProcess::kill);
+
+        process.start(parserBinary, parserArgs);
+        if (!process.waitForStarted()) {
+            QFile::remove(partialFile);
+            emit parsingFailed(tr("Failed to start the hotspot-perfparser process"));
+            return;
+        }
+        loop.exec();
+
+        const auto error = process.exitStatus() == QProcess::NormalExit ? perfparserExitError(process.exitCode())
+                                                                         : process.errorString();
+        if (m_stopRequested || !error.isEmpty() || !QFile::rename(partialFile, cacheFile)) {
+            QFile::remove(partialFile);
+            emit parsingFailed(m_stopRequested ? tr("Parsing stopped.")
+                                               : tr("Failed to cache %1: %2").arg(path, error));
+            return;
+        }
+        // the binaries get known once the cache gets opened
+        QFile::remove(perfparserCacheBinariesFile(cacheFile));
+        prunePerfparserCache(QFileInfo(cacheFile).path(), parserCacheSize);
+        emit parserOutputCached(path);
+    });
+}
+
+void PerfParser::exportParserOutput(const QUrl& url)
 {
     Q_ASSERT(!m_parserBinary.isEmpty());
     Q_ASSERT(!m_parserArgs.isEmpty());
 
-    using namespace ThreadWeaver;
-
     auto debuginfodUrls = Settings::instance()->debuginfodUrls();
-    stream() << make_job([this, url, parserBinary = m_parserBinary, parserArgs = m_parserArgs, debuginfodUrls]() {
+    exportOutput(url, [parserBinary = m_parserBinary, parserArgs = m_parserArgs,
+                       debuginfodUrls](const QString& outputPath) {
         QProcess perfParser;
+        perfParser.setStandardOutputFile(outputPath);
+        perfParser.setProcessEnvironment(perfparserEnvironment(debuginfodUrls));
+        perfParser.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+
+        perfParser.start(parserBinary, parserArgs);
+        if (!perfParser.waitForFinished(-1)) {
+            return perfParser.errorString();
+        }
+        return QString();
+    });
+}
+
+void PerfParser::exportOutput(const QUrl& url, const std::function<QString(const QString& outputPath)>& write)
+{
+    JobScheduler::run(JobScheduler::Priority::Background, [this, url, write]() {
         QSharedPointer<QTemporaryFile> tmpFile;
 
         const auto writeDirectly = url.isLocalFile();
+        QString outputPath;
 
         if (writeDirectly) {
-            perfParser.setStandardOutputFile(url.toLocalFile());
+            outputPath = url.toLocalFile();
         } else {
             tmpFile = QSharedPointer<QTemporaryFile>::create();
             if (!tmpFile->open()) {
@@ -1953,18 +6084,40 @@ void PerfParser::exportResults(const QUrl& url)
                 return;
             }
             tmpFile->close();
-            perfParser.setStandardOutputFile(tmpFile->fileName());
+            outputPath = tmpFile->fileName();
         }
 
-        perfParser.setProcessEnvironment(perfparserEnvironment(debuginfodUrls));
-        perfParser.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+#if KFArchive_FOUND
+        // the compressed file gets written from the complete output, the frames are compressed in parallel
+        QTemporaryFile uncompressedFile;
+        if (isSeekableZstdExport(url)) {
+            if (!uncompressedFile.open()) {
+                emit exportFailed(tr("File export failed: Failed to create temporary file %1.")
+                                      .arg(uncompressedFile.errorString()));
+                return;
+            }
+        }
+        const auto writePath = uncompressedFile.isOpen() ? uncompressedFile.fileName() : outputPath;
+#else
+        const auto writePath = outputPath;
+#endif
 
-        perfParser.start(parserBinary, parserArgs);
-        if (!perfParser.waitForFinished(-1)) {
-            emit exportFailed(tr("File export failed: %1").arg(perfParser.errorString()));
+        const auto writeError = write(writePath);
+        if (!writeError.isEmpty()) {
+            emit exportFailed(tr("File export failed: %1").arg(writeError));
             return;
         }
 
+#if KFArchive_FOUND
+        if (uncompressedFile.isOpen()) {
+            const auto error = writeSeekableZstd(&uncompressedFile, outputPath);
+            if (!error.isEmpty()) {
+                emit exportFailed(tr("File export failed: %1").arg(error));
+                return;
+            }
+        }
+#endif
+
         if (writeDirectly) {
             emit exportFinished(url);
             return;
@@ -1986,6 +6139,43 @@ void PerfParser::exportResults(const QUrl& url)
     });
 }
 
+QString PerfParser::mergeDirectory(const QString& path)
+{
+    // the data.<n> files next to the header only contain the samples of one thread, so perfparser cannot read
+    // them on their own. perf inject merges them into one file ordered by time
+    if (!QFileInfo::exists(path + QLatin1String("/data"))) {
+        emit parsingFailed(tr("'%1' is not a file.").arg(path));
+        return {};
+    }
+
+    auto perf = Settings::instance()->perfPath();
+    if (perf.isEmpty()) {
+        perf = QStandardPaths::findExecutable(QStringLiteral("perf"));
+    }
+    if (perf.isEmpty()) {
+        emit parsingFailed(tr("Failed to find perf, which is needed to open the perf data directory %1.").arg(path));
+        return {};
+    }
+
+    m_mergedDirectory = std::make_unique<QTemporaryFile>(this);
+    if (!m_mergedDirectory->open()) {
+        emit parsingFailed(tr("Failed to create a temporary file: %1").arg(m_mergedDirectory->errorString()));
+        return {};
+    }
+
+    QProcess process;
+    process.start(perf, {QStringLiteral("inject"), QStringLiteral("-i"), path, QStringLiteral("-o"),
+                         m_mergedDirectory->fileName()});
+    if (!process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+        const auto error = process.error() == QProcess::FailedToStart
+            ? process.errorString()
+            : QString::fromLocal8Bit(process.readAllStandardError()).trimmed();
+        emit parsingFailed(tr("Failed to merge the perf data directory %1: %2").arg(path, error));
+        return {};
+    }
+    return m_mergedDirectory->fileName();
+}
+
 QString PerfParser::decompressIfNeeded(const QString& path)
 {
 #if KFArchive_FOUND
@@ -1997,6 +6187,20 @@ QString PerfParser::decompressIfNeeded(const QString& path)
         return path;
     }
 
+    if (compressedFile.compressionType() == KCompressionDevice::Zstd) {
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly)) {
+            const auto seekTable = readSeekTable(&file);
+            if (!seekTable.isEmpty()) {
+                if (m_decompressed->open() && decompressSeekableZstd(&file, seekTable, m_decompressed.get())) {
+                    return m_decompressed->fileName();
+                }
+                // fall back to decompressing the frames one after the other
+                m_decompressed = std::make_unique<QTemporaryFile>(this);
+            }
+        }
+    }
+
     if (compressedFile.open(QIODevice::ReadOnly)) {
         m_decompressed->open();
 
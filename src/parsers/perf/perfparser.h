@@ -8,13 +8,23 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <memory>
+#include <QByteArray>
+#include <QMutex>
 #include <QObject>
 
 #include <models/data.h>
+#include <settings.h>
 
+class QIODevice;
 class QUrl;
 class QTemporaryFile;
+class FilterResultsCache;
+
+namespace ThreadWeaver {
+class Queue;
+}
 
 // TODO: create a parser interface
 class PerfParser : public QObject
@@ -26,15 +36,61 @@ public:
 
     void startParseFile(const QString& path);
 
+    // when enabled, startParseFile periodically publishes snapshots of the results parsed so far
+    // each snapshot is followed by partialResultsAvailable, the full results follow once everything got parsed
+    void setPublishPartialResults(bool publish);
+
+    // parses the perf data passed to addLiveInput while it is still getting recorded to @p outputPath
+    // snapshots of the aggregated results get published periodically, followed by partialResultsAvailable
+    // the full results follow once finishLiveInput got called and everything got parsed
+    void startParseLive(const QString& outputPath);
+    void addLiveInput(const QByteArray& data);
+    void finishLiveInput();
+
+    // parses @p paths with one parser each and publishes the merged costs of all of them, e.g. to get a single
+    // profile of the captures of many hosts. only the aggregated costs get kept, so the results have no events
+    // and can't be filtered
+    void startMergeFiles(const QStringList& paths);
+
+    // parses @p baselinePath and aligns it with the unfiltered results of this capture by their symbol paths
+    // the comparison gets computed in the background and published through comparisonDataAvailable, until the
+    // next filter or capture supersedes it
+    void startCompare(const QString& baselinePath);
+
     void filterResults(const Data::FilterAction& filter);
+    // computes the results of a filter that is likely to get applied next in the background and caches them,
+    // such that filterResults returns them right away; this cancels the previous speculation
+    void precomputeFilter(const Data::FilterAction& filter);
 
     void stop();
+    // true while a capture gets parsed or filtered in the background
+    bool isParsing() const
+    {
+        return m_isParsing;
+    }
 
+    // writes the loaded results including the current filter, or runs perfparser again while nothing got loaded
     void exportResults(const QUrl& url);
 
     // used when directly exporting without parsing for visualization purposes
     void exportResults(const QString& path, const QUrl& url);
 
+    // runs perfparser on @p path at a low CPU priority and stores its output in the cache that opening the file
+    // reuses later on, without loading any results, see CaptureWatcher. failures get reported by parsingFailed
+    void cacheParserOutput(const QString& path);
+
+    // the results of an analysis server, see AnalysisServer, get opened with startParseFile and an url like
+    // hotspot://bigbox:7777, only the aggregated results get transferred and the GUI works with them as usual
+    static bool isServerUrl(const QString& path);
+    // the line a client sends to request the results summed up per @p timeBuckets slices of the time range
+    static QByteArray serverRequest(quint32 timeBuckets);
+    // the time buckets of @p request, or 0 when it is invalid
+    static quint32 parseServerRequest(const QByteArray& request);
+    // writes the answer to a request, a perfparser stream in which the samples of a thread with the same stack
+    // got summed up per slice of the time range
+    static void writeServedResults(QIODevice* output, const Data::BottomUpResults& bottomUp,
+                                   const Data::EventResults& events, quint32 timeBuckets);
+
     Data::BottomUpResults bottomUpResults() const
     {
         return m_bottomUpResults;
@@ -47,6 +103,15 @@ public:
     {
         return m_events;
     }
+    Data::TracepointResults tracepointResults() const
+    {
+        return m_tracepointResults;
+    }
+    // empty while only partial results are available
+    Data::StackIndex stackIndex() const
+    {
+        return m_stackIndex;
+    }
 
 signals:
     void parsingStarted();
@@ -54,27 +119,69 @@ signals:
     void bottomUpDataAvailable(const Data::BottomUpResults& data);
     void topDownDataAvailable(const Data::TopDownResults& data);
     void perLibraryDataAvailable(const Data::PerLibraryResults& data);
+    // the top costs of the filtered results, the unfiltered ones come with the summary
+    void topCostsAvailable(const Data::TopCosts& data);
     void callerCalleeDataAvailable(const Data::CallerCalleeResults& data);
+    void comparisonDataAvailable(const Data::ComparisonResults& data);
     void tracepointDataAvailable(const Data::TracepointResults& data);
     void frequencyDataAvailable(const Data::FrequencyResults& data);
     void eventsAvailable(const Data::EventResults& events);
+    // the index of the stacks of the unfiltered events, it stays valid for the filtered ones
+    void stackIndexAvailable(const Data::StackIndex& index);
     void threadNamesAvailable(const Data::ThreadNames& threadNames);
+    // emitted once all results are available, for the unfiltered and the filtered ones
+    void memoryUsageAvailable(const Data::MemoryUsage& usage);
     void parsingFinished();
     void parsingFailed(const QString& errorMessage);
     void exportFailed(const QString& errorMessage);
     void progress(float progress);
+    // the throughput, memory and phase of the running parse, emitted along with progress and when the phase changes
+    void parseProgress(const Data::ParseProgress& progress);
     void debugInfoDownloadProgress(const QString& module, const QString& url, qint64 numerator, qint64 denominator);
     void stopRequested();
     void perfMapFileExists(bool exists);
 
     void parserWarning(const QString& errorMessage);
     void exportFinished(const QUrl& url);
+    // the output of perfparser for @p path is in the cache, also emitted when there was nothing to do
+    void parserOutputCached(const QString& path);
+
+    // the results emitted before were only a snapshot of the results parsed so far, parsing continues
+    void partialResultsAvailable();
+    void liveInputChanged();
 
 private:
     bool initParserArgs(const QString& path);
+    // requests the results of the analysis server at @p url and parses them like a file
+    void startParseServer(const QUrl& url);
 
     friend class TestPerfParser;
     QString decompressIfNeeded(const QString& path);
+    // merges a directory written by perf record --threads into a temporary file, empty on failure
+    QString mergeDirectory(const QString& path);
+    // runs hotspot-perfparser once more to export its output
+    void exportParserOutput(const QUrl& url);
+    // runs @p write in the background, compresses its output when needed and moves it to @p url
+    void exportOutput(const QUrl& url, const std::function<QString(const QString& outputPath)>& write);
+    // computes and emits the results of @p filter until @p cancelled gets set
+    // @p generation is the one of the filterResults call, a speculation with generation 0 only caches its results
+    // @p stackIndex is the one built after parsing, the caller copies it on the GUI thread
+    void runFilter(const Data::FilterAction& filter, Settings::CostAggregation costAggregation,
+                   bool costAggregationChanged, bool correctLostEventsSetting, bool foldInlines,
+                   const Data::StackIndex& stackIndex, Data::SpillDirectory* spillDirectory,
+                   const std::atomic<bool>& cancelled, uint generation);
+    void clearCostCube();
+    // takes a new lease on the interned symbols, see Data::SymbolTableLease
+    void renewSymbolTableLease();
+    struct MergeState;
+    // starts parsing the next files of startMergeFiles, once all got parsed the merged results get published
+    void continueMerge(const std::shared_ptr<MergeState>& state);
+    void finishMerge(const std::shared_ptr<MergeState>& state);
+    void cancelSpeculation();
+    // tells a running filter job to stop, it keeps running in the background until it notices
+    void cancelFilter();
+    // cancels the speculation and waits for it, e.g. before the data it uses gets reset
+    void finishSpeculation();
 
     // only set once after the initial startParseFile finished
     QString m_parserBinary;
@@ -83,10 +190,46 @@ private:
     Data::CallerCalleeResults m_callerCalleeResults;
     Data::TracepointResults m_tracepointResults;
     Data::EventResults m_events;
+    // the events of the current filter and its time range, for the export
+    Data::EventResults m_filteredEvents;
+    Data::TimeRange m_filterTime;
     Data::FrequencyResults m_frequencyResults;
     std::atomic<bool> m_isParsing;
     std::atomic<bool> m_stopRequested;
-    std::atomic<bool> m_costAggregationChanged;
+    // only used on the GUI thread, the filter jobs get passed its value
+    bool m_costAggregationChanged = false;
+    // set while parsing, the parsed costs are not corrected for lost events yet, see Settings::correctLostEvents
+    bool m_lostEventsUncorrected = false;
+    // set while parsing publishes snapshots of the results parsed so far, which can't be filtered
+    std::atomic<bool> m_hasPartialResults;
+    bool m_publishPartialResults = false;
+    // set when the results got merged from several files by startMergeFiles
+    bool m_hasMergedResults = false;
+    // snapshots that got published but were not handled yet, a new one is only built once all got handled
+    std::atomic<int> m_pendingSnapshots;
+    QMutex m_liveInputMutex;
+    QByteArray m_liveInput;
+    bool m_liveInputFinished = false;
     std::unique_ptr<QTemporaryFile> m_decompressed;
+    std::unique_ptr<QTemporaryFile> m_mergedDirectory;
     Data::ThreadNames m_threadNames;
+    // built while finalizing the parse, i.e. before any filter can run, and only accessed on the GUI thread
+    Data::StackIndex m_stackIndex;
+    std::unique_ptr<Data::SymbolTableLease> m_symbolTableLease;
+    // built once the cost aggregation changes, to aggregate the costs without visiting every event again
+    QMutex m_costCubeMutex;
+    Data::CostCube m_costCube;
+    std::unique_ptr<FilterResultsCache> m_filterResultsCache;
+    // set to cancel the most recent filter job, a newer filter supersedes it
+    std::shared_ptr<std::atomic<bool>> m_filterCancelled;
+    // where the events of the current results get spilled once they exceed the memory budget
+    std::shared_ptr<Data::SpillDirectory> m_spillDirectory = std::make_shared<Data::SpillDirectory>();
+    // incremented by every filterResults call, only the job of the most recent one publishes its results
+    std::atomic<uint> m_filterGeneration {0};
+    // incremented by every startCompare call and everything that supersedes a comparison
+    std::atomic<uint> m_comparisonGeneration {0};
+    // runs the speculations one at a time, apart from the jobs the user waits for
+    std::unique_ptr<ThreadWeaver::Queue> m_speculationQueue;
+    std::shared_ptr<std::atomic<bool>> m_speculationCancelled;
+    Data::FilterAction m_speculatedFilter;
 };
@@ -10,6 +10,7 @@
 #include "errnoutil.h"
 
 #include <cstring>
+#include <utility>
 
 #include <QFile>
 #include <QLoggingCategory>
@@ -73,41 +74,53 @@ bool PerfControlFifoWrapper::open()
     return m_ackFifoFd >= 0;
 }
 
-void PerfControlFifoWrapper::requestStart()
+void PerfControlFifoWrapper::requestStart(bool enableEvents)
 {
-    if (m_ctlFifoFd < 0) {
-        emit noFIFO();
-        return;
-    }
+    m_startRequested = true;
+    // perf acknowledges every command, so disable tells us that it is ready without enabling the events
+    sendCommand(enableEvents ? "enable\n" : "disable\n");
+}
 
-    m_ackReady = std::make_unique<QSocketNotifier>(m_ackFifoFd, QSocketNotifier::Read);
-    connect(m_ackReady.get(), &QSocketNotifier::activated, this, [this]() {
-        char buf[10];
-        if (read(m_ackFifoFd, buf, sizeof(buf)) == -1) {
-            qCWarning(perfcontrolfifowrapper)
-                << "failed to read message from fifo:" << m_ctlFifoPath << Util::PrintableErrno {errno};
-        }
-        emit started();
-        m_ackReady->disconnect(this);
-    });
-
-    const char start_cmd[] = "enable\n";
-    if (write(m_ctlFifoFd, start_cmd, sizeof(start_cmd) - 1) == -1) {
-        qCWarning(perfcontrolfifowrapper)
-            << "failed to write start message to fifo:" << m_ctlFifoPath << Util::PrintableErrno {errno};
-    }
+void PerfControlFifoWrapper::requestResume()
+{
+    sendCommand("enable\n");
+}
+
+void PerfControlFifoWrapper::requestPause()
+{
+    sendCommand("disable\n");
 }
 
 void PerfControlFifoWrapper::requestStop()
+{
+    sendCommand("stop\n");
+}
+
+void PerfControlFifoWrapper::sendCommand(const char* command)
 {
     if (m_ctlFifoFd < 0) {
         emit noFIFO();
         return;
     }
-    const char stop_cmd[] = "stop\n";
-    if (write(m_ctlFifoFd, stop_cmd, sizeof(stop_cmd) - 1) == -1) {
+
+    if (!m_ackReady) {
+        m_ackReady = std::make_unique<QSocketNotifier>(m_ackFifoFd, QSocketNotifier::Read);
+        connect(m_ackReady.get(), &QSocketNotifier::activated, this, [this]() {
+            // drain the acks of all commands, including the ones the application sent itself
+            char buf[64];
+            if (read(m_ackFifoFd, buf, sizeof(buf)) == -1) {
+                qCWarning(perfcontrolfifowrapper)
+                    << "failed to read message from fifo:" << m_ackFifoPath << Util::PrintableErrno {errno};
+            }
+            if (std::exchange(m_startRequested, false)) {
+                emit started();
+            }
+        });
+    }
+
+    if (write(m_ctlFifoFd, command, strlen(command)) == -1) {
         qCWarning(perfcontrolfifowrapper)
-            << "failed to write start message to fifo:" << m_ctlFifoPath << Util::PrintableErrno {errno};
+            << "failed to write message to fifo:" << m_ctlFifoPath << Util::PrintableErrno {errno};
     }
 }
 
@@ -116,6 +129,7 @@ void PerfControlFifoWrapper::close()
     if (m_ackReady) {
         m_ackReady = nullptr;
     }
+    m_startRequested = false;
     if (m_ctlFifoFd >= 0) {
         ::close(m_ctlFifoFd);
         m_ctlFifoFd = -1;
@@ -42,7 +42,11 @@ public:
     }
 
     bool open();
-    void requestStart();
+    // emits started once perf handled the command, with @p enableEvents false the events stay disabled
+    void requestStart(bool enableEvents = true);
+    // enable or disable the events of a running perf, see --delay=-1
+    void requestResume();
+    void requestPause();
     void requestStop();
     void close();
 
@@ -51,9 +55,12 @@ signals:
     void noFIFO();
 
 private:
+    void sendCommand(const char* command);
+
     std::unique_ptr<QSocketNotifier> m_ackReady;
     QString m_ctlFifoPath;
     QString m_ackFifoPath;
     int m_ctlFifoFd = -1;
     int m_ackFifoFd = -1;
+    bool m_startRequested = false;
 };
@@ -12,12 +12,15 @@
 
 #include <QDebug>
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
 #include <QProcess>
 #include <QStandardPaths>
 #include <QTemporaryFile>
 #include <QTimer>
 
+#include <KShell>
+
 #include <csignal>
 #include <unistd.h>
 
@@ -29,6 +32,85 @@
 #endif
 
 namespace {
+// the application inherits the stdout of perf, which carries the perf data when streaming
+// so the output of the application gets redirected to stderr, which ends up in the record output
+QStringList redirectedStdout(bool streamOutput)
+{
+    if (!streamOutput) {
+        return {};
+    }
+    return {QStringLiteral("/bin/sh"), QStringLiteral("-c"), QStringLiteral("exec \"$0\" \"$@\" >&2")};
+}
+
+// the user and system time of @p pid in nanoseconds, see proc(5)
+qint64 processCpuTime(qint64 pid)
+{
+    QFile file(QStringLiteral("/proc/%1/stat").arg(pid));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    // skip the name, which may contain spaces, the state is field 3, utime is field 14 and stime field 15
+    const auto stat = file.readAll();
+    const auto fields = stat.mid(stat.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 13) {
+        return -1;
+    }
+    const auto ticks = fields[11].toLongLong() + fields[12].toLongLong();
+    return ticks * 1000000000 / sysconf(_SC_CLK_TCK);
+}
+
+// the busy and total time of all CPUs in ticks, see proc(5)
+PerfRecord::CpuTimes systemCpuTimes()
+{
+    QFile file(QStringLiteral("/proc/stat"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    // "cpu  user nice system idle iowait irq softirq steal ..."
+    const auto fields = file.readLine().simplified().split(' ');
+    PerfRecord::CpuTimes times;
+    for (int i = 1, c = fields.size(); i < c; ++i) {
+        const auto ticks = fields[i].toULongLong();
+        times.total += ticks;
+        // idle and iowait
+        if (i != 4 && i != 5) {
+            times.busy += ticks;
+        }
+    }
+    return times;
+}
+
+// the shell script that runs @p perfCommand on the remote host, optionally piped through hotspot-perfparser
+// closing stdin of ssh interrupts perf, so that it finishes the recording properly. the pid of perf is
+// written to a temporary file, as $! would be the pid of the parser when parsing remotely
+QString remoteRecordScript(const QStringList& perfCommand, bool parseRemotely, const QString& workingDirectory)
+{
+    auto command = QStringLiteral("sh -c 'echo $$ > \"$0\"; exec \"$@\"' \"$pidfile\" ")
+        + KShell::joinArgs(perfCommand) + QStringLiteral(" </dev/null");
+    if (parseRemotely) {
+        command += QStringLiteral(" | hotspot-perfparser --max-frames 1024");
+    }
+
+    const QStringList script = {
+        QStringLiteral("cd ") + KShell::quoteArg(workingDirectory) + QStringLiteral(" || exit 1"),
+        QStringLiteral("pidfile=$(mktemp) || exit 1"),
+        QStringLiteral("exec 3<&0"),
+        QStringLiteral("{ ") + command + QStringLiteral("; } &"),
+        QStringLiteral("job=$!"),
+        QStringLiteral("{ read -r _ <&3; [ -s \"$pidfile\" ] && kill -INT \"$(cat \"$pidfile\")\"; }")
+            + QStringLiteral(" >/dev/null 2>&1 &"),
+        QStringLiteral("reader=$!"),
+        QStringLiteral("wait \"$job\""),
+        QStringLiteral("status=$?"),
+        QStringLiteral("rm -f \"$pidfile\""),
+        QStringLiteral("kill \"$reader\" 2>/dev/null"),
+        QStringLiteral("exit \"$status\""),
+    };
+    return script.join(QLatin1Char('\n'));
+}
+
 void createOutputFile(const QString& outputPath)
 {
     // elevated perf will obviously create a root-owned output by default, but testing revealed that
@@ -44,7 +126,10 @@ void createOutputFile(const QString& outputPath)
 PerfRecord::PerfRecord(const RecordHost* host, QObject* parent)
     : QObject(parent)
     , m_host(host)
+    , m_triggerTimer(new QTimer(this))
 {
+    connect(m_triggerTimer, &QTimer::timeout, this, &PerfRecord::checkTrigger);
+
     connect(&m_perfControlFifo, &PerfControlFifoWrapper::started, this,
             [this]() { m_targetProcessForPrivilegedPerf.continueStoppedProcess(); });
 
@@ -61,8 +146,7 @@ PerfRecord::~PerfRecord()
     }
 }
 
-bool PerfRecord::runPerf(bool elevatePrivileges, const QStringList& perfOptions, const QString& outputPath,
-                         const QString& workingDirectory)
+void PerfRecord::resetPerfProcess()
 {
     // Reset perf record process to avoid getting signals from old processes
     if (m_perfRecordProcess) {
@@ -72,8 +156,31 @@ bool PerfRecord::runPerf(bool elevatePrivileges, const QStringList& perfOptions,
         delete m_perfRecordProcess;
         m_perfControlFifo.close();
     }
+    m_triggerTimer->stop();
+}
+
+bool PerfRecord::runPerf(bool elevatePrivileges, const QStringList& perfOptions, const QString& outputPath,
+                         const QString& workingDirectory)
+{
     m_perfRecordProcess = new QProcess(this);
-    m_perfRecordProcess->setProcessChannelMode(QProcess::MergedChannels);
+    m_elevated = elevatePrivileges;
+    const bool isRemote = !m_host->isLocal();
+    // remote recordings always get streamed back via ssh
+    const bool streamOutput = m_streamOutput || isRemote;
+    // when streaming, stdout carries the perf data and only stderr is meant for the user
+    m_perfRecordProcess->setProcessChannelMode(streamOutput ? QProcess::SeparateChannels : QProcess::MergedChannels);
+    m_streamedOutputFile.reset();
+
+    if (m_flightRecorder && streamOutput) {
+        emit recordingFailed(tr("The flight recorder cannot be combined with the live analysis or remote recording."));
+        return false;
+    }
+    if (m_flightRecorder && elevatePrivileges) {
+        // the snapshot command of the control fifo only dumps AUX area traces, not the --switch-output ring buffers
+        emit recordingFailed(tr("The flight recorder cannot be combined with elevated privileges, as hotspot cannot "
+                                "signal the privileged perf process to take a snapshot."));
+        return false;
+    }
 
     const auto outputFileInfo = QFileInfo(outputPath);
     const auto folderPath = outputFileInfo.dir().path();
@@ -95,17 +202,32 @@ bool PerfRecord::runPerf(bool elevatePrivileges, const QStringList& perfOptions,
             this, [this](int exitCode, QProcess::ExitStatus exitStatus) {
                 Q_UNUSED(exitStatus)
 
-                const auto outputFileInfo = QFileInfo(m_outputPath);
+                if (m_streamedOutputFile) {
+                    readStreamedData();
+                    m_streamedOutputFile.reset();
+                }
+                // the file written at the end is reported last
+                const auto remainingOutput = m_perfRecordProcess->processChannelMode() == QProcess::SeparateChannels
+                    ? m_perfRecordProcess->readAllStandardError()
+                    : m_perfRecordProcess->readAll();
+                if (!remainingOutput.isEmpty()) {
+                    handleOutput(QString::fromUtf8(remainingOutput));
+                }
+
+                // with --switch-output perf moves the data at the end into a timestamped file as well
+                const auto resultPath = m_lastSnapshotPath.isEmpty() ? m_outputPath : m_lastSnapshotPath;
+                const auto outputFileInfo = QFileInfo(resultPath);
                 if ((exitCode == EXIT_SUCCESS || (exitCode == SIGTERM && m_userTerminated) || outputFileInfo.size() > 0)
                     && outputFileInfo.exists()) {
                     if (exitCode != EXIT_SUCCESS && !m_userTerminated) {
                         emit debuggeeCrashed();
                     }
-                    emit recordingFinished(m_outputPath);
+                    emit recordingFinished(resultPath);
                 } else {
                     emit recordingFailed(tr("Failed to record perf data, error code %1.").arg(exitCode));
                 }
                 m_userTerminated = false;
+                m_triggerTimer->stop();
                 delete m_perfRecordProcess;
                 m_perfControlFifo.close();
             });
@@ -118,24 +240,105 @@ bool PerfRecord::runPerf(bool elevatePrivileges, const QStringList& perfOptions,
     });
 
     connect(m_perfRecordProcess.data(), &QProcess::started, this,
-            [this] { emit recordingStarted(m_perfRecordProcess->program(), m_perfRecordProcess->arguments()); });
+            [this] {
+                emit recordingStarted(m_perfRecordProcess->program(), m_perfRecordProcess->arguments());
+                startTrigger();
+            });
 
-    connect(m_perfRecordProcess.data(), &QProcess::readyRead, this, [this]() {
-        const auto output = QString::fromUtf8(m_perfRecordProcess->readAll());
-        emit recordingOutput(output);
-    });
+    if (streamOutput) {
+        connect(m_perfRecordProcess.data(), &QProcess::readyReadStandardOutput, this, &PerfRecord::readStreamedData);
+        connect(m_perfRecordProcess.data(), &QProcess::readyReadStandardError, this, [this]() {
+            handleOutput(QString::fromUtf8(m_perfRecordProcess->readAllStandardError()));
+        });
+    } else {
+        connect(m_perfRecordProcess.data(), &QProcess::readyRead, this, [this]() {
+            handleOutput(QString::fromUtf8(m_perfRecordProcess->readAll()));
+        });
+    }
 
     m_outputPath = outputPath;
     m_userTerminated = false;
+    m_workingDirectory = workingDirectory;
+    m_lastSnapshotPath.clear();
+    m_pendingOutput.clear();
 
-    if (!workingDirectory.isEmpty()) {
+    if (!workingDirectory.isEmpty() && !isRemote) {
         m_perfRecordProcess->setWorkingDirectory(workingDirectory);
     }
 
-    QStringList perfCommand = {QStringLiteral("record"), QStringLiteral("-o"), m_outputPath};
+    if (streamOutput) {
+        m_streamedOutputFile = std::make_unique<QFile>(m_outputPath);
+        if (!m_streamedOutputFile->open(QIODevice::WriteOnly)) {
+            emit recordingFailed(tr("Failed to open output file '%1': %2")
+                                     .arg(m_outputPath, m_streamedOutputFile->errorString()));
+            m_streamedOutputFile.reset();
+            return false;
+        }
+    }
+
+    QStringList perfCommand;
+    if (m_statInterval > 0) {
+        if (m_flightRecorder || m_remoteParsing) {
+            emit recordingFailed(tr("Counting with perf stat cannot be combined with the flight recorder or the "
+                                    "parsing on the remote host."));
+            return false;
+        }
+        // perf stat has no data stream, but prints the counts to the given file descriptor
+        perfCommand = {QStringLiteral("stat"), QStringLiteral("--interval-print"), QString::number(m_statInterval),
+                       QStringLiteral("--field-separator"), QStringLiteral(",")};
+        perfCommand += streamOutput ? QStringList {QStringLiteral("--log-fd"), QStringLiteral("1")}
+                                    : QStringList {QStringLiteral("--output"), m_outputPath};
+    } else {
+        perfCommand = {QStringLiteral("record"), QStringLiteral("-o"),
+                       streamOutput ? QStringLiteral("-") : m_outputPath};
+    }
+    if (m_flightRecorder) {
+        // SIGUSR2 dumps the ring buffers into a new file, see takeSnapshot
+        perfCommand += {QStringLiteral("--overwrite"), QStringLiteral("--switch-output")};
+    }
+    if (!m_threads.isEmpty() && m_statInterval == 0) {
+        if (streamOutput || m_flightRecorder) {
+            emit recordingOutput(tr("Writing with multiple threads is not supported for streamed recordings or the "
+                                    "flight recorder, using a single thread.\n"));
+        } else {
+            perfCommand += QStringLiteral("--threads=") + m_threads;
+        }
+    }
+    // the options have to go before perfOptions, which end with the launched application
+    if (isRemote) {
+        if (m_trigger == RecordingTrigger::AfterDelay) {
+            // there is no control fifo on the remote host, but perf can wait on its own
+            perfCommand += QStringLiteral("--delay=%1").arg(m_triggerValue);
+        } else if (m_trigger != RecordingTrigger::Immediately) {
+            emit recordingFailed(tr("This recording trigger is only supported on the local host."));
+            return false;
+        }
+    } else if (elevatePrivileges || m_trigger != RecordingTrigger::Immediately) {
+        if (!m_perfControlFifo.isOpen() && !m_perfControlFifo.open()) {
+            emit recordingFailed(tr("Failed to create perf control fifos."));
+            return false;
+        }
+        perfCommand +=
+            {QStringLiteral("--control"),
+             QStringLiteral("fifo:%1,%2").arg(m_perfControlFifo.controlFifoPath(), m_perfControlFifo.ackFifoPath())};
+        // the triggers enable the events later on
+        if (m_trigger != RecordingTrigger::Immediately && !perfOptions.contains(QStringLiteral("-D"))) {
+            perfCommand += {QStringLiteral("-D"), QStringLiteral("-1")};
+        }
+    }
     perfCommand += perfOptions;
 
-    if (elevatePrivileges) {
+    if (isRemote) {
+        const auto ssh = RecordHost::sshBinaryPath();
+        if (ssh.isEmpty()) {
+            emit recordingFailed(tr("The ssh utility was not found, cannot record on %1.").arg(m_host->host()));
+            return false;
+        }
+
+        const auto script = remoteRecordScript(QStringList(m_host->perfBinaryPath()) + perfCommand, m_remoteParsing,
+                                               workingDirectory.isEmpty() ? QStringLiteral(".") : workingDirectory);
+        m_perfRecordProcess->start(ssh, m_host->sshArguments(script));
+    } else if (elevatePrivileges) {
         const auto pkexec = RecordHost::pkexecBinaryPath();
         if (pkexec.isEmpty()) {
             emit recordingFailed(tr("The pkexec utility was not found, cannot elevate privileges."));
@@ -146,15 +349,9 @@ bool PerfRecord::runPerf(bool elevatePrivileges, const QStringList& perfOptions,
         options.append(m_host->perfBinaryPath());
         options += perfCommand;
 
-        if (!m_perfControlFifo.open()) {
-            emit recordingFailed(tr("Failed to create perf control fifos."));
-            return false;
+        if (!streamOutput) {
+            createOutputFile(outputPath);
         }
-        options +=
-            {QStringLiteral("--control"),
-             QStringLiteral("fifo:%1,%2").arg(m_perfControlFifo.controlFifoPath(), m_perfControlFifo.ackFifoPath())};
-
-        createOutputFile(outputPath);
 
         m_perfRecordProcess->start(pkexec, options);
     } else {
@@ -171,7 +368,13 @@ void PerfRecord::record(const QStringList& perfOptions, const QString& outputPat
         emit recordingFailed(tr("Process does not exist."));
         return;
     }
+    if (!m_host->isLocal()) {
+        // the process list shows the local processes
+        emit recordingFailed(tr("Attaching to processes is not supported on remote hosts."));
+        return;
+    }
 
+    resetPerfProcess();
     QStringList options = perfOptions;
     options += {QStringLiteral("--pid"), pids.join(QLatin1Char(','))};
     runPerf(actuallyElevatePrivileges(elevatePrivileges), options, outputPath, {});
@@ -180,6 +383,17 @@ void PerfRecord::record(const QStringList& perfOptions, const QString& outputPat
 void PerfRecord::record(const QStringList& perfOptions, const QString& outputPath, bool elevatePrivileges,
                         const QString& exePath, const QStringList& exeOptions, const QString& workingDirectory)
 {
+    resetPerfProcess();
+    if (!m_host->isLocal()) {
+        // the application gets looked up on the remote host when perf launches it
+        QStringList options = perfOptions;
+        options += redirectedStdout(true);
+        options.append(exePath);
+        options += exeOptions;
+        runPerf(false, options, outputPath, workingDirectory);
+        return;
+    }
+
     QFileInfo exeFileInfo(exePath);
 
     if (!exeFileInfo.exists()) {
@@ -199,9 +413,22 @@ void PerfRecord::record(const QStringList& perfOptions, const QString& outputPat
         return;
     }
 
+    auto command = QStringList(exeFileInfo.absoluteFilePath()) + exeOptions;
+    if (m_trigger == RecordingTrigger::ApplicationMarker) {
+        // the application needs to know the fifo before perf gets started
+        if (!m_perfControlFifo.open()) {
+            emit recordingFailed(tr("Failed to create perf control fifos."));
+            return;
+        }
+        command = QStringList {QStringLiteral("env"),
+                               QLatin1String("HOTSPOT_PERF_CONTROL_FIFO=") + m_perfControlFifo.controlFifoPath()}
+            + command;
+    }
+
     QStringList options = perfOptions;
     if (actuallyElevatePrivileges(elevatePrivileges)) {
-        if (!m_targetProcessForPrivilegedPerf.createProcessAndStop(exePath, exeOptions, workingDirectory)) {
+        if (!m_targetProcessForPrivilegedPerf.createProcessAndStop(command.first(), command.mid(1),
+                                                                   workingDirectory)) {
             emit recordingFailed(tr("Failed to prepare a stopped process for %1.").arg(exePath));
             return;
         }
@@ -212,21 +439,147 @@ void PerfRecord::record(const QStringList& perfOptions, const QString& outputPat
             return;
         }
 
-        m_perfControlFifo.requestStart();
+        // the process continues once perf is ready, the events may have to wait for the trigger
+        m_perfControlFifo.requestStart(m_trigger == RecordingTrigger::Immediately);
     } else {
-        options.append(exeFileInfo.absoluteFilePath());
-        options += exeOptions;
+        options += redirectedStdout(m_streamOutput);
+        options += command;
         runPerf(false, options, outputPath, workingDirectory);
     }
 }
 
 void PerfRecord::recordSystem(const QStringList& perfOptions, const QString& outputPath)
 {
+    resetPerfProcess();
     auto options = perfOptions;
     options.append(QStringLiteral("--all-cpus"));
     runPerf(actuallyElevatePrivileges(true), options, outputPath, {});
 }
 
+void PerfRecord::recordCgroup(const QStringList& perfOptions, const QString& outputPath, const QString& cgroup)
+{
+    if (cgroup.isEmpty()) {
+        emit recordingFailed(tr("No cgroup selected."));
+        return;
+    }
+    if (!m_host->isLocal()) {
+        // the cgroups got discovered from the local processes
+        emit recordingFailed(tr("Recording a cgroup is not supported on remote hosts."));
+        return;
+    }
+
+    resetPerfProcess();
+    auto options = perfOptions;
+    if (!options.contains(QLatin1String("--event")) && !options.contains(QLatin1String("-e"))) {
+        // --cgroup applies to the events defined before it, so the default event has to be explicit
+        options += {QStringLiteral("--event"), QStringLiteral("cycles")};
+    }
+    // a single cgroup applies to all of the events, including the nested cgroups of it
+    options += {QStringLiteral("--all-cpus"), QStringLiteral("--cgroup"), cgroup};
+    runPerf(actuallyElevatePrivileges(true), options, outputPath, {});
+}
+
+void PerfRecord::setStreamOutput(bool streamOutput)
+{
+    m_streamOutput = streamOutput;
+}
+
+void PerfRecord::setRemoteParsing(bool remoteParsing)
+{
+    m_remoteParsing = remoteParsing;
+}
+
+void PerfRecord::setFlightRecorder(bool flightRecorder)
+{
+    m_flightRecorder = flightRecorder;
+}
+
+void PerfRecord::setThreads(const QString& threads)
+{
+    m_threads = threads;
+}
+
+void PerfRecord::setStatInterval(int statInterval)
+{
+    m_statInterval = statInterval;
+}
+
+void PerfRecord::setRecordingTrigger(RecordingTrigger trigger, int value)
+{
+    m_trigger = trigger;
+    m_triggerValue = value;
+}
+
+void PerfRecord::startTrigger()
+{
+    m_eventsEnabled = m_trigger == RecordingTrigger::Immediately;
+    if (!m_host->isLocal()) {
+        return;
+    }
+
+    switch (m_trigger) {
+    case RecordingTrigger::Immediately:
+    case RecordingTrigger::ApplicationMarker:
+        break;
+    case RecordingTrigger::AfterDelay:
+        m_triggerTimer->setSingleShot(true);
+        m_triggerTimer->start(m_triggerValue);
+        break;
+    case RecordingTrigger::CpuUsage:
+        m_lastCpuTimes = systemCpuTimes();
+        m_triggerTimer->setSingleShot(false);
+        m_triggerTimer->start(500);
+        break;
+    }
+}
+
+void PerfRecord::checkTrigger()
+{
+    if (m_trigger == RecordingTrigger::AfterDelay) {
+        m_eventsEnabled = true;
+        m_perfControlFifo.requestResume();
+        return;
+    }
+
+    const auto cpuTimes = systemCpuTimes();
+    const auto total = cpuTimes.total - m_lastCpuTimes.total;
+    if (total == 0) {
+        return;
+    }
+    const auto usage = 100. * (cpuTimes.busy - m_lastCpuTimes.busy) / total;
+    m_lastCpuTimes = cpuTimes;
+
+    // perf reports the changes as "Events enabled" and "Events disabled" in its output
+    const bool enable = usage >= m_triggerValue;
+    if (enable != m_eventsEnabled) {
+        m_eventsEnabled = enable;
+        if (enable) {
+            m_perfControlFifo.requestResume();
+        } else {
+            m_perfControlFifo.requestPause();
+        }
+    }
+}
+
+void PerfRecord::takeSnapshot()
+{
+    if (!m_perfRecordProcess || !m_flightRecorder) {
+        return;
+    }
+
+    // with --switch-output, only the signal makes perf dump the ring buffers, see runPerf
+    ::kill(m_perfRecordProcess->processId(), SIGUSR2);
+}
+
+qint64 PerfRecord::perfCpuTime() const
+{
+    // pkexec executes perf, so its pid is the one of perf too
+    if (!m_perfRecordProcess || !m_host->isLocal() || m_perfRecordProcess->state() != QProcess::Running) {
+        return -1;
+    }
+    return processCpuTime(m_perfRecordProcess->processId());
+}
+
 QString PerfRecord::perfCommand() const
 {
     if (m_perfRecordProcess) {
@@ -240,7 +593,10 @@ void PerfRecord::stopRecording()
 {
     m_userTerminated = true;
     if (m_perfRecordProcess) {
-        if (m_perfControlFifo.isOpen()) {
+        if (!m_host->isLocal()) {
+            // lets the remote script interrupt perf, killing ssh would lose the end of the data
+            m_perfRecordProcess->closeWriteChannel();
+        } else if (m_elevated && m_perfControlFifo.isOpen()) {
             m_perfControlFifo.requestStop();
             m_targetProcessForPrivilegedPerf.terminate();
         } else {
@@ -260,8 +616,64 @@ QStringList PerfRecord::offCpuProfilingOptions()
     return {QStringLiteral("--switch-events"), QStringLiteral("--event"), QStringLiteral("sched:sched_switch")};
 }
 
+QStringList PerfRecord::offCpuBpfProfilingOptions()
+{
+    return {QStringLiteral("--off-cpu")};
+}
+
+QStringList PerfRecord::lockContentionOptions()
+{
+    return {QStringLiteral("--event"), QStringLiteral("syscalls:sys_enter_futex"), QStringLiteral("--event"),
+            QStringLiteral("syscalls:sys_exit_futex")};
+}
+
+QStringList PerfRecord::statOptions()
+{
+    return {QStringLiteral("--event"), QStringLiteral("cycles,instructions"),
+            QStringLiteral("--event"), QStringLiteral("cache-references,cache-misses"),
+            QStringLiteral("--event"), QStringLiteral("branches,branch-misses"),
+            QStringLiteral("--event"), QStringLiteral("context-switches")};
+}
+
 bool PerfRecord::actuallyElevatePrivileges(bool elevatePrivileges) const
 {
+    // pkexec needs a local session
+    if (!m_host->isLocal()) {
+        return false;
+    }
     const auto capabilities = m_host->perfCapabilities();
     return elevatePrivileges && capabilities.canElevatePrivileges && !capabilities.privilegesAlreadyElevated;
 }
+
+void PerfRecord::readStreamedData()
+{
+    const auto data = m_perfRecordProcess->readAllStandardOutput();
+    if (data.isEmpty()) {
+        return;
+    }
+    if (m_streamedOutputFile) {
+        m_streamedOutputFile->write(data);
+    }
+    emit perfDataAvailable(data);
+}
+
+void PerfRecord::handleOutput(const QString& output)
+{
+    emit recordingOutput(output);
+
+    m_pendingOutput += output;
+    const auto lines = m_pendingOutput.split(QLatin1Char('\n'));
+    m_pendingOutput = lines.last();
+    // perf reports every file it wrote, like "[ perf record: Dump perf.data.2026101412345678 ]"
+    const auto prefix = QLatin1String("[ perf record: Dump ");
+    const auto suffix = QLatin1String(" ]");
+    for (int i = 0, c = lines.size() - 1; i < c; ++i) {
+        const auto line = lines[i].trimmed();
+        if (!m_flightRecorder || !line.startsWith(prefix) || !line.endsWith(suffix)) {
+            continue;
+        }
+        const auto fileName = line.mid(prefix.size(), line.size() - prefix.size() - suffix.size());
+        m_lastSnapshotPath = QDir(m_workingDirectory).absoluteFilePath(fileName);
+        emit snapshotTaken(m_lastSnapshotPath);
+    }
+}
@@ -14,9 +14,26 @@
 #include <QObject>
 #include <QPointer>
 
+#include <memory>
+
+class QFile;
 class QProcess;
+class QTimer;
 class RecordHost;
 
+// when perf records the events, everything but Immediately starts with disabled events
+enum class RecordingTrigger
+{
+    Immediately,
+    AfterDelay,
+    // the launched application writes "enable" or "disable" lines to the control fifo
+    // it finds the fifo in the HOTSPOT_PERF_CONTROL_FIFO environment variable
+    ApplicationMarker,
+    // records while the system wide CPU usage is above a threshold
+    CpuUsage
+};
+Q_DECLARE_METATYPE(RecordingTrigger)
+
 class PerfRecord : public QObject
 {
     Q_OBJECT
@@ -29,18 +46,56 @@ public:
     void record(const QStringList& perfOptions, const QString& outputPath, bool elevatePrivileges,
                 const QStringList& pids);
     void recordSystem(const QStringList& perfOptions, const QString& outputPath);
+    // like recordSystem, but the events only count while the processes of @p cgroup run
+    void recordCgroup(const QStringList& perfOptions, const QString& outputPath, const QString& cgroup);
+
+    // when enabled, perf streams its data through us instead of writing the output file itself
+    // the data gets forwarded via perfDataAvailable and written to the output file as it arrives
+    void setStreamOutput(bool streamOutput);
+    // when enabled, remote recordings get parsed by hotspot-perfparser on the remote host
+    // only the parsed data gets transferred then, and the symbols get resolved where the binaries are
+    void setRemoteParsing(bool remoteParsing);
+    // when enabled, perf keeps only the latest data in its ring buffers, see --overwrite
+    // takeSnapshot writes that data to a new file, and so does the end of the recording
+    void setFlightRecorder(bool flightRecorder);
+    // the --threads spec for writing the data in parallel, e.g. "numa" for one writer thread per NUMA node
+    // perf only supports this when it writes into a file, so streamed recordings ignore it
+    void setThreads(const QString& threads);
+    // when non-zero, perf stat only counts the events and writes their counts every this many milliseconds as CSV
+    // instead of perf record sampling them, see PerfStat
+    void setStatInterval(int statInterval);
+    void takeSnapshot();
+    // @p value is the delay in milliseconds for AfterDelay and the CPU usage in percent for CpuUsage
+    void setRecordingTrigger(RecordingTrigger trigger, int value = 0);
 
     QString perfCommand() const;
+    // the CPU time in nanoseconds that the local perf process spent so far, or -1 when unknown
+    qint64 perfCpuTime() const;
     void stopRecording();
     void sendInput(const QByteArray& input);
 
     static QStringList offCpuProfilingOptions();
+    // the off-CPU time gets aggregated per stack in the kernel, which avoids recording every context switch
+    static QStringList offCpuBpfProfilingOptions();
+    // the futex tracepoints, see LockContention
+    static QStringList lockContentionOptions();
+    // the events for a quick overview with perf stat, i.e. for the instructions per cycle, the cache and branch misses
+    // and the context switches
+    static QStringList statOptions();
+
+    struct CpuTimes
+    {
+        quint64 busy = 0;
+        quint64 total = 0;
+    };
 
 signals:
     void recordingStarted(const QString& perfBinary, const QStringList& arguments);
     void recordingFinished(const QString& fileLocation);
     void recordingFailed(const QString& errorMessage);
     void recordingOutput(const QString& errorMessage);
+    void perfDataAvailable(const QByteArray& data);
+    void snapshotTaken(const QString& fileLocation);
     void debuggeeCrashed();
 
 private:
@@ -50,8 +105,29 @@ private:
     PerfControlFifoWrapper m_perfControlFifo;
     QString m_outputPath;
     bool m_userTerminated = false;
+    bool m_streamOutput = false;
+    bool m_remoteParsing = false;
+    bool m_flightRecorder = false;
+    QString m_threads;
+    int m_statInterval = 0;
+    bool m_elevated = false;
+    RecordingTrigger m_trigger = RecordingTrigger::Immediately;
+    int m_triggerValue = 0;
+    bool m_eventsEnabled = true;
+    CpuTimes m_lastCpuTimes;
+    QTimer* m_triggerTimer = nullptr;
+    // the files perf reported to have written in flight recorder mode are relative to this folder
+    QString m_workingDirectory;
+    QString m_lastSnapshotPath;
+    QString m_pendingOutput;
+    std::unique_ptr<QFile> m_streamedOutputFile;
 
     bool actuallyElevatePrivileges(bool elevatePrivileges) const;
+    void readStreamedData();
+    void handleOutput(const QString& output);
+    void resetPerfProcess();
+    void startTrigger();
+    void checkTrigger();
 
     bool runPerf(bool elevatePrivileges, const QStringList& perfOptions, const QString& outputPath,
                  const QString& workingDirectory = QString());
@@ -25,17 +25,29 @@
 #include "hotspot-config.h"
 
 namespace {
-QByteArray perfOutput(const QString& perfPath, const QStringList& arguments)
+bool isLocalHost(const QString& host)
 {
-    if (perfPath.isEmpty())
+    return host == QLatin1String("localhost");
+}
+
+QStringList sshArgs(const QString& host, const QString& command)
+{
+    // BatchMode: fail instead of waiting for a password that nobody can enter
+    // the -- ensures the host never gets interpreted as an option
+    return {QStringLiteral("-o"), QStringLiteral("BatchMode=yes"), QStringLiteral("--"), host, command};
+}
+
+// runs @p program on @p host, locally or via ssh
+QByteArray hostOutput(const QString& host, const QString& program, const QStringList& arguments, bool* ok = nullptr)
+{
+    if (program.isEmpty())
         return {};
 
-    // TODO handle error if man is not installed
     QProcess process;
 
     auto reportError = [&]() {
-        qWarning() << "Failed to run perf" << process.arguments() << process.error() << process.errorString()
-                   << process.readAllStandardError();
+        qWarning() << "Failed to run" << process.program() << process.arguments() << process.error()
+                   << process.errorString() << process.readAllStandardError();
     };
 
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
@@ -43,16 +55,32 @@ QByteArray perfOutput(const QString& perfPath, const QStringList& arguments)
     process.setProcessEnvironment(env);
 
     QObject::connect(&process, &QProcess::errorOccurred, &process, reportError);
-    process.start(perfPath, arguments);
-    if (!process.waitForFinished(1000) || process.exitCode() != 0)
+    if (isLocalHost(host)) {
+        process.start(program, arguments);
+    } else {
+        // LANG isn't forwarded by ssh by default
+        const auto command = QLatin1String("LANG=C ") + KShell::joinArgs(QStringList(program) + arguments);
+        process.start(RecordHost::sshBinaryPath(), sshArgs(host, command));
+    }
+    // connecting to a remote host takes a while
+    const bool finished = process.waitForFinished(isLocalHost(host) ? 1000 : 10000);
+    if (!finished || process.exitCode() != 0)
         reportError();
+    if (ok)
+        *ok = finished && process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
     return process.readAllStandardOutput();
 }
 
-QByteArray perfRecordHelp(const QString& perfPath)
+QByteArray perfOutput(const QString& host, const QString& perfPath, const QStringList& arguments)
+{
+    // TODO handle error if man is not installed
+    return hostOutput(host, perfPath, arguments);
+}
+
+QByteArray perfRecordHelp(const QString& host, const QString& perfPath)
 {
-    QByteArray recordHelp = [&perfPath]() {
-        QByteArray help = perfOutput(perfPath, {QStringLiteral("record"), QStringLiteral("--help")});
+    QByteArray recordHelp = [&host, &perfPath]() {
+        QByteArray help = perfOutput(host, perfPath, {QStringLiteral("record"), QStringLiteral("--help")});
         if (help.isEmpty()) {
             // no man page installed, assume the best
             help = "--sample-cpu --switch-events";
@@ -62,9 +90,9 @@ QByteArray perfRecordHelp(const QString& perfPath)
     return recordHelp;
 }
 
-QByteArray perfBuildOptions(const QString& perfPath)
+QByteArray perfBuildOptions(const QString& host, const QString& perfPath)
 {
-    return perfOutput(perfPath, {QStringLiteral("version"), QStringLiteral("--build-options")});
+    return perfOutput(host, perfPath, {QStringLiteral("version"), QStringLiteral("--build-options")});
 }
 
 bool canTrace(const QString& path)
@@ -122,23 +150,37 @@ bool privsAlreadyElevated()
     return isElevated;
 }
 
-RecordHost::PerfCapabilities fetchLocalPerfCapabilities(const QString& perfPath)
+RecordHost::PerfCapabilities fetchPerfCapabilities(const QString& host, const QString& perfPath)
 {
     RecordHost::PerfCapabilities capabilities;
 
-    const auto buildOptions = perfBuildOptions(perfPath);
-    const auto help = perfRecordHelp(perfPath);
+    const auto buildOptions = perfBuildOptions(host, perfPath);
+    const auto help = perfRecordHelp(host, perfPath);
     capabilities.canCompress = Zstd_FOUND && buildOptions.contains("zstd: [ on  ]");
     capabilities.canUseAio = buildOptions.contains("aio: [ on  ]");
+    capabilities.canUseThreads = help.contains("--threads");
     capabilities.libtraceeventSupport = buildOptions.contains("libtraceevent: [ on  ]");
     capabilities.canSwitchEvents = help.contains("--switch-events");
     capabilities.canSampleCpu = help.contains("--sample-cpu");
-    capabilities.canProfileOffCpu =
-        capabilities.libtraceeventSupport && canTrace(QStringLiteral("events/sched/sched_switch"));
-
-    const auto isElevated = privsAlreadyElevated();
-    capabilities.privilegesAlreadyElevated = isElevated;
-    capabilities.canElevatePrivileges = isElevated || canElevatePrivileges();
+    capabilities.canProfileOffCpuWithBpf = help.contains("--off-cpu") && buildOptions.contains("bpf_skel: [ on  ]");
+    capabilities.canProfileCgroup = help.contains("--cgroup");
+
+    if (isLocalHost(host)) {
+        capabilities.canProfileOffCpu =
+            capabilities.libtraceeventSupport && canTrace(QStringLiteral("events/sched/sched_switch"));
+
+        const auto isElevated = privsAlreadyElevated();
+        capabilities.privilegesAlreadyElevated = isElevated;
+        capabilities.canElevatePrivileges = isElevated || canElevatePrivileges();
+    } else {
+        // pkexec needs a local session, so the remote host has to be set up for profiling already
+        const auto paranoid = hostOutput(host, QStringLiteral("cat"),
+                                         {QStringLiteral("/proc/sys/kernel/perf_event_paranoid")})
+                                  .trimmed();
+        capabilities.privilegesAlreadyElevated = paranoid == "-1";
+        capabilities.canElevatePrivileges = capabilities.privilegesAlreadyElevated;
+        capabilities.canProfileOffCpu = capabilities.libtraceeventSupport && capabilities.privilegesAlreadyElevated;
+    }
 
     return capabilities;
 }
@@ -160,6 +202,7 @@ RecordHost::RecordHost(QObject* parent)
     connectIsReady(&RecordHost::perfCapabilitiesChanged);
     connectIsReady(&RecordHost::recordTypeChanged);
     connectIsReady(&RecordHost::pidsChanged);
+    connectIsReady(&RecordHost::cgroupChanged);
     connectIsReady(&RecordHost::currentWorkingDirectoryChanged);
 
     setHost(QStringLiteral("localhost"));
@@ -181,6 +224,10 @@ bool RecordHost::isReady() const
         break;
     case RecordType::ProfileSystem:
         break;
+    case RecordType::ProfileCgroup:
+        if (m_cgroup.isEmpty() || !m_perfCapabilities.canProfileCgroup)
+            return false;
+        break;
     case RecordType::NUM_RECORD_TYPES:
         Q_ASSERT(false);
     }
@@ -216,7 +263,7 @@ void RecordHost::setHost(const QString& host)
     emit perfCapabilitiesChanged(m_perfCapabilities);
 
     const auto perfPath = perfBinaryPath();
-    m_checkPerfCapabilitiesJob.startJob([perfPath](auto&&) { return fetchLocalPerfCapabilities(perfPath); },
+    m_checkPerfCapabilitiesJob.startJob([host, perfPath](auto&&) { return fetchPerfCapabilities(host, perfPath); },
                                         [this](RecordHost::PerfCapabilities capabilities) {
                                             Q_ASSERT(QThread::currentThread() == thread());
 
@@ -225,7 +272,7 @@ void RecordHost::setHost(const QString& host)
                                         });
 
     m_checkPerfInstalledJob.startJob(
-        [isLocal = isLocal(), perfPath](auto&&) {
+        [host, isLocal = isLocal(), perfPath](auto&&) {
             if (isLocal) {
                 if (perfPath.isEmpty()) {
                     return !QStandardPaths::findExecutable(QStringLiteral("perf")).isEmpty();
@@ -234,12 +281,22 @@ void RecordHost::setHost(const QString& host)
                 return QFileInfo::exists(perfPath);
             }
 
-            qWarning() << "remote is not implemented";
-            return false;
+            if (sshBinaryPath().isEmpty()) {
+                return false;
+            }
+            bool ok = false;
+            hostOutput(host, perfPath, {QStringLiteral("--version")}, &ok);
+            return ok;
         },
-        [this](bool isInstalled) {
+        [this, isLocal = isLocal()](bool isInstalled) {
             if (!isInstalled) {
-                emit errorOccurred(tr("perf is not installed"));
+                if (isLocal) {
+                    emit errorOccurred(tr("perf is not installed"));
+                } else if (sshBinaryPath().isEmpty()) {
+                    emit errorOccurred(tr("ssh is not installed, cannot record on %1").arg(m_host));
+                } else {
+                    emit errorOccurred(tr("Failed to run perf on %1 via ssh").arg(m_host));
+                }
             }
             m_isPerfInstalled = isInstalled;
             emit isPerfInstalledChanged(isInstalled);
@@ -267,7 +324,10 @@ void RecordHost::setCurrentWorkingDirectory(const QString& cwd)
         return;
     }
 
-    qWarning() << "is not implemented for remote";
+    // the remote folder can only be checked once perf gets launched there
+    emit errorOccurred({});
+    m_cwd = cwd;
+    emit currentWorkingDirectoryChanged(cwd);
 }
 
 void RecordHost::setClientApplication(const QString& clientApplication)
@@ -298,35 +358,42 @@ void RecordHost::setClientApplication(const QString& clientApplication)
         return;
     }
 
-    qWarning() << "is not implemented for remote";
+    // the remote application can only be checked once perf launches it
+    if (clientApplication.isEmpty()) {
+        emit errorOccurred(tr("Application file cannot be found: %1").arg(clientApplication));
+        return;
+    }
+    emit errorOccurred({});
+    m_clientApplication = clientApplication;
+    emit clientApplicationChanged(m_clientApplication);
+
+    if (m_cwd.isEmpty()) {
+        // ssh starts in the home folder of the remote user
+        setCurrentWorkingDirectory(QStringLiteral("."));
+    }
 }
 
 void RecordHost::setOutputFileName(const QString& filePath)
 {
-    if (isLocal()) {
-        const auto perfDataExtension = QStringLiteral(".data");
-
-        const QFileInfo file(filePath);
-        const QFileInfo folder(file.absolutePath());
-
-        if (!folder.exists()) {
-            emit errorOccurred(tr("Output file directory folder cannot be found: %1").arg(folder.path()));
-        } else if (!folder.isDir()) {
-            emit errorOccurred(tr("Output file directory folder is not valid: %1").arg(folder.path()));
-        } else if (!folder.isWritable()) {
-            emit errorOccurred(tr("Output file directory folder is not writable: %1").arg(folder.path()));
-        } else if (!file.absoluteFilePath().endsWith(perfDataExtension)) {
-            emit errorOccurred(tr("Output file must end with %1").arg(perfDataExtension));
-        } else {
-            emit errorOccurred({});
-            m_outputFileName = filePath;
-            emit outputFileNameChanged(m_outputFileName);
-        }
-
-        return;
+    // the data of remote recordings is streamed back, so the output file is always local
+    const auto perfDataExtension = QStringLiteral(".data");
+
+    const QFileInfo file(filePath);
+    const QFileInfo folder(file.absolutePath());
+
+    if (!folder.exists()) {
+        emit errorOccurred(tr("Output file directory folder cannot be found: %1").arg(folder.path()));
+    } else if (!folder.isDir()) {
+        emit errorOccurred(tr("Output file directory folder is not valid: %1").arg(folder.path()));
+    } else if (!folder.isWritable()) {
+        emit errorOccurred(tr("Output file directory folder is not writable: %1").arg(folder.path()));
+    } else if (!file.absoluteFilePath().endsWith(perfDataExtension)) {
+        emit errorOccurred(tr("Output file must end with %1").arg(perfDataExtension));
+    } else {
+        emit errorOccurred({});
+        m_outputFileName = filePath;
+        emit outputFileNameChanged(m_outputFileName);
     }
-
-    qWarning() << "is not implemented for remote";
 }
 
 void RecordHost::setRecordType(RecordType type)
@@ -337,6 +404,7 @@ void RecordHost::setRecordType(RecordType type)
 
         m_pids.clear();
         emit pidsChanged();
+        setCgroup({});
     }
 }
 
@@ -348,9 +416,17 @@ void RecordHost::setPids(const QStringList& pids)
     }
 }
 
+void RecordHost::setCgroup(const QString& cgroup)
+{
+    if (m_cgroup != cgroup) {
+        m_cgroup = cgroup;
+        emit cgroupChanged(m_cgroup);
+    }
+}
+
 bool RecordHost::isLocal() const
 {
-    return m_host == QLatin1String("localhost");
+    return isLocalHost(m_host);
 }
 
 QString RecordHost::pkexecBinaryPath()
@@ -358,6 +434,16 @@ QString RecordHost::pkexecBinaryPath()
     return findPkexec();
 }
 
+QString RecordHost::sshBinaryPath()
+{
+    return QStandardPaths::findExecutable(QStringLiteral("ssh"));
+}
+
+QStringList RecordHost::sshArguments(const QString& command) const
+{
+    return sshArgs(m_host, command);
+}
+
 QString RecordHost::perfBinaryPath() const
 {
     if (isLocal()) {
@@ -366,5 +452,5 @@ QString RecordHost::perfBinaryPath() const
             perf = QStandardPaths::findExecutable(QStringLiteral("perf"));
         return perf;
     }
-    return {};
+    return QStringLiteral("perf");
 }
@@ -16,6 +16,8 @@ enum class RecordType
     LaunchApplication,
     AttachToProcess,
     ProfileSystem,
+    // system wide, but only the events of the processes in one cgroup, e.g. a container
+    ProfileCgroup,
     NUM_RECORD_TYPES
 };
 Q_DECLARE_METATYPE(RecordType)
@@ -43,9 +45,10 @@ public:
     {
         return m_host;
     }
+    // anything but localhost is reached via ssh, e.g. "user@server"
+    // key based authentication is required, as there is no terminal to ask for a password
     void setHost(const QString& host);
-
-    // TODO: username etc. pp.
+    bool isLocal() const;
 
     QString currentWorkingDirectory() const
     {
@@ -66,7 +69,11 @@ public:
     void setOutputFileName(const QString& filePath);
 
     static QString pkexecBinaryPath();
+    static QString sshBinaryPath();
+    // on remote hosts, perf is looked up in the PATH of the remote shell
     QString perfBinaryPath() const;
+    // the arguments for ssh to run the shell @p command on the remote host
+    QStringList sshArguments(const QString& command) const;
 
     // async query options
     struct PerfCapabilities
@@ -75,7 +82,11 @@ public:
         bool canProfileOffCpu = false;
         bool canSampleCpu = false;
         bool canSwitchEvents = false;
+        // perf record --off-cpu, which needs perf to be built with the BPF skeletons
+        bool canProfileOffCpuWithBpf = false;
+        bool canProfileCgroup = false;
         bool canUseAio = false;
+        bool canUseThreads = false;
         bool canCompress = false;
         bool canElevatePrivileges = false;
         bool privilegesAlreadyElevated = false;
@@ -96,6 +107,13 @@ public:
     // list of pids to record
     void setPids(const QStringList& pids);
 
+    // the cgroup to record, relative to the cgroup mount
+    QString cgroup() const
+    {
+        return m_cgroup;
+    }
+    void setCgroup(const QString& cgroup);
+
 signals:
     /// disallow "start" on recordpage until this is ready and that should only be the case when there's no error
     void isReadyChanged(bool isReady);
@@ -109,10 +127,9 @@ signals:
     void outputFileNameChanged(const QString& outputFileName);
     void recordTypeChanged(RecordType type);
     void pidsChanged();
+    void cgroupChanged(const QString& cgroup);
 
 private:
-    bool isLocal() const;
-
     QString m_host;
     QString m_error;
     QString m_cwd;
@@ -124,6 +141,7 @@ private:
     RecordType m_recordType = RecordType::LaunchApplication;
     bool m_isPerfInstalled = false;
     QStringList m_pids;
+    QString m_cgroup;
 };
 
 Q_DECLARE_METATYPE(RecordHost::PerfCapabilities)
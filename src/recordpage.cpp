@@ -13,10 +13,12 @@
 #include "processmodel.h"
 #include "recordhost.h"
 #include "resultsutil.h"
+#include "settings.h"
 #include "util.h"
 
 #include <QDebug>
 #include <QKeyEvent>
+#include <QLineEdit>
 #include <QListView>
 #include <QRegularExpression>
 #include <QScrollArea>
@@ -40,6 +42,8 @@
 #include <Solid/Device>
 #include <Solid/Processor>
 
+#include <algorithm>
+
 #include "multiconfigwidget.h"
 #include "perfoutputwidgetkonsole.h"
 #include "perfoutputwidgettext.h"
@@ -73,11 +77,72 @@ RecordType selectedRecordType(const std::unique_ptr<Ui::RecordPage>& ui)
     return ui->recordTypeComboBox->currentData().value<RecordType>();
 }
 
+RecordingTrigger selectedRecordingTrigger(const std::unique_ptr<Ui::RecordPage>& ui)
+{
+    return ui->recordingTriggerComboBox->currentData().value<RecordingTrigger>();
+}
+
+// the delay is shown in seconds, but passed on in milliseconds
+int recordingTriggerValue(const std::unique_ptr<Ui::RecordPage>& ui)
+{
+    const auto value = ui->recordingTriggerValueSpinBox->value();
+    return selectedRecordingTrigger(ui) == RecordingTrigger::AfterDelay ? value * 1000 : value;
+}
+
+// the settings that decide whether perf keeps up with the events, see recordingPresetComboBox
+struct ThroughputPreset
+{
+    // see compressionComboBox
+    int compressionLevel;
+    bool useAio;
+    // in MB
+    int mmapPages;
+    // see threadsComboBox
+    const char* threads;
+};
+
+// in the order of recordingPresetComboBox, after the custom entry
+const ThroughputPreset throughputPresets[] = {
+    // the fast default compression level
+    {0, false, 16, ""},
+    // the fastest compression and asynchronous writing into larger buffers keep up with high sampling frequencies
+    {1, true, 64, ""},
+    // one writer thread per NUMA node, which also reads the buffers of the CPUs close to it
+    {1, false, 64, "numa"},
+};
+
+// the index of the preset that matches the current settings, or -1
+int matchingThroughputPreset(const std::unique_ptr<Ui::RecordPage>& ui)
+{
+    const auto begin = std::begin(throughputPresets);
+    const auto end = std::end(throughputPresets);
+    const auto it = std::find_if(begin, end, [&ui](const ThroughputPreset& preset) {
+        return ui->compressionComboBox->currentData().toInt() == preset.compressionLevel
+            && ui->useAioCheckBox->isChecked() == preset.useAio && ui->mmapPagesSpinBox->value() == preset.mmapPages
+            && ui->mmapPagesUnitComboBox->currentIndex() == 2
+            && ui->threadsComboBox->currentData().toString() == QLatin1String(preset.threads);
+    });
+    return it == end ? -1 : static_cast<int>(std::distance(begin, it));
+}
+
+void applyThroughputPreset(const std::unique_ptr<Ui::RecordPage>& ui, const ThroughputPreset& preset)
+{
+    ui->compressionComboBox->setCurrentIndex(ui->compressionComboBox->findData(preset.compressionLevel));
+    ui->useAioCheckBox->setChecked(preset.useAio);
+    ui->mmapPagesSpinBox->setValue(preset.mmapPages);
+    // MB
+    ui->mmapPagesUnitComboBox->setCurrentIndex(2);
+    ui->threadsComboBox->setCurrentIndex(ui->threadsComboBox->findData(QString::fromLatin1(preset.threads)));
+}
+
 KConfigGroup config()
 {
     return KSharedConfig::openConfig()->group(QStringLiteral("RecordPage"));
 }
 
+// in percent of one CPU, more than that is likely to disturb the profiled application
+const auto maxPerfCpuUsage = 20.;
+
 KConfigGroup applicationConfig(const QString& application)
 {
     if (application.isEmpty())
@@ -138,6 +203,7 @@ RecordPage::RecordPage(QWidget* parent)
     , m_perfRecord(new PerfRecord(m_recordHost, this))
     , m_updateRuntimeTimer(new QTimer(this))
     , m_watcher(new QFutureWatcher<ProcDataList>(this))
+    , m_processListCache(std::make_shared<ProcessListCache>())
 {
     {
         auto* layout = new QVBoxLayout(this);
@@ -176,7 +242,7 @@ RecordPage::RecordPage(QWidget* parent)
     ui->compressionComboBox->addItem(tr("Enabled (Default Level)"), 0);
     ui->compressionComboBox->addItem(tr("Level 1 (Fastest)"), 1);
     for (int i = 2; i <= 21; ++i)
-        ui->compressionComboBox->addItem(tr("Level %1").arg(i), 0);
+        ui->compressionComboBox->addItem(tr("Level %1").arg(i), i);
     ui->compressionComboBox->addItem(tr("Level 22 (Slowest)"), 22);
     ui->compressionComboBox->setCurrentIndex(1);
     const auto defaultLevel = ui->compressionComboBox->currentData().toInt();
@@ -185,6 +251,15 @@ RecordPage::RecordPage(QWidget* parent)
     if (index != -1)
         ui->compressionComboBox->setCurrentIndex(index);
 
+    ui->threadsComboBox->addItem(tr("Disabled"), QString());
+    ui->threadsComboBox->addItem(tr("Per CPU"), QStringLiteral("cpu"));
+    ui->threadsComboBox->addItem(tr("Per Core"), QStringLiteral("core"));
+    ui->threadsComboBox->addItem(tr("Per Package"), QStringLiteral("package"));
+    ui->threadsComboBox->addItem(tr("Per NUMA Node"), QStringLiteral("numa"));
+    const auto threadsIndex = ui->threadsComboBox->findData(config().readEntry(QStringLiteral("threads"), QString()));
+    if (threadsIndex != -1)
+        ui->threadsComboBox->setCurrentIndex(threadsIndex);
+
     connect(m_recordHost, &RecordHost::perfCapabilitiesChanged, this,
             [this](RecordHost::PerfCapabilities capabilities) {
                 ui->sampleCpuCheckBox->setVisible(capabilities.canSampleCpu);
@@ -192,6 +267,8 @@ RecordPage::RecordPage(QWidget* parent)
 
                 ui->offCpuCheckBox->setVisible(capabilities.canSwitchEvents);
                 ui->offCpuLabel->setVisible(capabilities.canSwitchEvents);
+                ui->offCpuBpfCheckBox->setVisible(capabilities.canSwitchEvents && capabilities.canProfileOffCpuWithBpf);
+                ui->lockContentionCheckBox->setVisible(capabilities.canSwitchEvents);
 
                 ui->useAioCheckBox->setVisible(capabilities.canUseAio);
                 ui->useAioLabel->setVisible(capabilities.canUseAio);
@@ -199,6 +276,9 @@ RecordPage::RecordPage(QWidget* parent)
                 ui->compressionComboBox->setVisible(capabilities.canCompress);
                 ui->compressionLabel->setVisible(capabilities.canCompress);
 
+                ui->threadsComboBox->setVisible(capabilities.canUseThreads);
+                ui->threadsLabel->setVisible(capabilities.canUseThreads);
+
                 ui->offCpuCheckBox->setCheckable(capabilities.libtraceeventSupport);
 
                 if (!capabilities.libtraceeventSupport) {
@@ -234,15 +314,6 @@ RecordPage::RecordPage(QWidget* parent)
     ui->outputFile->setMode(KFile::File | KFile::LocalOnly);
     ui->eventTypeBox->lineEdit()->setPlaceholderText(tr("perf defaults (usually cycles:Pu)"));
 
-    m_perfOutput = PerfOutputWidgetKonsole::create(this);
-    if (!m_perfOutput) {
-        m_perfOutput = new PerfOutputWidgetText(this);
-    }
-    ui->recordOutputBoxLayout->addWidget(m_perfOutput);
-
-    connect(m_perfOutput, &PerfOutputWidget::sendInput, this,
-            [this](const QByteArray& input) { m_perfRecord->sendInput(input); });
-
     auto saveFunction = [this](KConfigGroup group) {
         group.writeEntry("params", ui->applicationParametersBox->text());
         group.writeEntry("workingDir", ui->workingDirectory->text());
@@ -267,6 +338,36 @@ RecordPage::RecordPage(QWidget* parent)
             &MultiConfigWidget::updateCurrentConfig);
     connect(ui->workingDirectory, &KUrlRequester::textChanged, m_multiConfig, &MultiConfigWidget::updateCurrentConfig);
 
+    {
+        // the call chains of frame pointers and LBR are part of the samples, so recording and parsing them is
+        // much cheaper than copying and unwinding the stack with DWARF
+        auto* presetComboBox = new QComboBox(this);
+        presetComboBox->addItem(tr("Custom"));
+        presetComboBox->addItem(tr("Low Overhead (Frame Pointer)"), QStringLiteral("fp"));
+        if (isIntel()) {
+            presetComboBox->addItem(tr("Low Overhead (Last Branch Record)"), QStringLiteral("lbr"));
+        }
+        presetComboBox->addItem(tr("Full Call Stacks (DWARF)"), QStringLiteral("dwarf"));
+        presetComboBox->setToolTip(
+            tr("<qt>Selects the unwinding method in the advanced options. The low overhead presets record the call "
+               "chains that the kernel collects with each sample, which is cheap enough for always-on sampling, "
+               "but requires frame pointers or an Intel CPU with LBR. DWARF unwinding works without either, "
+               "at the cost of large data files and slow parsing.</qt>"));
+        ui->formLayout->insertRow(0, tr("Preset:"), presetComboBox);
+
+        connect(presetComboBox, qOverload<int>(&QComboBox::activated), this, [this, presetComboBox](int index) {
+            const auto callGraphIdx = ui->callGraphComboBox->findData(presetComboBox->itemData(index));
+            if (callGraphIdx != -1) {
+                ui->callGraphComboBox->setCurrentIndex(callGraphIdx);
+            }
+        });
+        connect(ui->callGraphComboBox, qOverload<int>(&QComboBox::currentIndexChanged), presetComboBox,
+                [this, presetComboBox](int index) {
+                    const auto presetIdx = presetComboBox->findData(ui->callGraphComboBox->itemData(index));
+                    presetComboBox->setCurrentIndex(std::max(0, presetIdx));
+                });
+    }
+
     auto columnResizer = new KColumnResizer(this);
     columnResizer->addWidgetsFromLayout(ui->formLayout);
     columnResizer->addWidgetsFromLayout(ui->formLayout_1);
@@ -277,7 +378,21 @@ RecordPage::RecordPage(QWidget* parent)
     connect(ui->applicationName, &KUrlRequester::textChanged, m_recordHost, &RecordHost::setClientApplication);
     connect(ui->startRecordingButton, &QPushButton::toggled, this, &RecordPage::onStartRecordingButtonClicked);
     connect(ui->workingDirectory, &KUrlRequester::textChanged, m_recordHost, &RecordHost::setCurrentWorkingDirectory);
-    connect(ui->viewPerfRecordResultsButton, &QPushButton::clicked, this, [this] { emit openFile(m_resultsFile); });
+    connect(ui->viewPerfRecordResultsButton, &QPushButton::clicked, this, [this] {
+        // the results of a live recording get parsed already
+        if (!m_liveRecordingFile.isEmpty()) {
+            emit showLiveResults();
+        } else if (m_recordTimer.isValid()) {
+            // opening the results here would stop the flight recording
+            emit openFileInNewWindow(m_resultsFile);
+        } else {
+            for (const auto& file : std::as_const(m_additionalResultsFiles)) {
+                emit openFileInNewWindow(file);
+            }
+            emit openFile(m_resultsFile);
+        }
+    });
+    connect(ui->takeSnapshotButton, &QPushButton::clicked, m_perfRecord, &PerfRecord::takeSnapshot);
     connect(ui->outputFile, &KUrlRequester::textChanged, m_recordHost, &RecordHost::setOutputFileName);
     connect(ui->outputFile, static_cast<void (KUrlRequester::*)(const QString&)>(&KUrlRequester::returnPressed),
             m_recordHost, &RecordHost::setOutputFileName);
@@ -290,8 +405,28 @@ RecordPage::RecordPage(QWidget* parent)
                                     QVariant::fromValue(RecordType::AttachToProcess));
     ui->recordTypeComboBox->addItem(QIcon::fromTheme(QStringLiteral("run-build-install-root")), tr("Profile System"),
                                     QVariant::fromValue(RecordType::ProfileSystem));
+    ui->recordTypeComboBox->addItem(QIcon::fromTheme(QStringLiteral("run-build-install-root")),
+                                    tr("Profile Container (cgroup)"), QVariant::fromValue(RecordType::ProfileCgroup));
+
+    ui->recordingTriggerComboBox->addItem(tr("Immediately"), QVariant::fromValue(RecordingTrigger::Immediately));
+    ui->recordingTriggerComboBox->addItem(tr("After a Delay"), QVariant::fromValue(RecordingTrigger::AfterDelay));
+    ui->recordingTriggerComboBox->addItem(tr("On Application Marker"),
+                                          QVariant::fromValue(RecordingTrigger::ApplicationMarker));
+    ui->recordingTriggerComboBox->addItem(tr("Above CPU Usage"), QVariant::fromValue(RecordingTrigger::CpuUsage));
+    auto updateRecordingTrigger = [this]() {
+        const auto trigger = selectedRecordingTrigger(ui);
+        const bool isDelay = trigger == RecordingTrigger::AfterDelay;
+        ui->recordingTriggerValueSpinBox->setVisible(isDelay || trigger == RecordingTrigger::CpuUsage);
+        ui->recordingTriggerValueSpinBox->setSuffix(isDelay ? tr(" s") : tr(" %"));
+        ui->recordingTriggerValueSpinBox->setRange(isDelay ? 0 : 1, isDelay ? 24 * 60 * 60 : 100);
+    };
+    connect(ui->recordingTriggerComboBox, qOverload<int>(&QComboBox::currentIndexChanged), this,
+            updateRecordingTrigger);
     connect(ui->recordTypeComboBox, qOverload<int>(&QComboBox::currentIndexChanged), this,
             &RecordPage::updateRecordType);
+    // the selected processes mean something else for the other record type
+    connect(ui->recordTypeComboBox, qOverload<int>(&QComboBox::currentIndexChanged), ui->processesTableView,
+            &QAbstractItemView::clearSelection);
     connect(ui->recordTypeComboBox, qOverload<int>(&QComboBox::currentIndexChanged), m_recordHost,
             [this] { m_recordHost->setRecordType(ui->recordTypeComboBox->currentData().value<RecordType>()); });
     connect(m_recordHost, &RecordHost::clientApplicationChanged, this, &RecordPage::updateRecordType);
@@ -337,12 +472,25 @@ RecordPage::RecordPage(QWidget* parent)
     }
 
     {
-        for (const auto size : {1024, 2048, 4096, 8192, 16384}) {
+        for (const auto size : {1024, 2048, 4096, 8192, 16384, 32768, 65528}) {
             ui->stackDumpComboBox->addItem(QString::number(size));
         }
 
-        // select 8196 (perf default)
-        ui->stackDumpComboBox->setCurrentIndex(3);
+        // 8192 (perf default) unless the parser asked for more after the stacks of a recording got truncated
+        auto selectStackDumpSize = [this](int stackDumpSize) {
+            const auto text = QString::number(stackDumpSize);
+            auto index = ui->stackDumpComboBox->findText(text);
+            if (index == -1) {
+                ui->stackDumpComboBox->addItem(text);
+                index = ui->stackDumpComboBox->count() - 1;
+            }
+            ui->stackDumpComboBox->setCurrentIndex(index);
+        };
+        selectStackDumpSize(Settings::instance()->stackDumpSize());
+        connect(Settings::instance(), &Settings::stackDumpSizeChanged, this, selectStackDumpSize);
+        connect(ui->stackDumpComboBox, &QComboBox::currentTextChanged, this, [](const QString& text) {
+            Settings::instance()->setStackDumpSize(text.toInt());
+        });
     }
 
     connect(ui->callGraphComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
@@ -357,11 +505,25 @@ RecordPage::RecordPage(QWidget* parent)
             [this](const QString& perfBinary, const QStringList& arguments) {
                 m_recordTimer.start();
                 m_updateRuntimeTimer->start();
+                m_lastPerfCpuTime = -1;
+                ui->perfOverheadLabel->clear();
                 appendOutput(QLatin1String("$ ") + perfBinary + QLatin1Char(' ') + arguments.join(QLatin1Char(' '))
                              + QLatin1Char('\n'));
-                m_perfOutput->enableInput(true);
+                perfOutput()->enableInput(true);
+                if (!m_liveRecordingFile.isEmpty()) {
+                    ui->viewPerfRecordResultsButton->setEnabled(true);
+                    emit liveRecordingStarted(m_liveRecordingFile);
+                }
+                ui->takeSnapshotButton->setEnabled(ui->flightRecorderCheckBox->isChecked());
             });
 
+    connect(m_perfRecord, &PerfRecord::snapshotTaken, this, [this](const QString& fileLocation) {
+        m_resultsFile = fileLocation;
+        ui->viewPerfRecordResultsButton->setEnabled(true);
+    });
+
+    connect(m_perfRecord, &PerfRecord::perfDataAvailable, this, &RecordPage::liveDataAvailable);
+
     connect(m_perfRecord, &PerfRecord::recordingFinished, this, [this](const QString& fileLocation) {
         appendOutput(tr("\nrecording finished after %1").arg(Util::formatTimeString(m_recordTimer.nsecsElapsed())));
         m_resultsFile = fileLocation;
@@ -406,11 +568,21 @@ RecordPage::RecordPage(QWidget* parent)
             [this](const QItemSelection&, const QItemSelection&) {
                 const auto selection = ui->processesTableView->selectionModel()->selectedRows();
                 QStringList pids;
+                QStringList cgroups;
                 pids.reserve(selection.size());
                 for (const auto& item : selection) {
                     pids.append(item.data(ProcessModel::PIDRole).toString());
+                    cgroups.append(item.data(ProcessModel::CgroupRole).toString());
+                }
+                if (selectedRecordType(ui) == RecordType::ProfileCgroup) {
+                    const auto cgroup = commonCgroup(cgroups);
+                    m_recordHost->setCgroup(cgroup);
+                    setError(!selection.isEmpty() && cgroup.isEmpty()
+                                 ? tr("The selected processes are not in a common cgroup other than the root one.")
+                                 : QString());
+                } else {
+                    m_recordHost->setPids(pids);
                 }
-                m_recordHost->setPids(pids);
             });
 
     ResultsUtil::connectFilter(ui->processesFilterBox, m_processProxyModel);
@@ -426,31 +598,75 @@ RecordPage::RecordPage(QWidget* parent)
         }
 
         ui->offCpuCheckBox->setEnabled(enableOffCpuProfiling);
+        // the lock tracepoints need the same privileges as the scheduler ones
+        ui->lockContentionCheckBox->setEnabled(enableOffCpuProfiling);
 
         // prevent user confusion: don't show the value as checked when the checkbox is disabled
         if (!enableOffCpuProfiling) {
             // remember the current value
             config().writeEntry(QStringLiteral("offCpuProfiling"), ui->offCpuCheckBox->isChecked());
+            config().writeEntry(QStringLiteral("lockContention"), ui->lockContentionCheckBox->isChecked());
             ui->offCpuCheckBox->setChecked(false);
+            ui->lockContentionCheckBox->setChecked(false);
         } else {
             ui->offCpuCheckBox->setChecked(config().readEntry(QStringLiteral("offCpuProfiling"), false));
+            ui->lockContentionCheckBox->setChecked(config().readEntry(QStringLiteral("lockContention"), false));
         }
     };
 
     connect(ui->elevatePrivilegesCheckBox, &QCheckBox::toggled, this,
             [this, updateOffCpuCheckboxState] { updateOffCpuCheckboxState(m_recordHost->perfCapabilities()); });
+    // the BPF aggregation only changes how the off-CPU time gets recorded
+    connect(ui->offCpuCheckBox, &QCheckBox::toggled, ui->offCpuBpfCheckBox, &QCheckBox::setEnabled);
 
     connect(m_recordHost, &RecordHost::perfCapabilitiesChanged, this, updateOffCpuCheckboxState);
 
+    restoreCombobox(config(), QStringLiteral("hosts"), ui->hostComboBox, {QStringLiteral("localhost")});
     restoreCombobox(config(), QStringLiteral("applications"), ui->applicationName->comboBox());
     restoreCombobox(config(), QStringLiteral("eventType"), ui->eventTypeBox, {ui->eventTypeBox->currentText()});
     restoreCombobox(config(), QStringLiteral("customOptions"), ui->perfParams);
 
+    auto applyHost = [this]() {
+        // the first host gets validated, the others are recorded on as they are
+        auto hosts = ui->hostComboBox->currentText().split(QLatin1Char(','), Qt::SkipEmptyParts);
+        for (auto& host : hosts) {
+            host = host.trimmed();
+        }
+        hosts.removeAll(QString());
+        m_recordHost->setHost(hosts.isEmpty() ? QStringLiteral("localhost") : hosts.takeFirst());
+        m_additionalHosts = hosts;
+    };
+    connect(ui->hostComboBox->lineEdit(), &QLineEdit::editingFinished, this, applyHost);
+    connect(ui->hostComboBox, qOverload<int>(&QComboBox::activated), this, applyHost);
+    connect(m_recordHost, &RecordHost::hostChanged, this, [this]() {
+        const bool isRemote = !m_recordHost->isLocal();
+        ui->remoteParsingLabel->setVisible(isRemote);
+        ui->remoteParsingCheckBox->setVisible(isRemote);
+        // the host resets the application, so validate it again on the new host
+        m_recordHost->setClientApplication(ui->applicationName->text());
+    });
+    ui->remoteParsingLabel->setVisible(false);
+    ui->remoteParsingCheckBox->setVisible(false);
+    applyHost();
+
     // set application in RecordHost if it was restored
     m_recordHost->setClientApplication(ui->applicationName->text());
 
     ui->elevatePrivilegesCheckBox->setChecked(config().readEntry(QStringLiteral("elevatePrivileges"), false));
     ui->offCpuCheckBox->setChecked(config().readEntry(QStringLiteral("offCpuProfiling"), false));
+    ui->offCpuBpfCheckBox->setChecked(config().readEntry(QStringLiteral("offCpuBpfProfiling"), false));
+    ui->offCpuBpfCheckBox->setEnabled(ui->offCpuCheckBox->isChecked());
+    ui->lockContentionCheckBox->setChecked(config().readEntry(QStringLiteral("lockContention"), false));
+    ui->liveAnalysisCheckBox->setChecked(config().readEntry(QStringLiteral("liveAnalysis"), false));
+    ui->remoteParsingCheckBox->setChecked(config().readEntry(QStringLiteral("remoteParsing"), false));
+    ui->flightRecorderCheckBox->setChecked(config().readEntry(QStringLiteral("flightRecorder"), false));
+    connect(ui->statCheckBox, &QCheckBox::toggled, ui->statIntervalSpinBox, &QWidget::setEnabled);
+    ui->statCheckBox->setChecked(config().readEntry(QStringLiteral("stat"), false));
+    ui->statIntervalSpinBox->setEnabled(ui->statCheckBox->isChecked());
+    ui->statIntervalSpinBox->setValue(config().readEntry(QStringLiteral("statInterval"), 1000));
+    ui->recordingTriggerComboBox->setCurrentIndex(config().readEntry(QStringLiteral("recordingTrigger"), 0));
+    updateRecordingTrigger();
+    ui->recordingTriggerValueSpinBox->setValue(config().readEntry(QStringLiteral("recordingTriggerValue"), 10));
     ui->sampleCpuCheckBox->setChecked(config().readEntry(QStringLiteral("sampleCpu"), true));
     ui->mmapPagesSpinBox->setValue(config().readEntry(QStringLiteral("mmapPages"), 16));
     ui->mmapPagesUnitComboBox->setCurrentIndex(config().readEntry(QStringLiteral("mmapPagesUnit"), 2));
@@ -459,6 +675,28 @@ RecordPage::RecordPage(QWidget* parent)
                 ui->useAioCheckBox->setChecked(config().readEntry(QStringLiteral("useAio"), capabilities.canUseAio));
             });
 
+    ui->recordingPresetComboBox->addItem(tr("Custom"));
+    ui->recordingPresetComboBox->addItem(tr("Default"));
+    ui->recordingPresetComboBox->addItem(tr("High Event Rate"));
+    ui->recordingPresetComboBox->addItem(tr("Many Cores"));
+    // the preset only reflects the individual settings, which are remembered on their own
+    auto updateThroughputPreset = [this]() {
+        ui->recordingPresetComboBox->setCurrentIndex(matchingThroughputPreset(ui) + 1);
+    };
+    connect(ui->recordingPresetComboBox, qOverload<int>(&QComboBox::activated), this,
+            [this, updateThroughputPreset](int index) {
+                if (index > 0) {
+                    applyThroughputPreset(ui, throughputPresets[index - 1]);
+                }
+                updateThroughputPreset();
+            });
+    connect(ui->compressionComboBox, qOverload<int>(&QComboBox::currentIndexChanged), this, updateThroughputPreset);
+    connect(ui->useAioCheckBox, &QCheckBox::toggled, this, updateThroughputPreset);
+    connect(ui->mmapPagesSpinBox, qOverload<int>(&QSpinBox::valueChanged), this, updateThroughputPreset);
+    connect(ui->mmapPagesUnitComboBox, qOverload<int>(&QComboBox::currentIndexChanged), this, updateThroughputPreset);
+    connect(ui->threadsComboBox, qOverload<int>(&QComboBox::currentIndexChanged), this, updateThroughputPreset);
+    updateThroughputPreset();
+
     const auto callGraph = config().readEntry("callGraph", ui->callGraphComboBox->currentData());
     const auto callGraphIdx = ui->callGraphComboBox->findData(callGraph);
     if (callGraphIdx != -1) {
@@ -470,6 +708,7 @@ RecordPage::RecordPage(QWidget* parent)
         // round to the nearest second
         const auto roundedElapsed = std::round(double(m_recordTimer.nsecsElapsed()) / 1E9) * 1E9;
         ui->startRecordingButton->setText(tr("Stop Recording (%1)").arg(Util::formatTimeString(roundedElapsed, true)));
+        updatePerfOverhead();
     });
 
     auto* stopRecordingShortcut = new QShortcut(tr("Escape"), this);
@@ -494,6 +733,29 @@ RecordPage::RecordPage(QWidget* parent)
 
 RecordPage::~RecordPage() = default;
 
+void RecordPage::showEvent(QShowEvent* event)
+{
+    perfOutput();
+    QWidget::showEvent(event);
+}
+
+PerfOutputWidget* RecordPage::perfOutput()
+{
+    // loading the konsole part is slow, so only do it once the record page gets used
+    if (!m_perfOutput) {
+        m_perfOutput = PerfOutputWidgetKonsole::create(this);
+        if (!m_perfOutput) {
+            m_perfOutput = new PerfOutputWidgetText(this);
+        }
+        m_perfOutput->setInputVisible(selectedRecordType(ui) == RecordType::LaunchApplication);
+        ui->recordOutputBoxLayout->addWidget(m_perfOutput);
+
+        connect(m_perfOutput, &PerfOutputWidget::sendInput, this,
+                [this](const QByteArray& input) { m_perfRecord->sendInput(input); });
+    }
+    return m_perfOutput;
+}
+
 void RecordPage::showRecordPage()
 {
     m_resultsFile.clear();
@@ -509,12 +771,13 @@ void RecordPage::onStartRecordingButtonClicked(bool checked)
         showRecordPage();
         m_watcher->cancel();
         ui->recordTypeComboBox->setEnabled(false);
+        ui->hostComboBox->setEnabled(false);
         ui->launchAppBox->setEnabled(false);
         ui->attachAppBox->setEnabled(false);
         ui->perfOptionsBox->setEnabled(false);
         ui->startRecordingButton->setIcon(QIcon::fromTheme(QStringLiteral("media-playback-stop")));
         ui->startRecordingButton->setText(tr("Stop Recording"));
-        m_perfOutput->clear();
+        perfOutput()->clear();
         ui->applicationRecordWarningMessage->hide();
 
         auto perfCapabilities = m_recordHost->perfCapabilities();
@@ -543,18 +806,36 @@ void RecordPage::onStartRecordingButtonClicked(bool checked)
         perfOptions += KShell::splitArgs(customOptions);
 
         const bool offCpuProfilingEnabled = ui->offCpuCheckBox->isChecked();
+        const bool lockContentionEnabled = ui->lockContentionCheckBox->isChecked();
+        if ((offCpuProfilingEnabled || lockContentionEnabled) && perfCapabilities.canSwitchEvents
+            && eventType.isEmpty()) {
+            // the tracepoints replace the default event
+            // TODO: use clock event in VM context
+            perfOptions += QStringLiteral("--event");
+            perfOptions += QStringLiteral("cycles");
+        }
         if (offCpuProfilingEnabled && perfCapabilities.canSwitchEvents) {
-            if (eventType.isEmpty()) {
-                // TODO: use clock event in VM context
-                perfOptions += QStringLiteral("--event");
-                perfOptions += QStringLiteral("cycles");
+            if (ui->offCpuBpfCheckBox->isChecked() && perfCapabilities.canProfileOffCpuWithBpf) {
+                perfOptions += PerfRecord::offCpuBpfProfilingOptions();
+            } else {
+                perfOptions += PerfRecord::offCpuProfilingOptions();
             }
-            perfOptions += PerfRecord::offCpuProfilingOptions();
+        }
+        if (lockContentionEnabled && perfCapabilities.canSwitchEvents) {
+            perfOptions += PerfRecord::lockContentionOptions();
         }
         config().writeEntry(QStringLiteral("offCpuProfiling"), offCpuProfilingEnabled);
+        config().writeEntry(QStringLiteral("offCpuBpfProfiling"), ui->offCpuBpfCheckBox->isChecked());
+        config().writeEntry(QStringLiteral("lockContention"), lockContentionEnabled);
+
+        // perf doesn't support the asynchronous writing along with the parallel one
+        const auto threads = ui->threadsComboBox->currentData().toString();
+        const bool useThreads = perfCapabilities.canUseThreads && !threads.isEmpty();
+        m_perfRecord->setThreads(useThreads ? threads : QString());
+        config().writeEntry(QStringLiteral("threads"), threads);
 
         const bool useAioEnabled = ui->useAioCheckBox->isChecked();
-        if (useAioEnabled && perfCapabilities.canUseAio) {
+        if (useAioEnabled && perfCapabilities.canUseAio && !useThreads) {
             perfOptions += QStringLiteral("--aio");
         }
         config().writeEntry(QStringLiteral("useAio"), useAioEnabled);
@@ -568,6 +849,35 @@ void RecordPage::onStartRecordingButtonClicked(bool checked)
         }
         config().writeEntry(QStringLiteral("compressionLevel"), compressionLevel);
 
+        if (!m_recordHost->isLocal() || !m_additionalHosts.isEmpty()) {
+            rememberCombobox(config(), QStringLiteral("hosts"), ui->hostComboBox->currentText().trimmed(),
+                             ui->hostComboBox);
+        }
+        // perf stat only writes the counts as text, which can't be parsed remotely, analyzed live or buffered
+        const bool statEnabled = ui->statCheckBox->isChecked();
+        const auto statInterval = statEnabled ? ui->statIntervalSpinBox->value() : 0;
+        config().writeEntry(QStringLiteral("stat"), statEnabled);
+        config().writeEntry(QStringLiteral("statInterval"), ui->statIntervalSpinBox->value());
+        m_perfRecord->setStatInterval(statInterval);
+
+        const bool remoteParsingEnabled =
+            !m_recordHost->isLocal() && ui->remoteParsingCheckBox->isChecked() && !statEnabled;
+        config().writeEntry(QStringLiteral("remoteParsing"), ui->remoteParsingCheckBox->isChecked());
+        m_perfRecord->setRemoteParsing(remoteParsingEnabled);
+
+        const bool flightRecorderEnabled = ui->flightRecorderCheckBox->isChecked();
+        config().writeEntry(QStringLiteral("flightRecorder"), flightRecorderEnabled);
+        m_perfRecord->setFlightRecorder(flightRecorderEnabled && !statEnabled);
+
+        config().writeEntry(QStringLiteral("recordingTrigger"), ui->recordingTriggerComboBox->currentIndex());
+        config().writeEntry(QStringLiteral("recordingTriggerValue"), ui->recordingTriggerValueSpinBox->value());
+        m_perfRecord->setRecordingTrigger(selectedRecordingTrigger(ui), recordingTriggerValue(ui));
+
+        // the live analysis needs the raw perf data
+        const bool liveAnalysisEnabled =
+            ui->liveAnalysisCheckBox->isChecked() && !remoteParsingEnabled && !flightRecorderEnabled && !statEnabled;
+        config().writeEntry(QStringLiteral("liveAnalysis"), ui->liveAnalysisCheckBox->isChecked());
+
         const bool elevatePrivileges = ui->elevatePrivilegesCheckBox->isChecked();
 
         const bool sampleCpuEnabled = ui->sampleCpuCheckBox->isChecked();
@@ -575,7 +885,8 @@ void RecordPage::onStartRecordingButtonClicked(bool checked)
             perfOptions += QStringLiteral("--sample-cpu");
         }
 
-        if (recordType != RecordType::ProfileSystem) { // always true when recording full system
+        // always true when recording full system
+        if (recordType != RecordType::ProfileSystem && recordType != RecordType::ProfileCgroup) {
             config().writeEntry(QStringLiteral("elevatePrivileges"), elevatePrivileges);
             config().writeEntry(QStringLiteral("sampleCpu"), sampleCpuEnabled);
         }
@@ -610,7 +921,17 @@ void RecordPage::onStartRecordingButtonClicked(bool checked)
         config().writeEntry(QStringLiteral("mmapPages"), mmapPages);
         config().writeEntry(QStringLiteral("mmapPagesUnit"), mmapPagesUnit);
 
+        if (statEnabled) {
+            // perf stat counts its own events, none of the options for the sampling apply to it
+            perfOptions = PerfRecord::statOptions();
+        }
+
         const auto outputFile = m_recordHost->outputFileName();
+        m_perfRecord->setStreamOutput(liveAnalysisEnabled);
+        m_liveRecordingFile = liveAnalysisEnabled ? outputFile : QString();
+
+        // start the other hosts right before the first one, so that all of them record the same time frame
+        startAdditionalRecordings(recordType, perfOptions, ui->remoteParsingCheckBox->isChecked() && !statEnabled);
 
         switch (recordType) {
         case RecordType::LaunchApplication: {
@@ -643,6 +964,10 @@ void RecordPage::onStartRecordingButtonClicked(bool checked)
             m_perfRecord->recordSystem(perfOptions, outputFile);
             break;
         }
+        case RecordType::ProfileCgroup: {
+            m_perfRecord->recordCgroup(perfOptions, outputFile, m_recordHost->cgroup());
+            break;
+        }
         case RecordType::NUM_RECORD_TYPES:
             break;
         }
@@ -651,34 +976,112 @@ void RecordPage::onStartRecordingButtonClicked(bool checked)
     }
 }
 
+void RecordPage::startAdditionalRecordings(RecordType recordType, const QStringList& perfOptions,
+                                           bool remoteParsing)
+{
+    for (auto* perfRecord : std::as_const(m_additionalRecordings)) {
+        // also deletes the record host owning it
+        delete perfRecord->parent();
+    }
+    m_additionalRecordings.clear();
+    m_additionalResultsFiles.clear();
+
+    for (const auto& hostName : std::as_const(m_additionalHosts)) {
+        auto* host = new RecordHost(this);
+        host->setHost(hostName);
+        auto* perfRecord = new PerfRecord(host, host);
+        perfRecord->setRemoteParsing(remoteParsing && !host->isLocal());
+        perfRecord->setRecordingTrigger(selectedRecordingTrigger(ui), recordingTriggerValue(ui));
+        perfRecord->setStatInterval(ui->statCheckBox->isChecked() ? ui->statIntervalSpinBox->value() : 0);
+        m_additionalRecordings.append(perfRecord);
+
+        connect(perfRecord, &PerfRecord::recordingOutput, this, &RecordPage::appendOutput);
+        connect(perfRecord, &PerfRecord::recordingFinished, this, [this, hostName](const QString& fileLocation) {
+            appendOutput(tr("\nrecording on %1 finished").arg(hostName));
+            m_additionalResultsFiles.append(fileLocation);
+        });
+        connect(perfRecord, &PerfRecord::recordingFailed, this, [this, hostName](const QString& errorMessage) {
+            appendOutput(tr("\nrecording on %1 failed: %2").arg(hostName, errorMessage));
+        });
+
+        // every host gets its own output file, e.g. perf.data.user_node2
+        auto fileSuffix = hostName;
+        fileSuffix.replace(QRegularExpression(QStringLiteral("[^\\w.-]")), QStringLiteral("_"));
+        const auto outputFile = m_recordHost->outputFileName() + QLatin1Char('.') + fileSuffix;
+
+        switch (recordType) {
+        case RecordType::LaunchApplication: {
+            auto workingDir = m_recordHost->currentWorkingDirectory();
+            if (workingDir.isEmpty()) {
+                workingDir = ui->workingDirectory->placeholderText();
+            }
+            perfRecord->record(perfOptions, outputFile, false, m_recordHost->clientApplication(),
+                               KShell::splitArgs(ui->applicationParametersBox->text()), workingDir);
+            break;
+        }
+        case RecordType::AttachToProcess:
+            // the selected processes only exist on the first host
+            appendOutput(tr("\nattaching is only supported on the first host, not recording on %1").arg(hostName));
+            break;
+        case RecordType::ProfileCgroup:
+            // the cgroups got discovered from the processes of the first host
+            appendOutput(tr("\nrecording a cgroup is only supported on the first host, not recording on %1")
+                             .arg(hostName));
+            break;
+        case RecordType::ProfileSystem:
+            perfRecord->recordSystem(perfOptions, outputFile);
+            break;
+        case RecordType::NUM_RECORD_TYPES:
+            break;
+        }
+    }
+}
+
 void RecordPage::recordingStopped()
 {
+    // the other hosts stop together with the first one
+    for (auto* perfRecord : std::as_const(m_additionalRecordings)) {
+        perfRecord->stopRecording();
+    }
     m_updateRuntimeTimer->stop();
     m_recordTimer.invalidate();
+    if (!m_liveRecordingFile.isEmpty()) {
+        m_liveRecordingFile.clear();
+        emit liveRecordingFinished();
+    }
+    ui->takeSnapshotButton->setEnabled(false);
     ui->startRecordingButton->setChecked(false);
     ui->startRecordingButton->setIcon(QIcon::fromTheme(QStringLiteral("media-playback-start")));
     ui->startRecordingButton->setText(tr("Start Recording"));
 
     ui->recordTypeComboBox->setEnabled(true);
+    ui->hostComboBox->setEnabled(true);
     ui->launchAppBox->setEnabled(true);
     ui->attachAppBox->setEnabled(true);
     ui->perfOptionsBox->setEnabled(true);
-    m_perfOutput->enableInput(false);
+    if (m_perfOutput) {
+        m_perfOutput->enableInput(false);
+    }
 }
 
 void RecordPage::stopRecording()
 {
     m_perfRecord->stopRecording();
+    for (auto* perfRecord : std::as_const(m_additionalRecordings)) {
+        perfRecord->stopRecording();
+    }
 }
 
 void RecordPage::updateProcesses()
 {
-    m_watcher->setFuture(QtConcurrent::run(processList));
+    m_watcher->setFuture(QtConcurrent::run([cache = m_processListCache]() { return processList(cache.get()); }));
 }
 
 void RecordPage::updateProcessesFinished()
 {
-    if (ui->startRecordingButton->isChecked() || selectedRecordType(ui) != RecordType::AttachToProcess) {
+    const auto recordType = selectedRecordType(ui);
+    if (ui->startRecordingButton->isChecked()
+        || (recordType != RecordType::AttachToProcess && recordType != RecordType::ProfileCgroup)) {
         return;
     }
 
@@ -686,9 +1089,29 @@ void RecordPage::updateProcessesFinished()
     QTimer::singleShot(1000, this, &RecordPage::updateProcesses);
 }
 
+void RecordPage::updatePerfOverhead()
+{
+    const auto cpuTime = m_perfRecord->perfCpuTime();
+    const auto elapsed = m_recordTimer.nsecsElapsed();
+    if (cpuTime >= 0 && m_lastPerfCpuTime >= 0 && elapsed > m_lastOverheadCheck) {
+        const auto usage = 100. * (cpuTime - m_lastPerfCpuTime) / (elapsed - m_lastOverheadCheck);
+        ui->perfOverheadLabel->setText(tr("perf CPU usage: %1%").arg(usage, 0, 'f', 1));
+        // perf cannot change the frequency of a running recording, so only suggest it for the next one
+        if (usage > maxPerfCpuUsage && ui->applicationRecordWarningMessage->isHidden()) {
+            ui->applicationRecordWarningMessage->setText(
+                tr("perf uses %1% of a CPU, which may slow down the profiled application. Consider lowering the "
+                   "sampling frequency, e.g. with -F in the advanced options.")
+                    .arg(usage, 0, 'f', 1));
+            ui->applicationRecordWarningMessage->show();
+        }
+    }
+    m_lastPerfCpuTime = cpuTime;
+    m_lastOverheadCheck = elapsed;
+}
+
 void RecordPage::appendOutput(const QString& text)
 {
-    m_perfOutput->addOutput(text);
+    perfOutput()->addOutput(text);
 }
 
 void RecordPage::setError(const QString& message)
@@ -703,12 +1126,16 @@ void RecordPage::updateRecordType()
 
     const auto recordType = selectedRecordType(ui);
     ui->launchAppBox->setVisible(recordType == RecordType::LaunchApplication);
-    ui->attachAppBox->setVisible(recordType == RecordType::AttachToProcess);
+    const bool selectsProcesses = recordType == RecordType::AttachToProcess || recordType == RecordType::ProfileCgroup;
+    ui->attachAppBox->setVisible(selectsProcesses);
+    m_processProxyModel->setShowContainers(recordType == RecordType::ProfileCgroup);
 
-    m_perfOutput->setInputVisible(recordType == RecordType::LaunchApplication);
-    m_perfOutput->clear();
+    if (m_perfOutput) {
+        m_perfOutput->setInputVisible(recordType == RecordType::LaunchApplication);
+        m_perfOutput->clear();
+    }
 
-    if (recordType == RecordType::AttachToProcess) {
+    if (selectsProcesses) {
         updateProcesses();
     }
 }
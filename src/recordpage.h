@@ -44,34 +44,62 @@ public:
     void showRecordPage();
     void stopRecording();
 
+protected:
+    void showEvent(QShowEvent* event) override;
+
 signals:
     void homeButtonClicked();
     void openFile(QString filePath);
 
+    // only emitted for recordings with live analysis
+    void liveRecordingStarted(const QString& filePath);
+    void liveDataAvailable(const QByteArray& data);
+    void liveRecordingFinished();
+    void showLiveResults();
+
+    // e.g. a snapshot of a flight recording that is still running, or the recordings of additional hosts
+    void openFileInNewWindow(const QString& filePath);
+
 private:
     void onStartRecordingButtonClicked(bool checked);
     void updateProcesses();
     void updateProcessesFinished();
+    void updatePerfOverhead();
+    // records on the hosts after the first one, each into its own file
+    void startAdditionalRecordings(RecordType recordType, const QStringList& perfOptions, bool remoteParsing);
 
     void recordingStopped();
     void updateRecordType();
     void appendOutput(const QString& text);
     void setError(const QString& message);
+    // creates the output widget on first use
+    PerfOutputWidget* perfOutput();
 
     std::unique_ptr<Ui::RecordPage> ui;
 
     RecordHost* m_recordHost;
     PerfRecord* m_perfRecord;
     QString m_resultsFile;
+    // the output file of the running recording with live analysis, empty otherwise
+    QString m_liveRecordingFile;
     QElapsedTimer m_recordTimer;
     QTimer* m_updateRuntimeTimer;
+    // the CPU time of perf and the recording time when the overhead got measured last
+    qint64 m_lastPerfCpuTime = -1;
+    qint64 m_lastOverheadCheck = 0;
     KParts::ReadOnlyPart* m_konsolePart = nullptr;
     QTemporaryFile* m_konsoleFile = nullptr;
     MultiConfigWidget* m_multiConfig;
-    PerfOutputWidget* m_perfOutput;
+    PerfOutputWidget* m_perfOutput = nullptr;
 
     ProcessModel* m_processModel;
     ProcessFilterModel* m_processProxyModel;
 
     QFutureWatcher<ProcDataList>* m_watcher;
+    // the host combobox takes a comma separated list, the hosts after the first one are recorded at the same time
+    QStringList m_additionalHosts;
+    QVector<PerfRecord*> m_additionalRecordings;
+    QStringList m_additionalResultsFiles;
+    // shared with the enumeration, which can outlive the page
+    std::shared_ptr<ProcessListCache> m_processListCache;
 };
@@ -17,7 +17,9 @@
 
 #include "parsers/perf/perfparser.h"
 #include "resultsutil.h"
+#include "symboltimeseriesplot.h"
 
+#include "models/symboltimeseries.h"
 #include "models/treemodel.h"
 
 namespace {
@@ -65,6 +67,20 @@ ResultsBottomUpPage::ResultsBottomUpPage(FilterAndZoomStack* filterStack, PerfPa
     ResultsUtil::setupCostDelegate(bottomUpCostModel, ui->bottomUpTreeView);
     ResultsUtil::setupContextMenu(ui->bottomUpTreeView, contextMenu, bottomUpCostModel, filterStack, this);
 
+    auto timeSeries = new SymbolTimeSeriesCache(this);
+    auto timeSeriesPlot = new SymbolTimeSeriesPlot(this);
+    ui->bottomUpVerticalLayout->addWidget(timeSeriesPlot);
+    ResultsUtil::setupTimeSeries(bottomUpCostModel, ui->bottomUpTreeView, timeSeries, timeSeriesPlot);
+    connect(parser, &PerfParser::eventsAvailable, timeSeries, &SymbolTimeSeriesCache::setEvents);
+    connect(parser, &PerfParser::stackIndexAvailable, timeSeries, &SymbolTimeSeriesCache::setStackIndex);
+
+    ui->bottomUpTreeView->setTreeWriter([bottomUpCostModel]() -> CopyableTreeView::TreeWriter {
+        return [results = bottomUpCostModel->results()](QTextStream* stream, TreeExport::Format format,
+                                                        const TreeExport::Progress& progress) {
+            return TreeExport::write(stream, format, results, progress);
+        };
+    });
+
     connect(
         parser, &PerfParser::bottomUpDataAvailable, this,
         [this, bottomUpCostModel, exportMenu](const Data::BottomUpResults& data) {
@@ -94,6 +110,13 @@ ResultsBottomUpPage::ResultsBottomUpPage(FilterAndZoomStack* filterStack, PerfPa
             }
         });
 
+    connect(parser, &PerfParser::comparisonDataAvailable, this,
+            [this, bottomUpCostModel](const Data::ComparisonResults& data) {
+                bottomUpCostModel->setData(data.bottomUp);
+                ResultsUtil::hideEmptyColumns(data.bottomUp.costs, ui->bottomUpTreeView,
+                                              BottomUpModel::NUM_BASE_COLUMNS);
+            });
+
     ResultsUtil::setupResultsAggregation(ui->costAggregationComboBox);
 }
 
@@ -18,12 +18,14 @@
 #include "costcontextmenu.h"
 #include "parsers/perf/perfparser.h"
 #include "resultsutil.h"
+#include "symboltimeseriesplot.h"
 
 #include "models/callercalleemodel.h"
 #include "models/callercalleeproxy.h"
 #include "models/disassemblyoutput.h"
 #include "models/filterandzoomstack.h"
 #include "models/hashmodel.h"
+#include "models/symboltimeseries.h"
 #include "models/treemodel.h"
 
 #include <QPushButton>
@@ -93,7 +95,14 @@ ResultsCallerCalleePage::ResultsCallerCalleePage(FilterAndZoomStack* filterStack
     ResultsUtil::setupHeaderView(ui->callerCalleeTableView, contextMenu);
     ResultsUtil::setupCostDelegate(m_callerCalleeCostModel, ui->callerCalleeTableView);
 
-    connect(parser, &PerfParser::callerCalleeDataAvailable, this, [this](const Data::CallerCalleeResults& data) {
+    auto timeSeries = new SymbolTimeSeriesCache(this);
+    auto timeSeriesPlot = new SymbolTimeSeriesPlot(this);
+    ui->callerCalleeLayout->addWidget(timeSeriesPlot);
+    ResultsUtil::setupTimeSeries(m_callerCalleeCostModel, ui->callerCalleeTableView, timeSeries, timeSeriesPlot);
+    connect(parser, &PerfParser::eventsAvailable, timeSeries, &SymbolTimeSeriesCache::setEvents);
+    connect(parser, &PerfParser::stackIndexAvailable, timeSeries, &SymbolTimeSeriesCache::setStackIndex);
+
+    auto setData = [this](const Data::CallerCalleeResults& data) {
         m_callerCalleeCostModel->setResults(data);
         ResultsUtil::hideEmptyColumns(data.inclusiveCosts, ui->callerCalleeTableView,
                                       CallerCalleeModel::NUM_BASE_COLUMNS);
@@ -113,7 +122,10 @@ ResultsCallerCalleePage::ResultsCallerCalleePage(FilterAndZoomStack* filterStack
             m_callgraph->setResults(data);
         }
 #endif
-    });
+    };
+    connect(parser, &PerfParser::callerCalleeDataAvailable, this, setData);
+    connect(parser, &PerfParser::comparisonDataAvailable, this,
+            [setData](const Data::ComparisonResults& data) { setData(data.callerCallee); });
 
 #if KGraphViewerPart_FOUND
     m_callgraph = CallgraphWidget::createCallgraphWidget({}, this);
@@ -291,6 +303,6 @@ void ResultsCallerCalleePage::openEditor(const Data::Symbol& symbol)
 
     if (it == map.keyEnd()) {
         emit navigateToCodeFailed(
-            tr("Failed to find location for symbol %1 in %2.").arg(symbol.prettySymbol, symbol.binary));
+            tr("Failed to find location for symbol %1 in %2.").arg(symbol.prettySymbol(), symbol.binary));
     }
 }
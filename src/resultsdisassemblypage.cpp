@@ -18,18 +18,22 @@
 #include <QMenu>
 #include <QMessageBox>
 #include <QPainter>
+#include <QPointer>
 #include <QProcess>
 #include <QStandardItemModel>
 #include <QStandardPaths>
 #include <QString>
 #include <QTemporaryFile>
 #include <QTextStream>
+#include <QTimer>
 #include <QVarLengthArray>
 
 #include <KColorScheme>
 #include <KStandardAction>
 
+#include "jobscheduler.h"
 #include "resultsutil.h"
+#include "selfprofiler.h"
 
 #if KFSyntaxHighlighting_FOUND
 #include <KSyntaxHighlighting/definition.h>
@@ -219,14 +223,9 @@ private:
 ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu, QWidget* parent)
     : QWidget(parent)
     , ui(std::make_unique<Ui::ResultsDisassemblyPage>())
-#if KFSyntaxHighlighting_FOUND
-    , m_repository(std::make_unique<KSyntaxHighlighting::Repository>())
-    , m_disassemblyModel(new DisassemblyModel(m_repository.get(), this))
-    , m_sourceCodeModel(new SourceCodeModel(m_repository.get(), this))
-#else
+    // loading the syntax definitions takes a while, so the repository only gets created once it is needed
     , m_disassemblyModel(new DisassemblyModel(nullptr, this))
     , m_sourceCodeModel(new SourceCodeModel(nullptr, this))
-#endif
     , m_disassemblyCostDelegate(new CostDelegate(DisassemblyModel::CostRole, DisassemblyModel::TotalCostRole, this))
     , m_sourceCodeCostDelegate(new CostDelegate(SourceCodeModel::CostRole, SourceCodeModel::TotalCostRole, this))
     , m_disassemblyDelegate(new CodeDelegate(DisassemblyModel::RainbowLineNumberRole, DisassemblyModel::HighlightRole,
@@ -234,6 +233,8 @@ ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu,
     , m_sourceCodeDelegate(new CodeDelegate(SourceCodeModel::RainbowLineNumberRole, SourceCodeModel::HighlightRole,
                                             SourceCodeModel::SyntaxHighlightRole, this))
     , m_branchesDelegate(new BranchDelegate(this))
+    , m_prefetchTimer(new QTimer(this))
+    , m_prefetchState(std::make_shared<PrefetchState>())
 {
     // TODO: the auto resize behavior is broken with these models that don't have the stretch column on the left
     auto setCostHeader = [this, costContextMenu](QTreeView* view) {
@@ -257,6 +258,16 @@ ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu,
 
     connect(settings, &Settings::sysrootChanged, m_sourceCodeModel, &SourceCodeModel::setSysroot);
 
+    connect(ui->showWholeFile, &QCheckBox::toggled, this, [this](bool showWholeFile) {
+        m_sourceCodeModel->setShowWholeFile(showWholeFile);
+        showDisassembly();
+    });
+    connect(m_sourceCodeModel, &SourceCodeModel::sourceCodeLoaded, this, [this]() {
+        if (m_sourceCodeModel->showWholeFile()) {
+            ui->sourceCodeView->scrollTo(m_sourceCodeModel->firstSymbolLineIndex(), QAbstractItemView::PositionAtTop);
+        }
+    });
+
     auto updateFromDisassembly = [this](const QModelIndex& index) {
         const auto fileLine = m_disassemblyModel->fileLineForIndex(index);
         m_disassemblyModel->updateHighlighting(fileLine.line);
@@ -271,6 +282,24 @@ ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu,
 
     connect(settings, &Settings::sourceCodePathsChanged, this, [this](const QString&) { showDisassembly(); });
 
+    // index the search paths for the binaries in the background, see findBinaryForSymbol
+    // both lists get passed every time, as the indices of the paths missing in them get dropped
+    auto indexSearchPaths = [settings]() {
+        const auto paths = settings->debugPaths() + QLatin1Char(':') + settings->extraLibPaths();
+        JobScheduler::run(JobScheduler::Priority::Background,
+                          [paths]() { DisassemblyOutput::indexSearchPaths(paths.split(QLatin1Char(':'))); });
+    };
+    connect(settings, &Settings::debugPathsChanged, this, indexSearchPaths);
+    connect(settings, &Settings::extraLibPathsChanged, this, indexSearchPaths);
+    indexSearchPaths();
+    // other binaries may be found now
+    connect(settings, &Settings::debugPathsChanged, this, &ResultsDisassemblyPage::resetPrefetch);
+    connect(settings, &Settings::extraLibPathsChanged, this, &ResultsDisassemblyPage::resetPrefetch);
+
+    m_prefetchTimer->setSingleShot(true);
+    m_prefetchTimer->setInterval(500);
+    connect(m_prefetchTimer, &QTimer::timeout, this, &ResultsDisassemblyPage::prefetchDisassembly);
+
     connect(ui->assemblyView, &QTreeView::entered, this, updateFromDisassembly);
     connect(ui->sourceCodeView, &QTreeView::entered, this, updateFromSource);
 
@@ -310,7 +339,40 @@ ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu,
         }
     });
 
-    createContextMenu(ui->assemblyView, m_disassemblyModel, [](auto&&, auto&&) {});
+    createContextMenu(ui->assemblyView, m_disassemblyModel, [this](QMenu* menu, const QModelIndex& index) {
+        const auto hottestLoop = m_disassemblyModel->hottestLoop(0);
+        if (hottestLoop != -1) {
+            auto* hottestLoopAction = menu->addAction(tr("Go to Hottest Loop"));
+            QObject::connect(hottestLoopAction, &QAction::triggered, this,
+                             [this, hottestLoop]() { goToLoop(hottestLoop); });
+        }
+
+        const auto loop = index.isValid() ? m_disassemblyModel->controlFlow().loopForRow(index.row()) : -1;
+        if (loop != -1) {
+            const auto isCollapsed = m_collapsedLoops.contains(loop);
+            auto* collapseAction = menu->addAction(isCollapsed ? tr("Expand Loop") : tr("Collapse Loop"));
+            QObject::connect(collapseAction, &QAction::triggered, this, [this, loop, isCollapsed]() {
+                if (isCollapsed) {
+                    m_collapsedLoops.remove(loop);
+                } else {
+                    m_collapsedLoops.insert(loop);
+                }
+                updateCollapsedLoops();
+            });
+        }
+
+        if (!m_collapsedLoops.isEmpty()) {
+            auto* expandAllAction = menu->addAction(tr("Expand All Loops"));
+            QObject::connect(expandAllAction, &QAction::triggered, this, [this]() {
+                m_collapsedLoops.clear();
+                updateCollapsedLoops();
+            });
+        }
+
+        if (!menu->isEmpty()) {
+            menu->addSeparator();
+        }
+    });
 
     auto addScrollTo = [](QTreeView* sourceView, QTreeView* destView, auto sourceModel, auto destModel) {
         connect(sourceView, &QTreeView::clicked, sourceView, [=](const QModelIndex& index) {
@@ -343,6 +405,10 @@ ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu,
                 m_symbolStack.push_back(*symbol);
                 m_stackIndex++;
                 emit stackChanged();
+            } else if (const auto function = findFunction(functionName); function.isValid()) {
+                m_symbolStack.push_back(function);
+                m_stackIndex++;
+                emit stackChanged();
             } else {
                 ui->symbolNotFound->setText(tr("unknown symbol %1").arg(functionName));
                 ui->symbolNotFound->show();
@@ -370,7 +436,7 @@ ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu,
         ui->stackBackButton->setEnabled(m_stackIndex > 0);
         ui->stackNextButton->setEnabled(m_stackIndex < m_symbolStack.size() - 1);
 
-        ui->stackEntry->setText(m_symbolStack[m_stackIndex].prettySymbol);
+        ui->stackEntry->setText(m_symbolStack[m_stackIndex].prettySymbol());
 
         showDisassembly();
     });
@@ -396,12 +462,12 @@ ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu,
         view->addAction(findAction);
 
         auto searchNext = [model, edit, additionalRows, searchResultIndex] {
-            const auto offset = searchResultIndex->isValid() ? searchResultIndex->row() - additionalRows : 0;
+            const auto offset = searchResultIndex->isValid() ? searchResultIndex->row() - additionalRows : -1;
             model->find(edit->text(), Direction::Forward, offset);
         };
 
         auto searchPrev = [model, edit, additionalRows, searchResultIndex] {
-            const auto offset = searchResultIndex->isValid() ? searchResultIndex->row() - additionalRows : 0;
+            const auto offset = searchResultIndex->isValid() ? searchResultIndex->row() - additionalRows : -1;
 
             model->find(edit->text(), Direction::Backward, offset);
         };
@@ -457,7 +523,61 @@ ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu,
         ui->assemblyView->setColumnHidden(DisassemblyModel::HexdumpColumn, !showHexdump);
     });
 
+#if !KFSyntaxHighlighting_FOUND
+    ui->customSourceCodeHighlighting->setVisible(false);
+    ui->customAssemblyHighlighting->setVisible(false);
+#endif
+}
+
+ResultsDisassemblyPage::~ResultsDisassemblyPage() = default;
+
+void ResultsDisassemblyPage::clear()
+{
+    m_disassemblyModel->clear();
+    m_sourceCodeModel->clear();
+    m_collapsedLoops.clear();
+}
+
+void ResultsDisassemblyPage::setupAsmViewModel()
+{
+
+    ui->sourceCodeView->setItemDelegateForColumn(SourceCodeModel::SourceCodeColumn, m_sourceCodeDelegate);
+    ui->sourceCodeView->header()->setStretchLastSection(false);
+    ui->sourceCodeView->header()->setSectionResizeMode(SourceCodeModel::SourceCodeLineNumber,
+                                                       QHeaderView::ResizeToContents);
+    ui->sourceCodeView->header()->setSectionResizeMode(SourceCodeModel::SourceCodeColumn, QHeaderView::Stretch);
+
+    ui->assemblyView->setItemDelegateForColumn(DisassemblyModel::BranchColumn, m_branchesDelegate);
+    ui->assemblyView->setItemDelegateForColumn(DisassemblyModel::DisassemblyColumn, m_disassemblyDelegate);
+    ui->assemblyView->header()->setStretchLastSection(false);
+    ui->assemblyView->header()->setSectionResizeMode(DisassemblyModel::AddrColumn, QHeaderView::ResizeToContents);
+    ui->assemblyView->header()->setSectionResizeMode(DisassemblyModel::BranchColumn, QHeaderView::Interactive);
+    ui->assemblyView->header()->setSectionResizeMode(DisassemblyModel::HexdumpColumn, QHeaderView::Interactive);
+    ui->assemblyView->header()->setSectionResizeMode(DisassemblyModel::DisassemblyColumn, QHeaderView::Stretch);
+
+    for (int col = DisassemblyModel::COLUMN_COUNT; col < m_disassemblyModel->columnCount(); col++) {
+        ui->assemblyView->setColumnWidth(col, 100);
+        ui->assemblyView->header()->setSectionResizeMode(col, QHeaderView::Interactive);
+        ui->assemblyView->setItemDelegateForColumn(col, m_disassemblyCostDelegate);
+    }
+
+    for (int col = SourceCodeModel::COLUMN_COUNT; col < m_sourceCodeModel->columnCount(); col++) {
+        ui->sourceCodeView->setColumnWidth(col, 100);
+        ui->sourceCodeView->header()->setSectionResizeMode(col, QHeaderView::Interactive);
+        ui->sourceCodeView->setItemDelegateForColumn(col, m_sourceCodeCostDelegate);
+    }
+}
+
+void ResultsDisassemblyPage::setupHighlighting()
+{
 #if KFSyntaxHighlighting_FOUND
+    if (m_repository) {
+        return;
+    }
+    m_repository = std::make_unique<KSyntaxHighlighting::Repository>();
+    m_disassemblyModel->highlightedText()->setRepository(m_repository.get());
+    m_sourceCodeModel->highlightedText()->setRepository(m_repository.get());
+
     QStringList schemes;
 
     auto definitions = m_repository->definitions();
@@ -503,88 +623,214 @@ ResultsDisassemblyPage::ResultsDisassemblyPage(CostContextMenu* costContextMenu,
 
     connect(m_disassemblyModel->highlightedText(), &HighlightedText::usesAnsiChanged, this,
             [this](bool usesAnsi) { ui->customAssemblyHighlighting->setVisible(!usesAnsi); });
-#else
-    ui->customSourceCodeHighlighting->setVisible(false);
-    ui->customAssemblyHighlighting->setVisible(false);
 #endif
 }
 
-ResultsDisassemblyPage::~ResultsDisassemblyPage() = default;
+void ResultsDisassemblyPage::showDisassembly()
+{
+    if (m_symbolStack.isEmpty())
+        return;
 
-void ResultsDisassemblyPage::clear()
+    const auto& curSymbol = m_symbolStack[m_stackIndex];
+
+    // Show empty tab when selected symbol is not valid
+    if (curSymbol.symbol.isEmpty()) {
+        clear();
+    }
+
+    ui->symbolNotFound->hide();
+
+    showDisassembly(disassemble(curSymbol));
+}
+
+QString ResultsDisassemblyPage::objdump() const
 {
-    m_disassemblyModel->clear();
-    m_sourceCodeModel->clear();
+    // TODO: add the ability to configure the arch <-> objdump mapping somehow in the settings
+    if (!m_objdump.isEmpty())
+        return m_objdump;
+
+    if (m_arch.startsWith(QLatin1String("armv8")) || m_arch.startsWith(QLatin1String("aarch64"))) {
+        return QStringLiteral("aarch64-linux-gnu-objdump");
+    }
+    const auto isArm = m_arch.startsWith(QLatin1String("arm"));
+    return isArm ? QStringLiteral("arm-linux-gnueabi-objdump") : QStringLiteral("objdump");
 }
 
-void ResultsDisassemblyPage::setupAsmViewModel()
+std::function<DisassemblyOutput(const Data::Symbol&)> ResultsDisassemblyPage::disassembler() const
 {
+    auto settings = Settings::instance();
+    const auto colon = QLatin1Char(':');
 
-    ui->sourceCodeView->setItemDelegateForColumn(SourceCodeModel::SourceCodeColumn, m_sourceCodeDelegate);
-    ui->sourceCodeView->header()->setStretchLastSection(false);
-    ui->sourceCodeView->header()->setSectionResizeMode(SourceCodeModel::SourceCodeLineNumber,
-                                                       QHeaderView::ResizeToContents);
-    ui->sourceCodeView->header()->setSectionResizeMode(SourceCodeModel::SourceCodeColumn, QHeaderView::Stretch);
+    // capture everything by value, so that this can be used from a background thread
+    return [objdump = objdump(), arch = m_arch, debugPaths = settings->debugPaths().split(colon),
+            extraLibPaths = settings->extraLibPaths().split(colon),
+            sourceCodePaths = settings->sourceCodePaths().split(colon), sysroot = settings->sysroot(),
+            builtinDisassembler = settings->builtinDisassembler()](const Data::Symbol& symbol) {
+        ScopedPhase phase("disassemble");
+        return DisassemblyOutput::disassemble(objdump, arch, debugPaths, extraLibPaths, sourceCodePaths, sysroot,
+                                              symbol, builtinDisassembler);
+    };
+}
 
-    ui->assemblyView->setItemDelegateForColumn(DisassemblyModel::BranchColumn, m_branchesDelegate);
-    ui->assemblyView->setItemDelegateForColumn(DisassemblyModel::DisassemblyColumn, m_disassemblyDelegate);
-    ui->assemblyView->header()->setStretchLastSection(false);
-    ui->assemblyView->header()->setSectionResizeMode(DisassemblyModel::AddrColumn, QHeaderView::ResizeToContents);
-    ui->assemblyView->header()->setSectionResizeMode(DisassemblyModel::BranchColumn, QHeaderView::Interactive);
-    ui->assemblyView->header()->setSectionResizeMode(DisassemblyModel::HexdumpColumn, QHeaderView::Interactive);
-    ui->assemblyView->header()->setSectionResizeMode(DisassemblyModel::DisassemblyColumn, QHeaderView::Stretch);
+DisassemblyOutput ResultsDisassemblyPage::disassemble(const Data::Symbol& symbol) const
+{
+    return disassembler()(symbol);
+}
 
-    for (int col = DisassemblyModel::COLUMN_COUNT; col < m_disassemblyModel->columnCount(); col++) {
-        ui->assemblyView->setColumnWidth(col, 100);
-        ui->assemblyView->header()->setSectionResizeMode(col, QHeaderView::Interactive);
-        ui->assemblyView->setItemDelegateForColumn(col, m_disassemblyCostDelegate);
+void ResultsDisassemblyPage::prefetchDisassembly()
+{
+    cancelPrefetch();
+    const auto jobId = m_prefetchJobId.load();
+    if (!m_callerCalleeResults.selfCosts.numTypes()) {
+        return;
     }
 
-    for (int col = SourceCodeModel::COLUMN_COUNT; col < m_sourceCodeModel->columnCount(); col++) {
-        ui->sourceCodeView->setColumnWidth(col, 100);
-        ui->sourceCodeView->header()->setSectionResizeMode(col, QHeaderView::Interactive);
-        ui->sourceCodeView->setItemDelegateForColumn(col, m_sourceCodeCostDelegate);
+    // the symbols with the highest self cost are the ones that get looked at
+    QVector<QPair<qint64, Data::Symbol>> candidates;
+    for (auto it = m_callerCalleeResults.entries.cbegin(), end = m_callerCalleeResults.entries.cend(); it != end;
+         ++it) {
+        const auto& symbol = it.key();
+        if (symbol.symbol.isEmpty() || symbol.isKernel || symbol.isInline || !symbol.relAddr || !symbol.size) {
+            continue;
+        }
+        const auto cost = m_callerCalleeResults.selfCosts.cost(0, it->id);
+        if (cost > 0) {
+            candidates.push_back({cost, symbol});
+        }
     }
+
+    const auto numSymbols = std::min(static_cast<int>(candidates.size()), PrefetchedSymbols);
+    std::partial_sort(candidates.begin(), candidates.begin() + numSymbols, candidates.end(),
+                      [](const QPair<qint64, Data::Symbol>& lhs, const QPair<qint64, Data::Symbol>& rhs) {
+                          return lhs.first > rhs.first;
+                      });
+    candidates.resize(numSymbols);
+    if (candidates.isEmpty()) {
+        return;
+    }
+
+    // the results end up in the disassembly cache, see DisassemblyOutput::disassemble
+    const auto smartThis = QPointer<ResultsDisassemblyPage>(this);
+    auto jobCancelled = [smartThis, jobId, currentJobId = &m_prefetchJobId]() {
+        return !smartThis || jobId != (*currentJobId);
+    };
+    JobScheduler::run(JobScheduler::Priority::Background,
+                      [candidates, jobCancelled, state = m_prefetchState, disassemble = disassembler()]() {
+                          for (const auto& candidate : candidates) {
+                              if (jobCancelled()) {
+                                  return;
+                              }
+                              // skip the symbols that are cached already or getting disassembled by a previous job
+                              {
+                                  QMutexLocker lock(&state->mutex);
+                                  if (state->symbols.contains(candidate.second)) {
+                                      continue;
+                                  }
+                                  state->symbols.insert(candidate.second);
+                              }
+                              disassemble(candidate.second);
+                          }
+                      });
 }
 
-void ResultsDisassemblyPage::showDisassembly()
+void ResultsDisassemblyPage::loadLocationMaps(const Data::Symbol& symbol)
 {
-    if (m_symbolStack.isEmpty())
+    const auto jobId = ++m_locationMapsJobId;
+    const auto smartThis = QPointer<ResultsDisassemblyPage>(this);
+    JobScheduler::run(JobScheduler::Priority::Interactive, [smartThis, jobId, symbol,
+                                                            results = m_callerCalleeResults]() {
+        // the second map comes from the cache of the location index, unless that got disabled
+        const auto sourceMap = results.sourceMap(symbol);
+        const auto offsetMap = results.offsetMap(symbol);
+        QMetaObject::invokeMethod(
+            smartThis.data(),
+            [smartThis, jobId, sourceMap, offsetMap]() {
+                if (smartThis && jobId == smartThis->m_locationMapsJobId) {
+                    smartThis->m_disassemblyModel->setOffsetMap(offsetMap);
+                    smartThis->m_sourceCodeModel->setSourceMap(sourceMap);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void ResultsDisassemblyPage::cancelPrefetch()
+{
+    ++m_prefetchJobId;
+}
+
+void ResultsDisassemblyPage::resetPrefetch()
+{
+    cancelPrefetch();
+    m_prefetchState = std::make_shared<PrefetchState>();
+}
+
+void ResultsDisassemblyPage::disassembleBinary(const Data::Symbol& symbol)
+{
+    auto settings = Settings::instance();
+    if (!settings->disassembleWholeBinaries() || symbol.isKernel || !symbol.canDisassemble()) {
         return;
+    }
 
-    const auto& curSymbol = m_symbolStack[m_stackIndex];
+    // this is a no-op when the binary got disassembled already
+    const auto colon = QLatin1Char(':');
+    JobScheduler::run(
+        JobScheduler::Priority::Background,
+        [objdump = objdump(), debugPaths = settings->debugPaths().split(colon),
+         extraLibPaths = settings->extraLibPaths().split(colon), symbol]() {
+            DisassemblyOutput::disassembleBinary(objdump, debugPaths, extraLibPaths, symbol);
+        });
+}
 
-    // Show empty tab when selected symbol is not valid
-    if (curSymbol.symbol.isEmpty()) {
-        clear();
+Data::Symbol ResultsDisassemblyPage::findFunction(const QString& name) const
+{
+    auto settings = Settings::instance();
+    if (!settings->disassembleWholeBinaries() || m_symbolStack.isEmpty()) {
+        return {};
     }
 
-    // TODO: add the ability to configure the arch <-> objdump mapping somehow in the settings
-    const auto objdump = [this]() {
-        if (!m_objdump.isEmpty())
-            return m_objdump;
+    const auto colon = QLatin1Char(':');
+    return DisassemblyOutput::findFunction(objdump(), settings->debugPaths().split(colon),
+                                           settings->extraLibPaths().split(colon), m_symbolStack[m_stackIndex], name);
+}
 
-        if (m_arch.startsWith(QLatin1String("armv8")) || m_arch.startsWith(QLatin1String("aarch64"))) {
-            return QStringLiteral("aarch64-linux-gnu-objdump");
+void ResultsDisassemblyPage::updateCollapsedLoops()
+{
+    const auto& controlFlow = m_disassemblyModel->controlFlow();
+    for (int row = 0, c = m_disassemblyModel->rowCount(); row < c; ++row) {
+        bool isHidden = false;
+        for (auto loop = controlFlow.loopForRow(row); loop != -1 && !isHidden;
+             loop = controlFlow.loops.at(loop).parent) {
+            isHidden = m_collapsedLoops.contains(loop) && row != controlFlow.loops.at(loop).firstRow;
         }
-        const auto isArm = m_arch.startsWith(QLatin1String("arm"));
-        return isArm ? QStringLiteral("arm-linux-gnueabi-objdump") : QStringLiteral("objdump");
-    };
+        ui->assemblyView->setRowHidden(row, {}, isHidden);
+    }
+}
 
-    ui->symbolNotFound->hide();
+void ResultsDisassemblyPage::goToLoop(int loop)
+{
+    const auto& controlFlow = m_disassemblyModel->controlFlow();
+    const auto& range = controlFlow.loops.at(loop);
 
-    auto settings = Settings::instance();
-    const auto colon = QLatin1Char(':');
+    // the first row of the loop is always shown, unless an enclosing loop is collapsed
+    for (auto parent = range.parent; parent != -1; parent = controlFlow.loops.at(parent).parent) {
+        m_collapsedLoops.remove(parent);
+    }
+    updateCollapsedLoops();
 
-    showDisassembly(DisassemblyOutput::disassemble(
-        objdump(), m_arch, settings->debugPaths().split(colon), settings->extraLibPaths().split(colon),
-        settings->sourceCodePaths().split(colon), settings->sysroot(), curSymbol));
+    const auto index = m_disassemblyModel->index(range.firstRow, DisassemblyModel::DisassemblyColumn);
+    ui->assemblyView->setCurrentIndex(index);
+    ui->assemblyView->scrollTo(index, QAbstractItemView::PositionAtTop);
 }
 
 void ResultsDisassemblyPage::showDisassembly(const DisassemblyOutput& disassemblyOutput)
 {
+    // the costs of the previous symbol are not needed anymore
+    ++m_locationMapsJobId;
     m_disassemblyModel->clear();
     m_sourceCodeModel->clear();
+    // resetting the model shows all rows again
+    m_collapsedLoops.clear();
 
     // this function is only called if m_symbolStack is non empty (see above)
     Q_ASSERT(!m_symbolStack.isEmpty());
@@ -605,8 +851,19 @@ void ResultsDisassemblyPage::showDisassembly(const DisassemblyOutput& disassembl
 
     ui->errorMessage->hide();
 
-    m_disassemblyModel->setDisassembly(disassemblyOutput, m_callerCalleeResults);
-    m_sourceCodeModel->setDisassembly(disassemblyOutput, m_callerCalleeResults);
+    setupHighlighting();
+    if (m_callerCalleeResults.hasLocationMaps(disassemblyOutput.symbol)) {
+        m_disassemblyModel->setDisassembly(disassemblyOutput, m_callerCalleeResults);
+        m_sourceCodeModel->setDisassembly(disassemblyOutput, m_callerCalleeResults);
+    } else {
+        // computing the costs goes through all samples, so the code gets shown right away and the costs follow
+        m_disassemblyModel->setDisassembly(disassemblyOutput, m_callerCalleeResults, {});
+        m_sourceCodeModel->setDisassembly(disassemblyOutput, m_callerCalleeResults, {});
+        loadLocationMaps(disassemblyOutput.symbol);
+    }
+
+    // the other symbols of the binary will then be shown without running objdump again
+    disassembleBinary(curSymbol);
 
 #if KFSyntaxHighlighting_FOUND
     m_sourceCodeModel->highlightedText()->setDefinition(
@@ -644,16 +901,23 @@ void ResultsDisassemblyPage::setSymbol(const Data::Symbol& symbol)
 void ResultsDisassemblyPage::setCostsMap(const Data::CallerCalleeResults& callerCalleeResults)
 {
     m_callerCalleeResults = callerCalleeResults;
+    // the costs getting computed belong to the previous results
+    ++m_locationMapsJobId;
+    // the previous costs are outdated, so are the symbols their prefetch picked
+    cancelPrefetch();
+    m_prefetchTimer->start();
 }
 
 void ResultsDisassemblyPage::setObjdump(const QString& objdump)
 {
     m_objdump = objdump;
+    resetPrefetch();
 }
 
 void ResultsDisassemblyPage::setArch(const QString& arch)
 {
     m_arch = arch.trimmed().toLower();
+    resetPrefetch();
 }
 
 void ResultsDisassemblyPage::changeEvent(QEvent* event)
@@ -672,4 +936,13 @@ void ResultsDisassemblyPage::jumpToSourceLine(const Data::FileLine& line)
     }
 }
 
+void ResultsDisassemblyPage::jumpToAddress(quint64 addr)
+{
+    const auto index = m_disassemblyModel->indexForAddress(addr);
+    if (index.isValid()) {
+        ui->assemblyView->scrollTo(index, QAbstractItemView::PositionAtCenter);
+        ui->assemblyView->setCurrentIndex(index);
+    }
+}
+
 #include "resultsdisassemblypage.moc"
@@ -12,11 +12,16 @@
 #include "hotspot-config.h"
 #include "models/costdelegate.h"
 
+#include <QMutex>
+#include <QSet>
 #include <QWidget>
 
+#include <atomic>
+#include <functional>
 #include <memory>
 
 class QStyledItemDelegate;
+class QTimer;
 
 namespace Ui {
 class ResultsDisassemblyPage;
@@ -53,6 +58,10 @@ public:
     void setArch(const QString& arch);
 
     void jumpToSourceLine(const Data::FileLine& line);
+    void jumpToAddress(quint64 addr);
+
+    // disassembles a symbol with the current settings, the returned function is safe to call from any thread
+    std::function<DisassemblyOutput(const Data::Symbol&)> disassembler() const;
 
 signals:
     void jumpToCallerCallee(const Data::Symbol& symbol);
@@ -64,8 +73,27 @@ protected:
 
 private:
     void setupAsmViewModel();
+    // creates the syntax highlighting repository, delayed until the first disassembly since loading it is slow
+    void setupHighlighting();
     void showDisassembly(const DisassemblyOutput& disassemblyOutput);
     void showDisassembly();
+    QString objdump() const;
+    DisassemblyOutput disassemble(const Data::Symbol& symbol) const;
+    // fills the disassembly cache with the hottest symbols in the background
+    void prefetchDisassembly();
+    // stops the running prefetch after its current symbol
+    void cancelPrefetch();
+    // forgets which symbols got prefetched, for when the settings of the disassembler change
+    void resetPrefetch();
+    // fills in the costs of @p symbol once its source and offset maps got computed in the background
+    void loadLocationMaps(const Data::Symbol& symbol);
+    // disassembles the binary of @p symbol in the background when whole binaries should be disassembled
+    void disassembleBinary(const Data::Symbol& symbol);
+    // a function without samples in the binary of the current symbol, see DisassemblyOutput::findFunction
+    Data::Symbol findFunction(const QString& name) const;
+    // hides the rows of the collapsed loops, except for their first row
+    void updateCollapsedLoops();
+    void goToLoop(int loop);
 
     std::unique_ptr<Ui::ResultsDisassemblyPage> ui;
 #if KFSyntaxHighlighting_FOUND
@@ -91,4 +119,22 @@ private:
 
     QVector<Data::Symbol> m_symbolStack;
     int m_stackIndex = 0;
+
+    // indices into the loops of DisassemblyModel::controlFlow()
+    QSet<int> m_collapsedLoops;
+
+    // the number of symbols that get disassembled ahead of time
+    static constexpr int PrefetchedSymbols = 20;
+    std::atomic<uint> m_prefetchJobId {0};
+    // only accessed on the GUI thread, see loadLocationMaps
+    uint m_locationMapsJobId = 0;
+    // the prefetch only starts once the costs stopped changing for a while, e.g. during live profiling
+    QTimer* m_prefetchTimer;
+    // the symbols that got prefetched or are getting prefetched right now, shared with the prefetch jobs
+    struct PrefetchState
+    {
+        QMutex mutex;
+        QSet<Data::Symbol> symbols;
+    };
+    std::shared_ptr<PrefetchState> m_prefetchState;
 };
@@ -12,6 +12,7 @@
 #include "parsers/perf/perfparser.h"
 
 #include <QAction>
+#include <QDir>
 #include <QFileDialog>
 #include <QImageWriter>
 #include <QMenu>
@@ -70,6 +71,11 @@ ResultsFlameGraphPage::ResultsFlameGraphPage(FilterAndZoomStack* filterStack, Pe
 
     connect(parser, &PerfParser::topDownDataAvailable, this,
             [this](const Data::TopDownResults& data) { ui->flameGraph->setTopDownData(data); });
+    connect(parser, &PerfParser::eventsAvailable, this,
+            [this](const Data::EventResults& data) { ui->flameGraph->setEvents(data); });
+
+    connect(ui->flameGraph, &FlameGraph::compareRequested, this, &ResultsFlameGraphPage::loadBaseline);
+    connect(ui->flameGraph, &FlameGraph::compareCancelled, this, &ResultsFlameGraphPage::cancelBaseline);
 
     connect(ui->flameGraph, &FlameGraph::jumpToCallerCallee, this, &ResultsFlameGraphPage::jumpToCallerCallee);
     connect(ui->flameGraph, &FlameGraph::openEditor, this, &ResultsFlameGraphPage::openEditor);
@@ -80,14 +86,75 @@ ResultsFlameGraphPage::ResultsFlameGraphPage(FilterAndZoomStack* filterStack, Pe
 
 ResultsFlameGraphPage::~ResultsFlameGraphPage() = default;
 
+void ResultsFlameGraphPage::loadBaseline()
+{
+    if (m_baselineParserBusy) {
+        // the parser is still busy with the previous baseline
+        ui->flameGraph->clearBaseline();
+        return;
+    }
+
+    const auto filter = tr("Hotspot data Files (perf*.data perf.data.* *.perfparser);;"
+                           "Linux Perf Files (perf*.data perf.data.*);;"
+                           "Perfparser Files (*.perfparser);;"
+                           "All Files (*)");
+    const auto fileName = QFileDialog::getOpenFileName(this, tr("Compare With"), QDir::currentPath(), filter);
+    if (fileName.isEmpty()) {
+        ui->flameGraph->clearBaseline();
+        return;
+    }
+
+    // parse the baseline with a parser of its own, this doesn't interfere with the data of the other views
+    if (!m_baselineParser) {
+        m_baselineParser = new PerfParser(this);
+        connect(m_baselineParser, &PerfParser::bottomUpDataAvailable, this, [this](const Data::BottomUpResults& data) {
+            if (m_loadingBaseline) {
+                m_baselineBottomUpData = data;
+            }
+        });
+        connect(m_baselineParser, &PerfParser::topDownDataAvailable, this, [this](const Data::TopDownResults& data) {
+            if (m_loadingBaseline) {
+                m_loadingBaseline = false;
+                ui->flameGraph->setBaseline(m_baselineBottomUpData, data);
+                m_baselineBottomUpData = {};
+            }
+        });
+        connect(m_baselineParser, &PerfParser::parsingFinished, this, [this]() { m_baselineParserBusy = false; });
+        connect(m_baselineParser, &PerfParser::parsingFailed, this, [this](const QString& errorMessage) {
+            m_baselineParserBusy = false;
+            if (m_loadingBaseline) {
+                m_loadingBaseline = false;
+                ui->flameGraph->clearBaseline();
+                QMessageBox::warning(this, tr("Comparison Failed"),
+                                     tr("Failed to load the baseline: %1").arg(errorMessage));
+            }
+        });
+    }
+
+    m_baselineParserBusy = true;
+    m_loadingBaseline = true;
+    m_baselineParser->startParseFile(fileName);
+}
+
+void ResultsFlameGraphPage::cancelBaseline()
+{
+    if (!m_loadingBaseline) {
+        return;
+    }
+    m_loadingBaseline = false;
+    m_baselineBottomUpData = {};
+    m_baselineParser->stop();
+}
+
 void ResultsFlameGraphPage::clear()
 {
     ui->flameGraph->clear();
+    cancelBaseline();
     delete m_exportAction;
     m_exportAction = nullptr;
 }
 
-void ResultsFlameGraphPage::setHoveredStacks(const QVector<QVector<Data::Symbol>>& hoveredStacks)
+void ResultsFlameGraphPage::setHoveredStacks(const QSet<qint32>& stackIds)
 {
-    ui->flameGraph->setHoveredStacks(hoveredStacks);
+    ui->flameGraph->setHoveredStacks(stackIds);
 }
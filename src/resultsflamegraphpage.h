@@ -8,10 +8,13 @@
 
 #pragma once
 
+#include <QSet>
 #include <QWidget>
 
 #include <memory>
 
+#include <models/data.h>
+
 class QMenu;
 class QAction;
 
@@ -19,10 +22,6 @@ namespace Ui {
 class ResultsFlameGraphPage;
 }
 
-namespace Data {
-struct Symbol;
-}
-
 class PerfParser;
 class FilterAndZoomStack;
 
@@ -36,7 +35,7 @@ public:
 
     void clear();
 
-    void setHoveredStacks(const QVector<QVector<Data::Symbol>>& hoveredStacks);
+    void setHoveredStacks(const QSet<qint32>& stackIds);
 
 signals:
     void jumpToCallerCallee(const Data::Symbol& symbol);
@@ -46,6 +45,14 @@ signals:
     void jumpToDisassembly(const Data::Symbol& symbol);
 
 private:
+    void loadBaseline();
+    void cancelBaseline();
+
     std::unique_ptr<Ui::ResultsFlameGraphPage> ui;
     QAction* m_exportAction = nullptr;
+    // parses the baseline capture of the differential flame graph
+    PerfParser* m_baselineParser = nullptr;
+    Data::BottomUpResults m_baselineBottomUpData;
+    bool m_baselineParserBusy = false;
+    bool m_loadingBaseline = false;
 };
@@ -14,6 +14,9 @@
 
 #include "costcontextmenu.h"
 #include "dockwidgetsetup.h"
+#include "flamechart.h"
+#include "jobscheduler.h"
+#include "lockcontentionpage.h"
 #include "resultsbottomuppage.h"
 #include "resultscallercalleepage.h"
 #include "resultsdisassemblypage.h"
@@ -24,6 +27,7 @@
 #include "timelinewidget.h"
 
 #include "models/filterandzoomstack.h"
+#include "models/pgoexport.h"
 
 #include <KLocalizedString>
 
@@ -38,9 +42,13 @@
 #endif // KDDOCKWIDGETS_VERSION < KDDOCKWIDGETS_VERSION_CHECK(2, 0, 0)
 
 #include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileDialog>
 #include <QLabel>
 #include <QMenu>
 #include <QProgressBar>
+#include <QTextStream>
 #include <QTimer>
 
 #include "hotspot-config.h"
@@ -56,6 +64,12 @@ void showDock(DockWidget* dock)
     dock->setAsCurrentTab();
 }
 
+// the ids of the docks and docking areas have to be unique in the whole process
+QString uniqueDockId(const QString& id, int windowId)
+{
+    return windowId == 0 ? id : id + QLatin1Char('-') + QString::number(windowId);
+}
+
 CoreDockWidget* toDockWidget(DockWidget* dock)
 {
 #if KDDOCKWIDGETS_VERSION < KDDOCKWIDGETS_VERSION_CHECK(2, 0, 0)
@@ -66,10 +80,11 @@ CoreDockWidget* toDockWidget(DockWidget* dock)
 }
 }
 
-ResultsPage::ResultsPage(PerfParser* parser, QWidget* parent)
+ResultsPage::ResultsPage(PerfParser* parser, int windowId, QWidget* parent)
     : QWidget(parent)
     , ui(std::make_unique<Ui::ResultsPage>())
-    , m_contents(createDockingArea(QStringLiteral("results"), this))
+    , m_parser(parser)
+    , m_contents(createDockingArea(uniqueDockId(QStringLiteral("results"), windowId), this))
     , m_filterAndZoomStack(new FilterAndZoomStack(this))
     , m_costContextMenu(new CostContextMenu(this))
     , m_filterMenu(new QMenu(this))
@@ -82,6 +97,8 @@ ResultsPage::ResultsPage(PerfParser* parser, QWidget* parent)
     , m_resultsCallerCalleePage(new ResultsCallerCalleePage(m_filterAndZoomStack, parser, m_costContextMenu, this))
     , m_resultsDisassemblyPage(new ResultsDisassemblyPage(m_costContextMenu, this))
     , m_timeLineWidget(new TimeLineWidget(parser, m_filterMenu, m_filterAndZoomStack, this))
+    , m_flameChart(new FlameChart(parser, m_filterAndZoomStack, this))
+    , m_lockContentionPage(new LockContentionPage(m_filterAndZoomStack, parser, m_costContextMenu, this))
 #if QCustomPlot_FOUND
     , m_frequencyPage(new FrequencyPage(parser, this))
 #endif
@@ -105,8 +122,8 @@ ResultsPage::ResultsPage(PerfParser* parser, QWidget* parent)
     ui->errorWidget->hide();
     ui->lostMessage->hide();
 
-    auto dockify = [](QWidget* widget, const QString& id, const QString& title, const QString& shortcut) {
-        auto* dock = new DockWidget(id);
+    auto dockify = [windowId](QWidget* widget, const QString& id, const QString& title, const QString& shortcut) {
+        auto* dock = new DockWidget(uniqueDockId(id, windowId));
         dock->setWidget(widget);
         dock->setTitle(title);
         dock->toggleAction()->setShortcut(shortcut);
@@ -121,6 +138,8 @@ ResultsPage::ResultsPage(PerfParser* parser, QWidget* parent)
     m_summaryPageDock->addDockWidgetAsTab(m_topDownDock);
     m_flameGraphDock = dockify(m_resultsFlameGraphPage, QStringLiteral("flameGraph"), tr("Flame &Graph"), tr("Ctrl+G"));
     m_summaryPageDock->addDockWidgetAsTab(m_flameGraphDock);
+    m_flameChartDock = dockify(m_flameChart, QStringLiteral("flameChart"), tr("Flame C&hart"), tr("Ctrl+H"));
+    m_summaryPageDock->addDockWidgetAsTab(m_flameChartDock);
     m_callerCalleeDock =
         dockify(m_resultsCallerCalleePage, QStringLiteral("callerCallee"), tr("Ca&ller / Callee"), tr("Ctrl+L"));
     m_summaryPageDock->addDockWidgetAsTab(m_callerCalleeDock);
@@ -128,6 +147,8 @@ ResultsPage::ResultsPage(PerfParser* parser, QWidget* parent)
         dockify(m_resultsDisassemblyPage, QStringLiteral("disassembly"), tr("D&isassembly"), tr("Ctrl+I"));
     m_summaryPageDock->addDockWidgetAsTab(m_disassemblyDock, KDDockWidgets::InitialVisibilityOption::StartHidden);
     m_disassemblyDock->toggleAction()->setEnabled(false);
+    m_lockContentionDock = dockify(m_lockContentionPage, QStringLiteral("lockContention"), tr("L&ocks"), tr("Ctrl+J"));
+    m_summaryPageDock->addDockWidgetAsTab(m_lockContentionDock);
     m_summaryPageDock->setAsCurrentTab();
 #if QCustomPlot_FOUND
     m_frequencyDock = dockify(m_frequencyPage, QStringLiteral("frequency"), tr("Fr&equency"), tr("Ctrl+E"));
@@ -139,8 +160,30 @@ ResultsPage::ResultsPage(PerfParser* parser, QWidget* parent)
 
     connect(parser, &PerfParser::callerCalleeDataAvailable, m_resultsDisassemblyPage,
             &ResultsDisassemblyPage::setCostsMap);
+    connect(parser, &PerfParser::callerCalleeDataAvailable, this, [this](const Data::CallerCalleeResults& data) {
+        // the profiles follow the filter, so the menu gets rebuilt for every result
+        delete m_pgoExportMenu;
+        m_pgoExportMenu = m_exportMenu->addMenu(QIcon::fromTheme(QStringLiteral("run-build")),
+                                                tr("Profile Guided Optimization"));
+        m_pgoExportMenu->setToolTip(tr("Export the sampled addresses of every binary for AutoFDO or BOLT."));
+        for (int i = 0, c = data.selfCosts.numTypes(); i < c; ++i) {
+            // off-CPU time and tracepoints say nothing about the hot code
+            if (!data.selfCosts.totalCost(i) || data.selfCosts.unit(i) != Data::Costs::Unit::Unknown) {
+                continue;
+            }
+            const auto costName = data.selfCosts.typeName(i);
+            m_pgoExportMenu->addAction(tr("AutoFDO (%1)").arg(costName), this, [this, data, i]() {
+                exportPgoProfiles(data, PgoExport::Format::AutoFdo, i);
+            });
+            m_pgoExportMenu->addAction(tr("BOLT (%1)").arg(costName), this, [this, data, i]() {
+                exportPgoProfiles(data, PgoExport::Format::Bolt, i);
+            });
+        }
+        m_pgoExportMenu->setEnabled(!m_pgoExportMenu->isEmpty());
+    });
 
     connect(m_filterAndZoomStack, &FilterAndZoomStack::filterChanged, parser, &PerfParser::filterResults);
+    connect(m_filterAndZoomStack, &FilterAndZoomStack::filterHinted, parser, &PerfParser::precomputeFilter);
 
     connect(parser, &PerfParser::summaryDataAvailable, this, [this](const Data::Summary& data) {
         if (data.lostChunks > 0) {
@@ -171,6 +214,8 @@ ResultsPage::ResultsPage(PerfParser* parser, QWidget* parent)
     connect(m_resultsSummaryPage, &ResultsSummaryPage::openEditor, this, &ResultsPage::onOpenEditor);
     connect(m_resultsSummaryPage, &ResultsSummaryPage::selectSymbol, m_timeLineWidget, &TimeLineWidget::selectSymbol);
     connect(m_resultsSummaryPage, &ResultsSummaryPage::jumpToDisassembly, this, &ResultsPage::onJumpToDisassembly);
+    connect(m_resultsSummaryPage, &ResultsSummaryPage::jumpToInstruction, this, &ResultsPage::onJumpToInstruction);
+    m_resultsSummaryPage->setDisassembler([this]() { return m_resultsDisassemblyPage->disassembler(); });
     connect(m_resultsBottomUpPage, &ResultsBottomUpPage::jumpToCallerCallee, this, &ResultsPage::onJumpToCallerCallee);
     connect(m_resultsBottomUpPage, &ResultsBottomUpPage::openEditor, this, &ResultsPage::onOpenEditor);
     connect(m_resultsBottomUpPage, &ResultsBottomUpPage::selectSymbol, m_timeLineWidget, &TimeLineWidget::selectSymbol);
@@ -200,11 +245,14 @@ ResultsPage::ResultsPage(PerfParser* parser, QWidget* parent)
         m_resultsDisassemblyPage->clear();
         m_disassemblyDock->toggleAction()->setEnabled(false);
     });
-    connect(parser, &PerfParser::parsingFinished, this, [this]() {
+    auto enableContents = [this]() {
         // re-enable when we finished filtering
         m_contents->setEnabled(true);
         m_filterBusyIndicator->setVisible(false);
-    });
+    };
+    connect(parser, &PerfParser::parsingFinished, this, enableContents);
+    // the snapshots of partial results can be looked at while parsing continues
+    connect(parser, &PerfParser::partialResultsAvailable, this, enableContents);
 
     connect(parser, &PerfParser::perfMapFileExists, this, [errorWidget = ui->errorWidget](bool exists) {
         if (exists) {
@@ -232,6 +280,10 @@ ResultsPage::ResultsPage(PerfParser* parser, QWidget* parent)
 
     connect(Settings::instance(), &Settings::costAggregationChanged, this,
             [this, parser] { parser->filterResults(m_filterAndZoomStack->filter()); });
+    connect(Settings::instance(), &Settings::correctLostEventsChanged, this,
+            [this, parser] { parser->filterResults(m_filterAndZoomStack->filter()); });
+    connect(Settings::instance(), &Settings::foldInlinesChanged, this,
+            [this, parser] { parser->filterResults(m_filterAndZoomStack->filter()); });
 }
 
 ResultsPage::~ResultsPage() = default;
@@ -266,6 +318,12 @@ void ResultsPage::onJumpToSourceCode(const Data::Symbol& symbol, const Data::Fil
     }
 }
 
+void ResultsPage::onJumpToInstruction(const Data::Symbol& symbol, quint64 addr)
+{
+    onJumpToDisassembly(symbol);
+    m_resultsDisassemblyPage->jumpToAddress(addr);
+}
+
 void ResultsPage::setObjdump(const QString& objdump)
 {
     m_resultsDisassemblyPage->setObjdump(objdump);
@@ -311,7 +369,7 @@ QList<QAction*> ResultsPage::windowActions() const
     {
         m_summaryPageDock->toggleAction(), m_bottomUpDock->toggleAction(), m_topDownDock->toggleAction(),
             m_flameGraphDock->toggleAction(), m_callerCalleeDock->toggleAction(), m_disassemblyDock->toggleAction(),
-            m_timeLineDock->toggleAction(),
+            m_timeLineDock->toggleAction(), m_lockContentionDock->toggleAction(),
 #if QCustomPlot_FOUND
             m_frequencyDock->toggleAction()
 #endif
@@ -340,6 +398,50 @@ void ResultsPage::showError(const QString& message)
     QTimer::singleShot(5000, ui->errorWidget, &KMessageWidget::animatedHide);
 }
 
+void ResultsPage::exportPgoProfiles(const Data::CallerCalleeResults& results, PgoExport::Format format,
+                                    int costType)
+{
+    const auto directory = QFileDialog::getExistingDirectory(this, tr("Export Profiles"), QDir::currentPath());
+    if (directory.isEmpty()) {
+        return;
+    }
+
+    // collecting the costs per address goes through all samples
+    JobScheduler::run(JobScheduler::Priority::Background, [smartThis = QPointer<ResultsPage>(this), results, format,
+                                                           costType, directory]() {
+        const auto event = results.selfCosts.typeName(costType);
+        const auto samplesPerBinary = PgoExport::samplesPerBinary(results, costType);
+        QStringList errors;
+        for (auto it = samplesPerBinary.cbegin(), end = samplesPerBinary.cend(); it != end; ++it) {
+            QFile file(QDir(directory).filePath(PgoExport::fileName(format, it.key())));
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+                errors << tr("Failed to write %1: %2").arg(file.fileName(), file.errorString());
+                continue;
+            }
+            QTextStream stream(&file);
+            PgoExport::write(&stream, format, it.value(), event);
+        }
+        if (samplesPerBinary.isEmpty()) {
+            errors << tr("No binary has samples of type %1.").arg(event);
+        }
+
+        QMetaObject::invokeMethod(
+            smartThis.data(),
+            [smartThis, errors]() {
+                if (smartThis && !errors.isEmpty()) {
+                    smartThis->showError(errors.join(QLatin1Char('\n')));
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void ResultsPage::stopComparison()
+{
+    // the results of the current filter replace the comparison
+    m_parser->filterResults(m_filterAndZoomStack->filter());
+}
+
 void ResultsPage::initDockWidgets(const QVector<CoreDockWidget*>& restored)
 {
     auto summaryPageDock = toDockWidget(m_summaryPageDock);
@@ -350,9 +452,11 @@ void ResultsPage::initDockWidgets(const QVector<CoreDockWidget*>& restored)
         m_bottomUpDock,
         m_topDownDock,
         m_flameGraphDock,
+        m_flameChartDock,
         m_callerCalleeDock,
         m_timeLineDock,
         m_disassemblyDock,
+        m_lockContentionDock,
 #if QCustomPlot_FOUND
         m_frequencyDock
 #endif
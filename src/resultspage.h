@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <QPointer>
 #include <QWidget>
 
 #include <memory>
@@ -24,6 +25,11 @@ class ResultsPage;
 namespace Data {
 struct Symbol;
 struct FileLine;
+struct CallerCalleeResults;
+}
+
+namespace PgoExport {
+enum class Format;
 }
 
 class PerfParser;
@@ -31,18 +37,21 @@ class ResultsSummaryPage;
 class ResultsBottomUpPage;
 class ResultsTopDownPage;
 class ResultsFlameGraphPage;
+class FlameChart;
 class ResultsCallerCalleePage;
 class ResultsDisassemblyPage;
 class FilterAndZoomStack;
 class TimeLineWidget;
 class CostContextMenu;
 class FrequencyPage;
+class LockContentionPage;
 
 class ResultsPage : public QWidget
 {
     Q_OBJECT
 public:
-    explicit ResultsPage(PerfParser* parser, QWidget* parent = nullptr);
+    // the docks of all but the first window of the process get @p windowId appended to their ids to keep them unique
+    explicit ResultsPage(PerfParser* parser, int windowId = 0, QWidget* parent = nullptr);
     ~ResultsPage();
 
     void selectSummaryTab();
@@ -53,6 +62,9 @@ public:
 
     void initDockWidgets(const QVector<CoreDockWidget*>& restored);
 
+    // shows the results of the capture on their own again, see PerfParser::startCompare
+    void stopComparison();
+
 public slots:
     void setSysroot(const QString& path);
     void setAppPath(const QString& path);
@@ -63,6 +75,7 @@ public slots:
     void showError(const QString& message);
     void onJumpToDisassembly(const Data::Symbol& symbol);
     void onJumpToSourceCode(const Data::Symbol& symbol, const Data::FileLine& line);
+    void onJumpToInstruction(const Data::Symbol& symbol, quint64 addr);
 
 signals:
     void navigateToCode(const QString& url, int lineNumber, int columnNumber);
@@ -70,13 +83,17 @@ signals:
 private:
     void resizeEvent(QResizeEvent* event) override;
     void repositionFilterBusyIndicator();
+    // writes the profile of every binary into a directory the user picks, see PgoExport
+    void exportPgoProfiles(const Data::CallerCalleeResults& results, PgoExport::Format format, int costType);
 
     std::unique_ptr<Ui::ResultsPage> ui;
+    PerfParser* m_parser;
     DockMainWindow* m_contents;
     FilterAndZoomStack* m_filterAndZoomStack;
     CostContextMenu* m_costContextMenu;
     QMenu* m_filterMenu;
     QMenu* m_exportMenu;
+    QPointer<QMenu> m_pgoExportMenu;
     DockWidget* m_summaryPageDock;
     ResultsSummaryPage* m_resultsSummaryPage;
     DockWidget* m_bottomUpDock;
@@ -85,12 +102,16 @@ private:
     ResultsTopDownPage* m_resultsTopDownPage;
     DockWidget* m_flameGraphDock;
     ResultsFlameGraphPage* m_resultsFlameGraphPage;
+    DockWidget* m_flameChartDock;
     DockWidget* m_callerCalleeDock;
     ResultsCallerCalleePage* m_resultsCallerCalleePage;
     DockWidget* m_disassemblyDock;
     ResultsDisassemblyPage* m_resultsDisassemblyPage;
     DockWidget* m_timeLineDock;
     TimeLineWidget* m_timeLineWidget;
+    FlameChart* m_flameChart;
+    DockWidget* m_lockContentionDock;
+    LockContentionPage* m_lockContentionPage;
     FrequencyPage* m_frequencyPage = nullptr;
     DockWidget* m_frequencyDock = nullptr;
     QWidget* m_filterBusyIndicator = nullptr;
@@ -9,6 +9,7 @@
 #include "resultssummarypage.h"
 #include "ui_resultssummarypage.h"
 
+#include <QPointer>
 #include <QSortFilterProxyModel>
 #include <QStringListModel>
 #include <QTextStream>
@@ -16,10 +17,19 @@
 #include <KFormat>
 #include <KLocalizedString>
 
+#include <algorithm>
+#include <numeric>
+
+#include "jobscheduler.h"
 #include "parsers/perf/perfparser.h"
 #include "resultsutil.h"
+#include "settings.h"
 #include "util.h"
 
+#include "models/concurrencyprofile.h"
+#include "models/filterandzoomstack.h"
+#include "models/hotpathmodel.h"
+#include "models/topinstructionsmodel.h"
 #include "models/topproxy.h"
 #include "models/treemodel.h"
 
@@ -31,6 +41,8 @@ ResultsSummaryPage::ResultsSummaryPage(FilterAndZoomStack* filterStack, PerfPars
     ui->setupUi(this);
 
     ui->parserErrorsBox->setVisible(false);
+    ui->memoryUsageGroupBox->setVisible(false);
+    ui->concurrencyGroupBox->setVisible(false);
 
     auto bottomUpCostModel = new BottomUpModel(this);
     auto perLibraryModel = new PerLibraryModel(this);
@@ -55,6 +67,14 @@ ResultsSummaryPage::ResultsSummaryPage(FilterAndZoomStack* filterStack, PerfPars
     ResultsUtil::setupHeaderView(ui->topLibraryTreeView, contextMenu);
     ResultsUtil::setupContextMenu(ui->topLibraryTreeView, contextMenu, perLibraryModel, filterStack, this, {});
 
+    // see the truncated stacks below
+    connect(ui->summaryLabel, &QLabel::linkActivated, this, [](const QString& link) {
+        const auto prefix = QLatin1String("stackDumpSize:");
+        if (link.startsWith(prefix)) {
+            Settings::instance()->setStackDumpSize(link.mid(prefix.size()).toInt());
+        }
+    });
+
     connect(ui->eventSourceComboBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this,
             [topHotspotsProxy, this]() {
                 topHotspotsProxy->setCostColumn(ui->eventSourceComboBox->currentData().toInt()
@@ -67,25 +87,118 @@ ResultsSummaryPage::ResultsSummaryPage(FilterAndZoomStack* filterStack, PerfPars
                                                + PerLibraryModel::NUM_BASE_COLUMNS);
             });
 
-    connect(
-        parser, &PerfParser::bottomUpDataAvailable, this, [this, bottomUpCostModel](const Data::BottomUpResults& data) {
-            bottomUpCostModel->setData(data);
-            ResultsUtil::hideEmptyColumns(data.costs, ui->topHotspotsTableView, BottomUpModel::NUM_BASE_COLUMNS);
-            ResultsUtil::hideTracepointColumns(data.costs, ui->topHotspotsTableView, BottomUpModel::NUM_BASE_COLUMNS);
-            ResultsUtil::fillEventSourceComboBox(ui->eventSourceComboBox, data.costs,
-                                                 tr("Show top hotspots for %1 events."));
-        });
+    // the top costs come with the summary, so we don't have to wait for the full bottom up and per library results
+    auto setTopCosts = [this, bottomUpCostModel, perLibraryModel](const Data::TopCosts& data) {
+        const auto& symbols = data.symbols;
+        bottomUpCostModel->setData(symbols);
+        ResultsUtil::hideEmptyColumns(symbols.costs, ui->topHotspotsTableView, BottomUpModel::NUM_BASE_COLUMNS);
+        ResultsUtil::hideTracepointColumns(symbols.costs, ui->topHotspotsTableView, BottomUpModel::NUM_BASE_COLUMNS);
+        ResultsUtil::fillEventSourceComboBox(ui->eventSourceComboBox, symbols.costs,
+                                             tr("Show top hotspots for %1 events."));
 
-    connect(parser, &PerfParser::perLibraryDataAvailable, this,
-            [this, perLibraryModel](const Data::PerLibraryResults& data) {
-                perLibraryModel->setData(data);
-                ResultsUtil::hideEmptyColumns(data.costs, ui->topLibraryTreeView, PerLibraryModel::NUM_BASE_COLUMNS);
-                ResultsUtil::hideTracepointColumns(data.costs, ui->topLibraryTreeView,
-                                                   PerLibraryModel::NUM_BASE_COLUMNS);
+        const auto& libraries = data.libraries;
+        perLibraryModel->setData(libraries);
+        ResultsUtil::hideEmptyColumns(libraries.costs, ui->topLibraryTreeView, PerLibraryModel::NUM_BASE_COLUMNS);
+        ResultsUtil::hideTracepointColumns(libraries.costs, ui->topLibraryTreeView, PerLibraryModel::NUM_BASE_COLUMNS);
+        ResultsUtil::fillEventSourceComboBox(ui->eventSourceComboBox_2, libraries.costs,
+                                             tr("Show top hotspots for %1 events."));
+    };
+    connect(parser, &PerfParser::topCostsAvailable, this, setTopCosts);
+    connect(parser, &PerfParser::summaryDataAvailable, this,
+            [setTopCosts](const Data::Summary& data) { setTopCosts(data.topCosts); });
 
-                ResultsUtil::fillEventSourceComboBox(ui->eventSourceComboBox_2, data.costs,
-                                                     tr("Show top hotspots for %1 events."));
-            });
+    m_topInstructionsModel = new TopInstructionsModel(this);
+    auto topInstructionsProxy = new QSortFilterProxyModel(this);
+    topInstructionsProxy->setSourceModel(m_topInstructionsModel);
+    topInstructionsProxy->setSortRole(TopInstructionsModel::SortRole);
+
+    ui->topInstructionsTreeView->setModel(topInstructionsProxy);
+    ui->topInstructionsTreeView->sortByColumn(TopInstructionsModel::InitialSortColumn, Qt::DescendingOrder);
+    ui->topInstructionsTreeView->setSortingEnabled(true);
+    ResultsUtil::setupCostDelegate<TopInstructionsModel>(m_topInstructionsModel, ui->topInstructionsTreeView);
+    ResultsUtil::setupHeaderView(ui->topInstructionsTreeView, contextMenu);
+    ResultsUtil::setupContextMenu(ui->topInstructionsTreeView, contextMenu, m_topInstructionsModel, filterStack,
+                                  this);
+
+    connect(ui->topInstructionsTreeView, &QTreeView::activated, this, [this](const QModelIndex& index) {
+        emit jumpToInstruction(index.data(TopInstructionsModel::SymbolRole).value<Data::Symbol>(),
+                               index.data(TopInstructionsModel::AddressRole).value<quint64>());
+    });
+
+    connect(ui->eventSourceComboBox_3, qOverload<int>(&QComboBox::currentIndexChanged), this,
+            &ResultsSummaryPage::updateTopInstructions);
+
+    connect(parser, &PerfParser::callerCalleeDataAvailable, this, [this](const Data::CallerCalleeResults& data) {
+        m_callerCalleeResults = data;
+        const QSignalBlocker blocker(ui->eventSourceComboBox_3);
+        ResultsUtil::fillEventSourceComboBox(ui->eventSourceComboBox_3, data.selfCosts,
+                                             tr("Show top instructions for %1 events."));
+        updateTopInstructions();
+    });
+
+    m_hotPathModel = new HotPathModel(this);
+    auto hotPathsProxy = new QSortFilterProxyModel(this);
+    hotPathsProxy->setSourceModel(m_hotPathModel);
+    hotPathsProxy->setSortRole(HotPathModel::SortRole);
+
+    ui->hotPathsTreeView->setModel(hotPathsProxy);
+    ui->hotPathsTreeView->sortByColumn(HotPathModel::InitialSortColumn, Qt::DescendingOrder);
+    ui->hotPathsTreeView->setSortingEnabled(true);
+    // the last frames are the interesting ones
+    ui->hotPathsTreeView->setTextElideMode(Qt::ElideLeft);
+    ResultsUtil::setupCostDelegate<HotPathModel>(m_hotPathModel, ui->hotPathsTreeView);
+    ResultsUtil::setupHeaderView(ui->hotPathsTreeView, contextMenu);
+
+    // the first level of the aggregation is only known by its name, which isn't unique for threads and thus can't be
+    // filtered by, the tooltips of the paths tell so
+    connect(ui->hotPathsTreeView, &QTreeView::activated, this, [filterStack](const QModelIndex& index) {
+        filterStack->filterInBySymbols(index.data(HotPathModel::FramesRole).value<QVector<Data::Symbol>>());
+    });
+
+    connect(ui->eventSourceComboBox_4, qOverload<int>(&QComboBox::currentIndexChanged), this,
+            &ResultsSummaryPage::updateHotPaths);
+
+    connect(parser, &PerfParser::topDownDataAvailable, this, [this](const Data::TopDownResults& data) {
+        m_topDownResults = data;
+        const QSignalBlocker blocker(ui->eventSourceComboBox_4);
+        ResultsUtil::fillEventSourceComboBox(ui->eventSourceComboBox_4, data.selfCosts,
+                                             tr("Show hot paths for %1 events."));
+        updateHotPaths();
+    });
+
+    // the concurrency describes the whole capture, so it gets computed from the unfiltered events the parser keeps
+    // the parser updated them already, filtering leaves them alone, which the threads sharing their data tell
+    connect(parser, &PerfParser::eventsAvailable, this, [this, parser]() {
+        const auto events = parser->eventResults();
+        if (!events.threads.isEmpty() && events.threads.constData() == m_concurrencyThreads.constData()) {
+            return;
+        }
+        m_concurrencyThreads = events.threads;
+        updateConcurrency(events);
+    });
+
+    connect(parser, &PerfParser::memoryUsageAvailable, this, [this](const Data::MemoryUsage& usage) {
+        const auto format = KFormat();
+        auto formatRow = [&format](const QString& description, qint64 bytes) {
+            return QLatin1String("<tr><td>") + description + QLatin1String(": </td><td align=\"right\">")
+                + format.formatByteSize(bytes, 1, KFormat::MetricBinaryDialect) + QLatin1String("</td></tr>");
+        };
+
+        QString text;
+        QTextStream stream(&text);
+        stream << "<qt><table>" << formatRow(tr("Thread Events"), usage.threadEvents)
+               << formatRow(tr("CPU Events"), usage.cpuEvents) << formatRow(tr("Stacks"), usage.stacks)
+               << formatRow(tr("Bottom Up"), usage.bottomUp) << formatRow(tr("Caller/Callee"), usage.callerCallee)
+               << formatRow(tr("Frequency"), usage.frequency) << formatRow(tr("Tracepoints"), usage.tracepoints)
+               << formatRow(QLatin1String("<b>") + tr("Total") + QLatin1String("</b>"), usage.total());
+        const auto budget = Settings::instance()->memoryBudget();
+        if (budget > 0) {
+            stream << formatRow(tr("Budget"), static_cast<qint64>(budget) * 1024 * 1024);
+        }
+        stream << "</table></qt>";
+        ui->memoryUsageLabel->setText(text);
+        ui->memoryUsageGroupBox->setVisible(true);
+    });
 
     auto parserErrorsModel = new QStringListModel(this);
     ui->parserErrorsView->setModel(parserErrorsModel);
@@ -107,6 +220,32 @@ ResultsSummaryPage::ResultsSummaryPage(FilterAndZoomStack* filterStack, PerfPars
             if (data.offCpuTime > 0 || data.onCpuTime > 0) {
                 stream << formatSummaryText(indent + tr("On CPU Time"), Util::formatTimeString(data.onCpuTime))
                        << formatSummaryText(indent + tr("Off CPU Time"), Util::formatTimeString(data.offCpuTime));
+                if (!data.onCpuSlices.isEmpty()) {
+                    stream << formatSummaryText(indent + tr("On CPU Slices"),
+                                                Util::formatDurationHistogram(data.onCpuSlices));
+                }
+                if (!data.offCpuDurations.isEmpty()) {
+                    stream << formatSummaryText(indent + tr("Off CPU Durations"),
+                                                Util::formatDurationHistogram(data.offCpuDurations));
+                }
+            }
+            if (!data.syscallLatencies.isEmpty()) {
+                // the syscalls that took the longest in total
+                auto syscalls = data.syscallLatencies.keys();
+                std::sort(syscalls.begin(), syscalls.end(), [&data](qint64 lhs, qint64 rhs) {
+                    return data.syscallLatencies[lhs].total > data.syscallLatencies[rhs].total;
+                });
+                const auto total = std::accumulate(
+                    data.syscallLatencies.cbegin(), data.syscallLatencies.cend(), quint64(0),
+                    [](quint64 total, const Data::DurationHistogram& latencies) { return total + latencies.total; });
+                stream << formatSummaryText(tr("Syscall Time"), Util::formatTimeString(total));
+                for (const auto id : syscalls.mid(0, NumTopSyscalls)) {
+                    const auto& latencies = data.syscallLatencies[id];
+                    stream << formatSummaryText(indent + tr("Syscall %1").arg(id),
+                                                tr("%1 in total, %2")
+                                                    .arg(Util::formatTimeString(latencies.total),
+                                                         Util::formatDurationHistogram(latencies)));
+                }
             }
             stream << formatSummaryText(tr("Processes"), QString::number(data.processCount))
                    << formatSummaryText(tr("Threads"), QString::number(data.threadCount));
@@ -139,6 +278,40 @@ ResultsSummaryPage::ResultsSummaryPage(FilterAndZoomStack* filterStack, PerfPars
                     stream << formatSummaryText(indent + tr("<b>WARNING</b>"), tr("Sampling frequency below 100Hz"));
                 }
             }
+            if (data.stackDumpSize > 0 && data.userStackCount > 0) {
+                stream << formatSummaryText(
+                    tr("Truncated Stacks"),
+                    tr("%1 (%2% of the user stacks, stack dump size %3 bytes)")
+                        .arg(QString::number(data.truncatedStackCount),
+                             Util::formatCostRelative(data.truncatedStackCount, data.userStackCount),
+                             QString::number(data.stackDumpSize)));
+                if (data.suggestedStackDumpSize > 0) {
+                    const auto size = data.suggestedStackDumpSize;
+                    auto warning = tr("Record with <code>--call-graph dwarf,%1</code>").arg(size);
+                    if (Settings::instance()->stackDumpSize() < static_cast<int>(size)) {
+                        // opening a file shouldn't change how the next one gets recorded unless asked for
+                        warning += QLatin1Char(' ')
+                            + tr("(<a href=\"stackDumpSize:%1\">use it for new recordings</a>)").arg(size);
+                    }
+                    stream << formatSummaryText(indent + tr("<b>WARNING</b>"), warning);
+                }
+            }
+            if (!data.counters.isEmpty()) {
+                const auto numEvents =
+                    std::count_if(data.counters.begin(), data.counters.end(),
+                                  [](const Data::CounterSummary& counter) { return !counter.isMetric; });
+                stream << formatSummaryText(tr("Counters"), tr("%n event(s)", nullptr, static_cast<int>(numEvents)));
+                for (const auto& counter : data.counters) {
+                    auto value = QString::number(counter.value, 'G', 4);
+                    if (!counter.unit.isEmpty()) {
+                        value += QLatin1Char(' ') + counter.unit.toHtmlEscaped();
+                    } else if (!counter.isMetric && data.applicationTime.delta() > 0) {
+                        value = tr("%1 (%2)").arg(value, Util::formatFrequency(static_cast<quint64>(counter.value),
+                                                                               data.applicationTime.delta()));
+                    }
+                    stream << formatSummaryText(indent + counter.name.toHtmlEscaped(), value);
+                }
+            }
             stream << formatSummaryText(tr("Lost Events"), QString::number(data.lostEvents));
             stream << formatSummaryText(tr("Lost Chunks"), QString::number(data.lostChunks));
             stream << "</table></qt>";
@@ -177,3 +350,119 @@ ResultsSummaryPage::ResultsSummaryPage(FilterAndZoomStack* filterStack, PerfPars
 }
 
 ResultsSummaryPage::~ResultsSummaryPage() = default;
+
+void ResultsSummaryPage::setDisassembler(
+    const std::function<std::function<DisassemblyOutput(const Data::Symbol&)>()>& disassembler)
+{
+    m_topInstructionsModel->setDisassembler(disassembler);
+}
+
+void ResultsSummaryPage::updateTopInstructions()
+{
+    const auto jobId = ++m_topInstructionsJobId;
+    const auto type = ui->eventSourceComboBox_3->currentData().toInt();
+
+    const auto smartThis = QPointer<ResultsSummaryPage>(this);
+    JobScheduler::run(
+        JobScheduler::Priority::Normal,
+        [smartThis, jobId, currentJobId = &m_topInstructionsJobId, results = m_callerCalleeResults, type]() {
+            if (!smartThis || jobId != (*currentJobId)) {
+                return;
+            }
+
+            const auto instructions = topInstructions(results, type, NumTopInstructions);
+            QMetaObject::invokeMethod(
+                smartThis.data(),
+                [smartThis, jobId, instructions, selfCosts = results.selfCosts]() {
+                    if (smartThis && jobId == smartThis->m_topInstructionsJobId) {
+                        smartThis->m_topInstructionsModel->setResults(instructions, selfCosts);
+                        ResultsUtil::hideEmptyColumns(selfCosts, smartThis->ui->topInstructionsTreeView,
+                                                      TopInstructionsModel::NUM_BASE_COLUMNS);
+                    }
+                },
+                Qt::QueuedConnection);
+        });
+}
+
+void ResultsSummaryPage::updateHotPaths()
+{
+    const auto jobId = ++m_hotPathsJobId;
+    const auto type = ui->eventSourceComboBox_4->currentData().toInt();
+    // the first level groups the costs by thread or process then, it isn't part of the call paths
+    const auto skipFirstLevel = Settings::instance()->costAggregation() != Settings::CostAggregation::BySymbol;
+
+    const auto smartThis = QPointer<ResultsSummaryPage>(this);
+    JobScheduler::run(
+        JobScheduler::Priority::Normal,
+        [smartThis, jobId, currentJobId = &m_hotPathsJobId, results = m_topDownResults, type, skipFirstLevel]() {
+            if (!smartThis || jobId != (*currentJobId)) {
+                return;
+            }
+
+            const auto paths = hotPaths(results, type, NumHotPaths, skipFirstLevel);
+            QMetaObject::invokeMethod(
+                smartThis.data(),
+                [smartThis, jobId, paths, selfCosts = results.selfCosts]() {
+                    if (smartThis && jobId == smartThis->m_hotPathsJobId) {
+                        smartThis->m_hotPathModel->setResults(paths, selfCosts);
+                        ResultsUtil::hideEmptyColumns(selfCosts, smartThis->ui->hotPathsTreeView,
+                                                      HotPathModel::NUM_BASE_COLUMNS);
+                    }
+                },
+                Qt::QueuedConnection);
+        });
+}
+
+void ResultsSummaryPage::updateConcurrency(const Data::EventResults& events)
+{
+    const auto jobId = ++m_concurrencyJobId;
+    ui->concurrencyGroupBox->setVisible(false);
+
+    const auto smartThis = QPointer<ResultsSummaryPage>(this);
+    JobScheduler::run(JobScheduler::Priority::Normal,
+                      [smartThis, jobId, currentJobId = &m_concurrencyJobId, events]() {
+                          if (!smartThis || jobId != (*currentJobId)) {
+                              return;
+                          }
+
+                          const auto profile = ConcurrencyProfile(events);
+                          QMetaObject::invokeMethod(
+                              smartThis.data(),
+                              [smartThis, jobId, profile]() {
+                                  if (smartThis && jobId == smartThis->m_concurrencyJobId) {
+                                      smartThis->setConcurrency(profile);
+                                  }
+                              },
+                              Qt::QueuedConnection);
+                      });
+}
+
+void ResultsSummaryPage::setConcurrency(const ConcurrencyProfile& profile)
+{
+    if (profile.isEmpty()) {
+        return;
+    }
+
+    auto formatRow = [](const QString& description, const QString& value) {
+        return QLatin1String("<tr><td>") + description + QLatin1String(": </td><td align=\"right\">") + value
+            + QLatin1String("</td></tr>");
+    };
+
+    QString text;
+    QTextStream stream(&text);
+    stream << "<qt><table>"
+           << formatRow(tr("Average"), QString::number(profile.averageRunningThreads(), 'f', 2))
+           << formatRow(tr("Maximum"), QString::number(profile.maxRunningThreads()));
+    const auto& histogram = profile.histogram();
+    const auto total = profile.time().delta();
+    for (int threads = 0, c = histogram.size(); threads < c; ++threads) {
+        if (histogram[threads]) {
+            stream << formatRow(tr("%n thread(s)", nullptr, threads),
+                                tr("%1 (%2%)").arg(Util::formatTimeString(histogram[threads]),
+                                                  Util::formatCostRelative(histogram[threads], total)));
+        }
+    }
+    stream << "</table></qt>";
+    ui->concurrencyLabel->setText(text);
+    ui->concurrencyGroupBox->setVisible(true);
+}
@@ -10,11 +10,13 @@
 
 #include <QWidget>
 
+#include <atomic>
+#include <functional>
 #include <memory>
 
-namespace Data {
-struct Symbol;
-}
+#include "data.h"
+
+struct DisassemblyOutput;
 
 namespace Ui {
 class ResultsSummaryPage;
@@ -23,6 +25,9 @@ class ResultsSummaryPage;
 class PerfParser;
 class FilterAndZoomStack;
 class CostContextMenu;
+class TopInstructionsModel;
+class HotPathModel;
+class ConcurrencyProfile;
 
 class ResultsSummaryPage : public QWidget
 {
@@ -32,12 +37,37 @@ public:
                                 QWidget* parent = nullptr);
     ~ResultsSummaryPage();
 
+    // used to show the text of the top instructions, see TopInstructionsModel::setDisassembler
+    void setDisassembler(const std::function<std::function<DisassemblyOutput(const Data::Symbol&)>()>& disassembler);
+
 signals:
     void jumpToCallerCallee(const Data::Symbol& symbol);
     void openEditor(const Data::Symbol& symbol);
     void selectSymbol(const Data::Symbol& symbol);
     void jumpToDisassembly(const Data::Symbol& symbol);
+    void jumpToInstruction(const Data::Symbol& symbol, quint64 addr);
 
 private:
+    // ranks the instructions by the cost type selected in the event source combo box in the background
+    void updateTopInstructions();
+    // searches the hottest call paths for the cost type selected in their event source combo box in the background
+    void updateHotPaths();
+    // computes how many threads were running from the context switches of the unfiltered threads in the background
+    void updateConcurrency(const Data::EventResults& events);
+    void setConcurrency(const ConcurrencyProfile& profile);
+
     std::unique_ptr<Ui::ResultsSummaryPage> ui;
+    TopInstructionsModel* m_topInstructionsModel;
+    Data::CallerCalleeResults m_callerCalleeResults;
+    std::atomic<uint> m_topInstructionsJobId {0};
+    HotPathModel* m_hotPathModel;
+    Data::TopDownResults m_topDownResults;
+    std::atomic<uint> m_hotPathsJobId {0};
+    std::atomic<uint> m_concurrencyJobId {0};
+    // the threads of the unfiltered events the concurrency got computed from, kept to tell when they change
+    QVector<Data::ThreadEvents> m_concurrencyThreads;
+
+    static constexpr int NumTopInstructions = 100;
+    static constexpr int NumHotPaths = 20;
+    static constexpr int NumTopSyscalls = 10;
 };
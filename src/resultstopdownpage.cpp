@@ -25,30 +25,38 @@ ResultsTopDownPage::ResultsTopDownPage(FilterAndZoomStack* filterStack, PerfPars
     ResultsUtil::setupTreeView(ui->topDownTreeView, contextMenu, ui->topDownSearch, topDownCostModel);
     ResultsUtil::setupCostDelegate(topDownCostModel, ui->topDownTreeView);
     ResultsUtil::setupContextMenu(ui->topDownTreeView, contextMenu, topDownCostModel, filterStack, this);
+    ui->topDownTreeView->setTreeWriter([topDownCostModel]() -> CopyableTreeView::TreeWriter {
+        return [results = topDownCostModel->results()](QTextStream* stream, TreeExport::Format format,
+                                                       const TreeExport::Progress& progress) {
+            return TreeExport::write(stream, format, results, progress);
+        };
+    });
 
-    connect(parser, &PerfParser::topDownDataAvailable, this,
-            [this, topDownCostModel](const Data::TopDownResults& data) {
-                topDownCostModel->setData(data);
-                ResultsUtil::hideEmptyColumns(data.inclusiveCosts, ui->topDownTreeView, TopDownModel::NUM_BASE_COLUMNS);
-
-                ResultsUtil::hideEmptyColumns(data.selfCosts, ui->topDownTreeView,
-                                              TopDownModel::NUM_BASE_COLUMNS + data.inclusiveCosts.numTypes());
-                ResultsUtil::hideTracepointColumns(data.selfCosts, ui->topDownTreeView,
-                                                   TopDownModel::NUM_BASE_COLUMNS + data.inclusiveCosts.numTypes());
-
-                // hide self cost columns for sched:sched_switch and off-CPU
-                // quasi all rows will have a cost of 0%, and only the leaves will show
-                // a non-zero value that is equal to the inclusive cost then
-                const auto costs = data.inclusiveCosts.numTypes();
-                const auto schedSwitchName = QLatin1String("sched:sched_switch");
-                const auto offCpuName = PerfParser::tr("off-CPU Time");
-                for (int i = 0; i < costs; ++i) {
-                    const auto typeName = data.inclusiveCosts.typeName(i);
-                    if (typeName == schedSwitchName || typeName == offCpuName) {
-                        ui->topDownTreeView->hideColumn(topDownCostModel->selfCostColumn(i));
-                    }
-                }
-            });
+    auto setData = [this, topDownCostModel](const Data::TopDownResults& data) {
+        topDownCostModel->setData(data);
+        ResultsUtil::hideEmptyColumns(data.inclusiveCosts, ui->topDownTreeView, TopDownModel::NUM_BASE_COLUMNS);
+
+        ResultsUtil::hideEmptyColumns(data.selfCosts, ui->topDownTreeView,
+                                      TopDownModel::NUM_BASE_COLUMNS + data.inclusiveCosts.numTypes());
+        ResultsUtil::hideTracepointColumns(data.selfCosts, ui->topDownTreeView,
+                                           TopDownModel::NUM_BASE_COLUMNS + data.inclusiveCosts.numTypes());
+
+        // hide self cost columns for sched:sched_switch and off-CPU
+        // quasi all rows will have a cost of 0%, and only the leaves will show
+        // a non-zero value that is equal to the inclusive cost then
+        const auto costs = data.inclusiveCosts.numTypes();
+        const auto schedSwitchName = QLatin1String("sched:sched_switch");
+        const auto offCpuName = PerfParser::tr("off-CPU Time");
+        for (int i = 0; i < costs; ++i) {
+            const auto typeName = data.inclusiveCosts.typeName(i);
+            if (typeName == schedSwitchName || typeName == offCpuName) {
+                ui->topDownTreeView->hideColumn(topDownCostModel->selfCostColumn(i));
+            }
+        }
+    };
+    connect(parser, &PerfParser::topDownDataAvailable, this, setData);
+    connect(parser, &PerfParser::comparisonDataAvailable, this,
+            [setData](const Data::ComparisonResults& data) { setData(data.topDown); });
 
     ResultsUtil::setupResultsAggregation(ui->costAggregationComboBox);
 }
@@ -21,10 +21,13 @@
 #include "models/costdelegate.h"
 #include "models/data.h"
 #include "models/filterandzoomstack.h"
+#include "models/sparklinedelegate.h"
+#include "models/symboltimeseries.h"
 
 #include "costcontextmenu.h"
 #include "costheaderview.h"
 #include "settings.h"
+#include "symboltimeseriesplot.h"
 
 namespace ResultsUtil {
 
@@ -45,7 +48,16 @@ void connectFilter(QLineEdit* filter, QSortFilterProxyModel* proxy)
     proxy->setFilterCaseSensitivity(Qt::CaseInsensitive);
 
     QObject::connect(timer, &QTimer::timeout, proxy, [filter, proxy]() {
-        proxy->setFilterRegularExpression(QRegularExpression::escape(filter->text()));
+        // keep the case sensitivity and other options of the proxy
+        auto pattern = proxy->filterRegularExpression();
+        pattern.setPattern(QRegularExpression::escape(filter->text()));
+
+        // the proxies of the big trees match their symbols in the background and filter once that's done
+        if (auto* search = dynamic_cast<CallerCalleeProxyDetail::SymbolSearch*>(proxy)) {
+            search->search(proxy, pattern, [proxy, pattern]() { proxy->setFilterRegularExpression(pattern); });
+        } else {
+            proxy->setFilterRegularExpression(pattern);
+        }
     });
     QObject::connect(filter, &QLineEdit::textChanged, timer, [timer]() { timer->start(300); });
 }
@@ -131,6 +143,13 @@ void setupContextMenu(QTreeView* view, CostContextMenu* costContextMenu, int sym
             contextMenu.addSeparator();
         }
 
+        // e.g. copying the whole tree, see CopyableTreeView
+        const auto viewActions = view->actions();
+        if (!viewActions.isEmpty()) {
+            contextMenu.addActions(viewActions);
+            contextMenu.addSeparator();
+        }
+
         costContextMenu->addToMenu(view->header(),
                                    contextMenu.addMenu(QCoreApplication::translate("Util", "Visible Columns")));
         contextMenu.addSeparator();
@@ -162,10 +181,43 @@ void setupCostDelegate(QAbstractItemModel* model, QTreeView* view, int sortRole,
                      });
 }
 
+void setupTimeSeries(QAbstractItemModel* model, QTreeView* view, SymbolTimeSeriesCache* timeSeries,
+                     SymbolTimeSeriesPlot* plot, int timeSeriesRole, const std::function<int()>& timeSeriesColumn)
+{
+    auto sparklineDelegate = new SparklineDelegate(timeSeriesRole, view);
+    auto setDelegate = [view, sparklineDelegate, timeSeriesColumn]() {
+        view->setItemDelegateForColumn(timeSeriesColumn(), sparklineDelegate);
+    };
+    setDelegate();
+    // connected after the cost delegate, so this runs after it got set for all the columns
+    QObject::connect(model, &QAbstractItemModel::modelReset, sparklineDelegate, setDelegate);
+
+    auto updatePlot = [view, plot, timeSeriesRole, timeSeriesColumn]() {
+        const auto current = view->currentIndex();
+        if (!current.isValid()) {
+            plot->setSeries({}, {});
+            return;
+        }
+        // this computes the series of the current row, when it isn't shown in the view
+        const auto series = current.sibling(current.row(), timeSeriesColumn()).data(timeSeriesRole);
+        plot->setSeries(current.sibling(current.row(), 0).data().toString(), series.value<SymbolTimeSeries>());
+    };
+    QObject::connect(view->selectionModel(), &QItemSelectionModel::currentChanged, plot, updatePlot);
+
+    // the series get computed in the background for the rows that got painted
+    auto seriesChanged = [view, updatePlot]() {
+        view->viewport()->update();
+        updatePlot();
+    };
+    QObject::connect(timeSeries, &SymbolTimeSeriesCache::seriesAvailable, plot, seriesChanged);
+    QObject::connect(timeSeries, &SymbolTimeSeriesCache::cleared, plot, seriesChanged);
+}
+
 void hideEmptyColumns(const Data::Costs& costs, QTreeView* view, int numBaseColumns)
 {
     for (int i = 0; i < costs.numTypes(); ++i) {
-        if (!costs.totalCost(i)) {
+        // the deltas of a comparison may cancel each other out
+        if (!costs.totalCost(i) && costs.baselineType(i) == -1) {
             view->hideColumn(numBaseColumns + i);
         }
     }
@@ -230,7 +282,12 @@ void setupResultsAggregation(QComboBox* costAggregationComboBox)
          Settings::CostAggregation::ByProcess},
         {QCoreApplication::translate("Util", "CPU"),
          QCoreApplication::translate("Util", "Group events by CPU id and aggregate costs separately for each CPU."),
-         Settings::CostAggregation::ByCPU}};
+         Settings::CostAggregation::ByCPU},
+        {QCoreApplication::translate("Util", "NUMA Node"),
+         QCoreApplication::translate("Util",
+                                     "Group events by the NUMA node of their CPU and aggregate costs separately for "
+                                     "each node."),
+         Settings::CostAggregation::ByNumaNode}};
     for (const auto& aggregationType : types) {
         costAggregationComboBox->addItem(aggregationType.name, QVariant::fromValue(aggregationType.aggregation));
         costAggregationComboBox->setItemData(costAggregationComboBox->count() - 1, aggregationType.tooltip,
@@ -27,6 +27,8 @@ struct Symbol;
 
 class FilterAndZoomStack;
 class CostContextMenu;
+class SymbolTimeSeriesCache;
+class SymbolTimeSeriesPlot;
 
 namespace ResultsUtil {
 void setupHeaderView(QTreeView* view, CostContextMenu* contextMenu);
@@ -93,6 +95,19 @@ void setupContextMenu(QTreeView* view, CostContextMenu* costContextMenu, Model*
                      });
 }
 
+// paints the time series of @p timeSeriesColumn of @p model as sparklines and shows the one of the current row of
+// @p view in @p plot. call this after setupCostDelegate, the delegate of the column has to replace the cost delegate
+void setupTimeSeries(QAbstractItemModel* model, QTreeView* view, SymbolTimeSeriesCache* timeSeries,
+                     SymbolTimeSeriesPlot* plot, int timeSeriesRole, const std::function<int()>& timeSeriesColumn);
+
+template<typename Model>
+void setupTimeSeries(Model* model, QTreeView* view, SymbolTimeSeriesCache* timeSeries, SymbolTimeSeriesPlot* plot)
+{
+    model->setTimeSeries(timeSeries);
+    setupTimeSeries(model, view, timeSeries, plot, Model::TimeSeriesRole,
+                    [model]() { return model->timeSeriesColumn(); });
+}
+
 void hideEmptyColumns(const Data::Costs& costs, QTreeView* view, int numBaseColumns);
 
 void hideTracepointColumns(const Data::Costs& costs, QTreeView* view, int numBaseColumns);
@@ -0,0 +1,142 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "selfprofiler.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaObject>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+#include <iterator>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace {
+// time to bundle the phases before phasesChanged gets emitted
+const int ChangeDelay = 500;
+}
+
+std::atomic<bool> SelfProfiler::s_heapTracking {!qEnvironmentVariableIsEmpty("HOTSPOT_TRACE")};
+
+SelfProfiler::SelfProfiler()
+{
+    m_timer.start();
+    m_phases.reserve(1024);
+    // the first phase may come from a worker thread, but the signals have to be delivered on the main thread
+    if (auto* app = QCoreApplication::instance()) {
+        moveToThread(app->thread());
+    }
+}
+
+SelfProfiler* SelfProfiler::instance()
+{
+    static SelfProfiler profiler;
+    return &profiler;
+}
+
+qint64 SelfProfiler::heapUsage()
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+    // the small allocations from the arenas and the large ones that got mapped separately
+    const auto info = mallinfo2();
+    return static_cast<qint64>(info.uordblks + info.hblkhd);
+#else
+    return 0;
+#endif
+}
+
+void SelfProfiler::addPhase(const char* name, qint64 start, qint64 end, qint64 heapGrowth)
+{
+    const auto threadId = reinterpret_cast<quint64>(QThread::currentThreadId());
+    const Phase phase = {name, threadId, start, end - start, heapGrowth};
+
+    QMutexLocker locker(&m_mutex);
+    if (m_phases.size() < MaxPhases) {
+        m_phases.push_back(phase);
+    } else {
+        m_phases[m_oldest] = phase;
+        m_oldest = (m_oldest + 1) % MaxPhases;
+    }
+
+    if (!m_changePending) {
+        m_changePending = true;
+        // hop over to the thread of the profiler first, the timer can only be started there
+        QMetaObject::invokeMethod(
+            this,
+            [this]() {
+                QTimer::singleShot(ChangeDelay, this, [this]() {
+                    {
+                        QMutexLocker locker(&m_mutex);
+                        m_changePending = false;
+                    }
+                    emit phasesChanged();
+                });
+            },
+            Qt::QueuedConnection);
+    }
+}
+
+QVector<SelfProfiler::Phase> SelfProfiler::phases() const
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<Phase> phases;
+    phases.reserve(m_phases.size());
+    std::copy(m_phases.begin() + m_oldest, m_phases.end(), std::back_inserter(phases));
+    std::copy(m_phases.begin(), m_phases.begin() + m_oldest, std::back_inserter(phases));
+    return phases;
+}
+
+void SelfProfiler::clear()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_phases.clear();
+        m_oldest = 0;
+    }
+    emit phasesChanged();
+}
+
+bool SelfProfiler::writeChromeTrace(const QString& path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "failed to write trace to" << path << file.errorString();
+        return false;
+    }
+
+    const auto pid = static_cast<qint64>(QCoreApplication::applicationPid());
+    QJsonArray events;
+    for (const auto& phase : phases()) {
+        // complete events, the timestamps are in microseconds
+        events.append(QJsonObject {{QStringLiteral("name"), QString::fromUtf8(phase.name)},
+                                   {QStringLiteral("ph"), QStringLiteral("X")},
+                                   {QStringLiteral("pid"), pid},
+                                   {QStringLiteral("tid"), static_cast<qint64>(phase.threadId)},
+                                   {QStringLiteral("ts"), phase.start / 1000.},
+                                   {QStringLiteral("dur"), phase.duration / 1000.},
+                                   {QStringLiteral("args"), QJsonObject {{QStringLiteral("heapGrowth"),
+                                                                          phase.heapGrowth}}}});
+    }
+    file.write(QJsonDocument(QJsonObject {{QStringLiteral("traceEvents"), events}}).toJson(QJsonDocument::Compact));
+    return true;
+}
+
+void SelfProfiler::writeRequestedTrace() const
+{
+    const auto path = qEnvironmentVariable("HOTSPOT_TRACE");
+    if (!path.isEmpty()) {
+        writeChromeTrace(path);
+    }
+}
@@ -0,0 +1,128 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+#include <atomic>
+
+// records how long the phases of hotspot itself take, to find out what makes it slow on a capture
+// recording is always on: a phase costs two clock reads and an append under a mutex. the heap statistics walk all
+// arenas of the allocator, so they only get taken once the phases get looked at, see setHeapTracking
+// for the individual allocations, run hotspot in heaptrack
+// the phases can be inspected in the performance dialog, and get written as a Chrome trace to $HOTSPOT_TRACE
+class SelfProfiler : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(SelfProfiler)
+
+public:
+    struct Phase
+    {
+        // a string literal, see ScopedPhase
+        const char* name = nullptr;
+        quint64 threadId = 0;
+        // in nanoseconds since the start of the profiler
+        qint64 start = 0;
+        qint64 duration = 0;
+        // how much more memory got allocated from the heap at the end of the phase, by all threads
+        // negative when more got freed, see heapUsage. 0 without heap tracking
+        qint64 heapGrowth = 0;
+    };
+
+    // only the most recent phases are kept
+    static const constexpr int MaxPhases = 100000;
+
+    // this can be used from any thread, unlike most other singletons
+    static SelfProfiler* instance();
+
+    qint64 now() const
+    {
+        return m_timer.nsecsElapsed();
+    }
+
+    // the bytes currently allocated from the heap of the process, 0 when unknown
+    static qint64 heapUsage();
+
+    // whether the phases record the growth of the heap, on once the performance dialog got shown or for
+    // $HOTSPOT_TRACE
+    static bool heapTracking()
+    {
+        return s_heapTracking.load(std::memory_order_relaxed);
+    }
+    static void setHeapTracking(bool heapTracking)
+    {
+        s_heapTracking.store(heapTracking, std::memory_order_relaxed);
+    }
+
+    void addPhase(const char* name, qint64 start, qint64 end, qint64 heapGrowth = 0);
+
+    // ordered by their end
+    QVector<Phase> phases() const;
+    void clear();
+
+    // writes the phases in the Chrome trace event format, as understood by chrome://tracing and Perfetto
+    bool writeChromeTrace(const QString& path) const;
+
+    // writes the trace to $HOTSPOT_TRACE, if it is set
+    void writeRequestedTrace() const;
+
+signals:
+    // emitted on the thread of the profiler, with a delay to bundle many phases
+    void phasesChanged();
+
+private:
+    SelfProfiler();
+
+    static std::atomic<bool> s_heapTracking;
+
+    QElapsedTimer m_timer;
+    mutable QMutex m_mutex;
+    QVector<Phase> m_phases;
+    // the oldest phase once m_phases got full
+    int m_oldest = 0;
+    bool m_changePending = false;
+};
+
+// records the time from construction to destruction as a phase of @p name, which must be a string literal
+class ScopedPhase
+{
+    Q_DISABLE_COPY(ScopedPhase)
+
+public:
+    explicit ScopedPhase(const char* name)
+        : m_name(name)
+        , m_start(SelfProfiler::instance()->now())
+        , m_heapStart(SelfProfiler::heapTracking() ? SelfProfiler::heapUsage() : -1)
+    {
+    }
+
+    ~ScopedPhase()
+    {
+        finish();
+    }
+
+    // ends the phase before the end of the scope
+    void finish()
+    {
+        if (m_name) {
+            auto* profiler = SelfProfiler::instance();
+            const auto heapGrowth = m_heapStart < 0 ? 0 : SelfProfiler::heapUsage() - m_heapStart;
+            profiler->addPhase(m_name, m_start, profiler->now(), heapGrowth);
+            m_name = nullptr;
+        }
+    }
+
+private:
+    const char* m_name;
+    qint64 m_start;
+    // -1 without heap tracking
+    qint64 m_heapStart;
+};
@@ -0,0 +1,187 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "selfprofilerdialog.h"
+
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QHash>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSet>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include <KFormat>
+
+#include "selfprofiler.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+enum Columns
+{
+    PhaseColumn,
+    CountColumn,
+    TotalColumn,
+    MaximumColumn,
+    HeapGrowthColumn,
+    NumColumns
+};
+
+// only the most recent occurrences get listed below each phase, the totals include all of them
+const int MaxOccurrences = 100;
+
+void setDuration(QTreeWidgetItem* item, int column, qint64 duration)
+{
+    item->setText(column, Util::formatTimeString(duration));
+    item->setData(column, Qt::UserRole, duration);
+    item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+}
+
+void setHeapGrowth(QTreeWidgetItem* item, qint64 heapGrowth)
+{
+    const auto size = KFormat().formatByteSize(std::abs(heapGrowth), 1, KFormat::MetricBinaryDialect);
+    item->setText(HeapGrowthColumn, heapGrowth < 0 ? QLatin1Char('-') + size : size);
+    item->setTextAlignment(HeapGrowthColumn, Qt::AlignRight | Qt::AlignVCenter);
+}
+}
+
+SelfProfilerDialog::SelfProfilerDialog(QWidget* parent)
+    : QDialog(parent)
+    , m_phases(new QTreeWidget(this))
+    , m_summary(new QLabel(this))
+{
+    setWindowTitle(tr("Performance of Hotspot"));
+    resize(700, 500);
+
+    m_phases->setColumnCount(NumColumns);
+    m_phases->setHeaderLabels({tr("Phase"), tr("Count"), tr("Total"), tr("Maximum"), tr("Heap Growth")});
+    m_phases->headerItem()->setToolTip(HeapGrowthColumn,
+                                       tr("How much more memory the heap of hotspot used after the phase. All threads "
+                                          "count, so phases running concurrently affect each other. Only the phases "
+                                          "since the dialog got opened for the first time track the heap."));
+    m_phases->setRootIsDecorated(true);
+    m_phases->setUniformRowHeights(true);
+    m_phases->header()->setSectionResizeMode(PhaseColumn, QHeaderView::Stretch);
+    m_phases->header()->setStretchLastSection(false);
+
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    auto* clearButton = buttons->addButton(tr("Clear"), QDialogButtonBox::ResetRole);
+    auto* saveButton = buttons->addButton(tr("Save Trace..."), QDialogButtonBox::ActionRole);
+    saveButton->setToolTip(tr("Save the phases in the Chrome trace event format, e.g. for chrome://tracing or "
+                              "Perfetto. Set HOTSPOT_TRACE to write them automatically on exit."));
+    connect(buttons, &QDialogButtonBox::rejected, this, &QWidget::close);
+    connect(clearButton, &QPushButton::clicked, SelfProfiler::instance(), &SelfProfiler::clear);
+    connect(saveButton, &QPushButton::clicked, this, &SelfProfilerDialog::saveTrace);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->addWidget(m_summary);
+    layout->addWidget(m_phases);
+    layout->addWidget(buttons);
+
+    connect(SelfProfiler::instance(), &SelfProfiler::phasesChanged, this, [this]() {
+        // rebuilding the tree is wasted when nobody looks at it
+        if (isVisible()) {
+            updatePhases();
+        }
+    });
+}
+
+SelfProfilerDialog::~SelfProfilerDialog() = default;
+
+void SelfProfilerDialog::showEvent(QShowEvent* event)
+{
+    // the heap growth of the phases is only of interest from now on
+    SelfProfiler::setHeapTracking(true);
+    // the phases recorded while the dialog was hidden
+    updatePhases();
+    QDialog::showEvent(event);
+}
+
+void SelfProfilerDialog::updatePhases()
+{
+    const auto phases = SelfProfiler::instance()->phases();
+
+    // remember what got expanded, the tree gets rebuilt from scratch
+    QSet<QString> expanded;
+    for (int i = 0, c = m_phases->topLevelItemCount(); i < c; ++i) {
+        const auto* item = m_phases->topLevelItem(i);
+        if (item->isExpanded()) {
+            expanded.insert(item->text(PhaseColumn));
+        }
+    }
+
+    struct Total
+    {
+        int count = 0;
+        qint64 total = 0;
+        qint64 maximum = 0;
+        qint64 heapGrowth = 0;
+        QVector<const SelfProfiler::Phase*> occurrences;
+    };
+    QHash<QString, Total> totals;
+    for (const auto& phase : phases) {
+        auto& total = totals[QString::fromUtf8(phase.name)];
+        ++total.count;
+        total.total += phase.duration;
+        total.maximum = std::max(total.maximum, phase.duration);
+        total.heapGrowth += phase.heapGrowth;
+        total.occurrences.push_back(&phase);
+    }
+
+    m_phases->clear();
+    QList<QTreeWidgetItem*> items;
+    items.reserve(totals.size());
+    for (auto it = totals.cbegin(), end = totals.cend(); it != end; ++it) {
+        auto* item = new QTreeWidgetItem({it.key(), QString::number(it->count)});
+        item->setTextAlignment(CountColumn, Qt::AlignRight | Qt::AlignVCenter);
+        setDuration(item, TotalColumn, it->total);
+        setDuration(item, MaximumColumn, it->maximum);
+        setHeapGrowth(item, it->heapGrowth);
+
+        const auto& occurrences = it->occurrences;
+        for (auto i = std::max<qsizetype>(0, occurrences.size() - MaxOccurrences); i < occurrences.size(); ++i) {
+            const auto* phase = occurrences[i];
+            const auto label =
+                tr("at %1 on thread %2").arg(Util::formatTimeString(phase->start), QString::number(phase->threadId));
+            auto* child = new QTreeWidgetItem(item, {label});
+            setDuration(child, TotalColumn, phase->duration);
+            setHeapGrowth(child, phase->heapGrowth);
+        }
+        items.push_back(item);
+    }
+    // the most expensive phases first
+    std::sort(items.begin(), items.end(), [](const QTreeWidgetItem* lhs, const QTreeWidgetItem* rhs) {
+        return lhs->data(TotalColumn, Qt::UserRole).toLongLong() > rhs->data(TotalColumn, Qt::UserRole).toLongLong();
+    });
+    m_phases->addTopLevelItems(items);
+    for (auto* item : std::as_const(items)) {
+        item->setExpanded(expanded.contains(item->text(PhaseColumn)));
+    }
+    for (int column = CountColumn; column < NumColumns; ++column) {
+        m_phases->resizeColumnToContents(column);
+    }
+
+    m_summary->setText(tr("%n phase(s) recorded, the most recent %1 are kept.", nullptr, phases.size())
+                           .arg(SelfProfiler::MaxPhases));
+}
+
+void SelfProfilerDialog::saveTrace()
+{
+    const auto path = QFileDialog::getSaveFileName(this, tr("Save Trace"), QStringLiteral("hotspot-trace.json"),
+                                                   tr("Chrome Trace (*.json)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    if (!SelfProfiler::instance()->writeChromeTrace(path)) {
+        QMessageBox::warning(this, tr("Failed to save the trace"), tr("Could not write the trace to %1.").arg(path));
+    }
+}
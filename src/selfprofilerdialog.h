@@ -0,0 +1,31 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QDialog>
+
+class QLabel;
+class QTreeWidget;
+
+// lists the phases recorded by the SelfProfiler, with their total time per name at the top level
+class SelfProfilerDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit SelfProfilerDialog(QWidget* parent = nullptr);
+    ~SelfProfilerDialog();
+
+protected:
+    void showEvent(QShowEvent* event) override;
+
+private:
+    void updatePhases();
+    void saveTrace();
+
+    QTreeWidget* m_phases;
+    QLabel* m_summary;
+};
@@ -50,6 +50,23 @@ void Settings::setCollapseDepth(int depth)
     }
 }
 
+void Settings::setFoldThreshold(double threshold)
+{
+    threshold = std::clamp(threshold, 0., 100.);
+    if (m_foldThreshold != threshold) {
+        m_foldThreshold = threshold;
+        emit foldThresholdChanged(m_foldThreshold);
+    }
+}
+
+void Settings::setFoldInlines(bool foldInlines)
+{
+    if (m_foldInlines != foldInlines) {
+        m_foldInlines = foldInlines;
+        emit foldInlinesChanged(m_foldInlines);
+    }
+}
+
 void Settings::setColorScheme(Settings::ColorScheme scheme)
 {
     if (m_colorScheme != scheme) {
@@ -172,6 +189,8 @@ void Settings::loadFromFile()
     setPrettifySymbols(config.readEntry("prettifySymbols", true));
     setCollapseTemplates(config.readEntry("collapseTemplates", true));
     setCollapseDepth(config.readEntry("collapseDepth", 1));
+    setFoldThreshold(config.readEntry("foldThreshold", 0.));
+    setFoldInlines(config.readEntry("foldInlines", false));
 
     connect(Settings::instance(), &Settings::prettifySymbolsChanged, this, [sharedConfig](bool prettifySymbols) {
         sharedConfig->group(QStringLiteral("Settings")).writeEntry("prettifySymbols", prettifySymbols);
@@ -185,6 +204,14 @@ void Settings::loadFromFile()
         sharedConfig->group(QStringLiteral("Settings")).writeEntry("collapseDepth", collapseDepth);
     });
 
+    connect(this, &Settings::foldThresholdChanged, this, [sharedConfig](double foldThreshold) {
+        sharedConfig->group(QStringLiteral("Settings")).writeEntry("foldThreshold", foldThreshold);
+    });
+
+    connect(this, &Settings::foldInlinesChanged, this, [sharedConfig](bool foldInlines) {
+        sharedConfig->group(QStringLiteral("Settings")).writeEntry("foldInlines", foldInlines);
+    });
+
     const QStringList userPaths = {QDir::homePath()};
     const QStringList systemPaths = {QDir::rootPath()};
     setPaths(sharedConfig->group(QStringLiteral("PathSettings")).readEntry("userPaths", userPaths),
@@ -253,6 +280,72 @@ void Settings::loadFromFile()
     connect(this, &Settings::showHexdumpChanged, [sharedConfig](bool showHexdump) {
         sharedConfig->group(QStringLiteral("Disassembly")).writeEntry("showHexdump", showHexdump);
     });
+
+    setBuiltinDisassembler(
+        sharedConfig->group(QStringLiteral("Disassembly")).readEntry("builtinDisassembler", false));
+    connect(this, &Settings::builtinDisassemblerChanged, [sharedConfig](bool builtinDisassembler) {
+        sharedConfig->group(QStringLiteral("Disassembly")).writeEntry("builtinDisassembler", builtinDisassembler);
+    });
+
+    setDisassembleWholeBinaries(
+        sharedConfig->group(QStringLiteral("Disassembly")).readEntry("disassembleWholeBinaries", false));
+    connect(this, &Settings::disassembleWholeBinariesChanged, [sharedConfig](bool disassembleWholeBinaries) {
+        sharedConfig->group(QStringLiteral("Disassembly"))
+            .writeEntry("disassembleWholeBinaries", disassembleWholeBinaries);
+    });
+
+    setHardwareAcceleratedTimeline(
+        sharedConfig->group(QStringLiteral("TimeLine")).readEntry("hardwareAcceleration", false));
+    connect(this, &Settings::hardwareAcceleratedTimelineChanged, [sharedConfig](bool hardwareAcceleratedTimeline) {
+        sharedConfig->group(QStringLiteral("TimeLine")).writeEntry("hardwareAcceleration", hardwareAcceleratedTimeline);
+    });
+
+    setCorrectLostEvents(sharedConfig->group(QStringLiteral("Perf")).readEntry("correctLostEvents", false));
+    connect(this, &Settings::correctLostEventsChanged, [sharedConfig](bool correctLostEvents) {
+        sharedConfig->group(QStringLiteral("Perf")).writeEntry("correctLostEvents", correctLostEvents);
+    });
+
+    const auto defaultDerivedMetrics = QStringList {QStringLiteral("IPC=instructions/cycles"),
+                                                    QStringLiteral("Cache Miss Ratio=cache-misses/cache-references")};
+    setDerivedMetrics(sharedConfig->group(QStringLiteral("Perf")).readEntry("derivedMetrics", defaultDerivedMetrics));
+    connect(this, &Settings::derivedMetricsChanged, [sharedConfig](const QStringList& derivedMetrics) {
+        sharedConfig->group(QStringLiteral("Perf")).writeEntry("derivedMetrics", derivedMetrics);
+    });
+
+    setMemoryBudget(sharedConfig->group(QStringLiteral("Perf")).readEntry("memoryBudget", 0));
+    connect(this, &Settings::memoryBudgetChanged, [sharedConfig](int memoryBudget) {
+        sharedConfig->group(QStringLiteral("Perf")).writeEntry("memoryBudget", memoryBudget);
+    });
+
+    setParserCacheSize(sharedConfig->group(QStringLiteral("Perf")).readEntry("parserCacheSize", 10240));
+    connect(this, &Settings::parserCacheSizeChanged, [sharedConfig](int parserCacheSize) {
+        sharedConfig->group(QStringLiteral("Perf")).writeEntry("parserCacheSize", parserCacheSize);
+    });
+
+    setPreviewStride(sharedConfig->group(QStringLiteral("Perf")).readEntry("previewStride", 1));
+    connect(this, &Settings::previewStrideChanged, [sharedConfig](int previewStride) {
+        sharedConfig->group(QStringLiteral("Perf")).writeEntry("previewStride", previewStride);
+    });
+
+    setPruneFrames(sharedConfig->group(QStringLiteral("Perf")).readEntry("pruneFrames", QStringList()));
+    connect(this, &Settings::pruneFramesChanged, [sharedConfig](const QStringList& pruneFrames) {
+        sharedConfig->group(QStringLiteral("Perf")).writeEntry("pruneFrames", pruneFrames);
+    });
+
+    setMaxStackDepth(sharedConfig->group(QStringLiteral("Perf")).readEntry("maxStackDepth", 0));
+    connect(this, &Settings::maxStackDepthChanged, [sharedConfig](int maxStackDepth) {
+        sharedConfig->group(QStringLiteral("Perf")).writeEntry("maxStackDepth", maxStackDepth);
+    });
+
+    setCollapseRecursion(sharedConfig->group(QStringLiteral("Perf")).readEntry("collapseRecursion", false));
+    connect(this, &Settings::collapseRecursionChanged, [sharedConfig](bool collapseRecursion) {
+        sharedConfig->group(QStringLiteral("Perf")).writeEntry("collapseRecursion", collapseRecursion);
+    });
+
+    setStackDumpSize(sharedConfig->group(QStringLiteral("Perf")).readEntry("stackDumpSize", 8192));
+    connect(this, &Settings::stackDumpSizeChanged, [sharedConfig](int stackDumpSize) {
+        sharedConfig->group(QStringLiteral("Perf")).writeEntry("stackDumpSize", stackDumpSize);
+    });
 }
 
 void Settings::setSourceCodePaths(const QString& paths)
@@ -286,3 +379,107 @@ void Settings::setShowHexdump(bool showHexdump)
         emit showHexdumpChanged(m_showHexdump);
     }
 }
+
+void Settings::setBuiltinDisassembler(bool builtinDisassembler)
+{
+    if (m_builtinDisassembler != builtinDisassembler) {
+        m_builtinDisassembler = builtinDisassembler;
+        emit builtinDisassemblerChanged(m_builtinDisassembler);
+    }
+}
+
+void Settings::setDisassembleWholeBinaries(bool disassembleWholeBinaries)
+{
+    if (m_disassembleWholeBinaries != disassembleWholeBinaries) {
+        m_disassembleWholeBinaries = disassembleWholeBinaries;
+        emit disassembleWholeBinariesChanged(m_disassembleWholeBinaries);
+    }
+}
+
+void Settings::setHardwareAcceleratedTimeline(bool hardwareAcceleratedTimeline)
+{
+    if (m_hardwareAcceleratedTimeline != hardwareAcceleratedTimeline) {
+        m_hardwareAcceleratedTimeline = hardwareAcceleratedTimeline;
+        emit hardwareAcceleratedTimelineChanged(m_hardwareAcceleratedTimeline);
+    }
+}
+
+void Settings::setCorrectLostEvents(bool correctLostEvents)
+{
+    if (m_correctLostEvents != correctLostEvents) {
+        m_correctLostEvents = correctLostEvents;
+        emit correctLostEventsChanged(m_correctLostEvents);
+    }
+}
+
+void Settings::setMemoryBudget(int memoryBudget)
+{
+    if (m_memoryBudget != memoryBudget) {
+        m_memoryBudget = memoryBudget;
+        emit memoryBudgetChanged(m_memoryBudget);
+    }
+}
+
+void Settings::setParserCacheSize(int parserCacheSize)
+{
+    if (m_parserCacheSize != parserCacheSize) {
+        m_parserCacheSize = parserCacheSize;
+        emit parserCacheSizeChanged(m_parserCacheSize);
+    }
+}
+
+void Settings::setPreviewStride(int previewStride)
+{
+    if (m_previewStride != previewStride) {
+        m_previewStride = previewStride;
+        emit previewStrideChanged(m_previewStride);
+    }
+}
+
+void Settings::setPruneFrames(const QStringList& pruneFrames)
+{
+    if (m_pruneFrames != pruneFrames) {
+        m_pruneFrames = pruneFrames;
+        emit pruneFramesChanged(m_pruneFrames);
+    }
+}
+
+void Settings::setMaxStackDepth(int maxStackDepth)
+{
+    if (m_maxStackDepth != maxStackDepth) {
+        m_maxStackDepth = maxStackDepth;
+        emit maxStackDepthChanged(m_maxStackDepth);
+    }
+}
+
+void Settings::setCollapseRecursion(bool collapseRecursion)
+{
+    if (m_collapseRecursion != collapseRecursion) {
+        m_collapseRecursion = collapseRecursion;
+        emit collapseRecursionChanged(m_collapseRecursion);
+    }
+}
+
+void Settings::setStackDumpSize(int stackDumpSize)
+{
+    if (m_stackDumpSize != stackDumpSize) {
+        m_stackDumpSize = stackDumpSize;
+        emit stackDumpSizeChanged(m_stackDumpSize);
+    }
+}
+
+void Settings::setParseRestriction(const QString& parseRestriction)
+{
+    if (m_parseRestriction != parseRestriction) {
+        m_parseRestriction = parseRestriction;
+        emit parseRestrictionChanged(m_parseRestriction);
+    }
+}
+
+void Settings::setDerivedMetrics(const QStringList& derivedMetrics)
+{
+    if (m_derivedMetrics != derivedMetrics) {
+        m_derivedMetrics = derivedMetrics;
+        emit derivedMetricsChanged(m_derivedMetrics);
+    }
+}
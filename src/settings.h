@@ -33,7 +33,8 @@ public:
         BySymbol,
         ByThread,
         ByProcess,
-        ByCPU
+        ByCPU,
+        ByNumaNode
     };
     Q_ENUM(CostAggregation);
 
@@ -54,6 +55,18 @@ public:
         return m_collapseDepth;
     }
 
+    // children below this percentage of the total cost get folded into one row in the trees, 0 disables it
+    double foldThreshold() const
+    {
+        return m_foldThreshold;
+    }
+
+    // whether the costs of inlined frames get attributed to the function they got inlined into
+    bool foldInlines() const
+    {
+        return m_foldInlines;
+    }
+
     ColorScheme colorScheme() const
     {
         return m_colorScheme;
@@ -163,12 +176,91 @@ public:
         return m_showHexdump;
     }
 
+    bool builtinDisassembler() const
+    {
+        return m_builtinDisassembler;
+    }
+
+    bool disassembleWholeBinaries() const
+    {
+        return m_disassembleWholeBinaries;
+    }
+
+    bool hardwareAcceleratedTimeline() const
+    {
+        return m_hardwareAcceleratedTimeline;
+    }
+
+    bool correctLostEvents() const
+    {
+        return m_correctLostEvents;
+    }
+
+    // definitions of ratios between cost types like "IPC=instructions/cycles", see Data::DerivedMetrics
+    QStringList derivedMetrics() const
+    {
+        return m_derivedMetrics;
+    }
+
+    // in MiB, 0 means unlimited. once the results exceed it, the events get spilled to disk, see Data::MemoryUsage
+    int memoryBudget() const
+    {
+        return m_memoryBudget;
+    }
+
+    // in MiB, the output of perfparser gets cached to reopen files faster, 0 disables the cache
+    int parserCacheSize() const
+    {
+        return m_parserCacheSize;
+    }
+
+    // while a file gets parsed, the partial results show a preview of every n-th sample per thread
+    // 1 disables the preview
+    int previewStride() const
+    {
+        return m_previewStride;
+    }
+
+    // wildcards for the symbols and binaries of the frames that get dropped from every sampled stack, see StackPruning
+    QStringList pruneFrames() const
+    {
+        return m_pruneFrames;
+    }
+
+    // the number of innermost frames that get kept of every sampled stack, 0 keeps all of them
+    int maxStackDepth() const
+    {
+        return m_maxStackDepth;
+    }
+
+    // whether the frames of a direct recursion get collapsed into one
+    bool collapseRecursion() const
+    {
+        return m_collapseRecursion;
+    }
+
+    // the bytes of the user stack perf record copies per sample with --call-graph dwarf
+    // the summary offers a larger one when too many stacks got truncated, see ResultsSummaryPage
+    int stackDumpSize() const
+    {
+        return m_stackDumpSize;
+    }
+
+    // restricts the samples that get parsed when opening a file, see Data::ParseRestriction::fromString
+    // only applies to the current session, as a forgotten restriction would silently drop samples later on
+    QString parseRestriction() const
+    {
+        return m_parseRestriction;
+    }
+
     void loadFromFile();
 
 signals:
     void prettifySymbolsChanged(bool);
     void collapseTemplatesChanged(bool);
     void collapseDepthChanged(int);
+    void foldThresholdChanged(double);
+    void foldInlinesChanged(bool foldInlines);
     void colorSchemeChanged(Settings::ColorScheme);
     void costAggregationChanged(Settings::CostAggregation);
     void pathsChanged();
@@ -187,11 +279,26 @@ signals:
     void perfPathChanged(const QString& perfPath);
     void showBranchesChanged(bool showBranches);
     void showHexdumpChanged(bool showHexdump);
+    void builtinDisassemblerChanged(bool builtinDisassembler);
+    void disassembleWholeBinariesChanged(bool disassembleWholeBinaries);
+    void hardwareAcceleratedTimelineChanged(bool hardwareAcceleratedTimeline);
+    void correctLostEventsChanged(bool correctLostEvents);
+    void derivedMetricsChanged(const QStringList& derivedMetrics);
+    void memoryBudgetChanged(int memoryBudget);
+    void parserCacheSizeChanged(int parserCacheSize);
+    void previewStrideChanged(int previewStride);
+    void parseRestrictionChanged(const QString& parseRestriction);
+    void pruneFramesChanged(const QStringList& pruneFrames);
+    void maxStackDepthChanged(int maxStackDepth);
+    void collapseRecursionChanged(bool collapseRecursion);
+    void stackDumpSizeChanged(int stackDumpSize);
 
 public slots:
     void setPrettifySymbols(bool prettifySymbols);
     void setCollapseTemplates(bool collapseTemplates);
     void setCollapseDepth(int depth);
+    void setFoldThreshold(double threshold);
+    void setFoldInlines(bool foldInlines);
     void setColorScheme(Settings::ColorScheme scheme);
     void setPaths(const QStringList& userPaths, const QStringList& systemPaths);
     void setDebuginfodUrls(const QStringList& urls);
@@ -212,6 +319,19 @@ public slots:
     void setPerfPath(const QString& path);
     void setShowBranches(bool showBranches);
     void setShowHexdump(bool showHexdump);
+    void setBuiltinDisassembler(bool builtinDisassembler);
+    void setDisassembleWholeBinaries(bool disassembleWholeBinaries);
+    void setHardwareAcceleratedTimeline(bool hardwareAcceleratedTimeline);
+    void setCorrectLostEvents(bool correctLostEvents);
+    void setDerivedMetrics(const QStringList& derivedMetrics);
+    void setMemoryBudget(int memoryBudget);
+    void setParserCacheSize(int parserCacheSize);
+    void setPreviewStride(int previewStride);
+    void setParseRestriction(const QString& parseRestriction);
+    void setPruneFrames(const QStringList& pruneFrames);
+    void setMaxStackDepth(int maxStackDepth);
+    void setCollapseRecursion(bool collapseRecursion);
+    void setStackDumpSize(int stackDumpSize);
 
 private:
     using QObject::QObject;
@@ -220,6 +340,8 @@ private:
     bool m_prettifySymbols = true;
     bool m_collapseTemplates = true;
     int m_collapseDepth = 1;
+    double m_foldThreshold = 0;
+    bool m_foldInlines = false;
     ColorScheme m_colorScheme = ColorScheme::Default;
     CostAggregation m_costAggregation = CostAggregation::BySymbol;
     QStringList m_userPaths;
@@ -237,6 +359,19 @@ private:
     QString m_perfMapPath;
     bool m_showBranches = true;
     bool m_showHexdump = false;
+    bool m_builtinDisassembler = false;
+    bool m_disassembleWholeBinaries = false;
+    bool m_hardwareAcceleratedTimeline = false;
+    bool m_correctLostEvents = false;
+    QStringList m_derivedMetrics;
+    int m_memoryBudget = 0;
+    int m_parserCacheSize = 10240;
+    int m_previewStride = 1;
+    QString m_parseRestriction;
+    QStringList m_pruneFrames;
+    int m_maxStackDepth = 0;
+    bool m_collapseRecursion = false;
+    int m_stackDumpSize = 8192;
 
     QString m_lastUsedEnvironment;
 
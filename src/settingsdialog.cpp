@@ -13,6 +13,7 @@
 #include "ui_disassemblysettingspage.h"
 #include "ui_flamegraphsettingspage.h"
 #include "ui_perfsettingspage.h"
+#include "ui_timelinesettingspage.h"
 #include "ui_unwindsettingspage.h"
 
 #include "multiconfigwidget.h"
@@ -68,6 +69,7 @@ SettingsDialog::SettingsDialog(QWidget* parent)
 #if KGraphViewerPart_FOUND
     , callgraphPage(new Ui::CallgraphSettingsPage)
 #endif
+    , timeLinePage(new Ui::TimeLineSettingsPage)
 {
     addPerfSettingsPage();
     addPathSettingsPage();
@@ -77,6 +79,7 @@ SettingsDialog::SettingsDialog(QWidget* parent)
     addCallgraphPage();
 #endif
     addSourcePathPage();
+    addTimeLinePage();
 }
 
 SettingsDialog::~SettingsDialog() = default;
@@ -167,9 +170,33 @@ void SettingsDialog::addPerfSettingsPage()
     connect(this, &KPageDialog::accepted, this, [this]() {
         auto settings = Settings::instance();
         settings->setPerfPath(perfPage->perfPathEdit->url().toLocalFile());
+        settings->setCorrectLostEvents(perfPage->correctLostEvents->isChecked());
+        auto derivedMetrics = perfPage->derivedMetrics->text().split(QLatin1Char(';'), Qt::SkipEmptyParts);
+        for (auto& derivedMetric : derivedMetrics) {
+            derivedMetric = derivedMetric.trimmed();
+        }
+        settings->setDerivedMetrics(derivedMetrics);
+        settings->setMemoryBudget(perfPage->memoryBudget->value());
+        settings->setParserCacheSize(perfPage->parserCacheSize->value());
+        settings->setPreviewStride(perfPage->previewStride->value());
+        auto pruneFrames = perfPage->pruneFrames->text().split(QLatin1Char(';'), Qt::SkipEmptyParts);
+        for (auto& pruneFrame : pruneFrames) {
+            pruneFrame = pruneFrame.trimmed();
+        }
+        settings->setPruneFrames(pruneFrames);
+        settings->setMaxStackDepth(perfPage->maxStackDepth->value());
+        settings->setCollapseRecursion(perfPage->collapseRecursion->isChecked());
     });
 
     perfPage->perfPathEdit->setUrl(QUrl::fromLocalFile(Settings::instance()->perfPath()));
+    perfPage->correctLostEvents->setChecked(Settings::instance()->correctLostEvents());
+    perfPage->derivedMetrics->setText(Settings::instance()->derivedMetrics().join(QLatin1String("; ")));
+    perfPage->memoryBudget->setValue(Settings::instance()->memoryBudget());
+    perfPage->parserCacheSize->setValue(Settings::instance()->parserCacheSize());
+    perfPage->previewStride->setValue(Settings::instance()->previewStride());
+    perfPage->pruneFrames->setText(Settings::instance()->pruneFrames().join(QLatin1String("; ")));
+    perfPage->maxStackDepth->setValue(Settings::instance()->maxStackDepth());
+    perfPage->collapseRecursion->setChecked(Settings::instance()->collapseRecursion());
 }
 
 void SettingsDialog::addPathSettingsPage()
@@ -337,10 +364,40 @@ void SettingsDialog::addSourcePathPage()
 
     disassemblyPage->showBranches->setChecked(settings->showBranches());
     disassemblyPage->showHexdump->setChecked(settings->showHexdump());
+    disassemblyPage->builtinDisassembler->setChecked(settings->builtinDisassembler());
+    disassemblyPage->disassembleWholeBinaries->setChecked(settings->disassembleWholeBinaries());
+#if !Capstone_FOUND
+    disassemblyPage->builtinDisassembler->setEnabled(false);
+    disassemblyPage->builtinDisassembler->setToolTip(tr("Hotspot was built without capstone support."));
+#endif
 
     connect(buttonBox(), &QDialogButtonBox::accepted, this, [this, colon, settings] {
         settings->setSourceCodePaths(disassemblyPage->sourcePaths->items().join(colon));
         settings->setShowBranches(disassemblyPage->showBranches->isChecked());
         settings->setShowHexdump(disassemblyPage->showHexdump->isChecked());
+        settings->setBuiltinDisassembler(disassemblyPage->builtinDisassembler->isChecked());
+        settings->setDisassembleWholeBinaries(disassemblyPage->disassembleWholeBinaries->isChecked());
+    });
+}
+
+void SettingsDialog::addTimeLinePage()
+{
+    auto page = new QWidget(this);
+    auto item = addPage(page, tr("Time Line"));
+    item->setHeader(tr("Time Line Settings"));
+    item->setIcon(icon());
+
+    timeLinePage->setupUi(page);
+
+    auto settings = Settings::instance();
+
+    timeLinePage->hardwareAcceleration->setChecked(settings->hardwareAcceleratedTimeline());
+#if !QtOpenGLWidgets_FOUND
+    timeLinePage->hardwareAcceleration->setEnabled(false);
+    timeLinePage->hardwareAcceleration->setToolTip(tr("Hotspot was built without OpenGL support."));
+#endif
+
+    connect(buttonBox(), &QDialogButtonBox::accepted, this, [this, settings] {
+        settings->setHardwareAcceleratedTimeline(timeLinePage->hardwareAcceleration->isChecked());
     });
 }
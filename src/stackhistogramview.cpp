@@ -0,0 +1,257 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "stackhistogramview.h"
+
+#include <QEvent>
+#include <QHeaderView>
+#include <QHelpEvent>
+#include <QPainter>
+#include <QPointer>
+#include <QToolTip>
+#include <QTreeView>
+
+#include "jobscheduler.h"
+#include "models/eventmodel.h"
+#include "models/filterandzoomstack.h"
+#include "models/timelinedelegate.h"
+#include "selfprofiler.h"
+#include "util.h"
+
+#include <numeric>
+
+namespace {
+QColor entryColor(const StackHistogram::Buckets& buckets, int entry)
+{
+    if (entry == buckets.labels.size() - 1) {
+        // the others
+        return Qt::gray;
+    }
+    return QColor::fromHsv(static_cast<int>(qHash(buckets.labels.at(entry)) % 360), 140, 230);
+}
+}
+
+uint qHash(const StackHistogramView::Key& key, uint seed)
+{
+    Util::HashCombine hash;
+    seed = hash(seed, key.time.start);
+    seed = hash(seed, key.time.end);
+    seed = hash(seed, key.costType);
+    seed = hash(seed, key.numBuckets);
+    return seed;
+}
+
+StackHistogramView::StackHistogramView(FilterAndZoomStack* filterAndZoomStack, QTreeView* timeLineView,
+                                       QWidget* parent)
+    : QWidget(parent)
+    , m_filterAndZoomStack(filterAndZoomStack)
+    , m_timeLineView(timeLineView)
+{
+    setMinimumHeight(4 * fontMetrics().height());
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    m_cache.setMaxCost(MaxCachedBuckets);
+
+    connect(filterAndZoomStack, &FilterAndZoomStack::zoomChanged, this, &StackHistogramView::updateBuckets);
+    // the buckets follow the width of the events column
+    connect(timeLineView->header(), &QHeaderView::sectionResized, this, &StackHistogramView::updateBuckets);
+    connect(timeLineView->header(), &QHeaderView::geometriesChanged, this, &StackHistogramView::updateBuckets);
+}
+
+StackHistogramView::~StackHistogramView() = default;
+
+void StackHistogramView::setData(const Data::EventResults& events, const Data::BottomUpResults& bottomUp,
+                                 Data::TimeRange time)
+{
+    m_events = events;
+    m_bottomUp = bottomUp;
+    m_time = time;
+    m_histogram.reset();
+    reset();
+}
+
+void StackHistogramView::setCostType(int costType)
+{
+    if (costType != m_costType) {
+        m_costType = costType;
+        updateBuckets();
+    }
+}
+
+void StackHistogramView::setGrouping(StackHistogram::Grouping grouping)
+{
+    if (grouping != m_grouping) {
+        m_grouping = grouping;
+        m_histogram.reset();
+        reset();
+    }
+}
+
+void StackHistogramView::reset()
+{
+    ++m_currentJobId;
+    m_cache.clear();
+    m_buckets = {};
+    m_bucketsKey = {};
+    updateBuckets();
+}
+
+void StackHistogramView::showEvent(QShowEvent* event)
+{
+    // nothing gets aggregated while the track is hidden
+    updateBuckets();
+    QWidget::showEvent(event);
+}
+
+QRect StackHistogramView::eventsRect() const
+{
+    // the track lies right above the timeline, with the same width
+    const auto* header = m_timeLineView->header();
+    const auto x = m_timeLineView->viewport()->geometry().x()
+        + header->sectionViewportPosition(EventModel::EventsColumn) + TimeLineData::padding;
+    const auto width = header->sectionSize(EventModel::EventsColumn) - 2 * TimeLineData::padding;
+    return QRect(x, TimeLineData::padding, std::max(0, width), height() - 2 * TimeLineData::padding);
+}
+
+StackHistogramView::Key StackHistogramView::currentKey() const
+{
+    Key key;
+    const auto zoom = m_filterAndZoomStack->zoom();
+    key.time = zoom.isValid() ? zoom.time.normalized() : m_time;
+    key.costType = m_costType;
+    key.numBuckets = eventsRect().width() / BucketWidth;
+    return key;
+}
+
+void StackHistogramView::updateBuckets()
+{
+    if (!isVisible() || m_events.threads.isEmpty()) {
+        return;
+    }
+
+    const auto key = currentKey();
+    if (key == m_bucketsKey) {
+        return;
+    }
+    if (key.numBuckets <= 0 || key.time.isEmpty()) {
+        m_buckets = {};
+        m_bucketsKey = key;
+        update();
+        return;
+    }
+    if (const auto* cached = m_cache.object(key)) {
+        m_buckets = *cached;
+        m_bucketsKey = key;
+        update();
+        return;
+    }
+
+    struct Result
+    {
+        std::shared_ptr<const StackHistogram> histogram;
+        StackHistogram::Buckets buckets;
+    };
+
+    const auto jobId = ++m_currentJobId;
+    const auto smartThis = QPointer<StackHistogramView>(this);
+    auto jobCancelled = [smartThis, jobId, currentJobId = &m_currentJobId]() {
+        return !smartThis || jobId != (*currentJobId);
+    };
+    JobScheduler::run(JobScheduler::Priority::Normal, [histogram = m_histogram, events = m_events,
+                                                       bottomUp = m_bottomUp, grouping = m_grouping, key, smartThis,
+                                                       jobCancelled]() mutable {
+        ScopedPhase phase("stack histogram");
+        if (!histogram) {
+            histogram = std::make_shared<const StackHistogram>(events, bottomUp, grouping);
+        }
+        if (jobCancelled()) {
+            return;
+        }
+        Result result {histogram, histogram->buckets(key.costType, key.time, key.numBuckets, TopEntries)};
+        QMetaObject::invokeMethod(
+            smartThis.data(),
+            [smartThis, jobCancelled, key, result = std::move(result)]() {
+                if (jobCancelled()) {
+                    return;
+                }
+                smartThis->m_histogram = result.histogram;
+                smartThis->m_cache.insert(key, new StackHistogram::Buckets(result.buckets));
+                smartThis->m_buckets = result.buckets;
+                smartThis->m_bucketsKey = key;
+                smartThis->update();
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void StackHistogramView::paintEvent(QPaintEvent* /*event*/)
+{
+    QPainter painter(this);
+    const auto rect = eventsRect();
+    painter.fillRect(rect, palette().base());
+
+    if (!(m_bucketsKey == currentKey())) {
+        painter.setPen(palette().color(QPalette::PlaceholderText));
+        painter.drawText(rect, Qt::AlignCenter, tr("Aggregating the stacks..."));
+        return;
+    }
+    if (m_buckets.isEmpty() || !m_buckets.maxBucketCost) {
+        painter.setPen(palette().color(QPalette::PlaceholderText));
+        painter.drawText(rect, Qt::AlignCenter, tr("No samples in the visible time range"));
+        return;
+    }
+
+    // stack the entries of every bucket on top of each other, the top entry at the bottom
+    const auto yMultiplicator = static_cast<double>(rect.height()) / m_buckets.maxBucketCost;
+    for (int bucket = 0; bucket < m_buckets.numBuckets; ++bucket) {
+        const auto left = rect.x() + bucket * rect.width() / m_buckets.numBuckets;
+        const auto right = rect.x() + (bucket + 1) * rect.width() / m_buckets.numBuckets - 1;
+        quint64 cost = 0;
+        for (int entry = 0, c = m_buckets.labels.size(); entry < c; ++entry) {
+            const auto entryCost = m_buckets.cost(bucket, entry);
+            if (!entryCost) {
+                continue;
+            }
+            const auto bottom = rect.bottom() - static_cast<int>(cost * yMultiplicator);
+            cost += entryCost;
+            const auto top = rect.bottom() - static_cast<int>(cost * yMultiplicator);
+            painter.fillRect(QRect(QPoint(left, top), QPoint(right, bottom)), entryColor(m_buckets, entry));
+        }
+    }
+}
+
+bool StackHistogramView::event(QEvent* event)
+{
+    if (event->type() != QEvent::ToolTip) {
+        return QWidget::event(event);
+    }
+
+    const auto* helpEvent = static_cast<QHelpEvent*>(event);
+    const auto rect = eventsRect();
+    const auto x = helpEvent->pos().x() - rect.x();
+    if (!(m_bucketsKey == currentKey()) || m_buckets.isEmpty() || x < 0 || x >= rect.width()) {
+        QToolTip::hideText();
+        event->ignore();
+        return true;
+    }
+
+    const auto bucket = x * m_buckets.numBuckets / rect.width();
+    const auto time = m_buckets.bucketTime(bucket);
+    auto text = tr("time: %1 - %2").arg(Util::formatTimeString(time.start - m_time.start),
+                                        Util::formatTimeString(time.end - m_time.start));
+    const auto begin = m_buckets.costs.constBegin() + bucket * m_buckets.labels.size();
+    const auto total = std::accumulate(begin, begin + m_buckets.labels.size(), quint64(0));
+    for (int entry = 0, c = m_buckets.labels.size(); entry < c; ++entry) {
+        const auto cost = m_buckets.cost(bucket, entry);
+        if (cost) {
+            text += QLatin1Char('\n')
+                + tr("%1: %2 (%3%)")
+                      .arg(Util::elideSymbol(m_buckets.labels.at(entry), fontMetrics(), MaxLabelWidth),
+                           Util::formatCost(cost), Util::formatCostRelative(cost, total));
+        }
+    }
+    QToolTip::showText(helpEvent->globalPos(), text, this);
+    return true;
+}
@@ -0,0 +1,83 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QCache>
+#include <QWidget>
+
+#include <atomic>
+#include <memory>
+
+#include "models/data.h"
+#include "models/stackhistogram.h"
+
+class QTreeView;
+
+class FilterAndZoomStack;
+
+// a track above the timeline, showing how the costs of the top functions or binaries change over time
+// the buckets follow the zoom of the timeline and get aggregated in the background, once per zoom level
+class StackHistogramView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit StackHistogramView(FilterAndZoomStack* filterAndZoomStack, QTreeView* timeLineView,
+                                QWidget* parent = nullptr);
+    ~StackHistogramView() override;
+
+    void setData(const Data::EventResults& events, const Data::BottomUpResults& bottomUp, Data::TimeRange time);
+    void setCostType(int costType);
+    void setGrouping(StackHistogram::Grouping grouping);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void showEvent(QShowEvent* event) override;
+    bool event(QEvent* event) override;
+
+private:
+    struct Key
+    {
+        Data::TimeRange time;
+        int costType = 0;
+        int numBuckets = 0;
+
+        bool operator==(const Key& rhs) const
+        {
+            return time == rhs.time && costType == rhs.costType && numBuckets == rhs.numBuckets;
+        }
+    };
+    friend uint qHash(const Key& key, uint seed);
+
+    // drops the aggregated buckets, e.g. when the data changed
+    void reset();
+    void updateBuckets();
+    Key currentKey() const;
+    // the area of the events column of the timeline
+    QRect eventsRect() const;
+
+    // the approximate width of a bucket in pixels
+    static const constexpr int BucketWidth = 4;
+    static const constexpr int TopEntries = 8;
+    // of the labels in the tooltips
+    static const constexpr int MaxLabelWidth = 600;
+    // the number of zoom levels whose buckets get cached
+    static const constexpr int MaxCachedBuckets = 32;
+
+    FilterAndZoomStack* m_filterAndZoomStack = nullptr;
+    QTreeView* m_timeLineView = nullptr;
+    Data::EventResults m_events;
+    Data::BottomUpResults m_bottomUp;
+    Data::TimeRange m_time;
+    int m_costType = 0;
+    StackHistogram::Grouping m_grouping = StackHistogram::Grouping::Symbols;
+    // resolving the stacks is the expensive part, so this gets built once and reused for every zoom level
+    std::shared_ptr<const StackHistogram> m_histogram;
+    QCache<Key, StackHistogram::Buckets> m_cache;
+    StackHistogram::Buckets m_buckets;
+    Key m_bucketsKey;
+    std::atomic<uint> m_currentJobId {0};
+};
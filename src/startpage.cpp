@@ -13,8 +13,13 @@
 #include <QMainWindow>
 #include <QPainter>
 
+#include <KColorScheme>
 #include <KFormat>
 
+#include "models/data.h"
+#include "settings.h"
+#include "util.h"
+
 StartPage::StartPage(QWidget* parent)
     : QWidget(parent)
     , ui(std::make_unique<Ui::StartPage>())
@@ -24,7 +29,24 @@ StartPage::StartPage(QWidget* parent)
     connect(ui->openFileButton, &QAbstractButton::clicked, this, &StartPage::openFileButtonClicked);
     connect(ui->recordDataButton, &QAbstractButton::clicked, this, &StartPage::recordButtonClicked);
     connect(ui->stopParseButton, &QAbstractButton::clicked, this, &StartPage::stopParseButtonClicked);
+    connect(ui->viewPartialResultsButton, &QAbstractButton::clicked, this,
+            &StartPage::viewPartialResultsButtonClicked);
+    ui->viewPartialResultsButton->hide();
     connect(ui->pathSettings, &QAbstractButton::clicked, this, &StartPage::pathSettingsButtonClicked);
+
+    // the restriction applies to the next opened file, invalid ones get highlighted
+    auto* settings = Settings::instance();
+    ui->parseRestriction->setText(settings->parseRestriction());
+    connect(ui->parseRestriction, &QLineEdit::textChanged, settings, &Settings::setParseRestriction);
+    connect(ui->parseRestriction, &QLineEdit::textChanged, this, [this](const QString& restriction) {
+        const auto colorScheme = KColorScheme();
+        auto palette = ui->parseRestriction->palette();
+        palette.setBrush(QPalette::Text,
+                         Data::ParseRestriction::fromString(restriction)
+                             ? colorScheme.foreground()
+                             : colorScheme.foreground(KColorScheme::NegativeText));
+        ui->parseRestriction->setPalette(palette);
+    });
     ui->openFileButton->setFocus();
 
     updateBackground();
@@ -42,9 +64,11 @@ void StartPage::showParseFileProgress()
 {
     ui->loadingResultsErrorLabel->hide();
     ui->loadStack->setCurrentWidget(ui->parseProgressPage);
+    ui->viewPartialResultsButton->hide();
 
     // Reset maximum to show throbber, we may not get progress notifications
     ui->openFileProgressBar->setMaximum(0);
+    ui->parseProgressLabel->clear();
 }
 
 void StartPage::onOpenFileError(const QString& errorMessage)
@@ -55,6 +79,11 @@ void StartPage::onOpenFileError(const QString& errorMessage)
     ui->loadStack->setCurrentWidget(ui->openFilePage);
 }
 
+void StartPage::onPartialResultsAvailable()
+{
+    ui->viewPartialResultsButton->show();
+}
+
 void StartPage::onParseFileProgress(float percent)
 {
     ui->loadStack->setCurrentWidget(ui->parseProgressPage);
@@ -66,6 +95,11 @@ void StartPage::onParseFileProgress(float percent)
     ui->openFileProgressBar->setValue(static_cast<int>(percent * scale));
 }
 
+void StartPage::onParseProgress(const Data::ParseProgress& progress)
+{
+    ui->parseProgressLabel->setText(Util::formatParseProgress(progress));
+}
+
 void StartPage::onDebugInfoDownloadProgress(const QString& module, const QString& url, qint64 numerator,
                                             qint64 denominator)
 {
@@ -16,6 +16,10 @@ namespace Ui {
 class StartPage;
 }
 
+namespace Data {
+struct ParseProgress;
+}
+
 class QMenu;
 
 class StartPage : public QWidget
@@ -35,12 +39,15 @@ protected:
 public slots:
     void onOpenFileError(const QString& errorMessage);
     void onParseFileProgress(float percent);
+    void onParseProgress(const Data::ParseProgress& progress);
+    void onPartialResultsAvailable();
     void onDebugInfoDownloadProgress(const QString& module, const QString& url, qint64 numerator, qint64 denominator);
 
 signals:
     void openFileButtonClicked();
     void recordButtonClicked();
     void stopParseButtonClicked();
+    void viewPartialResultsButtonClicked();
     void pathSettingsButtonClicked();
 
 private:
@@ -0,0 +1,121 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "symboltimeseriesplot.h"
+
+#include <QHelpEvent>
+#include <QPainter>
+#include <QToolTip>
+
+#include "util.h"
+
+#include <algorithm>
+#include <numeric>
+
+SymbolTimeSeriesPlot::SymbolTimeSeriesPlot(QWidget* parent)
+    : QWidget(parent)
+{
+    setMinimumHeight(7 * fontMetrics().height());
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+SymbolTimeSeriesPlot::~SymbolTimeSeriesPlot() = default;
+
+void SymbolTimeSeriesPlot::setSeries(const QString& symbol, const SymbolTimeSeries& series)
+{
+    m_symbol = symbol;
+    m_series = series;
+    m_maxCost = series.isEmpty() ? 0 : *std::max_element(series.inclusiveCosts.begin(), series.inclusiveCosts.end());
+    update();
+}
+
+QRect SymbolTimeSeriesPlot::plotRect() const
+{
+    const auto lineHeight = fontMetrics().height();
+    return rect().adjusted(0, lineHeight, 0, -lineHeight);
+}
+
+void SymbolTimeSeriesPlot::paintEvent(QPaintEvent* /*event*/)
+{
+    QPainter painter(this);
+    const auto rect = plotRect();
+    painter.fillRect(rect, palette().base());
+
+    if (m_symbol.isEmpty() || m_series.isEmpty() || !m_maxCost) {
+        painter.setPen(palette().color(QPalette::PlaceholderText));
+        painter.drawText(rect, Qt::AlignCenter,
+                         m_symbol.isEmpty() ? tr("Select a symbol to see its cost over time")
+                                            : tr("No samples of %1 over time").arg(m_symbol));
+        return;
+    }
+
+    painter.setPen(palette().color(QPalette::WindowText));
+    const auto title = tr("%1, max. %2 per bucket").arg(m_symbol, Util::formatCost(m_maxCost));
+    painter.drawText(QRect(0, 0, width(), rect.top()), Qt::AlignLeft | Qt::AlignVCenter,
+                     fontMetrics().elidedText(title, Qt::ElideMiddle, width()));
+    const auto bottomLabels = QRect(0, rect.bottom() + 1, width(), height() - rect.bottom() - 1);
+    painter.drawText(bottomLabels, Qt::AlignLeft | Qt::AlignVCenter, Util::formatTimeString(0));
+    painter.drawText(bottomLabels, Qt::AlignRight | Qt::AlignVCenter,
+                     Util::formatTimeString(m_series.time.delta()));
+
+    const auto numBuckets = m_series.numBuckets();
+    const auto yMultiplicator = static_cast<double>(rect.height()) / m_maxCost;
+    const auto highlight = palette().color(QPalette::Highlight);
+    auto inclusiveColor = highlight;
+    inclusiveColor.setAlpha(90);
+    auto bucketRect = [&](int bucket, quint64 cost) {
+        const auto left = rect.x() + bucket * rect.width() / numBuckets;
+        const auto right = rect.x() + (bucket + 1) * rect.width() / numBuckets - 1;
+        const auto top = rect.bottom() - static_cast<int>(cost * yMultiplicator);
+        return QRect(QPoint(left, top), QPoint(right, rect.bottom()));
+    };
+    for (int bucket = 0; bucket < numBuckets; ++bucket) {
+        painter.fillRect(bucketRect(bucket, m_series.inclusiveCosts[bucket]), inclusiveColor);
+        painter.fillRect(bucketRect(bucket, m_series.selfCosts[bucket]), highlight);
+    }
+
+    // the mean level of every phase, separated by the change points
+    painter.setPen(QPen(palette().color(QPalette::WindowText), 1, Qt::DashLine));
+    for (int phase = 0, numPhases = m_series.changePoints.size() + 1; phase < numPhases; ++phase) {
+        const auto begin = phase == 0 ? 0 : m_series.changePoints[phase - 1];
+        const auto end = phase == numPhases - 1 ? numBuckets : m_series.changePoints[phase];
+        const auto cost = std::accumulate(m_series.inclusiveCosts.begin() + begin,
+                                          m_series.inclusiveCosts.begin() + end, quint64(0));
+        const auto left = rect.x() + begin * rect.width() / numBuckets;
+        const auto right = rect.x() + end * rect.width() / numBuckets;
+        const auto y = rect.bottom() - static_cast<int>(cost / (end - begin) * yMultiplicator);
+        painter.drawLine(left, y, right, y);
+        if (phase > 0) {
+            painter.drawLine(left, rect.top(), left, rect.bottom());
+        }
+    }
+}
+
+bool SymbolTimeSeriesPlot::event(QEvent* event)
+{
+    if (event->type() != QEvent::ToolTip) {
+        return QWidget::event(event);
+    }
+
+    const auto* helpEvent = static_cast<QHelpEvent*>(event);
+    const auto rect = plotRect();
+    const auto x = helpEvent->pos().x() - rect.x();
+    if (m_series.isEmpty() || x < 0 || x >= rect.width()) {
+        QToolTip::hideText();
+        event->ignore();
+        return true;
+    }
+
+    const auto bucket = x * m_series.numBuckets() / rect.width();
+    const auto time = m_series.bucketTime(bucket);
+    const auto text = tr("time: %1 - %2\ninclusive cost: %3\nself cost: %4")
+                          .arg(Util::formatTimeString(time.start - m_series.time.start),
+                               Util::formatTimeString(time.end - m_series.time.start),
+                               Util::formatCost(m_series.inclusiveCosts[bucket]),
+                               Util::formatCost(m_series.selfCosts[bucket]));
+    QToolTip::showText(helpEvent->globalPos(), text, this);
+    return true;
+}
@@ -0,0 +1,36 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QWidget>
+
+#include "models/symboltimeseries.h"
+
+// the detail plot of the SymbolTimeSeries of the current row of the bottom up and caller/callee views
+// it shows the inclusive and self cost per bucket along with the phases found by the change point detection
+class SymbolTimeSeriesPlot : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit SymbolTimeSeriesPlot(QWidget* parent = nullptr);
+    ~SymbolTimeSeriesPlot() override;
+
+    // an empty @p series shows a placeholder, e.g. while it gets computed
+    void setSeries(const QString& symbol, const SymbolTimeSeries& series);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    bool event(QEvent* event) override;
+
+private:
+    // the area of the bars, without the labels
+    QRect plotRect() const;
+
+    QString m_symbol;
+    SymbolTimeSeries m_series;
+    quint64 m_maxCost = 0;
+};
@@ -7,36 +7,54 @@
 
 #include "timelinewidget.h"
 
+#include "concurrencyview.h"
 #include "filterandzoomstack.h"
+#include "jobscheduler.h"
+#include "models/concurrencyprofile.h"
 #include "models/eventmodel.h"
 #include "resultsutil.h"
+#include "stackhistogramview.h"
 #include "timelinedelegate.h"
+#include "wakeupgraph.h"
 
 #include "data.h"
 #include "parsers/perf/perfparser.h"
+#include "settings.h"
+
+#include <hotspot-config.h>
 
 #include <QLabel>
+#include <QMutex>
+#if QtOpenGLWidgets_FOUND
+#include <QOpenGLWidget>
+#endif
 #include <QPointer>
 #include <QProgressBar>
 #include <QSortFilterProxyModel>
 #include <QVBoxLayout>
 
 #include <KLocalizedString>
-#include <ThreadWeaver/ThreadWeaver>
 
 #include <timeaxisheaderview.h>
 
 #include <ui_timelinewidget.h>
 
+// the stacks as shown with folded inlines, indexed once per results by the first job that needs them
+struct FoldedStackIndex
+{
+    QMutex mutex;
+    Data::StackIndex index;
+};
+
 namespace {
 template<typename Context, typename Job, typename SetData>
 void scheduleJob(Context* context, std::atomic<uint>* currentJobId, Job&& job, SetData&& setData)
 {
-    using namespace ThreadWeaver;
     const auto jobId = ++(*currentJobId);
     const auto smartContext = QPointer<Context>(context);
     auto jobCancelled = [=]() { return !smartContext || jobId != (*currentJobId); };
-    stream() << make_job([=]() {
+    // the user waits for the stacks of the selection or of the hovered events
+    JobScheduler::run(JobScheduler::Priority::Interactive, [=]() {
         auto results = job(jobCancelled);
 
         QMetaObject::invokeMethod(
@@ -49,6 +67,35 @@ void scheduleJob(Context* context, std::atomic<uint>* currentJobId, Job&& job, S
             Qt::QueuedConnection);
     });
 }
+
+// returns the index of the stacks for looking them up in a job, it gets built by the parser once everything got
+// parsed, so only partial results need to build it on their own
+// @p folded is only passed when the lookup needs the frames as shown with folded inlines
+std::function<Data::StackIndex()> stackIndexJob(const PerfParser* parser,
+                                                const std::shared_ptr<FoldedStackIndex>& folded = {})
+{
+    auto index = parser->stackIndex();
+    if (index.isEmpty()) {
+        return [bottomUpResults = parser->bottomUpResults(), stacks = parser->eventResults().stacks,
+                foldInlines = Settings::instance()->foldInlines()]() mutable {
+            bottomUpResults.foldInlines = foldInlines;
+            return Data::StackIndex(bottomUpResults, stacks);
+        };
+    }
+    // the prebuilt index keeps the inlined frames, which is fine to look up a symbol but it doesn't know the
+    // prefixes of the stacks as shown when the inlines get folded, those get indexed once per results
+    if (!folded) {
+        return [index]() { return index; };
+    }
+    return [bottomUpResults = parser->bottomUpResults(), stacks = parser->eventResults().stacks, folded]() mutable {
+        QMutexLocker locker(&folded->mutex);
+        if (folded->index.isEmpty()) {
+            bottomUpResults.foldInlines = true;
+            folded->index = Data::StackIndex(bottomUpResults, stacks);
+        }
+        return folded->index;
+    };
+}
 }
 
 TimeLineWidget::TimeLineWidget(PerfParser* parser, QMenu* filterMenu, FilterAndZoomStack* filterAndZoomStack,
@@ -57,6 +104,7 @@ TimeLineWidget::TimeLineWidget(PerfParser* parser, QMenu* filterMenu, FilterAndZ
     , ui(new Ui::TimeLineWidget)
     , m_parser(parser)
     , m_filterAndZoomStack(filterAndZoomStack)
+    , m_foldedStackIndex(std::make_shared<FoldedStackIndex>())
 {
     ui->setupUi(this);
 
@@ -79,12 +127,51 @@ TimeLineWidget::TimeLineWidget(PerfParser* parser, QMenu* filterMenu, FilterAndZ
     ui->timeLineEventFilterButton->setMenu(filterMenu);
     ui->timeLineView->setItemDelegateForColumn(EventModel::EventsColumn, m_timeLineDelegate);
 
+    auto setHardwareAcceleration = [this](bool enabled) {
+#if QtOpenGLWidgets_FOUND
+        // with an OpenGL viewport, QPainter uses the OpenGL paint engine which also keeps
+        // the cached row tiles of the delegate around as textures
+        const bool isAccelerated = qobject_cast<QOpenGLWidget*>(ui->timeLineView->viewport());
+        if (enabled == isAccelerated)
+            return;
+        ui->timeLineView->setViewport(enabled ? new QOpenGLWidget : new QWidget);
+        m_timeLineDelegate->viewportChanged();
+#else
+        Q_UNUSED(enabled);
+#endif
+    };
+    setHardwareAcceleration(Settings::instance()->hardwareAcceleratedTimeline());
+    connect(Settings::instance(), &Settings::hardwareAcceleratedTimelineChanged, this, setHardwareAcceleration);
+
     m_timeAxisHeaderView = new TimeAxisHeaderView(m_filterAndZoomStack, ui->timeLineView);
     ui->timeLineView->setHeader(m_timeAxisHeaderView);
 
+    m_stackHistogramView = new StackHistogramView(m_filterAndZoomStack, ui->timeLineView, this);
+    m_stackHistogramView->hide();
+    ui->verticalLayout->insertWidget(1, m_stackHistogramView);
+    ui->timeLineHistogram->addItem(tr("None"));
+    ui->timeLineHistogram->addItem(tr("Top Functions"), QVariant::fromValue(StackHistogram::Grouping::Symbols));
+    ui->timeLineHistogram->addItem(tr("Top Binaries"), QVariant::fromValue(StackHistogram::Grouping::Binaries));
+    connect(ui->timeLineHistogram, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this,
+            [this](int index) {
+                const auto grouping = ui->timeLineHistogram->itemData(index);
+                if (grouping.isValid()) {
+                    m_stackHistogramView->setGrouping(grouping.value<StackHistogram::Grouping>());
+                }
+                m_stackHistogramView->setVisible(grouping.isValid());
+            });
+
+    m_concurrencyView = new ConcurrencyView(m_filterAndZoomStack, ui->timeLineView, this);
+    m_concurrencyView->hide();
+    ui->verticalLayout->insertWidget(1, m_concurrencyView);
+    connect(ui->timeLineConcurrency, &QCheckBox::toggled, m_concurrencyView, &ConcurrencyView::setVisible);
+
     connect(timeLineProxy, &QAbstractItemModel::rowsInserted, this, [this]() { ui->timeLineView->expandToDepth(1); });
     connect(timeLineProxy, &QAbstractItemModel::modelReset, this, [this]() { ui->timeLineView->expandToDepth(1); });
 
+    connect(m_parser, &PerfParser::stackIndexAvailable, this,
+            [this]() { m_foldedStackIndex = std::make_shared<FoldedStackIndex>(); });
+
     connect(m_parser, &PerfParser::bottomUpDataAvailable, this, [this](const Data::BottomUpResults& data) {
         ResultsUtil::fillEventSourceComboBox(ui->timeLineEventSource, data.costs, tr("Show timeline for %1 events."));
     });
@@ -93,6 +180,7 @@ TimeLineWidget::TimeLineWidget(PerfParser* parser, QMenu* filterMenu, FilterAndZ
         eventModel->setData(data);
         ui->timeLineView->sortByColumn(EventModel::ThreadColumn, Qt::AscendingOrder);
         m_timeAxisHeaderView->setTimeRange(eventModel->timeRange());
+        m_stackHistogramView->setData(data, m_parser->bottomUpResults(), eventModel->timeRange());
         if (data.offCpuTimeCostId != -1) {
             // remove the off-CPU time event source, we only want normal sched switches
             for (int i = 0, c = ui->timeLineEventSource->count(); i < c; ++i) {
@@ -102,6 +190,32 @@ TimeLineWidget::TimeLineWidget(PerfParser* parser, QMenu* filterMenu, FilterAndZ
                 }
             }
         }
+
+        // the tracepoints got published before the events, connect the off-CPU time with the wakeups in the background
+        const auto tracepoints = m_parser->tracepointResults();
+        scheduleJob(
+            m_timeLineDelegate, &m_currentWakeupGraphJobId,
+            [data, tracepoints](auto jobCancelled) -> std::shared_ptr<const WakeupGraph> {
+                if (data.offCpuTimeCostId == -1 || tracepoints.tables.isEmpty() || jobCancelled())
+                    return {};
+                return std::make_shared<const WakeupGraph>(data, tracepoints);
+            },
+            [this](const std::shared_ptr<const WakeupGraph>& wakeupGraph) {
+                m_timeLineDelegate->setWakeupGraph(wakeupGraph);
+            });
+
+        const auto timeRange = eventModel->timeRange();
+        m_concurrencyView->setProfile({}, timeRange);
+        scheduleJob(
+            m_concurrencyView, &m_currentConcurrencyJobId,
+            [data](auto jobCancelled) -> std::shared_ptr<const ConcurrencyProfile> {
+                if (jobCancelled())
+                    return {};
+                return std::make_shared<const ConcurrencyProfile>(data);
+            },
+            [this, timeRange](const std::shared_ptr<const ConcurrencyProfile>& profile) {
+                m_concurrencyView->setProfile(profile, timeRange);
+            });
     });
 
     connect(m_parser, &PerfParser::tracepointDataAvailable, this,
@@ -111,42 +225,12 @@ TimeLineWidget::TimeLineWidget(PerfParser* parser, QMenu* filterMenu, FilterAndZ
             [this](int index) {
                 const auto typeId = ui->timeLineEventSource->itemData(index).toInt();
                 m_timeLineDelegate->setEventType(typeId);
+                m_stackHistogramView->setCostType(typeId);
             });
+    connect(ui->timeLineCpuHeatmap, &QCheckBox::toggled, m_timeLineDelegate, &TimeLineDelegate::setCpuHeatmap);
 
-    connect(m_timeLineDelegate, &TimeLineDelegate::stacksHovered, this, [this](const QSet<qint32>& stackIds) {
-        if (stackIds.isEmpty()) {
-            ++m_currentHoverStacksJobId;
-            emit stacksHovered({});
-            return;
-        }
-
-        const auto& stacks = m_parser->eventResults().stacks;
-        const auto& bottomUpResults = m_parser->bottomUpResults();
-
-        scheduleJob(
-            this, &m_currentHoverStacksJobId,
-            [stacks, bottomUpResults, stackIds](auto jobCancelled) -> QVector<QVector<Data::Symbol>> {
-                QVector<QVector<Data::Symbol>> hovered;
-                hovered.reserve(stackIds.size());
-                for (auto stackId : stackIds) {
-                    if (jobCancelled())
-                        return {};
-                    const auto& stack = stacks[stackId];
-                    QVector<Data::Symbol> symbols;
-                    symbols.reserve(stack.size());
-                    bottomUpResults.foreachFrame(stack, [&](const Data::Symbol& frame, const Data::Location&) {
-                        if (jobCancelled())
-                            return false;
-                        symbols.append(frame);
-                        return true;
-                    });
-                    hovered.append(std::move(symbols));
-                }
-
-                return hovered;
-            },
-            [this](const QVector<QVector<Data::Symbol>>& hovered) { emit stacksHovered(hovered); });
-    });
+    // the flame graph maps the stacks onto its nodes, see FlameGraph::setHoveredStacks
+    connect(m_timeLineDelegate, &TimeLineDelegate::stacksHovered, this, &TimeLineWidget::stacksHovered);
 }
 
 TimeLineWidget::~TimeLineWidget() = default;
@@ -159,31 +243,14 @@ void TimeLineWidget::selectSymbol(const Data::Symbol& symbol)
         return;
     }
 
-    const auto& stacks = m_parser->eventResults().stacks;
-    const auto& bottomUpResults = m_parser->bottomUpResults();
-
     scheduleJob(
         m_timeLineDelegate, &m_currentSelectStackJobId,
-        [stacks, bottomUpResults, symbol](auto jobCancelled) -> QSet<qint32> {
-            const auto numStacks = stacks.size();
-            QSet<qint32> selectedStacks;
-            selectedStacks.reserve(numStacks);
-            for (int i = 0; i < numStacks; ++i) {
-                if (jobCancelled())
-                    return {};
-                bool symbolFound = false;
-                bottomUpResults.foreachFrame(stacks[i], [&](const Data::Symbol& frame, const Data::Location&) {
-                    if (jobCancelled())
-                        return false;
-                    symbolFound = (frame == symbol);
-                    // break once we find the symbol we are looking for
-                    return !symbolFound;
-                });
-                if (symbolFound)
-                    selectedStacks.insert(i);
-            }
-
-            return selectedStacks;
+        [stackIndex = stackIndexJob(m_parser), symbol](auto jobCancelled) -> QSet<qint32> {
+            const auto index = stackIndex();
+            if (jobCancelled())
+                return {};
+            const auto stackIds = index.stacksWithSymbol(symbol);
+            return QSet<qint32>(stackIds.begin(), stackIds.end());
         },
         [this](const QSet<qint32>& selectedStacks) { m_timeLineDelegate->setSelectedStacks(selectedStacks); });
 }
@@ -196,48 +263,19 @@ void TimeLineWidget::selectStack(const QVector<Data::Symbol>& stack, bool bottom
         return;
     }
 
-    const auto& stacks = m_parser->eventResults().stacks;
-    const auto& bottomUpResults = m_parser->bottomUpResults();
-
     scheduleJob(
         m_timeLineDelegate, &m_currentSelectStackJobId,
-        [stacks, bottomUpResults, stack, bottomUp](auto jobCancelled) -> QSet<qint32> {
-            const auto numStacks = stacks.size();
-            QSet<qint32> selectedStacks;
-            selectedStacks.reserve(numStacks);
-            QVarLengthArray<Data::Symbol, 64> frames;
-            for (int i = 0; i < numStacks; ++i) {
-                if (jobCancelled())
-                    return {};
-
-                frames.clear();
-                bottomUpResults.foreachFrame(stacks[i], [&](const Data::Symbol& frame, const Data::Location&) {
-                    if (jobCancelled())
-                        return false;
-                    frames.append(frame);
-                    return true;
-                });
-
-                if (jobCancelled())
-                    return {};
-
-                if (frames.size() < stack.size())
-                    continue;
-
-                const auto matches = [&]() {
-                    if (bottomUp) {
-                        return std::equal(frames.begin(), std::next(frames.begin(), stack.size()), stack.rbegin(),
-                                          stack.rend());
-                    } else {
-                        return std::equal(frames.rbegin(), std::next(frames.rbegin(), stack.size()), stack.rbegin(),
-                                          stack.rend());
-                    }
-                }();
-                if (matches)
-                    selectedStacks.insert(i);
-            }
-
-            return selectedStacks;
+        [stackIndex = stackIndexJob(m_parser, Settings::instance()->foldInlines() ? m_foldedStackIndex : nullptr),
+         stack, bottomUp](auto jobCancelled) -> QSet<qint32> {
+            const auto index = stackIndex();
+            if (jobCancelled())
+                return {};
+            // the stack starts at the selected frame, the index wants the frames from the first level of the view
+            const auto frames = QVector<Data::Symbol>(stack.rbegin(), stack.rend());
+            const auto direction =
+                bottomUp ? Data::StackIndex::Direction::FromLeaf : Data::StackIndex::Direction::FromOutermostCaller;
+            const auto stackIds = index.stacksWithPrefix(frames, direction);
+            return QSet<qint32>(stackIds.begin(), stackIds.end());
         },
         [this](const QSet<qint32>& selectedStacks) { m_timeLineDelegate->setSelectedStacks(selectedStacks); });
 }
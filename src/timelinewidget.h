@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <QSet>
 #include <QWidget>
 
 #include <atomic>
@@ -20,10 +21,14 @@ namespace Data {
 struct Symbol;
 }
 
+struct FoldedStackIndex;
+
 class PerfParser;
 class FilterAndZoomStack;
 class TimeLineDelegate;
 class TimeAxisHeaderView;
+class StackHistogramView;
+class ConcurrencyView;
 
 class QMenu;
 
@@ -39,7 +44,8 @@ public:
     void selectStack(const QVector<Data::Symbol>& stack, bool bottomUp);
 
 signals:
-    void stacksHovered(const QVector<QVector<Data::Symbol>>& stacks);
+    // the ids of the hovered stacks, see Data::EventResults::stacks
+    void stacksHovered(const QSet<qint32>& stackIds);
 
 private:
     std::unique_ptr<Ui::TimeLineWidget> ui;
@@ -48,6 +54,11 @@ private:
     FilterAndZoomStack* m_filterAndZoomStack = nullptr;
     TimeLineDelegate* m_timeLineDelegate = nullptr;
     TimeAxisHeaderView* m_timeAxisHeaderView = nullptr;
+    StackHistogramView* m_stackHistogramView = nullptr;
+    ConcurrencyView* m_concurrencyView = nullptr;
     std::atomic<uint> m_currentSelectStackJobId;
-    std::atomic<uint> m_currentHoverStacksJobId;
+    std::atomic<uint> m_currentWakeupGraphJobId;
+    std::atomic<uint> m_currentConcurrencyJobId;
+    // replaced whenever the parser built its index for new results
+    std::shared_ptr<FoldedStackIndex> m_foldedStackIndex;
 };
@@ -9,20 +9,25 @@
 
 #include "hotspot-config.h"
 
+#include <QCache>
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
 #include <QFileInfo>
 #include <QFontMetrics>
+#include <QHash>
+#include <QMutex>
 #include <QProcessEnvironment>
 #include <QStandardPaths>
 
+#include <algorithm>
 #include <initializer_list>
 
 #include "data.h"
 #include "settings.h"
 
 #include <kcoreaddons_version.h>
+#include <KFormat>
 
 #if KCOREADDONS_VERSION >= QT_VERSION_CHECK(5, 86, 0)
 #include <KPluginFactory>
@@ -130,6 +135,28 @@ QString formatTooltipImpl(int id, const QString& text, const Data::Costs* selfCo
     }
     return QString(QLatin1String("<qt>") + toolTip + QLatin1String("</qt>"));
 }
+
+// the views format the same symbols over and over again while painting, cache the result per interned symbol
+// the key contains the settings that influence the result, so no invalidation is required when they change
+struct FormattedSymbolCache
+{
+    static quint64 key(qint32 internId, bool prettify, int collapseDepth)
+    {
+        // collapseDepth is -1 when templates are not collapsed
+        const auto depth = quint64(quint32(collapseDepth + 1) & 0x7fffffff);
+        return (quint64(quint32(internId)) << 32) | (depth << 1) | quint64(prettify);
+    }
+
+    QMutex mutex;
+    // the ids never get reused, so the cache is bounded by the characters of the strings instead of cleared
+    QCache<quint64, QString> symbols {8 * 1024 * 1024};
+};
+
+FormattedSymbolCache& formattedSymbolCache()
+{
+    static FormattedSymbolCache cache;
+    return cache;
+}
 }
 
 QString Util::collapseTemplate(const QString& str, int level)
@@ -258,11 +285,37 @@ QString Util::formatString(const QString& input, bool replaceEmptyString)
 
 QString Util::formatSymbol(const Data::Symbol& symbol, bool replaceEmptyString)
 {
-    QString symbolString = Settings::instance()->prettifySymbols() ? symbol.prettySymbol : symbol.symbol;
-    if (Settings::instance()->collapseTemplates()) {
-        symbolString = collapseTemplate(symbolString, Settings::instance()->collapseDepth());
+    const auto prettify = Settings::instance()->prettifySymbols();
+    const auto collapseDepth = Settings::instance()->collapseTemplates() ? Settings::instance()->collapseDepth() : -1;
+
+    auto formatSymbolString = [&]() {
+        QString symbolString = prettify ? symbol.prettySymbol() : symbol.symbol;
+        if (collapseDepth != -1) {
+            symbolString = collapseTemplate(symbolString, collapseDepth);
+        }
+        return symbolString;
+    };
+
+    if (symbol.internId == -1) {
+        return formatString(formatSymbolString(), replaceEmptyString);
+    }
+
+    auto& cache = formattedSymbolCache();
+    const auto key = FormattedSymbolCache::key(symbol.internId, prettify, collapseDepth);
+    {
+        QMutexLocker lock(&cache.mutex);
+        if (const auto* cached = cache.symbols.object(key)) {
+            const auto symbolString = *cached;
+            lock.unlock();
+            return formatString(symbolString, replaceEmptyString);
+        }
     }
 
+    const auto symbolString = formatSymbolString();
+    {
+        QMutexLocker lock(&cache.mutex);
+        cache.symbols.insert(key, new QString(symbolString), std::max(1, symbolString.size()));
+    }
     return formatString(symbolString, replaceEmptyString);
 }
 
@@ -281,7 +334,7 @@ QString Util::formatCost(quint64 cost)
     return QString::number(static_cast<double>(cost), 'G', 4);
 }
 
-QString Util::formatCostRelative(quint64 selfCost, quint64 totalCost, bool addPercentSign)
+QString Util::formatCostRelative(qint64 selfCost, qint64 totalCost, bool addPercentSign)
 {
     if (!totalCost) {
         return {};
@@ -354,6 +407,45 @@ QString Util::formatFrequency(quint64 occurrences, quint64 nanoseconds)
     return QString::number(hz, 'G', 4) + QLatin1String(*unit);
 }
 
+QString Util::formatParseProgress(const Data::ParseProgress& progress)
+{
+    const auto format = KFormat();
+    QString phase;
+    switch (progress.phase) {
+    case Data::ParseProgress::Phase::Parse:
+        phase = QCoreApplication::translate("Util", "Unwinding and symbolizing");
+        break;
+    case Data::ParseProgress::Phase::Aggregate:
+        phase = QCoreApplication::translate("Util", "Aggregating");
+        break;
+    case Data::ParseProgress::Phase::DeriveViews:
+        phase = QCoreApplication::translate("Util", "Building the views");
+        break;
+    }
+
+    auto text = QCoreApplication::translate("Util", "%1: %2 records/s, %3/s, %4 stacks, %5 symbols, %6 resident")
+                    .arg(phase, QString::number(progress.recordsPerSecond, 'f', 0),
+                         format.formatByteSize(progress.bytesPerSecond, 1, KFormat::MetricBinaryDialect),
+                         QString::number(progress.uniqueStacks), QString::number(progress.uniqueSymbols),
+                         format.formatByteSize(progress.residentMemory, 1, KFormat::MetricBinaryDialect));
+    if (progress.remaining >= 0) {
+        text += QCoreApplication::translate("Util", ", %1 remaining")
+                    .arg(format.formatDuration(progress.remaining));
+    }
+    return text;
+}
+
+QString Util::formatDurationHistogram(const Data::DurationHistogram& histogram)
+{
+    if (histogram.isEmpty()) {
+        return {};
+    }
+    return QCoreApplication::translate("Util", "%1 times, median: %2, 90%: %3, 99%: %4, max: %5")
+        .arg(QString::number(histogram.count), formatTimeString(histogram.percentile(0.5)),
+             formatTimeString(histogram.percentile(0.9)), formatTimeString(histogram.percentile(0.99)),
+             formatTimeString(histogram.max));
+}
+
 QString Util::formatBinaryTooltip(int id, const Data::Symbol& symbol, const Data::Costs& costs)
 {
     return formatTooltipImpl(id, Util::formatString(symbol.binary), nullptr, &costs);
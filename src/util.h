@@ -20,6 +20,8 @@ struct Symbol;
 struct FileLine;
 struct LocationCost;
 class Costs;
+struct DurationHistogram;
+struct ParseProgress;
 using ItemCost = std::valarray<qint64>;
 }
 
@@ -55,9 +57,12 @@ QString formatString(const QString& input, bool replaceEmptyString = true);
 QString formatSymbol(const Data::Symbol& symbol, bool replaceEmptyString = true);
 QString formatSymbolExtended(const Data::Symbol& symbol);
 QString formatCost(quint64 cost);
-QString formatCostRelative(quint64 selfCost, quint64 totalCost, bool addPercentSign = false);
+QString formatCostRelative(qint64 selfCost, qint64 totalCost, bool addPercentSign = false);
 QString formatTimeString(quint64 nanoseconds, bool shortForm = false);
 QString formatFrequency(quint64 occurrences, quint64 nanoseconds);
+QString formatDurationHistogram(const Data::DurationHistogram& histogram);
+// a single line with the phase, throughput, memory and ETA
+QString formatParseProgress(const Data::ParseProgress& progress);
 QString formatBinaryTooltip(int id, const Data::Symbol& symbol, const Data::Costs& costs);
 QString formatTooltip(int id, const Data::Symbol& symbol, const Data::Costs& costs);
 QString formatTooltip(int id, const Data::Symbol& symbol, const Data::Costs& selfCosts,
@@ -0,0 +1,236 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QImage>
+#include <QObject>
+#include <QPainter>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QTest>
+#include <QTreeView>
+
+#include "../../src/parsers/perf/perfparser.h"
+#include "../testutils.h"
+#include "perfstreamgenerator.h"
+
+#include <models/callercalleeproxy.h>
+#include <models/costproxy.h>
+#include <models/eventmodel.h>
+#include <models/filterandzoomstack.h>
+#include <models/flamegraphdata.h>
+#include <models/timelinedelegate.h>
+
+namespace {
+// HOTSPOT_BENCHMARK_SAMPLES selects the size of the synthetic profile, see bench_perfparser.cpp
+quint64 numSamples()
+{
+    return qEnvironmentVariable("HOTSPOT_BENCHMARK_SAMPLES", QStringLiteral("100000")).toULongLong();
+}
+
+// the rows of the timeline, i.e. the CPUs and the threads of the processes
+QModelIndexList timeLineRows(const QAbstractItemModel& model, const QModelIndex& parent = {})
+{
+    QModelIndexList rows;
+    for (int row = 0, c = model.rowCount(parent); row < c; ++row) {
+        const auto index = model.index(row, EventModel::EventsColumn, parent);
+        const auto child = model.index(row, 0, parent);
+        if (model.rowCount(child)) {
+            rows += timeLineRows(model, child);
+        } else if (parent.isValid()) {
+            rows.push_back(index);
+        }
+    }
+    return rows;
+}
+}
+
+// measures what the user waits for when interacting with the result views, on a synthetic profile
+class BenchModels : public QObject
+{
+    Q_OBJECT
+public:
+    using QObject::QObject;
+
+private slots:
+    void initTestCase()
+    {
+        SyntheticProfile profile;
+        profile.numSamples = numSamples();
+        profile.numThreads = 16;
+        profile.costTypes = {QStringLiteral("cycles"), QStringLiteral("instructions")};
+
+        QVERIFY(m_file.open());
+        writeSyntheticPerfStream(&m_file, profile);
+        m_file.close();
+
+        PerfParser parser;
+        QSignalSpy finishedSpy(&parser, &PerfParser::parsingFinished);
+        connect(&parser, &PerfParser::topDownDataAvailable, this,
+                [this](const Data::TopDownResults& data) { m_topDown = data; });
+        parser.startParseFile(m_file.fileName());
+        QVERIFY(finishedSpy.wait(30 * 60 * 1000));
+
+        m_bottomUp = parser.bottomUpResults();
+        m_callerCallee = parser.callerCalleeResults();
+        m_events = parser.eventResults();
+        QVERIFY(!m_topDown.root.children.isEmpty());
+    }
+
+    void benchBottomUpModelReset()
+    {
+        BottomUpModel model;
+        QBENCHMARK {
+            model.setData(m_bottomUp);
+        }
+    }
+
+    void benchTopDownModelReset()
+    {
+        TopDownModel model;
+        QBENCHMARK {
+            model.setData(m_topDown);
+        }
+    }
+
+    void benchCallerCalleeModelReset()
+    {
+        CallerCalleeModel model;
+        QBENCHMARK {
+            model.setResults(m_callerCallee);
+        }
+    }
+
+    void benchEventModelReset()
+    {
+        EventModel model;
+        QBENCHMARK {
+            model.setData(m_events);
+        }
+    }
+
+    // clicking a column header, the tree models sort themselves through the proxy
+    void benchCostProxySort()
+    {
+        BottomUpModel model;
+        model.setData(m_bottomUp);
+        CostProxy<BottomUpModel> proxy;
+        proxy.setSourceModel(&model);
+        proxy.setSortRole(BottomUpModel::SortRole);
+
+        int column = BottomUpModel::InitialSortColumn;
+        QBENCHMARK {
+            // alternate between the cost types, as sorting by the current column again is a no-op
+            column = column == BottomUpModel::InitialSortColumn ? column + 1 : BottomUpModel::InitialSortColumn;
+            proxy.sort(column, Qt::DescendingOrder);
+        }
+    }
+
+    // every key stroke filters the proxy again, see ResultsUtil::connectFilter
+    void benchCallerCalleeProxyFilter()
+    {
+        CallerCalleeModel model;
+        model.setResults(m_callerCallee);
+        CallerCalleeProxy<CallerCalleeModel> proxy;
+        proxy.setSourceModel(&model);
+        proxy.setFilterKeyColumn(-1);
+        proxy.setFilterCaseSensitivity(Qt::CaseInsensitive);
+
+        const auto typed = QStringLiteral("func12");
+        QBENCHMARK {
+            for (int i = 1; i <= typed.size(); ++i) {
+                auto pattern = proxy.filterRegularExpression();
+                pattern.setPattern(QRegularExpression::escape(typed.left(i)));
+                proxy.setFilterRegularExpression(pattern);
+            }
+            proxy.setFilterRegularExpression(QString());
+        }
+    }
+
+    void benchTimeLineDelegatePaint_data()
+    {
+        QTest::addColumn<int>("zoomFactor");
+
+        for (int zoomFactor : {1, 10, 100, 1000}) {
+            QTest::addRow("zoom-%d", zoomFactor) << zoomFactor;
+        }
+    }
+
+    // paints all rows at once, the tiles of the large rows get rendered in the background and cached
+    void benchTimeLineDelegatePaint()
+    {
+        QFETCH(int, zoomFactor);
+
+        EventModel model;
+        model.setData(m_events);
+        QTreeView view;
+        view.setModel(&model);
+        FilterAndZoomStack filterAndZoomStack;
+        TimeLineDelegate delegate(&filterAndZoomStack, &view, nullptr);
+
+        const auto rows = timeLineRows(model);
+        QVERIFY(!rows.isEmpty());
+
+        // zoom into the middle of the recording
+        const auto time = Data::TimeRange(rows.first().data(EventModel::MinTimeRole).value<quint64>(),
+                                          rows.first().data(EventModel::MaxTimeRole).value<quint64>());
+        const auto zoomedDelta = time.delta() / zoomFactor;
+        const auto zoomStart = time.start + (time.delta() - zoomedDelta) / 2;
+        if (zoomFactor > 1) {
+            filterAndZoomStack.zoomIn({zoomStart, zoomStart + zoomedDelta});
+        }
+        const QSize rowSize(1920, 30);
+        QImage image(rowSize, QImage::Format_ARGB32_Premultiplied);
+        QStyleOptionViewItem option;
+        option.rect = QRect(QPoint(0, 0), rowSize);
+        option.palette = view.palette();
+
+        qint64 paintedRows = 0;
+        QBENCHMARK {
+            QPainter painter(&image);
+            for (const auto& row : rows) {
+                delegate.paint(&painter, option, row);
+                ++paintedRows;
+            }
+        }
+        QVERIFY(paintedRows > 0);
+    }
+
+    void benchFlameGraphBuild_data()
+    {
+        QTest::addColumn<bool>("bottomUp");
+        QTest::addColumn<bool>("collapseRecursion");
+
+        QTest::newRow("top-down") << false << false;
+        QTest::newRow("top-down-collapsed") << false << true;
+        QTest::newRow("bottom-up") << true << false;
+    }
+
+    // the data the flame graph scene gets built from
+    void benchFlameGraphBuild()
+    {
+        QFETCH(bool, bottomUp);
+        QFETCH(bool, collapseRecursion);
+
+        QBENCHMARK {
+            const auto data = bottomUp
+                ? FlameGraphData::build(m_bottomUp.costs, 0, m_bottomUp.root.children, 0, collapseRecursion, {})
+                : FlameGraphData::build(m_topDown.inclusiveCosts, 0, m_topDown.root.children, 0, collapseRecursion,
+                                        {});
+            QVERIFY(!data.isEmpty());
+        }
+    }
+
+private:
+    QTemporaryFile m_file;
+    Data::BottomUpResults m_bottomUp;
+    Data::TopDownResults m_topDown;
+    Data::CallerCalleeResults m_callerCallee;
+    Data::EventResults m_events;
+};
+
+QTEST_MAIN(BenchModels)
+
+#include "bench_models.moc"
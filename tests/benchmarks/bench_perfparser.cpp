@@ -0,0 +1,270 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QTest>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "../../src/parsers/perf/perfparser.h"
+#include "../testutils.h"
+#include "data.h"
+#include "perfstreamgenerator.h"
+
+namespace {
+// the synthetic fixtures get written by writeSyntheticPerfStream
+// HOTSPOT_BENCHMARK_SAMPLES=1000000,10000000,100000000 selects the sizes, the default keeps a ctest run short
+QVector<quint64> syntheticSizes()
+{
+    const auto sizes = qEnvironmentVariable("HOTSPOT_BENCHMARK_SAMPLES", QStringLiteral("100000"));
+    QVector<quint64> ret;
+    for (const auto& size : sizes.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        ret.push_back(size.trimmed().toULongLong());
+    }
+    return ret;
+}
+
+// HOTSPOT_BENCHMARK_FILES adds recorded perf.data or .perfparser files, separated by colons
+QStringList recordedFiles()
+{
+    auto files = qEnvironmentVariable("HOTSPOT_BENCHMARK_FILES").split(QLatin1Char(':'), Qt::SkipEmptyParts);
+    files.prepend(QFINDTESTDATA("../modeltests/callgraph.perfparser"));
+    return files;
+}
+
+qint64 peakRssInKiB()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+void report(const char* stage, quint64 numSamples, qint64 elapsedNs)
+{
+    const auto seconds = elapsedNs / 1E9;
+    qInfo().noquote() << QStringLiteral("%1: %2 samples in %3 ms, %4 samples/s, peak RSS %5 MiB")
+                             .arg(QLatin1String(stage), QString::number(numSamples),
+                                  QString::number(elapsedNs / 1E6, 'f', 1),
+                                  QString::number(seconds > 0 ? numSamples / seconds : 0, 'f', 0),
+                                  QString::number(peakRssInKiB() / 1024));
+}
+}
+
+// times the stages between parsing a file and filtering its results, run it with -iterations N for stable numbers
+class BenchPerfParser : public QObject
+{
+    Q_OBJECT
+public:
+    using QObject::QObject;
+
+private slots:
+    void initTestCase()
+    {
+        const QByteArray perfparserPath =
+            QCoreApplication::applicationDirPath().toUtf8() + QByteArrayLiteral("/perfparser");
+        qputenv("HOTSPOT_PERFPARSER", perfparserPath);
+
+        for (auto size : syntheticSizes()) {
+            auto file = std::make_unique<QTemporaryFile>();
+            QVERIFY(file->open());
+            SyntheticProfile profile;
+            profile.numSamples = size;
+            profile.costTypes = {QStringLiteral("cycles"), QStringLiteral("instructions")};
+            writeSyntheticPerfStream(file.get(), profile);
+            file->close();
+            m_fixtures[QStringLiteral("synthetic-%1").arg(size)] = file->fileName();
+            m_syntheticFiles.push_back(std::move(file));
+        }
+        for (const auto& file : recordedFiles()) {
+            m_fixtures[QFileInfo(file).fileName()] = file;
+        }
+    }
+
+    void benchParse_data()
+    {
+        addFixtureRows();
+    }
+
+    // from startParseFile to the summary, which gets published once finalize is done
+    // the derived results follow with parsingFinished
+    void benchParse()
+    {
+        QFETCH(QString, path);
+
+        quint64 numSamples = 0;
+        qint64 finalizedNs = 0;
+        QElapsedTimer timer;
+        QBENCHMARK {
+            PerfParser parser;
+            QSignalSpy finishedSpy(&parser, &PerfParser::parsingFinished);
+            QSignalSpy failedSpy(&parser, &PerfParser::parsingFailed);
+            connect(&parser, &PerfParser::summaryDataAvailable, this, [&](const Data::Summary& summary) {
+                numSamples = summary.sampleCount;
+                finalizedNs = timer.nsecsElapsed();
+            });
+
+            timer.start();
+            parser.startParseFile(path);
+            QVERIFY(finishedSpy.wait(WaitTimeout));
+            QCOMPARE(failedSpy.count(), 0);
+        }
+        report("parse and finalize", numSamples, finalizedNs);
+        report("parse including derived results", numSamples, timer.nsecsElapsed());
+    }
+
+    void benchFilter_data()
+    {
+        QTest::addColumn<QString>("path");
+        QTest::addColumn<QString>("filter");
+
+        for (auto it = m_fixtures.cbegin(); it != m_fixtures.cend(); ++it) {
+            for (const auto* filter : {"time", "cpu", "symbol", "binary"}) {
+                QTest::addRow("%s-%s", qPrintable(it->first), filter) << it->second << QString::fromLatin1(filter);
+            }
+        }
+    }
+
+    // the results of a filter get cached, so every filter is only applied once
+    void benchFilter()
+    {
+        QFETCH(QString, path);
+        QFETCH(QString, filter);
+
+        auto& parsed = parse(path);
+        const auto& events = parsed.parser->eventResults();
+        Data::FilterAction action;
+        if (filter == QLatin1String("time")) {
+            const auto time = parsed.summary.applicationTime;
+            if (!time.isValid() || events.threads.isEmpty()) {
+                QSKIP("no timeline to filter");
+            }
+            action.time = {time.start + time.delta() / 4, time.end - time.delta() / 4};
+        } else if (filter == QLatin1String("cpu")) {
+            auto hasEvents = [](const Data::CpuEvents& cpu) { return !cpu.events.isEmpty(); };
+            auto cpu = std::find_if(events.cpus.begin(), events.cpus.end(), hasEvents);
+            if (cpu == events.cpus.end()) {
+                QSKIP("no CPU to filter");
+            }
+            action.cpuId = cpu->cpuId;
+        } else {
+            const auto& rows = parsed.bottomUp.root.children;
+            auto cheaper = [&](const Data::BottomUp& lhs, const Data::BottomUp& rhs) {
+                return parsed.bottomUp.costs.cost(0, lhs.id) < parsed.bottomUp.costs.cost(0, rhs.id);
+            };
+            auto hottest = std::max_element(rows.begin(), rows.end(), cheaper);
+            QVERIFY(hottest != rows.end());
+            if (filter == QLatin1String("symbol")) {
+                action.excludeSymbols.insert(hottest->symbol);
+            } else {
+                action.excludeBinaries.insert(hottest->symbol.binary);
+            }
+        }
+
+        QSignalSpy finishedSpy(parsed.parser.get(), &PerfParser::parsingFinished);
+        QSignalSpy failedSpy(parsed.parser.get(), &PerfParser::parsingFailed);
+        QElapsedTimer timer;
+        QBENCHMARK_ONCE {
+            timer.start();
+            parsed.parser->filterResults(action);
+            QVERIFY(finishedSpy.wait(WaitTimeout));
+            QCOMPARE(failedSpy.count(), 0);
+        }
+        report("filter", parsed.summary.sampleCount, timer.nsecsElapsed());
+    }
+
+    void benchTopDown_data()
+    {
+        addFixtureRows();
+    }
+
+    void benchTopDown()
+    {
+        QFETCH(QString, path);
+
+        const auto& parsed = parse(path);
+        QElapsedTimer timer;
+        QBENCHMARK {
+            timer.start();
+            const auto topDown = Data::TopDownResults::fromBottomUp(parsed.bottomUp, false);
+            QVERIFY(!topDown.root.children.isEmpty());
+        }
+        report("top down", parsed.summary.sampleCount, timer.nsecsElapsed());
+    }
+
+    void benchCallerCallee_data()
+    {
+        addFixtureRows();
+    }
+
+    void benchCallerCallee()
+    {
+        QFETCH(QString, path);
+
+        const auto& parsed = parse(path);
+        QElapsedTimer timer;
+        QBENCHMARK {
+            timer.start();
+            Data::CallerCalleeResults callerCallee;
+            Data::callerCalleesFromBottomUpData(parsed.bottomUp, &callerCallee);
+            QVERIFY(!callerCallee.entries.isEmpty());
+        }
+        report("caller callee", parsed.summary.sampleCount, timer.nsecsElapsed());
+    }
+
+private:
+    struct Parsed
+    {
+        std::unique_ptr<PerfParser> parser;
+        Data::Summary summary;
+        Data::BottomUpResults bottomUp;
+    };
+
+    // large fixtures take a while
+    static const constexpr int WaitTimeout = 30 * 60 * 1000;
+
+    void addFixtureRows()
+    {
+        QTest::addColumn<QString>("path");
+        for (auto it = m_fixtures.cbegin(); it != m_fixtures.cend(); ++it) {
+            QTest::newRow(qPrintable(it->first)) << it->second;
+        }
+    }
+
+    // parses every fixture once for the benchmarks that start from the parsed results
+    Parsed& parse(const QString& path)
+    {
+        auto& parsed = m_parsed[path];
+        if (!parsed.parser) {
+            parsed.parser = std::make_unique<PerfParser>();
+            QSignalSpy finishedSpy(parsed.parser.get(), &PerfParser::parsingFinished);
+            connect(parsed.parser.get(), &PerfParser::summaryDataAvailable, this,
+                    [&parsed](const Data::Summary& summary) { parsed.summary = summary; });
+            parsed.parser->startParseFile(path);
+            VERIFY_OR_THROW(finishedSpy.wait(WaitTimeout));
+            parsed.bottomUp = parsed.parser->bottomUpResults();
+        }
+        return parsed;
+    }
+
+    // ordered, to get a stable order of the rows
+    std::map<QString, QString> m_fixtures;
+    std::vector<std::unique_ptr<QTemporaryFile>> m_syntheticFiles;
+    std::map<QString, Parsed> m_parsed;
+};
+
+QTEST_GUILESS_MAIN(BenchPerfParser)
+
+#include "bench_perfparser.moc"
@@ -0,0 +1,80 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+
+#include "perfstreamgenerator.h"
+
+// writes a synthetic .perfparser file that hotspot can open without perf, e.g. for scale tests
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    SyntheticProfile profile;
+    auto option = [](const QString& name, const QString& description, auto defaultValue) {
+        return QCommandLineOption(name, description, QStringLiteral("value"), QString::number(defaultValue));
+    };
+    const auto samples = option(QStringLiteral("samples"), QStringLiteral("number of samples"), profile.numSamples);
+    const auto threads = option(QStringLiteral("threads"), QStringLiteral("number of threads"), profile.numThreads);
+    const auto cpus = option(QStringLiteral("cpus"), QStringLiteral("number of CPUs"), profile.numCpus);
+    const auto binaries =
+        option(QStringLiteral("binaries"), QStringLiteral("number of libraries"), profile.numBinaries);
+    const auto symbols = option(QStringLiteral("symbols"), QStringLiteral("number of symbols"), profile.numSymbols);
+    const auto minDepth =
+        option(QStringLiteral("min-depth"), QStringLiteral("minimum stack depth"), profile.minStackDepth);
+    const auto maxDepth =
+        option(QStringLiteral("max-depth"), QStringLiteral("maximum stack depth"), profile.maxStackDepth);
+    const auto recursion = option(QStringLiteral("recursion"),
+                                  QStringLiteral("probability of a frame calling its own symbol again"),
+                                  profile.recursionProbability);
+    const auto costTypes = QCommandLineOption(QStringLiteral("cost-types"),
+                                              QStringLiteral("comma separated names of the cost types"),
+                                              QStringLiteral("names"), profile.costTypes.join(QLatin1Char(',')));
+    const auto period =
+        option(QStringLiteral("period"), QStringLiteral("time between two samples of a thread in ns"),
+               profile.samplePeriod);
+    const auto contextSwitches =
+        option(QStringLiteral("context-switches"),
+               QStringLiteral("samples of a thread between two context switches, 0 disables them"),
+               profile.contextSwitchInterval);
+    const auto seed = option(QStringLiteral("seed"), QStringLiteral("seed of the random numbers"), profile.seed);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Generates synthetic profiles in the format of perfparser."));
+    parser.addHelpOption();
+    parser.addOptions({samples, threads, cpus, binaries, symbols, minDepth, maxDepth, recursion, costTypes, period,
+                       contextSwitches, seed});
+    parser.addPositionalArgument(QStringLiteral("output"), QStringLiteral("the .perfparser file to write"));
+    parser.process(app);
+
+    const auto args = parser.positionalArguments();
+    if (args.size() != 1) {
+        parser.showHelp(1);
+    }
+
+    profile.numSamples = parser.value(samples).toULongLong();
+    profile.numThreads = parser.value(threads).toInt();
+    profile.numCpus = parser.value(cpus).toInt();
+    profile.numBinaries = parser.value(binaries).toInt();
+    profile.numSymbols = parser.value(symbols).toInt();
+    profile.minStackDepth = parser.value(minDepth).toInt();
+    profile.maxStackDepth = parser.value(maxDepth).toInt();
+    profile.recursionProbability = parser.value(recursion).toDouble();
+    profile.costTypes = parser.value(costTypes).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    profile.samplePeriod = parser.value(period).toULongLong();
+    profile.contextSwitchInterval = parser.value(contextSwitches).toInt();
+    profile.seed = parser.value(seed).toUInt();
+
+    QFile output(args.first());
+    if (!output.open(QIODevice::WriteOnly)) {
+        qWarning("failed to open %s: %s", qPrintable(output.fileName()), qPrintable(output.errorString()));
+        return 1;
+    }
+    writeSyntheticPerfStream(&output, profile);
+    return 0;
+}
@@ -0,0 +1,187 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "perfstreamgenerator.h"
+
+#include <QIODevice>
+#include <QRandomGenerator>
+#include <QVector>
+#include <QtEndian>
+
+#include <algorithm>
+#include <deque>
+
+namespace {
+struct Thread
+{
+    quint32 pid = 0;
+    quint32 tid = 0;
+    quint32 cpu = 0;
+    quint64 numSamples = 0;
+};
+
+QDataStream& writeRecord(QDataStream& stream, const Thread& thread, quint64 time, quint32 cpu)
+{
+    return stream << thread.pid << thread.tid << time << cpu;
+}
+
+struct ContextSwitch
+{
+    quint64 time = 0;
+    int thread = 0;
+};
+}
+
+PerfStreamWriter::PerfStreamWriter(QIODevice* output)
+    : m_output(output)
+    , m_buffer(&m_event)
+{
+    m_event.reserve(4096);
+    m_buffer.open(QIODevice::WriteOnly);
+    m_stream.setDevice(&m_buffer);
+
+    // + 1 to include the trailing \0
+    m_output->write("QPERFSTREAM", 12);
+    const auto version = qToLittleEndian<qint32>(m_stream.version());
+    m_output->write(reinterpret_cast<const char*>(&version), sizeof(version));
+}
+
+qint32 PerfStreamWriter::stringId(const QString& string)
+{
+    auto& id = m_stringIds[string];
+    if (!id) {
+        id = m_stringIds.size();
+        writeEvent(EventType::StringDefinition,
+                   [&](QDataStream& stream) { stream << static_cast<qint32>(id - 1) << string.toUtf8(); });
+    }
+    return id - 1;
+}
+
+void PerfStreamWriter::writeEventData()
+{
+    const auto size = qToLittleEndian<quint32>(m_event.size());
+    m_output->write(reinterpret_cast<const char*>(&size), sizeof(size));
+    m_output->write(m_event);
+}
+
+void writeSyntheticPerfStream(QIODevice* output, const SyntheticProfile& profile)
+{
+    PerfStreamWriter writer(output);
+    using EventType = PerfStreamWriter::EventType;
+    QRandomGenerator random(profile.seed);
+    const quint64 startTime = 1000000000;
+    const auto numThreads = std::max(1, profile.numThreads);
+    const auto numCpus = std::max(1, profile.numCpus);
+    const auto numSymbols = std::max(1, profile.numSymbols);
+    const auto numBinaries = std::max(1, profile.numBinaries);
+
+    for (qint32 id = 0, c = profile.costTypes.size(); id < c; ++id) {
+        const auto name = writer.stringId(profile.costTypes[id]);
+        writer.writeEvent(EventType::AttributesDefinition, [&](QDataStream& stream) {
+            // hardware events, with the costs of the samples taken as they are
+            stream << id << quint32(0) << quint64(0) << name << true << quint64(0);
+        });
+    }
+
+    // one location per symbol, the first one is main in the application
+    for (qint32 id = 0; id < numSymbols; ++id) {
+        const auto binary = id ? QStringLiteral("lib%1.so").arg(id % numBinaries) : QStringLiteral("synthetic");
+        const auto path = writer.stringId(QLatin1String("/usr/lib/") + binary);
+        const auto binaryId = writer.stringId(binary);
+        const auto name = writer.stringId(id ? QStringLiteral("func%1").arg(id) : QStringLiteral("main"));
+        const quint64 relAddr = 0x1000 + id * 0x100;
+        writer.writeEvent(EventType::LocationDefinition, [&](QDataStream& stream) {
+            stream << id << (0x400000 + relAddr) << qint32(-1) << quint32(0) << qint32(0) << qint32(0) << qint32(-1)
+                   << relAddr;
+        });
+        writer.writeEvent(EventType::SymbolDefinition, [&](QDataStream& stream) {
+            stream << id << name << binaryId << path << false << relAddr << quint64(0x100) << path << false;
+        });
+    }
+
+    QVector<Thread> threads(numThreads);
+    const quint32 pid = 1000;
+    for (int i = 0; i < numThreads; ++i) {
+        auto& thread = threads[i];
+        thread.pid = pid;
+        thread.tid = pid + i;
+        thread.cpu = i % numCpus;
+        writer.writeEvent(EventType::ThreadStart, [&](QDataStream& stream) {
+            writeRecord(stream, thread, startTime, thread.cpu) << pid;
+        });
+        const auto comm = writer.stringId(i ? QStringLiteral("worker-%1").arg(i) : QStringLiteral("synthetic"));
+        writer.writeEvent(EventType::Command,
+                          [&](QDataStream& stream) { writeRecord(stream, thread, startTime, thread.cpu) << comm; });
+    }
+
+    // the threads take turns, the switch ins are due half a period after the switch out
+    const auto tick = std::max<quint64>(1, profile.samplePeriod / numThreads);
+    std::deque<ContextSwitch> pendingSwitchIns;
+    auto switchIn = [&](const ContextSwitch& contextSwitch) {
+        auto& thread = threads[contextSwitch.thread];
+        // threads get migrated to another CPU now and then
+        if (random.bounded(4) == 0) {
+            thread.cpu = random.bounded(numCpus);
+        }
+        writer.writeEvent(EventType::ContextSwitchDefinition, [&](QDataStream& stream) {
+            writeRecord(stream, thread, contextSwitch.time, thread.cpu) << false;
+        });
+    };
+
+    QVector<qint32> frames;
+    QVector<quint64> costs(profile.costTypes.size());
+    const auto minDepth = std::max(1, profile.minStackDepth);
+    const auto maxDepth = std::max(minDepth, profile.maxStackDepth);
+    quint64 time = startTime;
+    for (quint64 i = 0; i < profile.numSamples; ++i) {
+        time += tick;
+        while (!pendingSwitchIns.empty() && pendingSwitchIns.front().time <= time) {
+            switchIn(pendingSwitchIns.front());
+            pendingSwitchIns.pop_front();
+        }
+
+        const auto threadIndex = static_cast<int>(i % numThreads);
+        auto& thread = threads[threadIndex];
+
+        // outermost frame first, perfparser sends the leaf first
+        const auto depth = random.bounded(minDepth, maxDepth + 1);
+        frames.resize(0);
+        frames.push_back(0);
+        while (frames.size() < depth) {
+            const bool recurse = frames.size() > 1 && random.generateDouble() < profile.recursionProbability;
+            frames.push_back(recurse ? frames.last() : static_cast<qint32>(random.bounded(numSymbols)));
+        }
+        std::reverse(frames.begin(), frames.end());
+
+        for (int type = 0, c = costs.size(); type < c; ++type) {
+            const auto jitter = random.generateDouble() * profile.samplePeriod;
+            costs[type] = profile.samplePeriod / 2 + static_cast<quint64>(jitter);
+        }
+
+        writer.writeEvent(EventType::Sample, [&](QDataStream& stream) {
+            writeRecord(stream, thread, time, thread.cpu) << frames << quint8(0) << static_cast<quint32>(costs.size());
+            for (qint32 type = 0, c = costs.size(); type < c; ++type) {
+                stream << type << costs[type];
+            }
+        });
+
+        if (profile.contextSwitchInterval > 0 && ++thread.numSamples % profile.contextSwitchInterval == 0) {
+            writer.writeEvent(EventType::ContextSwitchDefinition,
+                              [&](QDataStream& stream) { writeRecord(stream, thread, time + 1, thread.cpu) << true; });
+            pendingSwitchIns.push_back({time + profile.samplePeriod / 2, threadIndex});
+        }
+    }
+
+    for (const auto& contextSwitch : pendingSwitchIns) {
+        switchIn(contextSwitch);
+        time = contextSwitch.time;
+    }
+    ++time;
+    for (const auto& thread : threads) {
+        writer.writeEvent(EventType::ThreadEnd,
+                          [&](QDataStream& stream) { writeRecord(stream, thread, time, thread.cpu); });
+    }
+}
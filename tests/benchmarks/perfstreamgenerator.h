@@ -0,0 +1,90 @@
+/*
+    SPDX-FileCopyrightText: 2026 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QDataStream>
+#include <QHash>
+#include <QStringList>
+
+class QIODevice;
+
+// writes the events of the format of hotspot-perfparser, i.e. the QPERFSTREAM read by PerfParserPrivate::tryParse
+// the record layouts follow the operator>> overloads in perfparser.cpp
+class PerfStreamWriter
+{
+public:
+    // see PerfParserPrivate::EventType
+    enum class EventType : qint8
+    {
+        ThreadStart,
+        ThreadEnd,
+        Command,
+        LocationDefinition,
+        SymbolDefinition,
+        StringDefinition,
+        LostDefinition,
+        FeaturesDefinition,
+        Error,
+        Progress,
+        TracePointFormat,
+        AttributesDefinition,
+        ContextSwitchDefinition,
+        Sample,
+        TracePointSample,
+    };
+
+    explicit PerfStreamWriter(QIODevice* output);
+
+    // @p write streams the record of the event
+    template<typename Write>
+    void writeEvent(EventType type, Write&& write)
+    {
+        m_event.resize(0);
+        m_buffer.seek(0);
+        m_stream << static_cast<qint8>(type);
+        write(m_stream);
+        writeEventData();
+    }
+
+    // defines @p string once, returns its id
+    qint32 stringId(const QString& string);
+
+private:
+    void writeEventData();
+
+    QIODevice* m_output;
+    QByteArray m_event;
+    QBuffer m_buffer;
+    QDataStream m_stream;
+    QHash<QString, qint32> m_stringIds;
+};
+
+// the shape of a synthetic profile, the same options and seed always produce the same profile
+struct SyntheticProfile
+{
+    quint64 numSamples = 100000;
+    int numThreads = 4;
+    int numCpus = 8;
+    int numBinaries = 20;
+    int numSymbols = 2000;
+    int minStackDepth = 2;
+    int maxStackDepth = 32;
+    // the probability of a frame calling its own symbol again
+    double recursionProbability = 0.05;
+    // every sample has a cost for each of these
+    QStringList costTypes = {QStringLiteral("cycles")};
+    // the time between two samples of a thread
+    quint64 samplePeriod = 1000000;
+    // every n-th sample of a thread is followed by a context switch, 0 disables them
+    int contextSwitchInterval = 100;
+    quint32 seed = 42;
+};
+
+// writes @p profile in the format of hotspot-perfparser, i.e. the QPERFSTREAM read by PerfParserPrivate::tryParse
+void writeSyntheticPerfStream(QIODevice* output, const SyntheticProfile& profile);
@@ -6,21 +6,35 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
+#include <QBuffer>
+#include <QDateTime>
 #include <QDebug>
+#include <QDir>
 #include <QObject>
+#include <QPointer>
 #include <QProcess>
+#include <QScopeGuard>
 #include <QSignalSpy>
 #include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
 #include <QTextStream>
+#include <QUrl>
 
+#include <algorithm>
+#include <functional>
+
+#include "capturewatcher.h"
 #include "data.h"
 #include "perfparser.h"
 #include "perfrecord.h"
 #include "recordhost.h"
 #include "util.h"
 
+#include "../benchmarks/perfstreamgenerator.h"
 #include "../testutils.h"
 #include <hotspot-config.h>
 
@@ -155,6 +169,91 @@ void dump(const Data::BottomUp& bottomUp, QTextStream& stream, const QByteArray&
     }
 }
 
+// the definitions of a synthetic capture, recorded with @p cmdline. every pair of the name and binary of @p symbols
+// gets a location and a symbol with its index as id, the samples reference them as frames
+void writeDefinitions(PerfStreamWriter* writer, const QByteArrayList& cmdline,
+                      const QVector<std::pair<QString, QString>>& symbols)
+{
+    using EventType = PerfStreamWriter::EventType;
+    writer->writeEvent(EventType::FeaturesDefinition, [&](QDataStream& stream) {
+        // the host, OS release, perf version and architecture, the CPUs online and available, the CPU description and
+        // id and the total memory, followed by no build ids, sibling cores and threads, NUMA nodes, PMUs or groups
+        stream << QByteArray() << QByteArray() << QByteArray() << QByteArray() << quint32(1) << quint32(1)
+               << QByteArray() << QByteArray() << quint64(0) << cmdline;
+        for (int i = 0; i < 6; ++i) {
+            stream << quint32(0);
+        }
+    });
+
+    for (qint32 id = 0, c = symbols.size(); id < c; ++id) {
+        const auto name = writer->stringId(symbols[id].first);
+        const auto binary = writer->stringId(symbols[id].second);
+        const quint64 relAddr = 0x1000 + id * 0x100;
+        writer->writeEvent(EventType::LocationDefinition, [&](QDataStream& stream) {
+            stream << id << (0x400000 + relAddr) << qint32(-1) << quint32(0) << qint32(0) << qint32(0) << qint32(-1)
+                   << relAddr;
+        });
+        writer->writeEvent(EventType::SymbolDefinition, [&](QDataStream& stream) {
+            stream << id << name << binary << binary << false << relAddr << quint64(0x100) << binary << false;
+        });
+    }
+}
+
+// starts the thread @p tid of the process 1000, which is named @p comm
+void writeThreadStart(PerfStreamWriter* writer, quint32 tid, const QString& comm)
+{
+    using EventType = PerfStreamWriter::EventType;
+    const quint32 pid = 1000;
+    const auto commId = writer->stringId(comm);
+    writer->writeEvent(EventType::ThreadStart,
+                       [&](QDataStream& stream) { stream << pid << tid << quint64(1) << quint32(0) << pid; });
+    writer->writeEvent(EventType::Command,
+                       [&](QDataStream& stream) { stream << pid << tid << quint64(1) << quint32(0) << commId; });
+}
+
+// a sample of the thread @p tid of the process 1000 with the cost 1 for the attribute @p attributeId, a tracepoint
+// sample when it has a @p payload. @p frames start with the leaf, like perfparser sends them
+void writeSample(PerfStreamWriter* writer, quint32 tid, quint64 time, const QVector<qint32>& frames,
+                 qint32 attributeId, const QHash<qint32, QVariant>* payload = nullptr)
+{
+    using EventType = PerfStreamWriter::EventType;
+    writer->writeEvent(payload ? EventType::TracePointSample : EventType::Sample, [&](QDataStream& stream) {
+        stream << quint32(1000) << tid << time << quint32(0) << frames << quint8(0) << quint32(1) << attributeId
+               << quint64(1);
+        if (payload) {
+            stream << *payload;
+        }
+    });
+}
+
+// parses the synthetic capture @p write writes and returns its summary, its events end up in @p events
+Data::Summary parseStream(const std::function<void(PerfStreamWriter* writer)>& write,
+                          Data::EventResults* events = nullptr)
+{
+    QTemporaryFile file;
+    if (!file.open()) {
+        return {};
+    }
+    {
+        PerfStreamWriter writer(&file);
+        write(&writer);
+    }
+    file.close();
+
+    PerfParser parser;
+    QSignalSpy parsingFinishedSpy(&parser, &PerfParser::parsingFinished);
+    QSignalSpy summaryDataSpy(&parser, &PerfParser::summaryDataAvailable);
+    QSignalSpy eventsDataSpy(&parser, &PerfParser::eventsAvailable);
+    parser.startParseFile(file.fileName());
+    if (!parsingFinishedSpy.wait(6000) || summaryDataSpy.isEmpty() || eventsDataSpy.isEmpty()) {
+        return {};
+    }
+    if (events) {
+        *events = eventsDataSpy.first().first().value<Data::EventResults>();
+    }
+    return summaryDataSpy.first().first().value<Data::Summary>();
+}
+
 class TestPerfParser : public QObject
 {
     Q_OBJECT
@@ -244,6 +343,10 @@ private slots:
         QTest::addRow("PERF v2") << QFINDTESTDATA("file_content/perf.data.true.v2") << QString();
 #if KFArchive_FOUND
         QTest::addRow("PERF v2, gzipped") << QFINDTESTDATA("file_content/perf.data.true.v2.gz") << QString();
+        QTest::addRow("pre-exported perfparser, gzipped")
+            << QFINDTESTDATA("file_content/true.perfparser.gz") << QString();
+        QTest::addRow("pre-exported perfparser, seekable zstd")
+            << QFINDTESTDATA("file_content/true.perfparser.zst") << QString();
 #endif
     }
 
@@ -283,6 +386,119 @@ private slots:
         }
     }
 
+    void testExportLoadedResults()
+    {
+        Data::Summary summary;
+        Data::EventResults events;
+        auto parse = [&](const QString& fileName) {
+            PerfParser parser(this);
+            QSignalSpy parsingFinishedSpy(&parser, &PerfParser::parsingFinished);
+            QSignalSpy summaryDataSpy(&parser, &PerfParser::summaryDataAvailable);
+            QSignalSpy eventsDataSpy(&parser, &PerfParser::eventsAvailable);
+            parser.startParseFile(fileName);
+            QVERIFY(parsingFinishedSpy.wait(6000));
+            summary = summaryDataSpy.first().first().value<Data::Summary>();
+            events = eventsDataSpy.first().first().value<Data::EventResults>();
+        };
+
+        parse(QFINDTESTDATA("file_content/true.perfparser"));
+        QVERIFY(summary.sampleCount > 0);
+        const auto loadedSummary = summary;
+        const auto loadedEvents = events;
+
+        QTemporaryDir dir;
+        const auto exported = QUrl::fromLocalFile(dir.filePath(QStringLiteral("exported.perfparser")));
+        {
+            PerfParser parser(this);
+            QSignalSpy parsingFinishedSpy(&parser, &PerfParser::parsingFinished);
+            QSignalSpy exportFinishedSpy(&parser, &PerfParser::exportFinished);
+            QSignalSpy exportFailedSpy(&parser, &PerfParser::exportFailed);
+            parser.startParseFile(QFINDTESTDATA("file_content/true.perfparser"));
+            QVERIFY(parsingFinishedSpy.wait(6000));
+            // the results are set through a queued connection
+            QCoreApplication::processEvents();
+            parser.exportResults(exported);
+            QVERIFY(exportFinishedSpy.wait(6000));
+            QCOMPARE(exportFailedSpy.count(), 0);
+        }
+
+        parse(exported.toLocalFile());
+        QCOMPARE(summary.costs.size(), loadedSummary.costs.size());
+        for (int i = 0; i < summary.costs.size(); ++i) {
+            QCOMPARE(summary.costs[i].label, loadedSummary.costs[i].label);
+            QCOMPARE(summary.costs[i].totalPeriod, loadedSummary.costs[i].totalPeriod);
+        }
+        QCOMPARE(events.threads.size(), loadedEvents.threads.size());
+        QCOMPARE(events.stacks.size(), loadedEvents.stacks.size());
+    }
+
+    void testServedResults()
+    {
+        QCOMPARE(PerfParser::parseServerRequest(PerfParser::serverRequest(42)), 42u);
+        QCOMPARE(PerfParser::parseServerRequest("GET / HTTP/1.1\r\n"), 0u);
+        QVERIFY(PerfParser::isServerUrl(QStringLiteral("hotspot://localhost:1234")));
+        QVERIFY(!PerfParser::isServerUrl(QStringLiteral("/tmp/perf.data")));
+
+        Data::BottomUpResults bottomUp;
+        Data::EventResults loadedEvents;
+        Data::Summary loadedSummary;
+        {
+            PerfParser parser(this);
+            QSignalSpy parsingFinishedSpy(&parser, &PerfParser::parsingFinished);
+            QSignalSpy summaryDataSpy(&parser, &PerfParser::summaryDataAvailable);
+            parser.startParseFile(QFINDTESTDATA("file_content/true.perfparser"));
+            QVERIFY(parsingFinishedSpy.wait(6000));
+            // the results are set through a queued connection
+            QCoreApplication::processEvents();
+            bottomUp = parser.bottomUpResults();
+            loadedEvents = parser.eventResults();
+            loadedSummary = summaryDataSpy.first().first().value<Data::Summary>();
+        }
+        QVERIFY(loadedSummary.sampleCount > 1);
+
+        // all samples of a thread with the same stack get summed up in a single slice of the time range
+        QByteArray answer;
+        QTcpServer server;
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+        connect(&server, &QTcpServer::newConnection, this, [&]() {
+            auto* socket = server.nextPendingConnection();
+            connect(socket, &QTcpSocket::readyRead, socket, [&, socket]() {
+                if (!socket->canReadLine()) {
+                    return;
+                }
+                const auto timeBuckets = PerfParser::parseServerRequest(socket->readLine());
+                QVERIFY(timeBuckets > 0);
+                QBuffer buffer(&answer);
+                buffer.open(QIODevice::WriteOnly);
+                PerfParser::writeServedResults(&buffer, bottomUp, loadedEvents, 1);
+                socket->write(answer);
+                socket->disconnectFromHost();
+            });
+        });
+
+        PerfParser parser(this);
+        QSignalSpy parsingFinishedSpy(&parser, &PerfParser::parsingFinished);
+        QSignalSpy parsingFailedSpy(&parser, &PerfParser::parsingFailed);
+        QSignalSpy summaryDataSpy(&parser, &PerfParser::summaryDataAvailable);
+        QSignalSpy eventsDataSpy(&parser, &PerfParser::eventsAvailable);
+        parser.startParseFile(QStringLiteral("hotspot://127.0.0.1:%1").arg(server.serverPort()));
+        QVERIFY(parsingFinishedSpy.wait(6000));
+        QCOMPARE(parsingFailedSpy.count(), 0);
+        QVERIFY(!answer.isEmpty());
+
+        const auto summary = summaryDataSpy.first().first().value<Data::Summary>();
+        QCOMPARE(summary.costs.size(), loadedSummary.costs.size());
+        for (int i = 0; i < summary.costs.size(); ++i) {
+            QCOMPARE(summary.costs[i].label, loadedSummary.costs[i].label);
+            QCOMPARE(summary.costs[i].totalPeriod, loadedSummary.costs[i].totalPeriod);
+        }
+        QVERIFY(summary.sampleCount <= loadedSummary.sampleCount);
+
+        const auto events = eventsDataSpy.first().first().value<Data::EventResults>();
+        QCOMPARE(events.threads.size(), loadedEvents.threads.size());
+        QCOMPARE(events.stacks.size(), loadedEvents.stacks.size());
+    }
+
     /* tests a perf file that has data with PERF_FORMAT_LOST attribute, see KDAB/hotspot#578 */
     void testPerfFormatLost()
     {
@@ -296,6 +512,291 @@ private slots:
         QCOMPARE(parsingFailedSpy.count(), 0);
     }
 
+    void testLostChunksWarning()
+    {
+        PerfParser parser(this);
+        QSignalSpy parsingFinishedSpy(&parser, &PerfParser::parsingFinished);
+        QSignalSpy summaryDataSpy(&parser, &PerfParser::summaryDataAvailable);
+        QSignalSpy parserWarningSpy(&parser, &PerfParser::parserWarning);
+
+        parser.startParseFile(QFINDTESTDATA("perf.data.PerfFormatLost"));
+        QTRY_COMPARE_WITH_TIMEOUT(parsingFinishedSpy.count(), 1, 58000);
+        const auto summary = summaryDataSpy.last().first().value<Data::Summary>();
+        if (summary.lostChunks == 0) {
+            QSKIP("the recording has no lost chunks");
+        }
+
+        // perf record doesn't report them, so the parser warns about the lost chunks of the data
+        const auto lostChunks = QString::number(summary.lostChunks);
+        const auto warned = std::any_of(parserWarningSpy.begin(), parserWarningSpy.end(), [&](const auto& args) {
+            const auto warning = args.first().toString();
+            return warning.contains(QLatin1String(" chunks")) && warning.contains(lostChunks);
+        });
+        QVERIFY(warned);
+    }
+
+    void testCorrectLostEventsAfterParsing()
+    {
+        Settings::instance()->setCorrectLostEvents(true);
+        auto resetCorrection = qScopeGuard([]() { Settings::instance()->setCorrectLostEvents(false); });
+
+        PerfParser parser(this);
+        QSignalSpy parsingFailedSpy(&parser, &PerfParser::parsingFailed);
+        QSignalSpy parsingFinishedSpy(&parser, &PerfParser::parsingFinished);
+        QSignalSpy bottomUpDataSpy(&parser, &PerfParser::bottomUpDataAvailable);
+
+        parser.startParseFile(QFINDTESTDATA("perf.data.PerfFormatLost"));
+        QTRY_VERIFY_WITH_TIMEOUT(parsingFinishedSpy.count() >= 1, 58000);
+        QCOMPARE(parsingFailedSpy.count(), 0);
+        if (parser.eventResults().lostEvents.isEmpty()) {
+            QSKIP("the recording has no lost events");
+        }
+
+        // a filter corrects the parsed costs once the results got parsed
+        QTRY_COMPARE_WITH_TIMEOUT(parsingFinishedSpy.count(), 2, 58000);
+        const auto parsed = bottomUpDataSpy.first().first().value<Data::BottomUpResults>();
+        const auto corrected = bottomUpDataSpy.last().first().value<Data::BottomUpResults>();
+        QVERIFY(corrected.costs.totalCost(0) >= parsed.costs.totalCost(0));
+    }
+
+    void testCaptureWatcherShutdown()
+    {
+        // keep the cached perfparser output out of the cache of the user
+        QStandardPaths::setTestModeEnabled(true);
+        auto disableTestMode = qScopeGuard([]() { QStandardPaths::setTestModeEnabled(false); });
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QVERIFY(QFile::copy(QFINDTESTDATA("perf.data.PerfFormatLost"), dir.filePath(QStringLiteral("perf.data"))));
+
+        QPointer<CaptureWatcher> watcher = new CaptureWatcher(this);
+        QSignalSpy startedSpy(watcher.data(), &CaptureWatcher::captureStarted);
+        QVERIFY(watcher->watch(dir.path()));
+        QTRY_COMPARE_WITH_TIMEOUT(startedSpy.count(), 1, 20000);
+
+        // toggle watching off while the capture is getting cached, the watcher outlives the job of its parser
+        watcher->shutdown();
+        QVERIFY(watcher);
+        QVERIFY(!watcher->parent());
+        QTRY_VERIFY_WITH_TIMEOUT(!watcher, 58000);
+    }
+
+    void testParserCache()
+    {
+        // keep the cached perfparser output out of the cache of the user
+        QStandardPaths::setTestModeEnabled(true);
+        auto disableTestMode = qScopeGuard([]() { QStandardPaths::setTestModeEnabled(false); });
+        QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/perfparser"));
+        QVERIFY(cacheDir.removeRecursively());
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const auto input = dir.filePath(QStringLiteral("perf.data"));
+        QVERIFY(QFile::copy(QFINDTESTDATA("perf.data.PerfFormatLost"), input));
+
+        auto parse = [this, &input]() {
+            PerfParser parser(this);
+            QSignalSpy parsingFinishedSpy(&parser, &PerfParser::parsingFinished);
+            QSignalSpy parsingFailedSpy(&parser, &PerfParser::parsingFailed);
+            parser.startParseFile(input);
+            QTRY_COMPARE_WITH_TIMEOUT(parsingFinishedSpy.count() + parsingFailedSpy.count(), 1, 58000);
+            QCOMPARE(parsingFailedSpy.count(), 0);
+        };
+
+        parse();
+        const auto caches = cacheDir.entryInfoList({QStringLiteral("*.perfparser")}, QDir::Files);
+        QCOMPARE(caches.size(), 1);
+        const auto cacheFile = caches.first().absoluteFilePath();
+        const auto binariesFile = cacheFile + QLatin1String(".binaries");
+        QVERIFY(QFile::exists(binariesFile));
+
+        // reopening the file reads the cache, which marks it as recently used
+        const auto yesterday = QDateTime::currentDateTime().addDays(-1);
+        {
+            QFile cache(cacheFile);
+            QVERIFY(cache.open(QIODevice::ReadOnly));
+            QVERIFY(cache.setFileTime(yesterday, QFileDevice::FileModificationTime));
+        }
+        parse();
+        QVERIFY(QFileInfo(cacheFile).lastModified() > yesterday.addSecs(3600));
+
+        // a rebuilt binary invalidates the cache, which gets written again
+        QTemporaryFile binary;
+        QVERIFY(binary.open());
+        binary.write("rebuilt");
+        binary.close();
+        {
+            QFile binaries(binariesFile);
+            QVERIFY(binaries.open(QIODevice::Append));
+            binaries.write(binary.fileName().toUtf8() + "\t1\t0\n");
+        }
+        parse();
+        QVERIFY(QFile::exists(cacheFile));
+        {
+            QFile binaries(binariesFile);
+            QVERIFY(binaries.open(QIODevice::ReadOnly));
+            QVERIFY(!binaries.readAll().contains(binary.fileName().toUtf8()));
+        }
+
+        // without a cache size, nothing gets cached
+        Settings::instance()->setParserCacheSize(0);
+        auto resetCacheSize = qScopeGuard([]() { Settings::instance()->setParserCacheSize(10240); });
+        QVERIFY(cacheDir.removeRecursively());
+        parse();
+        QVERIFY(!QFile::exists(cacheFile));
+    }
+
+    void testCollapsedStacks()
+    {
+        QTemporaryFile file;
+        QVERIFY(file.open());
+        file.write("main;foo;bar 3\n"
+                   "main;foo 2\n"
+                   "not a stack\n"
+                   "libc.so.6`start;main;schedule_[k] 1\n");
+        file.close();
+
+        PerfParser parser(this);
+        QSignalSpy parsingFinishedSpy(&parser, &PerfParser::parsingFinished);
+        QSignalSpy parsingFailedSpy(&parser, &PerfParser::parsingFailed);
+        QSignalSpy summaryDataSpy(&parser, &PerfParser::summaryDataAvailable);
+        QSignalSpy topDownDataSpy(&parser, &PerfParser::topDownDataAvailable);
+        QSignalSpy parserWarningSpy(&parser, &PerfParser::parserWarning);
+
+        parser.startParseFile(file.fileName());
+        QVERIFY(parsingFinishedSpy.wait(6000));
+        QCOMPARE(parsingFailedSpy.count(), 0);
+        // there are no times or threads to filter by
+        QCOMPARE(parserWarningSpy.count(), 1);
+
+        const auto summary = summaryDataSpy.first().first().value<Data::Summary>();
+        QCOMPARE(summary.sampleCount, quint64(3));
+        QCOMPARE(summary.costs.size(), 1);
+        QCOMPARE(summary.costs[0].totalPeriod, quint64(6));
+        QCOMPARE(summary.errors.size(), 1);
+
+        const auto topDown = topDownDataSpy.first().first().value<Data::TopDownResults>();
+        QCOMPARE(topDown.inclusiveCosts.totalCost(0), qint64(6));
+        QCOMPARE(topDown.root.children.size(), 2);
+        for (const auto& child : topDown.root.children) {
+            if (child.symbol.symbol == QLatin1String("main")) {
+                QCOMPARE(topDown.inclusiveCosts.cost(0, child.id), qint64(5));
+            } else {
+                QCOMPARE(child.symbol.symbol, QStringLiteral("start"));
+                QCOMPARE(child.symbol.binary, QStringLiteral("libc.so.6"));
+                QCOMPARE(child.children.size(), 1);
+                QCOMPARE(child.children[0].children.size(), 1);
+                QVERIFY(child.children[0].children[0].symbol.isKernel);
+            }
+        }
+
+        // filtering would drop all of the stacks, which have no events
+        QSignalSpy parsingStartedSpy(&parser, &PerfParser::parsingStarted);
+        Data::FilterAction filter;
+        filter.time = {1, 2};
+        parser.filterResults(filter);
+        QCOMPARE(parsingStartedSpy.count(), 0);
+    }
+
+    void testTruncatedStacks()
+    {
+        using EventType = PerfStreamWriter::EventType;
+        auto write = [](const QByteArrayList& cmdline) {
+            return [cmdline](PerfStreamWriter* writer) {
+                writeDefinitions(writer, cmdline,
+                                 {{QStringLiteral("_start"), QStringLiteral("app")},
+                                  {QStringLiteral("main"), QStringLiteral("app")},
+                                  {QStringLiteral("compute"), QStringLiteral("libcompute.so")}});
+                const auto cycles = writer->stringId(QStringLiteral("cycles"));
+                writer->writeEvent(EventType::AttributesDefinition, [&](QDataStream& stream) {
+                    stream << qint32(0) << quint32(0) << quint64(0) << cycles << false << quint64(1);
+                });
+                writeThreadStart(writer, 1000, QStringLiteral("app"));
+
+                // the unwinding of the last stack stopped in main, before it reached the entry point
+                quint64 time = 10;
+                for (int i = 0; i < 3; ++i) {
+                    writeSample(writer, 1000, time++, {2, 1, 0}, 0);
+                }
+                writeSample(writer, 1000, time++, {2, 1}, 0);
+            };
+        };
+
+        // the workload and its arguments don't tell how the stacks got recorded
+        auto summary = parseStream(write({"perf", "record", "--call-graph", "dwarf,4096", "--", "./dwarf", "dwarf"}));
+        QCOMPARE(summary.sampleCount, quint64(4));
+        QCOMPARE(summary.stackDumpSize, quint32(4096));
+        QCOMPARE(summary.userStackCount, quint64(4));
+        QCOMPARE(summary.truncatedStackCount, quint64(1));
+        QCOMPARE(summary.suggestedStackDumpSize, quint32(8192));
+        QVERIFY(std::any_of(summary.errors.begin(), summary.errors.end(),
+                            [](const QString& error) { return error.contains(QLatin1String("end in app")); }));
+
+        summary = parseStream(write({"perf", "record", "-g", "--", "./dwarf", "--call-graph", "dwarf"}));
+        QCOMPARE(summary.sampleCount, quint64(4));
+        QCOMPARE(summary.stackDumpSize, quint32(0));
+        QCOMPARE(summary.truncatedStackCount, quint64(0));
+        QCOMPARE(summary.suggestedStackDumpSize, quint32(0));
+    }
+
+    void testSyscallTime()
+    {
+        Data::EventResults events;
+        const auto summary = parseStream(
+            [](PerfStreamWriter* writer) {
+                using EventType = PerfStreamWriter::EventType;
+                writeDefinitions(writer, {"perf", "record", "-e", "raw_syscalls:*", "-g"},
+                                 {{QStringLiteral("_start"), QStringLiteral("app")},
+                                  {QStringLiteral("main"), QStringLiteral("app")}});
+                // the config of a tracepoint attribute is the id of its format
+                const QStringList tracepoints = {QStringLiteral("raw_syscalls:sys_enter"),
+                                                 QStringLiteral("raw_syscalls:sys_exit")};
+                for (qint32 id = 0; id < tracepoints.size(); ++id) {
+                    const auto name = writer->stringId(tracepoints[id]);
+                    writer->writeEvent(EventType::AttributesDefinition, [&](QDataStream& stream) {
+                        stream << id << quint32(2) << quint64(id) << name << false << quint64(1);
+                    });
+                }
+                writeThreadStart(writer, 1000, QStringLiteral("app"));
+
+                const auto idField = writer->stringId(QStringLiteral("id"));
+                auto writeSyscall = [&](quint64 time, qint32 tracepoint, qint64 syscall) {
+                    const QHash<qint32, QVariant> payload = {{idField, syscall}};
+                    writeSample(writer, 1000, time, {1, 0}, tracepoint, &payload);
+                };
+                // the recording started while the thread was in the syscall, so there is no enter to pair it with
+                writeSyscall(5, 1, 1);
+                writeSyscall(10, 0, 0);
+                writeSyscall(25, 1, 0);
+                // still in the syscall when the recording ended
+                writeSyscall(30, 0, 7);
+            },
+            &events);
+
+        QVERIFY(events.syscallTimeCostId != -1);
+        const auto& syscallTime = summary.costs.value(events.syscallTimeCostId);
+        QCOMPARE(syscallTime.label, QStringLiteral("Syscall Time"));
+        QCOMPARE(syscallTime.sampleCount, quint64(1));
+        QCOMPARE(syscallTime.totalPeriod, quint64(15));
+        QCOMPARE(summary.syscallLatencies.keys(), QList<qint64> {0});
+        QCOMPARE(summary.syscallLatencies.value(0).total, quint64(15));
+
+        // the syscall time is added at the exit and only to the thread
+        QCOMPARE(events.threads.size(), 1);
+        const auto& threadEvents = events.threads.first().events;
+        QVector<quint64> syscallTimes;
+        for (qsizetype i = 0, c = threadEvents.size(); i < c; ++i) {
+            const auto event = threadEvents.at(i);
+            if (event.type == events.syscallTimeCostId) {
+                syscallTimes.push_back(event.time);
+            }
+        }
+        QCOMPARE(syscallTimes, QVector<quint64> {25});
+        for (const auto& cpu : events.cpus) {
+            for (const auto& index : cpu.events) {
+                QVERIFY(events.threads.at(index.thread).events.at(index.event).type != events.syscallTimeCostId);
+            }
+        }
+    }
+
     void testCppInliningNoOptions()
     {
         const QStringList perfOptions;
@@ -692,6 +1193,40 @@ private slots:
         QVERIFY(m_bottomUpData.costs.totalCost(2) >= 5E8); // at least .5s sleep time
     }
 
+    void testOffCpuBpf()
+    {
+        const auto sleep = QStandardPaths::findExecutable(QStringLiteral("sleep"));
+        if (sleep.isEmpty()) {
+            QSKIP("no sleep command available");
+        }
+
+        if (!m_capabilities.canProfileOffCpuWithBpf || !m_capabilities.privilegesAlreadyElevated) {
+            QSKIP("perf record --off-cpu needs perf built with BPF skeletons and elevated privileges");
+        }
+
+        QStringList perfOptions = {QStringLiteral("--call-graph"), QStringLiteral("dwarf"), QStringLiteral("-e"),
+                                   QStringLiteral("cycles")};
+        perfOptions += PerfRecord::offCpuBpfProfilingOptions();
+
+        QTemporaryFile tempFile;
+        tempFile.open();
+
+        try {
+            perfRecord(perfOptions, sleep, {QStringLiteral(".5")}, tempFile.fileName());
+            testPerfData({}, {}, tempFile.fileName(), false);
+        } catch (...) {
+        }
+
+        // the BPF samples are imported as the off-CPU time, there are no context switches
+        QCOMPARE(m_bottomUpData.costs.numTypes(), 2);
+        QCOMPARE(m_bottomUpData.costs.typeName(0), QStringLiteral("cycles"));
+        QCOMPARE(m_bottomUpData.costs.typeName(1), QStringLiteral("off-CPU Time"));
+        QCOMPARE(m_bottomUpData.costs.unit(1), Data::Costs::Unit::Time);
+        QVERIFY(m_eventData.offCpuTimeSampled);
+        QCOMPARE(m_eventData.offCpuTimeCostId, 1);
+        QVERIFY(m_bottomUpData.costs.totalCost(1) >= 5E8); // at least .5s sleep time
+    }
+
     void testSampleCpu()
     {
         QStringList perfOptions = {QStringLiteral("--call-graph"), QStringLiteral("dwarf"),
@@ -790,6 +1325,48 @@ private slots:
         QCOMPARE(actual, expected);
     }
 
+    void testFastPreview()
+    {
+        const auto perfData = QFINDTESTDATA("custom_cost_aggregation_testfiles/custom_cost_aggregation.perfparser");
+        QVERIFY(!perfData.isEmpty() && QFile::exists(perfData));
+
+        Settings::instance()->setPreviewStride(10);
+        auto resetStride = qScopeGuard([]() { Settings::instance()->setPreviewStride(1); });
+
+        PerfParser parser(this);
+        parser.setPublishPartialResults(true);
+        QSignalSpy parsingFinishedSpy(&parser, &PerfParser::parsingFinished);
+        QSignalSpy parsingFailedSpy(&parser, &PerfParser::parsingFailed);
+        QSignalSpy partialResultsSpy(&parser, &PerfParser::partialResultsAvailable);
+        QSignalSpy bottomUpDataSpy(&parser, &PerfParser::bottomUpDataAvailable);
+
+        parser.startParseFile(perfData);
+        QVERIFY(parsingFinishedSpy.wait(6000));
+        QCOMPARE(parsingFailedSpy.count(), 0);
+
+        // the preview comes first, followed by the exact results
+        QVERIFY(partialResultsSpy.count() >= 1);
+        QVERIFY(bottomUpDataSpy.count() >= 2);
+        const auto preview = bottomUpDataSpy.first().first().value<Data::BottomUpResults>();
+        const auto exact = bottomUpDataSpy.last().first().value<Data::BottomUpResults>();
+        QCOMPARE(exact.root.children.size(), parser.bottomUpResults().root.children.size());
+        QVERIFY(exact.costs.totalCost(0) > 0);
+
+        // the file fits into the first batch of the pipeline, so the preview covers all of its samples
+        // the preview keeps the first of every ten samples of a thread and scales its cost up by ten
+        qint64 expectedPreviewCost = 0;
+        for (const auto& thread : parser.eventResults().threads) {
+            int numSamples = 0;
+            for (const auto& event : thread.events) {
+                if (event.type == 0 && numSamples++ % 10 == 0) {
+                    expectedPreviewCost += event.cost * 10;
+                }
+            }
+        }
+        QCOMPARE(preview.costs.totalCost(0), expectedPreviewCost);
+        QVERIFY(preview.costs.totalCost(0) != exact.costs.totalCost(0));
+    }
+
 #if KFArchive_FOUND
     void testDecompression_data()
     {
@@ -806,6 +1383,10 @@ private slots:
         QTest::newRow("xz") << QByteArray::fromBase64(QByteArrayLiteral(
             "/Td6WFoAAATm1rRGAgAhARYAAAB0L+WjAQALSGVsbG8gV29ybGQKACLgdT/V7Tg+AAEkDKYY2NgftvN9AQAAAAAEWVo="))
                             << QStringLiteral("XXXXXX.xz");
+        // two frames with a seek table, as written by the export
+        QTest::newRow("zstd seekable") << QByteArray::fromBase64(QByteArrayLiteral(
+            "KLUv/QRYMQAASGVsbG8gyx8b1yi1L/0EWDEAAFdvcmxkCi1MjqdeKk0YGQAAABMAAAAGAAAAEwAAAAYAAAACAAAAALHqko8="))
+                                       << QStringLiteral("XXXXXX.zst");
     }
 
     void testDecompression()
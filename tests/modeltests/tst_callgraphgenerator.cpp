@@ -5,11 +5,14 @@
 #include <QSignalSpy>
 #include <QTemporaryFile>
 #include <QTest>
+#include <QTextStream>
 
 #include "../../src/parsers/perf/perfparser.h"
 #include "../testutils.h"
 #include "data.h"
 
+#include <algorithm>
+
 class TestCallgraphGenerator : public QObject
 {
     Q_OBJECT
@@ -31,10 +34,7 @@ private slots:
             }
         }
 
-        QString test;
-        QTextStream stream(&test);
-        QHash<Data::Symbol, QString> lookup;
-        resultsToDot(3, Direction::Caller, key, results, {}, stream, lookup, 0.4 / 100.f);
+        const auto test = labels(buildCallGraph(key, results, 3, 0, 0.4 / 100.f));
 
         int parent3Pos = test.indexOf(QLatin1String("parent3"));
         int parent2Pos = test.indexOf(QLatin1String("parent2"));
@@ -59,10 +59,7 @@ private slots:
             }
         }
 
-        QString test;
-        QTextStream stream(&test);
-        QHash<Data::Symbol, QString> lookup;
-        resultsToDot(3, Direction::Callee, key, results, {}, stream, lookup, 0.4 / 100.f);
+        const auto test = labels(buildCallGraph(key, results, 0, 3, 0.4 / 100.f));
 
         int child1Pos = test.indexOf(QLatin1String("child1"));
         int child2Pos = test.indexOf(QLatin1String("child2"));
@@ -70,7 +67,50 @@ private slots:
         QVERIFY(child1Pos < child2Pos);
     }
 
+    void testWriteGraph()
+    {
+        auto results = callerCalleeResults(s_fileName);
+
+        auto key = Data::Symbol();
+        for (auto it = results.entries.cbegin(); it != results.entries.cend(); it++) {
+            if (it.key().symbol == QLatin1String("test")) {
+                key = it.key();
+                break;
+            }
+        }
+
+        const auto graph = buildCallGraph(key, results, 3, 3, 0.4 / 100.f);
+        QVERIFY(graph.nodes.size() > 1);
+        QCOMPARE(graph.nodes.first(), key);
+        QCOMPARE(graph.nodeId(key), 0);
+
+        // every symbol shows up once
+        auto nodes = graph.nodes;
+        std::sort(nodes.begin(), nodes.end());
+        QVERIFY(std::adjacent_find(nodes.begin(), nodes.end()) == nodes.end());
+
+        QString dot;
+        QTextStream stream(&dot);
+        writeGraph(stream, graph, QStringLiteral("#000000"));
+        stream.flush();
+
+        QVERIFY(dot.startsWith(QLatin1String("digraph callgraph {\n")));
+        QCOMPARE(dot.count(QLatin1String(" -> ")), graph.edges.size());
+        for (const auto& edge : graph.edges) {
+            QVERIFY(dot.contains(QStringLiteral("node%1 -> node%2\n").arg(edge.caller).arg(edge.callee)));
+        }
+    }
+
 private:
+    static QString labels(const CallGraph& graph)
+    {
+        QStringList labels;
+        for (const auto& node : graph.nodes) {
+            labels.append(node.prettySymbol());
+        }
+        return labels.join(QLatin1Char('\n'));
+    }
+
     Data::CallerCalleeResults callerCalleeResults(const QString& filename)
     {
         const QByteArray perfparserPath =
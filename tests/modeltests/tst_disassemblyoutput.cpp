@@ -13,11 +13,14 @@
 #include <QStandardPaths>
 #include <QString>
 #include <QStringList>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QTest>
 #include <QVector>
 
 #include <data.h>
+#include <hotspot-config.h>
+#include <models/controlflow.h>
 #include <models/disassemblyoutput.h>
 
 #include "../testutils.h"
@@ -102,6 +105,35 @@ private slots:
             }
         }
         QCOMPARE(actualText, expectedText);
+
+        // disassembling the same symbol again hits the cache, so objdump only runs once for it
+        // the runs get counted by a wrapper, which also gets its own cache entries as the path of objdump differs
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        const auto log = tempDir.filePath(QStringLiteral("objdump.log"));
+        const auto countingObjdump = tempDir.filePath(QStringLiteral("objdump"));
+        {
+            QFile script(countingObjdump);
+            QVERIFY(script.open(QIODevice::WriteOnly | QIODevice::Text));
+            script.write(QStringLiteral("#!/bin/sh\necho \"$@\" >> '%1'\nexec '%2' \"$@\"\n")
+                             .arg(log, mObjdumpBinary)
+                             .toUtf8());
+            QVERIFY(script.setPermissions(script.permissions() | QFileDevice::ExeOwner));
+        }
+        auto numRuns = [&log]() -> int {
+            QFile file(log);
+            return file.open(QIODevice::ReadOnly) ? static_cast<int>(file.readAll().count("--start-address")) : 0;
+        };
+
+        const auto firstOutput =
+            DisassemblyOutput::disassemble(countingObjdump, QStringLiteral("x86_64"), {}, {}, {}, {}, symbol);
+        QCOMPARE(numRuns(), 1);
+        const auto cachedOutput =
+            DisassemblyOutput::disassemble(countingObjdump, QStringLiteral("x86_64"), {}, {}, {}, {}, symbol);
+        QCOMPARE(numRuns(), 1);
+        QCOMPARE(cachedOutput.errorMessage, firstOutput.errorMessage);
+        QCOMPARE(cachedOutput.disassemblyLines.size(), disassemblyOutput.disassemblyLines.size());
+        QCOMPARE(cachedOutput.mainSourceFileName, disassemblyOutput.mainSourceFileName);
     }
 
     QString patch_expected_file(const QString& actualText, const QString& actualBinaryFile)
@@ -163,6 +195,57 @@ private slots:
         QVERIFY(result.errorMessage.isEmpty());
     }
 
+    void testSearchPathChanges()
+    {
+        const auto lib = QFileInfo(findLib(QStringLiteral("libfib.so")));
+        QVERIFY(lib.exists());
+        const Data::Symbol symbol = {QStringLiteral("fib(int)"), 4361, 67, QStringLiteral("libfib.so")};
+
+        QTemporaryDir tempDir;
+        QVERIFY(tempDir.isValid());
+        QVERIFY(QDir(tempDir.path()).mkpath(QStringLiteral("sub/dir")));
+        const auto searchPath = QStringList(tempDir.path());
+
+        auto result = DisassemblyOutput::disassemble(mObjdumpBinary, {}, searchPath, {}, {}, {}, symbol);
+        QVERIFY(result.errorMessage.contains(QLatin1String("Could not find binary")));
+
+        // the index of the search path gets updated once the binary shows up
+        QVERIFY(QFile::copy(lib.absoluteFilePath(), tempDir.filePath(QStringLiteral("sub/dir/libfib.so"))));
+        QTRY_VERIFY(DisassemblyOutput::disassemble(mObjdumpBinary, {}, searchPath, {}, {}, {}, symbol)
+                        .errorMessage.isEmpty());
+    }
+
+    void testBuiltinDisassembler()
+    {
+#if !Capstone_FOUND
+        QSKIP("built without Capstone, the builtin disassembler falls back to objdump");
+#endif
+        const auto lib = QFileInfo(findLib(QStringLiteral("libfib.so")));
+        QVERIFY(lib.exists());
+        auto [address, size] = findAddressAndSizeOfFunc(lib.absoluteFilePath(), QStringLiteral("_Z3fibi"));
+        const auto symbol = Data::Symbol {QStringLiteral("fib(int)"), address, size, QStringLiteral("libfib.so")};
+        const auto searchPath = QStringList(lib.absolutePath());
+
+        const auto objdump = DisassemblyOutput::disassemble(mObjdumpBinary, {}, searchPath, {}, {}, {}, symbol);
+        QVERIFY(objdump.errorMessage.isEmpty());
+        const auto builtin = DisassemblyOutput::disassemble(mObjdumpBinary, {}, searchPath, {}, {}, {}, symbol, true);
+        QVERIFY(builtin.errorMessage.isEmpty());
+
+        // both decode the same instructions, objdump additionally reports inlined functions without an address
+        // and wraps the hexdump of long instructions
+        auto addresses = [](const DisassemblyOutput& output) {
+            QVector<quint64> ret;
+            for (const auto& line : output.disassemblyLines) {
+                if (line.addr && !line.disassembly.isEmpty()) {
+                    ret.push_back(line.addr);
+                }
+            }
+            return ret;
+        };
+        QCOMPARE(addresses(builtin), addresses(objdump));
+        QCOMPARE(builtin.mainSourceFileName, objdump.mainSourceFileName);
+    }
+
     void testCustomSourceCodePath()
     {
         QTemporaryDir tempDir;
@@ -357,6 +440,75 @@ private slots:
         }
     }
 
+    void testJumpTarget_data()
+    {
+        QTest::addColumn<QString>("disassembly");
+        QTest::addColumn<quint64>("target");
+
+        QTest::addRow("x86") << QStringLiteral("jne    100b <main+0xb>") << quint64(0x100b);
+        QTest::addRow("prefix") << QStringLiteral("bnd jmp 1006 <main+0x6>") << quint64(0x1006);
+        QTest::addRow("ansi") << QStringLiteral("\u001B[33mjne\u001B[0m    100b <main+0xb>") << quint64(0x100b);
+        QTest::addRow("aarch64") << QStringLiteral("cbz    w0, 400600 <main+0x50>") << quint64(0x400600);
+        QTest::addRow("capstone") << QStringLiteral("b.ne #0x4005d0 <main+0x20>") << quint64(0x4005d0);
+        QTest::addRow("indirect") << QStringLiteral("jmp    *0x2fe2(%rip)        # 4018 <foo>") << quint64(0);
+        QTest::addRow("call") << QStringLiteral("call   1040 <foo>") << quint64(0);
+        QTest::addRow("lea") << QStringLiteral("lea    0x2e8f(%rip),%rdi        # 4010 <foo>") << quint64(0);
+    }
+
+    void testJumpTarget()
+    {
+        QFETCH(QString, disassembly);
+        QFETCH(quint64, target);
+
+        QCOMPARE(ControlFlow::jumpTarget(disassembly), target);
+    }
+
+    void testControlFlow()
+    {
+        DisassemblyOutput disassembly;
+        auto addLine = [&disassembly](quint64 addr, const char* text) {
+            DisassemblyOutput::DisassemblyLine line;
+            line.addr = addr;
+            line.disassembly = QString::fromLatin1(text);
+            disassembly.disassemblyLines.push_back(line);
+        };
+        addLine(0x1000, "push   %rbp");
+        addLine(0x1001, "mov    $0x0,%eax");
+        addLine(0x1006, "cmp    $0xa,%eax");
+        addLine(0x1009, "jg     1018 <main+0x18>");
+        addLine(0x100b, "add    $0x1,%ecx");
+        addLine(0x100e, "cmp    $0x5,%ecx");
+        addLine(0x1011, "jne    100b <main+0xb>");
+        addLine(0x1013, "add    $0x1,%eax");
+        addLine(0x1016, "jmp    1006 <main+0x6>");
+        addLine(0x1018, "ret");
+
+        const auto flow = ControlFlow::analyze(disassembly);
+
+        QCOMPARE(flow.blocks.size(), 5);
+        const QVector<QPair<int, int>> blocks = {{0, 1}, {2, 3}, {4, 6}, {7, 8}, {9, 9}};
+        for (int i = 0; i < blocks.size(); ++i) {
+            QCOMPARE(flow.blocks[i].firstRow, blocks[i].first);
+            QCOMPARE(flow.blocks[i].lastRow, blocks[i].second);
+        }
+        QCOMPARE(flow.blockForRow(5), 2);
+
+        QCOMPARE(flow.loops.size(), 2);
+        QCOMPARE(flow.loops[0].firstRow, 2);
+        QCOMPARE(flow.loops[0].lastRow, 8);
+        QCOMPARE(flow.loops[0].parent, -1);
+        QCOMPARE(flow.loops[1].firstRow, 4);
+        QCOMPARE(flow.loops[1].lastRow, 6);
+        QCOMPARE(flow.loops[1].parent, 0);
+        QCOMPARE(flow.loops[1].depth, 1);
+
+        QCOMPARE(flow.loopForRow(0), -1);
+        QCOMPARE(flow.loopForRow(3), 0);
+        QCOMPARE(flow.loopForRow(5), 1);
+        QCOMPARE(flow.loopForRow(7), 0);
+        QCOMPARE(flow.loopForRow(9), -1);
+    }
+
     void testCanDisassemble_data()
     {
         QTest::addColumn<Data::Symbol>("symbol");
@@ -383,6 +535,39 @@ private slots:
         QCOMPARE(symbol.canDisassemble(), canDisassemble);
     }
 
+    void testDisassembleBinary()
+    {
+        const auto lib = QFileInfo(findLib(QStringLiteral("libfib.so")));
+        QVERIFY(lib.exists());
+        auto [address, size] = findAddressAndSizeOfFunc(lib.absoluteFilePath(), QStringLiteral("_Z3fibi"));
+        const auto symbol = Data::Symbol {QStringLiteral("fib(int)"), address, size, QStringLiteral("libfib.so")};
+        const auto searchPath = QStringList(lib.absolutePath());
+
+        const auto objdump = DisassemblyOutput::disassemble(mObjdumpBinary, {}, searchPath, {}, {}, {}, symbol);
+        QVERIFY(objdump.errorMessage.isEmpty());
+
+        QVERIFY(!DisassemblyOutput::findFunction(mObjdumpBinary, searchPath, {}, symbol, symbol.symbol).isValid());
+        QVERIFY(DisassemblyOutput::disassembleBinary(mObjdumpBinary, searchPath, {}, symbol));
+
+        // the symbol is now served from the disassembly of the whole binary
+        const auto indexed = DisassemblyOutput::disassemble(mObjdumpBinary, {}, searchPath, {}, {}, {}, symbol);
+        QVERIFY(indexed.errorMessage.isEmpty());
+        QCOMPARE(indexed.mainSourceFileName, objdump.mainSourceFileName);
+        QCOMPARE(indexed.disassemblyLines.size(), objdump.disassemblyLines.size());
+        for (int i = 0; i < objdump.disassemblyLines.size(); ++i) {
+            QCOMPARE(indexed.disassemblyLines[i].addr, objdump.disassemblyLines[i].addr);
+            QCOMPARE(indexed.disassemblyLines[i].disassembly, objdump.disassemblyLines[i].disassembly);
+            QCOMPARE(indexed.disassemblyLines[i].fileLine, objdump.disassemblyLines[i].fileLine);
+        }
+
+        // the recursive calls link to the function itself
+        const auto function = DisassemblyOutput::findFunction(mObjdumpBinary, searchPath, {}, symbol, symbol.symbol);
+        QCOMPARE(function.symbol, symbol.symbol);
+        QCOMPARE(function.relAddr, symbol.relAddr);
+        QVERIFY(function.size > 0 && function.size <= symbol.size);
+        QCOMPARE(function.binary, symbol.binary);
+    }
+
 private:
     struct FunctionData
     {
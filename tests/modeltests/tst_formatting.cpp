@@ -11,6 +11,11 @@
 #include <models/formattingutils.h>
 #include <models/highlightedtext.h>
 
+#if KFSyntaxHighlighting_FOUND
+#include <KSyntaxHighlighting/Definition>
+#include <KSyntaxHighlighting/Repository>
+#endif
+
 #include "../testutils.h"
 
 Q_DECLARE_METATYPE(QVector<QTextLayout::FormatRange>)
@@ -83,6 +88,37 @@ private slots:
             }
         }
     }
+
+#if KFSyntaxHighlighting_FOUND
+    void testMultiLineHighlighting()
+    {
+        KSyntaxHighlighting::Repository repository;
+        HighlightedText highlighter(&repository);
+
+        // span a few highlighting checkpoints
+        QStringList lines = {QStringLiteral("/* a comment")};
+        for (int i = 0; i < 1000; ++i) {
+            lines.append(QStringLiteral("that spans"));
+        }
+        lines.append(QStringLiteral("many lines */"));
+        highlighter.setText(lines);
+        highlighter.setDefinition(repository.definitionForName(QStringLiteral("C++")));
+
+        auto foreground = [&highlighter](int line) {
+            const auto formats = highlighter.layoutForLine(line)->formats();
+            return formats.isEmpty() ? QBrush() : formats.first().format.foreground();
+        };
+
+        // lines get highlighted on demand, in any order, but still know that they are part of the comment
+        const auto comment = foreground(0);
+        QCOMPARE(foreground(lines.size() - 1), comment);
+        QCOMPARE(foreground(500), comment);
+        QCOMPARE(foreground(1), comment);
+
+        highlighter.updateHighlighting();
+        QCOMPARE(foreground(700), comment);
+    }
+#endif
 };
 
 HOTSPOT_GUITEST_MAIN(TestFormatting)
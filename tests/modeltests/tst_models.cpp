@@ -6,19 +6,57 @@
 */
 
 #include <QAbstractItemModelTester>
+#include <QBuffer>
 #include <QDebug>
+#include <QDir>
 #include <QFontDatabase>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QObject>
 #include <QProcess>
 #include <QRegularExpression>
+#include <QScopeGuard>
+#include <QSignalSpy>
+#include <QTemporaryDir>
 #include <QTest>
 #include <QTextStream>
+#include <QXmlStreamReader>
+
+#include <cmath>
+#include <optional>
 
 #include "../testutils.h"
 
+#include <jobscheduler.h>
+#include <models/callercalleeproxy.h>
+#include <models/concurrencyprofile.h>
+#include <models/costproxy.h>
 #include <models/disassemblymodel.h>
 #include <models/eventmodel.h>
+#include <models/filterandzoomstack.h>
+#include <models/flamechartdata.h>
+#include <models/flamegraphdata.h>
+#include <models/flamegraphexport.h>
+#include <models/hotpathmodel.h>
+#include <models/lockcontentionmodel.h>
+#include <models/perfettoexport.h>
+#include <models/perfmapindex.h>
+#include <models/perfstat.h>
+#include <models/pgoexport.h>
+#include <models/pprofexport.h>
+#include <models/processmodel.h>
+#include <models/reportexport.h>
+#include <models/resultsquery.h>
 #include <models/sourcecodemodel.h>
+#include <models/stackhistogram.h>
+#include <models/stackpruning.h>
+#include <models/symboltimeseries.h>
+#include <models/timelinemipmap.h>
+#include <models/timelinesearchindex.h>
+#include <models/topinstructionsmodel.h>
+#include <models/treeexport.h>
+#include <models/wakeupgraph.h>
 
 namespace {
 Data::BottomUpResults buildBottomUpTree(const QByteArray& stacks)
@@ -45,82 +83,2532 @@ Data::BottomUpResults buildBottomUpTree(const QByteArray& stacks)
             ret.costs.increment(0, node->id);
             parent = node;
         }
-        ret.costs.incrementTotal(0);
+        ret.costs.incrementTotal(0);
+    }
+    Data::BottomUp::initializeParents(&ret.root);
+    return ret;
+}
+
+Data::BottomUpResults generateTree1()
+{
+    return buildBottomUpTree(R"(
+        A;B;C
+        A;B;D
+        A;B;D
+        A;B;C;E
+        A;B;C;E;C
+        A;B;C;E;C;E
+        A;B;C;C
+        C
+        C
+    )");
+}
+
+Data::BottomUpResults generateTreeByThread()
+{
+    return buildBottomUpTree(R"(
+        A;B;C;T1
+        A;B;D;T1
+        A;B;D;T2
+        A;B;C;E;T1
+        A;B;C;E;C;T1
+        A;B;C;E;C;E;T1
+        A;B;C;C;T1
+        C;T1
+        C;T2
+    )");
+}
+
+// the varint and length delimited fields of a protobuf message, in the order they got written
+struct ProtoField
+{
+    quint32 number = 0;
+    quint64 value = 0;
+    QByteArray bytes;
+};
+
+QVector<ProtoField> decodeProto(const QByteArray& data)
+{
+    QVector<ProtoField> fields;
+    int pos = 0;
+    auto readVarint = [&]() {
+        quint64 value = 0;
+        for (int shift = 0; pos < data.size(); shift += 7) {
+            const auto byte = static_cast<quint8>(data[pos++]);
+            value |= static_cast<quint64>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        return value;
+    };
+    while (pos < data.size()) {
+        const auto key = readVarint();
+        ProtoField field;
+        field.number = static_cast<quint32>(key >> 3);
+        if ((key & 7) == 0) {
+            field.value = readVarint();
+        } else if ((key & 7) == 2) {
+            const auto size = static_cast<int>(readVarint());
+            field.bytes = data.mid(pos, size);
+            pos += size;
+        } else {
+            return {};
+        }
+        fields.append(field);
+    }
+    return fields;
+}
+
+QVector<quint64> protoValues(const QVector<ProtoField>& fields, quint32 number)
+{
+    QVector<quint64> values;
+    for (const auto& field : fields) {
+        if (field.number == number && field.bytes.isNull()) {
+            values.append(field.value);
+        }
+    }
+    return values;
+}
+
+QVector<QVector<ProtoField>> protoMessages(const QVector<ProtoField>& fields, quint32 number)
+{
+    QVector<QVector<ProtoField>> messages;
+    for (const auto& field : fields) {
+        if (field.number == number && !field.bytes.isNull()) {
+            messages.append(decodeProto(field.bytes));
+        }
+    }
+    return messages;
+}
+}
+
+class TestModels : public QObject
+{
+    Q_OBJECT
+public:
+    using QObject::QObject;
+
+private slots:
+    void testTreeParents()
+    {
+        const auto tree = generateTree1();
+
+        QVERIFY(!tree.root.parent);
+        for (const auto& firstLevel : tree.root.children) {
+            QVERIFY(!firstLevel.parent);
+            for (const auto& secondLevel : firstLevel.children) {
+                QCOMPARE(secondLevel.parent, &firstLevel);
+            }
+        }
+    }
+
+    void testBottomUpModel()
+    {
+        const auto tree = generateTree1();
+
+        QCOMPARE(tree.costs.totalCost(0), qint64(9));
+
+        const auto expectedTree = QStringList {
+            QStringLiteral("C=5"),     QStringLiteral(" B=1"),   QStringLiteral("  A=1"),   QStringLiteral(" E=1"),
+            QStringLiteral("  C=1"),   QStringLiteral("   B=1"), QStringLiteral("    A=1"), QStringLiteral(" C=1"),
+            QStringLiteral("  B=1"),   QStringLiteral("   A=1"), QStringLiteral("D=2"),     QStringLiteral(" B=2"),
+            QStringLiteral("  A=2"),   QStringLiteral("E=2"),    QStringLiteral(" C=2"),    QStringLiteral("  B=1"),
+            QStringLiteral("   A=1"),  QStringLiteral("  E=1"),  QStringLiteral("   C=1"),  QStringLiteral("    B=1"),
+            QStringLiteral("     A=1")};
+        QCOMPARE(printTree(tree), expectedTree);
+
+        BottomUpModel model;
+        QAbstractItemModelTester tester(&model);
+
+        model.setData(tree);
+    }
+
+    void testTreeModelFolding()
+    {
+        const auto tree = generateTree1();
+
+        BottomUpModel model;
+        QAbstractItemModelTester tester(&model);
+        model.setData(tree);
+        QCOMPARE(model.rowCount(), 3);
+
+        auto cost = [](const QModelIndex& index) {
+            const auto costIndex = index.siblingAtColumn(BottomUpModel::NUM_BASE_COLUMNS);
+            return costIndex.data(AbstractTreeModel::SortRole).toLongLong();
+        };
+
+        // D and E are below 25% of the samples and get folded, C stays
+        model.setFoldThreshold(25);
+        QCOMPARE(model.rowCount(), 2);
+        QCOMPARE(model.index(0, BottomUpModel::Symbol).data().toString(), QStringLiteral("C"));
+        const auto other = model.index(1, BottomUpModel::Symbol);
+        QCOMPARE(other.data().toString(), QStringLiteral("other (2 symbol(s))"));
+        QCOMPARE(cost(other), qint64(4));
+        QVERIFY(!other.data(AbstractTreeModel::SymbolRole).isValid());
+        QVERIFY(!model.hasChildren(other));
+        QVERIFY(!other.parent().isValid());
+
+        // all callers of C are folded
+        const auto c = model.index(0, BottomUpModel::Symbol);
+        QCOMPARE(model.rowCount(c), 1);
+        const auto otherCallers = model.index(0, BottomUpModel::Symbol, c);
+        QCOMPARE(otherCallers.data().toString(), QStringLiteral("other (3 symbol(s))"));
+        QCOMPARE(cost(otherCallers), qint64(3));
+        QCOMPARE(otherCallers.parent(), c);
+
+        // the "other" row stays at the end when sorting
+        model.sort(BottomUpModel::InitialSortColumn, Qt::AscendingOrder);
+        QCOMPARE(model.index(1, BottomUpModel::Symbol).data().toString(), QStringLiteral("other (2 symbol(s))"));
+
+        model.setFoldThreshold(0);
+        QCOMPARE(model.rowCount(), 3);
+
+        // folding a single child doesn't save any rows
+        TopDownModel topDownModel;
+        QAbstractItemModelTester topDownTester(&topDownModel);
+        topDownModel.setFoldThreshold(25);
+        topDownModel.setData(Data::TopDownResults::fromBottomUp(tree, false));
+        QCOMPARE(topDownModel.rowCount(), 2);
+    }
+
+    void testInternSymbol()
+    {
+        const auto symbol = Data::Symbol {QStringLiteral("foo"), 42, 0, QStringLiteral("libfoo.so")};
+        const auto otherSymbol = Data::Symbol {QStringLiteral("bar"), 42, 0, QStringLiteral("libfoo.so")};
+
+        const auto interned = Data::internSymbol(symbol);
+        QVERIFY(interned.internId != -1);
+        QCOMPARE(Data::internSymbol(symbol).internId, interned.internId);
+        QCOMPARE(Data::internSymbol(interned).internId, interned.internId);
+
+        const auto otherInterned = Data::internSymbol(otherSymbol);
+        QVERIFY(otherInterned.internId != interned.internId);
+
+        // interned and plain symbols can be mixed freely
+        QCOMPARE(interned, symbol);
+        QVERIFY(interned != otherSymbol);
+        QVERIFY(otherInterned != interned);
+        QCOMPARE(qHash(interned), qHash(symbol));
+        QCOMPARE(qHash(interned, 1234), qHash(symbol, 1234));
+
+        // the binaries and paths are shared by all interned symbols
+        const auto copy = Data::internSymbol(Data::Symbol {QStringLiteral("foo"), 42, 0, QStringLiteral("libfoo.so")});
+        QVERIFY(copy.binary.isSharedWith(interned.binary));
+        QVERIFY(copy.symbol.isSharedWith(interned.symbol));
+        QVERIFY(otherInterned.binary.isSharedWith(interned.binary));
+
+        // the prettified name gets computed on first use and then shared by all copies
+        const auto templated = Data::internSymbol(Data::Symbol {QStringLiteral("foo<std::string>"), 43});
+        QCOMPARE(templated.prettySymbol(), Data::prettifySymbol(templated.symbol));
+        QCOMPARE(templated.prettySymbol(), Data::internSymbol(templated).prettySymbol());
+    }
+
+    void testSymbolTableLease()
+    {
+        const auto symbol = Data::Symbol {QStringLiteral("foo<int>"), 42, 0, QStringLiteral("libfoo.so")};
+
+        auto lease = std::make_unique<Data::SymbolTableLease>();
+        const auto interned = Data::internSymbol(symbol);
+        QCOMPARE(interned.prettySymbol(), Data::prettifySymbol(symbol.symbol));
+        {
+            // the table is in use, so a second lease keeps the symbols
+            Data::SymbolTableLease otherLease;
+            QCOMPARE(Data::internSymbol(symbol).internId, interned.internId);
+        }
+
+        // once all leases got released the next one clears the table, without reusing the ids
+        lease.reset();
+        lease = std::make_unique<Data::SymbolTableLease>();
+        const auto reinterned = Data::internSymbol(symbol);
+        QVERIFY(reinterned.internId > interned.internId);
+        QCOMPARE(reinterned.prettySymbol(), interned.prettySymbol());
+
+        // the recursion guards size their marks by the symbols of the current table
+        QCOMPARE(Data::firstInternId(), reinterned.internId);
+        Data::RecursionGuard guard;
+        guard.reset();
+        QVERIFY(guard.insert(reinterned));
+        QVERIFY(!guard.insert(reinterned));
+        QVERIFY(guard.insert(interned));
+        QVERIFY(!guard.insert(interned));
+    }
+
+    void testCosts()
+    {
+        Data::Costs costs;
+        costs.addType(0, QStringLiteral("cycles"), Data::Costs::Unit::Unknown);
+        costs.add(0, 3, 5);
+        costs.add(0, 1, 2);
+        QCOMPARE(costs.cost(0, 3), qint64(5));
+        QCOMPARE(costs.cost(0, 1), qint64(2));
+        QCOMPARE(costs.cost(0, 2), qint64(0));
+        QCOMPARE(costs.cost(0, 100), qint64(0));
+
+        // adding a type later on keeps the costs of the existing ones
+        costs.addType(1, QStringLiteral("instructions"), Data::Costs::Unit::Unknown);
+        costs.add(1, 3, 7);
+        QCOMPARE(costs.cost(0, 3), qint64(5));
+        QCOMPARE(costs.cost(1, 3), qint64(7));
+        QCOMPARE(costs.cost(1, 1), qint64(0));
+
+        const auto view = costs.itemCostView(3);
+        QCOMPARE(view.size(), 2);
+        QCOMPARE(view[0], qint64(5));
+        QCOMPARE(view[1], qint64(7));
+        QCOMPARE(costs.itemCostView(100)[1], qint64(0));
+        QCOMPARE(costs.itemCost(100).size(), size_t(2));
+
+        Data::Costs other;
+        other.initializeCostsFrom(costs);
+        other.add(0, costs.itemCostView(3));
+        other.add(0, costs.itemCost(1));
+        QCOMPARE(other.cost(0, 0), qint64(7));
+        QCOMPARE(other.cost(1, 0), qint64(7));
+    }
+
+    void testRecursionGuard()
+    {
+        const auto interned = Data::internSymbol({QStringLiteral("recursion"), 1, 0, QStringLiteral("libfoo.so")});
+        const auto other = Data::Symbol {QStringLiteral("other"), 2, 0, QStringLiteral("libfoo.so")};
+
+        Data::RecursionGuard guard;
+        QVERIFY(guard.isEmpty());
+        for (int stack = 0; stack < 3; ++stack) {
+            guard.reset();
+            QVERIFY(guard.isEmpty());
+            QVERIFY(guard.insert(interned));
+            QVERIFY(!guard.isEmpty());
+            QVERIFY(guard.insert(other));
+            QVERIFY(!guard.insert(interned));
+            QVERIFY(!guard.insert(other));
+        }
+
+        const auto callee = Data::internSymbol({QStringLiteral("callee"), 3, 0, QStringLiteral("libfoo.so")});
+        for (int stack = 0; stack < 3; ++stack) {
+            guard.reset();
+            QVERIFY(guard.insertCall(interned, callee));
+            QVERIFY(guard.insertCall(callee, interned));
+            QVERIFY(guard.insertCall(other, callee));
+            QVERIFY(!guard.insertCall(interned, callee));
+            QVERIFY(!guard.insertCall(other, callee));
+        }
+    }
+
+    void testEntryForSymbol()
+    {
+        Data::BottomUp root;
+        quint32 maxId = 0;
+
+        // enough children to trigger the use of the index
+        const int numChildren = 100;
+        for (int i = 0; i < numChildren; ++i) {
+            const auto symbol = Data::Symbol {QString::number(i), {}};
+            auto* node = root.entryForSymbol(symbol, &maxId);
+            QCOMPARE(node->symbol, symbol);
+            QCOMPARE(node->id, quint32(i));
+        }
+        QCOMPARE(root.children.size(), numChildren);
+
+        for (int i = 0; i < numChildren; ++i) {
+            const auto symbol = Data::Symbol {QString::number(i), {}};
+            QCOMPARE(root.entryForSymbol(symbol, &maxId), root.children.data() + i);
+            QCOMPARE(std::as_const(root).entryForSymbol(symbol), root.children.constData() + i);
+        }
+        QCOMPARE(maxId, quint32(numChildren));
+        QVERIFY(!std::as_const(root).entryForSymbol(Data::Symbol {QStringLiteral("unknown"), {}}));
+    }
+
+    void testMergeBottomUp()
+    {
+        auto emptyResults = [] {
+            Data::BottomUpResults results;
+            results.costs.addType(0, QStringLiteral("samples"), Data::Costs::Unit::Unknown);
+            for (const auto& symbol : {"A", "B", "C"}) {
+                results.locations.push_back({});
+                results.symbols.push_back({QString::fromLatin1(symbol), {}});
+            }
+            return results;
+        };
+        auto addStacks = [](Data::BottomUpResults* results, const QVector<QVector<qint32>>& stacks) {
+            for (const auto& stack : stacks) {
+                results->addEvent(0, 1, stack, [](const Data::Symbol&, const Data::Location&) {});
+            }
+        };
+
+        const auto stacks1 = QVector<QVector<qint32>> {{2, 1, 0}, {1, 0}};
+        const auto stacks2 = QVector<QVector<qint32>> {{2, 1, 0}, {2}, {0}};
+
+        auto expected = emptyResults();
+        addStacks(&expected, stacks1 + stacks2);
+        Data::BottomUp::initializeParents(&expected.root);
+
+        auto merged = emptyResults();
+        addStacks(&merged, stacks1);
+        auto other = emptyResults();
+        addStacks(&other, stacks2);
+        merged.merge(other);
+
+        QCOMPARE(merged.costs.totalCost(0), qint64(5));
+        QCOMPARE(printTree(merged), printTree(expected));
+
+        for (const auto& firstLevel : merged.root.children) {
+            for (const auto& secondLevel : firstLevel.children) {
+                QCOMPARE(secondLevel.parent, &firstLevel);
+            }
+        }
+    }
+
+    void testMergeCaptures()
+    {
+        // the same binary installed at different paths, with different events recorded
+        auto capture = [](const QStringList& types, const QString& path) {
+            Data::BottomUpResults results;
+            for (int i = 0, c = types.size(); i < c; ++i) {
+                results.costs.addType(i, types[i], Data::Costs::Unit::Unknown);
+            }
+            const auto binary = QStringLiteral("app");
+            results.symbols = {{QStringLiteral("main"), 1, 0, binary, path},
+                               {QStringLiteral("work"), 2, 0, binary, path}};
+            results.locations = {{-1}, {-1}};
+            return results;
+        };
+        auto frameCallback = [](const Data::Symbol&, const Data::Location&) {};
+
+        auto first = capture({QStringLiteral("cycles")}, QStringLiteral("/opt/a/app"));
+        first.addEvent(0, 10, {1, 0}, frameCallback);
+        auto second = capture({QStringLiteral("instructions"), QStringLiteral("cycles")}, QStringLiteral("/opt/b/app"));
+        second.addEvent(1, 5, {1, 0}, frameCallback);
+        second.addEvent(0, 7, {0}, frameCallback);
+
+        Data::BottomUpResults merged;
+        merged.mergeCapture(first);
+        merged.mergeCapture(second);
+
+        QCOMPARE(merged.costs.numTypes(), 2);
+        QCOMPARE(merged.costs.typeName(0), QStringLiteral("cycles"));
+        QCOMPARE(merged.costs.typeName(1), QStringLiteral("instructions"));
+        QCOMPARE(merged.costs.totalCost(0), qint64(15));
+        QCOMPARE(merged.costs.totalCost(1), qint64(7));
+        const QStringList expectedTree = {
+            QStringLiteral("work=15, 0"),
+            QStringLiteral(" main=15, 0"),
+            QStringLiteral("main=0, 7"),
+        };
+        QCOMPARE(printTree(merged), expectedTree);
+    }
+
+    void testCompareCaptures()
+    {
+        auto capture = []() {
+            Data::BottomUpResults results;
+            results.costs.addType(0, QStringLiteral("cycles"), Data::Costs::Unit::Unknown);
+            const auto binary = QStringLiteral("app");
+            results.symbols = {{QStringLiteral("main"), 1, 0, binary}, {QStringLiteral("work"), 2, 0, binary}};
+            results.locations = {{-1}, {-1}};
+            return results;
+        };
+        auto frameCallback = [](const Data::Symbol&, const Data::Location&) {};
+
+        auto baseline = capture();
+        baseline.addEvent(0, 10, {1, 0}, frameCallback);
+        baseline.addEvent(0, 4, {0}, frameCallback);
+        auto current = capture();
+        current.addEvent(0, 6, {1, 0}, frameCallback);
+        current.addEvent(0, 9, {0}, frameCallback);
+
+        const auto compared = Data::BottomUpResults::compareCaptures(baseline, current);
+        QCOMPARE(compared.costs.numTypes(), 3);
+        QCOMPARE(compared.costs.typeName(0), QStringLiteral("cycles (baseline)"));
+        QCOMPARE(compared.costs.typeName(1), QStringLiteral("cycles"));
+        QCOMPARE(compared.costs.typeName(2), QStringLiteral("cycles (delta)"));
+        QCOMPARE(compared.costs.baselineType(1), -1);
+        QCOMPARE(compared.costs.baselineType(2), 0);
+        QCOMPARE(compared.costs.totalCost(2), qint64(1));
+        // the deltas are relative to the baseline
+        QCOMPARE(compared.costs.referenceCost(2), qint64(14));
+        const QStringList expectedTree = {
+            QStringLiteral("work=10, 6, -4"),
+            QStringLiteral(" main=10, 6, -4"),
+            QStringLiteral("main=4, 9, 5"),
+        };
+        QCOMPARE(printTree(compared), expectedTree);
+
+        // the deltas of work and main cancel each other out for the inclusive cost of main, but not for its self cost
+        const auto topDown = Data::TopDownResults::fromBottomUp(compared, false);
+        QCOMPARE(topDown.root.children.size(), 1);
+        const auto& main = topDown.root.children.constFirst();
+        QCOMPARE(main.symbol.symbol, QStringLiteral("main"));
+        QCOMPARE(topDown.inclusiveCosts.cost(2, main.id), qint64(1));
+        QCOMPARE(topDown.selfCosts.cost(2, main.id), qint64(5));
+        QCOMPARE(topDown.inclusiveCosts.cost(2, main.children.constFirst().id), qint64(-4));
+
+        const Data::DerivedMetrics metrics({}, compared.costs);
+        QCOMPARE(metrics.size(), 1);
+        QCOMPARE(metrics.metric(0).numerator, 2);
+        QCOMPARE(metrics.metric(0).denominator, 0);
+        QCOMPARE(metrics.value(0, compared.root.children.constFirst().id), -0.4);
+    }
+
+    void testFoldInlines()
+    {
+        Data::BottomUpResults results;
+        results.costs.addType(0, QStringLiteral("samples"), Data::Costs::Unit::Unknown);
+        auto addLocation = [&results](const char* symbol, bool isInline, qint32 parentLocationId) {
+            results.symbols.push_back({QString::fromLatin1(symbol), 0, 0, {}, {}, {}, false, isInline});
+            results.locations.push_back({parentLocationId});
+            return results.locations.size() - 1;
+        };
+        const auto main = addLocation("main", false, -1);
+        const auto caller = addLocation("caller", false, -1);
+        const auto inlined = addLocation("inlined", true, caller);
+        const auto nested = addLocation("nested", true, inlined);
+        // nothing to fold it into
+        const auto outermostInline = addLocation("outermostInline", true, -1);
+
+        auto frames = [&results](const QVector<qint32>& stack) {
+            QStringList symbols;
+            results.foreachFrame(stack, [&symbols](const Data::Symbol& symbol, const Data::Location&) {
+                symbols.append(symbol.symbol);
+                return true;
+            });
+            return symbols.join(QLatin1Char(';'));
+        };
+
+        const auto stack = QVector<qint32> {nested, main};
+        const auto outermostInlineStack = QVector<qint32> {outermostInline, main};
+        QCOMPARE(frames(stack), QStringLiteral("nested;inlined;caller;main"));
+        QCOMPARE(frames(outermostInlineStack), QStringLiteral("outermostInline;main"));
+
+        results.foldInlines = true;
+        QCOMPARE(frames(stack), QStringLiteral("caller;main"));
+        QCOMPARE(frames(outermostInlineStack), QStringLiteral("outermostInline;main"));
+
+        results.addEvent(0, 1, stack, [](const Data::Symbol&, const Data::Location&) {});
+        Data::BottomUp::initializeParents(&results.root);
+        QCOMPARE(printTree(results), QStringList({QStringLiteral("caller=1"), QStringLiteral(" main=1")}));
+    }
+
+    void testStackIndex()
+    {
+        Data::BottomUpResults results;
+        const auto libA = QStringLiteral("libA.so");
+        const auto libB = QStringLiteral("libB.so");
+        const auto a = Data::Symbol {QStringLiteral("a"), 1, 0, libA};
+        const auto b = Data::Symbol {QStringLiteral("b"), 2, 0, libA};
+        const auto c = Data::Symbol {QStringLiteral("c"), 3, 0, libB};
+        for (const auto& symbol : {a, b, c}) {
+            results.locations.push_back({});
+            results.symbols.push_back(symbol);
+        }
+        const auto stacks = QVector<QVector<qint32>> {{0}, {1, 0}, {2, 1}, {2}};
+        const Data::StackIndex index(results, stacks);
+        QVERIFY(!index.isEmpty());
+
+        auto filterStacks = [&index](auto setup) {
+            Data::FilterAction filter;
+            setup(filter);
+            return index.filterStacks(filter);
+        };
+
+        QCOMPARE(filterStacks([](Data::FilterAction&) {}), QVector<bool>({true, true, true, true}));
+        QCOMPARE(filterStacks([&](Data::FilterAction& filter) { filter.includeSymbols = {b}; }),
+                 QVector<bool>({false, true, true, false}));
+        QCOMPARE(filterStacks([&](Data::FilterAction& filter) { filter.includeSymbols = {a, b}; }),
+                 QVector<bool>({false, true, false, false}));
+        QCOMPARE(filterStacks([&](Data::FilterAction& filter) { filter.excludeSymbols = {c}; }),
+                 QVector<bool>({true, true, false, false}));
+        QCOMPARE(filterStacks([&](Data::FilterAction& filter) { filter.includeBinaries = {libB}; }),
+                 QVector<bool>({false, false, true, true}));
+        QCOMPARE(filterStacks([&](Data::FilterAction& filter) {
+                     filter.includeBinaries = {libA};
+                     filter.excludeSymbols = {a};
+                 }),
+                 QVector<bool>({false, false, true, false}));
+        QCOMPARE(filterStacks([&](Data::FilterAction& filter) {
+                     filter.includeSymbols = {Data::Symbol {QStringLiteral("unknown"), {}}};
+                 }),
+                 QVector<bool>({false, false, false, false}));
+
+        QCOMPARE(index.stacksWithSymbol(b), QVector<qint32>({1, 2}));
+        QCOMPARE(index.stacksWithSymbol(Data::Symbol {QStringLiteral("unknown"), {}}), QVector<qint32>());
+
+        using Direction = Data::StackIndex::Direction;
+        QCOMPARE(index.stacksWithPrefix({c}, Direction::FromLeaf), QVector<qint32>({2, 3}));
+        QCOMPARE(index.stacksWithPrefix({c, b}, Direction::FromLeaf), QVector<qint32>({2}));
+        QCOMPARE(index.stacksWithPrefix({b}, Direction::FromLeaf), QVector<qint32>({1}));
+        QCOMPARE(index.stacksWithPrefix({a}, Direction::FromOutermostCaller), QVector<qint32>({0, 1}));
+        QCOMPARE(index.stacksWithPrefix({a, b}, Direction::FromOutermostCaller), QVector<qint32>({1}));
+        QCOMPARE(index.stacksWithPrefix({b, c}, Direction::FromOutermostCaller), QVector<qint32>({2}));
+        QCOMPARE(index.stacksWithPrefix({c, a}, Direction::FromOutermostCaller), QVector<qint32>());
+        QCOMPARE(index.stacksWithPrefix({}, Direction::FromLeaf), QVector<qint32>({0, 1, 2, 3}));
+    }
+
+    void testSymbolTimeSeries()
+    {
+        Data::BottomUpResults results;
+        const auto a = Data::Symbol {QStringLiteral("a"), 1, 0, QStringLiteral("libA.so")};
+        const auto b = Data::Symbol {QStringLiteral("b"), 2, 0, QStringLiteral("libA.so")};
+        const auto c = Data::Symbol {QStringLiteral("c"), 3, 0, QStringLiteral("libB.so")};
+        for (const auto& symbol : {a, b, c}) {
+            results.locations.push_back({});
+            results.symbols.push_back(symbol);
+        }
+
+        Data::EventResults events;
+        // the leaf frame comes first
+        events.stacks = {{0}, {1, 0}, {2}};
+        events.threads.resize(2);
+        // a runs on its own first, then it calls b, which is more expensive
+        for (int i = 0; i < 100; ++i) {
+            events.threads[0].events.push_back({1000 + quint64(i) * 10, i < 50 ? 1u : 5u, 0, i < 50 ? 0 : 1, 0});
+        }
+        // the events of other cost types and other symbols don't count
+        events.threads[1].events.push_back({1500, 100, 1, 0, 0});
+        events.threads[1].events.push_back({1500, 100, 0, 2, 0});
+        const Data::StackIndex stackIndex(results, events.stacks);
+
+        const SymbolTimeSeriesIndex index(events, stackIndex);
+        QCOMPARE(index.time(), Data::TimeRange(1000, 1990));
+
+        const auto seriesA = index.series(a, 0, 10);
+        QCOMPARE(seriesA.numBuckets(), 10);
+        QCOMPARE(seriesA.bucketTime(0).start, quint64(1000));
+        QCOMPARE(seriesA.bucketTime(9).end, quint64(1990));
+        QCOMPARE(seriesA.inclusiveCosts, QVector<quint64>({10, 10, 10, 10, 10, 50, 50, 50, 50, 50}));
+        QCOMPARE(seriesA.selfCosts, QVector<quint64>({10, 10, 10, 10, 10, 0, 0, 0, 0, 0}));
+        QCOMPARE(seriesA.changePoints, QVector<int>({5}));
+
+        const auto seriesB = index.series(b, 0, 10);
+        QCOMPARE(seriesB.inclusiveCosts, QVector<quint64>({0, 0, 0, 0, 0, 50, 50, 50, 50, 50}));
+        QCOMPARE(seriesB.selfCosts, seriesB.inclusiveCosts);
+
+        // only the first half of the time
+        const auto firstHalf = index.series(a, 0, 5, {1000, 1490});
+        QCOMPARE(firstHalf.inclusiveCosts, QVector<quint64>({10, 10, 10, 10, 10}));
+        QVERIFY(firstHalf.changePoints.isEmpty());
+
+        QCOMPARE(index.series(a, 1, 10).inclusiveCosts, QVector<quint64>({0, 0, 0, 0, 0, 100, 0, 0, 0, 0}));
+        QCOMPARE(index.series(Data::Symbol {QStringLiteral("unknown"), {}}, 0, 10).inclusiveCosts,
+                 QVector<quint64>(10, 0));
+
+        // the jitter doesn't make a phase, but the steps do
+        QVector<quint64> values;
+        for (int i = 0; i < 32; ++i) {
+            values.push_back(i % 2 ? 12 : 10);
+        }
+        QVERIFY(SymbolTimeSeries::changePoints(values).isEmpty());
+        for (int i = 12; i < 20; ++i) {
+            values[i] += 100;
+        }
+        QCOMPARE(SymbolTimeSeries::changePoints(values), QVector<int>({12, 20}));
+        QCOMPARE(SymbolTimeSeries::changePoints(values, 1).size(), 1);
+        QVERIFY(SymbolTimeSeries::changePoints(QVector<quint64>(16, 7)).isEmpty());
+
+        SymbolTimeSeriesCache cache;
+        BottomUpModel model;
+        QAbstractItemModelTester tester(&model);
+        model.setData(generateTree1());
+        const auto numColumns = model.columnCount();
+        QCOMPARE(model.timeSeriesColumn(), -1);
+        model.setTimeSeries(&cache);
+        QCOMPARE(model.columnCount(), numColumns + 1);
+        QCOMPARE(model.timeSeriesColumn(), numColumns);
+        // without events, there is nothing to compute
+        QVERIFY(!model.index(0, numColumns).data(BottomUpModel::TimeSeriesRole).isValid());
+    }
+
+    void testConcurrencyProfile()
+    {
+        Data::EventResults events;
+        events.offCpuTimeCostId = 1;
+        events.threads.resize(3);
+        // runs in [0, 20) and [50, 100)
+        auto& a = events.threads[0];
+        a.time = {0, 100};
+        a.state = Data::ThreadEvents::OnCpu;
+        a.events.push_back({5, 1, 0, -1, 0});
+        a.events.push_back({20, 30, 1, -1, 0});
+        // runs in [10, 40) and [60, 80), the last switch out has no off-CPU time event
+        auto& b = events.threads[1];
+        b.time = {10, 90};
+        b.state = Data::ThreadEvents::OffCpu;
+        b.lastSwitchTime = 80;
+        b.events.push_back({40, 20, 1, -1, 0});
+        // never got switched, so it's unknown when it ran
+        auto& c = events.threads[2];
+        c.time = {0, 100};
+        c.events.push_back({50, 1, 0, -1, 0});
+
+        const ConcurrencyProfile profile(events);
+        using Step = ConcurrencyProfile::Step;
+        QCOMPARE(profile.steps(),
+                 QVector<Step>({{0, 1}, {10, 2}, {20, 1}, {40, 0}, {50, 1}, {60, 2}, {80, 1}, {100, 0}}));
+        QCOMPARE(profile.time(), Data::TimeRange(0, 100));
+        QCOMPARE(profile.histogram(), QVector<quint64>({10, 60, 30}));
+        QCOMPARE(profile.maxRunningThreads(), 2);
+        QCOMPARE(profile.averageRunningThreads(), 1.2);
+        QCOMPARE(profile.averageRunningThreads({0, 20}), 1.5);
+        QCOMPARE(profile.averageRunningThreads({65, 65}), 2.);
+        QCOMPARE(profile.runningThreads(5), 1);
+        QCOMPARE(profile.runningThreads(15), 2);
+        QCOMPARE(profile.runningThreads(45), 0);
+        QCOMPARE(profile.runningThreads(100), 0);
+
+        // the sampled off-CPU time doesn't tell when the threads ran
+        events.offCpuTimeSampled = true;
+        QVERIFY(ConcurrencyProfile(events).isEmpty());
+        events.offCpuTimeSampled = false;
+        events.offCpuTimeCostId = -1;
+        QVERIFY(ConcurrencyProfile(events).isEmpty());
+    }
+
+    void testFlameGraphData()
+    {
+        const auto tree = generateTree1();
+        const auto rootSymbol = Data::Symbol(QStringLiteral("root"));
+
+        auto data = FlameGraphData::build(tree.costs, 0, tree.root.children, 0, false, rootSymbol);
+        QCOMPARE(data.symbol(0), rootSymbol);
+        QCOMPARE(data.node(0).cost, qint64(9));
+        QCOMPARE(data.node(0).firstChild, 1);
+        QCOMPARE(data.node(0).numChildren, 3);
+
+        // the children are sorted by symbol
+        const auto expectedChildren = QVector<QPair<QString, qint64>> {
+            {QStringLiteral("C"), 5}, {QStringLiteral("D"), 2}, {QStringLiteral("E"), 2}};
+        for (int i = 0; i < expectedChildren.size(); ++i) {
+            QCOMPARE(data.symbol(i + 1).symbol, expectedChildren[i].first);
+            QCOMPARE(data.node(i + 1).cost, expectedChildren[i].second);
+            QCOMPARE(data.node(i + 1).parent, 0);
+            QCOMPARE(data.node(i + 1).depth, 1);
+        }
+
+        // the nodes are stored breadth first
+        for (qint32 id = 1; id < data.size(); ++id) {
+            QVERIFY(data.node(id).depth >= data.node(id - 1).depth);
+            QVERIFY(data.node(id).parent < id);
+        }
+
+        const auto c = 1;
+        QCOMPARE(data.node(c).numChildren, 3);
+        QCOMPARE(data.findChild(c, Data::Symbol(QStringLiteral("C"))), data.node(c).firstChild + 1);
+        QCOMPARE(data.findChild(c, Data::Symbol(QStringLiteral("D"))), -1);
+
+        data.layout(0, 900);
+        QCOMPARE(data.numVisibleRows(), 7);
+        QCOMPARE(data.visibleNodes(1), (QVector<qint32> {1, 2, 3}));
+        QCOMPARE(data.width(1), 500.);
+        QCOMPARE(data.x(2), 500.);
+        QCOMPARE(data.nodeAt(1, 0), 1);
+        QCOMPARE(data.nodeAt(1, 600), 2);
+        QCOMPARE(data.nodeAt(1, 800), 3);
+        QCOMPARE(data.nodeAt(1, 950), -1);
+        QCOMPARE(data.nodeAt(0, 950), -1);
+        QCOMPARE(data.nodeAt(0, 10), 0);
+        QCOMPARE(data.nodeAt(7, 10), -1);
+
+        // zooming into C hides its siblings
+        data.layout(c, 900);
+        QCOMPARE(data.visibleNodes(1), (QVector<qint32> {1}));
+        QCOMPARE(data.width(c), 900.);
+        QVERIFY(!data.isVisible(2));
+        QCOMPARE(data.nodeAt(1, 600), c);
+
+        // collapsing the recursion merges C;C into C
+        data = FlameGraphData::build(tree.costs, 0, tree.root.children, 0, true, rootSymbol);
+        QCOMPARE(data.node(c).numChildren, 2);
+        const auto b = data.findChild(c, Data::Symbol(QStringLiteral("B")));
+        QVERIFY(b != -1);
+        QCOMPARE(data.node(b).cost, qint64(2));
+        QCOMPARE(data.findChild(c, Data::Symbol(QStringLiteral("C"))), -1);
+
+        // children of cheap nodes are skipped
+        data = FlameGraphData::build(tree.costs, 0, tree.root.children, 4, false, rootSymbol);
+        QCOMPARE(data.node(c).numChildren, 3);
+        QCOMPARE(data.node(2).numChildren, 0);
+        QCOMPARE(data.node(3).numChildren, 0);
+
+        // items are mapped across graphs through their symbol path
+        const auto unfiltered = FlameGraphData::build(tree.costs, 0, tree.root.children, 0, false, Data::Symbol());
+        QCOMPARE(data.findNode(unfiltered, 0), 0);
+        const auto cc = unfiltered.findChild(c, Data::Symbol(QStringLiteral("C")));
+        QCOMPARE(data.findNode(unfiltered, cc), data.findChild(c, Data::Symbol(QStringLiteral("C"))));
+        QCOMPARE(data.findNode(unfiltered, unfiltered.node(2).firstChild), -1);
+
+        // building depth by depth only ever appends nodes
+        const auto full = FlameGraphData::build(tree.costs, 0, tree.root.children, 0, false, rootSymbol);
+        FlameGraphBuilder<Data::BottomUp> builder(tree.costs, 0, tree.root.children, 0, false, rootSymbol);
+        QCOMPARE(builder.data().size(), 1);
+        QVERIFY(builder.buildNextDepth());
+        QCOMPARE(builder.data().size(), 4);
+        QCOMPARE(builder.data().symbol(1), full.symbol(1));
+        while (builder.buildNextDepth()) {
+            QVERIFY(!builder.isFinished());
+        }
+        QVERIFY(builder.isFinished());
+        QCOMPARE(builder.data().size(), full.size());
+        for (qint32 id = 0; id < full.size(); ++id) {
+            QCOMPARE(builder.data().symbol(id), full.symbol(id));
+            QCOMPARE(builder.data().node(id).parent, full.node(id).parent);
+        }
+    }
+
+    void testFlameGraphSearch()
+    {
+        const auto tree = buildBottomUpTree(R"(
+            drawWidget;paintEvent;main
+            drawText;drawWidget;paintEvent;main
+            drawText;main
+        )");
+        auto data = FlameGraphData::build(tree.costs, 0, tree.root.children, 0, false,
+                                          Data::Symbol(QStringLiteral("root")));
+        QCOMPARE(data.size(), 6);
+        QCOMPARE(data.symbol(2).symbol, QStringLiteral("drawText"));
+        QCOMPARE(data.symbol(4).symbol, QStringLiteral("drawWidget"));
+        QCOMPARE(data.symbol(5).symbol, QStringLiteral("drawText"));
+
+        QCOMPARE(data.search(QStringLiteral("draw")), (QVector<qint32> {2, 4, 5}));
+        QCOMPARE(data.search(QStringLiteral("DRAWTEXT")), (QVector<qint32> {2, 5}));
+        QCOMPARE(data.search(QStringLiteral("wid")), (QVector<qint32> {4}));
+        QCOMPARE(data.search(QStringLiteral("main")), (QVector<qint32> {1}));
+        // too short for the trigram index
+        QCOMPARE(data.search(QStringLiteral("xt")), (QVector<qint32> {2, 5}));
+        QCOMPARE(data.search(QStringLiteral("textdraw")), QVector<qint32>());
+        QCOMPARE(data.search(QStringLiteral("foo")), QVector<qint32>());
+    }
+
+    void testFlameGraphDiff()
+    {
+        const auto tree = generateTree1();
+        const auto baseline = buildBottomUpTree(R"(
+            A;B;C
+            A;B;D
+            C
+            X
+        )");
+        const auto rootSymbol = Data::Symbol(QStringLiteral("root"));
+
+        auto data = FlameGraphData::build(tree.costs, 0, tree.root.children, 0, false, rootSymbol);
+        QVERIFY(!data.hasBaseline());
+        FlameGraphDiff<Data::BottomUp> diff(baseline.costs, 0, baseline.root.children, false);
+        diff.update(&data, true);
+        QVERIFY(data.hasBaseline());
+        QCOMPARE(data.baselineCost(0), qint64(4));
+
+        const auto c = data.findChild(0, Data::Symbol(QStringLiteral("C")));
+        QCOMPARE(data.baselineCost(c), qint64(2));
+        QCOMPARE(data.baselineCost(data.findChild(0, Data::Symbol(QStringLiteral("D")))), qint64(1));
+        // frames that only exist in the new capture
+        QCOMPARE(data.baselineCost(data.findChild(0, Data::Symbol(QStringLiteral("E")))), qint64(0));
+        QCOMPARE(data.baselineCost(data.findChild(c, Data::Symbol(QStringLiteral("C")))), qint64(0));
+        QCOMPARE(data.baselineCost(data.findChild(c, Data::Symbol(QStringLiteral("B")))), qint64(1));
+
+        // intermediate results of a progressive build yield the same costs
+        FlameGraphBuilder<Data::BottomUp> builder(tree.costs, 0, tree.root.children, 0, false, rootSymbol);
+        FlameGraphDiff<Data::BottomUp> progressiveDiff(baseline.costs, 0, baseline.root.children, false);
+        bool isComplete = false;
+        while (!isComplete) {
+            isComplete = !builder.buildNextDepth();
+            auto partial = builder.data();
+            progressiveDiff.update(&partial, isComplete);
+            for (qint32 id = 0; id < partial.size(); ++id) {
+                QCOMPARE(partial.baselineCost(id), data.baselineCost(id));
+            }
+        }
+    }
+
+    void testFlameGraphMultiples()
+    {
+        const auto app = QStringLiteral("app");
+        Data::BottomUpResults bottomUp;
+        bottomUp.costs.addType(0, QStringLiteral("cycles"), Data::Costs::Unit::Unknown);
+        for (const auto& symbol : {Data::Symbol {QStringLiteral("main"), 1, 0, app},
+                                   Data::Symbol {QStringLiteral("run"), 2, 0, app},
+                                   Data::Symbol {QStringLiteral("foo"), 3, 0, app},
+                                   Data::Symbol {QStringLiteral("bar"), 4, 0, app}}) {
+            bottomUp.locations.push_back({});
+            bottomUp.symbols.push_back(symbol);
+        }
+
+        Data::EventResults events;
+        // from the leaf to the outermost caller: main;run;foo, main;bar and main;run
+        events.stacks = {{2, 1, 0}, {3, 0}, {1, 0}};
+        Data::ThreadEvents mainThread;
+        mainThread.pid = 1;
+        mainThread.tid = 1;
+        mainThread.name = app;
+        mainThread.events.push_back({1000000000, 10, 0, 0, 0});
+        mainThread.events.push_back({2000000000, 20, 0, 1, 0});
+        mainThread.events.push_back({3000000000, 5, 0, 2, 0});
+        Data::ThreadEvents worker;
+        worker.pid = 1;
+        worker.tid = 2;
+        worker.name = QStringLiteral("worker");
+        worker.events.push_back({6000000000, 7, 0, 0, 1});
+        Data::ThreadEvents other;
+        other.pid = 3;
+        other.tid = 3;
+        other.name = QStringLiteral("other");
+        other.events.push_back({1000000000, 50, 0, 0, 2});
+        // threads without any cost get no graph
+        Data::ThreadEvents idle;
+        idle.pid = 3;
+        idle.tid = 4;
+        idle.name = QStringLiteral("idle");
+        events.threads = {mainThread, worker, other, idle};
+
+        using namespace FlameGraphMultiples;
+        const auto threads = groups(events, 0, Grouping::Thread, 10);
+        QCOMPARE(threads.size(), 3);
+        QCOMPARE(threads[0].tid, 3);
+        QCOMPARE(threads[0].cost, qint64(50));
+        QCOMPARE(threads[1].tid, 1);
+        QCOMPARE(threads[1].cost, qint64(35));
+        QCOMPARE(threads[2].name, QStringLiteral("worker"));
+        QCOMPARE(groups(events, 0, Grouping::Thread, 2).size(), 2);
+
+        const auto processes = groups(events, 0, Grouping::Process, 10);
+        QCOMPARE(processes.size(), 2);
+        QCOMPARE(processes[0].pid, 3);
+        QCOMPARE(processes[1].pid, 1);
+        QCOMPARE(processes[1].tid, Data::INVALID_TID);
+        QCOMPARE(processes[1].name, app);
+        QCOMPARE(processes[1].cost, qint64(42));
+        QCOMPARE(processes[1].threads, QVector<qint32>({0, 1}));
+
+        const auto data = build(bottomUp, events, processes[1], 0, 0);
+        QCOMPARE(data.node(0).cost, qint64(42));
+        QCOMPARE(data.symbol(0).symbol, app);
+        const auto main = data.findChild(0, bottomUp.symbols[0]);
+        QVERIFY(main != -1);
+        QCOMPARE(data.node(main).cost, qint64(42));
+        QCOMPARE(data.node(data.findChild(main, bottomUp.symbols[1])).cost, qint64(22));
+        QCOMPARE(data.node(data.findChild(main, bottomUp.symbols[3])).cost, qint64(20));
+
+        // the other process only ran foo
+        const auto otherData = build(bottomUp, events, processes[0], 0, 0);
+        QCOMPARE(otherData.node(0).cost, qint64(50));
+        QCOMPARE(otherData.findChild(otherData.findChild(0, bottomUp.symbols[0]), bottomUp.symbols[3]), -1);
+    }
+
+    void testFlameGraphExport()
+    {
+        const auto tree = generateTree1();
+        QBuffer buffer;
+        QVERIFY(buffer.open(QIODevice::WriteOnly));
+        QVERIFY(FlameGraphExport::writeSvg(&buffer, tree, 0));
+        buffer.close();
+
+        // one frame per node of the tree, plus the root
+        const auto data = FlameGraphData::build(tree.costs, 0, tree.root.children, 0, false, Data::Symbol());
+        QXmlStreamReader reader(buffer.data());
+        int numFrames = 0;
+        QStringList titles;
+        while (!reader.atEnd()) {
+            if (reader.readNext() != QXmlStreamReader::StartElement) {
+                continue;
+            }
+            if (reader.name() == QLatin1String("rect")) {
+                ++numFrames;
+            } else if (reader.name() == QLatin1String("title")) {
+                titles.append(reader.readElementText());
+            }
+        }
+        QVERIFY(!reader.hasError());
+        QCOMPARE(numFrames, data.size());
+        QVERIFY(titles.contains(QStringLiteral("C (5, 55.6%)")));
+
+        // skipping narrow frames also skips their children
+        buffer.setData({});
+        QVERIFY(buffer.open(QIODevice::WriteOnly));
+        FlameGraphExport::Options options;
+        options.width = 100;
+        options.minWidth = 30;
+        QVERIFY(FlameGraphExport::writeSvg(&buffer, tree, 0, options));
+        QCOMPARE(buffer.data().count("<rect"), 2);
+    }
+
+    void testReportExport()
+    {
+        ReportExport::Results results;
+        results.file = QStringLiteral("perf.data");
+        results.topDown = Data::TopDownResults::fromBottomUp(generateTree1(), false);
+
+        QString stacks;
+        QTextStream stream(&stacks);
+        ReportExport::writeCollapsedStacks(&stream, results.topDown, 0);
+        stream.flush();
+        // the folded stacks have the same format as the input of generateTree1
+        const QStringList expectedStacks = {
+            QStringLiteral("A;B;C 1"),     QStringLiteral("A;B;C;C 1"),     QStringLiteral("A;B;C;E 1"),
+            QStringLiteral("A;B;C;E;C 1"), QStringLiteral("A;B;C;E;C;E 1"), QStringLiteral("A;B;D 2"),
+            QStringLiteral("C 2"),
+        };
+        QCOMPARE(stacks.split(QLatin1Char('\n'), Qt::SkipEmptyParts), expectedStacks);
+
+        const auto format = ReportExport::formatForFileName(QStringLiteral("report.folded"));
+        QCOMPARE(format, ReportExport::Format::Collapsed);
+        const auto collapsed = ReportExport::merge(format, {ReportExport::report(format, results)});
+        QVERIFY(collapsed.startsWith("perf.data;A;B;C 1\n"));
+
+        const auto json = ReportExport::merge(ReportExport::Format::Json,
+                                              {ReportExport::report(ReportExport::Format::Json, results),
+                                               ReportExport::report(ReportExport::Format::Json, results)});
+        QJsonParseError error;
+        const auto document = QJsonDocument::fromJson(json, &error);
+        QCOMPARE(error.error, QJsonParseError::NoError);
+        QCOMPARE(document.array().size(), 2);
+        const auto report = document.array().at(0).toObject();
+        QCOMPARE(report.value(QLatin1String("file")).toString(), results.file);
+        QCOMPARE(report.value(QLatin1String("collapsedStacks")).toArray().size(), expectedStacks.size());
+
+        const auto csv = ReportExport::merge(ReportExport::Format::Csv,
+                                             {ReportExport::report(ReportExport::Format::Csv, results)});
+        QVERIFY(csv.startsWith("file,section,name,binary,pid,tid,selfCost,inclusiveCost\n"));
+        QVERIFY(csv.contains("perf.data,stack,A;B;D,,,,2,2\n"));
+    }
+
+    void testResultsQuery()
+    {
+        const auto app = QStringLiteral("app");
+        const auto libFoo = QStringLiteral("libfoo.so");
+        Data::BottomUpResults bottomUp;
+        bottomUp.costs.addType(0, QStringLiteral("cycles"), Data::Costs::Unit::Unknown);
+        for (const auto& symbol : {Data::Symbol {QStringLiteral("main"), 1, 0, app},
+                                   Data::Symbol {QStringLiteral("run"), 2, 0, app},
+                                   Data::Symbol {QStringLiteral("foo(int, int)"), 3, 0, libFoo},
+                                   Data::Symbol {QStringLiteral("bar"), 4, 0, libFoo}}) {
+            bottomUp.locations.push_back({});
+            bottomUp.symbols.push_back(symbol);
+        }
+
+        Data::EventResults events;
+        // from the leaf to the outermost caller: main;run;foo, main;bar and main;run
+        events.stacks = {{2, 1, 0}, {3, 0}, {1, 0}};
+        Data::ThreadEvents mainThread;
+        mainThread.pid = 1;
+        mainThread.tid = 1;
+        mainThread.name = app;
+        mainThread.events.push_back({1000000000, 10, 0, 0, 0});
+        mainThread.events.push_back({2000000000, 20, 0, 1, 0});
+        mainThread.events.push_back({3000000000, 5, 0, 2, 0});
+        Data::ThreadEvents worker;
+        worker.pid = 1;
+        worker.tid = 2;
+        worker.name = QStringLiteral("worker");
+        worker.events.push_back({6000000000, 7, 0, 0, 1});
+        events.threads = {mainThread, worker};
+        const Data::StackIndex stackIndex(bottomUp, events.stacks);
+
+        auto evaluate = [&](const QString& spec, const Data::StackIndex& index) {
+            QString errorMessage;
+            const auto query = ResultsQuery::Query::fromString(spec, &errorMessage);
+            if (!query) {
+                qWarning() << spec << errorMessage;
+                return ResultsQuery::Result();
+            }
+            return ResultsQuery::evaluate(*query, bottomUp, events, index);
+        };
+        auto cost = [&](const QString& spec) {
+            const auto result = evaluate(spec, stackIndex);
+            // the stack index only speeds up the call paths
+            const auto withoutIndex = evaluate(spec, {});
+            return result.cost == withoutIndex.cost ? result.cost : -1;
+        };
+
+        QCOMPARE(cost({}), 42);
+        QCOMPARE(cost(QStringLiteral("binary=libfoo.so")), 37);
+        QCOMPARE(cost(QStringLiteral("binary=libfoo.so under=main;run")), 17);
+        QCOMPARE(cost(QStringLiteral("under=run")), 22);
+        QCOMPARE(cost(QStringLiteral("under=run;main")), 0);
+        QCOMPARE(cost(QStringLiteral("symbol=foo")), 17);
+        QCOMPARE(cost(QStringLiteral("symbol=\"foo(int, int)\",bar")), 37);
+        QCOMPARE(cost(QStringLiteral("last=1")), 7);
+        QCOMPARE(cost(QStringLiteral("time=0-1.5")), 30);
+        QCOMPARE(cost(QStringLiteral("time=2-")), 12);
+        QCOMPARE(cost(QStringLiteral("tid=2")), 7);
+        QCOMPARE(cost(QStringLiteral("pid=app cpu=0")), 35);
+        QCOMPARE(cost(QStringLiteral("cpu=0-1")), 42);
+        QCOMPARE(cost(QStringLiteral("cpu=1,3-4")), 7);
+        QCOMPARE(cost(QStringLiteral("pid=2")), 0);
+        QCOMPARE(cost(QStringLiteral("type=cycles")), 42);
+
+        const auto symbols = evaluate(QStringLiteral("group=symbol top=2"), stackIndex);
+        QCOMPARE(symbols.numSamples, 4);
+        QCOMPARE(symbols.rows.size(), 2);
+        QCOMPARE(symbols.rows[0].name, QStringLiteral("bar"));
+        QCOMPARE(symbols.rows[0].cost, 20);
+        QCOMPARE(symbols.rows[1].name, QStringLiteral("foo(int, int)"));
+        QCOMPARE(symbols.rows[1].binary, libFoo);
+        QCOMPARE(symbols.rows[1].cost, 17);
+        QCOMPARE(symbols.rows[1].numSamples, 2);
+
+        const auto threads = evaluate(QStringLiteral("group=thread"), stackIndex).toJson();
+        QCOMPARE(threads.value(QLatin1String("costType")).toString(), QStringLiteral("cycles"));
+        const auto rows = threads.value(QLatin1String("rows")).toArray();
+        QCOMPARE(rows.size(), 2);
+        QCOMPARE(rows.at(0).toObject().value(QLatin1String("name")).toString(), app);
+        QCOMPARE(rows.at(0).toObject().value(QLatin1String("cost")).toInt(), 35);
+        QCOMPARE(rows.at(1).toObject().value(QLatin1String("tid")).toInt(), 2);
+
+        QVERIFY(!evaluate(QStringLiteral("type=unknown"), stackIndex).error.isEmpty());
+        QVERIFY(!ResultsQuery::Query::fromString(QStringLiteral("foo")));
+        QVERIFY(!ResultsQuery::Query::fromString(QStringLiteral("group=everything")));
+        QVERIFY(!ResultsQuery::Query::fromString(QStringLiteral("symbol=\"foo")));
+        QVERIFY(!ResultsQuery::Query::fromString(QStringLiteral("time=5")));
+        QVERIFY(!ResultsQuery::Query::fromString(QStringLiteral("cpu=3-1")));
+
+        // the worker continues on the NUMA node of the main thread
+        events.cpus.resize(2);
+        events.cpus[0].numaNode = 0;
+        events.cpus[1].numaNode = 1;
+        events.threads[1].events.push_back({7000000000, 3, 0, 0, 0});
+        events.updateNumaMigrations();
+        QCOMPARE(events.numaMigrations, (QVector<quint64> {1, 0}));
+        QCOMPARE(events.threads[0].numaMigrations, quint64(0));
+        QCOMPARE(events.threads[1].numaMigrations, quint64(1));
+
+        const auto nodes = evaluate(QStringLiteral("group=numa"), stackIndex);
+        QCOMPARE(nodes.rows.size(), 2);
+        QCOMPARE(nodes.rows[0].name, QStringLiteral("NUMA node 0"));
+        QVERIFY(nodes.rows[0].numaNode == 0);
+        QCOMPARE(nodes.rows[0].cost, 38);
+        QCOMPARE(nodes.rows[0].numaMigrations, 1);
+        QVERIFY(nodes.rows[1].numaNode == 1);
+        QCOMPARE(nodes.rows[1].cost, 7);
+        QCOMPARE(nodes.rows[1].numaMigrations, 0);
+        const auto nodeRows = nodes.toJson().value(QLatin1String("rows")).toArray();
+        QCOMPARE(nodeRows.at(0).toObject().value(QLatin1String("numaNode")).toInt(), 0);
+        QCOMPARE(nodeRows.at(0).toObject().value(QLatin1String("numaMigrations")).toInt(), 1);
+    }
+
+    void testPerfettoExport()
+    {
+        const auto app = QStringLiteral("app");
+        Data::BottomUpResults bottomUp;
+        bottomUp.costs.addType(0, QStringLiteral("cycles"), Data::Costs::Unit::Unknown);
+        bottomUp.costs.addType(1, QStringLiteral("off-CPU Time"), Data::Costs::Unit::Time);
+        quint64 address = 0x1000;
+        for (const auto& name : {QStringLiteral("main"), QStringLiteral("run"), QStringLiteral("foo")}) {
+            bottomUp.locations.push_back({-1, Data::Location(address, address, {})});
+            bottomUp.symbols.push_back({name, address, 0x100, app, QStringLiteral("/usr/bin/app")});
+            address += 0x100;
+        }
+
+        Data::EventResults events;
+        events.totalCosts = {{QStringLiteral("cycles"), 3, 30, Data::Costs::Unit::Unknown},
+                             {QStringLiteral("off-CPU Time"), 1, 500, Data::Costs::Unit::Time}};
+        events.offCpuTimeCostId = 1;
+        // main;run;foo and main;run
+        events.stacks = {{2, 1, 0}, {1, 0}};
+        Data::ThreadEvents thread;
+        thread.pid = 1;
+        thread.tid = 1;
+        thread.name = app;
+        thread.events.push_back({1000, 10, 0, 0, 0});
+        thread.events.push_back({2000, 10, 0, 0, 1});
+        thread.events.push_back({2500, 500, 1, -1, 1});
+        thread.events.push_back({3000, 10, 0, 1, 0});
+        events.threads = {thread};
+        events.addLostEvents(5000, 3);
+
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(PerfettoExport::write(&buffer, bottomUp, events));
+        QVERIFY(PerfettoExport::isTraceFile(QStringLiteral("capture.pftrace")));
+        QVERIFY(!PerfettoExport::isTraceFile(QStringLiteral("capture.perfparser")));
+
+        QVector<QString> trackNames;
+        QVector<quint64> sliceTimes;
+        QVector<quint64> sampleSequences;
+        QVector<quint64> sampleStacks;
+        QHash<quint64, QByteArray> functionNames;
+        QHash<quint64, quint64> frameFunctions;
+        QHash<quint64, QVector<quint64>> callstacks;
+        for (const auto& packet : protoMessages(decodeProto(buffer.data()), 1)) {
+            for (const auto& track : protoMessages(packet, 60)) {
+                for (const auto& descriptor : protoMessages(track, 4)) {
+                    QCOMPARE(protoValues(descriptor, 2), QVector<quint64> {1});
+                    // the thread name comes after the pid and tid
+                    trackNames.append(QString::fromUtf8(descriptor.constLast().bytes));
+                }
+                for (const auto& process : protoMessages(track, 3)) {
+                    QCOMPARE(protoValues(process, 1), QVector<quint64> {1});
+                }
+            }
+            if (!protoMessages(packet, 11).isEmpty()) {
+                sliceTimes.append(protoValues(packet, 8).value(0));
+            }
+            for (const auto& internedData : protoMessages(packet, 12)) {
+                for (const auto& name : protoMessages(internedData, 5)) {
+                    functionNames.insert(protoValues(name, 1).value(0), name.value(1).bytes);
+                }
+                for (const auto& frame : protoMessages(internedData, 6)) {
+                    frameFunctions.insert(protoValues(frame, 1).value(0), protoValues(frame, 2).value(0));
+                }
+                for (const auto& callstack : protoMessages(internedData, 7)) {
+                    const auto iid = protoValues(callstack, 1).value(0);
+                    // every stack gets interned once per sequence
+                    QVERIFY(!callstacks.contains(iid));
+                    callstacks.insert(iid, protoValues(callstack, 2));
+                }
+            }
+            for (const auto& sample : protoMessages(packet, 66)) {
+                sampleSequences.append(protoValues(packet, 10).value(0));
+                sampleStacks.append(protoValues(sample, 4).value(0));
+                QCOMPARE(protoValues(sample, 3), QVector<quint64> {1});
+            }
+        }
+
+        QCOMPARE(trackNames, QVector<QString> {app});
+        // the off-CPU time and the window of lost events
+        QCOMPARE(sliceTimes, (QVector<quint64> {2500, 3000, 0, Data::EventResults::LostEventsWindow - 1}));
+        QCOMPARE(sampleStacks, (QVector<quint64> {1, 1, 2}));
+        QCOMPARE(sampleSequences.size(), 3);
+        QVERIFY(sampleSequences.constFirst() != 1);
+        QCOMPARE(sampleSequences.count(sampleSequences.constFirst()), 3);
+
+        QCOMPARE(callstacks.size(), 2);
+        auto stackNames = [&](quint64 iid) {
+            QByteArrayList names;
+            for (auto frame : callstacks.value(iid)) {
+                names.append(functionNames.value(frameFunctions.value(frame)));
+            }
+            return names.join(';');
+        };
+        // from the outermost frame on
+        QCOMPARE(stackNames(1), QByteArray("main;run;foo"));
+        QCOMPARE(stackNames(2), QByteArray("main;run"));
+    }
+
+    void testPprofExport()
+    {
+        const auto app = QStringLiteral("app");
+        Data::BottomUpResults bottomUp;
+        bottomUp.costs.addType(0, QStringLiteral("cycles"), Data::Costs::Unit::Unknown);
+        bottomUp.costs.addType(1, QStringLiteral("off-CPU Time"), Data::Costs::Unit::Time);
+        quint64 address = 0x1000;
+        for (const auto& name : {QStringLiteral("main"), QStringLiteral("run"), QStringLiteral("foo")}) {
+            bottomUp.locations.push_back({-1, Data::Location(address, address, {})});
+            bottomUp.symbols.push_back({name, address, 0x100, app, QStringLiteral("/usr/bin/app")});
+            address += 0x100;
+        }
+
+        Data::EventResults events;
+        // main;run;foo and main;run
+        events.stacks = {{2, 1, 0}, {1, 0}};
+        Data::ThreadEvents mainThread;
+        mainThread.pid = 1;
+        mainThread.tid = 1;
+        mainThread.name = app;
+        mainThread.events.push_back({1000, 10, 0, 0, 0});
+        mainThread.events.push_back({2000, 20, 0, 0, 1});
+        mainThread.events.push_back({2500, 500, 1, 1, 1});
+        Data::ThreadEvents worker;
+        worker.pid = 1;
+        worker.tid = 2;
+        worker.name = QStringLiteral("worker");
+        worker.events.push_back({3000, 5, 0, 0, 0});
+        events.threads = {mainThread, worker};
+
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(PprofExport::write(&buffer, bottomUp, events, PprofExport::Labels::Thread));
+        QVERIFY(PprofExport::isProfileFile(QStringLiteral("cpu.pb.gz")));
+        QVERIFY(!PprofExport::isProfileFile(QStringLiteral("cpu.perfparser")));
+
+        const auto profile = decodeProto(buffer.data());
+        QStringList strings;
+        for (const auto& field : profile) {
+            if (field.number == 6) {
+                strings.append(QString::fromUtf8(field.bytes));
+            }
+        }
+        QCOMPARE(strings.value(0), QString());
+
+        QStringList sampleTypes;
+        for (const auto& type : protoMessages(profile, 1)) {
+            sampleTypes.append(strings.value(protoValues(type, 1).value(0)) + QLatin1Char('/')
+                               + strings.value(protoValues(type, 2).value(0)));
+        }
+        QCOMPARE(sampleTypes,
+                 (QStringList {QStringLiteral("cycles/count"), QStringLiteral("off-CPU Time/nanoseconds")}));
+
+        QHash<quint64, QString> functionNames;
+        for (const auto& function : protoMessages(profile, 5)) {
+            functionNames.insert(protoValues(function, 1).value(0), strings.value(protoValues(function, 2).value(0)));
+        }
+        QHash<quint64, quint64> locationFunctions;
+        for (const auto& location : protoMessages(profile, 4)) {
+            const auto line = protoMessages(location, 4).value(0);
+            locationFunctions.insert(protoValues(location, 1).value(0), protoValues(line, 1).value(0));
+        }
+
+        // the events are summed up per stack and thread
+        QStringList samples;
+        for (const auto& sample : protoMessages(profile, 2)) {
+            QStringList frames;
+            for (auto location : protoValues(sample, 1)) {
+                frames.append(functionNames.value(locationFunctions.value(location)));
+            }
+            QStringList labels;
+            for (const auto& label : protoMessages(sample, 3)) {
+                const auto str = protoValues(label, 2);
+                labels.append(strings.value(protoValues(label, 1).value(0)) + QLatin1Char('=')
+                              + (str.isEmpty() ? QString::number(protoValues(label, 3).value(0))
+                                               : strings.value(str.constFirst())));
+            }
+            QStringList values;
+            for (auto value : protoValues(sample, 2)) {
+                values.append(QString::number(value));
+            }
+            samples.append(frames.join(QLatin1Char(';')) + QLatin1Char(' ') + values.join(QLatin1Char(','))
+                           + QLatin1Char(' ') + labels.join(QLatin1Char(',')));
+        }
+        // from the leaf on, like the stacks
+        QCOMPARE(samples,
+                 (QStringList {QStringLiteral("foo;run;main 30,0 thread=app,tid=1,pid=1"),
+                               QStringLiteral("run;main 0,500 thread=app,tid=1,pid=1"),
+                               QStringLiteral("foo;run;main 5,0 thread=worker,tid=2,pid=1")}));
+    }
+
+    void testPgoExport()
+    {
+        Data::CallerCalleeResults results;
+        results.selfCosts.addType(0, QStringLiteral("cycles"), Data::Costs::Unit::Unknown);
+        auto addSamples = [&results](const Data::Symbol& symbol, quint64 addr, qint64 cost) {
+            results.entry(symbol).offset(addr, 1).selfCost[0] += cost;
+        };
+        // the inlined function shares the address space of the function it got inlined into
+        addSamples({QStringLiteral("main"), 0x1000, 0x100, QStringLiteral("app")}, 0x1010, 3);
+        addSamples({QStringLiteral("inlined"), 0x1000, 0x100, QStringLiteral("app"), {}, {}, false, true}, 0x1040, 2);
+        addSamples({QStringLiteral("work"), 0x500, 0x10, QStringLiteral("libwork.so")}, 0x508, 5);
+        addSamples({QStringLiteral("schedule"), 0x100, 0x10, QStringLiteral("[kernel.kallsyms]"), {}, {}, true}, 0x104,
+                   7);
+
+        const auto samples = PgoExport::samplesPerBinary(results, 0);
+        QCOMPARE(samples.size(), 2);
+        QCOMPARE(samples.value(QStringLiteral("app")), PgoExport::Samples({{0x1010, 3}, {0x1040, 2}}));
+
+        auto write = [&samples](PgoExport::Format format) {
+            QString text;
+            QTextStream stream(&text);
+            PgoExport::write(&stream, format, samples.value(QStringLiteral("app")), QStringLiteral("cycles"));
+            stream.flush();
+            return text;
+        };
+        QCOMPARE(write(PgoExport::Format::AutoFdo), QStringLiteral("2\n1010-1010:3\n1040-1040:2\n0\n"));
+        QCOMPARE(write(PgoExport::Format::Bolt), QStringLiteral("E cycles\nS 1010 3\nS 1040 2\n"));
+        QCOMPARE(PgoExport::fileName(PgoExport::Format::Bolt, QStringLiteral("libwork.so")),
+                 QStringLiteral("libwork.so.preagg.txt"));
+    }
+
+    void testTreeExport()
+    {
+        const auto topDown = Data::TopDownResults::fromBottomUp(generateTree1(), false);
+
+        QString tsv;
+        QTextStream stream(&tsv);
+        QVERIFY(TreeExport::write(&stream, TreeExport::Format::Tsv, topDown));
+        stream.flush();
+        const auto lines = tsv.split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+        // one row per node of the top down tree
+        QCOMPARE(lines.size(), 10);
+        QCOMPARE(lines.at(0), QStringLiteral("depth\tsymbol\tbinary\tsamples (incl.)\tsamples (self)"));
+        // the children follow their parents
+        const auto a = lines.indexOf(QStringLiteral("0\tA\t\t7\t0"));
+        QVERIFY(a > 0);
+        QCOMPARE(lines.at(a + 1), QStringLiteral("1\tB\t\t7\t0"));
+        QVERIFY(lines.contains(QStringLiteral("2\tD\t\t2\t2")));
+        QVERIFY(lines.contains(QStringLiteral("0\tC\t\t2\t2")));
+
+        QString csv;
+        QTextStream csvStream(&csv);
+        QCOMPARE(TreeExport::formatForFileName(QStringLiteral("tree.CSV")), TreeExport::Format::Csv);
+        QVERIFY(TreeExport::write(&csvStream, TreeExport::Format::Csv, generateTree1()));
+        csvStream.flush();
+        QVERIFY(csv.startsWith(QLatin1String("depth,symbol,binary,samples (incl.)\n")));
+        QVERIFY(csv.contains(QLatin1String("\n0,C,,5\n")));
+
+        qint64 reportedRows = 0;
+        QString cancelled;
+        QTextStream cancelledStream(&cancelled);
+        QVERIFY(!TreeExport::write(&cancelledStream, TreeExport::Format::Tsv, topDown,
+                                   [&reportedRows](qint64 writtenRows, qint64 totalRows) {
+                                       reportedRows = writtenRows;
+                                       return writtenRows < totalRows;
+                                   }));
+        QCOMPARE(reportedRows, qint64(9));
+    }
+
+    void testTimeLineMipmap()
+    {
+        Data::Events events;
+        const auto time = Data::TimeRange {1000, 1000 + 100000};
+        for (quint64 t = time.start; t < time.end; t += 10) {
+            Data::Event event;
+            event.time = t;
+            event.cost = 1;
+            event.type = (t % 1000 == 0) ? 1 : 0;
+            events.push_back(event);
+        }
+
+        const auto mipmaps = TimeLineMipmap::build(events, 3, time);
+        QCOMPARE(mipmaps.size(), 3);
+        QVERIFY(mipmaps[2].isEmpty());
+
+        for (int type = 0; type < 2; ++type) {
+            const auto& mipmap = mipmaps[type];
+            QVERIFY(!mipmap.isEmpty());
+            QCOMPARE(mipmap.start(), time.start);
+            QVERIFY(mipmap.bins(0).size() <= TimeLineMipmap::MaxBins);
+
+            const qint64 numEvents = std::count(events.types().begin(), events.types().end(), type);
+            for (int level = 0;; ++level) {
+                const auto& bins = mipmap.bins(level);
+                quint64 cost = 0;
+                qint64 count = 0;
+                for (const auto& bin : bins) {
+                    cost += bin.cost;
+                    count += bin.count;
+                }
+                QCOMPARE(count, numEvents);
+                QCOMPARE(cost, quint64(numEvents));
+                if (bins.size() == 1) {
+                    break;
+                }
+                QCOMPARE(mipmap.binWidth(level + 1), 2 * mipmap.binWidth(level));
+            }
+        }
+
+        const auto& mipmap = mipmaps[0];
+        QCOMPARE(mipmap.levelForBinWidth(mipmap.binWidth(0) / 2.), -1);
+        QCOMPARE(mipmap.levelForBinWidth(mipmap.binWidth(0)), 0);
+        QCOMPARE(mipmap.levelForBinWidth(mipmap.binWidth(2) * 1.5), 2);
+
+        // too few events to be worth it
+        QVERIFY(TimeLineMipmap::build(Data::Events(), 1, time).first().isEmpty());
+
+        // merging the mipmaps of a row with the events of another one sums up the bins
+        TimeLineMipmap::Merger merger(3, time);
+        merger.add(mipmaps);
+        merger.add(events);
+        const auto merged = merger.result();
+        QCOMPARE(merged.size(), 3);
+        QVERIFY(merged[2].isEmpty());
+        for (int type = 0; type < 2; ++type) {
+            const auto& bins = merged[type].bins(0);
+            const auto& expected = mipmaps[type].bins(0);
+            QCOMPARE(bins.size(), expected.size());
+            for (int i = 0; i < bins.size(); ++i) {
+                QCOMPARE(bins[i].count, 2 * expected[i].count);
+                QCOMPARE(bins[i].cost, 2 * expected[i].cost);
+            }
+        }
+    }
+
+    void testTimeLineSearchIndex()
+    {
+        // samples of type 0 every 10ns, interleaved with off-CPU spans of type 1 that partly overlap
+        Data::Events events;
+        for (quint64 t = 0; t < 1000; t += 10) {
+            events.push_back({t, 1, 0, 0, 0});
+            if (t % 100 == 0) {
+                events.push_back({t, t == 200 ? 250u : 50u, 1, 0, 0});
+            }
+        }
+
+        const auto searchIndex = TimeLineSearchIndex::build(events, 3, 1);
+        QCOMPARE(searchIndex.events(0).size(), 100);
+        QCOMPARE(searchIndex.events(1).size(), 10);
+        QVERIFY(searchIndex.events(2).isEmpty());
+
+        auto samplesAt = [&](int type, quint64 time, bool contains) {
+            QVector<quint64> times;
+            auto collect = [&times](const Data::Event& event) { times.push_back(event.time); };
+            // map every 5ns to one pixel
+            auto map = [](quint64 time) { return static_cast<int>(time / 5); };
+            if (contains) {
+                searchIndex.forEachSpanAt(events, type, map(time), map, collect);
+            } else {
+                searchIndex.forEachEventAt(events, type, map(time), map, collect);
+            }
+            return times;
+        };
+
+        QCOMPARE(samplesAt(0, 120, false), QVector<quint64>({120}));
+        QCOMPARE(samplesAt(0, 125, false), QVector<quint64>());
+        QCOMPARE(samplesAt(1, 100, false), QVector<quint64>({100}));
+        QCOMPARE(samplesAt(1, 125, true), QVector<quint64>({100}));
+        QCOMPARE(samplesAt(1, 175, true), QVector<quint64>());
+        // the long span overlaps the following ones
+        QCOMPARE(samplesAt(1, 420, true), QVector<quint64>({200, 400}));
+        QCOMPARE(samplesAt(1, 470, true), QVector<quint64>());
+        QCOMPARE(samplesAt(2, 100, false), QVector<quint64>());
+        QCOMPARE(samplesAt(-1, 100, true), QVector<quint64>());
+    }
+
+    void testStackHistogram()
+    {
+        Data::BottomUpResults bottomUp;
+        const auto a = Data::Symbol {QStringLiteral("a"), 1, 0, QStringLiteral("libA.so")};
+        const auto b = Data::Symbol {QStringLiteral("b"), 2, 0, QStringLiteral("libA.so")};
+        const auto c = Data::Symbol {QStringLiteral("c"), 3, 0, QStringLiteral("libB.so")};
+        for (const auto& symbol : {a, b, c}) {
+            bottomUp.locations.push_back({});
+            bottomUp.symbols.push_back(symbol);
+        }
+
+        // a is hot in the first half, b in the second half, c only has events of another type
+        Data::EventResults events;
+        events.stacks = {{0}, {1, 0}, {2, 1}};
+        Data::ThreadEvents thread;
+        for (quint64 t = 0; t < 100; ++t) {
+            thread.events.push_back({t, t < 50 ? 1u : 2u, 0, t < 50 ? 0 : 1, 0});
+            if (t % 10 == 0) {
+                thread.events.push_back({t, 1, 1, 2, 0});
+            }
+        }
+        events.threads.push_back(thread);
+
+        const StackHistogram bySymbol(events, bottomUp, StackHistogram::Grouping::Symbols);
+        auto buckets = bySymbol.buckets(0, {0, 99}, 2, 1);
+        QCOMPARE(buckets.labels, QStringList({QStringLiteral("b"), QStringLiteral("others")}));
+        QCOMPARE(buckets.costs, QVector<quint64>({0, 50, 100, 0}));
+        QCOMPARE(buckets.maxBucketCost, quint64(100));
+        QCOMPARE(buckets.bucketTime(0), Data::TimeRange(0, 49));
+        QCOMPARE(buckets.bucketTime(1), Data::TimeRange(50, 99));
+
+        // only the visible time range counts, for the buckets and for the top entries
+        buckets = bySymbol.buckets(0, {50, 99}, 1, 2);
+        QCOMPARE(buckets.labels, QStringList({QStringLiteral("b"), QStringLiteral("others")}));
+        QCOMPARE(buckets.costs, QVector<quint64>({100, 0}));
+
+        buckets = bySymbol.buckets(1, {0, 99}, 1, 2);
+        QCOMPARE(buckets.labels, QStringList({QStringLiteral("c"), QStringLiteral("others")}));
+        QCOMPARE(buckets.costs, QVector<quint64>({10, 0}));
+
+        const StackHistogram byBinary(events, bottomUp, StackHistogram::Grouping::Binaries);
+        buckets = byBinary.buckets(0, {0, 99}, 4, 2);
+        QCOMPARE(buckets.labels, QStringList({QStringLiteral("libA.so"), QStringLiteral("others")}));
+        QCOMPARE(buckets.costs, QVector<quint64>({25, 0, 25, 0, 50, 0, 50, 0}));
+
+        QVERIFY(bySymbol.buckets(2, {0, 99}, 2, 2).isEmpty());
+    }
+
+    void testPerfMapIndex()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const auto mapPath = dir.filePath(QStringLiteral("perf-1234.map"));
+        const auto cacheDir = dir.filePath(QStringLiteral("cache"));
+        auto write = [&mapPath](const QByteArray& data, QIODevice::OpenMode mode) {
+            QFile file(mapPath);
+            QVERIFY(file.open(mode));
+            file.write(data);
+        };
+
+        write("7f0000001000 100 Interpreter\n"
+              "0x7f0000000100 20 LazyCompile:~foo bar.js:1\n"
+              "garbage\n"
+              "7f0000002000 10 partial",
+              QIODevice::WriteOnly);
+        auto index = PerfMapIndex::load(mapPath, cacheDir);
+        QVERIFY(index);
+        QCOMPARE(index->entries().size(), 2);
+        QVERIFY(!index->find(0x7f00000000ff));
+        QCOMPARE(index->name(*index->find(0x7f0000000100)), QStringLiteral("LazyCompile:~foo bar.js:1"));
+        QCOMPARE(index->name(*index->find(0x7f00000010ff)), QStringLiteral("Interpreter"));
+        QVERIFY(!index->find(0x7f0000001100));
+        QVERIFY(!index->find(0x7f0000002000));
+        QVERIFY(!QDir(cacheDir).isEmpty());
+
+        // the JIT completes the line and reuses the memory of the interpreter, only that gets parsed now
+        const auto parsedSize = index->parsedSize();
+        write(" function\n7f0000001000 80 Recompiled\n", QIODevice::Append);
+        auto grown = PerfMapIndex::load(mapPath, cacheDir);
+        QVERIFY(grown != index);
+        QVERIFY(grown->parsedSize() > parsedSize);
+        QCOMPARE(grown->entries().size(), 3);
+        QCOMPARE(grown->name(*grown->find(0x7f0000002000)), QStringLiteral("partial function"));
+        QCOMPARE(grown->name(*grown->find(0x7f0000001000)), QStringLiteral("Recompiled"));
+        QCOMPARE(grown->name(*grown->find(0x7f0000000100)), QStringLiteral("LazyCompile:~foo bar.js:1"));
+        // nothing changed, so it is shared
+        QCOMPARE(PerfMapIndex::load(mapPath, cacheDir), grown);
+
+        // a new process with the same pid rewrites the map
+        write("1000 10 other\n", QIODevice::WriteOnly | QIODevice::Truncate);
+        auto rewritten = PerfMapIndex::load(mapPath, cacheDir);
+        QCOMPARE(rewritten->entries().size(), 1);
+        QVERIFY(!rewritten->find(0x7f0000001000));
+        QCOMPARE(rewritten->name(*rewritten->find(0x1005)), QStringLiteral("other"));
+
+        QVERIFY(!PerfMapIndex::load(dir.filePath(QStringLiteral("perf-1.map")), cacheDir));
+    }
+
+    void testStackPruning()
+    {
+        auto definePruning = [](StackPruning* pruning) {
+            pruning->addSymbol(0, QStringLiteral("leaf"), QStringLiteral("app"));
+            pruning->addSymbol(1, QStringLiteral("recurse"), QStringLiteral("app"));
+            pruning->addSymbol(2, QStringLiteral("recurse"), QStringLiteral("app"));
+            pruning->addSymbol(3, QStringLiteral("main"), QStringLiteral("app"));
+            pruning->addSymbol(4, QStringLiteral("__libc_start_main"), QStringLiteral("libc.so.6"));
+            pruning->addSymbol(5, QStringLiteral("_start"), QStringLiteral("app"));
+            pruning->addSymbol(6, QStringLiteral("entry_SYSCALL_64"), QStringLiteral("[kernel.kallsyms]"));
+        };
+        // the frames start at the leaf, 7 has no symbol
+        const QVector<qint32> frames = {6, 0, 1, 2, 1, 3, 4, 7, 5};
+
+        StackPruning disabled;
+        QVERIFY(!disabled.isEnabled());
+
+        StackPruning drop({QStringLiteral("entry_SYSCALL*"), QStringLiteral("libc.so*"), QStringLiteral("_start")}, 0,
+                          false);
+        QVERIFY(drop.isEnabled());
+        definePruning(&drop);
+        QCOMPARE(drop.prune(frames), QVector<qint32>({0, 1, 2, 1, 3, 7}));
+
+        StackPruning collapse({}, 0, true);
+        definePruning(&collapse);
+        QCOMPARE(collapse.prune(frames), QVector<qint32>({6, 0, 1, 3, 4, 7, 5}));
+        // frames without a symbol never get collapsed
+        QCOMPARE(collapse.prune({7, 7, 8, 8}), QVector<qint32>({7, 7, 8, 8}));
+
+        StackPruning truncate({}, 3, false);
+        definePruning(&truncate);
+        QCOMPARE(truncate.prune(frames), QVector<qint32>({6, 0, 1}));
+
+        StackPruning all({QStringLiteral("entry_SYSCALL*")}, 2, true);
+        definePruning(&all);
+        QCOMPARE(all.prune(frames), QVector<qint32>({0, 1}));
+    }
+
+    void testFlameChartData()
+    {
+        Data::BottomUpResults bottomUp;
+        const auto a = Data::Symbol {QStringLiteral("a"), 1, 0, QStringLiteral("libA.so")};
+        const auto b = Data::Symbol {QStringLiteral("b"), 2, 0, QStringLiteral("libA.so")};
+        const auto c = Data::Symbol {QStringLiteral("c"), 3, 0, QStringLiteral("libB.so")};
+        for (const auto& symbol : {a, b, c}) {
+            bottomUp.locations.push_back({});
+            bottomUp.symbols.push_back(symbol);
+        }
+        const QVector<QVector<qint32>> stacks = {{0}, {1, 0}, {2}};
+
+        // a calls b, then a runs on its own, then the thread sleeps before it runs c
+        Data::Events events;
+        for (quint64 t = 0; t < 10; ++t) {
+            events.push_back({t, 1, 0, t < 5 ? 1 : 0, 0});
+        }
+        events.push_back({15, 1, 1, 2, 0});
+        events.push_back({20, 1, 0, 2, 0});
+        events.push_back({21, 1, 0, 2, 0});
+
+        const auto data = FlameChartData::build(events, 0, stacks, bottomUp);
+        QCOMPARE(data.period(), quint64(1));
+        QCOMPARE(data.depth(), 2);
+        QCOMPARE(data.time(), Data::TimeRange(0, 22));
+
+        auto symbolsAt = [&](int level, int depth, Data::TimeRange time) {
+            QStringList ret;
+            data.forEachSpan(level, depth, time, [&](const FlameChartData::Span& span) {
+                ret.push_back(data.symbol(span.symbolId).symbol + QLatin1Char(':') + QString::number(span.start)
+                              + QLatin1Char('-') + QString::number(span.end) + QLatin1Char('/')
+                              + QString::number(span.numSamples));
+            });
+            return ret;
+        };
+        // consecutive samples get merged, the gap ends the span of a
+        QCOMPARE(symbolsAt(0, 0, {0, 22}), QStringList({QStringLiteral("a:0-11/10"), QStringLiteral("c:20-22/2")}));
+        QCOMPARE(symbolsAt(0, 1, {0, 22}), QStringList({QStringLiteral("b:0-5/5")}));
+        QCOMPARE(symbolsAt(0, 0, {12, 19}), QStringList());
+        QCOMPARE(symbolsAt(0, 0, {11, 20}), QStringList({QStringLiteral("c:20-22/2")}));
+
+        // the coarser levels drop the short spans
+        QCOMPARE(data.numLevels(), 3);
+        QCOMPARE(symbolsAt(1, 0, {0, 22}), QStringList({QStringLiteral("a:0-11/10")}));
+        QCOMPARE(symbolsAt(1, 1, {0, 22}), QStringList({QStringLiteral("b:0-5/5")}));
+        QCOMPARE(symbolsAt(2, 0, {0, 22}), QStringList());
+        QCOMPARE(data.levelForResolution(1), 0);
+        QCOMPARE(data.levelForResolution(5), 1);
+        QCOMPARE(data.levelForResolution(1000), 2);
+
+        QVERIFY(FlameChartData::build(events, 2, stacks, bottomUp).isEmpty());
+    }
+
+    void testFilterRefinement()
+    {
+        const Data::FilterAction unfiltered;
+        QVERIFY(unfiltered.isRefinementOf(unfiltered));
+
+        Data::FilterAction byTime;
+        byTime.time = {100, 200};
+        QVERIFY(byTime.isRefinementOf(unfiltered));
+        QVERIFY(!unfiltered.isRefinementOf(byTime));
+
+        auto narrowerTime = byTime;
+        narrowerTime.time = {150, 200};
+        QVERIFY(narrowerTime.isRefinementOf(byTime));
+        QVERIFY(!byTime.isRefinementOf(narrowerTime));
+
+        auto otherTime = byTime;
+        otherTime.time = {150, 250};
+        QVERIFY(!otherTime.isRefinementOf(byTime));
+
+        auto excludeSymbol = byTime;
+        excludeSymbol.excludeSymbols.insert(Data::Symbol {QStringLiteral("foo"), {}});
+        QVERIFY(excludeSymbol.isRefinementOf(byTime));
+        QVERIFY(!byTime.isRefinementOf(excludeSymbol));
+        QVERIFY(excludeSymbol != byTime);
+
+        auto sameExcludes = byTime;
+        sameExcludes.excludeSymbols.insert(Data::Symbol {QStringLiteral("bar"), {}});
+        sameExcludes.excludeSymbols.insert(Data::Symbol {QStringLiteral("foo"), {}});
+        excludeSymbol.excludeSymbols.insert(Data::Symbol {QStringLiteral("bar"), {}});
+        QCOMPARE(sameExcludes, excludeSymbol);
+        QCOMPARE(qHash(sameExcludes), qHash(excludeSymbol));
+
+        auto byProcess = unfiltered;
+        byProcess.processId = 42;
+        QVERIFY(byProcess.isRefinementOf(unfiltered));
+        auto otherProcess = unfiltered;
+        otherProcess.processId = 43;
+        QVERIFY(!otherProcess.isRefinementOf(byProcess));
+    }
+
+    void testParseRestriction()
+    {
+        const auto empty = Data::ParseRestriction::fromString(QStringLiteral("  "));
+        QVERIFY(empty);
+        QVERIFY(empty->isEmpty());
+        QVERIFY(empty->acceptsCpu(7));
+
+        const auto restriction =
+            Data::ParseRestriction::fromString(QStringLiteral("time=1.5-2 pid=1234,firefox cpu=0-2,8"));
+        QVERIFY(restriction);
+        QVERIFY(!restriction->isEmpty());
+        QCOMPARE(restriction->time, Data::TimeRange(1500000000, 2000000000));
+        QCOMPARE(restriction->pids, QSet<qint32>({1234}));
+        QCOMPARE(restriction->commands, QSet<QString>({QStringLiteral("firefox")}));
+        QCOMPARE(restriction->cpus, QSet<quint32>({0, 1, 2, 8}));
+        QVERIFY(restriction->restrictsProcesses());
+        QVERIFY(restriction->acceptsCpu(8));
+        QVERIFY(!restriction->acceptsCpu(3));
+
+        const auto openEnd = Data::ParseRestriction::fromString(QStringLiteral("time=10-"));
+        QVERIFY(openEnd);
+        QCOMPARE(openEnd->time.start, quint64(10000000000));
+        QCOMPARE(openEnd->time.end, std::numeric_limits<quint64>::max());
+        QVERIFY(!openEnd->restrictsProcesses());
+
+        const auto openStart = Data::ParseRestriction::fromString(QStringLiteral("time=-1"));
+        QVERIFY(openStart);
+        QCOMPARE(openStart->time, Data::TimeRange(0, 1000000000));
+
+        for (const auto& invalid : {"time", "time=", "time=2-1", "time=1", "time=a-b", "cpu=3-1", "cpu=-1",
+                                    "cpu=0-100000", "foo=1"}) {
+            QVERIFY2(!Data::ParseRestriction::fromString(QString::fromLatin1(invalid)), invalid);
+        }
+    }
+
+    void testJobScheduler()
+    {
+        ThreadWeaver::Queue queue;
+        queue.setMaximumNumberOfThreads(1);
+        queue.suspend();
+
+        // the queue only has one thread, so the jobs run one after the other
+        QVector<JobScheduler::Priority> order;
+        for (auto priority : {JobScheduler::Priority::Background, JobScheduler::Priority::Normal,
+                              JobScheduler::Priority::Interactive, JobScheduler::Priority::Normal}) {
+            queue.stream() << JobScheduler::makeJob(priority, [&order, priority]() { order.push_back(priority); });
+        }
+        queue.resume();
+        queue.finish();
+
+        const QVector<JobScheduler::Priority> expected = {
+            JobScheduler::Priority::Interactive, JobScheduler::Priority::Normal, JobScheduler::Priority::Normal,
+            JobScheduler::Priority::Background};
+        QCOMPARE(order, expected);
+
+        QVERIFY(JobScheduler::queue(JobScheduler::Priority::Interactive) != ThreadWeaver::Queue::instance());
+        QCOMPARE(JobScheduler::queue(JobScheduler::Priority::Background), ThreadWeaver::Queue::instance());
+    }
+
+    void testFilterHint()
+    {
+        FilterAndZoomStack stack;
+        QVector<Data::FilterAction> hinted;
+        connect(&stack, &FilterAndZoomStack::filterHinted, this,
+                [&hinted](const Data::FilterAction& filter) { hinted.push_back(filter); });
+        int numChanged = 0;
+        connect(&stack, &FilterAndZoomStack::filterChanged, this, [&numChanged]() { ++numChanged; });
+
+        stack.filterInByTime({100, 200});
+        QCOMPARE(numChanged, 1);
+
+        Data::FilterAction byThread;
+        byThread.threadId = 42;
+        stack.hintFilter(byThread);
+        QCOMPARE(hinted.size(), 1);
+        // hinting doesn't change the filter
+        QCOMPARE(numChanged, 1);
+        QCOMPARE(stack.filter().threadId, Data::INVALID_TID);
+
+        // the hinted filter is the one that applying the hint results in
+        stack.filterInByThread(42);
+        QCOMPARE(numChanged, 2);
+        QCOMPARE(hinted.constFirst(), stack.filter());
+        QCOMPARE(hinted.constFirst().time, Data::TimeRange(100, 200));
+    }
+
+    void testTimeColumn()
+    {
+        Data::TimeColumn column;
+        QVector<quint64> expected;
+        quint64 time = 1000000000000;
+        for (int i = 0; i < 3 * Data::TimeColumn::BlockSize; ++i) {
+            time += 1000;
+            if (i % 100 == 0) {
+                // large gap that doesn't fit into the delta
+                time += std::numeric_limits<quint32>::max();
+            }
+            // times going backwards are allowed too
+            const auto value = (i % 77 == 0) ? time - 5000 : time;
+            column.push_back(value);
+            expected.push_back(value);
+        }
+
+        QCOMPARE(column.size(), expected.size());
+        QCOMPARE(column.blockCount(), 3);
+        QCOMPARE(column.blockAnchor(1), expected.at(Data::TimeColumn::BlockSize));
+        for (int i = 0; i < expected.size(); ++i) {
+            QCOMPARE(column.at(i), expected.at(i));
+        }
+
+        Data::Events events;
+        for (const auto value : expected) {
+            Data::Event event;
+            event.time = value;
+            events.push_back(event);
+        }
+        events.removeIf([](const Data::Event& event) { return event.time % 2000 == 0; });
+        QVector<quint64> remaining;
+        std::copy_if(expected.begin(), expected.end(), std::back_inserter(remaining),
+                     [](quint64 value) { return value % 2000 != 0; });
+        QCOMPARE(events.size(), remaining.size());
+        for (int i = 0; i < remaining.size(); ++i) {
+            QCOMPARE(events.at(i).time, remaining.at(i));
+        }
+    }
+
+    void testEventsTimeRange()
+    {
+        Data::Events events;
+        QVector<quint64> times;
+        for (quint64 time = 0; time < 10000; time += 10) {
+            Data::Event event;
+            event.time = time;
+            events.push_back(event);
+            times.push_back(time);
+        }
+
+        const auto probes = QVector<quint64> {0, 5, 2560, 2565, 9990, 20000};
+        for (const auto time : probes) {
+            const qsizetype expected =
+                std::distance(times.begin(), std::lower_bound(times.begin(), times.end(), time));
+            QCOMPARE(events.lowerBound(time), expected);
+            QCOMPARE(events.lowerBound(time, 300), std::max<qsizetype>(expected, 300));
+        }
+
+        const auto range = Data::TimeRange {1234, 5678};
+        auto filtered = events;
+        filtered.retainTimeRange(range);
+        auto expected = events;
+        expected.removeIf([range](const Data::Event& event) { return !range.contains(event.time); });
+        QCOMPARE(filtered, expected);
+        QCOMPARE(filtered.first().time, quint64(1240));
+        QCOMPARE(filtered.last().time, quint64(5670));
+    }
+
+    void testEventRuns()
+    {
+        // a busy loop with a fixed sample period, interrupted by a few other samples
+        Data::Events events;
+        QVector<Data::Event> expected;
+        for (quint64 i = 0; i < 3000; ++i) {
+            const Data::Event event = {i * 10, 1000, 0, i % 1000 == 999 ? 2 : 1, 3};
+            events.push_back(event);
+            expected.push_back(event);
+        }
+        QVERIFY(events.isCoalesced());
+        QCOMPARE(events.size(), qsizetype(3000));
+        QCOMPARE(events.at(999).stackId, 2);
+        QCOMPARE(events.at(2500), expected.at(2500));
+        QVERIFY(std::equal(events.begin(), events.end(), expected.begin()));
+        const auto& stackIds = events.stackIds();
+        QCOMPARE(std::count(stackIds.begin(), stackIds.end(), 2), qsizetype(3));
+        QCOMPARE(*std::find(stackIds.rbegin(), stackIds.rend(), 2), 2);
+
+        QVector<Data::EventRun> runs;
+        events.forEachRun([&runs](const Data::EventRun& run) {
+            runs.push_back(run);
+            return true;
+        });
+        QCOMPARE(runs.size(), 6);
+        QCOMPARE(runs[0].count, 999);
+        QCOMPARE(runs[1].first, qsizetype(999));
+        QCOMPARE(runs[1].count, 1);
+
+        // runs that start before the first event get clipped
+        runs.clear();
+        events.forEachRun(
+            [&runs](const Data::EventRun& run) {
+                runs.push_back(run);
+                return false;
+            },
+            500);
+        QCOMPARE(runs.size(), 1);
+        QCOMPARE(runs[0].first, qsizetype(500));
+        QCOMPARE(runs[0].count, 499);
+
+        auto filtered = events;
+        filtered.removeIf([](const Data::Event& event) { return event.stackId == 2; });
+        QCOMPARE(filtered.size(), qsizetype(2997));
+        QVERIFY(filtered.isCoalesced());
+        QCOMPARE(filtered.maxCost(0), quint64(1000));
+
+        // the events get expanded once the runs don't save memory anymore, which doesn't change their values
+        Data::Events mixed;
+        for (quint64 i = 0; i < 2000; ++i) {
+            mixed.push_back({i * 10, i, 0, static_cast<qint32>(i), 0});
+        }
+        QVERIFY(!mixed.isCoalesced());
+        QCOMPARE(mixed.at(1234).cost, quint64(1234));
+        runs.clear();
+        mixed.forEachRun([&runs](const Data::EventRun& run) {
+            runs.push_back(run);
+            return true;
+        });
+        QCOMPARE(runs.size(), 2000);
+    }
+
+    void testSpilledEvents()
+    {
+        QTemporaryDir spillDir;
+        QVERIFY(spillDir.isValid());
+        Data::setSpillDirectory(spillDir.path());
+        auto resetSpillDir = qScopeGuard([]() { Data::setSpillDirectory({}); });
+
+        Data::Events spilled;
+        for (quint64 i = 0; i < 300000; ++i) {
+            spilled.push_back({i * 10, i, static_cast<qint32>(i % 3), static_cast<qint32>(i), 0});
+        }
+        Data::setSpillDirectory({});
+        Data::Events inMemory;
+        for (quint64 i = 0; i < 300000; ++i) {
+            inMemory.push_back({i * 10, i, static_cast<qint32>(i % 3), static_cast<qint32>(i), 0});
+        }
+        QCOMPARE(spilled, inMemory);
+        // the file got unlinked right away
+        QVERIFY(QDir(spillDir.path()).isEmpty());
+
+        // copies share the columns until they get modified
+        auto copy = spilled;
+        QCOMPARE(copy.costs().constData(), spilled.costs().constData());
+        copy.removeIf([](const Data::Event& event) { return event.type != 0; });
+        QCOMPARE(copy.size(), qsizetype(100000));
+        QCOMPARE(spilled, inMemory);
+    }
+
+    void testScopedSpillDirectory()
+    {
+        QTemporaryDir spillDir;
+        QVERIFY(spillDir.isValid());
+        Data::SpillDirectory directory;
+        directory.setPath(spillDir.path());
+
+        auto fill = [](Data::EventResults* events) {
+            events->threads.resize(1);
+            for (quint64 i = 0; i < 300000; ++i) {
+                events->threads.first().events.push_back({i * 10, i, 0, -1, 0});
+            }
+        };
+
+        // only the columns allocated on this thread while the scope exists get spilled
+        Data::EventResults spilled;
+        {
+            const Data::ScopedSpillDirectory scope(&directory);
+            fill(&spilled);
+        }
+        Data::EventResults inMemory;
+        fill(&inMemory);
+        QVERIFY(Data::spillDirectory().isEmpty());
+        QVERIFY(Data::MemoryUsage::fromEvents(spilled).threadEvents
+                < Data::MemoryUsage::fromEvents(inMemory).threadEvents);
+        QCOMPARE(spilled, inMemory);
+    }
+
+    void testEventsSnapshot()
+    {
+        Data::Events events;
+        for (quint64 i = 0; i < 2000; ++i) {
+            events.push_back({i * 10, i, static_cast<qint32>(i % 3), static_cast<qint32>(i), 0});
+        }
+        QVERIFY(!events.isCoalesced());
+
+        // appending behind the events of a snapshot keeps sharing the columns
+        const auto snapshot = events;
+        events.push_back({20000, 2000, 0, 2000, 0});
+        QCOMPARE(events.costs().constData(), snapshot.costs().constData());
+        QCOMPARE(snapshot.size(), qsizetype(2000));
+        QCOMPARE(events.size(), qsizetype(2001));
+        QCOMPARE(events.at(1999), snapshot.at(1999));
+
+        // but only one of the copies can append in place
+        auto other = snapshot;
+        other.push_back({20000, 42, 0, 2000, 0});
+        QVERIFY(other.costs().constData() != events.costs().constData());
+        QCOMPARE(other.at(2000).cost, quint64(42));
+        QCOMPARE(events.at(2000).cost, quint64(2000));
+        QCOMPARE(snapshot.size(), qsizetype(2000));
+    }
+
+    void testMemoryUsage()
+    {
+        Data::EventResults events;
+        events.threads.resize(1);
+        auto& thread = events.threads.first();
+        for (quint64 i = 0; i < 10000; ++i) {
+            thread.events.push_back({i * 10, i, 0, -1, 0});
+        }
+        const auto inMemory = Data::MemoryUsage::fromEvents(events);
+        QVERIFY(inMemory.threadEvents >= 10000 * qint64(sizeof(quint64) + sizeof(qint32)));
+        QCOMPARE(inMemory.total(), inMemory.threadEvents + inMemory.cpuEvents + inMemory.stacks);
+
+        // the columns move to the spill directory when they grow large enough, then they don't count anymore
+        QTemporaryDir spillDir;
+        QVERIFY(spillDir.isValid());
+        Data::setSpillDirectory(spillDir.path());
+        auto resetSpillDir = qScopeGuard([]() { Data::setSpillDirectory({}); });
+        for (quint64 i = 10000; i < 300000; ++i) {
+            thread.events.push_back({i * 10, i, 0, -1, 0});
+        }
+        const auto spilled = Data::MemoryUsage::fromEvents(events);
+        QVERIFY(spilled.threadEvents < inMemory.threadEvents);
+        QCOMPARE(thread.events.size(), qsizetype(300000));
+        QCOMPARE(thread.events.at(1234).cost, quint64(1234));
+    }
+
+    void testFrequencyPyramid()
+    {
+        QVector<Data::FrequencyData> values;
+        for (int i = 0; i < 100; ++i) {
+            values.push_back({static_cast<quint64>(1000 + i * 10), i == 42 ? 10. : 1. + (i % 2)});
+        }
+
+        Data::FrequencyPyramid pyramid;
+        pyramid.build(values);
+
+        const auto& levels = pyramid.levels();
+        QCOMPARE(levels.size(), 2);
+        QCOMPARE(levels[0].size(), 13);
+        QCOMPARE(levels[1].size(), 2);
+
+        // the outlier is kept by the maximum of its buckets
+        QCOMPARE(levels[0][5].max, 10.);
+        QCOMPARE(levels[0][5].min, 1.);
+        QCOMPARE(levels[1][0].max, 10.);
+        QCOMPARE(levels[0][0].time, 1035.);
+        QCOMPARE(levels[0][0].avg, 1.5);
+
+        const auto average = pyramid.average(2, 6);
+        QCOMPARE(average.time, quint64(1035));
+        QCOMPARE(average.cost, 1.5);
+        QCOMPARE(pyramid.average(42, 43).cost, 10.);
+
+        // the last bucket of the first level only summarizes four values, so it weighs less in the next one
+        QCOMPARE(levels[0][12].duration, 40.);
+        QCOMPARE(levels[1][1].time, 1815.);
+
+        // the finest level that fits, optionally restricted to a time range
+        QCOMPARE(pyramid.level(1000, 1990, 100), 0);
+        QCOMPARE(pyramid.level(1000, 1990, 10), 1);
+        QCOMPARE(pyramid.level(1000, 1990, 1), 1);
+        QCOMPARE(pyramid.level(1000, 1300, 5), 0);
+        const auto buckets = pyramid.buckets(0, 1000, 1300);
+        QCOMPARE(buckets.second - buckets.first, std::ptrdiff_t(4));
+        QCOMPARE(buckets.first, levels[0].constData());
+
+        // a value lasts until the next one, so the one that lasts longest dominates the average
+        values = {{0, 1}, {90, 3}, {100, 3}, {110, 3}, {120, 3}, {130, 3}, {140, 3}, {150, 3}, {160, 3}};
+        pyramid.build(values);
+        QCOMPARE(pyramid.levels().size(), 1);
+        QCOMPARE(pyramid.levels()[0][0].duration, 160.);
+        QCOMPARE(pyramid.levels()[0][0].avg, 1.875);
+        QCOMPARE(pyramid.levels()[0][1].duration, 10.);
     }
-    Data::BottomUp::initializeParents(&ret.root);
-    return ret;
-}
 
-Data::BottomUpResults generateTree1()
-{
-    return buildBottomUpTree(R"(
-        A;B;C
-        A;B;D
-        A;B;D
-        A;B;C;E
-        A;B;C;E;C
-        A;B;C;E;C;E
-        A;B;C;C
-        C
-        C
-    )");
-}
+    void testCostCube()
+    {
+        Data::EventResults events;
+        events.threads.resize(2);
+        // time, cost, type, stack, cpu
+        events.threads[0].events.push_back({1000, 1, 0, 0, 0});
+        events.threads[0].events.push_back({1010, 2, 0, 0, 0});
+        events.threads[0].events.push_back({1020, 4, 1, 0, 0});
+        events.threads[0].events.push_back({2010, 8, 0, 1, 1});
+        events.threads[1].events.push_back({1030, 16, 0, 0, 1});
+        events.threads[1].events.push_back({3000, 32, 0, 1, 1});
+
+        using CellTuple = std::tuple<qint32, quint32, qint32, quint64>;
+        auto cellTuples = [](const QVector<Data::CostCube::Cell>& cells) {
+            QVector<CellTuple> tuples;
+            for (const auto& cell : cells) {
+                tuples.push_back({cell.stackId, cell.cpuId, cell.type, cell.cost});
+            }
+            return tuples;
+        };
 
-Data::BottomUpResults generateTreeByThread()
-{
-    return buildBottomUpTree(R"(
-        A;B;C;T1
-        A;B;D;T1
-        A;B;D;T2
-        A;B;C;E;T1
-        A;B;C;E;C;T1
-        A;B;C;E;C;E;T1
-        A;B;C;C;T1
-        C;T1
-        C;T2
-    )");
-}
-}
+        const Data::CostCube cube(events);
+        QVERIFY(!cube.isEmpty());
+        // stack, cpu, type, cost. the first two events end up in the same cell
+        QCOMPARE(cellTuples(cube.cells(0)), (QVector<CellTuple> {{0, 0, 0, 3}, {0, 0, 1, 4}, {1, 1, 0, 8}}));
+        QCOMPARE(cellTuples(cube.cells(1)), (QVector<CellTuple> {{0, 1, 0, 16}, {1, 1, 0, 32}}));
+
+        // the threads can be built separately, e.g. in parallel
+        const Data::CostCube parallelCube({Data::CostCube::threadCells(events.threads[0]),
+                                           Data::CostCube::threadCells(events.threads[1])});
+        QCOMPARE(cellTuples(parallelCube.cells(0)), cellTuples(cube.cells(0)));
+        QCOMPARE(cellTuples(parallelCube.cells(1)), cellTuples(cube.cells(1)));
+
+        // a cancelled build stops early, which only shows with enough events
+        Data::ThreadEvents bigThread;
+        for (quint64 i = 0; i < 10000; ++i) {
+            bigThread.events.push_back({i, 1, 0, static_cast<qint32>(i), 0});
+        }
+        QCOMPARE(Data::CostCube::threadCells(bigThread).size(), 10000);
+        const std::atomic<bool> cancelled {true};
+        QVERIFY(Data::CostCube::threadCells(bigThread, &cancelled).size() < 10000);
+    }
 
-class TestModels : public QObject
-{
-    Q_OBJECT
-public:
-    using QObject::QObject;
+    void testDurationHistogram()
+    {
+        Data::DurationHistogram histogram;
+        QVERIFY(histogram.isEmpty());
+        QCOMPARE(histogram.percentile(0.5), quint64(0));
+
+        QCOMPARE(Data::DurationHistogram::bucket(0), 0);
+        QCOMPARE(Data::DurationHistogram::bucket(1), 1);
+        QCOMPARE(Data::DurationHistogram::bucket(1000), 10);
+        QCOMPARE(Data::DurationHistogram::bucket(std::numeric_limits<quint64>::max()), 64);
+        QCOMPARE(Data::DurationHistogram::bucketEnd(10), quint64(1023));
+
+        for (quint64 duration : {10, 20, 30, 1000, 5000}) {
+            histogram.add(duration);
+        }
+        QCOMPARE(histogram.count, quint64(5));
+        QCOMPARE(histogram.total, quint64(6060));
+        QCOMPARE(histogram.max, quint64(5000));
+        QCOMPARE(histogram.percentile(0), quint64(15));
+        QCOMPARE(histogram.percentile(0.5), quint64(31));
+        QCOMPARE(histogram.percentile(0.7), quint64(1023));
+        // clamped to the largest duration
+        QCOMPARE(histogram.percentile(1), quint64(5000));
+
+        Data::DurationHistogram other;
+        other.add(20000);
+        histogram.merge(other);
+        QCOMPARE(histogram.count, quint64(6));
+        QCOMPARE(histogram.max, quint64(20000));
+        QCOMPARE(histogram.counts[Data::DurationHistogram::bucket(20000)], 1u);
+    }
 
-private slots:
-    void testTreeParents()
+    void testLostEvents()
     {
-        const auto tree = generateTree1();
+        const auto window = Data::EventResults::LostEventsWindow;
+        Data::EventResults events;
+        events.lostEventCostId = 1;
+        events.addLostEvents(window + 10, 2);
+        events.addLostEvents(window + 20, 2);
+        events.addLostEvents(3 * window, 5);
+        // out of order
+        events.addLostEvents(10, 1);
+
+        QCOMPARE(events.lostEvents.size(), 3);
+        QCOMPARE(events.lostEvents[0].time, Data::TimeRange(0, window - 1));
+        QCOMPARE(events.lostEvents[1].chunks, 2u);
+        QCOMPARE(events.lostEvents[1].lost, quint64(4));
+        QVERIFY(!events.lostEventsAt(2 * window));
+        QVERIFY(events.lostEventsAt(3 * window + 1));
+        QCOMPARE(events.lostEventsAt(3 * window + 1)->lost, quint64(5));
+        using Range = std::pair<qsizetype, qsizetype>;
+        QCOMPARE(events.lostEventsInRange({window + 5, 2 * window}), Range(1, 2));
+        QCOMPARE(events.lostEventsInRange({window * 5, window * 6}), Range(3, 3));
+
+        events.threads.resize(1);
+        // time, cost, type, stack, cpu
+        events.threads[0].events.push_back({window + 1, 10, 0, 0, 0});
+        events.threads[0].events.push_back({window + 15, 1, 1, -1, 0});
+        events.threads[0].events.push_back({window + 30, 10, 0, 0, 0});
+        events.threads[0].events.push_back({2 * window, 10, 0, 0, 0});
+        events.countLostEventSamples();
+        QCOMPARE(events.lostEvents[0].samples, quint64(0));
+        QCOMPARE(events.lostEvents[1].samples, quint64(2));
+        QCOMPARE(events.lostEvents[1].correction(), 3.);
+        // no recorded samples to scale up
+        QCOMPARE(events.lostEvents[2].correction(), 1.);
+
+        QCOMPARE(events.correctedCost(events.threads[0].events.at(0)), quint64(30));
+        QCOMPARE(events.correctedCost(events.threads[0].events.at(1)), quint64(1));
+        QCOMPARE(events.correctedCost(events.threads[0].events.at(3)), quint64(10));
+    }
 
-        QVERIFY(!tree.root.parent);
-        for (const auto& firstLevel : tree.root.children) {
-            QVERIFY(!firstLevel.parent);
-            for (const auto& secondLevel : firstLevel.children) {
-                QCOMPARE(secondLevel.parent, &firstLevel);
+    void testDerivedMetrics()
+    {
+        QVERIFY(Data::DerivedMetrics::matchesEvent(QStringLiteral("cycles"), QStringLiteral("cycles")));
+        QVERIFY(Data::DerivedMetrics::matchesEvent(QStringLiteral("cycles:u"), QStringLiteral("cycles")));
+        QVERIFY(Data::DerivedMetrics::matchesEvent(QStringLiteral("cpu_core/cycles/"), QStringLiteral("cycles")));
+        QVERIFY(!Data::DerivedMetrics::matchesEvent(QStringLiteral("ref-cycles"), QStringLiteral("cycles")));
+
+        Data::Costs costs;
+        costs.addType(0, QStringLiteral("cycles:u"), Data::Costs::Unit::Unknown);
+        costs.addType(1, QStringLiteral("instructions:u"), Data::Costs::Unit::Unknown);
+        costs.add(0, 0, 100);
+        costs.add(1, 0, 250);
+        costs.add(1, 1, 10);
+        costs.addTotalCost(0, 100);
+        costs.addTotalCost(1, 260);
+
+        const auto definitions = QStringList {QStringLiteral("IPC=instructions/cycles"),
+                                              QStringLiteral("Miss Ratio=cache-misses/cache-references"),
+                                              QStringLiteral("invalid")};
+        const Data::DerivedMetrics metrics(definitions, costs);
+        QCOMPARE(metrics.size(), 1);
+        QCOMPARE(metrics.metric(0).label, QStringLiteral("IPC"));
+        QCOMPARE(metrics.metric(0).numerator, 1);
+        QCOMPARE(metrics.metric(0).denominator, 0);
+        QCOMPARE(metrics.value(0, 0), 2.5);
+        QVERIFY(std::isnan(metrics.value(0, 1)));
+        QVERIFY(std::isnan(metrics.value(0, 100)));
+        QCOMPARE(metrics.totalValue(0), 2.6);
+        QCOMPARE(Data::DerivedMetrics::format(metrics.value(0, 0)), QStringLiteral("2.500"));
+        QVERIFY(Data::DerivedMetrics::format(metrics.value(0, 1)).isEmpty());
+    }
+
+    void testTopCosts()
+    {
+        Data::BottomUpResults bottomUp;
+        bottomUp.costs.addType(0, QStringLiteral("cycles"), Data::Costs::Unit::Unknown);
+        bottomUp.costs.addType(1, QStringLiteral("instructions"), Data::Costs::Unit::Unknown);
+        quint32 maxId = 0;
+        // symbol i lives in library i % 3 and costs i cycles, only the first symbols have instructions
+        for (int i = 0; i < 10; ++i) {
+            const auto library = QStringLiteral("lib%1.so").arg(i % 3);
+            const auto symbol = Data::Symbol(QStringLiteral("sym%1").arg(i), 0, 0, library, library);
+            const auto* row = bottomUp.root.entryForSymbol(symbol, &maxId);
+            bottomUp.costs.add(0, row->id, i);
+            bottomUp.costs.add(1, row->id, i < 2 ? 100 : 0);
+        }
+        Data::BottomUp::initializeParents(&bottomUp.root);
+
+        const auto topCosts = Data::TopCosts::fromBottomUp(bottomUp, false);
+
+        // the top five cycles symbols and the two with instructions
+        QStringList symbols;
+        for (const auto& row : topCosts.symbols.root.children) {
+            symbols.append(row.symbol.symbol);
+            QCOMPARE(topCosts.symbols.costs.cost(0, row.id), row.symbol.symbol.mid(3).toLongLong());
+        }
+        symbols.sort();
+        QCOMPARE(symbols,
+                 QStringList({QStringLiteral("sym0"), QStringLiteral("sym1"), QStringLiteral("sym5"),
+                              QStringLiteral("sym6"), QStringLiteral("sym7"), QStringLiteral("sym8"),
+                              QStringLiteral("sym9")}));
+
+        // all libraries make it, with the summed up costs of their symbols
+        const auto& libraries = topCosts.libraries;
+        QCOMPARE(libraries.root.children.size(), 3);
+        for (const auto& library : libraries.root.children) {
+            QVERIFY(library.symbol.symbol.isEmpty());
+            if (library.symbol.binary == QLatin1String("lib0.so")) {
+                QCOMPARE(libraries.costs.cost(0, library.id), qint64(0 + 3 + 6 + 9));
+                QCOMPARE(libraries.costs.cost(1, library.id), qint64(100));
+            } else if (library.symbol.binary == QLatin1String("lib1.so")) {
+                QCOMPARE(libraries.costs.cost(0, library.id), qint64(1 + 4 + 7));
+                QCOMPARE(libraries.costs.cost(1, library.id), qint64(100));
+            } else {
+                QCOMPARE(library.symbol.binary, QStringLiteral("lib2.so"));
+                QCOMPARE(libraries.costs.cost(0, library.id), qint64(2 + 5 + 8));
+                QCOMPARE(libraries.costs.cost(1, library.id), qint64(0));
             }
         }
     }
 
-    void testBottomUpModel()
+    void testTracepointTable()
     {
-        const auto tree = generateTree1();
+        Data::TracepointTable table;
+        table.name = QStringLiteral("block:block_rq_issue");
+        Data::TracepointField sector;
+        sector.name = QStringLiteral("sector");
+        Data::TracepointField device;
+        device.name = QStringLiteral("rwbs");
+        for (quint64 i = 1; i <= 10; ++i) {
+            table.times.push_back(i * 100);
+            sector.append(QVariant::fromValue(i * 8));
+            // the first values look numeric, but the field turns out to be a string
+            device.append(i < 5 ? QVariant::fromValue(i) : QVariant::fromValue(QByteArray("WS\0\0", 4)));
+        }
+        table.fields = {sector, device};
+
+        QVERIFY(table.fields[0].isNumeric);
+        QCOMPARE(table.fields[0].values.size(), qsizetype(10));
+        QVERIFY(!table.fields[1].isNumeric);
+        QCOMPARE(table.fields[1].size(), qsizetype(10));
+        // the four numbers and the repeated text
+        QCOMPARE(table.fields[1].texts.size(), 5);
+        QCOMPARE(table.fields[1].text(0), QStringLiteral("1"));
+        QCOMPARE(table.fields[1].text(9), QStringLiteral("WS"));
+        QCOMPARE(table.format(2), QStringLiteral("sector: 24\nrwbs: 3"));
+
+        using Range = std::pair<qsizetype, qsizetype>;
+        QCOMPARE(table.rowsInRange({250, 500}), Range(2, 5));
+        QCOMPARE(table.rowsInRange({100, 100}), Range(0, 1));
+        QCOMPARE(table.rowsInRange({1001, 2000}), Range(10, 10));
+
+        Data::TracepointResults results;
+        for (quint64 time : table.times) {
+            results.tracepoints.push_back({time, table.name, 0, static_cast<qint32>(results.tracepoints.size())});
+        }
+        QCOMPARE(results.tracepointsInRange({250, 500}), std::make_pair(2, 5));
+    }
 
-        QCOMPARE(tree.costs.totalCost(0), qint64(9));
+    void testLockContention()
+    {
+        auto field = [](const QString& name) {
+            Data::TracepointField field;
+            field.name = name;
+            return field;
+        };
 
-        const auto expectedTree = QStringList {
-            QStringLiteral("C=5"),     QStringLiteral(" B=1"),   QStringLiteral("  A=1"),   QStringLiteral(" E=1"),
-            QStringLiteral("  C=1"),   QStringLiteral("   B=1"), QStringLiteral("    A=1"), QStringLiteral(" C=1"),
-            QStringLiteral("  B=1"),   QStringLiteral("   A=1"), QStringLiteral("D=2"),     QStringLiteral(" B=2"),
-            QStringLiteral("  A=2"),   QStringLiteral("E=2"),    QStringLiteral(" C=2"),    QStringLiteral("  B=1"),
-            QStringLiteral("   A=1"),  QStringLiteral("  E=1"),  QStringLiteral("   C=1"),  QStringLiteral("    B=1"),
-            QStringLiteral("     A=1")};
-        QCOMPARE(printTree(tree), expectedTree);
+        Data::TracepointTable enter;
+        enter.name = QStringLiteral("syscalls:sys_enter_futex");
+        enter.fields = {field(QStringLiteral("uaddr")), field(QStringLiteral("op"))};
+        auto& uaddr = enter.fields[0];
+        auto& op = enter.fields[1];
+        // time, tid, stack, address, operation: thread 1 and 2 wait, thread 3 wakes them up
+        const std::tuple<quint64, qint32, qint32, quint64, qint64> enters[] = {
+            {10, 1, 0, 0x100, 128}, {12, 2, 1, 0x100, 0}, {15, 3, 0, 0x100, 1}, {40, 1, 0, 0x100, 137}};
+        for (const auto& [time, tid, stackId, address, operation] : enters) {
+            enter.times.push_back(time);
+            enter.threadIds.push_back(tid);
+            enter.stackIds.push_back(stackId);
+            uaddr.append(QVariant::fromValue(address));
+            op.append(QVariant::fromValue(operation));
+        }
 
-        BottomUpModel model;
+        Data::TracepointTable exit;
+        exit.name = QStringLiteral("syscalls:sys_exit_futex");
+        const std::pair<quint64, qint32> exits[] = {{15, 3}, {30, 1}, {32, 2}, {45, 1}, {50, 4}};
+        for (const auto& [time, tid] : exits) {
+            exit.times.push_back(time);
+            exit.threadIds.push_back(tid);
+            exit.stackIds.push_back(-1);
+        }
+
+        // the kernel locks, with the address formatted as text
+        Data::TracepointTable begin;
+        begin.name = QStringLiteral("lock:contention_begin");
+        begin.fields = {field(QStringLiteral("lock_addr"))};
+        begin.fields[0].append(QStringLiteral("0xffff0000"));
+        begin.times.push_back(20);
+        begin.threadIds.push_back(5);
+        begin.stackIds.push_back(2);
+        Data::TracepointTable end;
+        end.name = QStringLiteral("lock:contention_end");
+        end.times.push_back(26);
+        end.threadIds.push_back(5);
+        end.stackIds.push_back(-1);
+
+        Data::TracepointResults tracepoints;
+        tracepoints.tables = {enter, exit, begin, end};
+        const LockContention contention(tracepoints);
+
+        QCOMPARE(contention.waits().size(), 4);
+        QVector<quint64> starts;
+        for (const auto& wait : contention.waits()) {
+            starts.push_back(wait.time.start);
+        }
+        QCOMPARE(starts, QVector<quint64>({10, 12, 20, 40}));
+
+        QCOMPARE(contention.locks().size(), 2);
+        const auto futex = contention.locks().value(0x100);
+        QCOMPARE(futex.cost.waits, quint64(3));
+        QCOMPARE(futex.cost.waitTime, quint64(45));
+        QCOMPARE(futex.cost.maxWaitTime, quint64(20));
+        QCOMPARE(futex.cost.averageWaitTime(), quint64(15));
+        QCOMPARE(futex.cost.time, Data::TimeRange(10, 45));
+        QCOMPARE(futex.threads, 2);
+        QCOMPARE(futex.topStackId, 0);
+        const auto kernelLock = contention.locks().value(0xffff0000);
+        QCOMPARE(kernelLock.cost.waitTime, quint64(6));
+        QCOMPARE(kernelLock.topStackId, 2);
+
+        QCOMPARE(contention.stacks().size(), 3);
+        QCOMPARE(contention.stacks().value(0).cost.waitTime, quint64(25));
+        QCOMPARE(contention.stacks().value(0).locks, 1);
+        QCOMPARE(contention.stacks().value(1).cost.waits, quint64(1));
+
+        QVERIFY(LockContention::isFutexWait(0));
+        QVERIFY(LockContention::isFutexWait(128 | 9));
+        QVERIFY(!LockContention::isFutexWait(1));
+        QVERIFY(!LockContention::isFutexWait(128 | 1));
+
+        LockModel model;
         QAbstractItemModelTester tester(&model);
+        model.setResults(contention, {});
+        QCOMPARE(model.rowCount(), 2);
+        const auto index = model.indexForKey(0x100, LockModel::Threads);
+        QCOMPARE(index.data().toInt(), 2);
+        QCOMPARE(index.data(LockModel::TimeRole).value<Data::TimeRange>(), Data::TimeRange(10, 45));
 
-        model.setData(tree);
+        QVERIFY(LockContention(Data::TracepointResults()).isEmpty());
+    }
+
+    void testPerfStat()
+    {
+        const auto output = QByteArrayLiteral("# started on Thu Oct 15 10:00:00 2026\n"
+                                              "\n"
+                                              "     1.000000000,2000,,cycles,1000000000,100.00,,\n"
+                                              "1.000000000,3000,,instructions,1000000000,100.00,1.50,insn per cycle\n"
+                                              "     1.000000000,<not supported>,,cache-misses,0,100.00,,\n"
+                                              "     1.000000000,10,,context-switches,1000000000,100.00,10.00,/sec\n"
+                                              "garbage\n"
+                                              "     1.500000000,1000,,cycles,500000000,100.00,,\n"
+                                              "1.500000000,500,,instructions,500000000,100.00,0.50,insn per cycle\n"
+                                              "     1.500000000,4,,context-switches,500000000,100.00,8.00,/sec\n");
+        QVERIFY(PerfStat::isPerfStatOutput(output));
+        QVERIFY(!PerfStat::isPerfStatOutput("main;foo;bar 12\n"));
+        QVERIFY(!PerfStat::isPerfStatOutput("# started on Thu Oct 15 10:00:00 2026\n"));
+
+        const PerfStat stat(output);
+        QCOMPARE(stat.times(), QVector<quint64>({1000000000, 1500000000}));
+        QCOMPARE(stat.numInvalidLines(), 1);
+        QCOMPARE(stat.counters().size(), 4);
+        QCOMPARE(stat.counters()[1].event, QStringLiteral("instructions"));
+        QCOMPARE(stat.counters()[1].values, QVector<double>({3000, 500}));
+        QCOMPARE(stat.counters()[1].cpu, -1);
+        // neither counted in the first nor mentioned in the second interval
+        QCOMPARE(stat.counters()[2].values.size(), 2);
+        QVERIFY(std::isnan(stat.counters()[2].values[0]) && std::isnan(stat.counters()[2].values[1]));
+
+        const auto summary = stat.summary();
+        QCOMPARE(summary.size(), 5);
+        QCOMPARE(summary[0].name, QStringLiteral("cycles"));
+        QCOMPARE(summary[0].value, 3000.);
+        QCOMPARE(summary[2].value, 0.);
+        QCOMPARE(summary[3].value, 14.);
+        QVERIFY(!summary[3].isMetric);
+        QCOMPARE(summary[4].name, QStringLiteral("IPC"));
+        QCOMPARE(summary[4].value, 3500. / 3000.);
+        QVERIFY(summary[4].isMetric);
+
+        const auto frequencies = stat.frequencyResults();
+        QVERIFY(frequencies.isAggregated);
+        QCOMPARE(frequencies.cores.size(), 1);
+        const auto& costs = frequencies.cores[0].costs;
+        QCOMPARE(costs.size(), 5);
+        // the counts per second
+        QCOMPARE(costs[0].costName, QStringLiteral("cycles"));
+        QCOMPARE(costs[0].values.size(), 2);
+        QCOMPARE(costs[0].values[0].time, quint64(1000000000));
+        QCOMPARE(costs[0].values[0].cost, 2000.);
+        QCOMPARE(costs[0].values[1].cost, 2000.);
+        QVERIFY(costs[2].values.isEmpty());
+        QCOMPARE(costs[4].costName, QStringLiteral("IPC"));
+        QCOMPARE(costs[4].values.size(), 2);
+        QCOMPARE(costs[4].values[0].cost, 1.5);
+        QCOMPARE(costs[4].values[1].cost, 0.5);
+
+        // counted per CPU with --no-aggr
+        const PerfStat perCpu("1.000000000,CPU1,100,,cycles:u,1000000000,100.00,,\n"
+                              "1.000000000,CPU1,50,,instructions:u,1000000000,100.00,0.50,insn per cycle\n");
+        QCOMPARE(perCpu.counters()[0].cpu, 1);
+        const auto perCpuFrequencies = perCpu.frequencyResults();
+        QVERIFY(!perCpuFrequencies.isAggregated);
+        QCOMPARE(perCpuFrequencies.cores.size(), 2);
+        QVERIFY(perCpuFrequencies.cores[0].costs.isEmpty());
+        QCOMPARE(perCpuFrequencies.cores[1].costs.size(), 3);
+        QCOMPARE(perCpuFrequencies.cores[1].costs[2].costName, QStringLiteral("IPC (instructions:u)"));
+        QCOMPARE(perCpuFrequencies.cores[1].costs[2].values[0].cost, 0.5);
+    }
+
+    void testWakeupGraph()
+    {
+        Data::EventResults events;
+        events.offCpuTimeCostId = 1;
+        events.threads.resize(3);
+        const qint32 tids[] = {1, 2, 3};
+        const quint64 starts[] = {0, 0, 10};
+        for (int i = 0; i < 3; ++i) {
+            events.threads[i].tid = tids[i];
+            events.threads[i].time = {starts[i], 1000};
+        }
+        // time, cost, type, stack, cpu
+        events.threads[0].events.push_back({20, 1, 0, 0, 0});
+        events.threads[0].events.push_back({100, 200, 1, 4, 0});
+        events.threads[1].events.push_back({50, 150, 1, 5, 0});
+        events.threads[1].events.push_back({600, 100, 1, 6, 0});
+
+        // thread 3 wakes up thread 2, which then wakes up thread 1
+        Data::TracepointTable table;
+        table.name = QStringLiteral("sched:sched_wakeup");
+        Data::TracepointField pid;
+        pid.name = QStringLiteral("pid");
+        const quint64 times[] = {180, 250};
+        const qint32 wakers[] = {3, 2};
+        const qint32 wakees[] = {2, 1};
+        for (int i = 0; i < 2; ++i) {
+            table.times.push_back(times[i]);
+            table.threadIds.push_back(wakers[i]);
+            table.stackIds.push_back(7 + i);
+            pid.append(QVariant::fromValue(wakees[i]));
+        }
+        table.fields = {pid};
+        Data::TracepointResults tracepoints;
+        tracepoints.tables = {table};
+
+        const WakeupGraph graph(events, tracepoints);
+        QCOMPARE(graph.wakeups().size(), 2);
+        QCOMPARE(graph.offCpuSpans(2).size(), 2);
+
+        QVERIFY(!graph.blockedAt(1, 50));
+        QVERIFY(!graph.blockedAt(1, 350));
+        const auto* span = graph.blockedAt(1, 150);
+        QVERIFY(span);
+        QCOMPARE(span->time, Data::TimeRange(100, 300));
+        QCOMPARE(span->stackId, 4);
+        QCOMPARE(span->wakeup, 1);
+        // nothing woke up thread 2 the second time
+        span = graph.blockedAt(2, 650);
+        QVERIFY(span);
+        QCOMPARE(span->wakeup, -1);
+
+        const auto path = graph.criticalPath(1, 300);
+        QCOMPARE(path.size(), 3);
+        QCOMPARE(path[0].tid, 3);
+        QCOMPARE(path[0].time, Data::TimeRange(10, 180));
+        QCOMPARE(path[1].tid, 2);
+        QCOMPARE(path[1].time, Data::TimeRange(180, 250));
+        QCOMPARE(path[2].tid, 1);
+        QCOMPARE(path[2].time, Data::TimeRange(250, 300));
+
+        // thread 1 ran on its own before it blocked
+        const auto ownPath = graph.criticalPath(1, 80);
+        QCOMPARE(ownPath.size(), 1);
+        QCOMPARE(ownPath[0].time, Data::TimeRange(0, 80));
     }
 
     void testSimplifiedModel()
@@ -209,6 +2697,97 @@ private slots:
         QCOMPARE(modelData, expectedModelData);
     }
 
+    void testSimplifiedModelDeepChain()
+    {
+        // a deep chain below the top level function 1 that branches at the end
+        QStringList frames;
+        for (int i = 501; i > 0; --i) {
+            frames.append(QString::number(i));
+        }
+        const auto chain = frames.join(QLatin1Char(';'));
+        const auto tree = buildBottomUpTree((QLatin1String("a;") + chain + QLatin1String("\nb;") + chain).toUtf8());
+
+        BottomUpModel model;
+        QAbstractItemModelTester tester(&model);
+        model.setData(tree);
+
+        QCOMPARE(model.rowCount(), 1);
+        const auto headIdx = model.index(0, 0);
+        QCOMPARE(model.rowCount(headIdx), 500);
+
+        auto item = model.itemFromIndex(headIdx);
+        for (int row = 0; row < 500; ++row) {
+            item = &item->children.first();
+            const auto idx = model.index(row, 0, headIdx);
+            QCOMPARE(model.itemFromIndex(idx), item);
+            QCOMPARE(model.indexFromItem(item, 0), idx);
+            QCOMPARE(model.parent(idx), headIdx);
+        }
+        QCOMPARE(item->children.size(), 2);
+
+        model.setSimplify(false);
+        QCOMPARE(model.rowCount(model.index(0, 0)), 1);
+        model.setSimplify(true);
+        QCOMPARE(model.rowCount(model.index(0, 0)), 500);
+    }
+
+    void testTreeModelSort()
+    {
+        const auto tree = buildBottomUpTree(R"(
+            A;X
+            B;X
+            B;X
+            C;X
+            C;X
+            C;X
+            D;Y
+            E;Y
+            E;Y
+        )");
+
+        BottomUpModel model;
+        QAbstractItemModelTester tester(&model);
+        model.setData(tree);
+        QCOMPARE(model.rowCount(), 2);
+
+        auto symbols = [&model](const QModelIndex& parent) {
+            QStringList ret;
+            for (int row = 0, c = model.rowCount(parent); row < c; ++row) {
+                const auto index = model.index(row, BottomUpModel::Symbol, parent);
+                if (model.indexFromItem(model.itemFromIndex(index), BottomUpModel::Symbol) != index) {
+                    return QStringList();
+                }
+                ret.append(index.data().toString());
+            }
+            return ret;
+        };
+
+        const QPersistentModelIndex y = model.index(1, BottomUpModel::Symbol);
+        QCOMPARE(y.data().toString(), QStringLiteral("Y"));
+
+        model.sort(BottomUpModel::InitialSortColumn, Qt::DescendingOrder);
+        QCOMPARE(symbols({}), QStringList({QStringLiteral("X"), QStringLiteral("Y")}));
+        QCOMPARE(symbols(model.index(0, 0)),
+                 QStringList({QStringLiteral("C"), QStringLiteral("B"), QStringLiteral("A")}));
+
+        model.sort(BottomUpModel::InitialSortColumn, Qt::AscendingOrder);
+        QCOMPARE(symbols({}), QStringList({QStringLiteral("Y"), QStringLiteral("X")}));
+        QCOMPARE(symbols(model.index(1, 0)),
+                 QStringList({QStringLiteral("A"), QStringLiteral("B"), QStringLiteral("C")}));
+        QCOMPARE(y.row(), 0);
+        QCOMPARE(y.data().toString(), QStringLiteral("Y"));
+
+        model.sort(BottomUpModel::Symbol, Qt::DescendingOrder);
+        QCOMPARE(symbols({}), QStringList({QStringLiteral("Y"), QStringLiteral("X")}));
+        QCOMPARE(symbols(model.index(1, 0)),
+                 QStringList({QStringLiteral("C"), QStringLiteral("B"), QStringLiteral("A")}));
+
+        // the order is kept for new data
+        model.setData(tree);
+        QCOMPARE(symbols(model.index(1, 0)),
+                 QStringList({QStringLiteral("C"), QStringLiteral("B"), QStringLiteral("A")}));
+    }
+
     void testTopDownModel_data()
     {
         QTest::addColumn<bool>("skipFirstLevel");
@@ -255,6 +2834,74 @@ private slots:
         model.setData(tree);
     }
 
+    void testTopDownSubtrees_data()
+    {
+        QTest::addColumn<bool>("skipFirstLevel");
+
+        QTest::addRow("normal") << false;
+        QTest::addRow("skipFirstLevel") << true;
+    }
+
+    void testTopDownSubtrees()
+    {
+        QFETCH(bool, skipFirstLevel);
+
+        const auto tree = skipFirstLevel ? generateTreeByThread() : generateTree1();
+        const auto expected = Data::TopDownResults::fromBottomUp(tree, skipFirstLevel);
+        const auto expectedLibraries = Data::PerLibraryResults::fromTopDown(expected);
+
+        auto printLibraries = [](const Data::PerLibraryResults& results) {
+            QStringList list;
+            for (const auto& library : results.root.children) {
+                list.push_back(library.symbol.path + QLatin1Char('=')
+                               + QString::number(results.costs.cost(0, library.id)));
+            }
+            return list;
+        };
+
+        const int numChildren = tree.root.children.size();
+        QVERIFY(numChildren > 1);
+        for (int split = 1; split < numChildren; ++split) {
+            auto results = Data::TopDownResults::fromBottomUpSubtrees(tree, skipFirstLevel, 0, split);
+            results.merge(Data::TopDownResults::fromBottomUpSubtrees(tree, skipFirstLevel, split, numChildren));
+            Data::TopDown::initializeParents(&results.root);
+            QCOMPARE(printTree(results), printTree(expected));
+
+            const int numTopDownChildren = results.root.children.size();
+            for (int librarySplit = 1; librarySplit < numTopDownChildren; ++librarySplit) {
+                auto libraries = Data::PerLibraryResults::fromTopDownSubtrees(results, 0, librarySplit);
+                libraries.merge(
+                    Data::PerLibraryResults::fromTopDownSubtrees(results, librarySplit, numTopDownChildren));
+                QCOMPARE(printLibraries(libraries), printLibraries(expectedLibraries));
+            }
+        }
+    }
+
+    void testTopDownDeepChain()
+    {
+        const int depth = 10000;
+        QStringList frames;
+        for (int i = depth; i > 0; --i) {
+            frames.append(QString::number(i));
+        }
+        const auto tree = buildBottomUpTree(frames.join(QLatin1Char(';')).toUtf8());
+
+        const auto topDown = Data::TopDownResults::fromBottomUp(tree, false);
+        const Data::TopDown* node = &topDown.root;
+        for (int i = 0; i < depth; ++i) {
+            QCOMPARE(node->children.size(), 1);
+            node = &node->children.first();
+            QCOMPARE(node->symbol.symbol, QString::number(depth - i));
+            QCOMPARE(topDown.inclusiveCosts.cost(0, node->id), qint64(1));
+        }
+        QVERIFY(node->children.isEmpty());
+        QCOMPARE(topDown.selfCosts.cost(0, node->id), qint64(1));
+
+        const auto perLibrary = Data::PerLibraryResults::fromTopDown(topDown);
+        QCOMPARE(perLibrary.root.children.size(), 1);
+        QCOMPARE(perLibrary.costs.cost(0, perLibrary.root.children.first().id), qint64(1));
+    }
+
     void testTopProxy()
     {
         BottomUpModel model;
@@ -275,6 +2922,82 @@ private slots:
         }
     }
 
+    void testFilterMatcher()
+    {
+        using CallerCalleeProxyDetail::Matcher;
+        QCOMPARE(Matcher::literalPattern(QRegularExpression::escape(QStringLiteral("std::vector<int>"))),
+                 QStringLiteral("std::vector<int>"));
+        QCOMPARE(Matcher::literalPattern(QStringLiteral("foo")), QStringLiteral("foo"));
+        QVERIFY(!Matcher::literalPattern(QString()).isNull());
+        QVERIFY(Matcher::literalPattern(QStringLiteral("fo+")).isNull());
+        QVERIFY(Matcher::literalPattern(QStringLiteral("\\d")).isNull());
+
+        QSortFilterProxyModel proxy;
+        Matcher matcher;
+        const auto symbol =
+            Data::internSymbol({QStringLiteral("std::Vector::push_back"), 1, 0, QStringLiteral("libfoo.so")});
+        const auto other = Data::Symbol {QStringLiteral("main"), 2, 0, QStringLiteral("app")};
+        QVERIFY(matcher.match(&proxy, symbol));
+        QVERIFY(matcher.match(&proxy, other));
+
+        proxy.setFilterCaseSensitivity(Qt::CaseInsensitive);
+        proxy.setFilterRegularExpression(QRegularExpression::escape(QStringLiteral("vector::")));
+        QVERIFY(matcher.match(&proxy, symbol));
+        QVERIFY(!matcher.match(&proxy, other));
+
+        // the cached result of the interned symbol must not survive a filter change
+        proxy.setFilterRegularExpression(QRegularExpression::escape(QStringLiteral("app")));
+        QVERIFY(!matcher.match(&proxy, symbol));
+        QVERIFY(matcher.match(&proxy, other));
+
+        proxy.setFilterRegularExpression(QStringLiteral("^lib.*\\.so$"));
+        QVERIFY(matcher.match(&proxy, symbol));
+        QVERIFY(!matcher.match(&proxy, other));
+    }
+
+    void testSymbolSearch()
+    {
+        BottomUpModel model;
+        model.setData(generateTree1());
+        CostProxy<BottomUpModel> proxy;
+        proxy.setSourceModel(&model);
+        QAbstractItemModelTester tester(&proxy);
+        QCOMPARE(proxy.rowCount(), 3);
+
+        auto search = [&proxy](const QString& text) {
+            auto pattern = proxy.filterRegularExpression();
+            pattern.setPattern(text);
+            proxy.search(&proxy, pattern, [&proxy, pattern]() { proxy.setFilterRegularExpression(pattern); });
+        };
+
+        // the stale search must not overwrite the newer one
+        search(QStringLiteral("E"));
+        search(QStringLiteral("D"));
+        QTRY_COMPARE(proxy.filterRegularExpression().pattern(), QStringLiteral("D"));
+        QCOMPARE(proxy.rowCount(), 1);
+        QTest::qWait(100);
+        QCOMPARE(proxy.filterRegularExpression().pattern(), QStringLiteral("D"));
+
+        search(QString());
+        QCOMPARE(proxy.rowCount(), 3);
+    }
+
+    void testCallerCalleeSubtrees()
+    {
+        const auto tree = generateTree1();
+
+        Data::CallerCalleeResults expected;
+        Data::callerCalleesFromBottomUpData(tree, &expected);
+
+        const int numChildren = tree.root.children.size();
+        QVERIFY(numChildren > 1);
+        for (int split = 1; split < numChildren; ++split) {
+            auto results = Data::callerCalleesFromBottomUpSubtrees(tree, 0, split);
+            results.merge(Data::callerCalleesFromBottomUpSubtrees(tree, split, numChildren));
+            QCOMPARE(printMap(results), printMap(expected));
+        }
+    }
+
     void testCallerCalleeModel()
     {
         const auto tree = generateTree1();
@@ -299,6 +3022,15 @@ private slots:
         QTextStream(stdout) << "\nActual Model:\n" << printCallerCalleeModel(model).join(QLatin1Char('\n')) << "\n";
         QCOMPARE(printCallerCalleeModel(model), expectedMap);
 
+        // every symbol can be found, which is what other views use to select it
+        for (auto it = results.entries.constBegin(), end = results.entries.constEnd(); it != end; ++it) {
+            const auto index = model.indexForKey(it.key());
+            QVERIFY(index.isValid());
+            QCOMPARE(model.key(index.row()), it.key());
+        }
+        QVERIFY(!model.indexForKey(Data::Symbol(QStringLiteral("unknown"))).isValid());
+        QCOMPARE(model.keys().size(), results.entries.size());
+
         for (const auto& entry : std::as_const(results.entries)) {
             {
                 CallerModel model;
@@ -318,6 +3050,227 @@ private slots:
         }
     }
 
+    void testCallerCalleeAdjacency()
+    {
+        Data::CallerCalleeResults results;
+        Data::callerCalleesFromBottomUpData(generateTree1(), &results);
+        QVERIFY(results.hasAdjacency());
+        QCOMPARE(results.adjacencySymbols.size(), results.entries.size());
+
+        auto printEdges = [&results](const Data::CallerCalleeAdjacency& adjacency, const QString& symbol) {
+            QStringList edges;
+            const auto id = results.adjacencyId(Data::Symbol {symbol, {}});
+            for (const auto& edge : adjacency.edges(id)) {
+                edges.append(results.adjacencySymbols[edge.symbolId].symbol + QLatin1Char('=')
+                             + QString::number(edge.cost));
+            }
+            return edges;
+        };
+
+        // sorted by descending cost, matching CallerCalleeResults::entries
+        QCOMPARE(printEdges(results.calleeAdjacency, QStringLiteral("B")),
+                 QStringList({QStringLiteral("C=5"), QStringLiteral("D=2")}));
+        QCOMPARE(printEdges(results.callerAdjacency, QStringLiteral("C")),
+                 QStringList({QStringLiteral("B=5"), QStringLiteral("E=2"), QStringLiteral("C=1")}));
+        QCOMPARE(printEdges(results.callerAdjacency, QStringLiteral("A")), QStringList());
+        QCOMPARE(printEdges(results.calleeAdjacency, QStringLiteral("unknown")), QStringList());
+    }
+
+    void testCallerCalleeFileCosts()
+    {
+        Data::CallerCalleeResults results;
+        results.selfCosts.addType(0, QStringLiteral("samples"), Data::Costs::Unit::Unknown);
+        results.inclusiveCosts.addType(0, QStringLiteral("samples"), Data::Costs::Unit::Unknown);
+
+        const auto file = QStringLiteral("/src/main.cpp");
+        const auto header = QStringLiteral("/src/main.h");
+        {
+            auto& cost = results.entry({QStringLiteral("a"), {}}).source({file, 10}, 1);
+            cost.selfCost[0] = 3;
+            cost.inclusiveCost[0] = 5;
+        }
+        {
+            // e.g. inlined into another function
+            auto& entry = results.entry({QStringLiteral("b"), {}});
+            entry.source({file, 10}, 1).selfCost[0] = 1;
+            entry.source({file, 12}, 1).inclusiveCost[0] = 2;
+            entry.source({header, 10}, 1).inclusiveCost[0] = 7;
+        }
+
+        results.buildFileCosts();
+        QCOMPARE(results.fileCosts.size(), 2);
+        const auto lines = results.fileCosts.value(file);
+        QCOMPARE(lines.size(), 2);
+        QCOMPARE(lines.value(10).selfCost[0], qint64(4));
+        QCOMPARE(lines.value(10).inclusiveCost[0], qint64(5));
+        QCOMPARE(lines.value(12).selfCost[0], qint64(0));
+        QCOMPARE(lines.value(12).inclusiveCost[0], qint64(2));
+        QCOMPARE(results.fileCosts.value(header).value(10).inclusiveCost[0], qint64(7));
+    }
+
+    void testLocationCostIndex()
+    {
+        const auto file = QStringLiteral("/src/main.cpp");
+        const Data::Symbol leaf = {QStringLiteral("leaf"), {}};
+        const Data::Symbol main = {QStringLiteral("main"), {}};
+
+        // main calls leaf, the location ids double as symbol ids
+        Data::BottomUpResults bottomUp;
+        bottomUp.costs.addType(0, QStringLiteral("samples"), Data::Costs::Unit::Unknown);
+        bottomUp.symbols = {leaf, main};
+        bottomUp.locations = {{1, {0x1010, 0x10, {file, 10}}}, {-1, {0x1020, 0x20, {file, 20}}}};
+
+        Data::EventResults events;
+        events.stacks = {{0}, {1}};
+        events.threads.resize(1);
+        auto addEvent = [&events](quint64 cost, qint32 stackId) {
+            Data::Event event;
+            event.cost = cost;
+            event.type = 0;
+            event.stackId = stackId;
+            events.threads[0].events.push_back(event);
+        };
+        addEvent(5, 0);
+        addEvent(3, 1);
+        // events without a stack, e.g. lost events, are skipped
+        addEvent(7, -1);
+
+        Data::CallerCalleeResults results;
+        results.selfCosts.initializeCostsFrom(bottomUp.costs);
+        results.inclusiveCosts.initializeCostsFrom(bottomUp.costs);
+        results.entry(leaf);
+        results.entry(main);
+        results.locations = std::make_shared<const Data::LocationCostIndex>(bottomUp, events);
+
+        const auto leafMap = results.sourceMap(leaf);
+        QCOMPARE(leafMap.size(), 1);
+        QCOMPARE(leafMap.value({file, 10}).selfCost[0], qint64(5));
+        QCOMPARE(leafMap.value({file, 10}).inclusiveCost[0], qint64(5));
+
+        const auto mainMap = results.offsetMap(main);
+        QCOMPARE(mainMap.size(), 1);
+        QCOMPARE(mainMap.value(0x20).selfCost[0], qint64(3));
+        QCOMPARE(mainMap.value(0x20).inclusiveCost[0], qint64(8));
+
+        const auto selfMaps = results.selfOffsetMaps();
+        QCOMPARE(selfMaps.size(), 2);
+        QCOMPARE(selfMaps.value(leaf).value(0x10).selfCost[0], qint64(5));
+        QCOMPARE(selfMaps.value(main).value(0x20).selfCost[0], qint64(3));
+
+        results.buildFileCosts();
+        const auto lines = results.fileCosts.value(file);
+        QCOMPARE(lines.size(), 2);
+        QCOMPARE(lines.value(10).selfCost[0], qint64(5));
+        QCOMPARE(lines.value(20).selfCost[0], qint64(3));
+        QCOMPARE(lines.value(20).inclusiveCost[0], qint64(8));
+    }
+
+    void testTopInstructions()
+    {
+        Data::CallerCalleeResults results;
+        results.selfCosts.addType(0, QStringLiteral("samples"), Data::Costs::Unit::Unknown);
+        results.inclusiveCosts.addType(0, QStringLiteral("samples"), Data::Costs::Unit::Unknown);
+
+        // enough symbols to spread them across multiple jobs
+        for (int i = 0; i < 50; ++i) {
+            auto& entry = results.entry({QStringLiteral("func%1").arg(i), {}});
+            for (int j = 0; j < 10; ++j) {
+                const qint64 cost = (i * 7 + j * 13) % 97;
+                entry.offset(0x1000 + j * 4, 1).selfCost[0] = cost;
+                results.selfCosts.add(0, entry.id, cost);
+                results.selfCosts.addTotalCost(0, cost);
+            }
+        }
+
+        const auto instructions = topInstructions(results, 0, 20);
+        QCOMPARE(instructions.size(), 20);
+        for (int i = 1; i < instructions.size(); ++i) {
+            QVERIFY(instructions[i - 1].selfCost[0] >= instructions[i].selfCost[0]);
+        }
+        QCOMPARE(instructions.first().selfCost[0], qint64(96));
+
+        // the cheapest of the top instructions is at least as expensive as everything that didn't make it
+        qint64 costs = 0;
+        for (const auto& entry : std::as_const(results.entries)) {
+            for (const auto& cost : entry.offsetMap) {
+                if (cost.selfCost[0] > instructions.last().selfCost[0]) {
+                    ++costs;
+                }
+            }
+        }
+        QVERIFY(costs < instructions.size());
+
+        QVERIFY(topInstructions(results, 0, 0).isEmpty());
+        QVERIFY(topInstructions(results, 1, 10).isEmpty());
+
+        TopInstructionsModel model;
+        QAbstractItemModelTester tester(&model);
+        model.setResults(instructions, results.selfCosts);
+        QCOMPARE(model.rowCount(), 20);
+        QCOMPARE(model.columnCount(), TopInstructionsModel::NUM_BASE_COLUMNS + 1);
+        const auto index = model.index(0, TopInstructionsModel::InitialSortColumn);
+        QCOMPARE(index.data(TopInstructionsModel::SortRole).toLongLong(), qint64(96));
+        QCOMPARE(index.data(TopInstructionsModel::AddressRole).value<quint64>(), instructions.first().addr);
+        QCOMPARE(index.data(TopInstructionsModel::SymbolRole).value<Data::Symbol>(), instructions.first().symbol);
+    }
+
+    void testHotPaths()
+    {
+        const auto tree = buildBottomUpTree(R"(
+            A;B;C
+            A;B;C
+            A;B;C
+            A;B;D
+            A;B;D
+            A;B
+            A;E
+        )");
+        const auto topDown = Data::TopDownResults::fromBottomUp(tree, false);
+
+        auto frames = [](const HotPath& path) {
+            QStringList ret;
+            for (const auto& frame : path.frames) {
+                ret.append(frame.symbol);
+            }
+            return ret.join(QLatin1Char(';'));
+        };
+
+        auto paths = hotPaths(topDown, 0, 2, false);
+        QCOMPARE(paths.size(), 2);
+        QCOMPARE(frames(paths[0]), QStringLiteral("A;B;C"));
+        QCOMPARE(paths[0].cost[0], qint64(3));
+        QCOMPARE(frames(paths[1]), QStringLiteral("A;B;D"));
+        QCOMPARE(paths[1].cost[0], qint64(2));
+
+        // the paths that end within the tree count too, but there are no more paths than stacks
+        paths = hotPaths(topDown, 0, 10, false);
+        QCOMPARE(paths.size(), 4);
+        QStringList cheapest = {frames(paths[2]), frames(paths[3])};
+        cheapest.sort();
+        QCOMPARE(cheapest, QStringList({QStringLiteral("A;B"), QStringLiteral("A;E")}));
+        QCOMPARE(paths[3].cost[0], qint64(1));
+
+        // the first level groups the paths
+        paths = hotPaths(topDown, 0, 1, true);
+        QCOMPARE(paths.size(), 1);
+        QCOMPARE(paths[0].group.symbol, QStringLiteral("A"));
+        QCOMPARE(frames(paths[0]), QStringLiteral("B;C"));
+
+        QVERIFY(hotPaths(topDown, 0, 0, false).isEmpty());
+        QVERIFY(hotPaths(topDown, 1, 10, false).isEmpty());
+
+        HotPathModel model;
+        QAbstractItemModelTester tester(&model);
+        model.setResults(hotPaths(topDown, 0, 2, false), topDown.selfCosts);
+        QCOMPARE(model.rowCount(), 2);
+        QCOMPARE(model.columnCount(), HotPathModel::NUM_BASE_COLUMNS + 1);
+        QCOMPARE(model.index(0, HotPathModel::Path).data().toString(), QStringLiteral("A > B > C"));
+        QCOMPARE(model.index(0, HotPathModel::Depth).data().toInt(), 3);
+        const auto index = model.index(1, HotPathModel::InitialSortColumn);
+        QCOMPARE(index.data(HotPathModel::SortRole).toLongLong(), qint64(2));
+        QCOMPARE(index.data(HotPathModel::FramesRole).value<QVector<Data::Symbol>>().size(), 3);
+    }
+
     void testDisassemblyModel_data()
     {
         QTest::addColumn<Data::Symbol>("symbol");
@@ -361,6 +3314,25 @@ private slots:
         model.setDisassembly(disassemblyOutput, results);
         QCOMPARE(model.columnCount(), DisassemblyModel::COLUMN_COUNT + results.selfCosts.numTypes());
         QCOMPARE(model.rowCount(), disassemblyOutput.disassemblyLines.size());
+
+        // the source line of the instruction with costs jumps to it
+        const auto hotRow = model.indexForAddress(4294563);
+        QVERIFY(hotRow.isValid());
+        const auto fileLine = model.fileLineForIndex(hotRow);
+        QCOMPARE(model.indexForFileLine(fileLine).row(), hotRow.row());
+        QVERIFY(!model.indexForFileLine(Data::FileLine(QStringLiteral("/does/not/exist.cpp"), 1)).isValid());
+
+        // the costs can be filled in later, without resetting the model
+        Data::OffsetLocationCostMap offsetMap;
+        offsetMap.insert(4294563, locationCost);
+        model.setDisassembly(disassemblyOutput, results, {});
+        const auto costIndex = model.index(hotRow.row(), DisassemblyModel::COLUMN_COUNT);
+        QCOMPARE(model.data(costIndex, DisassemblyModel::CostRole).toLongLong(), 0);
+        QSignalSpy reset(&model, &QAbstractItemModel::modelReset);
+        model.setOffsetMap(offsetMap);
+        QCOMPARE(reset.count(), 0);
+        QCOMPARE(model.data(costIndex, DisassemblyModel::CostRole).toLongLong(), 200);
+        QCOMPARE(model.rowCount(), disassemblyOutput.disassemblyLines.size());
     }
 
     void testSourceCodeModelNoFileName_data()
@@ -471,6 +3443,16 @@ private slots:
         QCOMPARE(
             model.index(10, SourceCodeModel::SourceCodeColumn).data(SourceCodeModel::RainbowLineNumberRole).toInt(),
             28);
+
+        // the source code gets loaded in the background
+        QTRY_COMPARE(model.index(2, SourceCodeModel::SourceCodeColumn).data().toString().trimmed(),
+                     QStringLiteral("if (argc != 2) {"));
+
+        // loading the same file again is served from the cache
+        model.setDisassembly(disassemblyOutput, {});
+        QCOMPARE(model.rowCount(), 11);
+        QTRY_COMPARE(model.index(2, SourceCodeModel::SourceCodeColumn).data().toString().trimmed(),
+                     QStringLiteral("if (argc != 2) {"));
     }
 
     void testEventModel()
@@ -480,6 +3462,8 @@ private slots:
         events.cpus[0].cpuId = 0;
         events.cpus[1].cpuId = 1; // empty
         events.cpus[2].cpuId = 2;
+        events.cpus[0].numaNode = 1;
+        events.cpus[2].numaNode = 0;
         const int nonEmptyCpus = 2;
         const int processes = 2;
 
@@ -516,7 +3500,7 @@ private slots:
         }
 
         Data::CostSummary costSummary(QStringLiteral("cycles"), 0, 0, Data::Costs::Unit::Unknown);
-        auto generateEvent = [&costSummary, &events](quint64 time, quint32 cpuId) -> Data::Event {
+        auto generateEvent = [&costSummary, &events](qint32 threadIndex, quint64 time, quint32 cpuId) {
             Data::Event event;
             event.cost = 10;
             event.cpuId = cpuId;
@@ -524,30 +3508,47 @@ private slots:
             event.time = time;
             ++costSummary.sampleCount;
             costSummary.totalPeriod += event.cost;
-            events.cpus[cpuId].events << event;
-            return event;
+            auto& thread = events.threads[threadIndex];
+            events.cpus[cpuId].events.push_back({threadIndex, static_cast<qint32>(thread.events.size())});
+            thread.events << event;
         };
         for (quint64 time = 0; time < endTime; time += deltaTime) {
-            thread1.events << generateEvent(time, 0);
+            generateEvent(0, time, 0);
             if (thread2.time.contains(time)) {
-                thread2.events << generateEvent(time, 2);
+                generateEvent(1, time, 2);
             }
         }
         events.totalCosts = {costSummary};
+        for (auto& thread : events.threads) {
+            thread.updateMaxCost();
+        }
+        events.updateMaxCost();
 
         EventModel model;
         QAbstractItemModelTester tester(&model);
-        model.setData(events);
+        // the test modifies events below, which would detach it
+        const auto published = events;
+        model.setData(published);
+
+        // the mipmaps get built in the background, the time line stays blank until then
+        QVERIFY(!model.index(1, EventModel::ThreadColumn).data(EventModel::MipmapsRole).isValid());
+        QSignalSpy mipmapsChanged(&model, &QAbstractItemModel::dataChanged);
+        QTRY_VERIFY(model.index(1, EventModel::ThreadColumn).data(EventModel::MipmapsRole).isValid());
+        QVERIFY(!mipmapsChanged.isEmpty());
 
         QCOMPARE(model.columnCount(), static_cast<int>(EventModel::NUM_COLUMNS));
         QCOMPARE(model.rowCount(), 2);
 
+        // the empty CPU is not shown
         auto simplifiedEvents = events;
         simplifiedEvents.cpus.remove(1);
 
         auto verifyCommonData = [&](const QModelIndex& idx) {
             const auto eventResults = idx.data(EventModel::EventResultsRole).value<Data::EventResults>();
-            QCOMPARE(eventResults, simplifiedEvents);
+            QCOMPARE(eventResults, events);
+            // the model shares the events instead of holding a copy of its own
+            QCOMPARE(eventResults.cpus.constData(), published.cpus.constData());
+            QCOMPARE(eventResults.threads.constData(), published.threads.constData());
             const auto maxTime = idx.data(EventModel::MaxTimeRole).value<quint64>();
             QCOMPARE(maxTime, endTime);
             const auto minTime = idx.data(EventModel::MinTimeRole).value<quint64>();
@@ -573,13 +3574,61 @@ private slots:
             auto numRows = model.rowCount(parent);
             QCOMPARE(numRows, isCpuIndex ? nonEmptyCpus : processes);
 
+            if (isCpuIndex) {
+                // the CPUs get bins no matter how few events they have, the busiest one sets the scale of the heatmap
+                const auto maxCounts = parent.data(EventModel::HeatmapMaxCountsRole).value<QVector<QVector<quint32>>>();
+                QCOMPARE(maxCounts.size(), 1);
+                QVERIFY(!maxCounts[0].isEmpty());
+                for (int j = 0; j < numRows; ++j) {
+                    const auto mipmap = model.index(j, EventModel::ThreadColumn, parent)
+                                            .data(EventModel::MipmapsRole)
+                                            .value<QVector<TimeLineMipmap>>()
+                                            .value(0);
+                    QVERIFY(!mipmap.isEmpty());
+                    QCOMPARE(mipmap.numLevels(), maxCounts[0].size());
+                    for (int level = 0; level < mipmap.numLevels(); ++level) {
+                        quint32 maxCount = 0;
+                        for (const auto& bin : mipmap.bins(level)) {
+                            maxCount = std::max(maxCount, bin.count);
+                        }
+                        // the first CPU got an event whenever the second one got one
+                        if (j == 0) {
+                            QCOMPARE(maxCount, maxCounts[0][level]);
+                        } else {
+                            QVERIFY(maxCount <= maxCounts[0][level]);
+                        }
+                    }
+                }
+            }
+
             if (!isCpuIndex) {
+                auto binnedEvents = [](const QModelIndex& index) {
+                    const auto mipmap = index.data(EventModel::MipmapsRole).value<QVector<TimeLineMipmap>>().value(0);
+                    quint32 count = 0;
+                    if (!mipmap.isEmpty()) {
+                        for (const auto& bin : mipmap.bins(0)) {
+                            count += bin.count;
+                        }
+                    }
+                    return count;
+                };
+
+                // the rows of all threads and the processes sum up the events of their threads
+                QVERIFY(parent.data(EventModel::IsAggregateRole).toBool());
+                QCOMPARE(binnedEvents(parent), quint32(thread1.events.size() + thread2.events.size()));
+
                 // let's only look at the first process
                 parent = model.index(0, EventModel::ThreadColumn, parent);
                 verifyCommonData(parent);
                 QCOMPARE(parent.data().toString(), QLatin1String("foobar (#1234)"));
                 numRows = model.rowCount(parent);
                 QCOMPARE(numRows, 2);
+
+                QVERIFY(parent.data(EventModel::IsAggregateRole).toBool());
+                QCOMPARE(parent.data(EventModel::ThreadStartRole).value<quint64>(), quint64(0));
+                QCOMPARE(parent.data(EventModel::ThreadEndRole).value<quint64>(), endTime);
+                QCOMPARE(binnedEvents(parent), quint32(thread1.events.size() + thread2.events.size()));
+                QVERIFY(parent.data(EventModel::RowKeyRole) != model.index(0, 0, parent).data(EventModel::RowKeyRole));
             }
 
             for (int j = 0; j < numRows; ++j) {
@@ -596,14 +3645,18 @@ private slots:
 
                 if (isCpuIndex) {
                     const auto& cpu = simplifiedEvents.cpus[j];
-                    QCOMPARE(rowEvents, cpu.events);
+                    QCOMPARE(rowEvents, simplifiedEvents.cpuEvents(cpu));
+                    QCOMPARE(rowEvents.size(), cpu.events.size());
                     QCOMPARE(threadStart, quint64(0));
                     QCOMPARE(threadEnd, endTime);
                     QCOMPARE(threadId, Data::INVALID_TID);
                     QCOMPARE(processId, Data::INVALID_PID);
                     QVERIFY(threadName.contains(QString::number(cpu.cpuId)));
                     QCOMPARE(cpuId, cpu.cpuId);
-                    QCOMPARE(idx.data(EventModel::SortRole).value<quint32>(), cpu.cpuId);
+                    QCOMPARE(idx.data(EventModel::NumaNodeRole).toInt(), cpu.numaNode);
+                    // the CPUs get grouped by their NUMA node
+                    QCOMPARE(idx.data(EventModel::SortRole).value<quint64>(),
+                             (quint64(cpu.numaNode + 1) << 32) | cpu.cpuId);
                 } else {
                     const auto& thread = events.threads[j];
                     QCOMPARE(rowEvents, thread.events);
@@ -622,6 +3675,75 @@ private slots:
         }
     }
 
+    void testProcessModelMerge()
+    {
+        auto proc = [](const char* pid, const char* state) {
+            return ProcData {QString::fromLatin1(pid), QStringLiteral("app"), QString::fromLatin1(state),
+                             QStringLiteral("user")};
+        };
+
+        ProcessModel model;
+        QAbstractItemModelTester tester(&model);
+        model.mergeProcesses({proc("3", "S"), proc("1", "S"), proc("5", "S"), proc("7", "S")});
+        QCOMPARE(model.rowCount(), 4);
+
+        QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+        QSignalSpy removed(&model, &QAbstractItemModel::rowsRemoved);
+        QSignalSpy changed(&model, &QAbstractItemModel::dataChanged);
+        model.mergeProcesses({proc("2", "S"), proc("3", "R"), proc("4", "S"), proc("5", "R"), proc("6", "S")});
+        const ProcDataList expected = {proc("2", "S"), proc("3", "R"), proc("4", "S"), proc("5", "R"),
+                                       proc("6", "S")};
+        QCOMPARE(model.processes(), expected);
+        for (int i = 0; i < expected.size(); ++i) {
+            QVERIFY(model.processes().at(i).equals(expected.at(i)));
+        }
+        // 1 and 7 are gone, 2, 4 and 6 are new
+        QCOMPARE(removed.size(), 2);
+        QCOMPARE(inserted.size(), 3);
+        QCOMPARE(changed.size(), 2);
+
+        // the cached enumeration still sees the state changes
+        ProcessListCache cache;
+        const auto pid = QString::number(QCoreApplication::applicationPid());
+        auto findSelf = [&pid](const ProcDataList& processes) {
+            return std::find(processes.begin(), processes.end(), ProcData {pid, {}, {}, {}});
+        };
+        const auto first = processList(&cache);
+        QVERIFY(findSelf(first) != first.end());
+        const auto second = processList(&cache);
+        const auto self = findSelf(second);
+        QVERIFY(self != second.end());
+        QVERIFY(self->equals(*findSelf(first)));
+        QVERIFY(!self->user.isEmpty());
+    }
+
+    void testCgroups()
+    {
+        // cgroup v2
+        QCOMPARE(perfEventCgroup("0::/system.slice/foo.service\n"), QStringLiteral("system.slice/foo.service"));
+        QCOMPARE(perfEventCgroup("0::/\n"), QString());
+        // cgroup v1, the perf_event controller wins over the unified hierarchy
+        QCOMPARE(perfEventCgroup("12:cpu,cpuacct:/docker/abc\n7:perf_event:/docker/abc\n0::/\n"),
+                 QStringLiteral("docker/abc"));
+        QCOMPARE(perfEventCgroup("garbage"), QString());
+
+        const auto pod = QStringLiteral("kubepods.slice/kubepods-pod1.slice");
+        const auto container1 = pod + QLatin1String("/cri-containerd-1.scope");
+        const auto container2 = pod + QLatin1String("/cri-containerd-2.scope");
+        QCOMPARE(commonCgroup({container1}), container1);
+        QCOMPARE(commonCgroup({container1, container1}), container1);
+        QCOMPARE(commonCgroup({container1, container2}), pod);
+        QCOMPARE(commonCgroup({container1, QStringLiteral("system.slice/foo.service")}), QString());
+        QCOMPARE(commonCgroup({container1, QString()}), QString());
+        QCOMPARE(commonCgroup({}), QString());
+
+        ProcessModel model;
+        model.setProcesses({ProcData {QStringLiteral("1"), QStringLiteral("app"), QStringLiteral("S"),
+                                      QStringLiteral("user"), container1}});
+        QCOMPARE(model.index(0, ProcessModel::CgroupColumn).data().toString(), container1);
+        QCOMPARE(model.index(0, 0).data(ProcessModel::CgroupRole).toString(), container1);
+    }
+
     void testPrettySymbol_data()
     {
         QTest::addColumn<QString>("prettySymbol");
@@ -775,7 +3897,7 @@ private slots:
         QFETCH(QString, prettySymbol);
         QFETCH(QString, symbol);
 
-        QCOMPARE(Data::Symbol(symbol).prettySymbol, prettySymbol);
+        QCOMPARE(Data::Symbol(symbol).prettySymbol(), prettySymbol);
     }
 
     void testCollapseTemplates_data()
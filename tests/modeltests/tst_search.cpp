@@ -11,6 +11,7 @@
 
 #include <iterator>
 #include <models/search.h>
+#include <models/textsearchindex.h>
 
 class TestSearch : public QObject
 {
@@ -103,6 +104,48 @@ private slots:
                      testArray, 1, Direction::Forward, [](int i) { return i == 0; }, [] {}),
                  0);
     }
+
+    void testSearchMatches()
+    {
+        const QVector<int> matches = {1, 3};
+
+        QCOMPARE(searchMatches(matches, 0, Direction::Forward, [] {}), 1);
+        QCOMPARE(searchMatches(matches, 1, Direction::Forward, [] {}), 3);
+        QCOMPARE(searchMatches(matches, 3, Direction::Backward, [] {}), 1);
+        QCOMPARE(searchMatches(matches, 4, Direction::Backward, [] {}), 3);
+        QCOMPARE(searchMatches({}, 0, Direction::Forward, [] {}), -1);
+
+        // without a current match, the first or last one is found without reaching the end
+        bool startEndReached = false;
+        const QVector<int> matchesFromStart = {0, 3};
+        QCOMPARE(searchMatches(matchesFromStart, -1, Direction::Forward, [&] { startEndReached = true; }), 0);
+        QCOMPARE(searchMatches(matchesFromStart, -1, Direction::Backward, [&] { startEndReached = true; }), 3);
+        QVERIFY(!startEndReached);
+
+        bool endReached = false;
+        QCOMPARE(searchMatches(matches, 3, Direction::Forward, [&endReached] { endReached = true; }), 1);
+        QVERIFY(endReached);
+
+        endReached = false;
+        QCOMPARE(searchMatches(matches, 1, Direction::Backward, [&endReached] { endReached = true; }), 3);
+        QVERIFY(endReached);
+    }
+
+    void testTextSearchIndex()
+    {
+        const TextSearchIndex index(
+            {QStringLiteral("int main()"), QStringLiteral("{"), QStringLiteral("    return Main(MAIN, main);"),
+             QStringLiteral("}"), QStringLiteral("")});
+
+        QCOMPARE(index.numLines(), 5);
+        QCOMPARE(index.matchingLines(QStringLiteral("main")), QVector<int>({0, 2}));
+        QCOMPARE(index.matchingLines(QStringLiteral("MAIN(")), QVector<int>({0, 2}));
+        QCOMPARE(index.matchingLines(QStringLiteral("}")), QVector<int>({3}));
+        QCOMPARE(index.matchingLines(QStringLiteral("()\n{")), QVector<int>());
+        QCOMPARE(index.matchingLines(QStringLiteral("missing")), QVector<int>());
+        QCOMPARE(index.matchingLines({}), QVector<int>({0, 1, 2, 3, 4}));
+        QCOMPARE(TextSearchIndex().matchingLines(QStringLiteral("main")), QVector<int>());
+    }
 };
 
 QTEST_GUILESS_MAIN(TestSearch)